@@ -862,6 +862,21 @@ declare class TextFile {
    */
   public readLine(): string;
 
+  /**
+   * Returns an iterable over the remaining lines of the file, which reads
+   * one line at a time. The lines do not contain the newline characters.
+   *
+   * ```js
+   * const file = new TextFile(fileName);
+   * for (const line of file.lines())
+   *     tiled.log(line);
+   * file.close();
+   * ```
+   *
+   * @since 1.12
+   */
+  public lines(): Iterable<string>;
+
   /**
    * Reads all data from the file and returns it.
    */
@@ -955,6 +970,18 @@ declare class BinaryFile {
    */
   public readAll(): ArrayBuffer;
 
+  /**
+   * Maps `length` bytes of the file starting at `offset` into memory and
+   * returns them as an `ArrayBuffer`. When `length` is omitted, the rest of
+   * the file is returned. The current position is not changed.
+   *
+   * This is an efficient way of reading parts of large files, though the
+   * returned buffer is still a copy of the mapped data.
+   *
+   * @since 1.12
+   */
+  public map(offset: number, length?: number): ArrayBuffer;
+
   /**
    * Writes data into the file at the current position.
    */
@@ -1085,6 +1112,31 @@ declare class ObjectGroup extends Layer {
    */
   objectAt(index: number): MapObject;
 
+  /**
+   * Returns the objects whose bounds intersect the given rectangle (in
+   * pixels), in the same order as {@link objects}. Objects without a size are
+   * returned when their position is inside the rectangle.
+   *
+   * This is much faster than checking each object on layers with many
+   * objects.
+   *
+   * @since 1.12
+   */
+  objectsIntersecting(rect: rect): MapObject[];
+
+  /**
+   * Calls the given function for each object on this layer, passing a plain
+   * data record with the object's basic properties and the object's index.
+   * Iteration stops when the function returns `false`.
+   *
+   * This is much faster than iterating over {@link objects} on layers with
+   * many objects, since no {@link MapObject} references need to be created.
+   * Use {@link objectAt} to get a reference when one is needed.
+   *
+   * @since 1.12
+   */
+  forEachObject(callback: (object: MapObjectData, index: number) => boolean | void): void;
+
   /**
    * Removes the object at the given index.
    */
@@ -1104,6 +1156,68 @@ declare class ObjectGroup extends Layer {
    * Adds the given object to the layer. The object can’t already be part of a layer.
    */
   addObject(object: MapObject): void;
+
+  /**
+   * Returns an object that enables changing many objects in this layer at
+   * once. The changes are applied as a single undoable edit.
+   *
+   * @since 1.12
+   */
+  edit(): ObjectGroupEdit;
+}
+
+/**
+ * This object enables changing many objects of an {@link ObjectGroup} at once.
+ * Unlike setting the properties of each {@link MapObject} directly, all
+ * changes are applied as a single undo command when calling {@link apply},
+ * which is much faster when changing many objects.
+ *
+ * @since 1.12
+ */
+interface ObjectGroupEdit {
+  /**
+   * The target layer of this edit object.
+   */
+  readonly target: ObjectGroup;
+
+  /**
+   * Sets the name of the given object.
+   */
+  setName(object: MapObject, name: string): void;
+
+  /**
+   * Sets the class of the given object.
+   */
+  setClassName(object: MapObject, className: string): void;
+
+  /**
+   * Sets the position of the given object.
+   */
+  setPos(object: MapObject, pos: point): void;
+
+  /**
+   * Sets the size of the given object.
+   */
+  setSize(object: MapObject, size: size): void;
+
+  /**
+   * Sets the rotation of the given object.
+   */
+  setRotation(object: MapObject, rotation: number): void;
+
+  /**
+   * Sets whether the given object is visible.
+   */
+  setVisible(object: MapObject, visible: boolean): void;
+
+  /**
+   * Applies the changes made through this object to the target layer. This
+   * object can be reused to make further changes.
+   *
+   * Changes to objects that have been removed from the layer in the meantime
+   * are dropped.
+   */
+  apply(): void;
 }
 
 /**
@@ -1697,6 +1811,25 @@ type MapObjectShape =
   | typeof MapObject.Text
   | typeof MapObject.Point;
 
+/**
+ * A read-only snapshot of the basic properties of a {@link MapObject}, as
+ * passed to {@link ObjectGroup.forEachObject}.
+ *
+ * @since 1.12
+ */
+interface MapObjectData {
+  readonly id: number;
+  readonly name: string;
+  readonly className: string;
+  readonly shape: MapObjectShape;
+  readonly x: number;
+  readonly y: number;
+  readonly width: number;
+  readonly height: number;
+  readonly rotation: number;
+  readonly visible: boolean;
+}
+
 /**
  * An object that can be part of an {@link ObjectGroup}.
  */
@@ -1907,6 +2040,24 @@ declare class Asset extends TiledObject {
    */
   readonly assetType: AssetType;
 
+  /**
+   * An estimate of the memory used by this asset, in bytes, broken down by
+   * kind of data. For a map this includes its embedded tilesets, but not its
+   * external tilesets. The undo stack is only reported as the number of
+   * commands it holds.
+   *
+   * @since 1.12
+   */
+  readonly memoryUsage: {
+    tileLayers: number,
+    objects: number,
+    properties: number,
+    images: number,
+    tiles: number,
+    total: number,
+    undoCommands: number
+  };
+
   /**
    * Creates a single undo command that wraps all changes applied to this
    * asset by the given callback. Recommended to avoid spamming the undo
@@ -2439,6 +2590,14 @@ declare class Image {
    */
   readonly depth: number;
 
+  /**
+   * Number of bytes used to store a single line of pixels, as stored in the
+   * data returned by {@link bits}.
+   *
+   * @since 1.12
+   */
+  readonly bytesPerLine: number;
+
   /**
    * Size of the image in pixels.
    */
@@ -2573,6 +2732,63 @@ declare class Image {
    */
   setColorTable(colors: number[] | string[]): void;
 
+  /**
+   * Returns a copy of the pixel data, with each line taking
+   * {@link bytesPerLine} bytes. The layout of each pixel depends on the
+   * {@link format}. For example, the pixels of a 32-bit image can be
+   * processed using a `Uint32Array`:
+   *
+   * ```js
+   * const pixels = new Uint32Array(image.bits())
+   * // ...modify the pixels...
+   * image.setBits(pixels)
+   * ```
+   *
+   * @since 1.12
+   */
+  bits(): ArrayBuffer;
+
+  /**
+   * Replaces the pixel data. The data needs to have the same size and layout
+   * as returned by {@link bits}.
+   *
+   * @since 1.12
+   */
+  setBits(data: ArrayBuffer | ArrayBufferView): void;
+
+  /**
+   * Copies the given image to the given location, replacing the pixels
+   * including their alpha values.
+   *
+   * @since 1.12
+   */
+  blit(image: Image, x?: number, y?: number): void;
+
+  /**
+   * Draws the given image on top of this image at the given location,
+   * blending it based on its alpha values and the given opacity.
+   *
+   * @since 1.12
+   */
+  composite(image: Image, x?: number, y?: number, opacity?: number): void;
+
+  /**
+   * Multiplies the color and alpha of each pixel by the given color.
+   *
+   * @since 1.12
+   */
+  tint(color: color): void;
+
+  /**
+   * Replaces each color in `from` with the color at the same index in `to`.
+   * Colors can be given as 32-bit color values or strings (like "#rrggbb").
+   *
+   * For images with a color table, the color table is changed instead.
+   *
+   * @since 1.12
+   */
+  remapColors(from: number[] | string[], to: number[] | string[]): void;
+
   /**
    * Copies the given rectangle to a new image object.
    *
@@ -3161,6 +3377,7 @@ declare class TileMap extends Asset {
   static readonly Base64Zlib: unique symbol;
   static readonly Base64Zstandard: unique symbol;
   static readonly CSV: unique symbol;
+  static readonly Base64ZstandardDictionary: unique symbol;
 
   static readonly RightDown: unique symbol;
   static readonly RightUp: unique symbol;
@@ -3258,7 +3475,8 @@ declare class TileMap extends Asset {
     | typeof TileMap.Base64Gzip
     | typeof TileMap.Base64Zlib
     | typeof TileMap.Base64Zstandard
-    | typeof TileMap.CSV;
+    | typeof TileMap.CSV
+    | typeof TileMap.Base64ZstandardDictionary;
 
   /**
    * The chunk size used when saving tile layers of infinite maps.
@@ -3359,6 +3577,49 @@ declare class TileMap extends Asset {
    */
   public autoMap(region: region | rect, rulesOrMapFile?: string): void;
 
+  /**
+   * Applies [Automapping](https://doc.mapeditor.org/en/stable/manual/automapping/) in the given region using the given rules file or rule map file,
+   * using the given seed for all random choices. This overrides any `RandomSeed` property set on the rule maps and makes the result reproducible.
+   *
+   * When no rules file nor rule map file is given (an empty string), Automapping is applied using the default rules file.
+   *
+   * @note This operation can only be applied to maps loaded from a file.
+   *
+   * @since 1.12
+   */
+  public autoMap(region: region | rect, rulesOrMapFile: string, randomSeed: number): void;
+
+  /**
+   * Returns the statistics collected for each AutoMapping rule during the
+   * {@link autoMap} calls on this map since the rules were loaded, or since
+   * the statistics were last reset.
+   *
+   * Each entry contains the `rulesMap` file name, the `rule` index within that
+   * rules map, the rule bounds (`x`, `y`, `width`, `height`), the time spent
+   * compiling, matching and applying the rule (`compileTime`, `matchTime` and
+   * `applyTime`, in milliseconds), and the number of `positionsTested` and
+   * `matches`. The number of `allocations` counts how often the scratch
+   * memory kept for matching the rule had to grow.
+   *
+   * When `reset` is `true`, the statistics are cleared afterwards.
+   *
+   * @since 1.12
+   */
+  public autoMapStatistics(reset?: boolean): {
+    rulesMap: string,
+    rule: number,
+    x: number,
+    y: number,
+    width: number,
+    height: number,
+    compileTime: number,
+    matchTime: number,
+    applyTime: number,
+    positionsTested: number,
+    matches: number,
+    allocations: number
+  }[];
+
   /**
    * Sets the size of the map in tiles. This does not affect the contents of the map.
    *
@@ -3423,6 +3684,22 @@ declare class TileMap extends Asset {
    */
   public removeObjects(objects: MapObject[]): void;
 
+  /**
+   * Returns the object with the given ID, or `null` when no such object
+   * exists in this map.
+   *
+   * @since 1.12
+   */
+  public objectById(id: number): MapObject | null;
+
+  /**
+   * Returns the objects in this map that have the given class set on them,
+   * either directly or through their template.
+   *
+   * @since 1.12
+   */
+  public objectsByClassName(className: string): MapObject[];
+
   /**
    * Merges the tile layers in the given map with this one. If only a single
    * tile layer exists in the given map, it will be merged with the
@@ -3625,6 +3902,27 @@ declare class TileLayer extends Layer {
    */
   tileAt(x: number, y: number): Tile | null;
 
+  /**
+   * Returns the cells in the given rectangle as an `ArrayBuffer` of 32-bit
+   * global tile IDs (little-endian), stored row by row. Empty cells are 0.
+   *
+   * The global tile IDs are assigned the same way as when saving the map:
+   * the first tileset of the map starts at 1, and each following tileset
+   * starts after the last tile ID of the previous tileset. The flags are
+   * stored in the highest bits, as described in the TMX documentation.
+   *
+   * This is a lot faster than calling {@link cellAt} for each cell:
+   *
+   * ```js
+   * const gids = new Uint32Array(layer.readCells(Qt.rect(0, 0, layer.width, layer.height)))
+   * ```
+   *
+   * The layer needs to be part of a map.
+   *
+   * @since 1.12
+   */
+  readCells(rect: rect): ArrayBuffer;
+
   /**
    * Returns an object that enables making modifications to the tile layer.
    */
@@ -3673,6 +3971,18 @@ interface TileLayerEdit {
    */
   setTile(x: number, y: number, tile: Tile | null, flags?: number): void;
 
+  /**
+   * Sets all cells in the given rectangle from an array of 32-bit global tile
+   * IDs, stored row by row, as returned by {@link TileLayer.readCells}. Cells
+   * set to 0 are erased.
+   *
+   * The data can be given as an `ArrayBuffer` or a typed array like
+   * `Uint32Array`. Its size needs to match the size of the rectangle.
+   *
+   * @since 1.12
+   */
+  writeCells(rect: rect, data: ArrayBuffer | Uint32Array): void;
+
   /**
    * Applies the changes made through this object to the target layer. This
    * object can be reused to make further changes.
@@ -3763,6 +4073,15 @@ interface TileLayerWangEdit {
    */
   erasingEnabled: boolean;
 
+  /**
+   * The seed used for random choices between matching tiles. When set to a
+   * value other than 0, applying the same changes gives the same result.
+   * Defaults to `0`, which picks a new seed each time.
+   *
+   * @since 1.12
+   */
+  randomSeed: number;
+
   /**
    * Sets the desired color for the given Wang index at the given location.
    *
@@ -4651,6 +4970,26 @@ declare namespace tiled {
    */
   export function versionLessThan(a: string, b?: string): boolean;
 
+  /**
+   * Returns statistics about the cache of images loaded from files, such as
+   * tileset images. The cache evicts the least recently used images that are
+   * no longer in use when it grows beyond `maximumBytes`.
+   *
+   * The `hits`, `misses` and `evictions` are counted since Tiled was started,
+   * or since they were last reset. When `reset` is `true`, these counters are
+   * reset afterwards.
+   *
+   * @since 1.12
+   */
+  export function imageCacheStatistics(reset?: boolean): {
+    entries: number,
+    bytes: number,
+    maximumBytes: number,
+    hits: number,
+    misses: number,
+    evictions: number
+  };
+
   /**
    * The version of Qt which Tiled is running against.
    *
@@ -5394,6 +5733,71 @@ declare class Process {
   writeLine(text: string): void;
 }
 
+/**
+ * Runs a script in a separate thread, so that heavy processing does not block
+ * the editor and can make use of multiple cores.
+ *
+ * The worker script runs in its own script engine, which only provides the
+ * standard JavaScript functionality, `console.log` and a global `postMessage`
+ * function. It can't access the `tiled` module or any maps. Instead, it can
+ * receive plain data, like the tile data returned by
+ * {@link TileLayer.readCells}, and send back its results:
+ *
+ * ```js
+ * // worker.js
+ * onmessage = function(gids) {
+ *     const cells = new Uint32Array(gids)
+ *     // ...heavy processing...
+ *     postMessage(cells.buffer)
+ * }
+ * ```
+ *
+ * ```js
+ * const worker = new Worker("/path/to/worker.js")
+ * worker.onmessage = function(result) {
+ *     // handle the result
+ * }
+ * worker.postMessage(layer.readCells(Qt.rect(0, 0, layer.width, layer.height)))
+ * ```
+ *
+ * Files with an `.mjs` extension are loaded as modules.
+ *
+ * Messages are copied between the script engines. They can contain numbers,
+ * strings, arrays, plain objects and ArrayBuffers, but not functions or
+ * objects provided by Tiled.
+ *
+ * @since 1.12
+ */
+declare class Worker {
+  /**
+   * Function called with each message sent by the worker using
+   * `postMessage`.
+   */
+  onmessage: ((message: any) => void) | null;
+
+  /**
+   * Function called with the error message when the worker script raised an
+   * error. When not set, the error is reported in the Console.
+   */
+  onerror: ((message: string) => void) | null;
+
+  /**
+   * Starts a worker running the script in the given file.
+   */
+  constructor(fileName: string);
+
+  /**
+   * Sends a message to the worker, which receives it through its global
+   * `onmessage` function.
+   */
+  postMessage(message: any): void;
+
+  /**
+   * Stops the worker, interrupting the script it is running.
+   */
+  terminate(): void;
+}
+
 /**
  * A widget which allows the user to select a color.
  * When the color button is clicked, a color picker dialog will pop up.
@@ -0,0 +1,212 @@
+/*
+ * base64.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base64.h"
+
+#include <array>
+#include <type_traits>
+
+namespace Tiled {
+namespace Base64 {
+
+static const char encodeTable[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Decoded values of the base64 alphabet
+static constexpr quint8 Invalid = 0xff;
+static constexpr quint8 Padding = 0xfe;
+
+static constexpr std::array<quint8, 256> makeDecodeTable()
+{
+    std::array<quint8, 256> table {};
+    for (auto &value : table)
+        value = Invalid;
+    for (int i = 0; i < 64; ++i)
+        table[static_cast<quint8>(encodeTable[i])] = static_cast<quint8>(i);
+    table['='] = Padding;
+    return table;
+}
+
+static constexpr std::array<quint8, 256> decodeTable = makeDecodeTable();
+
+/**
+ * Encodes \a size bytes at \a data, replacing the contents of \a out.
+ */
+void encode(const char *data, qint64 size, QByteArray &out)
+{
+    out.resize(static_cast<int>(encodedSize(size)));
+
+    auto in = reinterpret_cast<const quint8*>(data);
+    const quint8 *end = in + size - size % 3;
+    char *o = out.data();
+
+    for (; in != end; in += 3, o += 4) {
+        const quint32 bits = (quint32(in[0]) << 16) | (quint32(in[1]) << 8) | in[2];
+        o[0] = encodeTable[bits >> 18];
+        o[1] = encodeTable[(bits >> 12) & 0x3f];
+        o[2] = encodeTable[(bits >> 6) & 0x3f];
+        o[3] = encodeTable[bits & 0x3f];
+    }
+
+    switch (size % 3) {
+    case 1: {
+        const quint32 bits = quint32(in[0]) << 16;
+        o[0] = encodeTable[bits >> 18];
+        o[1] = encodeTable[(bits >> 12) & 0x3f];
+        o[2] = '=';
+        o[3] = '=';
+        break;
+    }
+    case 2: {
+        const quint32 bits = (quint32(in[0]) << 16) | (quint32(in[1]) << 8);
+        o[0] = encodeTable[bits >> 18];
+        o[1] = encodeTable[(bits >> 12) & 0x3f];
+        o[2] = encodeTable[(bits >> 6) & 0x3f];
+        o[3] = '=';
+        break;
+    }
+    }
+}
+
+QByteArray encode(const QByteArray &data)
+{
+    QByteArray out;
+    encode(data.constData(), data.size(), out);
+    return out;
+}
+
+template<typename Char>
+static inline quint8 decodeValue(Char c)
+{
+    const auto code = static_cast<std::make_unsigned_t<Char>>(c);
+    return code < 256 ? decodeTable[code] : Invalid;
+}
+
+/**
+ * Decodes the next part of the data, replacing the contents of \a out with
+ * the bytes that could be completed so far.
+ */
+template<typename Char>
+void Decoder::decodeImpl(const Char *data, qint64 size, QByteArray &out)
+{
+    // Padding may complete one more group than the characters alone
+    out.resize(static_cast<int>(((mCount + size) / 4 + 1) * 3));
+    auto o = reinterpret_cast<quint8*>(out.data());
+    const Char *end = data + size;
+
+    while (data != end) {
+        // Decode complete groups of 4 characters at once, which is the
+        // common case since whitespace usually only surrounds the data
+        if (mCount == 0) {
+            while (end - data >= 4) {
+                const quint8 a = decodeValue(data[0]);
+                const quint8 b = decodeValue(data[1]);
+                const quint8 c = decodeValue(data[2]);
+                const quint8 d = decodeValue(data[3]);
+                if ((a | b | c | d) & 0xc0)
+                    break;
+
+                const quint32 bits = (quint32(a) << 18) | (quint32(b) << 12) | (quint32(c) << 6) | d;
+                o[0] = static_cast<quint8>(bits >> 16);
+                o[1] = static_cast<quint8>(bits >> 8);
+                o[2] = static_cast<quint8>(bits);
+                o += 3;
+                data += 4;
+            }
+
+            if (data == end)
+                break;
+        }
+
+        const quint8 value = decodeValue(*data++);
+        if (value == Invalid)
+            continue;
+
+        if (value == Padding) {
+            o = finishGroup(o);
+            continue;
+        }
+
+        mBits = (mBits << 6) | value;
+        if (++mCount == 4) {
+            o[0] = static_cast<quint8>(mBits >> 16);
+            o[1] = static_cast<quint8>(mBits >> 8);
+            o[2] = static_cast<quint8>(mBits);
+            o += 3;
+            mBits = 0;
+            mCount = 0;
+        }
+    }
+
+    out.resize(static_cast<int>(o - reinterpret_cast<quint8*>(out.data())));
+}
+
+void Decoder::decode(const char *data, qint64 size, QByteArray &out)
+{
+    decodeImpl(data, size, out);
+}
+
+void Decoder::decode(const char16_t *data, qint64 size, QByteArray &out)
+{
+    decodeImpl(data, size, out);
+}
+
+/**
+ * Outputs the bytes of the final, incomplete group of characters, which is
+ * the case when the padding was left out or when the data was cut off.
+ */
+void Decoder::finish(QByteArray &out)
+{
+    out.resize(2);
+    auto o = reinterpret_cast<quint8*>(out.data());
+    out.resize(static_cast<int>(finishGroup(o) - o));
+}
+
+/**
+ * Writes the bytes of an incomplete group of characters to \a o and returns
+ * the new end of the output.
+ */
+quint8 *Decoder::finishGroup(quint8 *o)
+{
+    switch (mCount) {
+    case 2:
+        *o++ = static_cast<quint8>(mBits >> 4);
+        break;
+    case 3:
+        *o++ = static_cast<quint8>(mBits >> 10);
+        *o++ = static_cast<quint8>(mBits >> 2);
+        break;
+    }
+
+    mBits = 0;
+    mCount = 0;
+    return o;
+}
+
+} // namespace Base64
+} // namespace Tiled
@@ -0,0 +1,81 @@
+/*
+ * base64.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QByteArray>
+
+namespace Tiled {
+
+/**
+ * Base64 encoding and decoding of binary layer data.
+ *
+ * Unlike QByteArray::toBase64() and QByteArray::fromBase64(), these write
+ * into buffers that can be reused, and the decoder takes its input in parts,
+ * straight from Latin-1 or UTF-16 text.
+ */
+namespace Base64 {
+
+/**
+ * Returns the size of the base64 encoding of \a size bytes, including
+ * padding.
+ */
+constexpr qint64 encodedSize(qint64 size)
+{
+    return (size + 2) / 3 * 4;
+}
+
+TILEDSHARED_EXPORT void encode(const char *data, qint64 size, QByteArray &out);
+TILEDSHARED_EXPORT QByteArray encode(const QByteArray &data);
+
+/**
+ * Decodes base64 data that is provided in parts. Characters outside of the
+ * base64 alphabet, like whitespace, are skipped. Padding ends the current
+ * group of characters, but is not required at the end of the data.
+ */
+class TILEDSHARED_EXPORT Decoder
+{
+public:
+    void decode(const char *data, qint64 size, QByteArray &out);
+    void decode(const char16_t *data, qint64 size, QByteArray &out);
+
+    void finish(QByteArray &out);
+
+private:
+    template<typename Char>
+    void decodeImpl(const Char *data, qint64 size, QByteArray &out);
+    quint8 *finishGroup(quint8 *o);
+
+    quint32 mBits = 0;      // of the incomplete group of 4 characters
+    int mCount = 0;         // number of characters in the incomplete group
+};
+
+} // namespace Base64
+} // namespace Tiled
@@ -0,0 +1,81 @@
+/*
+ * chunkstore.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "chunkstore.h"
+
+namespace Tiled {
+
+ChunkStore::~ChunkStore() = default;
+
+/**
+ * Reads the chunk at \a chunkPos and remembers it as unchanged.
+ */
+bool ChunkStore::loadChunk(QPoint chunkPos, Chunk &chunk)
+{
+    if (!readChunk(chunkPos, chunk))
+        return false;
+
+    mUnchangedChunks.insert(chunkPos, chunk);
+    return true;
+}
+
+/**
+ * Returns whether \a chunk is still the same as the chunk loaded or saved at
+ * \a chunkPos. Since changing a chunk detaches its data, this doesn't need
+ * to compare any cells.
+ */
+bool ChunkStore::isUnchanged(QPoint chunkPos, const Chunk &chunk) const
+{
+    auto it = mUnchangedChunks.constFind(chunkPos);
+    return it != mUnchangedChunks.constEnd() && it->isSharedWith(chunk);
+}
+
+/**
+ * Remembers \a chunk as the stored version of the chunk at \a chunkPos,
+ * after it was saved.
+ */
+void ChunkStore::setUnchanged(QPoint chunkPos, const Chunk &chunk)
+{
+    mUnchangedChunks.insert(chunkPos, chunk);
+}
+
+/**
+ * Forgets about the chunk at \a chunkPos, for example after it was paged out
+ * or removed. Until it is loaded again, it is considered changed.
+ */
+void ChunkStore::forget(QPoint chunkPos)
+{
+    mUnchangedChunks.remove(chunkPos);
+}
+
+void ChunkStore::forgetAll()
+{
+    mUnchangedChunks.clear();
+}
+
+} // namespace Tiled
@@ -0,0 +1,80 @@
+/*
+ * chunkstore.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tilelayer.h"
+
+#include <QHash>
+#include <QPoint>
+
+namespace Tiled {
+
+/**
+ * Provides the chunks of a tile layer that are not kept in memory. A tile
+ * layer with a chunk store pages in its stored chunks on demand, and may
+ * page out chunks again that were not changed since they were loaded.
+ *
+ * The store remembers the chunks it handed out, sharing their data, which
+ * allows telling whether a chunk was changed since it was loaded or saved.
+ *
+ * Chunk stores are not thread-safe. They are shared between a layer and its
+ * clones.
+ */
+class TILEDSHARED_EXPORT ChunkStore
+{
+public:
+    virtual ~ChunkStore();
+
+    bool loadChunk(QPoint chunkPos, Chunk &chunk);
+
+    /**
+     * Reads the chunk at \a chunkPos (in chunk coordinates) from the backing
+     * storage into \a chunk. Returns whether the chunk could be read.
+     */
+    virtual bool readChunk(QPoint chunkPos, Chunk &chunk) = 0;
+
+    bool isUnchanged(QPoint chunkPos, const Chunk &chunk) const;
+    void setUnchanged(QPoint chunkPos, const Chunk &chunk);
+    void forget(QPoint chunkPos);
+    void forgetAll();
+
+    /**
+     * The memory budget in bytes for the chunks of each layer using this
+     * store. When a layer pages in chunks beyond this budget, the least
+     * recently used unchanged chunks are paged out again.
+     */
+    qint64 memoryBudget() const { return mMemoryBudget; }
+    void setMemoryBudget(qint64 budget) { mMemoryBudget = budget; }
+
+private:
+    QHash<QPoint, Chunk> mUnchangedChunks;
+    qint64 mMemoryBudget = 256 * 1024 * 1024;
+};
+
+} // namespace Tiled
@@ -35,11 +35,14 @@
 #endif
 #ifdef TILED_ZSTD_SUPPORT
 #include <zstd.h>      // presumes zstd library is installed
+#include <zdict.h>
 #endif
 
 #include <QByteArray>
 #include <QDebug>
 
+#include <vector>
+
 #ifdef Z_PREFIX
 #undef compress
 #endif
@@ -158,6 +161,13 @@ QByteArray Tiled::decompress(const QByteArray &data,
     }
 }
 
+#ifdef TILED_ZSTD_SUPPORT
+static int zstdCompressionLevel(int compressionLevel)
+{
+    return compressionLevel == -1 ? 6 : qBound(1, compressionLevel, 22);
+}
+#endif
+
 QByteArray Tiled::compress(const QByteArray &data,
                            CompressionMethod method,
                            int compressionLevel)
@@ -219,10 +229,7 @@ QByteArray Tiled::compress(const QByteArray &data,
         return out;
 #ifdef TILED_ZSTD_SUPPORT
     } else if (method == Zstandard) {
-        if (compressionLevel == -1)
-            compressionLevel = 6;
-        else
-            compressionLevel = qBound(1, compressionLevel, 22);
+        compressionLevel = zstdCompressionLevel(compressionLevel);
 
         size_t const cBuffSize = ZSTD_compressBound(data.size());
 
@@ -243,3 +250,306 @@ QByteArray Tiled::compress(const QByteArray &data,
         return QByteArray();
     }
 }
+
+struct CompressionDictionary::Private
+{
+    QByteArray data;
+#ifdef TILED_ZSTD_SUPPORT
+    ZSTD_CDict *cdict = nullptr;
+    ZSTD_DDict *ddict = nullptr;
+
+    ~Private()
+    {
+        ZSTD_freeCDict(cdict);
+        ZSTD_freeDDict(ddict);
+    }
+#endif
+};
+
+CompressionDictionary::CompressionDictionary() = default;
+
+/**
+ * Creates a dictionary from previously trained dictionary \a data. The
+ * \a compressionLevel is used when compressing data with this dictionary.
+ *
+ * The dictionary is null when Zstandard is not supported or when the data
+ * could not be loaded.
+ */
+CompressionDictionary::CompressionDictionary(const QByteArray &data,
+                                             int compressionLevel)
+{
+#ifdef TILED_ZSTD_SUPPORT
+    if (data.isEmpty())
+        return;
+
+    auto p = std::make_shared<Private>();
+    p->data = data;
+    p->cdict = ZSTD_createCDict(data.constData(), data.size(),
+                                zstdCompressionLevel(compressionLevel));
+    p->ddict = ZSTD_createDDict(data.constData(), data.size());
+
+    if (p->cdict && p->ddict)
+        d = std::move(p);
+    else
+        qDebug() << "error loading compression dictionary";
+#else
+    Q_UNUSED(data)
+    Q_UNUSED(compressionLevel)
+#endif
+}
+
+/**
+ * Trains a dictionary of at most \a maxSize bytes on the given \a samples.
+ *
+ * Returns a null dictionary when Zstandard is not supported or when the
+ * training failed, which is usually because there were too few samples.
+ */
+CompressionDictionary CompressionDictionary::train(const QVector<QByteArray> &samples,
+                                                   int maxSize,
+                                                   int compressionLevel)
+{
+#ifdef TILED_ZSTD_SUPPORT
+    QByteArray samplesBuffer;
+    std::vector<size_t> sampleSizes;
+    sampleSizes.reserve(samples.size());
+
+    for (const QByteArray &sample : samples) {
+        samplesBuffer.append(sample);
+        sampleSizes.push_back(static_cast<size_t>(sample.size()));
+    }
+
+    QByteArray dictionary(maxSize, Qt::Uninitialized);
+    const size_t size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(),
+                                              samplesBuffer.constData(),
+                                              sampleSizes.data(),
+                                              static_cast<unsigned>(sampleSizes.size()));
+    if (ZDICT_isError(size))
+        return CompressionDictionary();
+
+    dictionary.resize(static_cast<int>(size));
+    return CompressionDictionary(dictionary, compressionLevel);
+#else
+    Q_UNUSED(samples)
+    Q_UNUSED(maxSize)
+    Q_UNUSED(compressionLevel)
+    return CompressionDictionary();
+#endif
+}
+
+bool CompressionDictionary::isNull() const
+{
+    return !d;
+}
+
+QByteArray CompressionDictionary::data() const
+{
+    return d ? d->data : QByteArray();
+}
+
+/**
+ * Compresses the given \a data in Zstandard format, using this dictionary.
+ * Returns a null QByteArray if compression failed.
+ */
+QByteArray CompressionDictionary::compress(const QByteArray &data) const
+{
+#ifdef TILED_ZSTD_SUPPORT
+    if (!d || data.isEmpty())
+        return QByteArray();
+
+    ZSTD_CCtx *context = ZSTD_createCCtx();
+    if (!context)
+        return QByteArray();
+
+    QByteArray out;
+    out.resize(ZSTD_compressBound(data.size()));
+
+    const size_t size = ZSTD_compress_usingCDict(context, out.data(), out.size(),
+                                                 data.constData(), data.size(),
+                                                 d->cdict);
+    ZSTD_freeCCtx(context);
+
+    if (ZSTD_isError(size)) {
+        qDebug() << "error compressing:" << ZSTD_getErrorName(size);
+        return QByteArray();
+    }
+
+    out.resize(static_cast<int>(size));
+    return out;
+#else
+    Q_UNUSED(data)
+    return QByteArray();
+#endif
+}
+
+
+struct Decompressor::Private
+{
+    CompressionMethod method;
+    bool valid = false;
+    bool finished = false;
+    std::vector<char> buffer = std::vector<char>(64 * 1024);
+
+    z_stream zlibStream;
+#ifdef TILED_ZSTD_SUPPORT
+    ZSTD_DStream *zstdStream = nullptr;
+#endif
+    CompressionDictionary dictionary;
+};
+
+Decompressor::Decompressor(CompressionMethod method)
+    : d(std::make_unique<Private>())
+{
+    d->method = method;
+
+    if (method == Zlib || method == Gzip) {
+        z_stream &strm = d->zlibStream;
+        strm.zalloc = Z_NULL;
+        strm.zfree = Z_NULL;
+        strm.opaque = Z_NULL;
+        strm.next_in = Z_NULL;
+        strm.avail_in = 0;
+
+        const int ret = inflateInit2(&strm, 15 + 32);
+        if (ret != Z_OK)
+            logZlibError(ret);
+        else
+            d->valid = true;
+#ifdef TILED_ZSTD_SUPPORT
+    } else if (method == Zstandard) {
+        d->zstdStream = ZSTD_createDStream();
+        d->valid = d->zstdStream && !ZSTD_isError(ZSTD_initDStream(d->zstdStream));
+#endif
+    } else {
+        qDebug() << "compression not supported:" << method;
+    }
+}
+
+/**
+ * Creates a decompressor for Zstandard compressed data, which was compressed
+ * using the given \a dictionary.
+ */
+Decompressor::Decompressor(const CompressionDictionary &dictionary)
+    : d(std::make_unique<Private>())
+{
+    d->method = Zstandard;
+
+#ifdef TILED_ZSTD_SUPPORT
+    if (dictionary.isNull())
+        return;
+
+    // The dictionary needs to be referenced after initializing the stream
+    d->dictionary = dictionary;
+    d->zstdStream = ZSTD_createDStream();
+    d->valid = d->zstdStream &&
+            !ZSTD_isError(ZSTD_initDStream(d->zstdStream)) &&
+            !ZSTD_isError(ZSTD_DCtx_refDDict(d->zstdStream, dictionary.d->ddict));
+#else
+    Q_UNUSED(dictionary)
+#endif
+}
+
+Decompressor::~Decompressor()
+{
+    if (d->method == Zlib || d->method == Gzip) {
+        if (d->valid)
+            inflateEnd(&d->zlibStream);
+#ifdef TILED_ZSTD_SUPPORT
+    } else if (d->zstdStream) {
+        ZSTD_freeDStream(d->zstdStream);
+#endif
+    }
+}
+
+/**
+ * Decompresses the next part of the compressed stream, passing the
+ * decompressed data to \a output in blocks of limited size.
+ *
+ * Returns false when an error occurred or when \a output returned false.
+ * Like decompress(), any data following the end of a zlib or gzip stream is
+ * ignored.
+ */
+bool Decompressor::decompress(const char *data, int size, const Output &output)
+{
+    if (!d->valid)
+        return false;
+    if (size == 0)
+        return true;
+    if (d->finished && d->method != Zstandard)
+        return true;
+
+    char *buffer = d->buffer.data();
+    const int bufferSize = static_cast<int>(d->buffer.size());
+
+    if (d->method == Zlib || d->method == Gzip) {
+        z_stream &strm = d->zlibStream;
+        strm.next_in = (Bytef *) data;
+        strm.avail_in = size;
+
+        // Keep going while there is input left, or while the output buffer
+        // was filled, since there may be more pending output
+        do {
+            strm.next_out = (Bytef *) buffer;
+            strm.avail_out = bufferSize;
+
+            int ret = inflate(&strm, Z_NO_FLUSH);
+            Q_ASSERT(ret != Z_STREAM_ERROR);
+
+            switch (ret) {
+            case Z_NEED_DICT:
+                ret = Z_DATA_ERROR;
+                [[fallthrough]];
+            case Z_DATA_ERROR:
+            case Z_MEM_ERROR:
+                logZlibError(ret);
+                return false;
+            }
+
+            const int produced = bufferSize - strm.avail_out;
+            if (produced > 0 && !output(buffer, produced))
+                return false;
+
+            if (ret == Z_STREAM_END) {
+                d->finished = true;
+                break;
+            }
+
+            if (ret == Z_BUF_ERROR)
+                break;  // no progress possible, needs more input
+        } while (strm.avail_in > 0 || strm.avail_out == 0);
+
+        return true;
+#ifdef TILED_ZSTD_SUPPORT
+    } else if (d->method == Zstandard) {
+        ZSTD_inBuffer in { data, static_cast<size_t>(size), 0 };
+
+        ZSTD_outBuffer out { buffer, static_cast<size_t>(bufferSize), 0 };
+
+        do {
+            out.pos = 0;
+
+            const size_t ret = ZSTD_decompressStream(d->zstdStream, &out, &in);
+            if (ZSTD_isError(ret)) {
+                qDebug() << "error decoding:" << ZSTD_getErrorName(ret);
+                return false;
+            }
+
+            if (out.pos > 0 && !output(buffer, static_cast<int>(out.pos)))
+                return false;
+
+            d->finished = ret == 0;
+        } while (in.pos < in.size || out.pos == out.size);
+
+        return true;
+#endif
+    }
+
+    return false;
+}
+
+/**
+ * Returns whether the end of the compressed stream was reached.
+ */
+bool Decompressor::isFinished() const
+{
+    return d->finished;
+}
@@ -30,6 +30,11 @@
 
 #include "tiled_global.h"
 
+#include <QVector>
+
+#include <functional>
+#include <memory>
+
 class QByteArray;
 
 namespace Tiled {
@@ -76,4 +81,62 @@ QByteArray TILEDSHARED_EXPORT compress(const QByteArray &data,
                                        CompressionMethod method,
                                        int compressionLevel = -1);
 
+/**
+ * A Zstandard dictionary, which improves the compression of many small
+ * pieces of similar data, like the chunks of an infinite map. The same
+ * dictionary is needed to decompress the data again.
+ *
+ * The dictionary is prepared for compression and decompression only once.
+ * It is implicitly shared and can be used from multiple threads.
+ */
+class TILEDSHARED_EXPORT CompressionDictionary
+{
+public:
+    CompressionDictionary();
+    explicit CompressionDictionary(const QByteArray &data,
+                                   int compressionLevel = -1);
+
+    static CompressionDictionary train(const QVector<QByteArray> &samples,
+                                       int maxSize,
+                                       int compressionLevel = -1);
+
+    bool isNull() const;
+    QByteArray data() const;
+
+    QByteArray compress(const QByteArray &data) const;
+
+private:
+    friend class Decompressor;
+
+    struct Private;
+    std::shared_ptr<const Private> d;
+};
+
+/**
+ * Decompresses a stream of zlib, gzip or Zstandard compressed data which is
+ * provided in parts, without holding the complete input or output in
+ * memory.
+ */
+class TILEDSHARED_EXPORT Decompressor
+{
+public:
+    /**
+     * Receives a block of decompressed data. Returning false stops the
+     * decompression.
+     */
+    using Output = std::function<bool (const char *data, int size)>;
+
+    explicit Decompressor(CompressionMethod method);
+    explicit Decompressor(const CompressionDictionary &dictionary);
+    ~Decompressor();
+
+    bool decompress(const char *data, int size, const Output &output);
+
+    bool isFinished() const;
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
 } // namespace Tiled
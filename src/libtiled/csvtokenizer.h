@@ -0,0 +1,135 @@
+/*
+ * csvtokenizer.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <QChar>
+
+namespace Tiled {
+
+/**
+ * Reads comma-separated unsigned numbers from a range of characters in a
+ * single pass, without allocating. Whitespace within the fields is ignored
+ * and empty fields are read as 0.
+ *
+ * Works on both 8-bit (char) and 16-bit (QChar) text.
+ */
+template<typename Char>
+class CsvTokenizer
+{
+public:
+    CsvTokenizer(const Char *begin, const Char *end)
+        : mCurrent(begin)
+        , mEnd(end)
+    {}
+
+    /**
+     * Returns whether all the text has been read.
+     */
+    bool atEnd() const { return mCurrent == mEnd; }
+
+    /**
+     * Reads the next field as a number in the given \a base, which is either
+     * 10 or 16. In base 16, the number may be prefixed by "0x".
+     *
+     * Returns false when the field contains an invalid character, in which
+     * case \a value is set to 0 and the rest of the field is skipped. The
+     * offending character is available through invalidChar().
+     */
+    bool readValue(unsigned &value, int base = 10)
+    {
+        value = 0;
+        int digits = 0;
+
+        while (mCurrent != mEnd) {
+            const QChar c = toQChar(*mCurrent++);
+
+            // Fast path for the common case of ASCII decimal digits
+            const char16_t u = c.unicode();
+            if (u >= u'0' && u <= u'9') {
+                value = value * base + (u - u'0');
+                ++digits;
+                continue;
+            }
+
+            if (c == QLatin1Char(','))
+                return true;
+            if (c.isSpace())
+                continue;
+
+            const int digit = digitValue(c, base);
+            if (digit != -1) {
+                value = value * base + digit;
+                ++digits;
+            } else if (base == 16 && digits == 1 && value == 0 &&
+                       (c == QLatin1Char('x') || c == QLatin1Char('X'))) {
+                digits = 0;
+            } else {
+                mInvalidChar = c;
+                value = 0;
+                skipField();
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    QChar invalidChar() const { return mInvalidChar; }
+
+private:
+    static QChar toQChar(QChar c) { return c; }
+    static QChar toQChar(char c) { return QLatin1Char(c); }
+
+    static int digitValue(QChar c, int base)
+    {
+        const int value = c.digitValue();
+        if (value != -1 || base != 16)
+            return value;
+
+        const char16_t u = c.unicode();
+        if (u >= u'a' && u <= u'f')
+            return u - u'a' + 10;
+        if (u >= u'A' && u <= u'F')
+            return u - u'A' + 10;
+        return -1;
+    }
+
+    void skipField()
+    {
+        while (mCurrent != mEnd)
+            if (toQChar(*mCurrent++) == QLatin1Char(','))
+                return;
+    }
+
+    const Char *mCurrent;
+    const Char *mEnd;
+    QChar mInvalidChar;
+};
+
+} // namespace Tiled
@@ -0,0 +1,225 @@
+/*
+ * diskimagecache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "diskimagecache.h"
+
+#include "compression.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstring>
+
+namespace Tiled {
+
+static const quint32 cacheFileMagic = 0x54494D47;    // "TIMG"
+static const quint32 cacheFileVersion = 1;
+
+// Smaller images decode quickly enough by themselves
+static const qint64 minimumCachedImageBytes = 1024 * 1024;
+
+static bool diskImageCacheEnabled;
+static QString diskImageCacheDirectory;
+
+/**
+ * Sets whether images are loaded from and stored in the disk cache. Disabled
+ * by default, since only interactive use benefits from it.
+ */
+void DiskImageCache::setEnabled(bool enabled)
+{
+    diskImageCacheEnabled = enabled;
+}
+
+bool DiskImageCache::isEnabled()
+{
+    return diskImageCacheEnabled;
+}
+
+/**
+ * Sets the directory in which cached images are stored. When not set, an
+ * "images" folder in the application's cache location is used.
+ */
+void DiskImageCache::setDirectory(const QString &directory)
+{
+    diskImageCacheDirectory = directory;
+}
+
+QString DiskImageCache::directory()
+{
+    if (!diskImageCacheDirectory.isEmpty())
+        return diskImageCacheDirectory;
+
+    const QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (cacheLocation.isEmpty())
+        return QString();
+
+    return QDir(cacheLocation).filePath(QStringLiteral("images"));
+}
+
+/**
+ * Loads the image from the given file. When the cache is enabled, the image
+ * is taken from the cache when possible. Otherwise, large images are added
+ * to the cache after decoding them.
+ *
+ * Returns a null image when the file could not be read as an image.
+ */
+QImage DiskImageCache::loadImage(const QString &fileName)
+{
+    if (!diskImageCacheEnabled)
+        return QImage(fileName);
+
+    const QString cachedFileName = cacheFileName(fileName);
+    if (cachedFileName.isEmpty())
+        return QImage(fileName);
+
+    QImage image = readCachedImage(cachedFileName);
+    if (!image.isNull())
+        return image;
+
+    image = QImage(fileName);
+    if (!image.isNull() && image.sizeInBytes() >= minimumCachedImageBytes)
+        writeCachedImage(cachedFileName, image);
+
+    return image;
+}
+
+QString DiskImageCache::cacheFileName(const QString &fileName)
+{
+    const QFileInfo info(fileName);
+    if (!info.isFile())
+        return QString();
+
+    const QString cacheDirectory = directory();
+    if (cacheDirectory.isEmpty())
+        return QString();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(info.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    hash.addData(QByteArray::number(info.size()));
+
+    const QString baseName = QString::fromLatin1(hash.result().toHex());
+    return QDir(cacheDirectory).filePath(baseName + QLatin1String(".timg"));
+}
+
+QImage DiskImageCache::readCachedImage(const QString &cacheFileName)
+{
+    QFile file(cacheFileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return QImage();
+
+    QDataStream stream(&file);
+
+    quint32 magic, version;
+    qint32 width, height, format, bytesPerLine, compression, dataSize;
+    QVector<QRgb> colorTable;
+
+    stream >> magic >> version;
+    if (magic != cacheFileMagic || version != cacheFileVersion)
+        return QImage();
+
+    stream >> width >> height >> format >> bytesPerLine >> colorTable >> compression >> dataSize;
+    if (stream.status() != QDataStream::Ok || width <= 0 || height <= 0 ||
+            format <= QImage::Format_Invalid || format >= QImage::NImageFormats ||
+            dataSize < 0 || !(compression == -1 || compression == Zstandard)) {
+        return QImage();
+    }
+
+    QImage image(width, height, static_cast<QImage::Format>(format));
+    if (image.isNull() || image.bytesPerLine() != bytesPerLine)
+        return QImage();
+
+    const qint64 imageBytes = image.sizeInBytes();
+
+    if (compression == -1) {
+        if (dataSize != imageBytes || stream.readRawData(reinterpret_cast<char*>(image.bits()), dataSize) != dataSize)
+            return QImage();
+    } else {
+        if (!compressionSupported(Zstandard))
+            return QImage();
+
+        QByteArray compressed(dataSize, Qt::Uninitialized);
+        if (stream.readRawData(compressed.data(), dataSize) != dataSize)
+            return QImage();
+
+        const QByteArray pixels = decompress(compressed, static_cast<int>(imageBytes), Zstandard);
+        if (pixels.size() != imageBytes)
+            return QImage();
+
+        std::memcpy(image.bits(), pixels.constData(), imageBytes);
+    }
+
+    image.setColorTable(colorTable);
+    return image;
+}
+
+void DiskImageCache::writeCachedImage(const QString &cacheFileName, const QImage &image)
+{
+    if (!QDir().mkpath(QFileInfo(cacheFileName).absolutePath()))
+        return;
+
+    const QByteArray pixels = QByteArray::fromRawData(reinterpret_cast<const char*>(image.constBits()),
+                                                      image.sizeInBytes());
+
+    qint32 compression = -1;
+    QByteArray data = pixels;
+
+    if (compressionSupported(Zstandard)) {
+        // Use a fast compression level, since loading speed is the goal
+        const QByteArray compressed = compress(pixels, Zstandard, 1);
+        if (!compressed.isNull()) {
+            compression = Zstandard;
+            data = compressed;
+        }
+    }
+
+    // QSaveFile makes sure other threads or instances never read a partially
+    // written file
+    QSaveFile file(cacheFileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream << cacheFileMagic << cacheFileVersion
+           << qint32(image.width()) << qint32(image.height())
+           << qint32(image.format()) << qint32(image.bytesPerLine())
+           << image.colorTable()
+           << compression << qint32(data.size());
+    stream.writeRawData(data.constData(), data.size());
+
+    if (stream.status() == QDataStream::Ok)
+        file.commit();
+}
+
+} // namespace Tiled
@@ -0,0 +1,66 @@
+/*
+ * diskimagecache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QImage>
+#include <QString>
+
+namespace Tiled {
+
+/**
+ * Keeps decoded copies of large images in the user's cache directory, so that
+ * they load faster than when decoding them from their original format.
+ *
+ * Entries are keyed by the path, modification time and size of the image
+ * file, so changed files are never loaded from the cache. When available,
+ * the pixels are compressed with Zstandard.
+ *
+ * The lookup functions are thread-safe, but the cache should be configured
+ * before it is used.
+ */
+class TILEDSHARED_EXPORT DiskImageCache
+{
+public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    static void setDirectory(const QString &directory);
+    static QString directory();
+
+    static QImage loadImage(const QString &fileName);
+
+private:
+    static QString cacheFileName(const QString &fileName);
+    static QImage readCachedImage(const QString &cacheFileName);
+    static void writeCachedImage(const QString &cacheFileName, const QImage &image);
+};
+
+} // namespace Tiled
@@ -44,7 +44,21 @@ public:
         NoCapability    = 0x0,
         Read            = 0x1,
         Write           = 0x2,
-        ReadWrite       = Read | Write
+        ReadWrite       = Read | Write,
+
+        /**
+         * Writing may happen on a worker thread. The data passed to the
+         * writer is a snapshot that isn't changed while it is written.
+         */
+        WriteInBackground = 0x4,
+
+        /**
+         * The writer takes care of tile layer chunks that are paged out, so
+         * they don't need to be loaded before writing.
+         *
+         * \sa TileLayer::setChunkStore()
+         */
+        WritePagedOutChunks = 0x8,
     };
     Q_DECLARE_FLAGS(Capabilities, Capability)
 
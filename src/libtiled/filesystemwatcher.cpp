@@ -28,43 +28,180 @@
 
 #include "filesystemwatcher.h"
 
+#include <QCoreApplication>
 #include <QDebug>
 #include <QFile>
 #include <QFileSystemWatcher>
+#include <QHash>
+#include <QPointer>
 #include <QStringList>
+#include <QVector>
 
 namespace Tiled {
 
+/**
+ * Owns the QFileSystemWatcher shared by all FileSystemWatcher instances and
+ * keeps track of which instances watch each path.
+ */
+class FileSystemWatcherBackend : public QObject
+{
+public:
+    static FileSystemWatcherBackend *instance();
+
+    void addPaths(FileSystemWatcher *client, const QStringList &paths);
+    void removePaths(FileSystemWatcher *client, const QStringList &paths);
+    void restoreWatches(const QStringList &paths);
+
+private:
+    explicit FileSystemWatcherBackend(QObject *parent);
+
+    template<typename Handler>
+    void notifyClients(const QString &path, Handler handler);
+
+    QFileSystemWatcher mWatcher;
+    QHash<QString, QVector<FileSystemWatcher*>> mClients;
+
+    static QPointer<FileSystemWatcherBackend> sInstance;
+};
+
+QPointer<FileSystemWatcherBackend> FileSystemWatcherBackend::sInstance;
+
+/**
+ * Returns the shared backend, creating it when necessary. Returns null when
+ * the application is already shutting down.
+ */
+FileSystemWatcherBackend *FileSystemWatcherBackend::instance()
+{
+    if (!sInstance) {
+        if (QCoreApplication *app = QCoreApplication::instance())
+            sInstance = new FileSystemWatcherBackend(app);
+    }
+    return sInstance;
+}
+
+FileSystemWatcherBackend::FileSystemWatcherBackend(QObject *parent)
+    : QObject(parent)
+{
+    connect(&mWatcher, &QFileSystemWatcher::fileChanged, this, [this] (const QString &path) {
+        notifyClients(path, &FileSystemWatcher::onFileChanged);
+    });
+    connect(&mWatcher, &QFileSystemWatcher::directoryChanged, this, [this] (const QString &path) {
+        notifyClients(path, &FileSystemWatcher::onDirectoryChanged);
+    });
+}
+
+/**
+ * Adds the given \a paths, which should not already be watched by
+ * \a client. Paths that are new to the backend are added in one batch.
+ */
+void FileSystemWatcherBackend::addPaths(FileSystemWatcher *client, const QStringList &paths)
+{
+    QStringList pathsToAdd;
+
+    for (const QString &path : paths) {
+        QVector<FileSystemWatcher*> &clients = mClients[path];
+        if (clients.isEmpty())
+            pathsToAdd.append(path);
+        clients.append(client);
+    }
+
+    if (!pathsToAdd.isEmpty())
+        mWatcher.addPaths(pathsToAdd);
+}
+
+void FileSystemWatcherBackend::removePaths(FileSystemWatcher *client, const QStringList &paths)
+{
+    QStringList pathsToRemove;
+
+    for (const QString &path : paths) {
+        auto it = mClients.find(path);
+        if (it == mClients.end())
+            continue;
+
+        it.value().removeOne(client);
+        if (it.value().isEmpty()) {
+            mClients.erase(it);
+            pathsToRemove.append(path);
+        }
+    }
+
+    if (!pathsToRemove.isEmpty())
+        mWatcher.removePaths(pathsToRemove);
+}
+
+/**
+ * If a file was replaced, the watcher is automatically removed and needs
+ * to be re-added to keep watching it for changes. This happens commonly
+ * with applications that do atomic saving.
+ */
+void FileSystemWatcherBackend::restoreWatches(const QStringList &paths)
+{
+    QStringList watchedFiles;
+    bool watchedFilesKnown = false;
+
+    for (const QString &path : paths) {
+        if (!mClients.contains(path))
+            continue;
+
+        if (!watchedFilesKnown) {
+            watchedFiles = mWatcher.files();
+            watchedFiles.append(mWatcher.directories());
+            watchedFilesKnown = true;
+        }
+
+        if (!watchedFiles.contains(path) && QFile::exists(path))
+            mWatcher.addPath(path);
+    }
+}
+
+template<typename Handler>
+void FileSystemWatcherBackend::notifyClients(const QString &path, Handler handler)
+{
+    // Copied, since clients may add or remove paths, or even be deleted, in
+    // response to the notification
+    QVector<QPointer<FileSystemWatcher>> clients;
+    for (FileSystemWatcher *client : mClients.value(path))
+        clients.append(client);
+
+    for (const QPointer<FileSystemWatcher> &client : std::as_const(clients))
+        if (client)
+            (client->*handler)(path);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 FileSystemWatcher::FileSystemWatcher(QObject *parent) :
-    QObject(parent),
-    mWatcher(new QFileSystemWatcher(this))
+    QObject(parent)
 {
     mChangedPathsTimer.setInterval(500);
     mChangedPathsTimer.setSingleShot(true);
 
-    connect(mWatcher, &QFileSystemWatcher::fileChanged,
-            this, &FileSystemWatcher::onFileChanged);
-    connect(mWatcher, &QFileSystemWatcher::directoryChanged,
-            this, &FileSystemWatcher::onDirectoryChanged);
-
     connect(&mChangedPathsTimer, &QTimer::timeout,
             this, &FileSystemWatcher::pathsChangedTimeout);
 }
 
+FileSystemWatcher::~FileSystemWatcher()
+{
+    clearInternal();
+}
+
 void FileSystemWatcher::setEnabled(bool enabled)
 {
     if (mEnabled == enabled)
         return;
 
-    mEnabled = enabled;
-
     if (enabled) {
+        mEnabled = true;
+
         const auto files = mWatchCount.keys();
         if (!files.isEmpty())
-            mWatcher->addPaths(files);
+            if (auto backend = FileSystemWatcherBackend::instance())
+                backend->addPaths(this, files);
     } else {
         clearInternal();
         mChangedPathsTimer.stop();
+
+        mEnabled = false;
     }
 }
 
@@ -91,7 +228,8 @@ void FileSystemWatcher::addPaths(const QStringList &paths)
     }
 
     if (!pathsToAdd.isEmpty())
-        mWatcher->addPaths(pathsToAdd);
+        if (auto backend = FileSystemWatcherBackend::instance())
+            backend->addPaths(this, pathsToAdd);
 }
 
 void FileSystemWatcher::removePaths(const QStringList &paths)
@@ -119,18 +257,20 @@ void FileSystemWatcher::removePaths(const QStringList &paths)
     }
 
     if (!pathsToRemove.isEmpty())
-        mWatcher->removePaths(pathsToRemove);
+        if (auto backend = FileSystemWatcherBackend::instance())
+            backend->removePaths(this, pathsToRemove);
 }
 
+/**
+ * Stops watching all paths, without forgetting them.
+ */
 void FileSystemWatcher::clearInternal()
 {
-    const QStringList files = mWatcher->files();
-    if (!files.isEmpty())
-        mWatcher->removePaths(files);
+    if (!mEnabled || mWatchCount.isEmpty())
+        return;
 
-    const QStringList directories = mWatcher->directories();
-    if (!directories.isEmpty())
-        mWatcher->removePaths(directories);
+    if (auto backend = FileSystemWatcherBackend::instance())
+        backend->removePaths(this, mWatchCount.keys());
 }
 
 void FileSystemWatcher::clear()
@@ -159,16 +299,8 @@ void FileSystemWatcher::pathsChangedTimeout()
 {
     const auto changedPaths = mChangedPaths.values();
 
-    // If the file was replaced, the watcher is automatically removed and needs
-    // to be re-added to keep watching it for changes. This happens commonly
-    // with applications that do atomic saving.
-    for (const QString &path : changedPaths) {
-        if (mWatchCount.contains(path) && !mWatcher->files().contains(path)) {
-            if (QFile::exists(path))
-                mWatcher->addPath(path);
-        }
-    }
-
+    if (auto backend = FileSystemWatcherBackend::instance())
+        backend->restoreWatches(changedPaths);
 
     emit pathsChanged(changedPaths);
 
@@ -35,15 +35,19 @@
 #include <QSet>
 #include <QTimer>
 
-class QFileSystemWatcher;
-
 namespace Tiled {
 
+class FileSystemWatcherBackend;
+
 /**
  * A wrapper around QFileSystemWatcher that deals gracefully with files being
  * watched multiple times. It also doesn't start complaining when a file
  * doesn't exist.
  *
+ * All instances share a single QFileSystemWatcher, so that each path is only
+ * watched once by the operating system, no matter how many instances watch
+ * it.
+ *
  * It's meant to be used as drop-in replacement for QFileSystemWatcher.
  *
  * Optionally, the 'pathsChanged' signal can be used, which triggers at a delay
@@ -56,6 +60,7 @@ class TILEDSHARED_EXPORT FileSystemWatcher : public QObject
 
 public:
     explicit FileSystemWatcher(QObject *parent = nullptr);
+    ~FileSystemWatcher() override;
 
     void setEnabled(bool enabled);
     bool isEnabled() const;
@@ -79,12 +84,13 @@ signals:
     void pathsChanged(const QStringList &paths);
 
 private:
+    friend class FileSystemWatcherBackend;
+
     void onFileChanged(const QString &path);
     void onDirectoryChanged(const QString &path);
     void pathsChangedTimeout();
     void clearInternal();
 
-    QFileSystemWatcher *mWatcher;
     QMap<QString, int> mWatchCount;
 
     QSet<QString> mChangedPaths;
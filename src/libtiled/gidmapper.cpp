@@ -28,12 +28,16 @@
 
 #include "gidmapper.h"
 
+#include "base64.h"
 #include "compression.h"
 #include "tile.h"
 #include "tiled.h"
 #include "tileset.h"
 
+#include <QtEndian>
+
 #include <algorithm>
+#include <vector>
 
 using namespace Tiled;
 
@@ -44,6 +48,26 @@ const unsigned FlippedAntiDiagonallyFlag = 0x20000000;
 
 const unsigned RotatedHexagonal120Flag   = 0x10000000;
 
+const unsigned AllFlags = FlippedHorizontallyFlag |
+                          FlippedVerticallyFlag |
+                          FlippedAntiDiagonallyFlag |
+                          RotatedHexagonal120Flag;
+
+const int FlagsShift = 28;
+const unsigned GidLimit = ~AllFlags + 1;
+
+/**
+ * Returns the GID flags matching the given cell \a flags.
+ */
+static unsigned cellFlagsToGidFlags(int flags)
+{
+    // The order of the flags in the GID is reversed compared to Cell::Flags
+    static constexpr unsigned char reversed[16] = {
+        0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15
+    };
+    return static_cast<unsigned>(reversed[flags & Cell::VisualFlags]) << FlagsShift;
+}
+
 /**
  * Default constructor. Use \l insert to initialize the gid mapper
  * incrementally.
@@ -122,28 +146,25 @@ unsigned GidMapper::cellToGid(const Cell &cell) const
     if (cell.isEmpty())
         return 0;
 
-    const Tileset *tileset = cell.tileset();
+    const unsigned firstGid = this->firstGid(cell.tileset());
+    if (firstGid == 0) // tileset not found
+        return 0;
+
+    return (firstGid + cell.tileId()) | cellFlagsToGidFlags(cell.flags());
+}
 
-    // Find the first GID for the tileset
+/**
+ * Returns the first global ID of the given \a tileset, or 0 when the tileset
+ * isn't known.
+ */
+unsigned GidMapper::firstGid(const Tileset *tileset) const
+{
     QMap<unsigned, SharedTileset>::const_iterator i = mFirstGidToTileset.begin();
     QMap<unsigned, SharedTileset>::const_iterator i_end = mFirstGidToTileset.end();
     while (i != i_end && i.value() != tileset)
         ++i;
 
-    if (i == i_end) // tileset not found
-        return 0;
-
-    unsigned gid = i.key() + cell.tileId();
-    if (cell.flippedHorizontally())
-        gid |= FlippedHorizontallyFlag;
-    if (cell.flippedVertically())
-        gid |= FlippedVerticallyFlag;
-    if (cell.flippedAntiDiagonally())
-        gid |= FlippedAntiDiagonallyFlag;
-    if (cell.rotatedHexagonal120())
-        gid |= RotatedHexagonal120Flag;
-
-    return gid;
+    return i != i_end ? i.key() : 0;
 }
 
 /**
@@ -156,23 +177,12 @@ QByteArray GidMapper::encodeLayerData(const TileLayer &tileLayer,
                                       QRect bounds, int compressionLevel) const
 {
     Q_ASSERT(format != Map::XML);
-    Q_ASSERT(format != Map::CSV);
 
     if (bounds.isEmpty())
         bounds = QRect(0, 0, tileLayer.width(), tileLayer.height());
 
-    QByteArray tileData;
-    tileData.reserve(bounds.width() * bounds.height() * 4);
-
-    for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
-        for (int x = bounds.left(); x <= bounds.right(); ++x) {
-            const unsigned gid = cellToGid(tileLayer.cellAt(x, y));
-            tileData.append(static_cast<char>(gid));
-            tileData.append(static_cast<char>(gid >> 8));
-            tileData.append(static_cast<char>(gid >> 16));
-            tileData.append(static_cast<char>(gid >> 24));
-        }
-    }
+    QByteArray tileData = gidData(tileLayer, bounds,
+                                  format == Map::Base64ZstandardDictionary);
 
     if (format == Map::Base64Gzip)
         tileData = compress(tileData, Gzip, compressionLevel);
@@ -180,56 +190,498 @@ QByteArray GidMapper::encodeLayerData(const TileLayer &tileLayer,
         tileData = compress(tileData, Zlib, compressionLevel);
     else if (format == Map::Base64Zstandard)
         tileData = compress(tileData, Zstandard, compressionLevel);
+    else if (format == Map::Base64ZstandardDictionary && mCompressionDictionary.isNull())
+        tileData = compress(tileData, Zstandard, compressionLevel);
+    else if (format == Map::Base64ZstandardDictionary)
+        tileData = mCompressionDictionary.compress(tileData);
 
-    return tileData.toBase64();
+    return Base64::encode(tileData);
 }
 
-GidMapper::DecodeError GidMapper::decodeLayerData(TileLayer &tileLayer,
-                                                  const QByteArray &layerData,
-                                                  Map::LayerDataFormat format,
-                                                  QRect bounds) const
+/**
+ * Returns the GIDs of the cells within \a bounds as little-endian 32-bit
+ * values.
+ *
+ * When \a deltaFiltered is true, each value is the difference with the
+ * previous GID instead. Since neighboring cells often use the same or
+ * consecutive tiles, this results in many repeated values that compress
+ * well.
+ */
+QByteArray GidMapper::gidData(const TileLayer &tileLayer, QRect bounds,
+                              bool deltaFiltered) const
 {
-    Q_ASSERT(format != Map::XML);
-    Q_ASSERT(format != Map::CSV);
+    QByteArray tileData(bounds.width() * bounds.height() * 4, Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar*>(tileData.data());
 
-    QByteArray decodedData = QByteArray::fromBase64(layerData);
-    const int size = bounds.width() * bounds.height() * 4;
+    // Adjacent cells usually refer to the same tileset, so remember the
+    // first GID of the last one instead of looking it up for each cell.
+    const Tileset *lastTileset = nullptr;
+    unsigned lastFirstGid = 0;
+    quint32 previousGid = 0;
+
+    for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+        for (int x = bounds.left(); x <= bounds.right(); ++x) {
+            const Cell cell = tileLayer.cellAt(x, y);
+            unsigned gid = 0;
+
+            if (const Tileset *tileset = cell.tileset()) {
+                if (tileset != lastTileset) {
+                    lastTileset = tileset;
+                    lastFirstGid = firstGid(tileset);
+                }
+                if (lastFirstGid)
+                    gid = (lastFirstGid + cell.tileId()) | cellFlagsToGidFlags(cell.flags());
+            }
+
+            if (deltaFiltered) {
+                const quint32 delta = gid - previousGid;
+                previousGid = gid;
+                gid = delta;
+            }
+
+            qToLittleEndian<quint32>(gid, out);
+            out += 4;
+        }
+    }
+
+    return tileData;
+}
+
+/**
+ * Trains a compression dictionary for the Base64ZstandardDictionary layer
+ * data format on the tile layers of the given \a map.
+ *
+ * The samples are the delta filtered chunks of infinite maps, or bands of
+ * rows for fixed-size maps. Returns a null dictionary when there are too
+ * few samples for a dictionary to be worth storing.
+ */
+CompressionDictionary GidMapper::trainCompressionDictionary(const Map &map,
+                                                            int compressionLevel) const
+{
+    // Training time grows with the amount of samples, while the dictionary
+    // hardly improves beyond a certain amount
+    constexpr int minimumSampleCount = 32;
+    constexpr qint64 maximumSamplesSize = 8 * 1024 * 1024;
+    constexpr int maximumDictionarySize = 16 * 1024;
+
+    QVector<QByteArray> samples;
+    qint64 samplesSize = 0;
+
+    auto addSample = [&] (const TileLayer &tileLayer, QRect bounds) {
+        if (samplesSize >= maximumSamplesSize)
+            return;
+
+        samples.append(gidData(tileLayer, bounds, true));
+        samplesSize += samples.last().size();
+    };
+
+    const QSize chunkSize = map.chunkSize();
+
+    for (const Layer *layer : map.tileLayers()) {
+        auto tileLayer = static_cast<const TileLayer*>(layer);
+
+        if (map.infinite()) {
+            const auto chunks = tileLayer->sortedChunksToWrite(chunkSize);
+            for (const QRect &rect : chunks)
+                addSample(*tileLayer, rect);
+        } else {
+            for (int y = 0; y < tileLayer->height(); y += CHUNK_SIZE) {
+                addSample(*tileLayer, QRect(0, y, tileLayer->width(),
+                                            std::min(CHUNK_SIZE, tileLayer->height() - y)));
+            }
+        }
+    }
+
+    if (samples.size() < minimumSampleCount)
+        return CompressionDictionary();
+
+    const int maximumSize = static_cast<int>(std::min<qint64>(maximumDictionarySize,
+                                                              samplesSize / 16));
+    return CompressionDictionary::train(samples, maximumSize, compressionLevel);
+}
+
+/**
+ * Decodes base64 encoded and optionally compressed layer data in parts,
+ * writing the cells straight into the tile layer. This way, only small
+ * buffers are needed regardless of the size of the layer.
+ */
+class GidMapper::LayerDataDecoder
+{
+public:
+    LayerDataDecoder(const GidMapper &gidMapper,
+                     TileLayer &tileLayer,
+                     Map::LayerDataFormat format,
+                     QRect bounds);
+
+    bool addBase64(const char *data, int size);
+    bool addBase64(QStringView data);
+    bool addParsedGids(const unsigned *gids, qint64 count);
+
+    DecodeError finish();
+
+    unsigned invalidTile() const { return mInvalidTile; }
+
+    void setMaxTileIds(MaxTileIds *maxTileIds) { mMaxTileIds = maxTileIds; }
+
+private:
+    template<typename Char>
+    bool addBase64Slices(const Char *data, qint64 size);
+    bool addDecoded(const char *data, int size);
+    bool addGids(const char *data, int size);
+    unsigned readGid(const char *data);
+    bool setCell(unsigned gid);
+    void finishRange();
+
+    const GidMapper &mGidMapper;
+    TileLayer &mTileLayer;
+    const QRect mBounds;
+    const qint64 mCellCount;
+    qint64 mCellIndex = 0;
+    int mX;
+    int mY;
+
+    std::unique_ptr<Decompressor> mDecompressor;
+    Base64::Decoder mBase64Decoder;
+    QByteArray mDecoded;
+    char mPartialGid[4];
+    int mPartialGidSize = 0;
+
+    // Whether the GIDs are stored as differences with the previous GID
+    bool mDeltaFiltered = false;
+    quint32 mPreviousGid = 0;
+
+    DecodeError mError = NoError;
+    unsigned mInvalidTile = 0;
+
+    // Cells with each combination of flags, indexed by the top 4 GID bits
+    Cell mFlaggedCells[16];
+
+    // The GID range of the tileset used by the previous cell. Since adjacent
+    // cells usually refer to the same tileset, this avoids most lookups.
+    unsigned mRangeStart = 0;
+    unsigned mRangeEnd = 0;
+    Tileset *mRangeTileset = nullptr;
+    int mRangeMaxTileId = -1;
+
+    MaxTileIds *mMaxTileIds = nullptr;
+};
+
+// The size of the parts in which the base64 data is decoded
+static const int Base64SliceSize = 64 * 1024;
+
+GidMapper::LayerDataDecoder::LayerDataDecoder(const GidMapper &gidMapper,
+                                              TileLayer &tileLayer,
+                                              Map::LayerDataFormat format,
+                                              QRect bounds)
+    : mGidMapper(gidMapper)
+    , mTileLayer(tileLayer)
+    , mBounds(bounds)
+    , mCellCount(qint64(bounds.width()) * bounds.height())
+    , mX(bounds.x())
+    , mY(bounds.y())
+{
+    Q_ASSERT(format != Map::XML);
 
     if (format == Map::Base64Gzip)
-        decodedData = decompress(decodedData, size, Gzip);
+        mDecompressor = std::make_unique<Decompressor>(Gzip);
     else if (format == Map::Base64Zlib)
-        decodedData = decompress(decodedData, size, Zlib);
+        mDecompressor = std::make_unique<Decompressor>(Zlib);
     else if (format == Map::Base64Zstandard)
-        decodedData = decompress(decodedData, size, Zstandard);
-
-    if (size != decodedData.length())
-        return CorruptLayerData;
-
-    const unsigned char *data = reinterpret_cast<const unsigned char*>(decodedData.constData());
-    int x = bounds.x();
-    int y = bounds.y();
-    bool ok;
-
-    for (int i = 0; i < size - 3; i += 4) {
-        const unsigned gid = data[i] |
-                             data[i + 1] << 8 |
-                             data[i + 2] << 16 |
-                             data[i + 3] << 24;
-
-        const Cell result = gidToCell(gid, ok);
-        if (!ok) {
-            mInvalidTile = gid;
-            return isEmpty() ? TileButNoTilesets : InvalidTile;
+        mDecompressor = std::make_unique<Decompressor>(Zstandard);
+    else if (format == Map::Base64ZstandardDictionary && gidMapper.mCompressionDictionary.isNull())
+        mDecompressor = std::make_unique<Decompressor>(Zstandard);
+    else if (format == Map::Base64ZstandardDictionary)
+        mDecompressor = std::make_unique<Decompressor>(gidMapper.mCompressionDictionary);
+
+    mDeltaFiltered = format == Map::Base64ZstandardDictionary;
+
+    for (unsigned flags = 0; flags < 16; ++flags) {
+        const unsigned gidFlags = flags << FlagsShift;
+        mFlaggedCells[flags].setFlippedHorizontally(gidFlags & FlippedHorizontallyFlag);
+        mFlaggedCells[flags].setFlippedVertically(gidFlags & FlippedVerticallyFlag);
+        mFlaggedCells[flags].setFlippedAntiDiagonally(gidFlags & FlippedAntiDiagonallyFlag);
+        mFlaggedCells[flags].setRotatedHexagonal120(gidFlags & RotatedHexagonal120Flag);
+    }
+
+    mDecoded.reserve(Base64SliceSize / 4 * 3 + 3);
+}
+
+/**
+ * Adds the next part of the base64 encoded data. Characters outside of the
+ * base64 alphabet, like whitespace, are skipped.
+ */
+bool GidMapper::LayerDataDecoder::addBase64(const char *data, int size)
+{
+    return addBase64Slices(data, size);
+}
+
+bool GidMapper::LayerDataDecoder::addBase64(QStringView data)
+{
+    return addBase64Slices(reinterpret_cast<const char16_t*>(data.utf16()), data.size());
+}
+
+template<typename Char>
+bool GidMapper::LayerDataDecoder::addBase64Slices(const Char *data, qint64 size)
+{
+    const Char *end = data + size;
+
+    while (data != end) {
+        const qint64 sliceSize = std::min<qint64>(end - data, Base64SliceSize);
+
+        mBase64Decoder.decode(data, sliceSize, mDecoded);
+        data += sliceSize;
+
+        if (!addDecoded(mDecoded.constData(), mDecoded.size()))
+            return false;
+    }
+
+    return true;
+}
+
+bool GidMapper::LayerDataDecoder::addDecoded(const char *data, int size)
+{
+    if (!mDecompressor)
+        return addGids(data, size);
+
+    if (!mDecompressor->decompress(data, size, [this] (const char *gids, int gidsSize) {
+                                       return addGids(gids, gidsSize);
+                                   })) {
+        if (mError == NoError)
+            mError = CorruptLayerData;
+        return false;
+    }
+
+    return true;
+}
+
+bool GidMapper::LayerDataDecoder::addGids(const char *data, int size)
+{
+    const char *end = data + size;
+
+    // Complete a GID that was split over two parts
+    while (mPartialGidSize > 0 && data != end) {
+        mPartialGid[mPartialGidSize++] = *data++;
+        if (mPartialGidSize == 4) {
+            mPartialGidSize = 0;
+            if (!setCell(readGid(mPartialGid)))
+                return false;
+        }
+    }
+
+    for (; end - data >= 4; data += 4)
+        if (!setCell(readGid(data)))
+            return false;
+
+    while (data != end)
+        mPartialGid[mPartialGidSize++] = *data++;
+
+    return true;
+}
+
+inline unsigned GidMapper::LayerDataDecoder::readGid(const char *data)
+{
+    const quint32 value = qFromLittleEndian<quint32>(data);
+    if (!mDeltaFiltered)
+        return value;
+
+    mPreviousGid += value;
+    return mPreviousGid;
+}
+
+/**
+ * Adds GIDs that were already parsed, for example from CSV layer data.
+ */
+bool GidMapper::LayerDataDecoder::addParsedGids(const unsigned *gids, qint64 count)
+{
+    for (const unsigned *end = gids + count; gids != end; ++gids)
+        if (!setCell(*gids))
+            return false;
+
+    return true;
+}
+
+bool GidMapper::LayerDataDecoder::setCell(unsigned gid)
+{
+    if (mCellIndex == mCellCount) {
+        mError = CorruptLayerData;  // too much data
+        return false;
+    }
+
+    const unsigned tileGid = gid & ~AllFlags;
+    Cell cell = mFlaggedCells[gid >> FlagsShift];
+
+    if (tileGid != 0) {
+        if (tileGid < mRangeStart || tileGid >= mRangeEnd) {
+            finishRange();
+
+            // Find the tileset containing this tile
+            const auto &firstGidToTileset = mGidMapper.mFirstGidToTileset;
+            auto i = firstGidToTileset.upperBound(tileGid);
+            if (i == firstGidToTileset.begin()) {
+                // Invalid global tile ID, since it lies before the first
+                // tileset (or there are no tilesets)
+                mInvalidTile = gid;
+                mError = mGidMapper.isEmpty() ? TileButNoTilesets : InvalidTile;
+                return false;
+            }
+
+            mRangeEnd = i == firstGidToTileset.end() ? GidLimit : i.key();
+            --i; // Navigate one tileset back since upper bound finds the next
+            mRangeStart = i.key();
+            mRangeTileset = i.value().data();
         }
 
-        tileLayer.setCell(x, y, result);
+        const int tileId = tileGid - mRangeStart;
+        mRangeMaxTileId = std::max(mRangeMaxTileId, tileId);
+        cell.setTile(mRangeTileset, tileId);
+    }
+
+    mTileLayer.setCell(mX, mY, cell);
+
+    ++mCellIndex;
+    if (++mX > mBounds.right()) {
+        mX = mBounds.x();
+        ++mY;
+    }
 
-        x++;
-        if (x > bounds.right()) {
-            x = bounds.x();
-            y++;
+    return true;
+}
+
+/**
+ * Adjusts the next tile ID of the tileset used by the last range of cells,
+ * in order to preserve tile references even to tilesets that failed to load.
+ *
+ * When collecting the highest tile IDs, the tileset is left untouched.
+ */
+void GidMapper::LayerDataDecoder::finishRange()
+{
+    if (mRangeTileset && mRangeMaxTileId >= 0) {
+        if (mMaxTileIds) {
+            auto it = mMaxTileIds->find(mRangeTileset);
+            if (it == mMaxTileIds->end())
+                mMaxTileIds->insert(mRangeTileset, mRangeMaxTileId);
+            else
+                *it = std::max(*it, mRangeMaxTileId);
+        } else if (mRangeMaxTileId >= mRangeTileset->nextTileId()) {
+            mRangeTileset->setNextTileId(mRangeMaxTileId + 1);
         }
     }
+    mRangeMaxTileId = -1;
+}
+
+/**
+ * Decodes any remaining data and checks whether the expected amount of data
+ * was provided.
+ */
+GidMapper::DecodeError GidMapper::LayerDataDecoder::finish()
+{
+    if (mError == NoError) {
+        mBase64Decoder.finish(mDecoded);
+        if (!mDecoded.isEmpty())
+            addDecoded(mDecoded.constData(), mDecoded.size());
+    }
+
+    finishRange();
+
+    if (mError == NoError) {
+        if (mCellIndex != mCellCount || mPartialGidSize != 0)
+            mError = CorruptLayerData;
+        else if (mDecompressor && mCellCount > 0 && !mDecompressor->isFinished())
+            mError = CorruptLayerData;
+    }
 
-    return NoError;
+    return mError;
+}
+
+GidMapper::DecodeError GidMapper::decodeLayerData(TileLayer &tileLayer,
+                                                  const QByteArray &layerData,
+                                                  Map::LayerDataFormat format,
+                                                  QRect bounds) const
+{
+    LayerDataDecoder decoder(*this, tileLayer, format, bounds);
+    decoder.addBase64(layerData.constData(), layerData.size());
+
+    const DecodeError error = decoder.finish();
+    if (error == InvalidTile || error == TileButNoTilesets)
+        mInvalidTile = decoder.invalidTile();
+
+    return error;
+}
+
+/**
+ * Overload that decodes the base64 encoded \a layerData directly from a
+ * string, without converting it to Latin-1 as a whole.
+ */
+GidMapper::DecodeError GidMapper::decodeLayerData(TileLayer &tileLayer,
+                                                  QStringView layerData,
+                                                  Map::LayerDataFormat format,
+                                                  QRect bounds) const
+{
+    LayerDataDecoder decoder(*this, tileLayer, format, bounds);
+    decoder.addBase64(layerData);
+
+    const DecodeError error = decoder.finish();
+    if (error == InvalidTile || error == TileButNoTilesets)
+        mInvalidTile = decoder.invalidTile();
+
+    return error;
+}
+
+/**
+ * Overload that does not modify any tilesets nor the state of the GidMapper,
+ * so that it can be used to decode different layers from multiple threads.
+ *
+ * Instead of adjusting the next tile ID of the referenced tilesets, the
+ * highest used tile IDs are collected in \a state. Call updateNextTileIds()
+ * when done decoding.
+ */
+GidMapper::DecodeError GidMapper::decodeLayerData(TileLayer &tileLayer,
+                                                  QStringView layerData,
+                                                  Map::LayerDataFormat format,
+                                                  QRect bounds,
+                                                  DecodeState &state) const
+{
+    LayerDataDecoder decoder(*this, tileLayer, format, bounds);
+    decoder.setMaxTileIds(&state.maxTileIds);
+    decoder.addBase64(layerData);
+
+    const DecodeError error = decoder.finish();
+    if (error == InvalidTile || error == TileButNoTilesets)
+        state.invalidTile = decoder.invalidTile();
+
+    return error;
+}
+
+/**
+ * Sets the cells within \a bounds of \a tileLayer to the given \a count
+ * already parsed \a gids, in row-major order.
+ *
+ * This is much faster than calling gidToCell() for each GID, since the
+ * tileset is only looked up when it differs from the one of the previous
+ * cell.
+ */
+GidMapper::DecodeError GidMapper::decodeGids(TileLayer &tileLayer,
+                                             const unsigned *gids,
+                                             qint64 count,
+                                             QRect bounds) const
+{
+    LayerDataDecoder decoder(*this, tileLayer, Map::CSV, bounds);
+    decoder.addParsedGids(gids, count);
+
+    const DecodeError error = decoder.finish();
+    if (error == InvalidTile || error == TileButNoTilesets)
+        mInvalidTile = decoder.invalidTile();
+
+    return error;
+}
+
+/**
+ * Makes sure the next tile ID of each tileset is higher than the highest
+ * tile ID collected in \a maxTileIds.
+ */
+void GidMapper::updateNextTileIds(const MaxTileIds &maxTileIds)
+{
+    for (auto it = maxTileIds.begin(), end = maxTileIds.end(); it != end; ++it)
+        if (it.value() >= it.key()->nextTileId())
+            it.key()->setNextTileId(it.value() + 1);
 }
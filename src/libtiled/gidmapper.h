@@ -28,9 +28,11 @@
 
 #pragma once
 
+#include "compression.h"
 #include "map.h"
 #include "tilelayer.h"
 
+#include <QHash>
 #include <QMap>
 
 namespace Tiled {
@@ -56,6 +58,12 @@ public:
                                QRect bounds = QRect(),
                                int compressionLevel = -1) const;
 
+    void setCompressionDictionary(const CompressionDictionary &dictionary);
+    const CompressionDictionary &compressionDictionary() const;
+
+    CompressionDictionary trainCompressionDictionary(const Map &map,
+                                                     int compressionLevel = -1) const;
+
     enum DecodeError {
         NoError = 0,
         CorruptLayerData,
@@ -68,10 +76,47 @@ public:
                                 Map::LayerDataFormat format,
                                 QRect bounds) const;
 
+    DecodeError decodeLayerData(TileLayer &tileLayer,
+                                QStringView layerData,
+                                Map::LayerDataFormat format,
+                                QRect bounds) const;
+
+    DecodeError decodeGids(TileLayer &tileLayer,
+                           const unsigned *gids,
+                           qint64 count,
+                           QRect bounds) const;
+
+    using MaxTileIds = QHash<Tileset*, int>;
+
+    /**
+     * Collects the results of decoding layer data which would otherwise be
+     * stored in shared places (see the thread-safe decodeLayerData()).
+     */
+    struct DecodeState
+    {
+        MaxTileIds maxTileIds;
+        unsigned invalidTile = 0;
+    };
+
+    DecodeError decodeLayerData(TileLayer &tileLayer,
+                                QStringView layerData,
+                                Map::LayerDataFormat format,
+                                QRect bounds,
+                                DecodeState &state) const;
+
+    static void updateNextTileIds(const MaxTileIds &maxTileIds);
+
     unsigned invalidTile() const;
 
 private:
+    class LayerDataDecoder;
+
+    unsigned firstGid(const Tileset *tileset) const;
+    QByteArray gidData(const TileLayer &tileLayer, QRect bounds,
+                       bool deltaFiltered) const;
+
     QMap<unsigned, SharedTileset> mFirstGidToTileset;
+    CompressionDictionary mCompressionDictionary;
 
     mutable unsigned mInvalidTile = 0;
 };
@@ -93,6 +138,20 @@ inline void GidMapper::clear()
     mFirstGidToTileset.clear();
 }
 
+/**
+ * Sets the \a dictionary used for the Base64ZstandardDictionary layer data
+ * format. Without a dictionary, that format uses plain Zstandard frames.
+ */
+inline void GidMapper::setCompressionDictionary(const CompressionDictionary &dictionary)
+{
+    mCompressionDictionary = dictionary;
+}
+
+inline const CompressionDictionary &GidMapper::compressionDictionary() const
+{
+    return mCompressionDictionary;
+}
+
 /**
  * Returns true when no tilesets are known to this gid mapper.
  */
@@ -147,6 +147,9 @@ void HexagonalRenderer::drawGrid(QPainter *painter, const QRectF &exposed,
     if (majorGridPen.color().alpha() <= 0)
         return;
 
+    // The minor lines fade out when zoomed out, at which point we skip them
+    const bool drawMinorLines = gridPen.color().alpha() > 0;
+
     if (p.staggerX) {
         // Prevent possible infinite loop
         if (p.columnWidth <= 0 || p.tileHeight + p.sideLengthY <= 0)
@@ -203,8 +206,10 @@ void HexagonalRenderer::drawGrid(QPainter *painter, const QRectF &exposed,
 
             startPos.rx() += p.columnWidth;
 
-            painter->setPen(gridPen);
-            painter->drawLines(minorLines.constData(), minorLines.size());
+            if (drawMinorLines) {
+                painter->setPen(gridPen);
+                painter->drawLines(minorLines.constData(), minorLines.size());
+            }
             painter->setPen(majorGridPen);
             painter->drawLines(majorLines.constData(), majorLines.size());
             minorLines.clear();
@@ -268,8 +273,10 @@ void HexagonalRenderer::drawGrid(QPainter *painter, const QRectF &exposed,
 
             startPos.ry() += p.rowHeight;
 
-            painter->setPen(gridPen);
-            painter->drawLines(minorLines.constData(), minorLines.size());
+            if (drawMinorLines) {
+                painter->setPen(gridPen);
+                painter->drawLines(minorLines.constData(), minorLines.size());
+            }
             painter->setPen(majorGridPen);
             painter->drawLines(majorLines.constData(), majorLines.size());
             minorLines.clear();
@@ -384,10 +391,8 @@ void HexagonalRenderer::drawTileLayer(const RenderTileCallback &renderTile,
     }
 }
 
-void HexagonalRenderer::drawTileSelection(QPainter *painter,
-                                          const QRegion &region,
-                                          const QColor &color,
-                                          const QRectF &exposed) const
+QPainterPath HexagonalRenderer::tileSelectionOutline(const QRegion &region,
+                                                    const QRectF &exposed) const
 {
     QPainterPath path;
 
@@ -395,22 +400,13 @@ void HexagonalRenderer::drawTileSelection(QPainter *painter,
         for (int y = r.top(); y <= r.bottom(); ++y) {
             for (int x = r.left(); x <= r.right(); ++x) {
                 const QPolygonF polygon = tileToScreenPolygon(x, y);
-                if (QRectF(polygon.boundingRect()).intersects(exposed))
+                if (exposed.isNull() || QRectF(polygon.boundingRect()).intersects(exposed))
                     path.addPolygon(polygon);
             }
         }
     }
 
-    QColor penColor(color);
-    penColor.setAlpha(255);
-
-    QPen pen(penColor);
-    pen.setCosmetic(true);
-
-    painter->setPen(pen);
-    painter->setBrush(color);
-    painter->setRenderHint(QPainter::Antialiasing, true);
-    painter->drawPath(path.simplified());
+    return path.simplified();
 }
 
 QPointF HexagonalRenderer::tileToPixelCoords(qreal x, qreal y) const
@@ -85,10 +85,8 @@ public:
     void drawTileLayer(const RenderTileCallback &renderTile,
                        const QRectF &exposed) const override;
 
-    void drawTileSelection(QPainter *painter,
-                           const QRegion &region,
-                           const QColor &color,
-                           const QRectF &exposed) const override;
+    QPainterPath tileSelectionOutline(const QRegion &region,
+                                      const QRectF &exposed) const override;
 
     using OrthogonalRenderer::pixelToTileCoords;
     QPointF pixelToTileCoords(qreal x, qreal y) const override;
@@ -28,6 +28,7 @@
 
 #include "imagecache.h"
 
+#include "diskimagecache.h"
 #include "logginginterface.h"
 #include "mapformat.h"
 #include "minimaprenderer.h"
@@ -35,19 +36,12 @@
 #include <QBitmap>
 #include <QCoreApplication>
 #include <QFileInfo>
+#include <QHash>
 
-namespace Tiled {
-
-struct LoadedPixmap
-{
-    explicit LoadedPixmap(const LoadedImage &cachedImage);
-
-    operator const QPixmap &() const { return pixmap; }
-
-    QPixmap pixmap;
-    QDateTime lastModified;
-};
+#include <algorithm>
+#include <limits>
 
+namespace Tiled {
 
 LoadedImage::LoadedImage()
     : LoadedImage(QImage(), QDateTime())
@@ -59,64 +53,307 @@ LoadedImage::LoadedImage(QImage image, const QDateTime &lastModified)
 {}
 
 
-LoadedPixmap::LoadedPixmap(const LoadedImage &cachedImage)
-    : pixmap(QPixmap::fromImage(cachedImage))
-    , lastModified(cachedImage.lastModified)
-{}
+namespace {
 
+struct CachedImage
+{
+    LoadedImage loaded;
+    quint64 lastUsed;
+};
 
-QHash<QString, LoadedImage> ImageCache::sLoadedImages;
-QHash<QString, LoadedPixmap> ImageCache::sLoadedPixmaps;
+struct CachedPixmap
+{
+    QPixmap pixmap;
+    QDateTime lastModified;
+    quint64 lastUsed;
+};
 
-LoadedImage ImageCache::loadImage(const QString &fileName)
+} // anonymous namespace
+
+static QHash<QString, CachedImage> loadedImages;
+static QHash<QString, CachedPixmap> loadedPixmaps;
+static ImageCache::Statistics imageCacheStatistics;
+static qint64 maximumCacheSize = qint64(512) * 1024 * 1024;
+static quint64 useCounter;
+
+static qint64 cost(const QImage &image)
 {
-    if (fileName.isEmpty())
-        return {};
+    return image.sizeInBytes();
+}
 
-    auto it = sLoadedImages.find(fileName);
+static qint64 cost(const QPixmap &pixmap)
+{
+    return static_cast<qint64>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
 
-    QFileInfo info(fileName);
-    bool found = it != sLoadedImages.end();
-    bool old = found && it.value().lastModified < info.lastModified();
+/**
+ * Evicts the least recently used entries until the cache fits its memory
+ * budget. Entries that are still referenced elsewhere are skipped, as well as
+ * the entries for the file that was just loaded (\a keep).
+ */
+static void evict(const QString &keep)
+{
+    while (imageCacheStatistics.bytes > maximumCacheSize) {
+        auto oldestImage = loadedImages.end();
+        auto oldestPixmap = loadedPixmaps.end();
+        quint64 oldest = std::numeric_limits<quint64>::max();
+
+        for (auto it = loadedImages.begin(); it != loadedImages.end(); ++it) {
+            if (it.value().lastUsed < oldest && it.key() != keep && it.value().loaded.image.isDetached()) {
+                oldest = it.value().lastUsed;
+                oldestImage = it;
+            }
+        }
+        for (auto it = loadedPixmaps.begin(); it != loadedPixmaps.end(); ++it) {
+            if (it.value().lastUsed < oldest && it.key() != keep && it.value().pixmap.isDetached()) {
+                oldest = it.value().lastUsed;
+                oldestPixmap = it;
+                oldestImage = loadedImages.end();
+            }
+        }
+
+        if (oldestPixmap != loadedPixmaps.end()) {
+            imageCacheStatistics.bytes -= cost(oldestPixmap.value().pixmap);
+            loadedPixmaps.erase(oldestPixmap);
+        } else if (oldestImage != loadedImages.end()) {
+            imageCacheStatistics.bytes -= cost(oldestImage.value().loaded.image);
+            loadedImages.erase(oldestImage);
+        } else {
+            break;  // everything left is in use
+        }
+
+        ++imageCacheStatistics.evictions;
+    }
+}
 
-    if (old)
-        remove(fileName);
+static void insertImage(const QString &fileName, LoadedImage image)
+{
+    imageCacheStatistics.bytes += cost(image.image);
+    loadedImages.insert(fileName, CachedImage { std::move(image), ++useCounter });
+    evict(fileName);
+}
+
+/**
+ * Returns the image loaded from the given file.
+ *
+ * When the image was already converted to a pixmap, the returned image is a
+ * view of the pixmap's pixels, which on the raster backend is not a copy.
+ */
+LoadedImage ImageCache::loadImage(const QString &fileName)
+{
+    if (fileName.isEmpty())
+        return {};
 
-    if (old || !found) {
-        QImage image(fileName);
+    const QDateTime lastModified = QFileInfo(fileName).lastModified();
 
-        // If the image failed to load, try to load and render a map file
-        if (image.isNull())
-            image = renderMap(fileName);
+    auto it = loadedImages.find(fileName);
+    if (it != loadedImages.end() && !(it.value().loaded.lastModified < lastModified)) {
+        ++imageCacheStatistics.hits;
+        it.value().lastUsed = ++useCounter;
+        return it.value().loaded;
+    }
 
-        it = sLoadedImages.insert(fileName, LoadedImage(image, info.lastModified()));
+    auto pixmapIt = loadedPixmaps.find(fileName);
+    if (pixmapIt != loadedPixmaps.end() && !(pixmapIt.value().lastModified < lastModified)) {
+        ++imageCacheStatistics.hits;
+        pixmapIt.value().lastUsed = ++useCounter;
+        return LoadedImage(pixmapIt.value().pixmap.toImage(), pixmapIt.value().lastModified);
     }
 
-    return it.value();
+    ++imageCacheStatistics.misses;
+    remove(fileName);
+
+    const LoadedImage loadedImage(readImage(fileName), lastModified);
+    insertImage(fileName, loadedImage);
+    return loadedImage;
 }
 
+/**
+ * Returns the pixmap for the given file.
+ *
+ * A previously loaded image of the same file is moved into the pixmap, so
+ * that the cache keeps its pixels only once.
+ */
 QPixmap ImageCache::loadPixmap(const QString &fileName)
 {
     if (fileName.isEmpty())
         return {};
 
-    auto it = sLoadedPixmaps.find(fileName);
+    const QDateTime lastModified = QFileInfo(fileName).lastModified();
+
+    auto it = loadedPixmaps.find(fileName);
+    if (it != loadedPixmaps.end()) {
+        if (!(it.value().lastModified < lastModified)) {
+            ++imageCacheStatistics.hits;
+            it.value().lastUsed = ++useCounter;
+            return it.value().pixmap;
+        }
 
-    bool found = it != sLoadedPixmaps.end();
-    bool old = found && it.value().lastModified < QFileInfo(fileName).lastModified();
+        imageCacheStatistics.bytes -= cost(it.value().pixmap);
+        loadedPixmaps.erase(it);
+    }
+
+    QImage image;
 
-    if (old)
+    auto imageIt = loadedImages.find(fileName);
+    if (imageIt != loadedImages.end() && !(imageIt.value().loaded.lastModified < lastModified)) {
+        ++imageCacheStatistics.hits;
+        imageCacheStatistics.bytes -= cost(imageIt.value().loaded.image);
+        image = std::move(imageIt.value().loaded.image);
+        loadedImages.erase(imageIt);
+    } else {
+        ++imageCacheStatistics.misses;
         remove(fileName);
-    if (old || !found)
-        it = sLoadedPixmaps.insert(fileName, LoadedPixmap(loadImage(fileName)));
+        image = readImage(fileName);
+    }
 
-    return it.value();
+    // Converts in place when nobody else holds a reference to the image.
+    // Opacity was already determined by toDisplayFormat.
+    const QPixmap pixmap = QPixmap::fromImage(toDisplayFormat(std::move(image)),
+                                              Qt::NoOpaqueDetection);
+
+    loadedPixmaps.insert(fileName, CachedPixmap { pixmap, lastModified, ++useCounter });
+    imageCacheStatistics.bytes += cost(pixmap);
+    evict(fileName);
+
+    return pixmap;
+}
+
+/**
+ * Converts the \a image to the format pixmaps use on the raster paint engine:
+ * premultiplied ARGB32 for images with translucent pixels and RGB32 for
+ * opaque ones. Images already in one of these formats are returned as-is.
+ *
+ * Turning the result into a pixmap neither converts nor scans the pixels, so
+ * this can be called on a worker thread to keep that work off the main
+ * thread. It also avoids per-draw conversions when painting the tiles.
+ */
+QImage ImageCache::toDisplayFormat(QImage image)
+{
+    switch (image.format()) {
+    case QImage::Format_Invalid:
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return image;
+    default:
+        break;
+    }
+
+    if (!image.hasAlphaChannel()) {
+        image.convertTo(QImage::Format_RGB32);
+        return image;
+    }
+
+    image.convertTo(QImage::Format_ARGB32_Premultiplied);
+
+    const int width = image.width();
+    const int height = image.height();
+    for (int y = 0; y < height; ++y) {
+        auto line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < width; ++x)
+            if (qAlpha(line[x]) != 255)
+                return image;
+    }
+
+    // Fully opaque, so the alpha channel is not needed
+    image.convertTo(QImage::Format_RGB32);
+    return image;
+}
+
+/**
+ * Returns whether an image has been loaded for the given \a fileName.
+ */
+bool ImageCache::contains(const QString &fileName)
+{
+    return loadedImages.contains(fileName) || loadedPixmaps.contains(fileName);
+}
+
+/**
+ * Adds an \a image that was loaded elsewhere, for example on a worker
+ * thread, to the cache.
+ */
+void ImageCache::insert(const QString &fileName, LoadedImage image)
+{
+    remove(fileName);
+    insertImage(fileName, std::move(image));
 }
 
 void ImageCache::remove(const QString &fileName)
 {
-    sLoadedImages.remove(fileName);
-    sLoadedPixmaps.remove(fileName);
+    auto imageIt = loadedImages.find(fileName);
+    if (imageIt != loadedImages.end()) {
+        imageCacheStatistics.bytes -= cost(imageIt.value().loaded.image);
+        loadedImages.erase(imageIt);
+    }
+
+    auto pixmapIt = loadedPixmaps.find(fileName);
+    if (pixmapIt != loadedPixmaps.end()) {
+        imageCacheStatistics.bytes -= cost(pixmapIt.value().pixmap);
+        loadedPixmaps.erase(pixmapIt);
+    }
+}
+
+/**
+ * Sets the memory budget of the cache in bytes. Images that are still in use
+ * are kept regardless of this budget.
+ */
+void ImageCache::setMaximumSize(qint64 bytes)
+{
+    maximumCacheSize = bytes;
+    evict(QString());
+}
+
+qint64 ImageCache::maximumSize()
+{
+    return maximumCacheSize;
+}
+
+ImageCache::Statistics ImageCache::statistics()
+{
+    Statistics statistics = imageCacheStatistics;
+    statistics.entries = loadedImages.size() + loadedPixmaps.size();
+    return statistics;
+}
+
+/**
+ * Resets the hit, miss and eviction counters.
+ */
+void ImageCache::resetStatistics()
+{
+    imageCacheStatistics.hits = 0;
+    imageCacheStatistics.misses = 0;
+    imageCacheStatistics.evictions = 0;
+}
+
+/**
+ * Returns the entries of the cache along with their size, largest first.
+ */
+QVector<ImageCache::Entry> ImageCache::entries()
+{
+    QVector<Entry> entries;
+    entries.reserve(loadedImages.size() + loadedPixmaps.size());
+
+    for (auto it = loadedImages.cbegin(); it != loadedImages.cend(); ++it)
+        entries.append(Entry { it.key(), cost(it.value().loaded.image), !it.value().loaded.image.isDetached() });
+    for (auto it = loadedPixmaps.cbegin(); it != loadedPixmaps.cend(); ++it)
+        entries.append(Entry { it.key(), cost(it.value().pixmap), !it.value().pixmap.isDetached() });
+
+    std::sort(entries.begin(), entries.end(), [] (const Entry &a, const Entry &b) {
+        return a.bytes > b.bytes;
+    });
+
+    return entries;
+}
+
+QImage ImageCache::readImage(const QString &fileName)
+{
+    QImage image = DiskImageCache::loadImage(fileName);
+
+    // If the image failed to load, try to load and render a map file
+    if (image.isNull())
+        image = renderMap(fileName);
+
+    return image;
 }
 
 QImage ImageCache::renderMap(const QString &fileName)
@@ -36,6 +36,7 @@
 #include <QImage>
 #include <QPixmap>
 #include <QString>
+#include <QVector>
 
 namespace Tiled {
 
@@ -50,22 +51,58 @@ struct LoadedImage
     QDateTime lastModified;
 };
 
-struct LoadedPixmap;
 class Map;
 
+/**
+ * Caches the images and pixmaps loaded from files, so that images shared by
+ * several tilesets, tiles or image layers are only loaded once.
+ *
+ * The cache is limited to a memory budget. When it is exceeded, the least
+ * recently used entries are evicted. Entries that are still in use somewhere
+ * are pinned, since evicting them would not free any memory.
+ *
+ * Each file is kept either as an image or as a pixmap. Once a pixmap has been
+ * requested, images are served as views of the pixmap's pixels.
+ */
 class TILEDSHARED_EXPORT ImageCache
 {
 public:
+    struct Statistics
+    {
+        int entries = 0;
+        qint64 bytes = 0;
+        qint64 hits = 0;
+        qint64 misses = 0;
+        qint64 evictions = 0;
+    };
+
+    struct Entry
+    {
+        QString fileName;
+        qint64 bytes = 0;
+        bool inUse = false;     // still referenced outside of the cache
+    };
+
     static LoadedImage loadImage(const QString &fileName);
     static QPixmap loadPixmap(const QString &fileName);
 
+    static QImage toDisplayFormat(QImage image);
+
+    static bool contains(const QString &fileName);
+    static void insert(const QString &fileName, LoadedImage image);
     static void remove(const QString &fileName);
 
+    static void setMaximumSize(qint64 bytes);
+    static qint64 maximumSize();
+
+    static Statistics statistics();
+    static void resetStatistics();
+
+    static QVector<Entry> entries();
+
 private:
+    static QImage readImage(const QString &fileName);
     static QImage renderMap(const QString &fileName);
-
-    static QHash<QString, LoadedImage> sLoadedImages;
-    static QHash<QString, LoadedPixmap> sLoadedPixmaps;
 };
 
 } // namespace Tiled
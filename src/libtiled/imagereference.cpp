@@ -37,7 +37,8 @@ QPixmap ImageReference::create() const
     if (!fileName.isEmpty())
         pixmap = ImageCache::loadPixmap(fileName);
     else if (!data.isEmpty())
-        pixmap = QPixmap::fromImage(QImage::fromData(data, format));
+        pixmap = QPixmap::fromImage(ImageCache::toDisplayFormat(QImage::fromData(data, format)),
+                                    Qt::NoOpaqueDetection);
 
     return pixmap;
 }
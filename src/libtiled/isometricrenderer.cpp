@@ -33,9 +33,13 @@
 #include "tile.h"
 #include "tilelayer.h"
 #include "objectgroup.h"
+#include "textlayoutcache.h"
 
+#include <QVarLengthArray>
 #include <QtMath>
 
+#include <limits>
+
 using namespace Tiled;
 
 QRect IsometricRenderer::boundingRect(const QRect &rect) const
@@ -231,24 +235,50 @@ void IsometricRenderer::drawGrid(QPainter *painter, const QRectF &rect,
     QPen gridPen, majorGridPen;
     setupGridPens(painter->device(), gridColor, gridPen, majorGridPen, qMin(tileWidth, tileHeight), gridMajor);
 
-    for (int y = startY; y <= endY; ++y) {
-        const QPointF start = tileToScreenCoords(startX, y);
-        const QPointF end = tileToScreenCoords(endX, y);
+    if (majorGridPen.color().alpha() <= 0)
+        return;
+
+    // The minor lines fade out when zoomed out, at which point we skip them
+    const bool drawMinorLines = gridPen.color().alpha() > 0;
+
+    QVarLengthArray<QLineF, 64> minorLines;
+    QVarLengthArray<QLineF, 64> majorLines;
 
-        painter->setPen(gridMajor.height() != 0 && y % gridMajor.height() == 0 ? majorGridPen : gridPen);
-        painter->drawLine(start, end);
+    for (int y = startY; y <= endY; ++y) {
+        const QLineF line(tileToScreenCoords(startX, y), tileToScreenCoords(endX, y));
+        if (gridMajor.height() != 0 && y % gridMajor.height() == 0)
+            majorLines.append(line);
+        else if (drawMinorLines)
+            minorLines.append(line);
     }
     for (int x = startX; x <= endX; ++x) {
-        const QPointF start = tileToScreenCoords(x, startY);
-        const QPointF end = tileToScreenCoords(x, endY);
-
-        painter->setPen(gridMajor.width() != 0 && x % gridMajor.width() == 0 ? majorGridPen : gridPen);
-        painter->drawLine(start, end);
+        const QLineF line(tileToScreenCoords(x, startY), tileToScreenCoords(x, endY));
+        if (gridMajor.width() != 0 && x % gridMajor.width() == 0)
+            majorLines.append(line);
+        else if (drawMinorLines)
+            minorLines.append(line);
     }
+
+    painter->setPen(gridPen);
+    painter->drawLines(minorLines.constData(), minorLines.size());
+    painter->setPen(majorGridPen);
+    painter->drawLines(majorLines.constData(), majorLines.size());
 }
 
 void IsometricRenderer::drawTileLayer(const RenderTileCallback &renderTile,
                                       const QRectF &exposed) const
+{
+    drawTileLayer(renderTile, exposed, nullptr);
+}
+
+/**
+ * When a \a layer is given, the parts of each row that fall within chunks
+ * that don't exist are skipped. This keeps panning over sparse infinite
+ * maps cheap, while still visiting the tiles in the same order.
+ */
+void IsometricRenderer::drawTileLayer(const RenderTileCallback &renderTile,
+                                      const QRectF &exposed,
+                                      const TileLayer *layer) const
 {
     const int tileWidth = map()->tileWidth();
     const int tileHeight = map()->tileHeight();
@@ -290,13 +320,32 @@ void IsometricRenderer::drawTileLayer(const RenderTileCallback &renderTile,
          y += tileHeight)
     {
         QPoint columnItr = rowItr;
+        int x = startPos.x();
+
+        // Number of columns left before the row leaves the current chunk
+        int columnsInChunk = layer ? 0 : std::numeric_limits<int>::max();
+
+        while (x < exposed.right()) {
+            if (columnsInChunk == 0) {
+                const QPoint cellPos = columnItr - layer->position();
+                columnsInChunk = qMin(CHUNK_SIZE - (cellPos.x() & CHUNK_MASK),
+                                      (cellPos.y() & CHUNK_MASK) + 1);
+
+                if (!layer->findChunk(cellPos.x(), cellPos.y())) {
+                    columnItr += QPoint(columnsInChunk, -columnsInChunk);
+                    x += columnsInChunk * tileWidth;
+                    columnsInChunk = 0;
+                    continue;
+                }
+            }
 
-        for (int x = startPos.x(); x < exposed.right(); x += tileWidth) {
             renderTile(columnItr, QPointF(x, (qreal)y / 2));
 
             // Advance to the next column
             ++columnItr.rx();
             --columnItr.ry();
+            x += tileWidth;
+            --columnsInChunk;
         }
 
         // Advance to the next row
@@ -312,29 +361,18 @@ void IsometricRenderer::drawTileLayer(const RenderTileCallback &renderTile,
     }
 }
 
-void IsometricRenderer::drawTileSelection(QPainter *painter,
-                                          const QRegion &region,
-                                          const QColor &color,
-                                          const QRectF &exposed) const
+QPainterPath IsometricRenderer::tileSelectionOutline(const QRegion &region,
+                                                    const QRectF &exposed) const
 {
     QPainterPath path;
 
     for (const QRect &r : region) {
         QPolygonF polygon = tileRectToScreenPolygon(r);
-        if (QRectF(polygon.boundingRect()).intersects(exposed))
+        if (exposed.isNull() || QRectF(polygon.boundingRect()).intersects(exposed))
             path.addPolygon(polygon);
     }
 
-    QColor penColor(color);
-    penColor.setAlpha(255);
-
-    QPen pen(penColor);
-    pen.setCosmetic(true);
-
-    painter->setPen(pen);
-    painter->setBrush(color);
-    painter->setRenderHint(QPainter::Antialiasing, true);
-    painter->drawPath(path.simplified());
+    return path.simplified();
 }
 
 void IsometricRenderer::drawMapObject(QPainter *painter,
@@ -384,13 +422,7 @@ void IsometricRenderer::drawMapObject(QPainter *painter,
         QRectF bounds = { pixelToScreenCoords(object->position()), object->size() };
         bounds.translate(-alignmentOffset(bounds, object->alignment(map())));
 
-        const auto& textData = object->textData();
-
-        painter->setFont(textData.font);
-        painter->setPen(textData.color);
-        painter->drawText(bounds,
-                          textData.text,
-                          textData.textOption());
+        TextLayoutCache::drawText(painter, bounds, object->textData());
     } else {
         const qreal lineWidth = objectLineWidth();
         const qreal scale = painterScale();
@@ -417,7 +449,7 @@ void IsometricRenderer::drawMapObject(QPainter *painter,
         case MapObject::Ellipse:
         case MapObject::Capsule: {
             const QPolygonF rect = pixelRectToScreenPolygon(bounds);
-            const QPainterPath path = shape(object);
+            const QPainterPath path = cachedShape(object);
 
             painter->drawPath(path.translated(shadowOffset));
             painter->drawPolygon(rect.translated(shadowOffset));
@@ -445,7 +477,7 @@ void IsometricRenderer::drawMapObject(QPainter *painter,
         case MapObject::Polygon:
         case MapObject::Polyline: {
             const QPointF &pos = object->position();
-            const QPolygonF polygon = object->polygon().translated(pos);
+            const QPolygonF polygon = simplifiedPolygon(object).translated(pos);
             const QPolygonF screenPolygon = pixelToScreenCoords(polygon);
             const QPointF pointPos = screenPolygon.isEmpty() ? pos
                                                              : screenPolygon.first();
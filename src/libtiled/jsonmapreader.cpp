@@ -0,0 +1,927 @@
+/*
+ * jsonmapreader.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "jsonmapreader.h"
+
+#include "grouplayer.h"
+#include "map.h"
+#include "objectgroup.h"
+
+#include <QJsonArray>
+
+#include <limits>
+#include <vector>
+
+namespace Tiled {
+
+struct JsonMapReader::PendingObject
+{
+    std::unique_ptr<MapObject> object;
+    QVariant templateVariant;
+    unsigned gid = 0;
+};
+
+/**
+ * A layer of which the objects and child layers have been read, but which
+ * can only be created once the tilesets are known.
+ */
+struct JsonMapReader::PendingLayer
+{
+    QVariantMap variant;
+    std::vector<PendingObject> objects;
+    std::vector<PendingLayer> layers;
+};
+
+/**
+ * A pull parser for JSON, which leaves it up to the caller how each value is
+ * stored. Values that are not of interest to the caller can be read as a
+ * QVariant.
+ */
+class JsonMapReader::Parser
+{
+public:
+    enum ValueType {
+        InvalidValue,
+        ObjectValue,
+        ArrayValue,
+        StringValue,
+        NumberValue,
+        BoolValue,
+        NullValue
+    };
+
+    explicit Parser(const QByteArray &data)
+        : mBegin(data.constData())
+        , mPos(mBegin)
+        , mEnd(mBegin + data.size())
+    {
+        // Skip the UTF-8 byte order mark some editors write
+        if (data.startsWith("\xef\xbb\xbf"))
+            mPos += 3;
+    }
+
+    ValueType peek();
+
+    bool beginObject();
+    bool nextKey(QByteArray &key);
+    bool beginArray();
+    bool nextElement();
+
+    QVariant readValue();
+    QString readString();
+    double readDouble();
+    int readInt();
+    unsigned readUInt();
+    bool readBool();
+
+    void finish();
+
+    bool hasError() const { return mError != nullptr; }
+    QString errorString() const;
+
+private:
+    struct Number
+    {
+        bool isInteger;
+        qint64 integer;
+        double real;
+    };
+
+    void skipWhitespace();
+    bool enterContainer();
+    bool nextMember(char close, const char *unterminated);
+    bool parseString(QString &string);
+    bool parseKey(QByteArray &key);
+    bool parseNumber(Number &number);
+    bool parseLiteral(const char *literal, int size);
+    bool setError(const char *error);
+
+    const char *mBegin;
+    const char *mPos;
+    const char *mEnd;
+
+    // Whether the next member of each open object or array is the first one
+    std::vector<bool> mFirstMember;
+
+    const char *mError = nullptr;
+    qint64 mErrorOffset = 0;
+};
+
+// The same limit as used by QJsonDocument
+static const size_t MaxNestingDepth = 1024;
+
+JsonMapReader::Parser::ValueType JsonMapReader::Parser::peek()
+{
+    skipWhitespace();
+
+    if (mPos == mEnd)
+        return InvalidValue;
+
+    switch (*mPos) {
+    case '{':   return ObjectValue;
+    case '[':   return ArrayValue;
+    case '"':   return StringValue;
+    case 't':
+    case 'f':   return BoolValue;
+    case 'n':   return NullValue;
+    case '-':   return NumberValue;
+    }
+
+    if (*mPos >= '0' && *mPos <= '9')
+        return NumberValue;
+
+    return InvalidValue;
+}
+
+bool JsonMapReader::Parser::beginObject()
+{
+    if (peek() != ObjectValue)
+        return setError(QT_TR_NOOP("expected an object"));
+
+    ++mPos;
+    return enterContainer();
+}
+
+/**
+ * Moves to the next member of the current object, storing its name in
+ * \a key. Returns false at the end of the object or when an error occurred.
+ *
+ * The \a key may refer to the parsed data, so it is only valid until the
+ * next call.
+ */
+bool JsonMapReader::Parser::nextKey(QByteArray &key)
+{
+    if (!nextMember('}', QT_TR_NOOP("unterminated object")))
+        return false;
+
+    if (mPos == mEnd || *mPos != '"')
+        return setError(QT_TR_NOOP("expected a member name"));
+    if (!parseKey(key))
+        return false;
+
+    skipWhitespace();
+    if (mPos == mEnd || *mPos != ':')
+        return setError(QT_TR_NOOP("missing name separator"));
+
+    ++mPos;
+    return true;
+}
+
+bool JsonMapReader::Parser::beginArray()
+{
+    if (peek() != ArrayValue)
+        return setError(QT_TR_NOOP("expected an array"));
+
+    ++mPos;
+    return enterContainer();
+}
+
+/**
+ * Moves to the next element of the current array. Returns false at the end
+ * of the array or when an error occurred.
+ */
+bool JsonMapReader::Parser::nextElement()
+{
+    return nextMember(']', QT_TR_NOOP("unterminated array"));
+}
+
+/**
+ * Reads the next value, of any type. Numbers are read as qlonglong when they
+ * are integers, like QJsonValue::toVariant does.
+ */
+QVariant JsonMapReader::Parser::readValue()
+{
+    switch (peek()) {
+    case ObjectValue: {
+        beginObject();
+
+        QVariantMap variantMap;
+        QByteArray key;
+        while (nextKey(key)) {
+            const QString name = QString::fromUtf8(key);
+            variantMap.insert(name, readValue());
+        }
+        return variantMap;
+    }
+    case ArrayValue: {
+        beginArray();
+
+        QVariantList variantList;
+        while (nextElement())
+            variantList.append(readValue());
+        return variantList;
+    }
+    case StringValue: {
+        QString string;
+        parseString(string);
+        return string;
+    }
+    case NumberValue: {
+        Number number;
+        if (!parseNumber(number))
+            return QVariant();
+        if (number.isInteger)
+            return number.integer;
+        return number.real;
+    }
+    case BoolValue:
+        return readBool();
+    case NullValue:
+        parseLiteral("null", 4);
+        return QVariant();
+    case InvalidValue:
+        break;
+    }
+
+    setError(QT_TR_NOOP("illegal value"));
+    return QVariant();
+}
+
+QString JsonMapReader::Parser::readString()
+{
+    if (peek() != StringValue)
+        return readValue().toString();
+
+    QString string;
+    parseString(string);
+    return string;
+}
+
+double JsonMapReader::Parser::readDouble()
+{
+    if (peek() != NumberValue)
+        return readValue().toDouble();
+
+    Number number;
+    if (!parseNumber(number))
+        return 0.0;
+    return number.isInteger ? static_cast<double>(number.integer) : number.real;
+}
+
+int JsonMapReader::Parser::readInt()
+{
+    if (peek() != NumberValue)
+        return readValue().toInt();
+
+    Number number;
+    if (!parseNumber(number))
+        return 0;
+    if (number.isInteger)
+        return static_cast<int>(number.integer);
+    return QVariant(number.real).toInt();
+}
+
+unsigned JsonMapReader::Parser::readUInt()
+{
+    if (peek() != NumberValue)
+        return readValue().toUInt();
+
+    Number number;
+    if (!parseNumber(number))
+        return 0;
+    if (number.isInteger)
+        return static_cast<unsigned>(number.integer);
+    return QVariant(number.real).toUInt();
+}
+
+bool JsonMapReader::Parser::readBool()
+{
+    if (peek() != BoolValue)
+        return readValue().toBool();
+
+    if (*mPos == 't')
+        return parseLiteral("true", 4);
+
+    parseLiteral("false", 5);
+    return false;
+}
+
+/**
+ * Checks that only whitespace follows the parsed value.
+ */
+void JsonMapReader::Parser::finish()
+{
+    skipWhitespace();
+
+    if (!hasError() && mPos != mEnd)
+        setError(QT_TR_NOOP("garbage at the end of the document"));
+}
+
+QString JsonMapReader::Parser::errorString() const
+{
+    return tr("%1 at offset %2").arg(tr(mError)).arg(mErrorOffset);
+}
+
+void JsonMapReader::Parser::skipWhitespace()
+{
+    while (mPos != mEnd && (*mPos == ' ' || *mPos == '\n' || *mPos == '\r' || *mPos == '\t'))
+        ++mPos;
+}
+
+bool JsonMapReader::Parser::enterContainer()
+{
+    if (mFirstMember.size() >= MaxNestingDepth)
+        return setError(QT_TR_NOOP("too deeply nested document"));
+
+    mFirstMember.push_back(true);
+    return true;
+}
+
+bool JsonMapReader::Parser::nextMember(char close, const char *unterminated)
+{
+    if (hasError())
+        return false;
+
+    skipWhitespace();
+    if (mPos == mEnd)
+        return setError(unterminated);
+
+    if (*mPos == close) {
+        ++mPos;
+        mFirstMember.pop_back();
+        return false;
+    }
+
+    if (mFirstMember.back()) {
+        mFirstMember.back() = false;
+    } else {
+        if (*mPos != ',')
+            return setError(QT_TR_NOOP("missing value separator"));
+
+        ++mPos;
+        skipWhitespace();
+    }
+
+    return true;
+}
+
+bool JsonMapReader::Parser::parseString(QString &string)
+{
+    Q_ASSERT(*mPos == '"');
+    ++mPos;
+
+    string.clear();
+    const char *segment = mPos;
+
+    while (true) {
+        if (mPos == mEnd)
+            return setError(QT_TR_NOOP("unterminated string"));
+
+        const char c = *mPos;
+
+        if (c == '"') {
+            if (string.isEmpty())
+                string = QString::fromUtf8(segment, static_cast<int>(mPos - segment));
+            else
+                string.append(QString::fromUtf8(segment, static_cast<int>(mPos - segment)));
+            ++mPos;
+            return true;
+        }
+
+        if (static_cast<unsigned char>(c) < 0x20)
+            return setError(QT_TR_NOOP("illegal character in string"));
+
+        if (c != '\\') {
+            ++mPos;
+            continue;
+        }
+
+        string.append(QString::fromUtf8(segment, static_cast<int>(mPos - segment)));
+
+        if (++mPos == mEnd)
+            return setError(QT_TR_NOOP("unterminated string"));
+
+        switch (*mPos++) {
+        case '"':   string.append(QLatin1Char('"')); break;
+        case '\\':  string.append(QLatin1Char('\\')); break;
+        case '/':   string.append(QLatin1Char('/')); break;
+        case 'b':   string.append(QLatin1Char('\b')); break;
+        case 'f':   string.append(QLatin1Char('\f')); break;
+        case 'n':   string.append(QLatin1Char('\n')); break;
+        case 'r':   string.append(QLatin1Char('\r')); break;
+        case 't':   string.append(QLatin1Char('\t')); break;
+        case 'u': {
+            if (mEnd - mPos < 4)
+                return setError(QT_TR_NOOP("illegal escape sequence"));
+
+            char16_t unit = 0;
+            for (int i = 0; i < 4; ++i) {
+                const char h = *mPos++;
+                unit <<= 4;
+                if (h >= '0' && h <= '9')
+                    unit |= h - '0';
+                else if (h >= 'a' && h <= 'f')
+                    unit |= h - 'a' + 10;
+                else if (h >= 'A' && h <= 'F')
+                    unit |= h - 'A' + 10;
+                else
+                    return setError(QT_TR_NOOP("illegal escape sequence"));
+            }
+
+            // Surrogate pairs are written as two escapes, which combine
+            // naturally in the UTF-16 string
+            string.append(QChar(unit));
+            break;
+        }
+        default:
+            return setError(QT_TR_NOOP("illegal escape sequence"));
+        }
+
+        segment = mPos;
+    }
+}
+
+/**
+ * Parses a member name. Names without escape sequences, which is nearly all
+ * of them, refer to the parsed data rather than being copied.
+ */
+bool JsonMapReader::Parser::parseKey(QByteArray &key)
+{
+    const char *start = mPos + 1;
+
+    for (const char *it = start; it != mEnd; ++it) {
+        if (*it == '"') {
+            key = QByteArray::fromRawData(start, static_cast<int>(it - start));
+            mPos = it + 1;
+            return true;
+        }
+        if (*it == '\\' || static_cast<unsigned char>(*it) < 0x20)
+            break;
+    }
+
+    QString string;
+    if (!parseString(string))
+        return false;
+
+    key = string.toUtf8();
+    return true;
+}
+
+static bool isDigit(const char *pos, const char *end)
+{
+    return pos != end && *pos >= '0' && *pos <= '9';
+}
+
+bool JsonMapReader::Parser::parseNumber(Number &number)
+{
+    const char *start = mPos;
+    const bool negative = *mPos == '-';
+    if (negative)
+        ++mPos;
+
+    if (!isDigit(mPos, mEnd))
+        return setError(QT_TR_NOOP("illegal number"));
+
+    if (*mPos == '0') {
+        ++mPos;
+    } else {
+        while (isDigit(mPos, mEnd))
+            ++mPos;
+    }
+
+    const char *integerEnd = mPos;
+    number.isInteger = true;
+
+    if (mPos != mEnd && *mPos == '.') {
+        number.isInteger = false;
+        ++mPos;
+        if (!isDigit(mPos, mEnd))
+            return setError(QT_TR_NOOP("illegal number"));
+        while (isDigit(mPos, mEnd))
+            ++mPos;
+    }
+
+    if (mPos != mEnd && (*mPos == 'e' || *mPos == 'E')) {
+        number.isInteger = false;
+        ++mPos;
+        if (mPos != mEnd && (*mPos == '+' || *mPos == '-'))
+            ++mPos;
+        if (!isDigit(mPos, mEnd))
+            return setError(QT_TR_NOOP("illegal number"));
+        while (isDigit(mPos, mEnd))
+            ++mPos;
+    }
+
+    // Integers of up to 18 digits always fit in a qint64
+    const char *digits = start + (negative ? 1 : 0);
+    if (number.isInteger && integerEnd - digits <= 18) {
+        qint64 value = 0;
+        for (const char *it = digits; it != integerEnd; ++it)
+            value = value * 10 + (*it - '0');
+        number.integer = negative ? -value : value;
+        return true;
+    }
+
+    bool ok;
+    number.isInteger = false;
+    number.real = QByteArray::fromRawData(start, static_cast<int>(mPos - start)).toDouble(&ok);
+    if (!ok)
+        return setError(QT_TR_NOOP("illegal number"));
+
+    return true;
+}
+
+bool JsonMapReader::Parser::parseLiteral(const char *literal, int size)
+{
+    if (mEnd - mPos < size || qstrncmp(mPos, literal, size) != 0)
+        return setError(QT_TR_NOOP("illegal value"));
+
+    mPos += size;
+    return true;
+}
+
+/**
+ * Records the first error. Always returns false, for convenience.
+ */
+bool JsonMapReader::Parser::setError(const char *error)
+{
+    if (!hasError()) {
+        mError = error;
+        mErrorOffset = mPos - mBegin;
+    }
+
+    // Stop parsing by skipping to the end
+    mPos = mEnd;
+    return false;
+}
+
+
+/**
+ * Reads the map from the given \a json data. The \a mapDir is necessary to
+ * resolve any relative references to external files.
+ *
+ * Returns null in case of an error. The error can be obtained using
+ * errorString().
+ */
+std::unique_ptr<Map> JsonMapReader::readMap(const QByteArray &json, const QDir &mapDir)
+{
+    mError.clear();
+
+    // Needed for reading templates and properties of objects, which happens
+    // before the converter is given the rest of the map
+    mConverter.mDir = mapDir;
+
+    Parser parser(json);
+    QVariantMap mapVariant;
+    std::vector<PendingLayer> layers;
+
+    if (parser.beginObject()) {
+        QByteArray key;
+        while (parser.nextKey(key)) {
+            if (key == "layers" && parser.peek() == Parser::ArrayValue)
+                readLayers(parser, layers);
+            else
+                mapVariant.insert(QString::fromUtf8(key), parser.readValue());
+        }
+        parser.finish();
+    }
+
+    if (parser.hasError()) {
+        mError = tr("Error parsing file: %1").arg(parser.errorString());
+        return nullptr;
+    }
+
+    auto map = mConverter.toMap(mapVariant, mapDir);
+    if (!map) {
+        mError = mConverter.errorString();
+        return nullptr;
+    }
+
+    for (PendingLayer &pendingLayer : layers) {
+        std::unique_ptr<Layer> layer = toLayer(pendingLayer);
+        if (!layer) {
+            mError = mConverter.errorString();
+            return nullptr;
+        }
+
+        map->addLayer(std::move(layer));
+    }
+
+    return map;
+}
+
+void JsonMapReader::readLayers(Parser &parser, std::vector<PendingLayer> &layers)
+{
+    parser.beginArray();
+
+    while (parser.nextElement()) {
+        layers.emplace_back();
+
+        if (parser.peek() == Parser::ObjectValue)
+            readLayer(parser, layers.back());
+        else
+            layers.back().variant = parser.readValue().toMap();
+    }
+}
+
+void JsonMapReader::readLayer(Parser &parser, PendingLayer &layer)
+{
+    parser.beginObject();
+
+    QByteArray key;
+    while (parser.nextKey(key)) {
+        if (key == "objects" && parser.peek() == Parser::ArrayValue)
+            readObjects(parser, layer);
+        else if (key == "layers" && parser.peek() == Parser::ArrayValue)
+            readLayers(parser, layer.layers);
+        else if (key == "data")
+            layer.variant.insert(QStringLiteral("data"), readLayerData(parser));
+        else if (key == "chunks")
+            layer.variant.insert(QStringLiteral("chunks"), readChunks(parser));
+        else
+            layer.variant.insert(QString::fromUtf8(key), parser.readValue());
+    }
+}
+
+void JsonMapReader::readObjects(Parser &parser, PendingLayer &layer)
+{
+    parser.beginArray();
+
+    while (parser.nextElement()) {
+        if (parser.peek() == Parser::ObjectValue) {
+            layer.objects.emplace_back();
+            readObject(parser, layer.objects.back());
+        } else {
+            parser.readValue();     // not an object, skip it
+        }
+    }
+}
+
+/**
+ * Reads an object, creating the MapObject straight away. Its template and
+ * tile are set up later, once the tilesets are known.
+ *
+ * This follows VariantToMapConverter::toMapObject.
+ */
+void JsonMapReader::readObject(Parser &parser, PendingObject &pendingObject)
+{
+    QString name;
+    QString className;
+    QString typeName;
+    int id = 0;
+    QPointF pos;
+    QSizeF size;
+    qreal rotation = 0.0;
+    bool hasRotation = false;
+    bool visible = true;
+    bool hasVisible = false;
+    QVariant properties;
+    QVariant propertyTypes;
+    QPolygonF polygon;
+    bool hasPolygon = false;
+    QPolygonF polyline;
+    bool hasPolyline = false;
+    bool ellipse = false;
+    bool capsule = false;
+    bool point = false;
+    QVariant text;
+
+    parser.beginObject();
+
+    QByteArray key;
+    while (parser.nextKey(key)) {
+        if (key == "id") {
+            id = parser.readInt();
+        } else if (key == "x") {
+            pos.setX(parser.readDouble());
+        } else if (key == "y") {
+            pos.setY(parser.readDouble());
+        } else if (key == "width") {
+            size.setWidth(parser.readDouble());
+        } else if (key == "height") {
+            size.setHeight(parser.readDouble());
+        } else if (key == "name") {
+            name = parser.readString();
+        } else if (key == "class") {
+            className = parser.readString();
+        } else if (key == "type") {
+            typeName = parser.readString();
+        } else if (key == "gid") {
+            pendingObject.gid = parser.readUInt();
+        } else if (key == "template") {
+            pendingObject.templateVariant = parser.readValue();
+        } else if (key == "rotation") {
+            rotation = parser.readDouble();
+            hasRotation = true;
+        } else if (key == "visible") {
+            visible = parser.readBool();
+            hasVisible = true;
+        } else if (key == "properties") {
+            properties = parser.readValue();
+        } else if (key == "propertytypes") {
+            propertyTypes = parser.readValue();
+        } else if (key == "polygon" && parser.peek() == Parser::ArrayValue) {
+            polygon = readPolygon(parser);
+            hasPolygon = true;
+        } else if (key == "polyline" && parser.peek() == Parser::ArrayValue) {
+            polyline = readPolygon(parser);
+            hasPolyline = true;
+        } else if (key == "ellipse") {
+            ellipse = parser.readBool();
+        } else if (key == "capsule") {
+            capsule = parser.readBool();
+        } else if (key == "point") {
+            point = parser.readBool();
+        } else if (key == "text") {
+            text = parser.readValue();
+        } else {
+            parser.readValue();     // unknown member, skip it
+        }
+    }
+
+    if (className.isEmpty())    // fallback for compatibility
+        className = typeName;
+
+    auto object = std::make_unique<MapObject>(name, className, pos, size);
+    object->setId(id);
+
+    if (hasRotation) {
+        object->setRotation(rotation);
+        object->setPropertyChanged(MapObject::RotationProperty);
+    }
+
+    object->setPropertyChanged(MapObject::NameProperty, !name.isEmpty());
+    object->setPropertyChanged(MapObject::SizeProperty, !size.isEmpty());
+
+    if (hasVisible) {
+        object->setVisible(visible);
+        object->setPropertyChanged(MapObject::VisibleProperty);
+    }
+
+    if (properties.isValid() || propertyTypes.isValid())
+        object->setProperties(mConverter.toProperties(properties, propertyTypes));
+
+    if (hasPolygon) {
+        object->setShape(MapObject::Polygon);
+        object->setPolygon(polygon);
+        object->setPropertyChanged(MapObject::ShapeProperty);
+    }
+    if (hasPolyline) {
+        object->setShape(MapObject::Polyline);
+        object->setPolygon(polyline);
+        object->setPropertyChanged(MapObject::ShapeProperty);
+    }
+    if (ellipse) {
+        object->setShape(MapObject::Ellipse);
+        object->setPropertyChanged(MapObject::ShapeProperty);
+    }
+    if (capsule) {
+        object->setShape(MapObject::Capsule);
+        object->setPropertyChanged(MapObject::ShapeProperty);
+    }
+    if (point) {
+        object->setShape(MapObject::Point);
+        object->setPropertyChanged(MapObject::ShapeProperty);
+    }
+    if (text.userType() == QMetaType::QVariantMap) {
+        object->setTextData(mConverter.toTextData(text.toMap()));
+        object->setShape(MapObject::Text);
+        object->setPropertyChanged(MapObject::TextProperty);
+    }
+
+    pendingObject.object = std::move(object);
+}
+
+QPolygonF JsonMapReader::readPolygon(Parser &parser)
+{
+    QPolygonF polygon;
+
+    parser.beginArray();
+
+    while (parser.nextElement()) {
+        QPointF point;
+
+        if (parser.peek() == Parser::ObjectValue) {
+            parser.beginObject();
+
+            QByteArray key;
+            while (parser.nextKey(key)) {
+                if (key == "x")
+                    point.setX(parser.readDouble());
+                else if (key == "y")
+                    point.setY(parser.readDouble());
+                else
+                    parser.readValue();
+            }
+        } else {
+            parser.readValue();
+        }
+
+        polygon.append(point);
+    }
+
+    return polygon;
+}
+
+/**
+ * Reads the chunks of a tile layer, keeping their data arrays as QJsonArray.
+ */
+QVariant JsonMapReader::readChunks(Parser &parser)
+{
+    if (parser.peek() != Parser::ArrayValue)
+        return parser.readValue();
+
+    QVariantList chunks;
+
+    parser.beginArray();
+
+    while (parser.nextElement()) {
+        if (parser.peek() != Parser::ObjectValue) {
+            chunks.append(parser.readValue());
+            continue;
+        }
+
+        QVariantMap chunk;
+
+        parser.beginObject();
+
+        QByteArray key;
+        while (parser.nextKey(key)) {
+            if (key == "data")
+                chunk.insert(QStringLiteral("data"), readLayerData(parser));
+            else
+                chunk.insert(QString::fromUtf8(key), parser.readValue());
+        }
+
+        chunks.append(chunk);
+    }
+
+    return chunks;
+}
+
+/**
+ * Reads the data of a tile layer or chunk. When it is an array, it is
+ * stored as QJsonArray rather than creating a QVariant for each tile (see
+ * VariantToMapConverter::readTileLayerData).
+ */
+QVariant JsonMapReader::readLayerData(Parser &parser)
+{
+    if (parser.peek() != Parser::ArrayValue)
+        return parser.readValue();
+
+    QJsonArray data;
+
+    parser.beginArray();
+
+    while (parser.nextElement()) {
+        if (parser.peek() == Parser::NumberValue)
+            data.append(parser.readDouble());
+        else
+            data.append(QJsonValue::fromVariant(parser.readValue()));
+    }
+
+    return QVariant::fromValue(data);
+}
+
+std::unique_ptr<Layer> JsonMapReader::toLayer(PendingLayer &pendingLayer)
+{
+    std::unique_ptr<Layer> layer = mConverter.toLayer(pendingLayer.variant);
+    if (!layer)
+        return nullptr;
+
+    if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
+        for (PendingObject &pendingObject : pendingLayer.objects) {
+            mConverter.resolveMapObject(*pendingObject.object,
+                                        pendingObject.templateVariant,
+                                        pendingObject.gid);
+            objectGroup->addObject(std::move(pendingObject.object));
+        }
+    } else if (GroupLayer *groupLayer = layer->asGroupLayer()) {
+        for (PendingLayer &pendingChild : pendingLayer.layers) {
+            std::unique_ptr<Layer> child = toLayer(pendingChild);
+            if (!child)
+                return nullptr;
+
+            groupLayer->addLayer(std::move(child));
+        }
+    }
+
+    return layer;
+}
+
+} // namespace Tiled
@@ -0,0 +1,80 @@
+/*
+ * jsonmapreader.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "varianttomapconverter.h"
+
+#include <QCoreApplication>
+#include <QDir>
+
+#include <memory>
+
+namespace Tiled {
+
+class Map;
+
+/**
+ * Reads a map from JSON without first parsing the whole document into a
+ * QJsonDocument and converting it to a QVariant tree.
+ *
+ * Layers and their objects are read as the document is parsed, creating the
+ * MapObject instances straight away. Everything else, like the map
+ * attributes, tilesets, tile layers and properties, is read into a QVariant
+ * and handed to the VariantToMapConverter.
+ */
+class TILEDSHARED_EXPORT JsonMapReader
+{
+    // Using the MapReader context since the messages are the same
+    Q_DECLARE_TR_FUNCTIONS(MapReader)
+
+public:
+    std::unique_ptr<Map> readMap(const QByteArray &json, const QDir &mapDir);
+
+    QString errorString() const { return mError; }
+
+private:
+    struct PendingObject;
+    struct PendingLayer;
+    class Parser;
+
+    void readLayers(Parser &parser, std::vector<PendingLayer> &layers);
+    void readLayer(Parser &parser, PendingLayer &layer);
+    void readObjects(Parser &parser, PendingLayer &layer);
+    void readObject(Parser &parser, PendingObject &pendingObject);
+    QPolygonF readPolygon(Parser &parser);
+    QVariant readChunks(Parser &parser);
+    QVariant readLayerData(Parser &parser);
+
+    std::unique_ptr<Layer> toLayer(PendingLayer &pendingLayer);
+
+    VariantToMapConverter mConverter;
+    QString mError;
+};
+
+} // namespace Tiled
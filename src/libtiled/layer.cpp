@@ -55,45 +55,36 @@ Layer::Layer(TypeFlag type, const QString &name, int x, int y)
 }
 
 /**
- * Returns the effective opacity, which is the opacity multiplied by the
- * opacity of any parent layers.
+ * Recomputes the render state of this layer and, for group layers, of its
+ * child layers. Called whenever a property affecting it changes.
  */
-qreal Layer::effectiveOpacity() const
+void Layer::updateRenderState()
 {
-    auto opacity = mOpacity;
-    const Layer *layer = this;
-    while ((layer = layer->parentLayer()))
-        opacity *= layer->opacity();
-    return opacity;
-}
-
-/**
- * Returns the effective tint color, which is the tint color multiplied by the
- * tint color of any parent layers.
- */
-QColor Layer::effectiveTintColor() const
-{
-    auto tintColor = mTintColor.isValid() ? mTintColor
-                                          : QColor(255, 255, 255, 255);
-
-    const Layer *layer = this;
-    while ((layer = layer->parentLayer()))
-        if (layer->tintColor().isValid())
-            tintColor = multiplyColors(tintColor, layer->tintColor());
-
-    return tintColor;
-}
+    LayerRenderState &state = mRenderState;
+
+    state.opacity = mOpacity;
+    state.tintColor = mTintColor.isValid() ? mTintColor
+                                           : QColor(255, 255, 255, 255);
+    state.totalOffset = mOffset;
+    state.parallaxFactor = mParallaxFactor;
+    state.hidden = !mVisible;
+
+    if (mParentLayer) {
+        const LayerRenderState &parentState = mParentLayer->renderState();
+        const QColor white(255, 255, 255, 255);
+
+        state.opacity *= parentState.opacity;
+        if (parentState.tintColor != white)
+            state.tintColor = multiplyColors(state.tintColor, parentState.tintColor);
+        state.totalOffset += parentState.totalOffset;
+        state.parallaxFactor.rx() *= parentState.parallaxFactor.x();
+        state.parallaxFactor.ry() *= parentState.parallaxFactor.y();
+        state.hidden |= parentState.hidden;
+    }
 
-/**
- * Returns whether this layer is hidden. A visible layer may still be hidden,
- * when one of its parent layers is not visible.
- */
-bool Layer::isHidden() const
-{
-    const Layer *layer = this;
-    while (layer && layer->isVisible())
-        layer = layer->parentLayer();
-    return layer;      // encountered an invisible layer
+    if (isGroupLayer())
+        for (Layer *layer : static_cast<GroupLayer*>(this)->layers())
+            layer->updateRenderState();
 }
 
 bool Layer::isUnlocked() const
@@ -134,11 +125,30 @@ int Layer::depth() const
  */
 int Layer::siblingIndex() const
 {
+    const QList<Layer*> *siblings = nullptr;
     if (mParentLayer)
-        return mParentLayer->layers().indexOf(const_cast<Layer*>(this));
-    if (mMap)
-        return mMap->layers().indexOf(const_cast<Layer*>(this));
-    return 0;
+        siblings = &mParentLayer->layers();
+    else if (mMap)
+        siblings = &mMap->layers();
+    else
+        return 0;
+
+    // Usually the layer is still at or next to where it was last found,
+    // which avoids a linear search in maps with many layers. The hint is
+    // atomic, since snapshots may be read from several threads.
+    const int hint = mSiblingIndexHint.load(std::memory_order_relaxed);
+    for (int index : { hint, hint + 1, hint - 1 }) {
+        if (index >= 0 && index < siblings->size() && siblings->at(index) == this) {
+            if (index != hint)
+                mSiblingIndexHint.store(index, std::memory_order_relaxed);
+            return index;
+        }
+    }
+
+    const int index = siblings->indexOf(const_cast<Layer*>(this));
+    if (index != -1)
+        mSiblingIndexHint.store(index, std::memory_order_relaxed);
+    return index;
 }
 
 /**
@@ -154,30 +164,6 @@ QList<Layer *> Layer::siblings() const
     return QList<Layer *>();
 }
 
-/**
- * Computes the total offset. which is the offset including the offset of all
- * parent layers.
- */
-QPointF Layer::totalOffset() const
-{
-    auto offset = mOffset;
-    const Layer *layer = this;
-    while ((layer = layer->parentLayer()))
-        offset += layer->offset();
-    return offset;
-}
-
-QPointF Layer::effectiveParallaxFactor() const
-{
-    auto factor = mParallaxFactor;
-    const Layer *layer = this;
-    while ((layer = layer->parentLayer())) {
-        factor.rx() *= layer->parallaxFactor().rx();
-        factor.ry() *= layer->parallaxFactor().ry();
-    }
-    return factor;
-}
-
 /**
  * Returns whether this layer can be merged down onto the layer below.
  */
@@ -214,6 +200,7 @@ Layer *Layer::initializeClone(Layer *clone) const
     clone->mVisible = mVisible;
     clone->mLocked = mLocked;
     clone->setProperties(properties());
+    clone->updateRenderState();
     return clone;
 }
 
@@ -39,6 +39,7 @@
 #include <QString>
 #include <QVector>
 
+#include <atomic>
 #include <cstddef>
 #include <iterator>
 
@@ -50,6 +51,20 @@ class ImageLayer;
 class ObjectGroup;
 class TileLayer;
 
+/**
+ * The properties of a layer that affect its rendering, with those of its
+ * parent layers applied. Kept up to date by the layer, so that renderers
+ * don't need to walk up the hierarchy.
+ */
+struct LayerRenderState
+{
+    qreal opacity = 1.0;
+    QColor tintColor = QColor(255, 255, 255, 255);
+    QPointF totalOffset;
+    QPointF parallaxFactor = { 1.0, 1.0 };
+    bool hidden = false;
+};
+
 /**
  * A map layer.
  */
@@ -78,7 +93,7 @@ public:
     void setId(int id) { mId = id; }
 
     const QColor &tintColor() const { return mTintColor; }
-    void setTintColor(const QColor &tintColor) { mTintColor = tintColor; }
+    void setTintColor(const QColor &tintColor) { mTintColor = tintColor; updateRenderState(); }
 
     /**
      * Returns the type of this layer.
@@ -103,17 +118,25 @@ public:
     /**
      * Sets the opacity of this layer.
      */
-    void setOpacity(qreal opacity) { mOpacity = opacity; }
+    void setOpacity(qreal opacity) { mOpacity = opacity; updateRenderState(); }
+
+    /**
+     * Returns the effective opacity, which is the opacity multiplied by the
+     * opacity of any parent layers.
+     */
+    qreal effectiveOpacity() const { return mRenderState.opacity; }
 
     /**
-     * Returns the effective opacity of this layer
+     * Returns the effective tint color, which is the tint color multiplied by
+     * the tint color of any parent layers.
      */
-    qreal effectiveOpacity() const;
+    const QColor &effectiveTintColor() const { return mRenderState.tintColor; }
 
     /**
-     * Returns the effective tint color of this layer
+     * Returns the state relevant for rendering this layer, with the
+     * properties of its parent layers applied.
      */
-    QColor effectiveTintColor() const;
+    const LayerRenderState &renderState() const { return mRenderState; }
 
     /**
      * Returns the visibility of this layer.
@@ -130,12 +153,16 @@ public:
      */
     bool isUnlocked() const;
 
-    bool isHidden() const;
+    /**
+     * Returns whether this layer is hidden. A visible layer may still be
+     * hidden, when one of its parent layers is not visible.
+     */
+    bool isHidden() const { return mRenderState.hidden; }
 
     /**
      * Sets the visibility of this layer.
      */
-    void setVisible(bool visible) { mVisible = visible; }
+    void setVisible(bool visible) { mVisible = visible; updateRenderState(); }
 
     void setLocked(bool locked) { mLocked = locked; }
 
@@ -187,11 +214,16 @@ public:
 
     void setOffset(const QPointF &offset);
     QPointF offset() const;
-    QPointF totalOffset() const;
+
+    /**
+     * Returns the total offset, which is the offset including the offset of
+     * all parent layers.
+     */
+    QPointF totalOffset() const { return mRenderState.totalOffset; }
 
     void setParallaxFactor(const QPointF &factor);
     QPointF parallaxFactor() const;
-    QPointF effectiveParallaxFactor() const;
+    QPointF effectiveParallaxFactor() const { return mRenderState.parallaxFactor; }
 
     BlendMode blendMode() const;
     void setBlendMode(BlendMode mode);
@@ -257,7 +289,8 @@ protected:
      * Map class.
      */
     virtual void setMap(Map *map) { mMap = map; }
-    void setParentLayer(GroupLayer *groupLayer) { mParentLayer = groupLayer; }
+    void setParentLayer(GroupLayer *groupLayer) { mParentLayer = groupLayer; updateRenderState(); }
+    void updateRenderState();
 
     Layer *initializeClone(Layer *clone) const;
 
@@ -276,6 +309,12 @@ protected:
     GroupLayer *mParentLayer = nullptr;
     bool mLocked = false;
 
+    // Derived from the above properties and those of the parent layers
+    LayerRenderState mRenderState;
+
+    // Where this layer was last found among its siblings
+    mutable std::atomic<int> mSiblingIndexHint { 0 };
+
     friend class Map;
     friend class GroupLayer;
 };
@@ -287,6 +326,7 @@ protected:
 inline void Layer::setOffset(const QPointF &offset)
 {
     mOffset = offset;
+    updateRenderState();
 }
 
 /**
@@ -303,6 +343,7 @@ inline QPointF Layer::offset() const
 inline void Layer::setParallaxFactor(const QPointF &factor)
 {
     mParallaxFactor = factor;
+    updateRenderState();
 }
 
 /**
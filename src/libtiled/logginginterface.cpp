@@ -35,9 +35,11 @@
 #include "objectgroup.h"
 #include "wangset.h"
 
+#include <QCoreApplication>
+
 namespace Tiled {
 
-unsigned Issue::mNextIssueId = 1;
+std::atomic<unsigned> Issue::mNextIssueId { 1 };
 
 Issue::Issue()
     : Issue(Error, QString())
@@ -63,7 +65,7 @@ void Issue::setCallback(std::function<void ()> callback)
 
 void Issue::addOccurrence(const Issue &issue)
 {
-    mOccurrences += 1;
+    mOccurrences += issue.occurrences();
     setCallback(issue.callback());
     setContext(issue.context());
 }
@@ -71,7 +73,17 @@ void Issue::addOccurrence(const Issue &issue)
 
 LoggingInterface::LoggingInterface(QObject *parent)
     : QObject(parent)
-{}
+    , mFlushTimer(this)
+{
+    // Issues are delivered from the main thread, even when the first issue
+    // is reported from a worker thread.
+    if (auto app = QCoreApplication::instance())
+        moveToThread(app->thread());
+
+    mFlushTimer.setSingleShot(true);
+    mFlushTimer.setInterval(100);
+    connect(&mFlushTimer, &QTimer::timeout, this, &LoggingInterface::flushIssues);
+}
 
 LoggingInterface &LoggingInterface::instance()
 {
@@ -80,9 +92,11 @@ LoggingInterface &LoggingInterface::instance()
 }
 
 /**
- * Reports an issue by emitting the "issue" signal with the given \a issue.
+ * Reports the given \a issue. Emits the "warning" or "error" signals right
+ * away, while the issue itself is queued and delivered along with other
+ * issues by the "issuesReported" signal.
  *
- * Also emits "warning" or "error" signals as appropriate.
+ * Can be called from any thread.
  */
 void LoggingInterface::report(const Issue &issue)
 {
@@ -95,7 +109,47 @@ void LoggingInterface::report(const Issue &issue)
         break;
     }
 
-    emit this->issue(issue);
+    const QPair<int, QString> key(issue.severity(), issue.text());
+    bool startTimer = false;
+
+    {
+        QMutexLocker locker(&mPendingIssuesMutex);
+
+        const auto it = mPendingIssueIndexes.constFind(key);
+        if (it != mPendingIssueIndexes.constEnd()) {
+            mPendingIssues[it.value()].addOccurrence(issue);
+        } else {
+            startTimer = mPendingIssues.isEmpty();
+            mPendingIssueIndexes.insert(key, mPendingIssues.size());
+            mPendingIssues.append(issue);
+        }
+    }
+
+    if (startTimer) {
+        QMetaObject::invokeMethod(this, [this] {
+            if (!mFlushTimer.isActive())
+                mFlushTimer.start();
+        });
+    }
+}
+
+/**
+ * Emits the "issuesReported" signal for any pending issues immediately.
+ *
+ * Should be called from the main thread.
+ */
+void LoggingInterface::flushIssues()
+{
+    QVector<Issue> issues;
+
+    {
+        QMutexLocker locker(&mPendingIssuesMutex);
+        issues.swap(mPendingIssues);
+        mPendingIssueIndexes.clear();
+    }
+
+    if (!issues.isEmpty())
+        emit issuesReported(issues);
 }
 
 /**
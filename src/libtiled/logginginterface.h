@@ -31,10 +31,15 @@
 
 #include "tiled_global.h"
 
+#include <QHash>
+#include <QMutex>
 #include <QObject>
 #include <QPoint>
+#include <QTimer>
+#include <QVector>
 #include <QWeakPointer>
 
+#include <atomic>
 #include <functional>
 
 class QString;
@@ -91,7 +96,7 @@ private:
     int mOccurrences = 1;
     unsigned mId = 0;
 
-    static unsigned mNextIssueId;
+    static std::atomic<unsigned> mNextIssueId;
 };
 
 /**
@@ -117,14 +122,26 @@ public:
     void report(const Issue &issue);
     void log(OutputType type, const QString &message);
 
+    void flushIssues();
+
 signals:
-    void issue(const Tiled::Issue &issue);
+    /**
+     * Emitted periodically with the issues reported since the last batch.
+     * Repeated issues are merged, with their occurrences added up.
+     */
+    void issuesReported(const QVector<Tiled::Issue> &issues);
 
     void info(const QString &message);
     void warning(const QString &message);
     void error(const QString &message);
 
     void removeIssuesWithContext(const void *context);
+
+private:
+    QMutex mPendingIssuesMutex;
+    QVector<Issue> mPendingIssues;
+    QHash<QPair<int, QString>, int> mPendingIssueIndexes;
+    QTimer mFlushTimer;
 };
 
 inline void REPORT(const Issue &issue)
@@ -244,9 +244,10 @@ Layer *Map::takeLayerAt(int index)
  */
 bool Map::addTileset(const SharedTileset &tileset)
 {
-    if (mTilesets.contains(tileset))
+    if (indexOfTileset(tileset) != -1)
         return false;
 
+    mTilesetIndex.insert(tileset.data(), mTilesets.size());
     mTilesets.append(tileset);
     invalidateDrawMargins();
     return true;
@@ -266,8 +267,9 @@ void Map::addTilesets(const QSet<SharedTileset> &tilesets)
  */
 void Map::insertTileset(int index, const SharedTileset &tileset)
 {
-    Q_ASSERT(!mTilesets.contains(tileset));
+    Q_ASSERT(indexOfTileset(tileset) == -1);
     mTilesets.insert(index, tileset);
+    mTilesetIndexValid = false;
     invalidateDrawMargins();
 }
 
@@ -277,7 +279,10 @@ void Map::insertTileset(int index, const SharedTileset &tileset)
  */
 int Map::indexOfTileset(const SharedTileset &tileset) const
 {
-    return mTilesets.indexOf(tileset);
+    if (!mTilesetIndexValid)
+        buildTilesetIndex();
+
+    return mTilesetIndex.value(tileset.data(), -1);
 }
 
 /**
@@ -291,6 +296,7 @@ int Map::indexOfTileset(const SharedTileset &tileset) const
 void Map::removeTilesetAt(int index)
 {
     mTilesets.remove(index);
+    mTilesetIndexValid = false;
     invalidateDrawMargins();
 }
 
@@ -306,7 +312,7 @@ bool Map::replaceTileset(const SharedTileset &oldTileset,
 {
     Q_ASSERT(oldTileset != newTileset);
 
-    const int index = mTilesets.indexOf(oldTileset);
+    const int index = indexOfTileset(oldTileset);
     Q_ASSERT(index != -1);
 
     const auto &layers = mLayers;
@@ -317,11 +323,14 @@ bool Map::replaceTileset(const SharedTileset &oldTileset,
 
     invalidateDrawMargins();
 
-    if (mTilesets.contains(newTileset)) {
+    if (indexOfTileset(newTileset) != -1) {
         mTilesets.remove(index);
+        mTilesetIndexValid = false;
         return false;
     } else {
         mTilesets.replace(index, newTileset);
+        mTilesetIndex.remove(oldTileset.data());
+        mTilesetIndex.insert(newTileset.data(), index);
         return true;
     }
 }
@@ -347,6 +356,8 @@ QSet<SharedTileset> Map::usedTilesets() const
  */
 bool Map::isTilesetUsed(const Tileset *tileset) const
 {
+    // Each layer keeps track of the tilesets it uses, so this only needs to
+    // look up the tileset for each top-level layer
     for (const Layer *layer : mLayers)
         if (layer->referencesTileset(tileset))
             return true;
@@ -371,18 +382,60 @@ std::unique_ptr<Map> Map::clone() const
         o->mLayers.append(clone);
     }
     o->mTilesets = mTilesets;
+    o->mTilesetIndex = mTilesetIndex;
+    o->mTilesetIndexValid = mTilesetIndexValid;
     o->mNextLayerId = mNextLayerId;
     o->mNextObjectId = mNextObjectId;
     return o;
 }
 
+/**
+ * Returns an immutable copy of this map, which any number of threads can read
+ * without locking while this map continues to be edited.
+ *
+ * Taking a snapshot is cheap for tile layers, since their chunks and
+ * properties are implicitly shared until this map changes them. Embedded
+ * tilesets are copied, since they are edited along with the map, whereas
+ * external tilesets are shared.
+ *
+ * Paged out chunks are paged in and the indexes that are otherwise built on
+ * first use are built up front, so that reading the snapshot doesn't change
+ * it. Needs to be called from the thread that owns this map.
+ */
+std::shared_ptr<const Map> Map::snapshot() const
+{
+    std::shared_ptr<Map> snapshot = clone();
+
+    // Chunk stores can only be used from the thread owning the map
+    snapshot->pageInAllChunks();
+
+    const auto tilesets = snapshot->tilesets();
+    for (const SharedTileset &tileset : tilesets)
+        if (tileset->fileName().isEmpty())
+            snapshot->replaceTileset(tileset, tileset->clone());
+
+    if (snapshot->mDrawMarginsDirty)
+        snapshot->recomputeDrawMargins();
+    snapshot->buildTilesetIndex();
+    snapshot->buildObjectIndex();
+    snapshot->buildObjectClassIndex();
+
+    for (Layer *layer : snapshot->objectGroups())
+        static_cast<ObjectGroup*>(layer)->buildIndexes();
+
+    return snapshot;
+}
+
 /**
  * Copies the given \a tileRegion of the \a layers to \a targetMap.
  *
  * Empty layers are included as well, to ensure a more consistent behavior when
  * copy/pasting multiple layers.
  *
- * Currently only copies tile layers.
+ * Currently only copies tile layers. Stored chunks that are paged out are
+ * copied as empty, so the region should be paged in first.
+ *
+ * \sa pageInChunks()
  */
 void Map::copyLayers(const QList<Layer *> &layers,
                      const QRegion &tileRegion,
@@ -428,7 +481,7 @@ void Map::normalizeTileLayerPositionsAndMapSize()
 
     QRect contentRect;
     while (auto tileLayer = static_cast<TileLayer*>(it.next()))
-        contentRect |= tileLayer->region().boundingRect();
+        contentRect |= tileLayer->usedBounds();
 
     if (!contentRect.topLeft().isNull()) {
         it.toFront();
@@ -485,15 +538,143 @@ Layer *Map::findLayerById(int layerId) const
     return nullptr;
 }
 
+/**
+ * Returns the object with the given \a objectId, or nullptr when no such
+ * object exists. When several objects share the same ID, the first one is
+ * returned.
+ *
+ * The lookup uses a hash that is built on first use and then kept up to date
+ * as objects are added and removed.
+ */
 MapObject *Map::findObjectById(int objectId) const
 {
+    if (!mObjectIndexValid)
+        buildObjectIndex();
+
+    return mObjectsById.value(objectId);
+}
+
+/**
+ * Returns the objects that have the given \a className set on them (or on
+ * their template). Tile objects inheriting their class from the tile are not
+ * included.
+ */
+QList<MapObject *> Map::findObjectsByClassName(const QString &className) const
+{
+    if (!mObjectClassIndexValid)
+        buildObjectClassIndex();
+
+    return mObjectsByClassName.value(className);
+}
+
+void Map::objectAdded(MapObject *object)
+{
+    mObjectClassIndexValid = false;
+
+    if (!mObjectIndexValid || object->id() == 0)
+        return;
+
+    auto it = mObjectsById.find(object->id());
+    if (it == mObjectsById.end())
+        mObjectsById.insert(object->id(), object);
+    else if (it.value() != object)
+        invalidateObjectIndex();    // rebuild to find the first one
+}
+
+void Map::objectRemoved(MapObject *object)
+{
+    mObjectClassIndexValid = false;
+
+    if (!mObjectIndexValid)
+        return;
+
+    auto it = mObjectsById.find(object->id());
+    if (it == mObjectsById.end() || it.value() != object)
+        return;
+
+    if (mHasDuplicateObjectIds)
+        invalidateObjectIndex();    // another object may take its place
+    else
+        mObjectsById.erase(it);
+}
+
+void Map::objectIdChanged(MapObject *object, int oldId)
+{
+    if (!mObjectIndexValid)
+        return;
+
+    auto it = mObjectsById.find(oldId);
+    if (it != mObjectsById.end() && it.value() == object) {
+        if (mHasDuplicateObjectIds) {
+            invalidateObjectIndex();
+            return;
+        }
+        mObjectsById.erase(it);
+    }
+
+    objectAdded(object);
+}
+
+void Map::objectClassNameChanged()
+{
+    mObjectClassIndexValid = false;
+}
+
+/**
+ * Drops the object index, for example when an object layer is added or
+ * removed. It will be rebuilt on the next lookup.
+ */
+void Map::invalidateObjectIndex()
+{
+    mObjectsById.clear();
+    mObjectsByClassName.clear();
+    mObjectIndexValid = false;
+    mObjectClassIndexValid = false;
+    mHasDuplicateObjectIds = false;
+}
+
+void Map::buildTilesetIndex() const
+{
+    mTilesetIndex.clear();
+    mTilesetIndex.reserve(mTilesets.size());
+
+    for (int i = 0; i < mTilesets.size(); ++i)
+        mTilesetIndex.insert(mTilesets.at(i).data(), i);
+
+    mTilesetIndexValid = true;
+}
+
+void Map::buildObjectIndex() const
+{
+    mObjectsById.clear();
+    mHasDuplicateObjectIds = false;
+
     for (Layer *layer : objectGroups()) {
         for (MapObject *mapObject : static_cast<ObjectGroup*>(layer)->objects()) {
-            if (mapObject->id() == objectId)
-                return mapObject;
+            if (mapObject->id() == 0)
+                continue;
+
+            if (mObjectsById.contains(mapObject->id()))
+                mHasDuplicateObjectIds = true;
+            else
+                mObjectsById.insert(mapObject->id(), mapObject);
         }
     }
-    return nullptr;
+
+    mObjectIndexValid = true;
+}
+
+void Map::buildObjectClassIndex() const
+{
+    mObjectsByClassName.clear();
+
+    for (Layer *layer : objectGroups()) {
+        for (MapObject *mapObject : static_cast<ObjectGroup*>(layer)->objects())
+            if (!mapObject->className().isEmpty())
+                mObjectsByClassName[mapObject->className()].append(mapObject);
+    }
+
+    mObjectClassIndexValid = true;
 }
 
 /**
@@ -527,6 +708,54 @@ QRegion Map::modifiedTileRegion() const
     return region;
 }
 
+/**
+ * Returns whether any of the tile layers has stored chunks that are not in
+ * memory.
+ *
+ * \sa TileLayer::setChunkStore()
+ */
+bool Map::hasPagedOutChunks() const
+{
+    LayerIterator it(this, Layer::TileLayerType);
+    while (auto tileLayer = static_cast<TileLayer*>(it.next()))
+        if (tileLayer->hasPagedOutChunks())
+            return true;
+    return false;
+}
+
+/**
+ * Loads the stored chunks of all tile layers within \a area (in map tile
+ * coordinates), for example before copying that area. Returns false when
+ * any of the chunks failed to load.
+ */
+bool Map::pageInChunks(const QRegion &area)
+{
+    bool success = true;
+    const QRect rect = area.boundingRect();
+
+    LayerIterator it(this, Layer::TileLayerType);
+    while (auto tileLayer = static_cast<TileLayer*>(it.next()))
+        success &= tileLayer->pageIn(rect.translated(-tileLayer->position()));
+
+    return success;
+}
+
+/**
+ * Loads all stored chunks of all tile layers. This is needed before writing
+ * the map in a format that doesn't know about chunk stores. Returns false
+ * when any of the chunks failed to load.
+ */
+bool Map::pageInAllChunks()
+{
+    bool success = true;
+
+    LayerIterator it(this, Layer::TileLayerType);
+    while (auto tileLayer = static_cast<TileLayer*>(it.next()))
+        success &= tileLayer->pageInAll();
+
+    return success;
+}
+
 QString Tiled::staggerAxisToString(Map::StaggerAxis staggerAxis)
 {
     switch (staggerAxis) {
@@ -609,6 +838,7 @@ QString Tiled::compressionToString(Map::LayerDataFormat layerDataFormat)
     case Map::Base64Zlib:
         return QStringLiteral("zlib");
     case Map::Base64Zstandard:
+    case Map::Base64ZstandardDictionary:
         return QStringLiteral("zstd");
     }
     return QString();
@@ -35,6 +35,7 @@
 #include "tileset.h"
 
 #include <QColor>
+#include <QHash>
 #include <QList>
 #include <QMargins>
 #include <QSharedPointer>
@@ -116,7 +117,8 @@ public:
         Base64Gzip      = 2,
         Base64Zlib      = 3,
         Base64Zstandard = 4,
-        CSV             = 5
+        CSV             = 5,
+        Base64ZstandardDictionary = 6
     };
 
     /**
@@ -167,7 +169,7 @@ public:
     struct EditorSettings
     {
         int compressionLevel = -1;
-        QSize chunkSize = QSize(CHUNK_SIZE, CHUNK_SIZE);
+        QSize chunkSize = QSize(OUTPUT_CHUNK_SIZE, OUTPUT_CHUNK_SIZE);
         LayerDataFormat layerDataFormat = Base64Zlib;
     };
 
@@ -289,6 +291,7 @@ public:
     bool isTilesetUsed(const Tileset *tileset) const;
 
     std::unique_ptr<Map> clone() const;
+    std::shared_ptr<const Map> snapshot() const;
 
     void copyLayers(const QList<Layer*> &layers,
                     const QRegion &tileRegion,
@@ -312,16 +315,34 @@ public:
 
     Layer *findLayerById(int layerId) const;
     MapObject *findObjectById(int objectId) const;
+    QList<MapObject*> findObjectsByClassName(const QString &className) const;
+
+    /**
+     * Called by ObjectGroup and MapObject to keep the object index up to
+     * date.
+     */
+    void objectAdded(MapObject *object);
+    void objectRemoved(MapObject *object);
+    void objectIdChanged(MapObject *object, int oldId);
+    void objectClassNameChanged();
+    void invalidateObjectIndex();
 
     QRect tileBoundingRect() const;
     QRegion modifiedTileRegion() const;
 
+    bool hasPagedOutChunks() const;
+    bool pageInChunks(const QRegion &area);
+    bool pageInAllChunks();
+
 private:
     friend class GroupLayer;    // so it can call adoptLayer
 
     void adoptLayer(Layer &layer);
 
     void recomputeDrawMargins() const;
+    void buildTilesetIndex() const;
+    void buildObjectIndex() const;
+    void buildObjectClassIndex() const;
 
     Parameters mParameters;
     EditorSettings mEditorSettings;
@@ -331,9 +352,17 @@ private:
 
     QList<Layer*> mLayers;
     QVector<SharedTileset> mTilesets;
+    mutable QHash<const Tileset*, int> mTilesetIndex;
+    mutable bool mTilesetIndexValid = false;
 
     int mNextLayerId = 1;
     int mNextObjectId = 1;
+
+    mutable QHash<int, MapObject*> mObjectsById;
+    mutable QHash<QString, QList<MapObject*>> mObjectsByClassName;
+    mutable bool mObjectIndexValid = false;
+    mutable bool mObjectClassIndexValid = false;
+    mutable bool mHasDuplicateObjectIds = false;
 };
 
 
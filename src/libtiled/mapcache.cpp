@@ -0,0 +1,347 @@
+/*
+ * mapcache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mapcache.h"
+
+#include "map.h"
+#include "mapformat.h"
+#include "maptovariantconverter.h"
+#include "varianttomapconverter.h"
+
+#include <QCborValue>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace Tiled {
+
+// Changing the layout of the snapshots requires increasing the version
+static const quint32 SnapshotMagic = 0x544d4353;   // "TMCS"
+static const quint32 SnapshotVersion = 2;
+
+// Smaller maps load fast enough to not be worth caching
+static const qint64 MinimumFileSize = 1024 * 1024;
+
+// The total size of the snapshots, beyond which the oldest are removed
+static const qint64 MaximumCacheSize = 1024 * 1024 * 1024;
+
+bool MapCache::mEnabled = true;
+bool MapCache::mStoreSnapshots = false;
+
+/**
+ * Does the part of reading the map at \a fileName that can be done on a
+ * worker thread. This parses the snapshot when an up-to-date one is
+ * available, and otherwise leaves the parsing to the \a format.
+ */
+MapCache::Parsed MapCache::parseMap(const MapFormat *format, const QString &fileName)
+{
+    Parsed parsed;
+
+    if (useCache(fileName)) {
+        parsed.contentHash = contentHash(fileName);
+        parsed.snapshot = parseSnapshot(format, fileName, parsed.contentHash,
+                                        &parsed.layerDataFormat);
+    }
+
+    if (!parsed.snapshot.isValid())
+        parsed.data = format->parse(fileName);
+
+    return parsed;
+}
+
+/**
+ * Reads the map at \a fileName using the given \a format, using a snapshot
+ * when an up-to-date one is available. Otherwise, a snapshot is stored after
+ * the map was read successfully.
+ *
+ * When the file was already parsed using parseMap(), the result can be
+ * passed as \a parsed.
+ *
+ * The error message is set when reading failed.
+ */
+std::unique_ptr<Map> MapCache::readMap(MapFormat *format,
+                                       const QString &fileName,
+                                       QString *error,
+                                       const Parsed *parsed)
+{
+    const bool cache = useCache(fileName);
+    QByteArray hash;
+
+    if (cache) {
+        QVariant snapshot;
+        int layerDataFormat = 0;
+
+        if (parsed && !parsed->contentHash.isEmpty()) {
+            hash = parsed->contentHash;
+            snapshot = parsed->snapshot;
+            layerDataFormat = parsed->layerDataFormat;
+        } else {
+            hash = contentHash(fileName);
+            snapshot = parseSnapshot(format, fileName, hash, &layerDataFormat);
+        }
+
+        if (snapshot.isValid()) {
+            if (auto map = fromSnapshot(snapshot, layerDataFormat, fileName)) {
+                // Marks the snapshot as recently used
+                QFile snapshotFile(snapshotFileName(fileName));
+                if (snapshotFile.open(QIODevice::Append))
+                    snapshotFile.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+                if (error)
+                    error->clear();
+                return map;
+            }
+        }
+    }
+
+    std::unique_ptr<Map> map = parsed && parsed->data.isValid()
+            ? format->readParsed(fileName, parsed->data)
+            : format->read(fileName);
+
+    if (error) {
+        if (map)
+            error->clear();
+        else
+            *error = format->errorString();
+    }
+
+    if (map && cache && mStoreSnapshots && !hash.isEmpty())
+        store(*map, format, fileName, hash);
+
+    return map;
+}
+
+bool MapCache::isEnabled()
+{
+    return mEnabled;
+}
+
+void MapCache::setEnabled(bool enabled)
+{
+    mEnabled = enabled;
+}
+
+bool MapCache::storeSnapshots()
+{
+    return mStoreSnapshots;
+}
+
+/**
+ * Sets whether snapshots are stored for maps that were read without one.
+ * Existing snapshots are used either way.
+ */
+void MapCache::setStoreSnapshots(bool enabled)
+{
+    mStoreSnapshots = enabled;
+}
+
+bool MapCache::useCache(const QString &fileName)
+{
+    return mEnabled && QFileInfo(fileName).size() >= MinimumFileSize;
+}
+
+/**
+ * Returns a hash of the contents of the given file, which catches changes
+ * that keep its size and modification time. This is much faster than
+ * parsing the map. Returns an empty array when the file can't be read.
+ *
+ * This function is thread-safe.
+ */
+QByteArray MapCache::contentHash(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    if (!hash.addData(&file))
+        return QByteArray();
+
+    return hash.result();
+}
+
+/**
+ * Parses the snapshot for the given map, if there is one that is still
+ * valid. The snapshot file is memory mapped, so it is parsed without first
+ * reading it into memory.
+ *
+ * This function is thread-safe.
+ */
+QVariant MapCache::parseSnapshot(const MapFormat *format, const QString &fileName,
+                                 const QByteArray &contentHash,
+                                 int *layerDataFormat)
+{
+    if (contentHash.isEmpty())
+        return QVariant();
+
+    QFile file(snapshotFileName(fileName));
+    if (!file.open(QIODevice::ReadOnly))
+        return QVariant();
+
+    const qint64 size = file.size();
+    const uchar *mapped = size > 0 ? file.map(0, size) : nullptr;
+    if (!mapped)
+        return QVariant();
+
+    // Not a deep copy, the data stays in the mapped pages
+    const QByteArray snapshot = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped),
+                                                        static_cast<int>(size));
+
+    QDataStream stream(snapshot);
+    stream.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic;
+    quint32 version;
+    QString tiledVersion;
+    QString qtVersion;
+    QString formatName;
+    qint64 fileSize;
+    qint64 lastModified;
+    QByteArray hash;
+    qint32 dataFormat;
+
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != SnapshotMagic || version != SnapshotVersion)
+        return QVariant();
+
+    stream >> tiledVersion >> qtVersion >> formatName >> fileSize >> lastModified
+           >> hash >> dataFormat;
+
+    const QFileInfo fileInfo(fileName);
+
+    if (stream.status() != QDataStream::Ok ||
+            tiledVersion != QCoreApplication::applicationVersion() ||
+            qtVersion != QLatin1String(qVersion()) ||
+            formatName != format->shortName() ||
+            fileSize != fileInfo.size() ||
+            lastModified != fileInfo.lastModified().toMSecsSinceEpoch() ||
+            hash != contentHash)
+        return QVariant();
+
+    const qint64 headerSize = stream.device()->pos();
+    const QCborValue value = QCborValue::fromCbor(QByteArray::fromRawData(snapshot.constData() + headerSize,
+                                                                          static_cast<int>(size - headerSize)));
+    if (!value.isMap())
+        return QVariant();
+
+    *layerDataFormat = dataFormat;
+    return value.toVariant();
+}
+
+/**
+ * Creates the map from a snapshot parsed by parseSnapshot().
+ */
+std::unique_ptr<Map> MapCache::fromSnapshot(const QVariant &snapshot,
+                                            int layerDataFormat,
+                                            const QString &fileName)
+{
+    VariantToMapConverter converter;
+    std::unique_ptr<Map> map = converter.toMap(snapshot, QFileInfo(fileName).dir());
+    if (map)
+        map->setLayerDataFormat(static_cast<Map::LayerDataFormat>(layerDataFormat));
+
+    return map;
+}
+
+/**
+ * Stores a snapshot of the given \a map. Any errors are ignored, since the
+ * cache is only an optimization.
+ *
+ * The layer data is always stored uncompressed, since that is fastest to
+ * load. The original layer data format is remembered separately.
+ *
+ * The \a contentHash needs to be taken before the map was read, so that the
+ * snapshot doesn't get associated with contents written in the meantime.
+ */
+void MapCache::store(const Map &map, MapFormat *format, const QString &fileName,
+                     const QByteArray &contentHash)
+{
+    const QString snapshotFile = snapshotFileName(fileName);
+    QDir().mkpath(QFileInfo(snapshotFile).path());
+
+    QSaveFile file(snapshotFile);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    const QFileInfo fileInfo(fileName);
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream << SnapshotMagic
+           << SnapshotVersion
+           << QCoreApplication::applicationVersion()
+           << QString::fromLatin1(qVersion())
+           << format->shortName()
+           << fileInfo.size()
+           << fileInfo.lastModified().toMSecsSinceEpoch()
+           << contentHash
+           << static_cast<qint32>(map.layerDataFormat());
+
+    MapToVariantConverter converter;
+    converter.setLayerDataFormat(Map::Base64);
+    const QVariant variant = converter.toVariant(map, fileInfo.dir());
+
+    file.write(QCborValue::fromVariant(variant).toCbor());
+
+    if (stream.status() == QDataStream::Ok && file.commit())
+        prune(snapshotFile);
+}
+
+/**
+ * Removes the least recently used snapshots, until their total size is
+ * within the limit. The \a snapshotFile that was just stored is kept.
+ */
+void MapCache::prune(const QString &snapshotFile)
+{
+    const QFileInfo snapshotInfo(snapshotFile);
+    const QFileInfoList snapshots = snapshotInfo.dir().entryInfoList(QDir::Files, QDir::Time);
+
+    qint64 totalSize = 0;
+    for (const QFileInfo &info : snapshots) {
+        totalSize += info.size();
+        if (totalSize > MaximumCacheSize && info != snapshotInfo)
+            QFile::remove(info.filePath());
+    }
+}
+
+QString MapCache::snapshotFileName(const QString &fileName)
+{
+    const QString absolutePath = QFileInfo(fileName).absoluteFilePath();
+    const QByteArray hash = QCryptographicHash::hash(absolutePath.toUtf8(),
+                                                     QCryptographicHash::Sha1).toHex();
+
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + QLatin1String("/maps/") + QString::fromLatin1(hash);
+}
+
+} // namespace Tiled
@@ -0,0 +1,103 @@
+/*
+ * mapcache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QString>
+#include <QVariant>
+
+#include <memory>
+
+namespace Tiled {
+
+class Map;
+class MapFormat;
+
+/**
+ * A cache of binary snapshots of large maps, which allows maps that did not
+ * change on disk to be reopened without parsing them again.
+ *
+ * The snapshots are stored in the user's cache location and are keyed by
+ * the absolute path of the map. A snapshot is only used when the size,
+ * modification time and a hash of the contents of the map file, as well as
+ * the Tiled and Qt versions and the map format, match the ones it was
+ * created for.
+ *
+ * Snapshots are only stored when enabled with setStoreSnapshots(), which is
+ * left off by the command-line tools. The total size of the snapshots is
+ * limited, removing the least recently used ones first.
+ */
+class TILEDSHARED_EXPORT MapCache
+{
+public:
+    /**
+     * The result of parseMap(), to be passed on to readMap().
+     */
+    struct Parsed
+    {
+        QVariant snapshot;          // set when an up-to-date snapshot was found
+        int layerDataFormat = 0;
+        QByteArray contentHash;
+        QVariant data;              // see MapFormat::parse
+    };
+
+    static Parsed parseMap(const MapFormat *format, const QString &fileName);
+
+    static std::unique_ptr<Map> readMap(MapFormat *format,
+                                        const QString &fileName,
+                                        QString *error = nullptr,
+                                        const Parsed *parsed = nullptr);
+
+    static bool isEnabled();
+    static void setEnabled(bool enabled);
+
+    static bool storeSnapshots();
+    static void setStoreSnapshots(bool enabled);
+
+private:
+    static bool useCache(const QString &fileName);
+    static QByteArray contentHash(const QString &fileName);
+    static QVariant parseSnapshot(const MapFormat *format, const QString &fileName,
+                                  const QByteArray &contentHash,
+                                  int *layerDataFormat);
+    static std::unique_ptr<Map> fromSnapshot(const QVariant &snapshot,
+                                             int layerDataFormat,
+                                             const QString &fileName);
+    static void store(const Map &map, MapFormat *format, const QString &fileName,
+                      const QByteArray &contentHash);
+    static void prune(const QString &snapshotFile);
+
+    static QString snapshotFileName(const QString &fileName);
+
+    static bool mEnabled;
+    static bool mStoreSnapshots;
+};
+
+} // namespace Tiled
@@ -29,6 +29,7 @@
 #include "mapformat.h"
 
 #include "map.h"
+#include "mapcache.h"
 #include "mapreader.h"
 
 namespace Tiled {
@@ -37,14 +38,7 @@ std::unique_ptr<Map> readMap(const QString &fileName, QString *error)
 {
     // Try the first registered map format that claims to support the file
     if (MapFormat *format = findSupportingMapFormat(fileName)) {
-        std::unique_ptr<Map> map(format->read(fileName));
-
-        if (error) {
-            if (!map)
-                *error = format->errorString();
-            else
-                *error = QString();
-        }
+        std::unique_ptr<Map> map(MapCache::readMap(format, fileName, error));
 
         if (map)
             map->fileName = fileName;
@@ -72,6 +72,25 @@ public:
      */
     virtual std::unique_ptr<Map> read(const QString &fileName) = 0;
 
+    /**
+     * Does the part of reading the map that doesn't touch any shared state,
+     * like reading and parsing the file. This is called on a worker thread
+     * when opening several files at once, and the result is passed to
+     * readParsed() on the main thread.
+     *
+     * Returns an invalid QVariant when the format doesn't support this or
+     * when parsing failed, in which case read() is used instead.
+     */
+    virtual QVariant parse(const QString &fileName) const
+    { Q_UNUSED(fileName) return QVariant(); }
+
+    /**
+     * Reads the map from the \a data returned by parse(). The default
+     * implementation ignores the data and calls read().
+     */
+    virtual std::unique_ptr<Map> readParsed(const QString &fileName, const QVariant &data)
+    { Q_UNUSED(data) return read(fileName); }
+
     /**
      * Writes the given \a map based on the suggested \a fileName.
      *
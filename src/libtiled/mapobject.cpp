@@ -37,6 +37,8 @@
 #include "tile.h"
 
 #include <QFontMetricsF>
+
+#include <atomic>
 #include <qmath.h>
 
 namespace Tiled {
@@ -74,6 +76,16 @@ QSizeF TextData::textSize() const
 }
 
 
+/**
+ * Returns the text data shared by all objects that don't have any text.
+ */
+static const std::shared_ptr<TextData> &defaultTextData()
+{
+    // Never deleted, since QFont can't be destroyed after the application
+    static const auto textData = new std::shared_ptr<TextData>(std::make_shared<TextData>());
+    return *textData;
+}
+
 MapObject::MapObject(const QString &name,
                      const QString &className,
                      const QPointF &pos,
@@ -82,7 +94,41 @@ MapObject::MapObject(const QString &name,
     , mName(name)
     , mPos(pos)
     , mSize(size)
+    , mTextData(defaultTextData())
+{
+    geometryChanged();
+}
+
+/**
+ * Sets the id of this object.
+ */
+void MapObject::setId(int id)
+{
+    if (mId == id)
+        return;
+
+    const int oldId = mId;
+    mId = id;
+
+    if (Map *map = this->map())
+        map->objectIdChanged(this, oldId);
+}
+
+/**
+ * Lets the object group update its spatial index.
+ */
+void MapObject::boundsChanged()
 {
+    geometryChanged();
+
+    if (mObjectGroup)
+        mObjectGroup->objectBoundsChanged(this);
+}
+
+void MapObject::geometryChanged()
+{
+    static std::atomic<quint64> lastGeometryRevision { 0 };
+    mGeometryRevision = ++lastGeometryRevision;
 }
 
 int MapObject::index() const
@@ -114,7 +160,28 @@ const QString &MapObject::effectiveClassName() const
  */
 void MapObject::setTextData(const TextData &textData)
 {
-    mTextData = textData;
+    mTextData = std::make_shared<TextData>(textData);
+    geometryChanged();
+}
+
+/**
+ * Returns the text data for modification, making a copy first when it is
+ * shared with other objects.
+ */
+TextData &MapObject::textDataForWriting()
+{
+    if (mTextData.use_count() > 1)
+        mTextData = std::make_shared<TextData>(*mTextData);
+    return *mTextData;
+}
+
+/**
+ * Shares the text data of the \a other object, rather than copying it.
+ */
+void MapObject::shareTextData(const MapObject &other)
+{
+    mTextData = other.mTextData;
+    geometryChanged();
 }
 
 static void align(QRectF &r, Alignment alignment)
@@ -305,11 +372,11 @@ QVariant MapObject::mapObjectProperty(Property property) const
     switch (property) {
     case NameProperty:          return mName;
     case VisibleProperty:       return mVisible;
-    case TextProperty:          return mTextData.text;
-    case TextFontProperty:      return mTextData.font;
-    case TextAlignmentProperty: return QVariant::fromValue(mTextData.alignment);
-    case TextWordWrapProperty:  return mTextData.wordWrap;
-    case TextColorProperty:     return mTextData.color;
+    case TextProperty:          return mTextData->text;
+    case TextFontProperty:      return mTextData->font;
+    case TextAlignmentProperty: return QVariant::fromValue(mTextData->alignment);
+    case TextWordWrapProperty:  return mTextData->wordWrap;
+    case TextColorProperty:     return mTextData->color;
     case PositionProperty:      return mPos;
     case SizeProperty:          return mSize;
     case RotationProperty:      return mRotation;
@@ -327,11 +394,11 @@ void MapObject::setMapObjectProperty(Property property, const QVariant &value)
     switch (property) {
     case NameProperty:          setName(value.toString()); break;
     case VisibleProperty:       setVisible(value.toBool()); break;
-    case TextProperty:          mTextData.text = value.toString(); break;
-    case TextFontProperty:      mTextData.font = value.value<QFont>(); break;
-    case TextAlignmentProperty: mTextData.alignment = value.value<Qt::Alignment>(); break;
-    case TextWordWrapProperty:  mTextData.wordWrap = value.toBool(); break;
-    case TextColorProperty:     mTextData.color = value.value<QColor>(); break;
+    case TextProperty:          textDataForWriting().text = value.toString(); break;
+    case TextFontProperty:      textDataForWriting().font = value.value<QFont>(); break;
+    case TextAlignmentProperty: textDataForWriting().alignment = value.value<Qt::Alignment>(); break;
+    case TextWordWrapProperty:  textDataForWriting().wordWrap = value.toBool(); break;
+    case TextColorProperty:     textDataForWriting().color = value.value<QColor>(); break;
     case PositionProperty:      setPosition(value.toPointF()); break;
     case SizeProperty:          setSize(value.toSizeF()); break;
     case RotationProperty:      setRotation(value.toReal()); break;
@@ -341,6 +408,8 @@ void MapObject::setMapObjectProperty(Property property, const QVariant &value)
     case CustomProperties:      Q_ASSERT(false); break;
     case AllProperties:         Q_ASSERT(false); break;
     }
+
+    geometryChanged();
 }
 
 /**
@@ -370,7 +439,7 @@ MapObject *MapObject::clone() const
     MapObject *o = new MapObject(mName, className(), mPos, mSize);
     o->setId(mId);
     o->setProperties(properties());
-    o->setTextData(mTextData);
+    o->shareTextData(*this);
     o->setPolygon(mPolygon);
     o->setShape(mShape);
     o->setCell(mCell);
@@ -385,7 +454,7 @@ void MapObject::copyPropertiesFrom(const MapObject *object)
 {
     setName(object->name());
     setSize(object->size());
-    setTextData(object->textData());
+    shareTextData(*object);
     setPolygon(object->polygon());
     setShape(object->shape());
     setCell(object->cell());
@@ -416,7 +485,7 @@ void MapObject::syncWithTemplate()
         setSize(base->size());
 
     if (!propertyChanged(MapObject::TextProperty))
-        setTextData(base->textData());
+        shareTextData(*base);
 
     if (!propertyChanged(MapObject::ShapeProperty)) {
         setShape(base->shape());
@@ -483,6 +552,8 @@ void MapObject::flipInScreenCoordinates(FlipDirection direction, const QPointF &
             mCell.setFlippedVertically(!mCell.flippedVertically());
     }
 
+    geometryChanged();
+
     rotationTransform.reset();
     rotationTransform.rotate(-rotation());
     QPointF newScreenPos = newTopLeftScreenPos - rotationTransform.map(flippedAlignmentOffset);
@@ -41,6 +41,8 @@
 #include <QString>
 #include <QTextOption>
 
+#include <memory>
+
 namespace Tiled {
 
 class MapRenderer;
@@ -233,7 +235,15 @@ public:
     bool isTemplateBase() const;
     void markAsTemplateBase();
 
+    quint64 geometryRevision() const;
+
 private:
+    void boundsChanged();
+    void geometryChanged();
+
+    TextData &textDataForWriting();
+    void shareTextData(const MapObject &other);
+
     void flipInScreenCoordinates(FlipDirection direction, const QPointF &screenOrigin);
     void flipInPixelCoordinates(FlipDirection direction, const QPointF &pixelOrigin);
 
@@ -242,7 +252,7 @@ private:
     QString mName;
     QPointF mPos;
     QSizeF mSize;
-    TextData mTextData;
+    std::shared_ptr<TextData> mTextData;    // shared until written
     QPolygonF mPolygon;
     Cell mCell;
     const ObjectTemplate *mObjectTemplate = nullptr;
@@ -251,6 +261,7 @@ private:
     bool mVisible = true;
     bool mTemplateBase = false;
     ChangedProperties mChangedProperties;
+    quint64 mGeometryRevision;
 };
 
 /**
@@ -260,12 +271,6 @@ private:
 inline int MapObject::id() const
 { return mId; }
 
-/**
- * Sets the id of this object.
- */
-inline void MapObject::setId(int id)
-{ mId = id; }
-
 /**
  * Sets the id back to 0. Mostly used when a new id should be assigned
  * after the object has been cloned.
@@ -296,7 +301,10 @@ inline const QPointF &MapObject::position() const
  * Sets the position of this object.
  */
 inline void MapObject::setPosition(const QPointF &pos)
-{ mPos = pos; }
+{
+    mPos = pos;
+    boundsChanged();
+}
 
 /**
  * Returns the x position of this object.
@@ -308,7 +316,10 @@ inline qreal MapObject::x() const
  * Sets the x position of this object.
  */
 inline void MapObject::setX(qreal x)
-{ mPos.setX(x); }
+{
+    mPos.setX(x);
+    boundsChanged();
+}
 
 /**
  * Returns the y position of this object.
@@ -320,7 +331,10 @@ inline qreal MapObject::y() const
  * Sets the x position of this object.
  */
 inline void MapObject::setY(qreal y)
-{ mPos.setY(y); }
+{
+    mPos.setY(y);
+    boundsChanged();
+}
 
 /**
  * Returns the size of this object.
@@ -332,7 +346,10 @@ inline const QSizeF &MapObject::size() const
  * Sets the size of this object.
  */
 inline void MapObject::setSize(const QSizeF &size)
-{ mSize = size; }
+{
+    mSize = size;
+    boundsChanged();
+}
 
 inline void MapObject::setSize(qreal width, qreal height)
 { setSize(QSizeF(width, height)); }
@@ -347,7 +364,10 @@ inline qreal MapObject::width() const
  * Sets the width of this object.
  */
 inline void MapObject::setWidth(qreal width)
-{ mSize.setWidth(width); }
+{
+    mSize.setWidth(width);
+    boundsChanged();
+}
 
 /**
  * Returns the height of this object.
@@ -359,7 +379,10 @@ inline qreal MapObject::height() const
  * Sets the height of this object.
  */
 inline void MapObject::setHeight(qreal height)
-{ mSize.setHeight(height); }
+{
+    mSize.setHeight(height);
+    boundsChanged();
+}
 
 /**
  * Sets the position and size of this object.
@@ -368,13 +391,14 @@ inline void MapObject::setBounds(const QRectF &bounds)
 {
     mPos = bounds.topLeft();
     mSize = bounds.size();
+    boundsChanged();
 }
 
 /**
  * Returns the text associated with this object, when it is a text object.
  */
 inline const TextData &MapObject::textData() const
-{ return mTextData; }
+{ return *mTextData; }
 
 /**
  * Returns the polygon associated with this object. Returns an empty
@@ -390,7 +414,7 @@ inline const QPolygonF &MapObject::polygon() const
  * \sa setShape()
  */
 inline void MapObject::setPolygon(const QPolygonF &polygon)
-{ mPolygon = polygon; }
+{ mPolygon = polygon; geometryChanged(); }
 
 /**
  * Returns the shape of the object.
@@ -402,7 +426,7 @@ inline MapObject::Shape MapObject::shape() const
  * Sets the shape of the object.
  */
 inline void MapObject::setShape(MapObject::Shape shape)
-{ mShape = shape; }
+{ mShape = shape; geometryChanged(); }
 
 /**
  * Returns true if this object has a width and height.
@@ -447,7 +471,7 @@ inline const Cell &MapObject::cell() const
  * \warning The object shape is ignored for tile objects!
  */
 inline void MapObject::setCell(const Cell &cell)
-{ mCell = cell; }
+{ mCell = cell; geometryChanged(); }
 
 inline const ObjectTemplate *MapObject::objectTemplate() const
 { return mObjectTemplate; }
@@ -478,7 +502,7 @@ inline qreal MapObject::rotation() const
  * Sets the rotation of the object in degrees clockwise.
  */
 inline void MapObject::setRotation(qreal rotation)
-{ mRotation = rotation; }
+{ mRotation = rotation; geometryChanged(); }
 
 inline bool MapObject::isVisible() const
 { return mVisible; }
@@ -495,6 +519,15 @@ inline void MapObject::setChangedProperties(ChangedProperties changedProperties)
 inline MapObject::ChangedProperties MapObject::changedProperties() const
 { return mChangedProperties; }
 
+/**
+ * Returns a number that changes whenever a property changes which affects
+ * the shape or bounds of this object. Revisions are unique across objects,
+ * except for copies of an unchanged object, so they can be used as cache key
+ * together with the object pointer.
+ */
+inline quint64 MapObject::geometryRevision() const
+{ return mGeometryRevision; }
+
 inline void MapObject::setPropertyChanged(Property property, bool state)
 {
     mChangedProperties.setFlag(property, state);
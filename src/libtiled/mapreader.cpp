@@ -31,6 +31,7 @@
 #include "mapreader.h"
 
 #include "compression.h"
+#include "csvtokenizer.h"
 #include "gidmapper.h"
 #include "grouplayer.h"
 #include "imagelayer.h"
@@ -42,14 +43,19 @@
 #include "tile.h"
 #include "tilelayer.h"
 #include "tilesetmanager.h"
+#include "tracing.h"
 #include "wangset.h"
 
+#include <QBuffer>
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
 #include <QFileInfo>
+#include <QHash>
+#include <QSet>
 #include <QVector>
 #include <QXmlStreamReader>
+#include <QtConcurrent>
 
 #include <memory>
 
@@ -68,7 +74,8 @@ class MapReaderPrivate
 public:
     explicit MapReaderPrivate(MapReader *mapReader):
         p(mapReader),
-        mReadingExternalTileset(false)
+        mReadingExternalTileset(false),
+        mParallelLayerDecoding(false)
     {}
 
     std::unique_ptr<Map> readMap(QIODevice *device, const QString &path);
@@ -81,6 +88,7 @@ public:
 
 private:
     void readUnknownElement();
+    void readLayerDictionary();
 
     std::unique_ptr<Map> readMap();
     void readMapEditorSettings(Map &map);
@@ -106,9 +114,13 @@ private:
                            QStringView encoding,
                            QRect bounds);
     void decodeBinaryLayerData(TileLayer &tileLayer,
-                               const QByteArray &data,
+                               QStringView data,
                                Map::LayerDataFormat format,
                                QRect bounds);
+    void decodePendingLayerData();
+    QString decodeErrorString(GidMapper::DecodeError error,
+                              const TileLayer &tileLayer,
+                              unsigned invalidTile) const;
     void decodeCSVLayerData(TileLayer &tileLayer,
                             QStringView text,
                             QRect bounds);
@@ -145,7 +157,30 @@ private:
     QDir mPath;
     std::unique_ptr<Map> mMap;
     GidMapper mGidMapper;
+    PropertiesDeduplicator mPropertiesDeduplicator;
     bool mReadingExternalTileset;
+    bool mParallelLayerDecoding;
+
+    /**
+     * Binary layer data of which decoding has been postponed, when layers
+     * are decoded in parallel.
+     */
+    struct PendingLayerData
+    {
+        TileLayer *tileLayer;
+        QString data;
+        Map::LayerDataFormat format;
+        QRect bounds;
+        qint64 lineNumber;
+        qint64 columnNumber;
+    };
+
+    QVector<PendingLayerData> mPendingLayerData;
+
+    /**
+     * Buffer for the GIDs parsed from CSV layer data.
+     */
+    QVector<unsigned> mCsvGids;
 
     QXmlStreamReader xml;
 };
@@ -155,7 +190,10 @@ private:
 
 std::unique_ptr<Map> MapReaderPrivate::readMap(QIODevice *device, const QString &path)
 {
+    TILED_TRACE_SCOPE("MapReader::readMap");
+
     mError.clear();
+    mPendingLayerData.clear();
     mPath.setPath(path);
     std::unique_ptr<Map> map;
 
@@ -168,11 +206,15 @@ std::unique_ptr<Map> MapReaderPrivate::readMap(QIODevice *device, const QString
     }
 
     mGidMapper.clear();
+    mGidMapper.setCompressionDictionary(CompressionDictionary());
+    mPropertiesDeduplicator.clear();
     return map;
 }
 
 SharedTileset MapReaderPrivate::readTileset(QIODevice *device, const QString &path)
 {
+    TILED_TRACE_SCOPE("MapReader::readTileset");
+
     mError.clear();
     mPath.setPath(path);
     SharedTileset tileset;
@@ -299,10 +341,16 @@ std::unique_ptr<Map> MapReaderPrivate::readMap()
             mMap->mergeProperties(readProperties());
         else if (xml.name() == QLatin1String("tileset"))
             mMap->addTileset(readTileset());
+        else if (xml.name() == QLatin1String("layerdictionary"))
+            readLayerDictionary();
         else
             readUnknownElement();
     }
 
+    // Also done in case of error, since the pending layer data precedes the
+    // error and its problems need to be reported first
+    decodePendingLayerData();
+
     // Clean up in case of error
     if (xml.hasError()) {
         mMap.reset();
@@ -319,7 +367,12 @@ std::unique_ptr<Map> MapReaderPrivate::readMap()
             if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
                 for (MapObject *object : *objectGroup) {
                     if (const Tile *tile = object->cell().tile()) {
-                        const QSizeF tileSize = tile->size();
+                        QSizeF tileSize = tile->size();
+
+                        // The tileset image may still be loading
+                        if (tileSize.isEmpty() && !tile->tileset()->isCollection())
+                            tileSize = tile->tileset()->tileSize();
+
                         if (object->width() == 0)
                             object->setWidth(tileSize.width());
                         if (object->height() == 0)
@@ -333,6 +386,29 @@ std::unique_ptr<Map> MapReaderPrivate::readMap()
     return std::move(mMap);
 }
 
+/**
+ * Reads the compression dictionary used by the tile layer data of the map.
+ */
+void MapReaderPrivate::readLayerDictionary()
+{
+    Q_ASSERT(xml.isStartElement() && xml.name() == QLatin1String("layerdictionary"));
+
+    const auto encoding = xml.attributes().value(QLatin1String("encoding"));
+    if (encoding != QLatin1String("base64")) {
+        xml.raiseError(tr("Unknown encoding: %1").arg(encoding.toString()));
+        return;
+    }
+
+    const QByteArray data = QByteArray::fromBase64(xml.readElementText().toLatin1());
+    const CompressionDictionary dictionary(data);
+    if (dictionary.isNull()) {
+        xml.raiseError(tr("Invalid or unsupported layer data dictionary"));
+        return;
+    }
+
+    mGidMapper.setCompressionDictionary(dictionary);
+}
+
 void MapReaderPrivate::readMapEditorSettings(Map &map)
 {
     Q_ASSERT(xml.isStartElement() && xml.name() == QLatin1String("editorsettings"));
@@ -344,8 +420,8 @@ void MapReaderPrivate::readMapEditorSettings(Map &map)
             int chunkWidth = atts.value(QLatin1String("width")).toInt();
             int chunkHeight = atts.value(QLatin1String("height")).toInt();
 
-            chunkWidth = chunkWidth == 0 ? CHUNK_SIZE : qMax(CHUNK_SIZE_MIN, chunkWidth);
-            chunkHeight = chunkHeight == 0 ? CHUNK_SIZE : qMax(CHUNK_SIZE_MIN, chunkHeight);
+            chunkWidth = chunkWidth == 0 ? OUTPUT_CHUNK_SIZE : qMax(CHUNK_SIZE_MIN, chunkWidth);
+            chunkHeight = chunkHeight == 0 ? OUTPUT_CHUNK_SIZE : qMax(CHUNK_SIZE_MIN, chunkHeight);
 
             map.setChunkSize(QSize(chunkWidth, chunkHeight));
 
@@ -459,8 +535,12 @@ SharedTileset MapReaderPrivate::readTileset()
         xml.skipCurrentElement();
     }
 
-    if (tileset && !mReadingExternalTileset)
+    if (tileset && !mReadingExternalTileset) {
+        // Pending layer data needs to be decoded with the tilesets that
+        // preceded it
+        decodePendingLayerData();
         mGidMapper.insert(firstGid, tileset);
+    }
 
     return tileset;
 }
@@ -931,6 +1011,7 @@ void MapReaderPrivate::readTileLayerData(TileLayer &tileLayer)
     const QXmlStreamAttributes atts = xml.attributes();
     const auto encoding = atts.value(QLatin1String("encoding"));
     const auto compression = atts.value(QLatin1String("compression"));
+    const auto filter = atts.value(QLatin1String("filter"));
 
     Map::LayerDataFormat layerDataFormat;
     if (encoding.isEmpty()) {
@@ -945,7 +1026,8 @@ void MapReaderPrivate::readTileLayerData(TileLayer &tileLayer)
         } else if (compression == QLatin1String("zlib")) {
             layerDataFormat = Map::Base64Zlib;
         } else if (compression == QLatin1String("zstd")) {
-            layerDataFormat = Map::Base64Zstandard;
+            layerDataFormat = filter == QLatin1String("delta") ? Map::Base64ZstandardDictionary
+                                                               : Map::Base64Zstandard;
         } else {
             xml.raiseError(tr("Compression method '%1' not supported")
                            .arg(compression.toString()));
@@ -956,6 +1038,11 @@ void MapReaderPrivate::readTileLayerData(TileLayer &tileLayer)
         return;
     }
 
+    if (!filter.isEmpty() && layerDataFormat != Map::Base64ZstandardDictionary) {
+        xml.raiseError(tr("Filter '%1' not supported").arg(filter.toString()));
+        return;
+    }
+
     mMap->setLayerDataFormat(layerDataFormat);
 
     readTileLayerRect(tileLayer,
@@ -1011,10 +1098,19 @@ void MapReaderPrivate::readTileLayerRect(TileLayer &tileLayer,
             }
         } else if (xml.isCharacters() && !xml.isWhitespace()) {
             if (encoding == QLatin1String("base64")) {
-                decodeBinaryLayerData(tileLayer,
-                                      xml.text().toLatin1(),
-                                      layerDataFormat,
-                                      bounds);
+                if (mParallelLayerDecoding) {
+                    mPendingLayerData.append({ &tileLayer,
+                                               xml.text().toString(),
+                                               layerDataFormat,
+                                               bounds,
+                                               xml.lineNumber(),
+                                               xml.columnNumber() });
+                } else {
+                    decodeBinaryLayerData(tileLayer,
+                                          xml.text(),
+                                          layerDataFormat,
+                                          bounds);
+                }
             } else if (encoding == QLatin1String("csv")) {
                 decodeCSVLayerData(tileLayer, xml.text(), bounds);
             }
@@ -1023,7 +1119,7 @@ void MapReaderPrivate::readTileLayerRect(TileLayer &tileLayer,
 }
 
 void MapReaderPrivate::decodeBinaryLayerData(TileLayer &tileLayer,
-                                             const QByteArray &data,
+                                             QStringView data,
                                              Map::LayerDataFormat format,
                                              QRect bounds)
 {
@@ -1031,65 +1127,152 @@ void MapReaderPrivate::decodeBinaryLayerData(TileLayer &tileLayer,
 
     error = mGidMapper.decodeLayerData(tileLayer, data, format, bounds);
 
+    if (error != GidMapper::NoError)
+        xml.raiseError(decodeErrorString(error, tileLayer, mGidMapper.invalidTile()));
+}
+
+/**
+ * Decodes the binary layer data that was collected while reading. Each
+ * tile layer is decoded on its own thread.
+ *
+ * When decoding fails, the error is reported for the first failing data
+ * in document order, at the position where it was read, to match the
+ * errors reported when decoding while reading.
+ */
+void MapReaderPrivate::decodePendingLayerData()
+{
+    if (mPendingLayerData.isEmpty())
+        return;
+
+    // A tile layer can't be modified from multiple threads, so all the data
+    // of a single layer is decoded by the same job
+    struct Job
+    {
+        TileLayer *tileLayer;
+        QVector<int> parts;
+        int failedPart = -1;
+        GidMapper::DecodeError error = GidMapper::NoError;
+        GidMapper::DecodeState state;
+    };
+
+    QVector<Job> jobs;
+    QHash<TileLayer*, int> jobIndexes;
+
+    for (int i = 0; i < mPendingLayerData.size(); ++i) {
+        TileLayer *tileLayer = mPendingLayerData.at(i).tileLayer;
+        auto it = jobIndexes.find(tileLayer);
+        if (it == jobIndexes.end()) {
+            it = jobIndexes.insert(tileLayer, jobs.size());
+            jobs.append(Job { tileLayer, {}, -1, GidMapper::NoError, {} });
+        }
+        jobs[it.value()].parts.append(i);
+    }
+
+    const auto decode = [this] (Job &job) {
+        for (int part : std::as_const(job.parts)) {
+            const PendingLayerData &pending = mPendingLayerData.at(part);
+            job.error = mGidMapper.decodeLayerData(*job.tileLayer,
+                                                   pending.data,
+                                                   pending.format,
+                                                   pending.bounds,
+                                                   job.state);
+            if (job.error != GidMapper::NoError) {
+                job.failedPart = part;
+                break;
+            }
+        }
+    };
+
+    if (jobs.size() == 1)
+        decode(jobs.first());
+    else
+        QtConcurrent::blockingMap(jobs, decode);
+
+    const Job *failedJob = nullptr;
+
+    for (const Job &job : std::as_const(jobs)) {
+        GidMapper::updateNextTileIds(job.state.maxTileIds);
+
+        if (job.error != GidMapper::NoError)
+            if (!failedJob || job.failedPart < failedJob->failedPart)
+                failedJob = &job;
+    }
+
+    if (failedJob) {
+        const PendingLayerData &pending = mPendingLayerData.at(failedJob->failedPart);
+        const QString message = decodeErrorString(failedJob->error,
+                                                  *failedJob->tileLayer,
+                                                  failedJob->state.invalidTile);
+
+        mError = tr("%3\n\nLine %1, column %2")
+                .arg(pending.lineNumber)
+                .arg(pending.columnNumber)
+                .arg(message);
+        xml.raiseError(message);
+    }
+
+    mPendingLayerData.clear();
+}
+
+QString MapReaderPrivate::decodeErrorString(GidMapper::DecodeError error,
+                                            const TileLayer &tileLayer,
+                                            unsigned invalidTile) const
+{
     switch (error) {
     case GidMapper::CorruptLayerData:
-        xml.raiseError(tr("Corrupt layer data for layer '%1'").arg(tileLayer.name()));
-        return;
+        return tr("Corrupt layer data for layer '%1'").arg(tileLayer.name());
     case GidMapper::TileButNoTilesets:
-        xml.raiseError(tr("Tile used but no tilesets specified"));
-        return;
+        return tr("Tile used but no tilesets specified");
     case GidMapper::InvalidTile:
-        xml.raiseError(tr("Invalid tile: %1").arg(mGidMapper.invalidTile()));
-        return;
+        return tr("Invalid tile: %1").arg(invalidTile);
     case GidMapper::NoError:
         break;
     }
+
+    return QString();
 }
 
 void MapReaderPrivate::decodeCSVLayerData(TileLayer &tileLayer,
                                           QStringView text,
                                           QRect bounds)
 {
-    int currentIndex = 0;
-
-    for (int y = bounds.top(); y <= bounds.bottom(); y++) {
-        for (int x = bounds.left(); x <= bounds.right(); x++) {
-            // Check if the stream ended early.
-            if (currentIndex >= text.length()) {
-                xml.raiseError(tr("Corrupt layer data for layer '%1'")
-                               .arg(tileLayer.name()));
-                return;
-            }
+    const int cellCount = bounds.width() * bounds.height();
 
-            // Get the next entry.
-            unsigned int gid = 0;
-            while (currentIndex < text.length()) {
-                auto currentChar = text.at(currentIndex);
-                currentIndex++;
-                if (currentChar == QLatin1Char(','))
-                    break;
-                if (currentChar.isSpace())
-                    continue;
-                int value = currentChar.digitValue();
-                if (value != -1)
-                    gid = gid * 10 + value;
-                else {
-                    xml.raiseError(
-                            tr("Unable to parse tile at (%1,%2) on layer '%3': \"%4\"")
-                                   .arg(x + 1).arg(y + 1).arg(tileLayer.name()).arg(currentChar));
-                    return;
-                }
-            }
+    // The GIDs are parsed into a buffer that is reused for all layers and
+    // chunks, after which they are mapped to cells all at once
+    mCsvGids.resize(cellCount);
+    unsigned *gids = mCsvGids.data();
+
+    CsvTokenizer<QChar> tokenizer(text.begin(), text.end());
 
-            tileLayer.setCell(x, y, cellForGid(gid));
+    for (int index = 0; index < cellCount; ++index) {
+        // Check if the stream ended early.
+        if (tokenizer.atEnd()) {
+            xml.raiseError(tr("Corrupt layer data for layer '%1'")
+                           .arg(tileLayer.name()));
+            return;
+        }
+
+        // Get the next entry.
+        if (!tokenizer.readValue(gids[index])) {
+            const int x = bounds.x() + index % bounds.width();
+            const int y = bounds.y() + index / bounds.width();
+            xml.raiseError(
+                    tr("Unable to parse tile at (%1,%2) on layer '%3': \"%4\"")
+                           .arg(x + 1).arg(y + 1).arg(tileLayer.name()).arg(tokenizer.invalidChar()));
+            return;
         }
     }
-    if (currentIndex < text.length()) {
+    if (!tokenizer.atEnd()) {
         // We didn't consume all the data.
         xml.raiseError(tr("Corrupt layer data for layer '%1'")
                        .arg(tileLayer.name()));
         return;
     }
+
+    const auto error = mGidMapper.decodeGids(tileLayer, gids, cellCount, bounds);
+    if (error != GidMapper::NoError)
+        xml.raiseError(decodeErrorString(error, tileLayer, mGidMapper.invalidTile()));
 }
 
 Cell MapReaderPrivate::cellForGid(unsigned gid)
@@ -1188,20 +1371,56 @@ std::unique_ptr<MapObject> MapReaderPrivate::readObject()
 {
     Q_ASSERT(xml.isStartElement() && xml.name() == QLatin1String("object"));
 
+    int id = 0;
+    QString name;
+    unsigned gid = 0;
+    QString templateFileName;
+    qreal x = 0;
+    qreal y = 0;
+    qreal width = 0;
+    qreal height = 0;
+    qreal rotation = 0;
+    bool hasRotation = false;
+    int visible = 1;
+    bool hasVisible = false;
+    QString className;
+    QString type;
+
+    // Handle the attributes in a single pass rather than looking up each
+    // one by name, since maps may contain very many objects
     const QXmlStreamAttributes atts = xml.attributes();
-    const int id = atts.value(QLatin1String("id")).toInt();
-    const QString name = atts.value(QLatin1String("name")).toString();
-    const unsigned gid = atts.value(QLatin1String("gid")).toUInt();
-    const QString templateFileName = atts.value(QLatin1String("template")).toString();
-    const qreal x = atts.value(QLatin1String("x")).toDouble();
-    const qreal y = atts.value(QLatin1String("y")).toDouble();
-    const qreal width = atts.value(QLatin1String("width")).toDouble();
-    const qreal height = atts.value(QLatin1String("height")).toDouble();
-    const auto visibleRef = atts.value(QLatin1String("visible"));
+    for (const QXmlStreamAttribute &attribute : atts) {
+        const auto attributeName = attribute.qualifiedName();
+        const auto value = attribute.value();
+
+        if (attributeName == QLatin1String("id"))
+            id = value.toInt();
+        else if (attributeName == QLatin1String("name"))
+            name = value.toString();
+        else if (attributeName == QLatin1String("gid"))
+            gid = value.toUInt();
+        else if (attributeName == QLatin1String("template"))
+            templateFileName = value.toString();
+        else if (attributeName == QLatin1String("x"))
+            x = value.toDouble();
+        else if (attributeName == QLatin1String("y"))
+            y = value.toDouble();
+        else if (attributeName == QLatin1String("width"))
+            width = value.toDouble();
+        else if (attributeName == QLatin1String("height"))
+            height = value.toDouble();
+        else if (attributeName == QLatin1String("rotation"))
+            rotation = value.toDouble(&hasRotation);
+        else if (attributeName == QLatin1String("visible"))
+            visible = value.toInt(&hasVisible);
+        else if (attributeName == QLatin1String("class"))
+            className = value.toString();
+        else if (attributeName == QLatin1String("type"))
+            type = value.toString();
+    }
 
-    QString className = atts.value(QLatin1String("class")).toString();
     if (className.isEmpty())    // fallback for compatibility
-        className = atts.value(QLatin1String("type")).toString();
+        className = type;
 
     const QPointF pos(x, y);
     const QSizeF size(width, height);
@@ -1219,9 +1438,7 @@ std::unique_ptr<MapObject> MapReaderPrivate::readObject()
     object->setPropertyChanged(MapObject::NameProperty, !name.isEmpty());
     object->setPropertyChanged(MapObject::SizeProperty, !size.isEmpty());
 
-    bool ok;
-    const qreal rotation = atts.value(QLatin1String("rotation")).toDouble(&ok);
-    if (ok) {
+    if (hasRotation) {
         object->setRotation(rotation);
         object->setPropertyChanged(MapObject::RotationProperty);
     }
@@ -1231,8 +1448,7 @@ std::unique_ptr<MapObject> MapReaderPrivate::readObject()
         object->setPropertyChanged(MapObject::CellProperty);
     }
 
-    const int visible = visibleRef.toInt(&ok);
-    if (ok) {
+    if (hasVisible) {
         object->setVisible(visible);
         object->setPropertyChanged(MapObject::VisibleProperty);
     }
@@ -1280,24 +1496,35 @@ QPolygonF MapReaderPrivate::readPolygon()
                                       xml.name() == QLatin1String("polyline")));
 
     const QXmlStreamAttributes atts = xml.attributes();
-    const QString points = atts.value(QLatin1String("points")).toString();
-    const QStringList pointsList = points.split(QLatin1Char(' '),
-                                                Qt::SkipEmptyParts);
+    QStringView points = atts.value(QLatin1String("points"));
 
     QPolygonF polygon;
     bool ok = true;
 
-    for (const QString &point : pointsList) {
-        const int commaPos = point.indexOf(QLatin1Char(','));
+    // Split the points manually, to avoid allocating a string for each point
+    for (;;) {
+        while (!points.isEmpty() && points.front() == QLatin1Char(' '))
+            points = points.mid(1);
+        if (points.isEmpty())
+            break;
+
+        auto pointSize = points.indexOf(QLatin1Char(' '));
+        if (pointSize == -1)
+            pointSize = points.size();
+
+        const QStringView point = points.left(pointSize);
+        points = points.mid(pointSize);
+
+        const auto commaPos = point.indexOf(QLatin1Char(','));
         if (commaPos == -1) {
             ok = false;
             break;
         }
 
-        const qreal x = QStringView(point).left(commaPos).toDouble(&ok);
+        const qreal x = point.left(commaPos).toDouble(&ok);
         if (!ok)
             break;
-        const qreal y = QStringView(point).mid(commaPos + 1).toDouble(&ok);
+        const qreal y = point.mid(commaPos + 1).toDouble(&ok);
         if (!ok)
             break;
 
@@ -1432,7 +1659,7 @@ Properties MapReaderPrivate::readProperties()
             readUnknownElement();
     }
 
-    return properties;
+    return mPropertiesDeduplicator.deduplicate(properties);
 }
 
 void MapReaderPrivate::readProperty(Properties *properties, const ExportContext &context)
@@ -1440,7 +1667,7 @@ void MapReaderPrivate::readProperty(Properties *properties, const ExportContext
     Q_ASSERT(xml.isStartElement() && xml.name() == QLatin1String("property"));
 
     const QXmlStreamAttributes atts = xml.attributes();
-    QString propertyName = atts.value(QLatin1String("name")).toString();
+    const QString propertyName = mPropertiesDeduplicator.name(atts.value(QLatin1String("name")).toString());
 
     properties->insert(propertyName, readPropertyValue(context));
 }
@@ -1491,18 +1718,82 @@ MapReader::~MapReader()
     delete d;
 }
 
+void MapReader::setParallelLayerDecoding(bool enabled)
+{
+    d->mParallelLayerDecoding = enabled;
+}
+
+bool MapReader::parallelLayerDecoding() const
+{
+    return d->mParallelLayerDecoding;
+}
+
 std::unique_ptr<Map> MapReader::readMap(QIODevice *device, const QString &path)
 {
     return d->readMap(device, path);
 }
 
+/**
+ * Quickly scans the given TMX data for template references, without parsing
+ * it. May return false positives, for example from property values.
+ */
+static QSet<QByteArray> scanTemplateReferences(const QByteArray &data)
+{
+    static const QByteArray attribute = QByteArrayLiteral(" template=\"");
+
+    QSet<QByteArray> references;
+    int from = 0;
+
+    while ((from = data.indexOf(attribute, from)) != -1) {
+        from += attribute.size();
+
+        const int end = data.indexOf('"', from);
+        if (end == -1)
+            break;
+
+        const QByteArray reference = data.mid(from, end - from);
+        from = end + 1;
+
+        // References using entities are left to be loaded while parsing
+        if (!reference.isEmpty() && !reference.contains('&'))
+            references.insert(reference);
+    }
+
+    return references;
+}
+
+std::unique_ptr<Map> MapReader::readMap(const QByteArray &data, const QString &path)
+{
+    // Load the referenced templates up front, so that their files can be
+    // read in parallel rather than one at a time while parsing the objects.
+    const QSet<QByteArray> references = scanTemplateReferences(data);
+    if (references.size() > 1) {
+        const QDir mapDir(path);
+
+        QStringList templateFileNames;
+        for (const QByteArray &reference : references)
+            templateFileNames.append(resolveReference(QString::fromUtf8(reference), mapDir));
+
+        TemplateManager::instance()->loadObjectTemplates(templateFileNames);
+    }
+
+    QByteArray contents = data;
+    QBuffer buffer(&contents);
+    buffer.open(QBuffer::ReadOnly | QBuffer::Text);
+
+    return readMap(&buffer, path);
+}
+
 std::unique_ptr<Map> MapReader::readMap(const QString &fileName)
 {
     QFile file(fileName);
     if (!d->openFile(&file))
         return nullptr;
 
-    return readMap(&file, QFileInfo(fileName).absolutePath());
+    const QByteArray data = file.readAll();
+    file.close();
+
+    return readMap(data, QFileInfo(fileName).absolutePath());
 }
 
 SharedTileset MapReader::readTileset(QIODevice *device, const QString &path)
@@ -67,6 +67,14 @@ public:
      */
     std::unique_ptr<Map> readMap(QIODevice *device, const QString &path = QString());
 
+    /**
+     * Reads a TMX map from the given \a data, which was read from a file in
+     * \a path. Any templates referenced by the map are loaded in parallel
+     * before parsing.
+     * \overload
+     */
+    std::unique_ptr<Map> readMap(const QByteArray &data, const QString &path);
+
     /**
      * Reads a TMX map from the given \a fileName.
      * \overload
@@ -98,6 +106,15 @@ public:
     std::unique_ptr<ObjectTemplate> readObjectTemplate(QIODevice *device, const QString &path = QString());
     std::unique_ptr<ObjectTemplate> readObjectTemplate(const QString &fileName);
 
+    /**
+     * Sets whether the binary layer data is decoded in parallel. When
+     * enabled, the encoded layer data is collected while reading and the
+     * tile layers are decoded on the global thread pool before the map is
+     * returned. The resulting map is the same either way.
+     */
+    void setParallelLayerDecoding(bool enabled);
+    bool parallelLayerDecoding() const;
+
 protected:
     /**
      * Called for each \a reference to an external file. Should return the path
@@ -32,108 +32,323 @@
 #include "isometricrenderer.h"
 #include "map.h"
 #include "mapobject.h"
+#include "mipmapcache.h"
 #include "objectgroup.h"
 #include "orthogonalrenderer.h"
 #include "staggeredrenderer.h"
 #include "tile.h"
 #include "tilelayer.h"
+#include "tintedimagecache.h"
+#include "tracing.h"
 
 #include <QCache>
+#include <QMutex>
 #include <QPaintEngine>
 #include <QPainter>
 #include <QVector2D>
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <limits>
+#include <optional>
 
 using namespace Tiled;
 
-struct TintedKey
+/**
+ * Caches the geometry of map objects for a renderer.
+ *
+ * Entries are keyed on the object pointer and validated using the object's
+ * geometry revision as well as the other values the geometry depends on.
+ * Since revisions are unique, an entry is never mistaken for one of an
+ * object later allocated at the same address. Entries of deleted objects
+ * are evicted along with the least recently used ones, once the estimated
+ * memory use of the cache exceeds MaxCost.
+ *
+ * The cache is shared between threads using the same renderer.
+ */
+class MapRenderer::ObjectGeometryCache
 {
-    const qint64 pixmapKey;
-    const QRect rect;
-    const QColor color;
+public:
+    struct Key
+    {
+        quint64 revision = 0;
+        qreal lineWidth = 0.0;
+        Alignment alignment = Unspecified;
+        QSize mapTileSize;
+        int hexSideLength = 0;
+        int stagger = 0;
+        const Tile *tile = nullptr;
+        QSize tileSize;
+        QPoint tileOffset;
+
+        bool operator==(const Key &other) const
+        {
+            return revision == other.revision &&
+                    lineWidth == other.lineWidth &&
+                    alignment == other.alignment &&
+                    mapTileSize == other.mapTileSize &&
+                    hexSideLength == other.hexSideLength &&
+                    stagger == other.stagger &&
+                    tile == other.tile &&
+                    tileSize == other.tileSize &&
+                    tileOffset == other.tileOffset;
+        }
+    };
 
-    bool operator==(const TintedKey &o) const
+    struct Entry
     {
-        return pixmapKey == o.pixmapKey &&
-                rect == o.rect &&
-                color == o.color;
+        Key key;
+        std::optional<QRectF> boundingRect;
+        std::optional<QPainterPath> shape;
+        std::optional<QPainterPath> interactionShape;
+        QHash<int, QPolygonF> simplifiedPolygons;  // by simplification level
+    };
+
+    static Key keyFor(const MapRenderer &renderer, const MapObject *object)
+    {
+        const Map *map = renderer.map();
+
+        Key key;
+        key.revision = object->geometryRevision();
+        key.lineWidth = renderer.objectLineWidth();
+        key.alignment = object->alignment(map);
+        key.mapTileSize = map->tileSize();
+        key.hexSideLength = map->hexSideLength();
+        key.stagger = map->staggerAxis() << 1 | map->staggerIndex();
+
+        if (const Tile *tile = object->cell().tile()) {
+            key.tile = tile;
+            key.tileSize = tile->size();
+            key.tileOffset = tile->offset();
+        }
+
+        return key;
     }
+
+    ObjectGeometryCache()
+        : mEntries(MaxCost)
+    {}
+
+    template<typename T, typename Compute>
+    T get(const MapObject *object, const Key &key,
+          std::optional<T> Entry::*member, Compute compute)
+    {
+        {
+            QMutexLocker locker(&mMutex);
+            const Entry *entry = mEntries.object(object);
+            if (entry && entry->key == key && (entry->*member))
+                return *(entry->*member);
+        }
+
+        // Computed without holding the lock, since it may take a while
+        const T value = compute();
+
+        QMutexLocker locker(&mMutex);
+
+        auto entry = takeEntry(object, key);
+        entry.get()->*member = value;
+        insertEntry(object, std::move(entry));
+
+        return value;
+    }
+
+    template<typename Compute>
+    QPolygonF getSimplifiedPolygon(const MapObject *object, const Key &key,
+                                   int level, Compute compute)
+    {
+        {
+            QMutexLocker locker(&mMutex);
+            const Entry *entry = mEntries.object(object);
+            if (entry && entry->key == key) {
+                auto polygonIt = entry->simplifiedPolygons.constFind(level);
+                if (polygonIt != entry->simplifiedPolygons.constEnd())
+                    return *polygonIt;
+            }
+        }
+
+        const QPolygonF polygon = compute();
+
+        QMutexLocker locker(&mMutex);
+
+        auto entry = takeEntry(object, key);
+        entry->simplifiedPolygons.insert(level, polygon);
+        insertEntry(object, std::move(entry));
+
+        return polygon;
+    }
+
+private:
+    // The memory budget of the cache, in bytes
+    static constexpr int MaxCost = 32 * 1024 * 1024;
+
+    /**
+     * Removes the entry for \a object from the cache, so that it can be
+     * changed and inserted again with its new cost. Returns a new entry when
+     * there was none or when it was outdated.
+     */
+    std::unique_ptr<Entry> takeEntry(const MapObject *object, const Key &key)
+    {
+        std::unique_ptr<Entry> entry(mEntries.take(object));
+        if (!entry || !(entry->key == key))
+            entry = std::make_unique<Entry>(Entry { key, {}, {}, {}, {} });
+        return entry;
+    }
+
+    void insertEntry(const MapObject *object, std::unique_ptr<Entry> entry)
+    {
+        const int cost = costOf(*entry);
+        mEntries.insert(object, entry.release(), cost);
+    }
+
+    static int costOf(const Entry &entry)
+    {
+        qint64 cost = sizeof(const MapObject*) + sizeof(Entry);
+        if (entry.shape)
+            cost += entry.shape->elementCount() * sizeof(QPainterPath::Element);
+        if (entry.interactionShape)
+            cost += entry.interactionShape->elementCount() * sizeof(QPainterPath::Element);
+        for (const QPolygonF &polygon : entry.simplifiedPolygons)
+            cost += sizeof(int) + polygon.size() * sizeof(QPointF);
+        return static_cast<int>(std::min<qint64>(cost, MaxCost));
+    }
+
+    QMutex mMutex;
+    QCache<const MapObject*, Entry> mEntries;
 };
 
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-uint qHash(const TintedKey &key, uint seed) Q_DECL_NOTHROW
-{
-    auto h = ::qHash(key.pixmapKey, seed);
-    h = ::qHash(key.rect.topLeft(), h);
-    h = ::qHash(key.rect.bottomRight(), h);
-    h = ::qHash(key.color.rgba(), h);
-    return h;
-}
-#else
-size_t qHash(const TintedKey &key, size_t seed) Q_DECL_NOTHROW
+MapRenderer::MapRenderer(const Map *map)
+    : mMap(map)
+    , mObjectGeometryCache(std::make_unique<ObjectGeometryCache>())
+{}
+
+MapRenderer::~MapRenderer()
+{}
+
+/**
+ * Returns boundingRect() for the given \a object, computing it only when
+ * the object or the properties it depends on have changed.
+ */
+QRectF MapRenderer::cachedBoundingRect(const MapObject *object) const
 {
-    return qHashMulti(seed, key.pixmapKey, key.rect, key.color.rgba());
+    return mObjectGeometryCache->get(object, ObjectGeometryCache::keyFor(*this, object),
+                                     &ObjectGeometryCache::Entry::boundingRect,
+                                     [=] { return boundingRect(object); });
 }
-#endif
 
-// Borrowed from qpixmapcache.cpp
-static inline qsizetype cost(const QPixmap &pixmap)
+/**
+ * Returns shape() for the given \a object, computing it only when the
+ * object or the properties it depends on have changed.
+ */
+QPainterPath MapRenderer::cachedShape(const MapObject *object) const
 {
-    // make sure to do a 64bit calculation; qsizetype might be smaller
-    const qint64 costKb = static_cast<qint64>(pixmap.width())
-                        * pixmap.height() * pixmap.depth() / (8 * 1024);
-    const qint64 costMax = std::numeric_limits<qsizetype>::max();
-    // a small pixmap should have at least a cost of 1(kb)
-    return static_cast<qsizetype>(qBound(1LL, costKb, costMax));
+    return mObjectGeometryCache->get(object, ObjectGeometryCache::keyFor(*this, object),
+                                     &ObjectGeometryCache::Entry::shape,
+                                     [=] { return shape(object); });
 }
 
-static bool needsTint(const QColor &color)
+/**
+ * Returns interactionShape() for the given \a object, computing it only
+ * when the object or the properties it depends on have changed.
+ */
+QPainterPath MapRenderer::cachedInteractionShape(const MapObject *object) const
 {
-    return color.isValid() &&
-            color != QColor(255, 255, 255, 255);
+    return mObjectGeometryCache->get(object, ObjectGeometryCache::keyFor(*this, object),
+                                     &ObjectGeometryCache::Entry::interactionShape,
+                                     [=] { return interactionShape(object); });
 }
 
-static QPixmap tinted(const QPixmap &pixmap, const QRect &rect, const QColor &color)
+/**
+ * Simplifies the \a polygon using the Douglas-Peucker algorithm, leaving
+ * out points that are less than \a tolerance away from the simplified line.
+ * The first and last points are always kept.
+ */
+static QPolygonF simplifyPolygon(const QPolygonF &polygon, qreal tolerance)
 {
-    if (pixmap.isNull() || !needsTint(color))
-        return pixmap;
+    const int size = polygon.size();
+    if (size < 3)
+        return polygon;
+
+    const qreal toleranceSquared = tolerance * tolerance;
 
-    // Cache for up to 100 MB of tinted pixmaps, since tinting is expensive
-    static QCache<TintedKey, QPixmap> cache { 100 * 1024 };
+    QVector<bool> keep(size, false);
+    keep[0] = true;
+    keep[size - 1] = true;
 
-    const TintedKey tintedKey { pixmap.cacheKey(), rect, color };
-    if (auto cached = cache.object(tintedKey))
-        return *cached;
+    // Iterative, since polylines may have many thousands of points
+    QVector<QPair<int, int>> ranges;
+    ranges.append(qMakePair(0, size - 1));
 
-    QPixmap resultImage = pixmap.copy(rect);
-    QPainter painter(&resultImage);
+    while (!ranges.isEmpty()) {
+        const QPair<int, int> range = ranges.takeLast();
+        const int first = range.first;
+        const int last = range.second;
 
-    QColor fullOpacity = color;
-    fullOpacity.setAlpha(255);
-    // tint the final color (this will will mess up the alpha which we will fix
-    // in the next lines)
-    painter.setCompositionMode(QPainter::CompositionMode_Multiply);
-    painter.fillRect(resultImage.rect(), fullOpacity);
+        const QPointF start = polygon.at(first);
+        const QPointF delta = polygon.at(last) - start;
+        const qreal lengthSquared = QPointF::dotProduct(delta, delta);
 
-    // apply the original alpha to the final image
-    painter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
-    painter.drawPixmap(resultImage.rect(), pixmap, rect);
+        int farthest = -1;
+        qreal farthestDistance = toleranceSquared;
 
-    // apply the alpha of the tint color so that we can use it to make the image
-    // transparent instead of just increasing or decreasing the tint effect
-    painter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
-    painter.fillRect(resultImage.rect(), color);
+        for (int i = first + 1; i < last; ++i) {
+            const QPointF offset = polygon.at(i) - start;
+            qreal distance;
 
-    painter.end();
+            if (lengthSquared == 0) {
+                distance = QPointF::dotProduct(offset, offset);
+            } else {
+                const qreal cross = delta.x() * offset.y() - delta.y() * offset.x();
+                distance = cross * cross / lengthSquared;
+            }
+
+            if (distance > farthestDistance) {
+                farthest = i;
+                farthestDistance = distance;
+            }
+        }
+
+        if (farthest != -1) {
+            keep[farthest] = true;
+            if (farthest - first > 1)
+                ranges.append(qMakePair(first, farthest));
+            if (last - farthest > 1)
+                ranges.append(qMakePair(farthest, last));
+        }
+    }
 
-    cache.insert(tintedKey, new QPixmap(resultImage), cost(resultImage));
+    QPolygonF simplified;
+    for (int i = 0; i < size; ++i)
+        if (keep.at(i))
+            simplified.append(polygon.at(i));
 
-    return resultImage;
+    return simplified;
 }
 
-MapRenderer::~MapRenderer()
-{}
+/**
+ * Returns the polygon of the given polygon or polyline \a object, in pixels
+ * relative to the object position, simplified for drawing at the current
+ * painterScale(). The full polygon is returned when zoomed in far enough for
+ * the simplification to become visible, or when it has only few points.
+ *
+ * Simplified polygons are cached per object for each power-of-two tolerance.
+ */
+QPolygonF MapRenderer::simplifiedPolygon(const MapObject *object) const
+{
+    constexpr int MinimumPointsToSimplify = 64;
+
+    const QPolygonF &polygon = object->polygon();
+    if (polygon.size() < MinimumPointsToSimplify || mPainterScale <= 0)
+        return polygon;
+
+    // Leave out details smaller than half a screen pixel
+    const int level = static_cast<int>(std::floor(std::log2(0.5 / mPainterScale)));
+    if (level < 0)
+        return polygon;
+
+    return mObjectGeometryCache->getSimplifiedPolygon(object, ObjectGeometryCache::keyFor(*this, object), level,
+                                                      [&] { return simplifyPolygon(polygon, std::ldexp(1.0, level)); });
+}
 
 QRect MapRenderer::mapBoundingRect() const
 {
@@ -156,6 +371,34 @@ QRectF MapRenderer::boundingRect(const ImageLayer *imageLayer) const
     return bounds;
 }
 
+void MapRenderer::drawTileSelection(QPainter *painter,
+                                    const QRegion &region,
+                                    const QColor &color,
+                                    const QRectF &exposed) const
+{
+    drawTileSelection(painter, tileSelectionOutline(region, exposed), color);
+}
+
+void MapRenderer::drawTileSelection(QPainter *painter,
+                                    const QPainterPath &outline,
+                                    const QColor &color) const
+{
+    QColor penColor(color);
+    penColor.setAlpha(255);
+
+    QPen pen(penColor);
+    pen.setCosmetic(true);
+
+    // Orthogonal selections only have axis-aligned edges
+    const bool orthogonal = map()->orientation() == Map::Orthogonal ||
+            map()->orientation() == Map::Unknown;
+
+    painter->setPen(pen);
+    painter->setBrush(color);
+    painter->setRenderHint(QPainter::Antialiasing, !orthogonal);
+    painter->drawPath(outline);
+}
+
 QPainterPath MapRenderer::pointShape(const QPointF &position) const
 {
     QPainterPath path;
@@ -184,10 +427,26 @@ void MapRenderer::drawImageLayer(QPainter *painter,
                                  const ImageLayer *imageLayer,
                                  const QRectF &exposed) const
 {
+    const QPixmap pixmap = TintedImageCache::tinted(imageLayer->image(),
+                                                    imageLayer->renderState().tintColor);
+    QBrush brush(pixmap);
+
+    // When zoomed out, draw large images from a cached downscaled copy, to
+    // avoid scaling down the whole image on each paint. The brush takes care
+    // of repeating the image.
+    const QTransform &transform = painter->deviceTransform();
+    const qreal scale = std::sqrt(std::abs(transform.determinant()));
+
+    if (const int level = MipmapCache::levelFor(pixmap, scale)) {
+        const QPixmap mipmap = MipmapCache::mipmap(pixmap, level);
+
+        brush.setTexture(mipmap);
+        brush.setTransform(QTransform::fromScale(qreal(pixmap.width()) / mipmap.width(),
+                                                 qreal(pixmap.height()) / mipmap.height()));
+    }
+
     painter->save();
-    painter->setBrush(tinted(imageLayer->image(),
-                             imageLayer->image().rect(),
-                             imageLayer->effectiveTintColor()));
+    painter->setBrush(brush);
     painter->setPen(Qt::NoPen);
     if (exposed.isNull())
         painter->drawRect(boundingRect(imageLayer));
@@ -266,18 +525,42 @@ QPointF MapRenderer::snapToGrid(const QPointF &pixelCoords, int subdivisions) co
 
 void MapRenderer::drawTileLayer(QPainter *painter, const TileLayer *layer, const QRectF &exposed) const
 {
+    TILED_TRACE_SCOPE("MapRenderer::drawTileLayer");
+
     const QSize tileSize = map()->tileSize();
 
+    const QTransform &deviceTransform = painter->deviceTransform();
+    const qreal deviceScale = std::sqrt(std::abs(deviceTransform.determinant()));
+    if (deviceScale * std::max(tileSize.width(), tileSize.height()) <= ColorMapTileSize &&
+            drawTileLayerColors(painter, layer, exposed)) {
+        return;
+    }
+
     // Don't draw more than the bounding rectangle of the given layer,
     // intersected with the exposed rectangle.
     QRect rect = boundingRect(layer->bounds());
     if (!exposed.isNull())
         rect &= exposed.toAlignedRect();
 
+    QMargins drawMargins = layer->drawMargins();
+
+    // When the tiles stay within their cells, they don't overlap and can be
+    // drawn in any order.
+    const bool tilesOverlap = map()->orientation() != Map::Orthogonal ||
+            drawMargins.left() > 0 || drawMargins.bottom() > 0 ||
+            drawMargins.top() > tileSize.height() ||
+            drawMargins.right() > tileSize.width();
+
+    // When the tiles don't extend horizontally beyond their cells, the tiles
+    // rendered on the same row never overlap, since each renderer places
+    // them at least a tile width apart. Then only the order of the rows
+    // matters, which allows grouping the tiles by image within each row.
+    const bool batchRows = tilesOverlap &&
+            drawMargins.left() <= 0 && drawMargins.right() <= tileSize.width();
+
     // Draw margins extend the rendered area on the opposite side. We subtract
     // the grid size because this has already been taken into account by
     // boundingRect.
-    QMargins drawMargins = layer->drawMargins();
     drawMargins.setTop(qMax(0, drawMargins.top() - tileSize.height()));
     drawMargins.setRight(qMax(0, drawMargins.right() - tileSize.width()));
     rect.adjust(-drawMargins.right(),
@@ -285,11 +568,21 @@ void MapRenderer::drawTileLayer(QPainter *painter, const TileLayer *layer, const
                 drawMargins.left(),
                 drawMargins.top());
 
-    CellRenderer renderer(painter, this, layer->effectiveTintColor());
+    CellRenderer renderer(painter, this, layer->renderState().tintColor,
+                          tilesOverlap && !batchRows ? CellRenderer::KeepOrder
+                                                     : CellRenderer::SortByImage);
 
-    auto tileRenderFunction = [layer, &renderer, tileSize](QPoint tilePos, const QPointF &screenPos) {
+    qreal rowY = std::numeric_limits<qreal>::quiet_NaN();
+
+    auto tileRenderFunction = [&](QPoint tilePos, const QPointF &screenPos) {
         const Cell &cell = layer->cellAt(tilePos - layer->position());
         if (!cell.isEmpty()) {
+            // Draw the previous row before starting a new one
+            if (batchRows && screenPos.y() != rowY) {
+                renderer.flush();
+                rowY = screenPos.y();
+            }
+
             QSize size = tileSize;
 
             if (cell.tileset()->tileRenderSize() == Tileset::TileSize) {
@@ -301,7 +594,103 @@ void MapRenderer::drawTileLayer(QPainter *painter, const TileLayer *layer, const
         }
     };
 
-    drawTileLayer(tileRenderFunction, rect);
+    drawTileLayer(tileRenderFunction, rect, layer);
+}
+
+/**
+ * Draws the given \a layer with one pixel per tile, in the average color of
+ * each tile. This is used when zoomed out so far that the tile images would
+ * not be recognizable anyway. Tile offsets and draw margins are ignored.
+ *
+ * Returns false when the map orientation doesn't map tiles to the screen
+ * with an affine transform, in which case nothing was drawn.
+ */
+bool MapRenderer::drawTileLayerColors(QPainter *painter, const TileLayer *layer,
+                                      const QRectF &exposed) const
+{
+    const Map::Orientation orientation = map()->orientation();
+    if (orientation != Map::Orthogonal && orientation != Map::Isometric)
+        return false;
+
+    TILED_TRACE_SCOPE("MapRenderer::drawTileLayerColors");
+
+    const QPointF origin = tileToScreenCoords(0, 0);
+    const QPointF xAxis = tileToScreenCoords(1, 0) - origin;
+    const QPointF yAxis = tileToScreenCoords(0, 1) - origin;
+    const QTransform tileTransform(xAxis.x(), xAxis.y(),
+                                   yAxis.x(), yAxis.y(),
+                                   origin.x(), origin.y());
+
+    QRect area = layer->bounds();
+    if (!exposed.isNull())
+        area &= tileTransform.inverted().mapRect(exposed).toAlignedRect();
+    if (area.isEmpty())
+        return true;
+
+    const QRect localArea = area.translated(-layer->position());
+    const QColor &tintColor = layer->renderState().tintColor;
+    const bool tint = TintedImageCache::needsTint(tintColor);
+    const bool animate = testFlag(ShowTileAnimations);
+
+    QImage image(area.size(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    const Tile *lastTile = nullptr;
+    QRgb lastColor = 0;
+
+    for (int chunkY = localArea.top() >> CHUNK_BITS; chunkY <= localArea.bottom() >> CHUNK_BITS; ++chunkY) {
+        for (int chunkX = localArea.left() >> CHUNK_BITS; chunkX <= localArea.right() >> CHUNK_BITS; ++chunkX) {
+            const Chunk *chunk = layer->findChunk(chunkX << CHUNK_BITS, chunkY << CHUNK_BITS);
+            if (!chunk)
+                continue;
+
+            const QRect chunkRect = QRect(chunkX << CHUNK_BITS, chunkY << CHUNK_BITS,
+                                          CHUNK_SIZE, CHUNK_SIZE) & localArea;
+
+            for (int y = chunkRect.top(); y <= chunkRect.bottom(); ++y) {
+                auto line = reinterpret_cast<QRgb*>(image.scanLine(y - localArea.top()));
+
+                for (int x = chunkRect.left(); x <= chunkRect.right(); ++x) {
+                    const Tile *tile = chunk->cellAt(x & CHUNK_MASK, y & CHUNK_MASK).tile();
+                    if (tile && animate)
+                        tile = tile->currentFrameTile();
+                    if (!tile)
+                        continue;
+
+                    if (tile != lastTile) {
+                        QColor color = QColor::fromRgba(tile->averageColor());
+                        if (tint) {
+                            color.setRgbF(color.redF() * tintColor.redF(),
+                                          color.greenF() * tintColor.greenF(),
+                                          color.blueF() * tintColor.blueF(),
+                                          color.alphaF() * tintColor.alphaF());
+                        }
+
+                        lastTile = tile;
+                        lastColor = qPremultiply(color.rgba());
+                    }
+
+                    line[x - localArea.left()] = lastColor;
+                }
+            }
+        }
+    }
+
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+    painter->setTransform(tileTransform, true);
+    painter->drawImage(area.topLeft(), image);
+    painter->restore();
+
+    return true;
+}
+
+void MapRenderer::drawTileLayer(const RenderTileCallback &renderTile,
+                                const QRectF &exposed,
+                                const TileLayer *layer) const
+{
+    Q_UNUSED(layer)
+    drawTileLayer(renderTile, exposed);
 }
 
 void MapRenderer::setFlag(RenderFlag flag, bool enabled)
@@ -394,6 +783,10 @@ static void renderMissingImageMarker(QPainter &painter, const QRectF &rect)
     painter.restore();
 }
 
+// Counters reported by CellRenderer::statistics()
+static std::atomic<qint64> drawCallCount { 0 };
+static std::atomic<qint64> fragmentCount { 0 };
+
 static bool hasOpenGLEngine(const QPainter *painter)
 {
     if (auto paintEngine = painter->paintEngine()) {
@@ -404,13 +797,80 @@ static bool hasOpenGLEngine(const QPainter *painter)
     return false;
 }
 
-CellRenderer::CellRenderer(QPainter *painter, const MapRenderer *renderer, const QColor &tintColor)
+CellRenderer::CellRenderer(QPainter *painter, const MapRenderer *renderer,
+                           const QColor &tintColor, Batching batching)
     : mPainter(painter)
     , mRenderer(renderer)
     , mTile(nullptr)
     , mIsOpenGL(hasOpenGLEngine(painter))
     , mTintColor(tintColor)
+    // With OpenGL, tiles sharing a tileset image are drawn from the same
+    // texture, so they can be drawn in a single batch. This is not possible
+    // when drawing collision shapes, since those are drawn per batch based on
+    // the current tile.
+    , mBatchByImage(mIsOpenGL &&
+                    !renderer->flags().testFlag(ShowTileCollisionShapes))
+    // Collision shapes are drawn on top of each batch, so they would get
+    // mixed up with the tiles of other batches when reordering.
+    , mSortByImage(batching == SortByImage &&
+                   !renderer->flags().testFlag(ShowTileCollisionShapes))
+    // Collision shapes are positioned based on the fragments, which refer to
+    // the full size tile when not using mipmaps.
+    , mUseMipmaps(!renderer->flags().testFlag(ShowTileCollisionShapes))
+{
+}
+
+/**
+ * Returns whether \a tile, drawn from \a image, can be added to the current
+ * batch of fragments.
+ */
+bool CellRenderer::isCurrentBatch(const Tile *tile, const QPixmap &image) const
+{
+    if (!mTile || mImage.cacheKey() != image.cacheKey())
+        return false;
+
+    return mTile == tile || mBatchByImage;
+}
+
+/**
+ * Returns the key of the batch \a tile belongs to, when sorting by image.
+ */
+qint64 CellRenderer::batchKey(const Tile *tile, const QPixmap &image) const
 {
+    if (mBatchByImage)
+        return image.cacheKey();
+    return static_cast<qint64>(reinterpret_cast<quintptr>(tile));
+}
+
+/**
+ * Puts the current batch aside and continues the batch of \a tile, if any.
+ * Only used when sorting by image, where the fragments of all batches are
+ * drawn when flushing.
+ */
+void CellRenderer::switchBatch(const Tile *tile, const QPixmap &image)
+{
+    if (mTile) {
+        Batch &batch = mPendingBatches[batchKey(mTile, mImage)];
+        batch.tile = mTile;
+        batch.image = mImage;
+        batch.fragments.swap(mFragments);
+    }
+
+    mTile = nullptr;
+    mImage = QPixmap();
+    mFragments.clear();
+
+    const auto it = mPendingBatches.find(batchKey(tile, image));
+    if (it != mPendingBatches.end()) {
+        mTile = it->tile;
+        mImage = it->image;
+        mFragments.swap(it->fragments);
+        mPendingBatches.erase(it);
+
+        // The same tile may have been drawn at a different mipmap level
+        if (mImage.cacheKey() != image.cacheKey())
+            flushBatch();
+    }
 }
 
 /**
@@ -418,7 +878,10 @@ CellRenderer::CellRenderer(QPainter *painter, const MapRenderer *renderer, const
  * the flipping and tile offset.
  *
  * For performance reasons, the actual drawing is delayed until a different
- * kind of tile has to be drawn. For this reason it is necessary to call
+ * kind of tile has to be drawn. With OpenGL, tiles are batched by their
+ * tileset image rather than by tile. When sorting by image, fragments are
+ * kept per batch until the end, so that each image is drawn only once.
+ * For this reason it is necessary to call
  * flush when finished doing drawCell calls. This function is also called by
  * the destructor so usually an explicit call is not needed.
  *
@@ -441,19 +904,10 @@ void CellRenderer::render(const Cell &cell, const QPointF &screenPos, const QSiz
         return;
     }
 
-    // The USHRT_MAX limit is rather arbitrary but avoids a crash in
-    // drawPixmapFragments for a large number of fragments.
-    if (mTile != tile || mFragments.size() == USHRT_MAX)
-        flush();
-
-    const QPixmap &image = tile->image();
-    QRect imageRect = tile->imageRect();
+    const QRect &imageRect = tile->imageRect();
     if (imageRect.isEmpty())
         return;
 
-    if (needsTint(mTintColor))
-        imageRect.moveTopLeft(QPoint(0, 0));
-
     const QPoint offset = tile->offset();
     const QPointF sizeHalf { size.width() / 2, size.height() / 2 };
 
@@ -483,6 +937,41 @@ void CellRenderer::render(const Cell &cell, const QPointF &screenPos, const QSiz
     fragment.x += offset.x() * fragment.scaleX;
     fragment.y += offset.y() * fragment.scaleY;
 
+    // When drawn at a small scale, draw the tile from a downscaled copy of
+    // its tileset image, which is both faster and avoids aliasing.
+    QPixmap image = tile->image();
+    if (mUseMipmaps) {
+        const QTransform &transform = mPainter->deviceTransform();
+        const qreal painterScale = std::sqrt(std::abs(transform.determinant()));
+        const qreal scale = painterScale * std::min(fragment.scaleX, fragment.scaleY);
+        const Tileset *tileset = tile->tileset();
+
+        if (const int level = MipmapCache::levelFor(tileset, scale)) {
+            const QRect sourceRect = MipmapCache::sourceRect(tileset, imageRect, level);
+            const int factor = 1 << level;
+
+            image = MipmapCache::mipmap(tileset, level);
+            fragment.sourceLeft = sourceRect.x();
+            fragment.sourceTop = sourceRect.y();
+            fragment.width = sourceRect.width();
+            fragment.height = sourceRect.height();
+            fragment.scaleX *= factor;
+            fragment.scaleY *= factor;
+        }
+    }
+
+    if (!isCurrentBatch(tile, image)) {
+        if (mSortByImage)
+            switchBatch(tile, image);
+        else
+            flush();
+    }
+
+    // The USHRT_MAX limit is rather arbitrary but avoids a crash in
+    // drawPixmapFragments for a large number of fragments.
+    if (mFragments.size() == USHRT_MAX)
+        flushBatch();
+
     // Correct the position if the origin is BottomLeft.
     if (origin == BottomLeft)
         fragment.y -= size.height();
@@ -518,6 +1007,7 @@ void CellRenderer::render(const Cell &cell, const QPointF &screenPos, const QSiz
     if (!mIsOpenGL && fragment.scaleX > 0 && fragment.scaleY > 0) {
 #endif
         mTile = tile;
+        mImage = image;
         mFragments.append(fragment);
         return;
     }
@@ -525,7 +1015,8 @@ void CellRenderer::render(const Cell &cell, const QPointF &screenPos, const QSiz
     // The Raster paint engine as of Qt 4.8.4 / 5.0.2 does not support
     // drawing fragments with a negative scaling factor.
 
-    flush(); // make sure we drew all tiles so far
+    if (!mSortByImage)
+        flush(); // make sure we drew all tiles so far
 
     const QTransform oldTransform = mPainter->transform();
     QTransform transform = oldTransform;
@@ -539,45 +1030,64 @@ void CellRenderer::render(const Cell &cell, const QPointF &screenPos, const QSiz
                         fragment.width, fragment.height);
 
     mPainter->setTransform(transform);
-    mPainter->drawPixmap(target, tinted(image, tile->imageRect(), mTintColor), source);
+    mPainter->drawPixmap(target, TintedImageCache::tinted(image, mTintColor), source);
     mPainter->setTransform(oldTransform);
 
-    // A bit of a hack to still draw tile collision shapes when requested
-    if (mRenderer->flags().testFlag(ShowTileCollisionShapes)
-            && tile->objectGroup()
-            && !tile->objectGroup()->objects().isEmpty()) {
-        mTile = tile;
-        mFragments.append(fragment);
-        paintTileCollisionShapes();
-        mTile = nullptr;
-        mFragments.clear();
-    }
+    drawCallCount.fetch_add(1, std::memory_order_relaxed);
+    fragmentCount.fetch_add(1, std::memory_order_relaxed);
+
+    addTileCollisionShapes(tile, { fragment });
 }
 
 /**
  * Renders any remaining cells.
  */
 void CellRenderer::flush()
+{
+    flushBatch();
+
+    for (auto it = mPendingBatches.begin(); it != mPendingBatches.end(); ++it) {
+        mTile = it->tile;
+        mFragments.swap(it->fragments);
+        flushBatch();
+    }
+    mPendingBatches.clear();
+
+    paintTileCollisionShapes();
+}
+
+/**
+ * Draws the fragments of the current batch.
+ */
+void CellRenderer::flushBatch()
 {
     if (!mTile)
         return;
 
+    TILED_TRACE_SCOPE("CellRenderer::flush");
+
     mPainter->drawPixmapFragments(mFragments.constData(),
                                   mFragments.size(),
-                                  tinted(mTile->image(),
-                                         mTile->imageRect(),
-                                         mTintColor));
-
-    if (mRenderer->flags().testFlag(ShowTileCollisionShapes)
-            && mTile->objectGroup()
-            && !mTile->objectGroup()->objects().isEmpty()) {
-        paintTileCollisionShapes();
-    }
+                                  TintedImageCache::tinted(mImage, mTintColor));
+
+    drawCallCount.fetch_add(1, std::memory_order_relaxed);
+    fragmentCount.fetch_add(mFragments.size(), std::memory_order_relaxed);
+
+    addTileCollisionShapes(mTile, mFragments);
 
     mTile = nullptr;
+    mImage = QPixmap();
     mFragments.clear();
 }
 
+CellRenderer::Statistics CellRenderer::statistics()
+{
+    Statistics statistics;
+    statistics.drawCalls = drawCallCount.load(std::memory_order_relaxed);
+    statistics.fragments = fragmentCount.load(std::memory_order_relaxed);
+    return statistics;
+}
+
 /**
  * Returns a transform that rotates by \a rotation degrees around the given
  * \a position.
@@ -591,12 +1101,36 @@ static QTransform rotateAt(const QPointF &position, qreal rotation)
     return transform;
 }
 
-void CellRenderer::paintTileCollisionShapes()
+/**
+ * Remembers the placements of \a tile, when its collision shapes should be
+ * shown. The shapes are drawn on top of the tiles when flushing.
+ */
+void CellRenderer::addTileCollisionShapes(const Tile *tile,
+                                          const QVector<QPainter::PixmapFragment> &fragments)
+{
+    if (!mRenderer->flags().testFlag(ShowTileCollisionShapes))
+        return;
+    if (!tile->objectGroup() || tile->objectGroup()->objects().isEmpty())
+        return;
+
+    mCollisionFragments[tile].append(fragments);
+}
+
+/**
+ * Returns the collision shapes of \a tile in tile coordinates, with the
+ * rotation of the objects applied. The shapes are created once per cell
+ * renderer, so that they are not recreated for each placement of the tile.
+ */
+const QVector<CellRenderer::CollisionShape> &CellRenderer::tileCollisionShapes(const Tile *tile)
 {
-    const Tileset *tileset = mTile->tileset();
-    const bool isIsometric = tileset->orientation() == Tileset::Isometric;
+    auto it = mCollisionShapes.find(tile);
+    if (it != mCollisionShapes.end())
+        return it.value();
+
+    const Tileset *tileset = tile->tileset();
     Map::Parameters mapParameters;
-    mapParameters.orientation = isIsometric ? Map::Isometric : Map::Orthogonal;
+    mapParameters.orientation = tileset->orientation() == Tileset::Isometric ? Map::Isometric
+                                                                             : Map::Orthogonal;
     mapParameters.width = 1;
     mapParameters.height = 1;
     mapParameters.tileWidth = tileset->gridSize().width();
@@ -604,6 +1138,32 @@ void CellRenderer::paintTileCollisionShapes()
     const Map map(mapParameters);
     const auto renderer = MapRenderer::create(&map);
 
+    QVector<CollisionShape> shapes;
+    for (MapObject *object : tile->objectGroup()->objects()) {
+        const auto transform = rotateAt(renderer->pixelToScreenCoords(object->position()),
+                                        object->rotation());
+
+        shapes.append(CollisionShape {
+                          transform.map(renderer->shape(object)),
+                          object->effectiveColor(),
+                          object->shape() == MapObject::Polyline
+                      });
+    }
+
+    return mCollisionShapes.insert(tile, shapes).value();
+}
+
+/**
+ * Draws the collision shapes of all tiles rendered since the last flush.
+ *
+ * The shapes are drawn tile by tile, with the painter transformed for each
+ * placement, so the paths don't need to be mapped for each placement.
+ */
+void CellRenderer::paintTileCollisionShapes()
+{
+    if (mCollisionFragments.isEmpty())
+        return;
+
     const qreal lineWidth = mRenderer->objectLineWidth();
     const qreal shadowDist = (lineWidth == 0 ? 1 : lineWidth) / mRenderer->painterScale();
     const QPointF shadowOffset = QPointF(shadowDist * 0.5, shadowDist * 0.5);
@@ -615,40 +1175,53 @@ void CellRenderer::paintTileCollisionShapes()
     shadowPen.setWidthF(lineWidth);
     shadowPen.setStyle(Qt::DotLine);
 
+    const QTransform oldTransform = mPainter->transform();
+    const bool antialiasing = mPainter->testRenderHint(QPainter::Antialiasing);
     mPainter->setRenderHint(QPainter::Antialiasing);
 
-    for (const auto &fragment : std::as_const(mFragments)) {
-        QTransform tileTransform;
-        tileTransform.translate(fragment.x, fragment.y);
-        tileTransform.rotate(fragment.rotation);
-        tileTransform.scale(fragment.scaleX, fragment.scaleY);
-        tileTransform.translate(-fragment.width * 0.5, -fragment.height * 0.5);
-
-        if (isIsometric)
-            tileTransform.translate(0, fragment.height - tileset->gridSize().height());
-
-        for (MapObject *object : mTile->objectGroup()->objects()) {
-            QColor penColor = object->effectiveColor();
-            QColor brushColor = penColor;
-            brushColor.setAlpha(50);
-            QPen colorPen(shadowPen);
-            colorPen.setColor(penColor);
-
-            mPainter->setPen(colorPen);
-            mPainter->setBrush(brushColor);
-
-            auto transform = rotateAt(renderer->pixelToScreenCoords(object->position()),
-                                      object->rotation());
-            transform *= tileTransform;
-
-            const auto shape = transform.map(renderer->shape(object));
-
-            mPainter->strokePath(shape.translated(shadowOffset), shadowPen);
-
-            if (object->shape() == MapObject::Polyline)
-                mPainter->strokePath(shape, colorPen);
-            else
-                mPainter->drawPath(shape);
+    for (auto it = mCollisionFragments.cbegin(); it != mCollisionFragments.cend(); ++it) {
+        const Tile *tile = it.key();
+        const Tileset *tileset = tile->tileset();
+        const bool isIsometric = tileset->orientation() == Tileset::Isometric;
+        const QVector<CollisionShape> &shapes = tileCollisionShapes(tile);
+
+        for (const auto &fragment : it.value()) {
+            QTransform tileTransform;
+            tileTransform.translate(fragment.x, fragment.y);
+            tileTransform.rotate(fragment.rotation);
+            tileTransform.scale(fragment.scaleX, fragment.scaleY);
+            tileTransform.translate(-fragment.width * 0.5, -fragment.height * 0.5);
+
+            if (isIsometric)
+                tileTransform.translate(0, fragment.height - tileset->gridSize().height());
+
+            const QTransform transform = tileTransform * oldTransform;
+            const QTransform shadowTransform = tileTransform *
+                    QTransform::fromTranslate(shadowOffset.x(), shadowOffset.y()) *
+                    oldTransform;
+
+            for (const CollisionShape &shape : shapes) {
+                QColor brushColor = shape.color;
+                brushColor.setAlpha(50);
+                QPen colorPen(shadowPen);
+                colorPen.setColor(shape.color);
+
+                mPainter->setTransform(shadowTransform);
+                mPainter->strokePath(shape.shape, shadowPen);
+
+                mPainter->setTransform(transform);
+                if (shape.polyline) {
+                    mPainter->strokePath(shape.shape, colorPen);
+                } else {
+                    mPainter->setPen(colorPen);
+                    mPainter->setBrush(brushColor);
+                    mPainter->drawPath(shape.shape);
+                }
+            }
         }
     }
+
+    mPainter->setTransform(oldTransform);
+    mPainter->setRenderHint(QPainter::Antialiasing, antialiasing);
+    mCollisionFragments.clear();
 }
@@ -34,6 +34,7 @@
 #include <functional>
 #include <memory>
 
+#include <QHash>
 #include <QPainter>
 #include <QPainterPath>
 
@@ -68,10 +69,7 @@ public:
         HexagonalCells
     };
 
-    MapRenderer(const Map *map)
-        : mMap(map)
-    {}
-
+    MapRenderer(const Map *map);
     virtual ~MapRenderer();
 
     /**
@@ -131,6 +129,12 @@ public:
      */
     QPainterPath pointInteractionShape(const MapObject *object) const;
 
+    QRectF cachedBoundingRect(const MapObject *object) const;
+    QPainterPath cachedShape(const MapObject *object) const;
+    QPainterPath cachedInteractionShape(const MapObject *object) const;
+
+    QPolygonF simplifiedPolygon(const MapObject *object) const;
+
     /**
      * Draws the tile grid in the specified \a rect using the given
      * \a painter.
@@ -148,10 +152,15 @@ public:
      *
      * Optionally, you can pass in the \a exposed rect (of pixels), so that
      * only tiles that can be visible in this area will be drawn.
+     *
+     * When the tiles end up smaller than ColorMapTileSize device pixels, each
+     * tile is drawn as a single pixel of its average color instead.
      */
     void drawTileLayer(QPainter *painter, const TileLayer *layer,
                        const QRectF &exposed = QRectF()) const;
 
+    static constexpr qreal ColorMapTileSize = 2;
+
     /**
      * Calls the given \a renderTile callback for each tile in the given
      * \a exposed rectangle.
@@ -166,16 +175,46 @@ public:
     virtual void drawTileLayer(const RenderTileCallback &renderTile,
                                const QRectF &exposed) const = 0;
 
+    /**
+     * Like the above, but allows the implementation to skip the parts of the
+     * \a exposed rectangle where the given \a layer has no chunks. The
+     * callback may still be called for empty cells.
+     *
+     * The default implementation ignores the \a layer.
+     */
+    virtual void drawTileLayer(const RenderTileCallback &renderTile,
+                               const QRectF &exposed,
+                               const TileLayer *layer) const;
+
     /**
      * Draws the tile selection given by \a region in the specified \a color.
      *
-     * The implementation can be optimized by taking into account the
-     * \a exposed rectangle, to avoid drawing too much.
+     * Only the part of the selection intersecting the \a exposed rectangle
+     * is drawn.
+     */
+    void drawTileSelection(QPainter *painter,
+                           const QRegion &region,
+                           const QColor &color,
+                           const QRectF &exposed) const;
+
+    /**
+     * Draws a tile selection with the given \a outline, as returned by
+     * tileSelectionOutline(), in the specified \a color.
      */
-    virtual void drawTileSelection(QPainter *painter,
-                                   const QRegion &region,
-                                   const QColor &color,
-                                   const QRectF &exposed) const = 0;
+    void drawTileSelection(QPainter *painter,
+                           const QPainterPath &outline,
+                           const QColor &color) const;
+
+    /**
+     * Returns the simplified outline of the given \a region of tiles, in
+     * screen coordinates. Parts of the region outside of the \a exposed
+     * rectangle may be left out, unless the rectangle is null.
+     *
+     * Building this path is relatively expensive for large selections, so
+     * it may be worth caching it.
+     */
+    virtual QPainterPath tileSelectionOutline(const QRegion &region,
+                                              const QRectF &exposed = QRectF()) const = 0;
 
     /**
      * Draws the \a object in the given \a color using the \a painter.
@@ -285,7 +324,13 @@ protected:
     void setCellType(CellType cellType) { mCellType = cellType; }
 
 private:
+    class ObjectGeometryCache;
+
+    bool drawTileLayerColors(QPainter *painter, const TileLayer *layer,
+                             const QRectF &exposed) const;
+
     const Map *mMap;
+    const std::unique_ptr<ObjectGeometryCache> mObjectGeometryCache;
 
     RenderFlags mFlags = ShowTileAnimations;
     CellType mCellType = OrthogonalCells;
@@ -322,7 +367,7 @@ inline QPointF MapRenderer::pixelToScreenCoords(const QPointF &point) const
 /**
  * A utility class for rendering cells.
  */
-class CellRenderer
+class TILEDSHARED_EXPORT CellRenderer
 {
 public:
     enum Origin {
@@ -330,8 +375,14 @@ public:
         BottomLeft
     };
 
+    enum Batching {
+        KeepOrder,      // fragments are drawn in the order they are rendered
+        SortByImage     // fragments may be grouped by image, for non-overlapping cells
+    };
+
     explicit CellRenderer(QPainter *painter, const MapRenderer *renderer,
-                          const QColor &tintColor);
+                          const QColor &tintColor,
+                          Batching batching = KeepOrder);
 
     ~CellRenderer() { flush(); }
 
@@ -339,15 +390,53 @@ public:
                 Origin origin = TopLeft);
     void flush();
 
+    /**
+     * Counts the draw calls made by all cell renderers, as well as the number
+     * of tiles drawn by them. Meant for reporting rendering performance.
+     */
+    struct Statistics
+    {
+        qint64 drawCalls = 0;
+        qint64 fragments = 0;
+    };
+
+    static Statistics statistics();
+
 private:
+    struct Batch {
+        const Tile *tile = nullptr;
+        QPixmap image;
+        QVector<QPainter::PixmapFragment> fragments;
+    };
+
+    struct CollisionShape {
+        QPainterPath shape;     // in tile coordinates
+        QColor color;
+        bool polyline;
+    };
+
+    void addTileCollisionShapes(const Tile *tile,
+                                const QVector<QPainter::PixmapFragment> &fragments);
+    const QVector<CollisionShape> &tileCollisionShapes(const Tile *tile);
     void paintTileCollisionShapes();
+    bool isCurrentBatch(const Tile *tile, const QPixmap &image) const;
+    qint64 batchKey(const Tile *tile, const QPixmap &image) const;
+    void switchBatch(const Tile *tile, const QPixmap &image);
+    void flushBatch();
 
     QPainter * const mPainter;
     const MapRenderer * const mRenderer;
     const Tile *mTile;
+    QPixmap mImage;     // the image of the current batch, may be a mipmap
     QVector<QPainter::PixmapFragment> mFragments;
     const bool mIsOpenGL;
     const QColor mTintColor;
+    const bool mBatchByImage;
+    const bool mSortByImage;
+    const bool mUseMipmaps;
+    QHash<qint64, Batch> mPendingBatches;
+    QHash<const Tile*, QVector<CollisionShape>> mCollisionShapes;
+    QHash<const Tile*, QVector<QPainter::PixmapFragment>> mCollisionFragments;
 };
 
 } // namespace Tiled
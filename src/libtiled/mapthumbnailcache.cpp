@@ -0,0 +1,278 @@
+/*
+ * mapthumbnailcache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mapthumbnailcache.h"
+
+#include "minimaprenderer.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace Tiled {
+
+static const quint32 cacheFileMagic = 0x5454484D;    // "TTHM"
+static const quint32 cacheFileVersion = 1;
+
+static const MiniMapRenderer::RenderFlags thumbnailRenderFlags =
+        MiniMapRenderer::DrawTileLayers |
+        MiniMapRenderer::DrawMapObjects |
+        MiniMapRenderer::DrawImageLayers |
+        MiniMapRenderer::IgnoreInvisibleLayer |
+        MiniMapRenderer::DrawBackground |
+        MiniMapRenderer::SmoothPixmapTransform |
+        MiniMapRenderer::IncludeOverhangingTiles;
+
+static bool mapThumbnailCacheEnabled;
+static QString mapThumbnailCacheDirectory;
+
+/**
+ * Sets whether thumbnails are loaded from and stored in the disk cache.
+ * Disabled by default.
+ */
+void MapThumbnailCache::setEnabled(bool enabled)
+{
+    mapThumbnailCacheEnabled = enabled;
+}
+
+bool MapThumbnailCache::isEnabled()
+{
+    return mapThumbnailCacheEnabled;
+}
+
+/**
+ * Sets the directory in which thumbnails are stored. When not set, a
+ * "thumbnails" folder in the application's cache location is used.
+ */
+void MapThumbnailCache::setDirectory(const QString &directory)
+{
+    mapThumbnailCacheDirectory = directory;
+}
+
+QString MapThumbnailCache::directory()
+{
+    if (!mapThumbnailCacheDirectory.isEmpty())
+        return mapThumbnailCacheDirectory;
+
+    const QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (cacheLocation.isEmpty())
+        return QString();
+
+    return QDir(cacheLocation).filePath(QStringLiteral("thumbnails"));
+}
+
+/**
+ * Returns the smallest stored resolution that is at least \a requiredSize
+ * pixels, or the largest one when none is large enough.
+ */
+int MapThumbnailCache::sizeFor(int requiredSize)
+{
+    for (int size : sizes)
+        if (size >= requiredSize)
+            return size;
+    return largestSize;
+}
+
+/**
+ * Loads the thumbnail of the map with the given \a fileName, at the given
+ * \a size as returned by sizeFor().
+ *
+ * Returns a null thumbnail when the cache is disabled or no up-to-date
+ * thumbnail is stored.
+ */
+MapThumbnailCache::Thumbnail MapThumbnailCache::load(const QString &fileName, int size)
+{
+    if (!mapThumbnailCacheEnabled)
+        return {};
+
+    QFile file(cacheFileName(fileName, size));
+    if (file.fileName().isEmpty() || !file.open(QIODevice::ReadOnly))
+        return {};
+
+    QDataStream stream(&file);
+
+    quint32 magic, version;
+    Thumbnail thumbnail;
+
+    stream >> magic >> version;
+    if (magic != cacheFileMagic || version != cacheFileVersion)
+        return {};
+
+    stream >> thumbnail.bounds >> thumbnail.image;
+    if (stream.status() != QDataStream::Ok || thumbnail.bounds.isEmpty())
+        return {};
+
+    return thumbnail;
+}
+
+/**
+ * Returns the bounds of the stored thumbnail of the map with the given
+ * \a fileName, without loading its image. Returns a null rect when no
+ * up-to-date thumbnail is stored.
+ */
+QRect MapThumbnailCache::bounds(const QString &fileName)
+{
+    if (!mapThumbnailCacheEnabled)
+        return QRect();
+
+    QFile file(cacheFileName(fileName, largestSize));
+    if (file.fileName().isEmpty() || !file.open(QIODevice::ReadOnly))
+        return QRect();
+
+    QDataStream stream(&file);
+
+    quint32 magic, version;
+    QRect bounds;
+
+    stream >> magic >> version >> bounds;
+    if (stream.status() != QDataStream::Ok ||
+            magic != cacheFileMagic || version != cacheFileVersion) {
+        return QRect();
+    }
+
+    return bounds;
+}
+
+/**
+ * Returns whether an up-to-date thumbnail is stored for the map with the
+ * given \a fileName.
+ */
+bool MapThumbnailCache::contains(const QString &fileName)
+{
+    if (!mapThumbnailCacheEnabled)
+        return false;
+
+    const QString cachedFileName = cacheFileName(fileName, largestSize);
+    return !cachedFileName.isEmpty() && QFile::exists(cachedFileName);
+}
+
+/**
+ * Renders a thumbnail of the given \a map, which fits within a square of
+ * \a size pixels.
+ */
+MapThumbnailCache::Thumbnail MapThumbnailCache::render(const Map *map, int size)
+{
+    MiniMapRenderer renderer(map);
+
+    Thumbnail thumbnail;
+    thumbnail.bounds = renderer.mapBoundingRect(thumbnailRenderFlags);
+    if (thumbnail.bounds.isEmpty())
+        return {};
+
+    const QSize imageSize = thumbnail.bounds.size().scaled(size, size, Qt::KeepAspectRatio)
+            .expandedTo(QSize(1, 1));
+
+    thumbnail.image = renderer.render(imageSize, thumbnailRenderFlags);
+    return thumbnail;
+}
+
+/**
+ * Returns a copy of the given \a thumbnail, scaled down to fit within a
+ * square of \a size pixels when it is larger.
+ */
+MapThumbnailCache::Thumbnail MapThumbnailCache::scaled(const Thumbnail &thumbnail, int size)
+{
+    const QSize imageSize = thumbnail.image.size();
+    if (imageSize.width() <= size && imageSize.height() <= size)
+        return thumbnail;
+
+    return { thumbnail.image.scaled(imageSize.scaled(size, size, Qt::KeepAspectRatio)
+                                    .expandedTo(QSize(1, 1)),
+                                    Qt::IgnoreAspectRatio, Qt::SmoothTransformation),
+             thumbnail.bounds };
+}
+
+/**
+ * Stores the given \a thumbnail of the map with the given \a fileName, which
+ * is scaled down to each of the stored resolutions.
+ *
+ * Since scaling and writing the images takes a while, this function is
+ * usually called from a worker thread.
+ */
+void MapThumbnailCache::store(const QString &fileName, const Thumbnail &thumbnail)
+{
+    if (!mapThumbnailCacheEnabled || thumbnail.isNull())
+        return;
+
+    for (int size : sizes) {
+        const QString cachedFileName = cacheFileName(fileName, size);
+        if (cachedFileName.isEmpty())
+            return;
+        if (!QDir().mkpath(QFileInfo(cachedFileName).absolutePath()))
+            return;
+
+        // QSaveFile makes sure other threads or instances never read a
+        // partially written file
+        QSaveFile file(cachedFileName);
+        if (!file.open(QIODevice::WriteOnly))
+            return;
+
+        QDataStream stream(&file);
+        stream << cacheFileMagic << cacheFileVersion
+               << thumbnail.bounds << scaled(thumbnail, size).image;
+
+        if (stream.status() == QDataStream::Ok)
+            file.commit();
+    }
+}
+
+/**
+ * Renders and stores a thumbnail of the given \a map, which was saved to or
+ * loaded from the file with the given \a fileName.
+ */
+void MapThumbnailCache::store(const QString &fileName, const Map *map)
+{
+    if (mapThumbnailCacheEnabled)
+        store(fileName, render(map));
+}
+
+QString MapThumbnailCache::cacheFileName(const QString &fileName, int size)
+{
+    const QFileInfo info(fileName);
+    if (!info.isFile())
+        return QString();
+
+    const QString cacheDirectory = directory();
+    if (cacheDirectory.isEmpty())
+        return QString();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(info.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    hash.addData(QByteArray::number(info.size()));
+
+    const QString baseName = QString::fromLatin1(hash.result().toHex());
+    return QDir(cacheDirectory).filePath(QStringLiteral("%1-%2.tthm").arg(baseName).arg(size));
+}
+
+} // namespace Tiled
@@ -0,0 +1,91 @@
+/*
+ * mapthumbnailcache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+
+#include "tiled_global.h"
+
+#include <QImage>
+#include <QRect>
+#include <QString>
+
+namespace Tiled {
+
+class Map;
+
+/**
+ * Keeps small images of maps in the user's cache directory, so that they can
+ * be shown without loading the map, for example when looking at a large
+ * world from far away.
+ *
+ * Each thumbnail is stored at a few resolutions. Entries are keyed by the
+ * path, modification time and size of the map file, so thumbnails of changed
+ * maps are never returned.
+ *
+ * The lookup and store functions are thread-safe, but the cache should be
+ * configured before it is used.
+ */
+class TILEDSHARED_EXPORT MapThumbnailCache
+{
+public:
+    struct Thumbnail
+    {
+        QImage image;
+        QRect bounds;   // in pixels, relative to the map origin
+
+        bool isNull() const { return image.isNull(); }
+    };
+
+    // The resolutions at which thumbnails are stored, from small to large
+    static constexpr int sizes[] = { 64, 256, 1024 };
+    static constexpr int largestSize = 1024;
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    static void setDirectory(const QString &directory);
+    static QString directory();
+
+    static int sizeFor(int requiredSize);
+
+    static Thumbnail load(const QString &fileName, int size);
+    static QRect bounds(const QString &fileName);
+    static bool contains(const QString &fileName);
+
+    static Thumbnail render(const Map *map, int size = largestSize);
+    static Thumbnail scaled(const Thumbnail &thumbnail, int size);
+
+    static void store(const QString &fileName, const Thumbnail &thumbnail);
+    static void store(const QString &fileName, const Map *map);
+
+private:
+    static QString cacheFileName(const QString &fileName, int size);
+};
+
+} // namespace Tiled
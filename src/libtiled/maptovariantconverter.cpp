@@ -32,6 +32,7 @@
 #include "tile.h"
 #include "tilelayer.h"
 #include "tileset.h"
+#include "tilesetexportcache.h"
 #include "wangset.h"
 
 #include <QCoreApplication>
@@ -67,10 +68,10 @@ QVariant MapToVariantConverter::toVariant(const Map &map, const QDir &mapDir)
     mapVariant[QStringLiteral("nextobjectid")] = map.nextObjectId();
     mapVariant[QStringLiteral("compressionlevel")] = map.compressionLevel();
 
-    if (map.chunkSize() != QSize(CHUNK_SIZE, CHUNK_SIZE) || !map.exportFileName.isEmpty() || !map.exportFormat.isEmpty()) {
+    if (map.chunkSize() != QSize(OUTPUT_CHUNK_SIZE, OUTPUT_CHUNK_SIZE) || !map.exportFileName.isEmpty() || !map.exportFormat.isEmpty()) {
         QVariantMap editorSettingsVariant;
 
-        if (map.chunkSize() != QSize(CHUNK_SIZE, CHUNK_SIZE)) {
+        if (map.chunkSize() != QSize(OUTPUT_CHUNK_SIZE, OUTPUT_CHUNK_SIZE)) {
             QVariantMap chunkSizeVariant;
             chunkSizeVariant[QStringLiteral("width")] = map.chunkSize().width();
             chunkSizeVariant[QStringLiteral("height")] = map.chunkSize().height();
@@ -119,8 +120,20 @@ QVariant MapToVariantConverter::toVariant(const Map &map, const QDir &mapDir)
     }
     mapVariant[QStringLiteral("tilesets")] = tilesetVariants;
 
+    const Map::LayerDataFormat layerDataFormat = mLayerDataFormat.value_or(map.layerDataFormat());
+
+    mGidMapper.setCompressionDictionary(CompressionDictionary());
+    if (layerDataFormat == Map::Base64ZstandardDictionary) {
+        const CompressionDictionary dictionary =
+                mGidMapper.trainCompressionDictionary(map, map.compressionLevel());
+        if (!dictionary.isNull()) {
+            mapVariant[QStringLiteral("layerdictionary")] = dictionary.data().toBase64();
+            mGidMapper.setCompressionDictionary(dictionary);
+        }
+    }
+
     mapVariant[QStringLiteral("layers")] = toVariant(map.layers(),
-                                                    map.layerDataFormat(),
+                                                    layerDataFormat,
                                                     map.compressionLevel(),
                                                     map.chunkSize());
 
@@ -182,6 +195,22 @@ QVariant MapToVariantConverter::toVariant(const Tileset &tileset,
         tilesetVariant[QStringLiteral("tiledversion")] = QCoreApplication::applicationVersion();
     }
 
+    // During a batch export, reuse the variant built for other maps
+    TilesetExportCache *cache = TilesetExportCache::instance();
+    if (firstGid == 0 || (cache && !cache->canCacheSerialized(tileset)))
+        cache = nullptr;
+
+    QString cacheContext;
+    if (cache) {
+        cacheContext = QStringLiteral("json%1:%2").arg(mVersion).arg(mDir.absolutePath());
+
+        QVariantMap cached = cache->serialized(&tileset, cacheContext).toMap();
+        if (!cached.isEmpty()) {
+            cached[QStringLiteral("firstgid")] = firstGid;
+            return cached;
+        }
+    }
+
     tilesetVariant[QStringLiteral("name")] = tileset.name();
     if (!tileset.className().isEmpty())
         tilesetVariant[QStringLiteral("class")] = tileset.className();
@@ -354,6 +383,9 @@ QVariant MapToVariantConverter::toVariant(const Tileset &tileset,
         tilesetVariant[QStringLiteral("wangsets")] = wangSetVariants;
     }
 
+    if (cache)
+        cache->insertSerialized(&tileset, cacheContext, tilesetVariant);
+
     return tilesetVariant;
 }
 
@@ -496,6 +528,11 @@ QVariant MapToVariantConverter::toVariant(const TileLayer &tileLayer,
         tileLayerVariant[QStringLiteral("encoding")] = QLatin1String("base64");
         tileLayerVariant[QStringLiteral("compression")] = compressionToString(format);
         break;
+    case Map::Base64ZstandardDictionary:
+        tileLayerVariant[QStringLiteral("encoding")] = QLatin1String("base64");
+        tileLayerVariant[QStringLiteral("compression")] = compressionToString(format);
+        tileLayerVariant[QStringLiteral("filter")] = QLatin1String("delta");
+        break;
     }
 
     if (tileLayer.map()->infinite()) {
@@ -742,6 +779,17 @@ void MapToVariantConverter::addTileLayerData(QVariantMap &variant,
     switch (format) {
     case Map::XML:
     case Map::CSV: {
+        if (mCompactLayerData) {
+            QVector<unsigned> gids;
+            gids.reserve(bounds.width() * bounds.height());
+            for (int y = bounds.top(); y <= bounds.bottom(); ++y)
+                for (int x = bounds.left(); x <= bounds.right(); ++x)
+                    gids.append(mGidMapper.cellToGid(tileLayer.cellAt(x, y)));
+
+            variant[QStringLiteral("data")] = QVariant::fromValue(gids);
+            break;
+        }
+
         QVariantList tileVariants;
         for (int y = bounds.top(); y <= bounds.bottom(); ++y)
             for (int x = bounds.left(); x <= bounds.right(); ++x)
@@ -753,7 +801,8 @@ void MapToVariantConverter::addTileLayerData(QVariantMap &variant,
     case Map::Base64:
     case Map::Base64Zlib:
     case Map::Base64Gzip:
-    case Map::Base64Zstandard:{
+    case Map::Base64Zstandard:
+    case Map::Base64ZstandardDictionary: {
         QByteArray layerData = mGidMapper.encodeLayerData(tileLayer, format, bounds, compressionLevel);
         variant[QStringLiteral("data")] = layerData;
         break;
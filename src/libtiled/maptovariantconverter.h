@@ -24,6 +24,8 @@
 #include <QDir>
 #include <QVariant>
 
+#include <optional>
+
 #include "gidmapper.h"
 
 namespace Tiled {
@@ -49,6 +51,21 @@ public:
         : mVersion(version)
     {}
 
+    /**
+     * Sets the format in which tile layer data is stored, overriding the
+     * layer data format of the map.
+     */
+    void setLayerDataFormat(Map::LayerDataFormat format)
+    { mLayerDataFormat = format; }
+
+    /**
+     * When enabled, CSV layer data is stored as a single QVector<unsigned>
+     * of global tile IDs rather than a QVariantList with a QVariant for each
+     * tile. Only supported by writers that know about this type.
+     */
+    void setCompactLayerData(bool enabled)
+    { mCompactLayerData = enabled; }
+
     /**
      * Converts the given \a map to a QVariant. The \a mapDir is used to
      * construct relative paths to external resources.
@@ -90,6 +107,8 @@ private:
     void exportValuesToVariantMap(QVariant &value) const;
 
     int mVersion;
+    std::optional<Map::LayerDataFormat> mLayerDataFormat;
+    bool mCompactLayerData = false;
     QDir mDir;
     GidMapper mGidMapper;
 };
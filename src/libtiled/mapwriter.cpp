@@ -42,13 +42,16 @@
 #include "tiled.h"
 #include "tilelayer.h"
 #include "tileset.h"
+#include "tilesetexportcache.h"
+#include "tracing.h"
 #include "wangset.h"
+#include "xmlwriter.h"
 #include "fileformat.h"
 
 #include <QBuffer>
 #include <QCoreApplication>
 #include <QDir>
-#include <QXmlStreamWriter>
+#include <QtConcurrent>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
@@ -77,25 +80,28 @@ public:
     int mCompressionlevel { -1 };
     bool mDtdEnabled { false };
     bool mMinimize { false };
-    QSize mChunkSize { CHUNK_SIZE, CHUNK_SIZE };
+    bool mParallelEncoding { false };
+    QSize mChunkSize { OUTPUT_CHUNK_SIZE, OUTPUT_CHUNK_SIZE };
 
 private:
-    void writeMap(QXmlStreamWriter &w, const Map &map);
-    void writeTileset(QXmlStreamWriter &w, const Tileset &tileset,
+    void writeMap(XmlWriter &w, const Map &map);
+    void writeTileset(XmlWriter &w, const Tileset &tileset,
                       unsigned firstGid);
-    void writeLayers(QXmlStreamWriter &w, const QList<Layer *> &layers);
-    void writeTileLayer(QXmlStreamWriter &w, const TileLayer &tileLayer);
-    void writeTileLayerData(QXmlStreamWriter &w, const TileLayer &tileLayer, QRect bounds);
-    void writeLayerAttributes(QXmlStreamWriter &w, const Layer &layer);
-    void writeObjectGroup(QXmlStreamWriter &w, const ObjectGroup &objectGroup);
-    void writeObject(QXmlStreamWriter &w, const MapObject &mapObject);
-    void writeObjectText(QXmlStreamWriter &w, const TextData &textData);
-    void writeImageLayer(QXmlStreamWriter &w, const ImageLayer &imageLayer);
-    void writeGroupLayer(QXmlStreamWriter &w, const GroupLayer &groupLayer);
-    void writeProperties(QXmlStreamWriter &w,
+    void writeLayers(XmlWriter &w, const QList<Layer *> &layers);
+    void writeTileLayer(XmlWriter &w, const TileLayer &tileLayer);
+    void writeTileLayerData(XmlWriter &w, const TileLayer &tileLayer, QRect bounds);
+    void writeLayerDictionary(XmlWriter &w, const Map &map);
+    void encodeLayerDataInParallel(const Map &map);
+    void writeLayerAttributes(XmlWriter &w, const Layer &layer);
+    void writeObjectGroup(XmlWriter &w, const ObjectGroup &objectGroup);
+    void writeObject(XmlWriter &w, const MapObject &mapObject);
+    void writeObjectText(XmlWriter &w, const TextData &textData);
+    void writeImageLayer(XmlWriter &w, const ImageLayer &imageLayer);
+    void writeGroupLayer(XmlWriter &w, const GroupLayer &groupLayer);
+    void writeProperties(XmlWriter &w,
                          const Properties &properties);
-    void writeExportValue(QXmlStreamWriter &w, const ExportValue &value);
-    void writeImage(QXmlStreamWriter &w,
+    void writeExportValue(XmlWriter &w, const ExportValue &value);
+    void writeImage(XmlWriter &w,
                     const QUrl &source,
                     const QPixmap &image,
                     const QColor &transColor,
@@ -104,6 +110,20 @@ private:
     QDir mDir;      // The directory in which the file is being saved
     GidMapper mGidMapper;
     bool mUseAbsolutePaths { false };
+
+    /**
+     * Binary layer data encoded ahead of writing, in the order in which it
+     * is written.
+     */
+    struct EncodedLayerData
+    {
+        const TileLayer *tileLayer;
+        QRect bounds;
+        QByteArray data;
+    };
+
+    QVector<EncodedLayerData> mEncodedLayerData;
+    int mNextEncodedLayerData = 0;
 };
 
 } // namespace Internal
@@ -123,13 +143,15 @@ bool MapWriterPrivate::openFile(SaveFile *file)
 void MapWriterPrivate::writeMap(const Map *map, QIODevice *device,
                                 const QString &path)
 {
+    TILED_TRACE_SCOPE("MapWriter::writeMap");
+
     mDir = QDir(path);
     mUseAbsolutePaths = path.isEmpty();
     mLayerDataFormat = map->layerDataFormat();
     mCompressionlevel = map->compressionLevel();
     mChunkSize = map->chunkSize();
 
-    QXmlStreamWriter writer(device);
+    XmlWriter writer(device);
     writer.setAutoFormatting(!mMinimize);
     writer.setAutoFormattingIndent(1);
 
@@ -148,10 +170,12 @@ void MapWriterPrivate::writeMap(const Map *map, QIODevice *device,
 void MapWriterPrivate::writeTileset(const Tileset &tileset, QIODevice *device,
                                     const QString &path)
 {
+    TILED_TRACE_SCOPE("MapWriter::writeTileset");
+
     mDir = QDir(path);
     mUseAbsolutePaths = path.isEmpty();
 
-    QXmlStreamWriter writer(device);
+    XmlWriter writer(device);
     writer.setAutoFormatting(!mMinimize);
     writer.setAutoFormattingIndent(1);
 
@@ -173,12 +197,12 @@ void MapWriterPrivate::writeObjectTemplate(const ObjectTemplate *objectTemplate,
     mDir = QDir(path);
     mUseAbsolutePaths = path.isEmpty();
 
-    QXmlStreamWriter writer(device);
+    XmlWriter writer(device);
     writer.setAutoFormatting(!mMinimize);
     writer.setAutoFormattingIndent(1);
 
     writer.writeStartDocument();
-    writer.writeStartElement(QStringLiteral("template"));
+    writer.writeStartElement(QLatin1String("template"));
 
     mGidMapper.clear();
     if (Tileset *tileset = objectTemplate->object()->cell().tileset()) {
@@ -193,73 +217,65 @@ void MapWriterPrivate::writeObjectTemplate(const ObjectTemplate *objectTemplate,
     writer.writeEndDocument();
 }
 
-void MapWriterPrivate::writeMap(QXmlStreamWriter &w, const Map &map)
+void MapWriterPrivate::writeMap(XmlWriter &w, const Map &map)
 {
-    w.writeStartElement(QStringLiteral("map"));
+    w.writeStartElement(QLatin1String("map"));
 
     const QString orientation = orientationToString(map.orientation());
     const QString renderOrder = renderOrderToString(map.renderOrder());
 
-    w.writeAttribute(QStringLiteral("version"), FileFormat::versionString());
-    w.writeAttribute(QStringLiteral("tiledversion"), QCoreApplication::applicationVersion());
+    w.writeAttribute(QLatin1String("version"), FileFormat::versionString());
+    w.writeAttribute(QLatin1String("tiledversion"), QCoreApplication::applicationVersion());
     if (!map.className().isEmpty())
-        w.writeAttribute(QStringLiteral("class"), map.className());
-    w.writeAttribute(QStringLiteral("orientation"), orientation);
-    w.writeAttribute(QStringLiteral("renderorder"), renderOrder);
+        w.writeAttribute(QLatin1String("class"), map.className());
+    w.writeAttribute(QLatin1String("orientation"), orientation);
+    w.writeAttribute(QLatin1String("renderorder"), renderOrder);
     if (map.compressionLevel() >= 0)
-        w.writeAttribute(QStringLiteral("compressionlevel"), QString::number(map.compressionLevel()));
-    w.writeAttribute(QStringLiteral("width"), QString::number(map.width()));
-    w.writeAttribute(QStringLiteral("height"), QString::number(map.height()));
-    w.writeAttribute(QStringLiteral("tilewidth"),
-                     QString::number(map.tileWidth()));
-    w.writeAttribute(QStringLiteral("tileheight"),
-                     QString::number(map.tileHeight()));
-    w.writeAttribute(QStringLiteral("infinite"),
-                     QString::number(map.infinite()));
+        w.writeAttribute(QLatin1String("compressionlevel"), map.compressionLevel());
+    w.writeAttribute(QLatin1String("width"), map.width());
+    w.writeAttribute(QLatin1String("height"), map.height());
+    w.writeAttribute(QLatin1String("tilewidth"), map.tileWidth());
+    w.writeAttribute(QLatin1String("tileheight"), map.tileHeight());
+    w.writeAttribute(QLatin1String("infinite"), map.infinite());
 
     if (map.orientation() == Map::Hexagonal) {
-        w.writeAttribute(QStringLiteral("hexsidelength"),
-                         QString::number(map.hexSideLength()));
+        w.writeAttribute(QLatin1String("hexsidelength"), map.hexSideLength());
     }
 
     if (map.orientation() == Map::Staggered || map.orientation() == Map::Hexagonal) {
-        w.writeAttribute(QStringLiteral("staggeraxis"),
-                         staggerAxisToString(map.staggerAxis()));
-        w.writeAttribute(QStringLiteral("staggerindex"),
-                         staggerIndexToString(map.staggerIndex()));
+        w.writeAttribute(QLatin1String("staggeraxis"), staggerAxisToString(map.staggerAxis()));
+        w.writeAttribute(QLatin1String("staggerindex"), staggerIndexToString(map.staggerIndex()));
     }
 
     if (!map.parallaxOrigin().isNull()) {
-        w.writeAttribute(QStringLiteral("parallaxoriginx"), QString::number(map.parallaxOrigin().x()));
-        w.writeAttribute(QStringLiteral("parallaxoriginy"), QString::number(map.parallaxOrigin().y()));
+        w.writeAttribute(QLatin1String("parallaxoriginx"), map.parallaxOrigin().x());
+        w.writeAttribute(QLatin1String("parallaxoriginy"), map.parallaxOrigin().y());
     }
 
     if (map.backgroundColor().isValid()) {
-        w.writeAttribute(QStringLiteral("backgroundcolor"),
-                         colorToString(map.backgroundColor()));
+        w.writeAttribute(QLatin1String("backgroundcolor"), colorToString(map.backgroundColor()));
     }
 
-    w.writeAttribute(QStringLiteral("nextlayerid"),
-                     QString::number(map.nextLayerId()));
-    w.writeAttribute(QStringLiteral("nextobjectid"),
-                     QString::number(map.nextObjectId()));
+    w.writeAttribute(QLatin1String("nextlayerid"), map.nextLayerId());
+    w.writeAttribute(QLatin1String("nextobjectid"), map.nextObjectId());
 
-    if (map.chunkSize() != QSize(CHUNK_SIZE, CHUNK_SIZE) || !map.exportFileName.isEmpty() || !map.exportFormat.isEmpty()) {
-        w.writeStartElement(QStringLiteral("editorsettings"));
+    if (map.chunkSize() != QSize(OUTPUT_CHUNK_SIZE, OUTPUT_CHUNK_SIZE) || !map.exportFileName.isEmpty() || !map.exportFormat.isEmpty()) {
+        w.writeStartElement(QLatin1String("editorsettings"));
 
-        if (map.chunkSize() != QSize(CHUNK_SIZE, CHUNK_SIZE)) {
-            w.writeStartElement(QStringLiteral("chunksize"));
-            w.writeAttribute(QStringLiteral("width"), QString::number(map.chunkSize().width()));
-            w.writeAttribute(QStringLiteral("height"), QString::number(map.chunkSize().height()));
+        if (map.chunkSize() != QSize(OUTPUT_CHUNK_SIZE, OUTPUT_CHUNK_SIZE)) {
+            w.writeStartElement(QLatin1String("chunksize"));
+            w.writeAttribute(QLatin1String("width"), map.chunkSize().width());
+            w.writeAttribute(QLatin1String("height"), map.chunkSize().height());
             w.writeEndElement();
         }
 
         if (!map.exportFileName.isEmpty() || !map.exportFormat.isEmpty()) {
-            w.writeStartElement(QStringLiteral("export"));
+            w.writeStartElement(QLatin1String("export"));
             if (!map.exportFileName.isEmpty())
-                w.writeAttribute(QStringLiteral("target"), mDir.relativeFilePath(map.exportFileName));
+                w.writeAttribute(QLatin1String("target"),
+                                 mDir.relativeFilePath(map.exportFileName));
             if (!map.exportFormat.isEmpty())
-                w.writeAttribute(QStringLiteral("format"), map.exportFormat);
+                w.writeAttribute(QLatin1String("format"), map.exportFormat);
             w.writeEndElement();
         }
 
@@ -276,9 +292,84 @@ void MapWriterPrivate::writeMap(QXmlStreamWriter &w, const Map &map)
         firstGid += tileset->nextTileId();
     }
 
+    writeLayerDictionary(w, map);
+
+    if (mParallelEncoding)
+        encodeLayerDataInParallel(map);
+
     writeLayers(w, map.layers());
 
+    mEncodedLayerData.clear();
+
+    w.writeEndElement();
+}
+
+/**
+ * Trains and writes the compression dictionary shared by the tile layer data
+ * of the map, when using the Base64ZstandardDictionary format. No dictionary
+ * is written when there is too little data for it to be useful.
+ */
+void MapWriterPrivate::writeLayerDictionary(XmlWriter &w, const Map &map)
+{
+    mGidMapper.setCompressionDictionary(CompressionDictionary());
+
+    if (mLayerDataFormat != Map::Base64ZstandardDictionary)
+        return;
+
+    const CompressionDictionary dictionary =
+            mGidMapper.trainCompressionDictionary(map, mCompressionlevel);
+    if (dictionary.isNull())
+        return;
+
+    w.writeStartElement(QLatin1String("layerdictionary"));
+    w.writeAttribute(QLatin1String("encoding"), QLatin1String("base64"));
+    w.writeCharacters(QLatin1String(dictionary.data().toBase64()));
     w.writeEndElement();
+
+    mGidMapper.setCompressionDictionary(dictionary);
+}
+
+/**
+ * Compresses and encodes the binary data of all tile layers and chunks on
+ * the global thread pool. The results are picked up in order by
+ * writeTileLayerData(), so the output is the same as when encoding while
+ * writing.
+ */
+void MapWriterPrivate::encodeLayerDataInParallel(const Map &map)
+{
+    mEncodedLayerData.clear();
+    mNextEncodedLayerData = 0;
+
+    if (mLayerDataFormat == Map::XML || mLayerDataFormat == Map::CSV)
+        return;
+
+    // Tile layers are returned in the same order as they are written
+    LayerIterator iterator(&map, Layer::TileLayerType);
+    while (Layer *layer = iterator.next()) {
+        const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
+
+        if (map.infinite()) {
+            const auto chunks = tileLayer->sortedChunksToWrite(mChunkSize);
+            for (const QRect &rect : chunks)
+                mEncodedLayerData.append({ tileLayer, rect, QByteArray() });
+        } else {
+            mEncodedLayerData.append({ tileLayer,
+                                       QRect(0, 0, tileLayer->width(), tileLayer->height()),
+                                       QByteArray() });
+        }
+    }
+
+    if (mEncodedLayerData.size() < 2) {
+        mEncodedLayerData.clear();
+        return;
+    }
+
+    QtConcurrent::blockingMap(mEncodedLayerData, [this] (EncodedLayerData &encoded) {
+        encoded.data = mGidMapper.encodeLayerData(*encoded.tileLayer,
+                                                  mLayerDataFormat,
+                                                  encoded.bounds,
+                                                  mCompressionlevel);
+    });
 }
 
 static bool includeTile(const Tile *tile)
@@ -299,19 +390,19 @@ static bool includeTile(const Tile *tile)
     return false;
 }
 
-void MapWriterPrivate::writeTileset(QXmlStreamWriter &w, const Tileset &tileset,
+void MapWriterPrivate::writeTileset(XmlWriter &w, const Tileset &tileset,
                                     unsigned firstGid)
 {
-    w.writeStartElement(QStringLiteral("tileset"));
+    w.writeStartElement(QLatin1String("tileset"));
 
     if (firstGid > 0) {
-        w.writeAttribute(QStringLiteral("firstgid"), QString::number(firstGid));
+        w.writeAttribute(QLatin1String("firstgid"), firstGid);
 
         const QString &fileName = tileset.fileName();
         if (!fileName.isEmpty()) {
             QString source = mUseAbsolutePaths ? fileName
                                                : filePathRelativeTo(mDir, fileName);
-            w.writeAttribute(QStringLiteral("source"), source);
+            w.writeAttribute(QLatin1String("source"), source);
 
             // Tileset is external, so no need to write any of the stuff below
             w.writeEndElement();
@@ -319,57 +410,71 @@ void MapWriterPrivate::writeTileset(QXmlStreamWriter &w, const Tileset &tileset,
         }
     } else {
         // Include version in external tilesets
-        w.writeAttribute(QStringLiteral("version"), FileFormat::versionString());
-        w.writeAttribute(QStringLiteral("tiledversion"), QCoreApplication::applicationVersion());
+        w.writeAttribute(QLatin1String("version"), FileFormat::versionString());
+        w.writeAttribute(QLatin1String("tiledversion"), QCoreApplication::applicationVersion());
+    }
+
+    // During a batch export, reuse the output written for other maps
+    TilesetExportCache *cache = TilesetExportCache::instance();
+    if (firstGid == 0 || (cache && !cache->canCacheSerialized(tileset)))
+        cache = nullptr;
+
+    QString cacheContext;
+    if (cache) {
+        cacheContext = QStringLiteral("tmx:%1:%2").arg(int(mMinimize))
+                .arg(mUseAbsolutePaths ? QString() : mDir.absolutePath());
+
+        const QByteArray recorded = cache->serialized(&tileset, cacheContext).toByteArray();
+        if (!recorded.isEmpty()) {
+            w.writeRecordedElementEnd(recorded);
+            return;
+        }
+
+        w.startRecording();
     }
 
-    w.writeAttribute(QStringLiteral("name"), tileset.name());
+    w.writeAttribute(QLatin1String("name"), tileset.name());
     if (!tileset.className().isEmpty())
-        w.writeAttribute(QStringLiteral("class"), tileset.className());
-    w.writeAttribute(QStringLiteral("tilewidth"),
-                     QString::number(tileset.tileWidth()));
-    w.writeAttribute(QStringLiteral("tileheight"),
-                     QString::number(tileset.tileHeight()));
+        w.writeAttribute(QLatin1String("class"), tileset.className());
+    w.writeAttribute(QLatin1String("tilewidth"), tileset.tileWidth());
+    w.writeAttribute(QLatin1String("tileheight"), tileset.tileHeight());
     const int tileSpacing = tileset.tileSpacing();
     const int margin = tileset.margin();
     if (tileSpacing != 0)
-        w.writeAttribute(QStringLiteral("spacing"),
-                         QString::number(tileSpacing));
+        w.writeAttribute(QLatin1String("spacing"), tileSpacing);
     if (margin != 0)
-        w.writeAttribute(QStringLiteral("margin"), QString::number(margin));
+        w.writeAttribute(QLatin1String("margin"), margin);
 
-    w.writeAttribute(QStringLiteral("tilecount"),
-                     QString::number(tileset.tileCount()));
-    w.writeAttribute(QStringLiteral("columns"),
-                     QString::number(tileset.columnCount()));
+    w.writeAttribute(QLatin1String("tilecount"), tileset.tileCount());
+    w.writeAttribute(QLatin1String("columns"), tileset.columnCount());
 
     if (tileset.backgroundColor().isValid()) {
-        w.writeAttribute(QStringLiteral("backgroundcolor"),
+        w.writeAttribute(QLatin1String("backgroundcolor"),
                          colorToString(tileset.backgroundColor()));
     }
 
     if (tileset.objectAlignment() != Unspecified) {
-        w.writeAttribute(QStringLiteral("objectalignment"),
+        w.writeAttribute(QLatin1String("objectalignment"),
                          alignmentToString(tileset.objectAlignment()));
     }
 
     if (tileset.tileRenderSize() != Tileset::TileSize) {
-        w.writeAttribute(QStringLiteral("tilerendersize"),
+        w.writeAttribute(QLatin1String("tilerendersize"),
                          Tileset::tileRenderSizeToString(tileset.tileRenderSize()));
     }
 
     if (tileset.fillMode() != Tileset::Stretch) {
-        w.writeAttribute(QStringLiteral("fillmode"),
-                         Tileset::fillModeToString(tileset.fillMode()));
+        w.writeAttribute(QLatin1String("fillmode"), Tileset::fillModeToString(tileset.fillMode()));
     }
 
     // Write editor settings when saving external tilesets
     if (firstGid == 0) {
         if (!tileset.exportFileName.isEmpty() || !tileset.exportFormat.isEmpty()) {
-            w.writeStartElement(QStringLiteral("editorsettings"));
-            w.writeStartElement(QStringLiteral("export"));
-            w.writeAttribute(QStringLiteral("target"), mDir.relativeFilePath(tileset.exportFileName));
-            w.writeAttribute(QStringLiteral("format"), tileset.exportFormat);
+            w.writeStartElement(QLatin1String("editorsettings"));
+            w.writeStartElement(QLatin1String("export"));
+            w.writeAttribute(QLatin1String("target"),
+                             mDir.relativeFilePath(tileset.exportFileName));
+            w.writeAttribute(QLatin1String("format"), tileset.exportFormat);
             w.writeEndElement();
             w.writeEndElement();
         }
@@ -377,31 +482,32 @@ void MapWriterPrivate::writeTileset(QXmlStreamWriter &w, const Tileset &tileset,
 
     const QPoint offset = tileset.tileOffset();
     if (!offset.isNull()) {
-        w.writeStartElement(QStringLiteral("tileoffset"));
-        w.writeAttribute(QStringLiteral("x"), QString::number(offset.x()));
-        w.writeAttribute(QStringLiteral("y"), QString::number(offset.y()));
+        w.writeStartElement(QLatin1String("tileoffset"));
+        w.writeAttribute(QLatin1String("x"), offset.x());
+        w.writeAttribute(QLatin1String("y"), offset.y());
         w.writeEndElement();
     }
 
     if (tileset.orientation() != Tileset::Orthogonal || tileset.gridSize() != tileset.tileSize()) {
-        w.writeStartElement(QStringLiteral("grid"));
-        w.writeAttribute(QStringLiteral("orientation"), Tileset::orientationToString(tileset.orientation()));
-        w.writeAttribute(QStringLiteral("width"), QString::number(tileset.gridSize().width()));
-        w.writeAttribute(QStringLiteral("height"), QString::number(tileset.gridSize().height()));
+        w.writeStartElement(QLatin1String("grid"));
+        w.writeAttribute(QLatin1String("orientation"),
+                         Tileset::orientationToString(tileset.orientation()));
+        w.writeAttribute(QLatin1String("width"), tileset.gridSize().width());
+        w.writeAttribute(QLatin1String("height"), tileset.gridSize().height());
         w.writeEndElement();
     }
 
     const auto transformationFlags = tileset.transformationFlags();
     if (transformationFlags) {
-        w.writeStartElement(QStringLiteral("transformations"));
-        w.writeAttribute(QStringLiteral("hflip"),
-                         QString::number(transformationFlags.testFlag(Tileset::AllowFlipHorizontally)));
-        w.writeAttribute(QStringLiteral("vflip"),
-                         QString::number(transformationFlags.testFlag(Tileset::AllowFlipVertically)));
-        w.writeAttribute(QStringLiteral("rotate"),
-                         QString::number(transformationFlags.testFlag(Tileset::AllowRotate)));
-        w.writeAttribute(QStringLiteral("preferuntransformed"),
-                         QString::number(transformationFlags.testFlag(Tileset::PreferUntransformed)));
+        w.writeStartElement(QLatin1String("transformations"));
+        w.writeAttribute(QLatin1String("hflip"),
+                         transformationFlags.testFlag(Tileset::AllowFlipHorizontally));
+        w.writeAttribute(QLatin1String("vflip"),
+                         transformationFlags.testFlag(Tileset::AllowFlipVertically));
+        w.writeAttribute(QLatin1String("rotate"),
+                         transformationFlags.testFlag(Tileset::AllowRotate));
+        w.writeAttribute(QLatin1String("preferuntransformed"),
+                         transformationFlags.testFlag(Tileset::PreferUntransformed));
         w.writeEndElement();
     }
 
@@ -418,25 +524,21 @@ void MapWriterPrivate::writeTileset(QXmlStreamWriter &w, const Tileset &tileset,
 
     for (const Tile *tile : tileset.tiles()) {
         if (includeAllTiles || includeTile(tile)) {
-            w.writeStartElement(QStringLiteral("tile"));
-            w.writeAttribute(QStringLiteral("id"), QString::number(tile->id()));
+            w.writeStartElement(QLatin1String("tile"));
+            w.writeAttribute(QLatin1String("id"), tile->id());
 
             const QRect &imageRect = tile->imageRect();
             if (!imageRect.isNull() && imageRect != tile->image().rect() && isCollection) {
-                w.writeAttribute(QStringLiteral("x"),
-                                 QString::number(imageRect.x()));
-                w.writeAttribute(QStringLiteral("y"),
-                                 QString::number(imageRect.y()));
-                w.writeAttribute(QStringLiteral("width"),
-                                 QString::number(imageRect.width()));
-                w.writeAttribute(QStringLiteral("height"),
-                                 QString::number(imageRect.height()));
+                w.writeAttribute(QLatin1String("x"), imageRect.x());
+                w.writeAttribute(QLatin1String("y"), imageRect.y());
+                w.writeAttribute(QLatin1String("width"), imageRect.width());
+                w.writeAttribute(QLatin1String("height"), imageRect.height());
             }
 
             if (!tile->className().isEmpty())
                 w.writeAttribute(FileFormat::classPropertyNameForObject(), tile->className());
             if (tile->probability() != 1.0)
-                w.writeAttribute(QStringLiteral("probability"), QString::number(tile->probability()));
+                w.writeAttribute(QLatin1String("probability"), tile->probability());
             if (!tile->properties().isEmpty())
                 writeProperties(w, tile->properties());
             if (isCollection)
@@ -446,11 +548,11 @@ void MapWriterPrivate::writeTileset(QXmlStreamWriter &w, const Tileset &tileset,
             if (tile->isAnimated()) {
                 const QVector<Frame> &frames = tile->frames();
 
-                w.writeStartElement(QStringLiteral("animation"));
+                w.writeStartElement(QLatin1String("animation"));
                 for (const Frame &frame : frames) {
-                    w.writeStartElement(QStringLiteral("frame"));
-                    w.writeAttribute(QStringLiteral("tileid"), QString::number(frame.tileId));
-                    w.writeAttribute(QStringLiteral("duration"), QString::number(frame.duration));
+                    w.writeStartElement(QLatin1String("frame"));
+                    w.writeAttribute(QLatin1String("tileid"), frame.tileId);
+                    w.writeAttribute(QLatin1String("duration"), frame.duration);
                     w.writeEndElement(); // </frame>
                 }
                 w.writeEndElement(); // </animation>
@@ -461,26 +563,26 @@ void MapWriterPrivate::writeTileset(QXmlStreamWriter &w, const Tileset &tileset,
 
     // Write the wangsets
     if (tileset.wangSetCount() > 0) {
-        w.writeStartElement(QStringLiteral("wangsets"));
+        w.writeStartElement(QLatin1String("wangsets"));
         for (const WangSet *ws : tileset.wangSets()) {
-            w.writeStartElement(QStringLiteral("wangset"));
+            w.writeStartElement(QLatin1String("wangset"));
 
-            w.writeAttribute(QStringLiteral("name"), ws->name());
+            w.writeAttribute(QLatin1String("name"), ws->name());
             if (!ws->className().isEmpty())
-                w.writeAttribute(QStringLiteral("class"), ws->className());
-            w.writeAttribute(QStringLiteral("type"), wangSetTypeToString(ws->type()));
-            w.writeAttribute(QStringLiteral("tile"), QString::number(ws->imageTileId()));
+                w.writeAttribute(QLatin1String("class"), ws->className());
+            w.writeAttribute(QLatin1String("type"), wangSetTypeToString(ws->type()));
+            w.writeAttribute(QLatin1String("tile"), ws->imageTileId());
 
             for (int i = 1; i <= ws->colorCount(); ++i) {
                 if (const WangColor *wc = ws->colorAt(i).data()) {
-                    w.writeStartElement(QStringLiteral("wangcolor"));
+                    w.writeStartElement(QLatin1String("wangcolor"));
 
-                    w.writeAttribute(QStringLiteral("name"), wc->name());
+                    w.writeAttribute(QLatin1String("name"), wc->name());
                     if (!wc->className().isEmpty())
-                        w.writeAttribute(QStringLiteral("class"), wc->className());
-                    w.writeAttribute(QStringLiteral("color"), colorToString(wc->color()));
-                    w.writeAttribute(QStringLiteral("tile"), QString::number(wc->imageId()));
-                    w.writeAttribute(QStringLiteral("probability"), QString::number(wc->probability()));
+                        w.writeAttribute(QLatin1String("class"), wc->className());
+                    w.writeAttribute(QLatin1String("color"), colorToString(wc->color()));
+                    w.writeAttribute(QLatin1String("tile"), wc->imageId());
+                    w.writeAttribute(QLatin1String("probability"), wc->probability());
 
                     writeProperties(w, wc->properties());
 
@@ -490,9 +592,9 @@ void MapWriterPrivate::writeTileset(QXmlStreamWriter &w, const Tileset &tileset,
 
             const auto wangTiles = ws->sortedWangTiles();
             for (const WangTile &wangTile : wangTiles) {
-                w.writeStartElement(QStringLiteral("wangtile"));
-                w.writeAttribute(QStringLiteral("tileid"), QString::number(wangTile.tileId()));
-                w.writeAttribute(QStringLiteral("wangid"), wangTile.wangId().toString());
+                w.writeStartElement(QLatin1String("wangtile"));
+                w.writeAttribute(QLatin1String("tileid"), wangTile.tileId());
+                w.writeAttribute(QLatin1String("wangid"), wangTile.wangId().toString());
                 w.writeEndElement(); // </wangtile>
             }
 
@@ -504,9 +606,12 @@ void MapWriterPrivate::writeTileset(QXmlStreamWriter &w, const Tileset &tileset,
     }
 
     w.writeEndElement();
+
+    if (cache)
+        cache->insertSerialized(&tileset, cacheContext, w.finishRecording());
 }
 
-void MapWriterPrivate::writeLayers(QXmlStreamWriter &w, const QList<Layer*> &layers)
+void MapWriterPrivate::writeLayers(XmlWriter &w, const QList<Layer*> &layers)
 {
     for (const Layer *layer : layers) {
         switch (layer->layerType()) {
@@ -526,15 +631,16 @@ void MapWriterPrivate::writeLayers(QXmlStreamWriter &w, const QList<Layer*> &lay
     }
 }
 
-void MapWriterPrivate::writeTileLayer(QXmlStreamWriter &w,
+void MapWriterPrivate::writeTileLayer(XmlWriter &w,
                                       const TileLayer &tileLayer)
 {
-    w.writeStartElement(QStringLiteral("layer"));
+    w.writeStartElement(QLatin1String("layer"));
     writeLayerAttributes(w, tileLayer);
     writeProperties(w, tileLayer.properties());
 
     QString encoding;
     QString compression;
+    QString filter;
 
     switch (mLayerDataFormat) {
     case Map::XML:
@@ -546,25 +652,32 @@ void MapWriterPrivate::writeTileLayer(QXmlStreamWriter &w,
         encoding = QStringLiteral("base64");
         compression = compressionToString(mLayerDataFormat);
         break;
+    case Map::Base64ZstandardDictionary:
+        encoding = QStringLiteral("base64");
+        compression = compressionToString(mLayerDataFormat);
+        filter = QStringLiteral("delta");
+        break;
     case Map::CSV:
         encoding = QStringLiteral("csv");
         break;
     }
 
-    w.writeStartElement(QStringLiteral("data"));
+    w.writeStartElement(QLatin1String("data"));
     if (!encoding.isEmpty())
-        w.writeAttribute(QStringLiteral("encoding"), encoding);
+        w.writeAttribute(QLatin1String("encoding"), encoding);
     if (!compression.isEmpty())
-        w.writeAttribute(QStringLiteral("compression"), compression);
+        w.writeAttribute(QLatin1String("compression"), compression);
+    if (!filter.isEmpty())
+        w.writeAttribute(QLatin1String("filter"), filter);
 
     if (tileLayer.map()->infinite()) {
         const auto chunks = tileLayer.sortedChunksToWrite(mChunkSize);
         for (const QRect &rect : chunks) {
-            w.writeStartElement(QStringLiteral("chunk"));
-            w.writeAttribute(QStringLiteral("x"), QString::number(rect.x()));
-            w.writeAttribute(QStringLiteral("y"), QString::number(rect.y()));
-            w.writeAttribute(QStringLiteral("width"), QString::number(rect.width()));
-            w.writeAttribute(QStringLiteral("height"), QString::number(rect.height()));
+            w.writeStartElement(QLatin1String("chunk"));
+            w.writeAttribute(QLatin1String("x"), rect.x());
+            w.writeAttribute(QLatin1String("y"), rect.y());
+            w.writeAttribute(QLatin1String("width"), rect.width());
+            w.writeAttribute(QLatin1String("height"), rect.height());
 
             writeTileLayerData(w, tileLayer, rect);
 
@@ -579,7 +692,7 @@ void MapWriterPrivate::writeTileLayer(QXmlStreamWriter &w,
     w.writeEndElement(); // </layer>
 }
 
-void MapWriterPrivate::writeTileLayerData(QXmlStreamWriter &w,
+void MapWriterPrivate::writeTileLayerData(XmlWriter &w,
                                           const TileLayer &tileLayer,
                                           QRect bounds)
 {
@@ -587,114 +700,117 @@ void MapWriterPrivate::writeTileLayerData(QXmlStreamWriter &w,
         for (int y = bounds.top(); y <= bounds.bottom(); y++) {
             for (int x = bounds.left(); x <= bounds.right(); x++) {
                 const unsigned gid = mGidMapper.cellToGid(tileLayer.cellAt(x, y));
-                w.writeStartElement(QStringLiteral("tile"));
+                w.writeStartElement(QLatin1String("tile"));
                 if (gid != 0)
-                    w.writeAttribute(QStringLiteral("gid"), QString::number(gid));
+                    w.writeAttribute(QLatin1String("gid"), gid);
                 w.writeEndElement();
             }
         }
     } else if (mLayerDataFormat == Map::CSV) {
-        QString chunkData;
+        QByteArray chunkData;
 
         if (!mMinimize)
-            chunkData.append(QLatin1Char('\n'));
+            chunkData.append('\n');
 
         for (int y = bounds.top(); y <= bounds.bottom(); y++) {
             for (int x = bounds.left(); x <= bounds.right(); x++) {
                 const unsigned gid = mGidMapper.cellToGid(tileLayer.cellAt(x, y));
-                chunkData.append(QString::number(gid));
+                XmlWriter::appendNumber(chunkData, qint64(gid));
                 if (x != bounds.right() || y != bounds.bottom())
-                    chunkData.append(QLatin1Char(','));
+                    chunkData.append(',');
             }
             if (!mMinimize)
-                chunkData.append(QLatin1Char('\n'));
+                chunkData.append('\n');
         }
 
-        w.writeCharacters(chunkData);
+        w.writeCharacters(QLatin1String(chunkData));
     } else {
-        QByteArray chunkData = mGidMapper.encodeLayerData(tileLayer,
-                                                          mLayerDataFormat,
-                                                          bounds,
-                                                          mCompressionlevel);
+        QByteArray chunkData;
+
+        if (mNextEncodedLayerData < mEncodedLayerData.size()) {
+            EncodedLayerData &encoded = mEncodedLayerData[mNextEncodedLayerData++];
+            Q_ASSERT(encoded.tileLayer == &tileLayer && encoded.bounds == bounds);
+            chunkData = std::move(encoded.data);
+        } else {
+            chunkData = mGidMapper.encodeLayerData(tileLayer,
+                                                   mLayerDataFormat,
+                                                   bounds,
+                                                   mCompressionlevel);
+        }
 
         if (!mMinimize)
             w.writeCharacters(QLatin1String("\n   "));
 
-        w.writeCharacters(QString::fromLatin1(chunkData));
+        w.writeCharacters(QLatin1String(chunkData));
 
         if (!mMinimize)
             w.writeCharacters(QLatin1String("\n  "));
     }
 }
 
-void MapWriterPrivate::writeLayerAttributes(QXmlStreamWriter &w,
+void MapWriterPrivate::writeLayerAttributes(XmlWriter &w,
                                             const Layer &layer)
 {
     if (layer.id() != 0)
-        w.writeAttribute(QStringLiteral("id"), QString::number(layer.id()));
+        w.writeAttribute(QLatin1String("id"), layer.id());
     if (!layer.name().isEmpty())
-        w.writeAttribute(QStringLiteral("name"), layer.name());
+        w.writeAttribute(QLatin1String("name"), layer.name());
     if (!layer.className().isEmpty())
-        w.writeAttribute(QStringLiteral("class"), layer.className());
+        w.writeAttribute(QLatin1String("class"), layer.className());
 
     const int x = layer.x();
     const int y = layer.y();
     const qreal opacity = layer.opacity();
     if (x != 0)
-        w.writeAttribute(QStringLiteral("x"), QString::number(x));
+        w.writeAttribute(QLatin1String("x"), x);
     if (y != 0)
-        w.writeAttribute(QStringLiteral("y"), QString::number(y));
+        w.writeAttribute(QLatin1String("y"), y);
 
     if (layer.layerType() == Layer::TileLayerType) {
         auto &tileLayer = static_cast<const TileLayer&>(layer);
         int width = tileLayer.width();
         int height = tileLayer.height();
 
-        w.writeAttribute(QStringLiteral("width"),
-                         QString::number(width));
-        w.writeAttribute(QStringLiteral("height"),
-                         QString::number(height));
+        w.writeAttribute(QLatin1String("width"), width);
+        w.writeAttribute(QLatin1String("height"), height);
     }
 
     if (!layer.isVisible())
-        w.writeAttribute(QStringLiteral("visible"), QStringLiteral("0"));
+        w.writeAttribute(QLatin1String("visible"), QLatin1String("0"));
     if (layer.isLocked())
-        w.writeAttribute(QStringLiteral("locked"), QStringLiteral("1"));
+        w.writeAttribute(QLatin1String("locked"), QLatin1String("1"));
     if (opacity != qreal(1))
-        w.writeAttribute(QStringLiteral("opacity"), QString::number(opacity));
+        w.writeAttribute(QLatin1String("opacity"), opacity);
     if (layer.tintColor().isValid()) {
-        w.writeAttribute(QStringLiteral("tintcolor"),
-                         colorToString(layer.tintColor()));
+        w.writeAttribute(QLatin1String("tintcolor"), colorToString(layer.tintColor()));
     }
 
     const QPointF offset = layer.offset();
     if (!offset.isNull()) {
-        w.writeAttribute(QStringLiteral("offsetx"), QString::number(offset.x()));
-        w.writeAttribute(QStringLiteral("offsety"), QString::number(offset.y()));
+        w.writeAttribute(QLatin1String("offsetx"), offset.x());
+        w.writeAttribute(QLatin1String("offsety"), offset.y());
     }
 
     const QPointF parallaxFactor = layer.parallaxFactor();
     if (parallaxFactor.x() != 1.0)
-        w.writeAttribute(QStringLiteral("parallaxx"), QString::number(parallaxFactor.x()));
+        w.writeAttribute(QLatin1String("parallaxx"), parallaxFactor.x());
     if (parallaxFactor.y() != 1.0)
-        w.writeAttribute(QStringLiteral("parallaxy"), QString::number(parallaxFactor.y()));
+        w.writeAttribute(QLatin1String("parallaxy"), parallaxFactor.y());
 
     if (layer.blendMode() != BlendMode::Normal)
-        w.writeAttribute(QStringLiteral("mode"), blendModeToString(layer.blendMode()));
+        w.writeAttribute(QLatin1String("mode"), blendModeToString(layer.blendMode()));
 }
 
-void MapWriterPrivate::writeObjectGroup(QXmlStreamWriter &w,
+void MapWriterPrivate::writeObjectGroup(XmlWriter &w,
                                         const ObjectGroup &objectGroup)
 {
-    w.writeStartElement(QStringLiteral("objectgroup"));
+    w.writeStartElement(QLatin1String("objectgroup"));
 
     if (objectGroup.color().isValid())
-        w.writeAttribute(QStringLiteral("color"),
-                         colorToString(objectGroup.color()));
+        w.writeAttribute(QLatin1String("color"), colorToString(objectGroup.color()));
 
     if (objectGroup.drawOrder() != ObjectGroup::TopDownOrder) {
-        w.writeAttribute(QStringLiteral("draworder"),
-                         drawOrderToString(objectGroup.drawOrder()));
+        w.writeAttribute(QLatin1String("draworder"), drawOrderToString(objectGroup.drawOrder()));
     }
 
     writeLayerAttributes(w, objectGroup);
@@ -711,10 +827,10 @@ static bool shouldWrite(bool holdsInfo, bool isTemplateInstance, bool changed)
     return isTemplateInstance ? changed : holdsInfo;
 }
 
-void MapWriterPrivate::writeObject(QXmlStreamWriter &w,
+void MapWriterPrivate::writeObject(XmlWriter &w,
                                    const MapObject &mapObject)
 {
-    w.writeStartElement(QStringLiteral("object"));
+    w.writeStartElement(QLatin1String("object"));
     const int id = mapObject.id();
     const QString &name = mapObject.name();
     const QString &className = mapObject.className();
@@ -723,45 +839,46 @@ void MapWriterPrivate::writeObject(QXmlStreamWriter &w,
     bool isTemplateInstance = mapObject.isTemplateInstance();
 
     if (!mapObject.isTemplateBase())
-        w.writeAttribute(QStringLiteral("id"), QString::number(id));
+        w.writeAttribute(QLatin1String("id"), id);
 
     if (const ObjectTemplate *objectTemplate = mapObject.objectTemplate()) {
         QString fileName = objectTemplate->fileName();
         if (!mUseAbsolutePaths)
             fileName = filePathRelativeTo(mDir, fileName);
-        w.writeAttribute(QStringLiteral("template"), fileName);
+        w.writeAttribute(QLatin1String("template"), fileName);
     }
 
     if (shouldWrite(!name.isEmpty(), isTemplateInstance, mapObject.propertyChanged(MapObject::NameProperty)))
-        w.writeAttribute(QStringLiteral("name"), name);
+        w.writeAttribute(QLatin1String("name"), name);
 
     if (!className.isEmpty())
         w.writeAttribute(FileFormat::classPropertyNameForObject(), className);
 
     if (shouldWrite(!mapObject.cell().isEmpty(), isTemplateInstance, mapObject.propertyChanged(MapObject::CellProperty))) {
         const unsigned gid = mGidMapper.cellToGid(mapObject.cell());
-        w.writeAttribute(QStringLiteral("gid"), QString::number(gid));
+        w.writeAttribute(QLatin1String("gid"), gid);
     }
 
     if (!mapObject.isTemplateBase()) {
-        w.writeAttribute(QStringLiteral("x"), QString::number(pos.x()));
-        w.writeAttribute(QStringLiteral("y"), QString::number(pos.y()));
+        w.writeAttribute(QLatin1String("x"), pos.x());
+        w.writeAttribute(QLatin1String("y"), pos.y());
     }
 
     if (shouldWrite(true, isTemplateInstance, mapObject.propertyChanged(MapObject::SizeProperty))) {
         const QSizeF size = mapObject.size();
         if (size.width() != 0)
-            w.writeAttribute(QStringLiteral("width"), QString::number(size.width()));
+            w.writeAttribute(QLatin1String("width"), size.width());
         if (size.height() != 0)
-            w.writeAttribute(QStringLiteral("height"), QString::number(size.height()));
+            w.writeAttribute(QLatin1String("height"), size.height());
     }
 
     const qreal rotation = mapObject.rotation();
     if (shouldWrite(rotation != 0.0, isTemplateInstance, mapObject.propertyChanged(MapObject::RotationProperty)))
-        w.writeAttribute(QStringLiteral("rotation"), QString::number(rotation));
+        w.writeAttribute(QLatin1String("rotation"), rotation);
 
     if (shouldWrite(!mapObject.isVisible(), isTemplateInstance, mapObject.propertyChanged(MapObject::VisibleProperty)))
-        w.writeAttribute(QStringLiteral("visible"), QLatin1String(mapObject.isVisible() ? "1" : "0"));
+        w.writeAttribute(QLatin1String("visible"),
+                         QLatin1String(mapObject.isVisible() ? "1" : "0"));
 
     writeProperties(w, mapObject.properties());
 
@@ -772,19 +889,19 @@ void MapWriterPrivate::writeObject(QXmlStreamWriter &w,
     case MapObject::Polyline: {
         if (shouldWrite(true, isTemplateInstance, mapObject.propertyChanged(MapObject::ShapeProperty))) {
             if (mapObject.shape() == MapObject::Polygon)
-                w.writeStartElement(QStringLiteral("polygon"));
+                w.writeStartElement(QLatin1String("polygon"));
             else
-                w.writeStartElement(QStringLiteral("polyline"));
+                w.writeStartElement(QLatin1String("polyline"));
 
-            QString points;
+            QByteArray points;
             for (const QPointF &point : mapObject.polygon()) {
-                points.append(QString::number(point.x()));
-                points.append(QLatin1Char(','));
-                points.append(QString::number(point.y()));
-                points.append(QLatin1Char(' '));
+                XmlWriter::appendNumber(points, point.x());
+                points.append(',');
+                XmlWriter::appendNumber(points, point.y());
+                points.append(' ');
             }
             points.chop(1);
-            w.writeAttribute(QStringLiteral("points"), points);
+            w.writeAttribute(QLatin1String("points"), QLatin1String(points));
             w.writeEndElement();
         }
         break;
@@ -816,59 +933,59 @@ void MapWriterPrivate::writeObject(QXmlStreamWriter &w,
     w.writeEndElement();
 }
 
-void MapWriterPrivate::writeObjectText(QXmlStreamWriter &w, const TextData &textData)
+void MapWriterPrivate::writeObjectText(XmlWriter &w, const TextData &textData)
 {
-    w.writeStartElement(QStringLiteral("text"));
+    w.writeStartElement(QLatin1String("text"));
 
     if (textData.font.family() != QLatin1String("sans-serif"))
-        w.writeAttribute(QStringLiteral("fontfamily"), textData.font.family());
+        w.writeAttribute(QLatin1String("fontfamily"), textData.font.family());
     if (textData.font.pixelSize() >= 0 && textData.font.pixelSize() != 16)
-        w.writeAttribute(QStringLiteral("pixelsize"), QString::number(textData.font.pixelSize()));
+        w.writeAttribute(QLatin1String("pixelsize"), textData.font.pixelSize());
     if (textData.wordWrap)
-        w.writeAttribute(QStringLiteral("wrap"), QStringLiteral("1"));
+        w.writeAttribute(QLatin1String("wrap"), QLatin1String("1"));
     if (textData.color != Qt::black)
-        w.writeAttribute(QStringLiteral("color"), colorToString(textData.color));
+        w.writeAttribute(QLatin1String("color"), colorToString(textData.color));
     if (textData.font.bold())
-        w.writeAttribute(QStringLiteral("bold"), QStringLiteral("1"));
+        w.writeAttribute(QLatin1String("bold"), QLatin1String("1"));
     if (textData.font.italic())
-        w.writeAttribute(QStringLiteral("italic"), QStringLiteral("1"));
+        w.writeAttribute(QLatin1String("italic"), QLatin1String("1"));
     if (textData.font.underline())
-        w.writeAttribute(QStringLiteral("underline"), QStringLiteral("1"));
+        w.writeAttribute(QLatin1String("underline"), QLatin1String("1"));
     if (textData.font.strikeOut())
-        w.writeAttribute(QStringLiteral("strikeout"), QStringLiteral("1"));
+        w.writeAttribute(QLatin1String("strikeout"), QLatin1String("1"));
     if (!textData.font.kerning())
-        w.writeAttribute(QStringLiteral("kerning"), QStringLiteral("0"));
+        w.writeAttribute(QLatin1String("kerning"), QLatin1String("0"));
 
     if (!textData.alignment.testFlag(Qt::AlignLeft)) {
         if (textData.alignment.testFlag(Qt::AlignHCenter))
-            w.writeAttribute(QStringLiteral("halign"), QStringLiteral("center"));
+            w.writeAttribute(QLatin1String("halign"), QLatin1String("center"));
         else if (textData.alignment.testFlag(Qt::AlignRight))
-            w.writeAttribute(QStringLiteral("halign"), QStringLiteral("right"));
+            w.writeAttribute(QLatin1String("halign"), QLatin1String("right"));
         else if (textData.alignment.testFlag(Qt::AlignJustify))
-            w.writeAttribute(QStringLiteral("halign"), QStringLiteral("justify"));
+            w.writeAttribute(QLatin1String("halign"), QLatin1String("justify"));
     }
 
     if (!textData.alignment.testFlag(Qt::AlignTop)) {
         if (textData.alignment.testFlag(Qt::AlignVCenter))
-            w.writeAttribute(QStringLiteral("valign"), QLatin1String("center"));
+            w.writeAttribute(QLatin1String("valign"), QLatin1String("center"));
         else if (textData.alignment.testFlag(Qt::AlignBottom))
-            w.writeAttribute(QStringLiteral("valign"), QLatin1String("bottom"));
+            w.writeAttribute(QLatin1String("valign"), QLatin1String("bottom"));
     }
 
     w.writeCharacters(textData.text);
     w.writeEndElement();
 }
 
-void MapWriterPrivate::writeImageLayer(QXmlStreamWriter &w,
+void MapWriterPrivate::writeImageLayer(XmlWriter &w,
                                        const ImageLayer &imageLayer)
 {
-    w.writeStartElement(QStringLiteral("imagelayer"));
+    w.writeStartElement(QLatin1String("imagelayer"));
     writeLayerAttributes(w, imageLayer);
 
     if (imageLayer.repeatX())
-        w.writeAttribute(QStringLiteral("repeatx"), QString::number(imageLayer.repeatX()));
+        w.writeAttribute(QLatin1String("repeatx"), imageLayer.repeatX());
     if (imageLayer.repeatY())
-        w.writeAttribute(QStringLiteral("repeaty"), QString::number(imageLayer.repeatY()));
+        w.writeAttribute(QLatin1String("repeaty"), imageLayer.repeatY());
 
     writeImage(w, imageLayer.imageSource(), imageLayer.image(),
                imageLayer.transparentColor(), QSize());
@@ -878,10 +995,10 @@ void MapWriterPrivate::writeImageLayer(QXmlStreamWriter &w,
     w.writeEndElement();
 }
 
-void MapWriterPrivate::writeGroupLayer(QXmlStreamWriter &w,
+void MapWriterPrivate::writeGroupLayer(XmlWriter &w,
                                        const GroupLayer &groupLayer)
 {
-    w.writeStartElement(QStringLiteral("group"));
+    w.writeStartElement(QLatin1String("group"));
     writeLayerAttributes(w, groupLayer);
 
     writeProperties(w, groupLayer.properties());
@@ -890,13 +1007,13 @@ void MapWriterPrivate::writeGroupLayer(QXmlStreamWriter &w,
     w.writeEndElement();
 }
 
-void MapWriterPrivate::writeProperties(QXmlStreamWriter &w,
+void MapWriterPrivate::writeProperties(XmlWriter &w,
                                        const Properties &properties)
 {
     if (properties.isEmpty())
         return;
 
-    w.writeStartElement(QStringLiteral("properties"));
+    w.writeStartElement(QLatin1String("properties"));
 
     ExportContext context(mUseAbsolutePaths ? QString() : mDir.path());
     context.setRecursiveBehavior(ExportContext::RecursiveBehavior::ExportValuesOnly);
@@ -904,8 +1021,8 @@ void MapWriterPrivate::writeProperties(QXmlStreamWriter &w,
     Properties::const_iterator it = properties.constBegin();
     Properties::const_iterator it_end = properties.constEnd();
     for (; it != it_end; ++it) {
-        w.writeStartElement(QStringLiteral("property"));
-        w.writeAttribute(QStringLiteral("name"), it.key());
+        w.writeStartElement(QLatin1String("property"));
+        w.writeAttribute(QLatin1String("name"), it.key());
 
         writeExportValue(w, context.toExportValue(it.value()));
 
@@ -915,18 +1032,18 @@ void MapWriterPrivate::writeProperties(QXmlStreamWriter &w,
     w.writeEndElement(); // </properties>
 }
 
-void MapWriterPrivate::writeExportValue(QXmlStreamWriter &w, const ExportValue &exportValue)
+void MapWriterPrivate::writeExportValue(XmlWriter &w, const ExportValue &exportValue)
 {
     if (exportValue.typeName != QLatin1String("string"))
-        w.writeAttribute(QStringLiteral("type"), exportValue.typeName);
+        w.writeAttribute(QLatin1String("type"), exportValue.typeName);
     if (!exportValue.propertyTypeName.isEmpty())
-        w.writeAttribute(QStringLiteral("propertytype"), exportValue.propertyTypeName);
+        w.writeAttribute(QLatin1String("propertytype"), exportValue.propertyTypeName);
 
     switch (exportValue.value.userType()) {
     case QMetaType::QVariantList: {
         const auto values = exportValue.value.toList();
         for (const QVariant &value : values) {
-            w.writeStartElement(QStringLiteral("item"));
+            w.writeStartElement(QLatin1String("item"));
             writeExportValue(w, value.value<ExportValue>());
             w.writeEndElement(); // </item>
         }
@@ -937,12 +1054,12 @@ void MapWriterPrivate::writeExportValue(QXmlStreamWriter &w, const ExportValue &
         if (map.isEmpty())
             break;
 
-        w.writeStartElement(QStringLiteral("properties"));
+        w.writeStartElement(QLatin1String("properties"));
         Properties::const_iterator it = map.constBegin();
         Properties::const_iterator it_end = map.constEnd();
         for (; it != it_end; ++it) {
-            w.writeStartElement(QStringLiteral("property"));
-            w.writeAttribute(QStringLiteral("name"), it.key());
+            w.writeStartElement(QLatin1String("property"));
+            w.writeAttribute(QLatin1String("name"), it.key());
 
             writeExportValue(w, it.value().value<ExportValue>());
 
@@ -957,12 +1074,12 @@ void MapWriterPrivate::writeExportValue(QXmlStreamWriter &w, const ExportValue &
         if (value.contains(QLatin1Char('\n')))
             w.writeCharacters(value);
         else
-            w.writeAttribute(QStringLiteral("value"), value);
+            w.writeAttribute(QLatin1String("value"), value);
         break;
     }
 }
 
-void MapWriterPrivate::writeImage(QXmlStreamWriter &w,
+void MapWriterPrivate::writeImage(XmlWriter &w,
                                   const QUrl &source,
                                   const QPixmap &image,
                                   const QColor &transColor,
@@ -971,37 +1088,35 @@ void MapWriterPrivate::writeImage(QXmlStreamWriter &w,
     if (source.isEmpty() && image.isNull())
         return;
 
-    w.writeStartElement(QStringLiteral("image"));
+    w.writeStartElement(QLatin1String("image"));
 
     if (!source.isEmpty()) {
         QString fileRef = toFileReference(source, mUseAbsolutePaths ? QString()
                                                                     : mDir.path());
-        w.writeAttribute(QStringLiteral("source"), fileRef);
+        w.writeAttribute(QLatin1String("source"), fileRef);
     }
 
     if (transColor.isValid())
-        w.writeAttribute(QStringLiteral("trans"), transColor.name().mid(1));
+        w.writeAttribute(QLatin1String("trans"), transColor.name().mid(1));
 
     const QSize imageSize = image.isNull() ? size : image.size();
     if (imageSize.width() > 0) {
-        w.writeAttribute(QStringLiteral("width"),
-                         QString::number(imageSize.width()));
+        w.writeAttribute(QLatin1String("width"), imageSize.width());
     }
     if (imageSize.height() > 0) {
-        w.writeAttribute(QStringLiteral("height"),
-                         QString::number(imageSize.height()));
+        w.writeAttribute(QLatin1String("height"), imageSize.height());
     }
 
     if (source.isEmpty()) {
         // Write an embedded image
-        w.writeAttribute(QStringLiteral("format"), QLatin1String("png"));
+        w.writeAttribute(QLatin1String("format"), QLatin1String("png"));
 
-        w.writeStartElement(QStringLiteral("data"));
-        w.writeAttribute(QStringLiteral("encoding"), QLatin1String("base64"));
+        w.writeStartElement(QLatin1String("data"));
+        w.writeAttribute(QLatin1String("encoding"), QLatin1String("base64"));
 
         QBuffer buffer;
         image.save(&buffer, "png");
-        w.writeCharacters(QString::fromLatin1(buffer.data().toBase64()));
+        w.writeCharacters(QLatin1String(buffer.data().toBase64()));
         w.writeEndElement(); // </data>
     }
 
@@ -1121,3 +1236,13 @@ bool MapWriter::minimizeOutput() const
 {
     return d->mMinimize;
 }
+
+void MapWriter::setParallelEncoding(bool enabled)
+{
+    d->mParallelEncoding = enabled;
+}
+
+bool MapWriter::parallelEncoding() const
+{
+    return d->mParallelEncoding;
+}
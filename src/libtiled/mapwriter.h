@@ -50,7 +50,7 @@ class MapWriterPrivate;
 } // namespace Internal
 
 /**
- * A QXmlStreamWriter based writer for the TMX and TSX formats.
+ * An XmlWriter based writer for the TMX and TSX formats.
  */
 class TILEDSHARED_EXPORT MapWriter
 {
@@ -118,6 +118,14 @@ public:
     void setMinimizeOutput(bool enabled);
     bool minimizeOutput() const;
 
+    /**
+     * Sets whether the binary layer data of a map is compressed and encoded
+     * in parallel, on the global thread pool. The output is the same either
+     * way.
+     */
+    void setParallelEncoding(bool enabled);
+    bool parallelEncoding() const;
+
 private:
     Q_DISABLE_COPY(MapWriter)
 
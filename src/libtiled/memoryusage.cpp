@@ -0,0 +1,176 @@
+/*
+ * memoryusage.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "memoryusage.h"
+
+#include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+namespace Tiled {
+
+MemoryUsage &MemoryUsage::operator+=(const MemoryUsage &other)
+{
+    tileLayers += other.tileLayers;
+    objects += other.objects;
+    properties += other.properties;
+    images += other.images;
+    tiles += other.tiles;
+    return *this;
+}
+
+static qint64 stringUsage(const QString &string)
+{
+    return static_cast<qint64>(string.capacity()) * sizeof(QChar);
+}
+
+static qint64 variantUsage(const QVariant &value)
+{
+    qint64 bytes = sizeof(QVariant);
+
+    switch (value.userType()) {
+    case QMetaType::QString:
+        bytes += stringUsage(value.toString());
+        break;
+    case QMetaType::QByteArray:
+        bytes += value.toByteArray().capacity();
+        break;
+    case QMetaType::QVariantList: {
+        const auto list = value.toList();
+        for (const QVariant &item : list)
+            bytes += variantUsage(item);
+        break;
+    }
+    case QMetaType::QVariantMap:
+        bytes += memoryUsage(value.toMap());
+        break;
+    default:
+        if (value.userType() == propertyValueId())
+            bytes += variantUsage(value.value<PropertyValue>().value);
+        break;
+    }
+
+    return bytes;
+}
+
+qint64 memoryUsage(const Properties &properties)
+{
+    qint64 bytes = 0;
+    for (auto it = properties.begin(), end = properties.end(); it != end; ++it)
+        bytes += sizeof(QString) + stringUsage(it.key()) + variantUsage(it.value());
+    return bytes;
+}
+
+qint64 memoryUsage(const QPixmap &pixmap)
+{
+    return static_cast<qint64>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
+
+static void addObjectUsage(const MapObject &object, MemoryUsage &usage)
+{
+    usage.objects += sizeof(MapObject)
+            + stringUsage(object.name())
+            + stringUsage(object.className())
+            + stringUsage(object.textData().text)
+            + object.polygon().capacity() * sizeof(QPointF);
+    usage.properties += memoryUsage(object.properties());
+}
+
+static void addObjectGroupUsage(const ObjectGroup &objectGroup, MemoryUsage &usage)
+{
+    usage.objects += sizeof(ObjectGroup);
+    for (const MapObject *object : objectGroup.objects())
+        addObjectUsage(*object, usage);
+}
+
+/**
+ * Returns the memory used by the given \a map, including its embedded
+ * tilesets. External tilesets are not included, since they may be shared
+ * with other maps.
+ */
+MemoryUsage memoryUsage(const Map &map)
+{
+    MemoryUsage usage;
+    usage.properties += memoryUsage(map.properties());
+
+    for (Layer *layer : map.allLayers()) {
+        usage.properties += memoryUsage(layer->properties());
+
+        switch (layer->layerType()) {
+        case Layer::TileLayerType:
+            usage.tileLayers += layer->asTileLayer()->memoryUsage();
+            break;
+        case Layer::ObjectGroupType:
+            addObjectGroupUsage(*layer->asObjectGroup(), usage);
+            break;
+        case Layer::ImageLayerType:
+            usage.images += memoryUsage(layer->asImageLayer()->image());
+            break;
+        case Layer::GroupLayerType:
+            break;
+        }
+    }
+
+    for (const SharedTileset &tileset : map.tilesets())
+        if (!tileset->isExternal())
+            usage += memoryUsage(*tileset);
+
+    return usage;
+}
+
+/**
+ * Returns the memory used by the given \a tileset. The tileset image is
+ * usually shared with the ImageCache, so it is counted in both.
+ */
+MemoryUsage memoryUsage(const Tileset &tileset)
+{
+    MemoryUsage usage;
+    usage.properties += memoryUsage(tileset.properties());
+    usage.images += memoryUsage(tileset.image());
+
+    for (const Tile *tile : tileset.tiles()) {
+        usage.tiles += sizeof(Tile) + tile->frames().capacity() * sizeof(Frame);
+        usage.properties += memoryUsage(tile->properties());
+
+        // Image collection tiles have their own image, while tiles from a
+        // tileset image share its pixels
+        if (tileset.isCollection())
+            usage.images += memoryUsage(tile->image());
+
+        if (const ObjectGroup *objectGroup = tile->objectGroup())
+            addObjectGroupUsage(*objectGroup, usage);
+    }
+
+    return usage;
+}
+
+} // namespace Tiled
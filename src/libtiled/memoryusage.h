@@ -0,0 +1,67 @@
+/*
+ * memoryusage.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "properties.h"
+
+class QPixmap;
+
+namespace Tiled {
+
+class Map;
+class MapObject;
+class Tileset;
+
+/**
+ * An estimate of the memory used by a map or tileset, in bytes.
+ *
+ * The estimates include the main data structures, but not the smaller
+ * per-instance allocations done by Qt, so they are a lower bound.
+ */
+struct TILEDSHARED_EXPORT MemoryUsage
+{
+    qint64 tileLayers = 0;  // the cells of the tile layers
+    qint64 objects = 0;     // map objects, including tile collision shapes
+    qint64 properties = 0;  // custom properties of all objects
+    qint64 images = 0;      // image layers, tileset images and tile images
+    qint64 tiles = 0;       // tile instances and their animation frames
+
+    qint64 total() const
+    { return tileLayers + objects + properties + images + tiles; }
+
+    MemoryUsage &operator+=(const MemoryUsage &other);
+};
+
+TILEDSHARED_EXPORT MemoryUsage memoryUsage(const Map &map);
+TILEDSHARED_EXPORT MemoryUsage memoryUsage(const Tileset &tileset);
+
+TILEDSHARED_EXPORT qint64 memoryUsage(const Properties &properties);
+TILEDSHARED_EXPORT qint64 memoryUsage(const QPixmap &pixmap);
+
+} // namespace Tiled
@@ -35,9 +35,16 @@
 #include "mapobject.h"
 #include "maprenderer.h"
 #include "objectgroup.h"
+#include "pngwriter.h"
+#include "savefile.h"
 #include "tilelayer.h"
+#include "tracing.h"
 
+#include <QCoreApplication>
 #include <QPainter>
+#include <QSemaphore>
+#include <QThread>
+#include <QtConcurrent>
 
 using namespace Tiled;
 
@@ -66,11 +73,6 @@ QImage MiniMapRenderer::render(QSize size, RenderFlags renderFlags) const
     return image;
 }
 
-static bool objectLessThan(const MapObject *a, const MapObject *b)
-{
-    return a->y() < b->y();
-}
-
 static QRectF cellRect(const MapRenderer &renderer,
                        const Cell &cell,
                        const QPointF &tileCoords)
@@ -120,19 +122,8 @@ static void extendMapRect(QRect &mapBoundingRect, const MapRenderer &renderer)
     mapBoundingRect = rect.toAlignedRect();
 }
 
-void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags) const
+QRect MiniMapRenderer::mapBoundingRect(RenderFlags renderFlags) const
 {
-    if (!mMap)
-        return;
-    if (image.isNull())
-        return;
-
-    const bool drawObjects = renderFlags.testFlag(RenderFlag::DrawMapObjects);
-    const bool drawTileLayers = renderFlags.testFlag(RenderFlag::DrawTileLayers);
-    const bool drawImageLayers = renderFlags.testFlag(RenderFlag::DrawImageLayers);
-    const bool drawTileGrid = renderFlags.testFlag(RenderFlag::DrawGrid);
-    const bool visibleLayersOnly = renderFlags.testFlag(RenderFlag::IgnoreInvisibleLayer);
-
     QRect mapBoundingRect = mRenderer->mapBoundingRect();
 
     if (renderFlags.testFlag(IncludeOverhangingTiles))
@@ -141,40 +132,321 @@ void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags) cons
     if (!renderFlags.testFlag(IgnoreOffsetsAndImages))
         mMap->adjustBoundingRectForOffsetsAndImageLayers(mapBoundingRect);
 
-    QSize mapSize = mapBoundingRect.size();
+    return mapBoundingRect;
+}
+
+void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags) const
+{
+    renderToImage(image, renderFlags, nullptr);
+}
+
+/**
+ * Repaints only the parts of \a image that show the given \a mapRegion,
+ * which is given in map pixel coordinates. The \a image is expected to
+ * have been fully rendered before with the same size and flags.
+ */
+void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags,
+                                    const QRegion &mapRegion) const
+{
+    if (!mapRegion.isEmpty())
+        renderToImage(image, renderFlags, &mapRegion);
+}
+
+/**
+ * Returns the transform from map to image coordinates, which scales the map
+ * to fit the image and centers it. Sets \a scale to the applied scale.
+ */
+static QTransform imageTransform(QSize imageSize, const QRect &mapBoundingRect, qreal &scale)
+{
+    const QSize mapSize = mapBoundingRect.size();
 
     // Determine the largest possible scale
-    const qreal scale = qMin(static_cast<qreal>(image.width()) / mapSize.width(),
-                             static_cast<qreal>(image.height()) / mapSize.height());
+    scale = qMin(static_cast<qreal>(imageSize.width()) / mapSize.width(),
+                 static_cast<qreal>(imageSize.height()) / mapSize.height());
+
+    // Center the map in the requested size
+    const QSize scaledMapSize = mapSize * scale;
+    const QPointF centerOffset((imageSize.width() - scaledMapSize.width()) / 2,
+                               (imageSize.height() - scaledMapSize.height()) / 2);
+
+    QTransform transform;
+    transform.translate(centerOffset.x(), centerOffset.y());
+    transform.scale(scale, scale);
+    transform.translate(-mapBoundingRect.x(), -mapBoundingRect.y());
+    return transform;
+}
 
+QColor MiniMapRenderer::backgroundColor(RenderFlags renderFlags) const
+{
     if (renderFlags.testFlag(DrawBackground) && mMap->backgroundColor().isValid())
-        image.fill(mMap->backgroundColor());
-    else
-        image.fill(Qt::transparent);
+        return mMap->backgroundColor();
+    return Qt::transparent;
+}
+
+void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags,
+                                    const QRegion *mapRegion) const
+{
+    if (!mMap)
+        return;
+    if (image.isNull())
+        return;
+
+    const QRect mapBoundingRect = this->mapBoundingRect(renderFlags);
+
+    qreal scale;
+    const QTransform transform = imageTransform(image.size(), mapBoundingRect, scale);
+    const QColor backgroundColor = this->backgroundColor(renderFlags);
 
     QPainter painter(&image);
+
+    // When only repainting a region, clip to the affected image pixels and
+    // limit the tile layers to the tiles that can be visible there
+    QRectF exposed;
+    if (mapRegion) {
+        QRegion imageRegion;
+        for (const QRect &rect : *mapRegion) {
+            // Grow by a pixel to cover the smoothing at the edges
+            imageRegion += transform.mapRect(QRectF(rect)).toAlignedRect()
+                    .adjusted(-1, -1, 1, 1);
+        }
+        imageRegion &= image.rect();
+        if (imageRegion.isEmpty())
+            return;
+
+        painter.setClipRegion(imageRegion);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        for (const QRect &rect : std::as_const(imageRegion))
+            painter.fillRect(rect, backgroundColor);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+        exposed = transform.inverted().mapRect(QRectF(imageRegion.boundingRect()));
+    } else {
+        image.fill(backgroundColor);
+    }
+
     painter.setRenderHints(QPainter::SmoothPixmapTransform, renderFlags.testFlag(SmoothPixmapTransform));
+    painter.setTransform(transform);
 
-    // Center the map in the requested size
-    const QSize scaledMapSize = mapSize * scale;
-    const QPointF centerOffset((image.width() - scaledMapSize.width()) / 2,
-                               (image.height() - scaledMapSize.height()) / 2);
+    mRenderer->setPainterScale(scale);
+
+    drawLayers(painter, renderFlags, exposed);
+    drawOverlays(painter, renderFlags, mapBoundingRect);
+}
+
+/**
+ * Renders the map like renderToImage(), but splits the image into
+ * horizontal bands that are rendered in parallel, each with its own painter.
+ *
+ * The \a progress callback, when set, is called on the calling thread each
+ * time a band has been rendered. When it returns false, the remaining bands
+ * are skipped and this function returns false, leaving the image incomplete.
+ *
+ * The grid and the object labels are drawn on the calling thread once all
+ * bands are done, so the label callback does not need to be thread-safe.
+ */
+bool MiniMapRenderer::renderToImageParallel(QImage &image, RenderFlags renderFlags,
+                                            const ProgressCallback &progress) const
+{
+    TILED_TRACE_SCOPE("MiniMapRenderer::renderToImageParallel");
+
+    if (!mMap)
+        return true;
+    if (image.isNull())
+        return true;
+
+    const QRect mapBoundingRect = this->mapBoundingRect(renderFlags);
+
+    qreal scale;
+    const QTransform transform = imageTransform(image.size(), mapBoundingRect, scale);
+    const QColor backgroundColor = this->backgroundColor(renderFlags);
 
-    painter.translate(centerOffset);
-    painter.scale(scale, scale);
-    painter.translate(-mapBoundingRect.topLeft());
+    // The renderer is shared by the bands, so its scale is set up front
+    mRenderer->setPainterScale(scale);
+
+    if (!drawLayersParallel(image, transform, renderFlags, backgroundColor, progress))
+        return false;
+
+    QPainter painter(&image);
+    painter.setRenderHints(QPainter::SmoothPixmapTransform, renderFlags.testFlag(SmoothPixmapTransform));
+    painter.setTransform(transform);
+
+    drawOverlays(painter, renderFlags, mapBoundingRect);
+    return true;
+}
+
+/**
+ * Renders the map into a PNG file of the given \a size, one strip of rows at
+ * a time. Each strip is rendered like renderToImageParallel() and is then
+ * compressed and written, so memory use is bounded by the strip size rather
+ * than the image size.
+ *
+ * The \a progress callback is called after each strip. When it returns
+ * false, rendering stops and this function returns false without setting
+ * \a error, and the file is left unchanged.
+ */
+bool MiniMapRenderer::renderToPng(const QString &fileName, QSize size,
+                                  RenderFlags renderFlags,
+                                  const ProgressCallback &progress,
+                                  QString *error) const
+{
+    TILED_TRACE_SCOPE("MiniMapRenderer::renderToPng");
+
+    SaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    PngWriter writer(file.device(), size);
+
+    const QRect mapBoundingRect = this->mapBoundingRect(renderFlags);
+
+    qreal scale;
+    const QTransform transform = imageTransform(size, mapBoundingRect, scale);
+    const QColor backgroundColor = this->backgroundColor(renderFlags);
 
     mRenderer->setPainterScale(scale);
 
+    // Limit each strip to about 32 MB
+    const qint64 maximumStripBytes = qint64(32) * 1024 * 1024;
+    const int stripHeight = static_cast<int>(qBound<qint64>(1, maximumStripBytes / (qint64(size.width()) * 4),
+                                                            size.height()));
+
+    for (int top = 0; top < size.height(); top += stripHeight) {
+        QImage strip(size.width(), qMin(stripHeight, size.height() - top),
+                     QImage::Format_ARGB32_Premultiplied);
+        if (strip.isNull()) {
+            if (error)
+                *error = QCoreApplication::translate("MiniMapRenderer", "Out of memory");
+            return false;
+        }
+
+        const QTransform stripTransform = transform * QTransform::fromTranslate(0, -top);
+
+        drawLayersParallel(strip, stripTransform, renderFlags, backgroundColor, ProgressCallback());
+
+        QPainter painter(&strip);
+        painter.setRenderHints(QPainter::SmoothPixmapTransform, renderFlags.testFlag(SmoothPixmapTransform));
+        painter.setTransform(stripTransform);
+        drawOverlays(painter, renderFlags, mapBoundingRect);
+        painter.end();
+
+        if (!writer.writeRows(strip))
+            break;
+
+        if (progress && !progress(top + strip.height(), size.height()))
+            return false;
+    }
+
+    if (!writer.finish()) {
+        if (error)
+            *error = writer.errorString();
+        return false;
+    }
+
+    if (!file.commit()) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Fills \a image with the background color and draws the layers using the
+ * given \a transform, in horizontal bands that are drawn in parallel.
+ *
+ * Returns false when the \a progress callback canceled the rendering.
+ */
+bool MiniMapRenderer::drawLayersParallel(QImage &image, const QTransform &transform,
+                                         RenderFlags renderFlags,
+                                         const QColor &backgroundColor,
+                                         const ProgressCallback &progress) const
+{
+    // Use a few bands per thread, so that bands with a lot of content don't
+    // keep the other threads waiting and the progress is updated regularly
+    const int bandCount = qBound(1, QThread::idealThreadCount() * 4, image.height());
+
+    struct Band
+    {
+        int top;
+        int bottom;
+    };
+
+    QVector<Band> bands;
+    bands.reserve(bandCount);
+    for (int band = 0; band < bandCount; ++band)
+        bands.append(Band { image.height() * band / bandCount,
+                            image.height() * (band + 1) / bandCount });
+
+    // Each band paints directly into its part of the image
+    uchar *bits = image.bits();
+    const qsizetype bytesPerLine = image.bytesPerLine();
+    const int width = image.width();
+    const QImage::Format format = image.format();
+
+    QAtomicInteger<bool> canceled(false);
+    QSemaphore finishedBands;
+
+    QFuture<void> future = QtConcurrent::map(bands, [&] (const Band &band) {
+        if (!canceled.loadRelaxed()) {
+            QImage bandImage(bits + band.top * bytesPerLine,
+                             width, band.bottom - band.top,
+                             bytesPerLine, format);
+            bandImage.fill(backgroundColor);
+
+            const QTransform bandTransform = transform * QTransform::fromTranslate(0, -band.top);
+
+            QPainter painter(&bandImage);
+            painter.setRenderHints(QPainter::SmoothPixmapTransform, renderFlags.testFlag(SmoothPixmapTransform));
+            painter.setTransform(bandTransform);
+
+            drawLayers(painter, renderFlags,
+                       bandTransform.inverted().mapRect(QRectF(bandImage.rect())));
+        }
+
+        finishedBands.release();
+    });
+
+    for (int finished = 1; finished <= bandCount; ++finished) {
+        finishedBands.acquire();
+
+        if (progress && !canceled.loadRelaxed() && !progress(finished, bandCount))
+            canceled.storeRelaxed(true);
+    }
+
+    future.waitForFinished();
+
+    return !canceled.loadRelaxed();
+}
+
+/**
+ * Draws the layers of the map. When \a exposed is not null, the tile layers
+ * are limited to the tiles that can be visible in that part of the map.
+ *
+ * May be called from several threads at once, as long as each uses its own
+ * painter.
+ */
+void MiniMapRenderer::drawLayers(QPainter &painter, RenderFlags renderFlags,
+                                 const QRectF &exposed) const
+{
+    const bool drawObjects = renderFlags.testFlag(RenderFlag::DrawMapObjects);
+    const bool drawTileLayers = renderFlags.testFlag(RenderFlag::DrawTileLayers);
+    const bool drawImageLayers = renderFlags.testFlag(RenderFlag::DrawImageLayers);
+    const bool visibleLayersOnly = renderFlags.testFlag(RenderFlag::IgnoreInvisibleLayer);
+
     LayerIterator iterator(mMap);
     while (const Layer *layer = iterator.next()) {
-        if (visibleLayersOnly && layer->isHidden())
+        const LayerRenderState &state = layer->renderState();
+        if (visibleLayersOnly && state.hidden)
             continue;
 
-        const auto offset = layer->totalOffset();
+        const auto offset = state.totalOffset;
         const auto compositionMode = layer->compositionMode();
 
-        painter.setOpacity(layer->effectiveOpacity());
+        painter.setOpacity(state.opacity);
         painter.translate(offset);
 
         switch (layer->layerType()) {
@@ -183,7 +455,8 @@ void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags) cons
                 painter.setCompositionMode(compositionMode);
 
                 const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
-                mRenderer->drawTileLayer(&painter, tileLayer);
+                mRenderer->drawTileLayer(&painter, tileLayer,
+                                         exposed.isNull() ? exposed : exposed.translated(-offset));
             }
             break;
         }
@@ -191,12 +464,7 @@ void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags) cons
         case Layer::ObjectGroupType: {
             if (drawObjects) {
                 const ObjectGroup *objectGroup = static_cast<const ObjectGroup*>(layer);
-                QList<MapObject*> objects = objectGroup->objects();
-
-                if (objectGroup->drawOrder() == ObjectGroup::TopDownOrder)
-                    std::stable_sort(objects.begin(), objects.end(), objectLessThan);
-
-                for (const MapObject *object : std::as_const(objects)) {
+                for (const MapObject *object : objectGroup->objectsInDrawOrder()) {
                     if (object->isVisible()) {
                         if (object->isTileObject())
                             painter.setCompositionMode(compositionMode);
@@ -237,8 +505,18 @@ void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags) cons
 
         painter.translate(-offset);
     }
+}
+
+/**
+ * Draws the grid and the object labels on top of the layers.
+ */
+void MiniMapRenderer::drawOverlays(QPainter &painter, RenderFlags renderFlags,
+                                   const QRect &mapBoundingRect) const
+{
+    const bool drawObjects = renderFlags.testFlag(RenderFlag::DrawMapObjects);
+    const bool visibleLayersOnly = renderFlags.testFlag(RenderFlag::IgnoreInvisibleLayer);
 
-    if (drawTileGrid)
+    if (renderFlags.testFlag(RenderFlag::DrawGrid))
         mRenderer->drawGrid(&painter, mapBoundingRect, mGridColor);
 
     if (drawObjects && mRenderObjectLabelCallback) {
@@ -33,6 +33,7 @@
 #include "tiled_global.h"
 
 #include <QImage>
+#include <QRegion>
 
 #include <functional>
 #include <memory>
@@ -47,6 +48,7 @@ class TILEDSHARED_EXPORT MiniMapRenderer
 {
 public:
     using RenderObjectLabelCallback = std::function<void(QPainter&, const MapObject*, const MapRenderer&)>;
+    using ProgressCallback = std::function<bool(int finished, int total)>;
 
     enum RenderFlag {
         DrawMapObjects          = 0x0001,
@@ -69,12 +71,34 @@ public:
     void setRenderObjectLabelCallback(const RenderObjectLabelCallback &cb);
 
     QSize mapSize() const;
+    QRect mapBoundingRect(RenderFlags renderFlags) const;
 
     QImage render(QSize size, RenderFlags renderFlags) const;
 
     void renderToImage(QImage &image, RenderFlags renderFlags) const;
+    void renderToImage(QImage &image, RenderFlags renderFlags,
+                       const QRegion &mapRegion) const;
+
+    bool renderToImageParallel(QImage &image, RenderFlags renderFlags,
+                               const ProgressCallback &progress = ProgressCallback()) const;
+
+    bool renderToPng(const QString &fileName, QSize size, RenderFlags renderFlags,
+                     const ProgressCallback &progress = ProgressCallback(),
+                     QString *error = nullptr) const;
 
 private:
+    void renderToImage(QImage &image, RenderFlags renderFlags,
+                       const QRegion *mapRegion) const;
+
+    QColor backgroundColor(RenderFlags renderFlags) const;
+    bool drawLayersParallel(QImage &image, const QTransform &transform,
+                            RenderFlags renderFlags, const QColor &backgroundColor,
+                            const ProgressCallback &progress) const;
+    void drawLayers(QPainter &painter, RenderFlags renderFlags,
+                    const QRectF &exposed) const;
+    void drawOverlays(QPainter &painter, RenderFlags renderFlags,
+                      const QRect &mapBoundingRect) const;
+
     const Map *mMap;
     std::unique_ptr<MapRenderer> mRenderer;
     QColor mGridColor = QColorConstants::Black;
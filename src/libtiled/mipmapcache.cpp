@@ -0,0 +1,258 @@
+/*
+ * mipmapcache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mipmapcache.h"
+
+#include "tileset.h"
+
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPainter>
+
+#include <limits>
+
+using namespace Tiled;
+
+namespace {
+
+struct MipmapKey
+{
+    qint64 pixmapKey;
+    int tileWidth;
+    int tileHeight;
+    int tileSpacing;
+    int margin;
+    int level;
+
+    bool operator==(const MipmapKey &o) const
+    {
+        return pixmapKey == o.pixmapKey &&
+                tileWidth == o.tileWidth &&
+                tileHeight == o.tileHeight &&
+                tileSpacing == o.tileSpacing &&
+                margin == o.margin &&
+                level == o.level;
+    }
+};
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+uint qHash(const MipmapKey &key, uint seed = 0) Q_DECL_NOTHROW
+{
+    auto h = ::qHash(key.pixmapKey, seed);
+    h = ::qHash(key.tileWidth, h);
+    h = ::qHash(key.tileHeight, h);
+    h = ::qHash(key.tileSpacing, h);
+    h = ::qHash(key.margin, h);
+    h = ::qHash(key.level, h);
+    return h;
+}
+#else
+size_t qHash(const MipmapKey &key, size_t seed = 0) Q_DECL_NOTHROW
+{
+    return qHashMulti(seed, key.pixmapKey, key.tileWidth, key.tileHeight,
+                      key.tileSpacing, key.margin, key.level);
+}
+#endif
+
+} // anonymous namespace
+
+// Cache for up to 50 MB of downscaled pixmaps. Entries for replaced tileset
+// images are no longer looked up and get evicted over time.
+static QCache<MipmapKey, QPixmap> mipmapCache { 50 * 1024 };
+static QMutex mipmapCacheMutex;
+
+// Borrowed from qpixmapcache.cpp
+static inline qsizetype cost(const QPixmap &pixmap)
+{
+    // make sure to do a 64bit calculation; qsizetype might be smaller
+    const qint64 costKb = static_cast<qint64>(pixmap.width())
+                        * pixmap.height() * pixmap.depth() / (8 * 1024);
+    const qint64 costMax = std::numeric_limits<qsizetype>::max();
+    // a small pixmap should have at least a cost of 1(kb)
+    return static_cast<qsizetype>(qBound(1LL, costKb, costMax));
+}
+
+static QPixmap createMipmap(const Tileset *tileset, int level)
+{
+    const QImage source = tileset->image().toImage();
+    const int columns = tileset->columnCountForWidth(source.width());
+    const int rows = tileset->rowCountForHeight(source.height());
+    const int width = tileset->tileWidth() >> level;
+    const int height = tileset->tileHeight() >> level;
+
+    QImage result(columns * width, rows * height, QImage::Format_ARGB32_Premultiplied);
+    result.fill(Qt::transparent);
+
+    QPainter painter(&result);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            const QRect tileRect(tileset->margin() + column * (tileset->tileWidth() + tileset->tileSpacing()),
+                                 tileset->margin() + row * (tileset->tileHeight() + tileset->tileSpacing()),
+                                 tileset->tileWidth(),
+                                 tileset->tileHeight());
+
+            painter.drawImage(column * width, row * height,
+                              source.copy(tileRect).scaled(width, height,
+                                                           Qt::IgnoreAspectRatio,
+                                                           Qt::SmoothTransformation));
+        }
+    }
+
+    painter.end();
+
+    return QPixmap::fromImage(std::move(result), Qt::NoOpaqueDetection);
+}
+
+/**
+ * Returns the mipmap level to use for drawing the tiles of \a tileset at
+ * the given \a scale. Level 0 refers to the tileset image itself, while
+ * each further level halves the size of the tiles.
+ *
+ * Only tilesets based on a single image can use mipmaps, and only up to
+ * the level at which the tile size can still be divided evenly.
+ */
+int MipmapCache::levelFor(const Tileset *tileset, qreal scale)
+{
+    if (tileset->isCollection() || tileset->image().isNull())
+        return 0;
+
+    int level = 0;
+    while (scale <= 0.5 && level < MaxLevel) {
+        const int factor = 1 << (level + 1);
+        if (tileset->tileWidth() % factor || tileset->tileHeight() % factor)
+            break;
+
+        scale *= 2;
+        ++level;
+    }
+
+    return level;
+}
+
+/**
+ * Returns the image of \a tileset downscaled to the given mipmap \a level,
+ * creating it when necessary. The tiles in the returned image are laid out
+ * without margin or spacing. Use sourceRect() to find a tile's location.
+ *
+ * This function is thread-safe.
+ */
+QPixmap MipmapCache::mipmap(const Tileset *tileset, int level)
+{
+    if (level <= 0)
+        return tileset->image();
+
+    const MipmapKey key {
+        tileset->image().cacheKey(),
+        tileset->tileWidth(),
+        tileset->tileHeight(),
+        tileset->tileSpacing(),
+        tileset->margin(),
+        level
+    };
+
+    QMutexLocker locker(&mipmapCacheMutex);
+
+    if (auto cached = mipmapCache.object(key))
+        return *cached;
+
+    const QPixmap pixmap = createMipmap(tileset, level);
+    mipmapCache.insert(key, new QPixmap(pixmap), cost(pixmap));
+    return pixmap;
+}
+
+/**
+ * Returns the mipmap level to use for drawing the whole \a pixmap at the
+ * given \a scale. Small images are always drawn directly, since scaling
+ * them while painting is cheap.
+ */
+int MipmapCache::levelFor(const QPixmap &pixmap, qreal scale)
+{
+    // Images smaller than this are not worth caching a downscaled copy
+    constexpr int minimumSize = 512;
+
+    if (pixmap.isNull() || qMax(pixmap.width(), pixmap.height()) < minimumSize)
+        return 0;
+
+    int level = 0;
+    while (scale <= 0.5 && level < MaxLevel) {
+        scale *= 2;
+        ++level;
+    }
+
+    return level;
+}
+
+/**
+ * Returns the \a pixmap downscaled as a whole to the given mipmap \a level,
+ * creating it when necessary. The size is rounded up, so the scale of the
+ * result may be slightly larger than 1 / 2^level.
+ *
+ * This function is thread-safe.
+ */
+QPixmap MipmapCache::mipmap(const QPixmap &pixmap, int level)
+{
+    if (level <= 0 || pixmap.isNull())
+        return pixmap;
+
+    // Zero tile size marks the image as scaled down as a whole
+    const MipmapKey key { pixmap.cacheKey(), 0, 0, 0, 0, level };
+
+    QMutexLocker locker(&mipmapCacheMutex);
+
+    if (auto cached = mipmapCache.object(key))
+        return *cached;
+
+    const int divisor = 1 << level;
+    const QPixmap scaled = pixmap.scaled((pixmap.width() + divisor - 1) / divisor,
+                                         (pixmap.height() + divisor - 1) / divisor,
+                                         Qt::IgnoreAspectRatio,
+                                         Qt::SmoothTransformation);
+
+    mipmapCache.insert(key, new QPixmap(scaled), cost(scaled));
+    return scaled;
+}
+
+/**
+ * Returns the location in the mipmap of the given \a level of the tile
+ * found at \a imageRect in the image of \a tileset.
+ */
+QRect MipmapCache::sourceRect(const Tileset *tileset, const QRect &imageRect, int level)
+{
+    if (level <= 0)
+        return imageRect;
+
+    const int column = (imageRect.x() - tileset->margin()) / (tileset->tileWidth() + tileset->tileSpacing());
+    const int row = (imageRect.y() - tileset->margin()) / (tileset->tileHeight() + tileset->tileSpacing());
+    const int width = tileset->tileWidth() >> level;
+    const int height = tileset->tileHeight() >> level;
+
+    return QRect(column * width, row * height, width, height);
+}
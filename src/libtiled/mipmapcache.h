@@ -0,0 +1,63 @@
+/*
+ * mipmapcache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QPixmap>
+
+namespace Tiled {
+
+class Tileset;
+
+/**
+ * Caches downscaled copies of tileset images, used when drawing tiles
+ * at a small scale.
+ *
+ * Each tile is scaled down on its own, into a tightly packed grid, so that
+ * the pixels of neighboring tiles don't bleed into each other regardless of
+ * the margin and spacing of the tileset.
+ *
+ * Large single images, like those of image layers, can be scaled down as a
+ * whole.
+ */
+class TILEDSHARED_EXPORT MipmapCache
+{
+public:
+    enum { MaxLevel = 4 };
+
+    static int levelFor(const Tileset *tileset, qreal scale);
+    static QPixmap mipmap(const Tileset *tileset, int level);
+    static QRect sourceRect(const Tileset *tileset, const QRect &imageRect, int level);
+
+    static int levelFor(const QPixmap &pixmap, qreal scale);
+    static QPixmap mipmap(const QPixmap &pixmap, int level);
+};
+
+} // namespace Tiled
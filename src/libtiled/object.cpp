@@ -28,6 +28,7 @@
 
 #include "object.h"
 
+#include "map.h"
 #include "mapobject.h"
 #include "tile.h"
 
@@ -40,6 +41,21 @@ Object::~Object()
     delete mEditable;
 }
 
+/**
+ * Sets the class of this object.
+ */
+void Object::setClassName(const QString &className)
+{
+    if (mClassName == className)
+        return;
+
+    mClassName = className;
+
+    if (mTypeId == MapObjectType)
+        if (Map *map = static_cast<MapObject*>(this)->map())
+            map->objectClassNameChanged();
+}
+
 const ClassPropertyType *Object::classType() const
 {
     QString objectClassName = className();
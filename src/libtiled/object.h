@@ -192,12 +192,6 @@ private:
 inline const QString &Object::className() const
 { return mClassName; }
 
-/**
- * Sets the class of this object.
- */
-inline void Object::setClassName(const QString &className)
-{ mClassName = className; }
-
 /**
  * Returns whether this object is stored as part of a tileset.
  */
@@ -35,10 +35,299 @@
 #include "mapobject.h"
 #include "tile.h"
 
+#include <QHash>
+
+#include <algorithm>
 #include <cmath>
 
 using namespace Tiled;
 
+// Object groups with fewer objects are searched linearly
+static constexpr int MinIndexedObjectCount = 256;
+
+// Objects spanning more cells are kept in a separate list
+static constexpr int MaxCellsPerObject = 64;
+
+/**
+ * A uniform grid of buckets used to quickly find the objects near a given
+ * area. Objects are stored in each of the cells touched by their possible
+ * bounds, which are independent of their alignment.
+ *
+ * The index refers to objects by their index in the object group, so it is
+ * dropped when objects are added, removed or reordered.
+ */
+class ObjectGroup::SpatialIndex
+{
+public:
+    explicit SpatialIndex(const QList<MapObject*> &objects);
+
+    void update(const MapObject *object);
+    QVector<int> candidates(const QRectF &rect) const;
+
+private:
+    static QRectF possibleBounds(const MapObject *object);
+    QRect cellRect(const QRectF &bounds) const;
+
+    void insert(int index);
+    void remove(int index);
+
+    qreal mCellSize = 1.0;
+    QVector<QRectF> mBounds;                // indexed like the objects
+    QHash<const MapObject*, int> mIndexOfObject;
+    QHash<QPoint, QVector<int>> mCells;
+    QVector<int> mLargeObjects;
+};
+
+ObjectGroup::SpatialIndex::SpatialIndex(const QList<MapObject*> &objects)
+{
+    mBounds.reserve(objects.size());
+    mIndexOfObject.reserve(objects.size());
+
+    QRectF totalBounds;
+    qreal totalExtent = 0.0;
+
+    for (int i = 0; i < objects.size(); ++i) {
+        const QRectF bounds = possibleBounds(objects.at(i));
+        mBounds.append(bounds);
+        mIndexOfObject.insert(objects.at(i), i);
+        totalBounds |= bounds;
+        totalExtent += std::max(bounds.width(), bounds.height());
+    }
+
+    // Choose cells a bit larger than the average object, but not so small
+    // that most cells would be empty.
+    if (!objects.isEmpty()) {
+        const qreal averageExtent = totalExtent / objects.size();
+        const qreal spacing = std::sqrt(totalBounds.width() * totalBounds.height() / objects.size());
+        mCellSize = std::max({ averageExtent * 2, spacing, qreal(1) });
+    }
+
+    for (int i = 0; i < objects.size(); ++i)
+        insert(i);
+}
+
+void ObjectGroup::SpatialIndex::update(const MapObject *object)
+{
+    const int index = mIndexOfObject.value(object, -1);
+    if (index == -1)
+        return;
+
+    const QRectF bounds = possibleBounds(object);
+    if (bounds == mBounds.at(index))
+        return;
+
+    remove(index);
+    mBounds[index] = bounds;
+    insert(index);
+}
+
+/**
+ * Returns the indexes of the objects that may intersect the given \a rect,
+ * sorted and without duplicates.
+ */
+QVector<int> ObjectGroup::SpatialIndex::candidates(const QRectF &rect) const
+{
+    QVector<int> result = mLargeObjects;
+
+    const QRect cells = cellRect(rect);
+    if (qint64(cells.width()) * cells.height() > mCells.size()) {
+        for (auto it = mCells.begin(); it != mCells.end(); ++it)
+            if (cells.contains(it.key()))
+                result.append(it.value());
+    } else {
+        for (int y = cells.top(); y <= cells.bottom(); ++y) {
+            for (int x = cells.left(); x <= cells.right(); ++x) {
+                auto it = mCells.find(QPoint(x, y));
+                if (it != mCells.end())
+                    result.append(it.value());
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+
+    return result;
+}
+
+/**
+ * Returns the union of the bounds the object can have for any alignment.
+ */
+QRectF ObjectGroup::SpatialIndex::possibleBounds(const MapObject *object)
+{
+    const QRectF bounds = object->bounds().normalized();
+    return bounds.adjusted(-bounds.width(), -bounds.height(), 0, 0);
+}
+
+QRect ObjectGroup::SpatialIndex::cellRect(const QRectF &bounds) const
+{
+    return QRect(QPoint(std::floor(bounds.left() / mCellSize),
+                        std::floor(bounds.top() / mCellSize)),
+                 QPoint(std::floor(bounds.right() / mCellSize),
+                        std::floor(bounds.bottom() / mCellSize)));
+}
+
+void ObjectGroup::SpatialIndex::insert(int index)
+{
+    const QRect cells = cellRect(mBounds.at(index));
+
+    if (qint64(cells.width()) * cells.height() > MaxCellsPerObject) {
+        mLargeObjects.insert(std::lower_bound(mLargeObjects.begin(), mLargeObjects.end(), index), index);
+        return;
+    }
+
+    for (int y = cells.top(); y <= cells.bottom(); ++y)
+        for (int x = cells.left(); x <= cells.right(); ++x)
+            mCells[QPoint(x, y)].append(index);
+}
+
+void ObjectGroup::SpatialIndex::remove(int index)
+{
+    const QRect cells = cellRect(mBounds.at(index));
+
+    if (qint64(cells.width()) * cells.height() > MaxCellsPerObject) {
+        mLargeObjects.removeOne(index);
+        return;
+    }
+
+    for (int y = cells.top(); y <= cells.bottom(); ++y) {
+        for (int x = cells.left(); x <= cells.right(); ++x) {
+            auto it = mCells.find(QPoint(x, y));
+            if (it == mCells.end())
+                continue;
+
+            it->removeOne(index);
+            if (it->isEmpty())
+                mCells.erase(it);
+        }
+    }
+}
+
+/**
+ * Keeps the objects of a top-down object group sorted by the y-coordinate at
+ * which they are displayed, with ties broken by their index. When an object
+ * moves, only that object changes its place in the sorted list.
+ *
+ * Like the spatial index, it refers to objects by their index in the object
+ * group, so it is dropped when objects are added, removed or reordered.
+ */
+class ObjectGroup::DrawOrderIndex
+{
+public:
+    DrawOrderIndex(const QList<MapObject*> &objects, bool isometric);
+
+    bool isIsometric() const { return mIsometric; }
+    const QList<MapObject*> &sortedObjects() const { return mSortedObjects; }
+
+    void update(const MapObject *object);
+    void sort(QList<MapObject*> &objects) const;
+
+private:
+    struct Key
+    {
+        qreal y;
+        int index;
+
+        bool operator<(const Key &other) const
+        { return y < other.y || (y == other.y && index < other.index); }
+    };
+
+    qreal sortY(const MapObject *object) const;
+
+    bool mIsometric;
+    QVector<qreal> mY;                      // indexed like the objects
+    QHash<const MapObject*, int> mIndexOfObject;
+    QVector<Key> mSortedKeys;
+    QList<MapObject*> mSortedObjects;
+};
+
+ObjectGroup::DrawOrderIndex::DrawOrderIndex(const QList<MapObject*> &objects, bool isometric)
+    : mIsometric(isometric)
+{
+    mY.reserve(objects.size());
+    mIndexOfObject.reserve(objects.size());
+    mSortedKeys.reserve(objects.size());
+
+    for (int i = 0; i < objects.size(); ++i) {
+        const qreal y = sortY(objects.at(i));
+        mY.append(y);
+        mIndexOfObject.insert(objects.at(i), i);
+        mSortedKeys.append(Key { y, i });
+    }
+
+    std::sort(mSortedKeys.begin(), mSortedKeys.end());
+
+    mSortedObjects.reserve(objects.size());
+    for (const Key &key : std::as_const(mSortedKeys))
+        mSortedObjects.append(objects.at(key.index));
+}
+
+void ObjectGroup::DrawOrderIndex::update(const MapObject *object)
+{
+    const int index = mIndexOfObject.value(object, -1);
+    if (index == -1)
+        return;
+
+    const qreal y = sortY(object);
+    if (y == mY.at(index))
+        return;
+
+    const Key oldKey { mY.at(index), index };
+    const Key newKey { y, index };
+    mY[index] = y;
+
+    const int from = std::lower_bound(mSortedKeys.begin(), mSortedKeys.end(), oldKey) - mSortedKeys.begin();
+    Q_ASSERT(from < mSortedKeys.size() && mSortedKeys.at(from).index == index);
+
+    // Small moves often don't change the order
+    if ((from == 0 || mSortedKeys.at(from - 1) < newKey) &&
+            (from == mSortedKeys.size() - 1 || newKey < mSortedKeys.at(from + 1))) {
+        mSortedKeys[from] = newKey;
+        return;
+    }
+
+    MapObject *sortedObject = mSortedObjects.takeAt(from);
+    mSortedKeys.remove(from);
+
+    const int to = std::lower_bound(mSortedKeys.begin(), mSortedKeys.end(), newKey) - mSortedKeys.begin();
+    mSortedKeys.insert(to, newKey);
+    mSortedObjects.insert(to, sortedObject);
+}
+
+/**
+ * Sorts the given objects, which need to be part of the object group, in
+ * draw order.
+ */
+void ObjectGroup::DrawOrderIndex::sort(QList<MapObject*> &objects) const
+{
+    QVector<std::pair<Key, MapObject*>> keyed;
+    keyed.reserve(objects.size());
+
+    for (MapObject *object : std::as_const(objects)) {
+        const int index = mIndexOfObject.value(object, -1);
+        Q_ASSERT(index != -1);
+        keyed.append({ Key { mY.value(index), index }, object });
+    }
+
+    std::sort(keyed.begin(), keyed.end(), [] (const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+
+    for (int i = 0; i < keyed.size(); ++i)
+        objects[i] = keyed.at(i).second;
+}
+
+/**
+ * Returns the value by which the object is sorted, which is its
+ * y-coordinate on the screen, up to a constant scale and offset.
+ */
+qreal ObjectGroup::DrawOrderIndex::sortY(const MapObject *object) const
+{
+    if (mIsometric)
+        return object->x() + object->y();
+    return object->y();
+}
+
 ObjectGroup::ObjectGroup(const QString &name)
     : ObjectGroup(name, 0, 0)
 {
@@ -68,8 +357,12 @@ void ObjectGroup::insertObject(int index, MapObject *object)
 {
     mObjects.insert(index, object);
     object->setObjectGroup(this);
-    if (mMap && object->id() == 0)
-        object->setId(mMap->takeNextObjectId());
+    invalidateIndexes();
+    if (mMap) {
+        if (object->id() == 0)
+            object->setId(mMap->takeNextObjectId());
+        mMap->objectAdded(object);
+    }
 }
 
 int ObjectGroup::removeObject(MapObject *object)
@@ -85,7 +378,10 @@ int ObjectGroup::removeObject(MapObject *object)
 void ObjectGroup::removeObjectAt(int index)
 {
     MapObject *object = mObjects.takeAt(index);
+    if (mMap)
+        mMap->objectRemoved(object);
     object->setObjectGroup(nullptr);
+    invalidateIndexes();
 }
 
 void ObjectGroup::moveObjects(int from, int to, int count)
@@ -108,6 +404,8 @@ void ObjectGroup::moveObjects(int from, int to, int count)
 
     for (int i = 0; i < count; ++i)
         mObjects.insert(to + i, movingObjects.at(i));
+
+    invalidateIndexes();
 }
 
 QRectF ObjectGroup::objectsBoundingRect() const
@@ -118,6 +416,103 @@ QRectF ObjectGroup::objectsBoundingRect() const
     return boundingRect;
 }
 
+QList<MapObject*> ObjectGroup::objectsIntersecting(const QRectF &rect) const
+{
+    auto intersects = [&rect] (const MapObject *object) {
+        const QRectF bounds = object->boundsUseTile();
+        if (bounds.isEmpty())
+            return rect.contains(bounds.topLeft());
+        return rect.intersects(bounds);
+    };
+
+    QList<MapObject*> result;
+
+    if (mObjects.size() < MinIndexedObjectCount) {
+        for (MapObject *object : mObjects)
+            if (intersects(object))
+                result.append(object);
+        return result;
+    }
+
+    if (!mSpatialIndex)
+        mSpatialIndex = std::make_unique<SpatialIndex>(mObjects);
+
+    const auto candidates = mSpatialIndex->candidates(rect);
+    for (int index : candidates) {
+        MapObject *object = mObjects.at(index);
+        if (intersects(object))
+            result.append(object);
+    }
+
+    return result;
+}
+
+void ObjectGroup::buildIndexes() const
+{
+    if (mObjects.size() >= MinIndexedObjectCount && !mSpatialIndex)
+        mSpatialIndex = std::make_unique<SpatialIndex>(mObjects);
+
+    if (mDrawOrder == TopDownOrder)
+        drawOrderIndex();
+}
+
+void ObjectGroup::setMap(Map *map)
+{
+    if (mMap == map)
+        return;
+
+    if (mMap)
+        mMap->invalidateObjectIndex();
+
+    Layer::setMap(map);
+
+    if (mMap)
+        mMap->invalidateObjectIndex();
+}
+
+const QList<MapObject*> &ObjectGroup::objectsInDrawOrder() const
+{
+    if (mDrawOrder != TopDownOrder)
+        return mObjects;
+
+    return drawOrderIndex().sortedObjects();
+}
+
+void ObjectGroup::sortByDrawOrder(QList<MapObject*> &objects) const
+{
+    if (mDrawOrder != TopDownOrder)
+        return;
+
+    if (objects.size() < 2)
+        return;
+
+    drawOrderIndex().sort(objects);
+}
+
+const ObjectGroup::DrawOrderIndex &ObjectGroup::drawOrderIndex() const
+{
+    const bool isometric = mMap && mMap->orientation() == Map::Isometric;
+
+    if (!mDrawOrderIndex || mDrawOrderIndex->isIsometric() != isometric)
+        mDrawOrderIndex = std::make_unique<DrawOrderIndex>(mObjects, isometric);
+
+    return *mDrawOrderIndex;
+}
+
+void ObjectGroup::invalidateIndexes()
+{
+    mSpatialIndex.reset();
+    mDrawOrderIndex.reset();
+}
+
+void ObjectGroup::objectBoundsChanged(MapObject *object)
+{
+    if (mSpatialIndex)
+        mSpatialIndex->update(object);
+    if (mDrawOrderIndex)
+        mDrawOrderIndex->update(object);
+}
+
 bool ObjectGroup::isEmpty() const
 {
     return mObjects.isEmpty();
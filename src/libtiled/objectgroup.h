@@ -124,6 +124,50 @@ public:
      */
     QRectF objectsBoundingRect() const;
 
+    /**
+     * Returns the objects whose bounds, taking into account their alignment,
+     * intersect the given \a rect (in pixels). For objects without a size,
+     * returns them when their position is inside the \a rect. The objects are
+     * returned in the same order as in objects().
+     *
+     * On large object groups, this uses a spatial index that is created on
+     * first use. Not thread-safe, even though it is a const function.
+     */
+    QList<MapObject*> objectsIntersecting(const QRectF &rect) const;
+
+    /**
+     * Returns the objects in the order in which they are drawn. For top-down
+     * object groups, they are sorted by the y-coordinate at which they are
+     * displayed, with objects at the same height kept in index order.
+     *
+     * The sorted list is created on first use and kept up to date as objects
+     * move, so only the moved objects are re-sorted. Not thread-safe, even
+     * though it is a const function.
+     */
+    const QList<MapObject*> &objectsInDrawOrder() const;
+
+    /**
+     * Sorts the given \a objects, which need to be part of this object group,
+     * in the order in which they are drawn. For index ordered object groups,
+     * the list is left unchanged.
+     *
+     * Shares the sorted order with objectsInDrawOrder().
+     */
+    void sortByDrawOrder(QList<MapObject*> &objects) const;
+
+    /**
+     * Builds the spatial index and the draw order, which are otherwise
+     * created on first use. Afterwards, the const functions can be used from
+     * multiple threads, as long as the object group is not changed.
+     */
+    void buildIndexes() const;
+
+    /**
+     * Called by MapObject when its position or size changed, to keep the
+     * spatial index and the draw order up to date.
+     */
+    void objectBoundsChanged(MapObject *object);
+
     /**
      * Returns whether this object group contains any objects.
      */
@@ -179,12 +223,22 @@ public:
     QList<MapObject*>::const_iterator end() const { return mObjects.end(); }
 
 protected:
+    void setMap(Map *map) override;
     ObjectGroup *initializeClone(ObjectGroup *clone) const;
 
 private:
+    class SpatialIndex;
+    class DrawOrderIndex;
+
+    const DrawOrderIndex &drawOrderIndex() const;
+    void invalidateIndexes();
+
     QList<MapObject*> mObjects;
     QColor mColor;
     DrawOrder mDrawOrder = TopDownOrder;
+
+    mutable std::unique_ptr<SpatialIndex> mSpatialIndex;
+    mutable std::unique_ptr<DrawOrderIndex> mDrawOrderIndex;
 };
 
 
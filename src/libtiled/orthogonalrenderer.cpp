@@ -33,7 +33,9 @@
 #include "tile.h"
 #include "tilelayer.h"
 #include "objectgroup.h"
+#include "textlayoutcache.h"
 
+#include <QVarLengthArray>
 #include <QtCore/qmath.h>
 
 using namespace Tiled;
@@ -249,24 +251,52 @@ void OrthogonalRenderer::drawGrid(QPainter *painter, const QRectF &rect,
     QPen gridPen, majorGridPen;
     setupGridPens(painter->device(), gridColor, gridPen, majorGridPen, qMin(tileWidth, tileHeight), gridMajor);
 
-    if (startY < endY) {
-        gridPen.setDashOffset(startY * tileHeight);
-        majorGridPen.setDashOffset(startY * tileHeight);
+    if (majorGridPen.color().alpha() <= 0)
+        return;
+
+    // The minor lines fade out when zoomed out, at which point we skip them
+    const bool drawMinorLines = gridPen.color().alpha() > 0;
+
+    QVarLengthArray<QLine, 64> minorLines;
+    QVarLengthArray<QLine, 64> majorLines;
+
+    auto drawLines = [&] (int dashOffset) {
+        if (!minorLines.isEmpty()) {
+            gridPen.setDashOffset(dashOffset);
+            painter->setPen(gridPen);
+            painter->drawLines(minorLines.constData(), minorLines.size());
+            minorLines.clear();
+        }
+        if (!majorLines.isEmpty()) {
+            majorGridPen.setDashOffset(dashOffset);
+            painter->setPen(majorGridPen);
+            painter->drawLines(majorLines.constData(), majorLines.size());
+            majorLines.clear();
+        }
+    };
 
+    if (startY < endY) {
         for (int x = startX; x < endX; ++x) {
-            painter->setPen(gridMajor.width() != 0 && x % gridMajor.width() == 0 ? majorGridPen : gridPen);
-            painter->drawLine(x * tileWidth, startY * tileHeight, x * tileWidth, endY * tileHeight);
+            const QLine line(x * tileWidth, startY * tileHeight, x * tileWidth, endY * tileHeight);
+            if (gridMajor.width() != 0 && x % gridMajor.width() == 0)
+                majorLines.append(line);
+            else if (drawMinorLines)
+                minorLines.append(line);
         }
+
+        drawLines(startY * tileHeight);
     }
 
     if (startX < endX) {
-        gridPen.setDashOffset(startX * tileWidth);
-        majorGridPen.setDashOffset(startX * tileWidth);
-
         for (int y = startY; y < endY; ++y) {
-            painter->setPen(gridMajor.height() != 0 && y % gridMajor.height() == 0 ? majorGridPen : gridPen);
-            painter->drawLine(startX * tileWidth, y * tileHeight, endX * tileWidth, y * tileHeight);
+            const QLine line(startX * tileWidth, y * tileHeight, endX * tileWidth, y * tileHeight);
+            if (gridMajor.height() != 0 && y % gridMajor.height() == 0)
+                majorLines.append(line);
+            else if (drawMinorLines)
+                minorLines.append(line);
         }
+
+        drawLines(startX * tileWidth);
     }
 }
 
@@ -316,29 +346,18 @@ void OrthogonalRenderer::drawTileLayer(const RenderTileCallback &renderTile,
             renderTile(QPoint(x, y), QPointF(x * tileWidth, (y + 1) * tileHeight));
 }
 
-void OrthogonalRenderer::drawTileSelection(QPainter *painter,
-                                           const QRegion &region,
-                                           const QColor &color,
-                                           const QRectF &exposed) const
+QPainterPath OrthogonalRenderer::tileSelectionOutline(const QRegion &region,
+                                                     const QRectF &exposed) const
 {
     QPainterPath path;
 
     for (const QRect &r : region) {
         const QRectF toFill = QRectF(boundingRect(r));
-        if (toFill.intersects(exposed))
+        if (exposed.isNull() || toFill.intersects(exposed))
             path.addRect(toFill);
     }
 
-    QColor penColor(color);
-    penColor.setAlpha(255);
-
-    QPen pen(penColor);
-    pen.setCosmetic(true);
-
-    painter->setPen(pen);
-    painter->setBrush(color);
-    painter->setRenderHint(QPainter::Antialiasing, false);
-    painter->drawPath(path.simplified());
+    return path.simplified();
 }
 
 void OrthogonalRenderer::drawMapObject(QPainter *painter,
@@ -427,7 +446,7 @@ void OrthogonalRenderer::drawMapObject(QPainter *painter,
 
         case MapObject::Polygon:
         case MapObject::Polyline: {
-            const QPolygonF screenPolygon = pixelToScreenCoords(object->polygon());
+            const QPolygonF screenPolygon = pixelToScreenCoords(simplifiedPolygon(object));
             const QPointF pointPos = screenPolygon.isEmpty() ? QPointF()
                                                              : screenPolygon.first();
 
@@ -487,10 +506,7 @@ void OrthogonalRenderer::drawMapObject(QPainter *painter,
         }
 
         case MapObject::Text: {
-            const auto& textData = object->textData();
-            painter->setFont(textData.font);
-            painter->setPen(textData.color);
-            painter->drawText(bounds, textData.text, textData.textOption());
+            TextLayoutCache::drawText(painter, bounds, object->textData());
             break;
         }
         case MapObject::Point: {
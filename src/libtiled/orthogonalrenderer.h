@@ -54,10 +54,8 @@ public:
     void drawTileLayer(const RenderTileCallback &renderTile,
                        const QRectF &exposed) const override;
 
-    void drawTileSelection(QPainter *painter,
-                           const QRegion &region,
-                           const QColor &color,
-                           const QRectF &exposed) const override;
+    QPainterPath tileSelectionOutline(const QRegion &region,
+                                      const QRectF &exposed) const override;
 
     void drawMapObject(QPainter *painter,
                        const MapObject *object,
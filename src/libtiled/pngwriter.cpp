@@ -0,0 +1,404 @@
+/*
+ * pngwriter.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "pngwriter.h"
+
+#include "taskscheduler.h"
+
+#if (defined(Q_OS_WIN) && defined(Q_CC_MSVC)) || defined(Q_OS_WASM)
+#include "QtZlib/zlib.h"
+#else
+#include <zlib.h>
+#endif
+
+#include <QCoreApplication>
+#include <QIODevice>
+#include <QImage>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace Tiled {
+
+static const uchar pngSignature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+static bool writeChunk(QIODevice *device, const char type[4], const uchar *data, uint size)
+{
+    uchar header[8];
+    qToBigEndian<quint32>(size, header);
+    memcpy(header + 4, type, 4);
+
+    uLong crc = crc32(0, header + 4, 4);
+    if (size > 0)
+        crc = crc32(crc, data, size);
+
+    uchar footer[4];
+    qToBigEndian<quint32>(static_cast<quint32>(crc), footer);
+
+    return device->write(reinterpret_cast<const char*>(header), 8) == 8 &&
+            (size == 0 || device->write(reinterpret_cast<const char*>(data), size) == size) &&
+            device->write(reinterpret_cast<const char*>(footer), 4) == 4;
+}
+
+/**
+ * Writes the PNG signature and the header for an 8-bit RGBA image.
+ */
+static bool writeSignatureAndHeader(QIODevice *device, QSize size)
+{
+    if (device->write(reinterpret_cast<const char*>(pngSignature), 8) != 8)
+        return false;
+
+    uchar header[13];
+    qToBigEndian<quint32>(static_cast<quint32>(size.width()), header);
+    qToBigEndian<quint32>(static_cast<quint32>(size.height()), header + 4);
+    header[8] = 8;      // bit depth
+    header[9] = 6;      // color type: RGBA
+    header[10] = 0;     // compression method: deflate
+    header[11] = 0;     // filter method: adaptive
+    header[12] = 0;     // interlace method: none
+
+    return writeChunk(device, "IHDR", header, sizeof(header));
+}
+
+struct PngWriter::Private
+{
+    QIODevice *device;
+    QSize size;
+    int rowsWritten = 0;
+    bool valid = false;
+    bool streamInitialized = false;
+    bool finished = false;
+    QString errorString;
+
+    z_stream zlibStream;
+    std::vector<uchar> previousRow;
+    std::vector<uchar> filteredRow;
+    std::vector<uchar> buffer = std::vector<uchar>(256 * 1024);
+
+    bool writeChunk(const char type[4], const uchar *data, uint size);
+    bool deflate(int flush);
+    void setError(const QString &error);
+};
+
+bool PngWriter::Private::writeChunk(const char type[4], const uchar *data, uint size)
+{
+    if (!Tiled::writeChunk(device, type, data, size)) {
+        setError(device->errorString());
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Compresses the pending input, writing an IDAT chunk each time the output
+ * buffer is full and, when \a flush is Z_FINISH, once for the remainder.
+ */
+bool PngWriter::Private::deflate(int flush)
+{
+    z_stream &strm = zlibStream;
+
+    do {
+        const int ret = ::deflate(&strm, flush);
+        if (ret == Z_STREAM_ERROR) {
+            setError(QCoreApplication::translate("PngWriter", "Compression failed"));
+            return false;
+        }
+
+        const uint size = static_cast<uint>(buffer.size()) - strm.avail_out;
+        if (strm.avail_out == 0 || (flush == Z_FINISH && size > 0)) {
+            if (!writeChunk("IDAT", buffer.data(), size))
+                return false;
+
+            strm.next_out = buffer.data();
+            strm.avail_out = static_cast<uInt>(buffer.size());
+        }
+
+        if (ret == Z_STREAM_END)
+            break;
+    } while (strm.avail_in > 0 || flush == Z_FINISH);
+
+    return true;
+}
+
+void PngWriter::Private::setError(const QString &error)
+{
+    if (errorString.isEmpty())
+        errorString = error;
+    valid = false;
+}
+
+/**
+ * Starts writing a PNG image of the given \a size to \a device, which needs
+ * to be open for writing.
+ */
+PngWriter::PngWriter(QIODevice *device, QSize size)
+    : d(std::make_unique<Private>())
+{
+    d->device = device;
+    d->size = size;
+
+    if (size.isEmpty()) {
+        d->setError(QCoreApplication::translate("PngWriter", "Invalid image size"));
+        return;
+    }
+
+    const size_t rowBytes = static_cast<size_t>(size.width()) * 4;
+    d->previousRow.assign(rowBytes, 0);
+    d->filteredRow.resize(rowBytes + 1);
+
+    z_stream &strm = d->zlibStream;
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.next_out = d->buffer.data();
+    strm.avail_out = static_cast<uInt>(d->buffer.size());
+
+    if (deflateInit(&strm, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        d->setError(QCoreApplication::translate("PngWriter", "Compression failed"));
+        return;
+    }
+
+    d->streamInitialized = true;
+    d->valid = true;
+
+    if (!writeSignatureAndHeader(device, size))
+        d->setError(device->errorString());
+}
+
+PngWriter::~PngWriter()
+{
+    if (d->streamInitialized)
+        deflateEnd(&d->zlibStream);
+}
+
+/**
+ * Appends the rows of the given image, which needs to have the width of the
+ * PNG image. Returns false when writing failed or when this would exceed the
+ * height of the PNG image.
+ */
+bool PngWriter::writeRows(const QImage &rows)
+{
+    if (!d->valid)
+        return false;
+
+    if (rows.width() != d->size.width() || d->rowsWritten + rows.height() > d->size.height()) {
+        d->setError(QCoreApplication::translate("PngWriter", "Rows don't match the image size"));
+        return false;
+    }
+
+    const QImage rgba = rows.convertToFormat(QImage::Format_RGBA8888);
+    const size_t rowBytes = d->previousRow.size();
+
+    for (int y = 0; y < rgba.height(); ++y) {
+        const uchar *row = rgba.constScanLine(y);
+
+        // Use the "Up" filter, which stores the difference with the previous
+        // row and compresses well for typical map images
+        uchar *filtered = d->filteredRow.data();
+        filtered[0] = 2;
+        for (size_t i = 0; i < rowBytes; ++i)
+            filtered[i + 1] = static_cast<uchar>(row[i] - d->previousRow[i]);
+        std::copy(row, row + rowBytes, d->previousRow.begin());
+
+        d->zlibStream.next_in = filtered;
+        d->zlibStream.avail_in = static_cast<uInt>(rowBytes + 1);
+
+        if (!d->deflate(Z_NO_FLUSH))
+            return false;
+    }
+
+    d->rowsWritten += rgba.height();
+    return true;
+}
+
+/**
+ * Finishes the compressed data and writes the end of the image. Returns
+ * false when writing failed or when not all rows have been written.
+ */
+bool PngWriter::finish()
+{
+    if (!d->valid || d->finished)
+        return false;
+
+    if (d->rowsWritten != d->size.height()) {
+        d->setError(QCoreApplication::translate("PngWriter", "Not all rows were written"));
+        return false;
+    }
+
+    d->finished = true;
+
+    return d->deflate(Z_FINISH) && d->writeChunk("IEND", nullptr, 0);
+}
+
+int PngWriter::rowsWritten() const
+{
+    return d->rowsWritten;
+}
+
+QString PngWriter::errorString() const
+{
+    return d->errorString;
+}
+
+
+/**
+ * Returns the compressed image data of the given image, using the same
+ * filter as PngWriter.
+ */
+static QByteArray compressImage(const QImage &image)
+{
+    const QImage rgba = image.convertToFormat(QImage::Format_RGBA8888);
+    const size_t rowBytes = static_cast<size_t>(rgba.width()) * 4;
+
+    std::vector<uchar> filtered((rowBytes + 1) * rgba.height());
+    uchar *out = filtered.data();
+
+    for (int y = 0; y < rgba.height(); ++y) {
+        const uchar *row = rgba.constScanLine(y);
+        const uchar *previousRow = y > 0 ? rgba.constScanLine(y - 1) : nullptr;
+
+        *out++ = 2;     // "Up" filter
+        for (size_t i = 0; i < rowBytes; ++i)
+            *out++ = static_cast<uchar>(row[i] - (previousRow ? previousRow[i] : 0));
+    }
+
+    uLongf compressedSize = compressBound(static_cast<uLong>(filtered.size()));
+    QByteArray compressed(static_cast<int>(compressedSize), Qt::Uninitialized);
+
+    if (compress2(reinterpret_cast<Bytef*>(compressed.data()), &compressedSize,
+                  filtered.data(), static_cast<uLong>(filtered.size()),
+                  Z_DEFAULT_COMPRESSION) != Z_OK) {
+        return QByteArray();
+    }
+
+    compressed.resize(static_cast<int>(compressedSize));
+    return compressed;
+}
+
+/**
+ * Writes the given \a frames as an animated PNG of the given \a size to
+ * \a device, which needs to be open for writing.
+ */
+bool AnimatedPngWriter::write(QIODevice *device, QSize size,
+                              const QVector<Frame> &frames,
+                              QString *error)
+{
+    auto fail = [error] (const QString &message) {
+        if (error)
+            *error = message;
+        return false;
+    };
+
+    if (size.isEmpty() || frames.isEmpty())
+        return fail(QCoreApplication::translate("PngWriter", "Invalid image size"));
+
+    const QRect imageRect(QPoint(), size);
+    for (const Frame &frame : frames) {
+        const QRect frameRect(frame.offset, frame.image.size());
+        if (frameRect.isEmpty() || !imageRect.contains(frameRect))
+            return fail(QCoreApplication::translate("PngWriter", "Frame outside of the image"));
+    }
+    if (frames.first().image.size() != size)
+        return fail(QCoreApplication::translate("PngWriter", "First frame doesn't cover the image"));
+
+    QVector<QByteArray> compressed(frames.size());
+    TaskScheduler::parallelFor(frames.size(), [&] (int index) {
+        compressed[index] = compressImage(frames.at(index).image);
+    });
+
+    for (const QByteArray &data : std::as_const(compressed))
+        if (data.isEmpty())
+            return fail(QCoreApplication::translate("PngWriter", "Compression failed"));
+
+    if (!writeSignatureAndHeader(device, size))
+        return fail(device->errorString());
+
+    uchar animationControl[8];
+    qToBigEndian<quint32>(static_cast<quint32>(frames.size()), animationControl);
+    qToBigEndian<quint32>(0, animationControl + 4);    // loop forever
+
+    if (!writeChunk(device, "acTL", animationControl, sizeof(animationControl)))
+        return fail(device->errorString());
+
+    quint32 sequenceNumber = 0;
+
+    for (int i = 0; i < frames.size(); ++i) {
+        const Frame &frame = frames.at(i);
+
+        // Delays are 16-bit fractions of a second
+        quint16 delayNumerator = static_cast<quint16>(std::min(frame.duration, 65535));
+        quint16 delayDenominator = 1000;
+        if (frame.duration > 65535) {
+            delayNumerator = static_cast<quint16>(std::min(frame.duration / 10, 65535));
+            delayDenominator = 100;
+        }
+
+        uchar frameControl[26];
+        qToBigEndian<quint32>(sequenceNumber++, frameControl);
+        qToBigEndian<quint32>(static_cast<quint32>(frame.image.width()), frameControl + 4);
+        qToBigEndian<quint32>(static_cast<quint32>(frame.image.height()), frameControl + 8);
+        qToBigEndian<quint32>(static_cast<quint32>(frame.offset.x()), frameControl + 12);
+        qToBigEndian<quint32>(static_cast<quint32>(frame.offset.y()), frameControl + 16);
+        qToBigEndian<quint16>(delayNumerator, frameControl + 20);
+        qToBigEndian<quint16>(delayDenominator, frameControl + 22);
+        frameControl[24] = 0;   // dispose op: none
+        frameControl[25] = 0;   // blend op: source
+
+        if (!writeChunk(device, "fcTL", frameControl, sizeof(frameControl)))
+            return fail(device->errorString());
+
+        const QByteArray &data = compressed.at(i);
+
+        if (i == 0) {
+            if (!writeChunk(device, "IDAT", reinterpret_cast<const uchar*>(data.constData()),
+                            static_cast<uint>(data.size()))) {
+                return fail(device->errorString());
+            }
+            continue;
+        }
+
+        QByteArray frameData(4, Qt::Uninitialized);
+        qToBigEndian<quint32>(sequenceNumber++, frameData.data());
+        frameData.append(data);
+
+        if (!writeChunk(device, "fdAT", reinterpret_cast<const uchar*>(frameData.constData()),
+                        static_cast<uint>(frameData.size()))) {
+            return fail(device->errorString());
+        }
+    }
+
+    if (!writeChunk(device, "IEND", nullptr, 0))
+        return fail(device->errorString());
+
+    return true;
+}
+
+} // namespace Tiled
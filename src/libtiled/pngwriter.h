@@ -0,0 +1,92 @@
+/*
+ * pngwriter.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QImage>
+#include <QPoint>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+class QIODevice;
+
+namespace Tiled {
+
+/**
+ * Writes a PNG image to a device row by row, so that images larger than what
+ * fits in a QImage can be written while only holding a few rows in memory.
+ *
+ * The image is written as 8-bit RGBA. Rows are passed in as images of the
+ * same width, and the image is complete once the number of rows given in the
+ * size has been written and finish() was called.
+ */
+class TILEDSHARED_EXPORT PngWriter
+{
+public:
+    PngWriter(QIODevice *device, QSize size);
+    ~PngWriter();
+
+    bool writeRows(const QImage &rows);
+    bool finish();
+
+    int rowsWritten() const;
+    QString errorString() const;
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+/**
+ * Writes an animated PNG (APNG), which loops forever.
+ *
+ * The first frame covers the whole image. Later frames may cover only the
+ * part of the image that changed, which replaces that part of the previous
+ * frame. The frames are compressed in parallel.
+ */
+class TILEDSHARED_EXPORT AnimatedPngWriter
+{
+public:
+    struct Frame
+    {
+        QImage image;
+        QPoint offset;          // of the image within the animation
+        int duration = 0;       // in milliseconds
+    };
+
+    static bool write(QIODevice *device, QSize size,
+                      const QVector<Frame> &frames,
+                      QString *error = nullptr);
+};
+
+} // namespace Tiled
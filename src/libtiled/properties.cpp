@@ -204,6 +204,89 @@ void mergeProperties(Properties &target, const Properties &source)
     target.insert(source);
 }
 
+/**
+ * Returns a string equal to \a name, sharing its storage with any equal
+ * name passed before.
+ */
+QString PropertiesDeduplicator::name(const QString &name)
+{
+    const auto it = mNames.constFind(name);
+    if (it != mNames.constEnd())
+        return *it;
+
+    mNames.insert(name);
+    return name;
+}
+
+static quint64 propertiesHash(const Properties &properties)
+{
+    quint64 hash = properties.size();
+
+    for (auto it = properties.begin(), end = properties.end(); it != end; ++it) {
+        hash = hash * 31 + qHash(it.key());
+        hash = hash * 31 + it.value().userType();
+
+        // Only strings are hashed by value, since other values would first
+        // need to be converted
+        if (it.value().userType() == QMetaType::QString)
+            hash = hash * 31 + qHash(it.value().toString());
+    }
+
+    return hash;
+}
+
+/**
+ * Compares the given sets of properties, including the types of their
+ * values, since QVariant may consider values of different types equal.
+ */
+static bool identicalProperties(const Properties &a, const Properties &b)
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (auto itA = a.begin(), itB = b.begin(), end = a.end(); itA != end; ++itA, ++itB) {
+        if (itA.key() != itB.key() ||
+                itA.value().userType() != itB.value().userType() ||
+                itA.value() != itB.value())
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * Returns a set of properties equal to \a properties, sharing its storage
+ * with any equal set passed before.
+ */
+Properties PropertiesDeduplicator::deduplicate(const Properties &properties)
+{
+    if (properties.isEmpty())
+        return properties;
+
+    // Limits the comparisons for sets that only differ in non-string values
+    constexpr int maxCandidates = 8;
+
+    const quint64 hash = propertiesHash(properties);
+    int candidates = 0;
+
+    for (auto it = mProperties.constFind(hash); it != mProperties.constEnd() && it.key() == hash; ++it) {
+        if (identicalProperties(it.value(), properties))
+            return it.value();
+        ++candidates;
+    }
+
+    if (candidates < maxCandidates)
+        mProperties.insert(hash, properties);
+
+    return properties;
+}
+
+void PropertiesDeduplicator::clear()
+{
+    mNames.clear();
+    mProperties.clear();
+}
+
 QJsonArray propertiesToJson(const Properties &properties, const ExportContext &context)
 {
     QJsonArray json;
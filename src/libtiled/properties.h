@@ -31,7 +31,9 @@
 #include "propertytype.h"
 
 #include <QJsonArray>
+#include <QMultiHash>
 #include <QObject>
+#include <QSet>
 #include <QUrl>
 #include <QVariantMap>
 
@@ -168,6 +170,27 @@ private:
 using Properties = QVariantMap;
 
 
+/**
+ * Reduces the memory used by loaded maps, by letting equal property names
+ * and equal sets of properties share their storage. This is common in maps
+ * with many objects that were created from the same templates.
+ *
+ * Since Properties are implicitly shared, the returned sets are only
+ * detached once they are modified.
+ */
+class TILEDSHARED_EXPORT PropertiesDeduplicator
+{
+public:
+    QString name(const QString &name);
+    Properties deduplicate(const Properties &properties);
+
+    void clear();
+
+private:
+    QSet<QString> mNames;
+    QMultiHash<quint64, Properties> mProperties;
+};
+
 /**
  * Collection of properties with information about the consistency of their
  * presence and value over several property collections.
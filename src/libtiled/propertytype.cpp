@@ -519,6 +519,8 @@ void PropertyTypes::merge(PropertyTypes typesToMerge)
         }
     }
 
+    updateIndex();
+
     // Update the type IDs for the class members
     for (auto classType : std::as_const(classesToProcess)) {
         QMutableMapIterator<QString, QVariant> it(classType->members);
@@ -563,6 +565,8 @@ void PropertyTypes::mergeObjectTypes(const QVector<ObjectType> &objectTypes)
             add(SharedPropertyType(propertyType.release()));
         }
     }
+
+    updateIndex();
 }
 
 /**
@@ -581,16 +585,35 @@ int PropertyTypes::findIndexByName(const QString &name) const
     return -1;
 }
 
+/**
+ * Rebuilds the index used for looking up types by ID and by name. Needs to
+ * be called after changing the name of a type.
+ */
+void PropertyTypes::updateIndex()
+{
+    mTypesById.clear();
+    mTypesByName.clear();
+
+    for (const SharedPropertyType &type : std::as_const(mTypes))
+        addToIndex(type.data());
+}
+
+void PropertyTypes::addToIndex(const PropertyType *type)
+{
+    // In case of duplicate IDs, the first type is found, as before
+    if (!mTypesById.contains(type->id))
+        mTypesById.insert(type->id, type);
+
+    mTypesByName[type->name].append(type);
+}
+
 /**
  * Returns a pointer to the PropertyType matching the given \a typeId, or
  * nullptr if it can't be found.
  */
 const PropertyType *PropertyTypes::findTypeById(int typeId) const
 {
-    auto it = std::find_if(begin(), end(), [&] (const SharedPropertyType &type) {
-        return type->id == typeId;
-    });
-    return it == end() ? nullptr : it->data();
+    return mTypesById.value(typeId);
 }
 
 /**
@@ -602,10 +625,15 @@ const PropertyType *PropertyTypes::findTypeByName(const QString &name, int usage
     if (name.isEmpty())
         return nullptr;
 
-    auto it = std::find_if(begin(), end(), [&] (const SharedPropertyType &type) {
-        return type->name == name && (typeUsageFlags(*type) & usageFlags) != 0;
-    });
-    return it == end() ? nullptr : it->data();
+    const auto it = mTypesByName.constFind(name);
+    if (it == mTypesByName.constEnd())
+        return nullptr;
+
+    for (const PropertyType *type : *it)
+        if ((typeUsageFlags(*type) & usageFlags) != 0)
+            return type;
+
+    return nullptr;
 }
 
 const PropertyType *PropertyTypes::findPropertyValueType(const QString &name) const
@@ -618,10 +646,15 @@ const ClassPropertyType *PropertyTypes::findClassFor(const QString &name, const
     if (name.isEmpty())
         return nullptr;
 
-    auto it = std::find_if(begin(), end(), [&] (const SharedPropertyType &type) {
-        return type->name == name && type->isClass() && static_cast<const ClassPropertyType&>(*type).isClassFor(object);
-    });
-    return static_cast<const ClassPropertyType*>(it == end() ? nullptr : it->data());
+    const auto it = mTypesByName.constFind(name);
+    if (it == mTypesByName.constEnd())
+        return nullptr;
+
+    for (const PropertyType *type : *it)
+        if (type->isClass() && static_cast<const ClassPropertyType&>(*type).isClassFor(object))
+            return static_cast<const ClassPropertyType*>(type);
+
+    return nullptr;
 }
 
 PropertyType *PropertyTypes::findTypeByNamePriv(const QString &name, int usageFlags)
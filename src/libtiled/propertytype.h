@@ -29,6 +29,7 @@
 #pragma once
 
 #include <QColor>
+#include <QHash>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QMetaType>
@@ -205,6 +206,8 @@ public:
 
     int findIndexByName(const QString &name) const;
 
+    void updateIndex();
+
     const PropertyType *findTypeById(int typeId) const;
     const PropertyType *findTypeByName(const QString &name, int usageFlags = ClassPropertyType::AnyUsage) const;
     const PropertyType *findPropertyValueType(const QString &name) const;
@@ -231,8 +234,14 @@ private:
     PropertyType *findTypeByNamePriv(const QString &name, int usageFlags = ClassPropertyType::AnyUsage);
     PropertyType *findPropertyValueTypePriv(const QString &name);
 
+    void addToIndex(const PropertyType *type);
+
     Types mTypes;
     int mNextId = 0;
+
+    // Speeds up looking up the types by ID and by name
+    QHash<int, const PropertyType*> mTypesById;
+    QHash<QString, QVector<const PropertyType*>> mTypesByName;
 };
 
 inline PropertyType &PropertyTypes::add(const SharedPropertyType &type)
@@ -243,12 +252,15 @@ inline PropertyType &PropertyTypes::add(const SharedPropertyType &type)
         mNextId = std::max(mNextId, type->id);
 
     mTypes.append(type);
+    addToIndex(type.data());
     return *mTypes.last();
 }
 
 inline void PropertyTypes::clear()
 {
     mTypes.clear();
+    mTypesById.clear();
+    mTypesByName.clear();
 }
 
 inline size_t PropertyTypes::count() const
@@ -259,11 +271,14 @@ inline size_t PropertyTypes::count() const
 inline void PropertyTypes::removeAt(int index)
 {
     mTypes.removeAt(index);
+    updateIndex();
 }
 
 inline SharedPropertyType PropertyTypes::takeAt(int index)
 {
-    return mTypes.takeAt(index);
+    SharedPropertyType type = mTypes.takeAt(index);
+    updateIndex();
+    return type;
 }
 
 inline PropertyType &PropertyTypes::typeAt(int index)
@@ -274,6 +289,7 @@ inline PropertyType &PropertyTypes::typeAt(int index)
 inline void PropertyTypes::moveType(int from, int to)
 {
     mTypes.move(from, to);
+    updateIndex();
 }
 
 using SharedPropertyTypes = QSharedPointer<PropertyTypes>;
@@ -0,0 +1,237 @@
+/*
+ * taskscheduler.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "taskscheduler.h"
+
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <deque>
+
+using namespace Tiled;
+
+// Priorities of the tasks in the QThreadPool queue
+static constexpr int BackgroundPoolPriority = 0;
+static constexpr int ForegroundPoolPriority = 1;
+static constexpr int InteractivePoolPriority = 2;
+
+// Chunks per thread used by parallelFor
+static constexpr int ChunksPerThread = 4;
+
+static QThreadPool *threadPool()
+{
+    return QThreadPool::globalInstance();
+}
+
+namespace {
+
+/**
+ * The background tasks waiting for a thread. They are kept out of the
+ * QThreadPool queue, so that they can't take all threads.
+ */
+struct BackgroundQueue
+{
+    QMutex mutex;
+    QWaitCondition idle;
+    std::deque<std::function<void()>> tasks;
+    int running = 0;
+
+    void startTasks();
+    void taskFinished();
+};
+
+} // anonymous namespace
+
+Q_GLOBAL_STATIC(BackgroundQueue, backgroundQueue)
+
+/**
+ * Starts queued tasks while the limit allows. Needs to be called with the
+ * mutex locked.
+ */
+void BackgroundQueue::startTasks()
+{
+    const int maxRunning = std::max(1, TaskScheduler::threadCount() / 2);
+
+    while (running < maxRunning && !tasks.empty()) {
+        std::function<void()> task = std::move(tasks.front());
+        tasks.pop_front();
+        ++running;
+
+        threadPool()->start([this, task = std::move(task)] {
+            task();
+            taskFinished();
+        }, BackgroundPoolPriority);
+    }
+}
+
+void BackgroundQueue::taskFinished()
+{
+    QMutexLocker locker(&mutex);
+    --running;
+    startTasks();
+
+    if (running == 0)
+        idle.wakeAll();
+}
+
+
+CancellationToken::CancellationToken()
+    : mCanceled(std::make_shared<std::atomic<bool>>(false))
+{
+}
+
+void CancellationToken::cancel()
+{
+    mCanceled->store(true, std::memory_order_relaxed);
+}
+
+bool CancellationToken::isCanceled() const
+{
+    return mCanceled->load(std::memory_order_relaxed);
+}
+
+
+int TaskScheduler::threadCount()
+{
+    return threadPool()->maxThreadCount();
+}
+
+void TaskScheduler::setThreadCount(int count)
+{
+    if (count <= 0)
+        count = QThread::idealThreadCount();
+
+    threadPool()->setMaxThreadCount(count);
+
+    // More background tasks may run now
+    BackgroundQueue *queue = backgroundQueue();
+    QMutexLocker locker(&queue->mutex);
+    queue->startTasks();
+}
+
+void TaskScheduler::start(std::function<void()> task,
+                          Priority priority,
+                          const CancellationToken &token)
+{
+    auto run = [task = std::move(task), token] {
+        if (!token.isCanceled())
+            task();
+    };
+
+    switch (priority) {
+    case Background: {
+        BackgroundQueue *queue = backgroundQueue();
+        QMutexLocker locker(&queue->mutex);
+        queue->tasks.push_back(std::move(run));
+        queue->startTasks();
+        break;
+    }
+    case Foreground:
+        threadPool()->start(std::move(run), ForegroundPoolPriority);
+        break;
+    case Interactive:
+        threadPool()->start(std::move(run), InteractivePoolPriority);
+        break;
+    }
+}
+
+void TaskScheduler::parallelFor(int count,
+                                const std::function<void(int)> &function,
+                                const CancellationToken &token)
+{
+    const int threads = threadCount();
+
+    if (count <= 1 || threads <= 1) {
+        for (int index = 0; index < count && !token.isCanceled(); ++index)
+            function(index);
+        return;
+    }
+
+    struct State
+    {
+        const std::function<void(int)> *function;
+        CancellationToken token;
+        int count;
+        int chunkCount;
+        std::atomic<int> nextChunk { 0 };
+        std::atomic<int> pendingChunks;
+        QMutex mutex;
+        QWaitCondition done;
+    };
+
+    auto state = std::make_shared<State>();
+    state->function = &function;
+    state->token = token;
+    state->count = count;
+    state->chunkCount = std::min(count, threads * ChunksPerThread);
+    state->pendingChunks = state->chunkCount;
+
+    // Helpers that start only after all chunks were taken return right
+    // away, without touching the function, which may be gone by then.
+    auto runChunks = [state] {
+        int chunk;
+        while ((chunk = state->nextChunk++) < state->chunkCount) {
+            if (!state->token.isCanceled()) {
+                const int begin = int(qint64(chunk) * state->count / state->chunkCount);
+                const int end = int(qint64(chunk + 1) * state->count / state->chunkCount);
+                for (int index = begin; index < end; ++index)
+                    (*state->function)(index);
+            }
+
+            if (--state->pendingChunks == 0) {
+                QMutexLocker locker(&state->mutex);
+                state->done.wakeAll();
+            }
+        }
+    };
+
+    const int helperCount = std::min(threads, state->chunkCount) - 1;
+    for (int i = 0; i < helperCount; ++i)
+        threadPool()->start(runChunks, InteractivePoolPriority);
+
+    runChunks();
+
+    QMutexLocker locker(&state->mutex);
+    while (state->pendingChunks > 0)
+        state->done.wait(&state->mutex);
+}
+
+void TaskScheduler::waitForDone()
+{
+    BackgroundQueue *queue = backgroundQueue();
+    {
+        QMutexLocker locker(&queue->mutex);
+        while (queue->running > 0 || !queue->tasks.empty())
+            queue->idle.wait(&queue->mutex);
+    }
+
+    threadPool()->waitForDone();
+}
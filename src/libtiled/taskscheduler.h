@@ -0,0 +1,134 @@
+/*
+ * taskscheduler.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace Tiled {
+
+/**
+ * A handle through which running or queued tasks can be asked to stop.
+ * Copies share the same state, so a token can be handed to a task while the
+ * owner keeps a copy to cancel it.
+ */
+class TILEDSHARED_EXPORT CancellationToken
+{
+public:
+    CancellationToken();
+
+    void cancel();
+    bool isCanceled() const;
+
+private:
+    std::shared_ptr<std::atomic<bool>> mCanceled;
+};
+
+/**
+ * Runs work on the shared worker threads, taking into account how urgently
+ * it is needed.
+ *
+ * The scheduler uses the global QThreadPool, so that the thread count also
+ * applies to code using QtConcurrent directly:
+ *
+ * - Interactive work is something the user is waiting for, like applying a
+ *   brush or automapping. Its tasks are queued ahead of any other work.
+ * - Foreground work is needed for what is currently displayed, like loading
+ *   tileset images.
+ * - Background work, like indexing or autosaving, never occupies more than
+ *   half of the threads, so that it doesn't delay other work.
+ */
+class TILEDSHARED_EXPORT TaskScheduler
+{
+public:
+    enum Priority {
+        Background,
+        Foreground,
+        Interactive
+    };
+
+    /**
+     * Returns the number of worker threads.
+     */
+    static int threadCount();
+
+    /**
+     * Sets the number of worker threads. A \a count of 0 uses one thread for
+     * each processor core.
+     */
+    static void setThreadCount(int count);
+
+    /**
+     * Runs \a task on a worker thread. The task is skipped when \a token is
+     * canceled before it starts. Long running tasks should also check the
+     * token while running.
+     */
+    static void start(std::function<void()> task,
+                      Priority priority = Foreground,
+                      const CancellationToken &token = CancellationToken());
+
+    /**
+     * Calls \a function for each index from 0 to \a count in parallel, and
+     * returns once all calls are done. The calling thread takes part in the
+     * work, so this may also be used from within a task.
+     *
+     * The range is split into more chunks than there are threads, which are
+     * picked up by the threads as they become idle. When \a token is
+     * canceled, the chunks that did not start yet are skipped.
+     */
+    static void parallelFor(int count,
+                            const std::function<void(int)> &function,
+                            const CancellationToken &token = CancellationToken());
+
+    /**
+     * Convenience function that calls \a function for each element in the
+     * range from \a begin to \a end in parallel.
+     *
+     * \sa parallelFor()
+     */
+    template<typename Iterator, typename Function>
+    static void blockingMap(Iterator begin, Iterator end, Function function,
+                            const CancellationToken &token = CancellationToken())
+    {
+        parallelFor(static_cast<int>(end - begin), [&] (int index) {
+            function(begin[index]);
+        }, token);
+    }
+
+    /**
+     * Waits until all started tasks, including the queued background tasks,
+     * have finished.
+     */
+    static void waitForDone();
+};
+
+} // namespace Tiled
@@ -26,9 +26,16 @@
 #include "objecttemplate.h"
 #include "objecttemplateformat.h"
 #include "logginginterface.h"
+#include "mapreader.h"
+#include "tmxmapformat.h"
 
+#include <QBuffer>
 #include <QFile>
 #include <QFileInfo>
+#include <QSet>
+#include <QtConcurrent>
+
+#include <vector>
 
 using namespace Tiled;
 
@@ -65,22 +72,98 @@ ObjectTemplate *TemplateManager::loadObjectTemplate(const QString &fileName, QSt
 {
     ObjectTemplate *objectTemplate = findObjectTemplate(fileName);
 
-    if (!objectTemplate) {
-        auto newTemplate = readObjectTemplate(fileName, error);
+    if (!objectTemplate)
+        objectTemplate = addObjectTemplate(fileName, readObjectTemplate(fileName, error));
 
-        // This instance will not have an object. It is used to detect broken
-        // template references.
-        if (!newTemplate)
-            newTemplate = std::make_unique<ObjectTemplate>(fileName);
+    return objectTemplate;
+}
 
-        // Watch the file, regardless of whether the parse was successful.
-        mWatcher->addPath(fileName);
+/**
+ * Loads the templates with the given file names, skipping the ones that are
+ * already loaded.
+ *
+ * The files are read in parallel, which saves a lot of time when they live
+ * on a slow (network) drive. Parsing happens on the calling thread, since
+ * templates may refer to tilesets that need to be loaded as well.
+ *
+ * Files that can't be read are ignored rather than registered as broken
+ * templates, since the given list may come from an imprecise scan.
+ */
+void TemplateManager::loadObjectTemplates(const QStringList &fileNames)
+{
+    struct PendingTemplate {
+        QString fileName;
+        QByteArray data;
+        bool read = false;
+    };
 
-        objectTemplate = newTemplate.get();
-        mObjectTemplates.insert(fileName, newTemplate.release());
+    std::vector<PendingTemplate> pending;
+    QSet<QString> seen;
+
+    for (const QString &fileName : fileNames) {
+        if (mObjectTemplates.contains(fileName) || seen.contains(fileName))
+            continue;
+
+        seen.insert(fileName);
+        pending.push_back(PendingTemplate { fileName, QByteArray(), false });
     }
 
-    return objectTemplate;
+    if (pending.empty())
+        return;
+
+    QtConcurrent::blockingMap(pending, [] (PendingTemplate &t) {
+        QFile file(t.fileName);
+        if (file.open(QFile::ReadOnly)) {
+            t.data = file.readAll();
+            t.read = true;
+        }
+    });
+
+    for (PendingTemplate &t : pending) {
+        if (!t.read)
+            continue;
+
+        ObjectTemplateFormat *format = findSupportingTemplateFormat(t.fileName);
+        if (!format)
+            continue;
+
+        std::unique_ptr<ObjectTemplate> newTemplate;
+
+        if (qobject_cast<XmlObjectTemplateFormat*>(format)) {
+            // Parse from the data we already read
+            QBuffer buffer(&t.data);
+            buffer.open(QBuffer::ReadOnly | QBuffer::Text);
+
+            MapReader reader;
+            newTemplate = reader.readObjectTemplate(&buffer, QFileInfo(t.fileName).absolutePath());
+            if (newTemplate) {
+                newTemplate->setFileName(t.fileName);
+                newTemplate->setFormat(format->shortName());
+            }
+        } else {
+            // Other formats read the file themselves, though it will likely
+            // still be in the OS cache
+            newTemplate = readObjectTemplate(t.fileName);
+        }
+
+        addObjectTemplate(t.fileName, std::move(newTemplate));
+    }
+}
+
+ObjectTemplate *TemplateManager::addObjectTemplate(const QString &fileName,
+                                                   std::unique_ptr<ObjectTemplate> objectTemplate)
+{
+    // This instance will not have an object. It is used to detect broken
+    // template references.
+    if (!objectTemplate)
+        objectTemplate = std::make_unique<ObjectTemplate>(fileName);
+
+    // Watch the file, regardless of whether the parse was successful.
+    mWatcher->addPath(fileName);
+
+    ObjectTemplate *result = objectTemplate.get();
+    mObjectTemplates.insert(fileName, objectTemplate.release());
+    return result;
 }
 
 void TemplateManager::pathsChanged(const QStringList &paths)
@@ -27,6 +27,8 @@
 #include <QHash>
 #include <QObject>
 
+#include <memory>
+
 namespace Tiled {
 
 class ObjectTemplate;
@@ -42,6 +44,7 @@ public:
     ObjectTemplate *findObjectTemplate(const QString &fileName);
     ObjectTemplate *loadObjectTemplate(const QString &fileName,
                                        QString *error = nullptr);
+    void loadObjectTemplates(const QStringList &fileNames);
 
 signals:
     /**
@@ -58,6 +61,8 @@ private:
     TemplateManager(QObject *parent = nullptr);
     ~TemplateManager() override;
 
+    ObjectTemplate *addObjectTemplate(const QString &fileName,
+                                      std::unique_ptr<ObjectTemplate> objectTemplate);
     void pathsChanged(const QStringList &paths);
 
     QHash<QString, ObjectTemplate*> mObjectTemplates;
@@ -0,0 +1,210 @@
+/*
+ * textlayoutcache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "textlayoutcache.h"
+
+#include "mapobject.h"
+
+#include <QCache>
+#include <QCoreApplication>
+#include <QPainter>
+#include <QStaticText>
+#include <QThread>
+
+#include <memory>
+
+using namespace Tiled;
+
+namespace {
+
+struct TextLayoutKey
+{
+    QString text;
+    QString font;
+    qreal width;
+    int flags;
+
+    bool operator==(const TextLayoutKey &o) const
+    {
+        return width == o.width &&
+                flags == o.flags &&
+                text == o.text &&
+                font == o.font;
+    }
+};
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+uint qHash(const TextLayoutKey &key, uint seed = 0) Q_DECL_NOTHROW
+{
+    auto h = ::qHash(key.text, seed);
+    h = ::qHash(key.font, h);
+    h = ::qHash(key.width, h);
+    h = ::qHash(key.flags, h);
+    return h;
+}
+#else
+size_t qHash(const TextLayoutKey &key, size_t seed = 0) Q_DECL_NOTHROW
+{
+    return qHashMulti(seed, key.text, key.font, key.width, key.flags);
+}
+#endif
+
+} // anonymous namespace
+
+using TextLayouts = QCache<TextLayoutKey, QStaticText>;
+
+// Created on first use and destroyed along with the application
+static std::unique_ptr<TextLayouts> textLayouts;
+static TextLayoutCache::Statistics textLayoutCacheStatistics;
+
+/**
+ * Laid out text refers to font engines, which are owned by the application,
+ * so the cache can't outlive it as a static object would.
+ */
+static void destroyTextLayouts()
+{
+    textLayouts.reset();
+}
+
+// A rough estimate of the memory used by the glyphs of a laid out text
+static inline qsizetype cost(const QString &text)
+{
+    return 256 + static_cast<qsizetype>(text.size()) * 64;
+}
+
+/**
+ * QStaticText shares its layout between copies and updates it when drawn
+ * with a different transform, so the cache may only be used by one thread.
+ */
+static bool canUseCache()
+{
+    const auto app = QCoreApplication::instance();
+    return app && !QCoreApplication::closingDown() && app->thread() == QThread::currentThread();
+}
+
+/**
+ * Returns the cache, creating it when needed. Can only be called when
+ * canUseCache() returned true.
+ */
+static TextLayouts &textLayoutCache()
+{
+    if (!textLayouts) {
+        // Cache for up to about 8 MB of laid out text
+        textLayouts = std::make_unique<TextLayouts>(8 * 1024 * 1024);
+        qAddPostRoutine(destroyTextLayouts);
+    }
+    return *textLayouts;
+}
+
+/**
+ * Draws the text of a text object within \a bounds, like
+ * QPainter::drawText(const QRectF &, const QString &, const QTextOption &)
+ * but re-using the text layout from previous calls when possible.
+ *
+ * Sets the font and pen of the \a painter.
+ */
+void TextLayoutCache::drawText(QPainter *painter,
+                               const QRectF &bounds,
+                               const TextData &textData)
+{
+    painter->setFont(textData.font);
+    painter->setPen(textData.color);
+
+    if (!canUseCache()) {
+        painter->drawText(bounds, textData.text, textData.textOption());
+        return;
+    }
+
+    const TextLayoutKey key {
+        textData.text,
+        textData.font.key(),
+        bounds.width(),
+        textData.flags()
+    };
+
+    TextLayouts &cache = textLayoutCache();
+    QStaticText *staticText = cache.object(key);
+    if (staticText) {
+        ++textLayoutCacheStatistics.hits;
+    } else {
+        ++textLayoutCacheStatistics.misses;
+
+        staticText = new QStaticText(textData.text);
+        staticText->setTextFormat(Qt::PlainText);
+        staticText->setTextOption(textData.textOption());
+        staticText->setTextWidth(bounds.width());
+        staticText->setPerformanceHint(QStaticText::AggressiveCaching);
+        staticText->prepare(painter->transform(), textData.font);
+
+        if (!cache.insert(key, staticText, cost(textData.text))) {
+            painter->drawText(bounds, textData.text, textData.textOption());
+            return;
+        }
+    }
+
+    // QStaticText only handles the horizontal alignment
+    const QSizeF size = staticText->size();
+    QPointF topLeft = bounds.topLeft();
+    if (textData.alignment & Qt::AlignBottom)
+        topLeft.ry() += bounds.height() - size.height();
+    else if (textData.alignment & Qt::AlignVCenter)
+        topLeft.ry() += (bounds.height() - size.height()) / 2;
+
+    // Clip overflowing text, like QPainter::drawText does
+    const bool clip = size.width() > bounds.width() ||
+            size.height() > bounds.height();
+
+    if (clip) {
+        painter->save();
+        painter->setClipRect(bounds, Qt::IntersectClip);
+    }
+
+    painter->drawStaticText(topLeft, *staticText);
+
+    if (clip)
+        painter->restore();
+}
+
+/**
+ * Removes all text layouts from the cache.
+ */
+void TextLayoutCache::clear()
+{
+    if (textLayouts)
+        textLayouts->clear();
+}
+
+TextLayoutCache::Statistics TextLayoutCache::statistics()
+{
+    return textLayoutCacheStatistics;
+}
+
+void TextLayoutCache::resetStatistics()
+{
+    textLayoutCacheStatistics = Statistics();
+}
@@ -0,0 +1,68 @@
+/*
+ * textlayoutcache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QtGlobal>
+
+class QPainter;
+class QRectF;
+
+namespace Tiled {
+
+struct TextData;
+
+/**
+ * Caches the layout of the text of text objects, so that it does not need
+ * to be laid out again each time the object is painted.
+ *
+ * The cache is shared by all renderers and limited to a fixed memory budget.
+ * It is only used from the thread of the application, and is destroyed
+ * along with the application.
+ */
+class TILEDSHARED_EXPORT TextLayoutCache
+{
+public:
+    struct Statistics
+    {
+        qint64 hits = 0;
+        qint64 misses = 0;
+    };
+
+    static void drawText(QPainter *painter,
+                         const QRectF &bounds,
+                         const TextData &textData);
+
+    static void clear();
+
+    static Statistics statistics();
+    static void resetStatistics();
+};
+
+} // namespace Tiled
@@ -123,6 +123,51 @@ void Tile::setImage(const QPixmap &image)
     mImage = image;
     mImageStatus = image.isNull() ? LoadingError : LoadingReady;
     mImageShape.reset();
+    mAverageColorKey = 0;
+    mAverageColor = 0;
+}
+
+/**
+ * Returns the average color of this tile's image, unpremultiplied. Used to
+ * draw the tile when it is too small for its image to be recognizable.
+ *
+ * The color is cached until the image or the image rect changes. This
+ * function is thread-safe, as long as the image isn't changed meanwhile.
+ */
+QRgb Tile::averageColor() const
+{
+    const QPixmap &pixmap = image();
+    const qint64 key = pixmap.cacheKey();
+
+    // A null pixmap has a cache key of 0, matching the initial transparent color
+    if (mAverageColorKey.load(std::memory_order_acquire) == key)
+        return mAverageColor.load(std::memory_order_relaxed);
+
+    const QImage tileImage = pixmap.copy(mImageRect).toImage()
+            .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    quint64 red = 0, green = 0, blue = 0, alpha = 0;
+    for (int y = 0; y < tileImage.height(); ++y) {
+        auto line = reinterpret_cast<const QRgb*>(tileImage.constScanLine(y));
+        for (int x = 0; x < tileImage.width(); ++x) {
+            red += qRed(line[x]);
+            green += qGreen(line[x]);
+            blue += qBlue(line[x]);
+            alpha += qAlpha(line[x]);
+        }
+    }
+
+    QRgb color = 0;
+    if (const quint64 count = quint64(tileImage.width()) * tileImage.height()) {
+        color = qUnpremultiply(qRgba(int(red / count),
+                                     int(green / count),
+                                     int(blue / count),
+                                     int(alpha / count)));
+    }
+
+    mAverageColor.store(color, std::memory_order_relaxed);
+    mAverageColorKey.store(key, std::memory_order_release);
+    return color;
 }
 
 /**
@@ -147,6 +192,8 @@ void Tile::setImageRect(const QRect &imageRect)
 
     mImageRect = imageRect;
     mImageShape.reset();
+    mAverageColorKey = 0;
+    mAverageColor = 0;
 }
 
 /**
@@ -182,6 +229,12 @@ void Tile::swapObjectGroup(std::unique_ptr<ObjectGroup> &objectGroup)
     std::swap(mObjectGroup, objectGroup);
 }
 
+void Tile::setImageSource(const QUrl &imageSource)
+{
+    mImageSource = imageSource;
+    mTileset->invalidateTileImagesHash();
+}
+
 /**
  * Sets the animation frames to be used by this tile. Resets any currently
  * running animation.
@@ -190,6 +243,7 @@ void Tile::setFrames(const QVector<Frame> &frames)
 {
     resetAnimation();
     mFrames = frames;
+    mTileset->invalidateAnimatedTiles();
 }
 
 /**
@@ -234,6 +288,22 @@ bool Tile::advanceAnimation(int ms)
     return previousTileId != frame.tileId;
 }
 
+/**
+ * Returns the amount of milliseconds after which advancing this animation
+ * moves to its next frame, or -1 if it never does.
+ */
+int Tile::timeUntilNextFrame() const
+{
+    if (!isAnimated())
+        return -1;
+
+    const Frame &frame = mFrames.at(mCurrentFrameIndex);
+    if (frame.duration <= 0)
+        return -1;
+
+    return qMax(1, frame.duration - mUnusedTime + 1);
+}
+
 /**
  * Returns a duplicate of this tile, to be added to the given \a tileset.
  */
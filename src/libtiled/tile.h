@@ -37,6 +37,7 @@
 #include <QSharedPointer>
 #include <QUrl>
 
+#include <atomic>
 #include <memory>
 #include <optional>
 
@@ -77,6 +78,8 @@ public:
     const QPainterPath &imageShape() const;
     void setImage(const QPixmap &image);
 
+    QRgb averageColor() const;
+
     const Tile *currentFrameTile() const;
 
     const QUrl &imageSource() const;
@@ -108,6 +111,7 @@ public:
     int currentFrameIndex() const;
     bool resetAnimation();
     bool advanceAnimation(int ms);
+    int timeUntilNextFrame() const;
 
     LoadingStatus imageStatus() const;
     void setImageStatus(LoadingStatus status);
@@ -119,6 +123,8 @@ private:
     Tileset *mTileset;
     QPixmap mImage;
     mutable std::optional<QPainterPath> mImageShape;   // cache
+    mutable std::atomic<qint64> mAverageColorKey { 0 }; // cache key of the image the color was computed for
+    mutable std::atomic<QRgb> mAverageColor { 0 };      // cache
     QUrl mImageSource;
     QRect mImageRect;
     LoadingStatus mImageStatus;
@@ -158,11 +164,6 @@ inline const QUrl &Tile::imageSource() const
     return mImageSource;
 }
 
-inline void Tile::setImageSource(const QUrl &imageSource)
-{
-    mImageSource = imageSource;
-}
-
 /**
  * Returns the image source rect in pixels.
  */
@@ -100,9 +100,15 @@ enum class BlendMode {
 
 const int CHUNK_SIZE = 16;
 const int CHUNK_BITS = 4;
-const int CHUNK_SIZE_MIN = 4;
 const int CHUNK_MASK = CHUNK_SIZE - 1;
 
+/*
+ * The default and minimum size of the chunks written to files for infinite
+ * maps. This is independent of the in-memory CHUNK_SIZE.
+ */
+const int OUTPUT_CHUNK_SIZE = 16;
+const int CHUNK_SIZE_MIN = 4;
+
 static const char TILES_MIMETYPE[] = "application/vnd.tile.list";
 static const char FRAMES_MIMETYPE[] = "application/vnd.frame.list";
 static const char LAYERS_MIMETYPE[] = "application/vnd.layer.list";
@@ -29,14 +29,18 @@
 
 #include "tilelayer.h"
 
-#include "containerhelpers.h"
+#include "chunkstore.h"
 #include "hex.h"
 #include "tile.h"
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
+#include <utility>
 
+#include <QDebug>
 #include <QSet>
+#include <QtConcurrent>
 
 using namespace Tiled;
 
@@ -63,75 +67,535 @@ void Cell::rotate(RotateDirection direction)
 
 QRegion Chunk::region(std::function<bool (const Cell &)> condition) const
 {
-    QRegion region;
+    return tileRegion(condition).toQRegion();
+}
 
-    for (int y = 0; y < CHUNK_SIZE; ++y) {
-        for (int x = 0; x < CHUNK_SIZE; ++x) {
-            if (condition(cellAt(x, y))) {
-                const int rangeStart = x;
-                for (++x; x <= CHUNK_SIZE; ++x) {
-                    if (x == CHUNK_SIZE || !condition(cellAt(x, y))) {
-                        const int rangeEnd = x;
-                        region += QRect(rangeStart, y, rangeEnd - rangeStart, 1);
-                        break;
-                    }
-                }
-            }
+/**
+ * Encodes the given \a cell as a word in the given packed \a format. Returns
+ * false when the cell can't be represented in that format.
+ */
+bool Chunk::encode(const Cell &cell, Format format, quint32 &word)
+{
+    using namespace ChunkFormat;
+
+    const int paletteBits = format == Packed16 ? Palette16Bits : Palette32Bits;
+    const int tileIdShift = format == Packed16 ? TileId16Shift : TileId32Shift;
+    const int tileIdBits = (format == Packed16 ? 16 : 32) - tileIdShift;
+
+    word = static_cast<quint32>(cell._flags) & FlagsMask;
+
+    if (!cell._tileset)
+        return cell._tileId == -1;
+
+    if (cell._tileId < 0 || cell._tileId >= (1 << tileIdBits))
+        return false;
+
+    const int index = paletteIndex(cell._tileset);
+    if (index >= (1 << paletteBits) - 1)
+        return false;
+
+    word |= static_cast<quint32>(index + 1) << FlagsBits;
+    word |= static_cast<quint32>(cell._tileId) << tileIdShift;
+    return true;
+}
+
+/**
+ * Returns the index of the given \a tileset in the palette of this chunk,
+ * adding it when necessary.
+ */
+int Chunk::paletteIndex(Tileset *tileset)
+{
+    int index = d->palette.indexOf(tileset);
+    if (index != -1)
+        return index;
+
+    // Reuse entries that were freed by removeReferencesToTileset
+    index = d->palette.indexOf(nullptr);
+    if (index != -1) {
+        d->palette[index] = tileset;
+        return index;
+    }
+
+    d->palette.append(tileset);
+    return d->palette.size() - 1;
+}
+
+/**
+ * Changes the storage of this chunk to the given wider \a format.
+ */
+void Chunk::widen(Format format)
+{
+    Q_ASSERT(format > d->format);
+
+    const int cellCount = CHUNK_SIZE * CHUNK_SIZE;
+
+    if (format == Packed32) {
+        using namespace ChunkFormat;
+
+        d->words32.resize(cellCount);
+        for (int i = 0; i < cellCount; ++i) {
+            const quint32 word = d->words16.at(i);
+            const quint32 palette = (word >> FlagsBits) & ((1 << Palette16Bits) - 1);
+            d->words32[i] = (word & FlagsMask)
+                    | (palette << FlagsBits)
+                    | ((word >> TileId16Shift) << TileId32Shift);
         }
+    } else {
+        d->cells.resize(cellCount);
+        for (int i = 0; i < cellCount; ++i)
+            d->cells[i] = cellAtIndex(i);
+
+        d->palette.clear();
+        d->palette.squeeze();
+        d->words32.clear();
+        d->words32.squeeze();
     }
 
-    return region;
+    d->words16.clear();
+    d->words16.squeeze();
+    d->format = format;
 }
 
 void Chunk::setCell(int x, int y, const Cell &cell)
 {
-    int index = x + y * CHUNK_SIZE;
+    const int index = x + y * CHUNK_SIZE;
+
+    // Avoid detaching shared data when the cell doesn't change
+    const Cell current = cellAtIndex(index);
+    if (current == cell && current.checked() == cell.checked())
+        return;
+
+    store(index, cell);
+    invalidateHash();
+
+    if (current.isEmpty() == cell.isEmpty())
+        return;
+
+    if (current.isEmpty()) {
+        ++d->cellCount;
+        d->bounds |= QRect(x, y, 1, 1);
+    } else if (--d->cellCount == 0) {
+        d->bounds = QRect();
+    } else {
+        const QRect &bounds = d->bounds;
+        if (x == bounds.left() || x == bounds.right() || y == bounds.top() || y == bounds.bottom())
+            shrinkBounds();
+    }
+}
+
+/**
+ * Stores the given \a cell at \a index, widening the format when needed.
+ */
+void Chunk::store(int index, const Cell &cell)
+{
+    quint32 word;
 
-    mGrid[index] = cell;
+    switch (d->format) {
+    case Packed16:
+        if (encode(cell, Packed16, word)) {
+            d->words16[index] = static_cast<quint16>(word);
+            return;
+        }
+        widen(Packed32);
+        [[fallthrough]];
+    case Packed32:
+        if (encode(cell, Packed32, word)) {
+            d->words32[index] = word;
+            return;
+        }
+        widen(Unpacked);
+        [[fallthrough]];
+    case Unpacked:
+        break;
+    }
+
+    d->cells[index] = cell;
 }
 
-bool Chunk::isEmpty() const
+/**
+ * Shrinks the bounds of the non-empty cells after cells were removed at its
+ * edges. Requires at least one non-empty cell.
+ */
+void Chunk::shrinkBounds()
 {
+    Q_ASSERT(d->cellCount > 0);
+
+    QRect &bounds = d->bounds;
+
+    auto rowIsEmpty = [&] (int y) {
+        for (int x = bounds.left(); x <= bounds.right(); ++x)
+            if (!isEmptyAt(x + y * CHUNK_SIZE))
+                return false;
+        return true;
+    };
+    auto columnIsEmpty = [&] (int x) {
+        for (int y = bounds.top(); y <= bounds.bottom(); ++y)
+            if (!isEmptyAt(x + y * CHUNK_SIZE))
+                return false;
+        return true;
+    };
+
+    while (rowIsEmpty(bounds.top()))
+        bounds.setTop(bounds.top() + 1);
+    while (rowIsEmpty(bounds.bottom()))
+        bounds.setBottom(bounds.bottom() - 1);
+    while (columnIsEmpty(bounds.left()))
+        bounds.setLeft(bounds.left() + 1);
+    while (columnIsEmpty(bounds.right()))
+        bounds.setRight(bounds.right() - 1);
+}
+
+/**
+ * Recomputes the number of non-empty cells and their bounds, after cells
+ * were changed without going through setCell().
+ */
+void Chunk::recount()
+{
+    int count = 0;
+    QRect bounds;
+
     for (int y = 0; y < CHUNK_SIZE; ++y) {
+        int left = CHUNK_SIZE;
+        int right = -1;
+
         for (int x = 0; x < CHUNK_SIZE; ++x) {
-            if (!cellAt(x, y).isEmpty())
-                return false;
+            if (!isEmptyAt(x + y * CHUNK_SIZE)) {
+                ++count;
+                left = qMin(left, x);
+                right = x;
+            }
         }
+
+        if (right != -1)
+            bounds |= QRect(left, y, right - left + 1, 1);
     }
 
-    return true;
+    d->cellCount = count;
+    d->bounds = bounds;
+    invalidateHash();
 }
 
-bool Chunk::hasCell(std::function<bool (const Cell &)> condition) const
+/**
+ * Returns whether this chunk stores the same data as \a other, which is the
+ * case when the data is shared or when the chunks were filled the same way.
+ *
+ * Chunks that return false may still contain the same cells, since the cells
+ * can be encoded differently.
+ */
+bool Chunk::hasSameData(const Chunk &other) const
 {
-    for (const Cell &cell : mGrid)
-        if (condition(cell))
-            return true;
+    if (d == other.d)
+        return true;
+    if (d->format != other.d->format || d->palette != other.d->palette)
+        return false;
+
+    switch (d->format) {
+    case Packed16:
+        return std::memcmp(d->words16.constData(), other.d->words16.constData(),
+                           sizeof(quint16) * CHUNK_SIZE * CHUNK_SIZE) == 0;
+    case Packed32:
+        return std::memcmp(d->words32.constData(), other.d->words32.constData(),
+                           sizeof(quint32) * CHUNK_SIZE * CHUNK_SIZE) == 0;
+    case Unpacked:
+        break;
+    }
 
-    return false;
+    return d->cells == other.d->cells;
+}
+
+static inline quint64 mixHash(quint64 x)
+{
+    // The splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * Returns a hash of the cells in this chunk. The hash does not depend on how
+ * the cells are encoded and it is kept until the chunk is changed, so
+ * comparing the hashes of chunks is cheap.
+ *
+ * Since tilesets are identified by their address, the hash is only
+ * meaningful within the running application. It never returns 0.
+ */
+quint64 Chunk::contentHash() const
+{
+    if (const quint64 hash = d->hash.loadRelaxed())
+        return hash;
+
+    quint64 hash = mixHash(static_cast<quint64>(d->cellCount));
+
+    const QRect &bounds = d->bounds;
+    for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+        for (int x = bounds.left(); x <= bounds.right(); ++x) {
+            const int index = x + y * CHUNK_SIZE;
+            if (isEmptyAt(index))
+                continue;
+
+            const Cell cell = cellAtIndex(index);
+            hash = mixHash(hash ^ reinterpret_cast<quintptr>(cell.tileset()));
+            hash = mixHash(hash ^ ((static_cast<quint64>(static_cast<quint32>(cell.tileId())) << 32)
+                                   | (static_cast<quint64>(cell.flags()) << 16)
+                                   | static_cast<quint64>(index)));
+        }
+    }
+
+    if (hash == 0)
+        hash = 1;
+
+    d->hash.storeRelaxed(hash);
+    return hash;
+}
+
+/**
+ * Returns an estimate of the number of bytes used by this chunk. Since the
+ * cell data is implicitly shared, chunks sharing their data with another
+ * chunk (for example in the undo stack) are counted in full.
+ */
+qint64 Chunk::memoryUsage() const
+{
+    return static_cast<qint64>(sizeof(Chunk)) + sizeof(Data)
+            + d->palette.capacity() * sizeof(Tileset*)
+            + d->words16.capacity() * sizeof(quint16)
+            + d->words32.capacity() * sizeof(quint32)
+            + d->cells.capacity() * sizeof(Cell);
+}
+
+/**
+ * Returns the region of the non-empty cells in this chunk, moved by the given
+ * \a offset. For the packed formats this only looks at the palette and tile
+ * ID bits of the words, without decoding the cells.
+ */
+TileRegion Chunk::nonEmptyRegion(QPoint offset) const
+{
+    if (isEmpty())
+        return TileRegion();
+    if (isFull())
+        return TileRegion(QRect(offset, QSize(CHUNK_SIZE, CHUNK_SIZE)));
+
+    // Only the bounds of the non-empty cells need to be scanned
+    const QRect bounds = d->bounds;
+
+    auto wordRegion = [offset, bounds] (const auto &words) {
+        TileRegion region;
+
+        for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+            const auto *row = words.constData() + y * CHUNK_SIZE;
+            const int end = bounds.right() + 1;
+
+            for (int x = bounds.left(); x < end; ++x) {
+                if ((row[x] >> ChunkFormat::FlagsBits) == 0)
+                    continue;
+
+                const int rangeStart = x;
+                while (x < end && (row[x] >> ChunkFormat::FlagsBits) != 0)
+                    ++x;
+
+                region.add(QRect(offset.x() + rangeStart, offset.y() + y,
+                                 x - rangeStart, 1));
+            }
+        }
+
+        return region;
+    };
+
+    switch (d->format) {
+    case Packed16:
+        return wordRegion(d->words16);
+    case Packed32:
+        return wordRegion(d->words32);
+    case Unpacked:
+        break;
+    }
+
+    return tileRegion([] (const Cell &cell) { return !cell.isEmpty(); }, offset);
+}
+
+/**
+ * Returns whether this chunk may contain cells referring to the given
+ * \a tileset. Does not detach the shared cell data.
+ */
+bool Chunk::references(const Tileset *tileset) const
+{
+    if (d->format == Unpacked) {
+        return std::any_of(d->cells.begin(), d->cells.end(), [=] (const Cell &cell) {
+            return cell.tileset() == tileset;
+        });
+    }
+
+    return d->palette.contains(const_cast<Tileset*>(tileset));
 }
 
 void Chunk::removeReferencesToTileset(Tileset *tileset)
 {
-    for (int i = 0, i_end = mGrid.size(); i < i_end; ++i) {
-        if (mGrid.at(i).tileset() == tileset)
-            mGrid.replace(i, Cell::empty);
+    if (!references(tileset))
+        return;
+
+    if (d->format == Unpacked) {
+        for (int i = 0, i_end = d->cells.size(); i < i_end; ++i) {
+            if (d->cells.at(i).tileset() == tileset)
+                d->cells.replace(i, Cell::empty);
+        }
+        recount();
+        return;
     }
+
+    using namespace ChunkFormat;
+
+    for (int p = 0; p < d->palette.size(); ++p) {
+        if (d->palette.at(p) != tileset)
+            continue;
+
+        const quint32 palette = p + 1;
+
+        if (d->format == Packed16) {
+            for (quint16 &word : d->words16)
+                if (((word >> FlagsBits) & ((1 << Palette16Bits) - 1)) == palette)
+                    word = 0;
+        } else {
+            for (quint32 &word : d->words32)
+                if (((word >> FlagsBits) & ((1 << Palette32Bits) - 1)) == palette)
+                    word = 0;
+        }
+
+        d->palette[p] = nullptr;
+    }
+
+    recount();
 }
 
 void Chunk::replaceReferencesToTileset(Tileset *oldTileset, Tileset *newTileset)
 {
-    for (Cell &cell : mGrid) {
-        if (cell.tileset() == oldTileset)
-            cell.setTile(newTileset, cell.tileId());
+    if (!references(oldTileset))
+        return;
+
+    invalidateHash();
+
+    if (d->format == Unpacked) {
+        for (Cell &cell : d->cells) {
+            if (cell.tileset() == oldTileset)
+                cell.setTile(newTileset, cell.tileId());
+        }
+        return;
+    }
+
+    // In packed form, only the palette needs to be updated
+    for (Tileset *&tileset : d->palette) {
+        if (tileset == oldTileset)
+            tileset = newTileset;
+    }
+}
+
+ChunkIndex::ChunkIndex(const ChunkIndex &other)
+    : mChunks(other.mChunks)
+    , mArea(other.mArea)
+{
+    updateTable();
+}
+
+ChunkIndex::ChunkIndex(ChunkIndex &&other) noexcept
+    : mChunks(std::move(other.mChunks))
+    , mArea(std::exchange(other.mArea, QRect()))
+    , mTable(std::move(other.mTable))
+{
+    other.mChunks.clear();
+    other.mTable.clear();
+}
+
+ChunkIndex &ChunkIndex::operator=(const ChunkIndex &other)
+{
+    if (this != &other) {
+        mChunks = other.mChunks;
+        mArea = other.mArea;
+        updateTable();
     }
+    return *this;
+}
+
+ChunkIndex &ChunkIndex::operator=(ChunkIndex &&other) noexcept
+{
+    mChunks.swap(other.mChunks);
+    std::swap(mArea, other.mArea);
+    mTable.swap(other.mTable);
+    return *this;
+}
+
+/**
+ * Returns the chunk at the given \a position (in chunk coordinates),
+ * creating it when it doesn't exist yet.
+ */
+Chunk &ChunkIndex::operator[](QPoint position)
+{
+    if (Chunk *chunk = find(position))
+        return *chunk;
+
+    Chunk &chunk = mChunks[position];
+
+    const QRect previousArea = mArea;
+    mArea |= QRect(position, QSize(1, 1));
+
+    if (!mTable.empty() && mArea == previousArea)
+        mTable[tableIndex(position)] = &chunk;
+    else
+        updateTable();
+
+    return chunk;
+}
+
+/**
+ * Removes the chunk at the given \a position (in chunk coordinates). The
+ * area is not shrunk.
+ */
+void ChunkIndex::remove(QPoint position)
+{
+    auto it = mChunks.find(position);
+    if (it == mChunks.end())
+        return;
+
+    if (!mTable.empty())
+        mTable[tableIndex(position)] = nullptr;
+
+    mChunks.erase(it);
+}
+
+void ChunkIndex::clear()
+{
+    mChunks.clear();
+    mArea = QRect();
+    mTable.clear();
+}
+
+/**
+ * Rebuilds the lookup table when the chunks are packed densely enough,
+ * otherwise releases it.
+ */
+void ChunkIndex::updateTable()
+{
+    // Allow up to 3 out of 4 table entries to be unused
+    constexpr qint64 minimumTableSize = 256;
+    const qint64 tableSize = qint64(mArea.width()) * mArea.height();
+    const bool dense = !mChunks.empty() &&
+            tableSize <= std::max(minimumTableSize, qint64(mChunks.size()) * 4);
+
+    if (!dense) {
+        mTable.clear();
+        mTable.shrink_to_fit();
+        return;
+    }
+
+    mTable.assign(tableSize, nullptr);
+    for (auto &entry : mChunks)
+        mTable[tableIndex(entry.first)] = &entry.second;
 }
 
 TileLayer::TileLayer(const QString &name, int x, int y, int width, int height)
     : Layer(TileLayerType, name, x, y)
     , mWidth(width)
     , mHeight(height)
-    , mUsedTilesetsDirty(false)
 {
 }
 
@@ -175,29 +639,256 @@ QMargins TileLayer::drawMargins() const
     return computeDrawMargins(usedTilesets());
 }
 
+/**
+ * Returns the bounding rectangle of the non-empty cells in this layer, in map
+ * tile coordinates. This is equivalent to region().boundingRect(), but only
+ * needs to look at the cached bounds of each chunk.
+ */
+QRect TileLayer::usedBounds() const
+{
+    QRect bounds;
+
+    for (auto it = mChunks.begin(); it != mChunks.end(); ++it) {
+        const Chunk &chunk = it.value();
+        if (chunk.isEmpty())
+            continue;
+
+        bounds |= chunk.bounds().translated(it.key().x() * CHUNK_SIZE + mX,
+                                            it.key().y() * CHUNK_SIZE + mY);
+    }
+
+    // The bounds of the stored chunks are not known until they are loaded
+    for (const QPoint &chunkPos : mPagedOutChunks)
+        bounds |= QRect(chunkPos.x() * CHUNK_SIZE + mX, chunkPos.y() * CHUNK_SIZE + mY,
+                        CHUNK_SIZE, CHUNK_SIZE);
+
+    return bounds;
+}
+
 /**
  * Calculates the region of cells in this tile layer for which the given
  * \a condition returns true.
  */
 QRegion TileLayer::region(std::function<bool (const Cell &)> condition) const
 {
-    QRegion region;
+    return tileRegion(condition).toQRegion();
+}
+
+/**
+ * Calls \a function for each of the \a jobs, which each cover a chunk.
+ * Processing a single chunk is quick, so threads are only used when there
+ * are a lot of them.
+ */
+template<typename Jobs, typename Function>
+static void forEachChunkJob(Jobs &jobs, Function function)
+{
+    constexpr int minimumParallelChunks = 16;
+
+    if (jobs.size() < minimumParallelChunks)
+        std::for_each(jobs.begin(), jobs.end(), function);
+    else
+        QtConcurrent::blockingMap(jobs, function);
+}
+
+/**
+ * Returns the area covered by the chunks in \a area, in tile coordinates.
+ */
+static QRect chunksToTiles(const QRect &area)
+{
+    return QRect(area.x() * CHUNK_SIZE, area.y() * CHUNK_SIZE,
+                 area.width() * CHUNK_SIZE, area.height() * CHUNK_SIZE);
+}
+
+/**
+ * Computes the region of each chunk using the given \a chunkRegion function
+ * and merges them. When there are enough chunks, they are processed in
+ * parallel.
+ */
+TileRegion TileLayer::mergeChunkRegions(const std::function<TileRegion (const Chunk &, QPoint)> &chunkRegion) const
+{
+    struct ChunkJob
+    {
+        const Chunk *chunk;
+        QPoint offset;
+        TileRegion region;
+    };
 
-    QHashIterator<QPoint, Chunk> it(mChunks);
-    while (it.hasNext()) {
-        it.next();
-        region += it.value().region(condition).translated(it.key().x() * CHUNK_SIZE + mX,
-                                                          it.key().y() * CHUNK_SIZE + mY);
+    QVector<ChunkJob> jobs;
+    jobs.reserve(mChunks.size());
+
+    for (auto it = mChunks.begin(); it != mChunks.end(); ++it) {
+        const QPoint offset(it.key().x() * CHUNK_SIZE + mX,
+                            it.key().y() * CHUNK_SIZE + mY);
+        jobs.append({ &it.value(), offset, TileRegion() });
     }
 
+    forEachChunkJob(jobs, [&chunkRegion] (ChunkJob &job) {
+        job.region = chunkRegion(*job.chunk, job.offset);
+    });
+
+    // The chunks are ordered row by row, which keeps merging cheap
+    TileRegion region;
+    for (const ChunkJob &job : std::as_const(jobs))
+        region.add(job.region);
+
     return region;
 }
 
+/**
+ * Moves each cell of this layer to the position set by \a transform, which
+ * may also change the flags of the cell. Cells for which \a transform
+ * returns false are removed.
+ *
+ * The new location of the cells is computed in parallel for each chunk,
+ * after which the new chunks are filled in parallel as well.
+ */
+void TileLayer::transformCells(const std::function<bool (QPoint &, Cell &)> &transform)
+{
+    struct Placement
+    {
+        int index;
+        Cell cell;
+    };
+
+    struct SourceJob
+    {
+        QPoint chunkPos;
+        const Chunk *chunk;
+        QHash<QPoint, QVector<Placement>> placements;   // by target chunk
+        QHash<Tileset*, int> removed;
+    };
+
+    QVector<SourceJob> sourceJobs;
+    sourceJobs.reserve(mChunks.size());
+
+    for (auto it = mChunks.begin(); it != mChunks.end(); ++it)
+        sourceJobs.append({ it.key(), &it.value(), {}, {} });
+
+    forEachChunkJob(sourceJobs, [&transform] (SourceJob &job) {
+        const QPoint origin(job.chunkPos.x() * CHUNK_SIZE,
+                            job.chunkPos.y() * CHUNK_SIZE);
+
+        for (auto it = job.chunk->begin(); it != job.chunk->end(); ++it) {
+            Cell cell = *it;
+            if (cell.isEmpty())
+                continue;
+
+            QPoint pos = origin + QPoint(it.index() & CHUNK_MASK, it.index() >> CHUNK_BITS);
+            if (!transform(pos, cell)) {
+                ++job.removed[cell.tileset()];
+                continue;
+            }
+
+            const QPoint target(pos.x() >> CHUNK_BITS, pos.y() >> CHUNK_BITS);
+            const int index = (pos.y() & CHUNK_MASK) * CHUNK_SIZE + (pos.x() & CHUNK_MASK);
+            job.placements[target].append({ index, cell });
+        }
+    });
+
+    struct TargetJob
+    {
+        Chunk *chunk;
+        QVector<const QVector<Placement>*> placements;
+    };
+
+    ChunkIndex chunks;
+    QHash<QPoint, int> targetJobIndexes;
+    QVector<TargetJob> targetJobs;
+
+    // Collected in the order of the source chunks, so that the result is
+    // deterministic should several cells end up at the same position
+    for (const SourceJob &job : std::as_const(sourceJobs)) {
+        for (auto it = job.placements.begin(); it != job.placements.end(); ++it) {
+            auto jobIndex = targetJobIndexes.find(it.key());
+            if (jobIndex == targetJobIndexes.end()) {
+                jobIndex = targetJobIndexes.insert(it.key(), targetJobs.size());
+                targetJobs.append({ &chunks[it.key()], {} });
+            }
+            targetJobs[jobIndex.value()].placements.append(&it.value());
+        }
+
+        for (auto it = job.removed.begin(); it != job.removed.end(); ++it) {
+            auto count = mTilesetUseCounts.find(it.key());
+            Q_ASSERT(count != mTilesetUseCounts.end());
+            if ((count.value() -= it.value()) == 0)
+                mTilesetUseCounts.erase(count);
+        }
+    }
+
+    forEachChunkJob(targetJobs, [] (TargetJob &job) {
+        for (const QVector<Placement> *placements : std::as_const(job.placements))
+            for (const Placement &placement : *placements)
+                job.chunk->setCell(placement.index & CHUNK_MASK,
+                                   placement.index >> CHUNK_BITS,
+                                   placement.cell);
+    });
+
+    mChunks = std::move(chunks);
+    mBounds = chunksToTiles(mChunks.area());
+    invalidateContentHash();
+}
+
+/**
+ * Moves the chunks of this layer by \a offset, which needs to be a multiple
+ * of the chunk size. Whole chunks are moved without looking at their cells,
+ * only the cells of chunks that are partially outside of \a clip are removed
+ * one by one. A null \a clip keeps all cells.
+ */
+void TileLayer::moveChunks(QPoint offset, const QRect &clip)
+{
+    Q_ASSERT(!(offset.x() & CHUNK_MASK) && !(offset.y() & CHUNK_MASK));
+
+    const QPoint chunkOffset(offset.x() >> CHUNK_BITS, offset.y() >> CHUNK_BITS);
+    ChunkIndex chunks;
+
+    for (auto it = mChunks.begin(); it != mChunks.end(); ++it) {
+        const QPoint chunkPos = it.key() + chunkOffset;
+        const QRect chunkRect(chunkPos.x() * CHUNK_SIZE, chunkPos.y() * CHUNK_SIZE,
+                              CHUNK_SIZE, CHUNK_SIZE);
+        const Chunk &chunk = it.value();
+
+        if (clip.isNull() || clip.contains(chunkRect)) {
+            chunks[chunkPos] = chunk;   // shares the cell data
+            continue;
+        }
+
+        Chunk *target = nullptr;
+
+        for (auto cellIt = chunk.begin(); cellIt != chunk.end(); ++cellIt) {
+            const Cell cell = *cellIt;
+            if (cell.isEmpty())
+                continue;
+
+            const int x = cellIt.index() & CHUNK_MASK;
+            const int y = cellIt.index() >> CHUNK_BITS;
+
+            if (clip.contains(chunkRect.x() + x, chunkRect.y() + y)) {
+                if (!target)
+                    target = &chunks[chunkPos];
+                target->setCell(x, y, cell);
+            } else {
+                releaseTileset(cell.tileset());
+            }
+        }
+    }
+
+    mChunks = std::move(chunks);
+    mBounds = chunksToTiles(mChunks.area());
+    invalidateContentHash();
+}
+
 /**
  * Sets the cell at the given coordinates.
  */
 void Tiled::TileLayer::setCell(int x, int y, const Cell &cell)
 {
+    if (!mPagedOutChunks.isEmpty()) {
+        // Changing a chunk that failed to load would lose its stored cells
+        const QPoint chunkPos(x >> CHUNK_BITS, y >> CHUNK_BITS);
+        if (mPagedOutChunks.contains(chunkPos) && !pageInChunk(chunkPos))
+            return;
+    }
+
     if (!findChunk(x, y)) {
         if (cell == Cell::empty && !cell.checked()) {
             return;
@@ -209,65 +900,191 @@ void Tiled::TileLayer::setCell(int x, int y, const Cell &cell)
         }
     }
 
-    Chunk &_chunk = chunk(x, y);
+    Chunk &_chunk = chunk(x, y);
+
+    Tileset *oldTileset = _chunk.cellAt(x & CHUNK_MASK, y & CHUNK_MASK).tileset();
+    Tileset *newTileset = cell.tileset();
+    if (oldTileset != newTileset) {
+        releaseTileset(oldTileset);
+        if (newTileset)
+            ++mTilesetUseCounts[newTileset];
+    }
+
+    _chunk.setCell(x & CHUNK_MASK, y & CHUNK_MASK, cell);
+}
+
+std::unique_ptr<TileLayer> TileLayer::copy(const QRegion &region) const
+{
+    const QRect regionBounds = region.boundingRect();
+    const QRegion regionWithContents = region.intersected(mBounds);
+
+    auto copied = std::make_unique<TileLayer>(QString(),
+                                              0, 0,
+                                              regionBounds.width(), regionBounds.height());
+
+    copied->setCells(-regionBounds.x(), -regionBounds.y(), this,
+                     regionWithContents.translated(-regionBounds.topLeft()));
+
+    return copied;
+}
+
+void TileLayer::merge(QPoint pos, const TileLayer *layer)
+{
+    // Determine the overlapping area
+    QRect area = QRect(pos, QSize(layer->width(), layer->height()));
+    area &= QRect(0, 0, width(), height());
+
+    if (area.isEmpty())
+        return;
+
+    const bool aligned = !(pos.x() & CHUNK_MASK) && !(pos.y() & CHUNK_MASK) && layer != this;
+
+    // Only the chunks of the merged layer need to be looked at
+    for (auto it = layer->mChunks.begin(); it != layer->mChunks.end(); ++it) {
+        const QRect chunkRect(it.key().x() * CHUNK_SIZE + pos.x(),
+                              it.key().y() * CHUNK_SIZE + pos.y(),
+                              CHUNK_SIZE, CHUNK_SIZE);
+        if (!area.intersects(chunkRect))
+            continue;
+
+        const Chunk &chunk = it.value();
+
+        // Chunks that don't need to be merged with existing cells are shared
+        if (aligned && area.contains(chunkRect)) {
+            const QPoint chunkPos(chunkRect.x() >> CHUNK_BITS, chunkRect.y() >> CHUNK_BITS);
+            const Chunk *target = mChunks.find(chunkPos);
+            if (!target || target->isEmpty()) {
+                shareChunk(chunkPos, chunk);
+                continue;
+            }
+        }
+
+        for (auto cellIt = chunk.begin(); cellIt != chunk.end(); ++cellIt) {
+            const Cell cell = *cellIt;
+            if (cell.isEmpty())
+                continue;
+
+            const int x = chunkRect.x() + (cellIt.index() & CHUNK_MASK);
+            const int y = chunkRect.y() + (cellIt.index() >> CHUNK_BITS);
+            if (area.contains(x, y))
+                setCell(x, y, cell);
+        }
+    }
+}
+
+void TileLayer::setCells(int x, int y, const TileLayer *layer,
+                         const QRegion &area)
+{
+    auto copyCells = [&] (const QRect &rect) {
+        for (int _x = rect.left(); _x <= rect.right(); ++_x)
+            for (int _y = rect.top(); _y <= rect.bottom(); ++_y)
+                setCell(_x, _y, layer->cellAt(_x - x, _y - y));
+    };
+
+    const QSet<QPoint> sharedChunks = shareChunks(x, y, layer, area);
+
+    // Copy the remaining cells, skipping the chunks that are now shared and
+    // the parts where neither layer has any chunks
+    for (const QRect &rect : area) {
+        for (int cy = rect.top() >> CHUNK_BITS; cy <= rect.bottom() >> CHUNK_BITS; ++cy) {
+            for (int cx = rect.left() >> CHUNK_BITS; cx <= rect.right() >> CHUNK_BITS; ++cx) {
+                const QPoint chunkPos(cx, cy);
+                if (sharedChunks.contains(chunkPos))
+                    continue;
+
+                const QRect part = rect & QRect(cx * CHUNK_SIZE, cy * CHUNK_SIZE,
+                                                CHUNK_SIZE, CHUNK_SIZE);
+
+                if (!mChunks.find(chunkPos) && !layer->hasChunksIn(part.translated(-x, -y)))
+                    continue;
 
-    if (!mUsedTilesetsDirty) {
-        Tileset *oldTileset = _chunk.cellAt(x & CHUNK_MASK, y & CHUNK_MASK).tileset();
-        Tileset *newTileset = cell.tileset();
-        if (oldTileset != newTileset) {
-            if (oldTileset)
-                mUsedTilesetsDirty = true;
-            else if (newTileset)
-                mUsedTilesets.insert(newTileset->sharedFromThis());
+                copyCells(part);
+            }
         }
     }
+}
 
-    _chunk.setCell(x & CHUNK_MASK, y & CHUNK_MASK, cell);
+/**
+ * Returns whether any chunks exist within the given \a rect.
+ */
+bool TileLayer::hasChunksIn(const QRect &rect) const
+{
+    for (int cy = rect.top() >> CHUNK_BITS; cy <= rect.bottom() >> CHUNK_BITS; ++cy)
+        for (int cx = rect.left() >> CHUNK_BITS; cx <= rect.right() >> CHUNK_BITS; ++cx)
+            if (mChunks.find(QPoint(cx, cy)))
+                return true;
+
+    return false;
 }
 
-std::unique_ptr<TileLayer> TileLayer::copy(const QRegion &region) const
+/**
+ * When \a layer is aligned to the chunk grid, shares its chunks that are
+ * completely covered by \a area with this layer, instead of copying each
+ * cell. The chunk data is only copied when either layer is changed.
+ *
+ * Returns the positions of the shared chunks, in chunk coordinates.
+ */
+QSet<QPoint> TileLayer::shareChunks(int x, int y, const TileLayer *layer,
+                                    const QRegion &area)
 {
-    const QRect regionBounds = region.boundingRect();
-    const QRegion regionWithContents = region.intersected(mBounds);
+    QSet<QPoint> sharedChunks;
 
-    auto copied = std::make_unique<TileLayer>(QString(),
-                                              0, 0,
-                                              regionBounds.width(), regionBounds.height());
+    if ((x & CHUNK_MASK) || (y & CHUNK_MASK) || layer == this)
+        return sharedChunks;
 
-    for (const QRect &rect : regionWithContents) {
-        for (int x = rect.left(); x <= rect.right(); ++x)
-            for (int y = rect.top(); y <= rect.bottom(); ++y)
-                copied->setCell(x - regionBounds.x(),
-                                y - regionBounds.y(),
-                                cellAt(x, y));
-    }
+    const QRect sourceBounds = area.boundingRect().translated(-x, -y) & layer->mBounds;
+    if (sourceBounds.isEmpty())
+        return sharedChunks;
 
-    return copied;
-}
+    const bool singleRect = area.rectCount() == 1;
 
-void TileLayer::merge(QPoint pos, const TileLayer *layer)
-{
-    // Determine the overlapping area
-    QRect area = QRect(pos, QSize(layer->width(), layer->height()));
-    area &= QRect(0, 0, width(), height());
+    for (int cy = sourceBounds.top() >> CHUNK_BITS; cy <= sourceBounds.bottom() >> CHUNK_BITS; ++cy) {
+        for (int cx = sourceBounds.left() >> CHUNK_BITS; cx <= sourceBounds.right() >> CHUNK_BITS; ++cx) {
+            const Chunk *sourceChunk = layer->mChunks.find(QPoint(cx, cy));
+            if (!sourceChunk)
+                continue;
 
-    for (int y = area.top(); y <= area.bottom(); ++y) {
-        for (int x = area.left(); x <= area.right(); ++x) {
-            const Cell &cell = layer->cellAt(x - pos.x(),
-                                             y - pos.y());
-            if (!cell.isEmpty())
-                setCell(x, y, cell);
+            const QRect chunkRect(cx * CHUNK_SIZE + x, cy * CHUNK_SIZE + y,
+                                  CHUNK_SIZE, CHUNK_SIZE);
+
+            const bool covered = singleRect ? area.boundingRect().contains(chunkRect)
+                                            : (QRegion(chunkRect) - area).isEmpty();
+            if (!covered)
+                continue;
+
+            const QPoint chunkPos(chunkRect.x() >> CHUNK_BITS, chunkRect.y() >> CHUNK_BITS);
+            if (shareChunk(chunkPos, *sourceChunk))
+                sharedChunks.insert(chunkPos);
         }
     }
+
+    return sharedChunks;
 }
 
-void TileLayer::setCells(int x, int y, const TileLayer *layer,
-                         const QRegion &area)
+/**
+ * Replaces the chunk at \a chunkPos (in chunk coordinates) with \a chunk,
+ * sharing its data. Returns false when the chunk at \a chunkPos is a stored
+ * chunk that failed to load.
+ */
+bool TileLayer::shareChunk(QPoint chunkPos, const Chunk &chunk)
 {
-    for (const QRect &rect : area)
-        for (int _x = rect.left(); _x <= rect.right(); ++_x)
-            for (int _y = rect.top(); _y <= rect.bottom(); ++_y)
-                setCell(_x, _y, layer->cellAt(_x - x, _y - y));
+    // A stored chunk is loaded to know the tilesets it releases
+    if (mPagedOutChunks.contains(chunkPos) && !pageInChunk(chunkPos))
+        return false;
+
+    Chunk &targetChunk = this->chunk(chunkPos.x() * CHUNK_SIZE,
+                                     chunkPos.y() * CHUNK_SIZE);
+
+    for (const Cell &cell : targetChunk)
+        releaseTileset(cell.tileset());
+    for (const Cell &cell : chunk)
+        if (Tileset *tileset = cell.tileset())
+            ++mTilesetUseCounts[tileset];
+
+    targetChunk = chunk;
+    mBounds |= QRect(chunkPos.x() * CHUNK_SIZE, chunkPos.y() * CHUNK_SIZE,
+                     CHUNK_SIZE, CHUNK_SIZE);
+    return true;
 }
 
 /**
@@ -278,6 +1095,8 @@ void TileLayer::setTiles(const QRegion &area, Tile *tile)
 {
     Q_ASSERT(area.subtracted(QRegion(0, 0, mWidth, mHeight)).isEmpty());
 
+    pageIn(area.boundingRect());
+
     for (const QRect &rect : area) {
         for (int x = rect.left(); x <= rect.right(); ++x) {
             for (int y = rect.top(); y <= rect.bottom(); ++y) {
@@ -306,49 +1125,34 @@ void TileLayer::clear()
 {
     mChunks.clear();
     mBounds = QRect();
-    mUsedTilesets.clear();
-    mUsedTilesetsDirty = false;
+    mTilesetUseCounts.clear();
+    mPagedOutChunks.clear();
+    mFailedChunks.clear();
+    mChunkLastUse.clear();
+    invalidateContentHash();
 }
 
 void TileLayer::flip(FlipDirection direction)
 {
-    const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, mWidth, mHeight);
-
     Q_ASSERT(direction == FlipHorizontally || direction == FlipVertically);
+    pageInAll();
 
-    QHashIterator<QPoint, Chunk> it(mChunks);
-    while (it.hasNext()) {
-        it.next();
-        for (int y = 0; y < CHUNK_SIZE; ++y) {
-            for (int x = 0; x < CHUNK_SIZE; ++x) {
-                int _x = it.key().x() * CHUNK_SIZE + x;
-                int _y = it.key().y() * CHUNK_SIZE + y;
-
-                Cell dest(it.value().cellAt(x, y));
-
-                if (dest.isEmpty())
-                    continue;
-
-                if (direction == FlipHorizontally) {
-                    dest.setFlippedHorizontally(!dest.flippedHorizontally());
-                    newLayer->setCell(mWidth - _x - 1, _y, dest);
-                } else if (direction == FlipVertically) {
-                    dest.setFlippedVertically(!dest.flippedVertically());
-                    newLayer->setCell(_x, mHeight - _y - 1, dest);
-                }
-            }
+    transformCells([this, direction] (QPoint &pos, Cell &cell) {
+        if (direction == FlipHorizontally) {
+            cell.setFlippedHorizontally(!cell.flippedHorizontally());
+            pos.setX(mWidth - pos.x() - 1);
+        } else {
+            cell.setFlippedVertically(!cell.flippedVertically());
+            pos.setY(mHeight - pos.y() - 1);
         }
-    }
-
-    mChunks = newLayer->mChunks;
-    mBounds = newLayer->mBounds;
+        return true;
+    });
 }
 
 void TileLayer::flipHexagonal(FlipDirection direction)
 {
-    const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, mWidth, mHeight);
-
     Q_ASSERT(direction == FlipHorizontally || direction == FlipVertically);
+    pageInAll();
 
     // for more info see impl "void TileLayer::rotateHexagonal(RotateDirection direction)"
     static constexpr unsigned char flipMaskH[16] = { 8, 6, 5, 4, 12, 2, 1, 0, 0, 14, 13, 12, 4, 10, 9, 8 }; // [0,15]<=>[8,7]; 2<=>5; 1<=>6; [12,3]<=>[4,11]; 14<=>9; 13<=>10;
@@ -356,96 +1160,64 @@ void TileLayer::flipHexagonal(FlipDirection direction)
 
     const unsigned char (&flipMask)[16] = (direction == FlipHorizontally ? flipMaskH : flipMaskV);
 
-    QHashIterator<QPoint, Chunk> it(mChunks);
-    while (it.hasNext()) {
-        it.next();
-        for (int y = 0; y < CHUNK_SIZE; ++y) {
-            for (int x = 0; x < CHUNK_SIZE; ++x) {
-                int _x = it.key().x() * CHUNK_SIZE + x;
-                int _y = it.key().y() * CHUNK_SIZE + y;
-
-                Cell dest(it.value().cellAt(x, y));
-
-                if (dest.isEmpty())
-                    continue;
-
-                unsigned char mask =
-                        (static_cast<unsigned char>(dest.flippedHorizontally()) << 3) |
-                        (static_cast<unsigned char>(dest.flippedVertically()) << 2) |
-                        (static_cast<unsigned char>(dest.flippedAntiDiagonally()) << 1) |
-                        (static_cast<unsigned char>(dest.rotatedHexagonal120()) << 0);
-
-                mask = flipMask[mask];
-
-                dest.setFlippedHorizontally((mask & 8) != 0);
-                dest.setFlippedVertically((mask & 4) != 0);
-                dest.setFlippedAntiDiagonally((mask & 2) != 0);
-                dest.setRotatedHexagonal120((mask & 1) != 0);
-
-                if (direction == FlipHorizontally)
-                    newLayer->setCell(mWidth - _x - 1, _y, dest);
-                else
-                    newLayer->setCell(_x, mHeight - _y - 1, dest);
-            }
-        }
-    }
-
-    mChunks = newLayer->mChunks;
-    mBounds = newLayer->mBounds;
+    transformCells([&] (QPoint &pos, Cell &cell) {
+        unsigned char mask =
+                (static_cast<unsigned char>(cell.flippedHorizontally()) << 3) |
+                (static_cast<unsigned char>(cell.flippedVertically()) << 2) |
+                (static_cast<unsigned char>(cell.flippedAntiDiagonally()) << 1) |
+                (static_cast<unsigned char>(cell.rotatedHexagonal120()) << 0);
+
+        mask = flipMask[mask];
+
+        cell.setFlippedHorizontally((mask & 8) != 0);
+        cell.setFlippedVertically((mask & 4) != 0);
+        cell.setFlippedAntiDiagonally((mask & 2) != 0);
+        cell.setRotatedHexagonal120((mask & 1) != 0);
+
+        if (direction == FlipHorizontally)
+            pos.setX(mWidth - pos.x() - 1);
+        else
+            pos.setY(mHeight - pos.y() - 1);
+        return true;
+    });
 }
 
 void TileLayer::rotate(RotateDirection direction)
 {
+    pageInAll();
+
     constexpr unsigned char rotateRightMask[8] = { 5, 4, 1, 0, 7, 6, 3, 2 };
     constexpr unsigned char rotateLeftMask[8]  = { 3, 2, 7, 6, 1, 0, 5, 4 };
 
     const unsigned char (&rotateMask)[8] =
             (direction == RotateRight) ? rotateRightMask : rotateLeftMask;
 
-    int newWidth = mHeight;
-    int newHeight = mWidth;
-    const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, newWidth, newHeight);
-
-    QHashIterator<QPoint, Chunk> it(mChunks);
-    while (it.hasNext()) {
-        it.next();
-        for (int y = 0; y < CHUNK_SIZE; ++y) {
-            for (int x = 0; x < CHUNK_SIZE; ++x) {
-                int _x = it.key().x() * CHUNK_SIZE + x;
-                int _y = it.key().y() * CHUNK_SIZE + y;
-
-                Cell dest(it.value().cellAt(x, y));
-
-                if (dest.isEmpty())
-                    continue;
-
-                unsigned char mask =
-                        (dest.flippedHorizontally() << 2) |
-                        (dest.flippedVertically() << 1) |
-                        (dest.flippedAntiDiagonally() << 0);
+    transformCells([&] (QPoint &pos, Cell &cell) {
+        unsigned char mask =
+                (cell.flippedHorizontally() << 2) |
+                (cell.flippedVertically() << 1) |
+                (cell.flippedAntiDiagonally() << 0);
 
-                mask = rotateMask[mask];
+        mask = rotateMask[mask];
 
-                dest.setFlippedHorizontally((mask & 4) != 0);
-                dest.setFlippedVertically((mask & 2) != 0);
-                dest.setFlippedAntiDiagonally((mask & 1) != 0);
+        cell.setFlippedHorizontally((mask & 4) != 0);
+        cell.setFlippedVertically((mask & 2) != 0);
+        cell.setFlippedAntiDiagonally((mask & 1) != 0);
 
-                if (direction == RotateRight)
-                    newLayer->setCell(mHeight - _y - 1, _x, dest);
-                else
-                    newLayer->setCell(_y, mWidth - _x - 1, dest);
-            }
-        }
-    }
+        if (direction == RotateRight)
+            pos = QPoint(mHeight - pos.y() - 1, pos.x());
+        else
+            pos = QPoint(pos.y(), mWidth - pos.x() - 1);
+        return true;
+    });
 
-    mWidth = newWidth;
-    mHeight = newHeight;
-    mChunks = newLayer->mChunks;
-    mBounds = newLayer->mBounds;
+    std::swap(mWidth, mHeight);
 }
 
 void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
 {
+    pageInAll();
+
     Map::StaggerIndex staggerIndex = map->staggerIndex();
     Map::StaggerAxis staggerAxis = map->staggerAxis();
 
@@ -461,7 +1233,6 @@ void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
 
     int newWidth = topRight.toStaggered(staggerIndex, staggerAxis).x() * 2 + 2;
     int newHeight = bottomRight.toStaggered(staggerIndex, staggerAxis).y() * 2 + 2;
-    const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, newWidth, newHeight);
 
     Hex newCenter(newWidth / 2, newHeight / 2, staggerIndex, staggerAxis);
 
@@ -489,50 +1260,33 @@ void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
     const unsigned char (&rotateMask)[16] =
             (direction == RotateRight) ? rotateRightMask : rotateLeftMask;
 
-    QHashIterator<QPoint, Chunk> it(mChunks);
-    while (it.hasNext()) {
-        it.next();
-        for (int y = 0; y < CHUNK_SIZE; ++y) {
-            for (int x = 0; x < CHUNK_SIZE; ++x) {
-                int _x = it.key().x() * CHUNK_SIZE + x;
-                int _y = it.key().y() * CHUNK_SIZE + y;
-
-                Cell dest(it.value().cellAt(x, y));
+    transformCells([&] (QPoint &pos, Cell &cell) {
+        unsigned char mask =
+                (static_cast<unsigned char>(cell.flippedHorizontally()) << 3) |
+                (static_cast<unsigned char>(cell.flippedVertically()) << 2) |
+                (static_cast<unsigned char>(cell.flippedAntiDiagonally()) << 1) |
+                (static_cast<unsigned char>(cell.rotatedHexagonal120()) << 0);
 
-                if (dest.isEmpty())
-                    continue;
-
-                unsigned char mask =
-                        (static_cast<unsigned char>(dest.flippedHorizontally()) << 3) |
-                        (static_cast<unsigned char>(dest.flippedVertically()) << 2) |
-                        (static_cast<unsigned char>(dest.flippedAntiDiagonally()) << 1) |
-                        (static_cast<unsigned char>(dest.rotatedHexagonal120()) << 0);
-
-                mask = rotateMask[mask];
-
-                dest.setFlippedHorizontally((mask & 8) != 0);
-                dest.setFlippedVertically((mask & 4) != 0);
-                dest.setFlippedAntiDiagonally((mask & 2) != 0);
-                dest.setRotatedHexagonal120((mask & 1) != 0);
+        mask = rotateMask[mask];
 
-                Hex rotatedHex(_x, _y, staggerIndex, staggerAxis);
-                rotatedHex -= center;
-                rotatedHex.rotate(direction);
-                rotatedHex += newCenter;
+        cell.setFlippedHorizontally((mask & 8) != 0);
+        cell.setFlippedVertically((mask & 4) != 0);
+        cell.setFlippedAntiDiagonally((mask & 2) != 0);
+        cell.setRotatedHexagonal120((mask & 1) != 0);
 
-                QPoint rotatedPoint = rotatedHex.toStaggered(staggerIndex, staggerAxis);
+        Hex rotatedHex(pos.x(), pos.y(), staggerIndex, staggerAxis);
+        rotatedHex -= center;
+        rotatedHex.rotate(direction);
+        rotatedHex += newCenter;
 
-                newLayer->setCell(rotatedPoint.x(), rotatedPoint.y(), dest);
-            }
-        }
-    }
+        pos = rotatedHex.toStaggered(staggerIndex, staggerAxis);
+        return true;
+    });
 
     mWidth = newWidth;
     mHeight = newHeight;
-    mChunks = newLayer->mChunks;
-    mBounds = newLayer->mBounds;
 
-    QRect filledRect = region().boundingRect();
+    QRect filledRect = usedBounds();
 
     if (staggerAxis == Map::StaggerY) {
         if (filledRect.y() & 1)
@@ -546,55 +1300,70 @@ void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
 }
 
 
+/**
+ * Returns the tilesets used by this layer. The number of cells referring to
+ * each tileset is kept up to date as cells are changed, so this does not
+ * need to look at the cells.
+ */
 QSet<SharedTileset> TileLayer::usedTilesets() const
 {
-    if (mUsedTilesetsDirty) {
-        QSet<SharedTileset> tilesets;
-
-        for (const Chunk &chunk : mChunks) {
-            for (const Cell &cell : chunk)
-                if (const Tile *tile = cell.tile())
-                    tilesets.insert(tile->sharedTileset());
-        }
+    QSet<SharedTileset> tilesets;
+    tilesets.reserve(mTilesetUseCounts.size());
 
-        mUsedTilesets.swap(tilesets);
-        mUsedTilesetsDirty = false;
-    }
+    for (auto it = mTilesetUseCounts.keyBegin(); it != mTilesetUseCounts.keyEnd(); ++it)
+        tilesets.insert((*it)->sharedFromThis());
 
-    return mUsedTilesets;
+    return tilesets;
 }
 
-bool TileLayer::hasCell(std::function<bool (const Cell &)> condition) const
+bool TileLayer::referencesTileset(const Tileset *tileset) const
 {
-    for (const Chunk &chunk : mChunks) {
-        if (chunk.hasCell(condition))
-            return true;
-    }
-
-    return false;
+    return mTilesetUseCounts.contains(const_cast<Tileset*>(tileset));
 }
 
-bool TileLayer::referencesTileset(const Tileset *tileset) const
+/**
+ * Returns the number of cells in this layer that refer to \a tileset.
+ */
+int TileLayer::tilesetUseCount(const Tileset *tileset) const
 {
-    return ::contains(usedTilesets(), tileset);
+    return mTilesetUseCounts.value(const_cast<Tileset*>(tileset));
 }
 
 void TileLayer::removeReferencesToTileset(Tileset *tileset)
 {
+    pageInAll();
     for (Chunk &chunk : mChunks)
         chunk.removeReferencesToTileset(tileset);
+    invalidateContentHash();
 
-    mUsedTilesets.remove(tileset->sharedFromThis());
+    mTilesetUseCounts.remove(tileset);
 }
 
 void TileLayer::replaceReferencesToTileset(Tileset *oldTileset,
                                            Tileset *newTileset)
 {
+    pageInAll();
     for (Chunk &chunk : mChunks)
         chunk.replaceReferencesToTileset(oldTileset, newTileset);
+    invalidateContentHash();
+
+    if (const int count = mTilesetUseCounts.take(oldTileset))
+        mTilesetUseCounts[newTileset] += count;
+}
+
+/**
+ * Decrements the use count of \a tileset, forgetting about it when it is no
+ * longer used.
+ */
+void TileLayer::releaseTileset(Tileset *tileset)
+{
+    if (!tileset)
+        return;
 
-    if (mUsedTilesets.remove(oldTileset->sharedFromThis()))
-        mUsedTilesets.insert(newTileset->sharedFromThis());
+    auto it = mTilesetUseCounts.find(tileset);
+    Q_ASSERT(it != mTilesetUseCounts.end());
+    if (--it.value() == 0)
+        mTilesetUseCounts.erase(it);
 }
 
 void TileLayer::resize(QSize size, QPoint offset)
@@ -602,18 +1371,20 @@ void TileLayer::resize(QSize size, QPoint offset)
     if (this->size() == size && offset.isNull())
         return;
 
-    const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, size.width(), size.height());
+    pageInAll();
+
+    // Keep the cells that end up within the new size
+    const QRect area(QPoint(), size);
 
-    // Copy over the preserved part
-    QRect area = mBounds.translated(offset).intersected(newLayer->rect());
-    for (int y = area.top(); y <= area.bottom(); ++y)
-        for (int x = area.left(); x <= area.right(); ++x)
-            newLayer->setCell(x, y, cellAt(x - offset.x(), y - offset.y()));
+    if (!(offset.x() & CHUNK_MASK) && !(offset.y() & CHUNK_MASK)) {
+        moveChunks(offset, area);
+    } else {
+        transformCells([&] (QPoint &pos, Cell &) {
+            pos += offset;
+            return area.contains(pos);
+        });
+    }
 
-    mChunks = newLayer->mChunks;
-    mBounds = newLayer->mBounds;
-    mUsedTilesets = newLayer->mUsedTilesets;
-    mUsedTilesetsDirty = newLayer->mUsedTilesetsDirty;
     setSize(size);
 }
 
@@ -631,62 +1402,40 @@ void TileLayer::offsetTiles(QPoint offset,
     if (offset.isNull())
         return;
 
-    const std::unique_ptr<TileLayer> newLayer(clone());
+    pageInAll();
 
-    for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
-        for (int x = bounds.left(); x <= bounds.right(); ++x) {
-            // Get position to pull tile value from
-            int oldX = x - offset.x();
-            int oldY = y - offset.y();
-
-            // Wrap x value that will be pulled from
-            if (wrapX)
-                oldX = clampWrap(oldX, bounds.left(), bounds.right() + 1);
-
-            // Wrap y value that will be pulled from
-            if (wrapY)
-                oldY = clampWrap(oldY, bounds.top(), bounds.bottom() + 1);
-
-            // Set the new tile
-            if (bounds.contains(oldX, oldY))
-                newLayer->setCell(x, y, cellAt(oldX, oldY));
-            else
-                newLayer->setCell(x, y, Cell::empty);
-        }
-    }
+    // Cells outside of the bounds stay in place, while the cells moved out of
+    // the bounds are either wrapped or removed
+    transformCells([&] (QPoint &pos, Cell &) {
+        if (!bounds.contains(pos))
+            return true;
+
+        pos += offset;
 
-    mChunks = newLayer->mChunks;
-    mBounds = newLayer->mBounds;
-    mUsedTilesets = newLayer->mUsedTilesets;
-    mUsedTilesetsDirty = newLayer->mUsedTilesetsDirty;
+        if (wrapX)
+            pos.setX(clampWrap(pos.x(), bounds.left(), bounds.right() + 1));
+        if (wrapY)
+            pos.setY(clampWrap(pos.y(), bounds.top(), bounds.bottom() + 1));
+
+        return bounds.contains(pos);
+    });
 }
 
 void TileLayer::offsetTiles(QPoint offset)
 {
-    const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, 0, 0);
-
-    // Process only the allocated chunks
-    QHashIterator<QPoint, Chunk> it(mChunks);
-    while (it.hasNext()) {
-        it.next();
+    if (offset.isNull())
+        return;
 
-        const QPoint p = it.key();
-        const Chunk &chunk = it.value();
-        const QRect r(p.x() * CHUNK_SIZE,
-                      p.y() * CHUNK_SIZE,
-                      CHUNK_SIZE, CHUNK_SIZE);
+    pageInAll();
 
-        for (int y = r.top(); y <= r.bottom(); ++y) {
-            for (int x = r.left(); x <= r.right(); ++x) {
-                int newX = x + offset.x();
-                int newY = y + offset.y();
-                newLayer->setCell(newX, newY, chunk.cellAt(x - r.left(), y - r.top()));
-            }
-        }
+    if (!(offset.x() & CHUNK_MASK) && !(offset.y() & CHUNK_MASK)) {
+        moveChunks(offset, QRect());
+    } else {
+        transformCells([&] (QPoint &pos, Cell &) {
+            pos += offset;
+            return true;
+        });
     }
-
-    mChunks = newLayer->mChunks;
-    mBounds = newLayer->mBounds;
 }
 
 bool TileLayer::canMergeWith(const Layer *other) const
@@ -701,6 +1450,14 @@ Layer *TileLayer::mergedWith(const Layer *other) const
     const TileLayer *o = static_cast<const TileLayer*>(other);
     TileLayer *merged = clone();
 
+    // The merged layer needs all cells of the other layer
+    std::unique_ptr<TileLayer> pagedIn;
+    if (o->hasPagedOutChunks()) {
+        pagedIn.reset(o->clone());
+        pagedIn->pageInAll();
+        o = pagedIn.get();
+    }
+
     if (map() && !map()->infinite()) {
         const QRect unitedRect = merged->rect().united(o->rect());
         const QPoint offset = merged->position() - unitedRect.topLeft();
@@ -718,32 +1475,109 @@ Layer *TileLayer::mergedWith(const Layer *other) const
 
 QRegion TileLayer::computeDiffRegion(const TileLayer &other) const
 {
-    QRegion ret;
+    TileRegion diff;
 
     const int dx = other.x() - mX;
     const int dy = other.y() - mY;
 
-    const QRect r = bounds().united(other.bounds()).translated(-position());
-
-    for (int y = r.top(); y <= r.bottom(); ++y) {
-        for (int x = r.left(); x <= r.right(); ++x) {
-            if (cellAt(x, y) != other.cellAt(x - dx, y - dy)) {
-                const int rangeStart = x;
-                while (x <= r.right() &&
-                       cellAt(x, y) != other.cellAt(x - dx, y - dy)) {
-                    ++x;
+    auto compareCells = [&] (const QRect &r) {
+        for (int y = r.top(); y <= r.bottom(); ++y) {
+            for (int x = r.left(); x <= r.right(); ++x) {
+                if (cellAt(x, y) != other.cellAt(x - dx, y - dy)) {
+                    const int rangeStart = x;
+                    while (x <= r.right() &&
+                           cellAt(x, y) != other.cellAt(x - dx, y - dy)) {
+                        ++x;
+                    }
+                    const int rangeEnd = x;
+                    diff.add(QRect(rangeStart, y, rangeEnd - rangeStart, 1));
                 }
-                const int rangeEnd = x;
-                ret += QRect(rangeStart, y, rangeEnd - rangeStart, 1);
             }
         }
+    };
+
+    if ((dx & CHUNK_MASK) || (dy & CHUNK_MASK)) {
+        compareCells(bounds().united(other.bounds()).translated(-position()));
+        return diff.toQRegion();
+    }
+
+    // When both layers use the same chunk grid, chunks that exist in only one
+    // of the layers, that share their data or that store the same data don't
+    // need to be compared cell by cell. Different content hashes are a quick
+    // way to tell the chunks differ, but equal hashes are not a proof that
+    // they are the same.
+    const QPoint chunkOffset(dx >> CHUNK_BITS, dy >> CHUNK_BITS);
+
+    for (auto it = mChunks.begin(); it != mChunks.end(); ++it) {
+        const QRect chunkRect(it.key().x() * CHUNK_SIZE, it.key().y() * CHUNK_SIZE,
+                              CHUNK_SIZE, CHUNK_SIZE);
+        const Chunk *otherChunk = other.mChunks.find(it.key() - chunkOffset);
+
+        if (!otherChunk)
+            diff.add(it.value().nonEmptyRegion(chunkRect.topLeft()));
+        else if (!it.value().isSharedWith(*otherChunk) &&
+                 (it.value().contentHash() != otherChunk->contentHash() ||
+                  !it.value().hasSameData(*otherChunk)))
+            compareCells(chunkRect);
+    }
+
+    for (auto it = other.mChunks.begin(); it != other.mChunks.end(); ++it) {
+        const QPoint chunkPos = it.key() + chunkOffset;
+        if (!mChunks.find(chunkPos))
+            diff.add(it.value().nonEmptyRegion(QPoint(chunkPos.x() * CHUNK_SIZE,
+                                                      chunkPos.y() * CHUNK_SIZE)));
+    }
+
+    return diff.toQRegion();
+}
+
+/**
+ * Returns a hash of the cells of this layer, relative to its position. It
+ * combines the content hashes of the chunks, so after changing some cells
+ * only the changed chunks need to be hashed again. Layers with the same
+ * cells have the same hash, regardless of how their chunks are encoded.
+ *
+ * Chunks that are paged out only contribute their position and their store,
+ * so the hash of a layer may change when its chunks are paged in or out.
+ *
+ * \sa Chunk::contentHash()
+ */
+quint64 TileLayer::contentHash() const
+{
+    if (const quint64 hash = mContentHash.loadRelaxed())
+        return hash;
+
+    auto positionHash = [] (QPoint chunkPos) {
+        return mixHash((static_cast<quint64>(static_cast<quint32>(chunkPos.x())) << 32)
+                       | static_cast<quint32>(chunkPos.y()));
+    };
+
+    // The chunk hashes are added up, since the order of the chunks in the
+    // index is not defined
+    quint64 hash = 0;
+    for (auto it = mChunks.begin(); it != mChunks.end(); ++it)
+        if (!it.value().isEmpty())
+            hash += mixHash(positionHash(it.key()) ^ it.value().contentHash());
+
+    if (!mPagedOutChunks.isEmpty()) {
+        const quint64 storeHash = mixHash(reinterpret_cast<quintptr>(mChunkStore.get()));
+        for (const QPoint &chunkPos : mPagedOutChunks)
+            hash += mixHash(positionHash(chunkPos) ^ storeHash);
     }
 
-    return ret;
+    if (hash == 0)
+        hash = 1;
+
+    mContentHash.storeRelaxed(hash);
+    return hash;
 }
 
 bool TileLayer::isEmpty() const
 {
+    // Only non-empty chunks are stored
+    if (!mPagedOutChunks.isEmpty())
+        return false;
+
     for (const Chunk &chunk : mChunks)
         if (!chunk.isEmpty())
             return false;
@@ -751,11 +1585,31 @@ bool TileLayer::isEmpty() const
     return true;
 }
 
-static bool compareRectPos(const QRect &a, const QRect &b)
+/**
+ * Returns an estimate of the number of bytes used by the chunks of this
+ * layer.
+ */
+qint64 TileLayer::memoryUsage() const
+{
+    qint64 bytes = sizeof(TileLayer);
+    for (const Chunk &chunk : mChunks)
+        bytes += chunk.memoryUsage();
+    return bytes;
+}
+
+/**
+ * Returns whether any of the tiles in \a region lie within \a rect.
+ */
+static bool intersects(const TileRegion &region, const QRect &rect)
 {
-    if (a.y() != b.y())
-        return a.y() < b.y();
-    return a.x() < b.x();
+    const auto &rows = region.rows();
+
+    for (auto it = rows.lowerBound(rect.top()); it != rows.end() && it.key() <= rect.bottom(); ++it)
+        for (const TileRegion::Span &span : it.value())
+            if (span.begin <= rect.right() && span.end > rect.left())
+                return true;
+
+    return false;
 }
 
 /**
@@ -768,78 +1622,270 @@ static bool compareRectPos(const QRect &a, const QRect &b)
 QVector<QRect> TileLayer::sortedChunksToWrite(QSize chunkSize) const
 {
     QVector<QRect> chunksToWrite;
-    QSet<QPoint> existingChunks;
 
     bool isNativeChunkSize = (chunkSize.width() == CHUNK_SIZE &&
                               chunkSize.height() == CHUNK_SIZE);
 
-    if (isNativeChunkSize)
+    if (isNativeChunkSize) {
+        // If the desired chunk size is equal to our native chunk size, then
+        // we just have to iterate our chunk list and return the bounds of
+        // each chunk. The chunks are already sorted by position.
         chunksToWrite.reserve(mChunks.size());
 
-    QHashIterator<QPoint, Chunk> it(mChunks);
-    while (it.hasNext()) {
-        it.next();
+        for (auto it = mChunks.begin(); it != mChunks.end(); ++it) {
+            if (it.value().isEmpty())
+                continue;
+
+            const QPoint &p = it.key();
+            chunksToWrite.append(QRect(p.x() * CHUNK_SIZE,
+                                       p.y() * CHUNK_SIZE,
+                                       CHUNK_SIZE, CHUNK_SIZE));
+        }
+
+        return chunksToWrite;
+    }
+
+    // Otherwise, we "rearrange" the chunks by determining which of the
+    // desired chunks each of our chunks overlaps with. To avoid writing empty
+    // chunks, only those overlapping with non-empty cells are included.
+    const int chunkWidth = chunkSize.width();
+    const int chunkHeight = chunkSize.height();
+
+    // Rounds down also for negative positions
+    auto chunkIndex = [] (int tile, int size) {
+        return tile >= 0 ? tile / size : (tile + 1) / size - 1;
+    };
+
+    QVector<QPoint> chunkPositions;
+
+    for (auto it = mChunks.begin(); it != mChunks.end(); ++it) {
         const Chunk &chunk = it.value();
         if (chunk.isEmpty())
             continue;
 
-        const QPoint &p = it.key();
+        const QPoint offset(it.key().x() * CHUNK_SIZE,
+                            it.key().y() * CHUNK_SIZE);
 
-        if (isNativeChunkSize) {
-            // If the desired chunk size is equal to our native chunk size,
-            // then we just we just have to iterate our chunk list and return
-            // the bounds of each chunk.
-            chunksToWrite.append(QRect(p.x() * CHUNK_SIZE,
-                                       p.y() * CHUNK_SIZE,
-                                       CHUNK_SIZE, CHUNK_SIZE));
-        } else {
-            // If the desired chunk size is not the native size, we have to do
-            // a bit of extra work and "rearrange" chunks as we iterate our
-            // list. We do this by iterating every cell in a chunk. If it's not
-            // empty, we check what chunk it should go into with the new chunk
-            // size. If that chunk doesn't exist yet, we create it.
-            //
-            // NOTE: Rather than checking every cell in every chunk, we could
-            // also just test which "new" chunks our "old" chunk would
-            // intersect with and return all of those, this would be faster.
-            // However, that way we could end up with completely empty chunks,
-            // so we'll take the slower route and iterate all cells instead to
-            // avoid that.
-            int oldChunkStartX = p.x() * CHUNK_SIZE;
-            int oldChunkStartY = p.y() * CHUNK_SIZE;
-
-            for (int y = 0; y < CHUNK_SIZE; ++y) {
-                for (int x = 0; x < CHUNK_SIZE; ++x) {
-                    const Cell &cell = chunk.cellAt(x, y);
-
-                    if (!cell.isEmpty()) {
-                        int tileX = oldChunkStartX + x;
-                        int tileY = oldChunkStartY + y;
-
-                        // Nasty conditionals because of potentially negative
-                        // chunk start position. Modulo with negative numbers
-                        // is weird and unintuitive in C++...
-                        int moduloX = tileX % chunkSize.width();
-                        int newChunkStartX = tileX - (moduloX < 0 ? moduloX + chunkSize.width() : moduloX);
-                        int moduloY = tileY % chunkSize.height();
-                        int newChunkStartY = tileY - (moduloY < 0 ? moduloY + chunkSize.height() : moduloY);
-                        QPoint startPoint(newChunkStartX, newChunkStartY);
-
-                        if (!existingChunks.contains(startPoint)) {
-                            existingChunks.insert(startPoint);
-                            chunksToWrite.append(QRect(newChunkStartX, newChunkStartY, chunkSize.width(), chunkSize.height()));
-                        }
-                    }
-                }
+        const QRect bounds = chunk.bounds().translated(offset);
+        const int left = chunkIndex(bounds.left(), chunkWidth);
+        const int right = chunkIndex(bounds.right(), chunkWidth);
+        const int top = chunkIndex(bounds.top(), chunkHeight);
+        const int bottom = chunkIndex(bounds.bottom(), chunkHeight);
+
+        // When the used area falls within a single chunk, it is known to
+        // contain non-empty cells
+        if (left == right && top == bottom) {
+            chunkPositions.append(QPoint(left, top));
+            continue;
+        }
+
+        const TileRegion region = chunk.nonEmptyRegion(offset);
+
+        for (int y = top; y <= bottom; ++y) {
+            for (int x = left; x <= right; ++x) {
+                const QRect rect(x * chunkWidth, y * chunkHeight, chunkWidth, chunkHeight);
+                if (intersects(region, rect))
+                    chunkPositions.append(QPoint(x, y));
             }
         }
     }
 
-    std::sort(chunksToWrite.begin(), chunksToWrite.end(), compareRectPos);
+    // Chunks may be found more than once, when they overlap with several of
+    // our chunks
+    std::sort(chunkPositions.begin(), chunkPositions.end(), [] (QPoint a, QPoint b) {
+        return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
+    });
+    chunkPositions.erase(std::unique(chunkPositions.begin(), chunkPositions.end()),
+                         chunkPositions.end());
+
+    chunksToWrite.reserve(chunkPositions.size());
+    for (const QPoint &position : std::as_const(chunkPositions))
+        chunksToWrite.append(QRect(position.x() * chunkWidth,
+                                   position.y() * chunkHeight,
+                                   chunkWidth, chunkHeight));
 
     return chunksToWrite;
 }
 
+/**
+ * Makes this layer use the given chunk \a store for the chunks at the
+ * \a storedChunks positions (in chunk coordinates), which are paged in when
+ * needed. The \a tilesetUseCounts of the stored chunks are needed to keep
+ * track of the used tilesets without loading them.
+ *
+ * Any chunks at the stored positions are replaced.
+ */
+void TileLayer::setChunkStore(std::shared_ptr<ChunkStore> store,
+                              const QVector<QPoint> &storedChunks,
+                              const QHash<Tileset*, int> &tilesetUseCounts)
+{
+    for (const QPoint &chunkPos : storedChunks) {
+        if (Chunk *chunk = mChunks.find(chunkPos)) {
+            for (const Cell &cell : std::as_const(*chunk))
+                releaseTileset(cell.tileset());
+            mChunks.remove(chunkPos);
+        }
+
+        mBounds |= QRect(chunkPos.x() * CHUNK_SIZE, chunkPos.y() * CHUNK_SIZE,
+                         CHUNK_SIZE, CHUNK_SIZE);
+    }
+
+    for (auto it = tilesetUseCounts.begin(); it != tilesetUseCounts.end(); ++it)
+        mTilesetUseCounts[it.key()] += it.value();
+
+    mChunkStore = std::move(store);
+    mPagedOutChunks = QSet<QPoint>(storedChunks.begin(), storedChunks.end());
+    mFailedChunks.clear();
+    mChunkLastUse.clear();
+    invalidateContentHash();
+}
+
+/**
+ * Loads the stored chunk at \a chunkPos, which needs to be paged out.
+ *
+ * When the chunk can't be loaded, it stays paged out and is remembered as
+ * failed, and false is returned. Loading a failed chunk is not attempted
+ * again, to avoid repeating the error on every access.
+ */
+bool TileLayer::pageInChunk(QPoint chunkPos)
+{
+    Q_ASSERT(mPagedOutChunks.contains(chunkPos));
+
+    if (mFailedChunks.contains(chunkPos))
+        return false;
+
+    Chunk chunk;
+    if (!mChunkStore->loadChunk(chunkPos, chunk)) {
+        qWarning() << "Failed to load chunk" << chunkPos << "of layer" << mName;
+        mFailedChunks.insert(chunkPos);
+        return false;
+    }
+
+    mPagedOutChunks.remove(chunkPos);
+    mChunks[chunkPos] = chunk;
+    mChunkLastUse.insert(chunkPos, mChunkUseCounter);
+    invalidateContentHash();
+    return true;
+}
+
+/**
+ * Makes sure the stored chunks within \a rect (in local tile coordinates)
+ * are in memory. When this exceeds the memory budget of the chunk store,
+ * the least recently used unchanged chunks outside of \a rect are paged out
+ * again.
+ *
+ * Returns false when any of the chunks failed to load.
+ *
+ * Paging in doesn't change the contents of the layer, but it does change
+ * its chunks, so it should not be done while the layer is used by other
+ * threads.
+ */
+bool TileLayer::pageIn(const QRect &rect)
+{
+    if (mPagedOutChunks.isEmpty() || rect.isEmpty())
+        return true;
+
+    const QRect chunkArea(QPoint(rect.left() >> CHUNK_BITS, rect.top() >> CHUNK_BITS),
+                          QPoint(rect.right() >> CHUNK_BITS, rect.bottom() >> CHUNK_BITS));
+
+    ++mChunkUseCounter;
+
+    // The chunks in the area count as used, also when already in memory
+    for (auto it = mChunkLastUse.begin(); it != mChunkLastUse.end(); ++it)
+        if (chunkArea.contains(it.key()))
+            it.value() = mChunkUseCounter;
+
+    QVector<QPoint> toLoad;
+    if (qint64(chunkArea.width()) * chunkArea.height() < mPagedOutChunks.size()) {
+        for (int y = chunkArea.top(); y <= chunkArea.bottom(); ++y)
+            for (int x = chunkArea.left(); x <= chunkArea.right(); ++x)
+                if (mPagedOutChunks.contains(QPoint(x, y)))
+                    toLoad.append(QPoint(x, y));
+    } else {
+        for (const QPoint &chunkPos : std::as_const(mPagedOutChunks))
+            if (chunkArea.contains(chunkPos))
+                toLoad.append(chunkPos);
+    }
+
+    if (toLoad.isEmpty())
+        return true;
+
+    bool success = true;
+    for (const QPoint &chunkPos : std::as_const(toLoad))
+        success &= pageInChunk(chunkPos);
+
+    pageOut(mChunkStore->memoryBudget());
+    return success;
+}
+
+/**
+ * Loads all stored chunks, for operations that need all cells of the layer.
+ * Returns false when any of the chunks failed to load.
+ */
+bool TileLayer::pageInAll()
+{
+    if (mPagedOutChunks.isEmpty())
+        return true;
+
+    ++mChunkUseCounter;
+
+    bool success = true;
+    const QList<QPoint> pagedOutChunks = mPagedOutChunks.values();
+    for (const QPoint &chunkPos : pagedOutChunks)
+        success &= pageInChunk(chunkPos);
+
+    return success;
+}
+
+/**
+ * Pages out the least recently used chunks that were not changed since they
+ * were loaded, until the chunks of this layer use at most \a memoryBudget
+ * bytes, or no unchanged chunks are left. The chunks used by the last
+ * pageIn() or pageInAll() are kept.
+ */
+void TileLayer::pageOut(qint64 memoryBudget)
+{
+    if (!mChunkStore)
+        return;
+
+    qint64 usage = memoryUsage();
+    if (usage <= memoryBudget)
+        return;
+
+    struct Candidate
+    {
+        quint64 lastUse;
+        QPoint chunkPos;
+        qint64 bytes;
+    };
+
+    QVector<Candidate> candidates;
+    for (auto it = mChunkLastUse.begin(); it != mChunkLastUse.end(); ++it) {
+        if (it.value() == mChunkUseCounter)
+            continue;
+
+        const Chunk *chunk = mChunks.find(it.key());
+        if (chunk && mChunkStore->isUnchanged(it.key(), *chunk))
+            candidates.append({ it.value(), it.key(), chunk->memoryUsage() });
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [] (const Candidate &a, const Candidate &b) {
+        return a.lastUse < b.lastUse;
+    });
+
+    for (const Candidate &candidate : std::as_const(candidates)) {
+        if (usage <= memoryBudget)
+            break;
+
+        mChunks.remove(candidate.chunkPos);
+        mChunkLastUse.remove(candidate.chunkPos);
+        mPagedOutChunks.insert(candidate.chunkPos);
+        mChunkStore->forget(candidate.chunkPos);
+        usage -= candidate.bytes;
+        invalidateContentHash();
+    }
+}
+
 /**
  * Returns a duplicate of this TileLayer.
  *
@@ -855,8 +1901,13 @@ TileLayer *TileLayer::initializeClone(TileLayer *clone) const
     Layer::initializeClone(clone);
     clone->mChunks = mChunks;
     clone->mBounds = mBounds;
-    clone->mUsedTilesets = mUsedTilesets;
-    clone->mUsedTilesetsDirty = mUsedTilesetsDirty;
+    clone->mTilesetUseCounts = mTilesetUseCounts;
+    clone->mChunkStore = mChunkStore;
+    clone->mPagedOutChunks = mPagedOutChunks;
+    clone->mFailedChunks = mFailedChunks;
+    clone->mChunkLastUse = mChunkLastUse;
+    clone->mChunkUseCounter = mChunkUseCounter;
+    clone->mContentHash.storeRelaxed(mContentHash.loadRelaxed());
     return clone;
 }
 
@@ -34,16 +34,22 @@
 #include "layer.h"
 #include "tiled.h"
 #include "tile.h"
+#include "tileregion.h"
 #include "tileset.h"
 
+#include <QAtomicInteger>
 #include <QHash>
 #include <QMargins>
 #include <QPoint>
+#include <QSharedDataPointer>
 #include <QSharedPointer>
 #include <QString>
 #include <QVector>
 
 #include <functional>
+#include <map>
+#include <memory>
+#include <vector>
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 inline uint qHash(QPoint key, uint seed = 0) Q_DECL_NOTHROW
@@ -56,6 +62,7 @@ inline uint qHash(QPoint key, uint seed = 0) Q_DECL_NOTHROW
 
 namespace Tiled {
 
+class ChunkStore;
 class Tile;
 
 /**
@@ -135,6 +142,8 @@ public:
     static Cell empty;
 
 private:
+    friend class Chunk;
+
     Tileset *_tileset = nullptr;
     int _tileId = -1;
     int _flags = 0;
@@ -167,118 +176,388 @@ inline bool Cell::refersTile(const Tile *tile) const
 
 /**
  * A Chunk is a grid of cells of size CHUNK_SIZExCHUNK_SIZE.
+ *
+ * To save memory, the cells are stored in packed form. Each chunk has a
+ * small palette of the tilesets it refers to and each cell is stored as a
+ * 16-bit or 32-bit word, containing the index into this palette, the tile ID
+ * and the flags. When a cell no longer fits the current word size, the chunk
+ * is widened, falling back to storing full Cell instances when needed.
+ *
+ * Since cells are decoded on access, they are returned by value.
+ *
+ * Each chunk also keeps track of its number of non-empty cells and their
+ * bounding rectangle, so that these don't require scanning the cells. A hash
+ * of its cells is computed on demand and kept until the chunk is changed.
  */
 class TILEDSHARED_EXPORT Chunk
 {
 public:
+    class const_iterator
+    {
+    public:
+        const_iterator(const Chunk *chunk, int index)
+            : mChunk(chunk)
+            , mIndex(index)
+        {}
+
+        const_iterator operator++(int)
+        {
+            const_iterator it = *this;
+            ++mIndex;
+            return it;
+        }
+
+        const_iterator &operator++()
+        {
+            ++mIndex;
+            return *this;
+        }
+
+        Cell operator*() const { return mChunk->cellAtIndex(mIndex); }
+
+        int index() const { return mIndex; }
+
+        friend bool operator==(const const_iterator &lhs, const const_iterator &rhs)
+        {
+            return lhs.mIndex == rhs.mIndex;
+        }
+
+        friend bool operator!=(const const_iterator &lhs, const const_iterator &rhs)
+        {
+            return lhs.mIndex != rhs.mIndex;
+        }
+
+    private:
+        const Chunk *mChunk;
+        int mIndex;
+    };
+
+    enum Format : quint8 {
+        Packed16,
+        Packed32,
+        Unpacked,
+    };
+
     Chunk() :
-        mGrid(CHUNK_SIZE * CHUNK_SIZE)
+        d(new Data)
     {}
 
     QRegion region(std::function<bool (const Cell &)> condition) const;
 
-    const Cell &cellAt(int x, int y) const;
-    const Cell &cellAt(QPoint point) const;
+    template<typename Condition>
+    TileRegion tileRegion(const Condition &condition, QPoint offset = QPoint()) const;
+    TileRegion nonEmptyRegion(QPoint offset = QPoint()) const;
+
+    Cell cellAt(int x, int y) const;
+    Cell cellAt(QPoint point) const;
 
     void setCell(int x, int y, const Cell &cell);
 
-    bool isEmpty() const;
+    bool isEmpty() const { return d->cellCount == 0; }
+    bool isFull() const { return d->cellCount == CHUNK_SIZE * CHUNK_SIZE; }
+    int cellCount() const { return d->cellCount; }
+    QRect bounds() const { return d->bounds; }
 
-    bool hasCell(std::function<bool (const Cell &)> condition) const;
+    qint64 memoryUsage() const;
+
+    template<typename Condition>
+    bool hasCell(const Condition &condition) const;
 
     void removeReferencesToTileset(Tileset *tileset);
 
     void replaceReferencesToTileset(Tileset *oldTileset, Tileset *newTileset);
 
-    QVector<Cell>::iterator begin() { return mGrid.begin(); }
-    QVector<Cell>::iterator end() { return mGrid.end(); }
-    QVector<Cell>::const_iterator begin() const { return mGrid.begin(); }
-    QVector<Cell>::const_iterator end() const { return mGrid.end(); }
+    Format format() const { return d->format; }
+
+    bool isSharedWith(const Chunk &other) const { return d == other.d; }
+    bool hasSameData(const Chunk &other) const;
+
+    quint64 contentHash() const;
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, CHUNK_SIZE * CHUNK_SIZE); }
 
 private:
-    QVector<Cell> mGrid;
+    Cell cellAtIndex(int index) const;
+    bool isEmptyAt(int index) const;
+    Cell decode(quint32 word, int paletteShift, int tileIdShift) const;
+    bool encode(const Cell &cell, Format format, quint32 &word);
+    void store(int index, const Cell &cell);
+    int paletteIndex(Tileset *tileset);
+    bool references(const Tileset *tileset) const;
+    void widen(Format format);
+    void shrinkBounds();
+    void recount();
+    void invalidateHash() { d->hash.storeRelaxed(0); }
+
+    /**
+     * The cell data is implicitly shared, so that copying a chunk (for
+     * example when cloning a layer or for undo) is cheap. It is detached
+     * when the chunk is modified.
+     */
+    struct Data : QSharedData
+    {
+        Data()
+            : words16(CHUNK_SIZE * CHUNK_SIZE)
+        {}
+
+        Format format = Packed16;
+        int cellCount = 0;      // number of non-empty cells
+        QRect bounds;           // bounding rect of the non-empty cells
+        mutable QAtomicInteger<quint64> hash;   // of the cells, 0 when unknown
+        QVector<Tileset*> palette;
+        QVector<quint16> words16;
+        QVector<quint32> words32;
+        QVector<Cell> cells;
+    };
+
+    QSharedDataPointer<Data> d;
 };
 
-inline const Cell &Chunk::cellAt(int x, int y) const
+namespace ChunkFormat {
+
+// Bit layout of the packed cell words. The lowest bits store the cell flags,
+// followed by the palette index (0 meaning "no tileset") and the tile ID.
+constexpr int FlagsBits = 5;
+constexpr quint32 FlagsMask = (1 << FlagsBits) - 1;
+
+constexpr int Palette16Bits = 3;
+constexpr int TileId16Shift = FlagsBits + Palette16Bits;
+constexpr int Palette32Bits = 8;
+constexpr int TileId32Shift = FlagsBits + Palette32Bits;
+
+} // namespace ChunkFormat
+
+inline Cell Chunk::decode(quint32 word, int paletteShift, int tileIdShift) const
+{
+    const int paletteMask = (1 << (tileIdShift - paletteShift)) - 1;
+    const int palette = (word >> paletteShift) & paletteMask;
+
+    Cell cell;
+    if (palette)
+        cell.setTile(d->palette.at(palette - 1), static_cast<int>(word >> tileIdShift));
+    cell._flags = word & ChunkFormat::FlagsMask;
+    return cell;
+}
+
+inline Cell Chunk::cellAtIndex(int index) const
 {
-    return mGrid.at(x + y * CHUNK_SIZE);
+    using namespace ChunkFormat;
+
+    switch (d->format) {
+    case Packed16:
+        return decode(d->words16.at(index), FlagsBits, TileId16Shift);
+    case Packed32:
+        return decode(d->words32.at(index), FlagsBits, TileId32Shift);
+    case Unpacked:
+        break;
+    }
+    return d->cells.at(index);
 }
 
-inline const Cell &Chunk::cellAt(QPoint point) const
+inline bool Chunk::isEmptyAt(int index) const
+{
+    switch (d->format) {
+    case Packed16:
+        return (d->words16.at(index) >> ChunkFormat::FlagsBits) == 0;
+    case Packed32:
+        return (d->words32.at(index) >> ChunkFormat::FlagsBits) == 0;
+    case Unpacked:
+        break;
+    }
+    return d->cells.at(index).isEmpty();
+}
+
+inline Cell Chunk::cellAt(int x, int y) const
+{
+    return cellAtIndex(x + y * CHUNK_SIZE);
+}
+
+inline Cell Chunk::cellAt(QPoint point) const
 {
     return cellAt(point.x(), point.y());
 }
 
 /**
- * A tile layer is a grid of cells. Each cell refers to a specific tile, and
- * stores how the tile is flipped.
+ * Returns the region of the cells matching the given \a condition, moved by
+ * the given \a offset.
  *
- * Coordinates and regions passed to function parameters are in local
- * coordinates and do not take into account the position of the layer.
+ * The condition is a template parameter, so that it can be inlined.
  */
-class TILEDSHARED_EXPORT TileLayer : public Layer
+template<typename Condition>
+inline TileRegion Chunk::tileRegion(const Condition &condition, QPoint offset) const
 {
-public:
-    class iterator
+    TileRegion region;
+
+    for (int y = 0; y < CHUNK_SIZE; ++y) {
+        for (int x = 0; x < CHUNK_SIZE; ++x) {
+            if (condition(cellAt(x, y))) {
+                const int rangeStart = x;
+                for (++x; x <= CHUNK_SIZE; ++x) {
+                    if (x == CHUNK_SIZE || !condition(cellAt(x, y))) {
+                        const int rangeEnd = x;
+                        region.add(QRect(offset.x() + rangeStart, offset.y() + y,
+                                         rangeEnd - rangeStart, 1));
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return region;
+}
+
+/**
+ * Returns whether this chunk contains a cell for which the given
+ * \a condition returns true.
+ */
+template<typename Condition>
+inline bool Chunk::hasCell(const Condition &condition) const
+{
+    for (const Cell &cell : *this)
+        if (condition(cell))
+            return true;
+
+    return false;
+}
+
+/**
+ * An index of the chunks of a tile layer, ordered by their position row by
+ * row.
+ *
+ * Iterating the index visits the chunks in spatial order, which is cache
+ * friendly and deterministic. While the chunks are densely packed, which is
+ * usually the case for finite maps, lookups go through a 2D table of chunk
+ * pointers. For sparse infinite maps, lookups fall back to the ordered map.
+ */
+class TILEDSHARED_EXPORT ChunkIndex
+{
+    struct PositionLess
     {
-    public:
-        iterator(QHash<QPoint, Chunk>::iterator it, QHash<QPoint, Chunk>::iterator end)
-            : mChunkPointer(it)
-            , mChunkEndPointer(end)
+        bool operator()(QPoint a, QPoint b) const
         {
-            if (it != end)
-                mCellPointer = it.value().begin();
+            return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
         }
+    };
+
+    using Container = std::map<QPoint, Chunk, PositionLess>;
 
-        iterator operator++(int)
+public:
+    template<typename ContainerIterator, typename T>
+    class Iterator
+    {
+    public:
+        Iterator(ContainerIterator it)
+            : mIterator(it)
+        {}
+
+        Iterator operator++(int)
         {
-            iterator it = *this;
-            advance();
+            Iterator it = *this;
+            ++mIterator;
             return it;
         }
 
-        iterator &operator++()
+        Iterator &operator++()
         {
-            advance();
+            ++mIterator;
             return *this;
         }
 
-        Cell &operator*() { return *mCellPointer; }
+        T &operator*() const { return mIterator->second; }
+        T *operator->() const { return &mIterator->second; }
 
-        QVector<Cell>::iterator operator->() const { return mCellPointer; }
-
-        friend bool operator==(const iterator& lhs, const iterator& rhs)
+        friend bool operator==(const Iterator &lhs, const Iterator &rhs)
         {
-            if (lhs.mChunkPointer == lhs.mChunkEndPointer || rhs.mChunkPointer == rhs.mChunkEndPointer)
-                return lhs.mChunkPointer == rhs.mChunkPointer;
-
-            return lhs.mCellPointer == rhs.mCellPointer;
+            return lhs.mIterator == rhs.mIterator;
         }
 
-        friend bool operator!=(const iterator& lhs, const iterator& rhs)
+        friend bool operator!=(const Iterator &lhs, const Iterator &rhs)
         {
-            if (lhs.mChunkPointer == lhs.mChunkEndPointer || rhs.mChunkPointer == rhs.mChunkEndPointer)
-                return lhs.mChunkPointer != rhs.mChunkPointer;
-
-            return lhs.mCellPointer != rhs.mCellPointer;
+            return lhs.mIterator != rhs.mIterator;
         }
 
-        Cell &value() const { return *mCellPointer; }
-
-        QPoint key() const;
+        QPoint key() const { return mIterator->first; }
+        T &value() const { return mIterator->second; }
 
     private:
-        void advance();
-
-        QHash<QPoint, Chunk>::iterator mChunkPointer;
-        QHash<QPoint, Chunk>::iterator mChunkEndPointer;
-        QVector<Cell>::iterator mCellPointer;
+        ContainerIterator mIterator;
     };
 
+    using iterator = Iterator<Container::iterator, Chunk>;
+    using const_iterator = Iterator<Container::const_iterator, const Chunk>;
+
+    ChunkIndex() = default;
+    ChunkIndex(const ChunkIndex &other);
+    ChunkIndex(ChunkIndex &&other) noexcept;
+
+    ChunkIndex &operator=(const ChunkIndex &other);
+    ChunkIndex &operator=(ChunkIndex &&other) noexcept;
+
+    int size() const { return static_cast<int>(mChunks.size()); }
+    bool isEmpty() const { return mChunks.empty(); }
+
+    /**
+     * Returns the bounding rect of the chunks, in chunk coordinates.
+     */
+    QRect area() const { return mArea; }
+
+    Chunk &operator[](QPoint position);
+
+    Chunk *find(QPoint position);
+    const Chunk *find(QPoint position) const;
+
+    void remove(QPoint position);
+    void clear();
+
+    iterator begin() { return iterator(mChunks.begin()); }
+    iterator end() { return iterator(mChunks.end()); }
+    const_iterator begin() const { return const_iterator(mChunks.begin()); }
+    const_iterator end() const { return const_iterator(mChunks.end()); }
+
+private:
+    int tableIndex(QPoint position) const;
+    void updateTable();
+
+    Container mChunks;
+    QRect mArea;
+    std::vector<Chunk*> mTable;     // empty when sparse
+};
+
+inline int ChunkIndex::tableIndex(QPoint position) const
+{
+    return (position.y() - mArea.y()) * mArea.width() + (position.x() - mArea.x());
+}
+
+inline Chunk *ChunkIndex::find(QPoint position)
+{
+    return const_cast<Chunk*>(std::as_const(*this).find(position));
+}
+
+inline const Chunk *ChunkIndex::find(QPoint position) const
+{
+    if (!mTable.empty())
+        return mArea.contains(position) ? mTable[tableIndex(position)] : nullptr;
+
+    auto it = mChunks.find(position);
+    return it != mChunks.end() ? &it->second : nullptr;
+}
+
+/**
+ * A tile layer is a grid of cells. Each cell refers to a specific tile, and
+ * stores how the tile is flipped.
+ *
+ * Coordinates and regions passed to function parameters are in local
+ * coordinates and do not take into account the position of the layer.
+ */
+class TILEDSHARED_EXPORT TileLayer : public Layer
+{
+public:
     class const_iterator
     {
     public:
-        const_iterator(QHash<QPoint, Chunk>::const_iterator it, QHash<QPoint, Chunk>::const_iterator end)
+        const_iterator(ChunkIndex::const_iterator it, ChunkIndex::const_iterator end)
             : mChunkPointer(it)
             , mChunkEndPointer(end)
         {
@@ -299,38 +578,36 @@ public:
             return *this;
         }
 
-        const Cell &operator*() { return *mCellPointer; }
-
-        QVector<Cell>::const_iterator operator->() const { return mCellPointer; }
+        Cell operator*() const { return *mCellPointer; }
 
         friend bool operator==(const const_iterator& lhs, const const_iterator& rhs)
         {
             if (lhs.mChunkPointer == lhs.mChunkEndPointer || rhs.mChunkPointer == rhs.mChunkEndPointer)
                 return lhs.mChunkPointer == rhs.mChunkPointer;
 
-            return lhs.mCellPointer == rhs.mCellPointer;
+            return lhs.mChunkPointer == rhs.mChunkPointer && lhs.mCellPointer == rhs.mCellPointer;
         }
 
         friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs)
         {
-            if (lhs.mChunkPointer == lhs.mChunkEndPointer || rhs.mChunkPointer == rhs.mChunkEndPointer)
-                return lhs.mChunkPointer != rhs.mChunkPointer;
-
-            return lhs.mCellPointer != rhs.mCellPointer;
+            return !(lhs == rhs);
         }
 
-        const Cell &value() const { return *mCellPointer; }
+        Cell value() const { return *mCellPointer; }
 
         QPoint key() const;
 
     private:
         void advance();
 
-        QHash<QPoint, Chunk>::const_iterator mChunkPointer;
-        QHash<QPoint, Chunk>::const_iterator mChunkEndPointer;
-        QVector<Cell>::const_iterator mCellPointer;
+        ChunkIndex::const_iterator mChunkPointer;
+        ChunkIndex::const_iterator mChunkEndPointer;
+        Chunk::const_iterator mCellPointer { nullptr, 0 };
     };
 
+    // Cells are stored in packed form, so they can't be modified in-place
+    using iterator = const_iterator;
+
     /**
      * Constructor.
      */
@@ -367,6 +644,8 @@ public:
      */
     QRect localBounds() const { return mBounds; }
 
+    QRect usedBounds() const;
+
     QRect rect() const { return QRect(mX, mY, mWidth, mHeight); }
 
     QMargins drawMargins() const;
@@ -382,14 +661,21 @@ public:
     QRegion region() const;
     QRegion modifiedRegion() const;
 
-    const Cell &cellAt(int x, int y) const;
-    const Cell &cellAt(QPoint point) const;
+    template<typename Condition>
+    TileRegion tileRegion(const Condition &condition) const;
+    TileRegion tileRegion() const;
+
+    Cell cellAt(int x, int y) const;
+    Cell cellAt(QPoint point) const;
 
     void setCell(int x, int y, const Cell &cell);
 
     /**
      * Returns a copy of the area specified by the given \a region. The
      * caller is responsible for the returned tile layer.
+     *
+     * Stored chunks that are paged out are copied as empty, so the area
+     * should be paged in first (see pageIn()).
      */
     std::unique_ptr<TileLayer> copy(const QRegion &region) const;
 
@@ -454,7 +740,7 @@ public:
     void rotateHexagonal(RotateDirection direction, Map *map);
 
     /**
-     * Computes and returns the set of tilesets used by this tile layer.
+     * Returns the set of tilesets used by this tile layer.
      */
     QSet<SharedTileset> usedTilesets() const override;
 
@@ -462,13 +748,16 @@ public:
      * Returns whether this tile layer has any cell for which the given
      * \a condition returns true.
      */
-    bool hasCell(std::function<bool (const Cell &)> condition) const;
+    template<typename Condition>
+    bool hasCell(const Condition &condition) const;
 
     /**
      * Returns whether this tile layer is referencing the given tileset.
      */
     bool referencesTileset(const Tileset *tileset) const override;
 
+    int tilesetUseCount(const Tileset *tileset) const;
+
     /**
      * Removes all references to the given tileset. This sets all tiles on this
      * layer that are from the given tileset to null.
@@ -519,10 +808,39 @@ public:
      */
     bool isEmpty() const override;
 
+    quint64 contentHash() const;
+
+    qint64 memoryUsage() const;
+
+    void setChunkStore(std::shared_ptr<ChunkStore> store,
+                       const QVector<QPoint> &storedChunks,
+                       const QHash<Tileset*, int> &tilesetUseCounts);
+
+    /**
+     * Returns the store providing the chunks that are not in memory, if any.
+     */
+    ChunkStore *chunkStore() const { return mChunkStore.get(); }
+
+    /**
+     * Returns the positions (in chunk coordinates) of the stored chunks that
+     * are currently not in memory. This includes the failed chunks.
+     */
+    const QSet<QPoint> &pagedOutChunks() const { return mPagedOutChunks; }
+    bool hasPagedOutChunks() const { return !mPagedOutChunks.isEmpty(); }
+
+    /**
+     * Returns the positions (in chunk coordinates) of the stored chunks that
+     * could not be loaded. These remain paged out, and changes to their
+     * cells are ignored, so that their stored cells are not lost.
+     */
+    const QSet<QPoint> &failedChunks() const { return mFailedChunks; }
+
+    bool pageIn(const QRect &rect);
+    bool pageInAll();
+    void pageOut(qint64 memoryBudget);
+
     TileLayer *clone() const override;
 
-    iterator begin() { return iterator(mChunks.begin(), mChunks.end()); }
-    iterator end() { return iterator(mChunks.end(), mChunks.end()); }
     const_iterator begin() const { return const_iterator(mChunks.begin(), mChunks.end()); }
     const_iterator end() const { return const_iterator(mChunks.end(), mChunks.end()); }
 
@@ -532,36 +850,30 @@ protected:
     TileLayer *initializeClone(TileLayer *clone) const;
 
 private:
+    QSet<QPoint> shareChunks(int x, int y, const TileLayer *layer, const QRegion &area);
+    bool shareChunk(QPoint chunkPos, const Chunk &chunk);
+    bool hasChunksIn(const QRect &rect) const;
+    TileRegion mergeChunkRegions(const std::function<TileRegion (const Chunk &, QPoint)> &chunkRegion) const;
+    void transformCells(const std::function<bool (QPoint &, Cell &)> &transform);
+    void moveChunks(QPoint offset, const QRect &clip);
+    void releaseTileset(Tileset *tileset);
+    bool pageInChunk(QPoint chunkPos);
+    void invalidateContentHash() { mContentHash.storeRelaxed(0); }
+
     int mWidth;
     int mHeight;
-    QHash<QPoint, Chunk> mChunks;
+    ChunkIndex mChunks;
     QRect mBounds;
-    mutable QSet<SharedTileset> mUsedTilesets;
-    mutable bool mUsedTilesetsDirty;
-};
+    QHash<Tileset*, int> mTilesetUseCounts;     // includes paged out chunks
 
-inline QPoint TileLayer::iterator::key() const
-{
-    const QPoint chunkPos = mChunkPointer.key();
-    QPoint tilePos = QPoint(chunkPos.x() * CHUNK_SIZE,
-                            chunkPos.y() * CHUNK_SIZE);
+    std::shared_ptr<ChunkStore> mChunkStore;
+    QSet<QPoint> mPagedOutChunks;
+    QSet<QPoint> mFailedChunks;                 // subset of mPagedOutChunks
+    QHash<QPoint, quint64> mChunkLastUse;       // of the chunks paged in
+    quint64 mChunkUseCounter = 0;
 
-    const auto index = std::distance(mChunkPointer.value().begin(), mCellPointer);
-    tilePos += QPoint(index & CHUNK_MASK, index / CHUNK_SIZE);
-
-    return tilePos;
-}
-
-inline void TileLayer::iterator::advance()
-{
-    if (mChunkPointer != mChunkEndPointer) {
-        if (++mCellPointer == mChunkPointer.value().end()) {
-            mChunkPointer++;
-            if (mChunkPointer != mChunkEndPointer)
-                mCellPointer = mChunkPointer.value().begin();
-        }
-    }
-}
+    mutable QAtomicInteger<quint64> mContentHash;   // 0 when unknown
+};
 
 inline QPoint TileLayer::const_iterator::key() const
 {
@@ -569,7 +881,7 @@ inline QPoint TileLayer::const_iterator::key() const
     QPoint tilePos = QPoint(chunkPos.x() * CHUNK_SIZE,
                             chunkPos.y() * CHUNK_SIZE);
 
-    const auto index = std::distance(mChunkPointer.value().begin(), mCellPointer);
+    const int index = mCellPointer.index();
     tilePos += QPoint(index & CHUNK_MASK, index / CHUNK_SIZE);
 
     return tilePos;
@@ -605,17 +917,22 @@ inline bool TileLayer::contains(QPoint point) const
     return contains(point.x(), point.y());
 }
 
+/**
+ * Returns the chunk at the given coordinates, creating it when needed. A
+ * stored chunk needs to be paged in first.
+ */
 inline Chunk& TileLayer::chunk(int x, int y)
 {
     const QPoint chunkCoordinates(x >> CHUNK_BITS, y >> CHUNK_BITS);
+    Q_ASSERT(!mPagedOutChunks.contains(chunkCoordinates));
+    invalidateContentHash();
     return mChunks[chunkCoordinates];
 }
 
 inline const Chunk* TileLayer::findChunk(int x, int y) const
 {
     const QPoint chunkCoordinates(x >> CHUNK_BITS, y >> CHUNK_BITS);
-    auto it = mChunks.find(chunkCoordinates);
-    return it != mChunks.end() ? &it.value() : nullptr;
+    return mChunks.find(chunkCoordinates);
 }
 
 /**
@@ -624,7 +941,47 @@ inline const Chunk* TileLayer::findChunk(int x, int y) const
  */
 inline QRegion TileLayer::region() const
 {
-    return region([] (const Cell &cell) { return !cell.isEmpty(); });
+    return tileRegion().toQRegion();
+}
+
+/**
+ * Same as region(), but returns a TileRegion, which is cheaper to compute and
+ * to combine with other regions.
+ *
+ * The chunks are scanned in parallel, so the \a condition may be called from
+ * several threads at once.
+ */
+template<typename Condition>
+inline TileRegion TileLayer::tileRegion(const Condition &condition) const
+{
+    return mergeChunkRegions([&condition] (const Chunk &chunk, QPoint offset) {
+        return chunk.tileRegion(condition, offset);
+    });
+}
+
+/**
+ * Same as region(), but returns a TileRegion.
+ */
+inline TileRegion TileLayer::tileRegion() const
+{
+    return mergeChunkRegions([] (const Chunk &chunk, QPoint offset) {
+        return chunk.nonEmptyRegion(offset);
+    });
+}
+
+/**
+ * Returns whether this layer contains a cell for which the given
+ * \a condition returns true.
+ */
+template<typename Condition>
+inline bool TileLayer::hasCell(const Condition &condition) const
+{
+    for (const Chunk &chunk : mChunks) {
+        if (chunk.hasCell(condition))
+            return true;
+    }
+
+    return false;
 }
 
 /**
@@ -639,10 +996,10 @@ inline QRegion TileLayer::modifiedRegion() const
 }
 
 /**
- * Returns a read-only reference to the cell at the given coordinates. The
- * coordinates have to be within this layer.
+ * Returns the cell at the given coordinates. The coordinates have to be within
+ * this layer.
  */
-inline const Cell &TileLayer::cellAt(int x, int y) const
+inline Cell TileLayer::cellAt(int x, int y) const
 {
     if (const Chunk *chunk = findChunk(x, y))
         return chunk->cellAt(x & CHUNK_MASK, y & CHUNK_MASK);
@@ -650,7 +1007,7 @@ inline const Cell &TileLayer::cellAt(int x, int y) const
     return Cell::empty;
 }
 
-inline const Cell &TileLayer::cellAt(QPoint point) const
+inline Cell TileLayer::cellAt(QPoint point) const
 {
     return cellAt(point.x(), point.y());
 }
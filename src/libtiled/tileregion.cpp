@@ -0,0 +1,332 @@
+/*
+ * tileregion.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tileregion.h"
+
+#include <algorithm>
+
+namespace Tiled {
+
+using Span = TileRegion::Span;
+using Spans = TileRegion::Spans;
+
+static Spans uniteSpans(const Spans &a, const Spans &b)
+{
+    Spans result;
+    result.reserve(a.size() + b.size());
+
+    auto append = [&result] (const Span &span) {
+        if (!result.isEmpty() && span.begin <= result.last().end)
+            result.last().end = std::max(result.last().end, span.end);
+        else
+            result.append(span);
+    };
+
+    auto i = a.begin();
+    auto j = b.begin();
+    while (i != a.end() && j != b.end()) {
+        if (i->begin < j->begin)
+            append(*i++);
+        else
+            append(*j++);
+    }
+    for (; i != a.end(); ++i)
+        append(*i);
+    for (; j != b.end(); ++j)
+        append(*j);
+
+    return result;
+}
+
+static Spans intersectSpans(const Spans &a, const Spans &b)
+{
+    Spans result;
+
+    auto i = a.begin();
+    auto j = b.begin();
+    while (i != a.end() && j != b.end()) {
+        const int begin = std::max(i->begin, j->begin);
+        const int end = std::min(i->end, j->end);
+        if (begin < end)
+            result.append({ begin, end });
+
+        if (i->end < j->end)
+            ++i;
+        else
+            ++j;
+    }
+
+    return result;
+}
+
+static Spans subtractSpans(const Spans &a, const Spans &b)
+{
+    Spans result;
+
+    auto j = b.begin();
+    for (const Span &span : a) {
+        while (j != b.end() && j->end <= span.begin)
+            ++j;
+
+        int begin = span.begin;
+        for (auto k = j; k != b.end() && k->begin < span.end; ++k) {
+            if (k->begin > begin)
+                result.append({ begin, k->begin });
+            begin = std::max(begin, k->end);
+        }
+
+        if (begin < span.end)
+            result.append({ begin, span.end });
+    }
+
+    return result;
+}
+
+TileRegion::TileRegion(const QRect &rect)
+{
+    add(rect);
+}
+
+TileRegion::TileRegion(const QRegion &region)
+{
+    for (const QRect &rect : region)
+        add(rect);
+}
+
+bool TileRegion::contains(int x, int y) const
+{
+    const auto row = mRows.constFind(y);
+    if (row == mRows.constEnd())
+        return false;
+
+    // Find the last span starting at or before x
+    const Spans &spans = *row;
+    auto it = std::upper_bound(spans.begin(), spans.end(), x,
+                               [] (int value, const Span &span) { return value < span.begin; });
+    if (it == spans.begin())
+        return false;
+
+    return x < (it - 1)->end;
+}
+
+QRect TileRegion::boundingRect() const
+{
+    if (mRows.isEmpty())
+        return QRect();
+
+    int left = mRows.first().first().begin;
+    int right = mRows.first().last().end;
+
+    for (const Spans &spans : mRows) {
+        left = std::min(left, spans.first().begin);
+        right = std::max(right, spans.last().end);
+    }
+
+    return QRect(QPoint(left, mRows.firstKey()),
+                 QPoint(right - 1, mRows.lastKey()));
+}
+
+/**
+ * Returns the number of tiles in this region.
+ */
+qint64 TileRegion::tileCount() const
+{
+    qint64 count = 0;
+    for (const Spans &spans : mRows)
+        for (const Span &span : spans)
+            count += span.end - span.begin;
+    return count;
+}
+
+void TileRegion::add(const QRect &rect)
+{
+    if (rect.isEmpty())
+        return;
+
+    const Span span { rect.left(), rect.right() + 1 };
+
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        Spans &spans = mRows[y];
+
+        // Fast path for adding spans from left to right
+        if (spans.isEmpty() || spans.last().end < span.begin)
+            spans.append(span);
+        else
+            spans = uniteSpans(spans, Spans { span });
+    }
+}
+
+void TileRegion::add(const TileRegion &region)
+{
+    if (mRows.isEmpty()) {
+        mRows = region.mRows;
+        return;
+    }
+
+    for (auto it = region.mRows.begin(), end = region.mRows.end(); it != end; ++it) {
+        auto row = mRows.find(it.key());
+        if (row == mRows.end())
+            mRows.insert(it.key(), it.value());
+        else
+            *row = uniteSpans(*row, it.value());
+    }
+}
+
+void TileRegion::subtract(const QRect &rect)
+{
+    if (rect.isEmpty())
+        return;
+
+    const Spans spans { Span { rect.left(), rect.right() + 1 } };
+
+    auto row = mRows.lowerBound(rect.top());
+    while (row != mRows.end() && row.key() <= rect.bottom()) {
+        *row = subtractSpans(*row, spans);
+        if (row->isEmpty())
+            row = mRows.erase(row);
+        else
+            ++row;
+    }
+}
+
+void TileRegion::subtract(const TileRegion &region)
+{
+    for (auto it = region.mRows.begin(), end = region.mRows.end(); it != end; ++it) {
+        auto row = mRows.find(it.key());
+        if (row == mRows.end())
+            continue;
+
+        *row = subtractSpans(*row, it.value());
+        if (row->isEmpty())
+            mRows.erase(row);
+    }
+}
+
+void TileRegion::intersect(const QRect &rect)
+{
+    if (rect.isEmpty()) {
+        mRows.clear();
+        return;
+    }
+
+    const Spans spans { Span { rect.left(), rect.right() + 1 } };
+
+    for (auto row = mRows.begin(); row != mRows.end(); ) {
+        if (row.key() >= rect.top() && row.key() <= rect.bottom())
+            *row = intersectSpans(*row, spans);
+        else
+            row->clear();
+
+        if (row->isEmpty())
+            row = mRows.erase(row);
+        else
+            ++row;
+    }
+}
+
+void TileRegion::intersect(const TileRegion &region)
+{
+    for (auto row = mRows.begin(); row != mRows.end(); ) {
+        const auto other = region.mRows.constFind(row.key());
+        if (other != region.mRows.constEnd())
+            *row = intersectSpans(*row, *other);
+        else
+            row->clear();
+
+        if (row->isEmpty())
+            row = mRows.erase(row);
+        else
+            ++row;
+    }
+}
+
+void TileRegion::translate(QPoint offset)
+{
+    if (offset.isNull())
+        return;
+
+    QMap<int, Spans> rows;
+
+    for (auto it = mRows.begin(), end = mRows.end(); it != end; ++it) {
+        Spans spans = it.value();
+        for (Span &span : spans) {
+            span.begin += offset.x();
+            span.end += offset.x();
+        }
+        rows.insert(rows.end(), it.key() + offset.y(), spans);
+    }
+
+    mRows.swap(rows);
+}
+
+/**
+ * Returns the rectangles making up this region, in the same y-x banded form
+ * as used by QRegion. Consecutive rows with equal spans are combined.
+ */
+QVector<QRect> TileRegion::rects() const
+{
+    QVector<QRect> rects;
+
+    const Spans *bandSpans = nullptr;
+    int bandTop = 0;
+    int bandBottom = 0;
+
+    auto flushBand = [&] {
+        if (!bandSpans)
+            return;
+        for (const Span &span : *bandSpans)
+            rects.append(QRect(span.begin, bandTop, span.end - span.begin, bandBottom - bandTop + 1));
+    };
+
+    for (auto it = mRows.begin(), end = mRows.end(); it != end; ++it) {
+        if (bandSpans && it.key() == bandBottom + 1 && it.value() == *bandSpans) {
+            bandBottom = it.key();
+            continue;
+        }
+
+        flushBand();
+        bandSpans = &it.value();
+        bandTop = bandBottom = it.key();
+    }
+
+    flushBand();
+
+    return rects;
+}
+
+QRegion TileRegion::toQRegion() const
+{
+    const QVector<QRect> rects = this->rects();
+
+    QRegion region;
+    if (!rects.isEmpty())
+        region.setRects(rects.constData(), int(rects.size()));
+    return region;
+}
+
+} // namespace Tiled
@@ -0,0 +1,128 @@
+/*
+ * tileregion.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QMap>
+#include <QRect>
+#include <QRegion>
+#include <QVector>
+
+namespace Tiled {
+
+/**
+ * A region of tiles, stored as a sorted list of horizontal spans per row.
+ *
+ * Unlike QRegion, which keeps its rectangles in y-x banded form and has to
+ * rebuild these bands on every operation, the operations on a TileRegion
+ * only touch the rows involved. This makes building up a region from many
+ * small pieces, as done by flood fills and selections, a lot cheaper.
+ *
+ * Convert to QRegion using toQRegion() where a QRegion is needed.
+ */
+class TILEDSHARED_EXPORT TileRegion
+{
+public:
+    /**
+     * A half-open range of columns [begin, end).
+     */
+    struct Span
+    {
+        int begin;
+        int end;
+
+        bool operator==(const Span &other) const
+        { return begin == other.begin && end == other.end; }
+        bool operator!=(const Span &other) const
+        { return !(*this == other); }
+    };
+
+    using Spans = QVector<Span>;
+
+    TileRegion() = default;
+    TileRegion(const QRect &rect);
+    explicit TileRegion(const QRegion &region);
+
+    bool isEmpty() const;
+    bool contains(QPoint point) const;
+    bool contains(int x, int y) const;
+    QRect boundingRect() const;
+    qint64 tileCount() const;
+
+    void add(const QRect &rect);
+    void add(const TileRegion &region);
+    void subtract(const QRect &rect);
+    void subtract(const TileRegion &region);
+    void intersect(const QRect &rect);
+    void intersect(const TileRegion &region);
+
+    void translate(QPoint offset);
+    TileRegion translated(QPoint offset) const;
+
+    QVector<QRect> rects() const;
+    QRegion toQRegion() const;
+
+    const QMap<int, Spans> &rows() const;
+
+    TileRegion &operator+=(const TileRegion &region) { add(region); return *this; }
+    TileRegion &operator-=(const TileRegion &region) { subtract(region); return *this; }
+    TileRegion &operator&=(const TileRegion &region) { intersect(region); return *this; }
+
+    bool operator==(const TileRegion &other) const { return mRows == other.mRows; }
+    bool operator!=(const TileRegion &other) const { return !(*this == other); }
+
+private:
+    QMap<int, Spans> mRows;     // never contains empty rows
+};
+
+
+inline bool TileRegion::isEmpty() const
+{
+    return mRows.isEmpty();
+}
+
+inline bool TileRegion::contains(QPoint point) const
+{
+    return contains(point.x(), point.y());
+}
+
+inline TileRegion TileRegion::translated(QPoint offset) const
+{
+    TileRegion region(*this);
+    region.translate(offset);
+    return region;
+}
+
+inline const QMap<int, TileRegion::Spans> &TileRegion::rows() const
+{
+    return mRows;
+}
+
+} // namespace Tiled
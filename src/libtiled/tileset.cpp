@@ -29,12 +29,15 @@
 
 #include "tileset.h"
 
+#include "imagecache.h"
 #include "tile.h"
 #include "tilesetmanager.h"
 #include "wangset.h"
 
 #include <QBitmap>
 
+#include <atomic>
+
 namespace Tiled {
 
 Tileset::Tileset(QString name, int tileWidth, int tileHeight,
@@ -115,13 +118,14 @@ int Tileset::findTileLocation(Tile *tile) const
  */
 Tile *Tileset::findOrCreateTile(int id)
 {
-    if (Tile *tile = mTilesById.value(id))
+    if (Tile *tile = findTile(id))
         return tile;
 
     mNextTileId = std::max(mNextTileId, id + 1);
 
     auto tile = new Tile(id, this);
     mTilesById[id] = tile;
+    updateTileTable(id, tile);
     mTiles.append(tile);
 
     return tile;
@@ -194,7 +198,8 @@ bool Tileset::loadFromImage(const QImage &image, const QUrl &source)
         return false;
     }
 
-    mImage = QPixmap::fromImage(image);
+    mImage = QPixmap::fromImage(ImageCache::toDisplayFormat(image),
+                                Qt::NoOpaqueDetection);
 
     initializeTilesetTiles();
 
@@ -235,6 +240,9 @@ bool Tileset::loadFromImage(const QString &fileName)
 bool Tileset::loadImage()
 {
     if (mImageReference.hasImage()) {
+        if (TilesetManager::instance()->loadImageAsync(this))
+            return true;
+
         mImage = mImageReference.create();
         if (mImage.isNull()) {
             mImageReference.status = LoadingError;
@@ -253,40 +261,54 @@ bool Tileset::initializeTilesetTiles()
     if (mImageReference.transparentColor.isValid())
         mImage.setMask(mImage.createMaskFromColor(mImageReference.transparentColor));
 
-    QVector<QRect> tileRects;
+    const int columnCount = std::max(0, columnCountForWidth(mImage.width()));
+    const int rowCount = std::max(0, rowCountForHeight(mImage.height()));
+    const int tileCount = columnCount * rowCount;
+
+    // The image rects are computed from the tile ID, rather than collecting
+    // them up front, since large atlases can contain many tiles
+    auto imageRect = [&] (int tileNum) {
+        const int x = mMargin + (tileNum % columnCount) * (mTileWidth + mTileSpacing);
+        const int y = mMargin + (tileNum / columnCount) * (mTileHeight + mTileSpacing);
+        return QRect(x, y, mTileWidth, mTileHeight);
+    };
 
-    for (int y = mMargin; y <= mImage.height() - mTileHeight; y += mTileHeight + mTileSpacing)
-        for (int x = mMargin; x <= mImage.width() - mTileWidth; x += mTileWidth + mTileSpacing)
-            tileRects.append(QRect(x, y, mTileWidth, mTileHeight));
+    bool tilesAdded = false;
+    auto it = mTilesById.begin();
 
-    for (int tileNum = 0; tileNum < tileRects.size(); ++tileNum) {
-        auto it = mTilesById.find(tileNum);
-        if (it != mTilesById.end()) {
+    for (int tileNum = 0; tileNum < tileCount; ++tileNum) {
+        if (it != mTilesById.end() && it.key() == tileNum) {
             it.value()->setImage(QPixmap());    // make sure it uses the tileset's image
-            it.value()->setImageRect(tileRects.at(tileNum));
+            it.value()->setImageRect(imageRect(tileNum));
         } else {
             auto tile = new Tile(tileNum, this);
-            tile->setImageRect(tileRects.at(tileNum));
-            mTilesById.insert(tileNum, tile);
-            mTiles.insert(tileNum, tile);
+            tile->setImageRect(imageRect(tileNum));
+            it = mTilesById.insert(it, tileNum, tile);  // hint makes this constant time
+            tilesAdded = true;
         }
+        ++it;
+    }
+
+    // Inserting the new tiles one by one in the list would be quadratic, and
+    // the tiles of image based tilesets are listed by ID anyway
+    if (tilesAdded) {
+        mTiles = mTilesById.values();
+        rebuildTileTable();
     }
 
     QPixmap blank;
 
     // Blank out any remaining tiles to avoid confusion (todo: could be more clear)
-    for (Tile *tile : std::as_const(mTiles)) {
-        if (tile->id() >= tileRects.size()) {
-            if (blank.isNull()) {
-                blank = QPixmap(mTileWidth, mTileHeight);
-                blank.fill();
-            }
-            tile->setImage(blank);
-            tile->setImageRect(QRect(0, 0, mTileWidth, mTileHeight));
+    for (; it != mTilesById.end(); ++it) {
+        if (blank.isNull()) {
+            blank = QPixmap(mTileWidth, mTileHeight);
+            blank.fill();
         }
+        it.value()->setImage(blank);
+        it.value()->setImageRect(QRect(0, 0, mTileWidth, mTileHeight));
     }
 
-    mNextTileId = std::max<int>(mNextTileId, tileRects.size());
+    mNextTileId = std::max(mNextTileId, tileCount);
 
     mImageReference.size = mImage.size();
     mColumnCount = columnCountForWidth(mImageReference.size.width());
@@ -323,9 +345,14 @@ SharedTileset Tileset::findSimilarTileset(const QVector<SharedTileset> &tilesets
     if (isExternal())
         return SharedTileset();
 
+    const size_t hash = similarityHash();
+
     for (const SharedTileset &candidate : tilesets) {
         Q_ASSERT(candidate != this);
 
+        // Most candidates are ruled out without comparing their tiles
+        if (candidate->similarityHash() != hash)
+            continue;
         if (candidate->tileCount() != tileCount())
             continue;
         if (candidate->imageSource() != imageSource())
@@ -350,6 +377,47 @@ SharedTileset Tileset::findSimilarTileset(const QVector<SharedTileset> &tilesets
     return SharedTileset();
 }
 
+/**
+ * Returns a hash of the properties compared by findSimilarTileset(). Similar
+ * tilesets have the same hash.
+ *
+ * For image collection tilesets this includes the image source of each
+ * tile, which is cached until the tiles or their image sources change.
+ */
+size_t Tileset::similarityHash() const
+{
+    size_t hash = qHash(mImageReference.source);
+    hash = qHash(tileCount(), hash);
+    hash = qHash(mTileWidth, hash);
+    hash = qHash(mTileHeight, hash);
+    hash = qHash(mTileSpacing, hash);
+    hash = qHash(mMargin, hash);
+    hash = qHash(mTileOffset.x(), hash);
+    hash = qHash(mTileOffset.y(), hash);
+
+    if (!isCollection())
+        return hash;
+
+    if (mTileImagesHashDirty) {
+        // Combined independently of the order of the tiles
+        mTileImagesHash = 0;
+        for (const Tile *tile : mTiles)
+            mTileImagesHash += qHash(tile->imageSource(), qHash(tile->id()));
+        mTileImagesHashDirty = false;
+    }
+
+    return hash ^ mTileImagesHash;
+}
+
+/**
+ * Should be called when tiles are added or removed, or when the image source
+ * of a tile changed.
+ */
+void Tileset::invalidateTileImagesHash()
+{
+    mTileImagesHashDirty = true;
+}
+
 /**
  * Changes the source of the tileset image.
  *
@@ -434,6 +502,7 @@ Tile *Tileset::addTile(const QPixmap &image, const QUrl &source, const QRect &re
     newTile->setImageRect(rect.isNull() ? image.rect() : rect);
 
     mTilesById.insert(newTile->id(), newTile);
+    updateTileTable(newTile->id(), newTile);
     mTiles.append(newTile);
     if (mTileHeight < newTile->height())
         mTileHeight = newTile->height();
@@ -452,9 +521,11 @@ void Tileset::addTiles(const QList<Tile *> &tiles)
     for (Tile *tile : tiles) {
         Q_ASSERT(tile->tileset() == this && !mTilesById.contains(tile->id()));
         mTilesById.insert(tile->id(), tile);
+        updateTileTable(tile->id(), tile);
         mTiles.append(tile);
     }
 
+    invalidateAnimatedTiles();
     updateTileSize();
 }
 
@@ -468,9 +539,11 @@ void Tileset::removeTiles(const QList<Tile *> &tiles)
     for (Tile *tile : tiles) {
         Q_ASSERT(tile->tileset() == this && mTilesById.contains(tile->id()));
         mTilesById.remove(tile->id());
+        updateTileTable(tile->id(), nullptr);
         mTiles.removeOne(tile);
     }
 
+    invalidateAnimatedTiles();
     updateTileSize();
 }
 
@@ -480,8 +553,108 @@ void Tileset::removeTiles(const QList<Tile *> &tiles)
 void Tileset::deleteTile(int id)
 {
     auto tile = mTilesById.take(id);
+    updateTileTable(id, nullptr);
     mTiles.removeOne(tile);
     delete tile;
+    invalidateAnimatedTiles();
+}
+
+/**
+ * Returns whether a tile table of the given \a size is small enough to be
+ * used for looking up \a tileCount tiles.
+ */
+static bool fitsTileTable(qint64 size, qint64 tileCount)
+{
+    // Allow up to 3 out of 4 table entries to be unused
+    constexpr qint64 minimumTableSize = 256;
+    return size <= std::max(minimumTableSize, tileCount * 4);
+}
+
+/**
+ * Keeps the tile table in sync after the tile with the given \a id was added
+ * to mTilesById, or removed when \a tile is nullptr.
+ */
+void Tileset::updateTileTable(int id, Tile *tile)
+{
+    invalidateTileImagesHash();
+
+    if (!mTileTable.empty() && id >= 0) {
+        const size_t index = static_cast<size_t>(id);
+
+        if (index < mTileTable.size()) {
+            mTileTable[index] = tile;
+            if (tile || fitsTileTable(mTileTable.size(), mTilesById.size()))
+                return;
+        } else if (tile && fitsTileTable(index + 1, mTilesById.size())) {
+            mTileTable.resize(index + 1, nullptr);
+            mTileTable[index] = tile;
+            return;
+        }
+    }
+
+    rebuildTileTable();
+}
+
+/**
+ * Fills the table used by findTile to look up tiles by their ID, as long as
+ * the IDs are dense enough. Otherwise the table is cleared and the tiles are
+ * looked up in mTilesById.
+ */
+void Tileset::rebuildTileTable()
+{
+    invalidateTileImagesHash();
+
+    mTileTable.clear();
+
+    if (mTilesById.isEmpty() || mTilesById.firstKey() < 0 ||
+            !fitsTileTable(qint64(mTilesById.lastKey()) + 1, mTilesById.size())) {
+        mTileTable.shrink_to_fit();
+        return;
+    }
+
+    mTileTable.resize(mTilesById.lastKey() + 1, nullptr);
+    for (auto it = mTilesById.cbegin(); it != mTilesById.cend(); ++it)
+        mTileTable[it.key()] = it.value();
+}
+
+// Incremented whenever the set of animated tiles of any tileset changes
+static std::atomic<int> animatedTilesGenerationCounter { 0 };
+
+/**
+ * Returns the tiles of this tileset that have an animation. Used to avoid
+ * iterating all tiles when advancing the tile animations.
+ */
+const QVector<Tile*> &Tileset::animatedTiles() const
+{
+    if (mAnimatedTilesDirty) {
+        mAnimatedTiles.clear();
+        for (Tile *tile : mTiles)
+            if (tile->isAnimated())
+                mAnimatedTiles.append(tile);
+        mAnimatedTilesDirty = false;
+    }
+
+    return mAnimatedTiles;
+}
+
+/**
+ * Should be called when tiles are added or removed, or when the animation
+ * of a tile changed.
+ */
+void Tileset::invalidateAnimatedTiles()
+{
+    mAnimatedTilesDirty = true;
+    ++animatedTilesGenerationCounter;
+}
+
+/**
+ * Returns a number that changes whenever the animated tiles of any tileset
+ * may have changed, so that places that keep track of where animated tiles
+ * are used know when to update.
+ */
+int Tileset::animatedTilesGeneration()
+{
+    return animatedTilesGenerationCounter;
 }
 
 /**
@@ -615,7 +788,12 @@ void Tileset::swap(Tileset &other)
     std::swap(mExpectedColumnCount, other.mExpectedColumnCount);
     std::swap(mExpectedRowCount, other.mExpectedRowCount);
     std::swap(mTilesById, other.mTilesById);
+    std::swap(mTileTable, other.mTileTable);
     std::swap(mTiles, other.mTiles);
+    invalidateAnimatedTiles();
+    other.invalidateAnimatedTiles();
+    invalidateTileImagesHash();
+    other.invalidateTileImagesHash();
     std::swap(mNextTileId, other.mNextTileId);
     std::swap(mWangSets, other.mWangSets);
     std::swap(mStatus, other.mStatus);
@@ -663,6 +841,7 @@ SharedTileset Tileset::clone() const
         c->mTilesById.insert(id, clonedTile);
         c->mTiles.append(clonedTile);
     }
+    c->rebuildTileTable();
 
     c->mWangSets.reserve(mWangSets.size());
     for (WangSet *wangSet : mWangSets)
@@ -41,6 +41,7 @@
 #include <QVector>
 
 #include <memory>
+#include <vector>
 
 class QImage;
 
@@ -176,6 +177,10 @@ public:
     Tile *findOrCreateTile(int id);
     int tileCount() const;
 
+    const QVector<Tile*> &animatedTiles() const;
+    void invalidateAnimatedTiles();
+    static int animatedTilesGeneration();
+
     int columnCount() const;
     int rowCount() const;
     void setColumnCount(int columnCount);
@@ -201,6 +206,8 @@ public:
     bool initializeTilesetTiles();
 
     SharedTileset findSimilarTileset(const QVector<SharedTileset> &tilesets) const;
+    size_t similarityHash() const;
+    void invalidateTileImagesHash();
 
     const QUrl &imageSource() const;
     void setImageSource(const QUrl &imageSource);
@@ -296,6 +303,8 @@ public:
 private:
     void maybeUpdateTileSize(QSize oldSize, QSize newSize);
     void updateTileSize();
+    void updateTileTable(int id, Tile *tile);
+    void rebuildTileTable();
 
     QString mName;
     QString mFileName;
@@ -316,7 +325,12 @@ private:
     int mExpectedRowCount = 0;
     int mNextTileId = 0;
     QMap<int, Tile*> mTilesById;
+    std::vector<Tile*> mTileTable;  // indexed by ID, empty when IDs are sparse
     QList<Tile*> mTiles;
+    mutable QVector<Tile*> mAnimatedTiles;
+    mutable bool mAnimatedTilesDirty = true;
+    mutable size_t mTileImagesHash = 0;
+    mutable bool mTileImagesHashDirty = true;
     QList<WangSet*> mWangSets;
     LoadingStatus mStatus = LoadingReady;
     QColor mBackgroundColor;
@@ -513,6 +527,9 @@ inline const QList<Tile*> &Tileset::tiles() const
  */
 inline Tile *Tileset::findTile(int id) const
 {
+    if (!mTileTable.empty())
+        return static_cast<unsigned>(id) < mTileTable.size() ? mTileTable[id] : nullptr;
+
     return mTilesById.value(id);
 }
 
@@ -0,0 +1,130 @@
+/*
+ * tilesetexportcache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tilesetexportcache.h"
+
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "tile.h"
+
+#include <QMutexLocker>
+
+namespace Tiled {
+
+static TilesetExportCache *activeCache;
+
+/**
+ * Makes this cache the active one, until it is destroyed.
+ */
+TilesetExportCache::TilesetExportCache()
+    : mPrevious(activeCache)
+{
+    activeCache = this;
+}
+
+TilesetExportCache::~TilesetExportCache()
+{
+    Q_ASSERT(activeCache == this);
+    activeCache = mPrevious;
+}
+
+/**
+ * Returns the active cache, or nullptr when no cache should be used.
+ */
+TilesetExportCache *TilesetExportCache::instance()
+{
+    return activeCache;
+}
+
+/**
+ * Returns whether the serialized form of the given tileset can be cached.
+ *
+ * This is only done for the cached export tilesets, since those are shared
+ * by many maps. Their serialized form needs to be independent of the map,
+ * apart from the first global tile ID, which is not the case when they have
+ * tile objects in their collision shapes.
+ */
+bool TilesetExportCache::canCacheSerialized(const Tileset &tileset) const
+{
+    {
+        QMutexLocker locker(&mMutex);
+        if (!mCachedExportTilesets.contains(&tileset))
+            return false;
+    }
+
+    for (const Tile *tile : tileset.tiles()) {
+        if (const ObjectGroup *objectGroup = tile->objectGroup()) {
+            for (const MapObject *object : objectGroup->objects())
+                if (!object->cell().isEmpty())
+                    return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Returns the tileset previously prepared for export from \a tileset with
+ * the given export \a options, or a null pointer.
+ */
+SharedTileset TilesetExportCache::exportTileset(const Tileset *tileset, int options) const
+{
+    QMutexLocker locker(&mMutex);
+    return mExportTilesets.value(qMakePair(tileset, options)).exportTileset;
+}
+
+void TilesetExportCache::insertExportTileset(const Tileset *tileset, int options,
+                                             const SharedTileset &exportTileset)
+{
+    QMutexLocker locker(&mMutex);
+    mExportTilesets.insert(qMakePair(tileset, options),
+                           ExportTileset { tileset->sharedFromThis(), exportTileset });
+    mCachedExportTilesets.insert(exportTileset.data());
+}
+
+/**
+ * Returns the serialized form of \a tileset, as previously stored for the
+ * given \a context, or an invalid QVariant.
+ *
+ * The \a context identifies the format and anything else affecting the
+ * output, like the directory relative to which paths are written.
+ */
+QVariant TilesetExportCache::serialized(const Tileset *tileset, const QString &context) const
+{
+    QMutexLocker locker(&mMutex);
+    return mSerialized.value(qMakePair(tileset, context));
+}
+
+void TilesetExportCache::insertSerialized(const Tileset *tileset, const QString &context,
+                                          const QVariant &data)
+{
+    QMutexLocker locker(&mMutex);
+    mSerialized.insert(qMakePair(tileset, context), data);
+}
+
+} // namespace Tiled
@@ -0,0 +1,83 @@
+/*
+ * tilesetexportcache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tileset.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QVariant>
+
+namespace Tiled {
+
+/**
+ * Caches the export versions of external tilesets and the serialized form
+ * of embedded tilesets, so that exporting many maps which embed the same
+ * tilesets prepares and serializes each tileset only once.
+ *
+ * The cache is used by the map writers while an instance exists, which is
+ * meant to cover a batch export. During that time, the cached tilesets are
+ * kept alive and must not be changed.
+ */
+class TILEDSHARED_EXPORT TilesetExportCache
+{
+public:
+    TilesetExportCache();
+    ~TilesetExportCache();
+
+    static TilesetExportCache *instance();
+
+    bool canCacheSerialized(const Tileset &tileset) const;
+
+    SharedTileset exportTileset(const Tileset *tileset, int options) const;
+    void insertExportTileset(const Tileset *tileset, int options,
+                             const SharedTileset &exportTileset);
+
+    QVariant serialized(const Tileset *tileset, const QString &context) const;
+    void insertSerialized(const Tileset *tileset, const QString &context,
+                          const QVariant &data);
+
+private:
+    Q_DISABLE_COPY(TilesetExportCache)
+
+    struct ExportTileset
+    {
+        SharedTileset tileset;          // keeps the key alive
+        SharedTileset exportTileset;
+    };
+
+    mutable QMutex mMutex;
+    QHash<QPair<const Tileset*, int>, ExportTileset> mExportTilesets;
+    QSet<const Tileset*> mCachedExportTilesets;
+    QHash<QPair<const Tileset*, QString>, QVariant> mSerialized;
+    TilesetExportCache *mPrevious;
+};
+
+} // namespace Tiled
@@ -29,16 +29,32 @@
 
 #include "tilesetmanager.h"
 
+#include "diskimagecache.h"
 #include "filesystemwatcher.h"
 #include "imagecache.h"
+#include "taskscheduler.h"
 #include "tile.h"
 #include "tileanimationdriver.h"
 #include "tilesetformat.h"
+#include "tracing.h"
 
 #include <QDebug>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QThread>
+
+#include <algorithm>
+#include <climits>
+#include <utility>
 
 namespace Tiled {
 
+/**
+ * In reduced animation mode, tile animations are advanced at most this often
+ * (in milliseconds).
+ */
+static const int reducedAnimationInterval = 100;
+
 TilesetManager *TilesetManager::mInstance;
 
 /**
@@ -54,7 +70,12 @@ TilesetManager::TilesetManager():
             this, &TilesetManager::filesChanged);
 
     connect(mAnimationDriver, &TileAnimationDriver::update,
-            this, &TilesetManager::advanceTileAnimations);
+            this, &TilesetManager::animationTick);
+
+    if (auto guiApp = qobject_cast<QGuiApplication*>(QCoreApplication::instance())) {
+        connect(guiApp, &QGuiApplication::applicationStateChanged,
+                this, &TilesetManager::updateAnimationDriver);
+    }
 }
 
 TilesetManager::~TilesetManager()
@@ -135,6 +156,9 @@ void TilesetManager::removeTileset(Tileset *tileset)
     Q_ASSERT(mTilesets.contains(tileset));
     mTilesets.removeOne(tileset);
 
+    for (auto it = mPendingImageLoads.begin(); it != mPendingImageLoads.end(); ++it)
+        it.value().removeOne(tileset);
+
     if (tileset->imageSource().isLocalFile())
         mWatcher->removePath(tileset->imageSource().toLocalFile());
 }
@@ -144,6 +168,8 @@ void TilesetManager::removeTileset(Tileset *tileset)
  */
 void TilesetManager::reloadImages(Tileset *tileset)
 {
+    TILED_TRACE_SCOPE("TilesetManager::reloadImages");
+
     if (!mTilesets.contains(tileset))
         return;
 
@@ -164,6 +190,72 @@ void TilesetManager::reloadImages(Tileset *tileset)
     }
 }
 
+/**
+ * Sets whether tileset images are loaded in the background. While enabled,
+ * Tileset::loadImage() returns immediately for images that still need to
+ * be loaded from disk. Such tilesets have their image status set to
+ * LoadingInProgress and tilesetImagesChanged() is emitted once their image
+ * has been loaded.
+ *
+ * Meant to be enabled only while opening files in the editor, since other
+ * code expects the images to be available after loading.
+ */
+void TilesetManager::setAsyncImageLoading(bool enabled)
+{
+    mAsyncImageLoading = enabled;
+}
+
+bool TilesetManager::asyncImageLoading() const
+{
+    return mAsyncImageLoading;
+}
+
+/**
+ * Starts decoding the image of the given \a tileset on the global thread
+ * pool, when asynchronous image loading is enabled.
+ *
+ * Returns whether loading was started. When it returns false, the image
+ * should be loaded directly.
+ */
+bool TilesetManager::loadImageAsync(Tileset *tileset)
+{
+    if (!mAsyncImageLoading || QThread::currentThread() != thread())
+        return false;
+
+    const QString fileName = Tiled::urlToLocalFileOrQrc(tileset->imageSource());
+    if (fileName.isEmpty() || ImageCache::contains(fileName))
+        return false;
+
+    tileset->setImageStatus(LoadingInProgress);
+
+    // Tilesets sharing the same image share the job
+    QVector<Tileset*> &tilesets = mPendingImageLoads[fileName];
+    if (!tilesets.contains(tileset))
+        tilesets.append(tileset);
+    if (tilesets.size() > 1)
+        return true;
+
+    // The image is handed over without keeping other references to it, so
+    // that the ImageCache can convert it to a pixmap in place
+    TaskScheduler::start([this, fileName] {
+        QImage decoded = DiskImageCache::loadImage(fileName);
+
+        // Convert to the display format here rather than on the main thread.
+        // Indexed images are kept as-is, since they are cheap to convert and
+        // ImageCache::loadImage users may still need their color table.
+        if (decoded.format() != QImage::Format_Indexed8)
+            decoded = ImageCache::toDisplayFormat(std::move(decoded));
+
+        LoadedImage image(std::move(decoded), QFileInfo(fileName).lastModified());
+
+        QMetaObject::invokeMethod(this, [this, fileName, image = std::move(image)] () mutable {
+            imageLoaded(fileName, std::move(image));
+        }, Qt::QueuedConnection);
+    }, TaskScheduler::Foreground);
+
+    return true;
+}
+
 /**
  * Sets whether tilesets are automatically reloaded when their tileset
  * image changes.
@@ -183,18 +275,34 @@ bool TilesetManager::reloadTilesetsOnChange() const
  */
 void TilesetManager::setAnimateTiles(bool enabled)
 {
-    // TODO: Avoid running the driver when there are no animated tiles
-    if (enabled) {
-        mAnimationDriver->start();
-    } else {
-        mAnimationDriver->stop();
+    if (mAnimateTiles == enabled)
+        return;
+
+    mAnimateTiles = enabled;
+    updateAnimationDriver();
+
+    if (!enabled)
         resetTileAnimations();
-    }
 }
 
 bool TilesetManager::animateTiles() const
 {
-    return mAnimationDriver->state() == QAbstractAnimation::Running;
+    return mAnimateTiles;
+}
+
+/**
+ * Sets whether tile animations should use less power, by updating them less
+ * frequently and pausing them while the application isn't active.
+ */
+void TilesetManager::setReducedAnimations(bool enabled)
+{
+    mReducedAnimations = enabled;
+    updateAnimationDriver();
+}
+
+bool TilesetManager::reducedAnimations() const
+{
+    return mReducedAnimations;
 }
 
 void TilesetManager::tilesetImageSourceChanged(const Tileset &tileset,
@@ -211,6 +319,8 @@ void TilesetManager::tilesetImageSourceChanged(const Tileset &tileset,
 
 void TilesetManager::filesChanged(const QStringList &fileNames)
 {
+    TILED_TRACE_SCOPE("TilesetManager::filesChanged");
+
     for (const QString &fileName : fileNames)
         ImageCache::remove(fileName);
 
@@ -222,6 +332,32 @@ void TilesetManager::filesChanged(const QStringList &fileNames)
     }
 }
 
+void TilesetManager::imageLoaded(const QString &fileName, LoadedImage image)
+{
+    TILED_TRACE_SCOPE("TilesetManager::imageLoaded");
+
+    const QVector<Tileset*> tilesets = mPendingImageLoads.take(fileName);
+
+    // Images that failed to decode could still be maps, which are rendered
+    // by the ImageCache when loading the image directly.
+    if (!image.image.isNull())
+        ImageCache::insert(fileName, std::move(image));
+
+    const bool asyncImageLoading = std::exchange(mAsyncImageLoading, false);
+
+    for (Tileset *tileset : tilesets) {
+        // Skip tilesets that changed their image in the meantime
+        if (tileset->imageStatus() != LoadingInProgress ||
+                Tiled::urlToLocalFileOrQrc(tileset->imageSource()) != fileName)
+            continue;
+
+        tileset->loadImage();
+        emit tilesetImagesChanged(tileset);
+    }
+
+    mAsyncImageLoading = asyncImageLoading;
+}
+
 /**
  * Resets all tile animations.
  *
@@ -230,34 +366,102 @@ void TilesetManager::filesChanged(const QStringList &fileNames)
  */
 void TilesetManager::resetTileAnimations()
 {
-    // TODO: This could be more optimal by keeping track of the list of
-    // actually animated tiles
+    int nextFrameDelay = INT_MAX;
 
     for (Tileset *tileset : std::as_const(mTilesets)) {
         bool imageChanged = false;
 
-        for (Tile *tile : tileset->tiles())
+        for (Tile *tile : tileset->animatedTiles()) {
             imageChanged |= tile->resetAnimation();
 
+            const int delay = tile->timeUntilNextFrame();
+            if (delay > 0)
+                nextFrameDelay = std::min(nextFrameDelay, delay);
+        }
+
         if (imageChanged)
             emit repaintTileset(tileset);
     }
+
+    mPendingAnimationTime = 0;
+    mNextFrameDelay = nextFrameDelay;
+    mAnimatedTilesGeneration = Tileset::animatedTilesGeneration();
 }
 
 void TilesetManager::advanceTileAnimations(int ms)
 {
-    // TODO: This could be more optimal by keeping track of the list of
-    // actually animated tiles
+    int nextFrameDelay = INT_MAX;
 
     for (Tileset *tileset : std::as_const(mTilesets)) {
         bool imageChanged = false;
 
-        for (Tile *tile : tileset->tiles())
+        for (Tile *tile : tileset->animatedTiles()) {
             imageChanged |= tile->advanceAnimation(ms);
 
+            const int delay = tile->timeUntilNextFrame();
+            if (delay > 0)
+                nextFrameDelay = std::min(nextFrameDelay, delay);
+        }
+
         if (imageChanged)
             emit repaintTileset(tileset);
     }
+
+    mNextFrameDelay = nextFrameDelay;
+    mAnimatedTilesGeneration = Tileset::animatedTilesGeneration();
+}
+
+/**
+ * Called for each frame while tile animations are playing. The animations
+ * are only advanced once the first of them is due to change its frame.
+ */
+void TilesetManager::animationTick(int ms)
+{
+    mPendingAnimationTime += ms;
+
+    const int interval = mReducedAnimations ? reducedAnimationInterval : 0;
+
+    // Animated tiles that were added or changed invalidate the next frame delay
+    if (mAnimatedTilesGeneration == Tileset::animatedTilesGeneration() &&
+            mPendingAnimationTime < std::max(mNextFrameDelay, interval))
+        return;
+
+    advanceTileAnimations(std::exchange(mPendingAnimationTime, 0));
+}
+
+/**
+ * Runs the animation driver while tile animations are enabled, pausing it
+ * while the application is hidden. In reduced animation mode, it is also
+ * paused while the application is inactive.
+ */
+void TilesetManager::updateAnimationDriver()
+{
+    bool run = mAnimateTiles;
+
+    if (run && qobject_cast<QGuiApplication*>(QCoreApplication::instance())) {
+        switch (QGuiApplication::applicationState()) {
+        case Qt::ApplicationSuspended:
+        case Qt::ApplicationHidden:
+            run = false;
+            break;
+        case Qt::ApplicationInactive:
+            run = !mReducedAnimations;
+            break;
+        case Qt::ApplicationActive:
+            break;
+        }
+    }
+
+    if (run) {
+        if (mAnimationDriver->state() == QAbstractAnimation::Paused)
+            mAnimationDriver->resume();
+        else if (mAnimationDriver->state() == QAbstractAnimation::Stopped)
+            mAnimationDriver->start();
+    } else if (!mAnimateTiles) {
+        mAnimationDriver->stop();
+    } else if (mAnimationDriver->state() == QAbstractAnimation::Running) {
+        mAnimationDriver->pause();
+    }
 }
 
 } // namespace Tiled
@@ -31,13 +31,16 @@
 
 #include "tileset.h"
 
+#include <QHash>
 #include <QObject>
 #include <QList>
 #include <QString>
+#include <QVector>
 
 namespace Tiled {
 
 class FileSystemWatcher;
+struct LoadedImage;
 class TileAnimationDriver;
 
 /**
@@ -66,12 +69,20 @@ public:
 
     void reloadImages(Tileset *tileset);
 
+    void setAsyncImageLoading(bool enabled);
+    bool asyncImageLoading() const;
+
+    bool loadImageAsync(Tileset *tileset);
+
     void setReloadTilesetsOnChange(bool enabled);
     bool reloadTilesetsOnChange() const;
 
     void setAnimateTiles(bool enabled);
     bool animateTiles() const;
 
+    void setReducedAnimations(bool enabled);
+    bool reducedAnimations() const;
+
     void advanceTileAnimations(int ms);
     void resetTileAnimations();
 
@@ -92,6 +103,10 @@ signals:
 
 private:
     void filesChanged(const QStringList &fileNames);
+    void imageLoaded(const QString &fileName, LoadedImage image);
+
+    void animationTick(int ms);
+    void updateAnimationDriver();
 
     /**
      * The list of loaded tilesets (weak references).
@@ -99,6 +114,23 @@ private:
     QList<Tileset*> mTilesets;
     FileSystemWatcher *mWatcher;
     TileAnimationDriver *mAnimationDriver;
+    bool mAnimateTiles = false;
+    bool mReducedAnimations = false;
+
+    /**
+     * Time passed since the tile animations were last advanced, and the time
+     * after which the first of them changes its frame.
+     */
+    int mPendingAnimationTime = 0;
+    int mNextFrameDelay = 0;
+    int mAnimatedTilesGeneration = -1;
+
+    bool mAsyncImageLoading = false;
+
+    /**
+     * The tilesets waiting for their image, by image file name.
+     */
+    QHash<QString, QVector<Tileset*>> mPendingImageLoads;
 
     static TilesetManager *mInstance;
 };
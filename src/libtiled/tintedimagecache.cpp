@@ -0,0 +1,166 @@
+/*
+ * tintedimagecache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tintedimagecache.h"
+
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPainter>
+
+#include <limits>
+
+using namespace Tiled;
+
+namespace {
+
+struct TintedKey
+{
+    qint64 pixmapKey;
+    QRgb color;
+
+    bool operator==(const TintedKey &o) const
+    {
+        return pixmapKey == o.pixmapKey &&
+                color == o.color;
+    }
+};
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+uint qHash(const TintedKey &key, uint seed = 0) Q_DECL_NOTHROW
+{
+    auto h = ::qHash(key.pixmapKey, seed);
+    h = ::qHash(key.color, h);
+    return h;
+}
+#else
+size_t qHash(const TintedKey &key, size_t seed = 0) Q_DECL_NOTHROW
+{
+    return qHashMulti(seed, key.pixmapKey, key.color);
+}
+#endif
+
+} // anonymous namespace
+
+// Cache for up to 100 MB of tinted pixmaps, since tinting is expensive
+static QCache<TintedKey, QPixmap> tintedCache { 100 * 1024 };
+static TintedImageCache::Statistics tintedCacheStatistics;
+static QMutex tintedCacheMutex;
+
+// Borrowed from qpixmapcache.cpp
+static inline qsizetype cost(const QPixmap &pixmap)
+{
+    // make sure to do a 64bit calculation; qsizetype might be smaller
+    const qint64 costKb = static_cast<qint64>(pixmap.width())
+                        * pixmap.height() * pixmap.depth() / (8 * 1024);
+    const qint64 costMax = std::numeric_limits<qsizetype>::max();
+    // a small pixmap should have at least a cost of 1(kb)
+    return static_cast<qsizetype>(qBound(1LL, costKb, costMax));
+}
+
+static QPixmap tint(const QPixmap &pixmap, const QColor &color)
+{
+    QPixmap resultImage = pixmap.copy();
+    QPainter painter(&resultImage);
+
+    QColor fullOpacity = color;
+    fullOpacity.setAlpha(255);
+    // tint the final color (this will will mess up the alpha which we will fix
+    // in the next lines)
+    painter.setCompositionMode(QPainter::CompositionMode_Multiply);
+    painter.fillRect(resultImage.rect(), fullOpacity);
+
+    // apply the original alpha to the final image
+    painter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+    painter.drawPixmap(0, 0, pixmap);
+
+    // apply the alpha of the tint color so that we can use it to make the image
+    // transparent instead of just increasing or decreasing the tint effect
+    painter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+    painter.fillRect(resultImage.rect(), color);
+
+    return resultImage;
+}
+
+/**
+ * Returns whether drawing with the given tint \a color has any effect.
+ */
+bool TintedImageCache::needsTint(const QColor &color)
+{
+    return color.isValid() &&
+            color != QColor(255, 255, 255, 255);
+}
+
+/**
+ * Returns the given \a pixmap tinted with \a color.
+ *
+ * The whole pixmap is tinted, so that for tileset images the tinted result
+ * can be shared by all tiles and the tiles keep their image rect.
+ *
+ * This function is thread-safe.
+ */
+QPixmap TintedImageCache::tinted(const QPixmap &pixmap, const QColor &color)
+{
+    if (pixmap.isNull() || !needsTint(color))
+        return pixmap;
+
+    const TintedKey tintedKey { pixmap.cacheKey(), color.rgba() };
+    QMutexLocker locker(&tintedCacheMutex);
+
+    if (auto cached = tintedCache.object(tintedKey)) {
+        ++tintedCacheStatistics.hits;
+        return *cached;
+    }
+
+    ++tintedCacheStatistics.misses;
+
+    const QPixmap resultImage = tint(pixmap, color);
+    tintedCache.insert(tintedKey, new QPixmap(resultImage), cost(resultImage));
+    return resultImage;
+}
+
+/**
+ * Removes all tinted images from the cache. Called when tint colors change,
+ * since the images tinted with the previous colors are no longer needed.
+ */
+void TintedImageCache::clear()
+{
+    QMutexLocker locker(&tintedCacheMutex);
+    tintedCache.clear();
+}
+
+TintedImageCache::Statistics TintedImageCache::statistics()
+{
+    QMutexLocker locker(&tintedCacheMutex);
+    return tintedCacheStatistics;
+}
+
+void TintedImageCache::resetStatistics()
+{
+    QMutexLocker locker(&tintedCacheMutex);
+    tintedCacheStatistics = Statistics();
+}
@@ -34,6 +34,8 @@
 
 #include <QBuffer>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QXmlStreamReader>
 
 using namespace Tiled;
@@ -48,6 +50,7 @@ std::unique_ptr<Map> TmxMapFormat::read(const QString &fileName)
     mError.clear();
 
     MapReader reader;
+    reader.setParallelLayerDecoding(true);
     std::unique_ptr<Map> map(reader.readMap(fileName));
     if (!map)
         mError = reader.errorString();
@@ -55,10 +58,37 @@ std::unique_ptr<Map> TmxMapFormat::read(const QString &fileName)
     return map;
 }
 
+/**
+ * Reads the contents of the file, since parsing the XML involves loading
+ * tilesets and templates, which needs to happen on the main thread.
+ */
+QVariant TmxMapFormat::parse(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return QVariant();
+
+    return file.readAll();
+}
+
+std::unique_ptr<Map> TmxMapFormat::readParsed(const QString &fileName, const QVariant &data)
+{
+    mError.clear();
+
+    MapReader reader;
+    reader.setParallelLayerDecoding(true);
+    std::unique_ptr<Map> map(reader.readMap(data.toByteArray(), QFileInfo(fileName).absolutePath()));
+    if (!map)
+        mError = reader.errorString();
+
+    return map;
+}
+
 bool TmxMapFormat::write(const Map *map, const QString &fileName, Options options)
 {
     MapWriter writer;
     writer.setMinimizeOutput(options.testFlag(WriteMinimized));
+    writer.setParallelEncoding(true);
 
     bool result = writer.writeMap(map, fileName);
     if (!result)
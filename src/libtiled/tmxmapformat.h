@@ -50,9 +50,13 @@ public:
     TmxMapFormat(QObject *parent = nullptr);
 
     std::unique_ptr<Map> read(const QString &fileName) override;
+    QVariant parse(const QString &fileName) const override;
+    std::unique_ptr<Map> readParsed(const QString &fileName, const QVariant &data) override;
 
     bool write(const Map *map, const QString &fileName, Options options) override;
 
+    Capabilities capabilities() const override { return ReadWrite | WriteInBackground; }
+
     /**
      * Converts the given map to a utf8 byte array (in .tmx format). This is
      * for storing a map in the clipboard. References to other files (like
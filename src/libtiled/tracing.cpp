@@ -0,0 +1,263 @@
+/*
+ * tracing.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tracing.h"
+
+#include "savefile.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+
+#include <memory>
+#include <vector>
+
+namespace Tiled {
+namespace Tracing {
+
+std::atomic<bool> Internal::enabled { false };
+
+namespace {
+
+struct Event
+{
+    const char *name;
+    qint64 start;
+    qint64 end;
+};
+
+/**
+ * Holds the most recent events recorded by a single thread. The mutex is
+ * only contended while the events are being collected for saving.
+ */
+class EventBuffer
+{
+public:
+    static constexpr int capacity = 1 << 14;
+
+    EventBuffer(int threadId, const QString &threadName)
+        : threadId(threadId)
+        , threadName(threadName)
+    {}
+
+    void add(const Event &event)
+    {
+        QMutexLocker locker(&mMutex);
+        if (mEvents.empty())
+            mEvents.resize(capacity);
+        mEvents[mCount % capacity] = event;
+        ++mCount;
+    }
+
+    std::vector<Event> events() const
+    {
+        QMutexLocker locker(&mMutex);
+        std::vector<Event> result;
+        const quint64 first = mCount > capacity ? mCount - capacity : 0;
+        result.reserve(mCount - first);
+        for (quint64 i = first; i < mCount; ++i)
+            result.push_back(mEvents[i % capacity]);
+        return result;
+    }
+
+    void clear()
+    {
+        QMutexLocker locker(&mMutex);
+        mCount = 0;
+    }
+
+    const int threadId;
+    const QString threadName;
+
+private:
+    mutable QMutex mMutex;
+    std::vector<Event> mEvents;
+    quint64 mCount = 0;
+};
+
+struct Registry
+{
+    Registry() { timer.start(); }
+
+    QElapsedTimer timer;
+    QMutex mutex;
+    std::vector<std::shared_ptr<EventBuffer>> buffers;
+};
+
+Registry &registry()
+{
+    static Registry registry;
+    return registry;
+}
+
+/**
+ * Returns the buffer of the current thread. The registry shares ownership,
+ * so that the events remain available after the thread has finished.
+ */
+EventBuffer &threadBuffer()
+{
+    thread_local const std::shared_ptr<EventBuffer> buffer = [] {
+        Registry &r = registry();
+        QMutexLocker locker(&r.mutex);
+
+        const int threadId = static_cast<int>(r.buffers.size()) + 1;
+        const QThread *thread = QThread::currentThread();
+
+        QString threadName = thread->objectName();
+        if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+            threadName = QStringLiteral("Main");
+        else if (threadName.isEmpty())
+            threadName = QStringLiteral("Thread %1").arg(threadId);
+
+        auto buffer = std::make_shared<EventBuffer>(threadId, threadName);
+        r.buffers.push_back(buffer);
+        return buffer;
+    }();
+
+    return *buffer;
+}
+
+} // anonymous namespace
+
+/**
+ * Enables or disables the recording of trace events. Events recorded
+ * earlier are kept until clear() is called.
+ */
+void setEnabled(bool enabled)
+{
+    registry();     // make sure the timer is started
+    Internal::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * Returns the current time in nanoseconds, relative to an arbitrary moment
+ * shared by all threads.
+ */
+qint64 now()
+{
+    return registry().timer.nsecsElapsed();
+}
+
+/**
+ * Adds an event with the given \a name, from \a start to \a end, to the
+ * events recorded by the current thread.
+ */
+void addEvent(const char *name, qint64 start, qint64 end)
+{
+    threadBuffer().add({ name, start, end });
+}
+
+/**
+ * Removes all recorded events.
+ */
+void clear()
+{
+    Registry &r = registry();
+    QMutexLocker locker(&r.mutex);
+    for (const auto &buffer : r.buffers)
+        buffer->clear();
+}
+
+/**
+ * Returns the recorded events in the JSON based Chrome trace event format.
+ */
+QByteArray toJson()
+{
+    std::vector<std::shared_ptr<EventBuffer>> buffers;
+    {
+        Registry &r = registry();
+        QMutexLocker locker(&r.mutex);
+        buffers = r.buffers;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray traceEvents;
+
+    for (const auto &buffer : buffers) {
+        traceEvents.append(QJsonObject {
+            { QStringLiteral("name"), QStringLiteral("thread_name") },
+            { QStringLiteral("ph"), QStringLiteral("M") },
+            { QStringLiteral("pid"), pid },
+            { QStringLiteral("tid"), buffer->threadId },
+            { QStringLiteral("args"), QJsonObject {
+                  { QStringLiteral("name"), buffer->threadName }
+              } },
+        });
+
+        for (const Event &event : buffer->events()) {
+            traceEvents.append(QJsonObject {
+                { QStringLiteral("name"), QLatin1String(event.name) },
+                { QStringLiteral("cat"), QStringLiteral("tiled") },
+                { QStringLiteral("ph"), QStringLiteral("X") },
+                { QStringLiteral("ts"), event.start / 1000.0 },
+                { QStringLiteral("dur"), (event.end - event.start) / 1000.0 },
+                { QStringLiteral("pid"), pid },
+                { QStringLiteral("tid"), buffer->threadId },
+            });
+        }
+    }
+
+    const QJsonObject trace {
+        { QStringLiteral("traceEvents"), traceEvents },
+        { QStringLiteral("displayTimeUnit"), QStringLiteral("ms") },
+    };
+
+    return QJsonDocument(trace).toJson(QJsonDocument::Compact);
+}
+
+/**
+ * Writes the recorded events to the given \a fileName. Returns false and sets
+ * \a error when saving failed.
+ */
+bool writeChromeTrace(const QString &fileName, QString *error)
+{
+    SaveFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error)
+            *error = QCoreApplication::translate("File Errors", "Could not open file for writing.");
+        return false;
+    }
+
+    file.device()->write(toJson());
+
+    if (file.error() != QFileDevice::NoError || !file.commit()) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Tracing
+} // namespace Tiled
@@ -0,0 +1,114 @@
+/*
+ * tracing.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QString>
+
+#include <atomic>
+
+/**
+ * Lightweight tracing of the time spent in selected functions, meant for
+ * finding out where time is spent when the editor is reported to be slow.
+ *
+ * Each thread records its events in its own ring buffer, which keeps only
+ * the most recent events. The recorded events can be saved in the Chrome
+ * trace event format, which can be opened in Perfetto (ui.perfetto.dev) or
+ * chrome://tracing.
+ */
+namespace Tiled {
+namespace Tracing {
+
+namespace Internal {
+extern TILEDSHARED_EXPORT std::atomic<bool> enabled;
+} // namespace Internal
+
+/**
+ * Returns whether trace events are currently being recorded.
+ */
+inline bool isEnabled()
+{
+    return Internal::enabled.load(std::memory_order_relaxed);
+}
+
+TILEDSHARED_EXPORT void setEnabled(bool enabled);
+
+TILEDSHARED_EXPORT qint64 now();
+TILEDSHARED_EXPORT void addEvent(const char *name, qint64 start, qint64 end);
+
+TILEDSHARED_EXPORT void clear();
+TILEDSHARED_EXPORT QByteArray toJson();
+TILEDSHARED_EXPORT bool writeChromeTrace(const QString &fileName, QString *error = nullptr);
+
+/**
+ * Records a trace event for the lifetime of this object, when tracing is
+ * enabled. The \a name needs to outlive the recorded events, so it should
+ * usually be a string literal.
+ *
+ * Use the TILED_TRACE_SCOPE macro, so that it can be compiled out.
+ */
+class Scope
+{
+public:
+    explicit Scope(const char *name)
+        : mName(name)
+        , mStart(isEnabled() ? now() : -1)
+    {}
+
+    ~Scope()
+    {
+        if (mStart != -1)
+            addEvent(mName, mStart, now());
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    const char *mName;
+    const qint64 mStart;
+};
+
+} // namespace Tracing
+} // namespace Tiled
+
+#define TILED_TRACE_CONCAT_IMPL(a, b) a##b
+#define TILED_TRACE_CONCAT(a, b) TILED_TRACE_CONCAT_IMPL(a, b)
+
+/**
+ * Records the time spent in the enclosing scope under the given name.
+ * Defining TILED_DISABLE_TRACING removes all tracing at compile-time.
+ */
+#ifdef TILED_DISABLE_TRACING
+#define TILED_TRACE_SCOPE(name) static_cast<void>(0)
+#else
+#define TILED_TRACE_SCOPE(name) \
+    const Tiled::Tracing::Scope TILED_TRACE_CONCAT(tiledTraceScope, __LINE__)(name)
+#endif
@@ -34,6 +34,7 @@
 #include "tilesetmanager.h"
 #include "wangset.h"
 
+#include <limits>
 #include <memory>
 
 namespace Tiled {
@@ -115,6 +116,18 @@ std::unique_ptr<Map> VariantToMapConverter::toMap(const QVariant &variant,
         map->addTileset(tileset);
     }
 
+    mGidMapper.setCompressionDictionary(CompressionDictionary());
+
+    const QString layerDictionary = variantMap[QStringLiteral("layerdictionary")].toString();
+    if (!layerDictionary.isEmpty()) {
+        const CompressionDictionary dictionary(QByteArray::fromBase64(layerDictionary.toLatin1()));
+        if (dictionary.isNull()) {
+            mError = tr("Invalid or unsupported layer data dictionary");
+            return nullptr;
+        }
+        mGidMapper.setCompressionDictionary(dictionary);
+    }
+
     const auto layerVariants = variantMap[QStringLiteral("layers")].toList();
     for (const QVariant &layerVariant : layerVariants) {
         std::unique_ptr<Layer> layer = toLayer(layerVariant);
@@ -177,7 +190,7 @@ Properties VariantToMapConverter::toProperties(const QVariant &propertiesVariant
         exportValue.typeName = propertyTypesMap.value(it.key()).toString();
         // TODO: Support for custom property types with customPropertyTypesMap
 
-        properties[it.key()] = context.toPropertyValue(exportValue);
+        properties[mPropertiesDeduplicator.name(it.key())] = context.toPropertyValue(exportValue);
     }
 
     // read array-based format (1.2)
@@ -186,10 +199,10 @@ Properties VariantToMapConverter::toProperties(const QVariant &propertiesVariant
         const QVariantMap propertyVariantMap = propertyVariant.toMap();
         const QString propertyName = propertyVariantMap[QStringLiteral("name")].toString();
 
-        properties[propertyName] = toPropertyValue(propertyVariantMap, context);
+        properties[mPropertiesDeduplicator.name(propertyName)] = toPropertyValue(propertyVariantMap, context);
     }
 
-    return properties;
+    return mPropertiesDeduplicator.deduplicate(properties);
 }
 
 QVariant VariantToMapConverter::toPropertyValue(const QVariantMap &valueVariantMap,
@@ -673,6 +686,7 @@ std::unique_ptr<TileLayer> VariantToMapConverter::toTileLayer(const QVariantMap
 
     const QString encoding = variantMap[QStringLiteral("encoding")].toString();
     const QString compression = variantMap[QStringLiteral("compression")].toString();
+    const QString filter = variantMap[QStringLiteral("filter")].toString();
 
     Map::LayerDataFormat layerDataFormat;
     if (encoding.isEmpty() || encoding == QLatin1String("csv")) {
@@ -685,7 +699,8 @@ std::unique_ptr<TileLayer> VariantToMapConverter::toTileLayer(const QVariantMap
         } else if (compression == QLatin1String("zlib")) {
             layerDataFormat = Map::Base64Zlib;
         } else if (compression == QLatin1String("zstd")) {
-            layerDataFormat = Map::Base64Zstandard;
+            layerDataFormat = filter == QLatin1String("delta") ? Map::Base64ZstandardDictionary
+                                                               : Map::Base64Zstandard;
         } else {
             mError = tr("Compression method '%1' not supported").arg(compression);
             return nullptr;
@@ -694,6 +709,11 @@ std::unique_ptr<TileLayer> VariantToMapConverter::toTileLayer(const QVariantMap
         mError = tr("Unknown encoding: %1").arg(encoding);
         return nullptr;
     }
+
+    if (!filter.isEmpty() && layerDataFormat != Map::Base64ZstandardDictionary) {
+        mError = tr("Filter '%1' not supported").arg(filter);
+        return nullptr;
+    }
     mMap->setLayerDataFormat(layerDataFormat);
 
     if (dataVariant.isValid() && !dataVariant.isNull()) {
@@ -747,7 +767,7 @@ std::unique_ptr<MapObject> VariantToMapConverter::toMapObject(const QVariantMap
 {
     const QString name = variantMap[QStringLiteral("name")].toString();
     const int id = variantMap[QStringLiteral("id")].toInt();
-    const int gid = variantMap[QStringLiteral("gid")].toInt();
+    const unsigned gid = variantMap[QStringLiteral("gid")].toUInt();
     const QVariant templateVariant = variantMap[QStringLiteral("template")];
     const qreal x = variantMap[QStringLiteral("x")].toReal();
     const qreal y = variantMap[QStringLiteral("y")].toReal();
@@ -770,32 +790,9 @@ std::unique_ptr<MapObject> VariantToMapConverter::toMapObject(const QVariantMap
         object->setPropertyChanged(MapObject::RotationProperty);
     }
 
-    if (!templateVariant.isNull()) { // This object is a template instance
-        QString templateFileName = resolvePath(mDir, templateVariant);
-        auto objectTemplate = TemplateManager::instance()->loadObjectTemplate(templateFileName);
-        object->setObjectTemplate(objectTemplate);
-    }
-
-    object->setId(id);
-
     object->setPropertyChanged(MapObject::NameProperty, !name.isEmpty());
     object->setPropertyChanged(MapObject::SizeProperty, !size.isEmpty());
 
-    if (gid) {
-        bool ok;
-        object->setCell(mGidMapper.gidToCell(gid, ok));
-
-        if (const Tile *tile = object->cell().tile()) {
-            const QSizeF &tileSize = tile->size();
-            if (width == 0)
-                object->setWidth(tileSize.width());
-            if (height == 0)
-                object->setHeight(tileSize.height());
-        }
-
-        object->setPropertyChanged(MapObject::CellProperty);
-    }
-
     if (variantMap.contains(QLatin1String("visible"))) {
         object->setVisible(variantMap[QStringLiteral("visible")].toBool());
         object->setPropertyChanged(MapObject::VisibleProperty);
@@ -838,11 +835,47 @@ std::unique_ptr<MapObject> VariantToMapConverter::toMapObject(const QVariantMap
         object->setPropertyChanged(MapObject::TextProperty);
     }
 
-    object->syncWithTemplate();
+    resolveMapObject(*object, templateVariant, gid);
 
     return object;
 }
 
+/**
+ * Sets up the template and the tile of the given \a object, and syncs it
+ * with its template. Needs to be called after the tilesets have been read.
+ */
+void VariantToMapConverter::resolveMapObject(MapObject &object,
+                                             const QVariant &templateVariant,
+                                             unsigned gid)
+{
+    if (!templateVariant.isNull()) { // This object is a template instance
+        QString templateFileName = resolvePath(mDir, templateVariant);
+        auto objectTemplate = TemplateManager::instance()->loadObjectTemplate(templateFileName);
+        object.setObjectTemplate(objectTemplate);
+    }
+
+    if (gid) {
+        bool ok;
+        object.setCell(mGidMapper.gidToCell(gid, ok));
+
+        if (const Tile *tile = object.cell().tile()) {
+            QSizeF tileSize = tile->size();
+
+            // The tileset image may still be loading
+            if (tileSize.isEmpty() && !tile->tileset()->isCollection())
+                tileSize = tile->tileset()->tileSize();
+            if (object.width() == 0)
+                object.setWidth(tileSize.width());
+            if (object.height() == 0)
+                object.setHeight(tileSize.height());
+        }
+
+        object.setPropertyChanged(MapObject::CellProperty);
+    }
+
+    object.syncWithTemplate();
+}
+
 std::unique_ptr<ImageLayer> VariantToMapConverter::toImageLayer(const QVariantMap &variantMap)
 {
     using ImageLayerPtr = std::unique_ptr<ImageLayer>;
@@ -956,8 +989,8 @@ void VariantToMapConverter::readMapEditorSettings(Map &map, const QVariantMap &e
     const QVariantMap chunkSizeVariant = editorSettings[QStringLiteral("chunksize")].toMap();
     int chunkWidth = chunkSizeVariant[QStringLiteral("width")].toInt();
     int chunkHeight = chunkSizeVariant[QStringLiteral("height")].toInt();
-    chunkWidth = chunkWidth == 0 ? CHUNK_SIZE : qMax(CHUNK_SIZE_MIN, chunkWidth);
-    chunkHeight = chunkHeight == 0 ? CHUNK_SIZE : qMax(CHUNK_SIZE_MIN, chunkHeight);
+    chunkWidth = chunkWidth == 0 ? OUTPUT_CHUNK_SIZE : qMax(CHUNK_SIZE_MIN, chunkWidth);
+    chunkHeight = chunkHeight == 0 ? OUTPUT_CHUNK_SIZE : qMax(CHUNK_SIZE_MIN, chunkHeight);
     map.setChunkSize(QSize(chunkWidth, chunkHeight));
 
     const QVariantMap exportVariant = editorSettings[QStringLiteral("export")].toMap();
@@ -984,6 +1017,11 @@ bool VariantToMapConverter::readTileLayerData(TileLayer &tileLayer,
     switch (layerDataFormat) {
     case Map::XML:
     case Map::CSV: {
+        // The JSON map format passes the array as-is, avoiding the creation
+        // of a QVariant for each tile
+        if (dataVariant.userType() == QMetaType::QJsonArray)
+            return readTileLayerData(tileLayer, dataVariant.toJsonArray(), bounds);
+
         const QVariantList dataVariantList = dataVariant.toList();
 
         if (dataVariantList.size() != bounds.width() * bounds.height()) {
@@ -1019,7 +1057,8 @@ bool VariantToMapConverter::readTileLayerData(TileLayer &tileLayer,
     case Map::Base64:
     case Map::Base64Zlib:
     case Map::Base64Gzip:
-    case Map::Base64Zstandard:{
+    case Map::Base64Zstandard:
+    case Map::Base64ZstandardDictionary: {
         const QByteArray data = dataVariant.toByteArray();
         GidMapper::DecodeError error = mGidMapper.decodeLayerData(tileLayer,
                                                                   data,
@@ -1047,6 +1086,48 @@ bool VariantToMapConverter::readTileLayerData(TileLayer &tileLayer,
     return true;
 }
 
+bool VariantToMapConverter::readTileLayerData(TileLayer &tileLayer,
+                                              const QJsonArray &data,
+                                              QRect bounds)
+{
+    if (data.size() != bounds.width() * bounds.height()) {
+        mError = tr("Corrupt layer data for layer '%1'").arg(tileLayer.name());
+        return false;
+    }
+
+    int x = bounds.x();
+    int y = bounds.y();
+    bool ok;
+
+    for (const QJsonValue value : data) {
+        unsigned gid;
+
+        if (value.isDouble()) {
+            const double number = value.toDouble();
+            ok = number >= 0 && number <= std::numeric_limits<unsigned>::max();
+            gid = static_cast<unsigned>(number);
+        } else {
+            gid = value.toVariant().toUInt(&ok);
+        }
+
+        if (!ok) {
+            mError = tr("Unable to parse tile at (%1,%2) on layer '%3'")
+                    .arg(x).arg(y).arg(tileLayer.name());
+            return false;
+        }
+
+        tileLayer.setCell(x, y, mGidMapper.gidToCell(gid, ok));
+
+        x++;
+        if (x > bounds.right()) {
+            x = bounds.x();
+            y++;
+        }
+    }
+
+    return true;
+}
+
 Properties VariantToMapConverter::extractProperties(const QVariantMap &variantMap) const
 {
     return toProperties(variantMap[QStringLiteral("properties")],
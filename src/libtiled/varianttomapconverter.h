@@ -26,6 +26,7 @@
 
 #include <QCoreApplication>
 #include <QDir>
+#include <QJsonArray>
 #include <QVariant>
 
 namespace Tiled {
@@ -96,6 +97,7 @@ private:
     std::unique_ptr<TileLayer> toTileLayer(const QVariantMap &variantMap);
     std::unique_ptr<ObjectGroup> toObjectGroup(const QVariantMap &variantMap);
     std::unique_ptr<MapObject> toMapObject(const QVariantMap &variantMap);
+    void resolveMapObject(MapObject &object, const QVariant &templateVariant, unsigned gid);
     std::unique_ptr<ImageLayer> toImageLayer(const QVariantMap &variantMap);
     std::unique_ptr<GroupLayer> toGroupLayer(const QVariantMap &variantMap);
 
@@ -108,6 +110,9 @@ private:
                            const QVariant &dataVariant,
                            Map::LayerDataFormat layerDataFormat,
                            QRect bounds);
+    bool readTileLayerData(TileLayer &tileLayer,
+                           const QJsonArray &data,
+                           QRect bounds);
 
     Properties extractProperties(const QVariantMap &variantMap) const;
 
@@ -115,7 +120,10 @@ private:
     QDir mDir;
     bool mReadingExternalTileset = false;
     GidMapper mGidMapper;
+    mutable PropertiesDeduplicator mPropertiesDeduplicator;
     QString mError;
+
+    friend class JsonMapReader;
 };
 
 } // namespace Tiled
@@ -447,8 +447,7 @@ void WangSet::setType(Type type)
         break;
     }
 
-    mColorDistancesDirty = true;
-    mCellsDirty = true;
+    ++mTilesRevision;
 }
 
 /**
@@ -480,6 +479,8 @@ void WangSet::setColorCount(int n)
             mColors.last()->mWangSet = this;
         }
     }
+
+    ++mColorsRevision;
 }
 
 /**
@@ -497,7 +498,7 @@ void WangSet::insertWangColor(const QSharedPointer<WangColor> &wangColor)
     for (int i = wangColor->colorIndex(); i < colorCount(); ++i)
         mColors.at(i)->setColorIndex(i + 1);
 
-    mColorDistancesDirty = true;
+    ++mColorsRevision;
 }
 
 /**
@@ -526,7 +527,7 @@ QSharedPointer<WangColor> WangSet::takeWangColorAt(int color)
     for (int i = color - 1; i < colorCount(); ++i)
         mColors.at(i)->setColorIndex(i + 1);
 
-    mColorDistancesDirty = true;
+    ++mColorsRevision;
     return wangColor;
 }
 
@@ -553,15 +554,13 @@ void WangSet::setWangId(int tileId, WangId wangId)
         return;
 
     mTileIdToWangId.insert(tileId, wangId);
-    mColorDistancesDirty = true;
-    mCellsDirty = true;
+    ++mTilesRevision;
 }
 
 void WangSet::removeTileId(int tileId)
 {
     mTileIdToWangId.remove(tileId);
-    mColorDistancesDirty = true;
-    mCellsDirty = true;
+    ++mTilesRevision;
 }
 
 /**
@@ -580,7 +579,7 @@ const QVector<WangSet::WangIdAndCell> &WangSet::wangIdsAndCells() const
 void WangSet::recalculateCells()
 {
     mWangIdAndCells.clear();
-    mCellsDirty = false;
+    mCellsRevision = mTilesRevision;
     mUniqueFullWangIdCount = 0;
 
     const auto mask = typeMask();
@@ -601,8 +600,10 @@ void WangSet::recalculateCells()
     const auto transformationFlags = tileset()->transformationFlags();
     mLastSeenTranslationFlags = transformationFlags;
 
-    if (!(transformationFlags & ~Tileset::PreferUntransformed))
+    if (!(transformationFlags & ~Tileset::PreferUntransformed)) {
+        recalculateCandidateIndex();
         return;
+    }
 
     // Then insert variations based on flipping
     it.toFront();
@@ -656,6 +657,31 @@ void WangSet::recalculateCells()
             mWangIdAndCells.append({wangIds[i], cells[i]});
         }
     }
+
+    recalculateCandidateIndex();
+}
+
+/**
+ * Sets up the bitsets used by forEachMatchingWangIdAndCell, which avoid
+ * having to check each WangId of large Wang sets.
+ */
+void WangSet::recalculateCandidateIndex()
+{
+    mCandidateMaxColor = 0;
+    for (const WangIdAndCell &entry : std::as_const(mWangIdAndCells))
+        for (int i = 0; i < WangId::NumIndexes; ++i)
+            mCandidateMaxColor = qMax(mCandidateMaxColor, entry.wangId.indexColor(i));
+
+    mCandidateWords = static_cast<int>((mWangIdAndCells.size() + 63) / 64);
+    mCandidateBits.assign(static_cast<size_t>(mCandidateMaxColor + 1) * WangId::NumIndexes * mCandidateWords, 0);
+
+    for (qsizetype e = 0; e < mWangIdAndCells.size(); ++e) {
+        const WangId wangId = mWangIdAndCells.at(e).wangId;
+        for (int i = 0; i < WangId::NumIndexes; ++i) {
+            quint64 *row = mCandidateBits.data() + (wangId.indexColor(i) * WangId::NumIndexes + i) * mCandidateWords;
+            row[e / 64] |= Q_UINT64_C(1) << (e % 64);
+        }
+    }
 }
 
 /**
@@ -743,7 +769,7 @@ void WangSet::recalculateColorDistances()
     } while (newConnections);
 
     mMaximumColorDistance = maximumDistance;
-    mColorDistancesDirty = false;
+    mColorDistancesRevision = revision();
 }
 
 /**
@@ -847,18 +873,15 @@ bool WangSet::wangIdIsValid(WangId wangId, int colorCount)
 bool WangSet::wangIdIsUsed(WangId wangId, WangId mask) const
 {
     mask &= typeMask();
-    const WangId maskedWangId = wangId & mask;
 
-    for (const auto &wangIdAndCell : wangIdsAndCells())
-        if ((wangIdAndCell.wangId & mask) == maskedWangId)
-            return true;
-
-    return false;
+    bool used = false;
+    forEachMatchingWangIdAndCell(wangId, mask, [&] (const WangIdAndCell &) { used = true; });
+    return used;
 }
 
 int WangSet::transitionPenalty(int colorA, int colorB) const
 {
-    if (mColorDistancesDirty)
+    if (colorDistancesDirty())
         const_cast<WangSet*>(this)->recalculateColorDistances();
 
     // Do some magic, since we don't have a transition array for no-color
@@ -873,7 +896,7 @@ int WangSet::transitionPenalty(int colorA, int colorB) const
 
 int WangSet::maximumColorDistance() const
 {
-    if (mColorDistancesDirty)
+    if (colorDistancesDirty())
         const_cast<WangSet*>(this)->recalculateColorDistances();
 
     return mMaximumColorDistance;
@@ -998,9 +1021,14 @@ WangSet *WangSet::clone(Tileset *tileset) const
     c->mColors = mColors;
     c->mTileIdToWangId = mTileIdToWangId;
     c->mWangIdAndCells = mWangIdAndCells;
+    c->mCandidateBits = mCandidateBits;
+    c->mCandidateWords = mCandidateWords;
+    c->mCandidateMaxColor = mCandidateMaxColor;
     c->mMaximumColorDistance = mMaximumColorDistance;
-    c->mColorDistancesDirty = mColorDistancesDirty;
-    c->mCellsDirty = mCellsDirty;
+    c->mTilesRevision = mTilesRevision;
+    c->mColorsRevision = mColorsRevision;
+    c->mCellsRevision = mCellsRevision;
+    c->mColorDistancesRevision = mColorDistancesRevision;
     c->mLastSeenTranslationFlags = mLastSeenTranslationFlags;
 
     // Avoid sharing Wang colors
@@ -36,6 +36,9 @@
 #include <QMultiHash>
 #include <QString>
 #include <QList>
+#include <QtAlgorithms>
+
+#include <vector>
 
 namespace Tiled {
 
@@ -295,6 +298,9 @@ public:
 
     const QVector<WangIdAndCell> &wangIdsAndCells() const;
 
+    template<typename Callback>
+    void forEachMatchingWangIdAndCell(WangId wangId, WangId mask, Callback callback) const;
+
     QList<WangTile> sortedWangTiles() const;
 
     WangId wangIdOfTile(const Tile *tile) const;
@@ -321,13 +327,24 @@ public:
 
     WangSet *clone(Tileset *tileset) const;
 
+    /**
+     * Returns a number that changes each time the tiles, the colors or the
+     * type of this Wang set change. Data derived from the Wang set can be
+     * cached along with this revision.
+     */
+    quint64 revision() const { return mTilesRevision + mColorsRevision; }
+
 private:
     void removeTileId(int tileId);
 
     bool cellsDirty() const;
+    bool colorDistancesDirty() const;
     void recalculateCells();
+    void recalculateCandidateIndex();
     void recalculateColorDistances();
 
+    const quint64 *candidateBits(int index, int color) const;
+
     Tileset *mTileset;
     QString mName;
     Type mType;
@@ -343,9 +360,19 @@ private:
 
     QVector<WangIdAndCell> mWangIdAndCells;
 
+    // For each index and color, a bitset with a bit set for each entry in
+    // mWangIdAndCells that has this color at this index.
+    std::vector<quint64> mCandidateBits;
+    int mCandidateWords = 0;
+    int mCandidateMaxColor = -1;
+
     int mMaximumColorDistance = 0;
-    bool mColorDistancesDirty = true;
-    bool mCellsDirty = true;
+    // Incremented on each change to the tiles or the colors, to know whether
+    // the derived data needs to be calculated again
+    quint64 mTilesRevision = 1;
+    quint64 mColorsRevision = 0;
+    quint64 mCellsRevision = 0;             // tiles revision of mWangIdAndCells
+    quint64 mColorDistancesRevision = 0;    // revision of the color distances
     Tileset::TransformationFlags mLastSeenTranslationFlags;
 };
 
@@ -414,7 +441,69 @@ inline bool WangSet::isEmpty() const
 
 inline bool WangSet::cellsDirty() const
 {
-    return mCellsDirty || mLastSeenTranslationFlags != mTileset->transformationFlags();
+    return mCellsRevision != mTilesRevision || mLastSeenTranslationFlags != mTileset->transformationFlags();
+}
+
+inline bool WangSet::colorDistancesDirty() const
+{
+    return mColorDistancesRevision != revision();
+}
+
+inline const quint64 *WangSet::candidateBits(int index, int color) const
+{
+    return mCandidateBits.data() + (color * WangId::NumIndexes + index) * mCandidateWords;
+}
+
+/**
+ * Calls \a callback for each entry in wangIdsAndCells() that matches the
+ * given \a wangId at the indexes included in \a mask, in order.
+ *
+ * Uses a per-index color index, so that only the matching entries need to be
+ * visited.
+ */
+template<typename Callback>
+void WangSet::forEachMatchingWangIdAndCell(WangId wangId, WangId mask, Callback callback) const
+{
+    const auto &entries = wangIdsAndCells();    // updates the index when needed
+
+    const quint64 *rows[WangId::NumIndexes];
+    int rowCount = 0;
+
+    for (int i = 0; i < WangId::NumIndexes; ++i) {
+        const int maskColor = mask.indexColor(i);
+        if (!maskColor)
+            continue;
+
+        // The index only handles masks covering entire indexes
+        if (maskColor != WangId::INDEX_MASK) {
+            const WangId maskedWangId = wangId & mask;
+            for (const WangIdAndCell &entry : entries)
+                if ((entry.wangId & mask) == maskedWangId)
+                    callback(entry);
+            return;
+        }
+
+        const int color = wangId.indexColor(i);
+        if (color > mCandidateMaxColor)
+            return;     // no entry has this color at this index
+
+        rows[rowCount++] = candidateBits(i, color);
+    }
+
+    for (int w = 0; w < mCandidateWords; ++w) {
+        quint64 bits = ~Q_UINT64_C(0);
+        if (w == mCandidateWords - 1 && entries.size() % 64)
+            bits >>= 64 - entries.size() % 64;
+
+        for (int r = 0; r < rowCount && bits; ++r)
+            bits &= rows[r][w];
+
+        while (bits) {
+            const int bit = qCountTrailingZeroBits(bits);
+            bits &= bits - 1;
+            callback(entries.at(w * 64 + bit));
+        }
+    }
 }
 
 TILEDSHARED_EXPORT QString wangSetTypeToString(WangSet::Type type);
@@ -28,6 +28,7 @@
 
 #include "world.h"
 
+#include "filesystemwatcher.h"
 #include "logginginterface.h"
 
 #include <QCoreApplication>
@@ -38,20 +39,49 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QThread>
 #include <QUrl>
+#include <QtMath>
 
 #include <QDebug>
 
+#include <algorithm>
+
 namespace Tiled {
 
+/**
+ * Returns the range of grid cells covered by the given \a rect.
+ */
+static QRect cellRange(const QRect &rect, QSize cellSize)
+{
+    return QRect(QPoint(qFloor(rect.left() / qreal(cellSize.width())),
+                        qFloor(rect.top() / qreal(cellSize.height()))),
+                 QPoint(qFloor(rect.right() / qreal(cellSize.width())),
+                        qFloor(rect.bottom() / qreal(cellSize.height()))));
+}
+
+static qint64 cellCount(const QRect &cells)
+{
+    return qint64(cells.width()) * cells.height();
+}
+
+static quint64 cellKey(int x, int y)
+{
+    return (quint64(quint32(x)) << 32) | quint32(y);
+}
+
+World::~World() = default;
+
 void World::setMapRect(int mapIndex, const QRect &rect)
 {
     maps[mapIndex].rect = rect;
+    invalidateMapIndex();
 }
 
 void World::removeMap(int mapIndex)
 {
     maps.removeAt(mapIndex);
+    invalidateMapIndex();
 }
 
 void World::addMap(const QString &fileName, const QRect &rect)
@@ -60,6 +90,7 @@ void World::addMap(const QString &fileName, const QRect &rect)
     entry.rect = rect;
     entry.fileName = fileName;
     maps.append(entry);
+    invalidateMapIndex();
 }
 
 int World::mapIndex(const QString &fileName) const
@@ -115,6 +146,11 @@ QRect World::mapRect(const QString &fileName) const
 }
 
 QVector<WorldMapEntry> World::allMaps() const
+{
+    return indexedMaps().entries;
+}
+
+QVector<WorldMapEntry> World::resolveAllMaps() const
 {
     QVector<WorldMapEntry> all(maps);
 
@@ -145,11 +181,40 @@ QVector<WorldMapEntry> World::allMaps() const
 
 QVector<WorldMapEntry> World::mapsInRect(const QRect &rect) const
 {
-    QVector<WorldMapEntry> maps(allMaps());
+    const MapIndex &index = indexedMaps();
+    QVector<WorldMapEntry> maps;
+
+    if (index.cellSize.isEmpty() || rect.isEmpty())
+        return maps;
+
+    const QRect cells = cellRange(rect, index.cellSize);
+
+    // Checking each entry is faster when the rect covers most of the world
+    if (cellCount(cells) > index.entries.size()) {
+        for (const WorldMapEntry &entry : index.entries)
+            if (entry.rect.intersects(rect))
+                maps.append(entry);
+        return maps;
+    }
+
+    QVector<int> candidates(index.largeEntries);
+    for (int y = cells.top(); y <= cells.bottom(); ++y) {
+        for (int x = cells.left(); x <= cells.right(); ++x) {
+            const auto it = index.cells.constFind(cellKey(x, y));
+            if (it != index.cells.constEnd())
+                candidates.append(*it);
+        }
+    }
+
+    // Return the maps in the same order as allMaps()
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
 
-    maps.erase(std::remove_if(maps.begin(), maps.end(),
-                              [&](const WorldMapEntry &mapEntry) { return !mapEntry.rect.intersects(rect); }),
-               maps.end());
+    for (int i : std::as_const(candidates)) {
+        const WorldMapEntry &entry = index.entries.at(i);
+        if (entry.rect.intersects(rect))
+            maps.append(entry);
+    }
 
     return maps;
 }
@@ -166,20 +231,86 @@ QString World::firstMap() const
     if (!maps.isEmpty())
         return maps.first().fileName;
 
-    if (!patterns.isEmpty()) {
-        const QDir dir(QFileInfo(fileName).dir());
-        const QStringList entries = dir.entryList(QDir::Files | QDir::Readable);
+    const MapIndex &index = indexedMaps();
+    if (!index.entries.isEmpty())
+        return index.entries.first().fileName;
 
-        for (const WorldPattern &pattern : patterns) {
-            for (const QString &fileName : entries) {
-                QRegularExpressionMatch match = pattern.regexp.match(fileName);
-                if (match.hasMatch())
-                    return dir.filePath(fileName);
-            }
+    return QString();
+}
+
+/**
+ * Returns the resolved map entries and their spatial index.
+ *
+ * On the main thread, the index is cached until the maps are changed or,
+ * for worlds using patterns, until the contents of the folder of the world
+ * change. On other threads, the index is built on each call.
+ */
+World::MapIndex World::indexedMaps() const
+{
+    const bool isMainThread = QCoreApplication::instance() &&
+            QThread::currentThread() == QCoreApplication::instance()->thread();
+
+    if (!isMainThread)
+        return buildMapIndex();
+
+    if (!mMapIndex.valid) {
+        if (!patterns.isEmpty() && !mDirectoryWatcher) {
+            mDirectoryWatcher = std::make_unique<FileSystemWatcher>();
+            mDirectoryWatcher->addPath(QFileInfo(fileName).path());
+            QObject::connect(mDirectoryWatcher.get(), &FileSystemWatcher::directoryChanged,
+                             mDirectoryWatcher.get(), [this] { invalidateMapIndex(); });
         }
+
+        mMapIndex = buildMapIndex();
     }
 
-    return QString();
+    return mMapIndex;
+}
+
+World::MapIndex World::buildMapIndex() const
+{
+    MapIndex index;
+    index.entries = resolveAllMaps();
+
+    // Use the average map size as cell size, so that most maps cover only a
+    // few cells
+    if (!index.entries.isEmpty()) {
+        qint64 totalWidth = 0;
+        qint64 totalHeight = 0;
+        for (const WorldMapEntry &entry : std::as_const(index.entries)) {
+            totalWidth += entry.rect.width();
+            totalHeight += entry.rect.height();
+        }
+        index.cellSize = QSize(qMax<qint64>(1, totalWidth / index.entries.size()),
+                               qMax<qint64>(1, totalHeight / index.entries.size()));
+    }
+
+    constexpr qint64 maximumCellsPerEntry = 64;
+
+    for (int i = 0; i < index.entries.size(); ++i) {
+        const QRect &rect = index.entries.at(i).rect;
+        if (rect.isEmpty())
+            continue;
+
+        const QRect cells = cellRange(rect, index.cellSize);
+
+        if (cellCount(cells) > maximumCellsPerEntry) {
+            index.largeEntries.append(i);
+            continue;
+        }
+
+        for (int y = cells.top(); y <= cells.bottom(); ++y)
+            for (int x = cells.left(); x <= cells.right(); ++x)
+                index.cells[cellKey(x, y)].append(i);
+    }
+
+    index.valid = true;
+    return index;
+}
+
+void World::invalidateMapIndex() const
+{
+    mMapIndex = MapIndex();
 }
 
 void World::error(const QString &message) const
@@ -31,6 +31,7 @@
 #include "object.h"
 
 #include <QCoreApplication>
+#include <QHash>
 #include <QPoint>
 #include <QRect>
 #include <QRegularExpression>
@@ -41,6 +42,8 @@
 
 namespace Tiled {
 
+class FileSystemWatcher;
+
 class TILEDSHARED_EXPORT WorldMapEntry
 {
     Q_GADGET
@@ -75,6 +78,7 @@ class TILEDSHARED_EXPORT World : public Object
 
 public:
     World() : Object(WorldType) {}
+    ~World() override;
 
     QString fileName;
     QVector<WorldMapEntry> maps;
@@ -109,6 +113,28 @@ public:
                                        QString *errorString = nullptr);
     static bool save(World &world,
                      QString *errorString = nullptr);
+
+private:
+    /**
+     * The resolved map entries along with a grid index of their rects, so
+     * that the maps within a certain area can be looked up quickly.
+     */
+    struct MapIndex
+    {
+        QVector<WorldMapEntry> entries;
+        QHash<quint64, QVector<int>> cells;
+        QVector<int> largeEntries;  // entries covering too many cells
+        QSize cellSize;
+        bool valid = false;
+    };
+
+    MapIndex indexedMaps() const;
+    MapIndex buildMapIndex() const;
+    void invalidateMapIndex() const;
+    QVector<WorldMapEntry> resolveAllMaps() const;
+
+    mutable MapIndex mMapIndex;
+    mutable std::unique_ptr<FileSystemWatcher> mDirectoryWatcher;
 };
 
 } // namespace Tiled
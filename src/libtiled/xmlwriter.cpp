@@ -0,0 +1,387 @@
+/*
+ * xmlwriter.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "xmlwriter.h"
+
+#include <QIODevice>
+
+#include <charconv>
+#include <cmath>
+
+namespace Tiled {
+
+// The amount of buffered output after which it is written to the device
+static const int FlushThreshold = 64 * 1024;
+
+XmlWriter::XmlWriter(QIODevice *device)
+    : mDevice(device)
+    , mIndent(4, ' ')
+{
+    mBuffer.reserve(FlushThreshold + 1024);
+}
+
+XmlWriter::~XmlWriter()
+{
+    flush();
+}
+
+void XmlWriter::setAutoFormatting(bool autoFormatting)
+{
+    mAutoFormatting = autoFormatting;
+}
+
+void XmlWriter::setAutoFormattingIndent(int spaces)
+{
+    mIndent = QByteArray(qMax(0, spaces), ' ');
+}
+
+void XmlWriter::writeStartDocument()
+{
+    finishStartElement(false);
+    write(QLatin1String("<?xml version=\"1.0\" encoding=\"UTF-8\"?>"));
+}
+
+void XmlWriter::writeDTD(QLatin1String dtd)
+{
+    finishStartElement();
+    if (mAutoFormatting)
+        write('\n');
+    write(dtd);
+    if (mAutoFormatting)
+        write('\n');
+}
+
+void XmlWriter::writeEndDocument()
+{
+    while (!mTagStack.isEmpty())
+        writeEndElement();
+    write('\n');
+    flush();
+}
+
+void XmlWriter::writeStartElement(QLatin1String name)
+{
+    writeStartElement(name, false);
+}
+
+void XmlWriter::writeEmptyElement(QLatin1String name)
+{
+    writeStartElement(name, true);
+}
+
+void XmlWriter::writeStartElement(QLatin1String name, bool empty)
+{
+    if (!finishStartElement(false) && mAutoFormatting)
+        indent(mTagStack.size());
+
+    mTagStack.append(name);
+    write('<');
+    write(name);
+
+    mInStartElement = mLastWasStartElement = true;
+    mInEmptyElement = empty;
+}
+
+void XmlWriter::writeEndElement()
+{
+    if (mTagStack.isEmpty())
+        return;
+
+    // Close as empty element when nothing was written
+    if (mInStartElement && !mInEmptyElement) {
+        write(QLatin1String("/>"));
+        mLastWasStartElement = mInStartElement = false;
+        mTagStack.removeLast();
+        return;
+    }
+
+    if (!finishStartElement(false) && !mLastWasStartElement && mAutoFormatting)
+        indent(mTagStack.size() - 1);
+    if (mTagStack.isEmpty())
+        return;
+
+    mLastWasStartElement = false;
+    write(QLatin1String("</"));
+    write(mTagStack.takeLast());
+    write('>');
+
+    if (mBuffer.size() >= FlushThreshold && mRecordingStart < 0)
+        flush();
+}
+
+void XmlWriter::writeAttribute(QLatin1String name, const QString &value)
+{
+    writeAttributeStart(name);
+    writeEscaped(value, true);
+    write('"');
+}
+
+void XmlWriter::writeAttribute(QLatin1String name, QLatin1String value)
+{
+    writeAttributeStart(name);
+    writeEscaped(value, true);
+    write('"');
+}
+
+void XmlWriter::writeAttribute(QLatin1String name, int value)
+{
+    writeAttributeStart(name);
+    appendNumber(mBuffer, qint64(value));
+    write('"');
+}
+
+void XmlWriter::writeAttribute(QLatin1String name, unsigned value)
+{
+    writeAttributeStart(name);
+    appendNumber(mBuffer, qint64(value));
+    write('"');
+}
+
+/**
+ * Writes a floating point attribute formatted like QString::number(value).
+ */
+void XmlWriter::writeAttribute(QLatin1String name, double value)
+{
+    writeAttributeStart(name);
+    appendNumber(mBuffer, value);
+    write('"');
+}
+
+void XmlWriter::writeAttribute(const QString &name, const QString &value)
+{
+    Q_ASSERT(mInStartElement);
+    write(' ');
+    writeEscaped(name, false);
+    write(QLatin1String("=\""));
+    writeEscaped(value, true);
+    write('"');
+}
+
+void XmlWriter::writeCharacters(const QString &text)
+{
+    finishStartElement();
+    writeEscaped(text, false);
+}
+
+void XmlWriter::writeCharacters(QLatin1String text)
+{
+    finishStartElement();
+    writeEscaped(text, false);
+}
+
+/**
+ * Starts recording the output, while in the start tag of an element. The
+ * recording is finished by finishRecording() after ending that element, and
+ * can be replayed for another element with writeRecordedElementEnd().
+ */
+void XmlWriter::startRecording()
+{
+    Q_ASSERT(mInStartElement && mRecordingStart < 0);
+    mRecordingStart = mBuffer.size();
+}
+
+/**
+ * Returns the output written since startRecording().
+ */
+QByteArray XmlWriter::finishRecording()
+{
+    Q_ASSERT(mRecordingStart >= 0);
+    const QByteArray recorded = mBuffer.mid(mRecordingStart);
+    mRecordingStart = -1;
+    return recorded;
+}
+
+/**
+ * Writes the remaining attributes, contents and end tag of the current
+ * element, as recorded earlier for an element at the same depth.
+ */
+void XmlWriter::writeRecordedElementEnd(const QByteArray &recorded)
+{
+    Q_ASSERT(mInStartElement && !mInEmptyElement);
+
+    mBuffer.append(recorded);
+    mTagStack.removeLast();
+    mInStartElement = mLastWasStartElement = false;
+    mWroteSomething = false;
+
+    if (mBuffer.size() >= FlushThreshold && mRecordingStart < 0)
+        flush();
+}
+
+/**
+ * Writes the buffered output to the device.
+ */
+void XmlWriter::flush()
+{
+    if (mBuffer.isEmpty())
+        return;
+
+    if (mDevice->write(mBuffer) != mBuffer.size())
+        mHasError = true;
+
+    mBuffer.resize(0);
+}
+
+bool XmlWriter::finishStartElement(bool contents)
+{
+    const bool hadSomethingWritten = mWroteSomething;
+    mWroteSomething = contents;
+    if (!mInStartElement)
+        return hadSomethingWritten;
+
+    if (mInEmptyElement) {
+        write(QLatin1String("/>"));
+        mTagStack.removeLast();
+        mLastWasStartElement = false;
+    } else {
+        write('>');
+    }
+
+    mInStartElement = mInEmptyElement = false;
+    return hadSomethingWritten;
+}
+
+void XmlWriter::indent(int level)
+{
+    write('\n');
+    for (int i = 0; i < level; ++i)
+        mBuffer.append(mIndent);
+}
+
+void XmlWriter::writeAttributeStart(QLatin1String name)
+{
+    Q_ASSERT(mInStartElement);
+    write(' ');
+    write(name);
+    write(QLatin1String("=\""));
+}
+
+/**
+ * Appends \a value to \a out, formatted like QString::number(value).
+ */
+void XmlWriter::appendNumber(QByteArray &out, qint64 value)
+{
+    char buffer[24];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, static_cast<int>(result.ptr - buffer));
+}
+
+/**
+ * Appends \a value to \a out, formatted like QString::number(value).
+ */
+void XmlWriter::appendNumber(QByteArray &out, double value)
+{
+    // QString::number uses the 'g' format with a precision of 6, which
+    // writes integers below a million without exponent or decimals
+    if (std::abs(value) < 1000000.0 && value == std::trunc(value) &&
+            !(value == 0.0 && std::signbit(value))) {
+        appendNumber(out, static_cast<qint64>(value));
+        return;
+    }
+
+    out.append(QByteArray::number(value));
+}
+
+/**
+ * Returns whether \a c can't be represented in XML 1.0, not even escaped.
+ */
+static bool isInvalidCharacter(char16_t c)
+{
+    if (c < 0x20)
+        return c != '\t' && c != '\n' && c != '\r';
+    return c == 0xfffe || c == 0xffff;
+}
+
+static const char *replacementFor(char16_t c, bool escapeWhitespace)
+{
+    switch (c) {
+    case '<':   return "&lt;";
+    case '>':   return "&gt;";
+    case '&':   return "&amp;";
+    case '"':   return "&quot;";
+    case '\t':  return escapeWhitespace ? "&#9;" : nullptr;
+    case '\n':  return escapeWhitespace ? "&#10;" : nullptr;
+    case '\r':  return escapeWhitespace ? "&#13;" : nullptr;
+    }
+    return nullptr;
+}
+
+void XmlWriter::writeEscaped(const QString &text, bool escapeWhitespace)
+{
+    const QChar *begin = text.constData();
+    const QChar *end = begin + text.size();
+    const QChar *it = begin;
+
+    while (it != end) {
+        const char16_t c = it->unicode();
+
+        // Invalid characters are dropped, like QXmlStreamWriter does
+        if (isInvalidCharacter(c)) {
+            mHasError = true;
+            ++it;
+            continue;
+        }
+
+        if (c >= 0x80) {
+            // Convert runs of non-ASCII characters at once, which keeps
+            // surrogate pairs together
+            const QChar *runEnd = it + 1;
+            while (runEnd != end && runEnd->unicode() >= 0x80 && !isInvalidCharacter(runEnd->unicode()))
+                ++runEnd;
+            mBuffer.append(QStringView(it, runEnd - it).toUtf8());
+            it = runEnd;
+            continue;
+        }
+
+        if (const char *replacement = replacementFor(c, escapeWhitespace))
+            mBuffer.append(replacement);
+        else
+            mBuffer.append(static_cast<char>(c));
+        ++it;
+    }
+}
+
+void XmlWriter::writeEscaped(QLatin1String text, bool escapeWhitespace)
+{
+    for (const char c : text) {
+        const auto uc = static_cast<unsigned char>(c);
+
+        if (uc >= 0x80) {
+            mBuffer.append(static_cast<char>(0xc0 | (uc >> 6)));
+            mBuffer.append(static_cast<char>(0x80 | (uc & 0x3f)));
+        } else if (isInvalidCharacter(uc)) {
+            mHasError = true;
+        } else if (const char *replacement = replacementFor(uc, escapeWhitespace)) {
+            mBuffer.append(replacement);
+        } else {
+            mBuffer.append(c);
+        }
+    }
+}
+
+} // namespace Tiled
@@ -0,0 +1,129 @@
+/*
+ * xmlwriter.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+namespace Tiled {
+
+/**
+ * A buffered UTF-8 XML writer, producing the same output as QXmlStreamWriter
+ * for the subset of its functionality used when writing TMX files.
+ *
+ * Element and attribute names are written as-is, since they are constants
+ * that never need escaping. Numbers are formatted straight into the output
+ * buffer rather than going through QString.
+ *
+ * Characters that are not allowed in XML 1.0 are dropped, and flagged as an
+ * error through hasError().
+ */
+class TILEDSHARED_EXPORT XmlWriter
+{
+public:
+    explicit XmlWriter(QIODevice *device);
+    ~XmlWriter();
+
+    void setAutoFormatting(bool autoFormatting);
+    void setAutoFormattingIndent(int spaces);
+
+    void writeStartDocument();
+    void writeDTD(QLatin1String dtd);
+    void writeEndDocument();
+
+    void writeStartElement(QLatin1String name);
+    void writeEmptyElement(QLatin1String name);
+    void writeEndElement();
+
+    void writeAttribute(QLatin1String name, const QString &value);
+    void writeAttribute(QLatin1String name, QLatin1String value);
+    void writeAttribute(QLatin1String name, int value);
+    void writeAttribute(QLatin1String name, unsigned value);
+    void writeAttribute(QLatin1String name, double value);
+    void writeAttribute(const QString &name, const QString &value);
+
+    void writeCharacters(const QString &text);
+    void writeCharacters(QLatin1String text);
+
+    void startRecording();
+    QByteArray finishRecording();
+    void writeRecordedElementEnd(const QByteArray &recorded);
+
+    void flush();
+
+    bool hasError() const;
+
+    static void appendNumber(QByteArray &out, qint64 value);
+    static void appendNumber(QByteArray &out, double value);
+
+private:
+    void writeStartElement(QLatin1String name, bool empty);
+    bool finishStartElement(bool contents = true);
+    void indent(int level);
+
+    void write(QLatin1String text);
+    void write(char c);
+    void writeEscaped(const QString &text, bool escapeWhitespace);
+    void writeEscaped(QLatin1String text, bool escapeWhitespace);
+    void writeAttributeStart(QLatin1String name);
+
+    QIODevice *mDevice;
+    QByteArray mBuffer;
+    QByteArray mIndent;
+    QVector<QLatin1String> mTagStack;
+    bool mAutoFormatting = false;
+    bool mInStartElement = false;
+    bool mInEmptyElement = false;
+    bool mLastWasStartElement = false;
+    bool mWroteSomething = false;
+    bool mHasError = false;
+    int mRecordingStart = -1;
+};
+
+inline void XmlWriter::write(QLatin1String text)
+{
+    mBuffer.append(text.data(), text.size());
+}
+
+inline void XmlWriter::write(char c)
+{
+    mBuffer.append(c);
+}
+
+inline bool XmlWriter::hasError() const
+{
+    return mHasError;
+}
+
+} // namespace Tiled
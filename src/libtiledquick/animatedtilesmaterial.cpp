@@ -0,0 +1,141 @@
+/*
+ * animatedtilesmaterial.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled Quick.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "animatedtilesmaterial.h"
+
+#include <QElapsedTimer>
+#include <QSGMaterialShader>
+#include <QSGTexture>
+
+#include <cstring>
+
+using namespace TiledQuick;
+
+namespace {
+
+// Offsets in the uniform buffer, following the std140 layout of "buf"
+constexpr int MatrixOffset = 0;
+constexpr int OpacityOffset = 64;
+constexpr int TimeOffset = 68;
+constexpr int FramesOffset = 80;
+
+class AnimatedTilesShader : public QSGMaterialShader
+{
+public:
+    AnimatedTilesShader()
+    {
+        setShaderFileName(VertexStage, QStringLiteral(":/tiledquick/animatedtiles.vert.qsb"));
+        setShaderFileName(FragmentStage, QStringLiteral(":/tiledquick/animatedtiles.frag.qsb"));
+    }
+
+    bool updateUniformData(RenderState &state,
+                           QSGMaterial *newMaterial,
+                           QSGMaterial *oldMaterial) override
+    {
+        Q_UNUSED(oldMaterial)
+
+        QByteArray *buffer = state.uniformData();
+        Q_ASSERT(buffer->size() >= FramesOffset + AnimatedTilesMaterial::MaxFrames * 16);
+        char *data = buffer->data();
+
+        if (state.isMatrixDirty()) {
+            const QMatrix4x4 matrix = state.combinedMatrix();
+            std::memcpy(data + MatrixOffset, matrix.constData(), 64);
+        }
+
+        if (state.isOpacityDirty()) {
+            const float opacity = state.opacity();
+            std::memcpy(data + OpacityOffset, &opacity, 4);
+        }
+
+        // The time changes every frame, which is what animates the tiles
+        const float time = AnimatedTilesMaterial::animationTime();
+        std::memcpy(data + TimeOffset, &time, 4);
+
+        auto material = static_cast<AnimatedTilesMaterial*>(newMaterial);
+        if (const QVector<QVector4D> *frames = material->frames()) {
+            const int count = qMin<int>(frames->size(), AnimatedTilesMaterial::MaxFrames);
+            std::memcpy(data + FramesOffset, frames->constData(), count * sizeof(QVector4D));
+        }
+
+        return true;
+    }
+
+    void updateSampledImage(RenderState &state, int binding, QSGTexture **texture,
+                            QSGMaterial *newMaterial, QSGMaterial *oldMaterial) override
+    {
+        Q_UNUSED(oldMaterial)
+
+        if (binding != 1)
+            return;
+
+        auto material = static_cast<AnimatedTilesMaterial*>(newMaterial);
+        if (QSGTexture *t = material->texture()) {
+            t->commitTextureOperations(state.rhi(), state.resourceUpdateBatch());
+            *texture = t;
+        }
+    }
+};
+
+} // anonymous namespace
+
+AnimatedTilesMaterial::AnimatedTilesMaterial()
+{
+    setFlag(Blending);
+}
+
+QSGMaterialType *AnimatedTilesMaterial::type() const
+{
+    static QSGMaterialType type;
+    return &type;
+}
+
+QSGMaterialShader *AnimatedTilesMaterial::createShader(QSGRendererInterface::RenderMode renderMode) const
+{
+    Q_UNUSED(renderMode)
+    return new AnimatedTilesShader;
+}
+
+int AnimatedTilesMaterial::compare(const QSGMaterial *other) const
+{
+    auto o = static_cast<const AnimatedTilesMaterial*>(other);
+
+    if (mTexture != o->mTexture)
+        return mTexture < o->mTexture ? -1 : 1;
+    if (mFrames != o->mFrames)
+        return mFrames < o->mFrames ? -1 : 1;
+
+    return 0;
+}
+
+/**
+ * Returns the time in milliseconds used to select the animation frames.
+ *
+ * Wraps around every 2^24 milliseconds (about 4.6 hours), to stay within the
+ * range in which a float can represent every millisecond.
+ */
+float AnimatedTilesMaterial::animationTime()
+{
+    static QElapsedTimer timer;
+    if (!timer.isValid())
+        timer.start();
+
+    return static_cast<float>(timer.elapsed() % (1 << 24));
+}
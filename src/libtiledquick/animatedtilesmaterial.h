@@ -0,0 +1,89 @@
+/*
+ * animatedtilesmaterial.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled Quick.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QSGMaterial>
+#include <QVector4D>
+#include <QVector>
+
+class QSGTexture;
+
+namespace TiledQuick {
+
+/**
+ * A material that selects the frames of animated tiles in the vertex shader.
+ *
+ * Each vertex refers to an animation in a table of frames, which is passed
+ * to the shader as uniform data along with the current time. This way tile
+ * animations don't require the geometry to be updated.
+ *
+ * An animation at offset \c o in the table is stored as a header
+ * (frameCount, totalDuration, 0, 0) at \c o, followed by one entry per frame
+ * (x, y, endTime, 0) with the normalized texture coordinates of the frame
+ * and the time in milliseconds at which the frame ends.
+ */
+class AnimatedTilesMaterial : public QSGMaterial
+{
+public:
+    enum {
+        MaxFrames = 256     // size of the frame table in the shaders
+    };
+
+    AnimatedTilesMaterial();
+
+    QSGMaterialType *type() const override;
+    QSGMaterialShader *createShader(QSGRendererInterface::RenderMode renderMode) const override;
+    int compare(const QSGMaterial *other) const override;
+
+    QSGTexture *texture() const;
+    void setTexture(QSGTexture *texture);
+
+    const QVector<QVector4D> *frames() const;
+    void setFrames(const QVector<QVector4D> *frames);
+
+    static float animationTime();
+
+private:
+    QSGTexture *mTexture = nullptr;
+    const QVector<QVector4D> *mFrames = nullptr;
+};
+
+inline QSGTexture *AnimatedTilesMaterial::texture() const
+{
+    return mTexture;
+}
+
+inline void AnimatedTilesMaterial::setTexture(QSGTexture *texture)
+{
+    mTexture = texture;
+}
+
+inline const QVector<QVector4D> *AnimatedTilesMaterial::frames() const
+{
+    return mFrames;
+}
+
+inline void AnimatedTilesMaterial::setFrames(const QVector<QVector4D> *frames)
+{
+    mFrames = frames;
+}
+
+} // namespace TiledQuick
@@ -20,11 +20,16 @@
 
 #include "mapitem.h"
 
+#include "texturemanager.h"
 #include "tilelayeritem.h"
 
 #include "map.h"
 #include "maprenderer.h"
+#include "tile.h"
 #include "tilelayer.h"
+#include "tileset.h"
+
+#include <QQuickWindow>
 
 #include <cmath>
 
@@ -36,7 +41,10 @@ MapItem::MapItem(QQuickItem *parent)
 {
 }
 
-MapItem::~MapItem() = default;
+MapItem::~MapItem()
+{
+    releaseTextures();
+}
 
 void MapItem::setMap(MapRef map)
 {
@@ -139,6 +147,31 @@ void MapItem::componentComplete()
         refresh();
 }
 
+void MapItem::itemChange(ItemChange change, const ItemChangeData &value)
+{
+    QQuickItem::itemChange(change, value);
+
+    if (change == ItemSceneChange) {
+        releaseTextures();
+        mTextureManager = TextureManager::instance(value.window);
+        acquireTextures();
+        updateAnimationDriver(value.window);
+    } else if (change == ItemVisibleHasChanged) {
+        updateAnimationDriver(window());
+    }
+}
+
+/**
+ * Updates the display of the tiles in the given \a region of \a layer, in
+ * layer coordinates. Should be called after changing the cells of a layer.
+ */
+void MapItem::tilesChanged(Tiled::TileLayer *layer, const QRegion &region)
+{
+    for (TileLayerItem *layerItem : std::as_const(mTileLayerItems))
+        if (layerItem->tileLayer() == layer)
+            layerItem->tilesChanged(region);
+}
+
 void MapItem::refresh()
 {
     if (!isComponentComplete())
@@ -147,10 +180,27 @@ void MapItem::refresh()
     qDeleteAll(mTileLayerItems);
     mTileLayerItems.clear();
 
+    releaseTextures();
+
     mRenderer = nullptr;
+    mHasAnimatedTiles = false;
 
-    if (!mMap)
+    if (!mMap) {
+        updateAnimationDriver(window());
         return;
+    }
+
+    acquireTextures();
+
+    for (const Tiled::SharedTileset &tileset : mMap->tilesets()) {
+        for (const Tiled::Tile *tile : tileset->tiles()) {
+            if (tile->isAnimated()) {
+                mHasAnimatedTiles = true;
+                break;
+            }
+        }
+    }
+    updateAnimationDriver(window());
 
     mRenderer = Tiled::MapRenderer::create(mMap);
 
@@ -164,3 +214,44 @@ void MapItem::refresh()
     const QRect rect = mRenderer->mapBoundingRect();
     setImplicitSize(rect.width(), rect.height());
 }
+
+/**
+ * Keeps the textures of the map's tilesets alive while this item displays
+ * them.
+ */
+void MapItem::acquireTextures()
+{
+    if (!mTextureManager || !mMap || !isComponentComplete())
+        return;
+
+    for (const Tiled::SharedTileset &tileset : mMap->tilesets()) {
+        mTextureManager->acquire(tileset.data());
+        mAcquiredTilesets.append(tileset.data());
+    }
+}
+
+/**
+ * Keeps the window rendering while the map contains animated tiles. The
+ * animation frames are selected on the GPU based on the time, so the only
+ * thing needed to animate them is rendering another frame.
+ */
+void MapItem::updateAnimationDriver(QQuickWindow *window)
+{
+    disconnect(mFrameSwappedConnection);
+
+    if (!window || !mHasAnimatedTiles || !isVisible())
+        return;
+
+    mFrameSwappedConnection = connect(window, &QQuickWindow::frameSwapped,
+                                      window, &QQuickWindow::update);
+    window->update();
+}
+
+void MapItem::releaseTextures()
+{
+    if (mTextureManager)
+        for (Tiled::Tileset *tileset : std::as_const(mAcquiredTilesets))
+            mTextureManager->release(tileset);
+
+    mAcquiredTilesets.clear();
+}
@@ -23,16 +23,21 @@
 #include "mapref.h"
 #include "tiledquick_global.h"
 
+#include <QPointer>
 #include <QQuickItem>
+#include <QRegion>
 
 #include <memory>
 
 namespace Tiled {
 class MapRenderer;
+class TileLayer;
+class Tileset;
 } // namespace Tiled
 
 namespace TiledQuick {
 
+class TextureManager;
 class TileItem;
 class TileLayerItem;
 
@@ -72,18 +77,34 @@ public:
 
     void componentComplete() override;
 
+    void tilesChanged(Tiled::TileLayer *layer, const QRegion &region);
+
+    TextureManager *textureManager() const;
+
 signals:
     void mapChanged();
     void visibleAreaChanged();
 
+protected:
+    void itemChange(ItemChange change, const ItemChangeData &value) override;
+
 private:
     void refresh();
+    void acquireTextures();
+    void releaseTextures();
+    void updateAnimationDriver(QQuickWindow *window);
 
     Tiled::Map *mMap;
     QRectF mVisibleArea;
 
     std::unique_ptr<Tiled::MapRenderer> mRenderer;
     QList<TileLayerItem*> mTileLayerItems;
+
+    QPointer<TextureManager> mTextureManager;
+    QVector<Tiled::Tileset*> mAcquiredTilesets;
+
+    bool mHasAnimatedTiles = false;
+    QMetaObject::Connection mFrameSwappedConnection;
 };
 
 inline const QRectF &MapItem::visibleArea() const
@@ -91,6 +112,11 @@ inline const QRectF &MapItem::visibleArea() const
     return mVisibleArea;
 }
 
+inline TextureManager *MapItem::textureManager() const
+{
+    return mTextureManager;
+}
+
 inline MapRef MapItem::map() const
 {
     return mMap;
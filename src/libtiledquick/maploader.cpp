@@ -24,33 +24,139 @@
 #include "mapreader.h"
 #include "tiled.h"
 #include "tileset.h"
+#include "tilesetmanager.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QtConcurrent>
 
 using namespace TiledQuick;
 
+namespace {
+
+struct FileContents
+{
+    QByteArray data;
+    bool read = false;
+};
+
+} // anonymous namespace
+
 MapLoader::MapLoader(QObject *parent)
     : QObject(parent)
     , m_map(nullptr)
     , m_status(Null)
 {
+    connect(Tiled::TilesetManager::instance(), &Tiled::TilesetManager::tilesetImagesChanged,
+            this, &MapLoader::checkPendingMap);
 }
 
 MapLoader::~MapLoader()
 {
 }
 
+/**
+ * Starts loading the map from the given \a source.
+ *
+ * The file is read on a worker thread, after which the map is parsed on the
+ * main thread, since that involves loading tilesets and templates. The
+ * tileset images are decoded in parallel on the global thread pool. The
+ * status is Loading until the map and all its tileset images are available,
+ * during which the previously loaded map remains available.
+ */
 void MapLoader::setSource(const QUrl &source)
 {
     if (m_source == source)
         return;
 
     m_source = source;
+    m_pendingMap.reset();
+
+    emit sourceChanged(source);
+
+    if (m_status != Loading) {
+        m_status = Loading;
+        emit statusChanged(m_status);
+    }
+
+    // Results of any previous load are ignored from here on
+    const int loadId = ++m_loadId;
+    const QString fileName = Tiled::urlToLocalFileOrQrc(source);
+
+    auto watcher = new QFutureWatcher<FileContents>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, loadId, fileName] {
+        watcher->deleteLater();
+
+        if (loadId == m_loadId) {
+            FileContents contents = watcher->result();
+            readMap(fileName, std::move(contents.data), contents.read);
+        }
+    });
+
+    watcher->setFuture(QtConcurrent::run([fileName] {
+        FileContents contents;
+
+        QFile file(fileName);
+        if (file.open(QIODevice::ReadOnly)) {
+            contents.data = file.readAll();
+            contents.read = true;
+        }
+
+        return contents;
+    }));
+}
+
+void MapLoader::readMap(const QString &fileName, QByteArray data, bool dataRead)
+{
+    auto tilesetManager = Tiled::TilesetManager::instance();
+    const bool asyncImageLoading = tilesetManager->asyncImageLoading();
+    tilesetManager->setAsyncImageLoading(true);
 
     Tiled::MapReader mapReader;
+    mapReader.setParallelLayerDecoding(true);
+
+    std::unique_ptr<Tiled::Map> map;
+
+    if (dataRead) {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        map = mapReader.readMap(&buffer, QFileInfo(fileName).absolutePath());
+    } else {
+        // Lets the reader report why the file couldn't be read
+        map = mapReader.readMap(fileName);
+    }
 
-    std::unique_ptr<Tiled::Map> map(mapReader.readMap(Tiled::urlToLocalFileOrQrc(source)));
-    Status status = map ? Ready : Error;
-    QString error = map ? QString() : mapReader.errorString();
+    tilesetManager->setAsyncImageLoading(asyncImageLoading);
+
+    if (!map) {
+        setResult(nullptr, Error, mapReader.errorString());
+        return;
+    }
 
+    m_pendingMap = std::move(map);
+    checkPendingMap();
+}
+
+/**
+ * Hands over the pending map once none of its tileset images are still
+ * being loaded.
+ */
+void MapLoader::checkPendingMap()
+{
+    if (!m_pendingMap)
+        return;
+
+    for (const Tiled::SharedTileset &tileset : m_pendingMap->tilesets())
+        if (tileset->imageStatus() == Tiled::LoadingInProgress)
+            return;
+
+    setResult(std::move(m_pendingMap), Ready, QString());
+}
+
+void MapLoader::setResult(std::unique_ptr<Tiled::Map> map, Status status, const QString &error)
+{
     const bool mapDiff = m_map != map;
     const bool statusDiff = m_status != status;
     const bool errorDiff = m_error != error;
@@ -59,8 +165,6 @@ void MapLoader::setSource(const QUrl &source)
     m_status = status;
     m_error = error;
 
-    emit sourceChanged(source);
-
     if (mapDiff)
         emit mapChanged(m_map.get());
     if (statusDiff)
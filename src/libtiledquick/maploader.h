@@ -35,7 +35,7 @@ class TILEDQUICK_SHARED_EXPORT MapLoader : public QObject
     Q_OBJECT
 
     Q_PROPERTY(QUrl source READ source WRITE setSource NOTIFY sourceChanged)
-    Q_PROPERTY(TiledQuick::MapRef map READ map NOTIFY sourceChanged)
+    Q_PROPERTY(TiledQuick::MapRef map READ map NOTIFY mapChanged)
     Q_PROPERTY(Status status READ status NOTIFY statusChanged)
     Q_PROPERTY(QString error READ error NOTIFY errorChanged)
 
@@ -43,7 +43,8 @@ public:
     enum Status {
         Null,
         Ready,
-        Error
+        Error,
+        Loading
     };
     Q_ENUM(Status)
 
@@ -65,10 +66,16 @@ public slots:
     void setSource(const QUrl &source);
 
 private:
+    void readMap(const QString &fileName, QByteArray data, bool dataRead);
+    void checkPendingMap();
+    void setResult(std::unique_ptr<Tiled::Map> map, Status status, const QString &error);
+
     QUrl m_source;
     std::unique_ptr<Tiled::Map> m_map;
+    std::unique_ptr<Tiled::Map> m_pendingMap;
     Status m_status;
     QString m_error;
+    int m_loadId = 0;
 };
 
 
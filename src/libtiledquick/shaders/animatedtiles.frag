@@ -0,0 +1,19 @@
+#version 440
+
+layout(location = 0) in vec2 texCoord;
+
+layout(location = 0) out vec4 fragColor;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 qt_Matrix;
+    float qt_Opacity;
+    float time;
+    vec4 frames[256];
+};
+
+layout(binding = 1) uniform sampler2D qt_Texture;
+
+void main()
+{
+    fragColor = texture(qt_Texture, texCoord) * qt_Opacity;
+}
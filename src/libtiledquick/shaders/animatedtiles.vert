@@ -0,0 +1,45 @@
+#version 440
+
+layout(location = 0) in vec4 vertexCoord;
+layout(location = 1) in vec2 textureCoord;
+layout(location = 2) in float animation;
+
+layout(location = 0) out vec2 texCoord;
+
+// See AnimatedTilesMaterial for the layout of the frame table
+layout(std140, binding = 0) uniform buf {
+    mat4 qt_Matrix;
+    float qt_Opacity;
+    float time;
+    vec4 frames[256];
+};
+
+out gl_PerVertex { vec4 gl_Position; };
+
+void main()
+{
+    vec2 frameOffset = vec2(0.0);
+
+    if (animation >= 0.0) {
+        int offset = int(animation);
+        vec4 header = frames[offset];
+        int frameCount = int(header.x);
+        float t = mod(time, header.y);
+
+        frameOffset = frames[offset + frameCount].xy;
+
+        for (int i = 1; i < 256; ++i) {
+            if (i > frameCount)
+                break;
+
+            vec4 frame = frames[offset + i];
+            if (t < frame.z) {
+                frameOffset = frame.xy;
+                break;
+            }
+        }
+    }
+
+    texCoord = frameOffset + textureCoord;
+    gl_Position = qt_Matrix * vertexCoord;
+}
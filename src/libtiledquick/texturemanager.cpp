@@ -0,0 +1,283 @@
+/*
+ * texturemanager.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled Quick.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "texturemanager.h"
+
+#include "animatedtilesmaterial.h"
+#include "imagecache.h"
+#include "tile.h"
+#include "tiled.h"
+#include "tileset.h"
+
+#include <QMutexLocker>
+#include <QPainter>
+#include <QQuickWindow>
+#include <QSGTexture>
+#include <QVector>
+
+using namespace Tiled;
+using namespace TiledQuick;
+
+// Limits for the size of texture atlases of image collection tilesets
+static constexpr int MaxAtlasWidth = 4096;
+static constexpr int MaxAtlasHeight = 16384;
+
+TextureManager::TextureManager(QQuickWindow *window)
+    : QObject(window)
+    , mWindow(window)
+{
+    connect(window, &QQuickWindow::sceneGraphInvalidated,
+            this, &TextureManager::invalidate, Qt::DirectConnection);
+}
+
+TextureManager::~TextureManager()
+{
+    invalidate();
+}
+
+/**
+ * Returns the texture manager of the given \a window, creating it when
+ * necessary. Needs to be called from the GUI thread.
+ */
+TextureManager *TextureManager::instance(QQuickWindow *window)
+{
+    if (!window)
+        return nullptr;
+
+    auto manager = window->findChild<TextureManager*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!manager)
+        manager = new TextureManager(window);
+    return manager;
+}
+
+/**
+ * Adds a reference to the texture of \a tileset.
+ */
+void TextureManager::acquire(Tileset *tileset)
+{
+    QMutexLocker locker(&mMutex);
+    ++mEntries[tileset].refCount;
+}
+
+/**
+ * Removes a reference to the texture of \a tileset. When it was the last
+ * reference, the texture is freed.
+ */
+void TextureManager::release(Tileset *tileset)
+{
+    QMutexLocker locker(&mMutex);
+
+    const auto it = mEntries.find(tileset);
+    if (it == mEntries.end())
+        return;
+
+    if (--it->second.refCount > 0)
+        return;
+
+    // The texture lives on the render thread, where it will be deleted
+    if (QSGTexture *texture = it->second.texture.texture)
+        texture->deleteLater();
+
+    mEntries.erase(it);
+}
+
+/**
+ * Returns the texture of \a tileset, creating it if necessary. The texture
+ * may be null when the tileset image could not be loaded.
+ *
+ * Needs to be called while updating the scene graph. The returned pointer
+ * stays valid until the tileset is released.
+ */
+const TextureManager::TilesetTexture *TextureManager::texture(Tileset *tileset)
+{
+    QMutexLocker locker(&mMutex);
+
+    Entry &entry = mEntries[tileset];
+    if (!entry.created) {
+        entry.texture = createTexture(tileset);
+        entry.created = true;
+    }
+    return &entry.texture;
+}
+
+/**
+ * Returns the position of the tile with the given \a tileId in the texture,
+ * or (-1, -1) when it is not part of the texture.
+ */
+static QPoint tilePosition(const Tileset *tileset,
+                           const TextureManager::TilesetTexture &texture,
+                           int tileId)
+{
+    if (!texture.tilePositions.isEmpty())
+        return texture.tilePositions.value(tileId, QPoint(-1, -1));
+
+    const int tileSpacing = tileset->tileSpacing();
+    const int margin = tileset->margin();
+    const int tileHSpace = tileset->tileWidth() + tileSpacing;
+    const int tileVSpace = tileset->tileHeight() + tileSpacing;
+    const int availableWidth = texture.texture->textureSize().width() + tileSpacing - margin;
+    const int tilesPerRow = qMax(availableWidth / tileHSpace, 1);
+
+    return QPoint(tileId % tilesPerRow * tileHSpace + margin,
+                  tileId / tilesPerRow * tileVSpace + margin);
+}
+
+/**
+ * Creates the table of animation frames used to animate the tiles on the
+ * GPU. Animations that don't fit in the table are left out, which means
+ * those tiles will not animate.
+ */
+static void createAnimationTable(const Tileset *tileset,
+                                 TextureManager::TilesetTexture &texture)
+{
+    const QSize size = texture.texture->textureSize();
+    const QRectF subRect = texture.texture->normalizedTextureSubRect();
+    const float scaleX = subRect.width() / size.width();
+    const float scaleY = subRect.height() / size.height();
+
+    for (const Tile *tile : tileset->tiles()) {
+        if (!tile->isAnimated())
+            continue;
+
+        const QVector<Frame> &frames = tile->frames();
+        if (texture.animationFrames.size() + frames.size() + 1 > AnimatedTilesMaterial::MaxFrames)
+            break;
+
+        const int offset = texture.animationFrames.size();
+        QVector<QVector4D> entries { QVector4D() };
+        int time = 0;
+
+        for (const Frame &frame : frames) {
+            const QPoint position = tilePosition(tileset, texture, frame.tileId);
+            if (position.x() < 0 || frame.duration <= 0)
+                break;
+
+            time += frame.duration;
+            entries.append(QVector4D(subRect.x() + position.x() * scaleX,
+                                     subRect.y() + position.y() * scaleY,
+                                     time, 0));
+        }
+
+        if (entries.size() != frames.size() + 1)
+            continue;
+
+        entries[0] = QVector4D(frames.size(), time, 0, 0);
+        texture.animationFrames.append(entries);
+        texture.animationOffsets.insert(tile->id(), offset);
+    }
+}
+
+TextureManager::TilesetTexture TextureManager::createTexture(Tileset *tileset) const
+{
+    TilesetTexture result = createTilesetTexture(tileset);
+    if (result.texture)
+        createAnimationTable(tileset, result);
+    return result;
+}
+
+TextureManager::TilesetTexture TextureManager::createTilesetTexture(Tileset *tileset) const
+{
+    TilesetTexture result;
+
+    if (!tileset->isCollection()) {
+        QImage image;
+
+        // The tileset image has the transparent color applied already
+        if (!tileset->transparentColor().isValid())
+            image = ImageCache::loadImage(urlToLocalFileOrQrc(tileset->imageSource()));
+        if (image.isNull())
+            image = tileset->image().toImage();
+        if (!image.isNull())
+            result.texture = mWindow->createTextureFromImage(image);
+
+        return result;
+    }
+
+    if (!mPackImageCollections)
+        return result;
+
+    // Pack the tile images into rows, with a pixel of spacing to avoid
+    // bleeding between tiles when filtering
+    QVector<std::pair<int, QImage>> images;
+    QSize atlasSize;
+    int x = 0;
+    int y = 0;
+    int rowHeight = 0;
+
+    for (const Tile *tile : tileset->tiles()) {
+        QImage image = ImageCache::loadImage(urlToLocalFileOrQrc(tile->imageSource()));
+        if (image.isNull())
+            image = tile->image().toImage();
+        if (image.isNull())
+            continue;
+
+        if (tile->imageRect() != image.rect() && !tile->imageRect().isEmpty())
+            image = image.copy(tile->imageRect());
+
+        if (x > 0 && x + image.width() > MaxAtlasWidth) {
+            x = 0;
+            y += rowHeight + 1;
+            rowHeight = 0;
+        }
+
+        if (y + image.height() > MaxAtlasHeight) {
+            qWarning("Texture atlas for tileset \"%s\" is full, not all tiles will be displayed",
+                     qUtf8Printable(tileset->name()));
+            break;
+        }
+
+        result.tilePositions.insert(tile->id(), QPoint(x, y));
+        images.append(std::make_pair(tile->id(), image));
+
+        atlasSize = atlasSize.expandedTo(QSize(x + image.width(), y + image.height()));
+        x += image.width() + 1;
+        rowHeight = qMax(rowHeight, image.height());
+    }
+
+    if (images.isEmpty())
+        return result;
+
+    QImage atlas(atlasSize, QImage::Format_ARGB32_Premultiplied);
+    atlas.fill(Qt::transparent);
+
+    QPainter painter(&atlas);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for (const auto &[tileId, image] : std::as_const(images))
+        painter.drawImage(result.tilePositions.value(tileId), image);
+    painter.end();
+
+    result.texture = mWindow->createTextureFromImage(atlas);
+    return result;
+}
+
+/**
+ * Deletes all textures. Called when the scene graph is invalidated, on the
+ * render thread.
+ */
+void TextureManager::invalidate()
+{
+    QMutexLocker locker(&mMutex);
+
+    for (auto &[tileset, entry] : mEntries) {
+        delete entry.texture.texture;
+        entry.texture = TilesetTexture();
+        entry.created = false;
+    }
+}
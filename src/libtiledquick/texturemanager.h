@@ -0,0 +1,115 @@
+/*
+ * texturemanager.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled Quick.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "tiledquick_global.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QPoint>
+#include <QVector4D>
+#include <QVector>
+
+#include <unordered_map>
+
+class QQuickWindow;
+class QSGTexture;
+
+namespace Tiled {
+class Tileset;
+}
+
+namespace TiledQuick {
+
+/**
+ * Manages the textures of tilesets for a window.
+ *
+ * Textures are reference counted by tileset. Items acquire the tilesets they
+ * display on the GUI thread, while the textures themselves are created on
+ * first use while updating the scene graph. A texture is freed when its
+ * tileset is no longer referenced, or when the scene graph is invalidated.
+ * The latter happens on the render thread, so the entries are guarded by a
+ * mutex.
+ *
+ * Image collection tilesets can be packed into a single texture atlas, so
+ * that their tiles can be drawn together.
+ */
+class TILEDQUICK_SHARED_EXPORT TextureManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct TilesetTexture
+    {
+        QSGTexture *texture = nullptr;
+
+        // Position of each tile in the atlas, for packed image collections
+        QHash<int, QPoint> tilePositions;
+
+        // Frames of the animated tiles in the layout used by
+        // AnimatedTilesMaterial, and the offset of each tile's animation
+        QVector<QVector4D> animationFrames;
+        QHash<int, int> animationOffsets;
+    };
+
+    static TextureManager *instance(QQuickWindow *window);
+
+    void acquire(Tiled::Tileset *tileset);
+    void release(Tiled::Tileset *tileset);
+
+    const TilesetTexture *texture(Tiled::Tileset *tileset);
+
+    bool packImageCollections() const;
+    void setPackImageCollections(bool enabled);
+
+private:
+    explicit TextureManager(QQuickWindow *window);
+    ~TextureManager() override;
+
+    struct Entry
+    {
+        int refCount = 0;
+        bool created = false;
+        TilesetTexture texture;
+    };
+
+    TilesetTexture createTexture(Tiled::Tileset *tileset) const;
+    TilesetTexture createTilesetTexture(Tiled::Tileset *tileset) const;
+    void invalidate();
+
+    QQuickWindow *mWindow;
+    QMutex mMutex;
+    std::unordered_map<Tiled::Tileset*, Entry> mEntries;
+    bool mPackImageCollections = true;
+};
+
+inline bool TextureManager::packImageCollections() const
+{
+    return mPackImageCollections;
+}
+
+inline void TextureManager::setPackImageCollections(bool enabled)
+{
+    mPackImageCollections = enabled;
+}
+
+} // namespace TiledQuick
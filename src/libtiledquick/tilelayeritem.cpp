@@ -27,34 +27,21 @@
 #include "maprenderer.h"
 
 #include "mapitem.h"
+#include "texturemanager.h"
 #include "tilesnode.h"
 
 #include <QtMath>
 #include <QQuickWindow>
+#include <QSet>
+
+#include <algorithm>
+#include <vector>
 
 using namespace Tiled;
 using namespace TiledQuick;
 
 namespace {
 
-/**
- * Returns the texture of a given tileset, or 0 if the image has not been
- * loaded yet.
- */
-static inline QSGTexture *tilesetTexture(Tileset *tileset,
-                                         QQuickWindow *window)
-{
-    static QHash<Tileset *, QSGTexture *> cache;
-
-    QSGTexture *texture = cache.value(tileset);
-    if (!texture) {
-        const QString imagePath(Tiled::urlToLocalFileOrQrc(tileset->imageSource()));
-        texture = window->createTextureFromImage(QImage(imagePath));
-        cache.insert(tileset, texture);
-    }
-    return texture;
-}
-
 /**
  * This helper class exists mainly to avoid redoing calculations that only need
  * to be done once per tileset.
@@ -62,7 +49,7 @@ static inline QSGTexture *tilesetTexture(Tileset *tileset,
 struct TilesetHelper
 {
     TilesetHelper(const MapItem *mapItem)
-        : mWindow(mapItem->window())
+        : mTextureManager(mapItem->textureManager())
         , mTileset(nullptr)
         , mTexture(nullptr)
         , mMargin(0)
@@ -73,13 +60,14 @@ struct TilesetHelper
     }
 
     Tileset *tileset() const { return mTileset; }
-    QSGTexture *texture() const { return mTexture; }
+    QSGTexture *texture() const { return mTexture ? mTexture->texture : nullptr; }
+    const QVector<QVector4D> *animationFrames() const { return mTexture ? &mTexture->animationFrames : nullptr; }
 
     void setTileset(Tileset *tileset)
     {
         mTileset = tileset;
-        mTexture = tilesetTexture(tileset, mWindow);
-        if (!mTexture)
+        mTexture = mTextureManager ? mTextureManager->texture(tileset) : nullptr;
+        if (!texture())
             return;
 
         const int tileSpacing = tileset->tileSpacing();
@@ -87,25 +75,45 @@ struct TilesetHelper
         mTileHSpace = tileset->tileWidth() + tileSpacing;
         mTileVSpace = tileset->tileHeight() + tileSpacing;
 
-        const QSize tilesetSize = mTexture->textureSize();
+        const QSize tilesetSize = texture()->textureSize();
         const int availableWidth = tilesetSize.width() + tileSpacing - mMargin;
         mTilesPerRow = qMax(availableWidth / mTileHSpace, 1);
     }
 
-    void setTextureCoordinates(TileData &data, const Cell &cell) const
+    /**
+     * Sets the texture coordinates of the tile of \a cell. Returns false when
+     * the tile is not part of the texture.
+     *
+     * Also sets the animation of the tile, when it is animated.
+     */
+    bool setTextureCoordinates(TileData &data, const Cell &cell) const
     {
         const int tileId = cell.tileId();
+        data.animation = mTexture->animationOffsets.value(tileId, -1);
+
+        // Tiles of image collections are packed into an atlas
+        if (!mTexture->tilePositions.isEmpty()) {
+            const auto it = mTexture->tilePositions.constFind(tileId);
+            if (it == mTexture->tilePositions.constEnd())
+                return false;
+
+            data.tx = it->x();
+            data.ty = it->y();
+            return true;
+        }
+
         const int column = tileId % mTilesPerRow;
         const int row = tileId / mTilesPerRow;
 
         data.tx = column * mTileHSpace + mMargin;
         data.ty = row * mTileVSpace + mMargin;
+        return true;
     }
 
 private:
-    QQuickWindow *mWindow;
+    TextureManager *mTextureManager;
     Tileset *mTileset;
-    QSGTexture *mTexture;
+    const TextureManager::TilesetTexture *mTexture;
     int mMargin;
     int mTileHSpace;
     int mTileVSpace;
@@ -134,13 +142,52 @@ void TileLayerItem::syncWithTileLayer()
     const QRectF boundingRect = mRenderer->boundingRect(mLayer->rect());
     setPosition(boundingRect.topLeft());
     setSize(boundingRect.size());
+
+    // Chunks can be drawn in any order when the tiles stay within their cells
+    const Map *map = mRenderer->map();
+    const QMargins margins = mLayer->drawMargins();
+    mUseChunkNodes = map->orientation() == Map::Orthogonal &&
+            margins.left() <= 0 && margins.bottom() <= 0 &&
+            margins.top() <= map->tileHeight() &&
+            margins.right() <= map->tileWidth();
+
+    // The position of the tiles may have changed, so all chunk nodes need
+    // to be recreated. The nodes belong to the render thread, so this is
+    // done in updatePaintNode.
+    mResetChunkNodes = true;
+    mChangedChunks.clear();
+
+    update();
 }
 
+void TileLayerItem::tilesChanged(const QRegion &region)
+{
+    if (mUseChunkNodes && !mResetChunkNodes) {
+        for (const QRect &rect : region) {
+            const int startX = rect.left() >> CHUNK_BITS;
+            const int startY = rect.top() >> CHUNK_BITS;
+            const int endX = rect.right() >> CHUNK_BITS;
+            const int endY = rect.bottom() >> CHUNK_BITS;
+
+            for (int y = startY; y <= endY; ++y)
+                for (int x = startX; x <= endX; ++x)
+                    mChangedChunks.insert(QPoint(x, y));
+        }
+    }
+
+    update();
+}
 
 
 QSGNode *TileLayerItem::updatePaintNode(QSGNode *node,
                                         QQuickItem::UpdatePaintNodeData *)
 {
+    if (mUseChunkNodes)
+        return updateChunkNodes(node);
+
+    mChunkNodes.clear();
+    mFreeNodes.clear();
+
     delete node;
     node = new QSGNode;
     node->setFlag(QSGNode::OwnedByParent);
@@ -163,7 +210,7 @@ QSGNode *TileLayerItem::updatePaintNode(QSGNode *node,
 
         if (tileset != helper.tileset() || tileData.size() == TilesNode::MaxTileCount) {
             if (!tileData.isEmpty()) {
-                node->appendChildNode(new TilesNode(helper.texture(), tileData));
+                node->appendChildNode(new TilesNode(helper.texture(), tileData, helper.animationFrames()));
                 tileData.clear();
             }
 
@@ -189,18 +236,166 @@ QSGNode *TileLayerItem::updatePaintNode(QSGNode *node,
         data.height = static_cast<float>(size.height());
         data.flippedHorizontally = cell.flippedHorizontally();
         data.flippedVertically = cell.flippedVertically();
-        helper.setTextureCoordinates(data, cell);
-        tileData.append(data);
+        if (helper.setTextureCoordinates(data, cell))
+            tileData.append(data);
     };
 
     mRenderer->drawTileLayer(tileRenderFunction, mVisibleArea);
 
     if (!tileData.isEmpty())
-        node->appendChildNode(new TilesNode(helper.texture(), tileData));
+        node->appendChildNode(new TilesNode(helper.texture(), tileData, helper.animationFrames()));
+
+    return node;
+}
+
+/**
+ * Updates the nodes so that they cover the chunks in the visible area. Nodes
+ * of chunks that are still visible are kept, so that scrolling only needs
+ * to create the nodes of the chunks that came into view.
+ *
+ * Nodes of chunks that went out of view are cleared and kept as children
+ * of the root node, to be reused for other chunks.
+ */
+QSGNode *TileLayerItem::updateChunkNodes(QSGNode *node)
+{
+    // Keep a limited amount of cleared nodes around for reuse
+    static constexpr int MaxFreeNodes = 256;
+
+    if (!node || mResetChunkNodes || (mChunkNodes.isEmpty() && mFreeNodes.isEmpty())) {
+        // Start with a new node tree, since the existing one may have been
+        // created when not using chunk nodes
+        delete node;
+        node = new QSGNode;
+        node->setFlag(QSGNode::OwnedByParent);
+        mChunkNodes.clear();
+        mFreeNodes.clear();
+        mResetChunkNodes = false;
+    }
+
+    QSet<QPoint> visibleChunks;
+
+    const int tileWidth = mRenderer->map()->tileWidth();
+    const int tileHeight = mRenderer->map()->tileHeight();
+
+    if (!mVisibleArea.isEmpty() && tileWidth > 0 && tileHeight > 0) {
+        const int startX = qFloor(mVisibleArea.left() / tileWidth) >> CHUNK_BITS;
+        const int startY = qFloor(mVisibleArea.top() / tileHeight) >> CHUNK_BITS;
+        const int endX = qFloor(mVisibleArea.right() / tileWidth) >> CHUNK_BITS;
+        const int endY = qFloor(mVisibleArea.bottom() / tileHeight) >> CHUNK_BITS;
+
+        for (int y = startY; y <= endY; ++y)
+            for (int x = startX; x <= endX; ++x)
+                visibleChunks.insert(QPoint(x, y));
+    }
+
+    // Nodes of changed chunks are recreated like those that came into view
+    for (auto it = mChunkNodes.begin(); it != mChunkNodes.end(); ) {
+        if (!mChangedChunks.contains(it.key()) && visibleChunks.remove(it.key())) {
+            ++it;
+            continue;
+        }
+
+        for (TilesNode *tilesNode : std::as_const(it.value())) {
+            if (mFreeNodes.size() < MaxFreeNodes) {
+                tilesNode->clear();
+                mFreeNodes.append(tilesNode);
+            } else {
+                node->removeChildNode(tilesNode);
+                delete tilesNode;
+            }
+        }
+
+        it = mChunkNodes.erase(it);
+    }
+
+    mChangedChunks.clear();
+
+    // Only the chunks that came into view remain
+    for (const QPoint &chunkPos : std::as_const(visibleChunks)) {
+        QVector<TilesNode*> nodes;
+        createChunkNodes(node, chunkPos, nodes);
+        mChunkNodes.insert(chunkPos, nodes);
+    }
 
     return node;
 }
 
+void TileLayerItem::createChunkNodes(QSGNode *root, QPoint chunkPos,
+                                     QVector<TilesNode*> &nodes)
+{
+    const QPoint start(chunkPos.x() * CHUNK_SIZE, chunkPos.y() * CHUNK_SIZE);
+
+    const Chunk *chunk = mLayer->findChunk(start.x(), start.y());
+    if (!chunk || chunk->isEmpty())
+        return;
+
+    struct TilesetTiles
+    {
+        TilesetHelper helper;
+        QVector<TileData> tileData;
+    };
+
+    // Tiles can't overlap, so they can be grouped by tileset
+    std::vector<TilesetTiles> groups;
+    const MapItem *mapItem = static_cast<MapItem*>(parentItem());
+
+    for (int y = 0; y < CHUNK_SIZE; ++y) {
+        for (int x = 0; x < CHUNK_SIZE; ++x) {
+            const Cell cell = chunk->cellAt(x, y);
+            Tileset *tileset = cell.tileset();
+            if (!tileset)
+                continue;
+
+            auto group = std::find_if(groups.begin(), groups.end(),
+                                      [tileset] (const TilesetTiles &group) {
+                return group.helper.tileset() == tileset;
+            });
+            if (group == groups.end()) {
+                groups.push_back(TilesetTiles { TilesetHelper(mapItem), {} });
+                group = groups.end() - 1;
+                group->helper.setTileset(tileset);
+            }
+
+            if (!group->helper.texture())
+                continue;
+
+            const QPoint tilePos = start + QPoint(x, y);
+            const QPointF screenPos = mRenderer->tileToScreenCoords(tilePos.x(), tilePos.y() + 1);
+
+            const auto offset = tileset->tileOffset();
+            const auto tile = tileset->findTile(cell.tileId());
+            const QSize size = (tile && !tile->image().isNull()) ? tile->size() : mRenderer->map()->tileSize();
+
+            TileData data;
+            data.x = static_cast<float>(screenPos.x()) + offset.x();
+            data.y = static_cast<float>(screenPos.y() - size.height()) + offset.y();
+            data.width = static_cast<float>(size.width());
+            data.height = static_cast<float>(size.height());
+            data.flippedHorizontally = cell.flippedHorizontally();
+            data.flippedVertically = cell.flippedVertically();
+            if (group->helper.setTextureCoordinates(data, cell))
+                group->tileData.append(data);
+        }
+    }
+
+    for (const TilesetTiles &group : groups) {
+        if (group.tileData.isEmpty())
+            continue;
+
+        TilesNode *tilesNode;
+        if (!mFreeNodes.isEmpty()) {
+            tilesNode = mFreeNodes.takeLast();
+            tilesNode->setTileData(group.helper.texture(), group.tileData,
+                                   group.helper.animationFrames());
+        } else {
+            tilesNode = new TilesNode(group.helper.texture(), group.tileData,
+                                      group.helper.animationFrames());
+            root->appendChildNode(tilesNode);
+        }
+        nodes.append(tilesNode);
+    }
+}
+
 void TileLayerItem::updateVisibleTiles()
 {
     const MapItem *mapItem = static_cast<MapItem*>(parentItem());
@@ -279,9 +474,10 @@ QSGNode *TileItem::updatePaintNode(QSGNode *node, QQuickItem::UpdatePaintNodeDat
         data[0].y = (mPosition.y() + 1) * tileHeight - tileset->tileHeight() + offset.y();
         data[0].width = size.width();
         data[0].height = size.height();
-        helper.setTextureCoordinates(data[0], mCell);
+        if (!helper.setTextureCoordinates(data[0], mCell))
+            return nullptr;
 
-        node = new TilesNode(helper.texture(), data);
+        node = new TilesNode(helper.texture(), data, helper.animationFrames());
     }
 
     return node;
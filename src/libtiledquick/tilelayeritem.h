@@ -20,7 +20,11 @@
 
 #pragma once
 
+#include <QHash>
 #include <QQuickItem>
+#include <QRegion>
+#include <QSet>
+#include <QVector>
 
 #include "tilelayer.h"
 #include "tiledquick_global.h"
@@ -32,6 +36,7 @@ class MapRenderer;
 namespace TiledQuick {
 
 class MapItem;
+class TilesNode;
 
 /**
  * A graphical item displaying a tile layer in a Qt Quick scene.
@@ -60,6 +65,14 @@ public:
      */
     void syncWithTileLayer();
 
+    Tiled::TileLayer *tileLayer() const { return mLayer; }
+
+    /**
+     * Updates the tiles in the given \a region, in layer coordinates. Should
+     * be called when the cells of the tile layer have changed.
+     */
+    void tilesChanged(const QRegion &region);
+
     QSGNode *updatePaintNode(QSGNode *node, UpdatePaintNodeData *) override;
 
 public slots:
@@ -68,9 +81,20 @@ public slots:
 private:
     void layerVisibilityChanged();
 
+    QSGNode *updateChunkNodes(QSGNode *node);
+    void createChunkNodes(QSGNode *root, QPoint chunkPos,
+                          QVector<TilesNode*> &nodes);
+
     Tiled::TileLayer *mLayer;
     Tiled::MapRenderer *mRenderer;
     QRectF mVisibleArea;
+
+    // Per-chunk nodes, only used when tiles can't overlap between chunks
+    bool mUseChunkNodes = false;
+    bool mResetChunkNodes = false;
+    QHash<QPoint, QVector<TilesNode*>> mChunkNodes;
+    QVector<TilesNode*> mFreeNodes;
+    QSet<QPoint> mChangedChunks;
 };
 
 /**
@@ -22,10 +22,40 @@
 
 #include <QSGTexture>
 
+#include <algorithm>
+
 namespace TiledQuick {
 
-TilesNode::TilesNode(QSGTexture *texture, const QVector<TileData> &tileData)
+namespace {
+
+struct AnimatedVertex
+{
+    float x;
+    float y;
+    float tx;
+    float ty;
+    float animation;
+};
+
+const QSGGeometry::AttributeSet &animatedVertexAttributes()
+{
+    static const QSGGeometry::Attribute attributes[] = {
+        QSGGeometry::Attribute::createWithAttributeType(0, 2, QSGGeometry::FloatType, QSGGeometry::PositionAttribute),
+        QSGGeometry::Attribute::createWithAttributeType(1, 2, QSGGeometry::FloatType, QSGGeometry::TexCoordAttribute),
+        QSGGeometry::Attribute::createWithAttributeType(2, 1, QSGGeometry::FloatType, QSGGeometry::UnknownAttribute),
+    };
+    static const QSGGeometry::AttributeSet attributeSet = {
+        3, sizeof(AnimatedVertex), attributes
+    };
+    return attributeSet;
+}
+
+} // anonymous namespace
+
+TilesNode::TilesNode(QSGTexture *texture, const QVector<TileData> &tileData,
+                     const QVector<QVector4D> *animationFrames)
     : mGeometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 0)
+    , mAnimatedGeometry(animatedVertexAttributes(), 0)
 {
     setFlag(QSGNode::OwnedByParent);
 
@@ -33,19 +63,84 @@ TilesNode::TilesNode(QSGTexture *texture, const QVector<TileData> &tileData)
     mMaterial.setMipmapFiltering(QSGTexture::Linear);
     mOpaqueMaterial.setTexture(texture);
     mOpaqueMaterial.setMipmapFiltering(QSGTexture::Linear);
+    mAnimatedMaterial.setTexture(texture);
 
     mGeometry.setDrawingMode(QSGGeometry::DrawTriangles);
     mGeometry.setVertexDataPattern(QSGGeometry::StaticPattern);
-
-    processTileData(tileData);
+    mAnimatedGeometry.setDrawingMode(QSGGeometry::DrawTriangles);
+    mAnimatedGeometry.setVertexDataPattern(QSGGeometry::StaticPattern);
 
     setGeometry(&mGeometry);
     setMaterial(&mMaterial);
     setOpaqueMaterial(&mOpaqueMaterial);
+
+    processTileData(tileData, animationFrames);
 }
 
-void TilesNode::processTileData(const QVector<TileData> &tileData)
+/**
+ * Replaces the tiles drawn by this node, allowing the node to be reused.
+ */
+void TilesNode::setTileData(QSGTexture *texture, const QVector<TileData> &tileData,
+                            const QVector<QVector4D> *animationFrames)
+{
+    if (mMaterial.texture() != texture) {
+        mMaterial.setTexture(texture);
+        mOpaqueMaterial.setTexture(texture);
+        mAnimatedMaterial.setTexture(texture);
+        markDirty(DirtyMaterial);
+    }
+
+    processTileData(tileData, animationFrames);
+}
+
+/**
+ * Removes all tiles, so that this node draws nothing.
+ */
+void TilesNode::clear()
 {
+    mGeometry.allocate(0);
+    mAnimatedGeometry.allocate(0);
+    markDirty(DirtyGeometry);
+}
+
+/**
+ * Switches between the static texture material and the material that
+ * animates the tiles on the GPU, which needs a different vertex layout.
+ */
+void TilesNode::setAnimated(bool animated)
+{
+    if (mAnimated == animated)
+        return;
+
+    mAnimated = animated;
+
+    if (animated) {
+        mGeometry.allocate(0);
+        setGeometry(&mAnimatedGeometry);
+        setMaterial(&mAnimatedMaterial);
+        setOpaqueMaterial(nullptr);
+    } else {
+        mAnimatedGeometry.allocate(0);
+        setGeometry(&mGeometry);
+        setMaterial(&mMaterial);
+        setOpaqueMaterial(&mOpaqueMaterial);
+    }
+}
+
+void TilesNode::processTileData(const QVector<TileData> &tileData,
+                                const QVector<QVector4D> *animationFrames)
+{
+    const bool animated = animationFrames && !animationFrames->isEmpty() &&
+            std::any_of(tileData.begin(), tileData.end(),
+                        [] (const TileData &data) { return data.animation >= 0; });
+
+    setAnimated(animated);
+
+    if (animated && mAnimatedMaterial.frames() != animationFrames) {
+        mAnimatedMaterial.setFrames(animationFrames);
+        markDirty(DirtyMaterial);
+    }
+
     const QSize s = mMaterial.texture()->textureSize();
     const QRectF r = mMaterial.texture()->normalizedTextureSubRect();
 
@@ -61,15 +156,32 @@ void TilesNode::processTileData(const QVector<TileData> &tileData)
     // With indices it would take:  4 * 16 + 4 * 2 = 72 bytes
 
     // Two triangles to draw each tile
-    mGeometry.allocate(tileData.size() * 6);
-    QSGGeometry::TexturedPoint2D *v = mGeometry.vertexDataAsTexturedPoint2D();
+    QSGGeometry::TexturedPoint2D vertices[6];
+    QSGGeometry::TexturedPoint2D *v = vertices;
+    QSGGeometry::TexturedPoint2D *staticVertices = nullptr;
+    AnimatedVertex *animatedVertices = nullptr;
+
+    if (animated) {
+        mAnimatedGeometry.allocate(tileData.size() * 6);
+        animatedVertices = static_cast<AnimatedVertex*>(mAnimatedGeometry.vertexData());
+    } else {
+        mGeometry.allocate(tileData.size() * 6);
+        staticVertices = mGeometry.vertexDataAsTexturedPoint2D();
+    }
 
     for (const TileData &data : tileData) {
+        // For animated tiles, the texture coordinates are relative to the
+        // current frame, which is selected by the shader
+        const bool animatedTile = animated && data.animation >= 0;
+
         // Taking into account the normalized texture subrectancle
         const float s_width = data.width * s_x;
         const float s_height = data.height * s_y;
-        const float s_tx = r_x + data.tx * s_x;
-        const float s_ty = r_y + data.ty * s_y;
+        const float s_tx = animatedTile ? 0.0f : r_x + data.tx * s_x;
+        const float s_ty = animatedTile ? 0.0f : r_y + data.ty * s_y;
+
+        if (staticVertices)
+            v = staticVertices;
 
         // TopLeft                      // TopRight
         v[0].x = data.x;                v[2].x = data.x + data.width;
@@ -107,7 +219,17 @@ void TilesNode::processTileData(const QVector<TileData> &tileData)
             std::swap(v[2].ty, v[3].ty);
         }
 
-        v += 6;
+        if (staticVertices) {
+            staticVertices += 6;
+        } else {
+            for (int i = 0; i < 6; ++i) {
+                animatedVertices[i] = AnimatedVertex {
+                    v[i].x, v[i].y, v[i].tx, v[i].ty,
+                    static_cast<float>(animatedTile ? data.animation : -1)
+                };
+            }
+            animatedVertices += 6;
+        }
     }
 
     markDirty(DirtyGeometry);
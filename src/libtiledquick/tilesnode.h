@@ -30,6 +30,7 @@
 
 #include <QSGTextureMaterial>
 
+#include "animatedtilesmaterial.h"
 #include "tiledquick_global.h"
 
 namespace TiledQuick {
@@ -43,6 +44,7 @@ struct TileData {
     float ty;
     bool flippedHorizontally;
     bool flippedVertically;
+    int animation = -1;     // offset in the animation frames, if animated
 };
 
 class TILEDQUICK_SHARED_EXPORT TilesNode : public QSGGeometryNode
@@ -52,16 +54,26 @@ public:
         MaxTileCount = 65536 / 6
     };
 
-    TilesNode(QSGTexture *texture, const QVector<TileData> &tileData);
+    TilesNode(QSGTexture *texture, const QVector<TileData> &tileData,
+              const QVector<QVector4D> *animationFrames = nullptr);
 
     QSGTexture *texture() const;
 
+    void setTileData(QSGTexture *texture, const QVector<TileData> &tileData,
+                     const QVector<QVector4D> *animationFrames = nullptr);
+    void clear();
+
 private:
-    void processTileData(const QVector<TileData> &tileData);
+    void processTileData(const QVector<TileData> &tileData,
+                         const QVector<QVector4D> *animationFrames);
+    void setAnimated(bool animated);
 
     QSGGeometry mGeometry;
+    QSGGeometry mAnimatedGeometry;
     QSGTextureMaterial mMaterial;
     QSGOpaqueTextureMaterial mOpaqueMaterial;
+    AnimatedTilesMaterial mAnimatedMaterial;
+    bool mAnimated = false;
 };
 
 inline QSGTexture *TilesNode::texture() const
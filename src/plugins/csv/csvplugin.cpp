@@ -40,6 +40,66 @@ const unsigned FlippedVerticallyFlag     = 0x40000000;
 const unsigned FlippedAntiDiagonallyFlag = 0x20000000;
 const unsigned RotatedHexagonal120Flag   = 0x10000000;
 
+/**
+ * Returns whether the tile layers should be written as one file per
+ * non-empty chunk, rather than one file per layer.
+ */
+static bool exportChunks(const Map *map)
+{
+    return map->resolvedProperty(QStringLiteral("exportChunks")).toBool();
+}
+
+/**
+ * Returns the file name used for the chunk of a layer at the given \a offset
+ * (in tiles).
+ */
+static QString chunkFileName(const QString &layerFileName, QPoint offset)
+{
+    const QFileInfo fileInfo(layerFileName);
+    const QString chunkName = QStringLiteral("%1_%2_%3.%4").arg(fileInfo.completeBaseName(),
+                                                                QString::number(offset.x()),
+                                                                QString::number(offset.y()),
+                                                                fileInfo.suffix());
+    return fileInfo.dir().filePath(chunkName);
+}
+
+static void writeCells(QIODevice *device, const TileLayer *tileLayer, const QRect &bounds)
+{
+    // Write out tiles either by ID or their name, if given. -1 is "empty"
+    for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+        for (int x = bounds.left(); x <= bounds.right(); ++x) {
+            if (x > bounds.left())
+                device->write(",", 1);
+
+            const Cell &cell = tileLayer->cellAt(x, y);
+            const Tile *tile = cell.tile();
+            if (tile && tile->hasProperty(QLatin1String("name"))) {
+                device->write(tile->property(QLatin1String("name")).toString().toUtf8());
+            } else {
+                int id = -1;
+
+                if (tile) {
+                    id = tile->id();
+
+                    if (cell.flippedHorizontally())
+                        id |= FlippedHorizontallyFlag;
+                    if (cell.flippedVertically())
+                        id |= FlippedVerticallyFlag;
+                    if (cell.flippedAntiDiagonally())
+                        id |= FlippedAntiDiagonallyFlag;
+                    if (cell.rotatedHexagonal120())
+                        id |= RotatedHexagonal120Flag;
+                }
+
+                device->write(QByteArray::number(id));
+            }
+        }
+
+        device->write("\n", 1);
+    }
+}
+
+
 CsvPlugin::CsvPlugin()
 {
 }
@@ -49,68 +109,30 @@ bool CsvPlugin::write(const Map *map, const QString &fileName, Options options)
     Q_UNUSED(options)
 
     // Get file paths for each layer
-    const QStringList layerPaths = outputFiles(map, fileName);
+    const QStringList layerPaths = layerFiles(map, fileName);
+    const bool chunked = exportChunks(map);
 
     // Traverse all tile layers
     int currentLayer = 0;
     for (const Layer *layer : map->tileLayers()) {
         const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
-
-        SaveFile file(layerPaths.at(currentLayer));
-
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            mError = QCoreApplication::translate("File Errors", "Could not open file for writing.");
-            mError += QLatin1String("\n");
-            mError += layerPaths.at(currentLayer);
-            return false;
-        }
-
-        auto device = file.device();
-
-        QRect bounds = map->infinite() ? tileLayer->region().boundingRect() : tileLayer->rect();
-        bounds.translate(-layer->position());
-
-        // Write out tiles either by ID or their name, if given. -1 is "empty"
-        for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
-            for (int x = bounds.left(); x <= bounds.right(); ++x) {
-                if (x > bounds.left())
-                    device->write(",", 1);
-
-                const Cell &cell = tileLayer->cellAt(x, y);
-                const Tile *tile = cell.tile();
-                if (tile && tile->hasProperty(QLatin1String("name"))) {
-                    device->write(tile->property(QLatin1String("name")).toString().toUtf8());
-                } else {
-                    int id = -1;
-
-                    if (tile) {
-                        id = tile->id();
-
-                        if (cell.flippedHorizontally())
-                            id |= FlippedHorizontallyFlag;
-                        if (cell.flippedVertically())
-                            id |= FlippedVerticallyFlag;
-                        if (cell.flippedAntiDiagonally())
-                            id |= FlippedAntiDiagonallyFlag;
-                        if (cell.rotatedHexagonal120())
-                            id |= RotatedHexagonal120Flag;
-                    }
-
-                    device->write(QByteArray::number(id));
-                }
+        const QString &layerPath = layerPaths.at(currentLayer);
+
+        if (chunked) {
+            // Write each non-empty chunk to its own file, named after its
+            // position in the map
+            const auto chunks = tileLayer->sortedChunksToWrite(map->chunkSize());
+            for (const QRect &rect : chunks) {
+                const QPoint offset = rect.topLeft() + layer->position();
+                if (!writeFile(chunkFileName(layerPath, offset), tileLayer, rect))
+                    return false;
             }
+        } else {
+            QRect bounds = map->infinite() ? tileLayer->usedBounds() : tileLayer->rect();
+            bounds.translate(-layer->position());
 
-            device->write("\n", 1);
-        }
-
-        if (file.error() != QFileDevice::NoError) {
-            mError = file.errorString();
-            return false;
-        }
-
-        if (!file.commit()) {
-            mError = file.errorString();
-            return false;
+            if (!writeFile(layerPath, tileLayer, bounds))
+                return false;
         }
 
         ++currentLayer;
@@ -125,6 +147,28 @@ QString CsvPlugin::errorString() const
 }
 
 QStringList CsvPlugin::outputFiles(const Tiled::Map *map, const QString &fileName) const
+{
+    const QStringList layerPaths = layerFiles(map, fileName);
+    if (!exportChunks(map))
+        return layerPaths;
+
+    QStringList result;
+
+    int currentLayer = 0;
+    for (const Layer *layer : map->tileLayers()) {
+        const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
+        const auto chunks = tileLayer->sortedChunksToWrite(map->chunkSize());
+
+        for (const QRect &rect : chunks)
+            result.append(chunkFileName(layerPaths.at(currentLayer), rect.topLeft() + layer->position()));
+
+        ++currentLayer;
+    }
+
+    return result;
+}
+
+QStringList CsvPlugin::layerFiles(const Tiled::Map *map, const QString &fileName) const
 {
     const QRegularExpression reservedChars(QStringLiteral("[<>:\"/\\|?*]"));
 
@@ -161,6 +205,34 @@ QStringList CsvPlugin::outputFiles(const Tiled::Map *map, const QString &fileNam
     return result;
 }
 
+bool CsvPlugin::writeFile(const QString &fileName,
+                          const TileLayer *tileLayer,
+                          const QRect &bounds)
+{
+    SaveFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        mError = QCoreApplication::translate("File Errors", "Could not open file for writing.");
+        mError += QLatin1String("\n");
+        mError += fileName;
+        return false;
+    }
+
+    writeCells(file.device(), tileLayer, bounds);
+
+    if (file.error() != QFileDevice::NoError) {
+        mError = file.errorString();
+        return false;
+    }
+
+    if (!file.commit()) {
+        mError = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
 QString CsvPlugin::nameFilter() const
 {
     return tr("CSV files (*.csv)");
@@ -44,6 +44,11 @@ protected:
     QString nameFilter() const override;
 
 private:
+    QStringList layerFiles(const Tiled::Map *map, const QString &fileName) const;
+    bool writeFile(const QString &fileName,
+                   const Tiled::TileLayer *tileLayer,
+                   const QRect &bounds);
+
     QString mError;
 };
 
@@ -29,24 +29,15 @@
 
 #include <QCoreApplication>
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
-#include <QTextStream>
+#include <QtConcurrent>
 
 #include <cmath>
+#include <vector>
 
 namespace DefoldCollection {
 
-static const char cellTemplate[] =
-R"(  cell {
-    x: {{x}}
-    y: {{y}}
-    tile: {{tile}}
-    h_flip: {{h_flip}}
-    v_flip: {{v_flip}}
-    rotate90: {{rotate90}}
-  }
-)";
-
 static const char layerTemplate[] =
 R"(layers {
   id: "{{id}}"
@@ -218,19 +209,135 @@ static float zIndexForLayer(const Tiled::Map &map, const Tiled::Layer &inLayer,
     return 0;
 }
 
-static void setCellProperties(QVariantHash &cellHash, const Tiled::Cell &cell)
+static void appendCell(QString &cells, int x, int y, const Tiled::Cell &cell)
 {
-    cellHash["tile"] = cell.tileId();
+    int hFlip = cell.flippedHorizontally() ? 1 : 0;
+    int vFlip = cell.flippedVertically() ? 1 : 0;
+    int rotate90 = 0;
 
     if (cell.flippedAntiDiagonally()) {
-        cellHash["h_flip"] = cell.flippedVertically() ? 1 : 0;
-        cellHash["v_flip"] = cell.flippedHorizontally() ? 0 : 1;
-        cellHash["rotate90"] = 1;
-    } else {
-        cellHash["h_flip"] = cell.flippedHorizontally() ? 1 : 0;
-        cellHash["v_flip"] = cell.flippedVertically() ? 1 : 0;
-        cellHash["rotate90"] = 0;
+        hFlip = cell.flippedVertically() ? 1 : 0;
+        vFlip = cell.flippedHorizontally() ? 0 : 1;
+        rotate90 = 1;
+    }
+
+    // Formatted directly, since using replaceTags for each cell is slow
+    cells.append(QLatin1String("  cell {\n    x: "));
+    cells.append(QString::number(x));
+    cells.append(QLatin1String("\n    y: "));
+    cells.append(QString::number(y));
+    cells.append(QLatin1String("\n    tile: "));
+    cells.append(QString::number(cell.tileId()));
+    cells.append(QLatin1String("\n    h_flip: "));
+    cells.append(QString::number(hFlip));
+    cells.append(QLatin1String("\n    v_flip: "));
+    cells.append(QString::number(vFlip));
+    cells.append(QLatin1String("\n    rotate90: "));
+    cells.append(QString::number(rotate90));
+    cells.append(QLatin1String("\n  }\n"));
+}
+
+/*
+ * Writes the given \a contents to \a fileName, unless the file already has
+ * exactly these contents. This avoids needlessly touching files when
+ * exporting many maps that share most of their output.
+ */
+static bool writeFile(const QString &fileName, const QByteArray &contents, QString &error)
+{
+    QFile existingFile(fileName);
+    if (existingFile.open(QIODevice::ReadOnly | QIODevice::Text) && existingFile.readAll() == contents)
+        return true;
+    existingFile.close();
+
+    Tiled::SaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        error = QCoreApplication::translate("File Errors", "Could not open file for writing.");
+        return false;
+    }
+
+    file.device()->write(contents);
+
+    if (file.error() != QFileDevice::NoError) {
+        error = file.errorString();
+        return false;
+    }
+
+    if (!file.commit()) {
+        error = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+namespace {
+
+struct TilemapLayer
+{
+    const Tiled::TileLayer *tileLayer;
+    float z;
+    bool visible;
+};
+
+/*
+ * A .tilemap file, containing the cells of the given layers that use the
+ * given tileset.
+ */
+struct TilemapJob
+{
+    const Tiled::Tileset *tileset;
+    QString filePath;
+    QVector<TilemapLayer> layers;
+
+    bool hasCells = false;
+    QString error;
+};
+
+} // anonymous namespace
+
+static bool writeTilemap(TilemapJob &job)
+{
+    QString layers;
+
+    for (const TilemapLayer &layer : std::as_const(job.layers)) {
+        const Tiled::TileLayer *tileLayer = layer.tileLayer;
+        QString cells;
+
+        for (int x = 0; x < tileLayer->width(); ++x) {
+            for (int y = 0; y < tileLayer->height(); ++y) {
+                const Tiled::Cell &cell = tileLayer->cellAt(x, y);
+                if (cell.isEmpty() || cell.tileset() != job.tileset) // skip cell if it doesn't belong to current tileset
+                    continue;
+
+                appendCell(cells, x, tileLayer->height() - y - 1, cell);
+            }
+        }
+
+        // only add this layer to the .tilemap if it has any cells
+        if (cells.isEmpty())
+            continue;
+
+        QVariantHash layerHash;
+        layerHash["id"] = tileLayer->name();
+        layerHash["z"] = layer.z;
+        layerHash["is_visible"] = layer.visible ? 1 : 0;
+        layerHash["cells"] = cells;
+        layers.append(replaceTags(QLatin1String(layerTemplate), layerHash));
     }
+
+    // no need to save a tilemap with 0 cells
+    job.hasCells = !layers.isEmpty();
+    if (!job.hasCells)
+        return true;
+
+    QVariantHash tileMapHash;
+    tileMapHash["layers"] = layers;
+    tileMapHash["material"] = "/builtins/materials/tile_map.material";
+    tileMapHash["blend_mode"] = "BLEND_MODE_ALPHA";
+    tileMapHash["tile_set"] = tileSource(*job.tileset);
+
+    const QString result = replaceTags(QLatin1String(tileMapTemplate), tileMapHash);
+    return writeFile(job.filePath, result.toUtf8(), job.error);
 }
 
 /*
@@ -258,96 +365,81 @@ bool DefoldCollectionPlugin::write(const Tiled::Map *map, const QString &collect
     QString tilesetFileDir = outputFilePath;
     tilesetFileDir.chop(outputFileName.length());
 
-    // dealing with top-level tile layers here only
-    // create a tilemap file for each tileset this map uses, and for each of them create a "component" in the main embedded instance
-    for (auto &tileset : map->tilesets()) {
-        QString tilemapFilePath = tilesetFileDir;
-        tilemapFilePath.append(mapName + "-" + tileset->name() + ".tilemap");
-
-        QVariantHash componentHash;
-        componentHash["tilemap_name"] = mapName + "-" + tileset->name();
-        componentHash["tilemap_rel_path"] = tilesetRelativePath(tilemapFilePath);
-
-        QVariantHash tileMapHash;
+    // Collect the tilemaps to write. For top-level tile layers, there is a
+    // tilemap for each tileset this map uses. For each group layer, there
+    // are as many tilemaps as there are tilesets as well.
+    std::vector<TilemapJob> jobs;
 
-        bool tilemapHasCells = false;
+    for (auto &tileset : map->tilesets()) {
+        TilemapJob job;
+        job.tileset = tileset.data();
+        job.filePath = tilesetFileDir + mapName + "-" + tileset->name() + ".tilemap";
 
-        int componentCells = 0;
-        QString layers;
         for (auto layer : map->layers()) {
             if (layer->layerType() != Tiled::Layer::TileLayerType)
                 continue;
-            auto tileLayer = static_cast<Tiled::TileLayer*>(layer);
-
-            QVariantHash layerHash;
-            layerHash["id"] = tileLayer->name();
-            layerHash["z"] = zIndexForLayer(*map, *tileLayer, true);
-            layerHash["is_visible"] = tileLayer->isVisible() ? 1 : 0;
-            QString cells;
-
-            for (int x = 0; x < tileLayer->width(); ++x) {
-                for (int y = 0; y < tileLayer->height(); ++y) {
-                    const Tiled::Cell &cell = tileLayer->cellAt(x, y);
-                    if (cell.isEmpty())
-                        continue;
-                    if (cell.tileset() != tileset) // skip cell if it doesn't belong to current tileset
-                        continue;
-
-                    tilemapHasCells = true;
-                    componentCells++;
-                    QVariantHash cellHash;
-                    cellHash["x"] = x;
-                    cellHash["y"] = tileLayer->height() - y - 1;
-                    setCellProperties(cellHash, cell);
-                    cells.append(replaceTags(QLatin1String(cellTemplate), cellHash));
-
-                    // Create a component for this embedded instance only when the first cell of this component is found.
-                    // If 0 cells are found, this component is not necessary.
-                    // If more than 1 cells are found, recreating it would be redundant.
-                    if (componentCells == 1)
-                        topLevelComponents.append(replaceTags(QLatin1String(componentTemplate), componentHash));
+
+            job.layers.append({ static_cast<Tiled::TileLayer*>(layer),
+                                zIndexForLayer(*map, *layer, true),
+                                layer->isVisible() });
+        }
+
+        jobs.push_back(std::move(job));
+    }
+
+    for (auto layer : map->layers()) {
+        if (layer->layerType() != Tiled::Layer::GroupLayerType)
+            continue;
+        auto groupLayer = static_cast<Tiled::GroupLayer*>(layer);
+
+        for (auto &tileset : map->tilesets()) {
+            TilemapJob job;
+            job.tileset = tileset.data();
+            job.filePath = tilesetFileDir + mapName + "-" + layer->name() + "-" + tileset->name() + ".tilemap";
+
+            for (auto subLayer : groupLayer->layers()) {
+                if (auto tileLayer = subLayer->asTileLayer()) {
+                    job.layers.append({ tileLayer,
+                                        zIndexForLayer(*map, *subLayer, false),
+                                        layer->isVisible() });
                 }
             }
-            layerHash["cells"] = cells;
 
-            // only add this layer to the .tilemap if it has any cells
-            if (!cells.isEmpty())
-                layers.append(replaceTags(QLatin1String(layerTemplate), layerHash));
+            jobs.push_back(std::move(job));
         }
-        // make a check that this tilemap has cells at all, or no .tilesource file is necessary
-        if (tilemapHasCells) {
-            tileMapHash["layers"] = layers;
-            tileMapHash["material"] = "/builtins/materials/tile_map.material";
-            tileMapHash["blend_mode"] = "BLEND_MODE_ALPHA";
-            tileMapHash["tile_set"] = tileSource(*tileset);
-
-            QString result = replaceTags(QLatin1String(tileMapTemplate), tileMapHash);
-            Tiled::SaveFile mapFile(tilemapFilePath);
-            if (!mapFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                mError = QCoreApplication::translate("File Errors", "Could not open file for writing.");
-                return false;
-            }
-            QTextStream stream(mapFile.device());
-            stream << result;
+    }
 
-            if (mapFile.error() != QFileDevice::NoError) {
-                mError = mapFile.errorString();
-                return false;
-            }
+    // Write the tilemaps in parallel
+    QtConcurrent::blockingMap(jobs, [] (TilemapJob &job) {
+        writeTilemap(job);
+    });
 
-            if (!mapFile.commit()) {
-                mError = mapFile.errorString();
-                return false;
-            }
+    for (const TilemapJob &job : jobs) {
+        if (!job.error.isEmpty()) {
+            mError = job.error;
+            return false;
         }
     }
 
+    auto job = jobs.cbegin();
+
+    // dealing with top-level tile layers here only
+    // for each tilemap with cells, create a "component" in the main embedded instance
+    for (auto &tileset : map->tilesets()) {
+        if (job->hasCells) {
+            QVariantHash componentHash;
+            componentHash["tilemap_name"] = mapName + "-" + tileset->name();
+            componentHash["tilemap_rel_path"] = tilesetRelativePath(job->filePath);
+            topLevelComponents.append(replaceTags(QLatin1String(componentTemplate), componentHash));
+        }
+        ++job;
+    }
+
     // For each Group Layer, create a "GameObject" parented to the "tilemaps" GO
-    // and create tilemaps for layers (as components of this GO)
+    // and add its tilemaps as components of this GO
     for (auto layer : map->layers()) {
         if (layer->layerType() != Tiled::Layer::GroupLayerType)
             continue;
-        auto groupLayer = static_cast<Tiled::GroupLayer*>(layer);
 
         QVariantHash childHash;
         childHash["child-name"] = layer->name();
@@ -361,87 +453,16 @@ bool DefoldCollectionPlugin::write(const Tiled::Map *map, const QString &collect
 
         QString components;
 
-        // write as many tilemaps as there are tilesets per group layer
         for (auto &tileset : map->tilesets()) {
-            QString tilemapFilePath = tilesetFileDir;
-            tilemapFilePath.append(mapName + "-" + layer->name() + "-" + tileset->name() + ".tilemap");
-
-            QVariantHash tileMapHash;
-            QString layers;
-
-            int componentCells = 0;
-            for (auto subLayer : groupLayer->layers()) {
-                auto tileLayer = subLayer->asTileLayer();
-                if (!tileLayer)
-                    continue;
-
-                QVariantHash layerHash;
-                layerHash["id"] = tileLayer->name();
-                layerHash["z"] = zIndexForLayer(*map, *subLayer, false);
-
-                layerHash["is_visible"] = layer->isVisible() ? 1 : 0;
-                QString cells;
-
-                for (int x = 0; x < tileLayer->width(); ++x) {
-                    for (int y = 0; y < tileLayer->height(); ++y) {
-                        const Tiled::Cell &cell = tileLayer->cellAt(x, y);
-                        if (cell.isEmpty() || cell.tileset() != tileset) // skip cell if it doesn't belong to current tileset
-                            continue;
-
-                        QVariantHash cellHash;
-                        cellHash["x"] = x;
-                        cellHash["y"] = tileLayer->height() - y - 1;
-                        setCellProperties(cellHash, cell);
-                        cells.append(replaceTags(QLatin1String(cellTemplate), cellHash));
-                        componentCells++;
-
-                        // Create a component for this embedded instance only when the first cell of this component is found.
-                        // If 0 cells are found, this component is not necessary.
-                        // If more than 1 cells are found, recreating it would be redundant.
-                        if (componentCells == 1) {
-                            QVariantHash componentHash;
-                            componentHash["tilemap_name"] = mapName + "-" + layer->name() + "-" + tileset->name();
-                            componentHash["tilemap_rel_path"] = tilesetRelativePath(tilemapFilePath);
-                            components.append(replaceTags(QLatin1String(componentTemplate), componentHash));
-                        }
-                    }
-                }
-
-                if (!cells.isEmpty()) {
-                    layerHash["cells"] = cells;
-                    layers.append(replaceTags(QLatin1String(layerTemplate), layerHash));
-                }
-            }
-
-            // no need to save a tilemap with 0 cells
-            if (layers.isEmpty())
-                continue;
-
-            tileMapHash["layers"] = layers;
-            tileMapHash["material"] = "/builtins/materials/tile_map.material";
-            tileMapHash["blend_mode"] = "BLEND_MODE_ALPHA";
-            tileMapHash["tile_set"] = tileSource(*tileset);
-
-            QString result = replaceTags(QLatin1String(tileMapTemplate), tileMapHash);
-            Tiled::SaveFile mapFile(tilemapFilePath);
-            if (!mapFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                mError = QCoreApplication::translate("File Errors", "Could not open file for writing.");
-                return false;
-            }
-
-            QTextStream stream(mapFile.device());
-            stream << result;
-
-            if (mapFile.error() != QFileDevice::NoError) {
-                mError = mapFile.errorString();
-                return false;
-            }
-
-            if (!mapFile.commit()) {
-                mError = mapFile.errorString();
-                return false;
+            if (job->hasCells) {
+                QVariantHash componentHash;
+                componentHash["tilemap_name"] = mapName + "-" + layer->name() + "-" + tileset->name();
+                componentHash["tilemap_rel_path"] = tilesetRelativePath(job->filePath);
+                components.append(replaceTags(QLatin1String(componentTemplate), componentHash));
             }
+            ++job;
         }
+
         emdeddedInstanceHash["components"] = components;
         embeddedInstances.append(replaceTags(QLatin1String(emdeddedInstanceTemplate), emdeddedInstanceHash));
     }
@@ -452,25 +473,7 @@ bool DefoldCollectionPlugin::write(const Tiled::Map *map, const QString &collect
     collectionHash["embedded-instances"] = embeddedInstances;
 
     QString result = replaceTags(QLatin1String(collectionTemplate), collectionHash);
-    Tiled::SaveFile mapFile(collectionFile);
-    if (!mapFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        mError = QCoreApplication::translate("File Errors", "Could not open file for writing.");
-        return false;
-    }
-    QTextStream stream(mapFile.device());
-    stream << result;
-
-    if (mapFile.error() != QFileDevice::NoError) {
-        mError = mapFile.errorString();
-        return false;
-    }
-
-    if (!mapFile.commit()) {
-        mError = mapFile.errorString();
-        return false;
-    }
-
-    return true;
+    return writeFile(collectionFile, result.toUtf8(), mError);
 }
 
 } // namespace DefoldCollection
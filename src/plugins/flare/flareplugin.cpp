@@ -85,7 +85,7 @@ std::unique_ptr<Tiled::Map> FlarePlugin::read(const QString &fileName)
     QColor backgroundColor;
 
     while (!stream.atEnd()) {
-        line = stream.readLine();
+        stream.readLineInto(&line);
         const QStringView lineView(line);
         if (!line.length())
             continue;
@@ -195,11 +195,12 @@ std::unique_ptr<Tiled::Map> FlarePlugin::read(const QString &fileName)
                     }
                 } else if (key == QLatin1String("data")) {
                     for (int y=0; y < map->height(); y++) {
-                        line = stream.readLine();
-                        QStringList l = line.split(QChar(','));
-                        for (int x=0; x < qMin(map->width(), l.size()); x++) {
+                        stream.readLineInto(&line);
+                        CsvTokenizer<QChar> tokenizer(line.constData(), line.constData() + line.size());
+                        for (int x=0; x < map->width() && !tokenizer.atEnd(); x++) {
                             bool ok;
-                            int tileid = l[x].toInt(nullptr, base);
+                            unsigned tileid;
+                            tokenizer.readValue(tileid, base);  // invalid ids are read as 0
                             Cell c = gidMapper.gidToCell(tileid, ok);
                             if (!ok) {
                                 mError += tr("Error mapping tile id %1.").arg(tileid);
@@ -21,6 +21,7 @@
 
 #include "jsonplugin.h"
 
+#include "jsonmapreader.h"
 #include "maptovariantconverter.h"
 #include "varianttomapconverter.h"
 #include "savefile.h"
@@ -30,12 +31,67 @@
 #include <QCoreApplication>
 #include <QFile>
 #include <QFileInfo>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QTextStream>
 
 namespace Json {
 
+static QVariant mapToVariant(const QJsonValue &value);
+
+/**
+ * Converts a tile layer or chunk object, keeping its "data" array as a
+ * QJsonArray instead of creating a QVariant for each tile.
+ */
+static QVariant layerDataToVariant(const QJsonObject &object)
+{
+    QVariantMap variantMap;
+
+    for (auto it = object.begin(); it != object.end(); ++it) {
+        if (it.key() == QLatin1String("data") && it.value().isArray()) {
+            variantMap.insert(it.key(), QVariant::fromValue(it.value().toArray()));
+        } else if (it.key() == QLatin1String("chunks") && it.value().isArray()) {
+            QVariantList chunks;
+            for (const QJsonValue chunk : it.value().toArray())
+                chunks.append(layerDataToVariant(chunk.toObject()));
+            variantMap.insert(it.key(), chunks);
+        } else {
+            variantMap.insert(it.key(), mapToVariant(it.value()));
+        }
+    }
+
+    return variantMap;
+}
+
+/**
+ * Like QJsonValue::toVariant, except for the data of tile layers (see
+ * layerDataToVariant).
+ */
+static QVariant mapToVariant(const QJsonValue &value)
+{
+    switch (value.type()) {
+    case QJsonValue::Object: {
+        const QJsonObject object = value.toObject();
+        if (object.value(QLatin1String("type")) == QLatin1String("tilelayer"))
+            return layerDataToVariant(object);
+
+        QVariantMap variantMap;
+        for (auto it = object.begin(); it != object.end(); ++it)
+            variantMap.insert(it.key(), mapToVariant(it.value()));
+        return variantMap;
+    }
+    case QJsonValue::Array: {
+        QVariantList variantList;
+        for (const QJsonValue element : value.toArray())
+            variantList.append(mapToVariant(element));
+        return variantList;
+    }
+    default:
+        return value.toVariant();
+    }
+}
+
 void JsonPlugin::initialize()
 {
     addObject(new JsonMapFormat(JsonMapFormat::Json, this));
@@ -51,14 +107,73 @@ JsonMapFormat::JsonMapFormat(SubFormat subFormat, QObject *parent)
 {}
 
 std::unique_ptr<Tiled::Map> JsonMapFormat::read(const QString &fileName)
+{
+    QByteArray contents;
+    if (!readContents(fileName, contents, &mError))
+        return nullptr;
+
+    Tiled::JsonMapReader reader;
+    auto map = reader.readMap(contents, QFileInfo(fileName).dir());
+
+    if (!map)
+        mError = reader.errorString();
+
+    return map;
+}
+
+QVariant JsonMapFormat::parse(const QString &fileName) const
+{
+    return parseFile(fileName, nullptr);
+}
+
+std::unique_ptr<Tiled::Map> JsonMapFormat::readParsed(const QString &fileName,
+                                                      const QVariant &data)
+{
+    Tiled::VariantToMapConverter converter;
+    auto map = converter.toMap(data, QFileInfo(fileName).dir());
+
+    if (!map)
+        mError = converter.errorString();
+
+    return map;
+}
+
+/**
+ * Reads the JSON (or JSONP) file and converts it to a QVariant. Does not
+ * touch any state, so it can be called from a worker thread.
+ */
+QVariant JsonMapFormat::parseFile(const QString &fileName, QString *error) const
+{
+    QByteArray contents;
+    if (!readContents(fileName, contents, error))
+        return QVariant();
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(contents, &parseError);
+
+    if (parseError.error != QJsonParseError::NoError) {
+        if (error)
+            *error = tr("Error parsing file: %1").arg(parseError.errorString());
+        return QVariant();
+    }
+
+    return mapToVariant(document.object());
+}
+
+/**
+ * Reads the contents of the JSON file, skipping the JSONP prefix and suffix
+ * when necessary.
+ */
+bool JsonMapFormat::readContents(const QString &fileName, QByteArray &contents, QString *error) const
 {
     QFile file(fileName);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        mError = QCoreApplication::translate("File Errors", "Could not open file for reading.");
-        return nullptr;
+        if (error)
+            *error = QCoreApplication::translate("File Errors", "Could not open file for reading.");
+        return false;
     }
 
-    QByteArray contents = file.readAll();
+    contents = file.readAll();
     if (mSubFormat == JavaScript && contents.size() > 0 && contents[0] != '{') {
         // Scan past JSONP prefix; look for an open curly at the start of the line
         int i = contents.indexOf("\n{");
@@ -70,21 +185,7 @@ std::unique_ptr<Tiled::Map> JsonMapFormat::read(const QString &fileName)
         }
     }
 
-    QJsonParseError error;
-    const QJsonDocument document = QJsonDocument::fromJson(contents, &error);
-
-    if (error.error != QJsonParseError::NoError) {
-        mError = tr("Error parsing file: %1").arg(error.errorString());
-        return nullptr;
-    }
-
-    Tiled::VariantToMapConverter converter;
-    auto map = converter.toMap(document.toVariant(), QFileInfo(fileName).dir());
-
-    if (!map)
-        mError = converter.errorString();
-
-    return map;
+    return true;
 }
 
 bool JsonMapFormat::write(const Tiled::Map *map,
@@ -99,6 +200,7 @@ bool JsonMapFormat::write(const Tiled::Map *map,
     }
 
     Tiled::MapToVariantConverter converter;
+    converter.setCompactLayerData(true);
     QVariant variant = converter.toVariant(*map, QFileInfo(fileName).dir());
 
     JsonWriter writer;
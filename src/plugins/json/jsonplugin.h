@@ -61,10 +61,14 @@ public:
     JsonMapFormat(SubFormat subFormat, QObject *parent = nullptr);
 
     std::unique_ptr<Tiled::Map> read(const QString &fileName) override;
+    QVariant parse(const QString &fileName) const override;
+    std::unique_ptr<Tiled::Map> readParsed(const QString &fileName, const QVariant &data) override;
     bool supportsFile(const QString &fileName) const override;
 
     bool write(const Tiled::Map *map, const QString &fileName, Options options) override;
 
+    Capabilities capabilities() const override { return ReadWrite | WriteInBackground; }
+
     QString nameFilter() const override;
     QString shortName() const override;
     QString errorString() const override;
@@ -72,6 +76,10 @@ public:
 protected:
     QString mError;
     SubFormat mSubFormat;
+
+private:
+    QVariant parseFile(const QString &fileName, QString *error) const;
+    bool readContents(const QString &fileName, QByteArray &contents, QString *error) const;
 };
 
 
@@ -10,6 +10,7 @@
 #include "json.h"
 
 #include <QDebug>
+#include <QVector>
 #include <qnumeric.h>
 
 /*!
@@ -153,7 +154,27 @@ static QString escape(const QVariant &variant)
  */
 void JsonWriter::stringify(const QVariant &variant, int depth)
 {
-    if (variant.type() == QVariant::List || variant.type() == QVariant::StringList) {
+    if (variant.userType() == qMetaTypeId<QVector<unsigned>>()) {
+        // Written directly, to avoid a QVariant per element
+        const QString indent = m_autoFormattingIndent.repeated(depth);
+        m_result += QLatin1Char('[');
+        const QVector<unsigned> values = variant.value<QVector<unsigned>>();
+        for (int i = 0; i < values.size(); i++) {
+            if (i != 0) {
+                m_result += QLatin1Char(',');
+                if (m_autoFormatting) {
+                    if (m_autoFormattingWrapArrayCount && i % m_autoFormattingWrapArrayCount == 0) {
+                        m_result += QLatin1Char('\n');
+                        m_result += indent;
+                    } else {
+                        m_result += QLatin1Char(' ');
+                    }
+                }
+            }
+            m_result += QString::number(values.at(i));
+        }
+        m_result += QLatin1Char(']');
+    } else if (variant.type() == QVariant::List || variant.type() == QVariant::StringList) {
         const QString indent = m_autoFormattingIndent.repeated(depth);
         m_result += QLatin1Char('[');
         QVariantList list = variant.toList();
@@ -249,6 +270,9 @@ void JsonWriter::stringify(const QVariant &variant, int depth)
   \o QVariant::List, QVariant::StringList
   \o JSON array []
   \row
+  \o QVector<unsigned>
+  \o JSON array [] of numbers
+  \row
   \o QVariant::Map
   \o JSON object {}
   \row
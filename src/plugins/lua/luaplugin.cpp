@@ -542,6 +542,10 @@ void LuaWriter::writeTileLayer(const TileLayer *tileLayer,
                                int compressionLevel,
                                QSize chunkSize)
 {
+    // The Lua format has no place for a shared compression dictionary
+    if (format == Map::Base64ZstandardDictionary)
+        format = Map::Base64Zstandard;
+
     mWriter.writeStartTable();
 
     mWriter.writeKeyAndValue("type", "tilelayer");
@@ -571,7 +575,8 @@ void LuaWriter::writeTileLayer(const TileLayer *tileLayer,
 
         break;
     }
-    case Map::Base64Zstandard: {
+    case Map::Base64Zstandard:
+    case Map::Base64ZstandardDictionary: {
         mWriter.writeKeyAndValue("encoding", "base64");
         mWriter.writeKeyAndValue("compression", "zstd");
 
@@ -627,7 +632,8 @@ void LuaWriter::writeTileLayerData(const TileLayer *tileLayer,
     case Map::Base64:
     case Map::Base64Zlib:
     case Map::Base64Gzip:
-    case Map::Base64Zstandard: {
+    case Map::Base64Zstandard:
+    case Map::Base64ZstandardDictionary: {
         QByteArray layerData = mGidMapper.encodeLayerData(*tileLayer, format, bounds, compressionLevel);
         mWriter.writeKeyAndValue("data", layerData);
         break;
@@ -22,13 +22,44 @@
 
 #include <QIODevice>
 
+#include <cstring>
+
 namespace Lua {
 
+/**
+ * Formats \a value as decimal digits, ending just before \a end. Returns a
+ * pointer to the first digit.
+ */
+static char *formatUnsigned(char *end, unsigned value)
+{
+    do {
+        *--end = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+    return end;
+}
+
+static char *formatInt(char *end, int value)
+{
+    if (value >= 0)
+        return formatUnsigned(end, unsigned(value));
+
+    char *begin = formatUnsigned(end, 0u - unsigned(value));
+    *--begin = '-';
+    return begin;
+}
+
 LuaTableWriter::LuaTableWriter(QIODevice *device)
     : m_device(device)
+    , m_buffer(new char[BufferSize])
 {
 }
 
+LuaTableWriter::~LuaTableWriter()
+{
+    flush();
+}
+
 void LuaTableWriter::writeStartDocument()
 {
     Q_ASSERT(m_indent == 0);
@@ -38,6 +69,7 @@ void LuaTableWriter::writeEndDocument()
 {
     Q_ASSERT(m_indent == 0);
     write('\n');
+    flush();
 }
 
 void LuaTableWriter::writeStartTable()
@@ -100,14 +132,46 @@ void LuaTableWriter::writeValue(const QByteArray &value)
     m_valueWritten = true;
 }
 
-void LuaTableWriter::writeUnquotedValue(const QByteArray &value)
+void LuaTableWriter::writeValue(int value)
+{
+    char buffer[16];
+    char * const end = buffer + sizeof(buffer);
+    const char *begin = formatInt(end, value);
+    writeUnquotedValue(begin, end - begin);
+}
+
+void LuaTableWriter::writeValue(unsigned value)
+{
+    char buffer[16];
+    char * const end = buffer + sizeof(buffer);
+    const char *begin = formatUnsigned(end, value);
+    writeUnquotedValue(begin, end - begin);
+}
+
+void LuaTableWriter::writeUnquotedValue(const char *bytes, qint64 length)
 {
     prepareNewValue();
-    write(value);
+    write(bytes, length);
     m_newLine = false;
     m_valueWritten = true;
 }
 
+void LuaTableWriter::writeKeyAndValue(const QByteArray &key, int value)
+{
+    char buffer[16];
+    char * const end = buffer + sizeof(buffer);
+    const char *begin = formatInt(end, value);
+    writeKeyAndUnquotedValue(key, begin, end - begin);
+}
+
+void LuaTableWriter::writeKeyAndValue(const QByteArray &key, unsigned value)
+{
+    char buffer[16];
+    char * const end = buffer + sizeof(buffer);
+    const char *begin = formatUnsigned(end, value);
+    writeKeyAndUnquotedValue(key, begin, end - begin);
+}
+
 void LuaTableWriter::writeKeyAndValue(const QByteArray &key,
                                       const char *value)
 {
@@ -182,12 +246,12 @@ void LuaTableWriter::writeVariantValue(const QVariant &value)
 }
 
 void LuaTableWriter::writeKeyAndUnquotedValue(const QByteArray &key,
-                                              const QByteArray &value)
+                                              const char *bytes, qint64 length)
 {
     prepareNewLine();
     write(key);
     write(m_minimize ? "=" : " = ");
-    write(value);
+    write(bytes, length);
     m_newLine = false;
     m_valueWritten = true;
 }
@@ -255,10 +319,35 @@ void LuaTableWriter::writeNewline()
     }
 }
 
-void LuaTableWriter::write(const char *bytes, qint64 length)
+/**
+ * Writes any buffered output to the device.
+ */
+void LuaTableWriter::flush()
 {
-    if (m_device->write(bytes, length) != length)
+    if (m_bufferUsed == 0)
+        return;
+
+    if (m_device->write(m_buffer.get(), m_bufferUsed) != m_bufferUsed)
         m_error = true;
+
+    m_bufferUsed = 0;
+}
+
+void LuaTableWriter::write(const char *bytes, qint64 length)
+{
+    if (m_bufferUsed + length > BufferSize) {
+        flush();
+
+        // Large writes bypass the buffer
+        if (length >= BufferSize) {
+            if (m_device->write(bytes, length) != length)
+                m_error = true;
+            return;
+        }
+    }
+
+    std::memcpy(m_buffer.get() + m_bufferUsed, bytes, size_t(length));
+    m_bufferUsed += int(length);
 }
 
 } // namespace Lua
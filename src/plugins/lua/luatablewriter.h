@@ -24,17 +24,24 @@
 #include <QString>
 #include <QVariant>
 
+#include <memory>
+
 class QIODevice;
 
 namespace Lua {
 
 /**
  * Makes it easy to produce a well formatted Lua table.
+ *
+ * Output is collected in a fixed-size buffer, which is written to the device
+ * whenever it is full and at the end of the document. Call flush() when
+ * writing anything else than a complete document.
  */
 class LuaTableWriter
 {
 public:
     LuaTableWriter(QIODevice *device);
+    ~LuaTableWriter();
 
     void writeStartDocument();
     void writeEndDocument();
@@ -74,11 +81,17 @@ public:
 
     void prepareNewLine();
 
+    void flush();
+
     bool hasError() const { return m_error; }
 
     static QString quote(const QString &str);
 
 private:
+    void writeUnquotedValue(const char *bytes, qint64 length);
+    void writeKeyAndUnquotedValue(const QByteArray &key,
+                                  const char *bytes, qint64 length);
+
     void prepareNewValue();
     void writeIndent();
 
@@ -88,7 +101,11 @@ private:
     void write(const QByteArray &bytes);
     void write(char c);
 
+    static constexpr int BufferSize = 64 * 1024;
+
     QIODevice *m_device;
+    std::unique_ptr<char[]> m_buffer;
+    int m_bufferUsed { 0 };
     int m_indent { 0 };
     char m_valueSeparator { ',' };
     bool m_suppressNewlines { false };
@@ -98,21 +115,9 @@ private:
     bool m_error { false };
 };
 
-inline void LuaTableWriter::writeValue(int value)
-{ writeUnquotedValue(QByteArray::number(value)); }
-
-inline void LuaTableWriter::writeValue(unsigned value)
-{ writeUnquotedValue(QByteArray::number(value)); }
-
 inline void LuaTableWriter::writeValue(const QString &value)
 { writeUnquotedValue(quote(value).toUtf8()); }
 
-inline void LuaTableWriter::writeKeyAndValue(const QByteArray &key, int value)
-{ writeKeyAndUnquotedValue(key, QByteArray::number(value)); }
-
-inline void LuaTableWriter::writeKeyAndValue(const QByteArray &key, unsigned value)
-{ writeKeyAndUnquotedValue(key, QByteArray::number(value)); }
-
 inline void LuaTableWriter::writeKeyAndValue(const QByteArray &key, float value)
 { writeKeyAndValue(key, static_cast<double>(value)); }
 
@@ -125,6 +130,13 @@ inline void LuaTableWriter::writeKeyAndValue(const QByteArray &key, bool value)
 inline void LuaTableWriter::writeKeyAndValue(const QByteArray &key, const QString &value)
 { writeKeyAndUnquotedValue(key, quote(value).toUtf8()); }
 
+inline void LuaTableWriter::writeUnquotedValue(const QByteArray &value)
+{ writeUnquotedValue(value.constData(), value.length()); }
+
+inline void LuaTableWriter::writeKeyAndUnquotedValue(const QByteArray &key,
+                                                     const QByteArray &value)
+{ writeKeyAndUnquotedValue(key, value.constData(), value.length()); }
+
 inline void LuaTableWriter::write(const char *bytes)
 { write(bytes, qstrlen(bytes)); }
 
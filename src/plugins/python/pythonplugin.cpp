@@ -65,6 +65,9 @@ PythonPlugin::PythonPlugin()
 
 PythonPlugin::~PythonPlugin()
 {
+    if (mMainThreadState)
+        PyEval_RestoreThread(mMainThreadState);
+
     for (const ScriptEntry &script : std::as_const(mScripts)) {
         Py_DECREF(script.module);
 
@@ -105,70 +108,87 @@ void PythonPlugin::initialize()
             return;
         }
 
-        PyObject *pmod = PyImport_ImportModule("tiled");
+        const bool ready = setupInterpreter();
 
-        if (pmod) {
-            PyObject *tiledPlugin = PyObject_GetAttrString(pmod, "Plugin");
-            PyObject *tiledTilesetPlugin = PyObject_GetAttrString(pmod, "TilesetPlugin");
-            Py_DECREF(pmod);
+        // Release the GIL, which is acquired again whenever Python is used
+        mMainThreadState = PyEval_SaveThread();
 
-            if (tiledPlugin) {
-                if (PyCallable_Check(tiledPlugin)) {
-                    mPluginClass = tiledPlugin;
-                } else {
-                    Py_DECREF(tiledPlugin);
-                }
-            }
-            if (tiledTilesetPlugin) {
-                if (PyCallable_Check(tiledTilesetPlugin)) {
-                    mTilesetPluginClass = tiledTilesetPlugin;
-                } else {
-                    Py_DECREF(tiledTilesetPlugin);
-                }
+        if (!ready)
+            return;
+    }
+
+    reloadModules();
+
+    if (QFile::exists(mScriptDir))
+        mFileSystemWatcher.addPath(mScriptDir);
+}
+
+/**
+ * Sets up the "tiled" module and redirects the output of scripts to the
+ * Console. Returns whether the plugin base classes were found.
+ */
+bool PythonPlugin::setupInterpreter()
+{
+    PyObject *pmod = PyImport_ImportModule("tiled");
+
+    if (pmod) {
+        PyObject *tiledPlugin = PyObject_GetAttrString(pmod, "Plugin");
+        PyObject *tiledTilesetPlugin = PyObject_GetAttrString(pmod, "TilesetPlugin");
+        Py_DECREF(pmod);
+
+        if (tiledPlugin) {
+            if (PyCallable_Check(tiledPlugin)) {
+                mPluginClass = tiledPlugin;
+            } else {
+                Py_DECREF(tiledPlugin);
             }
         }
-
-        if (!mPluginClass) {
-            Tiled::ERROR("Can't find tiled.Plugin baseclass");
-            handleError();
-            return;
+        if (tiledTilesetPlugin) {
+            if (PyCallable_Check(tiledTilesetPlugin)) {
+                mTilesetPluginClass = tiledTilesetPlugin;
+            } else {
+                Py_DECREF(tiledTilesetPlugin);
+            }
         }
+    }
 
-        if (!mTilesetPluginClass) {
-            Tiled::ERROR("Can't find tiled.TilesetPlugin baseclass");
-            handleError();
-            return;
-        }
+    if (!mPluginClass) {
+        Tiled::ERROR("Can't find tiled.Plugin baseclass");
+        handleError();
+        return false;
+    }
 
-        // w/o differentiating error messages could just rename "log"
-        // to "write" in the binding and assign plugin directly to stdout/stderr
-        PySys_SetObject((char *)"_tiledplugin",
-                        _wrap_convert_c2py__Tiled__LoggingInterface(&Tiled::LoggingInterface::instance()));
-
-        PyRun_SimpleString("import sys\n"
-                           "#from tiled.Tiled.LoggingInterface import INFO,ERROR\n"
-                           "class _Catcher:\n"
-                           "   def __init__(self, type):\n"
-                           "      self.buffer = ''\n"
-                           "      self.type = type\n"
-                           "   def write(self, msg):\n"
-                           "      self.buffer += msg\n"
-                           "      if self.buffer.endswith('\\n'):\n"
-                           "         sys._tiledplugin.log(self.type, self.buffer)\n"
-                           "         self.buffer = ''\n"
-                           "sys.stdout = _Catcher(0)\n"
-                           "sys.stderr = _Catcher(1)\n");
-
-        PyRun_SimpleString(QString("import sys; sys.path.insert(0, \"%1\")")
-                           .arg(mScriptDir).toUtf8().constData());
-
-        Tiled::INFO(QString("Python scripts path: %1\n").arg(mScriptDir));
+    if (!mTilesetPluginClass) {
+        Tiled::ERROR("Can't find tiled.TilesetPlugin baseclass");
+        handleError();
+        return false;
     }
 
-    reloadModules();
+    // w/o differentiating error messages could just rename "log"
+    // to "write" in the binding and assign plugin directly to stdout/stderr
+    PySys_SetObject((char *)"_tiledplugin",
+                    _wrap_convert_c2py__Tiled__LoggingInterface(&Tiled::LoggingInterface::instance()));
+
+    PyRun_SimpleString("import sys\n"
+                       "#from tiled.Tiled.LoggingInterface import INFO,ERROR\n"
+                       "class _Catcher:\n"
+                       "   def __init__(self, type):\n"
+                       "      self.buffer = ''\n"
+                       "      self.type = type\n"
+                       "   def write(self, msg):\n"
+                       "      self.buffer += msg\n"
+                       "      if self.buffer.endswith('\\n'):\n"
+                       "         sys._tiledplugin.log(self.type, self.buffer)\n"
+                       "         self.buffer = ''\n"
+                       "sys.stdout = _Catcher(0)\n"
+                       "sys.stderr = _Catcher(1)\n");
+
+    PyRun_SimpleString(QString("import sys; sys.path.insert(0, \"%1\")")
+                       .arg(mScriptDir).toUtf8().constData());
+
+    Tiled::INFO(QString("Python scripts path: %1\n").arg(mScriptDir));
 
-    if (QFile::exists(mScriptDir))
-        mFileSystemWatcher.addPath(mScriptDir);
+    return true;
 }
 
 /**
@@ -176,6 +196,11 @@ void PythonPlugin::initialize()
  */
 void PythonPlugin::reloadModules()
 {
+    if (!Py_IsInitialized())
+        return;
+
+    GilLocker locker;
+
     Tiled::INFO(tr("Reloading Python scripts"));
 
     // Remove any currently watched script files
@@ -197,18 +222,18 @@ void PythonPlugin::reloadModules()
         ScriptEntry script = mScripts.take(name);
         script.name = name;
 
-        // Throw away any existing class reference
-        if (script.mapFormat) {
-            PyObject *pluginClass = script.mapFormat->pythonClass();
-            Py_DECREF(pluginClass);
-        }
+        // The existing class references are only dropped once the formats
+        // refer to their new class, since running the script may let other
+        // threads use the formats in the meantime
+        PyObject *oldMapClass = script.mapFormat ? script.mapFormat->pythonClass() : nullptr;
+        PyObject *oldTilesetClass = script.tilesetFormat ? script.tilesetFormat->pythonClass() : nullptr;
 
-        if (script.tilesetFormat) {
-            PyObject *pluginClass = script.tilesetFormat->pythonClass();
-            Py_DECREF(pluginClass);
-        }
+        const bool loaded = loadOrReloadModule(script);
 
-        if (loadOrReloadModule(script)) {
+        Py_XDECREF(oldMapClass);
+        Py_XDECREF(oldTilesetClass);
+
+        if (loaded) {
             mScripts.insert(name, script);
         } else {
             if (!script.module) {
@@ -295,7 +320,8 @@ bool PythonPlugin::loadOrReloadModule(ScriptEntry &script)
         }
     } else if (script.mapFormat) {
         removeObject(script.mapFormat);
-        delete script.mapFormat;
+        retireFormat(script.mapFormat);
+        script.mapFormat = nullptr;
     }
 
     if (tilesetPluginClass) {
@@ -308,7 +334,8 @@ bool PythonPlugin::loadOrReloadModule(ScriptEntry &script)
         }
     } else if (script.tilesetFormat) {
         removeObject(script.tilesetFormat);
-        delete script.tilesetFormat;
+        retireFormat(script.tilesetFormat);
+        script.tilesetFormat = nullptr;
     }
 
     if (!pluginClass && !tilesetPluginClass) {
@@ -320,6 +347,18 @@ bool PythonPlugin::loadOrReloadModule(ScriptEntry &script)
     return true;
 }
 
+/**
+ * Detaches a format that is no longer provided by its script. It can't be
+ * deleted, since another thread may still be using it, so it is kept until
+ * the plugin is destroyed. Any further calls fail, since None has none of
+ * the expected methods. Requires the GIL to be held.
+ */
+void PythonPlugin::retireFormat(PythonFormat *format)
+{
+    Py_INCREF(Py_None);
+    format->setPythonClass(Py_None);
+}
+
 
 PythonFormat::PythonFormat(const QString &scriptFile, PyObject *class_)
     : mClass(nullptr)
@@ -328,15 +367,30 @@ PythonFormat::PythonFormat(const QString &scriptFile, PyObject *class_)
     setPythonClass(class_);
 }
 
+/**
+ * Returns a new reference to the Python class, which keeps it alive when the
+ * script is reloaded while it is being used. Requires the GIL to be held.
+ */
+PyObject *PythonFormat::acquireClass() const
+{
+    Py_INCREF(mClass);
+    return mClass;
+}
+
 bool PythonFormat::_supportsFile(const QString &fileName) const
 {
+    GilLocker locker;
+
     if (!PyObject_HasAttrString(mClass, "supportsFile"))
         return false;
 
-    PyObject *pinst = PyObject_CallMethod(mClass,
+    PyObject *class_ = acquireClass();
+    PyObject *pinst = PyObject_CallMethod(class_,
                                           (char *)"supportsFile",
                                           (char *)"(s)",
                                           fileName.toUtf8().constData());
+    Py_DECREF(class_);
+
     if (!pinst) {
         handleError();
         return false;
@@ -349,6 +403,8 @@ bool PythonFormat::_supportsFile(const QString &fileName) const
 
 QString PythonFormat::_nameFilter() const
 {
+    GilLocker locker;
+
     QString ret;
 
     // find fun
@@ -377,6 +433,8 @@ QString PythonFormat::_nameFilter() const
 
 QString PythonFormat::_shortName() const
 {
+    GilLocker locker;
+
     QString ret;
 
     // find fun
@@ -444,13 +502,17 @@ std::unique_ptr<Tiled::Map> PythonMapFormat::read(const QString &fileName)
 
     Tiled::INFO(tr("-- Using script %1 to read %2").arg(mScriptFile, fileName));
 
+    GilLocker locker;
+
     if (!PyObject_HasAttrString(mClass, "read")) {
         mError = "Please define class that extends tiled.Plugin and "
                 "has @classmethod read(cls, filename)";
         return nullptr;
     }
-    PyObject *pinst = PyObject_CallMethod(mClass, (char *)"read",
+    PyObject *class_ = acquireClass();
+    PyObject *pinst = PyObject_CallMethod(class_, (char *)"read",
                                           (char *)"(s)", fileName.toUtf8().constData());
+    Py_DECREF(class_);
 
     Tiled::Map *ret = nullptr;
     if (!pinst) {
@@ -474,13 +536,17 @@ bool PythonMapFormat::write(const Tiled::Map *map, const QString &fileName, Opti
 
     Tiled::INFO(tr("-- Using script %1 to write %2").arg(mScriptFile, fileName));
 
+    GilLocker locker;
+
     PyObject *pmap = _wrap_convert_c2py__Tiled__Map_const___star__(&map);
     if (!pmap)
         return false;
-    PyObject *pinst = PyObject_CallMethod(mClass,
+    PyObject *class_ = acquireClass();
+    PyObject *pinst = PyObject_CallMethod(class_,
                                           (char *)"write", (char *)"(Ns)",
                                           pmap,
                                           fileName.toUtf8().constData());
+    Py_DECREF(class_);
 
     if (!pinst) {
         PySys_WriteStderr("** Uncaught exception in script **\n");
@@ -512,13 +578,17 @@ Tiled::SharedTileset PythonTilesetFormat::read(const QString &fileName)
 
     Tiled::INFO(tr("-- Using script %1 to read %2").arg(mScriptFile, fileName));
 
+    GilLocker locker;
+
     if (!PyObject_HasAttrString(mClass, "read")) {
         mError = "Please define class that extends tiled.TilesetPlugin and "
                 "has @classmethod read(cls, filename)";
         return nullptr;
     }
-    PyObject *pinst = PyObject_CallMethod(mClass, (char *)"read",
+    PyObject *class_ = acquireClass();
+    PyObject *pinst = PyObject_CallMethod(class_, (char *)"read",
                                           (char *)"(s)", fileName.toUtf8().constData());
+    Py_DECREF(class_);
 
     Tiled::SharedTileset *ret = nullptr;
     if (!pinst) {
@@ -540,13 +610,17 @@ bool PythonTilesetFormat::write(const Tiled::Tileset &tileset, const QString &fi
 
     Tiled::INFO(tr("-- Using script %1 to write %2").arg(mScriptFile, fileName));
 
+    GilLocker locker;
+
     PyObject *ptileset = _wrap_convert_c2py__Tiled__Tileset_const(&tileset);
     if (!ptileset)
         return false;
-    PyObject *pinst = PyObject_CallMethod(mClass,
+    PyObject *class_ = acquireClass();
+    PyObject *pinst = PyObject_CallMethod(class_,
                                           (char *)"write", (char *)"(Ns)",
                                           ptileset,
                                           fileName.toUtf8().constData());
+    Py_DECREF(class_);
 
     if (!pinst) {
         PySys_WriteStderr("** Uncaught exception in script **\n");
@@ -41,9 +41,27 @@ class Map;
 
 namespace Python {
 
+class PythonFormat;
 class PythonMapFormat;
 class PythonTilesetFormat;
 
+/**
+ * Holds the global interpreter lock (GIL) for its lifetime. Needed around any
+ * use of the Python API, since the lock is released whenever Tiled is not
+ * running Python code, which allows formats to be used from any thread.
+ */
+class GilLocker
+{
+public:
+    GilLocker() : mState(PyGILState_Ensure()) {}
+    ~GilLocker() { PyGILState_Release(mState); }
+
+    Q_DISABLE_COPY(GilLocker)
+
+private:
+    PyGILState_STATE mState;
+};
+
 struct ScriptEntry
 {
     QString name;
@@ -65,8 +83,10 @@ public:
     void initialize() override;
 
 private:
+    bool setupInterpreter();
     void reloadModules();
     bool loadOrReloadModule(ScriptEntry &script);
+    void retireFormat(PythonFormat *format);
 
     PyObject *findPluginSubclass(PyObject *module, PyObject *pluginClass);
 
@@ -74,6 +94,7 @@ private:
     QMap<QString,ScriptEntry> mScripts;
     PyObject *mPluginClass;
     PyObject *mTilesetPluginClass;
+    PyThreadState *mMainThreadState = nullptr;
 
     QFileSystemWatcher mFileSystemWatcher;
     QTimer mReloadTimer;
@@ -109,6 +130,8 @@ public:
 protected:
     PythonFormat(const QString &scriptFile, PyObject *class_);
 
+    PyObject *acquireClass() const;
+
     bool _supportsFile(const QString &fileName) const;
 
     QString _nameFilter() const;
@@ -64,6 +64,7 @@ mod.add_include('"tile.h"')
 mod.add_include('"tilelayer.h"')
 mod.add_include('"tileset.h"')
 mod.add_include('"tilesetmanager.h"')
+mod.add_include('"gidmapper.h"')
 
 mod.header.writeln('#ifndef _MSC_VER')
 mod.header.writeln('#pragma GCC diagnostic ignored "-Wmissing-field-initializers"')
@@ -397,6 +398,121 @@ static Tiled::SharedTileset loadTileset(const QString &file)
 }
 """)
 
+mod.body.writeln("""
+/*
+ * Returns the global tile IDs of the given tile layer as a bytes object,
+ * holding one unsigned 32-bit integer in native byte order per cell, row by
+ * row. The first GIDs of the tilesets are assigned as when saving the map.
+ *
+ * This allows scripts to process whole layers at once, for example using
+ * numpy.frombuffer(data, dtype=numpy.uint32).
+ */
+static PyObject *
+_wrap_tiled_tileLayerGids(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs)
+{
+    PyTiledMap *map;
+    PyTiledTileLayer *layer;
+    const char *keywords[] = {"map", "layer", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "O!O!", (char **) keywords,
+                                     &PyTiledMap_Type, &map, &PyTiledTileLayer_Type, &layer)) {
+        return NULL;
+    }
+
+    const Tiled::GidMapper gidMapper(map->obj->tilesets());
+    const Tiled::TileLayer *tileLayer = layer->obj;
+    const int width = tileLayer->width();
+    const int height = tileLayer->height();
+
+    PyObject *bytes = PyBytes_FromStringAndSize(NULL, Py_ssize_t(width) * height * sizeof(quint32));
+    if (!bytes)
+        return NULL;
+
+    quint32 *gids = reinterpret_cast<quint32*>(PyBytes_AS_STRING(bytes));
+
+    // Other threads may run Python while the layer is being traversed
+    Py_BEGIN_ALLOW_THREADS
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            *gids++ = gidMapper.cellToGid(tileLayer->cellAt(x, y));
+    Py_END_ALLOW_THREADS
+
+    return bytes;
+}
+
+/*
+ * Sets all cells of the given tile layer from global tile IDs, provided by
+ * any object supporting the buffer protocol (like bytes or a numpy array)
+ * in the format returned by tileLayerGids.
+ */
+static PyObject *
+_wrap_tiled_setTileLayerGids(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs)
+{
+    PyTiledMap *map;
+    PyTiledTileLayer *layer;
+    Py_buffer buffer;
+    const char *keywords[] = {"map", "layer", "gids", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "O!O!y*", (char **) keywords,
+                                     &PyTiledMap_Type, &map, &PyTiledTileLayer_Type, &layer, &buffer)) {
+        return NULL;
+    }
+
+    Tiled::TileLayer *tileLayer = layer->obj;
+    const int width = tileLayer->width();
+    const int height = tileLayer->height();
+    const Py_ssize_t expectedSize = Py_ssize_t(width) * height * sizeof(quint32);
+
+    if (buffer.len != expectedSize) {
+        PyErr_Format(PyExc_ValueError, "expected %zd bytes of tile data, got %zd",
+                     expectedSize, buffer.len);
+        PyBuffer_Release(&buffer);
+        return NULL;
+    }
+
+    // Decode all cells before changing the layer, so that it is left alone
+    // when the data is invalid. Other threads may run Python meanwhile.
+    const Tiled::GidMapper gidMapper(map->obj->tilesets());
+    const char *data = static_cast<const char*>(buffer.buf);
+    QVector<Tiled::Cell> cells(width * height);
+    bool ok = true;
+    quint32 gid = 0;
+
+    Py_BEGIN_ALLOW_THREADS
+    for (Tiled::Cell &cell : cells) {
+        memcpy(&gid, data, sizeof(quint32));
+        data += sizeof(quint32);
+
+        cell = gidMapper.gidToCell(gid, ok);
+        if (!ok)
+            break;
+    }
+
+    if (ok) {
+        auto cell = cells.cbegin();
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x)
+                tileLayer->setCell(x, y, *cell++);
+    }
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&buffer);
+
+    if (!ok) {
+        PyErr_Format(PyExc_ValueError, "invalid tile GID %u", gid);
+        return NULL;
+    }
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+""")
+
+mod.add_custom_function_wrapper('tileLayerGids', '_wrap_tiled_tileLayerGids',
+    flags=['METH_KEYWORDS', 'METH_VARARGS'])
+mod.add_custom_function_wrapper('setTileLayerGids', '_wrap_tiled_setTileLayerGids',
+    flags=['METH_KEYWORDS', 'METH_VARARGS'])
+
 """
  C++ class PythonScript is seen as tiled.Plugin from Python script
  (naming describes the opposite side from either perspective)
@@ -0,0 +1,105 @@
+/*
+ * Regions Tiled Plugin
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "regionchunkstore.h"
+
+#include <algorithm>
+
+using namespace Tiled;
+
+namespace Regions {
+
+RegionChunkStore::RegionChunkStore(const QString &directory,
+                                   const QVector<SharedTileset> &tilesets)
+    : mDirectory(directory)
+    , mTilesets(tilesets)
+{
+}
+
+void RegionChunkStore::setTilesets(const QVector<SharedTileset> &tilesets)
+{
+    mTilesets = tilesets;
+}
+
+/**
+ * Returns whether the region files can be kept as they are when the map
+ * uses the given \a tilesets. This is the case as long as tilesets were only
+ * added, since the region files refer to the tilesets by index.
+ */
+bool RegionChunkStore::canKeepRegions(const QVector<SharedTileset> &tilesets) const
+{
+    if (tilesets.size() < mTilesets.size())
+        return false;
+
+    return std::equal(mTilesets.begin(), mTilesets.end(), tilesets.begin());
+}
+
+void RegionChunkStore::addEntry(QPoint chunkPos, Entry entry)
+{
+    mEntries.insert(chunkPos, entry);
+}
+
+/**
+ * Replaces the entries of the chunks in \a region with the \a written ones,
+ * after the region file was rewritten.
+ */
+void RegionChunkStore::replaceRegion(QPoint region, const QVector<StoredChunk> &written)
+{
+    for (int y = 0; y < REGION_SIZE; ++y) {
+        for (int x = 0; x < REGION_SIZE; ++x) {
+            const QPoint chunkPos(region.x() * REGION_SIZE + x,
+                                  region.y() * REGION_SIZE + y);
+            if (mEntries.remove(chunkPos))
+                forget(chunkPos);
+        }
+    }
+
+    for (const StoredChunk &stored : written)
+        mEntries.insert(stored.position, Entry { stored.offset, stored.size });
+}
+
+/**
+ * Closes the region file kept open for reading, which is needed before it
+ * can be replaced on some platforms.
+ */
+void RegionChunkStore::closeFile()
+{
+    mFile.close();
+}
+
+bool RegionChunkStore::readChunk(QPoint chunkPos, Chunk &chunk)
+{
+    const auto it = mEntries.constFind(chunkPos);
+    if (it == mEntries.constEnd())
+        return false;
+
+    const QPoint region = regionOf(chunkPos);
+    if (!mFile.isOpen() || mFileRegion != region) {
+        mFile.close();
+        mFile.setFileName(regionFileName(mDirectory, region));
+        if (!mFile.open(QIODevice::ReadOnly))
+            return false;
+        mFileRegion = region;
+    }
+
+    return readChunkCells(mFile, it->offset, it->size, mTilesets, chunk);
+}
+
+} // namespace Regions
@@ -0,0 +1,75 @@
+/*
+ * Regions Tiled Plugin
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "chunkstore.h"
+#include "regionfile.h"
+
+#include <QFile>
+#include <QHash>
+#include <QVector>
+
+namespace Regions {
+
+/**
+ * Pages in the chunks of a tile layer from the region files in a directory.
+ */
+class RegionChunkStore : public Tiled::ChunkStore
+{
+public:
+    struct Entry
+    {
+        quint64 offset;
+        quint32 size;
+    };
+
+    RegionChunkStore(const QString &directory,
+                     const QVector<Tiled::SharedTileset> &tilesets);
+
+    const QString &directory() const { return mDirectory; }
+
+    /**
+     * The tilesets referred to by index from the region files.
+     */
+    const QVector<Tiled::SharedTileset> &tilesets() const { return mTilesets; }
+    void setTilesets(const QVector<Tiled::SharedTileset> &tilesets);
+    bool canKeepRegions(const QVector<Tiled::SharedTileset> &tilesets) const;
+
+    const QHash<QPoint, Entry> &entries() const { return mEntries; }
+    void addEntry(QPoint chunkPos, Entry entry);
+    void replaceRegion(QPoint region, const QVector<StoredChunk> &written);
+
+    void closeFile();
+
+    bool readChunk(QPoint chunkPos, Tiled::Chunk &chunk) override;
+
+private:
+    QString mDirectory;
+    QVector<Tiled::SharedTileset> mTilesets;
+    QHash<QPoint, Entry> mEntries;
+
+    // The region file that was read from last, kept open for reading its
+    // neighboring chunks
+    QFile mFile;
+    QPoint mFileRegion;
+};
+
+} // namespace Regions
@@ -0,0 +1,321 @@
+/*
+ * Regions Tiled Plugin
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "regionfile.h"
+
+#include "savefile.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QtEndian>
+
+#include <algorithm>
+
+using namespace Tiled;
+
+namespace Regions {
+
+/*
+ * A region file starts with an index of the chunks it contains, followed by
+ * the compressed cells of each chunk:
+ *
+ *   quint32 magic, quint16 version, quint16 chunk size, quint32 chunk count
+ *   for each chunk:
+ *     qint32 x, qint32 y, quint64 offset, quint32 size
+ *     quint16 tileset count, for each: quint16 tileset index, quint32 cells
+ *
+ * Each cell is stored as quint16 tileset index + 1 (0 when empty), quint32
+ * tile ID and quint8 flags, before compression.
+ */
+static constexpr quint32 RegionMagic = 0x544d5247;     // "TMRG"
+static constexpr quint16 RegionVersion = 1;
+static constexpr int CellBytes = 7;
+static constexpr int ChunkCells = REGION_CHUNK_SIZE * REGION_CHUNK_SIZE;
+
+enum CellFlag : quint8 {
+    FlippedHorizontally     = 0x1,
+    FlippedVertically       = 0x2,
+    FlippedAntiDiagonally   = 0x4,
+    RotatedHexagonal120     = 0x8,
+};
+
+/**
+ * Returns the region containing the chunk at \a chunkPos, rounding down also
+ * for negative positions.
+ */
+QPoint regionOf(QPoint chunkPos)
+{
+    auto regionIndex = [] (int chunk) {
+        return chunk >= 0 ? chunk / REGION_SIZE : (chunk + 1) / REGION_SIZE - 1;
+    };
+    return QPoint(regionIndex(chunkPos.x()), regionIndex(chunkPos.y()));
+}
+
+QString regionFileName(const QString &layerDirectory, QPoint region)
+{
+    return QDir(layerDirectory).filePath(QStringLiteral("r.%1.%2.region")
+                                         .arg(region.x()).arg(region.y()));
+}
+
+/**
+ * Parses the region position from a \a fileName as returned by
+ * regionFileName(). Returns whether it was a region file name.
+ */
+bool parseRegionFileName(const QString &fileName, QPoint &region)
+{
+    const QStringList parts = fileName.split(QLatin1Char('.'));
+    if (parts.size() != 4 || parts.at(0) != QLatin1String("r") || parts.at(3) != QLatin1String("region"))
+        return false;
+
+    bool xOk, yOk;
+    region = QPoint(parts.at(1).toInt(&xOk), parts.at(2).toInt(&yOk));
+    return xOk && yOk;
+}
+
+/**
+ * Reads the index at the start of the region file \a fileName, without
+ * reading any cells.
+ */
+bool readRegionIndex(const QString &fileName,
+                     QVector<StoredChunk> &chunks,
+                     QString &error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QCoreApplication::translate("File Errors", "Could not open file for reading.")
+                + QLatin1Char(' ') + fileName;
+        return false;
+    }
+
+    QDataStream in(&file);
+
+    quint32 magic;
+    quint16 version;
+    quint16 chunkSize;
+    quint32 count;
+    in >> magic >> version >> chunkSize >> count;
+
+    if (in.status() != QDataStream::Ok || magic != RegionMagic) {
+        error = QCoreApplication::translate("Regions", "Not a region file: %1").arg(fileName);
+        return false;
+    }
+    if (version > RegionVersion) {
+        error = QCoreApplication::translate("Regions", "Unsupported region file version %1: %2")
+                .arg(version).arg(fileName);
+        return false;
+    }
+    if (chunkSize != REGION_CHUNK_SIZE) {
+        error = QCoreApplication::translate("Regions", "Region file uses chunks of %1 tiles, while %2 tiles are supported: %3")
+                .arg(chunkSize).arg(REGION_CHUNK_SIZE).arg(fileName);
+        return false;
+    }
+
+    chunks.reserve(chunks.size() + static_cast<int>(count));
+
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        StoredChunk chunk;
+        qint32 x, y;
+        quint16 tilesetCount;
+        in >> x >> y >> chunk.offset >> chunk.size >> tilesetCount;
+        chunk.position = QPoint(x, y);
+
+        for (quint16 t = 0; t < tilesetCount; ++t) {
+            quint16 tilesetIndex;
+            quint32 cells;
+            in >> tilesetIndex >> cells;
+            chunk.tilesetCounts.append(qMakePair(int(tilesetIndex), int(cells)));
+        }
+
+        chunks.append(chunk);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        error = QCoreApplication::translate("Regions", "Corrupt region file: %1").arg(fileName);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Reads the cells of a chunk stored at \a offset in \a device into \a chunk,
+ * using \a tilesets to look up the tileset indexes.
+ */
+bool readChunkCells(QIODevice &device,
+                    quint64 offset, quint32 size,
+                    const QVector<SharedTileset> &tilesets,
+                    Chunk &chunk)
+{
+    if (!device.seek(static_cast<qint64>(offset)))
+        return false;
+
+    const QByteArray compressed = device.read(size);
+    if (compressed.size() != static_cast<int>(size))
+        return false;
+
+    const QByteArray data = qUncompress(compressed);
+    if (data.size() != ChunkCells * CellBytes)
+        return false;
+
+    const uchar *cellData = reinterpret_cast<const uchar*>(data.constData());
+
+    for (int index = 0; index < ChunkCells; ++index, cellData += CellBytes) {
+        const quint16 tilesetIndex = qFromBigEndian<quint16>(cellData);
+        if (tilesetIndex == 0)
+            continue;
+        if (tilesetIndex > tilesets.size())
+            return false;
+
+        Cell cell(tilesets.at(tilesetIndex - 1).data(),
+                  static_cast<int>(qFromBigEndian<quint32>(cellData + 2)));
+
+        const quint8 flags = cellData[6];
+        cell.setFlippedHorizontally(flags & FlippedHorizontally);
+        cell.setFlippedVertically(flags & FlippedVertically);
+        cell.setFlippedAntiDiagonally(flags & FlippedAntiDiagonally);
+        cell.setRotatedHexagonal120(flags & RotatedHexagonal120);
+
+        chunk.setCell(index % REGION_CHUNK_SIZE, index / REGION_CHUNK_SIZE, cell);
+    }
+
+    return true;
+}
+
+static bool encodeChunk(const Chunk &chunk,
+                        const QHash<Tileset*, int> &tilesetIndexes,
+                        QByteArray &compressed,
+                        QVector<QPair<int, int>> &tilesetCounts)
+{
+    QByteArray data(ChunkCells * CellBytes, Qt::Uninitialized);
+    uchar *cellData = reinterpret_cast<uchar*>(data.data());
+    QHash<int, int> counts;
+
+    for (int index = 0; index < ChunkCells; ++index, cellData += CellBytes) {
+        const Cell cell = chunk.cellAt(index % REGION_CHUNK_SIZE, index / REGION_CHUNK_SIZE);
+
+        if (cell.isEmpty()) {
+            std::fill(cellData, cellData + CellBytes, 0);
+            continue;
+        }
+
+        const auto tilesetIndex = tilesetIndexes.constFind(cell.tileset());
+        if (tilesetIndex == tilesetIndexes.constEnd())
+            return false;
+
+        quint8 flags = 0;
+        if (cell.flippedHorizontally())
+            flags |= FlippedHorizontally;
+        if (cell.flippedVertically())
+            flags |= FlippedVertically;
+        if (cell.flippedAntiDiagonally())
+            flags |= FlippedAntiDiagonally;
+        if (cell.rotatedHexagonal120())
+            flags |= RotatedHexagonal120;
+
+        qToBigEndian<quint16>(static_cast<quint16>(tilesetIndex.value() + 1), cellData);
+        qToBigEndian<quint32>(static_cast<quint32>(cell.tileId()), cellData + 2);
+        cellData[6] = flags;
+
+        ++counts[tilesetIndex.value()];
+    }
+
+    compressed = qCompress(data);
+
+    tilesetCounts.clear();
+    for (auto it = counts.begin(); it != counts.end(); ++it)
+        tilesetCounts.append(qMakePair(it.key(), it.value()));
+    std::sort(tilesetCounts.begin(), tilesetCounts.end());
+
+    return true;
+}
+
+/**
+ * Writes the given \a chunks to the region file \a fileName, replacing any
+ * existing file. The index of the written file is stored in \a written.
+ */
+bool writeRegion(const QString &fileName,
+                 const QVector<QPair<QPoint, Chunk>> &chunks,
+                 const QHash<Tileset*, int> &tilesetIndexes,
+                 QVector<StoredChunk> &written,
+                 QString &error)
+{
+    QVector<QByteArray> compressedChunks;
+    compressedChunks.reserve(chunks.size());
+    written.clear();
+    written.reserve(chunks.size());
+
+    quint64 headerSize = 4 + 2 + 2 + 4;
+
+    for (const auto &entry : chunks) {
+        StoredChunk stored;
+        stored.position = entry.first;
+
+        QByteArray compressed;
+        if (!encodeChunk(entry.second, tilesetIndexes, compressed, stored.tilesetCounts)) {
+            error = QCoreApplication::translate("Regions", "A tile layer refers to a tileset that is not part of the map.");
+            return false;
+        }
+
+        stored.size = static_cast<quint32>(compressed.size());
+        headerSize += 4 + 4 + 8 + 4 + 2 + stored.tilesetCounts.size() * (2 + 4);
+
+        compressedChunks.append(compressed);
+        written.append(stored);
+    }
+
+    quint64 offset = headerSize;
+    for (StoredChunk &stored : written) {
+        stored.offset = offset;
+        offset += stored.size;
+    }
+
+    SaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        error = QCoreApplication::translate("File Errors", "Could not open file for writing.")
+                + QLatin1Char(' ') + fileName;
+        return false;
+    }
+
+    QDataStream out(file.device());
+    out << RegionMagic << RegionVersion << quint16(REGION_CHUNK_SIZE) << quint32(written.size());
+
+    for (const StoredChunk &stored : std::as_const(written)) {
+        out << qint32(stored.position.x()) << qint32(stored.position.y())
+            << stored.offset << stored.size
+            << quint16(stored.tilesetCounts.size());
+
+        for (const auto &count : stored.tilesetCounts)
+            out << quint16(count.first) << quint32(count.second);
+    }
+
+    for (const QByteArray &compressed : std::as_const(compressedChunks))
+        out.writeRawData(compressed.constData(), compressed.size());
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        error = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Regions
@@ -0,0 +1,81 @@
+/*
+ * Regions Tiled Plugin
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "tilelayer.h"
+
+#include <QHash>
+#include <QPair>
+#include <QPoint>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+namespace Regions {
+
+/**
+ * The number of chunks stored in a region file, horizontally and vertically.
+ */
+constexpr int REGION_SIZE = 32;
+
+/**
+ * The number of tiles in a stored chunk, horizontally and vertically. This is
+ * part of the file format, so that region files don't depend on how Tiled was
+ * built. Chunks are paged in and out as a whole, so they need to match the
+ * chunks of TileLayer.
+ */
+constexpr int REGION_CHUNK_SIZE = 16;
+
+static_assert(REGION_CHUNK_SIZE == Tiled::CHUNK_SIZE,
+              "Region chunks need to match the chunks of TileLayer");
+
+/**
+ * A chunk as stored in a region file.
+ */
+struct StoredChunk
+{
+    QPoint position;        // in chunk coordinates
+    quint64 offset = 0;     // of the compressed cells within the region file
+    quint32 size = 0;       // of the compressed cells
+    QVector<QPair<int, int>> tilesetCounts;     // tileset index, cell count
+};
+
+QPoint regionOf(QPoint chunkPos);
+QString regionFileName(const QString &layerDirectory, QPoint region);
+bool parseRegionFileName(const QString &fileName, QPoint &region);
+
+bool readRegionIndex(const QString &fileName,
+                     QVector<StoredChunk> &chunks,
+                     QString &error);
+
+bool readChunkCells(QIODevice &device,
+                    quint64 offset, quint32 size,
+                    const QVector<Tiled::SharedTileset> &tilesets,
+                    Tiled::Chunk &chunk);
+
+bool writeRegion(const QString &fileName,
+                 const QVector<QPair<QPoint, Tiled::Chunk>> &chunks,
+                 const QHash<Tiled::Tileset*, int> &tilesetIndexes,
+                 QVector<StoredChunk> &written,
+                 QString &error);
+
+} // namespace Regions
@@ -0,0 +1,412 @@
+/*
+ * Regions Tiled Plugin
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "regionsplugin.h"
+
+#include "regionchunkstore.h"
+#include "regionfile.h"
+
+#include "layer.h"
+#include "map.h"
+#include "mapreader.h"
+#include "mapwriter.h"
+#include "savefile.h"
+#include "tilelayer.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+
+using namespace Tiled;
+
+namespace Regions {
+
+static const int IndexVersion = 1;
+
+static QString regionsDirectory(const QString &fileName)
+{
+    const QFileInfo info(fileName);
+    return info.dir().filePath(info.completeBaseName() + QLatin1String(".regions"));
+}
+
+static QString indexFileName(const QString &regionsDirectory)
+{
+    return QDir(regionsDirectory).filePath(QStringLiteral("index.json"));
+}
+
+static bool isSameDirectory(const QString &a, const QString &b)
+{
+    return QDir::cleanPath(QFileInfo(a).absoluteFilePath()) ==
+            QDir::cleanPath(QFileInfo(b).absoluteFilePath());
+}
+
+static bool chunkPositionLessThan(QPoint a, QPoint b)
+{
+    return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
+}
+
+
+RegionsPlugin::RegionsPlugin()
+{
+}
+
+FileFormat::Capabilities RegionsPlugin::capabilities() const
+{
+    return ReadWrite | WritePagedOutChunks;
+}
+
+std::unique_ptr<Map> RegionsPlugin::read(const QString &fileName)
+{
+    MapReader reader;
+    std::unique_ptr<Map> map = reader.readMap(fileName);
+    if (!map) {
+        mError = reader.errorString();
+        return nullptr;
+    }
+
+    const QString directory = regionsDirectory(fileName);
+
+    QFile indexFile(indexFileName(directory));
+    if (!indexFile.open(QIODevice::ReadOnly)) {
+        mError = tr("Could not open file for reading: %1").arg(indexFile.fileName());
+        return nullptr;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(indexFile.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        mError = tr("Error parsing file: %1").arg(parseError.errorString());
+        return nullptr;
+    }
+
+    const QJsonObject index = document.object();
+    if (index.value(QLatin1String("version")).toInt() > IndexVersion) {
+        mError = tr("Unsupported region index version");
+        return nullptr;
+    }
+
+    const int chunkSize = index.value(QLatin1String("chunkSize")).toInt();
+    if (chunkSize != REGION_CHUNK_SIZE) {
+        mError = tr("The map was saved with chunks of %1 tiles, while %2 tiles are supported").arg(chunkSize).arg(REGION_CHUNK_SIZE);
+        return nullptr;
+    }
+
+    map->setInfinite(index.value(QLatin1String("infinite")).toBool(true));
+
+    const QJsonObject layers = index.value(QLatin1String("layers")).toObject();
+    const QVector<SharedTileset> &tilesets = map->tilesets();
+
+    LayerIterator it(map.get(), Layer::TileLayerType);
+    while (auto tileLayer = static_cast<TileLayer*>(it.next())) {
+        const QString layerName = QString::number(tileLayer->id());
+        const QJsonArray regions = layers.value(layerName).toArray();
+        if (regions.isEmpty())
+            continue;
+
+        auto store = std::make_shared<RegionChunkStore>(QDir(directory).filePath(layerName),
+                                                        tilesets);
+        QVector<QPoint> storedChunks;
+        QHash<Tileset*, int> tilesetUseCounts;
+
+        for (const QJsonValue &value : regions) {
+            const QJsonArray position = value.toArray();
+            const QPoint region(position.at(0).toInt(), position.at(1).toInt());
+
+            QVector<StoredChunk> chunks;
+            if (!readRegionIndex(regionFileName(store->directory(), region), chunks, mError))
+                return nullptr;
+
+            for (const StoredChunk &chunk : std::as_const(chunks)) {
+                for (const auto &count : chunk.tilesetCounts) {
+                    if (count.first < 0 || count.first >= tilesets.size()) {
+                        mError = tr("Invalid tileset index in region file: %1").arg(count.first);
+                        return nullptr;
+                    }
+                    tilesetUseCounts[tilesets.at(count.first).data()] += count.second;
+                }
+
+                store->addEntry(chunk.position, { chunk.offset, chunk.size });
+                storedChunks.append(chunk.position);
+            }
+        }
+
+        tileLayer->setChunkStore(std::move(store), storedChunks, tilesetUseCounts);
+    }
+
+    return map;
+}
+
+bool RegionsPlugin::supportsFile(const QString &fileName) const
+{
+    return fileName.endsWith(QLatin1String(".tmr"), Qt::CaseInsensitive);
+}
+
+bool RegionsPlugin::write(const Map *map, const QString &fileName, Options options)
+{
+    const QString directory = regionsDirectory(fileName);
+    if (!QDir().mkpath(directory)) {
+        mError = tr("Could not create directory: %1").arg(directory);
+        return false;
+    }
+
+    const QVector<SharedTileset> &tilesets = map->tilesets();
+    QHash<Tileset*, int> tilesetIndexes;
+    for (int i = 0; i < tilesets.size(); ++i)
+        tilesetIndexes.insert(tilesets.at(i).data(), i);
+
+    QJsonObject layersObject;
+    QSet<QString> layerNames;
+
+    LayerIterator it(map, Layer::TileLayerType);
+    while (auto tileLayer = static_cast<const TileLayer*>(it.next())) {
+        if (tileLayer->id() == 0) {
+            mError = tr("Layer '%1' has no ID").arg(tileLayer->name());
+            return false;
+        }
+
+        const QString layerName = QString::number(tileLayer->id());
+        QVector<QPoint> regions;
+        if (!writeLayer(*tileLayer, QDir(directory).filePath(layerName),
+                        tilesets, tilesetIndexes, regions))
+            return false;
+
+        if (!regions.isEmpty()) {
+            QJsonArray regionsArray;
+            for (const QPoint region : std::as_const(regions))
+                regionsArray.append(QJsonArray { region.x(), region.y() });
+            layersObject.insert(layerName, regionsArray);
+        }
+
+        layerNames.insert(layerName);
+    }
+
+    // Remove the region files of layers that no longer exist
+    const QDir regionsDir(directory);
+    const auto entries = regionsDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &entry : entries) {
+        bool isLayerId;
+        entry.toInt(&isLayerId);
+        if (isLayerId && !layerNames.contains(entry))
+            QDir(regionsDir.filePath(entry)).removeRecursively();
+    }
+
+    // The map itself is saved without the cells of its tile layers. It is
+    // saved as infinite, to avoid writing empty cells for finite maps.
+    std::unique_ptr<Map> mapWithoutCells = map->clone();
+    LayerIterator cloneIt(mapWithoutCells.get(), Layer::TileLayerType);
+    while (auto tileLayer = static_cast<TileLayer*>(cloneIt.next()))
+        tileLayer->clear();
+    mapWithoutCells->setInfinite(true);
+
+    MapWriter writer;
+    writer.setMinimizeOutput(options.testFlag(WriteMinimized));
+    if (!writer.writeMap(mapWithoutCells.get(), fileName)) {
+        mError = writer.errorString();
+        return false;
+    }
+
+    // The index is written last, since it refers to the written regions
+    QJsonObject index;
+    index.insert(QLatin1String("version"), IndexVersion);
+    index.insert(QLatin1String("chunkSize"), REGION_CHUNK_SIZE);
+    index.insert(QLatin1String("regionSize"), REGION_SIZE);
+    index.insert(QLatin1String("infinite"), map->infinite());
+    index.insert(QLatin1String("layers"), layersObject);
+
+    SaveFile indexFile(indexFileName(directory));
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        mError = tr("Could not open file for writing.");
+        return false;
+    }
+
+    const auto format = options.testFlag(WriteMinimized) ? QJsonDocument::Compact
+                                                         : QJsonDocument::Indented;
+    indexFile.device()->write(QJsonDocument(index).toJson(format));
+
+    if (!indexFile.commit()) {
+        mError = indexFile.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Writes the region files of the given tile \a layer.
+ *
+ * When the layer's chunks are stored in the same directory and the stored
+ * tileset indexes remain valid, only the regions with changed chunks are
+ * rewritten. Otherwise all regions are written, reading any paged-out chunks
+ * from their current store.
+ *
+ * The positions of the regions that have chunks are returned in \a regions.
+ */
+bool RegionsPlugin::writeLayer(const TileLayer &layer,
+                               const QString &layerDirectory,
+                               const QVector<SharedTileset> &tilesets,
+                               const QHash<Tileset*, int> &tilesetIndexes,
+                               QVector<QPoint> &regions)
+{
+    auto store = dynamic_cast<RegionChunkStore*>(layer.chunkStore());
+    const bool sameDirectory = store && isSameDirectory(store->directory(), layerDirectory);
+    const bool incremental = sameDirectory && store->canKeepRegions(tilesets);
+    const QSet<QPoint> &pagedOutChunks = layer.pagedOutChunks();
+
+    auto loadedChunk = [&] (QPoint chunkPos) {
+        return layer.findChunk(chunkPos.x() * CHUNK_SIZE, chunkPos.y() * CHUNK_SIZE);
+    };
+
+    QHash<QPoint, QVector<QPoint>> chunksByRegion;
+    QSet<QPoint> changedRegions;
+
+    const auto chunkRects = layer.sortedChunksToWrite(QSize(CHUNK_SIZE, CHUNK_SIZE));
+    for (const QRect &rect : chunkRects) {
+        const QPoint chunkPos(rect.x() >> CHUNK_BITS, rect.y() >> CHUNK_BITS);
+        const QPoint region = regionOf(chunkPos);
+        chunksByRegion[region].append(chunkPos);
+
+        if (incremental && !store->isUnchanged(chunkPos, *loadedChunk(chunkPos)))
+            changedRegions.insert(region);
+    }
+
+    for (const QPoint chunkPos : pagedOutChunks)
+        chunksByRegion[regionOf(chunkPos)].append(chunkPos);
+
+    QList<QPoint> regionsToWrite;
+    if (incremental) {
+        // Regions from which chunks were removed need to be rewritten as well
+        for (auto it = store->entries().cbegin(), end = store->entries().cend(); it != end; ++it) {
+            const QPoint chunkPos = it.key();
+            if (pagedOutChunks.contains(chunkPos))
+                continue;
+
+            const Chunk *chunk = loadedChunk(chunkPos);
+            if (!chunk || chunk->isEmpty())
+                changedRegions.insert(regionOf(chunkPos));
+        }
+        regionsToWrite = changedRegions.values();
+    } else {
+        regionsToWrite = chunksByRegion.keys();
+    }
+
+    // Rewriting a region would lose its chunks that could not be loaded
+    for (const QPoint chunkPos : layer.failedChunks()) {
+        if (regionsToWrite.contains(regionOf(chunkPos))) {
+            mError = tr("Chunk %1,%2 of layer '%3' could not be loaded, so its region can't be saved")
+                    .arg(chunkPos.x()).arg(chunkPos.y()).arg(layer.name());
+            return false;
+        }
+    }
+
+    if (!regionsToWrite.isEmpty() && !QDir().mkpath(layerDirectory)) {
+        mError = tr("Could not create directory: %1").arg(layerDirectory);
+        return false;
+    }
+
+    for (const QPoint region : std::as_const(regionsToWrite)) {
+        const QString fileName = regionFileName(layerDirectory, region);
+        QVector<QPoint> chunkPositions = chunksByRegion.value(region);
+
+        if (chunkPositions.isEmpty()) {
+            QFile::remove(fileName);
+            store->replaceRegion(region, {});
+            continue;
+        }
+
+        std::sort(chunkPositions.begin(), chunkPositions.end(), chunkPositionLessThan);
+
+        QVector<QPair<QPoint, Chunk>> chunks;
+        chunks.reserve(chunkPositions.size());
+
+        for (const QPoint chunkPos : std::as_const(chunkPositions)) {
+            if (!pagedOutChunks.contains(chunkPos)) {
+                chunks.append(qMakePair(chunkPos, *loadedChunk(chunkPos)));
+                continue;
+            }
+
+            Chunk chunk;
+            if (!store || !store->readChunk(chunkPos, chunk)) {
+                mError = tr("Could not read chunk %1,%2 of layer '%3'")
+                        .arg(chunkPos.x()).arg(chunkPos.y()).arg(layer.name());
+                return false;
+            }
+            chunks.append(qMakePair(chunkPos, chunk));
+        }
+
+        // The region file may be replaced, so it can't remain open
+        if (store)
+            store->closeFile();
+
+        QVector<StoredChunk> written;
+        if (!writeRegion(fileName, chunks, tilesetIndexes, written, mError))
+            return false;
+
+        if (sameDirectory) {
+            store->replaceRegion(region, written);
+            for (const auto &entry : std::as_const(chunks))
+                if (!pagedOutChunks.contains(entry.first))
+                    store->setUnchanged(entry.first, entry.second);
+        }
+    }
+
+    // A full write removes any region files that are no longer used
+    if (!incremental) {
+        const auto fileNames = QDir(layerDirectory).entryList(QDir::Files);
+        for (const QString &name : fileNames) {
+            QPoint region;
+            if (parseRegionFileName(name, region) && !chunksByRegion.contains(region)) {
+                QFile::remove(QDir(layerDirectory).filePath(name));
+                if (sameDirectory)
+                    store->replaceRegion(region, {});
+            }
+        }
+    }
+
+    if (sameDirectory)
+        store->setTilesets(tilesets);
+
+    regions.clear();
+    for (auto it = chunksByRegion.cbegin(), end = chunksByRegion.cend(); it != end; ++it)
+        regions.append(it.key());
+    std::sort(regions.begin(), regions.end(), chunkPositionLessThan);
+
+    return true;
+}
+
+QString RegionsPlugin::nameFilter() const
+{
+    return tr("Tiled region map files (*.tmr)");
+}
+
+QString RegionsPlugin::shortName() const
+{
+    return QStringLiteral("regions");
+}
+
+QString RegionsPlugin::errorString() const
+{
+    return mError;
+}
+
+} // namespace Regions
@@ -0,0 +1,76 @@
+/*
+ * Regions Tiled Plugin
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "regions_global.h"
+
+#include "mapformat.h"
+
+#include <QObject>
+#include <QPoint>
+#include <QVector>
+
+namespace Tiled {
+class TileLayer;
+}
+
+namespace Regions {
+
+/**
+ * A map format for huge maps, which stores the cells of the tile layers in
+ * region files next to the map. The stored chunks are paged in on demand,
+ * and saving only rewrites the region files with changed chunks.
+ *
+ * The map itself is saved in TMX format, without the cells of its tile
+ * layers. For a map "world.tmr", the region files are stored in the
+ * "world.regions" directory, which has an "index.json" file listing the
+ * regions of each tile layer and a sub-directory for each tile layer.
+ */
+class REGIONSSHARED_EXPORT RegionsPlugin : public Tiled::MapFormat
+{
+    Q_OBJECT
+    Q_INTERFACES(Tiled::MapFormat)
+    Q_PLUGIN_METADATA(IID "org.mapeditor.MapFormat" FILE "plugin.json")
+
+public:
+    RegionsPlugin();
+
+    Capabilities capabilities() const override;
+
+    std::unique_ptr<Tiled::Map> read(const QString &fileName) override;
+    bool supportsFile(const QString &fileName) const override;
+
+    bool write(const Tiled::Map *map, const QString &fileName, Options options) override;
+    QString nameFilter() const override;
+    QString shortName() const override;
+    QString errorString() const override;
+
+private:
+    bool writeLayer(const Tiled::TileLayer &layer,
+                    const QString &layerDirectory,
+                    const QVector<Tiled::SharedTileset> &tilesets,
+                    const QHash<Tiled::Tileset*, int> &tilesetIndexes,
+                    QVector<QPoint> &regions);
+
+    QString mError;
+};
+
+} // namespace Regions
@@ -65,17 +65,12 @@ std::unique_ptr<Tiled::Map> RpMapPlugin::read(const QString &fileName)
             return nullptr;
         }
         const KArchiveFile *f = static_cast<const KArchiveFile *>(e);
-        QByteArray arr(f->data());
-        //qDebug() << arr; // the file contents
-
-        // To avoid reading everything into memory in one go, we can use createDevice() instead
-#if 0
-        QIODevice *dev = f->createDevice();
-        while (!dev->atEnd()) {
-            qDebug() << dev->readLine();
-        }
-        delete dev;
-#endif
+
+        // Inflate the contents while reading, rather than reading
+        // everything into memory in one go
+        std::unique_ptr<QIODevice> dev(f->createDevice());
+        QXmlStreamReader reader(dev.get());
+        // ...
     }
     return nullptr;
 }
@@ -101,6 +96,62 @@ QString RpMapPlugin::errorString() const
     return mError;
 }
 
+namespace {
+
+/**
+ * Forwards everything written to it to the file currently being written to
+ * the given archive, so that the file doesn't need to be held in memory.
+ */
+class ArchiveFileDevice : public QIODevice
+{
+public:
+    explicit ArchiveFileDevice(KArchive &archive)
+        : mArchive(archive)
+    {
+        open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+    }
+
+protected:
+    qint64 readData(char *, qint64) override { return -1; }
+
+    qint64 writeData(const char *data, qint64 len) override
+    {
+        // Writing no data would finish the compression stream
+        if (len == 0)
+            return 0;
+        return mArchive.writeData(data, len) ? len : -1;
+    }
+
+private:
+    KArchive &mArchive;
+};
+
+} // anonymous namespace
+
+/**
+ * Writes a file to the \a archive using the given \a writeContents
+ * function, compressing the XML while it is being written.
+ */
+template<typename WriteContents>
+static bool writeXmlFile(KArchive &archive, const QString &name, WriteContents writeContents)
+{
+    if (!archive.prepareWriting(name, QString(), QString(), 0))
+        return false;
+
+    ArchiveFileDevice device(archive);
+    QXmlStreamWriter writer(&device);
+    writer.setAutoFormatting(true);
+    writer.setAutoFormattingIndent(1);
+    writer.writeStartDocument();
+    writeContents(writer);
+    writer.writeEndDocument();
+
+    if (writer.hasError())
+        return false;
+
+    return archive.finishWriting(device.pos());
+}
+
 static void writeEntry(QXmlStreamWriter &writer, QString const &key, QString const& value)
 {
     writer.writeStartElement(QStringLiteral("entry"));
@@ -414,37 +465,36 @@ bool RpMapPlugin::write(const Tiled::Map *map, const QString &fileName, Options
 
     Q_UNUSED(options)
     KZip archive(fileName);
-    if (archive.open(QIODevice::WriteOnly))
-    {
-        {
-            QByteArray properties;
-            QXmlStreamWriter writer(&properties);
-            writer.setAutoFormatting(true);
-            writer.setAutoFormattingIndent(1);
-            writer.writeStartDocument();
-            writer.writeStartElement(QStringLiteral("map"));
-            writeEntry(writer, QStringLiteral("campaignVersion"), QStringLiteral("1.4.1"));
-            writeEntry(writer, QStringLiteral("version"), QStringLiteral("1.7.0"));
-            writer.writeEndElement();
-            writer.writeEndDocument();
-            archive.writeFile(QStringLiteral("properties.xml"), properties);
-        }
-        {
-            QByteArray content;
-            QXmlStreamWriter writer(&content);
-            writer.setAutoFormatting(true);
-            writer.setAutoFormattingIndent(1);
-            writer.writeStartDocument();
-            writer.writeStartElement(QStringLiteral("net.rptools.maptool.util.PersistenceUtil_-PersistedMap"));
-            writeMap(writer, map);
-            writer.writeEndElement(); // PersistedMap
-            writer.writeEndDocument();
-            archive.writeFile(QStringLiteral("content.xml"), content);
-        }
+    if (!archive.open(QIODevice::WriteOnly)) {
+        mError = archive.errorString();
+        return false;
+    }
+
+    const bool written =
+            writeXmlFile(archive, QStringLiteral("properties.xml"), [] (QXmlStreamWriter &writer) {
+                writer.writeStartElement(QStringLiteral("map"));
+                writeEntry(writer, QStringLiteral("campaignVersion"), QStringLiteral("1.4.1"));
+                writeEntry(writer, QStringLiteral("version"), QStringLiteral("1.7.0"));
+                writer.writeEndElement();
+            }) &&
+            writeXmlFile(archive, QStringLiteral("content.xml"), [&] (QXmlStreamWriter &writer) {
+                writer.writeStartElement(QStringLiteral("net.rptools.maptool.util.PersistenceUtil_-PersistedMap"));
+                writeMap(writer, map);
+                writer.writeEndElement(); // PersistedMap
+            });
+
+    if (!written) {
+        mError = archive.errorString();
         archive.close();
-        return true;
+        return false;
     }
-    return false;
+
+    if (!archive.close()) {
+        mError = archive.errorString();
+        return false;
+    }
+
+    return true;
 }
 
 } // namespace RpMap
@@ -25,7 +25,9 @@
 
 #include "Map.hpp"
 
+#include <cstring>
 #include <fstream>
+#include <iterator>
 #include <stdexcept>
 #include <QDebug>
 
@@ -33,16 +35,83 @@
 
 namespace tbin
 {
+    /**
+     * Decodes values from a block of memory, like a memory-mapped file,
+     * throwing when reading past its end.
+     */
+    class Reader
+    {
+        public:
+            Reader( const char* data, std::size_t size )
+                : m_pos( data )
+                , m_end( data + size )
+            {
+            }
+
+            const char* take( std::size_t size )
+            {
+                if ( static_cast< std::size_t >( m_end - m_pos ) < size )
+                {
+                    throw std::invalid_argument( QT_TRANSLATE_NOOP("TbinMapFormat", "Unexpected end of file.") );
+                }
+
+                const char* data = m_pos;
+                m_pos += size;
+                return data;
+            }
+
+        private:
+            const char* m_pos;
+            const char* m_end;
+    };
+
+    /**
+     * Collects written values in a buffer, which is written to the stream
+     * in large blocks.
+     */
+    class Writer
+    {
+        public:
+            explicit Writer( Writer& out )
+                : m_out( out )
+            {
+                m_buffer.reserve( BufferSize );
+            }
+
+            void write( const char* data, std::size_t size )
+            {
+                if ( m_buffer.size() + size > BufferSize )
+                    flush();
+
+                if ( size >= BufferSize )
+                    m_out.write( data, static_cast< std::streamsize >( size ) );
+                else
+                    m_buffer.insert( m_buffer.end(), data, data + size );
+            }
+
+            void flush()
+            {
+                m_out.write( m_buffer.data(), static_cast< std::streamsize >( m_buffer.size() ) );
+                m_buffer.clear();
+            }
+
+        private:
+            static constexpr std::size_t BufferSize = 64 * 1024;
+
+            std::ostream& m_out;
+            std::vector< char > m_buffer;
+    };
+
     template< typename T >
-    T read( std::istream& in )
+    T read( Reader& in )
     {
         T t;
-        in.read( reinterpret_cast< char* >( &t ), sizeof( T ) );
+        std::memcpy( &t, in.take( sizeof( T ) ), sizeof( T ) );
         return t;
     }
 
     template<>
-    sf::Vector2i read< sf::Vector2i >( std::istream& in )
+    sf::Vector2i read< sf::Vector2i >( Reader& in )
     {
         sf::Int32 x = read< sf::Int32 >( in );
         sf::Int32 y = read< sf::Int32 >( in );
@@ -50,35 +119,38 @@ namespace tbin
     }
 
     template<>
-    std::string read< std::string >( std::istream& in )
+    std::string read< std::string >( Reader& in )
     {
         auto len = read< sf::Int32 >( in );
-        std::string str( len, 0 );
-        in.read( &str[ 0 ], len );
-        return str;
+        if ( len < 0 )
+        {
+            throw std::invalid_argument( QT_TRANSLATE_NOOP("TbinMapFormat", "Bad string length") );
+        }
+
+        return std::string( in.take( static_cast< std::size_t >( len ) ), static_cast< std::size_t >( len ) );
     }
 
     template< typename T >
-    void write( std::ostream& out, const T& t )
+    void write( Writer& out, const T& t )
     {
         out.write( reinterpret_cast< const char* >( &t ), sizeof( T ) );
     }
 
     template<>
-    void write< sf::Vector2i >( std::ostream& out, const sf::Vector2i& vec )
+    void write< sf::Vector2i >( Writer& out, const sf::Vector2i& vec )
     {
         write< sf::Int32 >( out, vec.x );
         write< sf::Int32 >( out, vec.y );
     }
 
     template<>
-    void write< std::string >( std::ostream& out, const std::string& str )
+    void write< std::string >( Writer& out, const std::string& str )
     {
         write< sf::Int32 >( out, str.length() );
-        out.write( &str[ 0 ], str.length() );
+        out.write( str.data(), str.length() );
     }
 
-    Properties readProperties( std::istream& in )
+    Properties readProperties( Reader& in )
     {
         Properties ret;
 
@@ -106,7 +178,7 @@ namespace tbin
         return ret;
     }
 
-    void writeProperties( std::ostream& out, const Properties& props )
+    void writeProperties( Writer& out, const Properties& props )
     {
         write< sf::Int32 >( out, props.size() );
         for ( const auto& prop : props )
@@ -124,7 +196,7 @@ namespace tbin
         }
     }
 
-    TileSheet readTilesheet( std::istream& in )
+    TileSheet readTilesheet( Reader& in )
     {
         TileSheet ret;
         ret.id = read< std::string >( in );
@@ -138,7 +210,7 @@ namespace tbin
         return ret;
     }
 
-    void writeTilesheet( std::ostream& out, const TileSheet& ts )
+    void writeTilesheet( Writer& out, const TileSheet& ts )
     {
         write( out, ts.id );
         write( out, ts.desc );
@@ -150,7 +222,7 @@ namespace tbin
         writeProperties( out, ts.props );
     }
 
-    Tile readStaticTile( std::istream& in, const std::string& currTilesheet )
+    Tile readStaticTile( Reader& in, const std::string& currTilesheet )
     {
         Tile ret;
         ret.tilesheet = currTilesheet;
@@ -160,14 +232,14 @@ namespace tbin
         return ret;
     }
 
-    void writeStaticTile( std::ostream& out, const Tile& tile )
+    void writeStaticTile( Writer& out, const Tile& tile )
     {
         write( out, tile.staticData.tileIndex );
         write( out, tile.staticData.blendMode );
         writeProperties( out, tile.props );
     }
 
-    Tile readAnimatedTile( std::istream& in )
+    Tile readAnimatedTile( Reader& in )
     {
         Tile ret;
         ret.animatedData.frameInterval = read< sf::Int32 >( in );
@@ -177,7 +249,7 @@ namespace tbin
         std::string currTilesheet;
         for ( int i = 0; i < frameCount; )
         {
-            char c = in.get();
+            char c = read< char >( in );
             switch ( c )
             {
                 case 'T':
@@ -197,7 +269,7 @@ namespace tbin
         return ret;
     }
 
-    void writeAnimatedTile( std::ostream& out, const Tile& tile )
+    void writeAnimatedTile( Writer& out, const Tile& tile )
     {
         write( out, tile.animatedData.frameInterval );
         write< sf::Int32 >( out, tile.animatedData.frames.size() );
@@ -219,7 +291,7 @@ namespace tbin
         writeProperties( out, tile.props );
     }
 
-    Layer readLayer( std::istream& in )
+    Layer readLayer( Reader& in )
     {
         Layer ret;
         ret.id = read< std::string >( in );
@@ -229,6 +301,11 @@ namespace tbin
         ret.tileSize = read< sf::Vector2i >( in );
         ret.props = readProperties( in );
 
+        if ( ret.layerSize.x < 0 || ret.layerSize.y < 0 )
+        {
+            throw std::invalid_argument( QT_TRANSLATE_NOOP("TbinMapFormat", "Bad layer size") );
+        }
+
         Tile nullTile;
         nullTile.staticData.tileIndex = -1;
         ret.tiles.resize( static_cast<size_t>(ret.layerSize.x) * ret.layerSize.y, nullTile );
@@ -265,7 +342,7 @@ namespace tbin
         return ret;
     }
 
-    void writeLayer( std::ostream& out, const Layer& layer )
+    void writeLayer( Writer& out, const Layer& layer )
     {
         write( out, layer.id );
         write< sf::Uint8 >( out, layer.visible ? 1 : 0 );
@@ -339,9 +416,17 @@ namespace tbin
     {
         in.exceptions( std::ifstream::failbit );
 
-        std::string magic( 6, '\0' );
-        in.read( &magic[ 0 ], 6 );
-        if ( magic != MAGIC_1_0 )
+        const std::string data( ( std::istreambuf_iterator< char >( in ) ),
+                                std::istreambuf_iterator< char >() );
+
+        return loadFromMemory( data.data(), data.size() );
+    }
+
+    bool Map::loadFromMemory( const char* data, std::size_t size )
+    {
+        Reader in( data, size );
+
+        if ( size < 6 || std::memcmp( in.take( 6 ), MAGIC_1_0, 6 ) != 0 )
         {
             throw std::runtime_error( QT_TRANSLATE_NOOP("TbinMapFormat", "File is not a tbin file.") );
         }
@@ -384,10 +469,11 @@ namespace tbin
         return saveToStream( file );
     }
 
-    bool Map::saveToStream( std::ostream& out ) const
+    bool Map::saveToStream( std::ostream& stream ) const
     {
-        out.exceptions( std::ifstream::failbit );
+        stream.exceptions( std::ifstream::failbit );
 
+        Writer out( stream );
         out.write( MAGIC_1_0, 6 );
 
         write( out, id );
@@ -402,6 +488,8 @@ namespace tbin
         for ( const Layer& layer : layers )
             writeLayer( out, layer );
 
+        out.flush();
+
         return true;
     }
 }
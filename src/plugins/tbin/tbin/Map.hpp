@@ -42,6 +42,7 @@ namespace tbin
         public:
             bool loadFromFile( const std::string& path );
             bool loadFromStream( std::istream& in );
+            bool loadFromMemory( const char* data, std::size_t size );
             
             bool saveToFile( const std::string& path ) const;
             bool saveToStream( std::ostream& out ) const;
@@ -33,6 +33,8 @@
 
 #include <QCoreApplication>
 #include <QDir>
+#include <QFile>
+#include <QHash>
 #include <QStringView>
 
 #include <cmath>
@@ -131,17 +133,27 @@ TbinMapFormat::TbinMapFormat(QObject *)
 
 std::unique_ptr<Tiled::Map> TbinMapFormat::read(const QString &fileName)
 {
-    std::ifstream file( fileName.toStdString(), std::ios::in | std::ios::binary );
-    if (!file) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
         mError = QCoreApplication::translate("File Errors", "Could not open file for reading.");
         return nullptr;
     }
 
+    // Decode straight from the memory-mapped file when possible
+    const qint64 size = file.size();
+    QByteArray contents;
+    const char *data = reinterpret_cast<const char*>(file.map(0, size));
+    if (!data) {
+        contents = file.readAll();
+        data = contents.constData();
+    }
+
     tbin::Map tmap;
     std::unique_ptr<Tiled::Map> map;
     try
     {
-        tmap.loadFromStream(file);
+        tmap.loadFromMemory(data, static_cast<std::size_t>(size));
+        file.close();
 
         if (tmap.layers.empty())
             throw std::invalid_argument(QT_TR_NOOP("Map contains no layers."));
@@ -160,10 +172,8 @@ std::unique_ptr<Tiled::Map> TbinMapFormat::read(const QString &fileName)
 
         const QDir fileDir(QFileInfo(fileName).dir());
 
-        std::map< std::string, int > tmapTilesheetMapping;
-        for (std::size_t i = 0; i < tmap.tilesheets.size(); ++i) {
-            const tbin::TileSheet& ttilesheet = tmap.tilesheets[i];
-            tmapTilesheetMapping[ttilesheet.id] = static_cast<int>(i);
+        std::map< std::string, Tiled::Tileset* > tmapTilesheetMapping;
+        for (const tbin::TileSheet& ttilesheet : tmap.tilesheets) {
 
             if (ttilesheet.spacing.x != ttilesheet.spacing.y)
                 throw std::invalid_argument(QT_TR_NOOP("Tilesheet must have equal spacings."));
@@ -194,8 +204,26 @@ std::unique_ptr<Tiled::Map> TbinMapFormat::read(const QString &fileName)
                 // (In tIDE, right click a tilesheet and choose "Auto Tiles..."
             }
 
+            tmapTilesheetMapping[ttilesheet.id] = tileset.data();
             map->addTileset(tileset);
         }
+
+        // Tiles usually refer to the same tilesheet as the previous tile, so
+        // the last lookup is remembered
+        const std::string *lastTilesheetName = nullptr;
+        Tiled::Tileset *lastTilesheet = nullptr;
+        auto tilesheetFor = [&] (const std::string &name) {
+            if (!lastTilesheetName || *lastTilesheetName != name) {
+                auto it = tmapTilesheetMapping.find(name);
+                if (it == tmapTilesheetMapping.end())
+                    throw std::invalid_argument(QT_TR_NOOP("Tile refers to unknown tilesheet."));
+
+                lastTilesheetName = &it->first;
+                lastTilesheet = it->second;
+            }
+            return lastTilesheet;
+        };
+
         for (const tbin::Layer& tlayer : tmap.layers) {
             if (tlayer.tileSize.x != firstLayer.tileSize.x || tlayer.tileSize.y != firstLayer.tileSize.y)
                 throw std::invalid_argument(QT_TR_NOOP("Different tile sizes per layer are not supported."));
@@ -213,8 +241,8 @@ std::unique_ptr<Tiled::Map> TbinMapFormat::read(const QString &fileName)
 
                 Tiled::Cell cell;
                 if (ttile.animatedData.frames.size() > 0) {
-                    tbin::Tile tfirstTile = ttile.animatedData.frames[0];
-                    Tiled::Tile* firstTile = map->tilesetAt(tmapTilesheetMapping[tfirstTile.tilesheet])->findOrCreateTile(tfirstTile.staticData.tileIndex);
+                    const tbin::Tile &tfirstTile = ttile.animatedData.frames[0];
+                    Tiled::Tile* firstTile = tilesheetFor(tfirstTile.tilesheet)->findOrCreateTile(tfirstTile.staticData.tileIndex);
                     QVector<Tiled::Frame> frames;
                     for (const tbin::Tile& tframe : ttile.animatedData.frames) {
                         if (tframe.isNullTile() || tframe.animatedData.frames.size() > 0 ||
@@ -230,7 +258,7 @@ std::unique_ptr<Tiled::Map> TbinMapFormat::read(const QString &fileName)
                     cell = Tiled::Cell(firstTile);
                 }
                 else {
-                    cell = Tiled::Cell(map->tilesetAt(tmapTilesheetMapping[ttile.tilesheet]).data(), ttile.staticData.tileIndex);
+                    cell = Tiled::Cell(tilesheetFor(ttile.tilesheet), ttile.staticData.tileIndex);
                 }
                 layer->setCell(ix, iy, cell);
 
@@ -296,6 +324,11 @@ bool TbinMapFormat::write(const Tiled::Map *map, const QString &fileName, Option
             tmap.tilesheets.push_back(std::move(ttilesheet));
         }
 
+        // The tilesheet of each tile is stored by name
+        QHash<const Tiled::Tileset*, std::string> tilesheetNames;
+        for (const Tiled::SharedTileset &tileset : map->tilesets())
+            tilesheetNames.insert(tileset.data(), tileset->name().toStdString());
+
         std::vector< Tiled::ObjectGroup* > objGroups;
         std::map< std::string, tbin::Layer* > tileLayerIdMap;
         tmap.layers.reserve(static_cast<std::size_t>(map->layers().size()));
@@ -310,6 +343,7 @@ bool TbinMapFormat::write(const Tiled::Map *map, const QString &fileName, Option
                 tlayer.layerSize.y = layer->height();
                 tlayer.tileSize.x = map->tileWidth();
                 tlayer.tileSize.y = map->tileHeight();
+                tlayer.tiles.reserve(static_cast<std::size_t>(tlayer.layerSize.x) * tlayer.layerSize.y);
                 //tlayer.visible = ???;
                 for (int iy = 0; iy < tlayer.layerSize.y; ++iy) {
                     for (int ix = 0; ix < tlayer.layerSize.x; ++ix) {
@@ -323,7 +357,7 @@ bool TbinMapFormat::write(const Tiled::Map *map, const QString &fileName, Option
                         }
 
                         if (Tiled::Tile *tile = cell.tile()) {
-                            ttile.tilesheet = tile->tileset()->name().toStdString();
+                            ttile.tilesheet = tilesheetNames.value(tile->tileset());
                             if (tile->frames().size() == 0) {
                                 ttile.staticData.tileIndex = tile->id();
                                 ttile.staticData.blendMode = 0;
@@ -345,7 +379,7 @@ bool TbinMapFormat::write(const Tiled::Map *map, const QString &fileName, Option
                                 }
                             }
                         }
-                        tlayer.tiles.push_back(ttile);
+                        tlayer.tiles.push_back(std::move(ttile));
                     }
                 }
                 tiledToTbinProperties(layer->properties(), tlayer.props, fileDir);
@@ -34,7 +34,9 @@
 #include <QFileInfo>
 #include <QMap>
 #include <QRegularExpression>
+#include <QtConcurrent>
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <stdexcept>
@@ -855,6 +857,185 @@ static void writeTileset(const Map *map, QFileDevice *device, bool isExternal, A
 }
 
 
+// A problem found while encoding the tile data of a layer, which is reported
+// afterwards since the encoding happens on worker threads
+struct CellIssue
+{
+    enum Kind {
+        ReservedAnimationTile,
+        RotatedHexagonal120,
+    };
+
+    Kind kind;
+    QPoint pos;
+    const Tile *tile;
+};
+
+// What is needed about each tileset for encoding tile data, looked up in
+// advance so that layers can be encoded in parallel
+struct TilesetEncoding
+{
+    const TilesetInfo *info = nullptr;
+    bool exportAlternates = false;
+};
+
+struct EncodedTileData
+{
+    QByteArray data;
+    QVector<CellIssue> issues;
+};
+
+// Formats the given integer, ending just before 'end', and returns a pointer
+// to its first character
+static char *formatInt(char *end, int value)
+{
+    unsigned v = value < 0 ? 0u - unsigned(value) : unsigned(value);
+    do {
+        *--end = char('0' + v % 10);
+        v /= 10;
+    } while (v);
+    if (value < 0)
+        *--end = '-';
+    return end;
+}
+
+static void appendUInt16(char *out, quint16 value)
+{
+    out[0] = char(value & 0xFF);
+    out[1] = char(value >> 8);
+}
+
+// Encodes the cells of a tile layer, either as the contents of the
+// PackedInt32Array used by the TileMap node, or as the binary tile_map_data
+// used by the TileMapLayer node.
+//
+// Tile packing format of the PackedInt32Array:
+// DestLocation, SrcX, SrcY
+// Where:
+//   DestLocation = (DestX >= 0 ? DestY : DestY + 1) * 65536 + DestX
+//   SrcX         = SrcX * 65536 + TileSetId
+//   SrcY         = SrcY + 65536 * (AlternateId | FLIP_H | FLIP_V | TRANSPOSE)
+//
+// The binary format starts with a 16-bit format version (0), followed by
+// 12 bytes per cell: X, Y, SourceId, SrcX, SrcY and AlternateId, each as a
+// little-endian 16-bit integer.
+static EncodedTileData encodeTileData(const TileLayer *layer,
+                                      const QHash<const Tileset*, TilesetEncoding> &tilesets,
+                                      bool binary)
+{
+    EncodedTileData result;
+    QByteArray &data = result.data;
+    qsizetype used = 0;
+
+    if (binary) {
+        data.resize(2);
+        appendUInt16(data.data(), 0);
+        used = 2;
+    }
+
+    const Tileset *lastTileset = nullptr;
+    const TilesetInfo *tilesetInfo = nullptr;
+    bool exportAlternates = false;
+    int columnCount = 1;
+    bool first = true;
+
+    const auto bounds = layer->bounds();
+    for (int y = bounds.y(); y < bounds.y() + bounds.height(); ++y) {
+        for (int x = bounds.x(); x < bounds.x() + bounds.width(); ++x) {
+            const Cell &cell = layer->cellAt(x, y);
+            if (cell.isEmpty())
+                continue;
+
+            if (cell.tileset() != lastTileset) {
+                lastTileset = cell.tileset();
+                const TilesetEncoding encoding = tilesets.value(lastTileset);
+                tilesetInfo = encoding.info;
+                exportAlternates = encoding.exportAlternates;
+                columnCount = std::max(1, lastTileset->columnCount());
+            }
+
+            if (tilesetInfo->reservedAnimationTiles.contains(cell.tileId()))
+                result.issues.append({ CellIssue::ReservedAnimationTile, QPoint(x, y), cell.tile() });
+            if (cell.rotatedHexagonal120())
+                result.issues.append({ CellIssue::RotatedHexagonal120, QPoint(x, y), cell.tile() });
+
+            int alt = 0;
+            if (cell.flippedHorizontally())
+                alt |= FlippedH;
+            if (cell.flippedVertically())
+                alt |= FlippedV;
+            if (cell.flippedAntiDiagonally())
+                alt |= Transposed;
+            // exportAlternate Deprecation Note: Remove this if block
+            if (alt && !exportAlternates)
+                alt <<= 12;
+
+            const int atlasX = cell.tileId() % columnCount;
+            const int atlasY = cell.tileId() / columnCount;
+
+            // Make sure there is room for the largest possible entry
+            if (data.size() - used < 64)
+                data.resize(std::max<qsizetype>(data.size() * 2, 4096));
+
+            char *out = data.data() + used;
+
+            if (binary) {
+                appendUInt16(out, quint16(qint16(x)));
+                appendUInt16(out + 2, quint16(qint16(y)));
+                appendUInt16(out + 4, quint16(tilesetInfo->atlasId));
+                appendUInt16(out + 6, quint16(atlasX));
+                appendUInt16(out + 8, quint16(atlasY));
+                appendUInt16(out + 10, quint16(alt));
+                out += 12;
+            } else {
+                const int values[3] = {
+                    (x >= 0 ? y : y + 1) * 65536 + x,
+                    atlasX * 65536 + tilesetInfo->atlasId,
+                    atlasY + alt * 65536,
+                };
+
+                for (int value : values) {
+                    if (!first) {
+                        *out++ = ',';
+                        *out++ = ' ';
+                    }
+                    first = false;
+
+                    char buffer[16];
+                    char * const end = buffer + sizeof(buffer);
+                    const char *begin = formatInt(end, value);
+                    out = std::copy(begin, static_cast<const char*>(end), out);
+                }
+            }
+
+            used = out - data.constData();
+        }
+    }
+
+    data.truncate(used);
+    return result;
+}
+
+static void reportIssues(const Map *map, const TileLayer *layer,
+                         const QVector<CellIssue> &issues)
+{
+    for (const CellIssue &issue : issues) {
+        switch (issue.kind) {
+        case CellIssue::ReservedAnimationTile:
+            Tiled::ERROR(TscnPlugin::tr("Cannot use tile %1 from tileset %2 because it is "
+                                        "reserved as an animation frame.")
+                                     .arg(issue.tile->id())
+                                     .arg(issue.tile->tileset()->name()),
+                         Tiled::SelectTile { issue.tile });
+            break;
+        case CellIssue::RotatedHexagonal120:
+            Tiled::ERROR(TscnPlugin::tr("Hex tiles that are rotated by 120° degrees are not supported."),
+                         Tiled::JumpToTile { map, issue.pos, layer });
+            break;
+        }
+    }
+}
+
 bool TscnPlugin::write(const Map *map, const QString &fileName, Options options)
 {
     Q_UNUSED(options)
@@ -881,8 +1062,14 @@ bool TscnPlugin::write(const Map *map, const QString &fileName, Options options)
         // And an extra load step per object resource
         loadSteps += assetInfo.objectIds.size();
 
+        // Godot 4.3 replaced the TileMap node with a TileMapLayer node per
+        // layer, storing its cells as binary data. Writing this data as base64
+        // requires format 4.
+        const bool tileMapLayers = map->resolvedProperty("exportTileMapLayers").toBool();
+
         // gdscene node
-        device->write(formatByteString("[gd_scene load_steps=%1 format=3]\n\n", loadSteps));
+        device->write(formatByteString("[gd_scene load_steps=%1 format=%2]\n\n",
+                                       loadSteps, tileMapLayers ? 4 : 3));
 
         writeExtObjects(device, assetInfo);
 
@@ -925,100 +1112,108 @@ bool TscnPlugin::write(const Map *map, const QString &fileName, Options options)
         device->write(formatByteString("[node name=\"%1\" type=\"Node2D\"]\n\n",
             sanitizeQuotedString(fi.baseName())));
 
-        // TileMap node
-        device->write("[node name=\"TileMap\" type=\"TileMap\" parent=\".\"]\n");
+        // Encode the tile data of all layers in parallel
+        QHash<const Tileset*, TilesetEncoding> tilesetEncodings;
+        for (const auto layer : std::as_const(assetInfo.layers)) {
+            const auto usedTilesets = layer->usedTilesets();
+            for (const SharedTileset &tileset : usedTilesets) {
+                if (tilesetEncodings.contains(tileset.data()))
+                    continue;
 
-        if (tilesetResPath.isEmpty())
-            device->write("tile_set = SubResource(\"TileSet_0\")\n");
-        else
-            device->write("tile_set = ExtResource(\"TileSet_0\")\n");
+                const auto resPath = imageSourceToRes(tileset.data(), assetInfo.resRoot);
+                TilesetEncoding &encoding = tilesetEncodings[tileset.data()];
+                encoding.info = &assetInfo.tilesetInfo[resPath];
+                encoding.exportAlternates = tileset->resolvedProperty("exportAlternates").toBool();
+            }
+        }
 
-        device->write("format = 2\n");
+        struct LayerJob
+        {
+            const TileLayer *layer;
+            EncodedTileData encoded;
+        };
 
-        // Tile packing format:
-        // DestLocation, SrcX, SrcY
-        // Where:
-        //   DestLocation = (DestX >= 0 ? DestY : DestY + 1) * 65536 + DestX
-        //   SrcX         = SrcX * 65536 + TileSetId
-        //   SrcY         = SrcY + 65536 * (AlternateId | FLIP_H | FLIP_V | TRANSPOSE)
-        int layerIndex = 0;
-        for (const auto layer : std::as_const(assetInfo.layers)) {
-            device->write(formatByteString("layer_%1/name = \"%2\"\n",
-                                           layerIndex,
-                                           sanitizeQuotedString(layer->name())));
+        QVector<LayerJob> jobs;
+        jobs.reserve(assetInfo.layers.size());
+        for (const auto layer : std::as_const(assetInfo.layers))
+            jobs.append({ layer, {} });
 
-            if (layer->resolvedProperty("ySortEnabled").isValid()) {
-                device->write(formatByteString("layer_%1/y_sort_enabled = true\n",
-                                               layerIndex));
-            }
+        QtConcurrent::blockingMap(jobs, [&] (LayerJob &job) {
+            job.encoded = encodeTileData(job.layer, tilesetEncodings, tileMapLayers);
+        });
 
-            if (layer->resolvedProperty("zIndex").isValid()) {
-                device->write(formatByteString("layer_%1/z_index = %2\n",
-                                               layerIndex,
-                                               layer->resolvedProperty("zIndex").toInt()));
-            }
+        for (const LayerJob &job : std::as_const(jobs))
+            reportIssues(map, job.layer, job.encoded.issues);
 
-            device->write(formatByteString("layer_%1/tile_data = PackedInt32Array(",
-                                           layerIndex));
-
-            bool first = true;
-            auto bounds = layer->bounds();
-            for (int y = bounds.y(); y < bounds.y() + bounds.height(); ++y) {
-                for (int x = bounds.x(); x < bounds.x() + bounds.width(); ++x) {
-                    auto& cell = layer->cellAt(x, y);
-
-                    if (!cell.isEmpty()) {
-                        auto resPath = imageSourceToRes(cell.tile()->tileset(), assetInfo.resRoot);
-                        auto& tilesetInfo = assetInfo.tilesetInfo[resPath];
-
-                        if (tilesetInfo.reservedAnimationTiles.contains(cell.tileId())) {
-                            Tiled::ERROR(TscnPlugin::tr("Cannot use tile %1 from tileset %2 because it is "
-                                                        "reserved as an animation frame.")
-                                                     .arg(cell.tileId())
-                                                     .arg(cell.tileset()->name()),
-                                         Tiled::SelectTile { cell.tile() });
-                        }
+        const QByteArray tileSetReference = tilesetResPath.isEmpty() ? QByteArray("SubResource(\"TileSet_0\")")
+                                                                     : QByteArray("ExtResource(\"TileSet_0\")");
 
-                        int alt = 0;
-                        if (cell.rotatedHexagonal120()) {
-                            Tiled::ERROR(TscnPlugin::tr("Hex tiles that are rotated by 120° degrees are not supported."),
-                                         Tiled::JumpToTile { map, QPoint(x, y), layer });
-                        }
-                        if (cell.flippedHorizontally())
-                            alt |= FlippedH;
-                        if (cell.flippedVertically())
-                            alt |= FlippedV;
-                        if (cell.flippedAntiDiagonally())
-                            alt |= Transposed;
-                        // exportAlternate Deprecation Note: Remove this if block
-                        if (alt && !cell.tileset()->resolvedProperty("exportAlternates").toBool()) {
-                            alt <<= 12;
-                        }
+        if (tileMapLayers) {
+            // One TileMapLayer node per layer
+            QSet<QString> usedNames;
 
-                        int destLocation = (x >= 0 ? y : y + 1) * 65536 + x;
-                        int srcX = cell.tileId() % cell.tileset()->columnCount();
-                        srcX *= 65536;
-                        srcX += tilesetInfo.atlasId;
-                        int srcY = cell.tileId() / cell.tileset()->columnCount();
-                        srcY += alt * 65536;     
+            for (const LayerJob &job : std::as_const(jobs)) {
+                const TileLayer *layer = job.layer;
 
-                        if (!first)
-                            device->write(", ");
+                // Node names need to be unique among siblings
+                QString name = layer->name();
+                if (name.isEmpty())
+                    name = QStringLiteral("TileMapLayer");
+                for (int i = 2; usedNames.contains(name); ++i)
+                    name = layer->name() + QString::number(i);
+                usedNames.insert(name);
 
-                        device->write(formatByteString("%1, %2, %3",
-                                                       destLocation, srcX, srcY));
+                device->write(formatByteString("[node name=\"%1\" type=\"TileMapLayer\" parent=\".\"]\n",
+                                               sanitizeQuotedString(name)));
 
-                        first = false;
-                    }
+                if (layer->resolvedProperty("ySortEnabled").isValid())
+                    device->write("y_sort_enabled = true\n");
+
+                if (layer->resolvedProperty("zIndex").isValid()) {
+                    device->write(formatByteString("z_index = %1\n",
+                                                   layer->resolvedProperty("zIndex").toInt()));
                 }
+
+                device->write("tile_map_data = PackedByteArray(\"");
+                device->write(job.encoded.data.toBase64());
+                device->write("\")\n");
+                device->write("tile_set = " + tileSetReference + "\n\n");
             }
+        } else {
+            // TileMap node
+            device->write("[node name=\"TileMap\" type=\"TileMap\" parent=\".\"]\n");
+            device->write("tile_set = " + tileSetReference + "\n");
+            device->write("format = 2\n");
 
-            device->write(")\n");
+            int layerIndex = 0;
+            for (const LayerJob &job : std::as_const(jobs)) {
+                const TileLayer *layer = job.layer;
 
-            layerIndex++;
-        }
+                device->write(formatByteString("layer_%1/name = \"%2\"\n",
+                                               layerIndex,
+                                               sanitizeQuotedString(layer->name())));
 
-        device->write("\n");
+                if (layer->resolvedProperty("ySortEnabled").isValid()) {
+                    device->write(formatByteString("layer_%1/y_sort_enabled = true\n",
+                                                   layerIndex));
+                }
+
+                if (layer->resolvedProperty("zIndex").isValid()) {
+                    device->write(formatByteString("layer_%1/z_index = %2\n",
+                                                   layerIndex,
+                                                   layer->resolvedProperty("zIndex").toInt()));
+                }
+
+                device->write(formatByteString("layer_%1/tile_data = PackedInt32Array(",
+                                               layerIndex));
+                device->write(job.encoded.data);
+                device->write(")\n");
+
+                layerIndex++;
+            }
+
+            device->write("\n");
+        }
                     
         // Object scene nodes
         for (const MapObject *object : assetInfo.objects) {
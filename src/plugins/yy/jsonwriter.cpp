@@ -33,6 +33,21 @@ JsonWriter::JsonWriter(QIODevice *device)
 {
 }
 
+/**
+ * Creates a writer that continues at the current scope of the \a parent
+ * writer, as if it was starting a new line there. This allows parts of a
+ * document to be written in parallel and then written to the parent using
+ * writeUnquotedValue().
+ */
+JsonWriter::JsonWriter(QIODevice *device, const JsonWriter &parent)
+    : m_device(device)
+    , m_scopes(parent.m_scopes)
+    , m_valueSeparator(parent.m_valueSeparator)
+    , m_suppressNewlines(parent.m_suppressNewlines)
+    , m_minimize(parent.m_minimize)
+{
+}
+
 void JsonWriter::writeEndDocument()
 {
     Q_ASSERT(m_scopes.isEmpty());
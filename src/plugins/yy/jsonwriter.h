@@ -44,6 +44,7 @@ class JsonWriter
 
 public:
     JsonWriter(QIODevice *device);
+    JsonWriter(QIODevice *device, const JsonWriter &parent);
 
     void writeEndDocument();
 
@@ -32,11 +32,14 @@
 #include "tile.h"
 #include "tilelayer.h"
 
+#include <QBuffer>
 #include <QCoreApplication>
 #include <QDir>
 #include <QDirIterator>
 #include <QFileInfo>
+#include <QLocale>
 #include <QRegularExpression>
+#include <QtConcurrent>
 
 #include <vector>
 
@@ -134,15 +137,65 @@ static const char *resourceTypeTagValue(ResourceType type)
     return "";
 }
 
-static QJsonValue idValue(const QString &id, const QString &scope)
+static QString idPath(const QString &id, const QString &scope)
+{
+    return QStringLiteral("%1/%2/%2.yy").arg(scope, id);
+}
+
+static void writeNameAndPath(JsonWriter &json,
+                             const QString &name, const QString &path)
+{
+    json.writeStartObject();
+    json.writeMember("name", name);
+    json.writeMember("path", path);
+    json.writeEndObject();
+}
+
+static void writeNameAndPath(JsonWriter &json, const char *key,
+                             const QString &name, const QString &path)
+{
+    json.writeStartObject(key);
+    json.writeMember("name", name);
+    json.writeMember("path", path);
+    json.writeEndObject();
+}
+
+static void writeIdMember(JsonWriter &json, const char *key,
+                          const QString &id, const QString &scope)
 {
     if (id.isEmpty())
-        return QJsonValue(QJsonValue::Null);
+        json.writeUnquotedMember(key, "null");
+    else
+        writeNameAndPath(json, key, id, idPath(id, scope));
+}
 
-    return QJsonObject {
-        { "name", id },
-        { "path", QStringLiteral("%1/%2/%2.yy").arg(scope, id) }
-    };
+/**
+ * Writes an array of objects, calling \a writeElement for each of the
+ * \a elements.
+ */
+template<typename Container, typename WriteElement>
+static void writeObjectArray(JsonWriter &json, const char *key,
+                             const Container &elements,
+                             WriteElement writeElement)
+{
+    json.writeStartArray(key);
+    for (const auto &element : elements) {
+        json.prepareNewLine(true);
+        writeElement(element);
+    }
+    json.writeEndArray(!elements.empty());
+}
+
+static void writeEmptyArray(JsonWriter &json, const char *key)
+{
+    json.writeStartArray(key);
+    json.writeEndArray();
+}
+
+// Numbers are written as doubles, since that's what GameMaker does
+static void writeNumber(JsonWriter &json, const char *key, double value)
+{
+    json.writeMember(key, value);
 }
 
 static unsigned colorToAbgr(const QColor &color)
@@ -175,61 +228,91 @@ struct GMRView
     int vspeed = -1;
     QString objectId;
 
-    QJsonObject toJson() const;
+    void write(JsonWriter &json) const;
 };
 
-QJsonObject GMRView::toJson() const
-{
-    return {
-        { "inherit", inherit },
-        { "visible", visible },
-        { "xview", xview },
-        { "yview", yview },
-        { "wview", wview },
-        { "hview", hview },
-        { "xport", xport },
-        { "yport", yport },
-        { "wport", wport },
-        { "hport", hport },
-        { "hborder", hborder },
-        { "vborder", vborder },
-        { "hspeed", hspeed },
-        { "vspeed", vspeed },
-        { "objectId", idValue(objectId, QStringLiteral("objects")) }
-    };
+void GMRView::write(JsonWriter &json) const
+{
+    json.writeStartObject();
+    writeNumber(json, "hborder", hborder);
+    writeNumber(json, "hport", hport);
+    writeNumber(json, "hspeed", hspeed);
+    writeNumber(json, "hview", hview);
+    json.writeMember("inherit", inherit);
+    writeIdMember(json, "objectId", objectId, QStringLiteral("objects"));
+    writeNumber(json, "vborder", vborder);
+    json.writeMember("visible", visible);
+    writeNumber(json, "vspeed", vspeed);
+    writeNumber(json, "wport", wport);
+    writeNumber(json, "wview", wview);
+    writeNumber(json, "xport", xport);
+    writeNumber(json, "xview", xview);
+    writeNumber(json, "yport", yport);
+    writeNumber(json, "yview", yview);
+    json.writeEndObject();
 }
 
 
+/**
+ * Base of all resources written to the .yy file.
+ *
+ * GameMaker expects the members of each object sorted case-insensitively.
+ * Since the members of the base resource end up in between those of the
+ * derived resources, each resource writes all its members itself, using the
+ * helper functions of this class for the common ones.
+ */
 struct GMResource
 {
     GMResource(ResourceType type) : resourceType(type) {}
     virtual ~GMResource() = default;
 
-    virtual QJsonObject toJson() const;
+    virtual void write(JsonWriter &json) const = 0;
 
     QString resourceVersion = QStringLiteral("2.0");
     QString name;
     QStringList tags;
     ResourceType resourceType;
+
+protected:
+    void writeStart(JsonWriter &json) const;
+    void writeName(JsonWriter &json) const;
+    void writeResourceTypeAndVersion(JsonWriter &json) const;
+    void writeTags(JsonWriter &json) const;
 };
 
-QJsonObject GMResource::toJson() const
+// Starts the object and writes the "$<type>" and "%Name" members, which are
+// always sorted first
+void GMResource::writeStart(JsonWriter &json) const
 {
-    QJsonObject json;
+    json.writeStartObject();
 
-    const char *type = resourceTypeStr(resourceType);
+    const QByteArray typeKey = QByteArray("$") + resourceTypeStr(resourceType);
+    json.writeMember(typeKey.constData(), resourceTypeTagValue(resourceType));
+    json.writeMember("%Name", name);
+}
 
-    json[QByteArray("$") + type] = resourceTypeTagValue(resourceType);
-    json["%Name"] = name;
-    json["resourceVersion"] = resourceVersion;
-    json["name"] = name;
+void GMResource::writeName(JsonWriter &json) const
+{
+    json.writeMember("name", name);
+}
 
-    if (!tags.isEmpty())
-        json["tags"] = QJsonArray::fromStringList(tags);
+void GMResource::writeResourceTypeAndVersion(JsonWriter &json) const
+{
+    json.writeMember("resourceType", resourceTypeStr(resourceType));
+    json.writeMember("resourceVersion", resourceVersion);
+}
 
-    json["resourceType"] = type;
+void GMResource::writeTags(JsonWriter &json) const
+{
+    if (tags.isEmpty())
+        return;
 
-    return json;
+    json.writeStartArray("tags");
+    for (const QString &tag : tags) {
+        json.prepareNewLine();
+        json.writeValue(tag);
+    }
+    json.writeEndArray();
 }
 
 
@@ -239,7 +322,7 @@ struct GMRGraphic final : GMResource
         : GMResource(isSprite ? GMRSpriteGraphicType : GMRGraphicType)
     {}
 
-    QJsonObject toJson() const override;
+    void write(JsonWriter &json) const override;
 
     QString spriteId;
 
@@ -274,45 +357,54 @@ struct GMRGraphic final : GMResource
     double y = 0.0;
 };
 
-QJsonObject GMRGraphic::toJson() const
+void GMRGraphic::write(JsonWriter &json) const
 {
-    QJsonObject json = GMResource::toJson();
+    const bool isSprite = resourceType == GMRSpriteGraphicType;
 
-    json["spriteId"] = idValue(spriteId, QStringLiteral("sprites"));
+    writeStart(json);
 
-    if (resourceType == GMRSpriteGraphicType) {
-        json["headPosition"] = headPosition;
-        json["rotation"] = rotation;
-        json["scaleX"] = scaleX;
-        json["scaleY"] = scaleY;
-        json["animationSpeed"] = animationSpeed;
-    } else {
-        json["w"] = w;
-        json["h"] = h;
-        json["u0"] = u0;
-        json["v0"] = v0;
-        json["u1"] = u1;
-        json["v1"] = v1;
-    }
+    if (isSprite)
+        writeNumber(json, "animationSpeed", animationSpeed);
 
-    json["colour"] = colorToAbgrF(colour);
+    writeNumber(json, "colour", colorToAbgrF(colour));
+    json.writeMember("frozen", frozen);
 
-    if (inheritedItemId.isEmpty()) {
-        json["inheritedItemId"] = QJsonValue(QJsonValue::Null);
-    } else {
-        json["inheritedItemId"] = QJsonObject {
-            { "name", inheritedItemId },
-            { "path", inheritedItemPath }
-        };
+    if (isSprite)
+        writeNumber(json, "headPosition", headPosition);
+    else
+        writeNumber(json, "h", h);
+
+    json.writeMember("ignore", ignore);
+
+    if (inheritedItemId.isEmpty())
+        json.writeUnquotedMember("inheritedItemId", "null");
+    else
+        writeNameAndPath(json, "inheritedItemId", inheritedItemId, inheritedItemPath);
+
+    json.writeMember("inheritItemSettings", inheritItemSettings);
+    writeName(json);
+    writeResourceTypeAndVersion(json);
+
+    if (isSprite) {
+        writeNumber(json, "rotation", rotation);
+        writeNumber(json, "scaleX", scaleX);
+        writeNumber(json, "scaleY", scaleY);
     }
 
-    json["frozen"] = frozen;
-    json["ignore"] = ignore;
-    json["inheritItemSettings"] = inheritItemSettings;
-    json["x"] = x;
-    json["y"] = y;
+    writeIdMember(json, "spriteId", spriteId, QStringLiteral("sprites"));
+    writeTags(json);
 
-    return json;
+    if (!isSprite) {
+        writeNumber(json, "u0", u0);
+        writeNumber(json, "u1", u1);
+        writeNumber(json, "v0", v0);
+        writeNumber(json, "v1", v1);
+        writeNumber(json, "w", w);
+    }
+
+    writeNumber(json, "x", x);
+    writeNumber(json, "y", y);
+    json.writeEndObject();
 }
 
 
@@ -320,25 +412,23 @@ struct GMOverriddenProperty final : GMResource
 {
     GMOverriddenProperty() : GMResource(GMOverriddenPropertyType) {}
 
-    QJsonObject toJson() const override;
+    void write(JsonWriter &json) const override;
 
     QString propertyId;
     QString objectId;
     QString value;
 };
 
-QJsonObject GMOverriddenProperty::toJson() const
+void GMOverriddenProperty::write(JsonWriter &json) const
 {
-    QJsonObject json = GMResource::toJson();
-
-    json["propertyId"] = QJsonObject {
-        { "name", propertyId },
-        { "path", QStringLiteral("%1/%2/%2.yy").arg(QStringLiteral("objects"), objectId) }
-    };
-    json["objectId"] = idValue(objectId, QStringLiteral("objects"));
-    json["value"] = value;
-
-    return json;
+    writeStart(json);
+    writeName(json);
+    writeIdMember(json, "objectId", objectId, QStringLiteral("objects"));
+    writeNameAndPath(json, "propertyId", propertyId, idPath(objectId, QStringLiteral("objects")));
+    writeResourceTypeAndVersion(json);
+    writeTags(json);
+    json.writeMember("value", value);
+    json.writeEndObject();
 }
 
 
@@ -346,7 +436,7 @@ struct GMRInstance final : GMResource
 {
     GMRInstance() : GMResource(GMRInstanceType) {}
 
-    QJsonObject toJson() const override;
+    void write(JsonWriter &json) const override;
 
     std::vector<GMOverriddenProperty> properties;
     bool isDnd = false;
@@ -368,44 +458,37 @@ struct GMRInstance final : GMResource
     double y = 0.0;
 };
 
-QJsonObject GMRInstance::toJson() const
+void GMRInstance::write(JsonWriter &json) const
 {
-    QJsonObject json = GMResource::toJson();
-
-    QJsonArray propertiesJson;
-    for (const GMOverriddenProperty &prop : properties)
-        propertiesJson.append(prop.toJson());
-    json["properties"] = propertiesJson;
-
-    json["isDnd"] = isDnd;
-
-    json["objectId"] = idValue(objectId, QStringLiteral("objects"));
-
-    json["inheritCode"] = inheritCode;
-    json["hasCreationCode"] = hasCreationCode;
-    json["colour"] = colorToAbgrF(colour);
-    json["rotation"] = rotation;
-    json["scaleX"] = scaleX;
-    json["scaleY"] = scaleY;
-    json["imageIndex"] = imageIndex;
-    json["imageSpeed"] = imageSpeed;
-
-    if (inheritedItemId.isEmpty()) {
-        json["inheritedItemId"] = QJsonValue(QJsonValue::Null);
-    } else {
-        json["inheritedItemId"] = QJsonObject {
-            { "name", inheritedItemId },
-            { "path", inheritedItemPath }
-        };
-    }
-
-    json["frozen"] = frozen;
-    json["ignore"] = ignore;
-    json["inheritItemSettings"] = inheritItemSettings;
-    json["x"] = x;
-    json["y"] = y;
-
-    return json;
+    writeStart(json);
+    writeNumber(json, "colour", colorToAbgrF(colour));
+    json.writeMember("frozen", frozen);
+    json.writeMember("hasCreationCode", hasCreationCode);
+    json.writeMember("ignore", ignore);
+    writeNumber(json, "imageIndex", imageIndex);
+    writeNumber(json, "imageSpeed", imageSpeed);
+    json.writeMember("inheritCode", inheritCode);
+
+    if (inheritedItemId.isEmpty())
+        json.writeUnquotedMember("inheritedItemId", "null");
+    else
+        writeNameAndPath(json, "inheritedItemId", inheritedItemId, inheritedItemPath);
+
+    json.writeMember("inheritItemSettings", inheritItemSettings);
+    json.writeMember("isDnd", isDnd);
+    writeName(json);
+    writeIdMember(json, "objectId", objectId, QStringLiteral("objects"));
+    writeObjectArray(json, "properties", properties, [&] (const GMOverriddenProperty &prop) {
+        prop.write(json);
+    });
+    writeResourceTypeAndVersion(json);
+    writeNumber(json, "rotation", rotation);
+    writeNumber(json, "scaleX", scaleX);
+    writeNumber(json, "scaleY", scaleY);
+    writeTags(json);
+    writeNumber(json, "x", x);
+    writeNumber(json, "y", y);
+    json.writeEndObject();
 }
 
 
@@ -413,7 +496,7 @@ struct GMPath final : GMResource
 {
     GMPath() : GMResource(GMPathType) {}
 
-    QJsonObject toJson() const override;
+    void write(JsonWriter &json) const override;
 
     int kind = 0;
     bool closed = false;
@@ -421,13 +504,12 @@ struct GMPath final : GMResource
     QVector<QPointF> points;
 };
 
-QJsonObject GMPath::toJson() const
+void GMPath::write(JsonWriter &json) const
 {
-    QJsonObject json = GMResource::toJson();
-
-    json["kind"] = kind;
-    json["closed"] = closed;
-    json["precision"] = precision;
+    writeStart(json);
+    json.writeMember("closed", closed);
+    writeNumber(json, "kind", kind);
+    writeName(json);
 
     // todo:
     // "parent":{
@@ -435,26 +517,31 @@ QJsonObject GMPath::toJson() const
     //   "path":"folders/Rooms.yy",
     // },
 
-    QJsonArray pointsJson;
-    for (const QPointF &point : points) {
-        pointsJson.append(QJsonObject {
-                              { "speed", 100.0 },
-                              { "x", point.x() },
-                              { "y", point.y() }
-                          });
-    }
-
-    json["points"] = pointsJson;
-
-    return json;
+    writeObjectArray(json, "points", points, [&] (const QPointF &point) {
+        json.writeStartObject();
+        writeNumber(json, "speed", 100.0);
+        writeNumber(json, "x", point.x());
+        writeNumber(json, "y", point.y());
+        json.writeEndObject();
+    });
+
+    writeNumber(json, "precision", precision);
+    writeResourceTypeAndVersion(json);
+    writeTags(json);
+    json.writeEndObject();
 }
 
 
+/**
+ * A layer, which also serves as the base of the more specific layers. Its
+ * members are written in several runs, between which the more specific
+ * layers write their own members.
+ */
 struct GMRLayer : GMResource
 {
     GMRLayer(ResourceType type = GMRLayerType) : GMResource(type) {}
 
-    QJsonObject toJson() const override;
+    void write(JsonWriter &json) const override;
 
     bool visible = true;
     int depth = 0;
@@ -465,33 +552,63 @@ struct GMRLayer : GMResource
     int gridY = 32;
     std::vector<std::unique_ptr<GMRLayer>> layers;
     bool hierarchyFrozen = false;
+
+protected:
+    void writeDepthToHierarchyFrozen(JsonWriter &json) const;
+    void writeInheritLayerDepthToInheritVisibility(JsonWriter &json) const;
+    void writeLayersAndName(JsonWriter &json) const;
+    void writeProperties(JsonWriter &json) const;
+    void writeUserdefinedDepthAndVisible(JsonWriter &json) const;
 };
 
-QJsonObject GMRLayer::toJson() const
+void GMRLayer::write(JsonWriter &json) const
 {
-    QJsonObject json = GMResource::toJson();
+    writeStart(json);
+    writeDepthToHierarchyFrozen(json);
+    writeInheritLayerDepthToInheritVisibility(json);
+    writeLayersAndName(json);
+    writeProperties(json);
+    writeResourceTypeAndVersion(json);
+    writeTags(json);
+    writeUserdefinedDepthAndVisible(json);
+    json.writeEndObject();
+}
 
-    json["visible"] = visible;
-    json["depth"] = depth;
-    json["userdefinedDepth"] = userdefinedDepth;
-    json["inheritLayerDepth"] = inheritLayerDepth;
-    json["inheritLayerSettings"] = inheritLayerSettings;
-    json["inheritSubLayers"] = true;
-    json["inheritVisibility"] = true;
-    json["gridX"] = gridX;
-    json["gridY"] = gridY;
-    json["effectEnabled"] = true;
-    json["effectType"] = QJsonValue(QJsonValue::Null);
+void GMRLayer::writeDepthToHierarchyFrozen(JsonWriter &json) const
+{
+    writeNumber(json, "depth", depth);
+    json.writeMember("effectEnabled", true);
+    json.writeUnquotedMember("effectType", "null");
+    writeNumber(json, "gridX", gridX);
+    writeNumber(json, "gridY", gridY);
+    json.writeMember("hierarchyFrozen", hierarchyFrozen);
+}
 
-    QJsonArray layersJson;
-    for (const std::unique_ptr<GMRLayer> &layer : layers)
-        layersJson.append(layer->toJson());
+void GMRLayer::writeInheritLayerDepthToInheritVisibility(JsonWriter &json) const
+{
+    json.writeMember("inheritLayerDepth", inheritLayerDepth);
+    json.writeMember("inheritLayerSettings", inheritLayerSettings);
+    json.writeMember("inheritSubLayers", true);
+    json.writeMember("inheritVisibility", true);
+}
 
-    json["layers"] = layersJson;
-    json["hierarchyFrozen"] = hierarchyFrozen;
-    json["properties"] = QJsonArray();
+void GMRLayer::writeLayersAndName(JsonWriter &json) const
+{
+    writeObjectArray(json, "layers", layers, [&] (const std::unique_ptr<GMRLayer> &layer) {
+        layer->write(json);
+    });
+    writeName(json);
+}
 
-    return json;
+void GMRLayer::writeProperties(JsonWriter &json) const
+{
+    writeEmptyArray(json, "properties");
+}
+
+void GMRLayer::writeUserdefinedDepthAndVisible(JsonWriter &json) const
+{
+    json.writeMember("userdefinedDepth", userdefinedDepth);
+    json.writeMember("visible", visible);
 }
 
 
@@ -499,7 +616,7 @@ struct GMRTileLayer final : GMRLayer
 {
     GMRTileLayer() : GMRLayer(GMRTileLayerType) {}
 
-    QJsonObject toJson() const override;
+    void write(JsonWriter &json) const override;
 
     QString tilesetId;
     int x = 0;
@@ -509,25 +626,45 @@ struct GMRTileLayer final : GMRLayer
     std::vector<unsigned> tiles;
 };
 
-QJsonObject GMRTileLayer::toJson() const
+void GMRTileLayer::write(JsonWriter &json) const
 {
-    QJsonObject json = GMRLayer::toJson();
-
-    json["tilesetId"] = idValue(tilesetId, QStringLiteral("tilesets"));
-    json["x"] = x;
-    json["y"] = y;
-
-    QJsonArray tilesJson;
-    for (size_t index = 0; index < tiles.size(); ++index)
-        tilesJson.append((double) tiles.at(index));
+    writeStart(json);
+    writeDepthToHierarchyFrozen(json);
+    writeInheritLayerDepthToInheritVisibility(json);
+    writeLayersAndName(json);
+    writeProperties(json);
+    writeResourceTypeAndVersion(json);
+    writeTags(json);
+
+    json.writeStartObject("tiles");
+    writeNumber(json, "SerialiseHeight", SerialiseHeight);
+    writeNumber(json, "SerialiseWidth", SerialiseWidth);
+    json.writeStartArray("TileSerialiseData");
+
+    // Most layers use only few different values, so remember how they were
+    // formatted
+    QHash<unsigned, QByteArray> formattedTiles;
+
+    for (size_t index = 0; index < tiles.size(); ++index) {
+        // Start a new line for each row of tiles
+        json.prepareNewLine(SerialiseWidth > 0 && index % SerialiseWidth == 0);
+
+        const unsigned tile = tiles[index];
+        auto it = formattedTiles.find(tile);
+        if (it == formattedTiles.end())
+            it = formattedTiles.insert(tile, QByteArray::number(double(tile), 'g', QLocale::FloatingPointShortest));
+
+        json.writeUnquotedValue(it.value());
+    }
 
-    json["tiles"] = QJsonObject {
-        { "SerialiseWidth", SerialiseWidth },
-        { "SerialiseHeight", SerialiseHeight },
-        { "TileSerialiseData", tilesJson }
-    };
+    json.writeEndArray(SerialiseWidth > 0);
+    json.writeEndObject();
 
-    return json;
+    writeIdMember(json, "tilesetId", tilesetId, QStringLiteral("tilesets"));
+    writeUserdefinedDepthAndVisible(json);
+    writeNumber(json, "x", x);
+    writeNumber(json, "y", y);
+    json.writeEndObject();
 }
 
 
@@ -535,22 +672,25 @@ struct GMRAssetLayer final : GMRLayer
 {
     GMRAssetLayer() : GMRLayer(GMRAssetLayerType) {}
 
-    QJsonObject toJson() const override;
+    void write(JsonWriter &json) const override;
 
     std::vector<GMRGraphic> assets;
 };
 
-QJsonObject GMRAssetLayer::toJson() const
+void GMRAssetLayer::write(JsonWriter &json) const
 {
-    QJsonObject json = GMRLayer::toJson();
-
-    QJsonArray assetsJson;
-    for (const auto &asset : assets)
-        assetsJson.append(asset.toJson());
-
-    json["assets"] = assetsJson;
-
-    return json;
+    writeStart(json);
+    writeObjectArray(json, "assets", assets, [&] (const GMRGraphic &asset) {
+        asset.write(json);
+    });
+    writeDepthToHierarchyFrozen(json);
+    writeInheritLayerDepthToInheritVisibility(json);
+    writeLayersAndName(json);
+    writeProperties(json);
+    writeResourceTypeAndVersion(json);
+    writeTags(json);
+    writeUserdefinedDepthAndVisible(json);
+    json.writeEndObject();
 }
 
 
@@ -558,22 +698,25 @@ struct GMRInstanceLayer final : GMRLayer
 {
     GMRInstanceLayer() : GMRLayer(GMRInstanceLayerType) {}
 
-    QJsonObject toJson() const override;
+    void write(JsonWriter &json) const override;
 
     std::vector<GMRInstance> instances;
 };
 
-QJsonObject GMRInstanceLayer::toJson() const
+void GMRInstanceLayer::write(JsonWriter &json) const
 {
-    QJsonObject json = GMRLayer::toJson();
-
-    QJsonArray instancesJson;
-    for (const auto &instance : instances)
-        instancesJson.append(instance.toJson());
-
-    json["instances"] = instancesJson;
-
-    return json;
+    writeStart(json);
+    writeDepthToHierarchyFrozen(json);
+    writeInheritLayerDepthToInheritVisibility(json);
+    writeObjectArray(json, "instances", instances, [&] (const GMRInstance &instance) {
+        instance.write(json);
+    });
+    writeLayersAndName(json);
+    writeProperties(json);
+    writeResourceTypeAndVersion(json);
+    writeTags(json);
+    writeUserdefinedDepthAndVisible(json);
+    json.writeEndObject();
 }
 
 
@@ -581,20 +724,25 @@ struct GMRPathLayer final : GMRLayer
 {
     GMRPathLayer() : GMRLayer(GMRPathLayerType) {}
 
-    QJsonObject toJson() const;
+    void write(JsonWriter &json) const override;
 
     QString pathId;
     QColor colour = Qt::red;
 };
 
-QJsonObject GMRPathLayer::toJson() const
+void GMRPathLayer::write(JsonWriter &json) const
 {
-    QJsonObject json = GMRLayer::toJson();
-
-    json["pathId"] = idValue(pathId, QStringLiteral("paths"));
-    json["colour"] = colorToAbgrF(colour);
-
-    return json;
+    writeStart(json);
+    writeNumber(json, "colour", colorToAbgrF(colour));
+    writeDepthToHierarchyFrozen(json);
+    writeInheritLayerDepthToInheritVisibility(json);
+    writeLayersAndName(json);
+    writeIdMember(json, "pathId", pathId, QStringLiteral("paths"));
+    writeProperties(json);
+    writeResourceTypeAndVersion(json);
+    writeTags(json);
+    writeUserdefinedDepthAndVisible(json);
+    json.writeEndObject();
 }
 
 
@@ -602,7 +750,7 @@ struct GMRBackgroundLayer final : GMRLayer
 {
     GMRBackgroundLayer() : GMRLayer(GMRBackgroundLayerType) {}
 
-    QJsonObject toJson() const;
+    void write(JsonWriter &json) const override;
 
     QString spriteId;
     QColor colour = Qt::white;
@@ -618,24 +766,29 @@ struct GMRBackgroundLayer final : GMRLayer
     bool userdefinedAnimFPS = false;
 };
 
-QJsonObject GMRBackgroundLayer::toJson() const
+void GMRBackgroundLayer::write(JsonWriter &json) const
 {
-    QJsonObject json = GMRLayer::toJson();
-
-    json["spriteId"] = idValue(spriteId, QStringLiteral("sprites"));
-    json["colour"] = colorToAbgrF(colour);
-    json["x"] = x;
-    json["y"] = y;
-    json["htiled"] = htiled;
-    json["vtiled"] = vtiled;
-    json["hspeed"] = hspeed;
-    json["vspeed"] = vspeed;
-    json["stretch"] = stretch;
-    json["animationFPS"] = animationFPS;
-    json["animationSpeedType"] = animationSpeedType;
-    json["userdefinedAnimFPS"] = userdefinedAnimFPS;
-
-    return json;
+    writeStart(json);
+    writeNumber(json, "animationFPS", animationFPS);
+    writeNumber(json, "animationSpeedType", animationSpeedType);
+    writeNumber(json, "colour", colorToAbgrF(colour));
+    writeDepthToHierarchyFrozen(json);
+    writeNumber(json, "hspeed", hspeed);
+    json.writeMember("htiled", htiled);
+    writeInheritLayerDepthToInheritVisibility(json);
+    writeLayersAndName(json);
+    writeProperties(json);
+    writeResourceTypeAndVersion(json);
+    writeIdMember(json, "spriteId", spriteId, QStringLiteral("sprites"));
+    json.writeMember("stretch", stretch);
+    writeTags(json);
+    json.writeMember("userdefinedAnimFPS", userdefinedAnimFPS);
+    writeUserdefinedDepthAndVisible(json);
+    writeNumber(json, "vspeed", vspeed);
+    json.writeMember("vtiled", vtiled);
+    writeNumber(json, "x", x);
+    writeNumber(json, "y", y);
+    json.writeEndObject();
 }
 
 
@@ -653,7 +806,7 @@ struct GMRoom final : GMResource
 {
     GMRoom() : GMResource(GMRoomType) {}
 
-    QJsonObject toJson() const override;
+    void write(JsonWriter &json) const override;
 
     bool isDnd = false;
     double volume = 1.0;
@@ -691,70 +844,93 @@ struct GMRoom final : GMResource
     QString roomPathInProject;
 };
 
-QJsonObject GMRoom::toJson() const
+/**
+ * Writes the room. The top-level layers are written in parallel, after which
+ * the results are written to the file in order.
+ */
+void GMRoom::write(JsonWriter &json) const
 {
-    QJsonObject json = GMResource::toJson();
+    writeStart(json);
+    json.writeMember("creationCodeFile", creationCodeFile);
+    json.writeMember("inheritCode", inheritCode);
+    json.writeMember("inheritCreationOrder", inheritCreationOrder);
+    json.writeMember("inheritLayers", inheritLayers);
+
+    writeObjectArray(json, "instanceCreationOrder", instanceCreationOrder, [&] (const InstanceCreation &creation) {
+        writeNameAndPath(json, creation.name, roomPathInProject);
+    });
+
+    json.writeMember("isDnd", isDnd);
+
+    // Each top-level layer is written to its own buffer, using a writer that
+    // continues in the scope of the layers array
+    struct LayerJob {
+        const GMRLayer *layer;
+        QByteArray data;
+    };
 
-    json["isDnd"] = isDnd;
-    json["volume"] = volume;
-    json["parentRoom"] = QJsonValue(QJsonValue::Null);  // TODO: Provide a way to set this?
+    std::vector<LayerJob> jobs;
+    jobs.reserve(layers.size());
+    for (const auto &layer : layers)
+        jobs.push_back(LayerJob { layer.get(), QByteArray() });
 
-    QJsonArray viewsJson;
-    for (const GMRView &view : views)
-        viewsJson.append(view.toJson());
+    json.writeStartArray("layers");
 
-    json["views"] = viewsJson;
+    QtConcurrent::blockingMap(jobs, [&json] (LayerJob &job) {
+        QBuffer buffer(&job.data);
+        buffer.open(QIODevice::WriteOnly);
 
-    QJsonArray layersJson;
-    for (const auto &layer : layers)
-        layersJson.append(layer->toJson());
+        JsonWriter layerJson(&buffer, json);
+        job.layer->write(layerJson);
+    });
 
-    json["layers"] = layersJson;
+    for (const LayerJob &job : jobs) {
+        json.prepareNewLine(true);
+        json.writeUnquotedValue(job.data);
+    }
 
-    json["inheritLayers"] = inheritLayers;
-    json["creationCodeFile"] = creationCodeFile;
-    json["inheritCode"] = inheritCode;
+    json.writeEndArray(!jobs.empty());
 
-    QJsonArray instanceCreationOrderJson;
-    for (const InstanceCreation &creation : instanceCreationOrder) {
-        instanceCreationOrderJson.append(QJsonObject {
-            { "name", creation.name },
-            { "path", roomPathInProject }
-        });
-    }
+    writeName(json);
 
-    json["instanceCreationOrder"] = instanceCreationOrderJson;
-    json["inheritCreationOrder"] = inheritCreationOrder;
-    json["sequenceId"] = QJsonValue(QJsonValue::Null);
+    writeNameAndPath(json, "parent", QFileInfo(parent).fileName(),
+                     QStringLiteral("folders/%1.yy").arg(parent));
 
-    json["roomSettings"] = QJsonObject {
-        { "inheritRoomSettings", roomSettings.inheritRoomSettings },
-        { "Width", roomSettings.Width },
-        { "Height", roomSettings.Height },
-        { "persistent", roomSettings.persistent }
-    };
+    json.writeUnquotedMember("parentRoom", "null");    // TODO: Provide a way to set this?
 
-    json["viewSettings"] = QJsonObject {
-        { "inheritViewSettings", viewSettings.inheritViewSettings },
-        { "enableViews", viewSettings.enableViews },
-        { "clearViewBackground", viewSettings.clearViewBackground },
-        { "clearDisplayBuffer", viewSettings.clearDisplayBuffer }
-    };
+    json.writeStartObject("physicsSettings");
+    json.writeMember("inheritPhysicsSettings", physicsSettings.inheritPhysicsSettings);
+    json.writeMember("PhysicsWorld", physicsSettings.PhysicsWorld);
+    writeNumber(json, "PhysicsWorldGravityX", physicsSettings.PhysicsWorldGravityX);
+    writeNumber(json, "PhysicsWorldGravityY", physicsSettings.PhysicsWorldGravityY);
+    writeNumber(json, "PhysicsWorldPixToMetres", physicsSettings.PhysicsWorldPixToMetres);
+    json.writeEndObject();
 
-    json["physicsSettings"] = QJsonObject {
-        { "inheritPhysicsSettings", physicsSettings.inheritPhysicsSettings },
-        { "PhysicsWorld", physicsSettings.PhysicsWorld },
-        { "PhysicsWorldGravityX", physicsSettings.PhysicsWorldGravityX },
-        { "PhysicsWorldGravityY", physicsSettings.PhysicsWorldGravityY },
-        { "PhysicsWorldPixToMetres", physicsSettings.PhysicsWorldPixToMetres }
-    };
+    writeResourceTypeAndVersion(json);
 
-    json["parent"] = QJsonObject {
-        { "name", QFileInfo(parent).fileName() },
-        { "path", QStringLiteral("folders/%1.yy").arg(parent) }
-    };
+    json.writeStartObject("roomSettings");
+    writeNumber(json, "Height", roomSettings.Height);
+    json.writeMember("inheritRoomSettings", roomSettings.inheritRoomSettings);
+    json.writeMember("persistent", roomSettings.persistent);
+    writeNumber(json, "Width", roomSettings.Width);
+    json.writeEndObject();
+
+    json.writeUnquotedMember("sequenceId", "null");
+    writeTags(json);
+
+    writeObjectArray(json, "views", views, [&] (const GMRView &view) {
+        view.write(json);
+    });
+
+    json.writeStartObject("viewSettings");
+    json.writeMember("clearDisplayBuffer", viewSettings.clearDisplayBuffer);
+    json.writeMember("clearViewBackground", viewSettings.clearViewBackground);
+    json.writeMember("enableViews", viewSettings.enableViews);
+    json.writeMember("inheritViewSettings", viewSettings.inheritViewSettings);
+    json.writeEndObject();
 
-    return json;
+    writeNumber(json, "volume", volume);
+    json.writeEndObject();
 }
 
 
@@ -1606,7 +1782,7 @@ bool YyPlugin::write(const Map *map, const QString &fileName, Options options)
 
     JsonWriter json(file.device());
     json.setMinimize(options.testFlag(WriteMinimized));
-    json.writeValue(room.toJson());
+    room.write(json);
     json.writeEndDocument();
 
     if (!file.commit()) {
@@ -32,8 +32,10 @@
 #include <QFileInfo>
 #include <QPainter>
 #include <QStringList>
+#include <QtConcurrent>
 
 #include <algorithm>
+#include <set>
 
 using namespace Tiled;
 
@@ -360,6 +362,29 @@ static QDebug operator<<(QDebug dbg, const TileTerrainNames &t)
     return dbg.space();
 }
 
+/**
+ * Returns a hash of the pixels of the given image, which is expected to be in
+ * ARGB32 format. Images with the same fingerprint are likely identical.
+ */
+static size_t fingerprint(const QImage &image)
+{
+    return qHashBits(image.constBits(), static_cast<size_t>(image.sizeInBytes()));
+}
+
+/**
+ * A tile to add to the target terrain set, either copied from a source
+ * tileset or composed from the images of the tiles in \c layers.
+ */
+struct TileJob
+{
+    TileTerrainNames terrainNames;
+    const Tile *sourceTile = nullptr;
+    QVector<QImage> layers;
+    Properties properties;
+    QImage image;
+    size_t fingerprint = 0;
+};
+
 static bool isEmpty(const QImage &image)
 {
     if (image.format() == QImage::Format_RGB32)
@@ -600,27 +625,25 @@ int main(int argc, char *argv[])
         }
     }
 
-    // Go through each combination of terrains and add the tile to the target
-    // terrain set if it's not in there yet.
+    // Go through each combination of terrains and determine how to create
+    // the tile, unless the target terrain set already has it.
+    QVector<TileJob> jobs;
+    std::set<TileTerrainNames> queued;
+
     for (const TileTerrainNames &terrainNames : process) {
         Tile *tile = terrainToTile.value(terrainNames);
 
         if (tile && tile->tileset() == targetTileset)
             continue;
+        if (!queued.insert(terrainNames).second)
+            continue;
 
-        QPixmap image;
-        Properties properties;
+        TileJob job;
+        job.terrainNames = terrainNames;
 
         if (!tile) {
             qInfo() << "Generating" << terrainNames;
 
-            // Start a new image
-            QImage tileImage = QImage(targetTileset->tileWidth(),
-                                      targetTileset->tileHeight(),
-                                      QImage::Format_ARGB32);
-            tileImage.fill(Qt::transparent);
-            QPainter painter(&tileImage);
-
             QStringList terrainList = terrainNames.terrainList();
             std::sort(terrainList.begin(), terrainList.end(), lessThan);
 
@@ -628,7 +651,7 @@ int main(int argc, char *argv[])
             const TileTerrainNames baseTerrain(terrainList.first());
             Tile *baseTile = terrainToTile.value(baseTerrain);
             if (baseTile)
-                painter.drawPixmap(0, 0, baseTile->image());
+                job.layers.append(baseTile->image().toImage());
 
             for (const QString &terrainName : std::as_const(terrainList)) {
                 TileTerrainNames filtered = terrainNames.filter(terrainName);
@@ -638,23 +661,86 @@ int main(int argc, char *argv[])
                     continue;
                 }
 
-                painter.drawPixmap(0, 0, tile->image());
-                mergeProperties(properties, tile->properties());
+                job.layers.append(tile->image().toImage());
+                mergeProperties(job.properties, tile->properties());
             }
-
-            image = QPixmap::fromImage(tileImage);
         } else {
             qInfo() << "Copying" << terrainNames << "from"
                     << QFileInfo(tile->tileset()->fileName()).fileName();
 
-            image = tile->image();
-            properties = tile->properties();
+            job.sourceTile = tile;
+            job.image = tile->image().toImage();
+            job.properties = tile->properties();
+        }
+
+        jobs.append(job);
+    }
+
+    // Compose the tile images in parallel. The painting is done on images,
+    // since pixmaps can't be used outside of the main thread.
+    const QSize tileSize = targetTileset->tileSize();
+    const int jobCount = jobs.size();
+    QAtomicInt finishedJobs;
+
+    QtConcurrent::blockingMap(jobs, [&] (TileJob &job) {
+        if (!job.sourceTile) {
+            QImage tileImage(tileSize, QImage::Format_ARGB32);
+            tileImage.fill(Qt::transparent);
+
+            QPainter painter(&tileImage);
+            for (const QImage &layer : std::as_const(job.layers))
+                painter.drawImage(0, 0, layer);
+            painter.end();
+
+            job.image = tileImage;
+            job.layers.clear();
+        }
+
+        job.image = job.image.convertToFormat(QImage::Format_ARGB32);
+        job.fingerprint = fingerprint(job.image);
+
+        // Report progress in steps of 10%
+        const int finished = finishedJobs.fetchAndAddRelaxed(1) + 1;
+        if (finished * 10 / jobCount != (finished - 1) * 10 / jobCount)
+            qInfo("Processed %d of %d tiles", finished, jobCount);
+    });
+
+    // Target tiles that are not part of the terrain set yet, by fingerprint,
+    // so that identical tiles are reused rather than added again
+    QMultiHash<size_t, Tile*> unassignedTiles;
+    const WangSet &targetWangSet = *targetTileset->wangSet(0);
+    for (Tile *tile : targetTileset->tiles()) {
+        if (!targetWangSet.wangIdOfTile(tile)) {
+            const QImage image = tile->image().toImage().convertToFormat(QImage::Format_ARGB32);
+            unassignedTiles.insert(fingerprint(image), tile);
+        }
+    }
+
+    // Add the tiles to the target terrain set, in the order of the
+    // combinations
+    for (const TileJob &job : std::as_const(jobs)) {
+        Tile *newTile = nullptr;
+
+        for (auto it = unassignedTiles.find(job.fingerprint);
+             it != unassignedTiles.end() && it.key() == job.fingerprint; ++it) {
+            if (it.value()->image().toImage().convertToFormat(QImage::Format_ARGB32) == job.image) {
+                newTile = it.value();
+                unassignedTiles.erase(it);
+                qInfo() << "Reusing tile" << newTile->id() << "for" << job.terrainNames;
+                break;
+            }
+        }
+
+        if (!newTile) {
+            if (job.sourceTile)
+                newTile = targetTileset->addTile(job.sourceTile->image());
+            else
+                newTile = targetTileset->addTile(QPixmap::fromImage(job.image));
         }
 
-        Tile *newTile = targetTileset->addTile(image);
-        builder.setWangId(newTile, builder.toWangId(terrainNames));
-        newTile->setProperties(properties);
-        terrainToTile.insert(terrainNames, newTile);
+        builder.setWangId(newTile, builder.toWangId(job.terrainNames));
+        newTile->setProperties(job.properties);
+        terrainToTile.insert(job.terrainNames, newTile);
     }
 
     if (targetTileset->tileCount() == 0)
@@ -34,6 +34,7 @@
 #include "maprenderer.h"
 #include "mapscene.h"
 #include "objectgroup.h"
+#include "objectpicker.h"
 #include "raiselowerhelper.h"
 #include "session.h"
 #include "templatemanager.h"
@@ -252,24 +253,24 @@ ObjectGroup *AbstractObjectTool::currentObjectGroup() const
     return dynamic_cast<ObjectGroup*>(mapDocument()->currentLayer());
 }
 
-QList<MapObject*> AbstractObjectTool::mapObjectsAt(const QPointF &pos) const
+/**
+ * Returns the object picker of the current map, if any.
+ */
+const ObjectPicker *AbstractObjectTool::objectPicker() const
 {
-    const QTransform viewTransform = mapScene()->views().first()->transform();
-    const QList<QGraphicsItem *> items = mapScene()->items(pos,
-                                                           Qt::IntersectsItemShape,
-                                                           Qt::DescendingOrder,
-                                                           viewTransform);
-
-    QList<MapObject*> objectList;
+    if (MapItem *mapItem = mapScene()->mapItem(mapDocument()))
+        return mapItem->objectPicker();
+    return nullptr;
+}
 
-    for (auto item : items) {
-        if (!item->isEnabled())
-            continue;
+QList<MapObject*> AbstractObjectTool::mapObjectsAt(const QPointF &pos) const
+{
+    const ObjectPicker *picker = objectPicker();
+    if (!picker)
+        return {};
 
-        MapObjectItem *objectItem = qgraphicsitem_cast<MapObjectItem*>(item);
-        if (objectItem && objectItem->mapObject()->objectGroup()->isUnlocked())
-            objectList.append(objectItem->mapObject());
-    }
+    const QTransform viewTransform = mapScene()->views().first()->transform();
+    QList<MapObject*> objectList = picker->objectsAt(pos, viewTransform);
 
     filterMapObjects(objectList);
     return objectList;
@@ -277,27 +278,17 @@ QList<MapObject*> AbstractObjectTool::mapObjectsAt(const QPointF &pos) const
 
 MapObject *AbstractObjectTool::topMostMapObjectAt(const QPointF &pos) const
 {
+    const ObjectPicker *picker = objectPicker();
+    if (!picker)
+        return nullptr;
+
     const QTransform viewTransform = mapScene()->views().first()->transform();
-    const QList<QGraphicsItem *> items = mapScene()->items(pos,
-                                                           Qt::IntersectsItemShape,
-                                                           Qt::DescendingOrder,
-                                                           viewTransform);
+    const QList<MapObject*> objects = picker->objectsAt(pos, viewTransform);
     const SelectionBehavior behavior = selectionBehavior();
 
     MapObject *topMost = nullptr;
 
-    for (QGraphicsItem *item : items) {
-        if (!item->isEnabled())
-            continue;
-
-        MapObjectItem *objectItem = qgraphicsitem_cast<MapObjectItem*>(item);
-        if (!objectItem)
-            continue;
-
-        auto mapObject = objectItem->mapObject();
-        if (!mapObject->objectGroup()->isUnlocked())
-            continue;
-
+    for (MapObject *mapObject : objects) {
         // Return immediately when we don't care if the layer is selected
         if (behavior == AllLayers)
             return mapObject;
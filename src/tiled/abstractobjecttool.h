@@ -31,6 +31,7 @@ class MapObject;
 class ObjectGroup;
 
 class MapObjectItem;
+class ObjectPicker;
 
 /**
  * A convenient base class for tools that work on object layers. Implements
@@ -76,6 +77,7 @@ public:
 
 protected:
     ObjectGroup *currentObjectGroup() const;
+    const ObjectPicker *objectPicker() const;
     QList<MapObject*> mapObjectsAt(const QPointF &pos) const;
     MapObject *topMostMapObjectAt(const QPointF &pos) const;
 
@@ -26,7 +26,12 @@
 #include "wangfiller.h"
 
 #include <QAction>
+#include <QRandomGenerator>
 #include <QUndoStack>
+#include <QtConcurrent>
+
+#include <memory>
+#include <vector>
 
 using namespace Tiled;
 
@@ -196,6 +201,7 @@ void AbstractTileFillTool::updatePreview(const QRegion &fillRegion)
     }
 
     mFillBounds = fillRegion.boundingRect();
+    mPendingFillRegion = QRegion();
     auto preview = SharedMap::create(mapDocument()->map()->parameters());
 
     static_cast<WangBrushItem*>(brushItem())->setInvalidTiles(QRegion());
@@ -233,8 +239,27 @@ void AbstractTileFillTool::updatePreview(const QRegion &fillRegion)
     mPreviewMap = preview;
 }
 
+/**
+ * Only highlights the given \a fillRegion, without generating the tiles that
+ * would be placed there. This keeps previewing cheap for very large regions.
+ * The tiles are generated when the preview is applied.
+ */
+void AbstractTileFillTool::updateRegionPreview(const QRegion &fillRegion)
+{
+    mFillBounds = fillRegion.boundingRect();
+    mPreviewMap.clear();
+    mPendingFillRegion = fillRegion;
+
+    static_cast<WangBrushItem*>(brushItem())->setInvalidTiles(QRegion());
+    brushItem()->clear();
+    brushItem()->setTileRegion(fillRegion);
+}
+
 bool AbstractTileFillTool::applyPreview(const QString &text)
 {
+    if (!mPreviewMap && !mPendingFillRegion.isEmpty())
+        updatePreview(mPendingFillRegion);
+
     auto preview = mPreviewMap;
     if (!preview)
         return false;
@@ -252,6 +277,7 @@ void AbstractTileFillTool::clearOverlay()
     static_cast<WangBrushItem*>(brushItem())->setInvalidTiles(QRegion());
 
     mPreviewMap.clear();
+    mPendingFillRegion = QRegion();
 }
 
 void AbstractTileFillTool::updateRandomListAndMissingTilesets()
@@ -289,15 +315,64 @@ void AbstractTileFillTool::randomFill(TileLayer &tileLayer, const QRegion &regio
         return;
 
     const auto localRegion = region.translated(-tileLayer.position());
-
-    for (const QRect &rect : localRegion) {
-        for (int y = rect.top(); y <= rect.bottom(); ++y) {
-            for (int x = rect.left(); x <= rect.right(); ++x) {
-                tileLayer.setCell(x, y,
-                                  mRandomCellPicker.pick());
+    const QRect bounds = localRegion.boundingRect();
+
+    // Large regions are filled in bands of chunk rows on separate layers in
+    // parallel. Merging them shares the chunks they fully cover.
+    constexpr int MinParallelArea = 256 * 256;
+    constexpr int BandHeight = CHUNK_SIZE * 4;
+
+    if (qint64(bounds.width()) * bounds.height() < MinParallelArea) {
+        for (const QRect &rect : localRegion) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                for (int x = rect.left(); x <= rect.right(); ++x) {
+                    tileLayer.setCell(x, y,
+                                      mRandomCellPicker.pick());
+                }
             }
         }
+        return;
+    }
+
+    struct Band
+    {
+        QPoint origin;
+        QRegion region;
+        quint32 seed;
+        std::unique_ptr<TileLayer> layer;
+    };
+
+    std::vector<Band> bands;
+
+    const int left = bounds.left() & ~CHUNK_MASK;
+    const int top = bounds.top() & ~(BandHeight - 1);
+
+    for (int y = top; y <= bounds.bottom(); y += BandHeight) {
+        const QRect bandRect(left, y, bounds.right() - left + 1, BandHeight);
+        QRegion bandRegion = localRegion.intersected(bandRect);
+        if (!bandRegion.isEmpty())
+            bands.push_back({ bandRect.topLeft(), std::move(bandRegion), QRandomGenerator::global()->generate(), nullptr });
     }
+
+    // Build the alias table before picking from several threads
+    mRandomCellPicker.prepare();
+
+    QtConcurrent::blockingMap(bands, [this] (Band &band) {
+        QRandomGenerator random(band.seed);
+        band.layer = std::make_unique<TileLayer>(QString(), 0, 0, 0, 0);
+
+        for (const QRect &rect : band.region.translated(-band.origin)) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                for (int x = rect.left(); x <= rect.right(); ++x) {
+                    band.layer->setCell(x, y,
+                                        mRandomCellPicker.pick(random.generateDouble()));
+                }
+            }
+        }
+    });
+
+    for (const Band &band : bands)
+        tileLayer.setCells(band.origin.x(), band.origin.y(), band.layer.get(), band.region);
 }
 
 void AbstractTileFillTool::wangFill(TileLayer &tileLayerToFill,
@@ -93,12 +93,14 @@ protected:
     virtual void clearConnections(MapDocument *mapDocument) = 0;
 
     void updatePreview(const QRegion &fillRegion);
+    void updateRegionPreview(const QRegion &fillRegion);
     bool applyPreview(const QString &text);
 
     void clearOverlay();
 
     TileStamp mStamp;
     SharedMap mPreviewMap;
+    QRegion mPendingFillRegion;     // region to fill once the preview is applied
     QVector<SharedTileset> mMissingTilesets;
 
     FillMethod mFillMethod;
@@ -121,7 +123,7 @@ private:
                        const QRegion &mask);
 
     WangSet *mWangSet;
-    RandomPicker<Cell> mRandomCellPicker;
+    AliasRandomPicker<Cell> mRandomCellPicker;
 
     CaptureStampHelper mCaptureStampHelper;
 
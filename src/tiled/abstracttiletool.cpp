@@ -27,6 +27,7 @@
 #include "maprenderer.h"
 #include "mapscene.h"
 #include "tilelayer.h"
+#include "tilesetmanager.h"
 #include "tilestamp.h"
 
 #include <QKeyEvent>
@@ -51,6 +52,13 @@ AbstractTileTool::AbstractTileTool(Id id,
         mBrushItem = new BrushItem;
     mBrushItem->setVisible(false);
     mBrushItem->setZValue(10000);
+
+    // The map scene only repaints the animated tiles placed on the map
+    connect(TilesetManager::instance(), &TilesetManager::repaintTileset,
+            this, [this] {
+        if (mBrushItem->isVisible())
+            mBrushItem->update();
+    });
 }
 
 AbstractTileTool::~AbstractTileTool()
@@ -186,8 +194,9 @@ void AbstractTileTool::updateStatusInfo()
         Cell cell;
         bool hex = false;
 
-        if (const TileLayer *tileLayer = currentTileLayer()) {
+        if (TileLayer *tileLayer = currentTileLayer()) {
             const QPoint pos = tilePosition() - tileLayer->position();
+            tileLayer->pageIn(QRect(pos, QSize(1, 1)));
             cell = tileLayer->cellAt(pos);
             hex = mapDocument()->renderer()->cellType() == MapRenderer::HexagonalCells;
         }
@@ -0,0 +1,377 @@
+/*
+ * assetdependencies.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "assetdependencies.h"
+
+#include "projectmodel.h"
+#include "tiled.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QXmlStreamReader>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+namespace Tiled {
+
+static void addDependency(QStringList &dependencies, const QString &reference, const QDir &dir)
+{
+    if (reference.isEmpty())
+        return;
+
+    const QString fileName = urlToLocalFileOrQrc(toUrl(reference, dir));
+    if (!fileName.isEmpty() && !dependencies.contains(fileName))
+        dependencies.append(fileName);
+}
+
+static void readXmlDependencies(QIODevice &device, const QDir &dir, QStringList &dependencies)
+{
+    QXmlStreamReader xml(&device);
+
+    while (!xml.atEnd()) {
+        if (xml.readNext() != QXmlStreamReader::StartElement)
+            continue;
+
+        // Layer data never refers to other files
+        if (xml.name() == QLatin1String("data")) {
+            xml.skipCurrentElement();
+            continue;
+        }
+
+        const QXmlStreamAttributes attributes = xml.attributes();
+
+        if (xml.name() == QLatin1String("tileset") || xml.name() == QLatin1String("image"))
+            addDependency(dependencies, attributes.value(QLatin1String("source")).toString(), dir);
+        else if (xml.name() == QLatin1String("property") && attributes.value(QLatin1String("type")) == QLatin1String("file"))
+            addDependency(dependencies, attributes.value(QLatin1String("value")).toString(), dir);
+
+        addDependency(dependencies, attributes.value(QLatin1String("template")).toString(), dir);
+    }
+}
+
+static void readJsonDependencies(const QJsonValue &value, const QDir &dir, QStringList &dependencies)
+{
+    if (value.isArray()) {
+        const QJsonArray array = value.toArray();
+        for (const QJsonValue &element : array)
+            if (element.isArray() || element.isObject())
+                readJsonDependencies(element, dir, dependencies);
+        return;
+    }
+
+    const QJsonObject object = value.toObject();
+
+    for (const char *key : { "source", "image", "template", "fileName" }) {
+        const QJsonValue reference = object.value(QLatin1String(key));
+        if (reference.isString())
+            addDependency(dependencies, reference.toString(), dir);
+    }
+
+    if (object.value(QLatin1String("type")) == QLatin1String("file"))
+        addDependency(dependencies, object.value(QLatin1String("value")).toString(), dir);
+
+    for (auto it = object.begin(), end = object.end(); it != end; ++it) {
+        // Layer data never refers to other files
+        if (it.key() == QLatin1String("data"))
+            continue;
+
+        if (it.value().isArray() || it.value().isObject())
+            readJsonDependencies(it.value(), dir, dependencies);
+    }
+}
+
+/**
+ * Extracts the files referred to by the given \a fileName, without actually
+ * loading it as a map, tileset, template or world.
+ */
+static QStringList readDependencies(const QString &fileName)
+{
+    QStringList dependencies;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return dependencies;
+
+    const QDir dir = QFileInfo(fileName).dir();
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+
+    if (suffix == QLatin1String("tmx") || suffix == QLatin1String("tsx") || suffix == QLatin1String("tx")) {
+        readXmlDependencies(file, dir, dependencies);
+    } else {
+        const QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+        if (document.isObject())
+            readJsonDependencies(document.object(), dir, dependencies);
+    }
+
+    return dependencies;
+}
+
+/**
+ * Returns the entries for the given \a files, reusing the existing
+ * \a entries for files that did not change. Runs in a worker thread.
+ */
+static QHash<QString, AssetDependencies::Entry> updateEntries(const QStringList &files,
+                                                              const QHash<QString, AssetDependencies::Entry> &entries)
+{
+    QHash<QString, AssetDependencies::Entry> result;
+    result.reserve(files.size());
+
+    for (const QString &fileName : files) {
+        const QFileInfo fileInfo(fileName);
+        if (!fileInfo.isFile())
+            continue;
+
+        AssetDependencies::Entry entry;
+        entry.lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+        entry.size = fileInfo.size();
+
+        const auto it = entries.constFind(fileName);
+        if (it != entries.constEnd() && it->lastModified == entry.lastModified && it->size == entry.size)
+            entry.dependencies = it->dependencies;
+        else
+            entry.dependencies = readDependencies(fileName);
+
+        result.insert(fileName, entry);
+    }
+
+    return result;
+}
+
+
+AssetDependencies::AssetDependencies(ProjectModel *projectModel, QObject *parent)
+    : QObject(parent)
+    , mProjectModel(projectModel)
+{
+    mUpdateTimer.setInterval(1000);
+    mUpdateTimer.setSingleShot(true);
+
+    connect(&mUpdateTimer, &QTimer::timeout, this, &AssetDependencies::startUpdate);
+    connect(projectModel, &ProjectModel::refreshed, this, [this] { mUpdateTimer.start(); });
+}
+
+AssetDependencies::~AssetDependencies() = default;
+
+/**
+ * Switches to the dependencies of the project stored at \a fileName. The
+ * dependencies remembered from a previous session are available right away,
+ * while they are being updated in the background.
+ */
+void AssetDependencies::setProjectFileName(const QString &fileName)
+{
+    if (mProjectFileName == fileName)
+        return;
+
+    // Ignore the result of an update that is still in progress
+    mUpdateWatcher = nullptr;
+
+    mProjectFileName = fileName;
+    mEntries.clear();
+    readIndex();
+    updateDependents();
+
+    mUpdateTimer.start();
+
+    emit updated();
+}
+
+/**
+ * Should be called when the given file was changed by Tiled itself, so that
+ * its dependencies get updated.
+ */
+void AssetDependencies::fileChanged(const QString &fileName)
+{
+    if (isAssetFile(fileName))
+        mUpdateTimer.start();
+}
+
+/**
+ * Returns the files used by the given \a fileName.
+ */
+QStringList AssetDependencies::dependencies(const QString &fileName) const
+{
+    return mEntries.value(fileName).dependencies;
+}
+
+/**
+ * Returns the files that use the given \a fileName, sorted by name.
+ */
+QStringList AssetDependencies::dependents(const QString &fileName) const
+{
+    return mDependents.value(fileName);
+}
+
+/**
+ * Returns whether the given file may refer to other files, based on its
+ * extension.
+ */
+bool AssetDependencies::isAssetFile(const QString &fileName)
+{
+    static const QStringList suffixes {
+        QStringLiteral("tmx"), QStringLiteral("tmj"),
+        QStringLiteral("tsx"), QStringLiteral("tsj"),
+        QStringLiteral("tx"), QStringLiteral("tj"),
+        QStringLiteral("world"),
+    };
+
+    const int dot = fileName.lastIndexOf(QLatin1Char('.'));
+    if (dot == -1)
+        return false;
+
+    const auto suffix = QStringView(fileName).mid(dot + 1);
+    return std::any_of(suffixes.begin(), suffixes.end(), [suffix] (const QString &s) {
+        return suffix.compare(s, Qt::CaseInsensitive) == 0;
+    });
+}
+
+void AssetDependencies::startUpdate()
+{
+    // Try again later when an update is already in progress
+    if (mUpdateWatcher) {
+        mUpdateTimer.start();
+        return;
+    }
+
+    QStringList files = mProjectModel->files();
+    files.erase(std::remove_if(files.begin(), files.end(),
+                               [] (const QString &fileName) { return !isAssetFile(fileName); }),
+                files.end());
+
+    auto watcher = new QFutureWatcher<QHash<QString, Entry>>(this);
+    mUpdateWatcher = watcher;
+
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher] {
+        watcher->deleteLater();
+
+        // Ignore the result when the project changed meanwhile
+        if (mUpdateWatcher != watcher)
+            return;
+
+        mUpdateWatcher = nullptr;
+        mEntries = watcher->result();
+        updateDependents();
+        writeIndex();
+
+        emit updated();
+    });
+
+    watcher->setFuture(QtConcurrent::run([files, entries = mEntries] {
+        return updateEntries(files, entries);
+    }));
+}
+
+void AssetDependencies::updateDependents()
+{
+    mDependents.clear();
+
+    for (auto it = mEntries.cbegin(), end = mEntries.cend(); it != end; ++it)
+        for (const QString &dependency : it->dependencies)
+            mDependents[dependency].append(it.key());
+
+    for (QStringList &dependents : mDependents)
+        dependents.sort();
+}
+
+static const quint32 dependenciesIndexMagic = 0x54414449;    // "TADI"
+static const quint32 dependenciesIndexVersion = 1;
+
+static QString indexFileName(const QString &projectFileName)
+{
+    if (projectFileName.isEmpty())
+        return QString();
+
+    const QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (cacheLocation.isEmpty())
+        return QString();
+
+    const QByteArray hash = QCryptographicHash::hash(projectFileName.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QDir(cacheLocation).filePath(QStringLiteral("assetdependencies/%1.index").arg(QString::fromLatin1(hash)));
+}
+
+void AssetDependencies::readIndex()
+{
+    const QString fileName = indexFileName(mProjectFileName);
+    if (fileName.isEmpty())
+        return;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream stream(&file);
+
+    quint32 magic, version;
+    QString projectFileName;
+    quint32 count;
+    stream >> magic >> version;
+    if (magic != dependenciesIndexMagic || version != dependenciesIndexVersion)
+        return;
+
+    stream >> projectFileName >> count;
+    if (projectFileName != mProjectFileName)
+        return;
+
+    QHash<QString, Entry> entries;
+    entries.reserve(count);
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString assetFileName;
+        Entry entry;
+        stream >> assetFileName >> entry.lastModified >> entry.size >> entry.dependencies;
+        entries.insert(assetFileName, entry);
+    }
+
+    if (stream.status() == QDataStream::Ok)
+        mEntries.swap(entries);
+}
+
+void AssetDependencies::writeIndex() const
+{
+    const QString fileName = indexFileName(mProjectFileName);
+    if (fileName.isEmpty() || !QDir().mkpath(QFileInfo(fileName).absolutePath()))
+        return;
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream << dependenciesIndexMagic << dependenciesIndexVersion
+           << mProjectFileName << quint32(mEntries.size());
+
+    for (auto it = mEntries.cbegin(), end = mEntries.cend(); it != end; ++it)
+        stream << it.key() << it->lastModified << it->size << it->dependencies;
+
+    if (stream.status() == QDataStream::Ok)
+        file.commit();
+}
+
+} // namespace Tiled
+
+#include "moc_assetdependencies.cpp"
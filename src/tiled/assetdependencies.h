@@ -0,0 +1,91 @@
+/*
+ * assetdependencies.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+namespace Tiled {
+
+class ProjectModel;
+
+/**
+ * Keeps track of which files of the project refer to which other files,
+ * like the tilesets and templates used by a map, or the images used by a
+ * tileset.
+ *
+ * The references are extracted in the background and stored in the cache,
+ * so that only files that changed since the last session need to be read
+ * again.
+ */
+class AssetDependencies : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AssetDependencies(ProjectModel *projectModel, QObject *parent = nullptr);
+    ~AssetDependencies() override;
+
+    void setProjectFileName(const QString &fileName);
+    void fileChanged(const QString &fileName);
+
+    bool isUpdating() const;
+
+    QStringList dependencies(const QString &fileName) const;
+    QStringList dependents(const QString &fileName) const;
+
+    static bool isAssetFile(const QString &fileName);
+
+    struct Entry
+    {
+        qint64 lastModified = 0;
+        qint64 size = -1;
+        QStringList dependencies;
+    };
+
+signals:
+    void updated();
+
+private:
+    void startUpdate();
+    void updateFinished();
+    void updateDependents();
+
+    void readIndex();
+    void writeIndex() const;
+
+    ProjectModel *mProjectModel;
+    QString mProjectFileName;
+    QHash<QString, Entry> mEntries;
+    QHash<QString, QStringList> mDependents;
+    QTimer mUpdateTimer;
+    QFutureWatcher<QHash<QString, Entry>> *mUpdateWatcher = nullptr;
+};
+
+inline bool AssetDependencies::isUpdating() const
+{
+    return mUpdateWatcher != nullptr;
+}
+
+} // namespace Tiled
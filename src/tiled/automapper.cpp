@@ -30,14 +30,15 @@
 #include "mapobject.h"
 #include "maprenderer.h"
 #include "objectgroup.h"
+#include "taskscheduler.h"
 #include "tile.h"
+#include "tracing.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QRandomGenerator>
-#include <QtConcurrent>
 
 #include <algorithm>
-#include <random>
 
 namespace Tiled {
 
@@ -46,28 +47,49 @@ static int wrap(int value, int bound)
     return (value % bound + bound) % bound;
 }
 
-static const Cell &getWrappedCell(int x, int y, const TileLayer &tileLayer)
+static Cell getWrappedCell(int x, int y, const TileLayer &tileLayer)
 {
     return tileLayer.cellAt(wrap(x, tileLayer.width()),
                             wrap(y, tileLayer.height()));
 }
 
-static const Cell &getBoundCell(int x, int y, const TileLayer &tileLayer)
+static Cell getBoundCell(int x, int y, const TileLayer &tileLayer)
 {
     return tileLayer.cellAt(qBound(0, x, tileLayer.width() - 1),
                             qBound(0, y, tileLayer.height() - 1));
 }
 
-static const Cell &getCell(int x, int y, const TileLayer &tileLayer)
+static Cell getCell(int x, int y, const TileLayer &tileLayer)
 {
     return tileLayer.cellAt(x, y);
 }
 
-static double randomDouble()
+static quint64 mix(quint64 value)
 {
-    thread_local std::mt19937 engine(std::random_device{}());
-    std::uniform_real_distribution<double> dist(0, 1);
-    return dist(engine);
+    // The finalizer of the SplitMix64 generator
+    value += 0x9e3779b97f4a7c15;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+    return value ^ (value >> 31);
+}
+
+enum class RandomPurpose : quint32 {
+    SkipChance,
+    OutputSet,
+};
+
+/**
+ * Returns a random number in the range [0, 1) that only depends on the given
+ * values. This keeps the random choices reproducible for a given seed,
+ * regardless of the order in which locations are matched or the number of
+ * threads used, and avoids any shared state between threads.
+ */
+static double positionRandom(quint32 seed, size_t ruleIndex, QPoint pos, RandomPurpose purpose)
+{
+    quint64 hash = mix((quint64(seed) << 32) | quint32(ruleIndex));
+    hash = mix(hash ^ ((quint64(quint32(pos.x())) << 32) | quint32(pos.y())));
+    hash = mix(hash ^ quint64(purpose));
+    return double(hash >> 11) / double(quint64(1) << 53);
 }
 
 template<typename Type, typename Container, typename Pred, typename... Args>
@@ -123,8 +145,9 @@ struct CompileContext
 
 struct ApplyContext
 {
-    ApplyContext(QRegion *appliedRegion)
+    ApplyContext(QRegion *appliedRegion, quint32 randomSeed)
         : appliedRegion(appliedRegion)
+        , randomSeed(randomSeed)
     {}
 
     // These regions store which parts of the map have already been altered by
@@ -133,8 +156,161 @@ struct ApplyContext
     QHash<const Layer*, QRegion> appliedRegions;
 
     QRegion *appliedRegion;
+    const quint32 randomSeed;
+};
+
+/**
+ * Stores where each tile can be found in the input layers, within the region
+ * that is being automapped. On large regions, this allows a rule to only be
+ * checked at the locations where its most selective cell can be found,
+ * rather than at every location.
+ */
+struct TileLocationIndex
+{
+    using Key = QPair<const Tileset*, int>;
+    using Locations = QVector<QPoint>;      // sorted by y, then x
+
+    // Indexed like RuleMapSetup::mInputLayerList. Layers that can change
+    // while matching are not indexed.
+    QVector<bool> indexed;
+    QVector<QHash<Key, Locations>> locations;
+
+    const Locations *find(int inputLayer, const Cell &cell) const
+    {
+        const auto &layerLocations = locations.at(inputLayer);
+        const auto it = layerLocations.find(Key(cell.tileset(), cell.tileId()));
+        return it != layerLocations.end() ? &it.value() : nullptr;
+    }
+
+    /**
+     * Prepares the index for reuse, keeping the memory of the location lists.
+     */
+    void reset(int layerCount)
+    {
+        indexed.fill(false, layerCount);
+        locations.resize(layerCount);
+
+        for (auto &layerLocations : locations)
+            for (auto &points : layerLocations)
+                points.resize(0);
+    }
+};
+
+/**
+ * Copies of the input layers as dense arrays of cell keys, covering the area
+ * that can be read while matching. Reading outside of the map follows the
+ * border options while copying, so that the matching itself doesn't need to
+ * care about them and can compare whole rows of cells at once.
+ *
+ * Each tile found in the input layers gets a number, which is combined with
+ * the flags of the cell into its key. Empty cells have key 0.
+ */
+struct InputRasters
+{
+    using Key = QPair<const Tileset*, int>;
+
+    static constexpr int FlagBits = 4;
+    static constexpr quint32 FlagMask = (1 << FlagBits) - 1;
+
+    QRect rect;
+
+    // Indexed like RuleMapSetup::mInputLayerList. Layers that can change
+    // while matching are not copied.
+    QVector<bool> rasterized;
+    QVector<std::vector<quint32>> layers;
+
+    QHash<Key, quint32> tileNumbers;
+
+    quint32 key(const Cell &cell)
+    {
+        if (cell.isEmpty())
+            return 0;
+
+        const Key tileKey(cell.tileset(), cell.tileId());
+        auto it = tileNumbers.find(tileKey);
+        if (it == tileNumbers.end())
+            it = tileNumbers.insert(tileKey, quint32(tileNumbers.size() + 1));
+
+        return (it.value() << FlagBits) | quint32(cell.flags());
+    }
+
+    /**
+     * Returns a pointer to the key of the cell at (0, y) in the given input
+     * layer. Only the columns within rect may be accessed.
+     */
+    const quint32 *row(int inputLayer, int y) const
+    {
+        return layers.at(inputLayer).data()
+                + qsizetype(y - rect.top()) * rect.width() - rect.left();
+    }
+
+    /**
+     * Prepares the rasters for reuse, keeping the memory of the layers.
+     */
+    void reset(int layerCount, const QRect &newRect)
+    {
+        rect = newRect;
+        rasterized.fill(false, layerCount);
+        layers.resize(layerCount);
+        tileNumbers.clear();
+    }
+};
+
+/**
+ * A MatchCell translated to the keys used by InputRasters. A cell matches
+ * when its key, after applying the mask, equals the value.
+ */
+struct RasterCell
+{
+    quint32 mask;
+    quint32 value;
+
+    bool matches(quint32 key) const { return (key & mask) == value; }
 };
 
+struct CandidateSource
+{
+    const TileLocationIndex::Locations *locations;
+    QPoint pos;                     // position relative to match location
+};
+
+/**
+ * Covers some rows of one of the rects in the match region of a rule. The
+ * rows are only split up when matching in parallel.
+ */
+struct MatchJob
+{
+    QRect rect;
+    int startX;
+    int startY;
+    QVector<QPoint> matches;
+    QVector<QPoint> candidates;
+    std::vector<quint8> rowMatches;
+    qint64 positionsTested = 0;
+    int allocations = 0;
+};
+
+/**
+ * The memory used while matching a rule, which is kept for the next time
+ * the rule is matched.
+ */
+struct MatchScratch
+{
+    QVector<CandidateSource> sources;
+    QVector<MatchJob> jobs;
+    QVector<QVector<RasterCell>> rasterCells;   // indexed like the input sets
+};
+
+// Below this amount of tiles, checking every location is fast enough
+static constexpr int MinIndexedArea = 64 * 64;
+
+// Above this amount of cells, the input layers are not copied to rasters
+static constexpr qint64 MaxRasterCells = 16 * 1024 * 1024;
+
+// Below this amount of locations, a rule is not matched in parallel
+static constexpr int MinParallelArea = 64 * 64;
+static constexpr int ParallelBandRows = 16;
+
 
 AutoMappingContext::AutoMappingContext(MapDocument *mapDocument)
     : targetDocument(mapDocument)
@@ -254,6 +430,10 @@ void AutoMapper::setupRuleMapProperties()
             mOptions.matchInOrderWasSet = true;
             continue;
         }
+        if (checkOption(name, value, QLatin1String("RandomSeed"), mOptions.randomSeed)) {
+            mOptions.randomSeedWasSet = true;
+            continue;
+        }
 
         if (checkRuleOptions(name, value, mRuleOptions, setRuleOptions))
             continue;
@@ -525,6 +705,9 @@ bool AutoMapper::setupRuleMapLayers()
     if (setup.mOutputSets.empty())
         error += tr("No output_<name> layer found!") + QLatin1Char('\n');
 
+    setup.mInputLayerList = setup.mInputLayerNames.values();
+    std::sort(setup.mInputLayerList.begin(), setup.mInputLayerList.end());
+
     // Make sure the input layers are always matched in the same order, which
     // significantly speeds up the matching logic.
     for (InputSet &set : setup.mInputSets) {
@@ -663,8 +846,13 @@ void AutoMapper::setupRules()
                     rule.outputSets.add(index, outputSet.probability);
             }
         }
+
+        // Rules may be applied from several threads
+        rule.outputSets.prepare();
     }
 
+    resetRuleStatistics();
+
 #ifndef QT_NO_DEBUG
     for (const Rule &rule : mRules) {
         const QRegion checkCoherent = rule.inputRegion.united(rule.outputRegion);
@@ -750,6 +938,14 @@ static void forEachPointInRegion(const QRegion &region, Callback callback)
                 callback(x, y);
 }
 
+static qint64 regionArea(const QRegion &region)
+{
+    qint64 area = 0;
+    for (const QRect &rect : region)
+        area += qint64(rect.width()) * rect.height();
+    return area;
+}
+
 /**
  * Fills \a cells with the list of all cells which can be found within all
  * tile layers within the given region.
@@ -789,6 +985,57 @@ static bool isEmptyRegion(const TileLayer &tileLayer,
     return true;
 }
 
+void AutoMapper::resetRuleStatistics()
+{
+    mRuleStatistics.assign(mRules.size(), RuleStatistics());
+
+    for (size_t i = 0; i < mRules.size(); ++i)
+        mRuleStatistics[i].bounds = mRules[i].inputRegion.united(mRules[i].outputRegion).boundingRect();
+}
+
+/**
+ * Returns the compiled input sets for all rules, given which of the input
+ * layers are present in the target map.
+ *
+ * The rules are only compiled again when that changed, or when the tilesets
+ * of the rules map changed (which happens when prepareAutoMap replaces them
+ * with similar tilesets from the target map).
+ */
+const AutoMapper::CompiledRules &AutoMapper::compiledRules(const QVector<bool> &inputLayersPresent) const
+{
+    const QVector<SharedTileset> &tilesets = mRulesMap->tilesets();
+
+    if (mCompiledRules &&
+            mCompiledRules->inputLayersPresent == inputLayersPresent &&
+            mCompiledRules->tilesets == tilesets) {
+        return *mCompiledRules;
+    }
+
+    CompiledRules &compiled = mCompiledRules.emplace();
+    compiled.tilesets = tilesets;
+    compiled.inputLayersPresent = inputLayersPresent;
+    compiled.inputSets.resize(mRules.size());
+
+    if (!mCompileContext)
+        mCompileContext = std::make_unique<CompileContext>();
+    CompileContext &compileContext = *mCompileContext;
+
+    for (size_t i = 0; i < mRules.size(); ++i) {
+        const Rule &rule = mRules[i];
+        if (rule.options.disabled || (!rule.outputSet && rule.outputSets.isEmpty()))
+            continue;
+
+        QElapsedTimer timer;
+        timer.start();
+
+        compileRule(compiled.inputSets[i], rule, compileContext, inputLayersPresent);
+
+        mRuleStatistics[i].compileTime += timer.nsecsElapsed();
+    }
+
+    return compiled;
+}
+
 /**
  * Sets up a small data structure for this rule that is optimized for matching.
  *
@@ -796,13 +1043,12 @@ static bool isEmptyRegion(const TileLayer &tileLayer,
  */
 bool AutoMapper::compileRule(QVector<RuleInputSet> &inputSets,
                              const Rule &rule,
-                             const AutoMappingContext &context) const
+                             CompileContext &compileContext,
+                             const QVector<bool> &inputLayersPresent) const
 {
-    CompileContext compileContext;
-
     for (const InputSet &inputSet : std::as_const(mRuleMapSetup.mInputSets)) {
         RuleInputSet index;
-        if (compileInputSet(index, inputSet, rule.inputRegion, compileContext, context))
+        if (compileInputSet(index, inputSet, rule.inputRegion, compileContext, inputLayersPresent))
             inputSets.append(std::move(index));
     }
 
@@ -869,7 +1115,7 @@ bool AutoMapper::compileInputSet(RuleInputSet &index,
                                  const InputSet &inputSet,
                                  const QRegion &inputRegion,
                                  CompileContext &compileContext,
-                                 const AutoMappingContext &context) const
+                                 const QVector<bool> &inputLayersPresent) const
 {
     const QPoint topLeft = inputRegion.boundingRect().topLeft();
 
@@ -886,7 +1132,8 @@ bool AutoMapper::compileInputSet(RuleInputSet &index,
         bool canMatch = true;
 
         RuleInputLayer layer;
-        layer.targetLayer = context.inputLayers.value(conditions.layerName, &dummy);
+        layer.inputLayer = mRuleMapSetup.mInputLayerList.indexOf(conditions.layerName);
+        const bool layerPresent = inputLayersPresent.at(layer.inputLayer);
 
         forEachPointInRegion(inputRegion, [&] (int x, int y) {
             anyOf.clear();
@@ -984,7 +1231,7 @@ bool AutoMapper::compileInputSet(RuleInputSet &index,
             // When the input layer is missing, it is considered empty. In this
             // case, we can drop this input set when empty tiles are not
             // allowed here.
-            if (layer.targetLayer == &dummy) {
+            if (!layerPresent) {
                 const bool emptyAllowed = (anyOf.isEmpty() ||
                                            std::any_of(anyOf.cbegin(),
                                                        anyOf.cend(),
@@ -1067,6 +1314,8 @@ void AutoMapper::autoMap(const QRegion &where,
                          QRegion *appliedRegion,
                          AutoMappingContext &context) const
 {
+    TILED_TRACE_SCOPE("AutoMapper::autoMap");
+
     QRegion applyRegion;
 
     // first resize the active area if applicable
@@ -1093,9 +1342,13 @@ void AutoMapper::autoMap(const QRegion &where,
 
         const QRegion regionToErase = inputLayersRegion.intersected(applyRegion);
 
-        for (const QString &name : mRuleMapSetup.mOutputTileLayerNames)
+        for (const QString &name : mRuleMapSetup.mOutputTileLayerNames) {
             context.outputTileLayers.value(name)->erase(regionToErase);
 
+            if (!context.touchedTileLayers.isEmpty())
+                context.changedTileRegions[name] |= regionToErase;
+        }
+
         for (const QString &name : mRuleMapSetup.mOutputObjectGroupNames) {
             const auto objects = objectsInRegion(*context.targetDocument->renderer(),
                                                  context.outputObjectGroups.value(name),
@@ -1115,49 +1368,237 @@ void AutoMapper::autoMap(const QRegion &where,
             get = &getBoundCell;
     }
 
-    ApplyContext applyContext { appliedRegion };
+    // Look up the input layers in the target map. Missing layers are
+    // considered empty.
+    QVector<const TileLayer*> inputLayers;
+    QVector<bool> inputLayersPresent;
+    for (const QString &name : std::as_const(mRuleMapSetup.mInputLayerList)) {
+        const TileLayer *inputLayer = context.inputLayers.value(name);
+        inputLayers.append(inputLayer ? inputLayer : &dummy);
+        inputLayersPresent.append(inputLayer != nullptr);
+    }
+
+    const CompiledRules &compiled = compiledRules(inputLayersPresent);
+
+    QSize maxRuleSize;
+    for (const Rule &rule : mRules)
+        maxRuleSize = maxRuleSize.expandedTo(rule.inputRegion.boundingRect().size());
+
+    // When matching in order, earlier rules may change the output layers, so
+    // those layers can't be indexed or copied upfront.
+    auto inputLayerMayChange = [&] (int i) {
+        return mOptions.matchInOrder && mRuleMapSetup.mOutputTileLayerNames.contains(mRuleMapSetup.mInputLayerList.at(i));
+    };
+
+    // Copy the input layers to rasters covering all cells that may be read
+    // while matching, with the cells outside of the map looked up according
+    // to the border options.
+    InputRasters *inputRasters = nullptr;
+    const QRect rasterRect = applyRegion.boundingRect().adjusted(-maxRuleSize.width(), -maxRuleSize.height(),
+                                                                 maxRuleSize.width(), maxRuleSize.height());
+    if (!applyRegion.isEmpty() &&
+            qint64(rasterRect.width()) * rasterRect.height() * inputLayers.size() <= MaxRasterCells) {
+        if (!mInputRasters)
+            mInputRasters = std::make_unique<InputRasters>();
+        inputRasters = mInputRasters.get();
+        inputRasters->reset(inputLayers.size(), rasterRect);
+
+        for (int i = 0; i < inputLayers.size(); ++i) {
+            if (inputLayerMayChange(i))
+                continue;
+
+            const TileLayer &inputLayer = *inputLayers.at(i);
+            auto &raster = inputRasters->layers[i];
+            raster.resize(size_t(rasterRect.width()) * size_t(rasterRect.height()));
+
+            auto key = raster.begin();
+            for (int y = rasterRect.top(); y <= rasterRect.bottom(); ++y)
+                for (int x = rasterRect.left(); x <= rasterRect.right(); ++x)
+                    *key++ = inputRasters->key(get(x, y, inputLayer));
+
+            inputRasters->rasterized[i] = true;
+        }
+    }
+
+    // On large regions, index where each tile can be found in the input
+    // layers. This is only possible when not reading outside of the map.
+    TileLocationIndex *tileLocations = nullptr;
+    if (get == &getCell && regionArea(applyRegion) >= MinIndexedArea) {
+        // Expand to include all cells that may be read while matching
+        QRegion indexRegion;
+        for (const QRect &rect : std::as_const(applyRegion)) {
+            indexRegion |= rect.adjusted(-maxRuleSize.width(), -maxRuleSize.height(),
+                                         maxRuleSize.width(), maxRuleSize.height());
+        }
+
+        if (!mTileLocations)
+            mTileLocations = std::make_unique<TileLocationIndex>();
+        tileLocations = mTileLocations.get();
+        tileLocations->reset(inputLayers.size());
+
+        for (int i = 0; i < inputLayers.size(); ++i) {
+            if (inputLayerMayChange(i))
+                continue;
+
+            const TileLayer *inputLayer = inputLayers.at(i);
+            auto &locations = tileLocations->locations[i];
+
+            forEachPointInRegion(indexRegion & inputLayer->localBounds(), [&] (int x, int y) {
+                const Cell cell = inputLayer->cellAt(x, y);
+                if (!cell.isEmpty())
+                    locations[TileLocationIndex::Key(cell.tileset(), cell.tileId())].append(QPoint(x, y));
+            });
+
+            for (auto &points : locations) {
+                std::sort(points.begin(), points.end(), [] (QPoint a, QPoint b) {
+                    return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
+                });
+            }
+
+            tileLocations->indexed[i] = true;
+        }
+    }
+
+    const TileLocationIndex *tileLocationsPtr = tileLocations;
+    const InputRasters *inputRastersPtr = inputRasters;
+
+    if (mMatchScratch.size() != mRules.size()) {
+        mMatchScratch.resize(mRules.size());
+        for (auto &scratch : mMatchScratch)
+            if (!scratch)
+                scratch = std::make_unique<MatchScratch>();
+    }
+
+    quint32 randomSeed;
+    if (context.randomSeed)
+        randomSeed = *context.randomSeed;
+    else if (mOptions.randomSeedWasSet)
+        randomSeed = static_cast<quint32>(mOptions.randomSeed);
+    else
+        randomSeed = QRandomGenerator::global()->generate();
+
+    ApplyContext applyContext { appliedRegion, randomSeed };
+
+    // During "AutoMap while drawing", only the rules reading one of the
+    // changed areas need to be matched again. These start out as the drawn
+    // area, and grow by the output of each applied rule (see copyMapRegion).
+    // When matching in order, following rules see the changes made by the
+    // rules before them. This is not possible when the output layers were
+    // erased.
+    const bool trackDependencies = !context.touchedTileLayers.isEmpty() && !mOptions.deleteTiles;
+
+    // Returns the region in which a rule with the given input sets needs to
+    // be matched. The changed areas are extended by the AutoMappingRadius
+    // here, and by the size of the rule in matchRule.
+    auto dirtyRegionForRule = [&] (const QVector<RuleInputSet> &inputSets) {
+        if (!trackDependencies)
+            return applyRegion;
+
+        QRegion changedRegion;
+        for (const RuleInputSet &inputSet : inputSets) {
+            // An input set without layers doesn't depend on anything
+            if (inputSet.layers.isEmpty())
+                return applyRegion;
+
+            for (const RuleInputLayer &layer : inputSet.layers)
+                changedRegion |= context.changedTileRegions.value(mRuleMapSetup.mInputLayerList.at(layer.inputLayer));
+        }
+
+        if (!mOptions.autoMappingRadius)
+            return changedRegion & applyRegion;
+
+        QRegion region;
+        for (const QRect &r : changedRegion) {
+            region |= r.adjusted(- mOptions.autoMappingRadius,
+                                 - mOptions.autoMappingRadius,
+                                 + mOptions.autoMappingRadius,
+                                 + mOptions.autoMappingRadius);
+        }
+        return region & applyRegion;
+    };
 
     if (mOptions.matchInOrder) {
-        for (const Rule &rule : mRules) {
+        // A rule can be matched in parallel when it doesn't read any of the
+        // layers it might change while being applied.
+        QVector<bool> inputLayerIsOutput;
+        for (const QString &name : std::as_const(mRuleMapSetup.mInputLayerList))
+            inputLayerIsOutput.append(mRuleMapSetup.mOutputTileLayerNames.contains(name));
+
+        auto readsOutputLayer = [&] (const QVector<RuleInputSet> &inputSets) {
+            return std::any_of(inputSets.begin(), inputSets.end(), [&] (const RuleInputSet &inputSet) {
+                return std::any_of(inputSet.layers.begin(), inputSet.layers.end(), [&] (const RuleInputLayer &layer) {
+                    return inputLayerIsOutput.at(layer.inputLayer);
+                });
+            });
+        };
+
+        for (size_t i = 0; i < mRules.size(); ++i) {
+            const Rule &rule = mRules[i];
             if (rule.options.disabled)
                 continue;
 
-            matchRule(rule, applyRegion, get, [&] (QPoint pos) {
+            const auto &inputSets = compiled.inputSets[i];
+            const QRegion matchRegion = dirtyRegionForRule(inputSets);
+            if (matchRegion.isEmpty())
+                continue;
+
+            const bool parallel = !readsOutputLayer(inputSets);
+
+            RuleStatistics &statistics = mRuleStatistics[i];
+            QElapsedTimer timer;
+            QElapsedTimer applyTimer;
+            qint64 applyTime = 0;
+            timer.start();
+
+            matchRule(rule, inputSets, inputLayers, tileLocationsPtr, inputRastersPtr, matchRegion, get, randomSeed, parallel, [&] (QPoint pos) {
+                applyTimer.start();
                 applyRule(rule, pos, applyContext, context);
+                applyTime += applyTimer.nsecsElapsed();
             }, context);
             applyContext.appliedRegions.clear();
+
+            statistics.matchTime += timer.nsecsElapsed() - applyTime;
+            statistics.applyTime += applyTime;
         }
     } else {
-        auto collectMatches = [&] (const Rule &rule) {
+        const int ruleCount = static_cast<int>(mRules.size());
+
+        QVector<QRegion> matchRegions;
+        matchRegions.reserve(ruleCount);
+        for (const auto &inputSets : compiled.inputSets)
+            matchRegions.append(dirtyRegionForRule(inputSets));
+
+        auto collectMatches = [&] (int ruleIndex) {
+            const Rule &rule = mRules[ruleIndex];
+            const QRegion &matchRegion = matchRegions.at(ruleIndex);
             QVector<QPoint> positions;
-            if (!rule.options.disabled)
-                matchRule(rule, applyRegion, get, [&] (QPoint pos) { positions.append(pos); }, context);
-            return positions;
-        };
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        auto result = QtConcurrent::blockingMapped(mRules, collectMatches);
-#else
-        struct MatchRule
-        {
-            using result_type = QVector<QPoint>;
-
-            std::function<result_type(const Rule&)> collectMatches;
-
-            result_type operator()(const Rule &rule)
-            {
-                return collectMatches(rule);
+            if (!rule.options.disabled && !matchRegion.isEmpty()) {
+                QElapsedTimer timer;
+                timer.start();
+
+                matchRule(rule, compiled.inputSets[ruleIndex], inputLayers, tileLocationsPtr, inputRastersPtr, matchRegion, get, randomSeed, false,
+                          [&] (QPoint pos) { positions.append(pos); }, context);
+
+                mRuleStatistics[ruleIndex].matchTime += timer.nsecsElapsed();
             }
+            return positions;
         };
 
-        const auto result = QtConcurrent::blockingMapped<QVector<QVector<QPoint>>>(mRules,
-                                                                                   MatchRule { collectMatches });
-#endif
+        QVector<QVector<QPoint>> result(ruleCount);
+        TaskScheduler::parallelFor(ruleCount, [&] (int ruleIndex) {
+            result[ruleIndex] = collectMatches(ruleIndex);
+        });
 
         for (size_t i = 0; i < mRules.size(); ++i) {
             const Rule &rule = mRules[i];
+            QElapsedTimer timer;
+            timer.start();
+
             for (const QPoint pos : result[i])
                 applyRule(rule, pos, applyContext, context);
             applyContext.appliedRegions.clear();
+
+            mRuleStatistics[i].applyTime += timer.nsecsElapsed();
         }
     }
 }
@@ -1173,15 +1614,19 @@ static bool cellMatches(const MatchCell &matchCell, const Cell &cell)
 /**
  * Checks whether the given \a inputSet matches at the given \a offset.
  */
-static bool matchInputIndex(const RuleInputSet &inputSet, QPoint offset, AutoMapper::GetCell getCell)
+static bool matchInputIndex(const RuleInputSet &inputSet,
+                            const QVector<const TileLayer*> &inputLayers,
+                            QPoint offset, AutoMapper::GetCell getCell)
 {
     qsizetype nextPos = 0;
     qsizetype nextCell = 0;
 
     for (const RuleInputLayer &layer : inputSet.layers) {
+        const TileLayer &targetLayer = *inputLayers.at(layer.inputLayer);
+
         for (auto p = std::exchange(nextPos, nextPos + layer.posCount); p < nextPos; ++p) {
             const RuleInputLayerPos &pos = inputSet.positions[p];
-            const Cell &cell = getCell(pos.x + offset.x(), pos.y + offset.y(), *layer.targetLayer);
+            const Cell &cell = getCell(pos.x + offset.x(), pos.y + offset.y(), targetLayer);
 
             // Match may succeed if any of the "any" tiles are seen, or when
             // there are no "any" tiles for this location.
@@ -1210,24 +1655,257 @@ static bool matchInputIndex(const RuleInputSet &inputSet, QPoint offset, AutoMap
     return true;
 }
 
-static bool matchRuleAtOffset(const QVector<RuleInputSet> &inputSets, QPoint offset, AutoMapper::GetCell getCell)
+static bool matchRuleAtOffset(const QVector<RuleInputSet> &inputSets,
+                              const QVector<const TileLayer*> &inputLayers,
+                              QPoint offset, AutoMapper::GetCell getCell)
 {
     return std::any_of(inputSets.begin(),
                        inputSets.end(),
-                       [=] (const RuleInputSet &index) { return matchInputIndex(index, offset, getCell); });
+                       [&] (const RuleInputSet &index) { return matchInputIndex(index, inputLayers, offset, getCell); });
+}
+
+/**
+ * Returns whether all the layers read by the given \a inputSets have been
+ * copied to the given \a rasters.
+ */
+static bool readsRasterizedLayers(const QVector<RuleInputSet> &inputSets,
+                                  const InputRasters &rasters)
+{
+    return std::all_of(inputSets.begin(), inputSets.end(), [&] (const RuleInputSet &inputSet) {
+        return std::all_of(inputSet.layers.begin(), inputSet.layers.end(), [&] (const RuleInputLayer &layer) {
+            return rasters.rasterized.at(layer.inputLayer);
+        });
+    });
+}
+
+/**
+ * Translates the cells of the given \a inputSets to the keys used by the
+ * given \a rasters. Tiles that don't appear in the rasters can't match.
+ */
+static void toRasterCells(const QVector<RuleInputSet> &inputSets,
+                          const InputRasters &rasters,
+                          QVector<QVector<RasterCell>> &rasterCells)
+{
+    rasterCells.resize(inputSets.size());
+
+    for (int i = 0; i < inputSets.size(); ++i) {
+        QVector<RasterCell> &cells = rasterCells[i];
+        cells.resize(0);
+
+        for (const MatchCell &matchCell : inputSets.at(i).cells) {
+            if (matchCell.isEmpty()) {
+                cells.append(RasterCell { ~0u, 0 });
+                continue;
+            }
+
+            const auto it = rasters.tileNumbers.constFind(InputRasters::Key(matchCell.tileset(),
+                                                                            matchCell.tileId()));
+            if (it == rasters.tileNumbers.constEnd()) {
+                cells.append(RasterCell { ~0u, ~0u });
+                continue;
+            }
+
+            const quint32 flagsMask = quint32(matchCell.flagsMask) & InputRasters::FlagMask;
+            cells.append(RasterCell { ~InputRasters::FlagMask | flagsMask,
+                                      (it.value() << InputRasters::FlagBits) | (quint32(matchCell.flags()) & flagsMask) });
+        }
+    }
+}
+
+/**
+ * Checks whether the given \a inputSet, with its cells translated to
+ * \a rasterCells, matches at the given \a offset.
+ */
+static bool matchInputSetInRasters(const RuleInputSet &inputSet,
+                                   const RasterCell *cells,
+                                   const InputRasters &rasters,
+                                   QPoint offset)
+{
+    qsizetype nextPos = 0;
+
+    for (const RuleInputLayer &layer : inputSet.layers) {
+        for (auto p = std::exchange(nextPos, nextPos + layer.posCount); p < nextPos; ++p) {
+            const RuleInputLayerPos &pos = inputSet.positions[p];
+            const quint32 key = rasters.row(layer.inputLayer, offset.y() + pos.y)[offset.x() + pos.x];
+            const auto matches = [key] (const RasterCell &cell) { return cell.matches(key); };
+
+            const RasterCell *anyEnd = cells + pos.anyCount;
+            const RasterCell *noneEnd = anyEnd + pos.noneCount;
+
+            if (pos.anyCount && std::none_of(cells, anyEnd, matches))
+                return false;
+            if (std::any_of(anyEnd, noneEnd, matches))
+                return false;
+
+            cells = noneEnd;
+        }
+    }
+
+    return true;
+}
+
+static bool matchRuleInRasters(const QVector<RuleInputSet> &inputSets,
+                               const QVector<QVector<RasterCell>> &rasterCells,
+                               const InputRasters &rasters,
+                               QPoint offset)
+{
+    for (int i = 0; i < inputSets.size(); ++i)
+        if (matchInputSetInRasters(inputSets.at(i), rasterCells.at(i).constData(), rasters, offset))
+            return true;
+    return false;
+}
+
+/**
+ * Checks the given \a inputSets at \a count positions, starting at \a offset
+ * and \a step tiles apart horizontally. Sets \a matches to 1 for each
+ * position where any of the input sets matches and to 0 elsewhere.
+ *
+ * Rather than checking one position after the other, all positions are
+ * checked together one condition at a time. This turns the matching into
+ * simple loops over the raster rows, which the compiler can vectorize.
+ * The \a alive and \a found buffers need room for \a count values.
+ */
+static void matchRowInRasters(const QVector<RuleInputSet> &inputSets,
+                              const QVector<QVector<RasterCell>> &rasterCells,
+                              const InputRasters &rasters,
+                              QPoint offset, int step, int count,
+                              quint8 *matches, quint8 *alive, quint8 *found)
+{
+    std::fill_n(matches, count, quint8(0));
+
+    for (int s = 0; s < inputSets.size(); ++s) {
+        const RuleInputSet &inputSet = inputSets.at(s);
+        const RasterCell *cells = rasterCells.at(s).constData();
+        qsizetype nextPos = 0;
+        bool anyAlive = true;
+
+        std::fill_n(alive, count, quint8(1));
+
+        for (const RuleInputLayer &layer : inputSet.layers) {
+            for (auto p = std::exchange(nextPos, nextPos + layer.posCount); p < nextPos && anyAlive; ++p) {
+                const RuleInputLayerPos &pos = inputSet.positions[p];
+                const quint32 *row = rasters.row(layer.inputLayer, offset.y() + pos.y) + offset.x() + pos.x;
+
+                if (pos.anyCount) {
+                    std::fill_n(found, count, quint8(0));
+                    for (int c = 0; c < pos.anyCount; ++c) {
+                        const RasterCell cell = cells[c];
+                        for (int i = 0; i < count; ++i)
+                            found[i] |= quint8(cell.matches(row[i * step]));
+                    }
+                    for (int i = 0; i < count; ++i)
+                        alive[i] &= found[i];
+                }
+
+                for (int c = pos.anyCount; c < pos.anyCount + pos.noneCount; ++c) {
+                    const RasterCell cell = cells[c];
+                    for (int i = 0; i < count; ++i)
+                        alive[i] &= quint8(!cell.matches(row[i * step]));
+                }
+
+                cells += pos.anyCount + pos.noneCount;
+                anyAlive = std::find(alive, alive + count, quint8(1)) != alive + count;
+            }
+
+            if (!anyAlive)
+                break;
+        }
+
+        if (!anyAlive)
+            continue;
+
+        for (int i = 0; i < count; ++i)
+            matches[i] |= alive[i];
+    }
+}
+
+/**
+ * Looks up the locations of the most selective cell of each input set,
+ * which is a position that requires one of a few specific tiles.
+ *
+ * Returns false when any of the input sets has no such position in an
+ * indexed layer, in which case the rule needs to be checked everywhere.
+ */
+static bool findCandidateSources(const QVector<RuleInputSet> &inputSets,
+                                 const TileLocationIndex &tileLocations,
+                                 QVector<CandidateSource> &sources,
+                                 qint64 &candidateCount)
+{
+    for (const RuleInputSet &inputSet : inputSets) {
+        qsizetype nextPos = 0;
+        qsizetype nextCell = 0;
+
+        const RuleInputLayerPos *bestPos = nullptr;
+        const RuleInputLayer *bestLayer = nullptr;
+        qsizetype bestCells = 0;
+        qint64 bestCount = 0;
+
+        for (const RuleInputLayer &layer : inputSet.layers) {
+            for (auto p = std::exchange(nextPos, nextPos + layer.posCount); p < nextPos; ++p) {
+                const RuleInputLayerPos &pos = inputSet.positions[p];
+                const auto firstCell = std::exchange(nextCell, nextCell + pos.anyCount + pos.noneCount);
+
+                if (!pos.anyCount || !tileLocations.indexed.at(layer.inputLayer))
+                    continue;
+
+                qint64 count = 0;
+                bool usable = true;
+
+                for (auto c = firstCell; c < firstCell + pos.anyCount; ++c) {
+                    const MatchCell &desired = inputSet.cells[c];
+                    if (desired.isEmpty()) {
+                        usable = false;     // empty cells are not indexed
+                        break;
+                    }
+                    if (auto locations = tileLocations.find(layer.inputLayer, desired))
+                        count += locations->size();
+                }
+
+                if (usable && (!bestPos || count < bestCount)) {
+                    bestPos = &pos;
+                    bestLayer = &layer;
+                    bestCells = firstCell;
+                    bestCount = count;
+                }
+            }
+        }
+
+        if (!bestPos)
+            return false;
+
+        for (auto c = bestCells; c < bestCells + bestPos->anyCount; ++c) {
+            auto locations = tileLocations.find(bestLayer->inputLayer, inputSet.cells[c]);
+            if (!locations)
+                continue;
+
+            // Cells differing only by flags share their locations
+            const CandidateSource source { locations, QPoint(bestPos->x, bestPos->y) };
+            if (std::none_of(sources.cbegin(), sources.cend(), [&] (const CandidateSource &s) {
+                             return s.locations == source.locations && s.pos == source.pos; })) {
+                sources.append(source);
+            }
+        }
+
+        candidateCount += bestCount;
+    }
+
+    return true;
 }
 
 void AutoMapper::matchRule(const Rule &rule,
+                           const QVector<RuleInputSet> &inputSets,
+                           const QVector<const TileLayer*> &inputLayers,
+                           const TileLocationIndex *tileLocations,
+                           const InputRasters *inputRasters,
                            const QRegion &matchRegion,
                            GetCell getCell,
+                           quint32 randomSeed,
+                           bool parallel,
                            const std::function<void(QPoint pos)> &matched,
                            const AutoMappingContext &context) const
 {
-    if (!rule.outputSet && rule.outputSets.isEmpty())
-        return;
-
-    QVector<RuleInputSet> inputSets;
-    if (!compileRule(inputSets, rule, context))
+    // Empty when the rule has no output or can never match
+    if (inputSets.isEmpty())
         return;
 
     const QRect inputBounds = rule.inputRegion.boundingRect();
@@ -1253,33 +1931,225 @@ void AutoMapper::matchRule(const Rule &rule,
                                  context.targetMap->height() - ruleHeight);
     }
 
+    const size_t ruleIndex = &rule - mRules.data();
+    MatchScratch &scratch = *mMatchScratch[ruleIndex];
+    qint64 allocations = 0;
+
+    // Use the tile location index when it brings the number of locations to
+    // check down compared to trying every location.
+    QVector<CandidateSource> &sources = scratch.sources;
+    const auto sourcesCapacity = sources.capacity();
+    sources.resize(0);
+    qint64 candidateCount = 0;
+    const bool useCandidates = tileLocations &&
+            findCandidateSources(inputSets, *tileLocations, sources, candidateCount) &&
+            candidateCount < regionArea(ruleMatchRegion) / (rule.options.modX * rule.options.modY);
+
+    if (sources.capacity() > sourcesCapacity)
+        ++allocations;
+
+    // Match against the rasters when all layers read by this rule have been
+    // copied, which avoids looking up each cell in its layer.
+    const QVector<QVector<RasterCell>> *rasterCells = nullptr;
+    if (inputRasters && readsRasterizedLayers(inputSets, *inputRasters)) {
+        const auto rasterCellsCapacity = scratch.rasterCells.capacity();
+        toRasterCells(inputSets, *inputRasters, scratch.rasterCells);
+        if (scratch.rasterCells.capacity() > rasterCellsCapacity)
+            ++allocations;
+        rasterCells = &scratch.rasterCells;
+    }
+
+    auto matchAt = [&] (QPoint pos) {
+        if (rasterCells)
+            return matchRuleInRasters(inputSets, *rasterCells, *inputRasters, pos);
+        return matchRuleAtOffset(inputSets, inputLayers, pos, getCell);
+    };
+
+    auto skip = [&] (QPoint pos) {
+        return rule.options.skipChance != 0.0 &&
+                positionRandom(randomSeed, ruleIndex, pos, RandomPurpose::SkipChance) < rule.options.skipChance;
+    };
+
+    const bool split = parallel && regionArea(ruleMatchRegion) >= MinParallelArea;
+    const int bandHeight = ParallelBandRows * rule.options.modY;
+
+    // The jobs are reused along with their vectors
+    QVector<MatchJob> &jobs = scratch.jobs;
+    const auto jobsCapacity = jobs.capacity();
+    int jobCount = 0;
+
+    auto addJob = [&] (const QRect &rect, int startX, int startY) {
+        if (jobCount == jobs.size())
+            jobs.append(MatchJob());
+
+        MatchJob &job = jobs[jobCount++];
+        job.rect = rect;
+        job.startX = startX;
+        job.startY = startY;
+        job.matches.resize(0);
+        job.candidates.resize(0);
+        job.positionsTested = 0;
+        job.allocations = 0;
+    };
+
     for (const QRect &rect : ruleMatchRegion) {
         const int startX = rect.left() + (rect.left() + rule.options.offsetX) % rule.options.modX;
         const int startY = rect.top() + (rect.top() + rule.options.offsetY) % rule.options.modY;
 
-        for (int y = startY; y <= rect.bottom(); y += rule.options.modY) {
-            for (int x = startX; x <= rect.right(); x += rule.options.modX) {
-                if (rule.options.skipChance != 0.0 && randomDouble() < rule.options.skipChance)
+        if (!split) {
+            addJob(rect, startX, startY);
+            continue;
+        }
+
+        // Bands start at a row that is checked, to keep the ModY behavior
+        for (int top = startY; top <= rect.bottom(); top += bandHeight) {
+            const QRect band(QPoint(rect.left(), top),
+                             QPoint(rect.right(), qMin(rect.bottom(), top + bandHeight - 1)));
+            addJob(band, startX, startY);
+        }
+    }
+
+    if (jobs.capacity() > jobsCapacity)
+        ++allocations;
+
+    const auto jobsBegin = jobs.begin();
+    const auto jobsEnd = jobsBegin + jobCount;
+
+    auto matchJob = [&] (MatchJob &job, const std::function<void(QPoint pos)> &onMatch) {
+        const QRect &rect = job.rect;
+
+        if (useCandidates) {
+            QVector<QPoint> &candidates = job.candidates;
+            const auto candidatesCapacity = candidates.capacity();
+
+            for (const CandidateSource &source : std::as_const(sources)) {
+                const QRect cellRect = rect.translated(source.pos);
+                const auto &locations = *source.locations;
+
+                auto it = std::lower_bound(locations.begin(), locations.end(), cellRect.top(),
+                                           [] (QPoint p, int y) { return p.y() < y; });
+
+                for (; it != locations.end() && it->y() <= cellRect.bottom(); ++it)
+                    if (it->x() >= cellRect.left() && it->x() <= cellRect.right())
+                        candidates.append(*it - source.pos);
+            }
+
+            // Check the candidates in the same order as the full scan below
+            std::sort(candidates.begin(), candidates.end(), [] (QPoint a, QPoint b) {
+                return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
+            });
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+            if (candidates.capacity() > candidatesCapacity)
+                ++job.allocations;
+
+            for (const QPoint pos : std::as_const(candidates)) {
+                if (pos.x() < job.startX || (pos.x() - job.startX) % rule.options.modX)
+                    continue;
+                if (pos.y() < job.startY || (pos.y() - job.startY) % rule.options.modY)
                     continue;
 
-                if (matchRuleAtOffset(inputSets, QPoint(x, y), getCell))
-                    matched(QPoint(x, y));
+                if (skip(pos))
+                    continue;
+
+                ++job.positionsTested;
+                if (matchAt(pos))
+                    onMatch(pos);
             }
+
+            return;
         }
+
+        if (rasterCells) {
+            const int modX = rule.options.modX;
+            const int count = job.startX <= rect.right() ? (rect.right() - job.startX) / modX + 1 : 0;
+            if (count == 0)
+                return;
+
+            const auto rowMatchesCapacity = job.rowMatches.capacity();
+            job.rowMatches.resize(size_t(count) * 3);
+            if (job.rowMatches.capacity() > rowMatchesCapacity)
+                ++job.allocations;
+
+            quint8 *matches = job.rowMatches.data();
+
+            for (int y = qMax(job.startY, rect.top()); y <= rect.bottom(); y += rule.options.modY) {
+                matchRowInRasters(inputSets, *rasterCells, *inputRasters,
+                                  QPoint(job.startX, y), modX, count,
+                                  matches, matches + count, matches + count * 2);
+
+                for (int i = 0; i < count; ++i) {
+                    const QPoint pos(job.startX + i * modX, y);
+                    if (skip(pos))
+                        continue;
+
+                    ++job.positionsTested;
+                    if (matches[i])
+                        onMatch(pos);
+                }
+            }
+
+            return;
+        }
+
+        for (int y = qMax(job.startY, rect.top()); y <= rect.bottom(); y += rule.options.modY) {
+            for (int x = job.startX; x <= rect.right(); x += rule.options.modX) {
+                if (skip(QPoint(x, y)))
+                    continue;
+
+                ++job.positionsTested;
+                if (matchRuleAtOffset(inputSets, inputLayers, QPoint(x, y), getCell))
+                    onMatch(QPoint(x, y));
+            }
+        }
+    };
+
+    qint64 matchCount = 0;
+    auto countMatch = [&] (QPoint pos) {
+        ++matchCount;
+        matched(pos);
+    };
+
+    if (split && jobCount > 1) {
+        TaskScheduler::blockingMap(jobsBegin, jobsEnd, [&] (MatchJob &job) {
+            const auto matchesCapacity = job.matches.capacity();
+            matchJob(job, [&] (QPoint pos) { job.matches.append(pos); });
+            if (job.matches.capacity() > matchesCapacity)
+                ++job.allocations;
+        });
+
+        // Report the matches in the same order as when matching serially
+        for (auto job = jobsBegin; job != jobsEnd; ++job)
+            for (const QPoint pos : std::as_const(job->matches))
+                countMatch(pos);
+    } else {
+        for (auto job = jobsBegin; job != jobsEnd; ++job)
+            matchJob(*job, countMatch);
+    }
+
+    RuleStatistics &statistics = mRuleStatistics[ruleIndex];
+    for (auto job = jobsBegin; job != jobsEnd; ++job) {
+        statistics.positionsTested += job->positionsTested;
+        allocations += job->allocations;
     }
+    statistics.matches += matchCount;
+    statistics.allocations += allocations;
 }
 
 void AutoMapper::applyRule(const Rule &rule, QPoint pos,
                            ApplyContext &applyContext,
                            AutoMappingContext &context) const
 {
-    // Translate the position to adjust to the location of the rule.
-    pos -= rule.inputRegion.boundingRect().topLeft();
-
     // If named output sets are given, choose one of them by chance
     const RuleOutputSet *randomOutputSet = nullptr;
-    if (!rule.outputSets.isEmpty())
-        randomOutputSet = &rule.outputSets.pick();
+    if (!rule.outputSets.isEmpty()) {
+        const size_t ruleIndex = &rule - mRules.data();
+        randomOutputSet = &rule.outputSets.pick(positionRandom(applyContext.randomSeed, ruleIndex, pos,
+                                                               RandomPurpose::OutputSet));
+    }
+
+    // Translate the position to adjust to the location of the rule.
+    pos -= rule.inputRegion.boundingRect().topLeft();
 
     if (rule.options.noOverlappingOutput) {
         QHash<const Layer*, QRegion> ruleRegionInLayer;
@@ -1366,13 +2236,17 @@ void AutoMapper::copyMapRegion(const Rule &rule, QPoint offset,
         if (!rule.options.ignoreLock && !toTileLayer->isUnlocked())
             continue;
 
-        if (!context.touchedTileLayers.isEmpty())
+        const bool trackChanges = !context.touchedTileLayers.isEmpty();
+        if (trackChanges)
             appendUnique<const TileLayer*>(context.touchedTileLayers, toTileLayer);
 
         for (const QRect &rect : rule.outputRegion) {
             copyTileRegion(tileOutput.tileLayer, rect, toTileLayer,
                            rect.x() + offset.x(), rect.y() + offset.y(),
                            context);
+
+            if (trackChanges)
+                context.changedTileRegions[tileOutput.name] |= rect.translated(offset);
         }
 
         applyLayerProperties(tileOutput.tileLayer, toTileLayer, context);
@@ -33,9 +33,11 @@
 #include <QRegion>
 #include <QSet>
 #include <QString>
+#include <QStringList>
 #include <QVector>
 
 #include <memory>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
@@ -159,6 +161,7 @@ struct RuleMapSetup
     std::vector<RuleOptionsArea> mRuleOptionsAreas;
 
     QSet<QString> mInputLayerNames;
+    QStringList mInputLayerList;    // sorted mInputLayerNames, see RuleInputLayer::inputLayer
     QSet<QString> mOutputTileLayerNames;
     QSet<QString> mOutputObjectGroupNames;
 
@@ -169,7 +172,7 @@ struct RuleMapSetup
 
 struct RuleInputLayer
 {
-    const TileLayer *targetLayer = nullptr;   // reference to layer in target map
+    int inputLayer = 0;     // index in RuleMapSetup::mInputLayerList
     int posCount = 0;
 };
 
@@ -223,6 +226,9 @@ struct RuleOutputSet
 
 struct CompileContext;
 struct ApplyContext;
+struct TileLocationIndex;
+struct InputRasters;
+struct MatchScratch;
 
 /**
  * A single context is used for running all active AutoMapper instances on a
@@ -259,6 +265,12 @@ struct TILED_EDITOR_EXPORT AutoMappingContext
     // Used to keep track of touched tile layers (only when initially non-empty)
     QVector<const TileLayer*> touchedTileLayers;
 
+    // The changed areas of tile layers by name, tracked along with touchedTileLayers
+    QHash<QString, QRegion> changedTileRegions;
+
+    // When set, overrides the RandomSeed property of the rules maps
+    std::optional<quint32> randomSeed;
+
 private:
     friend class AutoMapper;
 
@@ -312,6 +324,13 @@ public:
         bool matchInOrder = false;
         bool matchInOrderWasSet = false;
 
+        /**
+         * The seed used for random choices (SkipChance and the picking of
+         * output sets). When set, automapping gives reproducible results.
+         */
+        int randomSeed = 0;
+        bool randomSeedWasSet = false;
+
         /**
          * This variable determines, how many overlapping tiles should be used.
          * The bigger the more area is remapped at an automapping operation.
@@ -321,7 +340,26 @@ public:
         int autoMappingRadius = 0;
     };
 
-    using GetCell = const Cell &(*)(int x, int y, const TileLayer &tileLayer);
+    /**
+     * Statistics collected for a single rule, accumulated over all autoMap
+     * calls since the last call to resetRuleStatistics().
+     *
+     * Times are in nanoseconds.
+     */
+    struct RuleStatistics
+    {
+        QRect bounds;               // bounds of the rule in the rules map
+        qint64 compileTime = 0;
+        qint64 matchTime = 0;
+        qint64 applyTime = 0;
+        qint64 positionsTested = 0;
+        qint64 matches = 0;
+        qint64 allocations = 0;     // times the pooled scratch buffers had to grow
+
+        qint64 totalTime() const { return compileTime + matchTime + applyTime; }
+    };
+
+    using GetCell = Cell (*)(int x, int y, const TileLayer &tileLayer);
 
     /**
      * Constructs an AutoMapper.
@@ -371,6 +409,13 @@ public:
      */
     QString warningString() const { return mWarning; }
 
+    /**
+     * Returns the statistics for each rule, in the order the rules are
+     * applied.
+     */
+    const std::vector<RuleStatistics> &ruleStatistics() const { return mRuleStatistics; }
+    void resetRuleStatistics();
+
 private:
     struct Rule
     {
@@ -378,7 +423,7 @@ private:
         QRegion outputRegion;
         RuleOptions options;
         std::optional<RuleOutputSet> outputSet;
-        RandomPicker<RuleOutputSet> outputSets;
+        AliasRandomPicker<RuleOutputSet> outputSets;
     };
 
     void setupRuleMapProperties();
@@ -395,14 +440,27 @@ private:
     void setupRules();
 
     void setupWorkMapLayers(AutoMappingContext &context) const;
+    /**
+     * The compiled input sets of all rules, along with the state they were
+     * compiled for.
+     */
+    struct CompiledRules
+    {
+        QVector<SharedTileset> tilesets;
+        QVector<bool> inputLayersPresent;
+        std::vector<QVector<RuleInputSet>> inputSets;   // indexed like mRules
+    };
+
+    const CompiledRules &compiledRules(const QVector<bool> &inputLayersPresent) const;
     bool compileRule(QVector<RuleInputSet> &inputSets,
                      const Rule &rule,
-                     const AutoMappingContext &context) const;
+                     CompileContext &compileContext,
+                     const QVector<bool> &inputLayersPresent) const;
     bool compileInputSet(RuleInputSet &index,
                          const InputSet &inputSet,
                          const QRegion &inputRegion,
                          CompileContext &compileContext,
-                         const AutoMappingContext &context) const;
+                         const QVector<bool> &inputLayersPresent) const;
     bool compileOutputSet(RuleOutputSet &index,
                           const OutputSet &outputSet,
                           const QRegion &outputRegion) const;
@@ -438,11 +496,27 @@ private:
      * This goes through all the positions in \a matchRegion and checks if the
      * \a rule matches there.
      *
-     * Calls \a matched for each matching location.
+     * When a \a tileLocations index is given, it is used to only check the
+     * positions where the rule's most selective cells can be found.
+     *
+     * When \a inputRasters are given and contain all layers read by the
+     * rule, the cells are read from there instead of through \a getCell.
+     *
+     * When \a parallel is true, large regions are split into bands of rows
+     * that are matched on multiple threads. This is only possible when
+     * \a matched doesn't change the input layers.
+     *
+     * Calls \a matched for each matching location, in scanline order.
      */
     void matchRule(const Rule &rule,
+                   const QVector<RuleInputSet> &inputSets,
+                   const QVector<const TileLayer*> &inputLayers,
+                   const TileLocationIndex *tileLocations,
+                   const InputRasters *inputRasters,
                    const QRegion &matchRegion,
                    GetCell getCell,
+                   quint32 randomSeed,
+                   bool parallel,
                    const std::function<void (QPoint)> &matched,
                    const AutoMappingContext &context) const;
 
@@ -473,6 +547,29 @@ private:
      */
     std::vector<Rule> mRules;
 
+    /**
+     * Compiling the rules takes a while for large rules maps, so they are
+     * only compiled again when the rules map tilesets or the presence of the
+     * input layers in the target map changed.
+     */
+    mutable std::optional<CompiledRules> mCompiledRules;
+
+    /**
+     * Indexed like mRules. Only written for a given rule by the thread
+     * matching that rule.
+     */
+    mutable std::vector<RuleStatistics> mRuleStatistics;
+
+    /**
+     * Scratch buffers kept between autoMap calls, so that they don't need to
+     * be allocated again each time "AutoMap While Drawing" runs. The match
+     * scratch is indexed like mRules, since rules can be matched in parallel.
+     */
+    mutable std::unique_ptr<CompileContext> mCompileContext;
+    mutable std::unique_ptr<TileLocationIndex> mTileLocations;
+    mutable std::unique_ptr<InputRasters> mInputRasters;
+    mutable std::vector<std::unique_ptr<MatchScratch>> mMatchScratch;
+
     Options mOptions;
 
     /**
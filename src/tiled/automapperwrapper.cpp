@@ -33,23 +33,29 @@
 #include "tile.h"
 #include "tilelayer.h"
 
+#include <QElapsedTimer>
+
 using namespace Tiled;
 
 AutoMapperWrapper::AutoMapperWrapper(MapDocument *mapDocument,
                                      const QVector<const AutoMapper *> &autoMappers,
                                      const QRegion &where,
-                                     const TileLayer *touchedLayer)
+                                     const TileLayer *touchedLayer,
+                                     std::optional<quint32> randomSeed)
     : PaintTileLayer(mapDocument)
 {
     AutoMappingContext context(mapDocument);
+    context.randomSeed = randomSeed;
 
     for (const auto autoMapper : autoMappers)
         autoMapper->prepareAutoMap(context);
 
     // During "AutoMap while drawing", keep track of the touched layers, so we
     // can skip any rule maps that doesn't have these layers as input entirely.
-    if (touchedLayer)
+    if (touchedLayer) {
         context.touchedTileLayers.append(touchedLayer);
+        context.changedTileRegions.insert(touchedLayer->name(), where);
+    }
 
     // use a copy of the region, so each AutoMapper can manipulate it and the
     // following AutoMappers do see the impact
@@ -67,12 +73,19 @@ AutoMapperWrapper::AutoMapperWrapper(MapDocument *mapDocument,
         if (touchedLayer) {
             if (std::none_of(context.touchedTileLayers.cbegin(),
                              context.touchedTileLayers.cend(),
-                             [&] (const TileLayer *tileLayer) { return autoMapper->ruleLayerNameUsed(tileLayer->name()); }))
+                             [&] (const TileLayer *tileLayer) { return autoMapper->ruleLayerNameUsed(tileLayer->name()); })) {
+                mElapsed.append(-1);
                 continue;
+            }
         }
 
+        QElapsedTimer timer;
+        timer.start();
+
         autoMapper->autoMap(region, appliedRegionPtr, context);
 
+        mElapsed.append(timer.nsecsElapsed());
+
         if (appliedRegionPtr) {
             // expand where with modified area
             region |= std::exchange(appliedRegion, QRegion());
@@ -25,6 +25,8 @@
 
 #include <QVector>
 
+#include <optional>
+
 namespace Tiled {
 
 class AutoMapper;
@@ -42,7 +44,17 @@ public:
     AutoMapperWrapper(MapDocument *mapDocument,
                       const QVector<const AutoMapper *> &autoMappers,
                       const QRegion &where,
-                      const TileLayer *touchedLayer = nullptr);
+                      const TileLayer *touchedLayer = nullptr,
+                      std::optional<quint32> randomSeed = std::nullopt);
+
+    /**
+     * Returns the time in nanoseconds spent by each of the AutoMappers, or
+     * -1 for the ones that were skipped.
+     */
+    const QVector<qint64> &elapsed() const { return mElapsed; }
+
+private:
+    QVector<qint64> mElapsed;
 };
 
 } // namespace Tiled
@@ -30,15 +30,83 @@
 #include "projectmanager.h"
 #include "tilelayer.h"
 
+#include <QDateTime>
 #include <QDir>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
+#include <QHash>
 #include <QScopeGuard>
 #include <QScopedValueRollback>
+#include <QSet>
 #include <QTextStream>
 
+#include <algorithm>
+
 using namespace Tiled;
 
+namespace {
+
+/**
+ * Keeps track of the rule maps loaded by any AutomappingManager, so that
+ * when several documents use the same rule maps, these are only loaded and
+ * compiled once. A rule map is loaded again when its modification time
+ * changed.
+ *
+ * Only weak references are stored, so that a rule map is released once no
+ * document uses it anymore. Only used from the main thread.
+ */
+class RuleMapCache
+{
+public:
+    static std::shared_ptr<AutoMapper> find(const QString &filePath,
+                                            const QDateTime &lastModified);
+    static void insert(const QString &filePath,
+                       const QDateTime &lastModified,
+                       const std::shared_ptr<AutoMapper> &autoMapper);
+
+private:
+    struct Entry
+    {
+        QDateTime lastModified;
+        std::weak_ptr<AutoMapper> autoMapper;
+    };
+
+    static QHash<QString, Entry> &entries()
+    {
+        static QHash<QString, Entry> entries;
+        return entries;
+    }
+};
+
+std::shared_ptr<AutoMapper> RuleMapCache::find(const QString &filePath,
+                                               const QDateTime &lastModified)
+{
+    const auto it = entries().constFind(filePath);
+    if (it == entries().constEnd() || it->lastModified != lastModified)
+        return {};
+
+    return it->autoMapper.lock();
+}
+
+void RuleMapCache::insert(const QString &filePath,
+                          const QDateTime &lastModified,
+                          const std::shared_ptr<AutoMapper> &autoMapper)
+{
+    auto &entries = RuleMapCache::entries();
+
+    // Drop the entries of rule maps that are no longer used
+    for (auto it = entries.begin(); it != entries.end(); ) {
+        if (it->autoMapper.expired())
+            it = entries.erase(it);
+        else
+            ++it;
+    }
+
+    entries.insert(filePath, Entry { lastModified, autoMapper });
+}
+
+} // anonymous namespace
+
 SessionOption<bool> AutomappingManager::automappingWhileDrawing { "automapping.whileDrawing", false };
 
 AutomappingManager::AutomappingManager(QObject *parent)
@@ -103,6 +171,7 @@ void AutomappingManager::autoMapInternal(const QRegion &where,
 {
     mError.clear();
     mWarning.clear();
+    mLastTimings.clear();
 
     if (!mMapDocument)
         return;
@@ -157,16 +226,159 @@ void AutomappingManager::autoMapInternal(const QRegion &where,
             return;
     }
 
-    AutoMapperWrapper *aw = new AutoMapperWrapper(mMapDocument, autoMappers, where, touchedLayer);
+    // The rules can only match stored chunks that are in memory. While
+    // drawing, loading those around the changed area is enough.
+    Map *map = mMapDocument->map();
+    if (map->hasPagedOutChunks()) {
+        if (automatic) {
+            const int margin = CHUNK_SIZE * 2;
+            const QRect area = where.boundingRect().adjusted(-margin, -margin, margin, margin);
+            for (Layer *layer : map->tileLayers()) {
+                auto tileLayer = static_cast<TileLayer*>(layer);
+                tileLayer->pageIn(area.translated(-tileLayer->position()));
+            }
+        } else {
+            map->pageInAllChunks();
+        }
+    }
+
+    AutoMapperWrapper *aw = new AutoMapperWrapper(mMapDocument, autoMappers, where, touchedLayer, mRandomSeed);
     aw->setMergeable(automatic);
     aw->setText(tr("Apply AutoMap rules"));
 
+    for (int i = 0; i < autoMappers.size(); ++i) {
+        if (aw->elapsed().at(i) >= 0)
+            mLastTimings.append({ autoMappers.at(i)->rulesMapFileName(), aw->elapsed().at(i) });
+    }
+
     mMapDocument->undoStack()->push(aw);
 }
 
+/**
+ * Calls \a callback for each loaded AutoMapper, in the order they are
+ * referenced by the rules file.
+ */
+template<typename Callback>
+static void forEachLoadedAutoMapper(const QVector<RuleMapReference> &references,
+                                    const std::unordered_map<QString, std::shared_ptr<AutoMapper>> &autoMappers,
+                                    Callback callback)
+{
+    QSet<QString> seen;
+    for (const RuleMapReference &reference : references) {
+        if (seen.contains(reference.filePath))
+            continue;
+        seen.insert(reference.filePath);
+
+        auto it = autoMappers.find(reference.filePath);
+        if (it != autoMappers.end())
+            callback(*it->second);
+    }
+}
+
+static double toMilliseconds(qint64 nsecs)
+{
+    return nsecs / 1000000.0;
+}
+
+QVariantList AutomappingManager::ruleStatistics() const
+{
+    QVariantList result;
+
+    forEachLoadedAutoMapper(mRuleMapReferences, mLoadedAutoMappers, [&] (const AutoMapper &autoMapper) {
+        const auto &statistics = autoMapper.ruleStatistics();
+        for (size_t i = 0; i < statistics.size(); ++i) {
+            const AutoMapper::RuleStatistics &rule = statistics[i];
+            result.append(QVariantMap {
+                { QStringLiteral("rulesMap"), autoMapper.rulesMapFileName() },
+                { QStringLiteral("rule"), static_cast<int>(i) },
+                { QStringLiteral("x"), rule.bounds.x() },
+                { QStringLiteral("y"), rule.bounds.y() },
+                { QStringLiteral("width"), rule.bounds.width() },
+                { QStringLiteral("height"), rule.bounds.height() },
+                { QStringLiteral("compileTime"), toMilliseconds(rule.compileTime) },
+                { QStringLiteral("matchTime"), toMilliseconds(rule.matchTime) },
+                { QStringLiteral("applyTime"), toMilliseconds(rule.applyTime) },
+                { QStringLiteral("positionsTested"), rule.positionsTested },
+                { QStringLiteral("matches"), rule.matches },
+                { QStringLiteral("allocations"), rule.allocations },
+            });
+        }
+    });
+
+    return result;
+}
+
+QString AutomappingManager::ruleStatisticsReport(int maxRules) const
+{
+    struct Entry
+    {
+        const AutoMapper *autoMapper;
+        size_t index;
+    };
+
+    QVector<Entry> entries;
+
+    forEachLoadedAutoMapper(mRuleMapReferences, mLoadedAutoMappers, [&] (const AutoMapper &autoMapper) {
+        for (size_t i = 0; i < autoMapper.ruleStatistics().size(); ++i)
+            entries.append({ &autoMapper, i });
+    });
+
+    auto statistics = [] (const Entry &entry) -> const AutoMapper::RuleStatistics & {
+        return entry.autoMapper->ruleStatistics()[entry.index];
+    };
+
+    std::stable_sort(entries.begin(), entries.end(), [&] (const Entry &a, const Entry &b) {
+        return statistics(a).totalTime() > statistics(b).totalTime();
+    });
+
+    QString report;
+    QTextStream stream(&report);
+
+    stream << tr("AutoMapping statistics (times in ms, slowest rules first):") << '\n';
+    stream << QStringLiteral("%1 %2 %3 %4 %5 %6 %7  %8")
+              .arg(tr("Compile"), 9)
+              .arg(tr("Match"), 9)
+              .arg(tr("Apply"), 9)
+              .arg(tr("Tested"), 10)
+              .arg(tr("Matches"), 8)
+              .arg(tr("Allocs"), 7)
+              .arg(tr("Rule"), -16)
+              .arg(tr("Rules map")) << '\n';
+
+    for (const Entry &entry : entries.mid(0, maxRules)) {
+        const AutoMapper::RuleStatistics &rule = statistics(entry);
+        const QString ruleLocation = QStringLiteral("#%1 (%2,%3)")
+                .arg(entry.index).arg(rule.bounds.x()).arg(rule.bounds.y());
+
+        stream << QStringLiteral("%1 %2 %3 %4 %5 %6 %7  %8")
+                  .arg(toMilliseconds(rule.compileTime), 9, 'f', 2)
+                  .arg(toMilliseconds(rule.matchTime), 9, 'f', 2)
+                  .arg(toMilliseconds(rule.applyTime), 9, 'f', 2)
+                  .arg(rule.positionsTested, 10)
+                  .arg(rule.matches, 8)
+                  .arg(rule.allocations, 7)
+                  .arg(ruleLocation, -16)
+                  .arg(QFileInfo(entry.autoMapper->rulesMapFileName()).fileName()) << '\n';
+    }
+
+    if (entries.size() > maxRules)
+        stream << tr("(%n more rule(s) not shown)", nullptr, static_cast<int>(entries.size() - maxRules)) << '\n';
+
+    return report;
+}
+
+void AutomappingManager::resetRuleStatistics()
+{
+    for (auto &[fileName, autoMapper] : mLoadedAutoMappers)
+        autoMapper->resetRuleStatistics();
+}
+
 /**
  * Returns the AutoMapper instance for the given rules file, loading it if
  * necessary. Returns nullptr if the file could not be loaded.
+ *
+ * When another document already loaded an up-to-date instance for this file,
+ * that instance is shared.
  */
 const AutoMapper *AutomappingManager::findAutoMapper(const QString &filePath)
 {
@@ -174,9 +386,22 @@ const AutoMapper *AutomappingManager::findAutoMapper(const QString &filePath)
     if (it != mLoadedAutoMappers.end())
         return it->second.get();
 
-    auto autoMapper = loadRuleMap(filePath);
-    if (!autoMapper)
-        return nullptr;
+    // Determined before loading, so that changes while loading cause a reload
+    const QDateTime lastModified = QFileInfo(filePath).lastModified();
+
+    auto autoMapper = RuleMapCache::find(filePath, lastModified);
+    if (autoMapper) {
+        mWatcher.addPath(filePath);
+
+        mWarning += autoMapper->warningString();
+        mError += autoMapper->errorString();
+    } else {
+        autoMapper = loadRuleMap(filePath);
+        if (!autoMapper)
+            return nullptr;
+
+        RuleMapCache::insert(filePath, lastModified, autoMapper);
+    }
 
     auto result = mLoadedAutoMappers.emplace(filePath, std::move(autoMapper));
     return result.first->second.get();
@@ -269,7 +494,7 @@ bool AutomappingManager::loadRulesFile(const QString &filePath)
     return ret;
 }
 
-std::unique_ptr<AutoMapper> AutomappingManager::loadRuleMap(const QString &filePath)
+std::shared_ptr<AutoMapper> AutomappingManager::loadRuleMap(const QString &filePath)
 {
     QString errorString;
     auto rulesMap = readMap(filePath, &errorString);
@@ -285,7 +510,7 @@ std::unique_ptr<AutoMapper> AutomappingManager::loadRuleMap(const QString &fileP
 
     mWatcher.addPath(filePath);
 
-    auto autoMapper = std::make_unique<AutoMapper>(std::move(rulesMap));
+    auto autoMapper = std::make_shared<AutoMapper>(std::move(rulesMap));
 
     mWarning += autoMapper->warningString();
     const QString error = autoMapper->errorString();
@@ -28,8 +28,11 @@
 #include <QRegion>
 #include <QRegularExpression>
 #include <QString>
+#include <QVariant>
+#include <QVector>
 
 #include <memory>
+#include <optional>
 #include <unordered_map>
 
 namespace Tiled {
@@ -72,6 +75,38 @@ public:
     void autoMap();
     void autoMapRegion(const QRegion &region);
 
+    /**
+     * Sets the seed used for random choices, overriding the RandomSeed
+     * property of the rules maps.
+     */
+    void setRandomSeed(std::optional<quint32> seed) { mRandomSeed = seed; }
+
+    struct RuleMapTiming
+    {
+        QString rulesMapFileName;
+        qint64 elapsed;     // in nanoseconds
+    };
+
+    /**
+     * Returns how long each of the rule maps took during the last run.
+     */
+    const QVector<RuleMapTiming> &lastTimings() const { return mLastTimings; }
+
+    /**
+     * Returns the statistics collected for each rule of the loaded rule
+     * maps since the last call to resetRuleStatistics(), as a list of maps
+     * for use in scripts.
+     */
+    QVariantList ruleStatistics() const;
+
+    /**
+     * Returns the collected rule statistics as a plain text table, with the
+     * rules taking the most time first. At most \a maxRules are listed.
+     */
+    QString ruleStatisticsReport(int maxRules = 50) const;
+
+    void resetRuleStatistics();
+
     static SessionOption<bool> automappingWhileDrawing;
 
 signals:
@@ -94,7 +129,7 @@ private:
 
     bool loadFile(const QString &filePath);
     bool loadRulesFile(const QString &filePath);
-    std::unique_ptr<AutoMapper> loadRuleMap(const QString &filePath);
+    std::shared_ptr<AutoMapper> loadRuleMap(const QString &filePath);
 
     /**
      * Applies automapping to the region \a where.
@@ -114,11 +149,17 @@ private:
      */
     MapDocument *mMapDocument = nullptr;
 
+    std::optional<quint32> mRandomSeed;
+    QVector<RuleMapTiming> mLastTimings;
+
     /**
      * For each rule map referenced by the rules file a new AutoMapper is
      * setup. In this map we store all loaded AutoMappers instances.
+     *
+     * The AutoMapper instances are shared with the managers of other
+     * documents using the same rule maps (see RuleMapCache).
      */
-    std::unordered_map<QString, std::unique_ptr<AutoMapper>> mLoadedAutoMappers;
+    std::unordered_map<QString, std::shared_ptr<AutoMapper>> mLoadedAutoMappers;
 
     /**
      * The active list of rule map references, in the order they were
@@ -54,6 +54,22 @@ QList<MapObject*> objectsInRegion(const MapRenderer &renderer,
 {
     QList<MapObject*> objectsToErase;
 
+    // For orthogonal and isometric maps, the conversion between pixels and
+    // tiles is a plain scale, so the spatial index of the object group can be
+    // used to find the candidates. One tile is added on each side to account
+    // for the rounding in objectTileRect.
+    const Map::Orientation orientation = renderer.map()->orientation();
+    if (orientation == Map::Orthogonal || orientation == Map::Isometric) {
+        const QRectF tileRect = QRectF(where.boundingRect()).adjusted(-1, -1, 1, 1);
+        const QRectF pixelRect = renderer.tileToPixelCoords(tileRect).normalized();
+
+        for (MapObject *object : layer->objectsIntersecting(pixelRect))
+            if (where.intersects(objectTileRect(renderer, *object)))
+                objectsToErase.append(object);
+
+        return objectsToErase;
+    }
+
     for (MapObject *object : layer->objects()) {
         const QRect tileRect = objectTileRect(renderer, *object);
         if (where.intersects(tileRect))
@@ -0,0 +1,353 @@
+/*
+ * batchoperation.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "batchoperation.h"
+
+#include "documentmanager.h"
+#include "map.h"
+#include "mapformat.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "pluginmanager.h"
+#include "tilelayer.h"
+#include "tracing.h"
+
+#include <QDir>
+#include <QFutureWatcher>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+namespace Tiled {
+
+/**
+ * Returns the external tileset of the \a map with the given file name.
+ */
+static SharedTileset findTileset(const Map &map, const QString &fileName)
+{
+    const QString cleanFileName = QDir::cleanPath(fileName);
+
+    for (const SharedTileset &tileset : map.tilesets())
+        if (tileset->isExternal() && QDir::cleanPath(tileset->fileName()) == cleanFileName)
+            return tileset;
+
+    return SharedTileset();
+}
+
+FindTileUsesOperation::FindTileUsesOperation(const QString &tilesetFileName, int tileId)
+    : mTilesetFileName(tilesetFileName)
+    , mTileId(tileId)
+{}
+
+int FindTileUsesOperation::apply(Map &map) const
+{
+    const SharedTileset tileset = findTileset(map, mTilesetFileName);
+    if (!tileset)
+        return 0;
+
+    auto matches = [&] (const Cell &cell) {
+        return cell.tileset() == tileset.data() &&
+                (mTileId == -1 || cell.tileId() == mTileId);
+    };
+
+    int uses = 0;
+
+    for (Layer *layer : map.allLayers()) {
+        if (TileLayer *tileLayer = layer->asTileLayer()) {
+            for (auto it = tileLayer->begin(), end = tileLayer->end(); it != end; ++it)
+                if (matches(it.value()))
+                    ++uses;
+        } else if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
+            for (const MapObject *object : objectGroup->objects())
+                if (matches(object->cell()))
+                    ++uses;
+        }
+    }
+
+    return uses;
+}
+
+ReplaceTilesetOperation::ReplaceTilesetOperation(const QString &tilesetFileName,
+                                                 const SharedTileset &newTileset)
+    : mTilesetFileName(tilesetFileName)
+    , mNewTileset(newTileset)
+{}
+
+int ReplaceTilesetOperation::apply(Map &map) const
+{
+    const SharedTileset tileset = findTileset(map, mTilesetFileName);
+    if (!tileset || tileset == mNewTileset)
+        return 0;
+
+    map.replaceTileset(tileset, mNewTileset);
+    return 1;
+}
+
+
+BatchOperationRunner::BatchOperationRunner(std::shared_ptr<const BatchOperation> operation,
+                                           QObject *parent)
+    : QObject(parent)
+    , mOperation(std::move(operation))
+{}
+
+/**
+ * Blocks until the maps that are currently being processed are done, since
+ * their jobs refer to this runner.
+ */
+BatchOperationRunner::~BatchOperationRunner()
+{
+    mPendingFiles.clear();
+
+    const auto watchers = findChildren<QFutureWatcherBase*>();
+    for (QFutureWatcherBase *watcher : watchers)
+        watcher->waitForFinished();
+}
+
+/**
+ * Starts applying the operation to the given files. Files that are not maps
+ * are skipped.
+ */
+void BatchOperationRunner::start(const QStringList &fileNames)
+{
+    Q_ASSERT(!mRunning);
+
+    mPendingFiles = fileNames;
+    mResults.clear();
+    mRunning = true;
+    mTimer.start();
+
+    startJobs();
+}
+
+/**
+ * Stops processing any maps that haven't been started yet. The finished()
+ * signal is emitted once the current maps are done.
+ */
+void BatchOperationRunner::cancel()
+{
+    mPendingFiles.clear();
+
+    if (mRunning && mRunningJobs == 0) {
+        mRunning = false;
+        emit finished();
+    }
+}
+
+/**
+ * Maps are written one at a time, since a file format may not be used by
+ * more than one thread. When the editor is running, this is the thread that
+ * also saves documents in the background.
+ */
+static QThreadPool *writeThreadPool()
+{
+    if (DocumentManager *documentManager = DocumentManager::maybeInstance())
+        return documentManager->saveThreadPool();
+
+    struct WriteThreadPool : QThreadPool
+    {
+        WriteThreadPool() { setMaxThreadCount(1); }
+    };
+
+    static WriteThreadPool threadPool;
+    return &threadPool;
+}
+
+static MapFormat *findReaderFormat(const QString &fileName)
+{
+    return PluginManager::find<MapFormat>([&] (MapFormat *format) {
+        return format->hasCapabilities(FileFormat::Read) && format->supportsFile(fileName);
+    });
+}
+
+/**
+ * Starts parsing the next pending files. The number of maps in flight is
+ * limited, since each of them is kept in memory until it has been saved.
+ */
+void BatchOperationRunner::startJobs()
+{
+    const int maxRunningJobs = QThread::idealThreadCount() * 2;
+
+    while (mRunningJobs < maxRunningJobs && !mPendingFiles.isEmpty()) {
+        auto job = std::make_shared<Job>();
+        job->result.fileName = mPendingFiles.takeFirst();
+
+        // The format is looked up here, since not all formats can be used
+        // from other threads
+        job->format = findReaderFormat(job->result.fileName);
+        if (!job->format)
+            continue;   // not a map
+
+        DocumentManager *documentManager = DocumentManager::maybeInstance();
+        if (documentManager && documentManager->findDocument(job->result.fileName) != -1) {
+            job->result.status = BatchOperationResult::Skipped;
+            job->result.message = tr("Map is open in the editor");
+            addResult(job->result);
+            continue;
+        }
+
+        if (mOperation->modifiesMaps() && !job->format->hasCapabilities(FileFormat::Write)) {
+            job->result.status = BatchOperationResult::Skipped;
+            job->result.message = tr("File format doesn't support writing");
+            addResult(job->result);
+            continue;
+        }
+
+        ++mRunningJobs;
+
+        auto watcher = new QFutureWatcher<void>(this);
+        connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, job] {
+            watcher->deleteLater();
+            readMap(job);
+        });
+
+        // The worker only gets a raw pointer, so that the map is always
+        // destroyed on this thread
+        Job *j = job.get();
+        watcher->setFuture(QtConcurrent::run([j] {
+            TILED_TRACE_SCOPE("BatchOperationRunner::parseMap");
+
+            QElapsedTimer timer;
+            timer.start();
+            j->parsed = MapCache::parseMap(j->format, j->result.fileName);
+            j->result.loadTime = timer.elapsed();
+        }));
+    }
+
+    if (mRunning && mRunningJobs == 0 && mPendingFiles.isEmpty()) {
+        mRunning = false;
+        emit finished();
+    }
+}
+
+/**
+ * Creates the parsed map on the main thread and starts applying the
+ * operation on a worker thread.
+ */
+void BatchOperationRunner::readMap(const std::shared_ptr<Job> &job)
+{
+    TILED_TRACE_SCOPE("BatchOperationRunner::readMap");
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QString error;
+    job->map = MapCache::readMap(job->format, job->result.fileName, &error, &job->parsed);
+    job->parsed = MapCache::Parsed();
+    job->result.loadTime += timer.elapsed();
+
+    if (!job->map) {
+        job->result.status = BatchOperationResult::Failed;
+        job->result.message = error;
+        finishJob(job);
+        return;
+    }
+
+    job->writeInBackground = job->format->hasCapabilities(FileFormat::WriteInBackground);
+
+    auto watcher = new QFutureWatcher<void>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, job] {
+        watcher->deleteLater();
+        applyFinished(job);
+    });
+
+    Job *j = job.get();
+    watcher->setFuture(QtConcurrent::run([j, operation = mOperation] {
+        TILED_TRACE_SCOPE("BatchOperationRunner::apply");
+
+        QElapsedTimer timer;
+        timer.start();
+        j->result.changes = operation->apply(*j->map);
+        j->result.applyTime = timer.elapsed();
+    }));
+}
+
+/**
+ * Saves the map when the operation changed it. When its format supports it,
+ * the map is written on the write thread, otherwise it is written here.
+ */
+void BatchOperationRunner::applyFinished(const std::shared_ptr<Job> &job)
+{
+    BatchOperationResult &result = job->result;
+    const bool needsSave = result.changes > 0 && mOperation->modifiesMaps();
+
+    if (!needsSave) {
+        finishJob(job);
+        return;
+    }
+
+    if (!job->writeInBackground) {
+        QElapsedTimer timer;
+        timer.start();
+        result.saved = job->format->write(job->map.get(), result.fileName);
+        result.saveTime = timer.elapsed();
+
+        if (!result.saved)
+            result.message = job->format->errorString();
+
+        finishJob(job);
+        return;
+    }
+
+    auto watcher = new QFutureWatcher<void>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, job] {
+        watcher->deleteLater();
+        finishJob(job);
+    });
+
+    // The error is taken while still on the write thread, since the next
+    // write replaces it
+    Job *j = job.get();
+    watcher->setFuture(QtConcurrent::run(writeThreadPool(), [j] {
+        TILED_TRACE_SCOPE("BatchOperationRunner::write");
+
+        QElapsedTimer timer;
+        timer.start();
+        j->result.saved = j->format->write(j->map.get(), j->result.fileName);
+        j->result.saveTime = timer.elapsed();
+
+        if (!j->result.saved)
+            j->result.message = j->format->errorString();
+    }));
+}
+
+void BatchOperationRunner::finishJob(const std::shared_ptr<Job> &job)
+{
+    BatchOperationResult &result = job->result;
+    if (result.status == BatchOperationResult::Done &&
+            result.changes > 0 && mOperation->modifiesMaps() && !result.saved) {
+        result.status = BatchOperationResult::Failed;
+    }
+
+    job->map.reset();
+    --mRunningJobs;
+
+    addResult(job->result);
+    startJobs();
+}
+
+void BatchOperationRunner::addResult(const BatchOperationResult &result)
+{
+    mResults.append(result);
+    emit fileFinished(result);
+}
+
+} // namespace Tiled
+
+#include "moc_batchoperation.cpp"
@@ -0,0 +1,176 @@
+/*
+ * batchoperation.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mapcache.h"
+#include "tileset.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+#include <memory>
+
+namespace Tiled {
+
+class Map;
+class MapFormat;
+
+/**
+ * An operation applied by BatchOperationRunner to a number of maps.
+ *
+ * Operations work on the Map directly rather than on a MapDocument, so that
+ * the maps don't need to be opened in the editor. They are applied on worker
+ * threads, so apply() may only change the given map.
+ */
+class BatchOperation
+{
+public:
+    virtual ~BatchOperation() = default;
+
+    /**
+     * Applies the operation to the given \a map. Returns the number of
+     * changes made or, for operations that don't modify maps, the number of
+     * matches found.
+     */
+    virtual int apply(Map &map) const = 0;
+
+    /**
+     * Returns whether maps for which apply() reported changes need to be
+     * saved.
+     */
+    virtual bool modifiesMaps() const { return true; }
+};
+
+/**
+ * Counts the tiles and tile objects using the tileset with the given file
+ * name, or only a specific tile from it.
+ */
+class FindTileUsesOperation : public BatchOperation
+{
+public:
+    explicit FindTileUsesOperation(const QString &tilesetFileName, int tileId = -1);
+
+    int apply(Map &map) const override;
+    bool modifiesMaps() const override { return false; }
+
+private:
+    QString mTilesetFileName;
+    int mTileId;
+};
+
+/**
+ * Replaces the tileset with the given file name by another tileset, using
+ * Map::replaceTileset.
+ */
+class ReplaceTilesetOperation : public BatchOperation
+{
+public:
+    ReplaceTilesetOperation(const QString &tilesetFileName,
+                            const SharedTileset &newTileset);
+
+    int apply(Map &map) const override;
+
+private:
+    QString mTilesetFileName;
+    SharedTileset mNewTileset;
+};
+
+struct BatchOperationResult
+{
+    enum Status {
+        Done,
+        Skipped,
+        Failed
+    };
+
+    QString fileName;
+    Status status = Done;
+    QString message;        // reason for skipping or failing
+    int changes = 0;        // as returned by BatchOperation::apply
+    bool saved = false;
+
+    // Timing in milliseconds
+    qint64 loadTime = 0;
+    qint64 applyTime = 0;
+    qint64 saveTime = 0;
+};
+
+/**
+ * Applies a BatchOperation to a list of maps, without opening them in the
+ * editor.
+ *
+ * Several maps are processed in parallel. Each map is parsed on a worker
+ * thread, created on the main thread (since its tilesets are loaded through
+ * the TilesetManager) and then handed back to a worker thread to apply the
+ * operation. Changed maps are written one at a time on the thread used for
+ * saving documents in the background, when their format supports it, since
+ * file formats can't be used by several threads at once. Maps that are open
+ * in the editor are skipped, since their document would get out of sync with
+ * the file.
+ */
+class BatchOperationRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BatchOperationRunner(std::shared_ptr<const BatchOperation> operation,
+                                  QObject *parent = nullptr);
+    ~BatchOperationRunner() override;
+
+    void start(const QStringList &fileNames);
+    void cancel();
+
+    bool isRunning() const { return mRunning; }
+    qint64 elapsed() const { return mTimer.elapsed(); }
+
+    const QVector<BatchOperationResult> &results() const { return mResults; }
+
+signals:
+    void fileFinished(const BatchOperationResult &result);
+    void finished();
+
+private:
+    struct Job
+    {
+        BatchOperationResult result;
+        MapFormat *format = nullptr;
+        MapCache::Parsed parsed;
+        std::unique_ptr<Map> map;
+        bool writeInBackground = false;
+    };
+
+    void startJobs();
+    void readMap(const std::shared_ptr<Job> &job);
+    void applyFinished(const std::shared_ptr<Job> &job);
+    void finishJob(const std::shared_ptr<Job> &job);
+    void addResult(const BatchOperationResult &result);
+
+    const std::shared_ptr<const BatchOperation> mOperation;
+    QStringList mPendingFiles;
+    QVector<BatchOperationResult> mResults;
+    int mRunningJobs = 0;
+    bool mRunning = false;
+    QElapsedTimer mTimer;
+};
+
+} // namespace Tiled
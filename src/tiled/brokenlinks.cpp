@@ -99,6 +99,12 @@ BrokenLinksModel::BrokenLinksModel(QObject *parent)
     : QAbstractListModel(parent)
     , mDocument(nullptr)
 {
+    mRefreshTimer.setSingleShot(true);
+    connect(&mRefreshTimer, &QTimer::timeout, this, &BrokenLinksModel::refresh);
+
+    // Tileset images may finish loading after the document was opened
+    connect(TilesetManager::instance(), &TilesetManager::tilesetImagesChanged,
+            this, &BrokenLinksModel::scheduleRefresh);
 }
 
 void BrokenLinksModel::setDocument(Document *document)
@@ -126,7 +132,7 @@ void BrokenLinksModel::setDocument(Document *document)
             connect(mapDocument, &MapDocument::tilesetRemoved,
                     this, &BrokenLinksModel::tilesetRemoved);
             connect(mapDocument, &MapDocument::objectTemplateReplaced,
-                    this, &BrokenLinksModel::refresh);
+                    this, &BrokenLinksModel::scheduleRefresh);
 
             for (const SharedTileset &tileset : mapDocument->map()->tilesets())
                 connectToTileset(tileset);
@@ -142,6 +148,8 @@ void BrokenLinksModel::setDocument(Document *document)
 
 void BrokenLinksModel::refresh()
 {
+    mRefreshTimer.stop();
+
     if (mDocument)
         mDocument->checkIssues();
 
@@ -244,6 +252,16 @@ void BrokenLinksModel::refresh()
         emit hasBrokenLinksChanged(brokenLinksAfter);
 }
 
+/**
+ * Refreshes the model once control returns to the event loop, so that many
+ * changes in a row, like tileset images finishing to load, cause only a
+ * single refresh.
+ */
+void BrokenLinksModel::scheduleRefresh()
+{
+    mRefreshTimer.start();
+}
+
 int BrokenLinksModel::rowCount(const QModelIndex &parent) const
 {
     return parent.isValid() ? 0 : mBrokenLinks.count();
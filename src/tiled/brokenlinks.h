@@ -24,6 +24,7 @@
 #include "tileset.h"
 
 #include <QAbstractListModel>
+#include <QTimer>
 #include <QWidget>
 
 class QAbstractButton;
@@ -77,6 +78,7 @@ public:
     Document *document() const;
 
     void refresh();
+    void scheduleRefresh();
     bool hasBrokenLinks() const;
 
     const BrokenLink &brokenLink(int index) const;
@@ -105,6 +107,7 @@ private:
 
     Document *mDocument;
     QVector<BrokenLink> mBrokenLinks;
+    QTimer mRefreshTimer;
 };
 
 
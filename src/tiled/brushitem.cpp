@@ -32,8 +32,13 @@
 #include <QStyleOptionGraphicsItem>
 #include <QUndoStack>
 
+#include <QtMath>
+
 using namespace Tiled;
 
+// Larger stamps are drawn directly, limited to the exposed area
+static constexpr int MaxCacheSize = 2048;
+
 BrushItem::BrushItem():
     mMapDocument(nullptr)
 {
@@ -62,6 +67,7 @@ void BrushItem::clear()
     mTileLayer.clear();
     mMap.clear();
     mRegion = QRegion();
+    clearCache();
 
     updateBoundingRect();
     update();
@@ -81,10 +87,16 @@ void BrushItem::setTileLayer(const SharedTileLayer &tileLayer)
  * Sets a tile layer as well as the region that should be highlighted along
  * with it. This allows highlighting of areas that are not covered by tiles in
  * the given tile layer.
+ *
+ * The rendered brush is cached for as long as the same tile layer is set, so
+ * it should not be changed other than by moving it.
  */
 void BrushItem::setTileLayer(const SharedTileLayer &tileLayer,
                              const QRegion &region)
 {
+    if (mTileLayer != tileLayer)
+        clearCache();
+
     mTileLayer = tileLayer;
     mRegion = region;
 
@@ -97,8 +109,17 @@ void BrushItem::setMap(const SharedMap &map)
     setMap(map, map->modifiedTileRegion());
 }
 
+/**
+ * Sets a map as well as the region that should be highlighted along with it.
+ *
+ * The rendered brush is cached for as long as the same map is set, so its
+ * layers should not be changed other than by moving them.
+ */
 void BrushItem::setMap(const SharedMap &map, const QRegion &region)
 {
+    if (mMap != map)
+        clearCache();
+
     mMap = map;
     mRegion = region;
 
@@ -176,27 +197,122 @@ void BrushItem::paint(QPainter *painter,
         outsideMapRegion = mRegion.subtracted(mapRegion);
     }
 
+    // When the whole region is highlighted in the same color, the brush is
+    // rendered once and then only moved around
+    if (insideMapRegion.isEmpty() || outsideMapRegion.isEmpty()) {
+        const QColor &highlight = insideMapRegion.isEmpty() ? outsideMapHighlight
+                                                            : insideMapHighlight;
+        if (paintCached(painter, highlight))
+            return;
+    }
+
+    drawStamp(painter, option->exposedRect);
+
+    const MapRenderer *renderer = mMapDocument->renderer();
+    renderer->drawTileSelection(painter, insideMapRegion,
+                                insideMapHighlight,
+                                option->exposedRect);
+    renderer->drawTileSelection(painter, outsideMapRegion,
+                                outsideMapHighlight,
+                                option->exposedRect);
+}
+
+void BrushItem::drawStamp(QPainter *painter, const QRectF &exposed) const
+{
     const MapRenderer *renderer = mMapDocument->renderer();
     if (mTileLayer) {
         const qreal opacity = painter->opacity();
         painter->setOpacity(0.75);
-        renderer->drawTileLayer(painter, mTileLayer.data(), option->exposedRect);
+        renderer->drawTileLayer(painter, mTileLayer.data(), exposed);
         painter->setOpacity(opacity);
     } else if (mMap) {
         const qreal opacity = painter->opacity();
         painter->setOpacity(0.75);
         LayerIterator it(mMap.data(), Layer::TileLayerType);
         while (auto tileLayer = static_cast<TileLayer*>(it.next()))
-            renderer->drawTileLayer(painter, tileLayer, option->exposedRect);
+            renderer->drawTileLayer(painter, tileLayer, exposed);
         painter->setOpacity(opacity);
     }
+}
 
-    renderer->drawTileSelection(painter, insideMapRegion,
-                                insideMapHighlight,
-                                option->exposedRect);
-    renderer->drawTileSelection(painter, outsideMapRegion,
-                                outsideMapHighlight,
-                                option->exposedRect);
+/**
+ * Paints the brush from a cached pixmap, which is rendered again only when
+ * the brush, the zoom level or the highlight color changed. When the brush
+ * was merely moved, the pixmap is drawn at the new location.
+ *
+ * Returns false when the brush can't be cached, for example because it is
+ * too large.
+ */
+bool BrushItem::paintCached(QPainter *painter, const QColor &highlight)
+{
+    const QTransform transform = painter->transform();
+    if (transform.type() > QTransform::TxScale || transform.m11() != transform.m22())
+        return false;
+
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const qreal scale = transform.m11();
+    const qreal pixelRatio = painter->device()->devicePixelRatioF();
+    const QPoint tilePos = mRegion.boundingRect().topLeft();
+    const QPoint tileOffset = tilePos - mCacheRegion.boundingRect().topLeft();
+
+    bool valid = !mCachePixmap.isNull() &&
+            mCacheScale == scale &&
+            mCachePixmap.devicePixelRatio() == pixelRatio &&
+            mCacheHighlight == highlight &&
+            mCacheRegion.translated(tileOffset) == mRegion;
+
+    // On staggered maps, moving by an odd number of rows or columns changes
+    // the shape of the brush
+    const Map *map = mMapDocument->map();
+    if (valid && map->isStaggered()) {
+        const int staggerOffset = map->staggerAxis() == Map::StaggerY ? tileOffset.y()
+                                                                      : tileOffset.x();
+        valid = (staggerOffset & 1) == 0;
+    }
+
+    if (!valid) {
+        clearCache();
+
+        const QSize size(qCeil(mBoundingRect.width() * scale * pixelRatio),
+                         qCeil(mBoundingRect.height() * scale * pixelRatio));
+        if (size.isEmpty() || size.width() > MaxCacheSize || size.height() > MaxCacheSize)
+            return false;
+
+        QPixmap pixmap(size);
+        pixmap.setDevicePixelRatio(pixelRatio);
+        pixmap.fill(Qt::transparent);
+
+        QPainter cachePainter(&pixmap);
+        cachePainter.setRenderHints(painter->renderHints());
+        cachePainter.scale(scale, scale);
+        cachePainter.translate(-mBoundingRect.topLeft());
+        drawStamp(&cachePainter, mBoundingRect);
+        renderer->drawTileSelection(&cachePainter, mRegion, highlight, mBoundingRect);
+        cachePainter.end();
+
+        mCachePixmap = pixmap;
+        mCacheRegion = mRegion;
+        mCacheOrigin = mBoundingRect.topLeft();
+        mCacheScale = scale;
+        mCacheHighlight = highlight;
+    }
+
+    const QPointF offset = renderer->tileToScreenCoords(tilePos) -
+            renderer->tileToScreenCoords(mCacheRegion.boundingRect().topLeft());
+    const QPointF devicePos = transform.map(mCacheOrigin + offset);
+
+    painter->save();
+    painter->resetTransform();
+    painter->drawPixmap(QPointF(qRound(devicePos.x()), qRound(devicePos.y())), mCachePixmap);
+    painter->restore();
+
+    return true;
+}
+
+void BrushItem::clearCache()
+{
+    mCachePixmap = QPixmap();
+    mCacheRegion = QRegion();
 }
 
 void BrushItem::updateBoundingRect()
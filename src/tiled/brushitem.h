@@ -25,6 +25,7 @@
 #include "tilelayer.h"
 
 #include <QGraphicsItem>
+#include <QPixmap>
 
 namespace Tiled {
 
@@ -69,12 +70,22 @@ protected:
 
 private:
     void updateBoundingRect();
+    void drawStamp(QPainter *painter, const QRectF &exposed) const;
+    bool paintCached(QPainter *painter, const QColor &highlight);
+    void clearCache();
 
     MapDocument *mMapDocument;
     SharedTileLayer mTileLayer;
     SharedMap mMap;
     QRegion mRegion;
     QRectF mBoundingRect;
+
+    // The stamp and its highlight, as rendered for mCacheRegion
+    QPixmap mCachePixmap;
+    QRegion mCacheRegion;
+    QPointF mCacheOrigin;
+    qreal mCacheScale = 0;
+    QColor mCacheHighlight;
 };
 
 /**
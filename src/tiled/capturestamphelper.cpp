@@ -51,6 +51,7 @@ TileStamp CaptureStampHelper::endCapture(MapDocument &mapDocument, QPoint tilePo
 
     auto stamp = std::make_unique<Map>(mapParameters);
 
+    mapDocument.map()->pageInChunks(captured);
     mapDocument.map()->copyLayers(mapDocument.selectedLayers(),
                                   captured,
                                   *stamp);
@@ -25,6 +25,7 @@
 #include "objecttemplate.h"
 
 #include <QCoreApplication>
+#include <QSet>
 
 #include "addremovetileset.h"
 #include "changeevents.h"
@@ -78,6 +79,46 @@ void ChangeMapObject::swap()
 }
 
 
+ChangeMapObjects::ChangeMapObjects(Document *document,
+                                   const QVector<MapObjectChange> &changes,
+                                   QUndoCommand *parent)
+    : QUndoCommand(QCoreApplication::translate("Undo Commands",
+                                               "Change %n Object(s)",
+                                               nullptr,
+                                               changes.size()),
+                   parent)
+    , mDocument(document)
+    , mChanges(changes)
+{
+}
+
+void ChangeMapObjects::swap()
+{
+    QList<MapObject*> objects;
+    QSet<MapObject*> seen;
+    MapObject::ChangedProperties properties;
+
+    for (MapObjectChange &change : mChanges) {
+        MapObject *object = change.object;
+
+        const auto value = std::exchange(change.value, object->mapObjectProperty(change.property));
+        object->setMapObjectProperty(change.property, value);
+
+        const bool propertyChanged = object->propertyChanged(change.property);
+        object->setPropertyChanged(change.property, change.propertyChanged);
+        change.propertyChanged = propertyChanged;
+
+        if (!seen.contains(object)) {
+            seen.insert(object);
+            objects.append(object);
+        }
+        properties |= change.property;
+    }
+
+    emit mDocument->changed(MapObjectsChangeEvent(std::move(objects), properties));
+}
+
+
 ChangeMapObjectCells::ChangeMapObjectCells(Document *document,
                                            const QVector<MapObjectCell> &changes,
                                            QUndoCommand *parent)
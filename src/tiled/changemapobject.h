@@ -65,6 +65,37 @@ private:
 };
 
 
+struct MapObjectChange
+{
+    MapObject *object;
+    MapObject::Property property;
+    QVariant value;
+    bool propertyChanged = true;
+};
+
+class ChangeMapObjects : public QUndoCommand
+{
+public:
+    /**
+     * Creates an undo command that applies the given property \a changes to
+     * any number of objects, emitting a single change event. Each property
+     * of an object should be changed only once.
+     */
+    ChangeMapObjects(Document *document,
+                     const QVector<MapObjectChange> &changes,
+                     QUndoCommand *parent = nullptr);
+
+    void undo() override { swap(); }
+    void redo() override { swap(); }
+
+private:
+    void swap();
+
+    Document *mDocument;
+    QVector<MapObjectChange> mChanges;
+};
+
+
 struct MapObjectCell
 {
     MapObject *object;
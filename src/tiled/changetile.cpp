@@ -78,10 +78,7 @@ void ChangeTileImageRect::setValue(Tile *tile, const QRect &rect) const
 {
     tile->tileset()->setTileImageRect(tile, rect);
 
-    emit static_cast<TilesetDocument*>(document())->tileImageSourceChanged(tile);
-
-    for (MapDocument *mapDocument : static_cast<TilesetDocument*>(document())->mapDocuments())
-        emit mapDocument->tileImageSourceChanged(tile);
+    static_cast<TilesetDocument*>(document())->emitTileImageSourceChanged(tile);
 }
 
 } // namespace Tiled
@@ -21,11 +21,13 @@
 #include "clipboardmanager.h"
 
 #include "addremovemapobject.h"
+#include "compression.h"
 #include "map.h"
 #include "mapdocument.h"
 #include "mapobject.h"
 #include "maprenderer.h"
 #include "mapscene.h"
+#include "maptovariantconverter.h"
 #include "mapview.h"
 #include "objectgroup.h"
 #include "objectreferenceshelper.h"
@@ -33,9 +35,12 @@
 #include "tile.h"
 #include "tilelayer.h"
 #include "tmxmapformat.h"
+#include "varianttomapconverter.h"
 
 #include <QApplication>
 #include <QClipboard>
+#include <QDataStream>
+#include <QDir>
 #include <QHash>
 #include <QJsonDocument>
 #include <QMimeData>
@@ -48,9 +53,143 @@
 #include <algorithm>
 
 static const char * const TMX_MIMETYPE = "text/tmx";
+static const char * const MAP_MIMETYPE = "application/x-tiled-map";
+
+static constexpr quint32 MapDataMagic = 0x4d4c4954;     // "TILM"
+static constexpr quint32 MapDataVersion = 1;
 
 using namespace Tiled;
 
+/**
+ * Returns a copy of the given map. Like when the map is written and read
+ * back, external tilesets remain shared while embedded ones are copied.
+ */
+static std::unique_ptr<Map> copyForClipboard(const Map &map)
+{
+    auto copy = map.clone();
+
+    const auto tilesets = copy->tilesets();
+    for (const SharedTileset &tileset : tilesets)
+        if (tileset->fileName().isEmpty())
+            copy->replaceTileset(tileset, tileset->clone());
+
+    return copy;
+}
+
+/**
+ * Encodes the map in Tiled's binary clipboard format, which is the map in
+ * CBOR, compressed with Zstandard when available.
+ *
+ * File references are stored relative to the root, so that they can be
+ * resolved by any other Tiled instance.
+ */
+static QByteArray encodeMap(const Map &map)
+{
+    MapToVariantConverter converter;
+    converter.setLayerDataFormat(Map::Base64);
+    const QByteArray cbor = QCborValue::fromVariant(converter.toVariant(map, QDir::root())).toCbor();
+
+    const CompressionMethod method = compressionSupported(Zstandard) ? Zstandard : Zlib;
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream << MapDataMagic
+           << MapDataVersion
+           << static_cast<qint32>(method)
+           << static_cast<qint32>(cbor.size())
+           << compress(cbor, method);
+
+    return data;
+}
+
+static std::unique_ptr<Map> decodeMap(const QByteArray &data)
+{
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic;
+    quint32 version;
+    qint32 method;
+    qint32 size;
+    QByteArray compressed;
+
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != MapDataMagic || version != MapDataVersion)
+        return nullptr;
+
+    stream >> method >> size >> compressed;
+    if (stream.status() != QDataStream::Ok)
+        return nullptr;
+
+    if (method != Zlib && method != Zstandard)
+        return nullptr;
+    if (!compressionSupported(static_cast<CompressionMethod>(method)))
+        return nullptr;
+
+    const QByteArray cbor = decompress(compressed, size, static_cast<CompressionMethod>(method));
+    if (cbor.isNull())
+        return nullptr;
+
+    VariantToMapConverter converter;
+    return converter.toMap(QCborValue::fromCbor(cbor).toVariant(), QDir::root());
+}
+
+/**
+ * Holds a copy of the map placed on the clipboard, so that it can be pasted
+ * within this instance without any conversion.
+ *
+ * The binary format for other Tiled instances and the TMX fallback for other
+ * applications are only produced when requested.
+ */
+class MapMimeData : public QMimeData
+{
+public:
+    explicit MapMimeData(std::unique_ptr<Map> map)
+        : mMap(std::move(map))
+    {}
+
+    std::unique_ptr<Map> map() const { return copyForClipboard(*mMap); }
+
+    QStringList formats() const override
+    {
+        return { QLatin1String(MAP_MIMETYPE), QLatin1String(TMX_MIMETYPE) };
+    }
+
+    bool hasFormat(const QString &mimeType) const override
+    {
+        return mimeType == QLatin1String(MAP_MIMETYPE) ||
+                mimeType == QLatin1String(TMX_MIMETYPE);
+    }
+
+protected:
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    QVariant retrieveData(const QString &mimeType, QVariant::Type) const override
+#else
+    QVariant retrieveData(const QString &mimeType, QMetaType) const override
+#endif
+    {
+        if (mimeType == QLatin1String(MAP_MIMETYPE)) {
+            if (mBinary.isEmpty())
+                mBinary = encodeMap(*mMap);
+            return mBinary;
+        }
+
+        if (mimeType == QLatin1String(TMX_MIMETYPE)) {
+            if (mTmx.isEmpty())
+                mTmx = TmxMapFormat().toByteArray(mMap.get());
+            return mTmx;
+        }
+
+        return QVariant();
+    }
+
+private:
+    std::unique_ptr<Map> mMap;
+    mutable QByteArray mBinary;
+    mutable QByteArray mTmx;
+};
+
 ClipboardManager::ClipboardManager()
     : mClipboard(QApplication::clipboard())
 {
@@ -80,6 +219,17 @@ ClipboardManager *ClipboardManager::instance()
 std::unique_ptr<Map> ClipboardManager::map() const
 {
     const auto mimeData = mClipboard->mimeData();
+
+    // Copied by this instance, so no need to decode anything
+    if (auto mapMimeData = dynamic_cast<const MapMimeData*>(mimeData))
+        return mapMimeData->map();
+
+    const QByteArray binaryData = mimeData->data(QLatin1String(MAP_MIMETYPE));
+    if (!binaryData.isEmpty()) {
+        if (auto map = decodeMap(binaryData))
+            return map;
+    }
+
     const QByteArray data = mimeData->data(QLatin1String(TMX_MIMETYPE));
     if (data.isEmpty())
         return nullptr;
@@ -90,15 +240,13 @@ std::unique_ptr<Map> ClipboardManager::map() const
 
 /**
  * Sets the given map on the clipboard.
+ *
+ * Only a copy of the map is stored right away. It is encoded when another
+ * application or Tiled instance asks for it.
  */
 void ClipboardManager::setMap(const Map &map)
 {
-    TmxMapFormat format;
-
-    auto mimeData = new QMimeData;
-    mimeData->setData(QLatin1String(TMX_MIMETYPE), format.toByteArray(&map));
-
-    mClipboard->setMimeData(mimeData);
+    mClipboard->setMimeData(new MapMimeData(copyForClipboard(map)));
 }
 
 Properties ClipboardManager::properties() const
@@ -172,8 +320,10 @@ bool ClipboardManager::copySelection(const MapDocument &mapDocument)
         bool tileLayerSelected = std::any_of(selectedLayers.begin(), selectedLayers.end(),
                                              [] (Layer *layer) { return layer->isTileLayer(); });
 
-        if (tileLayerSelected)
+        if (tileLayerSelected) {
+            mapDocument.map()->pageInChunks(selectedArea);
             map->copyLayers(selectedLayers, selectedArea, copyMap);
+        }
     }
 
     if (!selectedObjects.isEmpty()) {
@@ -274,7 +424,8 @@ void ClipboardManager::update()
     bool hasListValues = false;
 
     if (const auto data = mClipboard->mimeData()) {
-        hasMap = data->hasFormat(QLatin1String(TMX_MIMETYPE));
+        hasMap = data->hasFormat(QLatin1String(MAP_MIMETYPE)) ||
+                data->hasFormat(QLatin1String(TMX_MIMETYPE));
         hasProperties = data->hasFormat(QLatin1String(PROPERTIES_MIMETYPE));
         hasListValues = data->hasFormat(QLatin1String(LIST_VALUES_MIMETYPE));
     }
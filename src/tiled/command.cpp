@@ -155,6 +155,7 @@ void Command::execute(bool inTerminal) const
 {
     if (saveBeforeExecute) {
         ActionManager::instance()->action("Save")->trigger();
+        DocumentManager::instance()->waitForBackgroundSaves();
 
         if (Document *document = DocumentManager::instance()->currentDocument()) {
             if (document->type() == Document::MapDocumentType) {
@@ -30,8 +30,15 @@
 #include "undocommands.h"
 #include "wangset.h"
 
+#include <QDir>
+#include <QFile>
 #include <QFileInfo>
+#include <QFutureWatcher>
+#include <QSet>
 #include <QUndoStack>
+#include <QtConcurrent>
+
+#include <algorithm>
 
 namespace Tiled {
 
@@ -96,22 +103,123 @@ void Document::setFileName(const QString &fileName)
     emit fileNameChanged(fileName, oldFileName);
 }
 
-void Document::checkFilePathProperties(const Object *object) const
+/**
+ * Starts collecting notifications that can be combined, like changes to the
+ * tiles of a layer, until the matching call to endChangeBatch(). Batches can
+ * be nested.
+ */
+void Document::beginChangeBatch()
+{
+    ++mChangeBatchDepth;
+}
+
+/**
+ * Ends a batch started by beginChangeBatch(). When the outermost batch ends,
+ * the collected notifications are emitted.
+ */
+void Document::endChangeBatch()
+{
+    Q_ASSERT(mChangeBatchDepth > 0);
+    if (--mChangeBatchDepth == 0)
+        flushBatchedChanges();
+}
+
+/**
+ * Collects the files referred to by the file properties of \a object, to be
+ * checked by checkFilePathReferences.
+ */
+void Document::checkFilePathProperties(const Object *object,
+                                       QVector<FilePathReference> &references) const
 {
     const auto &props = object->properties();
 
     for (auto i = props.begin(), i_end = props.end(); i != i_end; ++i) {
         if (i.value().userType() == filePathTypeId()) {
             const QString localFile = i.value().value<FilePath>().url.toLocalFile();
-            if (!localFile.isEmpty() && !QFile::exists(localFile)) {
-                WARNING(tr("Custom property '%1' refers to non-existing file '%2'").arg(i.key(), localFile),
-                        SelectCustomProperty { fileName(), i.key(), object},
-                        this);
-            }
+            if (!localFile.isEmpty())
+                references.append({ localFile, i.key(), object });
         }
     }
 }
 
+/**
+ * Returns the indexes of the given \a fileNames that do not exist.
+ *
+ * When many files are in the same directory, that directory is listed once
+ * instead of checking each file separately, which is a lot faster on network
+ * drives.
+ */
+static QVector<int> findMissingFiles(const QStringList &fileNames)
+{
+    constexpr int minimumFilesForListing = 8;
+
+    QHash<QString, QVector<int>> filesByDirectory;
+    for (int i = 0; i < fileNames.size(); ++i)
+        filesByDirectory[QFileInfo(fileNames.at(i)).path()].append(i);
+
+    QVector<int> missing;
+
+    for (auto it = filesByDirectory.cbegin(), end = filesByDirectory.cend(); it != end; ++it) {
+        QSet<QString> entries;
+        const bool listed = it.value().size() >= minimumFilesForListing;
+        if (listed) {
+            const auto entryList = QDir(it.key()).entryList(QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
+            entries = QSet<QString>(entryList.begin(), entryList.end());
+        }
+
+        for (int index : it.value()) {
+            const QString &fileName = fileNames.at(index);
+
+            // Files not listed are still checked individually, since the
+            // file system may not be case-sensitive
+            if (listed && entries.contains(QFileInfo(fileName).fileName()))
+                continue;
+            if (!QFile::exists(fileName))
+                missing.append(index);
+        }
+    }
+
+    std::sort(missing.begin(), missing.end());
+    return missing;
+}
+
+/**
+ * Checks in the background whether the given file \a references exist and
+ * reports a warning for each missing file. The result of an earlier check
+ * that is still in progress is discarded.
+ */
+void Document::checkFilePathReferences(QVector<FilePathReference> references)
+{
+    const int check = ++mFilePathCheck;
+
+    if (references.isEmpty())
+        return;
+
+    QStringList fileNames;
+    fileNames.reserve(references.size());
+    for (const FilePathReference &reference : std::as_const(references))
+        fileNames.append(reference.fileName);
+
+    auto watcher = new QFutureWatcher<QVector<int>>(this);
+
+    connect(watcher, &QFutureWatcherBase::finished, this, [=, references = std::move(references)] {
+        watcher->deleteLater();
+
+        // Ignore the result when the issues were checked again meanwhile
+        if (check != mFilePathCheck)
+            return;
+
+        for (int index : watcher->result()) {
+            const FilePathReference &reference = references.at(index);
+            WARNING(tr("Custom property '%1' refers to non-existing file '%2'").arg(reference.propertyName, reference.fileName),
+                    SelectCustomProperty { fileName(), reference.propertyName, reference.object },
+                    this);
+        }
+    });
+
+    watcher->setFuture(QtConcurrent::run(findMissingFiles, fileNames));
+}
+
 /**
  * Sets the current \a object alongside the document owning that object.
  *
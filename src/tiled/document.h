@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include "memoryusage.h"
 #include "properties.h"
 
 #include <QDateTime>
@@ -27,7 +28,9 @@
 #include <QSharedPointer>
 #include <QString>
 #include <QVariant>
+#include <QVector>
 
+#include <functional>
 #include <memory>
 
 class QUndoStack;
@@ -88,10 +91,28 @@ public:
      */
     virtual bool save(const QString &fileName, QString *error = nullptr) = 0;
 
+    /**
+     * Prepares saving the document to its current file on a worker thread.
+     * Returns a function that writes a snapshot of the document as it is
+     * now, or a null function when the document can't be saved this way.
+     *
+     * The document is considered saved right away. Once the returned function
+     * has been called, finishBackgroundSave() needs to be called on the GUI
+     * thread with the result.
+     */
+    virtual std::function<bool (QString *error)> prepareBackgroundSave() { return {}; }
+    virtual void finishBackgroundSave(bool success) { Q_UNUSED(success) }
+
     virtual bool canReload() const { return false; }
 
     virtual FileFormat *writerFormat() const = 0;
 
+    /**
+     * Returns an estimate of the memory used by the contents of this
+     * document. Does not include the undo stack.
+     */
+    virtual MemoryUsage memoryUsage() const { return {}; }
+
     QDateTime lastSaved() const { return mLastSaved; }
 
     QUndoStack *undoStack() const;
@@ -128,6 +149,10 @@ public:
 
     virtual void checkIssues() {}
 
+    void beginChangeBatch();
+    void endChangeBatch();
+    bool isBatchingChanges() const;
+
 signals:
     void changed(const ChangeEvent &change);
     void saved();
@@ -161,7 +186,18 @@ protected:
 
     void setFileName(const QString &fileName);
 
-    void checkFilePathProperties(const Object *object) const;
+    struct FilePathReference
+    {
+        QString fileName;
+        QString propertyName;
+        const Object *object;
+    };
+
+    void checkFilePathProperties(const Object *object,
+                                 QVector<FilePathReference> &references) const;
+    void checkFilePathReferences(QVector<FilePathReference> references);
+
+    virtual void flushBatchedChanges() {}
 
     QDateTime mLastSaved;
 
@@ -185,9 +221,17 @@ private:
     bool mModified = false;
     bool mChangedOnDisk = false;
     bool mIgnoreBrokenLinks = false;
+
+    int mFilePathCheck = 0;
+    int mChangeBatchDepth = 0;
 };
 
 
+inline bool Document::isBatchingChanges() const
+{
+    return mChangeBatchDepth > 0;
+}
+
 inline const QString &Document::fileName() const
 {
     return mFileName;
@@ -23,6 +23,7 @@
 
 #include "abstracttool.h"
 #include "adjusttileindexes.h"
+#include "assetdependencies.h"
 #include "brokenlinks.h"
 #include "containerhelpers.h"
 #include "editableasset.h"
@@ -32,8 +33,10 @@
 #include "logginginterface.h"
 #include "map.h"
 #include "mapdocument.h"
+#include "mapdocumentjournal.h"
 #include "mapeditor.h"
 #include "mapformat.h"
+#include "mapplaceholderitem.h"
 #include "maprenderer.h"
 #include "mapview.h"
 #include "noeditorwidget.h"
@@ -45,6 +48,7 @@
 #include "tilesetdocumentsmodel.h"
 #include "tilesetmanager.h"
 #include "tmxmapformat.h"
+#include "tracing.h"
 #include "utils.h"
 #include "world.h"
 #include "worlddocument.h"
@@ -62,6 +66,7 @@
 #include <QScrollBar>
 #include <QStackedLayout>
 #include <QTabBar>
+#include <QtConcurrent>
 #include <QUndoGroup>
 #include <QUndoStack>
 #include <QVBoxLayout>
@@ -102,6 +107,8 @@ DocumentManager::DocumentManager(QObject *parent)
 
     mLockedIcon.addFile(QStringLiteral(":images/24/locked.png"));
 
+    mSaveThreadPool.setMaxThreadCount(1);
+
     mBrokenLinksWidget->setVisible(false);
 
     mTabBar->setExpanding(false);
@@ -562,6 +569,8 @@ int DocumentManager::insertDocument(int index, const DocumentPtr &document)
     if (auto mapDocument = qobject_cast<MapDocument*>(documentPtr)) {
         for (const SharedTileset &tileset : mapDocument->map()->tilesets())
             addToTilesetDocument(tileset, mapDocument);
+
+        new MapDocumentJournal(mapDocument);
     } else if (auto tilesetDocument = qobject_cast<TilesetDocument*>(documentPtr)) {
         // We may have opened a bare tileset that wasn't seen before
         if (!mTilesetDocumentsModel->contains(tilesetDocument)) {
@@ -630,21 +639,55 @@ static bool isDocumentChangedOnDisk(Document *document)
     return document->changedOnDisk();
 }
 
+/**
+ * Returns a plugin that implements support for reading the given file.
+ */
+static FileFormat *findReaderFormat(const QString &fileName)
+{
+    return PluginManager::find<FileFormat>([&](FileFormat *format) {
+        return format->hasCapabilities(FileFormat::Read) && format->supportsFile(fileName);
+    });
+}
+
+/**
+ * Starts parsing the given file on a worker thread, when it is a map that
+ * is not open yet. The result can be passed to loadDocument(), which then
+ * only needs to create the map on the main thread.
+ *
+ * This allows several maps to be parsed in parallel, while the documents are
+ * still created one by one, sharing their tilesets through the
+ * TilesetManager.
+ */
+QFuture<MapCache::Parsed> DocumentManager::parseDocument(const QString &fileName,
+                                                         FileFormat *fileFormat)
+{
+    MapFormat *mapFormat = nullptr;
+
+    // The format is looked up here, since not all formats can be used from
+    // other threads
+    if (!mDocumentByFileName.contains(QFileInfo(fileName).canonicalFilePath()))
+        mapFormat = qobject_cast<MapFormat*>(fileFormat ? fileFormat : findReaderFormat(fileName));
+
+    return QtConcurrent::run([mapFormat, fileName] {
+        TILED_TRACE_SCOPE("DocumentManager::parseDocument");
+        return mapFormat ? MapCache::parseMap(mapFormat, fileName) : MapCache::Parsed();
+    });
+}
+
 DocumentPtr DocumentManager::loadDocument(const QString &fileName,
                                           FileFormat *fileFormat,
-                                          QString *error)
+                                          QString *error,
+                                          const MapCache::Parsed *parsed)
 {
+    TILED_TRACE_SCOPE("DocumentManager::loadDocument");
+
     // Try to find it in already loaded documents
     QString canonicalFilePath = QFileInfo(fileName).canonicalFilePath();
     if (Document *doc = mDocumentByFileName.value(canonicalFilePath))
         return doc->sharedFromThis();
 
-    if (!fileFormat) {
-        // Try to find a plugin that implements support for this format
-        fileFormat = PluginManager::find<FileFormat>([&](FileFormat *format) {
-            return format->hasCapabilities(FileFormat::Read) && format->supportsFile(fileName);
-        });
-    }
+    if (!fileFormat)
+        fileFormat = findReaderFormat(fileName);
 
     if (!fileFormat) {
         if (error)
@@ -655,7 +698,7 @@ DocumentPtr DocumentManager::loadDocument(const QString &fileName,
     DocumentPtr document;
 
     if (MapFormat *mapFormat = qobject_cast<MapFormat*>(fileFormat)) {
-        document = MapDocument::load(fileName, mapFormat, error);
+        document = MapDocument::load(fileName, mapFormat, error, parsed);
     } else if (TilesetFormat *tilesetFormat = qobject_cast<TilesetFormat*>(fileFormat)) {
         // It could be, that we have already loaded this tileset while loading some map.
         if (auto tilesetDocument = findTilesetDocument(fileName)) {
@@ -675,11 +718,26 @@ DocumentPtr DocumentManager::loadDocument(const QString &fileName,
  */
 bool DocumentManager::saveDocument(Document *document, const QString &fileName)
 {
+    TILED_TRACE_SCOPE("DocumentManager::saveDocument");
+
     if (fileName.isEmpty())
         return false;
 
+    // Finish pending background saves first, since they may write the same
+    // file or use the same file format
+    const FileFormat *format = document->writerFormat();
+    if (format && format->hasCapabilities(FileFormat::WriteInBackground))
+        waitForBackgroundSaves();
+    else
+        waitForBackgroundSave(document);
+
     emit documentAboutToBeSaved(document);
 
+    return writeDocument(document, fileName);
+}
+
+bool DocumentManager::writeDocument(Document *document, const QString &fileName)
+{
     QString error;
     if (!document->save(fileName, &error)) {
         switchToDocument(document);
@@ -692,6 +750,94 @@ bool DocumentManager::saveDocument(Document *document, const QString &fileName)
     return true;
 }
 
+/**
+ * Saves the given document to its existing file name on a worker thread,
+ * so that the editor stays responsive while large maps are written. Falls
+ * back to saving synchronously when the document or its file format doesn't
+ * support this.
+ *
+ * The document is considered saved right away. When the save fails, the
+ * error is reported once it has finished and the document is marked as
+ * modified again.
+ *
+ * @return <code>false</code> when the save failed synchronously
+ */
+bool DocumentManager::saveDocumentInBackground(Document *document)
+{
+    TILED_TRACE_SCOPE("DocumentManager::saveDocumentInBackground");
+
+    const QString fileName = document->fileName();
+    if (fileName.isEmpty())
+        return false;
+
+    waitForBackgroundSave(document);
+
+    emit documentAboutToBeSaved(document);
+
+    auto save = std::make_shared<BackgroundSave>();
+    save->write = document->prepareBackgroundSave();
+    if (!save->write)
+        return writeDocument(document, fileName);
+
+    save->watcher = new QFutureWatcher<void>(this);
+    connect(save->watcher, &QFutureWatcherBase::finished,
+            this, [this, document] { waitForBackgroundSave(document); });
+
+    mBackgroundSaves.insert(document, save);
+    updateDocumentTab(document);
+
+    // The worker only gets a raw pointer, so that the snapshot held by the
+    // write function is always destroyed on this thread
+    BackgroundSave *s = save.get();
+    save->watcher->setFuture(QtConcurrent::run(&mSaveThreadPool, [s] {
+        s->success = s->write(&s->error);
+    }));
+
+    return true;
+}
+
+bool DocumentManager::isSavingInBackground(Document *document) const
+{
+    return mBackgroundSaves.contains(document);
+}
+
+/**
+ * Blocks until the background save of the given \a document, if any, has
+ * finished, and reports its result.
+ */
+void DocumentManager::waitForBackgroundSave(Document *document)
+{
+    const auto save = mBackgroundSaves.take(document);
+    if (!save)
+        return;
+
+    save->watcher->waitForFinished();
+    save->watcher->disconnect(this);
+    save->watcher->deleteLater();
+
+    document->finishBackgroundSave(save->success);
+    updateDocumentTab(document);
+
+    if (!save->success) {
+        switchToDocument(document);
+        QMessageBox::critical(mWidget->window(), QCoreApplication::translate("Tiled::MainWindow", "Error Saving File"), save->error);
+        return;
+    }
+
+    emit documentSaved(document);
+}
+
+/**
+ * Blocks until all background saves have finished, and reports their
+ * results.
+ */
+void DocumentManager::waitForBackgroundSaves()
+{
+    const auto documents = mBackgroundSaves.keys();
+    for (Document *document : documents)
+        waitForBackgroundSave(document);
+}
+
 /**
  * Save the given document with a file name chosen by the user. When saved
  * successfully, the file is added to the list of recent files.
@@ -863,6 +1009,8 @@ void DocumentManager::closeDocumentAt(int index)
 {
     auto document = mDocuments.at(index);       // keeps alive and may delete
 
+    waitForBackgroundSave(document.data());
+
     emit documentAboutToClose(document.data());
 
     mDocuments.removeAt(index);
@@ -876,6 +1024,9 @@ void DocumentManager::closeDocumentAt(int index)
     if (auto mapDocument = qobject_cast<MapDocument*>(document.data())) {
         for (const SharedTileset &tileset : mapDocument->map()->tilesets())
             removeFromTilesetDocument(tileset, mapDocument);
+
+        // Closing discards any unsaved changes, so the journal goes as well
+        delete mapDocument->findChild<MapDocumentJournal*>(QString(), Qt::FindDirectChildrenOnly);
     } else if (auto tilesetDocument = qobject_cast<TilesetDocument*>(document.data())) {
         if (tilesetDocument->mapDocuments().isEmpty()) {
             mTilesetDocumentsModel->remove(tilesetDocument);
@@ -924,6 +1075,8 @@ bool DocumentManager::reloadDocumentAt(int index)
  */
 bool DocumentManager::reloadDocument(Document *document)
 {
+    TILED_TRACE_SCOPE("DocumentManager::reloadDocument");
+
     QString error;
 
     switch (document->type()) {
@@ -1044,6 +1197,8 @@ void DocumentManager::updateDocumentTab(Document *document)
         tabText.prepend(QLatin1Char('*'));
     if (document->isReadOnly())
         tabToolTip = tr("%1 [read-only]").arg(tabToolTip);
+    if (isSavingInBackground(document))
+        tabToolTip = tr("%1 [saving...]").arg(tabToolTip);
 
     mTabBar->setTabIcon(index, tabIcon);
     mTabBar->setTabText(index, tabText);
@@ -1075,6 +1230,12 @@ void DocumentManager::onDocumentSaved()
 {
     Document *document = static_cast<Document*>(sender());
 
+    ProjectManager::instance()->assetDependencies()->fileChanged(document->fileName());
+
+    // Keeps the thumbnail shown for this map in worlds up-to-date
+    if (auto mapDocument = qobject_cast<MapDocument*>(document))
+        MapPlaceholderItem::refreshThumbnail(mapDocument->fileName(), mapDocument->map());
+
     if (document->changedOnDisk()) {
         document->setChangedOnDisk(false);
         if (!isDocumentModified(currentDocument()))
@@ -1165,6 +1326,8 @@ void DocumentManager::fileChanged(const QString &fileName)
     // Ignore change event when it seems to be our own save
     if (fileInfo.lastModified() == document->lastSaved())
         return;
+    if (isSavingInBackground(document))
+        return;
 
     // Automatically reload when there are no unsaved changes
     if (!isDocumentModified(document)) {
@@ -24,14 +24,18 @@
 #include "mapdocument.h"
 #include "tilesetdocument.h"
 
+#include <QFutureWatcher>
 #include <QHash>
 #include <QIcon>
 #include <QList>
 #include <QObject>
 #include <QPointF>
 #include <QPointer>
+#include <QThreadPool>
 #include <QVector>
 
+#include <memory>
+
 class QTabWidget;
 class QUndoGroup;
 class QStackedLayout;
@@ -109,11 +113,20 @@ public:
 
     DocumentPtr loadDocument(const QString &fileName,
                              FileFormat *fileFormat = nullptr,
-                             QString *error = nullptr);
+                             QString *error = nullptr,
+                             const MapCache::Parsed *parsed = nullptr);
+    QFuture<MapCache::Parsed> parseDocument(const QString &fileName,
+                                            FileFormat *fileFormat = nullptr);
 
     bool saveDocument(Document *document);
     bool saveDocument(Document *document, const QString &fileName);
     bool saveDocumentAs(Document *document);
+    bool saveDocumentInBackground(Document *document);
+
+    bool isSavingInBackground(Document *document) const;
+    void waitForBackgroundSave(Document *document);
+    void waitForBackgroundSaves();
+    QThreadPool *saveThreadPool() { return &mSaveThreadPool; }
 
     void closeCurrentDocument();
     void closeAllDocuments();
@@ -192,6 +205,16 @@ public slots:
     void saveFile();
 
 private:
+    struct BackgroundSave
+    {
+        std::function<bool (QString *error)> write;
+        bool success = false;
+        QString error;
+        QFutureWatcher<void> *watcher = nullptr;
+    };
+
+    bool writeDocument(Document *document, const QString &fileName);
+
     void onWorldLoaded(WorldDocument *worldDocument);
     void onWorldUnloaded(WorldDocument *worldDocument);
 
@@ -249,6 +272,12 @@ private:
     FileSystemWatcher *mFileSystemWatcher;
     QHash<QString, Document*> mDocumentByFileName;
 
+    // Background saves run one at a time, so that a file format is never
+    // used by more than one thread. The pool is declared last, so that it
+    // waits for a running save before the snapshot it writes is destroyed.
+    QHash<Document*, std::shared_ptr<BackgroundSave>> mBackgroundSaves;
+    QThreadPool mSaveThreadPool;
+
     static DocumentManager *mInstance;
 
     bool mMultiDocumentClose;
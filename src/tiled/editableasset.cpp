@@ -21,7 +21,9 @@
 #include "editableasset.h"
 
 #include "documentmanager.h"
+#include "map.h"
 #include "scriptmanager.h"
+#include "tileset.h"
 
 #include <QCoreApplication>
 #include <QUndoStack>
@@ -55,6 +57,33 @@ bool EditableAsset::isModified() const
     return false;
 }
 
+/**
+ * Returns an estimate of the memory used by the asset, in bytes, along with
+ * the number of commands on its undo stack.
+ */
+QVariantMap EditableAsset::memoryUsage() const
+{
+    MemoryUsage usage;
+    if (auto doc = document())
+        usage = doc->memoryUsage();
+    else if (object()->typeId() == Object::MapType)
+        usage = Tiled::memoryUsage(*static_cast<const Map*>(object()));
+    else if (object()->typeId() == Object::TilesetType)
+        usage = Tiled::memoryUsage(*static_cast<const Tileset*>(object()));
+
+    const QUndoStack *stack = undoStack();
+
+    return QVariantMap {
+        { QStringLiteral("tileLayers"), usage.tileLayers },
+        { QStringLiteral("objects"), usage.objects },
+        { QStringLiteral("properties"), usage.properties },
+        { QStringLiteral("images"), usage.images },
+        { QStringLiteral("tiles"), usage.tiles },
+        { QStringLiteral("total"), usage.total() },
+        { QStringLiteral("undoCommands"), stack ? stack->count() : 0 },
+    };
+}
+
 bool EditableAsset::push(QUndoCommand *command)
 {
     return push(std::unique_ptr<QUndoCommand>(command));
@@ -96,9 +125,17 @@ QJSValue EditableAsset::macro(const QString &text, QJSValue callback)
     if (stack)
         undoStack()->beginMacro(text);
 
+    // Combine notifications, so that views update only once
+    auto doc = document();
+    if (doc)
+        doc->beginChangeBatch();
+
     QJSValue result = callback.call();
     ScriptManager::instance().checkError(result);
 
+    if (doc)
+        doc->endChangeBatch();
+
     if (stack)
         undoStack()->endMacro();
 
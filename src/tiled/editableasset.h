@@ -55,6 +55,7 @@ class EditableAsset : public EditableObject
     Q_PROPERTY(bool isTileMap READ isMap CONSTANT)
     Q_PROPERTY(bool isTileset READ isTileset CONSTANT)
     Q_PROPERTY(AssetType::Value assetType READ assetType CONSTANT)
+    Q_PROPERTY(QVariantMap memoryUsage READ memoryUsage)
 
 public:
     EditableAsset(Object *object, QObject *parent = nullptr);
@@ -67,6 +68,7 @@ public:
 
     QUndoStack *undoStack() const;
     bool isModified() const;
+    QVariantMap memoryUsage() const;
     bool push(QUndoCommand *command);
     bool push(std::unique_ptr<QUndoCommand> command);
 
@@ -373,6 +373,21 @@ void EditableMap::removeObjects(const QList<QObject*> &objects)
  *
  * @warning Currently only supports tile layers!
  */
+EditableMapObject *EditableMap::objectById(int id)
+{
+    if (MapObject *mapObject = map()->findObjectById(id))
+        return EditableMapObject::get(this, mapObject);
+    return nullptr;
+}
+
+QList<QObject *> EditableMap::objectsByClassName(const QString &className)
+{
+    QList<QObject*> objects;
+    for (MapObject *mapObject : map()->findObjectsByClassName(className))
+        objects.append(EditableMapObject::get(this, mapObject));
+    return objects;
+}
+
 void EditableMap::merge(EditableMap *editableMap, bool canJoin)
 {
     if (!editableMap) {
@@ -418,7 +433,8 @@ void EditableMap::resize(QSize size, QPoint offset, bool removeObjects)
     mapDocument()->resizeMap(size, offset, removeObjects);
 }
 
-void EditableMap::autoMap(const RegionValueType &region, const QString &rulesFile)
+void EditableMap::autoMap(const RegionValueType &region, const QString &rulesFile,
+                          std::optional<quint32> randomSeed)
 {
     if (checkReadOnly())
         return;
@@ -432,6 +448,7 @@ void EditableMap::autoMap(const RegionValueType &region, const QString &rulesFil
 
     AutomappingManager &manager = *mAutomappingManager;
     manager.setMapDocument(mapDocument(), rulesFile);
+    manager.setRandomSeed(randomSeed);
 
     if (region.region().isEmpty())
         manager.autoMap();
@@ -439,6 +456,17 @@ void EditableMap::autoMap(const RegionValueType &region, const QString &rulesFil
         manager.autoMapRegion(region.region());
 }
 
+QVariantList EditableMap::autoMapStatistics(bool reset)
+{
+    if (!mAutomappingManager)
+        return {};
+
+    const QVariantList statistics = mAutomappingManager->ruleStatistics();
+    if (reset)
+        mAutomappingManager->resetRuleStatistics();
+    return statistics;
+}
+
 Tiled::ScriptImage *EditableMap::toImage(QSize size) const
 {
     const MiniMapRenderer miniMapRenderer(map());
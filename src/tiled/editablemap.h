@@ -25,6 +25,8 @@
 #include "regionvaluetype.h"
 #include "scriptimage.h"
 
+#include <optional>
+
 namespace Tiled {
 
 class MapObject;
@@ -82,7 +84,8 @@ public:
         Base64Gzip      = 2,
         Base64Zlib      = 3,
         Base64Zstandard = 4,
-        CSV             = 5
+        CSV             = 5,
+        Base64ZstandardDictionary = 6
     };
     Q_ENUM(LayerDataFormat)
 
@@ -155,6 +158,8 @@ public:
     Q_INVOKABLE QList<QObject *> usedTilesets() const;
 
     Q_INVOKABLE void removeObjects(const QList<QObject*> &objects);
+    Q_INVOKABLE Tiled::EditableMapObject *objectById(int id);
+    Q_INVOKABLE QList<QObject*> objectsByClassName(const QString &className);
 
     Q_INVOKABLE void merge(Tiled::EditableMap *editableMap, bool canJoin = false);
 
@@ -166,6 +171,9 @@ public:
     Q_INVOKABLE void autoMap(const QRect &region, const QString &rulesFile = QString());
     Q_INVOKABLE void autoMap(const QRectF &region, const QString &rulesFile = QString());
     Q_INVOKABLE void autoMap(const Tiled::RegionValueType &region, const QString &rulesFile = QString());
+    Q_INVOKABLE void autoMap(const QRect &region, const QString &rulesFile, int randomSeed);
+    Q_INVOKABLE void autoMap(const Tiled::RegionValueType &region, const QString &rulesFile, int randomSeed);
+    Q_INVOKABLE QVariantList autoMapStatistics(bool reset = false);
 
     Q_INVOKABLE Tiled::ScriptImage *toImage(QSize size = QSize()) const;
 
@@ -219,6 +227,9 @@ protected:
     void setDocument(Document *document) override;
 
 private:
+    void autoMap(const RegionValueType &region, const QString &rulesFile,
+                 std::optional<quint32> randomSeed);
+
     void documentChanged(const ChangeEvent &change);
 
     void attachLayer(Layer *layer);
@@ -349,6 +360,21 @@ inline void EditableMap::autoMap(const QRectF &region, const QString &rulesFile)
     autoMap(region.toRect(), rulesFile);
 }
 
+inline void EditableMap::autoMap(const RegionValueType &region, const QString &rulesFile)
+{
+    autoMap(region, rulesFile, std::nullopt);
+}
+
+inline void EditableMap::autoMap(const QRect &region, const QString &rulesFile, int randomSeed)
+{
+    autoMap(RegionValueType(region), rulesFile, randomSeed);
+}
+
+inline void EditableMap::autoMap(const RegionValueType &region, const QString &rulesFile, int randomSeed)
+{
+    autoMap(region, rulesFile, std::optional<quint32>(randomSeed));
+}
+
 inline QPointF EditableMap::screenToTile(const QPointF &position) const
 {
     return screenToTile(position.x(), position.y());
@@ -154,7 +154,7 @@ EditableMapObject *EditableMapObject::get(EditableAsset *asset, MapObject *mapOb
     Q_ASSERT(mapObject->objectGroup());
 
     editable = new EditableMapObject(asset, mapObject);
-    editable->moveOwnershipToCpp();
+    editable->moveOwnershipToCache();
     return editable;
 }
 
@@ -29,10 +29,18 @@
 #include "scriptmanager.h"
 
 #include <QCoreApplication>
+#include <QPointer>
 #include <QQmlEngine>
+#include <QQueue>
 
 namespace Tiled {
 
+/**
+ * The maximum number of editables kept alive by moveOwnershipToCache().
+ */
+static constexpr int MaxCachedEditables = 4096;
+static QQueue<QPointer<EditableObject>> cachedEditables;
+
 EditableObject::EditableObject(EditableAsset *asset,
                                Object *object,
                                QObject *parent)
@@ -129,6 +137,30 @@ void EditableObject::moveOwnershipToCpp()
     QQmlEngine::setObjectOwnership(this, QQmlEngine::CppOwnership);
 }
 
+/**
+ * Keeps this editable alive from C++ as long as it is among the most recently
+ * cached editables. Once it drops out of the cache, ownership moves to
+ * JavaScript, so that it can be garbage collected when no script refers to it
+ * anymore.
+ *
+ * Only suitable for editables that reference an object owned by an asset,
+ * since these can be recreated on demand with the same state.
+ */
+void EditableObject::moveOwnershipToCache()
+{
+    moveOwnershipToCpp();
+
+    cachedEditables.enqueue(this);
+
+    while (cachedEditables.size() > MaxCachedEditables) {
+        const QPointer<EditableObject> editable = cachedEditables.dequeue();
+
+        // Skip editables that were deleted or became stand-alone since
+        if (editable && editable->asset())
+            editable->moveOwnershipToJavaScript();
+    }
+}
+
 /**
  * When this object is read-only, raises a script error and returns true.
  */
@@ -90,6 +90,7 @@ public slots:
 protected:
     bool moveOwnershipToJavaScript();
     void moveOwnershipToCpp();
+    void moveOwnershipToCache();
 
 private:
     void setPropertyImpl(const QString &name, const QVariant &value);
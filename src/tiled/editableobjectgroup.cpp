@@ -24,9 +24,11 @@
 #include "changeobjectgroupproperties.h"
 #include "editableasset.h"
 #include "map.h"
+#include "objectgroupedit.h"
 #include "scriptmanager.h"
 
 #include <QCoreApplication>
+#include <QJSEngine>
 
 namespace Tiled {
 
@@ -42,6 +44,12 @@ EditableObjectGroup::EditableObjectGroup(EditableAsset *asset,
 {
 }
 
+EditableObjectGroup::~EditableObjectGroup()
+{
+    while (!mActiveEdits.isEmpty())
+        delete mActiveEdits.first();
+}
+
 QList<QObject *> EditableObjectGroup::objects()
 {
     QList<QObject*> objects;
@@ -50,6 +58,66 @@ QList<QObject *> EditableObjectGroup::objects()
     return objects;
 }
 
+QList<QObject *> EditableObjectGroup::objectsIntersecting(const QRectF &rect)
+{
+    QList<QObject*> objects;
+    for (MapObject *object : objectGroup()->objectsIntersecting(rect))
+        objects.append(EditableMapObject::get(asset(), object));
+    return objects;
+}
+
+/**
+ * Calls the given \a callback for each object with a plain data record and the
+ * object's index. Unlike iterating over objects(), this avoids creating a
+ * wrapper for each object. Iteration stops when the callback returns false.
+ */
+void EditableObjectGroup::forEachObject(QJSValue callback)
+{
+    if (!callback.isCallable()) {
+        ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Invalid callback"));
+        return;
+    }
+
+    auto &scriptManager = ScriptManager::instance();
+    QJSEngine *engine = scriptManager.engine();
+
+    const QString idKey = QStringLiteral("id");
+    const QString nameKey = QStringLiteral("name");
+    const QString classNameKey = QStringLiteral("className");
+    const QString shapeKey = QStringLiteral("shape");
+    const QString xKey = QStringLiteral("x");
+    const QString yKey = QStringLiteral("y");
+    const QString widthKey = QStringLiteral("width");
+    const QString heightKey = QStringLiteral("height");
+    const QString rotationKey = QStringLiteral("rotation");
+    const QString visibleKey = QStringLiteral("visible");
+
+    // Copy the list, since the callback may modify the layer
+    const QList<MapObject*> objects = objectGroup()->objects();
+
+    for (int index = 0; index < objects.size(); ++index) {
+        const MapObject *object = objects.at(index);
+
+        QJSValue record = engine->newObject();
+        record.setProperty(idKey, object->id());
+        record.setProperty(nameKey, object->name());
+        record.setProperty(classNameKey, object->className());
+        record.setProperty(shapeKey, static_cast<int>(object->shape()));
+        record.setProperty(xKey, object->x());
+        record.setProperty(yKey, object->y());
+        record.setProperty(widthKey, object->width());
+        record.setProperty(heightKey, object->height());
+        record.setProperty(rotationKey, object->rotation());
+        record.setProperty(visibleKey, object->isVisible());
+
+        const QJSValue result = callback.call({ record, index });
+        if (scriptManager.checkError(result))
+            return;
+        if (result.isBool() && !result.toBool())
+            return;
+    }
+}
+
 EditableMapObject *EditableObjectGroup::objectAt(int index)
 {
     if (index < 0 || index >= objectCount()) {
@@ -135,6 +203,11 @@ void EditableObjectGroup::addObject(EditableMapObject *editableMapObject)
     insertObjectAt(objectCount(), editableMapObject);
 }
 
+ObjectGroupEdit *EditableObjectGroup::edit()
+{
+    return new ObjectGroupEdit(this);
+}
+
 /**
  * This functions exists in addition to EditableLayer::get() because the asset
  * might also be an EditableTileset in the case of object groups.
@@ -24,8 +24,12 @@
 #include "editablemapobject.h"
 #include "objectgroup.h"
 
+#include <QJSValue>
+
 namespace Tiled {
 
+class ObjectGroupEdit;
+
 class EditableObjectGroup : public EditableLayer
 {
     Q_OBJECT
@@ -50,15 +54,19 @@ public:
     EditableObjectGroup(EditableAsset *asset,
                         ObjectGroup *objectGroup,
                         QObject *parent = nullptr);
+    ~EditableObjectGroup() override;
 
     QList<QObject*> objects();
     int objectCount() const;
 
     Q_INVOKABLE Tiled::EditableMapObject *objectAt(int index);
+    Q_INVOKABLE QList<QObject*> objectsIntersecting(const QRectF &rect);
+    Q_INVOKABLE void forEachObject(QJSValue callback);
     Q_INVOKABLE void removeObjectAt(int index);
     Q_INVOKABLE void removeObject(Tiled::EditableMapObject *editableMapObject);
     Q_INVOKABLE void insertObjectAt(int index, Tiled::EditableMapObject *editableMapObject);
     Q_INVOKABLE void addObject(Tiled::EditableMapObject *editableMapObject);
+    Q_INVOKABLE Tiled::ObjectGroupEdit *edit();
     QColor color() const;
     DrawOrder drawOrder() const;
 
@@ -69,6 +77,11 @@ public:
 public slots:
     void setColor(const QColor &color);
     void setDrawOrder(DrawOrder drawOrder);
+
+private:
+    friend class ObjectGroupEdit;
+
+    QList<ObjectGroupEdit*> mActiveEdits;
 };
 
 
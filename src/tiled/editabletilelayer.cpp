@@ -23,12 +23,17 @@
 #include "addremovetileset.h"
 #include "changelayer.h"
 #include "editablemap.h"
+#include "gidmapper.h"
 #include "painttilelayer.h"
 #include "resizetilelayer.h"
 #include "scriptmanager.h"
 #include "tilelayeredit.h"
 #include "tilelayerwangedit.h"
 
+#include <QtEndian>
+
+#include <limits>
+
 namespace Tiled {
 
 EditableTileLayer::EditableTileLayer(const QString &name, QSize size, QObject *parent)
@@ -74,7 +79,7 @@ void EditableTileLayer::resize(QSize size, QPoint offset)
 
 RegionValueType EditableTileLayer::region() const
 {
-    return RegionValueType(tileLayer()->region());
+    return RegionValueType(tileLayer()->tileRegion());
 }
 
 Cell EditableTileLayer::cellAt(int x, int y) const
@@ -105,6 +110,58 @@ EditableTile *EditableTileLayer::tileAt(int x, int y) const
     return EditableTile::get(cellAt(x, y).tile());
 }
 
+/**
+ * Returns the cells in the given \a rect as an array of little-endian 32-bit
+ * global tile IDs, including the flip flags, row by row. The global IDs are
+ * assigned based on the order of the tilesets in the map.
+ */
+QByteArray EditableTileLayer::readCells(const QRect &rect) const
+{
+    const Map *map = tileLayer()->map();
+    if (!map) {
+        ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Layer not part of a map"));
+        return QByteArray();
+    }
+
+    if (rect.isEmpty())
+        return QByteArray();
+
+    if (qint64(rect.width()) * rect.height() > std::numeric_limits<int>::max() / 4) {
+        ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Rectangle too large"));
+        return QByteArray();
+    }
+
+    const GidMapper gidMapper(map->tilesets());
+    QByteArray data(rect.width() * rect.height() * 4, '\0');
+    auto gids = reinterpret_cast<quint32*>(data.data());
+
+    // Visit only the chunks overlapping the rect, since empty cells are
+    // already zero
+    const TileLayer *layer = tileLayer();
+    for (int chunkY = rect.top() >> CHUNK_BITS; chunkY <= rect.bottom() >> CHUNK_BITS; ++chunkY) {
+        for (int chunkX = rect.left() >> CHUNK_BITS; chunkX <= rect.right() >> CHUNK_BITS; ++chunkX) {
+            const Chunk *chunk = layer->findChunk(chunkX << CHUNK_BITS, chunkY << CHUNK_BITS);
+            if (!chunk)
+                continue;
+
+            const QRect chunkRect(chunkX << CHUNK_BITS, chunkY << CHUNK_BITS, CHUNK_SIZE, CHUNK_SIZE);
+            const QRect area = chunkRect & rect;
+
+            for (int y = area.top(); y <= area.bottom(); ++y) {
+                quint32 *row = gids + (y - rect.top()) * rect.width();
+
+                for (int x = area.left(); x <= area.right(); ++x) {
+                    const Cell cell = chunk->cellAt(x & CHUNK_MASK, y & CHUNK_MASK);
+                    if (!cell.isEmpty())
+                        row[x - rect.left()] = qToLittleEndian(quint32(gidMapper.cellToGid(cell)));
+                }
+            }
+        }
+    }
+
+    return data;
+}
+
 TileLayerEdit *EditableTileLayer::edit()
 {
     return new TileLayerEdit(this);
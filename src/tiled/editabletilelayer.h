@@ -67,6 +67,7 @@ public:
     Q_INVOKABLE Tiled::Cell cellAt(int x, int y) const;
     Q_INVOKABLE int flagsAt(int x, int y) const;
     Q_INVOKABLE Tiled::EditableTile *tileAt(int x, int y) const;
+    Q_INVOKABLE QByteArray readCells(const QRect &rect) const;
 
     Q_INVOKABLE Tiled::TileLayerEdit *edit();
     Q_INVOKABLE Tiled::TileLayerWangEdit *wangEdit(Tiled::EditableWangSet *wangSet);
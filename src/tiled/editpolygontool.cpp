@@ -34,6 +34,7 @@
 #include "maprenderer.h"
 #include "mapscene.h"
 #include "objectgroup.h"
+#include "objectpicker.h"
 #include "objectselectiontool.h"
 #include "pointhandle.h"
 #include "rangeset.h"
@@ -108,6 +109,8 @@ void EditPolygonTool::activate(MapScene *scene)
 
     connect(scene, &MapScene::parallaxParametersChanged,
             this, &EditPolygonTool::updateHandles);
+    connect(scene, &MapScene::painterScaleChanged,
+            this, &EditPolygonTool::updateHandleMargins);
 }
 
 void EditPolygonTool::deactivate(MapScene *scene)
@@ -117,13 +120,13 @@ void EditPolygonTool::deactivate(MapScene *scene)
 
     disconnect(scene, &MapScene::parallaxParametersChanged,
                this, &EditPolygonTool::updateHandles);
+    disconnect(scene, &MapScene::painterScaleChanged,
+               this, &EditPolygonTool::updateHandleMargins);
 
     abortCurrentAction(Deactivated);
 
     // Delete all handles
-    QHashIterator<MapObject*, QList<PointHandle*> > i(mHandles);
-    while (i.hasNext())
-        qDeleteAll(i.next().value());
+    qDeleteAll(mHandles);
 
     mHoveredHandle = nullptr;
     mHoveredSegment.clear();
@@ -329,7 +332,7 @@ void EditPolygonTool::mouseDoubleClicked(QGraphicsSceneMouseEvent *event)
 
         mapDocument()->undoStack()->push(splitSegment);
 
-        auto newNodeHandle = mHandles.value(mClickedSegment.object).at(mClickedSegment.index + 1);
+        auto newNodeHandle = mHandles.value(mClickedSegment.object)->handle(mClickedSegment.index + 1);
         setSelectedHandle(newNodeHandle);
         setHighlightedHandles(mSelectedHandles);
         mHoveredHandle = newNodeHandle;
@@ -361,6 +364,8 @@ void EditPolygonTool::setSelectedHandles(const QSet<PointHandle *> &handles)
             handle->setSelected(true);
 
     mSelectedHandles = handles;
+
+    releaseUnusedHandles();
 }
 
 void EditPolygonTool::setHighlightedHandles(const QSet<PointHandle *> &handles)
@@ -379,31 +384,25 @@ void EditPolygonTool::setHighlightedHandles(const QSet<PointHandle *> &handles)
 /**
  * Creates and removes handle instances as necessary to adapt to a new object
  * selection.
+ *
+ * The points of each object are painted by a single PointHandles item. A
+ * PointHandle is only created for points that are hovered, clicked or
+ * selected, to keep the scene fast for polygons with many points.
  */
 void EditPolygonTool::updateHandles()
 {
     const QList<MapObject*> &selection = mapDocument()->selectedObjects();
 
-    auto deleteHandle = [this](PointHandle *handle) {
-        if (mHoveredHandle == handle)
-            mHoveredHandle = nullptr;
-        if (mClickedHandle == handle)
-            mClickedHandle = nullptr;
-        if (handle->isSelected())
-            mSelectedHandles.remove(handle);
-        if (handle->isHighlighted())
-            mHighlightedHandles.remove(handle);
-        delete handle;
-    };
-
     // First destroy the handles for objects that are no longer selected
-    QMutableHashIterator<MapObject*, QList<PointHandle*> > i(mHandles);
+    QMutableHashIterator<MapObject*, PointHandles*> i(mHandles);
     while (i.hasNext()) {
         i.next();
         if (!selection.contains(i.key())) {
-            for (PointHandle *handle : std::as_const(i.value()))
-                deleteHandle(handle);
+            const auto handles = i.value()->handles();
+            for (PointHandle *handle : handles)
+                forgetHandle(handle);
 
+            delete i.value();
             i.remove();
         }
     }
@@ -413,6 +412,7 @@ void EditPolygonTool::updateHandles()
         mClickedSegment.clear();
 
     MapRenderer *renderer = mapDocument()->renderer();
+    const qreal margin = handleRadius();
 
     for (MapObject *object : selection) {
         if (!object->cell().isEmpty())
@@ -420,32 +420,86 @@ void EditPolygonTool::updateHandles()
 
         const QPolygonF &polygon = object->polygon();
 
-        QList<PointHandle*> &pointHandles = mHandles[object];
-
-        // Create missing handles
-        while (pointHandles.size() < polygon.size()) {
-            PointHandle *handle = new PointHandle(object, pointHandles.size());
-            pointHandles.append(handle);
-            mapScene()->addItem(handle);
+        PointHandles *&pointHandles = mHandles[object];
+        if (!pointHandles) {
+            pointHandles = new PointHandles(object);
+            pointHandles->setHandleMargin(margin);
+            mapScene()->addItem(pointHandles);
         }
 
         // Remove superfluous handles
-        while (pointHandles.size() > polygon.size())
-            deleteHandle(pointHandles.takeLast());
-
-        if (pointHandles.isEmpty())
-            continue;
+        const auto handles = pointHandles->handles();
+        for (PointHandle *handle : handles) {
+            if (handle->pointIndex() >= polygon.size()) {
+                forgetHandle(handle);
+                pointHandles->deleteHandle(handle);
+            }
+        }
 
         QPointF objectScreenPos = renderer->pixelToScreenCoords(object->position());
         QTransform rotate = rotateAt(objectScreenPos, object->rotation());
         QPointF totalOffset = mapScene()->absolutePositionForLayer(*object->objectGroup());
 
-        // Update the position of all handles
-        for (int i = 0; i < pointHandles.size(); ++i) {
+        // Update the position of all points
+        QVector<QPointF> positions(polygon.size());
+        for (int i = 0; i < polygon.size(); ++i) {
             QPointF pixelPos = polygon.at(i) + object->position();
             QPointF screenPos = renderer->pixelToScreenCoords(pixelPos);
             screenPos = rotate.map(screenPos);
-            pointHandles.at(i)->setPos(totalOffset + screenPos);
+            positions[i] = totalOffset + screenPos;
+        }
+        pointHandles->setPositions(positions);
+    }
+}
+
+/**
+ * Makes sure the painted points fit within the bounds of their items at the
+ * current zoom level.
+ */
+void EditPolygonTool::updateHandleMargins()
+{
+    const qreal margin = handleRadius();
+    for (PointHandles *pointHandles : std::as_const(mHandles))
+        pointHandles->setHandleMargin(margin);
+}
+
+/**
+ * Returns half the size of a handle, in scene coordinates.
+ */
+qreal EditPolygonTool::handleRadius() const
+{
+    return Utils::dpiScaled(qreal(7)) / mapDocument()->renderer()->painterScale();
+}
+
+/**
+ * Removes any references to the given handle, which is about to be deleted.
+ */
+void EditPolygonTool::forgetHandle(PointHandle *handle)
+{
+    if (mHoveredHandle == handle)
+        mHoveredHandle = nullptr;
+    if (mClickedHandle == handle)
+        mClickedHandle = nullptr;
+    if (handle->isSelected())
+        mSelectedHandles.remove(handle);
+    if (handle->isHighlighted())
+        mHighlightedHandles.remove(handle);
+}
+
+/**
+ * Deletes the handles that are no longer hovered, clicked, selected or
+ * highlighted. Their points are painted by their PointHandles item again.
+ */
+void EditPolygonTool::releaseUnusedHandles()
+{
+    for (PointHandles *pointHandles : std::as_const(mHandles)) {
+        const auto handles = pointHandles->handles();
+        for (PointHandle *handle : handles) {
+            if (handle == mHoveredHandle || handle == mClickedHandle ||
+                    handle->isSelected() || handle->isHighlighted())
+                continue;
+
+            pointHandles->deleteHandle(handle);
         }
     }
 }
@@ -473,34 +527,31 @@ void EditPolygonTool::updateSelection(QGraphicsSceneMouseEvent *event)
     rect.setWidth(qMax(qreal(1), rect.width()));
     rect.setHeight(qMax(qreal(1), rect.height()));
 
-    const auto intersectedItems = mapScene()->items(rect,
-                                                    Qt::IntersectsItemShape,
-                                                    Qt::DescendingOrder,
-                                                    viewTransform(event));
-
     if (mapDocument()->selectedObjects().isEmpty()) {
         // Allow selecting some map objects only when there aren't any selected
-        QList<MapObject*> selectedObjects;
+        const ObjectPicker *picker = objectPicker();
+        if (!picker)
+            return;
 
-        for (QGraphicsItem *item : intersectedItems) {
-            if (!item->isEnabled())
-                continue;
-            auto mapObjectItem = qgraphicsitem_cast<MapObjectItem*>(item);
-            if (mapObjectItem && mapObjectItem->mapObject()->objectGroup()->isUnlocked())
-                selectedObjects.append(mapObjectItem->mapObject());
-        }
+        QList<MapObject*> selectedObjects = picker->objectsIn(rect,
+                                                              Qt::IntersectsItemShape,
+                                                              viewTransform(event));
 
         filterMapObjects(selectedObjects);
 
         if (!selectedObjects.isEmpty())
             mapDocument()->setSelectedObjects(selectedObjects);
     } else {
-        // Update the selected handles
+        // Update the selected handles, which intersect the rectangle when
+        // their point is within a handle radius from it
+        const qreal radius = handleRadius();
+        const QRectF pointsRect = rect.adjusted(-radius, -radius, radius, radius);
         QSet<PointHandle*> selectedHandles;
 
-        for (QGraphicsItem *item : intersectedItems) {
-            if (PointHandle *handle = qgraphicsitem_cast<PointHandle*>(item))
-                selectedHandles.insert(handle);
+        for (PointHandles *pointHandles : std::as_const(mHandles)) {
+            const auto indexes = pointHandles->pointsIn(pointsRect);
+            for (int index : indexes)
+                selectedHandles.insert(pointHandles->handle(index));
         }
 
         if (event->modifiers() & (Qt::ControlModifier | Qt::ShiftModifier))
@@ -697,9 +748,9 @@ QSet<PointHandle *> EditPolygonTool::clickedHandles() const
     if (mClickedHandle) {
         handles.insert(mClickedHandle);
     } else if (mClickedSegment) {
-        auto handlesForObject = mHandles.value(mClickedSegment.object);
-        handles.insert(handlesForObject.at(mClickedSegment.index));
-        handles.insert(handlesForObject.at((mClickedSegment.index + 1) % handlesForObject.size()));
+        PointHandles *handlesForObject = mHandles.value(mClickedSegment.object);
+        handles.insert(handlesForObject->handle(mClickedSegment.index));
+        handles.insert(handlesForObject->handle((mClickedSegment.index + 1) % handlesForObject->pointCount()));
     }
 
     return handles;
@@ -1083,6 +1134,9 @@ void EditPolygonTool::updateHover(const QPointF &scenePos, QGraphicsSceneMouseEv
         QGraphicsItem *hoveredItem = mapScene()->itemAt(scenePos, transform);
         hoveredHandle = qgraphicsitem_cast<PointHandle*>(hoveredItem);
 
+        if (!hoveredHandle)
+            hoveredHandle = pointHandleAt(scenePos);
+
         if (!hoveredHandle) {
             // check if we're hovering a line segment
             MapRenderer *renderer = mapDocument()->renderer();
@@ -1129,15 +1183,46 @@ void EditPolygonTool::updateHover(const QPointF &scenePos, QGraphicsSceneMouseEv
     if (hoveredHandle) {
         highlightedHandles.insert(hoveredHandle);
     } else if (hoveredSegment) {
-        auto handles = mHandles.value(hoveredSegment.object);
-        highlightedHandles.insert(handles.at(hoveredSegment.index));
-        highlightedHandles.insert(handles.at((hoveredSegment.index + 1) % handles.size()));
+        PointHandles *handles = mHandles.value(hoveredSegment.object);
+        highlightedHandles.insert(handles->handle(hoveredSegment.index));
+        highlightedHandles.insert(handles->handle((hoveredSegment.index + 1) % handles->pointCount()));
     }
 
     setHighlightedHandles(highlightedHandles);
 
     mHoveredHandle = hoveredHandle;
     mHoveredSegment = hoveredSegment;
+
+    releaseUnusedHandles();
+}
+
+/**
+ * Returns the handle of the point closest to \a scenePos, creating it when
+ * necessary. Returns nullptr when no point is close enough.
+ */
+PointHandle *EditPolygonTool::pointHandleAt(const QPointF &scenePos) const
+{
+    const qreal radius = handleRadius();
+
+    PointHandles *closestHandles = nullptr;
+    int closestIndex = -1;
+    qreal closestDistance = 0;
+
+    for (PointHandles *pointHandles : std::as_const(mHandles)) {
+        const int index = pointHandles->pointAt(scenePos, radius);
+        if (index == -1)
+            continue;
+
+        const QPointF delta = pointHandles->positions().at(index) - scenePos;
+        const qreal distance = QPointF::dotProduct(delta, delta);
+        if (!closestHandles || distance < closestDistance) {
+            closestHandles = pointHandles;
+            closestIndex = index;
+            closestDistance = distance;
+        }
+    }
+
+    return closestHandles ? closestHandles->handle(closestIndex) : nullptr;
 }
 
 #include "moc_editpolygontool.cpp"
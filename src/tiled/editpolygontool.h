@@ -32,6 +32,7 @@ class QGraphicsItem;
 namespace Tiled {
 
 class PointHandle;
+class PointHandles;
 class SelectionRectangle;
 
 /**
@@ -70,6 +71,10 @@ protected:
 
 private:
     void updateHandles();
+    void updateHandleMargins();
+    qreal handleRadius() const;
+    void forgetHandle(PointHandle *handle);
+    void releaseUnusedHandles();
     void objectsAboutToBeRemoved(const QList<MapObject *> &objects);
 
     void joinNodes();
@@ -78,6 +83,7 @@ private:
     void extendPolyline();
 
     void updateHover(const QPointF &scenePos, QGraphicsSceneMouseEvent *event = nullptr);
+    PointHandle *pointHandleAt(const QPointF &scenePos) const;
 
     void setSelectedHandles(const QSet<PointHandle*> &handles);
     void setSelectedHandle(PointHandle *handle)
@@ -137,8 +143,8 @@ private:
     QPoint mScreenStart;
     Qt::KeyboardModifiers mModifiers;
 
-    /// The list of handles associated with each selected map object
-    QHash<MapObject*, QList<PointHandle*> > mHandles;
+    /// The handles associated with each selected map object
+    QHash<MapObject*, PointHandles*> mHandles;
     QSet<PointHandle*> mSelectedHandles;
     QSet<PointHandle*> mHighlightedHandles;
 };
@@ -38,6 +38,7 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QImageWriter>
+#include <QProgressDialog>
 
 using namespace Tiled;
 
@@ -184,34 +185,63 @@ void ExportAsImageDialog::accept()
     if (session::useCurrentScale)
         imageSize *= mCurrentScale;
 
-    try {
-        QImage image(imageSize, QImage::Format_ARGB32_Premultiplied);
-
-        if (image.isNull()) {
-            const size_t gigabyte = 1073741824;
-            const size_t memory = size_t(imageSize.width()) * size_t(imageSize.height()) * 4;
-            const double gigabytes = static_cast<double>(memory) / gigabyte;
-
-            QMessageBox::critical(this,
-                                  tr("Image too Big"),
-                                  tr("The resulting image would be %1 x %2 pixels and take %3 GB of memory. "
-                                     "Tiled is unable to create such an image. Try reducing the zoom level.")
-                                  .arg(imageSize.width())
-                                  .arg(imageSize.height())
-                                  .arg(gigabytes, 0, 'f', 2));
+    QProgressDialog progressDialog(tr("Exporting map as image..."), tr("Cancel"), 0, 0, this);
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.setMinimumDuration(500);
+
+    const auto progress = [&] (int finished, int total) {
+        progressDialog.setMaximum(total);
+        progressDialog.setValue(finished);
+        return !progressDialog.wasCanceled();
+    };
+
+    // Large images are streamed to PNG files, so that they don't need to be
+    // held in memory as a whole
+    const qint64 streamingThreshold = qint64(256) * 1024 * 1024;
+    const qint64 imageBytes = qint64(imageSize.width()) * imageSize.height() * 4;
+    const bool isPng = QFileInfo(fileName).suffix().compare(QLatin1String("png"), Qt::CaseInsensitive) == 0;
+
+    if (isPng && imageBytes > streamingThreshold) {
+        QString error;
+        if (!miniMapRenderer.renderToPng(fileName, imageSize, renderFlags, progress, &error)) {
+            // Keep the dialog open when the export failed or was canceled
+            if (!error.isEmpty())
+                QMessageBox::critical(this, tr("Error Exporting Image"), error);
             return;
         }
+    } else {
+        try {
+            QImage image(imageSize, QImage::Format_ARGB32_Premultiplied);
+
+            if (image.isNull()) {
+                const size_t gigabyte = 1073741824;
+                const size_t memory = size_t(imageSize.width()) * size_t(imageSize.height()) * 4;
+                const double gigabytes = static_cast<double>(memory) / gigabyte;
+
+                QMessageBox::critical(this,
+                                      tr("Image too Big"),
+                                      tr("The resulting image would be %1 x %2 pixels and take %3 GB of memory. "
+                                         "Tiled is unable to create such an image. Try reducing the zoom level "
+                                         "or exporting to PNG, which supports images of any size.")
+                                      .arg(imageSize.width())
+                                      .arg(imageSize.height())
+                                      .arg(gigabytes, 0, 'f', 2));
+                return;
+            }
 
-        miniMapRenderer.renderToImage(image, renderFlags);
+            // Keep the dialog open when the export was canceled
+            if (!miniMapRenderer.renderToImageParallel(image, renderFlags, progress))
+                return;
 
-        image.save(fileName);
+            image.save(fileName);
 
-    } catch (const std::bad_alloc &) {
-        QMessageBox::critical(this,
-                              tr("Out of Memory"),
-                              tr("Could not allocate sufficient memory for the image. "
-                                 "Try reducing the zoom level or using a 64-bit version of Tiled."));
-        return;
+        } catch (const std::bad_alloc &) {
+            QMessageBox::critical(this,
+                                  tr("Out of Memory"),
+                                  tr("Could not allocate sufficient memory for the image. "
+                                     "Try reducing the zoom level or using a 64-bit version of Tiled."));
+            return;
+        }
     }
 
     mPath = QFileInfo(fileName).path();
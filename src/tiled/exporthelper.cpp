@@ -20,10 +20,14 @@
 
 #include "exporthelper.h"
 
+#include "logginginterface.h"
 #include "mapobject.h"
 #include "objectgroup.h"
+#include "tilesetexportcache.h"
 #include "wangset.h"
 
+#include <QCoreApplication>
+
 namespace Tiled {
 
 /**
@@ -66,6 +70,14 @@ SharedTileset ExportHelper::prepareExportTileset(const SharedTileset &tileset,
         return tileset;
     }
 
+    // During a batch export, external tilesets are prepared only once
+    TilesetExportCache *cache = tileset->isExternal() ? TilesetExportCache::instance()
+                                                      : nullptr;
+    if (cache) {
+        if (SharedTileset exportTileset = cache->exportTileset(tileset.data(), int(mOptions)))
+            return exportTileset;
+    }
+
     // Either needs to be embedded or is already embedded and we may need to
     // make other changes to the tileset
     SharedTileset exportTileset = tileset->clone();
@@ -91,6 +103,9 @@ SharedTileset ExportHelper::prepareExportTileset(const SharedTileset &tileset,
     if (mOptions.testFlag(Preferences::ResolveObjectTypesAndProperties))
         resolveProperties(exportTileset.data());
 
+    if (cache)
+        cache->insertExportTileset(tileset.data(), int(mOptions), exportTileset);
+
     return exportTileset;
 }
 
@@ -100,12 +115,17 @@ const Map *ExportHelper::prepareExportMap(const Map *map, std::unique_ptr<Map> &
                                      && map->exportFormat.isEmpty());
 
     // If no export options are active, return the same map
-    if (!(mOptions & ~Preferences::ExportMinimized) && !hasExportSettings)
+    if (!(mOptions & ~Preferences::ExportMinimized) && !hasExportSettings
+            && !map->hasPagedOutChunks())
         return map;
 
     // Make a copy to which export options are applied
     exportMap = map->clone();
 
+    // Export formats need all chunks in memory
+    if (!exportMap->pageInAllChunks())
+        WARNING(QCoreApplication::translate("ExportHelper", "Some chunks of the map could not be loaded, so their tiles are missing from the export"));
+
     // We don't want to save the export options in the exported file
     if (hasExportSettings) {
         exportMap->exportFileName.clear();
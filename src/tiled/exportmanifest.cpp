@@ -0,0 +1,346 @@
+/*
+ * exportmanifest.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "exportmanifest.h"
+
+#include "fileformat.h"
+#include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "objecttemplate.h"
+#include "project.h"
+#include "projectmanager.h"
+#include "tile.h"
+#include "tileset.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+namespace Tiled {
+
+static const int manifestVersion = 1;
+
+static QByteArray hashFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(&file);
+    return hash.result().toHex();
+}
+
+static void addFile(QStringList &files, const QString &fileName)
+{
+    if (!fileName.isEmpty() && !fileName.startsWith(QLatin1Char(':')) && !files.contains(fileName))
+        files.append(fileName);
+}
+
+static void addFile(QStringList &files, const QUrl &url)
+{
+    if (url.isLocalFile())
+        addFile(files, url.toLocalFile());
+}
+
+static void addTileset(QStringList &files, const Tileset *tileset)
+{
+    addFile(files, tileset->fileName());
+    addFile(files, tileset->imageSource());
+
+    if (tileset->isCollection())
+        for (const Tile *tile : tileset->tiles())
+            addFile(files, tile->imageSource());
+}
+
+
+ExportManifest::ExportManifest(const QString &fileName)
+    : mFileName(fileName)
+{
+}
+
+/**
+ * Reads the manifest from its file. Returns false when the file could not
+ * be read, in which case the manifest is empty.
+ */
+bool ExportManifest::load()
+{
+    mEntries.clear();
+    mModified = false;
+
+    QFile file(mFileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root.value(QLatin1String("version")).toInt() != manifestVersion)
+        return false;
+
+    const QDir dir = QFileInfo(mFileName).dir();
+    const QJsonObject targets = root.value(QLatin1String("targets")).toObject();
+
+    for (auto it = targets.begin(), end = targets.end(); it != end; ++it) {
+        const QJsonObject object = it.value().toObject();
+
+        Entry entry;
+        entry.sourceFile = QDir::cleanPath(dir.absoluteFilePath(object.value(QLatin1String("source")).toString()));
+        entry.settings = object.value(QLatin1String("settings")).toString();
+        entry.targetLastModified = object.value(QLatin1String("targetModified")).toVariant().toLongLong();
+        entry.targetSize = object.value(QLatin1String("targetSize")).toVariant().toLongLong();
+
+        const QJsonArray inputs = object.value(QLatin1String("inputs")).toArray();
+        for (const QJsonValue &value : inputs) {
+            const QJsonObject inputObject = value.toObject();
+
+            Input input;
+            input.fileName = QDir::cleanPath(dir.absoluteFilePath(inputObject.value(QLatin1String("file")).toString()));
+            input.lastModified = inputObject.value(QLatin1String("modified")).toVariant().toLongLong();
+            input.size = inputObject.value(QLatin1String("size")).toVariant().toLongLong();
+            input.hash = inputObject.value(QLatin1String("hash")).toString().toLatin1();
+            entry.inputs.append(input);
+        }
+
+        mEntries.insert(QDir::cleanPath(dir.absoluteFilePath(it.key())), entry);
+    }
+
+    return true;
+}
+
+/**
+ * Writes the manifest to its file, unless nothing changed since it was
+ * loaded.
+ */
+bool ExportManifest::save() const
+{
+    if (!mModified)
+        return true;
+
+    const QDir dir = QFileInfo(mFileName).dir();
+    if (!dir.mkpath(QStringLiteral(".")))
+        return false;
+
+    QJsonObject targets;
+
+    for (auto it = mEntries.cbegin(), end = mEntries.cend(); it != end; ++it) {
+        QJsonArray inputs;
+        for (const Input &input : it->inputs) {
+            inputs.append(QJsonObject {
+                { QStringLiteral("file"), dir.relativeFilePath(input.fileName) },
+                { QStringLiteral("modified"), QString::number(input.lastModified) },
+                { QStringLiteral("size"), QString::number(input.size) },
+                { QStringLiteral("hash"), QString::fromLatin1(input.hash) },
+            });
+        }
+
+        targets.insert(dir.relativeFilePath(it.key()), QJsonObject {
+            { QStringLiteral("source"), dir.relativeFilePath(it->sourceFile) },
+            { QStringLiteral("settings"), it->settings },
+            { QStringLiteral("targetModified"), QString::number(it->targetLastModified) },
+            { QStringLiteral("targetSize"), QString::number(it->targetSize) },
+            { QStringLiteral("inputs"), inputs },
+        });
+    }
+
+    const QJsonObject root {
+        { QStringLiteral("version"), manifestVersion },
+        { QStringLiteral("targets"), targets },
+    };
+
+    QSaveFile file(mFileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(QJsonDocument(root).toJson());
+    return file.commit();
+}
+
+/**
+ * Returns whether \a targetFile was exported from \a sourceFile with the
+ * given \a settings, and none of the inputs used at that time changed since.
+ *
+ * Also returns false when the target file was changed or removed.
+ */
+bool ExportManifest::isUpToDate(const QString &targetFile,
+                                const QString &sourceFile,
+                                const QString &settings)
+{
+    const auto it = mEntries.find(QFileInfo(targetFile).absoluteFilePath());
+    if (it == mEntries.end())
+        return false;
+
+    Entry &entry = *it;
+    if (entry.sourceFile != QFileInfo(sourceFile).absoluteFilePath() || entry.settings != settings)
+        return false;
+
+    const QFileInfo targetInfo(targetFile);
+    if (!targetInfo.isFile() ||
+            targetInfo.lastModified().toMSecsSinceEpoch() != entry.targetLastModified ||
+            targetInfo.size() != entry.targetSize)
+        return false;
+
+    for (Input &input : entry.inputs)
+        if (!isUnchanged(input))
+            return false;
+
+    return true;
+}
+
+/**
+ * Records that \a targetFile was just exported from \a sourceFile with the
+ * given \a settings. The \a inputs are the files the export depended on,
+ * besides the source file.
+ */
+void ExportManifest::update(const QString &targetFile,
+                            const QString &sourceFile,
+                            const QString &settings,
+                            const QStringList &inputs)
+{
+    const QFileInfo targetInfo(targetFile);
+
+    Entry entry;
+    entry.sourceFile = QFileInfo(sourceFile).absoluteFilePath();
+    entry.settings = settings;
+    entry.targetLastModified = targetInfo.lastModified().toMSecsSinceEpoch();
+    entry.targetSize = targetInfo.size();
+
+    QStringList files { entry.sourceFile };
+    for (const QString &fileName : inputs)
+        addFile(files, QFileInfo(fileName).absoluteFilePath());
+
+    for (const QString &fileName : std::as_const(files)) {
+        const QFileInfo fileInfo(fileName);
+
+        Input input;
+        input.fileName = fileName;
+        if (fileInfo.isFile()) {
+            input.lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+            input.size = fileInfo.size();
+            input.hash = hashFile(fileName);
+        }
+        entry.inputs.append(input);
+    }
+
+    mEntries.insert(targetInfo.absoluteFilePath(), entry);
+    mModified = true;
+}
+
+/**
+ * Forgets about \a targetFile, for example because it was exported from
+ * unsaved changes.
+ */
+void ExportManifest::remove(const QString &targetFile)
+{
+    if (mEntries.remove(QFileInfo(targetFile).absoluteFilePath()))
+        mModified = true;
+}
+
+/**
+ * Takes over the entries of the \a other manifest, which take precedence.
+ */
+void ExportManifest::merge(const ExportManifest &other)
+{
+    for (auto it = other.mEntries.cbegin(), end = other.mEntries.cend(); it != end; ++it)
+        mEntries.insert(it.key(), it.value());
+
+    if (!other.mEntries.isEmpty())
+        mModified = true;
+}
+
+/**
+ * Returns a string identifying the export settings, which need to match for
+ * a previous export to be reused.
+ */
+QString ExportManifest::settings(const FileFormat *format,
+                                 Preferences::ExportOptions options)
+{
+    return QStringLiteral("%1;%2;%3;%4").arg(format->shortName(),
+                                             QString::number(int(options)),
+                                             FileFormat::versionString(),
+                                             QCoreApplication::applicationVersion());
+}
+
+/**
+ * Returns the files the given \a map depends on: its external tilesets and
+ * their images, its templates, the images of its image layers and the
+ * project, which defines the custom property types.
+ */
+QStringList ExportManifest::dependencies(const Map *map)
+{
+    QStringList files;
+
+    for (const SharedTileset &tileset : map->tilesets())
+        addTileset(files, tileset.data());
+
+    for (Layer *layer : map->allLayers()) {
+        if (auto imageLayer = layer->asImageLayer()) {
+            addFile(files, imageLayer->imageSource());
+        } else if (auto objectGroup = layer->asObjectGroup()) {
+            for (const MapObject *object : objectGroup->objects()) {
+                const ObjectTemplate *objectTemplate = object->objectTemplate();
+                if (!objectTemplate)
+                    continue;
+
+                addFile(files, objectTemplate->fileName());
+
+                if (const MapObject *templateObject = objectTemplate->object())
+                    if (const Tileset *tileset = templateObject->cell().tileset())
+                        addTileset(files, tileset);
+            }
+        }
+    }
+
+    if (ProjectManager *projectManager = ProjectManager::instance())
+        addFile(files, projectManager->project().fileName());
+
+    return files;
+}
+
+/**
+ * Returns whether the given \a input still has the same contents. When only
+ * its modification time changed, the stored modification time is updated.
+ */
+bool ExportManifest::isUnchanged(Input &input)
+{
+    const QFileInfo fileInfo(input.fileName);
+    if (!fileInfo.isFile())
+        return input.size == -1;
+
+    const qint64 lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+    if (lastModified == input.lastModified && fileInfo.size() == input.size)
+        return true;
+
+    if (fileInfo.size() != input.size || hashFile(input.fileName) != input.hash)
+        return false;
+
+    input.lastModified = lastModified;
+    mModified = true;
+    return true;
+}
+
+} // namespace Tiled
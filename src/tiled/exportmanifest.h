@@ -0,0 +1,100 @@
+/*
+ * exportmanifest.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "preferences.h"
+#include "tilededitor_global.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace Tiled {
+
+class FileFormat;
+class Map;
+
+/**
+ * Remembers which files were used to produce each exported file, so that
+ * exports whose inputs did not change can be skipped.
+ *
+ * For each target file, the manifest stores the source file, the export
+ * settings and a content hash of every input: the source file itself and
+ * the tilesets, templates, images and project it depends on. The
+ * modification time and size of each input are stored as well, so that
+ * inputs are only hashed again when they appear to have changed.
+ *
+ * Paths are stored relative to the manifest, so that a manifest can be
+ * kept along with the exported files.
+ */
+class TILED_EDITOR_EXPORT ExportManifest
+{
+public:
+    explicit ExportManifest(const QString &fileName = QString());
+
+    const QString &fileName() const { return mFileName; }
+
+    bool load();
+    bool save() const;
+
+    bool isUpToDate(const QString &targetFile,
+                    const QString &sourceFile,
+                    const QString &settings);
+
+    void update(const QString &targetFile,
+                const QString &sourceFile,
+                const QString &settings,
+                const QStringList &inputs);
+    void remove(const QString &targetFile);
+    void merge(const ExportManifest &other);
+
+    static QString settings(const FileFormat *format,
+                            Preferences::ExportOptions options);
+    static QStringList dependencies(const Map *map);
+
+private:
+    struct Input
+    {
+        QString fileName;
+        qint64 lastModified = 0;
+        qint64 size = -1;
+        QByteArray hash;
+    };
+
+    struct Entry
+    {
+        QString sourceFile;
+        QString settings;
+        qint64 targetLastModified = 0;
+        qint64 targetSize = -1;
+        QVector<Input> inputs;
+    };
+
+    bool isUnchanged(Input &input);
+
+    QString mFileName;
+    QHash<QString, Entry> mEntries;
+    bool mModified = false;
+};
+
+} // namespace Tiled
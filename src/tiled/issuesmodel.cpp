@@ -33,8 +33,8 @@ IssuesModel::IssuesModel(QObject *parent)
     mWarningIcon.addFile(QLatin1String("://images/24/dialog-warning.png"));
     mWarningIcon.addFile(QLatin1String("://images/32/dialog-warning.png"));
 
-    connect(&LoggingInterface::instance(), &LoggingInterface::issue,
-            this, &IssuesModel::addIssue);
+    connect(&LoggingInterface::instance(), &LoggingInterface::issuesReported,
+            this, &IssuesModel::addIssues);
     connect(&LoggingInterface::instance(), &LoggingInterface::removeIssuesWithContext,
             this, &IssuesModel::removeIssuesWithContext);
 }
@@ -47,24 +47,53 @@ IssuesModel &IssuesModel::instance()
 
 void IssuesModel::addIssue(const Issue &issue)
 {
-    int i = mIssues.indexOf(issue);
-    if (i != -1) {
-        auto &existingIssue = mIssues[i];
-        existingIssue.addOccurrence(issue);
+    addIssues({ issue });
+}
 
-        QModelIndex modelIndex = index(i);
-        emit dataChanged(modelIndex, modelIndex);
-        return;
-    }
+/**
+ * Adds the given \a issues, merging any issues that are already present.
+ *
+ * Emits a single insertion and a single change notification for the whole
+ * batch.
+ */
+void IssuesModel::addIssues(const QVector<Issue> &issues)
+{
+    QVector<Issue> newIssues;
+    int firstChanged = mIssues.size();
+    int lastChanged = -1;
+
+    for (const Issue &issue : issues) {
+        const QPair<int, QString> key(issue.severity(), issue.text());
+        const int i = mIssueIndexes.value(key, -1);
+
+        if (i != -1) {
+            if (i < mIssues.size()) {
+                mIssues[i].addOccurrence(issue);
+                firstChanged = std::min(firstChanged, i);
+                lastChanged = std::max(lastChanged, i);
+            } else {
+                newIssues[i - mIssues.size()].addOccurrence(issue);
+            }
+            continue;
+        }
+
+        switch (issue.severity()) {
+        case Issue::Error: ++mErrorCount; break;
+        case Issue::Warning: ++mWarningCount; break;
+        }
 
-    switch (issue.severity()) {
-    case Issue::Error: ++mErrorCount; break;
-    case Issue::Warning: ++mWarningCount; break;
+        mIssueIndexes.insert(key, mIssues.size() + newIssues.size());
+        newIssues.append(issue);
     }
 
-    beginInsertRows(QModelIndex(), mIssues.size(), mIssues.size());
-    mIssues.append(issue);
-    endInsertRows();
+    if (lastChanged != -1)
+        emit dataChanged(index(firstChanged), index(lastChanged));
+
+    if (!newIssues.isEmpty()) {
+        beginInsertRows(QModelIndex(), mIssues.size(), mIssues.size() + newIssues.size() - 1);
+        mIssues.append(newIssues);
+        endInsertRows();
+    }
 }
 
 void IssuesModel::removeIssues(const QList<unsigned> &issueIds)
@@ -84,6 +113,9 @@ void IssuesModel::removeIssues(const QList<unsigned> &issueIds)
 
 void IssuesModel::removeIssuesWithContext(const void *context)
 {
+    // Make sure no pending issues with this context get added afterwards
+    LoggingInterface::instance().flushIssues();
+
     RangeSet<int> indexes;
 
     for (int i = 0, size = mIssues.size(); i < size; ++i)
@@ -118,15 +150,32 @@ void IssuesModel::removeIssues(const RangeSet<int> &indexes)
         mIssues.remove(it.first(), it.length());
         endRemoveRows();
     } while (it != begin);
+
+    rebuildIssueIndexes();
+}
+
+void IssuesModel::rebuildIssueIndexes()
+{
+    mIssueIndexes.clear();
+    mIssueIndexes.reserve(mIssues.size());
+
+    for (int i = 0, size = mIssues.size(); i < size; ++i) {
+        const Issue &issue = mIssues.at(i);
+        const QPair<int, QString> key(issue.severity(), issue.text());
+        mIssueIndexes.insert(key, i);
+    }
 }
 
 void IssuesModel::clear()
 {
+    LoggingInterface::instance().flushIssues();
+
     beginResetModel();
 
     mErrorCount = 0;
     mWarningCount = 0;
     mIssues.clear();
+    mIssueIndexes.clear();
 
     endResetModel();
 }
@@ -43,6 +43,7 @@ public:
     static IssuesModel &instance();
 
     void addIssue(const Issue &issue);
+    void addIssues(const QVector<Issue> &issues);
     void removeIssues(const QList<unsigned> &issueIds);
     void removeIssuesWithContext(const void *context);
     void clear();
@@ -58,8 +59,10 @@ public:
 
 private:
     void removeIssues(const RangeSet<int> &indexes);
+    void rebuildIssueIndexes();
 
     QVector<Issue> mIssues;
+    QHash<QPair<int, QString>, int> mIssueIndexes;
 
     int mErrorCount = 0;
     int mWarningCount = 0;
@@ -0,0 +1,346 @@
+/*
+ * layercompositionitem.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "layercompositionitem.h"
+
+#include "layeritem.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+#include <algorithm>
+
+namespace Tiled {
+
+/**
+ * Sets the composition of the given \a item and all layer items below it,
+ * so that they report changes to the composition.
+ */
+static void setComposition(QGraphicsItem *item, LayerCompositionItem *composition)
+{
+    if (auto layerItem = dynamic_cast<LayerItem*>(item)) {
+        layerItem->setComposition(composition);
+
+        const auto children = item->childItems();
+        for (QGraphicsItem *child : children)
+            setComposition(child, composition);
+    }
+}
+
+/**
+ * Paints the given \a item and its children like the scene would, but with
+ * the given \a opacity for the item itself.
+ */
+static void paintItem(QPainter *painter, QGraphicsItem *item,
+                      const QTransform &viewTransform, qreal opacity,
+                      const QRectF &sceneRect, QWidget *widget)
+{
+    if (!item->isVisible() || opacity <= 0)
+        return;
+
+    const auto children = item->childItems();    // sorted by stacking order
+
+    auto paintChild = [&] (QGraphicsItem *child) {
+        paintItem(painter, child, viewTransform, opacity * child->opacity(),
+                  sceneRect, widget);
+    };
+
+    int i = 0;
+    for (; i < children.size(); ++i) {
+        QGraphicsItem *child = children.at(i);
+        if (child->zValue() >= 0 && !(child->flags() & QGraphicsItem::ItemStacksBehindParent))
+            break;
+        paintChild(child);
+    }
+
+    if (!(item->flags() & QGraphicsItem::ItemHasNoContents)) {
+        QStyleOptionGraphicsItem option;
+        option.exposedRect = item->boundingRect();
+        if (!(item->flags() & QGraphicsItem::ItemIgnoresTransformations))
+            option.exposedRect &= item->mapRectFromScene(sceneRect);
+
+        if (!option.exposedRect.isEmpty()) {
+            painter->save();
+            painter->setWorldTransform(item->deviceTransform(viewTransform));
+            painter->setOpacity(opacity);
+            item->paint(painter, &option, widget);
+            painter->restore();
+        }
+    }
+
+    for (; i < children.size(); ++i)
+        paintChild(children.at(i));
+}
+
+LayerCompositionItem::LayerCompositionItem(QGraphicsItem *parent)
+    : QGraphicsItem(parent)
+{
+    setAcceptedMouseButtons(Qt::MouseButtons());
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+LayerCompositionItem::~LayerCompositionItem()
+{
+    setLayerItems({});
+}
+
+/**
+ * Sets the layer items drawn by this composition, in drawing order. These
+ * need to be consecutive siblings and share their parent with this item.
+ *
+ * Items that are no longer part of the composition get their opacity back.
+ */
+void LayerCompositionItem::setLayerItems(const QVector<LayerItem*> &layerItems)
+{
+    QVector<Entry> entries;
+    entries.reserve(layerItems.size());
+    bool changed = false;
+
+    for (LayerItem *layerItem : layerItems) {
+        auto it = std::find_if(mEntries.begin(), mEntries.end(),
+                               [=] (const Entry &entry) { return entry.layerItem == layerItem; });
+
+        if (it != mEntries.end()) {
+            entries.append(*it);
+            mEntries.erase(it);
+        } else {
+            entries.append(Entry { layerItem, layerItem->opacity() });
+            layerItem->setOpacity(0);
+            changed = true;
+        }
+
+        // Also done for existing items, since layers may have been added
+        setComposition(layerItem, this);
+    }
+
+    changed |= !mEntries.isEmpty();
+
+    for (const Entry &entry : std::as_const(mEntries))
+        release(entry);
+
+    mEntries.swap(entries);
+
+    if (changed) {
+        setVisible(!mEntries.isEmpty());
+        invalidate();
+    }
+}
+
+/**
+ * Removes the given \a layerItem from the composition, without restoring its
+ * opacity. Used when the item is about to be deleted.
+ */
+void LayerCompositionItem::removeLayerItem(LayerItem *layerItem)
+{
+    auto it = std::find_if(mEntries.begin(), mEntries.end(),
+                           [=] (const Entry &entry) { return entry.layerItem == layerItem; });
+    if (it == mEntries.end())
+        return;
+
+    mEntries.erase(it);
+    setVisible(!mEntries.isEmpty());
+    invalidate();
+}
+
+bool LayerCompositionItem::contains(const LayerItem *layerItem) const
+{
+    return std::any_of(mEntries.begin(), mEntries.end(),
+                       [=] (const Entry &entry) { return entry.layerItem == layerItem; });
+}
+
+/**
+ * Changes the opacity the given \a layerItem is drawn with. When the item
+ * isn't part of this composition, its opacity is set directly.
+ */
+void LayerCompositionItem::setLayerItemOpacity(LayerItem *layerItem, qreal opacity)
+{
+    for (Entry &entry : mEntries) {
+        if (entry.layerItem == layerItem) {
+            if (entry.opacity != opacity) {
+                entry.opacity = opacity;
+                invalidate();
+            }
+            return;
+        }
+    }
+
+    layerItem->setOpacity(opacity);
+}
+
+/**
+ * Drops the cached pixmap. Should be called for any change that may affect
+ * the appearance or the size of the composited layers.
+ */
+void LayerCompositionItem::invalidate()
+{
+    mCacheValid = false;
+    mCache = QPixmap();
+    mDirtyRects.clear();
+
+    updateBoundingRect();
+    update();
+}
+
+/**
+ * Marks the given \a rect as needing to be rendered again. The \a rect is in
+ * item coordinates.
+ */
+void LayerCompositionItem::invalidate(const QRectF &rect)
+{
+    if (mCacheValid)
+        mDirtyRects.append(rect);
+
+    update(rect);
+}
+
+QRectF LayerCompositionItem::boundingRect() const
+{
+    return mBoundingRect;
+}
+
+void LayerCompositionItem::paint(QPainter *painter,
+                                 const QStyleOptionGraphicsItem *option,
+                                 QWidget *widget)
+{
+    const QTransform transform = painter->worldTransform();
+    const QRect bounds = transform.mapRect(mBoundingRect).toAlignedRect();
+    const QRect exposed = transform.mapRect(option->exposedRect).toAlignedRect() & bounds;
+
+    // The cache can be reused when the view was only scrolled by whole pixels
+    QPoint shift;
+    bool reuse = mCacheValid &&
+            transform.type() <= QTransform::TxScale &&
+            transform.m11() == mCacheTransform.m11() &&
+            transform.m22() == mCacheTransform.m22();
+
+    if (reuse) {
+        const qreal dx = transform.dx() - mCacheTransform.dx();
+        const qreal dy = transform.dy() - mCacheTransform.dy();
+        shift = QPoint(qRound(dx), qRound(dy));
+
+        reuse = qFuzzyIsNull(dx - shift.x()) &&
+                qFuzzyIsNull(dy - shift.y()) &&
+                mCacheRect.translated(shift).contains(exposed);
+    }
+
+    const QTransform viewTransform = sceneTransform().inverted() * transform;
+
+    if (!reuse) {
+        // Cover the device with some margin, to allow for scrolling
+        const QSize deviceSize(painter->device()->width(), painter->device()->height());
+        const QRect deviceRect = QRect(QPoint(), deviceSize).adjusted(-deviceSize.width() / 4,
+                                                                      -deviceSize.height() / 4,
+                                                                      deviceSize.width() / 4,
+                                                                      deviceSize.height() / 4);
+
+        mCacheRect = (deviceRect & bounds) | exposed;
+        mCacheTransform = transform;
+        mDirtyRects.clear();
+        shift = QPoint();
+
+        if (mCacheRect.isEmpty()) {
+            mCache = QPixmap();
+            mCacheValid = true;
+            return;
+        }
+
+        const qreal pixelRatio = painter->device()->devicePixelRatioF();
+        mCache = QPixmap(mCacheRect.size() * pixelRatio);
+        mCache.setDevicePixelRatio(pixelRatio);
+        mCache.fill(Qt::transparent);
+
+        QPainter cachePainter(&mCache);
+        cachePainter.setRenderHints(painter->renderHints());
+        render(&cachePainter, mCacheRect, viewTransform, widget);
+
+        mCacheValid = true;
+    } else if (!mDirtyRects.isEmpty()) {
+        const QTransform cacheViewTransform = sceneTransform().inverted() * mCacheTransform;
+
+        QPainter cachePainter(&mCache);
+        cachePainter.setRenderHints(painter->renderHints());
+
+        for (const QRectF &dirtyRect : std::as_const(mDirtyRects)) {
+            const QRect rect = mCacheTransform.mapRect(dirtyRect).toAlignedRect() & mCacheRect;
+            if (rect.isEmpty())
+                continue;
+
+            const QRect local = rect.translated(-mCacheRect.topLeft());
+            cachePainter.save();
+            cachePainter.setClipRect(local);
+            cachePainter.setCompositionMode(QPainter::CompositionMode_Clear);
+            cachePainter.fillRect(local, Qt::transparent);
+            cachePainter.restore();
+
+            cachePainter.save();
+            cachePainter.setClipRect(local);
+            render(&cachePainter, rect, cacheViewTransform, widget);
+            cachePainter.restore();
+        }
+
+        mDirtyRects.clear();
+    }
+
+    if (mCache.isNull())
+        return;
+
+    painter->save();
+    painter->setWorldTransform(QTransform());
+    painter->drawPixmap(mCacheRect.topLeft() + shift, mCache);
+    painter->restore();
+}
+
+void LayerCompositionItem::release(const Entry &entry)
+{
+    setComposition(entry.layerItem, nullptr);
+    entry.layerItem->setOpacity(entry.opacity);
+}
+
+void LayerCompositionItem::updateBoundingRect()
+{
+    QRectF boundingRect;
+    for (const Entry &entry : std::as_const(mEntries)) {
+        const LayerItem *item = entry.layerItem;
+        boundingRect |= item->mapRectToParent(item->boundingRect() | item->childrenBoundingRect());
+    }
+
+    if (mBoundingRect != boundingRect) {
+        prepareGeometryChange();
+        mBoundingRect = boundingRect;
+    }
+}
+
+/**
+ * Renders the composited layers within \a rect, which is in device pixels,
+ * to the given \a painter. The painter's origin corresponds to the top-left
+ * of the \a rect.
+ */
+void LayerCompositionItem::render(QPainter *painter, const QRect &rect,
+                                  const QTransform &viewTransform,
+                                  QWidget *widget) const
+{
+    const QTransform transform = viewTransform * QTransform::fromTranslate(-rect.x(), -rect.y());
+    const QRectF sceneRect = viewTransform.inverted().mapRect(QRectF(rect));
+
+    for (const Entry &entry : mEntries)
+        paintItem(painter, entry.layerItem, transform, entry.opacity, sceneRect, widget);
+}
+
+} // namespace Tiled
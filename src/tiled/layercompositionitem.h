@@ -0,0 +1,86 @@
+/*
+ * layercompositionitem.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QGraphicsItem>
+#include <QPixmap>
+#include <QTransform>
+#include <QVector>
+
+namespace Tiled {
+
+class LayerItem;
+
+/**
+ * Draws a number of consecutive layers from a single cached pixmap.
+ *
+ * The layer items themselves are made fully transparent while they are part
+ * of the composition, so that the scene skips them. This avoids repainting
+ * all of them whenever a nearby part of another layer changes.
+ *
+ * The cache covers the view and some area around it. It is reused while the
+ * view is scrolled by whole pixels and needs to be invalidated whenever the
+ * appearance of any of the composited layers changes.
+ */
+class LayerCompositionItem : public QGraphicsItem
+{
+public:
+    explicit LayerCompositionItem(QGraphicsItem *parent = nullptr);
+    ~LayerCompositionItem() override;
+
+    void setLayerItems(const QVector<LayerItem*> &layerItems);
+    void removeLayerItem(LayerItem *layerItem);
+    bool contains(const LayerItem *layerItem) const;
+
+    void setLayerItemOpacity(LayerItem *layerItem, qreal opacity);
+
+    void invalidate();
+    void invalidate(const QRectF &rect);
+
+    // QGraphicsItem
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter,
+               const QStyleOptionGraphicsItem *option,
+               QWidget *widget = nullptr) override;
+
+private:
+    struct Entry
+    {
+        LayerItem *layerItem;
+        qreal opacity;      // the opacity the item would otherwise have
+    };
+
+    void release(const Entry &entry);
+    void updateBoundingRect();
+    void render(QPainter *painter, const QRect &rect, const QTransform &viewTransform,
+                QWidget *widget) const;
+
+    QVector<Entry> mEntries;
+    QRectF mBoundingRect;
+
+    QPixmap mCache;
+    QRect mCacheRect;               // covered area, in device pixels
+    QTransform mCacheTransform;     // item to device transform of the cache
+    QVector<QRectF> mDirtyRects;    // in item coordinates
+    bool mCacheValid = false;
+};
+
+} // namespace Tiled
@@ -21,6 +21,7 @@
 #include "layeritem.h"
 
 #include "layer.h"
+#include "layercompositionitem.h"
 
 namespace Tiled {
 
@@ -32,4 +33,19 @@ LayerItem::LayerItem(Layer *layer, QGraphicsItem *parent)
     setOpacity(layer->opacity());
 }
 
+/**
+ * Schedules a redraw of the given \a rect, or the whole item when the rect
+ * is null. When the item is drawn as part of a composition, the affected
+ * part of the composition is invalidated instead.
+ */
+void LayerItem::repaint(const QRectF &rect)
+{
+    if (!mComposition)
+        update(rect);
+    else if (rect.isNull())
+        mComposition->invalidate();
+    else
+        mComposition->invalidate(mapRectToItem(mComposition, rect));
+}
+
 } // namespace Tiled
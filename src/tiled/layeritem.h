@@ -25,6 +25,7 @@
 namespace Tiled {
 
 class Layer;
+class LayerCompositionItem;
 
 class LayerItem : public QGraphicsItem
 {
@@ -33,8 +34,14 @@ public:
 
     Layer *layer() const { return mLayer; }
 
+    LayerCompositionItem *composition() const { return mComposition; }
+    void setComposition(LayerCompositionItem *composition) { mComposition = composition; }
+
+    void repaint(const QRectF &rect = QRectF());
+
 private:
     Layer *mLayer;
+    LayerCompositionItem *mComposition = nullptr;
 };
 
 } // namespace Tiled
@@ -332,15 +332,9 @@ QModelIndex LayerModel::index(Layer *layer, int column) const
 
     Q_ASSERT(layer->map() == map());
 
-    if (auto parentLayer = layer->parentLayer()) {
-        int row = parentLayer->layers().indexOf(layer);
-        Q_ASSERT(row != -1);
-        return createIndex(row, column, parentLayer);
-    }
-
-    int row = map()->layers().indexOf(layer);
+    const int row = layer->siblingIndex();
     Q_ASSERT(row != -1);
-    return createIndex(row, column, nullptr);
+    return createIndex(row, column, layer->parentLayer());
 }
 
 Layer *LayerModel::toLayer(const QModelIndex &index) const
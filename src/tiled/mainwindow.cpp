@@ -39,10 +39,13 @@
 #include "donationpopup.h"
 #include "exportasimagedialog.h"
 #include "exporthelper.h"
+#include "exportmanifest.h"
+#include "imagecache.h"
 #include "issuescounter.h"
 #include "issuesdock.h"
 #include "layer.h"
 #include "locatorwidget.h"
+#include "logginginterface.h"
 #include "map.h"
 #include "mapdocument.h"
 #include "mapdocumentactionhandler.h"
@@ -61,6 +64,7 @@
 #include "propertytypeseditor.h"
 #include "resizedialog.h"
 #include "scriptmanager.h"
+#include "scriptprofiler.h"
 #include "sentryhelper.h"
 #include "templatesdock.h"
 #include "tileset.h"
@@ -70,6 +74,7 @@
 #include "tilesetmanager.h"
 #include "tilestampmanager.h"
 #include "tmxmapformat.h"
+#include "tracing.h"
 #include "utils.h"
 #include "world.h"
 #include "worlddocument.h"
@@ -80,8 +85,10 @@
 #include <QActionGroup>
 #include <QCloseEvent>
 #include <QDesktopServices>
+#include <QDir>
 #include <QFileDialog>
 #include <QLabel>
+#include <QLocale>
 #include <QMessageBox>
 #include <QMimeData>
 #include <QRegularExpression>
@@ -253,6 +260,7 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     ActionManager::registerAction(mUi->actionAddFolderToProject, "AddFolderToProject");
     ActionManager::registerAction(mUi->actionAutoMap, "AutoMap");
     ActionManager::registerAction(mUi->actionAutoMapWhileDrawing, "AutoMapWhileDrawing");
+    ActionManager::registerAction(mUi->actionAutoMapStatistics, "AutoMapStatistics");
     ActionManager::registerAction(mUi->actionClearRecentFiles, "ClearRecentFiles");
     ActionManager::registerAction(mUi->actionClearRecentProjects, "ClearRecentProjects");
     ActionManager::registerAction(mUi->actionClearView, "ClearView");
@@ -274,6 +282,12 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     ActionManager::registerAction(mUi->actionFullScreen, "FullScreen");
     ActionManager::registerAction(mUi->actionHighlightCurrentLayer, "HighlightCurrentLayer");
     ActionManager::registerAction(mUi->actionHighlightHoveredObject, "HighlightHoveredObject");
+    ActionManager::registerAction(mUi->actionImageCacheStatistics, "ImageCacheStatistics");
+    ActionManager::registerAction(mUi->actionMemoryUsage, "MemoryUsage");
+    ActionManager::registerAction(mUi->actionScriptProfile, "ScriptProfile");
+    ActionManager::registerAction(mUi->actionExportScriptProfile, "ExportScriptProfile");
+    ActionManager::registerAction(mUi->actionRecordPerformanceTrace, "RecordPerformanceTrace");
+    ActionManager::registerAction(mUi->actionExportPerformanceTrace, "ExportPerformanceTrace");
     ActionManager::registerAction(mUi->actionLabelForHoveredObject, "LabelForHoveredObject");
     ActionManager::registerAction(mUi->actionLabelsForAllObjects, "LabelsForAllObjects");
     ActionManager::registerAction(mUi->actionLabelsForSelectedObjects, "LabelsForSelectedObjects");
@@ -532,7 +546,7 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     connect(mUi->actionSearchActions, &QAction::triggered, this, &MainWindow::searchActions);
     connect(mUi->actionReopenClosedFile, &QAction::triggered, this, &MainWindow::reopenClosedFile);
     connect(mUi->actionClearRecentFiles, &QAction::triggered, preferences, &Preferences::clearRecentFiles);
-    connect(mUi->actionSave, &QAction::triggered, this, &MainWindow::saveFile);
+    connect(mUi->actionSave, &QAction::triggered, this, &MainWindow::saveFileInBackground);
     connect(mUi->actionSaveAs, &QAction::triggered, this, &MainWindow::saveFileAs);
     connect(mUi->actionSaveAll, &QAction::triggered, this, &MainWindow::saveAll);
     connect(mUi->actionExportAsImage, &QAction::triggered, this, &MainWindow::exportAsImage);
@@ -675,6 +689,8 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     connect(mUi->actionOffsetMap, &QAction::triggered, this, &MainWindow::offsetMap);
     connect(mUi->actionAutoMap, &QAction::triggered,
             mAutomappingManager, &AutomappingManager::autoMap);
+    connect(mUi->actionAutoMapStatistics, &QAction::triggered,
+            this, &MainWindow::showAutoMappingStatistics);
     connect(mUi->actionMapProperties, &QAction::triggered,
             this, &MainWindow::editMapProperties);
 
@@ -697,6 +713,13 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
 
     connect(mUi->actionDocumentation, &QAction::triggered, this, &MainWindow::openDocumentation);
     connect(mUi->actionForum, &QAction::triggered, this, &MainWindow::openForum);
+    connect(mUi->actionImageCacheStatistics, &QAction::triggered, this, &MainWindow::showImageCacheStatistics);
+    connect(mUi->actionMemoryUsage, &QAction::triggered, this, &MainWindow::showMemoryUsage);
+    connect(mUi->actionScriptProfile, &QAction::triggered, this, &MainWindow::showScriptProfile);
+    connect(mUi->actionExportScriptProfile, &QAction::triggered, this, &MainWindow::exportScriptProfile);
+    mUi->actionRecordPerformanceTrace->setChecked(Tracing::isEnabled());
+    connect(mUi->actionRecordPerformanceTrace, &QAction::toggled, this, [] (bool checked) { Tracing::setEnabled(checked); });
+    connect(mUi->actionExportPerformanceTrace, &QAction::triggered, this, &MainWindow::exportPerformanceTrace);
     connect(mUi->actionDonate, &QAction::triggered, this, [] {
         QDesktopServices::openUrl(QUrl(QLatin1String("https://www.mapeditor.org/donate")));
     });
@@ -838,7 +861,9 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     connect(mDocumentManager, &DocumentManager::fileOpenDialogRequested,
             this, &MainWindow::openFileDialog);
     connect(mDocumentManager, &DocumentManager::fileSaveRequested,
-            this, &MainWindow::saveFile);
+            this, &MainWindow::saveFileInBackground);
+    connect(&mPendingFileWatcher, &QFutureWatcherBase::finished,
+            this, &MainWindow::openPendingFiles);
     connect(mDocumentManager, &DocumentManager::currentDocumentChanged,
             this, &MainWindow::documentChanged);
     connect(mDocumentManager, &DocumentManager::documentCloseRequested,
@@ -969,14 +994,16 @@ void MainWindow::dragEnterEvent(QDragEnterEvent *e)
 
 void MainWindow::dropEvent(QDropEvent *e)
 {
+    QStringList fileNames;
+
     const auto urls = e->mimeData()->urls();
     for (const QUrl &url : urls) {
         const QString localFile = url.toLocalFile();
-        if (localFile.isEmpty())
-            continue;
-
-        openFile(localFile);
+        if (!localFile.isEmpty())
+            fileNames.append(localFile);
     }
+
+    openFiles(fileNames);
 }
 
 void MainWindow::resizeEvent(QResizeEvent *e)
@@ -1038,7 +1065,8 @@ void MainWindow::initializeSession()
         restoreSession();
 }
 
-bool MainWindow::openFile(const QString &fileName, FileFormat *fileFormat)
+bool MainWindow::openFile(const QString &fileName, FileFormat *fileFormat,
+                          const MapCache::Parsed *parsed)
 {
     if (fileName.isEmpty())
         return false;
@@ -1074,8 +1102,16 @@ bool MainWindow::openFile(const QString &fileName, FileFormat *fileFormat)
     if (mDocumentManager->switchToDocument(fileName))
         return true;
 
+    // Let the tileset images load in the background, so that the document
+    // can be shown right away
+    auto tilesetManager = TilesetManager::instance();
+    const bool asyncImageLoading = tilesetManager->asyncImageLoading();
+    tilesetManager->setAsyncImageLoading(true);
+
     QString error;
-    DocumentPtr document = mDocumentManager->loadDocument(fileName, fileFormat, &error);
+    DocumentPtr document = mDocumentManager->loadDocument(fileName, fileFormat, &error, parsed);
+
+    tilesetManager->setAsyncImageLoading(asyncImageLoading);
 
     if (!document) {
         // HACK: Templates can't open as documents, but we can instead show
@@ -1103,6 +1139,61 @@ bool MainWindow::openFile(const QString &fileName, FileFormat *fileFormat)
     return true;
 }
 
+/**
+ * Opens the given files. The maps among them are parsed in parallel on
+ * worker threads, after which the files are opened in the given order, each
+ * as soon as it is ready. The \a opened function is called once the last
+ * file has been opened.
+ */
+void MainWindow::openFiles(const QStringList &fileNames, FileFormat *fileFormat,
+                           std::function<void ()> opened)
+{
+    for (const QString &fileName : fileNames) {
+        mPendingFiles.append({ fileName,
+                               fileFormat,
+                               mDocumentManager->parseDocument(fileName, fileFormat),
+                               {} });
+    }
+
+    if (opened) {
+        if (mPendingFiles.isEmpty())
+            opened();
+        else
+            mPendingFiles.last().opened = std::move(opened);
+    }
+
+    openPendingFiles();
+}
+
+/**
+ * Opens the files queued by openFiles(), in order, as far as they have been
+ * parsed. Called again when the next file has been parsed.
+ */
+void MainWindow::openPendingFiles()
+{
+    // Opening a file may show a message box, which runs an event loop
+    if (mOpeningPendingFiles)
+        return;
+
+    mOpeningPendingFiles = true;
+
+    while (!mPendingFiles.isEmpty()) {
+        if (!mPendingFiles.first().parsed.isFinished()) {
+            mPendingFileWatcher.setFuture(mPendingFiles.first().parsed);
+            break;
+        }
+
+        const PendingFile file = mPendingFiles.takeFirst();
+        const MapCache::Parsed parsed = file.parsed.result();
+        openFile(file.fileName, file.fileFormat, &parsed);
+
+        if (file.opened)
+            file.opened();
+    }
+
+    mOpeningPendingFiles = false;
+}
+
 void MainWindow::openFileDialog()
 {
     SessionOption<QString> lastUsedOpenFilter { "file.lastUsedOpenFilter" };
@@ -1132,8 +1223,7 @@ void MainWindow::openFileDialog()
 
     lastUsedOpenFilter = selectedFilter;
 
-    for (const QString &fileName : fileNames)
-        openFile(fileName, fileFormat);
+    openFiles(fileNames, fileFormat);
 }
 
 void MainWindow::openFileInProject()
@@ -1189,6 +1279,24 @@ bool MainWindow::saveFile()
         return mDocumentManager->saveDocument(document, currentFileName);
 }
 
+/**
+ * Like saveFile(), but writes the document on a worker thread when its
+ * format allows it, so that the editor doesn't block on saving large maps.
+ */
+void MainWindow::saveFileInBackground()
+{
+    Document *document = mDocumentManager->currentDocument();
+    if (!document)
+        return;
+
+    document = saveAsDocument(document);
+
+    if (document->fileName().isEmpty() || !document->writerFormat())
+        mDocumentManager->saveDocumentAs(document);
+    else
+        mDocumentManager->saveDocumentInBackground(document);
+}
+
 bool MainWindow::saveFileAs()
 {
     Document *document = mDocumentManager->currentDocument();
@@ -1223,7 +1331,7 @@ void MainWindow::saveAll()
             mDocumentManager->switchToDocument(document.data());
             if (!mDocumentManager->saveDocumentAs(document.data()))
                 return;
-        } else if (!mDocumentManager->saveDocument(document.data(), fileName)) {
+        } else if (!mDocumentManager->saveDocumentInBackground(document.data())) {
             return;
         }
     }
@@ -1239,7 +1347,13 @@ void MainWindow::saveAll()
 
 bool MainWindow::confirmSave(Document *document)
 {
-    if (!document || !mDocumentManager->isDocumentModified(document))
+    if (!document)
+        return true;
+
+    // A failed background save marks the document as modified again
+    mDocumentManager->waitForBackgroundSave(document);
+
+    if (!mDocumentManager->isDocumentModified(document))
         return true;
 
     mDocumentManager->switchToDocument(document);
@@ -1304,6 +1418,20 @@ void MainWindow::export_()
     }
 }
 
+/**
+ * Returns the manifest in which the editor records map exports, used to skip
+ * exports of maps that did not change.
+ */
+static ExportManifest editorExportManifest()
+{
+    const QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    ExportManifest manifest(cacheLocation.isEmpty() ? QString()
+                                                    : QDir(cacheLocation).filePath(QStringLiteral("exportmanifest.json")));
+    if (!cacheLocation.isEmpty())
+        manifest.load();
+    return manifest;
+}
+
 /**
  * Exports the given document to the previously used export file name and the
  * previously used export format.
@@ -1320,11 +1448,29 @@ bool MainWindow::exportDocument(Document *document)
 
     if (auto mapDocument = qobject_cast<MapDocument*>(document)) {
         if (MapFormat *exportFormat = mapDocument->exportFormat()) {
+            // Skip the export when neither the map nor its inputs changed
+            ExportManifest manifest = editorExportManifest();
+            const QString settings = ExportManifest::settings(exportFormat, Preferences::instance()->exportOptions());
+            const bool recordExport = !mapDocument->isModified() && !mapDocument->fileName().isEmpty();
+
+            if (recordExport && manifest.isUpToDate(exportFileName, mapDocument->fileName(), settings)) {
+                manifest.save();
+                statusBar()->showMessage(tr("%1 is up to date").arg(exportFileName), 3000);
+                return true;
+            }
+
             std::unique_ptr<Map> exportMap;
             ExportHelper exportHelper;
             const Map *map = exportHelper.prepareExportMap(mapDocument->map(), exportMap);
 
             if (exportFormat->write(map, exportFileName, exportHelper.formatOptions())) {
+                if (recordExport)
+                    manifest.update(exportFileName, mapDocument->fileName(), settings,
+                                    ExportManifest::dependencies(mapDocument->map()));
+                else
+                    manifest.remove(exportFileName);
+                manifest.save();
+
                 statusBar()->showMessage(tr("Exported to %1").arg(exportFileName), 3000);
                 return true;
             }
@@ -1390,6 +1536,9 @@ void MainWindow::closeFile()
 bool MainWindow::closeAllFiles()
 {
     if (confirmAllSave()) {
+        // Files that are still being opened from the previous session
+        mPendingFiles.clear();
+
         mDocumentManager->closeAllDocuments();
         return true;
     }
@@ -1492,12 +1641,12 @@ void MainWindow::restoreSession()
     const auto &session = Session::current();
 
     // Copy values because the session will get changed while restoring it
-    const auto openFiles = session.openFiles;
-    const auto activeFile = session.activeFile;
+    const QStringList files = session.openFiles;
+    const QString activeFile = session.activeFile;
 
-    for (const QString &file : openFiles)
-        openFile(file);
-    mDocumentManager->switchToDocument(activeFile);
+    openFiles(files, nullptr, [this, activeFile] {
+        mDocumentManager->switchToDocument(activeFile);
+    });
 
     WorldManager::instance().loadWorlds(mLoadedWorlds);
 
@@ -2001,6 +2150,164 @@ void MainWindow::autoMappingWarning(bool automatic)
     }
 }
 
+/**
+ * Logs the statistics collected per rule since the last time they were shown
+ * to the Console and starts collecting new ones.
+ */
+void MainWindow::showAutoMappingStatistics()
+{
+    INFO(mAutomappingManager->ruleStatisticsReport());
+    mAutomappingManager->resetRuleStatistics();
+
+    mConsoleDock->show();
+    mConsoleDock->raise();
+}
+
+/**
+ * Logs the size and hit rate of the image cache to the Console.
+ */
+void MainWindow::showImageCacheStatistics()
+{
+    const ImageCache::Statistics statistics = ImageCache::statistics();
+    const qint64 lookups = statistics.hits + statistics.misses;
+    const int hitRate = lookups > 0 ? qRound(100.0 * statistics.hits / lookups) : 0;
+    const QLocale locale;
+
+    INFO(tr("Image cache: %1 entries using %2 of %3, %4 hits, %5 misses (%6% hit rate), %7 evictions")
+         .arg(statistics.entries)
+         .arg(locale.formattedDataSize(statistics.bytes),
+              locale.formattedDataSize(ImageCache::maximumSize()))
+         .arg(statistics.hits)
+         .arg(statistics.misses)
+         .arg(hitRate)
+         .arg(statistics.evictions));
+
+    mConsoleDock->show();
+    mConsoleDock->raise();
+}
+
+/**
+ * Logs an estimate of the memory used by each open document and by the
+ * largest image cache entries to the Console.
+ */
+void MainWindow::showMemoryUsage()
+{
+    const QLocale locale;
+    MemoryUsage total;
+
+    for (const auto &document : mDocumentManager->documents()) {
+        const MemoryUsage usage = document->memoryUsage();
+        total += usage;
+
+        INFO(tr("Memory: %1 uses %2 (tile layers %3, objects %4, properties %5, images %6, tiles %7), %8 undo commands")
+             .arg(document->displayName(),
+                  locale.formattedDataSize(usage.total()),
+                  locale.formattedDataSize(usage.tileLayers),
+                  locale.formattedDataSize(usage.objects),
+                  locale.formattedDataSize(usage.properties),
+                  locale.formattedDataSize(usage.images),
+                  locale.formattedDataSize(usage.tiles))
+             .arg(document->undoStack()->count()));
+    }
+
+    INFO(tr("Memory: open documents use %1 in total").arg(locale.formattedDataSize(total.total())));
+
+    const auto entries = ImageCache::entries();
+    qint64 cacheBytes = 0;
+    for (const ImageCache::Entry &entry : entries)
+        cacheBytes += entry.bytes;
+
+    INFO(tr("Memory: image cache uses %1 for %2 entries")
+         .arg(locale.formattedDataSize(cacheBytes))
+         .arg(entries.size()));
+
+    for (int i = 0; i < std::min<int>(entries.size(), 10); ++i) {
+        const ImageCache::Entry &entry = entries.at(i);
+        INFO(tr("Memory: %1 uses %2%3")
+             .arg(entry.fileName,
+                  locale.formattedDataSize(entry.bytes),
+                  entry.inUse ? QString() : tr(" (unused)")));
+    }
+
+    mConsoleDock->show();
+    mConsoleDock->raise();
+}
+
+/**
+ * Logs the extension callbacks that took the most time to the Console.
+ */
+void MainWindow::showScriptProfile()
+{
+    const auto statistics = ScriptProfiler::statistics();
+
+    if (statistics.isEmpty()) {
+        INFO(tr("Script profile: no extension callbacks have been called yet"));
+    } else {
+        constexpr int maximumEntries = 20;
+        constexpr double nsPerMs = 1000000.0;
+
+        INFO(tr("Script profile (top %1 of %2 callbacks by total time):")
+             .arg(qMin(maximumEntries, int(statistics.size())))
+             .arg(statistics.size()));
+
+        for (int i = 0; i < statistics.size() && i < maximumEntries; ++i) {
+            const auto &entry = statistics.at(i);
+            const QString extension = entry.extension.isEmpty() ? tr("Unknown")
+                                                                : entry.extension;
+
+            INFO(tr("  %1 - %2: %3 calls, %4 ms total, %5 ms average, %6 ms slowest")
+                 .arg(extension, entry.callback)
+                 .arg(entry.calls)
+                 .arg(entry.totalTime / nsPerMs, 0, 'f', 2)
+                 .arg(entry.totalTime / nsPerMs / entry.calls, 0, 'f', 3)
+                 .arg(entry.maximumTime / nsPerMs, 0, 'f', 3));
+        }
+    }
+
+    mConsoleDock->show();
+    mConsoleDock->raise();
+}
+
+/**
+ * Writes the recorded extension callbacks to a file that can be opened in
+ * a trace viewer like chrome://tracing or Perfetto.
+ */
+void MainWindow::exportScriptProfile()
+{
+    const QString filter = tr("Chrome Trace (*.json)");
+    const QString fileName = QFileDialog::getSaveFileName(window(),
+                                                          tr("Export Script Profile"),
+                                                          QStringLiteral("script-profile.json"),
+                                                          filter,
+                                                          nullptr);
+    if (fileName.isEmpty())
+        return;
+
+    QString error;
+    if (!ScriptProfiler::writeChromeTrace(fileName, &error))
+        QMessageBox::critical(window(), tr("Error Exporting Script Profile"), error);
+}
+
+/**
+ * Writes the recorded performance trace to a file that can be opened in
+ * a trace viewer like chrome://tracing or Perfetto.
+ */
+void MainWindow::exportPerformanceTrace()
+{
+    const QString filter = tr("Chrome Trace (*.json)");
+    const QString fileName = QFileDialog::getSaveFileName(window(),
+                                                          tr("Export Performance Trace"),
+                                                          QStringLiteral("tiled-trace.json"),
+                                                          filter,
+                                                          nullptr);
+    if (fileName.isEmpty())
+        return;
+
+    QString error;
+    if (!Tracing::writeChromeTrace(fileName, &error))
+        QMessageBox::critical(window(), tr("Error Exporting Performance Trace"), error);
+}
+
 void MainWindow::onPropertyTypesEditorClosed()
 {
     mShowPropertyTypesEditor->setChecked(false);
@@ -2197,6 +2504,7 @@ void MainWindow::updateActions()
     mUi->actionOffsetMap->setEnabled(mapDocument);
     mUi->actionMapProperties->setEnabled(mapDocument);
     mUi->actionAutoMap->setEnabled(mapDocument);
+    mUi->actionAutoMapStatistics->setEnabled(mapDocument);
 
     mUi->menuTileset->menuAction()->setVisible(tilesetDocument);
     mUi->actionTilesetProperties->setEnabled(tilesetDocument);
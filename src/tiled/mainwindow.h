@@ -24,16 +24,20 @@
 #pragma once
 
 #include "document.h"
+#include "mapcache.h"
 #include "preferences.h"
 #include "preferencesdialog.h"
 #include "project.h"
 #include "session.h"
 #include "tilededitor_global.h"
 
+#include <QFutureWatcher>
 #include <QMainWindow>
 #include <QPointer>
 #include <QSessionManager>
 
+#include <functional>
+
 class QComboBox;
 class QLabel;
 class QToolButton;
@@ -94,7 +98,10 @@ public:
      *
      * @return whether the file was successfully opened
      */
-    bool openFile(const QString &fileName, FileFormat *fileFormat = nullptr);
+    bool openFile(const QString &fileName, FileFormat *fileFormat = nullptr,
+                  const MapCache::Parsed *parsed = nullptr);
+    void openFiles(const QStringList &fileNames, FileFormat *fileFormat = nullptr,
+                   std::function<void ()> opened = {});
 
     bool addRecentProjectsActions(QMenu *menu) const;
 
@@ -119,6 +126,7 @@ private:
     void searchActions();
     void showLocatorWidget(LocatorSource *source);
     bool saveFile();
+    void saveFileInBackground();
     bool saveFileAs();
     void saveAll();
     void export_(); // 'export' is a reserved word
@@ -134,6 +142,7 @@ private:
     bool closeProject();
     bool switchProject(std::unique_ptr<Project> project);
     void restoreSession();
+    void openPendingFiles();
     void projectProperties();
 
     void cut();
@@ -191,6 +200,12 @@ private:
     void reloadError(const QString &error);
     void autoMappingError(bool automatic);
     void autoMappingWarning(bool automatic);
+    void showAutoMappingStatistics();
+    void showImageCacheStatistics();
+    void showMemoryUsage();
+    void showScriptProfile();
+    void exportScriptProfile();
+    void exportPerformanceTrace();
 
     void onPropertyTypesEditorClosed();
     void ensureHasBorderInFullScreen();
@@ -272,6 +287,18 @@ private:
 
     SessionOption<QStringList> mLoadedWorlds { "loadedWorlds" };
 
+    struct PendingFile
+    {
+        QString fileName;
+        FileFormat *fileFormat;
+        QFuture<MapCache::Parsed> parsed;
+        std::function<void ()> opened;
+    };
+
+    QList<PendingFile> mPendingFiles;
+    QFutureWatcher<MapCache::Parsed> mPendingFileWatcher;
+    bool mOpeningPendingFiles = false;
+
     static MainWindow *mInstance;
 };
 
@@ -42,6 +42,8 @@
 #include "issuesmodel.h"
 #include "layermodel.h"
 #include "logginginterface.h"
+#include "mapcache.h"
+#include "mapdocumentjournal.h"
 #include "mapobject.h"
 #include "mapobjectmodel.h"
 #include "maprenderer.h"
@@ -61,6 +63,7 @@
 #include "tilelayer.h"
 #include "tilesetdocument.h"
 #include "transformmapobjects.h"
+#include "tracing.h"
 #include "world.h"
 #include "worlddocument.h"
 #include "worldmanager.h"
@@ -70,6 +73,11 @@
 #include <QSet>
 #include <QString>
 #include <QUndoStack>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
 
 using namespace Tiled;
 
@@ -91,6 +99,312 @@ private:
     std::unique_ptr<Map> mMap;
 };
 
+/**
+ * Replaces the data of existing map objects with that of reloaded objects,
+ * while keeping their identity (and thereby any selection or references).
+ */
+class ReloadMapObjects : public QUndoCommand
+{
+public:
+    ReloadMapObjects(Document *document,
+                     const QList<MapObject*> &mapObjects,
+                     const QList<MapObject*> &reloadedObjects,
+                     QUndoCommand *parent)
+        : QUndoCommand(parent)
+        , mDocument(document)
+        , mMapObjects(mapObjects)
+        , mOtherObjects(reloadedObjects)
+    {}
+
+    ~ReloadMapObjects() override { qDeleteAll(mOtherObjects); }
+
+    void undo() override { swap(); }
+    void redo() override { swap(); }
+
+private:
+    void swap()
+    {
+        for (int i = 0; i < mMapObjects.size(); ++i) {
+            MapObject *mapObject = mMapObjects.at(i);
+            MapObject *other = mOtherObjects.at(i);
+            MapObject *current = mapObject->clone();
+
+            mapObject->copyPropertiesFrom(other);
+            mapObject->setClassName(other->className());
+            mapObject->setPosition(other->position());
+
+            delete other;
+            mOtherObjects[i] = current;
+        }
+
+        const MapObject::ChangedProperties changedProperties =
+                MapObject::AllProperties | MapObject::SizeProperty |
+                MapObject::RotationProperty | MapObject::CellProperty |
+                MapObject::ShapeProperty | MapObject::TemplateProperty |
+                MapObject::CustomProperties;
+
+        emit mDocument->changed(MapObjectsChangeEvent(mMapObjects, changedProperties));
+    }
+
+    Document *mDocument;
+    QList<MapObject*> mMapObjects;
+    QList<MapObject*> mOtherObjects;
+};
+
+static bool sameMapObject(const MapObject *a, const MapObject *b)
+{
+    const TextData &textA = a->textData();
+    const TextData &textB = b->textData();
+
+    return a->name() == b->name() &&
+            a->className() == b->className() &&
+            a->position() == b->position() &&
+            a->size() == b->size() &&
+            a->rotation() == b->rotation() &&
+            a->isVisible() == b->isVisible() &&
+            a->shape() == b->shape() &&
+            a->polygon() == b->polygon() &&
+            a->cell() == b->cell() &&
+            textA.text == textB.text &&
+            textA.font == textB.font &&
+            textA.color == textB.color &&
+            textA.alignment == textB.alignment &&
+            textA.wordWrap == textB.wordWrap &&
+            a->objectTemplate() == b->objectTemplate() &&
+            a->changedProperties() == b->changedProperties() &&
+            a->properties() == b->properties();
+}
+
+static bool sameLayerAttributes(const Layer *a, const Layer *b)
+{
+    if (a->layerType() != b->layerType() ||
+            a->id() != b->id() ||
+            a->name() != b->name() ||
+            a->className() != b->className() ||
+            a->opacity() != b->opacity() ||
+            a->tintColor() != b->tintColor() ||
+            a->isVisible() != b->isVisible() ||
+            a->isLocked() != b->isLocked() ||
+            a->position() != b->position() ||
+            a->offset() != b->offset() ||
+            a->parallaxFactor() != b->parallaxFactor() ||
+            a->blendMode() != b->blendMode() ||
+            a->properties() != b->properties())
+        return false;
+
+    switch (a->layerType()) {
+    case Layer::TileLayerType:
+        return static_cast<const TileLayer*>(a)->size() == static_cast<const TileLayer*>(b)->size();
+    case Layer::ObjectGroupType: {
+        auto objectGroupA = static_cast<const ObjectGroup*>(a);
+        auto objectGroupB = static_cast<const ObjectGroup*>(b);
+        return objectGroupA->color() == objectGroupB->color() &&
+                objectGroupA->drawOrder() == objectGroupB->drawOrder();
+    }
+    case Layer::ImageLayerType: {
+        auto imageLayerA = static_cast<const ImageLayer*>(a);
+        auto imageLayerB = static_cast<const ImageLayer*>(b);
+        return imageLayerA->imageSource() == imageLayerB->imageSource() &&
+                imageLayerA->transparentColor() == imageLayerB->transparentColor() &&
+                imageLayerA->repetition() == imageLayerB->repetition();
+    }
+    case Layer::GroupLayerType:
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Pairs up the layers of the current and the reloaded map. Returns false
+ * when the layer hierarchy or any of the layer attributes differ.
+ */
+static bool matchLayers(const QList<Layer*> &layers,
+                        const QList<Layer*> &reloadedLayers,
+                        QVector<std::pair<Layer*, Layer*>> &pairs)
+{
+    if (layers.size() != reloadedLayers.size())
+        return false;
+
+    for (int i = 0; i < layers.size(); ++i) {
+        Layer *layer = layers.at(i);
+        Layer *reloadedLayer = reloadedLayers.at(i);
+
+        if (!sameLayerAttributes(layer, reloadedLayer))
+            return false;
+
+        pairs.append({ layer, reloadedLayer });
+
+        if (layer->isGroupLayer()) {
+            if (!matchLayers(static_cast<GroupLayer*>(layer)->layers(),
+                             static_cast<GroupLayer*>(reloadedLayer)->layers(),
+                             pairs)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Collects the minimal set of changes that turns the objects of
+ * \a objectGroup into those of \a reloadedGroup, matching objects by their
+ * ID. Returns false when the objects can't be matched up, or when the
+ * remaining objects were reordered.
+ */
+static bool diffObjectGroup(ObjectGroup *objectGroup,
+                            const ObjectGroup *reloadedGroup,
+                            QList<MapObject*> &removedObjects,
+                            QVector<AddMapObjects::Entry> &addedObjects,
+                            QList<MapObject*> &changedObjects,
+                            QList<MapObject*> &reloadedObjects)
+{
+    QHash<int, MapObject*> objectsById;
+    for (MapObject *mapObject : objectGroup->objects()) {
+        if (mapObject->id() <= 0 || objectsById.contains(mapObject->id()))
+            return false;
+        objectsById.insert(mapObject->id(), mapObject);
+    }
+
+    QSet<int> reloadedIds;
+    for (const MapObject *reloadedObject : reloadedGroup->objects()) {
+        const int id = reloadedObject->id();
+        if (id <= 0 || reloadedIds.contains(id))
+            return false;
+        reloadedIds.insert(id);
+    }
+
+    QList<MapObject*> keptObjects;
+    QVector<AddMapObjects::Entry> newObjects;
+
+    for (const MapObject *reloadedObject : reloadedGroup->objects()) {
+        if (MapObject *mapObject = objectsById.value(reloadedObject->id())) {
+            keptObjects.append(mapObject);
+            if (!sameMapObject(mapObject, reloadedObject)) {
+                changedObjects.append(mapObject);
+                reloadedObjects.append(reloadedObject->clone());
+            }
+        } else {
+            // Insertion index relative to the kept objects
+            AddMapObjects::Entry entry { reloadedObject->clone(), objectGroup };
+            entry.index = keptObjects.size();
+            newObjects.append(entry);
+        }
+    }
+
+    // AddMapObjects inserts at decreasing indices, so objects sharing an
+    // index need to be passed in reverse to end up in the right order.
+    std::reverse_copy(newObjects.cbegin(), newObjects.cend(),
+                      std::back_inserter(addedObjects));
+
+    int keptIndex = 0;
+    for (MapObject *mapObject : objectGroup->objects()) {
+        if (!reloadedIds.contains(mapObject->id()))
+            removedObjects.append(mapObject);
+        else if (keptObjects.at(keptIndex++) != mapObject)
+            return false;   // objects were reordered
+    }
+
+    return true;
+}
+
+/**
+ * Compares the reloaded map to the current one and creates a command that
+ * applies only the differences. Returns nullptr when the maps differ in a
+ * way that requires replacing the whole map, or when tile layers have paged
+ * out chunks.
+ *
+ * An empty command is returned when nothing changed.
+ */
+static std::unique_ptr<QUndoCommand> createReloadChanges(MapDocument *mapDocument,
+                                                          const Map &reloadedMap)
+{
+    const Map *map = mapDocument->map();
+
+    if (map->orientation() != reloadedMap.orientation() ||
+            map->renderOrder() != reloadedMap.renderOrder() ||
+            map->width() != reloadedMap.width() ||
+            map->height() != reloadedMap.height() ||
+            map->tileWidth() != reloadedMap.tileWidth() ||
+            map->tileHeight() != reloadedMap.tileHeight() ||
+            map->infinite() != reloadedMap.infinite() ||
+            map->hexSideLength() != reloadedMap.hexSideLength() ||
+            map->staggerAxis() != reloadedMap.staggerAxis() ||
+            map->staggerIndex() != reloadedMap.staggerIndex() ||
+            map->parallaxOrigin() != reloadedMap.parallaxOrigin() ||
+            map->backgroundColor() != reloadedMap.backgroundColor() ||
+            map->compressionLevel() != reloadedMap.compressionLevel() ||
+            map->chunkSize() != reloadedMap.chunkSize() ||
+            map->layerDataFormat() != reloadedMap.layerDataFormat() ||
+            map->className() != reloadedMap.className() ||
+            map->properties() != reloadedMap.properties())
+        return nullptr;
+
+    // External tilesets are shared, so this only fails to match when
+    // tilesets were added, removed or reordered, or for embedded tilesets.
+    if (map->tilesets() != reloadedMap.tilesets())
+        return nullptr;
+
+    QVector<std::pair<Layer*, Layer*>> layerPairs;
+    if (!matchLayers(map->layers(), reloadedMap.layers(), layerPairs))
+        return nullptr;
+
+    auto command = std::make_unique<QUndoCommand>(QCoreApplication::translate("Undo Commands", "Reload Map"));
+    PaintTileLayer *paint = nullptr;
+
+    QList<MapObject*> removedObjects;
+    QVector<AddMapObjects::Entry> addedObjects;
+    QList<MapObject*> changedObjects;
+    QList<MapObject*> reloadedObjects;
+
+    auto cleanup = [&] {
+        for (const AddMapObjects::Entry &entry : std::as_const(addedObjects))
+            delete entry.mapObject;
+        qDeleteAll(reloadedObjects);
+    };
+
+    for (const auto &[layer, reloadedLayer] : std::as_const(layerPairs)) {
+        if (TileLayer *tileLayer = layer->asTileLayer()) {
+            auto reloadedTileLayer = static_cast<const TileLayer*>(reloadedLayer);
+
+            // Paged out chunks can't be compared, since their cells are not
+            // loaded. Copying cells from such chunks would also erase tiles.
+            if (tileLayer->hasPagedOutChunks() || reloadedTileLayer->hasPagedOutChunks()) {
+                cleanup();
+                return nullptr;
+            }
+
+            const QRegion diffRegion = tileLayer->computeDiffRegion(*reloadedTileLayer);
+            if (diffRegion.isEmpty())
+                continue;
+
+            if (!paint)
+                paint = new PaintTileLayer(mapDocument, command.get());
+
+            paint->paint(tileLayer, 0, 0, reloadedTileLayer,
+                         diffRegion.translated(tileLayer->position()));
+        } else if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
+            if (!diffObjectGroup(objectGroup,
+                                 static_cast<const ObjectGroup*>(reloadedLayer),
+                                 removedObjects, addedObjects,
+                                 changedObjects, reloadedObjects)) {
+                cleanup();
+                return nullptr;
+            }
+        }
+    }
+
+    if (!removedObjects.isEmpty())
+        new RemoveMapObjects(mapDocument, removedObjects, command.get());
+    if (!addedObjects.isEmpty())
+        new AddMapObjects(mapDocument, addedObjects, command.get());
+    if (!changedObjects.isEmpty())
+        new ReloadMapObjects(mapDocument, changedObjects, reloadedObjects, command.get());
+
+    return command;
+}
+
 
 MapDocument::MapDocument(std::unique_ptr<Map> map)
     : Document(MapDocumentType, map->fileName)
@@ -154,6 +468,15 @@ bool MapDocument::save(const QString &fileName, QString *error)
         return false;
     }
 
+    if (!mapFormat->hasCapabilities(FileFormat::WritePagedOutChunks)) {
+        // Writing without the chunks that failed to load would lose them
+        if (!mMap->pageInAllChunks()) {
+            if (error)
+                *error = tr("Some chunks of the map could not be loaded");
+            return false;
+        }
+    }
+
     if (!mapFormat->write(map(), fileName)) {
         if (error)
             *error = mapFormat->errorString();
@@ -170,15 +493,74 @@ bool MapDocument::save(const QString &fileName, QString *error)
     setFileName(fileName);
     mLastSaved = QFileInfo(fileName).lastModified();
 
-    // Mark TilesetDocuments for embedded tilesets as saved
+    setEmbeddedTilesetsClean();
+
+    emit saved();
+    return true;
+}
+
+/**
+ * Saves a snapshot of the map when its format can be written on a worker
+ * thread. Cloning the map is cheap, since the tile layer chunks are shared
+ * until either copy is changed. Embedded tilesets are cloned as well, since
+ * they are written out in full and may be edited during the save.
+ */
+std::function<bool (QString *error)> MapDocument::prepareBackgroundSave()
+{
+    MapFormat *mapFormat = writerFormat();
+    if (!mapFormat || fileName().isEmpty())
+        return {};
+    if (!mapFormat->hasCapabilities(FileFormat::WriteInBackground))
+        return {};
+
+    // Paging in all chunks can fail, which is handled by the regular save
+    if (mMap->hasPagedOutChunks())
+        return {};
+
+    TILED_TRACE_SCOPE("MapDocument::prepareBackgroundSave");
+
+    std::shared_ptr<const Map> snapshot = mMap->snapshot();
+
+    mSavingInBackground = true;
+    undoStack()->setClean();
+    setEmbeddedTilesetsClean();
+
+    return [mapFormat, snapshot, fileName = fileName()] (QString *error) {
+        TILED_TRACE_SCOPE("MapDocument::backgroundSave");
+
+        if (mapFormat->write(snapshot.get(), fileName))
+            return true;
+
+        if (error)
+            *error = mapFormat->errorString();
+        return false;
+    };
+}
+
+void MapDocument::finishBackgroundSave(bool success)
+{
+    mSavingInBackground = false;
+
+    if (!success) {
+        // The snapshot was not written, so the document is modified again
+        undoStack()->resetClean();
+        return;
+    }
+
+    mLastSaved = QFileInfo(fileName()).lastModified();
+    emit saved();
+}
+
+/**
+ * Marks the TilesetDocuments for embedded tilesets as saved.
+ */
+void MapDocument::setEmbeddedTilesetsClean()
+{
     for (const SharedTileset &tileset : mMap->tilesets()) {
         if (TilesetDocument *tilesetDocument = TilesetDocument::findDocumentForTileset(tileset))
             if (tilesetDocument->isEmbedded())
                 tilesetDocument->setClean();
     }
-
-    emit saved();
-    return true;
 }
 
 bool MapDocument::canReload() const
@@ -198,17 +580,29 @@ bool MapDocument::reload(QString *error)
         return false;
     }
 
-    auto map = format->read(fileName());
+    QString readError;
+    auto map = MapCache::readMap(format, fileName(), &readError);
 
     if (!map) {
         if (error)
-            *error = format->errorString();
+            *error = readError;
         return false;
     }
 
     map->fileName = fileName();
 
-    undoStack()->push(new ReloadMap(this, std::move(map)));
+    // Apply only the differences when possible, which preserves the
+    // selection and avoids rebuilding the whole view
+    if (auto changes = createReloadChanges(this, *map)) {
+        if (changes->childCount() > 0)
+            undoStack()->push(changes.release());
+
+        mMap->setNextLayerId(std::max(mMap->nextLayerId(), map->nextLayerId()));
+        mMap->setNextObjectId(std::max(mMap->nextObjectId(), map->nextObjectId()));
+    } else {
+        undoStack()->push(new ReloadMap(this, std::move(map)));
+    }
+
     undoStack()->setClean();
 
     mLastSaved = QFileInfo(fileName()).lastModified();
@@ -217,25 +611,34 @@ bool MapDocument::reload(QString *error)
     return true;
 }
 
+MemoryUsage MapDocument::memoryUsage() const
+{
+    return Tiled::memoryUsage(*mMap);
+}
+
 MapDocumentPtr MapDocument::load(const QString &fileName,
                                  MapFormat *format,
-                                 QString *error)
+                                 QString *error,
+                                 const MapCache::Parsed *parsed)
 {
-    auto map = format->read(fileName);
+    auto map = MapCache::readMap(format, fileName, error, parsed);
 
-    if (!map) {
-        if (error)
-            *error = format->errorString();
+    if (!map)
         return MapDocumentPtr();
-    }
 
     map->fileName = fileName;
 
+    // Replay any changes that were left unsaved due to a crash
+    const bool recovered = MapDocumentJournal::recover(*map, fileName);
+
     MapDocumentPtr document = MapDocumentPtr::create(std::move(map));
     document->setReaderFormat(format);
     if (format->hasCapabilities(MapFormat::Write))
         document->setWriterFormat(format);
 
+    if (recovered)
+        document->undoStack()->resetClean();
+
     return document;
 }
 
@@ -371,7 +774,7 @@ static bool intersects(const QRectF &a, const QRectF &b)
 static bool visibleIn(const QRectF &area, MapObject *object,
                       const MapRenderer &renderer)
 {
-    QRectF boundingRect = renderer.boundingRect(object);
+    QRectF boundingRect = renderer.cachedBoundingRect(object);
 
     if (object->rotation() != 0) {
         // Rotate around object position
@@ -404,12 +807,31 @@ void MapDocument::resizeMap(QSize size, QPoint offset, bool removeObjects)
     QList<MapObject *> objectsToRemove;
     QList<MapObject *> objectsToMove;
 
+    // Resize all tile layers at once, since this can take a while
+    struct ResizeJob
+    {
+        TileLayer *layer;
+        TileLayer *resizedLayer;
+    };
+
+    QVector<ResizeJob> resizeJobs;
+    for (Layer *layer : map()->tileLayers())
+        resizeJobs.append({ static_cast<TileLayer*>(layer), nullptr });
+
+    QtConcurrent::blockingMap(resizeJobs, [=] (ResizeJob &job) {
+        job.resizedLayer = job.layer->clone();
+        job.resizedLayer->resize(size, offset);
+    });
+
+    auto resizeJob = resizeJobs.cbegin();
+
     LayerIterator iterator(map());
     while (Layer *layer = iterator.next()) {
         switch (layer->layerType()) {
         case Layer::TileLayerType: {
-            auto tileLayer = static_cast<TileLayer*>(layer);
-            new ResizeTileLayer(this, tileLayer, size, offset, command);
+            Q_ASSERT(resizeJob->layer == layer);
+            new ResizeTileLayer(this, resizeJob->layer, resizeJob->resizedLayer, command);
+            ++resizeJob;
             break;
         }
         case Layer::ObjectGroupType: {
@@ -482,7 +904,7 @@ void MapDocument::autocropMap()
         return;
 
     auto tileLayer = static_cast<TileLayer*>(mCurrentLayer);
-    const QRect bounds = tileLayer->region().boundingRect();
+    const QRect bounds = tileLayer->usedBounds();
     if (bounds.isNull())
         return;
 
@@ -498,11 +920,19 @@ void MapDocument::offsetMap(const QList<Layer*> &layers,
     if (layers.empty())
         return;
 
+    // Offset all layers at once, since this can take a while
+    QVector<OffsetLayer*> commands(layers.size());
+    QVector<int> indexes(layers.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+
+    QtConcurrent::blockingMap(indexes, [&] (int index) {
+        commands[index] = new OffsetLayer(this, layers.at(index), offset,
+                                          bounds, wholeMap, wrapX, wrapY);
+    });
+
     undoStack()->beginMacro(tr("Offset Map"));
-    for (auto layer : layers) {
-        undoStack()->push(new OffsetLayer(this, layer, offset,
-                                          bounds, wholeMap, wrapX, wrapY));
-    }
+    for (OffsetLayer *command : std::as_const(commands))
+        undoStack()->push(command);
     undoStack()->endMacro();
 }
 
@@ -1548,6 +1978,9 @@ static void collectObjects(Layer *layer, QList<MapObject*> &objects)
 
 void MapDocument::onLayerAboutToBeRemoved(GroupLayer *groupLayer, int index)
 {
+    // Pending notifications may refer to the removed layers
+    flushBatchedChanges();
+
     Layer *layer = groupLayer ? groupLayer->layerAt(index) : mMap->layerAt(index);
 
     // Deselect any objects on this layer when necessary
@@ -1649,20 +2082,45 @@ void MapDocument::checkIssues()
               this);
     }
 
-    checkFilePathProperties(map());
+    QVector<FilePathReference> references;
+    checkFilePathProperties(map(), references);
 
     for (Layer *layer : map()->allLayers()) {
-        checkFilePathProperties(layer);
+        checkFilePathProperties(layer, references);
 
         if (layer->isObjectGroup()) {
             for (MapObject *mapObject : static_cast<ObjectGroup*>(layer)->objects())
-                checkFilePathProperties(mapObject);
+                checkFilePathProperties(mapObject, references);
         }
     }
+
+    checkFilePathReferences(std::move(references));
+}
+
+/**
+ * Emits regionChanged, unless changes are being batched, in which case the
+ * regions are combined per layer and emitted when the batch ends.
+ */
+void MapDocument::emitRegionChanged(const QRegion &region, TileLayer *tileLayer)
+{
+    if (isBatchingChanges())
+        mBatchedRegionChanges[tileLayer] |= region;
+    else
+        emit regionChanged(region, tileLayer);
+}
+
+void MapDocument::flushBatchedChanges()
+{
+    const auto regionChanges = std::exchange(mBatchedRegionChanges, {});
+    for (auto it = regionChanges.cbegin(), end = regionChanges.cend(); it != end; ++it)
+        emit regionChanged(it.value(), it.key());
 }
 
 void MapDocument::swapMap(std::unique_ptr<Map> &other)
 {
+    // Pending notifications refer to the layers of the current map
+    flushBatchedChanges();
+
     // Store previous state
     const int currentLayerId = currentLayer() ? currentLayer()->id() : -1;
 
@@ -25,6 +25,7 @@
 #include "document.h"
 #include "layer.h"
 #include "map.h"
+#include "mapcache.h"
 #include "mapformat.h"
 #include "tiled.h"
 #include "tilededitor_global.h"
@@ -91,17 +92,23 @@ public:
     MapDocumentPtr sharedFromThis() { return qSharedPointerCast<MapDocument>(Document::sharedFromThis()); }
 
     bool save(const QString &fileName, QString *error = nullptr) override;
+    std::function<bool (QString *error)> prepareBackgroundSave() override;
+    void finishBackgroundSave(bool success) override;
+    bool isSavingInBackground() const { return mSavingInBackground; }
 
     bool canReload() const override;
     bool reload(QString *error);
 
+    MemoryUsage memoryUsage() const override;
+
     /**
      * Loads a map and returns a MapDocument instance on success. Returns null
      * on error and sets the \a error message.
      */
     static MapDocumentPtr load(const QString &fileName,
                                MapFormat *format,
-                               QString *error = nullptr);
+                               QString *error = nullptr,
+                               const MapCache::Parsed *parsed = nullptr);
 
     MapFormat *readerFormat() const;
     void setReaderFormat(MapFormat *format);
@@ -267,6 +274,8 @@ public:
 
     void checkIssues() override;
 
+    void emitRegionChanged(const QRegion &region, TileLayer *tileLayer);
+
     void swapMap(std::unique_ptr<Map> &other);
 
     QSet<int> expandedGroupLayers;
@@ -369,12 +378,13 @@ signals:
     void objectsInserted(ObjectGroup *objectGroup, int first, int last);
     void objectsIndexChanged(ObjectGroup *objectGroup, int first, int last);
 
-    // emitted from the TilesetDocument
+    // emitted from the TilesetDocument, the tile changes at most once per
+    // event loop iteration
     void tilesetNameChanged(Tileset *tileset);
     void tilesetTilePositioningChanged(Tileset *tileset);
-    void tileImageSourceChanged(Tile *tile);
-    void tileProbabilityChanged(Tile *tile);
-    void tileObjectGroupChanged(Tile *tile);
+    void tileImageSourceChanged(const QList<Tile*> &tiles);
+    void tileProbabilityChanged(const QList<Tile*> &tiles);
+    void tileObjectGroupChanged(const QList<Tile*> &tiles);
 
 public slots:
     void updateTemplateInstances(const ObjectTemplate *objectTemplate);
@@ -383,8 +393,11 @@ public slots:
 
 protected:
     std::unique_ptr<EditableAsset> createEditable() override;
+    void flushBatchedChanges() override;
 
 private:
+    void setEmbeddedTilesetsClean();
+
     void onChanged(const ChangeEvent &change);
 
     void onMapObjectModelRowsInserted(const QModelIndex &parent, int first, int last);
@@ -416,8 +429,12 @@ private:
     std::unique_ptr<MapRenderer> mRenderer;
     Layer *mCurrentLayer = nullptr;
     MapObjectModel *mMapObjectModel;
+    bool mSavingInBackground = false;
     bool mAllowHidingObjects = true;
     bool mAllowTileObjects = true;
+
+    // Region changes collected while batching changes
+    QHash<TileLayer*, QRegion> mBatchedRegionChanges;
 };
 
 } // namespace Tiled
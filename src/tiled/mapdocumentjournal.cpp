@@ -0,0 +1,818 @@
+/*
+ * mapdocumentjournal.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mapdocumentjournal.h"
+
+#include "changeevents.h"
+#include "logginginterface.h"
+#include "map.h"
+#include "mapdocument.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "objecttemplate.h"
+#include "templatemanager.h"
+#include "tilelayer.h"
+#include "tilesetmanager.h"
+#include "tracing.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QThreadPool>
+#include <QUndoStack>
+
+#include <algorithm>
+#include <vector>
+
+namespace Tiled {
+
+Preference<bool> MapDocumentJournal::enabled { "Storage/JournalUnsavedChanges", true };
+
+static constexpr quint32 JournalMagic = 0x4c4e4a54; // "TJNL"
+static constexpr quint32 JournalVersion = 2;
+static constexpr int FlushInterval = 1000;          // ms
+static constexpr qint64 CompactThreshold = 4 * 1024 * 1024;
+
+enum RecordType : quint8 {
+    CellsRecord = 1,
+    ObjectRecord,
+    ObjectRemovedRecord,
+    TilesetsRecord,
+};
+
+/**
+ * All journal writes go through a single thread, which keeps them in order.
+ */
+static QThreadPool *journalThreadPool()
+{
+    struct JournalThreadPool : QThreadPool
+    {
+        JournalThreadPool() { setMaxThreadCount(1); }
+    };
+
+    static JournalThreadPool threadPool;
+    return &threadPool;
+}
+
+static QByteArray journalHeader(const QString &fileName)
+{
+    QByteArray header;
+    QDataStream out(&header, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << JournalMagic << JournalVersion
+        << QFileInfo(fileName).lastModified().toMSecsSinceEpoch();
+    return header;
+}
+
+/**
+ * Encodes the tilesets of the \a map, identifying external tilesets by their
+ * file name and embedded ones by their name. Cells refer to tilesets by their
+ * index in the most recent tilesets record.
+ */
+static QByteArray tilesetsRecord(const Map &map)
+{
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << quint8(TilesetsRecord) << qint32(map.tilesetCount());
+    for (const SharedTileset &tileset : map.tilesets())
+        out << tileset->fileName() << tileset->name();
+    return record;
+}
+
+/**
+ * Looks up the tilesets listed in a tilesets record. External tilesets that
+ * are not part of the \a map are loaded and appended to \a added.
+ *
+ * Returns false when any of the tilesets can't be found, in which case the
+ * journal no longer matches the map.
+ */
+static bool readTilesets(QDataStream &in, const Map &map,
+                         QVector<SharedTileset> &tilesets,
+                         QVector<SharedTileset> &added)
+{
+    qint32 count;
+    in >> count;
+    if (in.status() != QDataStream::Ok || count < 0)
+        return false;
+
+    tilesets.clear();
+
+    for (qint32 i = 0; i < count; ++i) {
+        QString fileName, name;
+        in >> fileName >> name;
+        if (in.status() != QDataStream::Ok)
+            return false;
+
+        auto matches = [&] (const SharedTileset &tileset) {
+            if (tilesets.contains(tileset))
+                return false;
+            if (!fileName.isEmpty())
+                return tileset->fileName() == fileName;
+            return tileset->fileName().isEmpty() && tileset->name() == name;
+        };
+
+        SharedTileset tileset;
+
+        for (const SharedTileset &candidate : map.tilesets() + added) {
+            if (matches(candidate)) {
+                tileset = candidate;
+                break;
+            }
+        }
+
+        // Embedded tilesets added since the last save can't be recovered
+        if (!tileset && !fileName.isEmpty()) {
+            tileset = TilesetManager::instance()->loadTileset(fileName);
+            if (tileset)
+                added.append(tileset);
+        }
+
+        if (!tileset)
+            return false;
+
+        tilesets.append(tileset);
+    }
+
+    return true;
+}
+
+/**
+ * Reads the records that follow the header. A crash while writing may leave
+ * a truncated record at the end, which is ignored.
+ */
+static QVector<QByteArray> readRecords(QDataStream &in)
+{
+    QVector<QByteArray> records;
+
+    while (!in.atEnd()) {
+        QByteArray record;
+        in >> record;
+        if (in.status() != QDataStream::Ok)
+            break;
+        records.append(record);
+    }
+
+    return records;
+}
+
+static void writeCell(QDataStream &out, const Cell &cell,
+                      const QHash<const Tileset*, int> &tilesetIndexes)
+{
+    const qint16 tilesetIndex = cell.isEmpty() ? -1 : tilesetIndexes.value(cell.tileset(), -1);
+    out << tilesetIndex;
+    if (tilesetIndex != -1)
+        out << qint32(cell.tileId()) << quint8(cell.flags());
+}
+
+static Cell readCell(QDataStream &in, const QVector<SharedTileset> &tilesets)
+{
+    qint16 tilesetIndex;
+    in >> tilesetIndex;
+    if (tilesetIndex == -1)
+        return Cell();
+
+    qint32 tileId;
+    quint8 flags;
+    in >> tileId >> flags;
+
+    if (tilesetIndex < 0 || tilesetIndex >= tilesets.size())
+        return Cell();
+
+    Cell cell(tilesets.at(tilesetIndex).data(), tileId);
+    cell.setFlippedHorizontally(flags & Cell::FlippedHorizontally);
+    cell.setFlippedVertically(flags & Cell::FlippedVertically);
+    cell.setFlippedAntiDiagonally(flags & Cell::FlippedAntiDiagonally);
+    cell.setRotatedHexagonal120(flags & Cell::RotatedHexagonal120);
+    return cell;
+}
+
+/**
+ * The state of a changed object, taken on the main thread. The \a object is
+ * a copy, or nullptr when the object was removed.
+ */
+struct JournaledObject
+{
+    int id;
+    std::unique_ptr<MapObject> object;
+    int objectGroupId = 0;
+    int index = 0;
+    QString templateFileName;
+};
+
+/**
+ * The changes to append to the journal. The tile layers are copies, which
+ * are cheap to make since their chunks are shared until the map changes
+ * them, so that the cells can be encoded on the journal thread.
+ */
+struct JournalChanges
+{
+    QByteArray tilesetsRecord;      // empty when the tilesets didn't change
+    QHash<const Tileset*, int> tilesetIndexes;
+    std::vector<std::pair<std::unique_ptr<TileLayer>, QRegion>> tileLayers;
+    std::vector<JournaledObject> objects;
+};
+
+static void writeObject(QDataStream &out, const JournaledObject &journaledObject,
+                        const QHash<const Tileset*, int> &tilesetIndexes,
+                        const ExportContext &context)
+{
+    const MapObject &object = *journaledObject.object;
+    const TextData &textData = object.textData();
+    const QJsonArray properties = propertiesToJson(object.properties(), context);
+
+    out << qint32(object.id())
+        << qint32(journaledObject.objectGroupId)
+        << qint32(journaledObject.index)
+        << object.name()
+        << object.className()
+        << object.position()
+        << object.size()
+        << object.rotation()
+        << object.isVisible()
+        << qint32(object.shape())
+        << object.polygon();
+
+    writeCell(out, object.cell(), tilesetIndexes);
+
+    out << textData.text
+        << textData.font.toString()
+        << textData.color
+        << qint32(textData.alignment)
+        << textData.wordWrap
+        << journaledObject.templateFileName
+        << qint32(object.changedProperties())
+        << QJsonDocument(properties).toJson(QJsonDocument::Compact);
+}
+
+/**
+ * Encodes the given \a changes as journal records. Called on the journal
+ * thread.
+ */
+static QByteArray encodeChanges(const JournalChanges &changes, const QString &fileName)
+{
+    TILED_TRACE_SCOPE("MapDocumentJournal::encodeChanges");
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+
+    if (!changes.tilesetsRecord.isEmpty())
+        out << changes.tilesetsRecord;
+
+    for (const auto &[tileLayer, region] : changes.tileLayers) {
+        for (const QRect &rect : region) {
+            QByteArray record;
+            QDataStream recordStream(&record, QIODevice::WriteOnly);
+            recordStream.setVersion(QDataStream::Qt_5_15);
+            recordStream << quint8(CellsRecord) << qint32(tileLayer->id()) << rect;
+
+            for (int y = rect.top(); y <= rect.bottom(); ++y)
+                for (int x = rect.left(); x <= rect.right(); ++x)
+                    writeCell(recordStream, tileLayer->cellAt(x, y), changes.tilesetIndexes);
+
+            out << record;
+        }
+    }
+
+    if (!changes.objects.empty()) {
+        const ExportContext context(QFileInfo(fileName).path());
+
+        for (const JournaledObject &journaledObject : changes.objects) {
+            QByteArray record;
+            QDataStream recordStream(&record, QIODevice::WriteOnly);
+            recordStream.setVersion(QDataStream::Qt_5_15);
+
+            if (journaledObject.object) {
+                recordStream << quint8(ObjectRecord);
+                writeObject(recordStream, journaledObject, changes.tilesetIndexes, context);
+            } else {
+                recordStream << quint8(ObjectRemovedRecord) << qint32(journaledObject.id);
+            }
+
+            out << record;
+        }
+    }
+
+    return data;
+}
+
+/**
+ * Reads an object record and applies it to the \a map, creating the object
+ * when it doesn't exist yet.
+ */
+static void readObject(QDataStream &in, Map &map,
+                       const QVector<SharedTileset> &tilesets,
+                       QHash<int, MapObject*> &objectsById,
+                       const ExportContext &context)
+{
+    qint32 id, objectGroupId, index, shape, alignment, changedProperties;
+    QString name, className, font, templateFileName;
+    QPointF position;
+    QSizeF size;
+    qreal rotation;
+    bool visible;
+    QPolygonF polygon;
+    TextData textData;
+    QByteArray properties;
+
+    in >> id >> objectGroupId >> index >> name >> className >> position
+       >> size >> rotation >> visible >> shape >> polygon;
+
+    const Cell cell = readCell(in, tilesets);
+
+    in >> textData.text >> font >> textData.color >> alignment
+       >> textData.wordWrap >> templateFileName >> changedProperties
+       >> properties;
+
+    if (in.status() != QDataStream::Ok)
+        return;
+
+    Layer *layer = map.findLayerById(objectGroupId);
+    ObjectGroup *objectGroup = layer ? layer->asObjectGroup() : nullptr;
+    if (!objectGroup)
+        return;
+
+    MapObject *object = objectsById.value(id);
+    if (object) {
+        object->objectGroup()->removeObject(object);
+    } else {
+        object = new MapObject;
+        object->setId(id);
+        objectsById.insert(id, object);
+    }
+
+    objectGroup->insertObject(qBound(0, int(index), objectGroup->objectCount()), object);
+
+    textData.font.fromString(font);
+    textData.alignment = Qt::Alignment(QFlag(alignment));
+
+    object->setName(name);
+    object->setClassName(className);
+    object->setPosition(position);
+    object->setSize(size);
+    object->setRotation(rotation);
+    object->setVisible(visible);
+    object->setShape(static_cast<MapObject::Shape>(shape));
+    object->setPolygon(polygon);
+    object->setCell(cell);
+    object->setTextData(textData);
+    object->setObjectTemplate(templateFileName.isEmpty()
+                              ? nullptr
+                              : TemplateManager::instance()->loadObjectTemplate(templateFileName));
+    object->setChangedProperties(MapObject::ChangedProperties(QFlag(changedProperties)));
+    object->setProperties(propertiesFromJson(QJsonDocument::fromJson(properties).array(), context));
+}
+
+MapDocumentJournal::MapDocumentJournal(MapDocument *mapDocument)
+    : QObject(mapDocument)
+    , mMapDocument(mapDocument)
+    , mFileName(mapDocument->fileName())
+{
+    mFlushTimer.setSingleShot(true);
+    mFlushTimer.setInterval(FlushInterval);
+    connect(&mFlushTimer, &QTimer::timeout, this, &MapDocumentJournal::flush);
+
+    connect(mapDocument, &Document::changed, this, &MapDocumentJournal::onChanged);
+    connect(mapDocument, &MapDocument::regionChanged, this, &MapDocumentJournal::onRegionChanged);
+    connect(mapDocument, &Document::propertyAdded, this, &MapDocumentJournal::onPropertiesChanged);
+    connect(mapDocument, &Document::propertyRemoved, this, &MapDocumentJournal::onPropertiesChanged);
+    connect(mapDocument, &Document::propertyChanged, this, &MapDocumentJournal::onPropertiesChanged);
+    connect(mapDocument, &Document::propertiesChanged, this, &MapDocumentJournal::onPropertiesChanged);
+    connect(mapDocument->undoStack(), &QUndoStack::cleanChanged, this, &MapDocumentJournal::onCleanChanged);
+    connect(mapDocument, &Document::saved, this, &MapDocumentJournal::onSaved);
+    connect(mapDocument, &Document::fileNameChanged, this, &MapDocumentJournal::onFileNameChanged);
+
+    // A journal left next to the file was either recovered when the map was
+    // loaded, in which case we continue it, or it is outdated.
+    if (!mFileName.isEmpty()) {
+        const QString journal = journalFileName(mFileName);
+        if (QFile::exists(journal)) {
+            if (mapDocument->isModified())
+                continueJournal();
+            else
+                QFile::remove(journal);
+        }
+    }
+}
+
+/**
+ * Discards the journal, since the document was closed and any unsaved changes
+ * were intentionally dropped.
+ *
+ * Only refers to the file name stored in the journal, since this may be
+ * called while the document is being destroyed.
+ */
+MapDocumentJournal::~MapDocumentJournal()
+{
+    reset();
+}
+
+/**
+ * Replays the journal of the map saved at \a fileName on top of the given
+ * \a map, if such a journal exists.
+ *
+ * Returns whether any changes were recovered.
+ */
+bool MapDocumentJournal::recover(Map &map, const QString &fileName)
+{
+    if (!enabled)
+        return false;
+
+    QFile file(journalFileName(fileName));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    TILED_TRACE_SCOPE("MapDocumentJournal::recover");
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic, version;
+    qint64 lastModified;
+    in >> magic >> version >> lastModified;
+
+    if (in.status() != QDataStream::Ok || magic != JournalMagic || version != JournalVersion)
+        return false;
+
+    // The journal only applies to the file it was recorded for
+    if (lastModified != QFileInfo(fileName).lastModified().toMSecsSinceEpoch()) {
+        WARNING(tr("Ignoring outdated journal for '%1'").arg(fileName));
+        return false;
+    }
+
+    const QVector<QByteArray> records = readRecords(in);
+    if (records.isEmpty())
+        return false;
+
+    // Resolve the tilesets before touching the map, so that a journal that
+    // no longer matches is refused as a whole
+    QVector<QVector<SharedTileset>> tilesetTables;
+    QVector<SharedTileset> addedTilesets;
+
+    for (const QByteArray &record : records) {
+        if (record.isEmpty() || quint8(record.at(0)) != TilesetsRecord)
+            continue;
+
+        QDataStream recordStream(record);
+        recordStream.setVersion(QDataStream::Qt_5_15);
+        recordStream.skipRawData(1);
+
+        QVector<SharedTileset> tilesets;
+        if (!readTilesets(recordStream, map, tilesets, addedTilesets)) {
+            WARNING(tr("Ignoring journal for '%1', since its tilesets no longer match the map").arg(fileName));
+            return false;
+        }
+        tilesetTables.append(tilesets);
+    }
+
+    for (const SharedTileset &tileset : std::as_const(addedTilesets))
+        map.addTileset(tileset);
+
+    const ExportContext context(QFileInfo(fileName).path());
+
+    QHash<int, MapObject*> objectsById;
+    for (Layer *layer : map.objectGroups())
+        for (MapObject *object : static_cast<ObjectGroup*>(layer)->objects())
+            objectsById.insert(object->id(), object);
+
+    const QVector<SharedTileset> noTilesets;
+    int tilesetTable = -1;
+
+    for (const QByteArray &record : records) {
+        QDataStream recordStream(record);
+        recordStream.setVersion(QDataStream::Qt_5_15);
+
+        const auto &tilesets = tilesetTable == -1 ? noTilesets
+                                                  : tilesetTables.at(tilesetTable);
+
+        quint8 type;
+        recordStream >> type;
+
+        switch (type) {
+        case TilesetsRecord:
+            ++tilesetTable;
+            break;
+        case CellsRecord: {
+            qint32 layerId;
+            QRect rect;
+            recordStream >> layerId >> rect;
+
+            Layer *layer = map.findLayerById(layerId);
+            TileLayer *tileLayer = layer ? layer->asTileLayer() : nullptr;
+            if (!tileLayer)
+                break;
+
+            for (int y = rect.top(); y <= rect.bottom(); ++y)
+                for (int x = rect.left(); x <= rect.right(); ++x)
+                    tileLayer->setCell(x, y, readCell(recordStream, tilesets));
+            break;
+        }
+        case ObjectRecord:
+            readObject(recordStream, map, tilesets, objectsById, context);
+            break;
+        case ObjectRemovedRecord: {
+            qint32 id;
+            recordStream >> id;
+            if (MapObject *object = objectsById.take(id)) {
+                object->objectGroup()->removeObject(object);
+                delete object;
+            }
+            break;
+        }
+        }
+    }
+
+    int highestObjectId = 0;
+    for (auto it = objectsById.cbegin(); it != objectsById.cend(); ++it)
+        highestObjectId = std::max(highestObjectId, it.key());
+    if (highestObjectId >= map.nextObjectId())
+        map.setNextObjectId(highestObjectId + 1);
+
+    INFO(tr("Recovered unsaved changes to '%1'").arg(fileName));
+    return true;
+}
+
+/**
+ * Picks up the journal that was recovered when the map was loaded, taking
+ * note of what it covers so that compacting it doesn't lose anything.
+ */
+void MapDocumentJournal::continueJournal()
+{
+    QFile file(journalFileName(mFileName));
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic, version;
+    qint64 lastModified;
+    in >> magic >> version >> lastModified;
+
+    for (const QByteArray &record : readRecords(in)) {
+        QDataStream recordStream(record);
+        recordStream.setVersion(QDataStream::Qt_5_15);
+
+        quint8 type;
+        qint32 id;
+        recordStream >> type >> id;
+
+        switch (type) {
+        case CellsRecord: {
+            QRect rect;
+            recordStream >> rect;
+            mJournaledRegions[id] |= rect;
+            break;
+        }
+        case ObjectRecord:
+        case ObjectRemovedRecord:
+            mJournaledObjects.insert(id);
+            break;
+        }
+    }
+
+    mCreated = true;
+    mSizes->journal = file.size();
+}
+
+QString MapDocumentJournal::journalFileName(const QString &fileName)
+{
+    const QFileInfo fileInfo(fileName);
+    return fileInfo.dir().filePath(QLatin1Char('.') + fileInfo.fileName() + QLatin1String(".journal"));
+}
+
+void MapDocumentJournal::onChanged(const ChangeEvent &change)
+{
+    switch (change.type) {
+    case ChangeEvent::MapObjectAdded:
+    case ChangeEvent::MapObjectAboutToBeRemoved: {
+        auto &event = static_cast<const MapObjectEvent&>(change);
+        objectChanged(event.objectGroup->objectAt(event.index)->id());
+        break;
+    }
+    case ChangeEvent::MapObjectsChanged:
+        for (MapObject *object : static_cast<const MapObjectsChangeEvent&>(change).mapObjects)
+            objectChanged(object->id());
+        break;
+    case ChangeEvent::ObjectsChanged:
+        for (Object *object : static_cast<const ObjectsChangeEvent&>(change).objects)
+            onPropertiesChanged(object);
+        break;
+    default:
+        break;
+    }
+}
+
+void MapDocumentJournal::onRegionChanged(const QRegion &region, TileLayer *tileLayer)
+{
+    if (tileLayer->map() != mMapDocument->map())
+        return;
+
+    mChangedRegions[tileLayer->id()] |= region.translated(-tileLayer->position());
+    scheduleFlush();
+}
+
+void MapDocumentJournal::onPropertiesChanged(Object *object)
+{
+    if (object->typeId() == Object::MapObjectType)
+        objectChanged(static_cast<MapObject*>(object)->id());
+}
+
+void MapDocumentJournal::onCleanChanged(bool clean)
+{
+    // The document matches the file, so there is nothing to recover. While
+    // saving in the background, the write may still fail, so the journal is
+    // kept until onSaved() confirms it.
+    if (clean && !mMapDocument->isSavingInBackground())
+        reset();
+}
+
+/**
+ * Removes the journal once the document was saved. When the document was
+ * saved in the background, it may already have been changed again. The
+ * journal is kept in that case, but it now applies to the newly written file.
+ */
+void MapDocumentJournal::onSaved()
+{
+    if (mMapDocument->undoStack()->isClean()) {
+        reset();
+        return;
+    }
+
+    if (!mCreated)
+        return;
+
+    journalThreadPool()->start([fileName = mFileName] {
+        QFile file(journalFileName(fileName));
+        if (file.open(QIODevice::ReadWrite))
+            file.write(journalHeader(fileName));
+    });
+}
+
+void MapDocumentJournal::onFileNameChanged(const QString &fileName, const QString &oldFileName)
+{
+    Q_UNUSED(oldFileName)
+
+    reset();
+    mFileName = fileName;
+}
+
+void MapDocumentJournal::objectChanged(int id)
+{
+    mChangedObjects.insert(id);
+    scheduleFlush();
+}
+
+void MapDocumentJournal::scheduleFlush()
+{
+    if (!mFlushTimer.isActive())
+        mFlushTimer.start();
+}
+
+/**
+ * Takes a copy of the current state of the changed tile regions and objects,
+ * which is encoded and appended to the journal on the journal thread.
+ *
+ * Since the same tiles and objects tend to be changed over and over, the
+ * journal is compacted once it has grown well beyond the size it would have
+ * when rewritten from the current state of everything it covers.
+ */
+void MapDocumentJournal::flush()
+{
+    const QString fileName = mFileName;
+    if (fileName.isEmpty() || !enabled) {
+        mChangedRegions.clear();
+        mChangedObjects.clear();
+        return;
+    }
+
+    TILED_TRACE_SCOPE("MapDocumentJournal::flush");
+
+    const Map *map = mMapDocument->map();
+
+    for (auto it = mChangedRegions.cbegin(); it != mChangedRegions.cend(); ++it)
+        mJournaledRegions[it.key()] |= it.value();
+    mJournaledObjects.unite(mChangedObjects);
+
+    const qint64 journalSize = mSizes->journal.load();
+    const bool rewrite = !mCreated || (journalSize > CompactThreshold &&
+                                       journalSize > 2 * mSizes->compacted.load());
+
+    const auto &regions = rewrite ? mJournaledRegions : mChangedRegions;
+    const auto &objects = rewrite ? mJournaledObjects : mChangedObjects;
+
+    auto changes = std::make_shared<JournalChanges>();
+
+    QVector<const Tileset*> tilesets;
+    for (int i = 0; i < map->tilesetCount(); ++i) {
+        tilesets.append(map->tilesetAt(i).data());
+        changes->tilesetIndexes.insert(tilesets.last(), i);
+    }
+
+    if (rewrite || tilesets != mJournaledTilesets) {
+        changes->tilesetsRecord = tilesetsRecord(*map);
+        mJournaledTilesets = tilesets;
+    }
+
+    for (auto it = regions.cbegin(); it != regions.cend(); ++it) {
+        Layer *layer = map->findLayerById(it.key());
+        if (const TileLayer *tileLayer = layer ? layer->asTileLayer() : nullptr)
+            changes->tileLayers.emplace_back(tileLayer->clone(), it.value());
+    }
+
+    if (!objects.isEmpty()) {
+        QHash<int, const MapObject*> objectsById;
+        for (Layer *layer : map->objectGroups())
+            for (const MapObject *object : static_cast<ObjectGroup*>(layer)->objects())
+                objectsById.insert(object->id(), object);
+
+        for (int id : objects) {
+            JournaledObject journaledObject { id, nullptr };
+
+            if (const MapObject *object = objectsById.value(id)) {
+                journaledObject.object.reset(object->clone());
+                journaledObject.objectGroupId = object->objectGroup()->id();
+                journaledObject.index = object->index();
+                if (const ObjectTemplate *objectTemplate = object->objectTemplate())
+                    journaledObject.templateFileName = objectTemplate->fileName();
+            }
+
+            changes->objects.push_back(std::move(journaledObject));
+        }
+    }
+
+    mChangedRegions.clear();
+    mChangedObjects.clear();
+    mCreated = true;
+
+    journalThreadPool()->start([fileName, changes, rewrite, sizes = mSizes] {
+        const QByteArray data = encodeChanges(*changes, fileName);
+
+        if (rewrite) {
+            sizes->journal = data.size();
+            sizes->compacted = data.size();
+        } else {
+            sizes->journal += data.size();
+        }
+
+        QFile file(journalFileName(fileName));
+        if (!file.open(rewrite ? QIODevice::WriteOnly | QIODevice::Truncate
+                               : QIODevice::WriteOnly | QIODevice::Append))
+            return;
+
+        if (rewrite)
+            file.write(journalHeader(fileName));
+        file.write(data);
+    });
+}
+
+/**
+ * Drops any pending changes and removes the journal.
+ */
+void MapDocumentJournal::reset()
+{
+    mFlushTimer.stop();
+    mChangedRegions.clear();
+    mChangedObjects.clear();
+    mJournaledRegions.clear();
+    mJournaledObjects.clear();
+    mJournaledTilesets.clear();
+
+    // Any writes still in progress update the previous sizes
+    mSizes = std::make_shared<JournalSizes>();
+
+    if (!mCreated)
+        return;
+
+    mCreated = false;
+
+    journalThreadPool()->start([fileName = mFileName] {
+        QFile::remove(journalFileName(fileName));
+    });
+}
+
+} // namespace Tiled
+
+#include "moc_mapdocumentjournal.cpp"
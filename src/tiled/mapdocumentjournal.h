@@ -0,0 +1,107 @@
+/*
+ * mapdocumentjournal.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "preferences.h"
+
+#include <QHash>
+#include <QObject>
+#include <QRegion>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+namespace Tiled {
+
+class ChangeEvent;
+class Map;
+class MapDocument;
+class Object;
+class TileLayer;
+class Tileset;
+
+/**
+ * Keeps an append-only journal of the unsaved changes to a map document,
+ * stored next to the map file.
+ *
+ * The journal records the current state of any edited tile regions and map
+ * objects. The main thread only takes cheap copies of the changed layers and
+ * objects, which are encoded and appended to the journal on a worker thread,
+ * so that writing never blocks editing. Tiles refer to tilesets by file name
+ * (or by name for embedded tilesets), and the journal is refused when these
+ * can no longer be found while recovering.
+ *
+ * The journal is discarded when the document is closed and truncated
+ * whenever the document matches the file again. When it is still around
+ * while opening the map, the editor must have crashed and the journal is
+ * replayed on top of the saved map.
+ */
+class MapDocumentJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MapDocumentJournal(MapDocument *mapDocument);
+    ~MapDocumentJournal() override;
+
+    static bool recover(Map &map, const QString &fileName);
+
+    static QString journalFileName(const QString &fileName);
+
+    static Preference<bool> enabled;
+
+private:
+    void onChanged(const ChangeEvent &change);
+    void onRegionChanged(const QRegion &region, TileLayer *tileLayer);
+    void onPropertiesChanged(Object *object);
+    void onCleanChanged(bool clean);
+    void onSaved();
+    void onFileNameChanged(const QString &fileName, const QString &oldFileName);
+
+    void continueJournal();
+    void objectChanged(int id);
+    void scheduleFlush();
+    void flush();
+    void reset();
+
+    MapDocument *mMapDocument;
+    QString mFileName;
+    QTimer mFlushTimer;
+    QHash<int, QRegion> mChangedRegions;    // by layer ID, in layer coordinates
+    QSet<int> mChangedObjects;
+    QHash<int, QRegion> mJournaledRegions;  // everything journaled since the last save
+    QSet<int> mJournaledObjects;
+    QVector<const Tileset*> mJournaledTilesets;
+
+    // Updated on the journal thread as the changes are written
+    struct JournalSizes
+    {
+        std::atomic<qint64> journal { 0 };
+        std::atomic<qint64> compacted { 0 };
+    };
+    std::shared_ptr<JournalSizes> mSizes = std::make_shared<JournalSizes>();
+    bool mCreated = false;
+};
+
+} // namespace Tiled
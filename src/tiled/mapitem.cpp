@@ -23,10 +23,12 @@
 #include "abstractworldtool.h"
 #include "changeevents.h"
 #include "changeworld.h"
+#include "containerhelpers.h"
 #include "documentmanager.h"
 #include "grouplayer.h"
 #include "grouplayeritem.h"
 #include "imagelayeritem.h"
+#include "layercompositionitem.h"
 #include "mapeditor.h"
 #include "mapobject.h"
 #include "mapobjectitem.h"
@@ -34,11 +36,15 @@
 #include "mapscene.h"
 #include "mapview.h"
 #include "objectgroupitem.h"
+#include "objectpicker.h"
 #include "objectselectionitem.h"
 #include "preferences.h"
+#include "tile.h"
 #include "tilelayer.h"
 #include "tilelayeritem.h"
 #include "tileselectionitem.h"
+#include "tilesetmanager.h"
+#include "tintedimagecache.h"
 #include "world.h"
 #include "worldmanager.h"
 #include "zoomable.h"
@@ -49,6 +55,7 @@
 #include <QStyleOptionGraphicsItem>
 #include <QWidget>
 
+#include <algorithm>
 #include <memory>
 
 namespace Tiled {
@@ -56,6 +63,33 @@ namespace Tiled {
 static const qreal darkeningFactor = 0.6;
 static const qreal opacityFactor = 0.4;
 
+/**
+ * Object groups with at least this many objects only get map object items
+ * for the objects near the view and the selected objects. The object group
+ * item paints all other objects.
+ */
+static const int virtualizedObjectGroupThreshold = 10000;
+
+/**
+ * When more objects than this are near the view (usually when zoomed out),
+ * only the selected objects of a virtualized object group get an item.
+ */
+static const int maxNearbyObjectItems = 5000;
+
+/**
+ * Object groups with at least this many objects, all of which are tile
+ * objects, only get map object items for the selected objects. This allows
+ * the object group item to draw the tile objects in batches.
+ */
+static const int batchedTileObjectsThreshold = 100;
+
+static bool containsOnlyTileObjects(const ObjectGroup *objectGroup)
+{
+    const auto &objects = objectGroup->objects();
+    return std::all_of(objects.begin(), objects.end(),
+                       [] (const MapObject *object) { return object->isTileObject(); });
+}
+
 class TileGridItem : public QGraphicsObject
 {
     Q_OBJECT
@@ -133,7 +167,10 @@ MapItem::MapItem(const MapDocumentPtr &mapDocument, DisplayMode displayMode,
     : QGraphicsObject(parent)
     , mMapDocument(mapDocument)
     , mDarkRectangle(new QGraphicsRectItem(this))
+    , mLayersBelow(new LayerCompositionItem(this))
+    , mLayersAbove(new LayerCompositionItem(this))
     , mBorderRectangle(new QGraphicsRectItem(this))
+    , mObjectPicker(std::make_unique<ObjectPicker>(mapDocument.data(), this))
     , mDisplayMode(Editable)
 {
     // Since we don't do any painting, we can spare us the call to paint()
@@ -166,8 +203,10 @@ MapItem::MapItem(const MapDocumentPtr &mapDocument, DisplayMode displayMode,
     connect(mapDocument.data(), &MapDocument::tileImageSourceChanged, this, &MapItem::adaptToTileSizeChanges);
     connect(mapDocument.data(), &MapDocument::tileObjectGroupChanged, this, &MapItem::tileObjectGroupChanged);
     connect(mapDocument.data(), &MapDocument::tilesetReplaced, this, &MapItem::tilesetReplaced);
+    connect(TilesetManager::instance(), &TilesetManager::tilesetImagesChanged, this, &MapItem::tilesetImagesChanged);
     connect(mapDocument.data(), &MapDocument::objectsInserted, this, &MapItem::objectsInserted);
     connect(mapDocument.data(), &MapDocument::objectsIndexChanged, this, &MapItem::objectsIndexChanged);
+    connect(mapDocument.data(), &MapDocument::selectedObjectsChanged, this, [this] { updateObjectItems(true); });
 
     updateBoundingRect();
 
@@ -206,6 +245,9 @@ MapItem::MapItem(const MapDocumentPtr &mapDocument, DisplayMode displayMode,
 
 MapItem::~MapItem()
 {
+    // Deleted before the layer items, to restore their opacity
+    delete mLayersBelow;
+    delete mLayersAbove;
 }
 
 void MapItem::setDisplayMode(DisplayMode displayMode)
@@ -245,6 +287,7 @@ void MapItem::setDisplayMode(DisplayMode displayMode)
     }
 
     updateSelectedLayersHighlight();
+    updateObjectItems(true);    // selected objects only have items when editable
 }
 
 void MapItem::setShowTileCollisionShapes(bool enabled)
@@ -256,9 +299,11 @@ void MapItem::setShowTileCollisionShapes(bool enabled)
             if (tile->objectGroup() && !tile->objectGroup()->isEmpty())
                 item->syncWithMapObject();
 
+    updateVirtualizedObjectGroups();
+
     for (LayerItem *item : std::as_const(mLayerItems))
         if (item->layer()->isTileLayer())
-            item->update();
+            item->repaint();
 }
 
 void MapItem::updateLayerPositions()
@@ -275,6 +320,31 @@ void MapItem::updateLayerPositions()
         mTileGridItem->updateOffset();
         mObjectSelectionItem->updateItemPositions();
     }
+
+    updateObjectItems();
+}
+
+/**
+ * Makes sure the virtualized object groups have map object items for the
+ * objects near the view and for the selected objects.
+ */
+void MapItem::updateObjectItems(bool force)
+{
+    for (LayerItem *layerItem : std::as_const(mLayerItems))
+        if (auto ogItem = dynamic_cast<ObjectGroupItem*>(layerItem))
+            if (ogItem->isVirtualized())
+                updateObjectItems(ogItem, force);
+}
+
+/**
+ * Updates the items which depend on the visible area of the scene.
+ */
+void MapItem::viewRectChanged()
+{
+    updateObjectItems();
+
+    if (mDisplayMode == Editable)
+        mObjectSelectionItem->updateReferenceVisibility();
 }
 
 QRectF MapItem::boundingRect() const
@@ -350,9 +420,11 @@ void MapItem::repaintRegion(const QRegion &region, TileLayer *tileLayer)
     const QMargins margins = mapDocument()->map()->drawMargins();
     TileLayerItem *tileLayerItem = static_cast<TileLayerItem*>(mLayerItems.value(tileLayer));
 
+    tileLayerItem->invalidateCache(region);
+
     for (const QRect &r : region) {
         QRectF boundingRect = renderer->boundingRect(r).marginsAdded(margins);
-        tileLayerItem->update(boundingRect);
+        tileLayerItem->repaint(boundingRect);
     }
 }
 
@@ -379,13 +451,18 @@ void MapItem::documentChanged(const ChangeEvent &change)
         if (!objectsChange.objects.isEmpty() && (objectsChange.properties & ObjectsChangeEvent::ClassProperty)) {
             const auto typeId = objectsChange.objects.first()->typeId();
             if (typeId == Object::MapObjectType) {
+                QList<MapObject*> mapObjects;
                 for (Object *object : objectsChange.objects)
-                    mObjectItems.value(static_cast<MapObject*>(object))->syncWithMapObject();
+                    mapObjects.append(static_cast<MapObject*>(object));
+                syncObjectItems(mapObjects);
             } else if (typeId == Object::TileType) {
-                if (mapDocument()->renderer()->testFlag(ShowTileObjectOutlines))
+                if (mapDocument()->renderer()->testFlag(ShowTileObjectOutlines)) {
                     for (MapObjectItem *item : std::as_const(mObjectItems))
                         if (item->mapObject()->isTileObject())
                             item->syncWithMapObject();
+
+                    updateVirtualizedObjectGroups();
+                }
             }
         }
 
@@ -458,6 +535,9 @@ void MapItem::documentChanged(const ChangeEvent &change)
                 if (TileLayerItem *tli = dynamic_cast<TileLayerItem*>(item))
                     tli->syncWithTileLayer();
             }
+            invalidateLayerCompositions();
+        } else if (tilesetChange.property == Tileset::FillModeProperty) {
+            invalidateTileLayerCaches();
         }
         break;
     }
@@ -499,6 +579,7 @@ void MapItem::tileLayerChanged(TileLayer *tileLayer, MapDocument::TileLayerChang
 {
     TileLayerItem *item = static_cast<TileLayerItem*>(mLayerItems.value(tileLayer));
     item->syncWithTileLayer();
+    item->repaint();
 
     if (flags & MapDocument::LayerBoundsChanged)
         updateBoundingRect();
@@ -515,6 +596,7 @@ void MapItem::layerAdded(Layer *layer)
 
     updateBoundingRect();
     updateSelectedLayersHighlight();
+    invalidateLayerComposition(layer);
 }
 
 void MapItem::layerAboutToBeRemoved(GroupLayer *parentLayer, int index)
@@ -535,6 +617,7 @@ void MapItem::layerRemoved(Layer *layer)
     deleteLayerItems(layer);
     updateBoundingRect();
     updateSelectedLayersHighlight();
+    invalidateLayerCompositions();
 }
 
 /**
@@ -545,9 +628,12 @@ void MapItem::layerChanged(const LayerChangeEvent &change)
 {
     Layer *layer = change.layer;
     Preferences *prefs = Preferences::instance();
-    QGraphicsItem *layerItem = mLayerItems.value(layer);
+    LayerItem *layerItem = mLayerItems.value(layer);
     Q_ASSERT(layerItem);
 
+    if (change.properties & LayerChangeEvent::TintColorProperty)
+        TintedImageCache::clear();
+
     if (change.properties & (LayerChangeEvent::TintColorProperty |
                              LayerChangeEvent::BlendModeProperty)) {
         updateLayerItems(layer);
@@ -576,7 +662,7 @@ void MapItem::layerChanged(const LayerChangeEvent &change)
             multiplier = opacityFactor;
     }
 
-    layerItem->setOpacity(layer->opacity() * multiplier);
+    setLayerItemOpacity(layerItem, layer->opacity() * multiplier);
 
     if (layer->isGroupLayer() && (change.properties & LayerChangeEvent::ParallaxFactorProperty))
         updateLayerPositions();
@@ -584,21 +670,38 @@ void MapItem::layerChanged(const LayerChangeEvent &change)
         layerItem->setPos(static_cast<MapScene*>(scene())->layerItemPosition(*layer));
 
     updateBoundingRect();   // possible layer offset change
+
+    // Blend mode and parallax factor determine which layers are composited
+    updateLayerCompositions();
+    invalidateLayerComposition(layer);
 }
 
 void MapItem::updateLayerItems(Layer *layer)
 {
     switch (layer->layerType()) {
     case Layer::TileLayerType:
+        static_cast<TileLayerItem*>(mLayerItems.value(layer))->invalidateCache();
+        mLayerItems.value(layer)->update();
+        break;
     case Layer::ImageLayerType:
         mLayerItems.value(layer)->update();
         break;
-    case Layer::ObjectGroupType:
+    case Layer::ObjectGroupType: {
+        auto ogItem = static_cast<ObjectGroupItem*>(mLayerItems.value(layer));
+        if (ogItem->isVirtualized()) {
+            ogItem->update();
+            for (MapObject *mapObject : ogItem->objectsWithItem())
+                if (mapObject->isTileObject())
+                    mObjectItems.value(mapObject)->update();
+            break;
+        }
+
         for (MapObject *mapObject : static_cast<const ObjectGroup&>(*layer)) {
             if (mapObject->isTileObject())
                 mObjectItems.value(mapObject)->update();
         }
         break;
+    }
     case Layer::GroupLayerType:
         // Recurse into group layers since tint color is inherited
         for (auto childLayer : static_cast<GroupLayer*>(layer)->layers())
@@ -615,7 +718,7 @@ void MapItem::imageLayerChanged(ImageLayer *imageLayer)
 {
     ImageLayerItem *item = static_cast<ImageLayerItem*>(mLayerItems.value(imageLayer));
     item->syncWithImageLayer();
-    item->update();
+    item->repaint();
 }
 
 /**
@@ -633,30 +736,66 @@ void MapItem::adaptToTilesetTileSizeChanges(Tileset *tileset)
         if (cell.tileset() == tileset)
             item->syncWithMapObject();
     }
+
+    updateVirtualizedObjectGroups();
 }
 
-void MapItem::adaptToTileSizeChanges(Tile *tile)
+/**
+ * Repaints the places showing any of the changed \a tiles, after their image
+ * changed.
+ */
+void MapItem::adaptToTileSizeChanges(const QList<Tile*> &tiles)
 {
+    const QSet<const Tile*> changedTiles(tiles.cbegin(), tiles.cend());
+
     for (QGraphicsItem *item : std::as_const(mLayerItems))
         if (TileLayerItem *tli = dynamic_cast<TileLayerItem*>(item))
-            tli->syncWithTileLayer();
+            tli->repaintTiles(changedTiles);
 
-    for (MapObjectItem *item : std::as_const(mObjectItems)) {
-        const Cell &cell = item->mapObject()->cell();
-        if (cell.tile() == tile)
-            item->syncWithMapObject();
-    }
+    repaintTileObjects(changedTiles);
 }
 
-void MapItem::tileObjectGroupChanged(Tile *tile)
+void MapItem::tileObjectGroupChanged(const QList<Tile*> &tiles)
 {
     if (!Preferences::instance()->showTileCollisionShapes())
         return;
 
+    repaintTileObjects(QSet<const Tile*>(tiles.cbegin(), tiles.cend()));
+}
+
+/**
+ * Updates and repaints the tile objects showing any of the given \a tiles.
+ */
+void MapItem::repaintTileObjects(const QSet<const Tile*> &tiles)
+{
+    auto showsChangedTile = [&tiles] (const MapObject *object) {
+        const Tile *tile = object->cell().tile();
+        return tile && tiles.contains(tile);
+    };
+
+    // Virtualized object groups paint most of their objects themselves
+    for (LayerItem *layerItem : std::as_const(mLayerItems)) {
+        if (auto ogItem = dynamic_cast<ObjectGroupItem*>(layerItem)) {
+            if (ogItem->isVirtualized()) {
+                const auto &objects = ogItem->objectGroup()->objects();
+                if (std::any_of(objects.begin(), objects.end(), showsChangedTile))
+                    ogItem->repaint();
+            }
+        }
+    }
+
     for (MapObjectItem *item : std::as_const(mObjectItems)) {
-        const Cell &cell = item->mapObject()->cell();
-        if (cell.tile() == tile)
-            item->syncWithMapObject();
+        if (!showsChangedTile(item->mapObject()))
+            continue;
+
+        auto ogItem = static_cast<ObjectGroupItem*>(item->parentItem());
+        if (ogItem->composition())
+            ogItem->repaint(item->mapRectToParent(item->boundingRect()));
+
+        item->syncWithMapObject();
+
+        if (ogItem->composition())
+            ogItem->repaint(item->mapRectToParent(item->boundingRect()));
     }
 }
 
@@ -666,6 +805,70 @@ void MapItem::tilesetReplaced(int index, Tileset *tileset)
     adaptToTilesetTileSizeChanges(tileset);
 }
 
+void MapItem::tilesetImagesChanged(Tileset *tileset)
+{
+    if (contains(mapDocument()->map()->tilesets(), tileset))
+        invalidateTileLayerCaches();
+}
+
+static bool isAnimatedTileFrom(const Cell &cell, const Tileset *tileset)
+{
+    if (cell.tileset() != tileset)
+        return false;
+
+    const Tile *tile = cell.tile();
+    return tile && tile->isAnimated();
+}
+
+/**
+ * Repaints the tiles and tile objects showing animated tiles from the given
+ * \a tileset, after their animation advanced.
+ */
+void MapItem::repaintAnimatedTiles(Tileset *tileset)
+{
+    if (!contains(mapDocument()->map()->tilesets(), tileset))
+        return;
+
+    for (LayerItem *layerItem : std::as_const(mLayerItems)) {
+        if (auto tileLayerItem = dynamic_cast<TileLayerItem*>(layerItem)) {
+            tileLayerItem->repaintAnimatedTiles(tileset);
+        } else if (auto ogItem = dynamic_cast<ObjectGroupItem*>(layerItem)) {
+            // Virtualized object groups paint most of their objects themselves
+            if (ogItem->isVirtualized()) {
+                const auto &objects = ogItem->objectGroup()->objects();
+                if (std::any_of(objects.begin(), objects.end(), [tileset] (const MapObject *object) {
+                                return isAnimatedTileFrom(object->cell(), tileset);
+                })) {
+                    ogItem->repaint();
+                }
+            }
+        }
+    }
+
+    for (MapObjectItem *item : std::as_const(mObjectItems)) {
+        if (isAnimatedTileFrom(item->mapObject()->cell(), tileset)) {
+            auto ogItem = static_cast<ObjectGroupItem*>(item->parentItem());
+            if (ogItem->composition())
+                ogItem->repaint(item->mapRectToParent(item->boundingRect()));
+            else
+                item->update();
+        }
+    }
+}
+
+/**
+ * Drops the pre-rendered tiles of all tile layers, for changes that may
+ * affect the appearance of any tile.
+ */
+void MapItem::invalidateTileLayerCaches()
+{
+    for (QGraphicsItem *item : std::as_const(mLayerItems))
+        if (TileLayerItem *tli = dynamic_cast<TileLayerItem*>(item))
+            tli->invalidateCache();
+
+    invalidateLayerCompositions();
+}
+
 /**
  * Inserts map object items for the given objects.
  */
@@ -675,19 +878,52 @@ void MapItem::objectsInserted(ObjectGroup *objectGroup, int first, int last)
     auto ogItem = static_cast<ObjectGroupItem*>(mLayerItems.value(objectGroup));
     Q_ASSERT(ogItem);
 
-    const ObjectGroup::DrawOrder drawOrder = objectGroup->drawOrder();
+    invalidateLayerComposition(objectGroup);
 
-    for (int i = first; i <= last; ++i) {
-        MapObject *object = objectGroup->objectAt(i);
+    if (ogItem->objectItems() == ObjectGroupItem::SelectedObjectItems) {
+        // Other objects would get drawn below the batched tile objects
+        for (int i = first; i <= last; ++i) {
+            if (!objectGroup->objectAt(i)->isTileObject()) {
+                ogItem->setObjectItems(ObjectGroupItem::AllObjectItems, mapDocument());
 
-        MapObjectItem *item = new MapObjectItem(object, mapDocument(), ogItem);
-        if (drawOrder == ObjectGroup::TopDownOrder)
-            item->setZValue(item->y());
-        else
-            item->setZValue(i);
+                const auto &objects = objectGroup->objects();
+                for (int j = 0; j < objects.size(); ++j)
+                    if (!mObjectItems.contains(objects.at(j)))
+                        createObjectItem(objects.at(j), j, ogItem);
+                return;
+            }
+        }
+    }
 
-        mObjectItems.insert(object, item);
+    if (ogItem->isVirtualized()) {
+        for (int i = first; i <= last; ++i)
+            ogItem->updateObject(objectGroup->objectAt(i));
+
+        updateObjectItems(ogItem, true);
+        return;
     }
+
+    for (int i = first; i <= last; ++i)
+        createObjectItem(objectGroup->objectAt(i), i, ogItem);
+}
+
+MapObjectItem *MapItem::createObjectItem(MapObject *object, int index,
+                                         ObjectGroupItem *objectGroupItem)
+{
+    MapObjectItem *item = new MapObjectItem(object, mapDocument(), objectGroupItem);
+    if (object->objectGroup()->drawOrder() == ObjectGroup::TopDownOrder)
+        item->setZValue(item->y());
+    else
+        item->setZValue(index);
+
+    mObjectItems.insert(object, item);
+
+    if (objectGroupItem->isVirtualized()) {
+        objectGroupItem->setHasObjectItem(object, true);
+        objectGroupItem->updateObject(object);
+    }
+
+    return item;
 }
 
 /**
@@ -696,20 +932,38 @@ void MapItem::objectsInserted(ObjectGroup *objectGroup, int first, int last)
 void MapItem::deleteObjectItem(MapObject *object)
 {
     auto item = mObjectItems.take(object);
-    Q_ASSERT(item);
+
+    auto ogItem = static_cast<ObjectGroupItem*>(mLayerItems.value(object->objectGroup()));
+    if (ogItem && ogItem->isVirtualized()) {
+        ogItem->setHasObjectItem(object, false);
+        ogItem->updateObject(object);
+    } else {
+        Q_ASSERT(item);
+    }
+
     delete item;
+
+    invalidateLayerComposition(object->objectGroup());
 }
 
 /**
  * Updates the map object items related to the given objects.
+ *
+ * Objects without an item are part of a virtualized object group. Since we
+ * don't know where they were painted before, their whole layer is repainted.
  */
 void MapItem::syncObjectItems(const QList<MapObject*> &objects)
 {
     for (MapObject *object : objects) {
-        MapObjectItem *item = mObjectItems.value(object);
-        Q_ASSERT(item);
+        if (MapObjectItem *item = mObjectItems.value(object)) {
+            item->syncWithMapObject();
+        } else {
+            auto ogItem = static_cast<ObjectGroupItem*>(mLayerItems.value(object->objectGroup()));
+            Q_ASSERT(ogItem && ogItem->isVirtualized());
+            ogItem->update();
+        }
 
-        item->syncWithMapObject();
+        invalidateLayerComposition(object->objectGroup());
     }
 }
 
@@ -722,11 +976,18 @@ void MapItem::objectsIndexChanged(ObjectGroup *objectGroup,
     if (objectGroup->drawOrder() != ObjectGroup::IndexOrder)
         return;
 
+    auto ogItem = static_cast<ObjectGroupItem*>(mLayerItems.value(objectGroup));
+    if (ogItem->isVirtualized())
+        ogItem->update();
+
+    invalidateLayerComposition(objectGroup);
+
     for (int i = first; i <= last; ++i) {
         MapObjectItem *item = mObjectItems.value(objectGroup->objectAt(i));
-        Q_ASSERT(item);
+        Q_ASSERT(item || ogItem->isVirtualized());
 
-        item->setZValue(i);
+        if (item)
+            item->setZValue(i);
     }
 }
 
@@ -734,6 +995,91 @@ void MapItem::syncAllObjectItems()
 {
     for (MapObjectItem *item : std::as_const(mObjectItems))
         item->syncWithMapObject();
+
+    updateVirtualizedObjectGroups();
+}
+
+/**
+ * Creates the map object items needed for the given virtualized object group
+ * and deletes the ones that are no longer needed.
+ *
+ * Items are created for the selected objects and, unless there are too many
+ * or the group only needs items for selected objects, for the objects near the
+ * view. Unless \a force is set, nothing is done while the view is still within
+ * the area covered by the last update.
+ */
+void MapItem::updateObjectItems(ObjectGroupItem *objectGroupItem, bool force)
+{
+    auto mapScene = static_cast<MapScene*>(scene());
+    if (!mapScene)
+        return;
+
+    ObjectGroup *objectGroup = objectGroupItem->objectGroup();
+    QSet<MapObject*> wanted;
+
+    if (objectGroupItem->objectItems() == ObjectGroupItem::NearbyObjectItems) {
+        const QRectF viewRect = objectGroupItem->mapRectFromScene(mapScene->viewRect());
+        if (!force && objectGroupItem->realizedArea().contains(viewRect))
+            return;
+
+        // Include some area around the view, so that small movements of the
+        // view don't require a new update
+        const QRectF area = viewRect.adjusted(-viewRect.width() / 2,
+                                              -viewRect.height() / 2,
+                                              viewRect.width() / 2,
+                                              viewRect.height() / 2);
+        objectGroupItem->setRealizedArea(area);
+
+        const MapRenderer *renderer = mapDocument()->renderer();
+        const QRectF pixelArea = renderer->screenToPixelCoords(QPolygonF(area)).boundingRect();
+
+        const QList<MapObject*> nearbyObjects = objectGroup->objectsIntersecting(pixelArea);
+        if (nearbyObjects.size() <= maxNearbyObjectItems)
+            for (MapObject *object : nearbyObjects)
+                wanted.insert(object);
+    } else if (!force) {
+        return;
+    }
+
+    if (mDisplayMode == Editable) {
+        for (MapObject *object : mapDocument()->selectedObjects())
+            if (object->objectGroup() == objectGroup)
+                wanted.insert(object);
+    }
+
+    const QSet<MapObject*> objectsWithItem = objectGroupItem->objectsWithItem();
+    for (MapObject *object : objectsWithItem) {
+        if (!wanted.contains(object)) {
+            objectGroupItem->setHasObjectItem(object, false);
+            objectGroupItem->updateObject(object);
+            delete mObjectItems.take(object);
+        }
+    }
+
+    if (objectGroupItem->objectsWithItem().size() == wanted.size())
+        return;
+
+    // Walk the objects in order, since the index determines the Z value
+    const QList<MapObject*> &objects = objectGroup->objects();
+    for (int i = 0; i < objects.size(); ++i) {
+        MapObject *object = objects.at(i);
+        if (wanted.contains(object) && !objectGroupItem->hasObjectItem(object))
+            createObjectItem(object, i, objectGroupItem);
+    }
+}
+
+/**
+ * Repaints the objects painted by virtualized object groups, for changes that
+ * may affect the appearance of any object.
+ */
+void MapItem::updateVirtualizedObjectGroups()
+{
+    for (LayerItem *layerItem : std::as_const(mLayerItems))
+        if (auto ogItem = dynamic_cast<ObjectGroupItem*>(layerItem))
+            if (ogItem->isVirtualized())
+                ogItem->update();
+
+    invalidateLayerCompositions();
 }
 
 void MapItem::setObjectLineWidth(qreal lineWidth)
@@ -747,6 +1093,8 @@ void MapItem::setObjectLineWidth(qreal lineWidth)
             item->update();
         }
     }
+
+    updateVirtualizedObjectGroups();
 }
 
 void MapItem::setShowTileObjectOutlines(bool enabled)
@@ -757,6 +1105,8 @@ void MapItem::setShowTileObjectOutlines(bool enabled)
         if (!item->mapObject()->cell().isEmpty())
             item->update();
     }
+
+    updateVirtualizedObjectGroups();
 }
 
 void MapItem::createLayerItems(const QList<Layer *> &layers)
@@ -785,20 +1135,20 @@ LayerItem *MapItem::createLayerItem(Layer *layer)
 
     case Layer::ObjectGroupType: {
         auto og = static_cast<ObjectGroup*>(layer);
-        const ObjectGroup::DrawOrder drawOrder = og->drawOrder();
         ObjectGroupItem *ogItem = new ObjectGroupItem(og, parent);
-        int objectIndex = 0;
-        for (MapObject *object : og->objects()) {
-            MapObjectItem *item = new MapObjectItem(object, mapDocument(),
-                                                    ogItem);
-            if (drawOrder == ObjectGroup::TopDownOrder)
-                item->setZValue(item->y());
-            else
-                item->setZValue(objectIndex);
 
-            mObjectItems.insert(object, item);
-            ++objectIndex;
+        // Items for huge object groups and groups of tile objects are
+        // created by updateObjectItems
+        if (og->objectCount() >= batchedTileObjectsThreshold && containsOnlyTileObjects(og)) {
+            ogItem->setObjectItems(ObjectGroupItem::SelectedObjectItems, mapDocument());
+        } else if (og->objectCount() >= virtualizedObjectGroupThreshold) {
+            ogItem->setObjectItems(ObjectGroupItem::NearbyObjectItems, mapDocument());
+        } else {
+            int objectIndex = 0;
+            for (MapObject *object : og->objects())
+                createObjectItem(object, objectIndex++, ogItem);
         }
+
         layerItem = ogItem;
         break;
     }
@@ -828,6 +1178,10 @@ LayerItem *MapItem::createLayerItem(Layer *layer)
     if (GroupLayer *groupLayer = layer->asGroupLayer())
         createLayerItems(groupLayer->layers());
 
+    if (auto ogItem = dynamic_cast<ObjectGroupItem*>(layerItem))
+        if (ogItem->isVirtualized())
+            updateObjectItems(ogItem, true);
+
     return layerItem;
 }
 
@@ -849,7 +1203,10 @@ void MapItem::deleteLayerItems(Layer *layer)
         break;
     }
 
-    delete mLayerItems.take(layer);
+    LayerItem *layerItem = mLayerItems.take(layer);
+    mLayersBelow->removeLayerItem(layerItem);
+    mLayersAbove->removeLayerItem(layerItem);
+    delete layerItem;
 }
 
 void MapItem::updateBoundingRect()
@@ -881,9 +1238,10 @@ void MapItem::updateSelectedLayersHighlight()
 
             // Restore opacity for all layers
             for (auto layerItem : std::as_const(mLayerItems))
-                layerItem->setOpacity(layerItem->layer()->opacity());
+                setLayerItemOpacity(layerItem, layerItem->layer()->opacity());
         }
 
+        updateLayerCompositions();
         return;
     }
 
@@ -918,9 +1276,113 @@ void MapItem::updateSelectedLayersHighlight()
 
         if (!layer->isGroupLayer()) {
             qreal multiplier = (foundSelected && !isSelected) ? opacityFactor : 1;
-            mLayerItems.value(layer)->setOpacity(layer->opacity() * multiplier);
+            setLayerItemOpacity(mLayerItems.value(layer), layer->opacity() * multiplier);
+        }
+    }
+
+    updateLayerCompositions();
+}
+
+static bool canComposite(const Layer *layer)
+{
+    // Parallax scrolling moves the layer relative to the cached pixmap
+    if (layer->blendMode() != BlendMode::Normal || layer->parallaxFactor() != QPointF(1, 1))
+        return false;
+
+    if (const GroupLayer *groupLayer = layer->asGroupLayer()) {
+        const auto &layers = groupLayer->layers();
+        return std::all_of(layers.begin(), layers.end(), canComposite);
+    }
+
+    return true;
+}
+
+/**
+ * Draws the top-level layers directly below and above the selected layers
+ * from cached pixmaps, since these layers rarely change while editing.
+ *
+ * Only runs of at least two layers are composited, and they end at the
+ * first layer with a blend mode or a parallax factor.
+ */
+void MapItem::updateLayerCompositions()
+{
+    QVector<LayerItem*> below;
+    QVector<LayerItem*> above;
+    int first = 0;
+    int last = 0;
+
+    const auto &selectedLayers = mapDocument()->selectedLayers();
+
+    if (mDisplayMode == Editable && !selectedLayers.isEmpty()) {
+        const auto &layers = mapDocument()->map()->layers();
+        first = layers.size();
+        last = -1;
+
+        for (Layer *layer : selectedLayers) {
+            while (layer->parentLayer())
+                layer = layer->parentLayer();
+
+            const int index = layer->siblingIndex();
+            first = std::min(first, index);
+            last = std::max(last, index);
         }
+
+        int begin = first;
+        while (begin > 0 && canComposite(layers.at(begin - 1)))
+            --begin;
+        for (int i = begin; i < first; ++i)
+            below.append(mLayerItems.value(layers.at(i)));
+
+        for (int i = last + 1; i < layers.size() && canComposite(layers.at(i)); ++i)
+            above.append(mLayerItems.value(layers.at(i)));
+
+        if (below.size() < 2)
+            below.clear();
+        if (above.size() < 2)
+            above.clear();
     }
+
+    mLayersBelow->setLayerItems(below);
+    mLayersAbove->setLayerItems(above);
+
+    // Stay below the dark rectangle, which is placed at first - 0.5
+    mLayersBelow->setZValue(first - 0.75);
+    mLayersAbove->setZValue(last + 0.75);
+}
+
+/**
+ * Sets the opacity of the given \a layerItem, which is applied by its
+ * composition when it is composited.
+ */
+void MapItem::setLayerItemOpacity(LayerItem *layerItem, qreal opacity)
+{
+    LayerCompositionItem *composition = layerItem->composition();
+
+    if (composition && composition->contains(layerItem)) {
+        composition->setLayerItemOpacity(layerItem, opacity);
+    } else if (layerItem->opacity() != opacity) {
+        layerItem->setOpacity(opacity);
+
+        if (composition)
+            composition->invalidate();
+    }
+}
+
+/**
+ * Drops the cached pixmap of the composition the given \a layer is part
+ * of, if any.
+ */
+void MapItem::invalidateLayerComposition(Layer *layer)
+{
+    if (LayerItem *layerItem = mLayerItems.value(layer))
+        if (LayerCompositionItem *composition = layerItem->composition())
+            composition->invalidate();
+}
+
+void MapItem::invalidateLayerCompositions()
+{
+    mLayersBelow->invalidate();
+    mLayersAbove->invalidate();
 }
 
 } // namespace Tiled
@@ -39,9 +39,12 @@ class Tileset;
 
 class BorderItem;
 class LayerChangeEvent;
+class LayerCompositionItem;
 class LayerItem;
 class MapObjectItem;
 class MapScene;
+class ObjectGroupItem;
+class ObjectPicker;
 class ObjectSelectionItem;
 class TileGridItem;
 class TileSelectionItem;
@@ -70,11 +73,16 @@ public:
     int type() const override { return Type; }
 
     MapDocument *mapDocument() const;
+    ObjectPicker *objectPicker() const;
 
     void setDisplayMode(DisplayMode displayMode);
     void setShowTileCollisionShapes(bool enabled);
 
     void updateLayerPositions();
+    void updateObjectItems(bool force = false);
+    void viewRectChanged();
+
+    void repaintAnimatedTiles(Tileset *tileset);
 
     // QGraphicsItem
     QRectF boundingRect() const override;
@@ -112,18 +120,26 @@ private:
     void imageLayerChanged(ImageLayer *imageLayer);
 
     void adaptToTilesetTileSizeChanges(Tileset *tileset);
-    void adaptToTileSizeChanges(Tile *tile);
-    void tileObjectGroupChanged(Tile *tile);
+    void adaptToTileSizeChanges(const QList<Tile*> &tiles);
+    void tileObjectGroupChanged(const QList<Tile*> &tiles);
+    void repaintTileObjects(const QSet<const Tile*> &tiles);
 
     void tilesetReplaced(int index, Tileset *tileset);
+    void tilesetImagesChanged(Tileset *tileset);
+    void invalidateTileLayerCaches();
 
     void objectsInserted(ObjectGroup *objectGroup, int first, int last);
+    MapObjectItem *createObjectItem(MapObject *object, int index,
+                                    ObjectGroupItem *objectGroupItem);
     void deleteObjectItem(MapObject *object);
     void syncObjectItems(const QList<MapObject*> &objects);
     void objectsIndexChanged(ObjectGroup *objectGroup, int first, int last);
 
     void syncAllObjectItems();
 
+    void updateObjectItems(ObjectGroupItem *objectGroupItem, bool force);
+    void updateVirtualizedObjectGroups();
+
     void setObjectLineWidth(qreal lineWidth);
     void setShowTileObjectOutlines(bool enabled);
 
@@ -134,9 +150,17 @@ private:
     void updateBoundingRect();
     void updateSelectedLayersHighlight();
 
+    void updateLayerCompositions();
+    void setLayerItemOpacity(LayerItem *layerItem, qreal opacity);
+    void invalidateLayerComposition(Layer *layer);
+    void invalidateLayerCompositions();
+
     MapDocumentPtr mMapDocument;
     QGraphicsRectItem *mDarkRectangle;
+    LayerCompositionItem *mLayersBelow;
+    LayerCompositionItem *mLayersAbove;
     QGraphicsRectItem *mBorderRectangle;
+    std::unique_ptr<ObjectPicker> mObjectPicker;
     std::unique_ptr<TileSelectionItem> mTileSelectionItem;
     std::unique_ptr<TileGridItem> mTileGridItem;
     std::unique_ptr<ObjectSelectionItem> mObjectSelectionItem;
@@ -152,4 +176,9 @@ inline MapDocument *MapItem::mapDocument() const
     return mMapDocument.data();
 }
 
+inline ObjectPicker *MapItem::objectPicker() const
+{
+    return mObjectPicker.get();
+}
+
 } // namespace Tiled
@@ -64,15 +64,11 @@ void MapObjectItem::syncWithMapObject()
         update();
     }
 
-    QString toolTip = mObject->name();
-    const QString &className = mObject->effectiveClassName();
-    if (!className.isEmpty())
-        toolTip += QStringLiteral(" (") + className + QLatin1Char(')');
-    setToolTip(toolTip);
+    setToolTip(objectToolTip(mObject));
 
     MapRenderer *renderer = mMapDocument->renderer();
     QPointF pixelPos = renderer->pixelToScreenCoords(mObject->position());
-    QRectF bounds = renderer->boundingRect(mObject);
+    QRectF bounds = renderer->cachedBoundingRect(mObject);
 
     bounds.translate(-pixelPos);
 
@@ -111,6 +107,18 @@ void MapObjectItem::setIsHoverIndicator(bool isHoverIndicator)
     syncWithMapObject();
 }
 
+/**
+ * Returns the tool tip shown for the given \a object.
+ */
+QString MapObjectItem::objectToolTip(const MapObject *object)
+{
+    QString toolTip = object->name();
+    const QString &className = object->effectiveClassName();
+    if (!className.isEmpty())
+        toolTip += QStringLiteral(" (") + className + QLatin1Char(')');
+    return toolTip;
+}
+
 QRectF MapObjectItem::boundingRect() const
 {
     return mBoundingRect;
@@ -121,7 +129,7 @@ QPainterPath MapObjectItem::shape() const
     if (mObject->isTileObject() && preciseTileObjectSelection)
         return mObject->tileObjectShape(mMapDocument->map());
 
-    QPainterPath path = mMapDocument->renderer()->interactionShape(mObject);
+    QPainterPath path = mMapDocument->renderer()->cachedInteractionShape(mObject);
     path.translate(-pos());
     return path;
 }
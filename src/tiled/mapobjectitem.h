@@ -68,6 +68,8 @@ public:
     bool isHoverIndicator() const;
     void setIsHoverIndicator(bool isHoverIndicator);
 
+    static QString objectToolTip(const MapObject *object);
+
     // QGraphicsItem
     QRectF boundingRect() const override;
     QPainterPath shape() const override;
@@ -33,10 +33,14 @@
 
 #include <QApplication>
 #include <QPalette>
+#include <QSet>
 #include <QStyle>
 
 using namespace Tiled;
 
+// The number of objects added to the model at once for each object layer
+static constexpr int objectFetchBatchSize = 1000;
+
 ObjectIconManager::ObjectIconManager()
    : mRectangleIcon(QLatin1String(":images/24/object-rectangle.png"))
    , mImageIcon(QLatin1String(":images/24/object-image.png"))
@@ -87,8 +91,8 @@ QModelIndex MapObjectModel::index(int row, int column,
                                   const QModelIndex &parent) const
 {
     if (ObjectGroup *objectGroup = toObjectGroup(parent)) {
-        if (row < objectGroup->objectCount())
-            return createIndex(row, column, objectGroup->objectAt(row));
+        if (row < fetchedObjectCount(objectGroup))
+            return createIndex(row, column, objectGroup->objectAt(row + unfetchedObjectCount(objectGroup)));
         return QModelIndex();
     }
 
@@ -135,7 +139,7 @@ int MapObjectModel::rowCount(const QModelIndex &parent) const
         case Layer::GroupLayerType:
             return filteredChildLayers(static_cast<GroupLayer*>(layer)).size();
         case Layer::ObjectGroupType:
-            return static_cast<ObjectGroup*>(layer)->objectCount();
+            return fetchedObjectCount(static_cast<ObjectGroup*>(layer));
         default:
             break;
         }
@@ -143,6 +147,19 @@ int MapObjectModel::rowCount(const QModelIndex &parent) const
     return 0;
 }
 
+bool MapObjectModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (ObjectGroup *objectGroup = toObjectGroup(parent))
+        return unfetchedObjectCount(objectGroup) > 0;
+    return false;
+}
+
+void MapObjectModel::fetchMore(const QModelIndex &parent)
+{
+    if (ObjectGroup *objectGroup = toObjectGroup(parent))
+        fetchObjects(objectGroup, objectFetchBatchSize);
+}
+
 int MapObjectModel::columnCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent)
@@ -346,7 +363,10 @@ QModelIndex MapObjectModel::index(MapObject *mapObject, int column) const
     Q_ASSERT(mapObject->objectGroup());
     Q_ASSERT(mapObject->map() == map());
 
-    const int row = mapObject->objectGroup()->objects().indexOf(mapObject);
+    const int row = objectIndex(mapObject) - unfetchedObjectCount(mapObject->objectGroup());
+    if (row < 0)
+        return QModelIndex();   // not fetched yet, see fetchObject()
+
     return createIndex(row, column, mapObject);
 }
 
@@ -416,6 +436,8 @@ void MapObjectModel::setMapDocument(MapDocument *mapDocument)
     mMapDocument = mapDocument;
 
     mFilteredLayers.clear();
+    mFetchedObjectCounts.clear();
+    mObjectIndexes.clear();
 
     if (mMapDocument) {
         connect(mMapDocument, &MapDocument::layerAdded,
@@ -433,6 +455,8 @@ void MapObjectModel::setMapDocument(MapDocument *mapDocument)
 void MapObjectModel::layerAdded(Layer *layer)
 {
     if (layer->isObjectGroup() || layer->isGroupLayer()) {
+        forgetLayer(layer);
+
         auto &filtered = filteredChildLayers(layer->parentLayer());
         if (filtered.contains(layer))
             return;
@@ -473,6 +497,7 @@ void MapObjectModel::layerAboutToBeRemoved(GroupLayer *groupLayer, int index)
 
         beginRemoveRows(parent, row, row);
         filtered.removeAt(row);
+        forgetLayer(layer);
         endRemoveRows();
     }
 }
@@ -491,12 +516,14 @@ void MapObjectModel::classChanged(const QList<Object *> &objects)
         for (Object *object : objects)
             affectedObjects.append(static_cast<MapObject*>(object));
     } else if (typeId == Object::TileType) {
+        const QSet<Object*> tiles(objects.begin(), objects.end());
+
         for (const Layer *layer : map()->objectGroups()) {
             auto objectGroup = static_cast<const ObjectGroup*>(layer);
             for (MapObject *mapObject : objectGroup->objects()) {
                 if (mapObject->className().isEmpty())
                     if (auto tile = mapObject->cell().tile())
-                        if (objects.contains(tile))
+                        if (tiles.contains(tile))
                             affectedObjects.append(mapObject);
             }
         }
@@ -524,6 +551,11 @@ QList<Layer *> &MapObjectModel::filteredChildLayers(GroupLayer *parentLayer) con
 
 void MapObjectModel::moveObjects(ObjectGroup *og, int from, int to, int count)
 {
+    // Moving objects from or to the part that wasn't fetched yet is not
+    // expressible as a row move, so fetch all objects in that case.
+    if (std::min(from, to) < unfetchedObjectCount(og))
+        fetchObjects(og, og->objectCount());
+
     const QModelIndex parent = index(og);
     if (!beginMoveRows(parent, from, from + count - 1, parent, to)) {
         Q_ASSERT(false); // The code should never attempt this
@@ -531,9 +563,38 @@ void MapObjectModel::moveObjects(ObjectGroup *og, int from, int to, int count)
     }
 
     og->moveObjects(from, to, count);
+    mObjectIndexes.remove(og);
     endMoveRows();
 }
 
+/**
+ * Makes sure the given \a mapObject is part of the model, fetching all
+ * objects above it in its layer when necessary.
+ */
+void MapObjectModel::fetchObject(MapObject *mapObject)
+{
+    ObjectGroup *objectGroup = mapObject->objectGroup();
+    const int unfetched = unfetchedObjectCount(objectGroup);
+    const int index = objectIndex(mapObject);
+
+    if (index >= 0 && index < unfetched)
+        fetchObjects(objectGroup, unfetched - index);
+}
+
+/**
+ * Fetches all objects, for example to be able to filter them.
+ */
+void MapObjectModel::fetchAllObjects()
+{
+    if (!mMapDocument)
+        return;
+
+    for (Layer *layer : map()->objectGroups()) {
+        auto objectGroup = static_cast<ObjectGroup*>(layer);
+        fetchObjects(objectGroup, unfetchedObjectCount(objectGroup));
+    }
+}
+
 void MapObjectModel::documentChanged(const ChangeEvent &change)
 {
     // Notify views about certain property changes
@@ -543,6 +604,8 @@ void MapObjectModel::documentChanged(const ChangeEvent &change)
         break;
     case ChangeEvent::DocumentReloaded:
         mFilteredLayers.clear();
+        mFetchedObjectCounts.clear();
+        mObjectIndexes.clear();
         endResetModel();
         break;
     case ChangeEvent::ObjectsChanged: {
@@ -570,21 +633,40 @@ void MapObjectModel::documentChanged(const ChangeEvent &change)
         // handled individually instead
         break;
     case ChangeEvent::MapObjectAboutToBeAdded: {
+        // Objects inserted below the fetched objects don't affect the rows
         auto &e = static_cast<const MapObjectEvent&>(change);
-        beginInsertRows(index(e.objectGroup), e.index, e.index);
+        const int row = e.index - unfetchedObjectCount(e.objectGroup);
+        mInsertingOrRemovingRow = row >= 0;
+        if (mInsertingOrRemovingRow)
+            beginInsertRows(index(e.objectGroup), row, row);
         break;
     }
     case ChangeEvent::MapObjectAboutToBeRemoved: {
         auto &e = static_cast<const MapObjectEvent&>(change);
-        beginRemoveRows(index(e.objectGroup), e.index, e.index);
+        const int row = e.index - unfetchedObjectCount(e.objectGroup);
+        mInsertingOrRemovingRow = row >= 0;
+        if (mInsertingOrRemovingRow)
+            beginRemoveRows(index(e.objectGroup), row, row);
         break;
     }
-    case ChangeEvent::MapObjectAdded:
-        endInsertRows();
+    case ChangeEvent::MapObjectAdded: {
+        auto &e = static_cast<const MapObjectEvent&>(change);
+        mObjectIndexes.remove(e.objectGroup);
+        if (std::exchange(mInsertingOrRemovingRow, false)) {
+            ++mFetchedObjectCounts[e.objectGroup];
+            endInsertRows();
+        }
         break;
-    case ChangeEvent::MapObjectRemoved:
-        endRemoveRows();
+    }
+    case ChangeEvent::MapObjectRemoved: {
+        auto &e = static_cast<const MapObjectEvent&>(change);
+        mObjectIndexes.remove(e.objectGroup);
+        if (std::exchange(mInsertingOrRemovingRow, false)) {
+            --mFetchedObjectCounts[e.objectGroup];
+            endRemoveRows();
+        }
         break;
+    }
     case ChangeEvent::MapObjectsChanged: {
         const auto &mapObjectChange = static_cast<const MapObjectsChangeEvent&>(change);
 
@@ -603,6 +685,10 @@ void MapObjectModel::documentChanged(const ChangeEvent &change)
     }
 }
 
+/**
+ * Emits dataChanged for the given \a objects, combining the rows of
+ * adjacent objects into a single signal.
+ */
 void MapObjectModel::emitDataChanged(const QList<MapObject *> &objects,
                                      const QVarLengthArray<Column, 3> &columns,
                                      const QVector<int> &roles)
@@ -610,11 +696,50 @@ void MapObjectModel::emitDataChanged(const QList<MapObject *> &objects,
     if (columns.isEmpty())
         return;
 
-    auto minMaxPair = std::minmax_element(columns.begin(), columns.end());
-    for (auto object : objects) {
-        emit dataChanged(index(object, *minMaxPair.first),
-                         index(object, *minMaxPair.second),
-                         roles);
+    const auto minMaxPair = std::minmax_element(columns.begin(), columns.end());
+    const int firstColumn = *minMaxPair.first;
+    const int lastColumn = *minMaxPair.second;
+
+    if (objects.size() == 1) {
+        const QModelIndex index = this->index(objects.first());
+        if (index.isValid())
+            emit dataChanged(index.siblingAtColumn(firstColumn),
+                             index.siblingAtColumn(lastColumn),
+                             roles);
+        return;
+    }
+
+    QHash<ObjectGroup*, QVector<int>> rowsByObjectGroup;
+    for (MapObject *object : objects) {
+        const QModelIndex index = this->index(object);
+        if (index.isValid())
+            rowsByObjectGroup[object->objectGroup()].append(index.row());
+    }
+
+    for (auto it = rowsByObjectGroup.begin(); it != rowsByObjectGroup.end(); ++it) {
+        const QModelIndex parent = index(it.key());
+        QVector<int> &rows = it.value();
+        std::sort(rows.begin(), rows.end());
+
+        int first = rows.first();
+        int last = first;
+
+        auto emitRange = [&] {
+            emit dataChanged(index(first, firstColumn, parent),
+                             index(last, lastColumn, parent),
+                             roles);
+        };
+
+        for (int i = 1; i < rows.size(); ++i) {
+            const int row = rows.at(i);
+            if (row <= last + 1) {
+                last = row;
+            } else {
+                emitRange();
+                first = last = row;
+            }
+        }
+        emitRange();
     }
 }
 
@@ -623,4 +748,71 @@ Map *MapObjectModel::map() const
     return mMapDocument->map();
 }
 
+int MapObjectModel::fetchedObjectCount(ObjectGroup *objectGroup) const
+{
+    auto it = mFetchedObjectCounts.find(objectGroup);
+    if (it == mFetchedObjectCounts.end()) {
+        const int count = std::min(objectGroup->objectCount(), objectFetchBatchSize);
+        it = mFetchedObjectCounts.insert(objectGroup, count);
+    }
+    return it.value();
+}
+
+int MapObjectModel::unfetchedObjectCount(ObjectGroup *objectGroup) const
+{
+    return objectGroup->objectCount() - fetchedObjectCount(objectGroup);
+}
+
+/**
+ * Adds up to \a count more objects of the given \a objectGroup to the model.
+ * Since the top-most objects are fetched first, these are inserted as the
+ * first rows.
+ */
+void MapObjectModel::fetchObjects(ObjectGroup *objectGroup, int count)
+{
+    count = std::min(count, unfetchedObjectCount(objectGroup));
+    if (count <= 0)
+        return;
+
+    beginInsertRows(index(objectGroup), 0, count - 1);
+    mFetchedObjectCounts[objectGroup] += count;
+    endInsertRows();
+}
+
+/**
+ * Returns the index of the object in its object group. Uses a lookup table
+ * to avoid a linear search on layers with many objects.
+ */
+int MapObjectModel::objectIndex(MapObject *mapObject) const
+{
+    const ObjectGroup *objectGroup = mapObject->objectGroup();
+
+    auto it = mObjectIndexes.find(objectGroup);
+    if (it == mObjectIndexes.end()) {
+        it = mObjectIndexes.insert(objectGroup, {});
+
+        QHash<const MapObject*, int> &indexes = it.value();
+        const auto &objects = objectGroup->objects();
+        indexes.reserve(objects.size());
+        for (int i = 0; i < objects.size(); ++i)
+            indexes.insert(objects.at(i), i);
+    }
+
+    return it.value().value(mapObject, -1);
+}
+
+/**
+ * Drops the cached state of the given \a layer and its child layers.
+ */
+void MapObjectModel::forgetLayer(Layer *layer)
+{
+    if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
+        mFetchedObjectCounts.remove(objectGroup);
+        mObjectIndexes.remove(objectGroup);
+    } else if (GroupLayer *groupLayer = layer->asGroupLayer()) {
+        for (Layer *childLayer : groupLayer->layers())
+            forgetLayer(childLayer);
+    }
+}
+
 #include "moc_mapobjectmodel.cpp"
@@ -24,6 +24,7 @@
 #include "mapobject.h"
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QIcon>
 
 namespace Tiled {
@@ -88,6 +89,9 @@ public:
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     int columnCount(const QModelIndex &parent = QModelIndex()) const override;
 
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
 
     bool setData(const QModelIndex &index, const QVariant &value, int role) override;
@@ -109,6 +113,9 @@ public:
 
     void moveObjects(ObjectGroup *og, int from, int to, int count);
 
+    void fetchObject(MapObject *mapObject);
+    void fetchAllObjects();
+
     QIcon objectGroupIcon() const;
 
 private:
@@ -123,12 +130,28 @@ private:
 
     Map *map() const;
 
+    int fetchedObjectCount(ObjectGroup *objectGroup) const;
+    int unfetchedObjectCount(ObjectGroup *objectGroup) const;
+    void fetchObjects(ObjectGroup *objectGroup, int count);
+    int objectIndex(MapObject *mapObject) const;
+    void forgetLayer(Layer *layer);
+
     MapDocument *mMapDocument = nullptr;
 
     // cache
     mutable QMap<GroupLayer*, QList<Layer*>> mFilteredLayers;
     QList<Layer *> &filteredChildLayers(GroupLayer *parentLayer) const;
 
+    /*
+     * Only the top-most objects of each object layer are initially part of
+     * the model, further objects are added in batches by fetchMore(). The
+     * rows of an object layer are therefore offset by the number of objects
+     * not yet fetched.
+     */
+    mutable QHash<const ObjectGroup*, int> mFetchedObjectCounts;
+    mutable QHash<const ObjectGroup*, QHash<const MapObject*, int>> mObjectIndexes;
+    bool mInsertingOrRemovingRow = false;
+
     QIcon mObjectGroupIcon;
 };
 
@@ -0,0 +1,201 @@
+/*
+ * mapplaceholderitem.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mapplaceholderitem.h"
+
+#include "map.h"
+
+#include <QCache>
+#include <QFileInfo>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtConcurrent>
+#include <QtMath>
+
+#include <memory>
+
+namespace Tiled {
+
+using Thumbnail = MapThumbnailCache::Thumbnail;
+
+// Thumbnails are kept up to a total of 64 MB, with the cost in kilobytes
+static QCache<QString, Thumbnail> &thumbnailCache()
+{
+    static QCache<QString, Thumbnail> cache(64 * 1024);
+    return cache;
+}
+
+static QString thumbnailKey(const QString &fileName, int size)
+{
+    return QString::number(size) + QLatin1Char(':') + fileName;
+}
+
+static void insertThumbnail(const QString &fileName, int size, const Thumbnail &thumbnail)
+{
+    const int cost = qMax<qsizetype>(1, thumbnail.image.sizeInBytes() / 1024);
+    thumbnailCache().insert(thumbnailKey(fileName, size), new Thumbnail(thumbnail), cost);
+}
+
+/**
+ * Renders a thumbnail of a copy of the given \a map on a worker thread, and
+ * stores it in the MapThumbnailCache.
+ */
+static void storeInBackground(const QString &fileName, const Map *map)
+{
+    if (!MapThumbnailCache::isEnabled())
+        return;
+
+    // Tile data is shared, so cloning the map is relatively cheap
+    std::shared_ptr<const Map> clone = map->clone();
+
+    QtConcurrent::run([fileName, clone] {
+        MapThumbnailCache::store(fileName, clone.get());
+    });
+}
+
+MapPlaceholderItem::MapPlaceholderItem(const QString &fileName, QSize size,
+                                       QGraphicsItem *parent)
+    : QGraphicsItem(parent)
+    , mFileName(fileName)
+    , mRect(QPointF(), size)
+    , mBoundingRect(mRect)
+{
+    // Include the parts of the thumbnail that overhang the map area
+    QRect bounds;
+    for (int size : MapThumbnailCache::sizes) {
+        if (const Thumbnail *thumbnail = thumbnailCache().object(thumbnailKey(fileName, size))) {
+            bounds = thumbnail->bounds;
+            break;
+        }
+    }
+    if (bounds.isNull())
+        bounds = MapThumbnailCache::bounds(fileName);
+
+    mBoundingRect |= QRectF(bounds);
+}
+
+QRectF MapPlaceholderItem::boundingRect() const
+{
+    return mBoundingRect;
+}
+
+void MapPlaceholderItem::paint(QPainter *painter,
+                               const QStyleOptionGraphicsItem *option,
+                               QWidget *)
+{
+    const QRectF viewRect = painter->worldTransform().mapRect(mRect);
+
+    // Pick the thumbnail resolution based on the size at which it is shown
+    const int requiredSize = MapThumbnailCache::sizeFor(qCeil(qMax(viewRect.width(),
+                                                                  viewRect.height())));
+    if (requiredSize > mThumbnailSize)
+        loadThumbnail(requiredSize);
+
+    if (!mThumbnail.isNull()) {
+        painter->setRenderHint(QPainter::SmoothPixmapTransform);
+        painter->drawImage(QRectF(mThumbnail.bounds), mThumbnail.image);
+        return;
+    }
+
+    const qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+
+    QColor color = option->palette.highlight().color();
+    color.setAlpha(32);
+
+    QPen pen(option->palette.mid().color());
+    pen.setCosmetic(true);
+
+    painter->setPen(pen);
+    painter->setBrush(color);
+    painter->drawRect(mRect);
+
+    // Only show the name when it can be read
+    if (viewRect.width() < 64 || viewRect.height() < 16)
+        return;
+
+    painter->save();
+    painter->scale(1 / lod, 1 / lod);
+    painter->setPen(option->palette.text().color());
+    painter->drawText(QRectF(mRect.topLeft() * lod, mRect.size() * lod),
+                      Qt::AlignCenter | Qt::TextWordWrap,
+                      QFileInfo(mFileName).fileName());
+    painter->restore();
+}
+
+/**
+ * Looks up the thumbnail at the given \a size, first in memory and then in
+ * the MapThumbnailCache. Keeps the current thumbnail when none is found.
+ */
+void MapPlaceholderItem::loadThumbnail(int size)
+{
+    mThumbnailSize = size;
+
+    if (const Thumbnail *thumbnail = thumbnailCache().object(thumbnailKey(mFileName, size))) {
+        mThumbnail = *thumbnail;
+        return;
+    }
+
+    const Thumbnail thumbnail = MapThumbnailCache::load(mFileName, size);
+    if (thumbnail.isNull())
+        return;
+
+    mThumbnail = thumbnail;
+    insertThumbnail(mFileName, size, thumbnail);
+}
+
+/**
+ * Renders small images of the given \a map, to be shown by placeholders for
+ * the map with the given \a fileName. When the MapThumbnailCache has no
+ * thumbnail for the map yet, one is stored in the background.
+ */
+void MapPlaceholderItem::storeThumbnail(const QString &fileName, const Map *map)
+{
+    // Larger thumbnails are not needed until zooming in, which is when the
+    // map would be loaded again
+    constexpr int immediateThumbnailSize = 256;
+
+    const Thumbnail thumbnail = MapThumbnailCache::render(map, immediateThumbnailSize);
+    if (thumbnail.isNull())
+        return;
+
+    for (int size : MapThumbnailCache::sizes) {
+        if (size > immediateThumbnailSize)
+            break;
+        insertThumbnail(fileName, size, MapThumbnailCache::scaled(thumbnail, size));
+    }
+
+    if (!MapThumbnailCache::contains(fileName))
+        storeInBackground(fileName, map);
+}
+
+/**
+ * Replaces the thumbnails of the given \a map after it was saved to the file
+ * with the given \a fileName. The new thumbnails are rendered in the
+ * background.
+ */
+void MapPlaceholderItem::refreshThumbnail(const QString &fileName, const Map *map)
+{
+    for (int size : MapThumbnailCache::sizes)
+        thumbnailCache().remove(thumbnailKey(fileName, size));
+
+    storeInBackground(fileName, map);
+}
+
+} // namespace Tiled
@@ -0,0 +1,70 @@
+/*
+ * mapplaceholderitem.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mapthumbnailcache.h"
+
+#include <QGraphicsItem>
+
+namespace Tiled {
+
+class Map;
+
+/**
+ * Stands in for a map of a world that is currently not loaded.
+ *
+ * When a thumbnail of the map is available, it is drawn in place of the map.
+ * Otherwise, only the area of the map and its file name are shown. The
+ * thumbnail is taken from the MapThumbnailCache at a resolution matching the
+ * zoom level, when the map has been loaded or saved before.
+ */
+class MapPlaceholderItem final : public QGraphicsItem
+{
+public:
+    MapPlaceholderItem(const QString &fileName, QSize size,
+                       QGraphicsItem *parent = nullptr);
+
+    const QString &fileName() const;
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter,
+               const QStyleOptionGraphicsItem *option,
+               QWidget *widget = nullptr) override;
+
+    static void storeThumbnail(const QString &fileName, const Map *map);
+    static void refreshThumbnail(const QString &fileName, const Map *map);
+
+private:
+    void loadThumbnail(int size);
+
+    QString mFileName;
+    QRectF mRect;
+    QRectF mBoundingRect;
+    MapThumbnailCache::Thumbnail mThumbnail;
+    int mThumbnailSize = 0;
+};
+
+inline const QString &MapPlaceholderItem::fileName() const
+{
+    return mFileName;
+}
+
+} // namespace Tiled
@@ -30,8 +30,12 @@
 #include "documentmanager.h"
 #include "map.h"
 #include "mapobject.h"
+#include "mapobjectitem.h"
+#include "mapplaceholderitem.h"
 #include "maprenderer.h"
+#include "mapthumbnailcache.h"
 #include "objectgroup.h"
+#include "objectpicker.h"
 #include "objecttemplate.h"
 #include "snaphelper.h"
 #include "stylehelper.h"
@@ -43,14 +47,22 @@
 
 #include <QApplication>
 #include <QFileInfo>
+#include <QGraphicsSceneHelpEvent>
 #include <QGraphicsSceneMouseEvent>
+#include <QGraphicsView>
 #include <QKeyEvent>
+#include <QLineF>
 #include <QMimeData>
 #include <QPalette>
+#include <QToolTip>
+
+#include <algorithm>
 
 using namespace Tiled;
 
 SessionOption<bool> MapScene::enableWorlds { "mapScene.enableWorlds", true };
+SessionOption<int> MapScene::worldStreamingDistance { "mapScene.worldStreamingDistance", 1024 };
+SessionOption<int> MapScene::worldStreamingMaximumMaps { "mapScene.worldStreamingMaximumMaps", 64 };
 
 MapScene::MapScene(QObject *parent)
     : QGraphicsScene(parent)
@@ -65,7 +77,7 @@ MapScene::MapScene(QObject *parent)
     connect(tilesetManager, &TilesetManager::tilesetImagesChanged,
             this, &MapScene::repaintTileset);
     connect(tilesetManager, &TilesetManager::repaintTileset,
-            this, &MapScene::repaintTileset);
+            this, &MapScene::repaintAnimatedTiles);
 
     WorldManager &worldManager = WorldManager::instance();
     connect(&worldManager, &WorldManager::worldsChanged, this, &MapScene::refreshScene);
@@ -76,6 +88,11 @@ MapScene::MapScene(QObject *parent)
 
     mEnableWorldsCallback = enableWorlds.onChange([this] { setWorldsEnabled(enableWorlds); });
 
+    // Streamed maps are loaded one at a time, to keep the UI responsive
+    mStreamingTimer.setSingleShot(true);
+    mStreamingTimer.setInterval(0);
+    connect(&mStreamingTimer, &QTimer::timeout, this, &MapScene::loadNextStreamedMap);
+
 #ifdef QT_DEBUG
     mDebugDrawItem = new DebugDrawItem;
     addItem(mDebugDrawItem);
@@ -104,8 +121,6 @@ void MapScene::setMapDocument(MapDocument *mapDocument)
                 this, &MapScene::changeEvent);
         connect(mMapDocument, &MapDocument::tilesetTilePositioningChanged,
                 this, [this] { update(); });
-        connect(mMapDocument, &MapDocument::tileImageSourceChanged,
-                this, [this] { update(); });
         connect(mMapDocument, &MapDocument::tilesetReplaced,
                 this, &MapScene::tilesetReplaced);
     }
@@ -141,6 +156,15 @@ void MapScene::setPainterScale(qreal painterScale)
 {
     for (auto mapItem : std::as_const(mMapItems))
         mapItem->mapDocument()->renderer()->setPainterScale(painterScale);
+
+    if (mPainterScale != painterScale) {
+        mPainterScale = painterScale;
+
+        if (!mStreamedMaps.isEmpty())
+            updateStreaming();
+
+        emit painterScaleChanged();
+    }
 }
 
 void MapScene::setSuppressMouseMoveEvents(bool suppress)
@@ -207,8 +231,15 @@ void MapScene::setViewRect(const QRectF &rect)
 
     mViewRect = rect;
 
-    if (mParallaxEnabled)
-        emit parallaxParametersChanged();
+    if (mParallaxEnabled) {
+        emit parallaxParametersChanged();   // also updates the object items
+    } else {
+        for (MapItem *mapItem : std::as_const(mMapItems))
+            mapItem->viewRectChanged();
+    }
+
+    if (!mStreamedMaps.isEmpty())
+        updateStreaming();
 }
 
 void MapScene::setOverrideBackgroundColor(QColor backgroundColor)
@@ -283,9 +314,15 @@ void MapScene::refreshScene()
 {
     QHash<MapDocument*, MapItem*> mapItems;
 
+    mStreamedMaps.clear();
+    mPendingMaps.clear();
+    mFailedMaps.clear();
+    mStreamingTimer.stop();
+
     if (!mMapDocument) {
         mMapItems.swap(mapItems);
         qDeleteAll(mapItems);
+        updatePlaceholders();
         updateSceneRect();
         return;
     }
@@ -297,15 +334,31 @@ void MapScene::refreshScene()
         const auto world = worldDocument->world();
         const QPoint currentMapPosition = world->mapRect(currentMapFile).topLeft();
         auto const contextMaps = world->contextMaps(currentMapFile);
+        auto documentManager = DocumentManager::instance();
+
+        QHash<QString, MapDocument*> loadedMaps;
+        for (MapItem *mapItem : std::as_const(mMapItems))
+            loadedMaps.insert(mapItem->mapDocument()->fileName(), mapItem->mapDocument());
+
+        mWorldOrigin = currentMapPosition;
 
         for (const WorldMapEntry &mapEntry : contextMaps) {
             MapDocumentPtr mapDocument;
 
+            // Other maps are only shown right away when they are already
+            // loaded. The rest is loaded by updateStreaming when in view.
             if (mapEntry.fileName == currentMapFile) {
                 mapDocument = mMapDocument->sharedFromThis();
             } else {
-                auto doc = DocumentManager::instance()->loadDocument(mapEntry.fileName);
-                mapDocument = doc.objectCast<MapDocument>();
+                mStreamedMaps.append(mapEntry);
+
+                if (MapDocument *loaded = loadedMaps.value(mapEntry.fileName)) {
+                    mapDocument = loaded->sharedFromThis();
+                } else {
+                    const int index = documentManager->findDocument(mapEntry.fileName);
+                    if (index != -1)
+                        mapDocument = documentManager->documents().at(index).objectCast<MapDocument>();
+                }
             }
 
             if (mapDocument) {
@@ -330,12 +383,196 @@ void MapScene::refreshScene()
     for (MapItem *mapItem : std::as_const(mMapItems))
         mapItem->updateLayerPositions();
 
+    updatePlaceholders();
+    updateStreaming();
     updateBackgroundColor();
     updateSceneRect();
 
     emit sceneRefreshed();
 }
 
+/**
+ * Determines which of the other maps of the current world should be loaded,
+ * based on their distance to the view. Maps that are far away are unloaded
+ * again, also when more maps than allowed are loaded.
+ *
+ * When zoomed out far enough for a stored thumbnail to show a map in full
+ * detail, the map is not loaded at all.
+ */
+void MapScene::updateStreaming()
+{
+    mPendingMaps.clear();
+
+    if (mStreamedMaps.isEmpty() || !mWorldsEnabled) {
+        mStreamingTimer.stop();
+        return;
+    }
+
+    const qreal distance = qMax(0, worldStreamingDistance.get());
+    const int maximumMaps = qMax(1, worldStreamingMaximumMaps.get());
+    const QRectF loadRect = mViewRect.adjusted(-distance, -distance, distance, distance);
+    const QRectF keepRect = loadRect.adjusted(-distance, -distance, distance, distance);
+    const QPointF viewCenter = mViewRect.center();
+
+    QHash<QString, MapItem*> mapItemsByFileName;
+    for (MapItem *mapItem : std::as_const(mMapItems))
+        if (mapItem->mapDocument() != mMapDocument)
+            mapItemsByFileName.insert(mapItem->mapDocument()->fileName(), mapItem);
+
+    struct Candidate
+    {
+        qreal distance;
+        const WorldMapEntry *entry;
+        MapItem *mapItem;
+    };
+
+    QVector<Candidate> loaded;
+    QVector<Candidate> pending;
+
+    for (const WorldMapEntry &entry : std::as_const(mStreamedMaps)) {
+        const QRectF rect = streamedMapRect(entry);
+        const Candidate candidate { QLineF(viewCenter, rect.center()).length(),
+                                    &entry,
+                                    mapItemsByFileName.value(entry.fileName) };
+
+        if (candidate.mapItem) {
+            if (rect.intersects(keepRect))
+                loaded.append(candidate);
+            else
+                unloadStreamedMap(candidate.mapItem);
+        } else if (rect.intersects(loadRect) && !mFailedMaps.contains(entry.fileName)) {
+            const qreal viewSize = qMax(rect.width(), rect.height()) * mPainterScale;
+            if (viewSize > MapThumbnailCache::largestSize ||
+                    !MapThumbnailCache::contains(entry.fileName)) {
+                pending.append(candidate);
+            }
+        }
+    }
+
+    auto byDistance = [] (const Candidate &a, const Candidate &b) {
+        return a.distance < b.distance;
+    };
+
+    // Unload the furthest maps that are not close to the view when there
+    // are too many
+    if (loaded.size() > maximumMaps) {
+        std::sort(loaded.begin(), loaded.end(), byDistance);
+        while (loaded.size() > maximumMaps) {
+            const Candidate &furthest = loaded.last();
+            if (streamedMapRect(*furthest.entry).intersects(loadRect))
+                break;
+            unloadStreamedMap(furthest.mapItem);
+            loaded.removeLast();
+        }
+    }
+
+    std::sort(pending.begin(), pending.end(), byDistance);
+
+    const int budget = qMax(0, maximumMaps - int(loaded.size()));
+    for (int i = 0; i < pending.size() && i < budget; ++i)
+        mPendingMaps.append(*pending.at(i).entry);
+
+    if (mPendingMaps.isEmpty())
+        mStreamingTimer.stop();
+    else if (!mStreamingTimer.isActive())
+        mStreamingTimer.start();
+}
+
+/**
+ * Loads the closest of the pending maps. Tileset images are loaded in the
+ * background, and each map is loaded in a separate iteration of the event
+ * loop.
+ */
+void MapScene::loadNextStreamedMap()
+{
+    if (mPendingMaps.isEmpty())
+        return;
+
+    const WorldMapEntry entry = mPendingMaps.takeFirst();
+
+    auto tilesetManager = TilesetManager::instance();
+    const bool asyncImageLoading = tilesetManager->asyncImageLoading();
+    tilesetManager->setAsyncImageLoading(true);
+
+    auto document = DocumentManager::instance()->loadDocument(entry.fileName);
+    auto mapDocument = document.objectCast<MapDocument>();
+
+    tilesetManager->setAsyncImageLoading(asyncImageLoading);
+
+    if (mapDocument && !mMapItems.contains(mapDocument.data())) {
+        auto mapItem = takeOrCreateMapItem(mapDocument, MapItem::ReadOnly);
+        mapItem->setPos(streamedMapRect(entry).topLeft());
+        mapItem->setVisible(mWorldsEnabled);
+        mapItem->updateLayerPositions();
+        mMapItems.insert(mapDocument.data(), mapItem);
+
+        delete mPlaceholderItems.take(entry.fileName);
+        updateSceneRect();
+    } else if (!mapDocument) {
+        mFailedMaps.insert(entry.fileName);
+    }
+
+    if (!mPendingMaps.isEmpty())
+        mStreamingTimer.start();
+}
+
+/**
+ * Removes the given map item, replacing it with a placeholder showing a
+ * thumbnail of the map.
+ */
+void MapScene::unloadStreamedMap(MapItem *mapItem)
+{
+    MapDocument *mapDocument = mapItem->mapDocument();
+    const QString fileName = mapDocument->fileName();
+
+    MapPlaceholderItem::storeThumbnail(fileName, mapDocument->map());
+
+    mMapItems.remove(mapDocument);
+    delete mapItem;
+
+    updatePlaceholders();
+}
+
+/**
+ * Makes sure there is a placeholder for each map of the current world that
+ * is not loaded, and no others.
+ */
+void MapScene::updatePlaceholders()
+{
+    QSet<QString> loadedMaps;
+    for (MapItem *mapItem : std::as_const(mMapItems))
+        loadedMaps.insert(mapItem->mapDocument()->fileName());
+
+    QHash<QString, MapPlaceholderItem*> placeholderItems;
+
+    for (const WorldMapEntry &entry : std::as_const(mStreamedMaps)) {
+        if (loadedMaps.contains(entry.fileName))
+            continue;
+
+        MapPlaceholderItem *item = mPlaceholderItems.take(entry.fileName);
+        if (!item || item->boundingRect().size() != QSizeF(entry.rect.size())) {
+            delete item;
+            item = new MapPlaceholderItem(entry.fileName, entry.rect.size());
+            addItem(item);
+        }
+
+        item->setPos(streamedMapRect(entry).topLeft());
+        item->setVisible(mWorldsEnabled);
+        placeholderItems.insert(entry.fileName, item);
+    }
+
+    mPlaceholderItems.swap(placeholderItems);
+    qDeleteAll(placeholderItems);
+}
+
+/**
+ * Returns the rect of the given world map entry in scene coordinates.
+ */
+QRectF MapScene::streamedMapRect(const WorldMapEntry &entry) const
+{
+    return entry.rect.translated(-mWorldOrigin);
+}
+
 void MapScene::updateDefaultBackgroundColor()
 {
     const QColor darkColor = QGuiApplication::palette().dark().color();
@@ -370,6 +607,9 @@ void MapScene::updateSceneRect()
     for (MapItem *mapItem : std::as_const(mMapItems))
         sceneRect |= mapItem->boundingRect().translated(mapItem->pos());
 
+    for (MapPlaceholderItem *item : std::as_const(mPlaceholderItems))
+        sceneRect |= item->boundingRect().translated(item->pos());
+
     setSceneRect(sceneRect);
 }
 
@@ -382,6 +622,10 @@ void MapScene::setWorldsEnabled(bool enabled)
 
     for (MapItem *mapItem : std::as_const(mMapItems))
         mapItem->setVisible(mWorldsEnabled || mapItem->mapDocument() == mMapDocument);
+    for (MapPlaceholderItem *item : std::as_const(mPlaceholderItems))
+        item->setVisible(mWorldsEnabled);
+
+    updateStreaming();
 }
 
 MapItem *MapScene::takeOrCreateMapItem(const MapDocumentPtr &mapDocument, MapItem::DisplayMode displayMode)
@@ -441,6 +685,16 @@ void MapScene::repaintTileset(Tileset *tileset)
     }
 }
 
+/**
+ * Repaints only the places showing animated tiles from the given \a tileset,
+ * rather than the whole scene, since this happens for each animation frame.
+ */
+void MapScene::repaintAnimatedTiles(Tileset *tileset)
+{
+    for (MapItem *mapItem : std::as_const(mMapItems))
+        mapItem->repaintAnimatedTiles(tileset);
+}
+
 void MapScene::tilesetReplaced(int index, Tileset *tileset, Tileset *oldTileset)
 {
     Q_UNUSED(index)
@@ -479,6 +733,36 @@ bool MapScene::event(QEvent *event)
     return QGraphicsScene::event(event);
 }
 
+/**
+ * Shows the tool tip of objects that are painted by their object group item
+ * rather than by a MapObjectItem.
+ */
+void MapScene::helpEvent(QGraphicsSceneHelpEvent *event)
+{
+    MapItem *mapItem = this->mapItem(mMapDocument);
+    QGraphicsView *view = views().isEmpty() ? nullptr : views().first();
+
+    if (mapItem && view) {
+        const QTransform viewTransform = view->transform();
+        const auto itemsAtPos = items(event->scenePos(), Qt::IntersectsItemShape,
+                                      Qt::DescendingOrder, viewTransform);
+        const bool itemHasToolTip = std::any_of(itemsAtPos.begin(), itemsAtPos.end(),
+                                                [] (QGraphicsItem *item) { return !item->toolTip().isEmpty(); });
+
+        if (!itemHasToolTip) {
+            const auto objects = mapItem->objectPicker()->objectsAt(event->scenePos(), viewTransform);
+            if (!objects.isEmpty()) {
+                const QString text = MapObjectItem::objectToolTip(objects.first());
+                QToolTip::showText(event->screenPos(), text, event->widget());
+                event->setAccepted(!text.isEmpty());
+                return;
+            }
+        }
+    }
+
+    QGraphicsScene::helpEvent(event);
+}
+
 void MapScene::keyPressEvent(QKeyEvent *event)
 {
     if (mSelectedTool)
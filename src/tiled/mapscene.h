@@ -26,10 +26,13 @@
 #include "mapdocument.h"
 #include "mapitem.h"
 #include "session.h"
+#include "world.h"
 
 #include <QColor>
 #include <QGraphicsScene>
 #include <QHash>
+#include <QSet>
+#include <QTimer>
 
 namespace Tiled {
 
@@ -45,6 +48,7 @@ class DebugDrawItem;
 class LayerItem;
 class MapDocument;
 class MapObjectItem;
+class MapPlaceholderItem;
 class MapScene;
 class ObjectGroupItem;
 
@@ -85,6 +89,8 @@ public:
     QPointF parallaxOffset(const Layer &layer) const;
 
     static SessionOption<bool> enableWorlds;
+    static SessionOption<int> worldStreamingDistance;
+    static SessionOption<int> worldStreamingMaximumMaps;
 
 signals:
     void mapDocumentChanged(MapDocument *mapDocument);
@@ -93,9 +99,11 @@ signals:
 
     void fontChanged();
     void parallaxParametersChanged();
+    void painterScaleChanged();
 
 protected:
     bool event(QEvent *event) override;
+    void helpEvent(QGraphicsSceneHelpEvent *event) override;
 
     void keyPressEvent(QKeyEvent *event) override;
     void mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent) override;
@@ -113,6 +121,7 @@ private:
 
     void changeEvent(const ChangeEvent &change);
     void repaintTileset(Tileset *tileset);
+    void repaintAnimatedTiles(Tileset *tileset);
 
     void tilesetReplaced(int index, Tileset *tileset, Tileset *oldTileset);
 
@@ -122,6 +131,12 @@ private:
 
     void setWorldsEnabled(bool enabled);
 
+    void updateStreaming();
+    void loadNextStreamedMap();
+    void unloadStreamedMap(MapItem *mapItem);
+    void updatePlaceholders();
+    QRectF streamedMapRect(const WorldMapEntry &entry) const;
+
     MapItem *takeOrCreateMapItem(const MapDocumentPtr &mapDocument,
                                  MapItem::DisplayMode displayMode);
 
@@ -131,6 +146,16 @@ private:
 
     MapDocument *mMapDocument = nullptr;
     QHash<MapDocument*, MapItem*> mMapItems;
+
+    // The other maps of the current world, which are loaded on demand
+    QVector<WorldMapEntry> mStreamedMaps;
+    QVector<WorldMapEntry> mPendingMaps;
+    QSet<QString> mFailedMaps;
+    QHash<QString, MapPlaceholderItem*> mPlaceholderItems;
+    QPoint mWorldOrigin;
+    QTimer mStreamingTimer;
+    qreal mPainterScale = 1.0;
+
     AbstractTool *mSelectedTool = nullptr;
     DebugDrawItem *mDebugDrawItem = nullptr;
     bool mUnderMouse = false;
@@ -28,14 +28,18 @@
 #include "objectgroup.h"
 #include "pannableviewhelper.h"
 #include "preferences.h"
+#include "textlayoutcache.h"
 #include "tileanimationdriver.h"
+#include "tintedimagecache.h"
 #include "utils.h"
 #include "zoomable.h"
 
 #include <QApplication>
 #include <QCursor>
+#include <QElapsedTimer>
 #include <QGesture>
 #include <QGestureEvent>
+#include <QPainter>
 #include <QPinchGesture>
 #include <QScrollBar>
 #include <QWheelEvent>
@@ -60,6 +64,7 @@ using namespace Tiled;
 
 Preference<bool> MapView::ourAutoScrollingEnabled { "Interface/AutoScrolling", false };
 Preference<bool> MapView::ourSmoothScrollingEnabled { "Interface/SmoothScrolling", true };
+Preference<bool> MapView::ourFrameStatisticsEnabled { "Interface/ShowFrameStatistics", false };
 
 MapView::MapView(QWidget *parent)
     : QGraphicsView(parent)
@@ -477,7 +482,106 @@ void MapView::paintEvent(QPaintEvent *event)
     if (auto scene = mapScene())
         scene->setPainterScale(scale());
 
+    if (!ourFrameStatisticsEnabled) {
+        if (!mFrameStatisticsRect.isNull()) {
+            viewport()->update(mFrameStatisticsRect);
+            mFrameStatisticsRect = QRect();
+        }
+
+        QGraphicsView::paintEvent(event);
+        return;
+    }
+
+    // Repainting just the statistics doesn't count as a new frame
+    const bool statisticsOnly = !mFrameStatisticsRepaintRect.isNull() &&
+            mFrameStatisticsRepaintRect.contains(event->rect());
+    mFrameStatisticsRepaintRect = QRect();
+
+    const FrameStatistics before = currentFrameStatistics();
+    QElapsedTimer timer;
+    timer.start();
+
     QGraphicsView::paintEvent(event);
+
+    if (!statisticsOnly) {
+        const FrameStatistics after = currentFrameStatistics();
+
+        mFrameStatistics.frameTime = timer.nsecsElapsed();
+        mFrameStatistics.drawCalls = after.drawCalls - before.drawCalls;
+        mFrameStatistics.fragments = after.fragments - before.fragments;
+        mFrameStatistics.exposedRect = event->rect();
+        mFrameStatistics.exposedRectCount = event->region().rectCount();
+        mFrameStatistics.tintedImageCacheHits = after.tintedImageCacheHits - before.tintedImageCacheHits;
+        mFrameStatistics.tintedImageCacheMisses = after.tintedImageCacheMisses - before.tintedImageCacheMisses;
+        mFrameStatistics.textLayoutCacheHits = after.textLayoutCacheHits - before.textLayoutCacheHits;
+        mFrameStatistics.textLayoutCacheMisses = after.textLayoutCacheMisses - before.textLayoutCacheMisses;
+    }
+
+    paintFrameStatistics(event->region());
+}
+
+MapView::FrameStatistics MapView::currentFrameStatistics()
+{
+    const auto cellRenderer = CellRenderer::statistics();
+    const auto tintedImageCache = TintedImageCache::statistics();
+    const auto textLayoutCache = TextLayoutCache::statistics();
+
+    FrameStatistics statistics;
+    statistics.drawCalls = cellRenderer.drawCalls;
+    statistics.fragments = cellRenderer.fragments;
+    statistics.tintedImageCacheHits = tintedImageCache.hits;
+    statistics.tintedImageCacheMisses = tintedImageCache.misses;
+    statistics.textLayoutCacheHits = textLayoutCache.hits;
+    statistics.textLayoutCacheMisses = textLayoutCache.misses;
+    return statistics;
+}
+
+/**
+ * Paints the statistics of the last frame in the top-left corner of the
+ * viewport. When the statistics were only partially repainted, another
+ * repaint of just the statistics is scheduled.
+ */
+void MapView::paintFrameStatistics(const QRegion &exposedRegion)
+{
+    const auto hitRate = [] (qint64 hits, qint64 misses) {
+        const qint64 lookups = hits + misses;
+        if (lookups == 0)
+            return tr("no lookups");
+        return tr("%1% of %2 lookups").arg(qRound(100.0 * hits / lookups)).arg(lookups);
+    };
+
+    const FrameStatistics &s = mFrameStatistics;
+    const QStringList lines {
+        tr("Frame time: %1 ms").arg(s.frameTime / 1000000.0, 0, 'f', 2),
+        tr("Tiles drawn: %1 in %2 draw calls").arg(s.fragments).arg(s.drawCalls),
+        tr("Exposed: %1 x %2 in %3 rects").arg(s.exposedRect.width()).arg(s.exposedRect.height()).arg(s.exposedRectCount),
+        tr("Tinted image cache: %1").arg(hitRate(s.tintedImageCacheHits, s.tintedImageCacheMisses)),
+        tr("Text layout cache: %1").arg(hitRate(s.textLayoutCacheHits, s.textLayoutCacheMisses)),
+    };
+
+    QPainter painter(viewport());
+
+    const QFontMetrics fontMetrics = painter.fontMetrics();
+    const int margin = Utils::dpiScaled(4);
+    int textWidth = 0;
+    for (const QString &line : lines)
+        textWidth = qMax(textWidth, fontMetrics.horizontalAdvance(line));
+
+    const QRect textRect(margin * 3, margin * 3,
+                         textWidth, fontMetrics.height() * lines.size());
+    const QRect rect = textRect.adjusted(-margin, -margin, margin, margin);
+
+    painter.fillRect(rect, QColor(0, 0, 0, 160));
+    painter.setPen(Qt::white);
+    painter.drawText(textRect, Qt::AlignLeft | Qt::AlignTop, lines.join(QLatin1Char('\n')));
+
+    const QRect dirtyRect = rect | mFrameStatisticsRect;
+    mFrameStatisticsRect = rect;
+
+    if (!(QRegion(dirtyRect) - exposedRegion).isEmpty()) {
+        mFrameStatisticsRepaintRect = dirtyRect;
+        viewport()->update(dirtyRect);
+    }
 }
 
 void MapView::hideEvent(QHideEvent *event)
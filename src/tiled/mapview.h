@@ -53,6 +53,7 @@ class MapView : public QGraphicsView
 public:
     static Preference<bool> ourAutoScrollingEnabled;
     static Preference<bool> ourSmoothScrollingEnabled;
+    static Preference<bool> ourFrameStatisticsEnabled;
 
     MapView(QWidget *parent = nullptr);
     ~MapView() override;
@@ -129,6 +130,22 @@ private:
 
     void setMapDocument(MapDocument *mapDocument);
 
+    struct FrameStatistics
+    {
+        qint64 frameTime = 0;       // in nanoseconds
+        qint64 drawCalls = 0;
+        qint64 fragments = 0;
+        QRect exposedRect;
+        int exposedRectCount = 0;
+        qint64 tintedImageCacheHits = 0;
+        qint64 tintedImageCacheMisses = 0;
+        qint64 textLayoutCacheHits = 0;
+        qint64 textLayoutCacheMisses = 0;
+    };
+
+    static FrameStatistics currentFrameStatistics();
+    void paintFrameStatistics(const QRegion &exposedRegion);
+
     MapDocument *mMapDocument = nullptr;
     QPoint mLastMousePos;
     QPoint mScrollStartPos;
@@ -143,6 +160,10 @@ private:
 
     PanDirections mPanDirections;
     TileAnimationDriver *mPanningDriver;
+
+    FrameStatistics mFrameStatistics;
+    QRect mFrameStatisticsRect;
+    QRect mFrameStatisticsRepaintRect;
 };
 
 /**
@@ -21,12 +21,14 @@
 
 #include "minimap.h"
 
+#include "changeevents.h"
 #include "documentmanager.h"
 #include "map.h"
 #include "mapdocument.h"
 #include "maprenderer.h"
 #include "mapscene.h"
 #include "mapview.h"
+#include "tilelayer.h"
 #include "utils.h"
 #include "zoomable.h"
 
@@ -34,6 +36,9 @@
 #include <QResizeEvent>
 #include <QScrollBar>
 #include <QUndoStack>
+#include <QtConcurrent>
+
+#include <memory>
 
 using namespace Tiled;
 
@@ -73,9 +78,37 @@ void MiniMap::setMapDocument(MapDocument *map)
 
     mMapDocument = map;
 
+    // Forget about the old map and any render still running for it
+    mMapImage = QImage();
+    mMapRect = QRect();
+    mDirtyRegion = QRegion();
+    mFullRedraw = true;
+    mRenderWatcher = nullptr;
+    updateImageRect();
+
     if (mMapDocument) {
         connect(mMapDocument->undoStack(), &QUndoStack::indexChanged,
                 this, &MiniMap::scheduleMapImageUpdate);
+        connect(mMapDocument, &MapDocument::regionChanged,
+                this, &MiniMap::regionChanged);
+        connect(mMapDocument, &Document::changed,
+                this, &MiniMap::documentChanged);
+        connect(mMapDocument, &MapDocument::mapResized,
+                this, &MiniMap::invalidateMapImage);
+        connect(mMapDocument, &MapDocument::layerAdded,
+                this, &MiniMap::invalidateMapImage);
+        connect(mMapDocument, &MapDocument::layerRemoved,
+                this, &MiniMap::invalidateMapImage);
+        connect(mMapDocument, &MapDocument::tileLayerChanged,
+                this, &MiniMap::invalidateMapImage);
+        connect(mMapDocument, &MapDocument::tilesetReplaced,
+                this, &MiniMap::invalidateMapImage);
+        connect(mMapDocument, &MapDocument::tilesetTilePositioningChanged,
+                this, &MiniMap::invalidateMapImage);
+        connect(mMapDocument, &MapDocument::tileImageSourceChanged,
+                this, &MiniMap::invalidateMapImage);
+        connect(mMapDocument, &MapDocument::objectsIndexChanged,
+                this, &MiniMap::invalidateMapImage);
 
         if (MapView *mapView = dm->viewForDocument(mMapDocument))
             connect(mapView, &MapView::viewRectChanged, this, [this] { update(); });
@@ -94,6 +127,57 @@ void MiniMap::scheduleMapImageUpdate()
     mMapImageUpdateTimer.start(100);
 }
 
+/**
+ * Schedules a redraw of the whole minimap image, for changes that can't be
+ * narrowed down to a region of the map.
+ */
+void MiniMap::invalidateMapImage()
+{
+    mFullRedraw = true;
+    scheduleMapImageUpdate();
+}
+
+/**
+ * Remembers the pixels covered by the changed \a region of \a tileLayer, so
+ * that only that part of the minimap image needs to be repainted.
+ */
+void MiniMap::regionChanged(const QRegion &region, TileLayer *tileLayer)
+{
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const QMargins margins = mMapDocument->map()->drawMargins();
+    const QPoint offset = tileLayer->totalOffset().toPoint();
+
+    for (const QRect &r : region) {
+        const QRect boundingRect = renderer->boundingRect(r).marginsAdded(margins);
+        mDirtyRegion += boundingRect.translated(offset).adjusted(-1, -1, 1, 1);
+    }
+
+    scheduleMapImageUpdate();
+}
+
+void MiniMap::documentChanged(const ChangeEvent &change)
+{
+    switch (change.type) {
+    case ChangeEvent::DocumentAboutToReload:
+    case ChangeEvent::MapObjectAboutToBeAdded:
+    case ChangeEvent::MapObjectAboutToBeRemoved:
+    case ChangeEvent::MapObjectsAboutToBeRemoved:
+    case ChangeEvent::TilesAboutToBeRemoved:
+    case ChangeEvent::WangSetAboutToBeAdded:
+    case ChangeEvent::WangSetAboutToBeRemoved:
+    case ChangeEvent::WangSetAdded:
+    case ChangeEvent::WangSetRemoved:
+    case ChangeEvent::WangSetChanged:
+    case ChangeEvent::WangColorAboutToBeRemoved:
+    case ChangeEvent::WangColorChanged:
+        // These don't affect the rendered map
+        break;
+    default:
+        invalidateMapImage();
+        break;
+    }
+}
+
 void MiniMap::paintEvent(QPaintEvent *pe)
 {
     QFrame::paintEvent(pe);
@@ -162,35 +246,98 @@ void MiniMap::renderMapToImage()
         return;
     }
 
+    // A background render is in progress, it will schedule another update
+    // when it finishes and changes were made in the meantime.
+    if (mRenderWatcher)
+        return;
+
     MiniMapRenderer miniMapRenderer(mMapDocument->map());
 
-    const QSize mapSize = miniMapRenderer.mapSize();
-    if (mapSize.isEmpty()) {
+    const QRect mapRect = miniMapRenderer.mapBoundingRect(mRenderFlags);
+    if (mapRect.isEmpty()) {
         mMapImage = QImage();
         return;
     }
 
     // Determine the largest possible scale
     const QSize viewSize = contentsRect().size() * devicePixelRatioF();
-    qreal scale = qMin(static_cast<qreal>(viewSize.width()) / mapSize.width(),
-                       static_cast<qreal>(viewSize.height()) / mapSize.height());
+    qreal scale = qMin(static_cast<qreal>(viewSize.width()) / mapRect.width(),
+                       static_cast<qreal>(viewSize.height()) / mapRect.height());
 
-    QSize imageSize = mapSize * scale;
+    QSize imageSize = mapRect.size() * scale;
 
     // Improve the quality if the image size is small
     if (imageSize.width() < 512 && imageSize.height() < 512)
         imageSize *= 2;
 
-    // Allocate a new image when the size changed
-    if (mMapImage.size() != imageSize) {
-        mMapImage = QImage(imageSize, QImage::Format_ARGB32_Premultiplied);
-        updateImageRect();
-    }
-
     if (imageSize.isEmpty())
         return;
 
-    miniMapRenderer.renderToImage(mMapImage, mRenderFlags);
+    // A new image is rendered in the background, so that opening or resizing
+    // a huge map doesn't block the UI
+    if (mMapImage.size() != imageSize || mMapRect != mapRect) {
+        startRenderInBackground(mapRect, imageSize);
+        return;
+    }
+
+    // When there is no known region, the change came from somewhere we're
+    // not tracking, so everything is repainted.
+    if (mFullRedraw || mDirtyRegion.isEmpty())
+        miniMapRenderer.renderToImage(mMapImage, mRenderFlags);
+    else
+        miniMapRenderer.renderToImage(mMapImage, mRenderFlags, mDirtyRegion);
+
+    mDirtyRegion = QRegion();
+    mFullRedraw = false;
+}
+
+void MiniMap::startRenderInBackground(const QRect &mapRect, QSize imageSize)
+{
+    // The map is cloned so that it can be changed while the render is in
+    // progress. This is relatively cheap since tile data is shared.
+    std::shared_ptr<Map> map = mMapDocument->map()->clone();
+    const auto renderFlags = mRenderFlags;
+
+    // Chunk stores can only be used from this thread, so the paged out chunks
+    // of the layers that will be rendered are paged in up front.
+    if (renderFlags.testFlag(MiniMapRenderer::DrawTileLayers) && map->hasPagedOutChunks()) {
+        const bool visibleLayersOnly = renderFlags.testFlag(MiniMapRenderer::IgnoreInvisibleLayer);
+
+        LayerIterator it(map.get(), Layer::TileLayerType);
+        while (auto tileLayer = static_cast<TileLayer*>(it.next()))
+            if (!(visibleLayersOnly && tileLayer->isHidden()))
+                tileLayer->pageInAll();
+    }
+
+    auto watcher = new QFutureWatcher<QImage>(this);
+    mRenderWatcher = watcher;
+
+    mMapRect = mapRect;
+    mDirtyRegion = QRegion();
+    mFullRedraw = false;
+
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher] {
+        watcher->deleteLater();
+
+        // Ignore the result when the map document changed meanwhile
+        if (mRenderWatcher != watcher)
+            return;
+
+        mRenderWatcher = nullptr;
+        mMapImage = watcher->result();
+        updateImageRect();
+
+        // Apply any changes made since the map was cloned
+        if (mFullRedraw || !mDirtyRegion.isEmpty())
+            scheduleMapImageUpdate();
+
+        update();
+    });
+
+    watcher->setFuture(QtConcurrent::run([map, imageSize, renderFlags] {
+        const MiniMapRenderer miniMapRenderer(map.get());
+        return miniMapRenderer.render(imageSize, renderFlags);
+    }));
 }
 
 void MiniMap::centerViewOnLocalPixel(const QPointF &centerPos, int delta)
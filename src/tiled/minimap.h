@@ -24,12 +24,16 @@
 #include "minimaprenderer.h"
 
 #include <QFrame>
+#include <QFutureWatcher>
 #include <QImage>
+#include <QRegion>
 #include <QTimer>
 
 namespace Tiled {
 
+class ChangeEvent;
 class MapDocument;
+class TileLayer;
 
 class MiniMap : public QFrame
 {
@@ -41,7 +45,7 @@ public:
     void setMapDocument(MapDocument *);
 
     MiniMapRenderer::RenderFlags renderFlags() const { return mRenderFlags; }
-    void setRenderFlags(MiniMapRenderer::RenderFlags flags) { mRenderFlags = flags; }
+    void setRenderFlags(MiniMapRenderer::RenderFlags flags) { mRenderFlags = flags; mFullRedraw = true; }
 
     QSize sizeHint() const override;
 
@@ -59,10 +63,17 @@ protected:
 
 private:
     void redrawTimeout();
+    void invalidateMapImage();
+    void regionChanged(const QRegion &region, TileLayer *tileLayer);
+    void documentChanged(const ChangeEvent &change);
 
     MapDocument *mMapDocument;
     QImage mMapImage;
     QRect mImageRect;
+    QRect mMapRect;                 /**< Map bounding rect shown by mMapImage. */
+    QRegion mDirtyRegion;           /**< Changed map pixels since last render. */
+    bool mFullRedraw = true;
+    QFutureWatcher<QImage> *mRenderWatcher = nullptr;
     QTimer mMapImageUpdateTimer;
     bool mDragging;
     QPoint mDragOffset;
@@ -74,6 +85,7 @@ private:
     QPointF mapToScene(QPointF p) const;
     void updateImageRect();
     void renderMapToImage();
+    void startRenderInBackground(const QRect &mapRect, QSize imageSize);
     void centerViewOnLocalPixel(const QPointF &centerPos, int delta = 0);
 };
 
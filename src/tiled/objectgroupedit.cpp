@@ -0,0 +1,185 @@
+/*
+ * objectgroupedit.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "objectgroupedit.h"
+
+#include "changemapobject.h"
+#include "changeproperties.h"
+#include "editableasset.h"
+#include "editablemapobject.h"
+#include "editableobjectgroup.h"
+#include "scriptmanager.h"
+
+#include <QCoreApplication>
+#include <QMap>
+
+namespace Tiled {
+
+ObjectGroupEdit::ObjectGroupEdit(EditableObjectGroup *objectGroup, QObject *parent)
+    : QObject(parent)
+    , mTargetLayer(objectGroup)
+{
+    mTargetLayer->mActiveEdits.append(this);
+}
+
+ObjectGroupEdit::~ObjectGroupEdit()
+{
+    mTargetLayer->mActiveEdits.removeOne(this);
+}
+
+void ObjectGroupEdit::setName(EditableMapObject *object, const QString &name)
+{
+    setMapObjectProperty(object, MapObject::NameProperty, name);
+}
+
+void ObjectGroupEdit::setClassName(EditableMapObject *object, const QString &className)
+{
+    if (auto changes = changesFor(object))
+        changes->className = className;
+}
+
+void ObjectGroupEdit::setPos(EditableMapObject *object, QPointF pos)
+{
+    setMapObjectProperty(object, MapObject::PositionProperty, pos);
+}
+
+void ObjectGroupEdit::setSize(EditableMapObject *object, QSizeF size)
+{
+    setMapObjectProperty(object, MapObject::SizeProperty, size);
+}
+
+void ObjectGroupEdit::setRotation(EditableMapObject *object, qreal rotation)
+{
+    setMapObjectProperty(object, MapObject::RotationProperty, rotation);
+}
+
+void ObjectGroupEdit::setVisible(EditableMapObject *object, bool visible)
+{
+    setMapObjectProperty(object, MapObject::VisibleProperty, visible);
+}
+
+/**
+ * Applies all collected changes to the target layer as a single undo
+ * command, which emits one change event for all changed objects.
+ *
+ * Changes to objects that have since been removed from the layer are
+ * dropped.
+ */
+void ObjectGroupEdit::apply()
+{
+    const ObjectGroup *objectGroup = mTargetLayer->objectGroup();
+
+    QVector<MapObjectChange> changes;
+    QMap<QString, QList<Object*>> classChanges;
+    int objectCount = 0;
+
+    for (const ObjectChanges &objectChanges : std::as_const(mChanges)) {
+        if (!objectChanges.object)
+            continue;
+
+        MapObject *mapObject = objectChanges.object->mapObject();
+        if (mapObject->objectGroup() != objectGroup)
+            continue;
+
+        for (const auto &property : objectChanges.properties)
+            changes.append(MapObjectChange { mapObject, property.first, property.second });
+
+        if (objectChanges.className)
+            classChanges[*objectChanges.className].append(mapObject);
+
+        ++objectCount;
+    }
+
+    mChanges.clear();
+    mChangesIndex.clear();
+
+    if (objectCount == 0)
+        return;
+
+    if (auto doc = mTargetLayer->document()) {
+        auto command = new QUndoCommand(QCoreApplication::translate("Undo Commands",
+                                                                    "Change %n Object(s)",
+                                                                    nullptr,
+                                                                    objectCount));
+        if (!changes.isEmpty())
+            new ChangeMapObjects(doc, changes, command);
+
+        for (auto it = classChanges.cbegin(); it != classChanges.cend(); ++it)
+            new ChangeClassName(doc, it.value(), it.key(), command);
+
+        mTargetLayer->asset()->push(command);
+    } else if (!mTargetLayer->checkReadOnly()) {
+        for (const MapObjectChange &change : std::as_const(changes)) {
+            change.object->setMapObjectProperty(change.property, change.value);
+            change.object->setPropertyChanged(change.property);
+        }
+
+        for (auto it = classChanges.cbegin(); it != classChanges.cend(); ++it)
+            for (Object *object : it.value())
+                object->setClassName(it.key());
+    }
+}
+
+ObjectGroupEdit::ObjectChanges *ObjectGroupEdit::changesFor(EditableMapObject *object)
+{
+    if (!object) {
+        ScriptManager::instance().throwNullArgError(0);
+        return nullptr;
+    }
+
+    if (object->mapObject()->objectGroup() != mTargetLayer->objectGroup()) {
+        ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Object not found"));
+        return nullptr;
+    }
+
+    auto it = mChangesIndex.find(object);
+    if (it != mChangesIndex.end()) {
+        ObjectChanges &changes = mChanges[it.value()];
+        if (changes.object != object)   // a deleted object's address got reused
+            changes = ObjectChanges { object, {}, {} };
+        return &changes;
+    }
+
+    mChangesIndex.insert(object, mChanges.size());
+    mChanges.append(ObjectChanges { object, {}, {} });
+    return &mChanges.last();
+}
+
+void ObjectGroupEdit::setMapObjectProperty(EditableMapObject *object,
+                                           MapObject::Property property,
+                                           const QVariant &value)
+{
+    auto changes = changesFor(object);
+    if (!changes)
+        return;
+
+    for (auto &change : changes->properties) {
+        if (change.first == property) {
+            change.second = value;
+            return;
+        }
+    }
+
+    changes->properties.append({ property, value });
+}
+
+} // namespace Tiled
+
+#include "moc_objectgroupedit.cpp"
@@ -0,0 +1,87 @@
+/*
+ * objectgroupedit.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mapobject.h"
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+
+#include <optional>
+
+namespace Tiled {
+
+class EditableMapObject;
+class EditableObjectGroup;
+
+/**
+ * Collects changes to the objects of an object layer, which are then applied
+ * together as a single undo command.
+ */
+class ObjectGroupEdit : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(Tiled::EditableObjectGroup *target READ target CONSTANT)
+
+public:
+    explicit ObjectGroupEdit(EditableObjectGroup *objectGroup,
+                             QObject *parent = nullptr);
+    ~ObjectGroupEdit() override;
+
+    EditableObjectGroup *target() const;
+
+public slots:
+    void setName(Tiled::EditableMapObject *object, const QString &name);
+    void setClassName(Tiled::EditableMapObject *object, const QString &className);
+    void setPos(Tiled::EditableMapObject *object, QPointF pos);
+    void setSize(Tiled::EditableMapObject *object, QSizeF size);
+    void setRotation(Tiled::EditableMapObject *object, qreal rotation);
+    void setVisible(Tiled::EditableMapObject *object, bool visible);
+    void apply();
+
+private:
+    struct ObjectChanges
+    {
+        QPointer<EditableMapObject> object;
+        QVector<QPair<MapObject::Property, QVariant>> properties;
+        std::optional<QString> className;
+    };
+
+    ObjectChanges *changesFor(EditableMapObject *object);
+    void setMapObjectProperty(EditableMapObject *object,
+                              MapObject::Property property,
+                              const QVariant &value);
+
+    EditableObjectGroup *mTargetLayer;
+    QVector<ObjectChanges> mChanges;
+    QHash<EditableMapObject*, int> mChangesIndex;
+};
+
+
+inline EditableObjectGroup *ObjectGroupEdit::target() const
+{
+    return mTargetLayer;
+}
+
+} // namespace Tiled
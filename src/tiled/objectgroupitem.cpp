@@ -20,6 +20,18 @@
 
 #include "objectgroupitem.h"
 
+#include "map.h"
+#include "mapdocument.h"
+#include "mapobject.h"
+#include "maprenderer.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+#include <algorithm>
+#include <climits>
+#include <optional>
+
 using namespace Tiled;
 
 ObjectGroupItem::ObjectGroupItem(ObjectGroup *objectGroup, QGraphicsItem *parent)
@@ -29,13 +41,153 @@ ObjectGroupItem::ObjectGroupItem(ObjectGroup *objectGroup, QGraphicsItem *parent
     setFlag(QGraphicsItem::ItemHasNoContents);
 }
 
+/**
+ * Sets which objects get a map object item. When not all objects have one,
+ * this item paints the objects that have no item.
+ *
+ * This is used for huge object groups, for which creating an item for each
+ * object would take too long and use too much memory, and for groups of
+ * tile objects, which can be drawn much faster in batches.
+ */
+void ObjectGroupItem::setObjectItems(ObjectItems objectItems, MapDocument *mapDocument)
+{
+    prepareGeometryChange();
+
+    mObjectItems = objectItems;
+    mMapDocument = objectItems == AllObjectItems ? nullptr : mapDocument;
+    mRealizedArea = QRectF();
+
+    if (objectItems == AllObjectItems)
+        mObjectsWithItem.clear();
+
+    setFlag(QGraphicsItem::ItemHasNoContents, !mMapDocument);
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, mMapDocument);
+    update();
+}
+
+void ObjectGroupItem::setHasObjectItem(MapObject *object, bool hasItem)
+{
+    if (hasItem)
+        mObjectsWithItem.insert(object);
+    else
+        mObjectsWithItem.remove(object);
+}
+
+/**
+ * Schedules a repaint of the area covered by the given \a object, when it
+ * is painted by this item.
+ */
+void ObjectGroupItem::updateObject(const MapObject *object)
+{
+    if (!mMapDocument)
+        return;
+
+    // Point objects ignore the zoom level, so we don't know their size
+    if (object->shape() == MapObject::Point) {
+        update();
+        return;
+    }
+
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const QPointF pixelPos = renderer->pixelToScreenCoords(object->position());
+
+    QTransform transform;
+    transform.translate(pixelPos.x(), pixelPos.y());
+    transform.rotate(object->rotation());
+    transform.translate(-pixelPos.x(), -pixelPos.y());
+
+    update(transform.mapRect(renderer->cachedBoundingRect(object)));
+}
+
 QRectF ObjectGroupItem::boundingRect() const
 {
-    return QRectF();
+    if (!mMapDocument)
+        return QRectF();
+
+    // Objects can be anywhere, so we can't easily know our bounds
+    return QRectF(INT_MIN / 512, INT_MIN / 512,
+                  INT_MAX / 256, INT_MAX / 256);
 }
 
-void ObjectGroupItem::paint(QPainter *,
-                            const QStyleOptionGraphicsItem *,
+void ObjectGroupItem::paint(QPainter *painter,
+                            const QStyleOptionGraphicsItem *option,
                             QWidget *)
 {
+    if (!mMapDocument)
+        return;
+
+    MapRenderer *renderer = mMapDocument->renderer();
+    const ObjectGroup *objectGroup = this->objectGroup();
+
+    // Extend the exposed area a little, to catch objects that are rotated or
+    // rendered larger than their bounds
+    const QSize tileSize = mMapDocument->map()->tileSize();
+    const QMargins drawMargins = mMapDocument->map()->drawMargins();
+    const int margin = 2 * std::max(tileSize.width(), tileSize.height()) +
+            std::max({ drawMargins.left(), drawMargins.top(),
+                       drawMargins.right(), drawMargins.bottom() });
+
+    const QRectF exposed = option->exposedRect.adjusted(-margin, -margin, margin, margin);
+    const QRectF pixelRect = renderer->screenToPixelCoords(QPolygonF(exposed)).boundingRect();
+
+    QList<MapObject*> objects = objectGroup->objectsIntersecting(pixelRect);
+
+    objects.erase(std::remove_if(objects.begin(), objects.end(), [this] (MapObject *object) {
+        return !object->isVisible() || mObjectsWithItem.contains(object);
+    }), objects.end());
+
+    objectGroup->sortByDrawOrder(objects);
+
+    const qreal painterScale = renderer->painterScale();
+    const bool showOutlines = renderer->testFlag(ShowTileObjectOutlines);
+    const Map *map = mMapDocument->map();
+
+    // Consecutive tile objects are drawn in batches
+    std::optional<CellRenderer> cellRenderer;
+
+    painter->save();
+
+    for (MapObject *object : std::as_const(objects)) {
+        if (object->isTileObject() && object->rotation() == 0.0 && !showOutlines) {
+            if (!cellRenderer) {
+                painter->setCompositionMode(objectGroup->compositionMode());
+                cellRenderer.emplace(painter, renderer, objectGroup->effectiveTintColor());
+            }
+
+            // Matches the positioning in MapRenderer::drawMapObject
+            QRectF bounds { renderer->pixelToScreenCoords(object->position()), object->size() };
+            bounds.translate(-alignmentOffset(bounds, object->alignment(map)));
+
+            cellRenderer->render(object->cell(), bounds.topLeft(), bounds.size());
+            continue;
+        }
+
+        cellRenderer.reset();   // flushes the batch
+
+        // Painting should match MapObjectItem::paint
+        const QPointF pixelPos = renderer->pixelToScreenCoords(object->position());
+
+        painter->save();
+        painter->setCompositionMode(object->isTileObject() ? objectGroup->compositionMode()
+                                                           : QPainter::CompositionMode_SourceOver);
+
+        if (object->shape() == MapObject::Point) {
+            // Point objects ignore the zoom level
+            const QPointF devicePos = painter->transform().map(pixelPos);
+            painter->setTransform(QTransform::fromTranslate(devicePos.x(), devicePos.y()));
+            renderer->setPainterScale(1);
+        } else {
+            painter->translate(pixelPos);
+        }
+
+        painter->rotate(object->rotation());
+        painter->translate(-pixelPos);
+        renderer->drawMapObject(painter, object, object->effectiveColors());
+        painter->restore();
+
+        renderer->setPainterScale(painterScale);
+    }
+
+    cellRenderer.reset();
+    painter->restore();
 }
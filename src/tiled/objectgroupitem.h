@@ -24,26 +24,61 @@
 
 #include "objectgroup.h"
 
+#include <QSet>
+
 namespace Tiled {
 
+class MapDocument;
+
 /**
- * A graphics item representing an object group in a QGraphicsView. It only
- * serves to group together the objects belonging to the same object group.
+ * A graphics item representing an object group in a QGraphicsView. It
+ * usually only serves to group together the objects belonging to the same
+ * object group.
+ *
+ * For huge object groups and for groups of tile objects the item can be
+ * virtualized, in which case map object items are only created for some of
+ * the objects (see MapItem::updateObjectItems). The item then paints all
+ * other objects itself, batching the drawing of tile objects.
  *
  * @see MapObjectItem
  */
 class ObjectGroupItem : public LayerItem
 {
 public:
+    enum ObjectItems {
+        AllObjectItems,         // each object has a map object item
+        NearbyObjectItems,      // objects near the view and selected objects have one
+        SelectedObjectItems     // only selected objects have one
+    };
+
     ObjectGroupItem(ObjectGroup *objectGroup, QGraphicsItem *parent = nullptr);
 
     ObjectGroup *objectGroup() const;
 
+    ObjectItems objectItems() const;
+    void setObjectItems(ObjectItems objectItems, MapDocument *mapDocument);
+    bool isVirtualized() const;
+
+    bool hasObjectItem(MapObject *object) const;
+    void setHasObjectItem(MapObject *object, bool hasItem);
+    const QSet<MapObject*> &objectsWithItem() const;
+
+    void updateObject(const MapObject *object);
+
+    QRectF realizedArea() const;
+    void setRealizedArea(const QRectF &area);
+
     // QGraphicsItem
     QRectF boundingRect() const override;
     void paint(QPainter *painter,
                const QStyleOptionGraphicsItem *option,
                QWidget *widget = nullptr) override;
+
+private:
+    MapDocument *mMapDocument = nullptr;
+    ObjectItems mObjectItems = AllObjectItems;
+    QSet<MapObject*> mObjectsWithItem;
+    QRectF mRealizedArea;
 };
 
 inline ObjectGroup *ObjectGroupItem::objectGroup() const
@@ -51,4 +86,38 @@ inline ObjectGroup *ObjectGroupItem::objectGroup() const
     return static_cast<ObjectGroup*>(layer());
 }
 
+inline ObjectGroupItem::ObjectItems ObjectGroupItem::objectItems() const
+{
+    return mObjectItems;
+}
+
+inline bool ObjectGroupItem::isVirtualized() const
+{
+    return mObjectItems != AllObjectItems;
+}
+
+inline bool ObjectGroupItem::hasObjectItem(MapObject *object) const
+{
+    return mObjectsWithItem.contains(object);
+}
+
+inline const QSet<MapObject*> &ObjectGroupItem::objectsWithItem() const
+{
+    return mObjectsWithItem;
+}
+
+/**
+ * Returns the area (in item coordinates) for which the map object items
+ * were last updated.
+ */
+inline QRectF ObjectGroupItem::realizedArea() const
+{
+    return mRealizedArea;
+}
+
+inline void ObjectGroupItem::setRealizedArea(const QRectF &area)
+{
+    mRealizedArea = area;
+}
+
 } // namespace Tiled
@@ -0,0 +1,172 @@
+/*
+ * objectpicker.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "objectpicker.h"
+
+#include "layer.h"
+#include "map.h"
+#include "mapdocument.h"
+#include "mapitem.h"
+#include "mapobject.h"
+#include "mapobjectitem.h"
+#include "maprenderer.h"
+#include "mapscene.h"
+#include "objectgroup.h"
+#include "utils.h"
+
+#include <QTransform>
+
+#include <algorithm>
+
+namespace Tiled {
+
+ObjectPicker::ObjectPicker(MapDocument *mapDocument, MapItem *mapItem)
+    : mMapDocument(mapDocument)
+    , mMapItem(mapItem)
+{
+}
+
+/**
+ * Returns the objects whose shape contains the given \a scenePos, top-most
+ * object first.
+ */
+QList<MapObject*> ObjectPicker::objectsAt(const QPointF &scenePos,
+                                          const QTransform &viewTransform) const
+{
+    return pick(QRectF(scenePos, QSizeF()), viewTransform,
+                [] (const QPainterPath &shape, const QRectF &rect) {
+        return shape.contains(rect.topLeft());
+    });
+}
+
+/**
+ * Returns the objects within the given \a sceneRect, top-most object first.
+ * The \a mode has the same meaning as for QGraphicsScene::items.
+ */
+QList<MapObject*> ObjectPicker::objectsIn(const QRectF &sceneRect,
+                                          Qt::ItemSelectionMode mode,
+                                          const QTransform &viewTransform) const
+{
+    return pick(sceneRect, viewTransform,
+                [mode] (const QPainterPath &shape, const QRectF &rect) {
+        switch (mode) {
+        case Qt::ContainsItemShape:
+        case Qt::ContainsItemBoundingRect:
+            return rect.contains(shape.boundingRect());
+        case Qt::IntersectsItemShape:
+            return shape.intersects(rect) || rect.contains(shape.boundingRect());
+        case Qt::IntersectsItemBoundingRect:
+            break;
+        }
+        return rect.intersects(shape.boundingRect());
+    });
+}
+
+template<typename Test>
+QList<MapObject*> ObjectPicker::pick(const QRectF &sceneRect,
+                                     const QTransform &viewTransform,
+                                     Test test) const
+{
+    QList<MapObject*> result;
+
+    const auto mapScene = static_cast<MapScene*>(mMapItem->scene());
+    if (!mapScene)
+        return result;
+
+    const qreal viewScale = viewTransform.m11();
+
+    LayerIterator iterator(mMapDocument->map(), Layer::ObjectGroupType);
+    iterator.toBack();
+    while (auto objectGroup = static_cast<ObjectGroup*>(iterator.previous())) {
+        if (objectGroup->isHidden() || !objectGroup->isUnlocked())
+            continue;
+
+        const QPointF layerPos = mMapItem->pos() + mapScene->absolutePositionForLayer(*objectGroup);
+        const QRectF layerRect = sceneRect.translated(-layerPos);
+
+        const auto objects = candidates(objectGroup, layerRect, viewScale);
+        for (MapObject *object : objects)
+            if (test(shapeInLayer(object, viewScale), layerRect))
+                result.append(object);
+    }
+
+    return result;
+}
+
+/**
+ * Returns the visible objects of the given \a objectGroup that may be found
+ * within \a layerRect, in the order in which they are hit (top-most first).
+ */
+QList<MapObject*> ObjectPicker::candidates(const ObjectGroup *objectGroup,
+                                           const QRectF &layerRect,
+                                           qreal viewScale) const
+{
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const Map *map = mMapDocument->map();
+
+    // The bounds of the objects don't include rotation, tile offsets and the
+    // size of point objects, so some margin is needed
+    const QSize tileSize = map->tileSize();
+    const QMargins drawMargins = map->drawMargins();
+    const qreal margin = 2 * std::max(tileSize.width(), tileSize.height()) +
+            std::max({ drawMargins.left(), drawMargins.top(),
+                       drawMargins.right(), drawMargins.bottom() }) +
+            Utils::dpiScaled(32) / viewScale;
+
+    const QRectF screenRect = layerRect.adjusted(-margin, -margin, margin, margin);
+    const QRectF pixelRect = renderer->screenToPixelCoords(QPolygonF(screenRect)).boundingRect();
+
+    QList<MapObject*> objects = objectGroup->objectsIntersecting(pixelRect);
+
+    objects.erase(std::remove_if(objects.begin(), objects.end(), [] (MapObject *object) {
+        return !object->isVisible();
+    }), objects.end());
+
+    objectGroup->sortByDrawOrder(objects);
+    std::reverse(objects.begin(), objects.end());
+
+    return objects;
+}
+
+/**
+ * Returns the shape of the \a object in layer coordinates, matching
+ * MapObjectItem::shape.
+ */
+QPainterPath ObjectPicker::shapeInLayer(const MapObject *object, qreal viewScale) const
+{
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const QPointF pixelPos = renderer->pixelToScreenCoords(object->position());
+
+    QTransform transform;
+    transform.translate(pixelPos.x(), pixelPos.y());
+    if (object->shape() == MapObject::Point)     // ignores the zoom level
+        transform.scale(1 / viewScale, 1 / viewScale);
+    transform.rotate(object->rotation());
+
+    QPainterPath path;
+    if (object->isTileObject() && MapObjectItem::preciseTileObjectSelection)
+        path = object->tileObjectShape(mMapDocument->map());
+    else
+        path = renderer->cachedInteractionShape(object).translated(-pixelPos);
+
+    return transform.map(path);
+}
+
+} // namespace Tiled
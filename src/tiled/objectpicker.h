@@ -0,0 +1,75 @@
+/*
+ * objectpicker.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QList>
+#include <QPainterPath>
+
+class QTransform;
+
+namespace Tiled {
+
+class MapDocument;
+class MapObject;
+class ObjectGroup;
+
+class MapItem;
+
+/**
+ * Finds the map objects at a certain position or within a certain area of
+ * the scene, without going through QGraphicsScene::items.
+ *
+ * Candidates are taken from the spatial index of each object group and only
+ * those are tested against their exact shape. The shapes are cached by the
+ * MapRenderer.
+ *
+ * Objects are returned from top to bottom and only for visible and unlocked
+ * object layers.
+ */
+class ObjectPicker
+{
+public:
+    ObjectPicker(MapDocument *mapDocument, MapItem *mapItem);
+
+    QList<MapObject*> objectsAt(const QPointF &scenePos,
+                                const QTransform &viewTransform) const;
+
+    QList<MapObject*> objectsIn(const QRectF &sceneRect,
+                                Qt::ItemSelectionMode mode,
+                                const QTransform &viewTransform) const;
+
+private:
+    template<typename Test>
+    QList<MapObject*> pick(const QRectF &sceneRect,
+                           const QTransform &viewTransform,
+                           Test test) const;
+
+    QList<MapObject*> candidates(const ObjectGroup *objectGroup,
+                                 const QRectF &layerRect,
+                                 qreal viewScale) const;
+
+    QPainterPath shapeInLayer(const MapObject *object, qreal viewScale) const;
+
+    MapDocument *mMapDocument;
+    MapItem *mMapItem;
+};
+
+} // namespace Tiled
@@ -88,6 +88,9 @@ ObjectsTreeView::ObjectsTreeView(MapDocument *mapDocument, QWidget *parent)
 {
     mProxyModel->setFilterCaseSensitivity(Qt::CaseInsensitive);
     mProxyModel->setFilterKeyColumn(-1);
+    // Fetch all objects, since they need to be searchable
+    mapDocument->mapObjectModel()->fetchAllObjects();
+
     mProxyModel->setSourceModel(mapDocument->mapObjectModel());
     setModel(mProxyModel);
     expandAll();
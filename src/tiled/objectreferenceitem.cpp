@@ -33,6 +33,7 @@
 #include <QPen>
 #include <QVector2D>
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 
@@ -147,6 +148,31 @@ void ObjectReferenceItem::updateColor()
     }
 }
 
+/**
+ * Hides this item when its line does not pass through \a cullRect, which
+ * is given in parent coordinates. A null rect disables culling.
+ */
+void ObjectReferenceItem::updateVisibility(const QRectF &cullRect)
+{
+    bool visible = true;
+
+    if (!cullRect.isNull() && !cullRect.contains(mSourcePos) && !cullRect.contains(mTargetPos)) {
+        const QLineF line(mSourcePos, mTargetPos);
+        const std::array<QLineF, 4> edges = {
+            QLineF(cullRect.topLeft(), cullRect.topRight()),
+            QLineF(cullRect.topRight(), cullRect.bottomRight()),
+            QLineF(cullRect.bottomRight(), cullRect.bottomLeft()),
+            QLineF(cullRect.bottomLeft(), cullRect.topLeft()),
+        };
+
+        visible = std::any_of(edges.begin(), edges.end(), [&] (const QLineF &edge) {
+            return line.intersects(edge, nullptr) == QLineF::BoundedIntersection;
+        });
+    }
+
+    setVisible(visible);
+}
+
 void ObjectReferenceItem::updateArrowRotation()
 {
     qreal dx = mTargetPos.x() - mSourcePos.x();
@@ -49,6 +49,7 @@ public:
     void syncWithSourceObject(const MapRenderer &renderer);
     void syncWithTargetObject(const MapRenderer &renderer);
     void updateColor();
+    void updateVisibility(const QRectF &cullRect);
 
     QRectF boundingRect() const override;
     void paint(QPainter *painter,
@@ -36,6 +36,7 @@
 #include "utils.h"
 
 #include <QApplication>
+#include <QSet>
 #include <QTimerEvent>
 #include <QVector2D>
 
@@ -334,10 +335,13 @@ void ObjectSelectionItem::updateItemPositions()
     for (MapObjectOutline *outline : std::as_const(mObjectOutlines))
         outline->syncWithMapObject(renderer);
 
+    const QRectF cullRect = referenceCullRect();
+
     for (const auto &items : std::as_const(mReferencesBySourceObject)) {
         for (ObjectReferenceItem *item : items) {
             item->syncWithSourceObject(renderer);
             item->syncWithTargetObject(renderer);
+            item->updateVisibility(cullRect);
         }
     }
 
@@ -345,6 +349,19 @@ void ObjectSelectionItem::updateItemPositions()
         mHoveredMapObjectItem->syncWithMapObject();
 }
 
+/**
+ * Hides the object references that are outside of the view. Should be called
+ * when the visible area of the scene changes.
+ */
+void ObjectSelectionItem::updateReferenceVisibility()
+{
+    const QRectF cullRect = referenceCullRect();
+
+    for (const auto &items : std::as_const(mReferencesBySourceObject))
+        for (ObjectReferenceItem *item : items)
+            item->updateVisibility(cullRect);
+}
+
 const MapRenderer &ObjectSelectionItem::mapRenderer() const
 {
     return *mMapDocument->renderer();
@@ -382,6 +399,8 @@ void ObjectSelectionItem::changeEvent(const ChangeEvent &event)
         mObjectHoverItems.clear();
         mReferencesBySourceObject.clear();
         mReferencesByTargetObject.clear();
+        mReferencedIdsBySourceObject.clear();
+        mSourceObjectsByReferencedId.clear();
         break;
 
     case ChangeEvent::DocumentReloaded:
@@ -546,8 +565,7 @@ void ObjectSelectionItem::layerAdded(Layer *layer)
         }
     }
 
-    if (Preferences::instance()->showObjectReferences())
-        addRemoveObjectReferences();
+    addRemoveObjectReferences(newObjects);
 }
 
 void ObjectSelectionItem::layerAboutToBeRemoved(GroupLayer *parentLayer, int index)
@@ -596,6 +614,7 @@ void ObjectSelectionItem::layerChanged(const LayerChangeEvent &event)
 void ObjectSelectionItem::syncOverlayItems(const QList<MapObject*> &objects)
 {
     const MapRenderer &renderer = *mMapDocument->renderer();
+    const QRectF cullRect = referenceCullRect();
 
     for (MapObject *object : objects) {
         if (MapObjectOutline *outlineItem = mObjectOutlines.value(object))
@@ -608,12 +627,16 @@ void ObjectSelectionItem::syncOverlayItems(const QList<MapObject*> &objects)
             labelItem->syncWithMapObject(renderer);
 
         const auto sourceItems = mReferencesBySourceObject.value(object);
-        for (auto item : sourceItems)
+        for (auto item : sourceItems) {
             item->syncWithSourceObject(renderer);
+            item->updateVisibility(cullRect);
+        }
 
         const auto targetItems = mReferencesByTargetObject.value(object);
-        for (auto item : targetItems)
+        for (auto item : targetItems) {
             item->syncWithTargetObject(renderer);
+            item->updateVisibility(cullRect);
+        }
 
         if (mHoveredMapObjectItem && mHoveredMapObjectItem->mapObject() == object)
             mHoveredMapObjectItem->syncWithMapObject();
@@ -657,12 +680,7 @@ void ObjectSelectionItem::objectsAdded(const QList<MapObject *> &objects)
         }
     }
 
-    // This could be a tad slow if there are many objects, but currently it is
-    // necessary because the list of added objects could include target
-    // objects. To optimize this, we could instantiate reference items also if
-    // the target was not found and only try to repair those here.
-    if (Preferences::instance()->showObjectReferences())
-        addRemoveObjectReferences();
+    addRemoveObjectReferences(objects);
 }
 
 void ObjectSelectionItem::objectsAboutToBeRemoved(const QList<MapObject *> &objects)
@@ -672,6 +690,10 @@ void ObjectSelectionItem::objectsAboutToBeRemoved(const QList<MapObject *> &obje
             delete mObjectLabels.take(object);
 
     for (MapObject *object : objects) {
+        // References to this object remain in the reference graph, so they
+        // can be restored when an object with this ID is added again
+        setReferencedIds(object, {});
+
         // Remove any references originating from this object
         auto it = mReferencesBySourceObject.find(object);
         if (it != mReferencesBySourceObject.end()) {
@@ -892,6 +914,10 @@ void ObjectSelectionItem::addRemoveObjectReferences()
     QHash<MapObject*, QList<ObjectReferenceItem*>> referencesBySourceObject;
     QHash<MapObject*, QList<ObjectReferenceItem*>> referencesByTargetObject;
     const MapRenderer &renderer = *mMapDocument->renderer();
+    const QRectF cullRect = referenceCullRect();
+
+    mReferencedIdsBySourceObject.clear();
+    mSourceObjectsByReferencedId.clear();
 
     auto ensureReferenceItem = [&] (MapObject *sourceObject, ObjectRef ref) {
         MapObject *targetObject = DisplayObjectRef(ref, mMapDocument).object();
@@ -920,6 +946,7 @@ void ObjectSelectionItem::addRemoveObjectReferences()
         auto item = new ObjectReferenceItem(sourceObject, targetObject, this);
         item->syncWithSourceObject(renderer);
         item->syncWithTargetObject(renderer);
+        item->updateVisibility(cullRect);
         items.append(item);
         referencesByTargetObject[targetObject].append(item);
     };
@@ -931,9 +958,12 @@ void ObjectSelectionItem::addRemoveObjectReferences()
                 continue;
 
             for (MapObject *object : objectGroup->objects()) {
+                QVector<int> referencedIds;
                 forEachObjectReference(object->properties(), [&] (ObjectRef ref) {
+                    referencedIds.append(ref.id);
                     ensureReferenceItem(object, ref);
                 });
+                setReferencedIds(object, std::move(referencedIds));
             }
         }
     }
@@ -953,6 +983,7 @@ void ObjectSelectionItem::addRemoveObjectReferences(MapObject *object)
     items.swap(existingItems);
 
     const MapRenderer &renderer = *mMapDocument->renderer();
+    const QRectF cullRect = referenceCullRect();
 
     auto ensureReferenceItem = [&] (MapObject *sourceObject, ObjectRef ref) {
         MapObject *targetObject = DisplayObjectRef(ref, mMapDocument).object();
@@ -974,16 +1005,22 @@ void ObjectSelectionItem::addRemoveObjectReferences(MapObject *object)
         auto item = new ObjectReferenceItem(sourceObject, targetObject, this);
         item->syncWithSourceObject(renderer);
         item->syncWithTargetObject(renderer);
+        item->updateVisibility(cullRect);
         items.append(item);
         mReferencesByTargetObject[targetObject].append(item);
     };
 
+    QVector<int> referencedIds;
+
     if (Preferences::instance()->showObjectReferences()) {
         forEachObjectReference(object->properties(), [&] (ObjectRef ref) {
+            referencedIds.append(ref.id);
             ensureReferenceItem(object, ref);
         });
     }
 
+    setReferencedIds(object, std::move(referencedIds));
+
     // Delete remaining existing items, also removing them from mReferencesByTargetObject
     for (ObjectReferenceItem *item : std::as_const(existingItems)) {
         auto &itemsByTarget = mReferencesByTargetObject[item->targetObject()];
@@ -995,6 +1032,70 @@ void ObjectSelectionItem::addRemoveObjectReferences(MapObject *object)
     }
 }
 
+/**
+ * Updates the references of the given newly added \a objects, as well as
+ * the references to them from other objects, using the reference graph.
+ */
+void ObjectSelectionItem::addRemoveObjectReferences(const QList<MapObject *> &objects)
+{
+    if (!Preferences::instance()->showObjectReferences())
+        return;
+
+    QList<MapObject*> sourceObjects;
+    QSet<MapObject*> seen;
+
+    auto addSourceObject = [&] (MapObject *object) {
+        if (!seen.contains(object)) {
+            seen.insert(object);
+            sourceObjects.append(object);
+        }
+    };
+
+    for (MapObject *object : objects) {
+        if (!object->objectGroup()->isHidden())
+            addSourceObject(object);
+
+        const auto it_end = mSourceObjectsByReferencedId.cend();
+        for (auto it = mSourceObjectsByReferencedId.constFind(object->id());
+             it != it_end && it.key() == object->id(); ++it) {
+            addSourceObject(it.value());
+        }
+    }
+
+    for (MapObject *object : std::as_const(sourceObjects))
+        addRemoveObjectReferences(object);
+}
+
+void ObjectSelectionItem::setReferencedIds(MapObject *sourceObject, QVector<int> ids)
+{
+    const QVector<int> previousIds = mReferencedIdsBySourceObject.take(sourceObject);
+    for (int id : previousIds)
+        mSourceObjectsByReferencedId.remove(id, sourceObject);
+
+    if (ids.isEmpty())
+        return;
+
+    for (int id : std::as_const(ids))
+        mSourceObjectsByReferencedId.insert(id, sourceObject);
+
+    mReferencedIdsBySourceObject.insert(sourceObject, std::move(ids));
+}
+
+/**
+ * Returns the area in which object references are visible, in item
+ * coordinates. Returns a null rect when the visible area is not known.
+ */
+QRectF ObjectSelectionItem::referenceCullRect() const
+{
+    auto mapScene = static_cast<MapScene*>(scene());
+    if (!mapScene || mapScene->viewRect().isEmpty())
+        return QRectF();
+
+    // Leave room for the arrow heads, which ignore the view transformation
+    const qreal margin = Utils::dpiScaled(16) / mapRenderer().painterScale();
+    return mapRectFromScene(mapScene->viewRect()).adjusted(-margin, -margin, margin, margin);
+}
+
 } // namespace Tiled
 
 #include "moc_objectselectionitem.cpp"
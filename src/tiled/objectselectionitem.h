@@ -24,6 +24,7 @@
 
 #include <QGraphicsObject>
 #include <QHash>
+#include <QVector>
 
 #include <memory>
 
@@ -79,6 +80,7 @@ public:
     ~ObjectSelectionItem() override;
 
     void updateItemPositions();
+    void updateReferenceVisibility();
 
     const MapRenderer &mapRenderer() const;
 
@@ -118,6 +120,9 @@ private:
     void addRemoveObjectHoverItems();
     void addRemoveObjectReferences();
     void addRemoveObjectReferences(MapObject *object);
+    void addRemoveObjectReferences(const QList<MapObject*> &objects);
+    void setReferencedIds(MapObject *sourceObject, QVector<int> ids);
+    QRectF referenceCullRect() const;
 
     MapDocument *mMapDocument;
     QHash<MapObject*, MapObjectLabel*> mObjectLabels;
@@ -125,6 +130,10 @@ private:
     QHash<MapObject*, MapObjectOutline*> mObjectHoverItems;
     QHash<MapObject*, QList<ObjectReferenceItem*>> mReferencesBySourceObject;
     QHash<MapObject*, QList<ObjectReferenceItem*>> mReferencesByTargetObject;
+
+    // The object IDs referenced by each object, including unresolved ones
+    QHash<MapObject*, QVector<int>> mReferencedIdsBySourceObject;
+    QMultiHash<int, MapObject*> mSourceObjectsByReferencedId;
     std::unique_ptr<MapObjectItem> mHoveredMapObjectItem;
 };
 
@@ -33,6 +33,7 @@
 #include "maprenderer.h"
 #include "mapscene.h"
 #include "objectgroup.h"
+#include "objectpicker.h"
 #include "preferences.h"
 #include "raiselowerhelper.h"
 #include "selectionrectangle.h"
@@ -924,7 +925,7 @@ static QRectF objectBounds(const MapObject *object,
             return transform.map(screenPolygon).boundingRect();
         }
         case MapObject::Point: {
-            return transform.mapRect(renderer->shape(object).boundingRect());
+            return transform.mapRect(renderer->cachedShape(object).boundingRect());
         }
         case MapObject::Polygon:
         case MapObject::Polyline: {
@@ -935,7 +936,7 @@ static QRectF objectBounds(const MapObject *object,
             return transform.map(screenPolygon).boundingRect();
         }
         case MapObject::Text: {
-            const auto rect = renderer->boundingRect(object);
+            const auto rect = renderer->cachedBoundingRect(object);
             return transform.mapRect(rect);
         }
         }
@@ -1173,18 +1174,12 @@ QList<MapObject*> ObjectSelectionTool::objectsAboutToBeSelected(const QPointF &p
                                                                : Qt::ContainsItemShape;
     }
 
+    const ObjectPicker *picker = objectPicker();
+    if (!picker)
+        return selectedObjects;
+
     const QTransform viewTransform = mapScene()->views().first()->transform();
-    const QList<QGraphicsItem *> items = mapScene()->items(rect,
-                                                           selectionMode,
-                                                           Qt::DescendingOrder,
-                                                           viewTransform);
-    for (QGraphicsItem *item : items) {
-        if (!item->isEnabled())
-            continue;
-        MapObjectItem *mapObjectItem = qgraphicsitem_cast<MapObjectItem*>(item);
-        if (mapObjectItem && mapObjectItem->mapObject()->objectGroup()->isUnlocked())
-            selectedObjects.append(mapObjectItem->mapObject());
-    }
+    selectedObjects = picker->objectsIn(rect, selectionMode, viewTransform);
 
     filterMapObjects(selectedObjects);
 
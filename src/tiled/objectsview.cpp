@@ -35,6 +35,7 @@
 #include <QMenu>
 #include <QPainter>
 #include <QScopedValueRollback>
+#include <QScrollBar>
 
 namespace Tiled {
 
@@ -62,6 +63,11 @@ ObjectsView::ObjectsView(QWidget *parent)
 
     connect(this, &QAbstractItemView::activated, this, &ObjectsView::onActivated);
 
+    connect(verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &ObjectsView::fetchMoreVisibleObjects);
+    connect(verticalScrollBar(), &QScrollBar::rangeChanged,
+            this, &ObjectsView::fetchMoreVisibleObjects);
+
     connect(header(), &QHeaderView::sectionResized,
             this, &ObjectsView::onSectionResized);
 
@@ -101,10 +107,12 @@ void ObjectsView::setMapDocument(MapDocument *mapDoc)
         restoreVisibleColumns();
         synchronizeSelectedItems();
 
-        if (mActiveFilter)
+        if (mActiveFilter) {
+            mapObjectModel()->fetchAllObjects();
             expandAll();
-        else
+        } else {
             restoreExpandedLayers();
+        }
     } else {
         mProxyModel->setSourceModel(nullptr);
     }
@@ -127,6 +135,7 @@ QModelIndex ObjectsView::layerViewIndex(Layer *layer) const
 
 void ObjectsView::ensureVisible(MapObject *mapObject)
 {
+    mapObjectModel()->fetchObject(mapObject);
     scrollTo(mProxyModel->mapFromSource(mapObjectModel()->index(mapObject)));
 }
 
@@ -138,6 +147,10 @@ void ObjectsView::setFilter(const QString &filter)
     if (!hadActiveFilter && activeFilter)
         saveExpandedLayers();
 
+    // Objects not fetched yet could not be found by the filter
+    if (activeFilter && mMapDocument)
+        mapObjectModel()->fetchAllObjects();
+
     mProxyModel->setFilterFixedString(filter);
     mActiveFilter = activeFilter;
 
@@ -369,6 +382,7 @@ void ObjectsView::synchronizeSelectedItems()
     QItemSelection itemSelection;
 
     for (MapObject *o : mMapDocument->selectedObjects()) {
+        mapObjectModel()->fetchObject(o);
         QModelIndex index = mProxyModel->mapFromSource(mapObjectModel()->index(o));
         itemSelection.select(index, index);
     }
@@ -384,6 +398,7 @@ void ObjectsView::expandToSelectedObjects()
 {
     const QList<MapObject *> &selectedObjects = mMapDocument->selectedObjects();
     for (auto object : selectedObjects) {
+        mapObjectModel()->fetchObject(object);
         auto index = mProxyModel->mapFromSource(mapObjectModel()->index(object));
 
         // Make sure all parents are expanded
@@ -393,6 +408,32 @@ void ObjectsView::expandToSelectedObjects()
     }
 }
 
+/**
+ * Fetches more objects when the last fetched object of an object layer
+ * becomes visible. QTreeView only does this by itself for top-level items.
+ */
+void ObjectsView::fetchMoreVisibleObjects()
+{
+    if (!mMapDocument)
+        return;
+
+    const QRect rect = viewport()->rect();
+
+    for (QModelIndex index = indexAt(rect.topLeft());
+         index.isValid() && visualRect(index).top() <= rect.bottom();
+         index = indexBelow(index)) {
+
+        const QModelIndex parent = index.parent();
+        if (!parent.isValid() || !mProxyModel->canFetchMore(parent))
+            continue;
+
+        if (index.row() == mProxyModel->rowCount(parent) - 1) {
+            mProxyModel->fetchMore(parent);
+            break;  // the view will update its scroll range and call us again
+        }
+    }
+}
+
 void ObjectsView::updateRow(MapObject *object)
 {
     if (!object || !object->objectGroup())
@@ -78,6 +78,7 @@ private:
     void restoreVisibleColumns();
     void synchronizeSelectedItems();
     void expandToSelectedObjects();
+    void fetchMoreVisibleObjects();
 
     void updateRow(MapObject *object);
 
@@ -27,8 +27,12 @@
 
 #include <QCoreApplication>
 
+#include <algorithm>
+
 using namespace Tiled;
 
+static qint64 sTotalMemoryUsage;
+
 PaintTileLayer::PaintTileLayer(MapDocument *mapDocument, QUndoCommand *parent)
     : QUndoCommand(parent)
     , mMapDocument(mapDocument)
@@ -51,6 +55,7 @@ PaintTileLayer::PaintTileLayer(MapDocument *mapDocument,
 
 PaintTileLayer::~PaintTileLayer()
 {
+    sTotalMemoryUsage -= mMemoryUsage;
 }
 
 void PaintTileLayer::paint(TileLayer *target,
@@ -59,16 +64,16 @@ void PaintTileLayer::paint(TileLayer *target,
                            const TileLayer *source,
                            const QRegion &paintRegion)
 {
+    // The previous cells need to be known for undo
+    target->pageIn(paintRegion.boundingRect().translated(-target->position()));
+
     PaintTileLayer::LayerData data;
-    data.mSource = std::make_unique<TileLayer>();
-    data.mSource->setCells(x + target->x(),
-                           y + target->y(), source, paintRegion);
-    data.mErased = std::make_unique<TileLayer>();
-    data.mErased->setCells(target->x(),
-                           target->y(), target, paintRegion);
-    data.mPaintedRegion = paintRegion;
+    data.record(target,
+                QPoint(x + target->x(), y + target->y()), source,
+                paintRegion);
 
     mLayerData[target].mergeWith(std::move(data));
+    updateMemoryUsage();
 }
 
 void PaintTileLayer::erase(TileLayer *target, const QRegion &eraseRegion)
@@ -81,7 +86,7 @@ void PaintTileLayer::undo()
 {
     for (const auto& [tileLayer, data] : mLayerData) {
         TilePainter painter(mMapDocument, tileLayer);
-        painter.setCells(0, 0, data.mErased.get(), data.mPaintedRegion);
+        painter.setCells(0, 0, data.toTileLayer(false).get(), data.paintedRegion());
     }
 
     QUndoCommand::undo(); // undo child commands
@@ -93,48 +98,267 @@ void PaintTileLayer::redo()
 
     for (const auto& [tileLayer, data] : mLayerData) {
         TilePainter painter(mMapDocument, tileLayer);
-        painter.setCells(0, 0, data.mSource.get(), data.mPaintedRegion);
+        painter.setCells(0, 0, data.toTileLayer(true).get(), data.paintedRegion());
+    }
+}
+
+bool PaintTileLayer::mergeWith(const QUndoCommand *other)
+{
+    const PaintTileLayer *o = static_cast<const PaintTileLayer*>(other);
+    if (!(mMapDocument == o->mMapDocument && o->mMergeable))
+        return false;
+    if (mMemoryUsage + o->mMemoryUsage > MaximumMergedMemoryUsage)
+        return false;
+    if (!cloneChildren(other, this))
+        return false;
+
+    for (const auto& [tileLayer, data] : o->mLayerData)
+        mLayerData[tileLayer].mergeWith(data);
+
+    updateMemoryUsage();
+    return true;
+}
+
+/**
+ * Returns the approximate amount of memory in bytes used by all paint
+ * commands, which are usually the largest commands on the undo stacks.
+ */
+qint64 PaintTileLayer::totalMemoryUsage()
+{
+    return sTotalMemoryUsage;
+}
+
+void PaintTileLayer::updateMemoryUsage()
+{
+    qint64 memoryUsage = 0;
+    for (const auto& [tileLayer, data] : mLayerData)
+        memoryUsage += data.memoryUsage();
+
+    sTotalMemoryUsage += memoryUsage - mMemoryUsage;
+    mMemoryUsage = memoryUsage;
+}
+
+/**
+ * Records the change of the cells in \a paintRegion (in map coordinates)
+ * from their current value on \a target to the cells in \a source, which is
+ * positioned at \a sourceOffset.
+ */
+void PaintTileLayer::LayerData::record(const TileLayer *target,
+                                       QPoint sourceOffset, const TileLayer *source,
+                                       const QRegion &paintRegion)
+{
+    QHash<QPoint, QVector<Change>> changes;
+
+    for (const QRect &rect : paintRegion) {
+        for (int cy = rect.top() >> CHUNK_BITS; cy <= rect.bottom() >> CHUNK_BITS; ++cy) {
+            for (int cx = rect.left() >> CHUNK_BITS; cx <= rect.right() >> CHUNK_BITS; ++cx) {
+                const QRect piece = rect & QRect(cx * CHUNK_SIZE, cy * CHUNK_SIZE,
+                                                 CHUNK_SIZE, CHUNK_SIZE);
+                auto &chunkChanges = changes[QPoint(cx, cy)];
+
+                for (int y = piece.top(); y <= piece.bottom(); ++y) {
+                    for (int x = piece.left(); x <= piece.right(); ++x) {
+                        chunkChanges.append({
+                            (x & CHUNK_MASK) + (y & CHUNK_MASK) * CHUNK_SIZE,
+                            target->cellAt(x - target->x(), y - target->y()),
+                            source->cellAt(x - sourceOffset.x(), y - sourceOffset.y())
+                        });
+                    }
+                }
+            }
+        }
     }
+
+    mChunks.clear();
+    for (auto it = changes.begin(); it != changes.end(); ++it)
+        mChunks.insert(it.key(), encode(it.value()));
+
+    mPaintedRegion = paintRegion;
 }
 
 void PaintTileLayer::LayerData::mergeWith(const LayerData &o)
 {
-    if (!mSource) {
-        mSource.reset(o.mSource->clone());
-        mErased.reset(o.mErased->clone());
-        mPaintedRegion = o.mPaintedRegion;
+    if (mChunks.isEmpty()) {
+        *this = o;
         return;
     }
 
-    copy(o);
+    for (auto it = o.mChunks.begin(); it != o.mChunks.end(); ++it) {
+        auto existing = mChunks.find(it.key());
+        if (existing == mChunks.end()) {
+            mChunks.insert(it.key(), it.value());
+            continue;
+        }
+
+        // Merge the changes, keeping our old cells and their new cells
+        const QVector<Change> ours = decode(existing.value(), it.key(), mPaintedRegion);
+        const QVector<Change> theirs = decode(it.value(), it.key(), o.mPaintedRegion);
+        QVector<Change> merged;
+        merged.reserve(ours.size() + theirs.size());
+
+        auto a = ours.begin();
+        auto b = theirs.begin();
+        while (a != ours.end() || b != theirs.end()) {
+            if (b == theirs.end() || (a != ours.end() && a->index < b->index)) {
+                merged.append(*a++);
+            } else if (a == ours.end() || b->index < a->index) {
+                merged.append(*b++);
+            } else {
+                merged.append({ a->index, a->oldCell, b->newCell });
+                ++a;
+                ++b;
+            }
+        }
+
+        existing.value() = encode(merged);
+    }
+
+    mPaintedRegion |= o.mPaintedRegion;
 }
 
 void PaintTileLayer::LayerData::mergeWith(LayerData &&o)
 {
-    if (!mSource)
+    if (mChunks.isEmpty())
         *this = std::move(o);
     else
-        copy(o);
+        mergeWith(std::as_const(o));
 }
 
-void PaintTileLayer::LayerData::copy(const LayerData &o)
+/**
+ * Returns a tile layer with either the new or the old cells, positioned in
+ * map coordinates.
+ */
+std::unique_ptr<TileLayer> PaintTileLayer::LayerData::toTileLayer(bool newCells) const
 {
-    // Copy the newly painted tiles as well as the newly erased tiles over
-    mSource->setCells(0, 0, o.mSource.get(), o.mPaintedRegion);
-    mErased->setCells(0, 0, o.mErased.get(), o.mPaintedRegion - mPaintedRegion);
-    mPaintedRegion |= o.mPaintedRegion;
+    auto tileLayer = std::make_unique<TileLayer>();
+
+    for (auto it = mChunks.begin(); it != mChunks.end(); ++it) {
+        const QPoint chunkOrigin = it.key() * CHUNK_SIZE;
+
+        if (!it.value().packed.isEmpty()) {
+            const Chunk &chunk = it.value().packed.at(newCells ? 1 : 0);
+            const QRect chunkRect(chunkOrigin, QSize(CHUNK_SIZE, CHUNK_SIZE));
+
+            for (const QRect &rect : mPaintedRegion & chunkRect)
+                for (int y = rect.top(); y <= rect.bottom(); ++y)
+                    for (int x = rect.left(); x <= rect.right(); ++x)
+                        tileLayer->setCell(x, y, chunk.cellAt(x & CHUNK_MASK, y & CHUNK_MASK));
+            continue;
+        }
+
+        for (const Run &run : it.value().runs) {
+            const Cell &cell = newCells ? run.newCell : run.oldCell;
+            for (int index = run.index; index < run.index + run.length; ++index) {
+                tileLayer->setCell(chunkOrigin.x() + (index & CHUNK_MASK),
+                                   chunkOrigin.y() + index / CHUNK_SIZE,
+                                   cell);
+            }
+        }
+    }
+
+    return tileLayer;
 }
 
-bool PaintTileLayer::mergeWith(const QUndoCommand *other)
+qint64 PaintTileLayer::LayerData::memoryUsage() const
 {
-    const PaintTileLayer *o = static_cast<const PaintTileLayer*>(other);
-    if (!(mMapDocument == o->mMapDocument && o->mMergeable))
-        return false;
-    if (!cloneChildren(other, this))
-        return false;
+    qint64 memoryUsage = sizeof(LayerData) + mPaintedRegion.rectCount() * sizeof(QRect);
 
-    for (const auto& [tileLayer, data] : o->mLayerData)
-        mLayerData[tileLayer].mergeWith(data);
+    for (const ChunkChanges &chunkChanges : mChunks) {
+        memoryUsage += sizeof(QPoint) + sizeof(ChunkChanges) + chunkChanges.runs.size() * sizeof(Run);
+        for (const Chunk &chunk : chunkChanges.packed)
+            memoryUsage += chunk.memoryUsage();
+    }
 
-    return true;
+    return memoryUsage;
+}
+
+/**
+ * Encodes the given \a changes, which are sorted by this function, into runs
+ * or into packed chunks, whichever takes less memory.
+ */
+PaintTileLayer::LayerData::ChunkChanges PaintTileLayer::LayerData::encode(QVector<Change> &changes)
+{
+    std::sort(changes.begin(), changes.end(), [] (const Change &a, const Change &b) {
+        return a.index < b.index;
+    });
+
+    QVector<Run> runs;
+
+    for (const Change &change : std::as_const(changes)) {
+        if (!runs.isEmpty()) {
+            Run &last = runs.last();
+            if (last.index + last.length == change.index &&
+                    last.oldCell == change.oldCell &&
+                    last.newCell == change.newCell) {
+                ++last.length;
+                continue;
+            }
+        }
+
+        runs.append({ static_cast<quint16>(change.index), 1, change.oldCell, change.newCell });
+    }
+
+    ChunkChanges chunkChanges;
+
+    // Packed chunks take at least 16 bits per cell for both the old and new
+    // cells, so they are only tried when the runs take more than that
+    const qint64 runsSize = runs.size() * sizeof(Run);
+    if (runsSize > 2 * CHUNK_SIZE * CHUNK_SIZE * sizeof(quint16)) {
+        Chunk oldCells;
+        Chunk newCells;
+
+        for (const Change &change : std::as_const(changes)) {
+            const int x = change.index & CHUNK_MASK;
+            const int y = change.index >> CHUNK_BITS;
+            oldCells.setCell(x, y, change.oldCell);
+            newCells.setCell(x, y, change.newCell);
+        }
+
+        if (oldCells.memoryUsage() + newCells.memoryUsage() < runsSize) {
+            chunkChanges.packed = { oldCells, newCells };
+            return chunkChanges;
+        }
+    }
+
+    runs.squeeze();
+    chunkChanges.runs = std::move(runs);
+    return chunkChanges;
+}
+
+/**
+ * Decodes the changes of the chunk at \a chunkPos, sorted by index. The
+ * \a paintedRegion is needed to know which cells of packed chunks changed.
+ */
+QVector<PaintTileLayer::LayerData::Change> PaintTileLayer::LayerData::decode(const ChunkChanges &chunkChanges,
+                                                                            QPoint chunkPos,
+                                                                            const QRegion &paintedRegion)
+{
+    QVector<Change> changes;
+
+    if (!chunkChanges.packed.isEmpty()) {
+        const Chunk &oldCells = chunkChanges.packed.at(0);
+        const Chunk &newCells = chunkChanges.packed.at(1);
+        const QRect chunkRect(chunkPos * CHUNK_SIZE, QSize(CHUNK_SIZE, CHUNK_SIZE));
+
+        for (const QRect &rect : paintedRegion & chunkRect) {
+            for (int y = rect.top() & CHUNK_MASK; y <= (rect.bottom() & CHUNK_MASK); ++y) {
+                for (int x = rect.left() & CHUNK_MASK; x <= (rect.right() & CHUNK_MASK); ++x) {
+                    changes.append({ x + y * CHUNK_SIZE,
+                                     oldCells.cellAt(x, y),
+                                     newCells.cellAt(x, y) });
+                }
+            }
+        }
+
+        std::sort(changes.begin(), changes.end(), [] (const Change &a, const Change &b) {
+            return a.index < b.index;
+        });
+        return changes;
+    }
+
+    for (const Run &run : chunkChanges.runs)
+        for (int index = run.index; index < run.index + run.length; ++index)
+            changes.append({ index, run.oldCell, run.newCell });
+
+    return changes;
 }
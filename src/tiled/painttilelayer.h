@@ -20,8 +20,10 @@
 
 #pragma once
 
+#include "tilelayer.h"
 #include "undocommands.h"
 
+#include <QHash>
 #include <QRegion>
 #include <QUndoCommand>
 
@@ -30,8 +32,6 @@
 
 namespace Tiled {
 
-class TileLayer;
-
 class MapDocument;
 
 /**
@@ -90,23 +90,81 @@ public:
     int id() const override { return Cmd_PaintTileLayer; }
     bool mergeWith(const QUndoCommand *other) override;
 
+    /**
+     * Returns the approximate amount of memory in bytes used by this command
+     * to store the changes.
+     */
+    qint64 memoryUsage() const { return mMemoryUsage; }
+
+    static qint64 totalMemoryUsage();
+
+    /**
+     * Commands will not merge when the result would use more than this
+     * amount of memory, to avoid a single undo step of unbounded size.
+     */
+    static constexpr qint64 MaximumMergedMemoryUsage = 32 * 1024 * 1024;
+
 private:
-    struct LayerData
+    /**
+     * The changes made to a single tile layer. For each chunk, the changed
+     * cells are stored as runs of consecutive cells that changed from the
+     * same old cell to the same new cell. When the runs would take more
+     * memory, for example for a random fill, the old and new cells are stored
+     * in packed chunks instead, with the painted region telling which of
+     * their cells changed.
+     */
+    class LayerData
     {
+    public:
+        void record(const TileLayer *target,
+                    QPoint sourceOffset, const TileLayer *source,
+                    const QRegion &paintRegion);
+
         void mergeWith(const LayerData &o);
         void mergeWith(LayerData &&o);
 
-        std::unique_ptr<TileLayer> mSource;
-        std::unique_ptr<TileLayer> mErased;
-        QRegion mPaintedRegion;
+        std::unique_ptr<TileLayer> toTileLayer(bool newCells) const;
+
+        const QRegion &paintedRegion() const { return mPaintedRegion; }
+        qint64 memoryUsage() const;
 
     private:
-        void copy(const LayerData &o);
+        struct Change
+        {
+            int index;
+            Cell oldCell;
+            Cell newCell;
+        };
+
+        struct Run
+        {
+            quint16 index;
+            quint16 length;
+            Cell oldCell;
+            Cell newCell;
+        };
+
+        struct ChunkChanges
+        {
+            QVector<Run> runs;
+            QVector<Chunk> packed;  // old and new cells, when not using runs
+        };
+
+        static ChunkChanges encode(QVector<Change> &changes);
+        static QVector<Change> decode(const ChunkChanges &chunkChanges,
+                                      QPoint chunkPos,
+                                      const QRegion &paintedRegion);
+
+        QHash<QPoint, ChunkChanges> mChunks;
+        QRegion mPaintedRegion;
     };
 
+    void updateMemoryUsage();
+
     MapDocument *mMapDocument;
     std::unordered_map<TileLayer*, LayerData> mLayerData;
     bool mMergeable;
+    qint64 mMemoryUsage = 0;
 };
 
 inline void PaintTileLayer::setMergeable(bool mergeable)
@@ -21,11 +21,16 @@
 #include "pointhandle.h"
 
 #include "mapobject.h"
+#include "tilelayer.h"      // for qHash(QPoint) on Qt 5
 #include "utils.h"
 
 #include <QApplication>
 #include <QPainter>
 #include <QPalette>
+#include <QSet>
+#include <QStyleOptionGraphicsItem>
+
+#include <cmath>
 
 namespace Tiled {
 
@@ -87,4 +92,220 @@ void PointHandle::paint(QPainter *painter,
         painter->drawEllipse(QRectF(-4, -4, 8, 8));
 }
 
+
+PointHandles::PointHandles(MapObject *mapObject)
+    : QGraphicsItem()
+    , mMapObject(mapObject)
+{
+    setAcceptedMouseButtons(Qt::MouseButtons());
+    setFlags(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setZValue(10000);
+}
+
+/**
+ * Sets the scene positions of the points and moves any existing handles
+ * along. Handles for points that no longer exist should be deleted first.
+ */
+void PointHandles::setPositions(const QVector<QPointF> &positions)
+{
+    prepareGeometryChange();
+
+    mPositions = positions;
+    mCells.clear();
+
+    QPolygonF polygon(positions);
+    mBounds = polygon.boundingRect();
+
+    // Use a grid with on average about one point per cell
+    const qreal size = std::max(mBounds.width(), mBounds.height());
+    mCellSize = std::max<qreal>(1, size / std::sqrt(std::max(1, int(positions.size()))));
+
+    for (int i = 0; i < positions.size(); ++i)
+        mCells[cellAt(positions.at(i))].append(i);
+
+    for (auto it = mHandles.cbegin(); it != mHandles.cend(); ++it)
+        it.value()->setPos(mPositions.at(it.key()));
+
+    update();
+}
+
+/**
+ * Sets the margin, in scene coordinates, by which the painted points may
+ * extend beyond the bounding rectangle of their positions.
+ */
+void PointHandles::setHandleMargin(qreal margin)
+{
+    if (mHandleMargin == margin)
+        return;
+
+    prepareGeometryChange();
+    mHandleMargin = margin;
+}
+
+/**
+ * Returns the handle for the given point, creating it when necessary.
+ */
+PointHandle *PointHandles::handle(int pointIndex)
+{
+    PointHandle *&handle = mHandles[pointIndex];
+    if (!handle) {
+        handle = new PointHandle(mMapObject, pointIndex);
+        handle->setParentItem(this);
+        handle->setPos(mPositions.at(pointIndex));
+        update(handle->mapRectToParent(handle->boundingRect()));
+    }
+    return handle;
+}
+
+PointHandle *PointHandles::existingHandle(int pointIndex) const
+{
+    return mHandles.value(pointIndex);
+}
+
+/**
+ * Deletes the given handle. Its point will be painted by this item again.
+ */
+void PointHandles::deleteHandle(PointHandle *handle)
+{
+    if (mHandles.value(handle->pointIndex()) != handle)
+        return;
+
+    mHandles.remove(handle->pointIndex());
+    update(handle->mapRectToParent(handle->boundingRect()));
+    delete handle;
+}
+
+/**
+ * Returns the index of the point closest to \a pos, within \a radius
+ * horizontally and vertically, or -1 when there is no such point.
+ */
+int PointHandles::pointAt(const QPointF &pos, qreal radius) const
+{
+    const QRectF rect(pos.x() - radius, pos.y() - radius, radius * 2, radius * 2);
+
+    int closestIndex = -1;
+    qreal closestDistance = 0;
+
+    forEachPointIn(rect, [&] (int index) {
+        const QPointF delta = mPositions.at(index) - pos;
+        const qreal distance = QPointF::dotProduct(delta, delta);
+        if (closestIndex == -1 || distance < closestDistance) {
+            closestIndex = index;
+            closestDistance = distance;
+        }
+    });
+
+    return closestIndex;
+}
+
+/**
+ * Returns the indexes of the points within \a rect.
+ */
+QVector<int> PointHandles::pointsIn(const QRectF &rect) const
+{
+    QVector<int> indexes;
+    forEachPointIn(rect, [&] (int index) { indexes.append(index); });
+    return indexes;
+}
+
+QRectF PointHandles::boundingRect() const
+{
+    if (mPositions.isEmpty())
+        return QRectF();
+
+    return mBounds.adjusted(-mHandleMargin, -mHandleMargin,
+                            mHandleMargin, mHandleMargin);
+}
+
+/**
+ * The points are picked using pointAt and pointsIn, so this item doesn't
+ * get in the way of QGraphicsScene::itemAt and QGraphicsScene::items.
+ */
+QPainterPath PointHandles::shape() const
+{
+    return QPainterPath();
+}
+
+bool PointHandles::contains(const QPointF &) const
+{
+    return false;
+}
+
+void PointHandles::paint(QPainter *painter,
+                         const QStyleOptionGraphicsItem *option,
+                         QWidget *)
+{
+    const QRectF exposedRect = option->exposedRect.adjusted(-mHandleMargin, -mHandleMargin,
+                                                            mHandleMargin, mHandleMargin);
+    const QTransform transform = painter->worldTransform();
+    const qreal scale = Utils::defaultDpiScale();
+
+    QPen pen(Qt::black);
+    pen.setWidthF(scale);
+
+    painter->save();
+    painter->resetTransform();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(pen);
+    painter->setBrush(QColor(Qt::lightGray));
+
+    // When zoomed out, many points end up at the same device pixel. These
+    // only need to be painted once.
+    QSet<QPoint> paintedPixels;
+
+    forEachPointIn(exposedRect, [&] (int index) {
+        if (mHandles.contains(index))
+            return;
+
+        const QPointF pos = transform.map(mPositions.at(index));
+        const QPoint pixel = pos.toPoint();
+        if (paintedPixels.contains(pixel))
+            return;
+
+        paintedPixels.insert(pixel);
+        painter->drawEllipse(pos, 4 * scale, 4 * scale);
+    });
+
+    painter->restore();
+}
+
+template<typename Callback>
+void PointHandles::forEachPointIn(const QRectF &rect, Callback callback) const
+{
+    const QRectF searchRect = rect.intersected(mBounds.adjusted(-1, -1, 1, 1));
+    if (searchRect.isEmpty())
+        return;
+
+    const QPoint topLeft = cellAt(searchRect.topLeft());
+    const QPoint bottomRight = cellAt(searchRect.bottomRight());
+    const qint64 cellCount = qint64(bottomRight.x() - topLeft.x() + 1) *
+                             qint64(bottomRight.y() - topLeft.y() + 1);
+
+    // When the rectangle covers many cells, checking each point is faster
+    if (cellCount > mCells.size()) {
+        for (int i = 0; i < mPositions.size(); ++i)
+            if (rect.contains(mPositions.at(i)))
+                callback(i);
+        return;
+    }
+
+    for (int y = topLeft.y(); y <= bottomRight.y(); ++y) {
+        for (int x = topLeft.x(); x <= bottomRight.x(); ++x) {
+            const auto it = mCells.constFind(QPoint(x, y));
+            if (it == mCells.constEnd())
+                continue;
+
+            for (int index : it.value())
+                if (rect.contains(mPositions.at(index)))
+                    callback(index);
+        }
+    }
+}
+
+QPoint PointHandles::cellAt(const QPointF &pos) const
+{
+    return QPoint(int(std::floor((pos.x() - mBounds.left()) / mCellSize)),
+                  int(std::floor((pos.y() - mBounds.top()) / mCellSize)));
+}
+
 } // namespace Tiled
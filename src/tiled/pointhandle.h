@@ -21,6 +21,8 @@
 #pragma once
 
 #include <QGraphicsItem>
+#include <QHash>
+#include <QVector>
 
 namespace Tiled {
 
@@ -61,4 +63,57 @@ private:
     bool mHighlighted;
 };
 
+/**
+ * Paints the points of a polygon and creates a PointHandle for a point only
+ * when it is needed, for example because it is hovered or selected.
+ *
+ * Used instead of one PointHandle per point, since for polygons with many
+ * thousands of points the item count slows down the whole scene.
+ */
+class PointHandles : public QGraphicsItem
+{
+public:
+    explicit PointHandles(MapObject *mapObject);
+
+    enum { Type = UserType + 4 };
+    int type() const override { return Type; }
+
+    MapObject *mapObject() const { return mMapObject; }
+
+    void setPositions(const QVector<QPointF> &positions);
+    const QVector<QPointF> &positions() const { return mPositions; }
+    int pointCount() const { return mPositions.size(); }
+
+    void setHandleMargin(qreal margin);
+
+    PointHandle *handle(int pointIndex);
+    PointHandle *existingHandle(int pointIndex) const;
+    QList<PointHandle*> handles() const { return mHandles.values(); }
+    void deleteHandle(PointHandle *handle);
+
+    int pointAt(const QPointF &pos, qreal radius) const;
+    QVector<int> pointsIn(const QRectF &rect) const;
+
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override;
+    bool contains(const QPointF &point) const override;
+    void paint(QPainter *painter,
+               const QStyleOptionGraphicsItem *option,
+               QWidget *widget = nullptr) override;
+
+private:
+    template<typename Callback>
+    void forEachPointIn(const QRectF &rect, Callback callback) const;
+
+    QPoint cellAt(const QPointF &pos) const;
+
+    MapObject *mMapObject;
+    QVector<QPointF> mPositions;
+    QRectF mBounds;
+    qreal mHandleMargin = 0;
+    qreal mCellSize = 1;
+    QHash<QPoint, QVector<int>> mCells;
+    QHash<int, PointHandle*> mHandles;
+};
+
 } // namespace Tiled
@@ -22,9 +22,11 @@
 #include "preferences.h"
 
 #include "languagemanager.h"
+#include "mapcache.h"
 #include "pluginmanager.h"
 #include "savefile.h"
 #include "session.h"
+#include "taskscheduler.h"
 #include "tilesetmanager.h"
 
 #include <QApplication>
@@ -87,6 +89,8 @@ void Preferences::initialize()
         dataDir.mkpath(QStringLiteral("."));
 
     SaveFile::setSafeSavingEnabled(safeSavingEnabled());
+    MapCache::setEnabled(mapCacheEnabled());
+    TaskScheduler::setThreadCount(threadCount());
 
     // Backwards compatibility check since 'FusionStyle' was removed from the
     // preferences dialog.
@@ -98,6 +102,7 @@ void Preferences::initialize()
 
     TilesetManager *tilesetManager = TilesetManager::instance();
     tilesetManager->setReloadTilesetsOnChange(reloadTilesetsOnChange());
+    tilesetManager->setReducedAnimations(reducedAnimations());
     tilesetManager->setAnimateTiles(showTileAnimations());
 
     // Read the lists of enabled and disabled plugins
@@ -447,6 +452,32 @@ void Preferences::setSafeSavingEnabled(bool enabled)
     SaveFile::setSafeSavingEnabled(enabled);
 }
 
+bool Preferences::mapCacheEnabled() const
+{
+    return get("Storage/MapCacheEnabled", true);
+}
+
+void Preferences::setMapCacheEnabled(bool enabled)
+{
+    setValue(QLatin1String("Storage/MapCacheEnabled"), enabled);
+    MapCache::setEnabled(enabled);
+}
+
+/**
+ * Returns the number of worker threads, with 0 meaning one thread for each
+ * processor core.
+ */
+int Preferences::threadCount() const
+{
+    return get("Performance/ThreadCount", 0);
+}
+
+void Preferences::setThreadCount(int count)
+{
+    setValue(QLatin1String("Performance/ThreadCount"), count);
+    TaskScheduler::setThreadCount(count);
+}
+
 bool Preferences::exportOnSave() const
 {
     return get("Storage/ExportOnSave", false);
@@ -673,6 +704,17 @@ void Preferences::setNaturalSorting(bool enabled)
     emit naturalSortingChanged(enabled);
 }
 
+bool Preferences::reducedAnimations() const
+{
+    return get("Interface/ReducedAnimations", false);
+}
+
+void Preferences::setReducedAnimations(bool enabled)
+{
+    setValue(QLatin1String("Interface/ReducedAnimations"), enabled);
+    TilesetManager::instance()->setReducedAnimations(enabled);
+}
+
 void Preferences::addToRecentFileList(const QString &fileName, QStringList& files)
 {
     // Remember the file by its absolute file path (not the canonical one,
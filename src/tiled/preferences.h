@@ -115,6 +115,12 @@ public:
     bool safeSavingEnabled() const;
     void setSafeSavingEnabled(bool enabled);
 
+    bool mapCacheEnabled() const;
+    void setMapCacheEnabled(bool enabled);
+
+    int threadCount() const;
+    void setThreadCount(int count);
+
     bool exportOnSave() const;
     void setExportOnSave(bool enabled);
 
@@ -167,6 +173,9 @@ public:
     bool naturalSorting() const;
     void setNaturalSorting(bool enabled);
 
+    bool reducedAnimations() const;
+    void setReducedAnimations(bool enabled);
+
     bool checkForUpdates() const;
     void setCheckForUpdates(bool on);
 
@@ -93,8 +93,14 @@ PreferencesDialog::PreferencesDialog(QWidget *parent)
             preferences, &Preferences::setSafeSavingEnabled);
     connect(mUi->exportOnSave, &QCheckBox::toggled,
             preferences, &Preferences::setExportOnSave);
+    connect(mUi->mapCache, &QCheckBox::toggled,
+            preferences, &Preferences::setMapCacheEnabled);
+    connect(mUi->threadCount, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            preferences, &Preferences::setThreadCount);
     connect(mUi->naturalSorting, &QCheckBox::toggled,
             preferences, &Preferences::setNaturalSorting);
+    connect(mUi->reducedAnimations, &QCheckBox::toggled,
+            preferences, &Preferences::setReducedAnimations);
 
     connect(mUi->embedTilesets, &QCheckBox::toggled, preferences, [preferences] (bool value) {
         preferences->setExportOption(Preferences::EmbedTilesets, value);
@@ -144,6 +150,8 @@ PreferencesDialog::PreferencesDialog(QWidget *parent)
             this, [] (bool checked) { MapView::ourAutoScrollingEnabled = checked; });
     connect(mUi->smoothScrolling, &QCheckBox::toggled,
             this, [] (bool checked) { MapView::ourSmoothScrollingEnabled = checked; });
+    connect(mUi->showFrameStatistics, &QCheckBox::toggled,
+            this, [] (bool checked) { MapView::ourFrameStatisticsEnabled = checked; });
     connect(mUi->duplicateAddsCopy, &QCheckBox::toggled,
             this, [] (bool checked) { Editor::duplicateAddsCopy = checked; });
 
@@ -220,7 +228,10 @@ void PreferencesDialog::fromPreferences()
     mUi->restoreSession->setChecked(prefs->restoreSessionOnStartup());
     mUi->safeSaving->setChecked(prefs->safeSavingEnabled());
     mUi->exportOnSave->setChecked(prefs->exportOnSave());
+    mUi->mapCache->setChecked(prefs->mapCacheEnabled());
+    mUi->threadCount->setValue(prefs->threadCount());
     mUi->naturalSorting->setChecked(prefs->naturalSorting());
+    mUi->reducedAnimations->setChecked(prefs->reducedAnimations());
 
     mUi->embedTilesets->setChecked(prefs->exportOption(Preferences::EmbedTilesets));
     mUi->detachTemplateInstances->setChecked(prefs->exportOption(Preferences::DetachTemplateInstances));
@@ -238,6 +249,7 @@ void PreferencesDialog::fromPreferences()
     mUi->wheelZoomsByDefault->setChecked(prefs->wheelZoomsByDefault());
     mUi->autoScrolling->setChecked(MapView::ourAutoScrollingEnabled);
     mUi->smoothScrolling->setChecked(MapView::ourSmoothScrollingEnabled);
+    mUi->showFrameStatistics->setChecked(MapView::ourFrameStatisticsEnabled);
     mUi->duplicateAddsCopy->setChecked(Editor::duplicateAddsCopy);
 
     const QFont customFont = prefs->customFont();
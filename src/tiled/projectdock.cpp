@@ -22,7 +22,11 @@
 
 #include "actionmanager.h"
 #include "addremovetileset.h"
+#include "assetdependencies.h"
+#include "batchoperation.h"
 #include "documentmanager.h"
+#include "fileformat.h"
+#include "logginginterface.h"
 #include "mapdocumentactionhandler.h"
 #include "mapeditor.h"
 #include "objecttemplate.h"
@@ -32,10 +36,12 @@
 #include "session.h"
 #include "templatemanager.h"
 #include "tilesetdock.h"
+#include "tilesetformat.h"
 #include "tilesetmanager.h"
 #include "utils.h"
 
 #include <QBoxLayout>
+#include <QDir>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QMenu>
@@ -79,6 +85,11 @@ private:
     void onActivated(const QModelIndex &index);
     void onRowsInserted(const QModelIndex &parent);
 
+    void replaceTilesetInMaps(const QString &tilesetFileName);
+    void runBatchOperation(const QString &title,
+                           std::shared_ptr<const BatchOperation> operation,
+                           const QStringList &fileNames);
+
     void restoreExpanded(const QModelIndex &parent);
 
     ProjectModel *mProjectModel;
@@ -298,6 +309,38 @@ void ProjectView::contextMenuEvent(QContextMenuEvent *event)
                         tilesetDock->setCurrentTileset(tileset);
                     })->setEnabled(!mapHasTileset);
                 }
+
+                menu.addSeparator();
+
+                menu.addAction(tr("Find Uses in Project Maps"), [=] {
+                    runBatchOperation(tr("Find uses of %1").arg(QFileInfo(path).fileName()),
+                                      std::make_shared<FindTileUsesOperation>(path),
+                                      mProjectModel->files());
+                });
+
+                menu.addAction(tr("Replace in Project Maps..."), [=] {
+                    replaceTilesetInMaps(path);
+                });
+            }
+
+            // List the files referring to this file
+            const auto dependents = ProjectManager::instance()->assetDependencies()->dependents(path);
+            if (!dependents.isEmpty()) {
+                const int maximumShown = 25;
+
+                menu.addSeparator();
+                auto usedByMenu = menu.addMenu(tr("Used By (%1)").arg(dependents.size()));
+                usedByMenu->setToolTipsVisible(true);
+
+                for (const QString &dependent : dependents.mid(0, maximumShown)) {
+                    auto action = usedByMenu->addAction(QFileInfo(dependent).fileName(), [=] {
+                        DocumentManager::instance()->openFile(dependent);
+                    });
+                    action->setToolTip(QDir::toNativeSeparators(dependent));
+                }
+
+                if (dependents.size() > maximumShown)
+                    usedByMenu->addAction(tr("%n more...", nullptr, dependents.size() - maximumShown))->setEnabled(false);
             }
         }
 
@@ -320,6 +363,106 @@ void ProjectView::contextMenuEvent(QContextMenuEvent *event)
         menu.exec(event->globalPos());
 }
 
+/**
+ * Asks for a tileset to replace the given tileset with, and replaces it in
+ * all maps of the project that aren't open in the editor.
+ */
+void ProjectView::replaceTilesetInMaps(const QString &tilesetFileName)
+{
+    FormatHelper<TilesetFormat> helper(FileFormat::Read, tr("All Files (*)"));
+
+    Session &session = Session::current();
+    const QString fileName = QFileDialog::getOpenFileName(window(),
+                                                          tr("Replace Tileset in Project Maps"),
+                                                          session.lastPath(Session::ExternalTileset),
+                                                          helper.filter());
+    if (fileName.isEmpty())
+        return;
+
+    session.setLastPath(Session::ExternalTileset, QFileInfo(fileName).path());
+
+    QString error;
+    SharedTileset newTileset = TilesetManager::instance()->loadTileset(fileName, &error);
+    if (!newTileset) {
+        WARNING(tr("Error loading tileset '%1': %2").arg(QDir::toNativeSeparators(fileName), error));
+        return;
+    }
+    if (newTileset->fileName() == tilesetFileName)
+        return;
+
+    runBatchOperation(tr("Replace %1 with %2").arg(QFileInfo(tilesetFileName).fileName(),
+                                                   QFileInfo(fileName).fileName()),
+                      std::make_shared<ReplaceTilesetOperation>(tilesetFileName, newTileset),
+                      mProjectModel->files());
+}
+
+/**
+ * Applies the given \a operation to the maps among \a fileNames, reporting
+ * the results and timing for each map in the Console.
+ */
+void ProjectView::runBatchOperation(const QString &title,
+                                    std::shared_ptr<const BatchOperation> operation,
+                                    const QStringList &fileNames)
+{
+    auto runner = new BatchOperationRunner(std::move(operation), this);
+
+    connect(runner, &BatchOperationRunner::fileFinished, this, [title] (const BatchOperationResult &result) {
+        const QString fileName = result.fileName;
+        const QString nativeFileName = QDir::toNativeSeparators(fileName);
+
+        switch (result.status) {
+        case BatchOperationResult::Done:
+            if (result.saved) {
+                ProjectManager::instance()->assetDependencies()->fileChanged(fileName);
+
+                INFO(tr("%1: %2: %3 (loaded in %4 ms, applied in %5 ms, saved in %6 ms)")
+                     .arg(title, nativeFileName)
+                     .arg(result.changes)
+                     .arg(result.loadTime)
+                     .arg(result.applyTime)
+                     .arg(result.saveTime));
+            } else if (result.changes > 0) {
+                INFO(tr("%1: %2: %3 (loaded in %4 ms, applied in %5 ms)")
+                     .arg(title, nativeFileName)
+                     .arg(result.changes)
+                     .arg(result.loadTime)
+                     .arg(result.applyTime));
+            }
+            break;
+        case BatchOperationResult::Skipped:
+            INFO(tr("%1: %2: Skipped, %3").arg(title, nativeFileName, result.message));
+            break;
+        case BatchOperationResult::Failed:
+            WARNING(tr("%1: %2: %3").arg(title, nativeFileName, result.message),
+                    [fileName] { DocumentManager::instance()->openFile(fileName); });
+            break;
+        }
+    });
+
+    connect(runner, &BatchOperationRunner::finished, this, [title, runner] {
+        int matched = 0;
+        int failed = 0;
+
+        for (const BatchOperationResult &result : runner->results()) {
+            if (result.status == BatchOperationResult::Failed)
+                ++failed;
+            else if (result.changes > 0)
+                ++matched;
+        }
+
+        INFO(tr("%1: %2 of %3 maps affected, %4 failed, in %5 ms")
+             .arg(title)
+             .arg(matched)
+             .arg(runner->results().size())
+             .arg(failed)
+             .arg(runner->elapsed()));
+
+        runner->deleteLater();
+    });
+
+    runner->start(fileNames);
+}
+
 void ProjectView::onActivated(const QModelIndex &index)
 {
     const QString path = filePath(index);
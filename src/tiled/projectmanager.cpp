@@ -20,6 +20,7 @@
 
 #include "projectmanager.h"
 
+#include "assetdependencies.h"
 #include "fileformat.h"
 #include "objecttypes.h"
 #include "preferences.h"
@@ -32,6 +33,7 @@ ProjectManager *ProjectManager::ourInstance;
 ProjectManager::ProjectManager(QObject *parent)
     : QObject(parent)
     , mProjectModel(new ProjectModel(this))
+    , mAssetDependencies(new AssetDependencies(mProjectModel, this))
 {
     Q_ASSERT(!ourInstance);
     ourInstance = this;
@@ -68,6 +70,8 @@ void ProjectManager::setProject(std::unique_ptr<Project> _project)
 
     FileFormat::setCompatibilityVersion(project.mCompatibilityVersion);
 
+    mAssetDependencies->setProjectFileName(project.fileName());
+
     emit projectChanged();
 }
 
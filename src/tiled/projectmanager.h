@@ -26,6 +26,7 @@
 
 namespace Tiled {
 
+class AssetDependencies;
 class EditableAsset;
 class ProjectModel;
 
@@ -49,12 +50,14 @@ public:
     EditableAsset *editableProject();
 
     ProjectModel *projectModel();
+    AssetDependencies *assetDependencies();
 
 signals:
     void projectChanged();
 
 private:
     ProjectModel *mProjectModel;
+    AssetDependencies *mAssetDependencies;
 
     static ProjectManager *ourInstance;
 };
@@ -70,4 +73,9 @@ inline ProjectModel *ProjectManager::projectModel()
     return mProjectModel;
 }
 
+inline AssetDependencies *ProjectManager::assetDependencies()
+{
+    return mAssetDependencies;
+}
+
 } // namespace Tiled
@@ -25,11 +25,17 @@
 #include "preferences.h"
 #include "utils.h"
 
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDir>
 #include <QFileInfo>
 #include <QMimeData>
+#include <QMutex>
+#include <QSaveFile>
 #include <QSet>
+#include <QStandardPaths>
 #include <QUrl>
+#include <QtConcurrent>
 
 namespace Tiled {
 
@@ -39,15 +45,27 @@ class FolderScanner : public QObject
 
 public:
     void setNameFilters(const QStringList &nameFilters);
-    void scanFolder(const QString &folder);
+    void scanFolder(const QString &folder, bool isProjectFolder);
 
 signals:
-    void scanFinished(FolderEntry *entry);
+    void scanFinished(FolderEntry *entry, bool fromIndex);
 
 private:
-    void scan(FolderEntry &folder, QSet<QString> &visitedFolders) const;
+    struct VisitedFolders
+    {
+        bool insert(const QString &canonicalPath);
+
+        QMutex mutex;
+        QSet<QString> paths;
+    };
+
+    void scan(FolderEntry &folder, VisitedFolders &visitedFolders, int depth) const;
+
+    std::unique_ptr<FolderEntry> readIndex(const QString &folder) const;
+    void writeIndex(const FolderEntry &folder) const;
 
     QStringList mNameFilters;
+    QSet<QString> mIndexedFolders;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -78,24 +96,60 @@ static void collectDirectories(const FolderEntry &entry, QStringList &filePaths)
     }
 }
 
-static void findFiles(const FolderEntry &entry, int offset, const QStringList &words, QVector<ProjectModel::Match> &result)
+static QString childPath(const QString &directory, const QString &fileName)
 {
-    for (const auto &childEntry : entry.entries) {
-        if (childEntry->entries.empty()) {
-            const auto relativePath = QStringView(childEntry->filePath).mid(offset);
-            const int totalScore = Utils::matchingScore(words, relativePath);
-
-            if (totalScore > 0) {
-                result.append(ProjectModel::Match {
-                                   totalScore,
-                                   offset,
-                                   childEntry->filePath
-                               });
-            }
-        } else {
-            findFiles(*childEntry, offset, words, result);
-        }
+    if (directory.endsWith(QLatin1Char('/')))
+        return directory + fileName;
+    return directory + QLatin1Char('/') + fileName;
+}
+
+/**
+ * Returns a mask with a bit set for each character that appears in the
+ * given string, ignoring case. Since words only match a path when all their
+ * characters appear in it, this allows skipping most paths when searching.
+ *
+ * Strings with non-ASCII characters get all bits set, since case-insensitive
+ * matching may match them to other characters.
+ */
+static quint64 characterMask(QStringView string)
+{
+    quint64 mask = 0;
+
+    for (const QChar c : string) {
+        const ushort u = c.unicode();
+        if (u >= 128)
+            return ~quint64(0);
+
+        int bit;
+        if (u >= 'a' && u <= 'z')
+            bit = u - 'a';
+        else if (u >= 'A' && u <= 'Z')
+            bit = u - 'A';
+        else if (u >= '0' && u <= '9')
+            bit = 26 + (u - '0');
+        else
+            bit = 36 + u % 28;
+
+        mask |= quint64(1) << bit;
     }
+
+    return mask;
+}
+
+/**
+ * Returns whether all files matching \a words also match \a previousWords,
+ * which is the case when each of the previous words was only extended.
+ */
+static bool narrowsSearch(const QStringList &words, const QStringList &previousWords)
+{
+    if (words.size() < previousWords.size())
+        return false;
+
+    for (int i = 0; i < previousWords.size(); ++i)
+        if (!words.at(i).startsWith(previousWords.at(i)))
+            return false;
+
+    return true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -151,6 +205,7 @@ void ProjectModel::setProject(std::unique_ptr<Project> project)
 
     mFolders.clear();
     mFoldersPendingScan.clear();
+    invalidateFileIndex();
 
     const auto &folders = this->project().folders();
     for (const QString &folder : folders) {
@@ -187,6 +242,7 @@ void ProjectModel::addFolder(const QString &folder)
 
     mFolders.push_back(std::make_unique<FolderEntry>(folder));
     mWatcher.addPath(folder);
+    invalidateFileIndex();
 
     scheduleFolderScan(folder);
 
@@ -212,6 +268,7 @@ void ProjectModel::removeFolder(int row)
 
     mFolders.erase(mFolders.begin() + row);
     mWatcher.removePaths(watchedFilePaths);
+    invalidateFileIndex();
 
     endRemoveRows();
 
@@ -233,12 +290,58 @@ void ProjectModel::refreshFolders()
 
 QVector<ProjectModel::Match> ProjectModel::findFiles(const QStringList &words) const
 {
+    updateFileIndex();
+
+    quint64 wordsMask = 0;
+    for (const QString &word : words)
+        wordsMask |= characterMask(word);
+
     QVector<Match> result;
-    for (const auto &entry : mFolders)
-        Tiled::findFiles(*entry, entry->filePath.lastIndexOf(QLatin1Char('/')) + 1, words, result);
+    QVector<int> matches;
+
+    auto tryMatch = [&] (int index) {
+        const IndexedFile &file = mFileIndex[index];
+        if (wordsMask & ~file.characters)
+            return;
+
+        const auto relativePath = QStringView(file.path).mid(file.offset);
+        const int totalScore = Utils::matchingScore(words, relativePath);
+
+        if (totalScore > 0) {
+            result.append(Match { totalScore, file.offset, file.path });
+            matches.append(index);
+        }
+    };
+
+    if (!mLastSearchWords.isEmpty() && narrowsSearch(words, mLastSearchWords)) {
+        for (int index : std::as_const(mLastSearchMatches))
+            tryMatch(index);
+    } else {
+        for (int index = 0, count = int(mFileIndex.size()); index < count; ++index)
+            tryMatch(index);
+    }
+
+    mLastSearchWords = words;
+    mLastSearchMatches = std::move(matches);
+
     return result;
 }
 
+/**
+ * Returns all files in the project folders.
+ */
+QStringList ProjectModel::files() const
+{
+    updateFileIndex();
+
+    QStringList files;
+    files.reserve(int(mFileIndex.size()));
+    for (const IndexedFile &file : mFileIndex)
+        files.append(file.path);
+
+    return files;
+}
+
 QString ProjectModel::filePath(const QModelIndex &index) const
 {
     if (!index.isValid())
@@ -380,13 +483,19 @@ void ProjectModel::pluginObjectAddedOrRemoved(QObject *object)
             mUpdateNameFiltersTimer.start();
 }
 
+/**
+ * Rescans only the directories that changed, rather than the whole project
+ * folders they are part of.
+ */
 void ProjectModel::pathsChanged(const QStringList &paths)
 {
-    for (const std::unique_ptr<FolderEntry> &entry : mFolders) {
-        if (std::any_of(paths.begin(), paths.end(),
-                        [&entry] (const QString &path) { return path.startsWith(entry->filePath); })) {
+    for (const QString &path : paths) {
+        FolderEntry *entry = findEntry(mFolders, path);
+        while (entry && entry->parent && !entry->isDir)
+            entry = entry->parent;
+
+        if (entry)
             scheduleFolderScan(entry->filePath);
-        }
     }
 }
 
@@ -418,72 +527,141 @@ void ProjectModel::updateNameFilters()
     }
 }
 
+/**
+ * Schedules a scan of the given \a folder, which is either one of the
+ * project folders or a directory within them.
+ */
+void ProjectModel::invalidateFileIndex()
+{
+    mFileIndexValid = false;
+    mFileIndex.clear();
+    mLastSearchWords.clear();
+    mLastSearchMatches.clear();
+}
+
+void ProjectModel::updateFileIndex() const
+{
+    if (mFileIndexValid)
+        return;
+
+    auto collectFiles = [this] (auto &self, const FolderEntry &entry, int offset) -> void {
+        for (const auto &childEntry : entry.entries) {
+            if (childEntry->entries.empty()) {
+                const auto relativePath = QStringView(childEntry->filePath).mid(offset);
+                mFileIndex.push_back({ childEntry->filePath, offset, characterMask(relativePath) });
+            } else {
+                self(self, *childEntry, offset);
+            }
+        }
+    };
+
+    mFileIndex.clear();
+    for (const auto &entry : mFolders)
+        collectFiles(collectFiles, *entry, entry->filePath.lastIndexOf(QLatin1Char('/')) + 1);
+
+    mFileIndexValid = true;
+}
+
 void ProjectModel::scheduleFolderScan(const QString &folder)
 {
+    // No need to scan a directory when it is part of a pending scan
+    auto isPartOf = [&] (const QString &pending) {
+        return folder == pending || folder.startsWith(childPath(pending, QString()));
+    };
+    if (std::any_of(mFoldersPendingScan.cbegin(), mFoldersPendingScan.cend(), isPartOf))
+        return;
+
     if (mScanningFolder.isEmpty()) {
         mScanningFolder = folder;
-        emit scanFolder(mScanningFolder);
-    } else if (!mFoldersPendingScan.contains(folder)) {
+        emit scanFolder(mScanningFolder, isProjectFolder(mScanningFolder));
+    } else {
         mFoldersPendingScan.append(folder);
     }
 }
 
-void ProjectModel::folderScanned(FolderEntry *resultPointer)
+bool ProjectModel::isProjectFolder(const QString &folder) const
+{
+    return std::any_of(mFolders.begin(), mFolders.end(),
+                       [&] (const std::unique_ptr<FolderEntry> &entry) { return entry->filePath == folder; });
+}
+
+void ProjectModel::folderScanned(FolderEntry *resultPointer, bool fromIndex)
 {
     const std::unique_ptr<FolderEntry> result { resultPointer };
     Q_ASSERT(!result->parent);
 
-    const auto it = std::find_if(mFolders.begin(), mFolders.end(),
-                                 [&] (const std::unique_ptr<FolderEntry> &value) { return value->filePath == result->filePath; });
+    // A result loaded from the index is followed by the actual scan result
+    if (!fromIndex) {
+        if (!mFoldersPendingScan.isEmpty()) {
+            mScanningFolder = mFoldersPendingScan.takeFirst();
+            emit scanFolder(mScanningFolder, isProjectFolder(mScanningFolder));
+        } else {
+            mScanningFolder.clear();
+        }
+    }
 
     // The folder may have been removed in the meantime
-    if (it == mFolders.end())
+    FolderEntry *entry = findEntry(mFolders, result->filePath);
+    if (!entry || (entry->parent && !entry->isDir))
         return;
 
     // There appears to be no way to reset a subset of the model, so signal the
     // removal of all previous rows and re-add the new rows instead.
 
-    const std::unique_ptr<FolderEntry> &entry = *it;
-    const QModelIndex index = indexForEntry(entry.get());
+    const QModelIndex index = indexForEntry(entry);
 
     QStringList previousDirectories;
     QStringList newDirectories;
     collectDirectories(*entry, previousDirectories);
     collectDirectories(*result, newDirectories);
 
+    // A directory within a project folder is left out when it became empty
+    const bool removeEntry = entry->parent && result->entries.empty();
+    if (removeEntry)
+        previousDirectories.append(entry->filePath);
+
     // First add the new paths to avoid needlessly unwatching/watching paths
     mWatcher.addPaths(newDirectories);
     mWatcher.removePaths(previousDirectories);
 
     emit aboutToRefresh();
 
-    if (!entry->entries.empty()) {
-        beginRemoveRows(index, 0, int(entry->entries.size() - 1));
-        entry->entries.clear();
+    invalidateFileIndex();
+
+    if (removeEntry) {
+        FolderEntry *parent = entry->parent;
+        auto &siblings = parent->entries;
+        const auto it = std::find_if(siblings.begin(), siblings.end(),
+                                     [entry] (const std::unique_ptr<FolderEntry> &value) { return value.get() == entry; });
+        const int row = int(std::distance(siblings.begin(), it));
+
+        beginRemoveRows(indexForEntry(parent), row, row);
+        siblings.erase(it);
         endRemoveRows();
-    }
+    } else {
+        if (!entry->entries.empty()) {
+            beginRemoveRows(index, 0, int(entry->entries.size() - 1));
+            entry->entries.clear();
+            endRemoveRows();
+        }
 
-    if (!result->entries.empty()) {
-        beginInsertRows(index, 0, int(result->entries.size() - 1));
-        entry->entries.swap(result->entries);
+        if (!result->entries.empty()) {
+            beginInsertRows(index, 0, int(result->entries.size() - 1));
+            entry->entries.swap(result->entries);
 
-        // Fix up parent pointers
-        for (auto &childEntry: entry->entries)
-            childEntry->parent = entry.get();
+            // Fix up parent pointers
+            for (auto &childEntry: entry->entries)
+                childEntry->parent = entry;
 
-        endInsertRows();
+            endInsertRows();
+        }
     }
 
     emit refreshed();
 
-    if (!mFoldersPendingScan.isEmpty()) {
-        mScanningFolder = mFoldersPendingScan.takeFirst();
-        emit scanFolder(mScanningFolder);
-    } else {
-        mScanningFolder.clear();
-    }
-
-    emit dataChanged(index, index, { Qt::DisplayRole });
+    // Update the "Refreshing" label
+    if (!entry->parent)
+        emit dataChanged(index, index, { Qt::DisplayRole });
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -493,19 +671,47 @@ void FolderScanner::setNameFilters(const QStringList &nameFilters)
     mNameFilters = nameFilters;
 }
 
-void FolderScanner::scanFolder(const QString &folder)
+/**
+ * Scans the given \a folder. For project folders, the first scan first reports
+ * the contents stored in the index by a previous session, so they can be
+ * shown immediately, and the index is updated after each scan.
+ */
+void FolderScanner::scanFolder(const QString &folder, bool isProjectFolder)
 {
-    QSet<QString> visitedFolders;
+    if (isProjectFolder && !mIndexedFolders.contains(folder)) {
+        mIndexedFolders.insert(folder);
+        if (auto entry = readIndex(folder))
+            emit scanFinished(entry.release(), true);
+    }
+
+    VisitedFolders visitedFolders;
     auto entry = std::make_unique<FolderEntry>(folder);
-    scan(*entry, visitedFolders);
+    scan(*entry, visitedFolders, 0);
+
+#ifndef Q_OS_WASM
+    if (isProjectFolder && !thread()->isInterruptionRequested())
+#else
+    if (isProjectFolder)
+#endif
+        writeIndex(*entry);
 
-    emit scanFinished(entry.release());
+    emit scanFinished(entry.release(), false);
 }
 
-void FolderScanner::scan(FolderEntry &folder, QSet<QString> &visitedFolders) const
+bool FolderScanner::VisitedFolders::insert(const QString &canonicalPath)
+{
+    QMutexLocker locker(&mutex);
+    if (paths.contains(canonicalPath))
+        return false;
+    paths.insert(canonicalPath);
+    return true;
+}
+
+void FolderScanner::scan(FolderEntry &folder, VisitedFolders &visitedFolders, int depth) const
 {
 #ifndef Q_OS_WASM
-    if (QThread::currentThread()->isInterruptionRequested())
+    // Checking the scanner's thread, since this may run on the thread pool
+    if (thread()->isInterruptionRequested())
         return;
 #endif
 
@@ -513,28 +719,144 @@ void FolderScanner::scan(FolderEntry &folder, QSet<QString> &visitedFolders) con
     // Get unsorted list - sorting is handled by ProjectProxyModel
     const auto list = QDir(folder.filePath).entryInfoList(mNameFilters, filters, QDir::NoSort);
 
+    std::vector<std::unique_ptr<FolderEntry>> entries;
+    std::vector<FolderEntry*> directories;
+    entries.reserve(list.size());
+
     for (const auto &fileInfo : list) {
         auto entry = std::make_unique<FolderEntry>(fileInfo.filePath(), &folder);
         entry->isDir = fileInfo.isDir();
 
-        if (fileInfo.isDir()) {
-            const QString canonicalPath = fileInfo.canonicalFilePath();
-
+        if (entry->isDir) {
             // prevent potential endless symlink loop
-            if (!visitedFolders.contains(canonicalPath)) {
-                visitedFolders.insert(canonicalPath);
-                scan(*entry, visitedFolders);
-            }
-
-            // Leave out empty directories
-            if (entry->entries.empty())
+            if (!visitedFolders.insert(fileInfo.canonicalFilePath()))
                 continue;
+
+            directories.push_back(entry.get());
         }
 
+        entries.push_back(std::move(entry));
+    }
+
+    auto scanDirectory = [&] (FolderEntry *entry) {
+        scan(*entry, visitedFolders, depth + 1);
+    };
+
+    // The top levels of the tree are scanned in parallel, which helps
+    // especially when the files are on network storage
+    constexpr int parallelScanDepth = 2;
+    if (depth < parallelScanDepth && directories.size() > 1)
+        QtConcurrent::blockingMap(directories, scanDirectory);
+    else
+        std::for_each(directories.begin(), directories.end(), scanDirectory);
+
+    for (auto &entry : entries) {
+        // Leave out empty directories
+        if (entry->isDir && entry->entries.empty())
+            continue;
+
         folder.entries.push_back(std::move(entry));
     }
 }
 
+static const quint32 projectIndexMagic = 0x54505849;   // "TPXI"
+static const quint32 projectIndexVersion = 1;
+
+static QString indexFileName(const QString &folder)
+{
+    const QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (cacheLocation.isEmpty())
+        return QString();
+
+    const QByteArray hash = QCryptographicHash::hash(folder.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QDir(cacheLocation).filePath(QStringLiteral("projectfolders/%1.index").arg(QString::fromLatin1(hash)));
+}
+
+static void writeEntries(QDataStream &stream, const FolderEntry &folder)
+{
+    const int prefixLength = childPath(folder.filePath, QString()).size();
+
+    stream << quint32(folder.entries.size());
+
+    for (const auto &entry : folder.entries) {
+        stream << entry->filePath.mid(prefixLength) << entry->isDir;
+        if (entry->isDir)
+            writeEntries(stream, *entry);
+    }
+}
+
+static bool readEntries(QDataStream &stream, FolderEntry &folder)
+{
+    quint32 count;
+    stream >> count;
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString fileName;
+        bool isDir;
+        stream >> fileName >> isDir;
+
+        auto entry = std::make_unique<FolderEntry>(childPath(folder.filePath, fileName), &folder);
+        entry->isDir = isDir;
+
+        if (isDir && !readEntries(stream, *entry))
+            return false;
+
+        folder.entries.push_back(std::move(entry));
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+/**
+ * Reads the contents of the given project \a folder as stored by a previous
+ * scan. Returns null when there is no usable index.
+ */
+std::unique_ptr<FolderEntry> FolderScanner::readIndex(const QString &folder) const
+{
+    QFile file(indexFileName(folder));
+    if (!file.open(QIODevice::ReadOnly))
+        return nullptr;
+
+    QDataStream stream(&file);
+
+    quint32 magic, version;
+    QString indexedFolder;
+    QStringList nameFilters;
+    stream >> magic >> version;
+    if (magic != projectIndexMagic || version != projectIndexVersion)
+        return nullptr;
+
+    // The index is only valid when it was made with the same name filters
+    stream >> indexedFolder >> nameFilters;
+    if (indexedFolder != folder || nameFilters != mNameFilters)
+        return nullptr;
+
+    auto entry = std::make_unique<FolderEntry>(folder);
+    if (!readEntries(stream, *entry))
+        return nullptr;
+
+    return entry;
+}
+
+void FolderScanner::writeIndex(const FolderEntry &folder) const
+{
+    const QString fileName = indexFileName(folder.filePath);
+    if (fileName.isEmpty() || !QDir().mkpath(QFileInfo(fileName).absolutePath()))
+        return;
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream << projectIndexMagic << projectIndexVersion
+           << folder.filePath << mNameFilters;
+    writeEntries(stream, folder);
+
+    if (stream.status() == QDataStream::Ok)
+        file.commit();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 ProjectProxyModel::ProjectProxyModel(QObject *parent)
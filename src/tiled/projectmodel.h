@@ -82,6 +82,7 @@ public:
     };
 
     QVector<Match> findFiles(const QStringList &words) const;
+    QStringList files() const;
 
     QString filePath(const QModelIndex &index) const;
 
@@ -104,7 +105,7 @@ signals:
     void folderRemoved(const QString &folder);
 
     void nameFiltersChanged(const QStringList &nameFilters);
-    void scanFolder(const QString &folder);
+    void scanFolder(const QString &folder, bool isProjectFolder);
 
     void aboutToRefresh();
     void refreshed();
@@ -117,8 +118,12 @@ private:
 
     void pathsChanged(const QStringList &paths);
 
+    void invalidateFileIndex();
+    void updateFileIndex() const;
+
     void scheduleFolderScan(const QString &folder);
-    void folderScanned(FolderEntry *entry);
+    bool isProjectFolder(const QString &folder) const;
+    void folderScanned(FolderEntry *entry, bool fromIndex);
 
     std::unique_ptr<ProjectDocument> mProjectDocument;
     Project mEmptyProject;
@@ -128,6 +133,21 @@ private:
 
     std::vector<std::unique_ptr<FolderEntry>> mFolders;
 
+    // Flat list of all files, used by findFiles
+    struct IndexedFile
+    {
+        QString path;
+        int offset;
+        quint64 characters;     // see characterMask
+    };
+
+    mutable std::vector<IndexedFile> mFileIndex;
+    mutable bool mFileIndexValid = false;
+
+    // The previous search, since typing more narrows down its matches
+    mutable QStringList mLastSearchWords;
+    mutable QVector<int> mLastSearchMatches;
+
     QThread mScanningThread;
     QString mScanningFolder;
     QStringList mFoldersPendingScan;
@@ -144,6 +144,8 @@ template<> EnumData enumData<Map::LayerDataFormat>()
     if (compressionSupported(Zstandard)) {
         names.append(QCoreApplication::translate("PreferencesDialog", "Base64 (Zstandard compressed)"));
         values.append(Map::Base64Zstandard);
+        names.append(QCoreApplication::translate("PreferencesDialog", "Base64 (Zstandard compressed, shared dictionary)"));
+        values.append(Map::Base64ZstandardDictionary);
     }
 
     return { names, values };
@@ -488,6 +490,7 @@ public:
     }
 
     void setDocument(Document *document);
+    void refreshIfScheduled();
 
     MapDocument *mapDocument() const override
     {
@@ -513,12 +516,12 @@ private:
 
         if (objectsChange.properties & ObjectsChangeEvent::ClassProperty) {
             if (objectsChange.objects.contains(object)) {
-                refresh();
+                scheduleRefresh();
             } else if (object->typeId() == Object::MapObjectType) {
                 auto mapObject = static_cast<MapObject*>(object);
                 if (auto tile = mapObject->cell().tile()) {
                     if (mapObject->className().isEmpty() && objectsChange.objects.contains(tile))
-                        refresh();
+                        scheduleRefresh();
                 }
             }
         }
@@ -529,7 +532,7 @@ private:
             return;
         if (!objectPropertiesRelevant(mDocument, object))
             return;
-        refresh();
+        scheduleRefresh();
     }
 
     void propertyRemoved(Object *object, const QString &) {
@@ -537,7 +540,7 @@ private:
             return;
         if (!objectPropertiesRelevant(mDocument, object))
             return;
-        refresh();
+        scheduleRefresh();
     }
 
     void propertyChanged(Object *object, const QString &name) {
@@ -545,20 +548,22 @@ private:
             return;
         if (!propertyValueAffected(mDocument->currentObject(), object, name))
             return;
-        refresh();
+        scheduleRefresh();
     }
 
     void propertiesChanged(Object *object) {
         if (!objectPropertiesRelevant(mDocument, object))
             return;
-        refresh();
+        scheduleRefresh();
     }
 
     void refresh();
+    void scheduleRefresh();
 
     void setPropertyValue(const PropertyPath &path, const QVariant &value);
 
     bool mUpdating = false;
+    bool mRefreshScheduled = false;
 };
 
 
@@ -947,6 +952,7 @@ private:
         case Map::Base64Gzip:
         case Map::Base64Zlib:
         case Map::Base64Zstandard:
+        case Map::Base64ZstandardDictionary:
             mCompressionLevelProperty->setEnabled(true);
             break;
         }
@@ -1961,10 +1967,16 @@ public:
                     this, &TileProperties::tileProbabilityChanged);
         } else if (auto mapDocument = qobject_cast<MapDocument*>(document)) {
             connect(mapDocument, &MapDocument::tileImageSourceChanged,
-                    this, &TileProperties::tileImageSourceChanged);
+                    this, [this] (const QList<Tile*> &tiles) {
+                if (tiles.contains(tile()))
+                    tileImageSourceChanged(tile());
+            });
 
             connect(mapDocument, &MapDocument::tileProbabilityChanged,
-                    this, &TileProperties::tileProbabilityChanged);
+                    this, [this] (const QList<Tile*> &tiles) {
+                if (tiles.contains(tile()))
+                    tileProbabilityChanged(tile());
+            });
         }
 
         updateEnabledState();
@@ -2325,6 +2337,9 @@ GroupProperty *PropertiesWidget::customPropertiesGroup() const
 
 void PropertiesWidget::selectCustomProperty(const QString &name, bool focus)
 {
+    // The property may have just been added
+    mCustomProperties->refreshIfScheduled();
+
     if (auto property = mCustomProperties->property(name)) {
         if (focus)
             mPropertiesView->focusProperty(property);
@@ -2528,8 +2543,31 @@ static void addAutomappingProperties(Properties &properties, const Object *objec
     }
 }
 
+/**
+ * Refreshes the custom properties once control returns to the event loop.
+ * Used for changes to the properties of objects, since changing the
+ * properties of many objects at once emits a signal for each of them.
+ */
+void CustomProperties::scheduleRefresh()
+{
+    if (mRefreshScheduled)
+        return;
+
+    mRefreshScheduled = true;
+    QMetaObject::invokeMethod(this, &CustomProperties::refreshIfScheduled,
+                              Qt::QueuedConnection);
+}
+
+void CustomProperties::refreshIfScheduled()
+{
+    if (mRefreshScheduled)
+        refresh();
+}
+
 void CustomProperties::refresh()
 {
+    mRefreshScheduled = false;
+
     if (!mDocument || !mDocument->currentObject()) {
         setValue({});
         return;
@@ -2700,6 +2738,7 @@ void PropertiesWidget::paste()
     }
 
     // Select the pasted properties
+    mCustomProperties->refreshIfScheduled();
     QList<Property*> selectedProperties;
     for (const QString &name : pastedProperties.keys()) {
         if (auto property = mCustomProperties->property(name))
@@ -3010,6 +3049,7 @@ void PropertiesWidget::showContextMenu(const QPoint &pos)
         undoStack->endMacro();
 
         // Restore selected properties
+        mCustomProperties->refreshIfScheduled();
         QList<Property*> selectedProperties;
         for (const QString &name : state.customPropertyNames) {
             if (auto property = mCustomProperties->property(name))
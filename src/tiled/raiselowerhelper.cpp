@@ -221,7 +221,7 @@ bool RaiseLowerHelper::initContext()
         if (object->objectGroup() != mObjectGroup)
             return false;
 
-        QPainterPath path = renderer->shape(object);
+        QPainterPath path = renderer->cachedShape(object);
         QPointF screenPos = renderer->pixelToScreenCoords(object->position());
         path = rotateAt(screenPos, object->rotation()).map(path);
         path.translate(mMapScene->absolutePositionForLayer(*object->objectGroup()));
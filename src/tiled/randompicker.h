@@ -21,14 +21,20 @@
 #pragma once
 
 #include <QMap>
+#include <QVector>
 
 #include <random>
+#include <type_traits>
 
 namespace Tiled {
 
+/**
+ * Returns a random engine for the calling thread, so that random picks can
+ * be made from several threads without sharing state.
+ */
 inline std::default_random_engine &globalRandomEngine()
 {
-    static std::default_random_engine engine(std::random_device{}());
+    thread_local std::default_random_engine engine(std::random_device{}());
     return engine;
 }
 
@@ -78,6 +84,21 @@ public:
         return it.value();
     }
 
+    /**
+     * Picks a value using the given \a random number in the range [0, 1),
+     * for when the choice needs to be reproducible.
+     */
+    const T &pick(Real random) const
+    {
+        Q_ASSERT(!isEmpty());
+
+        auto it = mThresholds.lowerBound(random * mSum);
+        if (it == mThresholds.end())
+            --it;
+
+        return it.value();
+    }
+
     //same as pick, but removes the selected element.
     T take()
     {
@@ -94,6 +115,23 @@ public:
         return result;
     }
 
+    /**
+     * Same as take(), but using the given \a random number in the range
+     * [0, 1), for when the choice needs to be reproducible.
+     */
+    T take(Real random)
+    {
+        Q_ASSERT(!isEmpty());
+
+        auto it = mThresholds.lowerBound(random * mSum);
+        if (it == mThresholds.end())
+            --it;
+
+        const T result = it.value();
+        mThresholds.erase(it);
+        return result;
+    }
+
     void clear()
     {
         mSum = 0.0;
@@ -105,4 +143,150 @@ private:
     QMap<Real, T> mThresholds;
 };
 
+/**
+ * A picker of random things that each have a probability assigned, which
+ * picks in constant time using Vose's alias method.
+ *
+ * The alias table is built on the first pick after values were added. Call
+ * prepare() before picking from multiple threads at once.
+ *
+ * Unlike RandomPicker, values can't be taken out of this picker.
+ */
+template<typename T, typename Real = qreal>
+class AliasRandomPicker
+{
+public:
+    void add(const T &value, Real probability = 1.0)
+    {
+        if (probability > 0) {
+            mValues.append(value);
+            mWeights.append(probability);
+            mSum += probability;
+            mDirty = true;
+        }
+    }
+
+    bool isEmpty() const
+    {
+        return mValues.isEmpty();
+    }
+
+    qsizetype size() const
+    {
+        return mValues.size();
+    }
+
+    /**
+     * Builds the alias table, if needed.
+     */
+    void prepare() const
+    {
+        if (mDirty)
+            buildTable();
+    }
+
+    const T &pick() const
+    {
+        return pick(globalRandomEngine());
+    }
+
+    /**
+     * Picks a value using the given random \a engine, for when the sequence
+     * of choices should be determined by a seed.
+     */
+    template<typename Engine,
+             typename = std::enable_if_t<!std::is_arithmetic_v<Engine>>>
+    const T &pick(Engine &engine) const
+    {
+        std::uniform_real_distribution<Real> dis(0, 1);
+        return pick(dis(engine));
+    }
+
+    /**
+     * Picks a value using the given \a random number in the range [0, 1),
+     * for when the choice needs to be reproducible.
+     */
+    const T &pick(Real random) const
+    {
+        Q_ASSERT(!isEmpty());
+
+        const int count = mValues.size();
+        if (count == 1)
+            return mValues.first();
+
+        prepare();
+
+        // The integer part selects a column, the fraction decides between
+        // the column's own value and its alias
+        const Real scaled = random * count;
+        const int index = qBound(0, static_cast<int>(scaled), count - 1);
+        const Real fraction = scaled - index;
+
+        if (fraction < mProbabilities.at(index))
+            return mValues.at(index);
+        return mValues.at(mAliases.at(index));
+    }
+
+    void clear()
+    {
+        mSum = 0.0;
+        mValues.clear();
+        mWeights.clear();
+        mProbabilities.clear();
+        mAliases.clear();
+        mDirty = false;
+    }
+
+private:
+    void buildTable() const
+    {
+        const int count = mValues.size();
+
+        mProbabilities.resize(count);
+        mAliases.resize(count);
+
+        QVector<Real> scaled(count);
+        QVector<int> small;
+        QVector<int> large;
+
+        for (int i = 0; i < count; ++i) {
+            scaled[i] = mWeights.at(i) * count / mSum;
+            mAliases[i] = i;
+            if (scaled.at(i) < 1)
+                small.append(i);
+            else
+                large.append(i);
+        }
+
+        while (!small.isEmpty() && !large.isEmpty()) {
+            const int s = small.takeLast();
+            const int l = large.last();
+
+            mProbabilities[s] = scaled.at(s);
+            mAliases[s] = l;
+
+            scaled[l] = (scaled.at(l) + scaled.at(s)) - 1;
+            if (scaled.at(l) < 1) {
+                large.removeLast();
+                small.append(l);
+            }
+        }
+
+        // Whatever remains is at probability 1, up to rounding errors
+        for (int i : std::as_const(large))
+            mProbabilities[i] = 1;
+        for (int i : std::as_const(small))
+            mProbabilities[i] = 1;
+
+        mDirty = false;
+    }
+
+    Real mSum = 0.0;
+    QVector<T> mValues;
+    QVector<Real> mWeights;
+    mutable QVector<Real> mProbabilities;
+    mutable QVector<int> mAliases;
+    mutable bool mDirty = false;
+};
+
 } // namespace Tiled
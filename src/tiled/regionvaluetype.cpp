@@ -25,7 +25,7 @@
 namespace Tiled {
 
 RegionValueType::RegionValueType(int x, int y, int w, int h)
-    : mRegion(x, y, w, h)
+    : mRegion(QRect(x, y, w, h))
 {
 }
 
@@ -39,9 +39,14 @@ RegionValueType::RegionValueType(const QRegion &region)
 {
 }
 
+RegionValueType::RegionValueType(const TileRegion &region)
+    : mRegion(region)
+{
+}
+
 QString RegionValueType::toString() const
 {
-    switch (mRegion.rectCount()) {
+    switch (mRegion.rects().size()) {
     case 0:
         return QStringLiteral("Region(empty)");
     case 1: {
@@ -56,7 +61,7 @@ QString RegionValueType::toString() const
 
 QVector<RegionValueType> RegionValueType::contiguousRegions() const
 {
-    const auto regions = Tiled::coherentRegions(mRegion);
+    const auto regions = Tiled::coherentRegions(region());
     QVector<RegionValueType> regionValues;
     for (const auto &region : regions)
         regionValues.append(RegionValueType(region));
@@ -65,7 +70,7 @@ QVector<RegionValueType> RegionValueType::contiguousRegions() const
 
 QVector<QRect> RegionValueType::rects() const
 {
-    return QVector<QRect>(mRegion.begin(), mRegion.end());
+    return mRegion.rects();
 }
 
 } // namespace Tiled
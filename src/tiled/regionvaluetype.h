@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include "tileregion.h"
+
 #include <QObject>
 #include <QRegion>
 #include <QVector>
@@ -38,6 +40,7 @@ public:
     RegionValueType(int x, int y, int w, int h);
     explicit RegionValueType(const QRect &rect);
     explicit RegionValueType(const QRegion &region);
+    explicit RegionValueType(const TileRegion &region);
 
     Q_INVOKABLE QString toString() const;
 
@@ -59,16 +62,17 @@ public:
     QRect boundingRect() const;
     QVector<QRect> rects() const;
 
-    const QRegion &region() const;
+    QRegion region() const;
+    const TileRegion &tileRegion() const;
 
 private:
-    QRegion mRegion;
+    TileRegion mRegion;
 };
 
 
 inline bool RegionValueType::contains(int x, int y) const
 {
-    return mRegion.contains(QPoint(x, y));
+    return mRegion.contains(x, y);
 }
 
 inline bool RegionValueType::contains(QPoint point) const
@@ -78,7 +82,7 @@ inline bool RegionValueType::contains(QPoint point) const
 
 inline void RegionValueType::add(const QRect &rect)
 {
-    mRegion += rect;
+    mRegion.add(rect);
 }
 
 inline void RegionValueType::add(const QRectF &rect)
@@ -88,12 +92,12 @@ inline void RegionValueType::add(const QRectF &rect)
 
 inline void RegionValueType::add(const RegionValueType &region)
 {
-    mRegion += region.region();
+    mRegion.add(region.tileRegion());
 }
 
 inline void RegionValueType::subtract(const QRect &rect)
 {
-    mRegion -= rect;
+    mRegion.subtract(rect);
 }
 
 inline void RegionValueType::subtract(const QRectF &rect)
@@ -103,12 +107,12 @@ inline void RegionValueType::subtract(const QRectF &rect)
 
 inline void RegionValueType::subtract(const RegionValueType &region)
 {
-    mRegion -= region.region();
+    mRegion.subtract(region.tileRegion());
 }
 
 inline void RegionValueType::intersect(const QRect &rect)
 {
-    mRegion &= rect;
+    mRegion.intersect(rect);
 }
 
 inline void RegionValueType::intersect(const QRectF &rect)
@@ -118,7 +122,7 @@ inline void RegionValueType::intersect(const QRectF &rect)
 
 inline void RegionValueType::intersect(const RegionValueType &region)
 {
-    mRegion &= region.region();
+    mRegion.intersect(region.tileRegion());
 }
 
 inline QRect RegionValueType::boundingRect() const
@@ -126,7 +130,12 @@ inline QRect RegionValueType::boundingRect() const
     return mRegion.boundingRect();
 }
 
-inline const QRegion &RegionValueType::region() const
+inline QRegion RegionValueType::region() const
+{
+    return mRegion.toQRegion();
+}
+
+inline const TileRegion &RegionValueType::tileRegion() const
 {
     return mRegion;
 }
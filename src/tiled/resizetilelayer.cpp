@@ -46,6 +46,20 @@ ResizeTileLayer::ResizeTileLayer(MapDocument *mapDocument,
     mResizedLayer->resize(size, offset);
 }
 
+ResizeTileLayer::ResizeTileLayer(MapDocument *mapDocument,
+                                 TileLayer *layer,
+                                 TileLayer *resizedLayer,
+                                 QUndoCommand *parent)
+    : QUndoCommand(QCoreApplication::translate("Undo Commands",
+                                               "Resize Layer"),
+                   parent)
+    , mMapDocument(mapDocument)
+    , mDone(false)
+    , mOriginalLayer(layer)
+    , mResizedLayer(resizedLayer)
+{
+}
+
 ResizeTileLayer::~ResizeTileLayer()
 {
     if (mDone)
@@ -47,6 +47,15 @@ public:
                     QPoint offset,
                     QUndoCommand *parent = nullptr);
 
+    /**
+     * Creates an undo command that replaces \a layer with the already
+     * resized \a resizedLayer, taking ownership of it.
+     */
+    ResizeTileLayer(MapDocument *mapDocument,
+                    TileLayer *layer,
+                    TileLayer *resizedLayer,
+                    QUndoCommand *parent = nullptr);
+
     ~ResizeTileLayer() override;
 
     void undo() override;
@@ -21,6 +21,7 @@
 #include "scriptedaction.h"
 
 #include "scriptmanager.h"
+#include "scriptprofiler.h"
 
 #include <QJSEngine>
 
@@ -32,6 +33,7 @@ ScriptedAction::ScriptedAction(Id id,
     : QAction(parent)
     , mId(id)
     , mCallback(callback)
+    , mExtension(ScriptManager::instance().currentExtension())
 {
     static QIcon scriptIcon = [] {
         QIcon icon(QStringLiteral("://images/32/plugin.png"));
@@ -43,6 +45,8 @@ ScriptedAction::ScriptedAction(Id id,
     setIcon(scriptIcon);
 
     connect(this, &QAction::triggered, this, [this] {
+        const ScriptProfiler::Scope profile(mExtension, QStringLiteral("Action '%1'").arg(mId.toString()));
+
         QJSValueList arguments;
         arguments.append(ScriptManager::instance().engine()->newQObject(this));
 
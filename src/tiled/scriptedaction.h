@@ -49,6 +49,7 @@ private:
     Id mId;
     QJSValue mCallback;
     QString mIconFileName;
+    QString mExtension;
 };
 
 
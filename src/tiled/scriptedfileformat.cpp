@@ -24,6 +24,7 @@
 #include "editabletileset.h"
 #include "savefile.h"
 #include "scriptmanager.h"
+#include "scriptprofiler.h"
 
 #include <QCoreApplication>
 #include <QFile>
@@ -35,6 +36,7 @@ namespace Tiled {
 
 ScriptedFileFormat::ScriptedFileFormat(const QJSValue &object)
     : mObject(object)
+    , mExtension(ScriptManager::instance().currentExtension())
 {
 }
 
@@ -72,6 +74,7 @@ QJSValue ScriptedFileFormat::read(const QString &fileName)
     QJSValueList arguments;
     arguments.append(fileName);
 
+    const ScriptProfiler::Scope profile(mExtension, callbackName("read"));
     return mObject.property(QStringLiteral("read")).call(arguments);
 }
 
@@ -87,7 +90,10 @@ bool ScriptedFileFormat::write(EditableAsset *asset,
     arguments.append(fileName);
     arguments.append(static_cast<FileFormat::Options::Int>(options));
 
-    QJSValue resultValue = mObject.property(QStringLiteral("write")).call(arguments);
+    QJSValue resultValue = [&] {
+        const ScriptProfiler::Scope profile(mExtension, callbackName("write"));
+        return mObject.property(QStringLiteral("write")).call(arguments);
+    }();
     if (ScriptManager::instance().checkError(resultValue)) {
         error = resultValue.toString();
         return false;
@@ -114,7 +120,10 @@ QStringList ScriptedFileFormat::outputFiles(EditableAsset *asset, const QString
     arguments.append(ScriptManager::instance().engine()->newQObject(asset));
     arguments.append(fileName);
 
-    QJSValue resultValue = outputFiles.call(arguments);
+    QJSValue resultValue = [&] {
+        const ScriptProfiler::Scope profile(mExtension, callbackName("outputFiles"));
+        return outputFiles.call(arguments);
+    }();
 
     if (resultValue.isString())
         return QStringList(resultValue.toString());
@@ -131,6 +140,12 @@ QStringList ScriptedFileFormat::outputFiles(EditableAsset *asset, const QString
     return QStringList(fileName);
 }
 
+QString ScriptedFileFormat::callbackName(const char *function) const
+{
+    return QStringLiteral("Format '%1': %2").arg(mObject.property(QStringLiteral("name")).toString(),
+                                                 QLatin1String(function));
+}
+
 bool ScriptedFileFormat::validateFileFormatObject(const QJSValue &value)
 {
     const QJSValue nameProperty = value.property(QStringLiteral("name"));
@@ -47,7 +47,10 @@ public:
     static bool validateFileFormatObject(const QJSValue &value);
 
 private:
+    QString callbackName(const char *function) const;
+
     QJSValue mObject;
+    QString mExtension;
 };
 
 class ScriptedMapFormat final : public MapFormat
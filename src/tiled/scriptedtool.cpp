@@ -28,6 +28,7 @@
 #include "mapdocument.h"
 #include "pluginmanager.h"
 #include "scriptmanager.h"
+#include "scriptprofiler.h"
 #include "tile.h"
 #include "tilesetdocument.h"
 
@@ -42,6 +43,7 @@ namespace Tiled {
 ScriptedTool::ScriptedTool(Id id, QJSValue object, QObject *parent)
     : AbstractTileTool(id, QStringLiteral("<unnamed tool>"), QIcon(), QKeySequence(), nullptr, parent)
     , mScriptObject(std::move(object))
+    , mExtension(ScriptManager::instance().currentExtension())
 {
     // Read out the properties from the script object before setting its prototype
     const QJSValue nameProperty = mScriptObject.property(QStringLiteral("name"));
@@ -321,6 +323,7 @@ bool ScriptedTool::call(const QString &methodName, const QJSValueList &args)
 {
     QJSValue method = mScriptObject.property(methodName);
     if (method.isCallable()) {
+        const ScriptProfiler::Scope profile(mExtension, QStringLiteral("Tool '%1': %2").arg(name(), methodName));
         auto &scriptManager = ScriptManager::instance();
         QJSValue result = method.callWithInstance(mScriptObject, args);
         scriptManager.checkError(result);
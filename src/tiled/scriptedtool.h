@@ -84,6 +84,7 @@ private:
 
     QJSValue mScriptObject;
     QString mIconFileName;
+    QString mExtension;
     QList<Id> mToolBarActions;
 };
 
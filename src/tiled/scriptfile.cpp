@@ -176,6 +176,7 @@ public:
     Q_INVOKABLE void seek(qint64 pos);
     Q_INVOKABLE QByteArray read(qint64 size);
     Q_INVOKABLE QByteArray readAll();
+    Q_INVOKABLE QByteArray map(qint64 offset, qint64 length = -1);
     Q_INVOKABLE void write(const QByteArray &data);
     Q_INVOKABLE void commit();
     Q_INVOKABLE void close();
@@ -216,6 +217,7 @@ public:
 
     Q_INVOKABLE QString readLine();
     Q_INVOKABLE QString readAll();
+    Q_INVOKABLE QJSValue lines();
     bool atEof() const;
     Q_INVOKABLE void truncate();
     Q_INVOKABLE void write(const QString &string);
@@ -568,6 +570,40 @@ QByteArray ScriptBinaryFile::readAll()
     return data;
 }
 
+QByteArray ScriptBinaryFile::map(qint64 offset, qint64 length)
+{
+    if (checkForClosed())
+        return {};
+
+    const qint64 fileSize = m_file->size();
+    if (length < 0)
+        length = fileSize - offset;
+
+    if (Q_UNLIKELY(offset < 0 || offset > fileSize || length > fileSize - offset)) {
+        ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors",
+                                                                         "Offset and length are outside of the file"));
+        return {};
+    }
+
+    if (length == 0)
+        return QByteArray();
+
+    // The mapped pages are copied straight into the returned buffer, which
+    // avoids going through the buffer of the file and doesn't change the
+    // current position.
+    uchar *mapped = m_file->map(offset, length);
+    if (Q_UNLIKELY(!mapped)) {
+        ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors",
+                                                                         "Could not map '%1': %2").arg(m_file->fileName(),
+                                                                                                       m_file->errorString()));
+        return {};
+    }
+
+    const QByteArray data(reinterpret_cast<const char*>(mapped), length);
+    m_file->unmap(mapped);
+    return data;
+}
+
 void ScriptBinaryFile::write(const QByteArray &data)
 {
     if (checkForClosed())
@@ -705,6 +741,34 @@ QString ScriptTextFile::readAll()
     return m_stream->readAll();
 }
 
+/**
+ * Returns an iterable that reads the remaining lines of the file one at a
+ * time, so that large files can be processed without reading them at once.
+ */
+QJSValue ScriptTextFile::lines()
+{
+    if (checkForClosed())
+        return {};
+
+    QJSEngine *engine = qjsEngine(this);
+    if (!engine)
+        return {};
+
+    QJSValue makeIterable = engine->evaluate(QStringLiteral(
+        "(function(file) {"
+        "    return {"
+        "        [Symbol.iterator]() { return this; },"
+        "        next() {"
+        "            if (file.atEof)"
+        "                return { done: true, value: undefined };"
+        "            return { done: false, value: file.readLine() };"
+        "        }"
+        "    };"
+        "})"));
+
+    return makeIterable.call({ engine->newQObject(this) });
+}
+
 bool ScriptTextFile::atEof() const
 {
     if (checkForClosed())
@@ -24,8 +24,12 @@
 
 #include <QBuffer>
 #include <QCoreApplication>
+#include <QHash>
 #include <QJSEngine>
 
+#include <array>
+#include <cstring>
+
 namespace Tiled {
 
 ScriptImage::ScriptImage(QObject *parent)
@@ -79,33 +83,202 @@ QJSValue ScriptImage::colorTable() const
     return array;
 }
 
-void ScriptImage::setColorTable(QJSValue colors)
+/**
+ * Converts the given array of colors, given as numbers or color names.
+ * Returns false and throws a script error when a color is invalid.
+ */
+static bool parseColors(const QJSValue &colors, QVector<QRgb> &result)
 {
-    QVector<QRgb> colorTable;
-
     const int length = colors.property(QStringLiteral("length")).toInt();
-    colorTable.resize(length);
+    result.resize(length);
 
     for (int i = 0; i < length; ++i) {
         const QJSValue color = colors.property(i);
         if (color.isNumber()) {
-            colorTable[i] = color.toUInt();
+            result[i] = color.toUInt();
         } else if (color.isString()) {
             const QString colorName = color.toString();
             if (QColor::isValidColor(colorName)) {
-                colorTable[i] = QColor(colorName).rgba();
+                result[i] = QColor(colorName).rgba();
             } else {
                 ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors",
                                                                                  "Invalid color name: '%2'").arg(colorName));
-                return;
+                return false;
             }
         } else {
             ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Invalid color value"));
-            return;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ScriptImage::setColorTable(QJSValue colors)
+{
+    QVector<QRgb> colorTable;
+    if (parseColors(colors, colorTable))
+        mImage.setColorTable(std::move(colorTable));
+}
+
+/**
+ * Returns a copy of the pixel data, with each line taking bytesPerLine bytes.
+ */
+QByteArray ScriptImage::bits() const
+{
+    return QByteArray(reinterpret_cast<const char*>(mImage.constBits()),
+                      int(mImage.sizeInBytes()));
+}
+
+/**
+ * Replaces the pixel data with the given ArrayBuffer or typed array, which
+ * needs to be of the same size as returned by bits().
+ */
+void ScriptImage::setBits(const QJSValue &data)
+{
+    // Typed arrays are views on a range of an ArrayBuffer
+    QByteArray bytes;
+    const QJSValue buffer = data.property(QStringLiteral("buffer"));
+    if (buffer.isUndefined()) {
+        bytes = data.toVariant().toByteArray();
+    } else {
+        bytes = buffer.toVariant().toByteArray().mid(data.property(QStringLiteral("byteOffset")).toInt(),
+                                                     data.property(QStringLiteral("byteLength")).toInt());
+    }
+
+    if (bytes.size() != mImage.sizeInBytes()) {
+        ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Data size does not match the image"));
+        return;
+    }
+
+    std::memcpy(mImage.bits(), bytes.constData(), size_t(bytes.size()));
+}
+
+void ScriptImage::drawImage(ScriptImage *image, int x, int y, qreal opacity,
+                            QPainter::CompositionMode mode)
+{
+    if (!image) {
+        ScriptManager::instance().throwNullArgError(0);
+        return;
+    }
+
+    if (mImage.isNull() || mImage.depth() < 8 || mImage.format() == QImage::Format_Indexed8) {
+        ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Image format not supported for drawing"));
+        return;
+    }
+
+    QPainter painter(&mImage);
+    painter.setCompositionMode(mode);
+    painter.setOpacity(opacity);
+    painter.drawImage(x, y, image->image());
+}
+
+/**
+ * Copies the given \a image to the given location, replacing the pixels,
+ * including their alpha.
+ */
+void ScriptImage::blit(ScriptImage *image, int x, int y)
+{
+    drawImage(image, x, y, 1.0, QPainter::CompositionMode_Source);
+}
+
+/**
+ * Draws the given \a image on top of this image at the given location.
+ */
+void ScriptImage::composite(ScriptImage *image, int x, int y, qreal opacity)
+{
+    drawImage(image, x, y, opacity, QPainter::CompositionMode_SourceOver);
+}
+
+/**
+ * Multiplies each pixel by the given \a color, including its alpha.
+ */
+void ScriptImage::tint(const QColor &color)
+{
+    if (mImage.isNull())
+        return;
+
+    const QRgb rgba = color.rgba();
+    const int tintAlpha = qAlpha(rgba);
+
+    // For premultiplied pixels, the color channels are also affected by the
+    // tint alpha. Lookup tables avoid any divisions in the inner loop.
+    std::array<uchar, 256> red, green, blue, alpha;
+    for (int i = 0; i < 256; ++i) {
+        red[i] = uchar((i * qRed(rgba) * tintAlpha + 32512) / 65025);
+        green[i] = uchar((i * qGreen(rgba) * tintAlpha + 32512) / 65025);
+        blue[i] = uchar((i * qBlue(rgba) * tintAlpha + 32512) / 65025);
+        alpha[i] = uchar((i * tintAlpha + 127) / 255);
+    }
+
+    const QImage::Format format = mImage.format();
+    QImage image = std::move(mImage).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    for (int y = 0; y < image.height(); ++y) {
+        auto line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            const QRgb pixel = line[x];
+            line[x] = qRgba(red[qRed(pixel)],
+                            green[qGreen(pixel)],
+                            blue[qBlue(pixel)],
+                            alpha[qAlpha(pixel)]);
+        }
+    }
+
+    mImage = std::move(image).convertToFormat(format);
+}
+
+/**
+ * Replaces each color in \a from with the color at the same index in \a to.
+ * For indexed images, the color table is changed instead of the pixels.
+ */
+void ScriptImage::remapColors(QJSValue from, QJSValue to)
+{
+    QVector<QRgb> fromColors, toColors;
+    if (!parseColors(from, fromColors) || !parseColors(to, toColors))
+        return;
+
+    if (fromColors.size() != toColors.size()) {
+        ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Color arrays differ in length"));
+        return;
+    }
+
+    QHash<QRgb, QRgb> mapping;
+    mapping.reserve(fromColors.size());
+    for (int i = 0; i < fromColors.size(); ++i)
+        mapping.insert(fromColors.at(i), toColors.at(i));
+
+    if (mapping.isEmpty() || mImage.isNull())
+        return;
+
+    if (mImage.format() == QImage::Format_Indexed8) {
+        QVector<QRgb> colorTable = mImage.colorTable();
+        for (QRgb &color : colorTable)
+            color = mapping.value(color, color);
+        mImage.setColorTable(std::move(colorTable));
+        return;
+    }
+
+    const QImage::Format format = mImage.format();
+    QImage image = std::move(mImage).convertToFormat(QImage::Format_ARGB32);
+
+    // Neighboring pixels often have the same color
+    QRgb lastColor = 0;
+    QRgb lastResult = mapping.value(0, 0);
+
+    for (int y = 0; y < image.height(); ++y) {
+        auto line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            const QRgb pixel = line[x];
+            if (pixel != lastColor) {
+                lastColor = pixel;
+                lastResult = mapping.value(pixel, pixel);
+            }
+            line[x] = lastResult;
         }
     }
 
-    mImage.setColorTable(std::move(colorTable));
+    mImage = std::move(image).convertToFormat(format);
 }
 
 ScriptImage *ScriptImage::copy(QRect rect) const
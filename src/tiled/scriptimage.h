@@ -23,6 +23,7 @@
 #include <QImage>
 #include <QJSValue>
 #include <QObject>
+#include <QPainter>
 
 namespace Tiled {
 
@@ -33,6 +34,7 @@ class ScriptImage : public QObject
     Q_PROPERTY(int width READ width)
     Q_PROPERTY(int height READ height)
     Q_PROPERTY(int depth READ depth)
+    Q_PROPERTY(int bytesPerLine READ bytesPerLine)
     Q_PROPERTY(QSize size READ size)
     Q_PROPERTY(Format format READ format)
 
@@ -102,6 +104,7 @@ public:
     int width() const { return mImage.width(); }
     int height() const { return mImage.height(); }
     int depth() const { return mImage.depth(); }
+    int bytesPerLine() const { return mImage.bytesPerLine(); }
     QSize size() const { return mImage.size(); }
 
     Q_INVOKABLE uint pixel(int x, int y) const
@@ -146,6 +149,14 @@ public:
 
     Q_INVOKABLE void setColorTable(QJSValue colors);
 
+    Q_INVOKABLE QByteArray bits() const;
+    Q_INVOKABLE void setBits(const QJSValue &data);
+
+    Q_INVOKABLE void blit(Tiled::ScriptImage *image, int x = 0, int y = 0);
+    Q_INVOKABLE void composite(Tiled::ScriptImage *image, int x = 0, int y = 0, qreal opacity = 1.0);
+    Q_INVOKABLE void tint(const QColor &color);
+    Q_INVOKABLE void remapColors(QJSValue from, QJSValue to);
+
     Q_INVOKABLE Tiled::ScriptImage *copy(QRect rect = {}) const;
     Q_INVOKABLE Tiled::ScriptImage *copy(int x, int y, int w, int h) const;
     Q_INVOKABLE Tiled::ScriptImage *scaled(int w, int h,
@@ -156,6 +167,9 @@ public:
     const QImage &image() const { return mImage; }
 
 private:
+    void drawImage(ScriptImage *image, int x, int y, qreal opacity,
+                   QPainter::CompositionMode mode);
+
     QByteArray mImageData;
     QImage mImage;
 };
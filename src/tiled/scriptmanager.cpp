@@ -34,6 +34,7 @@
 #include "logginginterface.h"
 #include "mapeditor.h"
 #include "mapview.h"
+#include "objectgroupedit.h"
 #include "preferences.h"
 #include "project.h"
 #include "projectmanager.h"
@@ -50,6 +51,7 @@
 #include "scriptmodule.h"
 #include "scriptprocess.h"
 #include "scriptpropertytype.h"
+#include "scriptworker.h"
 #include "tilecollisiondock.h"
 #include "tilelayer.h"
 #include "tilelayeredit.h"
@@ -61,6 +63,7 @@
 #include <QDesktopServices>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QQmlEngine>
 #include <QStandardPaths>
 #if QT_VERSION < QT_VERSION_CHECK(6,0,0)
@@ -123,6 +126,7 @@ ScriptManager::ScriptManager(QObject *parent)
     qRegisterMetaType<Font>();
     qRegisterMetaType<MapEditor*>();
     qRegisterMetaType<MapView*>();
+    qRegisterMetaType<ObjectGroupEdit*>();
     qRegisterMetaType<RegionValueType>();
     qRegisterMetaType<QVector<Tiled::RegionValueType>>();
     qRegisterMetaType<ScriptedAction*>();
@@ -184,6 +188,8 @@ QJSValue ScriptManager::evaluate(const QString &program,
 
 void ScriptManager::evaluateFileOrLoadModule(const QString &fileName)
 {
+    const QScopedValueRollback<QString> currentScriptFile(mCurrentScriptFile, fileName);
+
     if (fileName.endsWith(QLatin1String(".js"), Qt::CaseInsensitive)) {
         evaluateFile(fileName);
     } else {
@@ -222,6 +228,15 @@ static bool fromUtf8(const QByteArray &bytes, QString &unicode)
 }
 #endif
 
+/**
+ * Returns the file name of the script that is currently being loaded, if
+ * any. Used to attribute registered callbacks to their extension.
+ */
+QString ScriptManager::currentExtension() const
+{
+    return QFileInfo(mCurrentScriptFile).fileName();
+}
+
 QJSValue ScriptManager::evaluateFile(const QString &fileName)
 {
     QFile file(fileName);
@@ -414,6 +429,7 @@ void ScriptManager::initialize()
     registerGeometry(engine);
     registerProcess(engine);
     registerPropertyTypes(engine);
+    registerWorker(engine);
     loadExtensions();
 }
 
@@ -75,6 +75,8 @@ public:
 
     void evaluateFileOrLoadModule(const QString &fileName);
 
+    QString currentExtension() const;
+
     /**
      * Create a new global identifier ($0, $1, $2, ...) for the value. Returns
      * the name of the identifier.
@@ -114,6 +116,7 @@ private:
     FileSystemWatcher mWatcher;
     QString mExtensionsPath;
     QStringList mExtensionsPaths;
+    QString mCurrentScriptFile;
     int mTempCount = 0;
     bool mProjectExtensionsSuppressed = false;
 
@@ -25,6 +25,7 @@
 #include "compression.h"
 #include "documentmanager.h"
 #include "editabletileset.h"
+#include "imagecache.h"
 #include "issuesmodel.h"
 #include "logginginterface.h"
 #include "mainwindow.h"
@@ -45,6 +46,7 @@
 #include <QAction>
 #include <QCoreApplication>
 #include <QFileDialog> 
+#include <QGuiApplication>
 #include <QInputDialog>
 #include <QLibraryInfo>
 #include <QMenu>
@@ -310,6 +312,22 @@ bool ScriptModule::versionLessThan(const QString &a, const QString &b)
     return QVersionNumber::fromString(a) < QVersionNumber::fromString(b);
 }
 
+QVariantMap ScriptModule::imageCacheStatistics(bool reset) const
+{
+    const ImageCache::Statistics statistics = ImageCache::statistics();
+    if (reset)
+        ImageCache::resetStatistics();
+
+    return {
+        { QStringLiteral("entries"), statistics.entries },
+        { QStringLiteral("bytes"), statistics.bytes },
+        { QStringLiteral("maximumBytes"), ImageCache::maximumSize() },
+        { QStringLiteral("hits"), statistics.hits },
+        { QStringLiteral("misses"), statistics.misses },
+        { QStringLiteral("evictions"), statistics.evictions },
+    };
+}
+
 EditableAsset *ScriptModule::open(const QString &fileName) const
 {
     auto documentManager = DocumentManager::maybeInstance();
@@ -604,8 +622,20 @@ void ScriptModule::executeCommand(const QString &name, bool inTerminal) const
     ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Unknown command"));
 }
 
+// Dialogs can't be answered when running without a display, as is the case
+// for command-line operations
+static bool canShowDialogs()
+{
+    return QGuiApplication::platformName() != QLatin1String("offscreen");
+}
+
 void ScriptModule::alert(const QString &text, const QString &title) const
 {
+    if (!canShowDialogs()) {
+        Tiled::WARNING(title.isEmpty() ? text : title + QLatin1String(": ") + text);
+        return;
+    }
+
     ScriptManager::ResetBlocker blocker;
     QMessageBox msgBox(QMessageBox::Warning, title, text, QMessageBox::Ok,
                        MainWindow::maybeInstance());
@@ -620,6 +650,9 @@ void ScriptModule::alert(const QString &text, const QString &title) const
 
 bool ScriptModule::confirm(const QString &text, const QString &title) const
 {
+    if (!canShowDialogs())
+        return false;
+
     ScriptManager::ResetBlocker blocker;
     QMessageBox msgBox(QMessageBox::Question, title, text,
                        QMessageBox::Yes | QMessageBox::No,
@@ -635,12 +668,18 @@ bool ScriptModule::confirm(const QString &text, const QString &title) const
 
 QString ScriptModule::prompt(const QString &label, const QString &text, const QString &title) const
 {
+    if (!canShowDialogs())
+        return text;
+
     ScriptManager::ResetBlocker blocker;
     return QInputDialog::getText(MainWindow::maybeInstance(), title, label, QLineEdit::Normal, text);
 }
 
 QString ScriptModule::promptDirectory(const QString &defaultDir, const QString &title) const
 {
+    if (!canShowDialogs())
+        return QString();
+
     ScriptManager::ResetBlocker blocker;
     return QFileDialog::getExistingDirectory(MainWindow::maybeInstance(),
                                              title.isEmpty() ? tr("Open Directory") : title,
@@ -650,6 +689,9 @@ QString ScriptModule::promptDirectory(const QString &defaultDir, const QString &
 
 QStringList ScriptModule::promptOpenFiles(const QString &defaultDir, const QString &filters, const QString &title) const
 {
+    if (!canShowDialogs())
+        return QStringList();
+
     ScriptManager::ResetBlocker blocker;
     return QFileDialog::getOpenFileNames(MainWindow::maybeInstance(),
                                          title.isEmpty() ? tr("Open Files") : title,
@@ -658,6 +700,9 @@ QStringList ScriptModule::promptOpenFiles(const QString &defaultDir, const QStri
 
 QString ScriptModule::promptOpenFile(const QString &defaultDir, const QString &filters, const QString &title) const
 {
+    if (!canShowDialogs())
+        return QString();
+
     ScriptManager::ResetBlocker blocker;
     return QFileDialog::getOpenFileName(MainWindow::maybeInstance(),
                                         title.isEmpty() ? tr("Open File") : title,
@@ -666,6 +711,9 @@ QString ScriptModule::promptOpenFile(const QString &defaultDir, const QString &f
 
 QString ScriptModule::promptSaveFile(const QString &defaultDir, const QString &filters, const QString &title) const
 {
+    if (!canShowDialogs())
+        return QString();
+
     ScriptManager::ResetBlocker blocker;
     return QFileDialog::getSaveFileName(MainWindow::maybeInstance(),
                                         title.isEmpty() ? tr("Save File") : title,
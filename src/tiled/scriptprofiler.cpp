@@ -0,0 +1,154 @@
+/*
+ * scriptprofiler.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scriptprofiler.h"
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include <algorithm>
+
+namespace Tiled {
+
+namespace {
+
+struct TraceEvent
+{
+    QString extension;
+    QString callback;
+    qint64 start;       // in nanoseconds
+    qint64 duration;    // in nanoseconds
+};
+
+// Limits the memory used by the trace, dropping the oldest events
+constexpr int maximumTraceEvents = 100000;
+
+QHash<QPair<QString, QString>, ScriptProfiler::CallStatistics> callStatistics;
+QVector<TraceEvent> traceEvents;
+
+} // anonymous namespace
+
+ScriptProfiler::Scope::Scope(const QString &extension, const QString &callback)
+    : mExtension(extension)
+    , mCallback(callback)
+    , mStart(now())
+{}
+
+ScriptProfiler::Scope::~Scope()
+{
+    record(mExtension, mCallback, mStart, now() - mStart);
+}
+
+/**
+ * Returns the statistics for each callback, sorted by descending total time.
+ */
+QVector<ScriptProfiler::CallStatistics> ScriptProfiler::statistics()
+{
+    QVector<CallStatistics> result;
+    result.reserve(callStatistics.size());
+    for (const CallStatistics &statistics : std::as_const(callStatistics))
+        result.append(statistics);
+
+    std::sort(result.begin(), result.end(), [] (const CallStatistics &a, const CallStatistics &b) {
+        return a.totalTime > b.totalTime;
+    });
+
+    return result;
+}
+
+void ScriptProfiler::reset()
+{
+    callStatistics.clear();
+    traceEvents.clear();
+}
+
+/**
+ * Writes the recorded calls in the Trace Event Format, which can be opened
+ * by the Chrome tracing and Perfetto trace viewers.
+ */
+bool ScriptProfiler::writeChromeTrace(const QString &fileName, QString *error)
+{
+    QJsonArray events;
+    for (const TraceEvent &event : std::as_const(traceEvents)) {
+        events.append(QJsonObject {
+            { QStringLiteral("name"), event.callback },
+            { QStringLiteral("cat"), event.extension },
+            { QStringLiteral("ph"), QStringLiteral("X") },
+            { QStringLiteral("ts"), event.start / 1000.0 },
+            { QStringLiteral("dur"), event.duration / 1000.0 },
+            { QStringLiteral("pid"), 1 },
+            { QStringLiteral("tid"), 1 },
+        });
+    }
+
+    const QJsonObject trace {
+        { QStringLiteral("traceEvents"), events },
+        { QStringLiteral("displayTimeUnit"), QStringLiteral("ms") },
+    };
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+
+    if (!file.commit()) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+qint64 ScriptProfiler::now()
+{
+    static QElapsedTimer clock = [] {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock.nsecsElapsed();
+}
+
+void ScriptProfiler::record(const QString &extension, const QString &callback,
+                            qint64 start, qint64 duration)
+{
+    CallStatistics &statistics = callStatistics[qMakePair(extension, callback)];
+    if (statistics.calls == 0) {
+        statistics.extension = extension;
+        statistics.callback = callback;
+    }
+    ++statistics.calls;
+    statistics.totalTime += duration;
+    statistics.maximumTime = std::max(statistics.maximumTime, duration);
+
+    if (traceEvents.size() >= maximumTraceEvents)
+        traceEvents.remove(0, maximumTraceEvents / 2);
+    traceEvents.append({ extension, callback, start, duration });
+}
+
+} // namespace Tiled
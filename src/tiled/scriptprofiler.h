@@ -0,0 +1,77 @@
+/*
+ * scriptprofiler.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+namespace Tiled {
+
+/**
+ * Measures the time spent in the callbacks of extensions, like the event
+ * handlers of scripted tools or the functions of scripted file formats.
+ *
+ * Callbacks are only called from the main thread, so no locking is done.
+ */
+class ScriptProfiler
+{
+public:
+    /**
+     * Measures the time until it goes out of scope and records it for the
+     * given \a callback of the given \a extension.
+     */
+    class Scope
+    {
+    public:
+        Scope(const QString &extension, const QString &callback);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        const QString mExtension;
+        const QString mCallback;
+        const qint64 mStart;
+    };
+
+    struct CallStatistics
+    {
+        QString extension;
+        QString callback;
+        qint64 calls = 0;
+        qint64 totalTime = 0;   // in nanoseconds
+        qint64 maximumTime = 0; // in nanoseconds
+    };
+
+    static QVector<CallStatistics> statistics();
+    static void reset();
+
+    static bool writeChromeTrace(const QString &fileName, QString *error = nullptr);
+
+private:
+    static qint64 now();
+    static void record(const QString &extension, const QString &callback,
+                       qint64 start, qint64 duration);
+};
+
+} // namespace Tiled
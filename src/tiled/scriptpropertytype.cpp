@@ -47,6 +47,7 @@ void ScriptPropertyType::setName(const QString &name)
     }
 
     mType->name = name;
+    project.propertyTypes()->updateIndex();
     applyPropertyChanges();
 }
 
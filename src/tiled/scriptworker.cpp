@@ -0,0 +1,275 @@
+/*
+ * scriptworker.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scriptworker.h"
+
+#include "logginginterface.h"
+#include "scriptmanager.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJSEngine>
+#include <QJSValue>
+#include <QMutex>
+#include <QThread>
+#include <QVariant>
+
+#include <algorithm>
+
+namespace Tiled {
+
+/**
+ * Returns whether the given \a value can be sent to or from a worker. Only
+ * plain data can be sent, since objects live in one of the script engines.
+ */
+static bool isCloneable(const QVariant &value)
+{
+    switch (value.userType()) {
+    case QMetaType::QVariantList: {
+        const QVariantList list = value.toList();
+        return std::all_of(list.begin(), list.end(), isCloneable);
+    }
+    case QMetaType::QVariantMap: {
+        const QVariantMap map = value.toMap();
+        return std::all_of(map.begin(), map.end(), isCloneable);
+    }
+    default:
+        break;
+    }
+
+    if (value.userType() == qMetaTypeId<QJSValue>())
+        return false;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6,0,0)
+    return !(value.metaType().flags() & QMetaType::PointerToQObject);
+#else
+    return !(QMetaType::typeFlags(value.userType()) & QMetaType::PointerToQObject);
+#endif
+}
+
+/**
+ * Lives in the thread of a worker and owns its script engine.
+ */
+class WorkerContext : public QObject
+{
+    Q_OBJECT
+
+public:
+    Q_INVOKABLE void postMessage(const QJSValue &message);
+
+    void start(const QString &fileName);
+    void receive(const QVariant &message);
+    void interrupt();
+
+signals:
+    void message(const QVariant &message);
+    void error(const QString &message);
+
+private:
+    bool checkError(const QJSValue &value);
+
+    QJSEngine *mEngine = nullptr;
+    QMutex mMutex;              // protects mEngine and mInterrupted
+    bool mInterrupted = false;
+};
+
+void WorkerContext::postMessage(const QJSValue &message)
+{
+    const QVariant value = message.toVariant();
+    if (!isCloneable(value)) {
+        mEngine->throwError(QCoreApplication::translate("Script Errors", "Value can't be sent from a worker"));
+        return;
+    }
+
+    emit this->message(value);
+}
+
+void WorkerContext::start(const QString &fileName)
+{
+    {
+        QMutexLocker locker(&mMutex);
+        mEngine = new QJSEngine(this);
+        mEngine->setInterrupted(mInterrupted);
+    }
+
+    mEngine->installExtensions(QJSEngine::ConsoleExtension);
+
+    QJSValue globalObject = mEngine->globalObject();
+    QJSValue context = mEngine->newQObject(this);
+    globalObject.setProperty(QStringLiteral("postMessage"), context.property(QStringLiteral("postMessage")));
+
+    if (fileName.endsWith(QLatin1String(".js"), Qt::CaseInsensitive)) {
+        QFile file(fileName);
+        if (!file.open(QFile::ReadOnly | QFile::Text)) {
+            emit error(QCoreApplication::translate("Script Errors", "Error opening file: %1").arg(fileName));
+            return;
+        }
+
+        checkError(mEngine->evaluate(QString::fromUtf8(file.readAll()), fileName));
+    } else {
+        globalObject.setProperty(QStringLiteral("__filename"), fileName);
+        checkError(mEngine->importModule(fileName));
+    }
+}
+
+void WorkerContext::receive(const QVariant &message)
+{
+    if (!mEngine)
+        return;
+
+    QJSValue handler = mEngine->globalObject().property(QStringLiteral("onmessage"));
+    if (handler.isCallable())
+        checkError(handler.call({ mEngine->toScriptValue(message) }));
+}
+
+/**
+ * Interrupts any script running in the worker. Can be called from any thread.
+ */
+void WorkerContext::interrupt()
+{
+    QMutexLocker locker(&mMutex);
+    mInterrupted = true;
+    if (mEngine)
+        mEngine->setInterrupted(true);
+}
+
+bool WorkerContext::checkError(const QJSValue &value)
+{
+    if (!value.isError())
+        return false;
+
+    emit error(QStringLiteral("%1:%2: %3").arg(value.property(QStringLiteral("fileName")).toString(),
+                                               value.property(QStringLiteral("lineNumber")).toString(),
+                                               value.toString()));
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Runs a script in a separate thread with its own script engine, exchanging
+ * plain data with the calling script through messages.
+ */
+class ScriptWorker : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(QJSValue onmessage READ onMessage WRITE setOnMessage)
+    Q_PROPERTY(QJSValue onerror READ onError WRITE setOnError)
+
+public:
+    Q_INVOKABLE explicit ScriptWorker(const QString &fileName);
+    ~ScriptWorker() override;
+
+    QJSValue onMessage() const { return mOnMessage; }
+    void setOnMessage(const QJSValue &handler) { mOnMessage = handler; }
+
+    QJSValue onError() const { return mOnError; }
+    void setOnError(const QJSValue &handler) { mOnError = handler; }
+
+    Q_INVOKABLE void postMessage(const QJSValue &message);
+    Q_INVOKABLE void terminate();
+
+signals:
+    void messagePosted(const QVariant &message);
+
+private:
+    void handleMessage(const QVariant &message);
+    void handleError(const QString &message);
+
+    QThread mThread;
+    WorkerContext *mContext;
+    QJSValue mOnMessage;
+    QJSValue mOnError;
+};
+
+ScriptWorker::ScriptWorker(const QString &fileName)
+    : mContext(new WorkerContext)
+{
+    mThread.setObjectName(QStringLiteral("ScriptWorker"));
+    mContext->moveToThread(&mThread);
+
+    connect(&mThread, &QThread::finished, mContext, &QObject::deleteLater);
+    connect(this, &ScriptWorker::messagePosted, mContext, &WorkerContext::receive);
+    connect(mContext, &WorkerContext::message, this, &ScriptWorker::handleMessage);
+    connect(mContext, &WorkerContext::error, this, &ScriptWorker::handleError);
+
+    mThread.start();
+
+    QMetaObject::invokeMethod(mContext, [context = mContext, fileName] {
+        context->start(fileName);
+    }, Qt::QueuedConnection);
+}
+
+ScriptWorker::~ScriptWorker()
+{
+    terminate();
+}
+
+void ScriptWorker::postMessage(const QJSValue &message)
+{
+    const QVariant value = message.toVariant();
+    if (!isCloneable(value)) {
+        ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Value can't be sent to a worker"));
+        return;
+    }
+
+    emit messagePosted(value);
+}
+
+/**
+ * Stops the worker, interrupting any script it is running. Messages that
+ * were not handled yet are discarded.
+ */
+void ScriptWorker::terminate()
+{
+    if (!mThread.isRunning())
+        return;
+
+    mContext->interrupt();
+    mThread.quit();
+    mThread.wait();
+}
+
+void ScriptWorker::handleMessage(const QVariant &message)
+{
+    QJSEngine *engine = qjsEngine(this);
+    if (engine && mOnMessage.isCallable())
+        ScriptManager::instance().checkError(mOnMessage.call({ engine->toScriptValue(message) }));
+}
+
+void ScriptWorker::handleError(const QString &message)
+{
+    if (mOnError.isCallable())
+        ScriptManager::instance().checkError(mOnError.call({ message }));
+    else
+        Tiled::ERROR(message);
+}
+
+
+void registerWorker(QJSEngine *jsEngine)
+{
+    jsEngine->globalObject().setProperty(QStringLiteral("Worker"),
+                                         jsEngine->newQMetaObject<ScriptWorker>());
+}
+
+} // namespace Tiled
+
+#include "scriptworker.moc"
@@ -49,14 +49,14 @@ void SelectSameTileTool::tilePositionChanged(QPoint tilePos)
         mMatchCells.clear();
 
     const bool infinite = mapDocument()->map()->infinite();
-    QRegion resultRegion;
+    TileRegion resultRegion;
 
     if (infinite || tileLayer->contains(tilePos)) {
         const Cell &currentCell = tileLayer->cellAt(tilePos);
         if (!mMatchCells.contains(currentCell))
             mMatchCells.append(currentCell);
 
-        resultRegion = tileLayer->region(
+        resultRegion = tileLayer->tileRegion(
             [&](const Cell &cell) { return mMatchCells.contains(cell); });
 
         // Due to the way TileLayer::region only iterates allocated chunks, and
@@ -66,14 +66,14 @@ void SelectSameTileTool::tilePositionChanged(QPoint tilePos)
                                               mMatchCells.end(),
                                               [](const Cell &cell) { return cell.isEmpty(); });
         if (hasEmptyCell) {
-            QRegion emptyRegion = infinite ? tileLayer->bounds() : tileLayer->rect();
-            emptyRegion -= tileLayer->region();
+            TileRegion emptyRegion = infinite ? tileLayer->bounds() : tileLayer->rect();
+            emptyRegion.subtract(tileLayer->tileRegion());
 
-            resultRegion += emptyRegion;
+            resultRegion.add(emptyRegion);
         }
     }
 
-    setSelectionPreview(resultRegion);
+    setSelectionPreview(resultRegion.toQRegion());
 }
 
 void SelectSameTileTool::languageChanged()
@@ -231,14 +231,25 @@ void ShapeFillTool::updateFillOverlay()
     QRect area = QRect::span(p1, p2);
 #endif
 
+    QRegion region;
+
     switch (mCurrentShape) {
     case Rect:
-        updatePreview(area);
+        region = area;
         break;
     case Circle:
-        updatePreview(ellipseRegion(area));
+        region = ellipseRegion(area);
         break;
     }
+
+    // Generating the tiles for huge shapes is too slow to do while dragging,
+    // so only the shape is shown until it is applied
+    constexpr qint64 MaxTilePreviewArea = 256 * 256;
+
+    if (qint64(area.width()) * area.height() > MaxTilePreviewArea)
+        updateRegionPreview(region);
+    else
+        updatePreview(region);
 }
 
 #include "moc_shapefilltool.cpp"
@@ -95,8 +95,8 @@ void StampBrush::tilePositionChanged(QPoint pos)
             drawPreviewLayer(QVector<QPoint>() << points.at(i));
 
             // Only update the brush item for the last drawn piece
-            if (i == points.size() - 1)
-                brushItem()->setMap(mPreviewMap);
+            if (i == points.size() - 1 && mPreviewMap)
+                brushItem()->setMap(mPreviewMap, mPreviewRegion);
 
             doPaint(Mergeable, &paintedRegions);
         }
@@ -272,6 +272,7 @@ void StampBrush::mapDocumentChanged(MapDocument *oldDocument,
     }
 
     if (newDocument) {
+        mPreviewPoints.clear();
         invalidateRandomCache();
         updatePreview();
         connect(newDocument, &MapDocument::tileProbabilityChanged,
@@ -316,6 +317,7 @@ void StampBrush::setStamp(const TileStamp &stamp)
         return;
 
     mStamp = stamp;
+    mPreviewPoints.clear();
 
     invalidateRandomCache();
     updatePreview();
@@ -427,9 +429,59 @@ static void shiftColumns(TileLayer *tileLayer, Map::StaggerIndex staggerIndex)
     }
 }
 
+/**
+ * Moves the existing preview when only the position of a single stamp
+ * changed, which avoids rebuilding the preview on each mouse move.
+ *
+ * Returns false when the preview needs to be rebuilt.
+ */
+bool StampBrush::translatePreview(const QVector<QPoint> &points)
+{
+    // Random and Wang fill previews depend on the position
+    if (!mPreviewMap || mIsRandom || mIsWangFill)
+        return false;
+    if (points.size() != 1 || mPreviewPoints.size() != 1)
+        return false;
+    if (mStamp.variations().size() != 1)
+        return false;
+
+    // Tilesets may have been removed from the map since the preview was drawn
+    const Map *map = mapDocument()->map();
+    for (const SharedTileset &tileset : mPreviewMap->tilesets())
+        if (!map->tilesets().contains(tileset) && !mMissingTilesets.contains(tileset))
+            return false;
+
+    const QPoint offset = points.first() - mPreviewPoints.first();
+
+    // On staggered maps, the stamp is shifted depending on its position
+    if (map->isStaggered()) {
+        const int staggerOffset = map->staggerAxis() == Map::StaggerY ? offset.y()
+                                                                      : offset.x();
+        if (staggerOffset & 1)
+            return false;
+    }
+
+    for (Layer *layer : mPreviewMap->tileLayers())
+        layer->setPosition(layer->position() + offset);
+
+    mPreviewRegion.translate(offset);
+    mPreviewPoints = points;
+    return true;
+}
+
+void StampBrush::setPreviewMap(const SharedMap &preview, const QVector<QPoint> &points)
+{
+    mPreviewMap = preview;
+    mPreviewRegion = preview ? preview->modifiedTileRegion() : QRegion();
+    mPreviewPoints = preview ? points : QVector<QPoint>();
+}
+
 void StampBrush::drawPreviewLayer(const QVector<QPoint> &points)
 {
-    mPreviewMap.clear();
+    if (translatePreview(points))
+        return;
+
+    setPreviewMap(SharedMap(), points);
 
     if (mStamp.isEmpty() && !mIsWangFill)
         return;
@@ -466,7 +518,7 @@ void StampBrush::drawPreviewLayer(const QVector<QPoint> &points)
 
         preview->addLayer(std::move(previewLayer));
         preview->addTilesets(preview->usedTilesets());
-        mPreviewMap = preview;
+        setPreviewMap(preview, points);
     } else if (mIsWangFill) {
         if (!mWangSet)
             return;
@@ -498,7 +550,7 @@ void StampBrush::drawPreviewLayer(const QVector<QPoint> &points)
 
         preview->addLayer(std::move(previewLayer));
         preview->addTileset(mWangSet->tileset()->sharedFromThis());
-        mPreviewMap = preview;
+        setPreviewMap(preview, points);
     } else {
         QRegion paintedRegion;
         QVector<PaintOperation> operations;
@@ -620,7 +672,7 @@ void StampBrush::drawPreviewLayer(const QVector<QPoint> &points)
         qDeleteAll(shiftedCopies);
 
         preview->addTilesets(preview->usedTilesets());
-        mPreviewMap = preview;
+        setPreviewMap(preview, points);
     }
 }
 
@@ -669,7 +721,7 @@ void StampBrush::updatePreview(QPoint tilePos)
         }
 
         if (mPreviewMap)
-            tileRegion = mPreviewMap->modifiedTileRegion();
+            tileRegion = mPreviewRegion;
 
         if (tileRegion.isEmpty())
             tileRegion = QRect(tilePos, tilePos);
@@ -684,6 +736,7 @@ void StampBrush::setRandom(bool value)
         return;
 
     mIsRandom = value;
+    mPreviewPoints.clear();
 
     if (mIsRandom) {
         mIsWangFill = false;
@@ -700,6 +753,7 @@ void StampBrush::setWangFill(bool value)
         return;
 
     mIsWangFill = value;
+    mPreviewPoints.clear();
 
     if (mIsWangFill) {
         mIsRandom = false;
@@ -115,12 +115,16 @@ private:
 
     TileStamp mStamp;
     SharedMap mPreviewMap;
+    QRegion mPreviewRegion;             // tile region covered by mPreviewMap
+    QVector<QPoint> mPreviewPoints;     // points mPreviewMap was drawn for
     QVector<SharedTileset> mMissingTilesets;
 
     CaptureStampHelper mCaptureStampHelper;
     QPoint mPrevTilePosition;
 
     void drawPreviewLayer(const QVector<QPoint> &points);
+    bool translatePreview(const QVector<QPoint> &points);
+    void setPreviewMap(const SharedMap &preview, const QVector<QPoint> &points);
 
     /**
      * There are several options how the stamp utility can be used.
@@ -156,7 +160,7 @@ private:
     QPoint mStampReference;
 
     bool mIsRandom = false;
-    RandomPicker<Cell> mRandomCellPicker;
+    AliasRandomPicker<Cell> mRandomCellPicker;
 
     bool mIsWangFill = false;
     WangSet *mWangSet = nullptr;
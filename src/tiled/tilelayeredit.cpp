@@ -22,6 +22,11 @@
 
 #include "editabletile.h"
 #include "editabletilelayer.h"
+#include "gidmapper.h"
+#include "scriptmanager.h"
+
+#include <QCoreApplication>
+#include <QtEndian>
 
 namespace Tiled {
 
@@ -54,6 +59,59 @@ void TileLayerEdit::setTile(int x, int y, EditableTile *tile, int flags)
     mChanges.setCell(x, y, cell);
 }
 
+/**
+ * Returns the bytes of the given ArrayBuffer or typed array \a value.
+ */
+static QByteArray arrayBufferData(const QJSValue &value)
+{
+    // Typed arrays are views on a range of an ArrayBuffer
+    const QJSValue buffer = value.property(QStringLiteral("buffer"));
+    if (buffer.isUndefined())
+        return value.toVariant().toByteArray();
+
+    const QByteArray data = buffer.toVariant().toByteArray();
+    return data.mid(value.property(QStringLiteral("byteOffset")).toInt(),
+                    value.property(QStringLiteral("byteLength")).toInt());
+}
+
+/**
+ * Sets the cells in the given \a rect from an array of little-endian 32-bit
+ * global tile IDs, as returned by EditableTileLayer::readCells.
+ */
+void TileLayerEdit::writeCells(const QRect &rect, const QJSValue &data)
+{
+    const Map *map = mTargetLayer->tileLayer()->map();
+    if (!map) {
+        ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Layer not part of a map"));
+        return;
+    }
+
+    const QByteArray bytes = arrayBufferData(data);
+    if (rect.isEmpty() || bytes.size() != qint64(rect.width()) * rect.height() * 4) {
+        ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Data size does not match the rectangle"));
+        return;
+    }
+
+    const GidMapper gidMapper(map->tilesets());
+    auto gids = reinterpret_cast<const quint32*>(bytes.constData());
+
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        for (int x = rect.left(); x <= rect.right(); ++x) {
+            const unsigned gid = qFromLittleEndian(*gids++);
+
+            bool ok;
+            Cell cell = gidMapper.gidToCell(gid, ok);
+            if (!ok) {
+                ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Invalid global tile ID: %1").arg(gid));
+                return;
+            }
+
+            cell.setChecked(true);  // Used to find painted region later (allows erasing)
+            mChanges.setCell(x, y, cell);
+        }
+    }
+}
+
 void TileLayerEdit::apply()
 {
     // Applying an edit automatically makes it mergeable, so that further
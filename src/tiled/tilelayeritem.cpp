@@ -23,11 +23,70 @@
 #include "map.h"
 #include "mapdocument.h"
 #include "maprenderer.h"
+#include "preferences.h"
+#include "tile.h"
+#include "tileset.h"
 
+#include <QCache>
+#include <QPainter>
+#include <QPixmap>
 #include <QStyleOptionGraphicsItem>
 
+#include <cmath>
+#include <memory>
+
 using namespace Tiled;
 
+namespace {
+
+/**
+ * Identifies a pre-rendered block of CHUNK_SIZE x CHUNK_SIZE tiles of a
+ * layer, at scale 2^zoomLevel.
+ *
+ * The cache id and block generation change when the layer or the block is
+ * invalidated, so that outdated blocks are no longer found without having to
+ * look for them. They are evicted from the cache as least recently used.
+ */
+struct RenderCacheKey
+{
+    quint64 cacheId;
+    QPoint block;
+    int zoomLevel;
+    int generation;
+
+    bool operator==(const RenderCacheKey &other) const
+    {
+        return cacheId == other.cacheId && block == other.block &&
+                zoomLevel == other.zoomLevel && generation == other.generation;
+    }
+};
+
+inline uint qHash(const RenderCacheKey &key, uint seed = 0) Q_DECL_NOTHROW
+{
+    return ::qHash(key.cacheId, seed) ^ ::qHash(key.block.x() * 31 + key.block.y(), seed) ^
+            key.zoomLevel ^ (key.generation << 8);
+}
+
+} // namespace
+
+/**
+ * When more cells than this need to be repainted on a layer, for example
+ * because they show animated tiles, the whole layer is repainted rather than
+ * each tile separately.
+ */
+static const int maxCellUpdates = 256;
+
+// The memory budget for pre-rendered blocks of all tile layers, in MiB
+static Preference<int> tileLayerCacheSize { "Interface/TileLayerCacheSize", 128 };
+
+/**
+ * Pre-rendered blocks, shared by all tile layer items and evicted in least
+ * recently used order. The cost of each block is its size in KiB.
+ */
+static QCache<RenderCacheKey, QPixmap> renderCache;
+
+static quint64 nextCacheId = 0;
+
 TileLayerItem::TileLayerItem(TileLayer *layer, MapDocument *mapDocument, QGraphicsItem *parent)
     : LayerItem(layer, parent)
     , mMapDocument(mapDocument)
@@ -37,9 +96,20 @@ TileLayerItem::TileLayerItem(TileLayer *layer, MapDocument *mapDocument, QGraphi
     syncWithTileLayer();
 }
 
+TileLayerItem::~TileLayerItem()
+{
+    // Releases the memory used by this layer right away, rather than waiting
+    // for its blocks to be evicted
+    const auto keys = renderCache.keys();
+    for (const RenderCacheKey &key : keys)
+        if (key.cacheId == mCacheId)
+            renderCache.remove(key);
+}
+
 void TileLayerItem::syncWithTileLayer()
 {
     prepareGeometryChange();
+    invalidateCache();
 
     QRect layerBounds = tileLayer()->bounds();
     if (!mMapDocument->map()->infinite())
@@ -48,7 +118,9 @@ void TileLayerItem::syncWithTileLayer()
     const MapRenderer *renderer = mMapDocument->renderer();
     const QRect boundingRect = renderer->boundingRect(layerBounds);
 
-    QMargins margins = tileLayer()->drawMargins();
+    mDrawMargins = tileLayer()->drawMargins();
+
+    QMargins margins = mDrawMargins;
     if (const Map *map = tileLayer()->map()) {
         margins.setTop(qMax(0, margins.top() - map->tileHeight()));
         margins.setRight(qMax(0, margins.right() - map->tileWidth()));
@@ -62,6 +134,138 @@ QRectF TileLayerItem::boundingRect() const
     return mBoundingRect;
 }
 
+/**
+ * Invalidates all pre-rendered blocks of this layer.
+ */
+void TileLayerItem::invalidateCache()
+{
+    mCacheId = nextCacheId++;
+    mBlockGenerations.clear();
+
+    mAnimatedBlocks.clear();
+    mAnimatedCells.clear();
+    mAnimatedCellsDirty = true;
+}
+
+/**
+ * Invalidates the pre-rendered blocks of this layer that overlap the given
+ * \a region, in map tile coordinates.
+ */
+void TileLayerItem::invalidateCache(const QRegion &region)
+{
+    QSet<QPoint> blocks;
+    for (const QRect &rect : region)
+        for (int y = rect.top() >> CHUNK_BITS; y <= rect.bottom() >> CHUNK_BITS; ++y)
+            for (int x = rect.left() >> CHUNK_BITS; x <= rect.right() >> CHUNK_BITS; ++x)
+                blocks.insert(QPoint(x, y));
+
+    for (const QPoint &block : std::as_const(blocks)) {
+        ++mBlockGenerations[block];
+        mAnimatedBlocks.remove(block);
+    }
+
+    mAnimatedCells.clear();
+    mAnimatedCellsDirty = true;
+}
+
+/**
+ * Repaints the cells of this layer showing animated tiles from the given
+ * \a tileset.
+ */
+void TileLayerItem::repaintAnimatedTiles(Tileset *tileset)
+{
+    if (!isVisible())
+        return;
+
+    updateAnimatedCells();
+
+    const auto it = mAnimatedCells.constFind(tileset);
+    if (it == mAnimatedCells.constEnd())
+        return;
+
+    if (it->size() > maxCellUpdates) {
+        repaint();
+        return;
+    }
+
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const QMargins margins = tileLayer()->drawMargins();
+
+    for (const QPoint &pos : *it)
+        repaint(renderer->boundingRect(QRect(pos, QSize(1, 1))).marginsAdded(margins));
+}
+
+/**
+ * Repaints the cells of this layer showing any of the given \a tiles, after
+ * their image changed. When this changed the draw margins of the layer, the
+ * whole layer is updated instead.
+ */
+void TileLayerItem::repaintTiles(const QSet<const Tile*> &tiles)
+{
+    if (tileLayer()->drawMargins() != mDrawMargins) {
+        syncWithTileLayer();
+        repaint();
+        return;
+    }
+
+    const TileLayer *layer = tileLayer();
+    const QPoint offset = layer->position();
+
+    QVector<QPoint> cells;
+    for (auto it = layer->begin(), end = layer->end(); it != end; ++it) {
+        const Tile *tile = it.value().tile();
+        if (tile && tiles.contains(tile))
+            cells.append(it.key() + offset);
+    }
+
+    if (cells.isEmpty())
+        return;
+
+    if (cells.size() > maxCellUpdates) {
+        invalidateCache();
+        repaint();
+        return;
+    }
+
+    QRegion region;
+    for (const QPoint &pos : std::as_const(cells))
+        region += QRect(pos, QSize(1, 1));
+
+    invalidateCache(region);
+
+    const MapRenderer *renderer = mMapDocument->renderer();
+    for (const QPoint &pos : std::as_const(cells))
+        repaint(renderer->boundingRect(QRect(pos, QSize(1, 1))).marginsAdded(mDrawMargins));
+}
+
+/**
+ * Rebuilds the index of animated cells when the layer changed or when tiles
+ * started or stopped being animated.
+ */
+void TileLayerItem::updateAnimatedCells()
+{
+    const int generation = Tileset::animatedTilesGeneration();
+    if (generation != mAnimatedTilesGeneration) {
+        // Blocks may have been cached before their tiles got animated
+        invalidateCache();
+        mAnimatedTilesGeneration = generation;
+    }
+
+    if (!mAnimatedCellsDirty)
+        return;
+
+    const TileLayer *layer = tileLayer();
+    const QPoint offset = layer->position();
+
+    for (auto it = layer->begin(), end = layer->end(); it != end; ++it) {
+        const Cell cell = it.value();
+        if (const Tile *tile = cell.tile(); tile && tile->isAnimated())
+            mAnimatedCells[cell.tileset()].append(it.key() + offset);
+    }
+
+    mAnimatedCellsDirty = false;
+}
+
 void TileLayerItem::paint(QPainter *painter,
                           const QStyleOptionGraphicsItem *option,
                           QWidget *)
@@ -69,5 +273,153 @@ void TileLayerItem::paint(QPainter *painter,
     MapRenderer *renderer = mMapDocument->renderer();
     // TODO: Display a border around the layer when selected
     painter->setCompositionMode(layer()->compositionMode());
-    renderer->drawTileLayer(painter, tileLayer(), option->exposedRect);
+
+    if (tileLayer()->hasPagedOutChunks())
+        pageInExposedChunks(option->exposedRect);
+
+    const QTransform &transform = painter->worldTransform();
+    const qreal scale = transform.m11();
+
+    if (transform.type() <= QTransform::TxScale && transform.m22() == scale && canUseCache(scale))
+        paintCached(painter, option->exposedRect, scale);
+    else
+        renderer->drawTileLayer(painter, tileLayer(), option->exposedRect);
+}
+
+/**
+ * Pre-rendered blocks are used when zoomed out, which is when drawing each
+ * tile gets expensive. They are limited to orthogonal maps with tiles that
+ * fit the grid, since otherwise tiles of neighboring blocks overlap and
+ * the result would depend on the order in which the blocks are drawn.
+ */
+bool TileLayerItem::canUseCache(qreal scale) const
+{
+    if (scale >= 1.0 || scale <= 0.0 || tileLayerCacheSize <= 0)
+        return false;
+
+    const Map *map = mMapDocument->map();
+    if (map->orientation() != Map::Orthogonal)
+        return false;
+
+    const QMargins margins = tileLayer()->drawMargins();
+    return margins.left() <= 0 && margins.bottom() <= 0 &&
+            margins.top() <= map->tileHeight() &&
+            margins.right() <= map->tileWidth();
+}
+
+/**
+ * Loads the stored chunks of the layer that are about to be painted.
+ */
+void TileLayerItem::pageInExposedChunks(const QRectF &exposed)
+{
+    const MapRenderer *renderer = mMapDocument->renderer();
+    TileLayer *layer = tileLayer();
+
+    const QRectF exposedRect = exposed.isNull() ? mBoundingRect : (exposed & mBoundingRect);
+
+    // The corners are mapped separately, since for isometric maps the
+    // exposed area is not a rectangle in tile coordinates
+    QPolygonF tilePolygon;
+    for (const QPointF &corner : { exposedRect.topLeft(), exposedRect.topRight(),
+                                   exposedRect.bottomLeft(), exposedRect.bottomRight() })
+        tilePolygon.append(renderer->screenToTileCoords(corner));
+    const QRect tileRect = tilePolygon.boundingRect().toAlignedRect();
+
+    // Include the tiles that extend into the exposed area
+    const QMargins margins = layer->drawMargins();
+    const QSize tileSize = mMapDocument->map()->tileSize();
+    const int marginX = (margins.left() + margins.right()) / qMax(1, tileSize.width()) + 1;
+    const int marginY = (margins.top() + margins.bottom()) / qMax(1, tileSize.height()) + 1;
+
+    layer->pageIn(tileRect.adjusted(-marginX, -marginY, marginX, marginY)
+                  .translated(-layer->position()));
+}
+
+void TileLayerItem::paintCached(QPainter *painter, const QRectF &exposed, qreal scale)
+{
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const Map *map = mMapDocument->map();
+    const TileLayer *layer = tileLayer();
+
+    renderCache.setMaxCost(tileLayerCacheSize * 1024);
+
+    // Blocks are rendered at the next power of two at or above the scale, so
+    // that they are only ever scaled down
+    const int zoomLevel = static_cast<int>(std::ceil(std::log2(scale)));
+    const qreal blockScale = std::pow(2.0, zoomLevel);
+    const qreal pixelRatio = painter->device()->devicePixelRatioF();
+
+    QRect tileRect = layer->bounds();
+    if (!map->infinite())
+        tileRect &= layer->rect();
+    tileRect.translate(layer->position());
+
+    const QRectF exposedRect = exposed.isNull() ? mBoundingRect : (exposed & mBoundingRect);
+    const QPointF topLeft = renderer->screenToTileCoords(exposedRect.topLeft());
+    const QPointF bottomRight = renderer->screenToTileCoords(exposedRect.bottomRight());
+    tileRect &= QRect(QPoint(std::floor(topLeft.x()), std::floor(topLeft.y())),
+                      QPoint(std::floor(bottomRight.x()), std::floor(bottomRight.y())));
+
+    if (tileRect.isEmpty())
+        return;
+
+    for (int by = tileRect.top() >> CHUNK_BITS; by <= tileRect.bottom() >> CHUNK_BITS; ++by) {
+        for (int bx = tileRect.left() >> CHUNK_BITS; bx <= tileRect.right() >> CHUNK_BITS; ++bx) {
+            const QPoint block(bx, by);
+            const QRect blockTiles(bx * CHUNK_SIZE, by * CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE);
+            const QRect blockPixels = renderer->boundingRect(blockTiles);
+
+            if (mAnimatedBlocks.contains(block)) {
+                renderer->drawTileLayer(painter, layer, QRectF(blockPixels) & exposedRect);
+                continue;
+            }
+
+            const RenderCacheKey key { mCacheId, block, zoomLevel, mBlockGenerations.value(block) };
+            if (const QPixmap *pixmap = renderCache.object(key)) {
+                painter->drawPixmap(QRectF(blockPixels), *pixmap, QRectF(pixmap->rect()));
+                continue;
+            }
+
+            // Animated tiles change appearance, so their blocks aren't cached
+            bool isAnimated = false;
+            bool isEmpty = true;
+            for (int y = blockTiles.top(); y <= blockTiles.bottom() && !isAnimated; ++y) {
+                for (int x = blockTiles.left(); x <= blockTiles.right(); ++x) {
+                    const Cell cell = layer->cellAt(QPoint(x, y) - layer->position());
+                    if (cell.isEmpty())
+                        continue;
+                    isEmpty = false;
+                    if (const Tile *tile = cell.tile(); tile && tile->isAnimated()) {
+                        isAnimated = true;
+                        break;
+                    }
+                }
+            }
+
+            if (isEmpty)
+                continue;
+
+            if (isAnimated) {
+                mAnimatedBlocks.insert(block);
+                renderer->drawTileLayer(painter, layer, QRectF(blockPixels) & exposedRect);
+                continue;
+            }
+
+            const QSize size = (QSizeF(blockPixels.size()) * blockScale * pixelRatio).toSize();
+            auto pixmap = std::make_unique<QPixmap>(size);
+            pixmap->fill(Qt::transparent);
+            {
+                QPainter blockPainter(pixmap.get());
+                blockPainter.setRenderHints(painter->renderHints());
+                blockPainter.scale(blockScale * pixelRatio, blockScale * pixelRatio);
+                blockPainter.translate(-blockPixels.topLeft());
+                renderer->drawTileLayer(&blockPainter, layer, blockPixels);
+            }
+
+            painter->drawPixmap(QRectF(blockPixels), *pixmap, QRectF(pixmap->rect()));
+
+            const int cost = std::max(1, size.width() * size.height() * 4 / 1024);
+            renderCache.insert(key, pixmap.release(), cost);
+        }
+    }
 }
@@ -24,6 +24,10 @@
 
 #include "tilelayer.h"
 
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
 namespace Tiled {
 
 class MapDocument;
@@ -41,6 +45,7 @@ public:
      * @param mapDocument the map document owning the map of this layer
      */
     TileLayerItem(TileLayer *layer, MapDocument *mapDocument, QGraphicsItem *parent = nullptr);
+    ~TileLayerItem() override;
 
     TileLayer *tileLayer() const;
 
@@ -54,6 +59,12 @@ public:
      */
     void syncWithTileLayer();
 
+    void invalidateCache();
+    void invalidateCache(const QRegion &region);
+
+    void repaintAnimatedTiles(Tileset *tileset);
+    void repaintTiles(const QSet<const Tile*> &tiles);
+
     // QGraphicsItem
     QRectF boundingRect() const override;
     void paint(QPainter *painter,
@@ -61,8 +72,22 @@ public:
                QWidget *widget = nullptr) override;
 
 private:
+    bool canUseCache(qreal scale) const;
+    void paintCached(QPainter *painter, const QRectF &exposed, qreal scale);
+    void pageInExposedChunks(const QRectF &exposed);
+    void updateAnimatedCells();
+
     MapDocument *mMapDocument;
     QRectF mBoundingRect;
+    QMargins mDrawMargins;
+    QSet<QPoint> mAnimatedBlocks;   // Blocks that are never cached
+    quint64 mCacheId = 0;
+    QHash<QPoint, int> mBlockGenerations;
+
+    // Locations of animated tiles, in map coordinates, built on demand
+    QHash<Tileset*, QVector<QPoint>> mAnimatedCells;
+    bool mAnimatedCellsDirty = true;
+    int mAnimatedTilesGeneration = -1;
 };
 
 inline TileLayer *TileLayerItem::tileLayer() const
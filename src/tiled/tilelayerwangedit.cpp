@@ -74,6 +74,19 @@ void TileLayerWangEdit::setErasingEnabled(bool erasingEnabled)
     mWangFiller->setErasingEnabled(erasingEnabled);
 }
 
+int TileLayerWangEdit::randomSeed() const
+{
+    return static_cast<int>(mWangFiller->randomSeed().value_or(0));
+}
+
+void TileLayerWangEdit::setRandomSeed(int randomSeed)
+{
+    if (randomSeed)
+        mWangFiller->setRandomSeed(static_cast<quint32>(randomSeed));
+    else
+        mWangFiller->setRandomSeed(std::nullopt);
+}
+
 void TileLayerWangEdit::setWangIndex(QPoint pos, WangIndex::Value index, int color)
 {
     mWangFiller->setWangIndex(pos, static_cast<WangId::Index>(index), color);
@@ -65,6 +65,7 @@ class TileLayerWangEdit : public QObject
     Q_PROPERTY(bool mergeable READ isMergeable WRITE setMergeable)
     Q_PROPERTY(bool correctionsEnabled READ correctionsEnabled WRITE setCorrectionsEnabled)
     Q_PROPERTY(bool erasingEnabled READ erasingEnabled WRITE setErasingEnabled)
+    Q_PROPERTY(int randomSeed READ randomSeed WRITE setRandomSeed)
 
 public:
     explicit TileLayerWangEdit(EditableTileLayer *tileLayer,
@@ -87,6 +88,9 @@ public:
     bool erasingEnabled() const;
     void setErasingEnabled(bool erasingEnabled);
 
+    int randomSeed() const;
+    void setRandomSeed(int randomSeed);
+
     EditableTileLayer *target() const;
     EditableWangSet *wangSet() const;
 
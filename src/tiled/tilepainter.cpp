@@ -24,6 +24,7 @@
 #include "mapdocument.h"
 #include "map.h"
 
+#include <QBitArray>
 #include <QQueue>
 
 using namespace Tiled;
@@ -78,6 +79,7 @@ Cell TilePainter::cellAt(int x, int y) const
     const int layerX = x - mTileLayer->x();
     const int layerY = y - mTileLayer->y();
 
+    mTileLayer->pageIn(QRect(layerX, layerY, 1, 1));
     return mTileLayer->cellAt(layerX, layerY);
 }
 
@@ -95,7 +97,7 @@ void TilePainter::setCells(int x, int y,
                          tileLayer,
                          region.translated(-mTileLayer->position()));
 
-    emit mMapDocument->regionChanged(region, mTileLayer);
+    mMapDocument->emitRegionChanged(region, mTileLayer);
 }
 
 void TilePainter::drawCells(int x, int y, TileLayer *tileLayer)
@@ -120,7 +122,7 @@ void TilePainter::drawCells(int x, int y, TileLayer *tileLayer)
         }
     }
 
-    emit mMapDocument->regionChanged(region, mTileLayer);
+    mMapDocument->emitRegionChanged(region, mTileLayer);
 }
 
 void TilePainter::drawStamp(const TileLayer *stamp,
@@ -156,7 +158,7 @@ void TilePainter::drawStamp(const TileLayer *stamp,
         }
     }
 
-    emit mMapDocument->regionChanged(region, mTileLayer);
+    mMapDocument->emitRegionChanged(region, mTileLayer);
 }
 
 void TilePainter::erase(const QRegion &region)
@@ -166,22 +168,21 @@ void TilePainter::erase(const QRegion &region)
         return;
 
     mTileLayer->erase(paintable.translated(-mTileLayer->position()));
-    emit mMapDocument->regionChanged(paintable, mTileLayer);
+    mMapDocument->emitRegionChanged(paintable, mTileLayer);
 }
 
-static QRegion fillRegion(const TileLayer &layer,
-                          const QRegion &region,
-                          QPoint fillOrigin,
-                          std::function<bool(const Cell &)> condition,
-                          Map::Orientation orientation,
-                          Map::StaggerAxis staggerAxis,
-                          Map::StaggerIndex staggerIndex)
+TileRegion TilePainter::fillRegion(const TileLayer &layer,
+                                   const QRect &bounds,
+                                   QPoint fillOrigin,
+                                   std::function<bool(const Cell &)> condition,
+                                   Map::Orientation orientation,
+                                   Map::StaggerAxis staggerAxis,
+                                   Map::StaggerIndex staggerIndex)
 {
     // Return empty region when the bounds do not contain the fill origin
-    if (!region.contains(fillOrigin))
-        return QRegion();
+    if (!bounds.contains(fillOrigin))
+        return TileRegion();
 
-    const QRect bounds = region.boundingRect();
     const int width = bounds.width();
     const int height = bounds.height();
     const int indexOffset = -(bounds.left() + bounds.top() * width);
@@ -192,11 +193,10 @@ static QRegion fillRegion(const TileLayer &layer,
     QQueue<QPoint> fillPositions;
     fillPositions.enqueue(fillOrigin);
 
-    // Create an array that will store which cells have been processed
+    // Create a bitmask that will store which cells have been processed
     // This is faster than checking if a given cell is in the region/list
-    QVector<bool> processedCellsVec(width * height);
-    bool *processedCells = processedCellsVec.data();
-    QRegion fillRegion;
+    QBitArray processedCells(width * height);
+    TileRegion fillRegion;
 
     // Loop through queued positions and fill them, while at the same time
     // checking adjacent positions to see if they should be added
@@ -208,18 +208,18 @@ static QRegion fillRegion(const TileLayer &layer,
         int left = currentPoint.x();
         while (left > bounds.left() && condition(layer.cellAt(left - 1, currentPoint.y()))) {
             --left;
-            processedCells[indexOffset + startOfLine + left] = true;
+            processedCells.setBit(indexOffset + startOfLine + left);
         }
 
         // Seek as far right as we can
         int right = currentPoint.x();
         while (right < bounds.right() && condition(layer.cellAt(right + 1, currentPoint.y()))) {
             ++right;
-            processedCells[indexOffset + startOfLine + right] = true;
+            processedCells.setBit(indexOffset + startOfLine + right);
         }
 
         // Add cells between left and right to the region
-        fillRegion += QRegion(left, currentPoint.y(), right - left + 1, 1);
+        fillRegion.add(QRect(left, currentPoint.y(), right - left + 1, 1));
 
         bool leftColumnIsStaggered = false;
         bool rightColumnIsStaggered = false;
@@ -240,13 +240,13 @@ static QRegion fillRegion(const TileLayer &layer,
 
         // Loop between left and right and check if cells above or below need
         // to be added to the queue.
-        auto findFillPositions = [=,&fillPositions](int left, int right, int y) {
+        auto findFillPositions = [&](int left, int right, int y) {
             bool adjacentCellAdded = false;
 
             for (int x = left; x <= right; ++x) {
                 const int index = y * width + x;
 
-                if (!processedCells[indexOffset + index] && condition(layer.cellAt(x, y))) {
+                if (!processedCells.testBit(indexOffset + index) && condition(layer.cellAt(x, y))) {
                     // Do not add the cell to the queue if an adjacent cell was added.
                     if (!adjacentCellAdded) {
                         fillPositions.enqueue(QPoint(x, y));
@@ -256,7 +256,7 @@ static QRegion fillRegion(const TileLayer &layer,
                     adjacentCellAdded = false;
                 }
 
-                processedCells[indexOffset + index] = true;
+                processedCells.setBit(indexOffset + index);
             }
         };
 
@@ -298,39 +298,51 @@ QRegion TilePainter::computePaintableFillRegion(QPoint fillOrigin,
     const Map *map = mMapDocument->map();
     const QRegion &selection = mMapDocument->selectedArea();
 
-    QRegion bounds;
+    QRect bounds;
 
-    if (map->infinite())
-        bounds = selection.isEmpty() ? mTileLayer->bounds() : selection;
-    else
+    if (map->infinite()) {
+        if (selection.isEmpty()) {
+            bounds = mTileLayer->bounds();
+        } else {
+            if (!selection.contains(fillOrigin))
+                return QRegion();
+            bounds = selection.boundingRect();
+        }
+    } else {
         bounds = mTileLayer->rect();
+    }
+
+    // The fill can spread over the whole bounds
+    mTileLayer->pageIn(bounds.translated(-mTileLayer->position()));
 
-    QRegion region = fillRegion(*mTileLayer,
-                                bounds.translated(-mTileLayer->position()),
-                                fillOrigin - mTileLayer->position(),
-                                condition,
-                                map->orientation(), map->staggerAxis(), map->staggerIndex());
+    TileRegion region = fillRegion(*mTileLayer,
+                                   bounds.translated(-mTileLayer->position()),
+                                   fillOrigin - mTileLayer->position(),
+                                   condition,
+                                   map->orientation(), map->staggerAxis(), map->staggerIndex());
 
     region.translate(mTileLayer->position());
 
     if (!selection.isEmpty())
-        region &= selection;
+        region.intersect(TileRegion(selection));
 
-    return region;
+    return region.toQRegion();
 }
 
 QRegion TilePainter::computeFillRegion(QPoint fillOrigin,
                                        std::function<bool(const Cell &)> condition) const
 {
     const Map *map = mMapDocument->map();
-    QRegion bounds = map->infinite() ? mTileLayer->bounds() : mTileLayer->rect();
-    QRegion region = fillRegion(*mTileLayer,
-                                bounds.translated(-mTileLayer->position()),
-                                fillOrigin - mTileLayer->position(),
-                                condition,
-                                map->orientation(), map->staggerAxis(), map->staggerIndex());
-
-    return region.translated(mTileLayer->position());
+    const QRect bounds = map->infinite() ? mTileLayer->bounds() : mTileLayer->rect();
+    mTileLayer->pageIn(bounds.translated(-mTileLayer->position()));
+
+    const TileRegion region = fillRegion(*mTileLayer,
+                                         bounds.translated(-mTileLayer->position()),
+                                         fillOrigin - mTileLayer->position(),
+                                         condition,
+                                         map->orientation(), map->staggerAxis(), map->staggerIndex());
+
+    return region.translated(mTileLayer->position()).toQRegion();
 }
 
 QRegion TilePainter::paintableRegion(const QRegion &region) const
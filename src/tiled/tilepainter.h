@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include "map.h"
+#include "tilededitor_global.h"
 #include "tilelayer.h"
 
 #include <QRegion>
@@ -37,7 +39,7 @@ class MapDocument;
  * This class also does bounds checking and when there is a tile selection, it
  * will only draw within this selection.
  */
-class TilePainter
+class TILED_EDITOR_EXPORT TilePainter
 {
 public:
     /**
@@ -52,6 +54,8 @@ public:
      * Returns the cell at the given coordinates. The coordinates are relative
      * to the map origin. Returns an empty cell if the coordinates lay outside
      * of the layer.
+     *
+     * Pages in the chunk containing the cell, when it is stored.
      */
     Cell cellAt(int x, int y) const;
     Cell cellAt(QPoint pos) const;
@@ -98,6 +102,23 @@ public:
      */
     QRegion computeFillRegion(QPoint fillOrigin, std::function<bool(const Cell &)> condition) const;
 
+    /**
+     * Computes the region of connected cells in \a layer for which the given
+     * \a condition returns true, starting at \a fillOrigin and limited to
+     * \a bounds. Coordinates are relative to the layer, which needs to have
+     * the \a bounds paged in.
+     *
+     * Uses a scanline fill that marks processed cells in a bitmask and
+     * collects the filled spans in a TileRegion.
+     */
+    static TileRegion fillRegion(const TileLayer &layer,
+                                 const QRect &bounds,
+                                 QPoint fillOrigin,
+                                 std::function<bool(const Cell &)> condition,
+                                 Map::Orientation orientation,
+                                 Map::StaggerAxis staggerAxis,
+                                 Map::StaggerIndex staggerIndex);
+
 private:
     QRegion paintableRegion(const QRegion &region) const;
     QRegion paintableRegion(int x, int y, int width, int height) const
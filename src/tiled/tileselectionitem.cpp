@@ -21,17 +21,47 @@
 #include "tileselectionitem.h"
 
 #include "changeevents.h"
+#include "map.h"
 #include "mapdocument.h"
 #include "maprenderer.h"
 #include "mapscene.h"
+#include "tileregion.h"
 
 #include <QApplication>
 #include <QPainter>
 #include <QPalette>
 #include <QStyleOptionGraphicsItem>
 
+#include <algorithm>
+#include <cmath>
+
 using namespace Tiled;
 
+// Selections with more rectangles than this get a simplified outline when
+// their tiles become too small to see
+static const int lodRectCount = 256;
+static const qreal minBlockPixels = 4;
+static const int maxBlockSize = 64;
+
+/**
+ * Returns the given \a region with each rectangle extended to cover whole
+ * blocks of \a blockSize by \a blockSize tiles.
+ */
+static QRegion alignedToBlocks(const QRegion &region, int blockSize)
+{
+    const int mask = ~(blockSize - 1);
+    TileRegion aligned;
+
+    for (const QRect &r : region) {
+        const QPoint topLeft(r.left() & mask, r.top() & mask);
+        const QPoint bottomRight((r.right() & mask) + blockSize - 1,
+                                 (r.bottom() & mask) + blockSize - 1);
+        aligned.add(QRect(topLeft, bottomRight));
+    }
+
+    return aligned.toQRegion();
+}
+
 TileSelectionItem::TileSelectionItem(MapDocument *mapDocument,
                                      QGraphicsItem *parent)
     : QGraphicsObject(parent)
@@ -70,8 +100,31 @@ void TileSelectionItem::paint(QPainter *painter,
     highlight.setAlpha(128);
 
     MapRenderer *renderer = mMapDocument->renderer();
-    renderer->drawTileSelection(painter, selection, highlight,
-                                option->exposedRect);
+
+    // Small selections are cheap enough to draw without caching
+    if (selection.rectCount() <= 1) {
+        renderer->drawTileSelection(painter, selection, highlight,
+                                    option->exposedRect);
+        return;
+    }
+
+    int blockSize = 1;
+
+    if (selection.rectCount() > lodRectCount) {
+        const QTransform &transform = painter->worldTransform();
+        const qreal scale = std::sqrt(std::abs(transform.determinant()));
+        const QSize tileSize = mMapDocument->map()->tileSize();
+        const qreal tilePixels = std::min(tileSize.width(), tileSize.height()) * scale;
+
+        while (blockSize < maxBlockSize && tilePixels * blockSize < minBlockPixels)
+            blockSize *= 2;
+
+        // The extended selection shouldn't be drawn outside of our bounds
+        if (blockSize > 1)
+            painter->setClipRect(mBoundingRect, Qt::IntersectClip);
+    }
+
+    renderer->drawTileSelection(painter, outline(blockSize), highlight);
 }
 
 void TileSelectionItem::documentChanged(const ChangeEvent &change)
@@ -81,6 +134,13 @@ void TileSelectionItem::documentChanged(const ChangeEvent &change)
         selectionChanged(mMapDocument->selectedArea(),
                          mMapDocument->selectedArea());
         break;
+    case ChangeEvent::MapChanged:
+        // The outline depends on the orientation and tile size
+        mOutlines.clear();
+        prepareGeometryChange();
+        updateBoundingRect();
+        update();
+        break;
     case ChangeEvent::LayerChanged: {
         const auto &layerChange = static_cast<const LayerChangeEvent&>(change);
         if (layerChange.properties & LayerChangeEvent::PositionProperties)
@@ -97,6 +157,8 @@ void TileSelectionItem::documentChanged(const ChangeEvent &change)
 void TileSelectionItem::selectionChanged(const QRegion &newSelection,
                                          const QRegion &oldSelection)
 {
+    mOutlines.clear();
+
     prepareGeometryChange();
     updateBoundingRect();
 
@@ -114,4 +176,23 @@ void TileSelectionItem::updateBoundingRect()
     mBoundingRect.adjust(-1, -1, 1, 1);
 }
 
+/**
+ * Returns the outline of the selection, with the selection extended to
+ * whole blocks of \a blockSize tiles. The outline is kept until the
+ * selection changes, since building it is slow for large selections.
+ */
+const QPainterPath &TileSelectionItem::outline(int blockSize)
+{
+    auto it = mOutlines.find(blockSize);
+    if (it == mOutlines.end()) {
+        QRegion region = mMapDocument->selectedArea();
+        if (blockSize > 1)
+            region = alignedToBlocks(region, blockSize);
+
+        const MapRenderer *renderer = mMapDocument->renderer();
+        it = mOutlines.insert(blockSize, renderer->tileSelectionOutline(region));
+    }
+    return it.value();
+}
+
 #include "moc_tileselectionitem.cpp"
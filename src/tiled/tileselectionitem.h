@@ -21,6 +21,8 @@
 #pragma once
 
 #include <QGraphicsObject>
+#include <QHash>
+#include <QPainterPath>
 
 namespace Tiled {
 
@@ -58,8 +60,11 @@ private:
 
     void updateBoundingRect();
 
+    const QPainterPath &outline(int blockSize);
+
     MapDocument *mMapDocument;
     QRectF mBoundingRect;
+    QHash<int, QPainterPath> mOutlines;     // by block size
 };
 
 } // namespace Tiled
@@ -78,6 +78,12 @@ namespace preferences {
 static Preference<bool> showTilesetFilter { "Interface/ShowTilesetFilter", true };
 } // namespace preferences
 
+/**
+ * The number of views kept around for tilesets that are no longer shown, to
+ * make switching between maps using the same tilesets fast.
+ */
+static const int maxKeptTilesetViews = 64;
+
 namespace {
 
 class NoTilesetWidget : public QWidget
@@ -600,29 +606,38 @@ void TilesetDock::createTilesetView(int index, TilesetDocument *tilesetDocument)
 
     mTilesetDocuments.insert(index, tilesetDocument);
 
-    TilesetView *view = new TilesetView;
+    TilesetView *view = takeKeptTilesetView(tilesetDocument);
 
     // Hides the "New Tileset..." special view if it is shown.
     mSuperViewStack->setCurrentIndex(1);
 
-    // Restore state from last time
-    const QString fileName = tilesetDocument->externalOrEmbeddedFileName();
-    const QVariantMap fileState = Session::current().fileState(fileName);
-    if (fileState.isEmpty()) {
-        // Compatibility with Tiled 1.3
-        QString path = QLatin1String("TilesetDock/TilesetScale/") + tileset->name();
-        qreal scale = Preferences::instance()->value(path, 1).toReal();
-        view->zoomable()->setScale(scale);
-    } else {
-        bool ok;
-        const qreal scale = fileState.value(QLatin1String("scaleInDock")).toReal(&ok);
-        if (scale > 0 && ok)
+    if (!view) {
+        view = new TilesetView;
+
+        // Restore state from last time
+        const QString fileName = tilesetDocument->externalOrEmbeddedFileName();
+        const QVariantMap fileState = Session::current().fileState(fileName);
+        if (fileState.isEmpty()) {
+            // Compatibility with Tiled 1.3
+            QString path = QLatin1String("TilesetDock/TilesetScale/") + tileset->name();
+            qreal scale = Preferences::instance()->value(path, 1).toReal();
             view->zoomable()->setScale(scale);
-
-        if (fileState.contains(QLatin1String("dynamicWrapping"))) {
-            const bool dynamicWrapping = fileState.value(QLatin1String("dynamicWrapping")).toBool();
-            view->setDynamicWrapping(dynamicWrapping);
+        } else {
+            bool ok;
+            const qreal scale = fileState.value(QLatin1String("scaleInDock")).toReal(&ok);
+            if (scale > 0 && ok)
+                view->zoomable()->setScale(scale);
+
+            if (fileState.contains(QLatin1String("dynamicWrapping"))) {
+                const bool dynamicWrapping = fileState.value(QLatin1String("dynamicWrapping")).toBool();
+                view->setDynamicWrapping(dynamicWrapping);
+            }
         }
+
+        connect(view, &TilesetView::clicked,
+                this, &TilesetDock::updateCurrentTiles);
+        connect(view, &TilesetView::swapTilesRequested,
+                this, &TilesetDock::swapTiles);
     }
 
     // Insert view before the tab to make sure it is there when the tab index
@@ -642,11 +657,6 @@ void TilesetDock::createTilesetView(int index, TilesetDocument *tilesetDocument)
             this, &TilesetDock::tilesetFileNameChanged);
     connect(tilesetDocument, &TilesetDocument::tilesetChanged,
             this, &TilesetDock::tilesetChanged);
-
-    connect(view, &TilesetView::clicked,
-            this, &TilesetDock::updateCurrentTiles);
-    connect(view, &TilesetView::swapTilesRequested,
-            this, &TilesetDock::swapTiles);
 }
 
 void TilesetDock::deleteTilesetView(int index)
@@ -666,7 +676,15 @@ void TilesetDock::deleteTilesetView(int index)
     Preferences::instance()->remove(path);
 
     mTilesetDocuments.removeAt(index);
-    delete view;                    // view needs to go before the tab
+
+    // View needs to go before the tab. Views without a model are cheap to
+    // create, so only those that were shown before are kept.
+    mViewStack->removeWidget(view);
+    if (view->model())
+        keepTilesetView(tilesetDocument, view);
+    else
+        delete view;
+
     mTabBar->removeTab(index);
 
     // Make the "New Tileset..." special tab reappear if there is no tileset open
@@ -1092,6 +1110,68 @@ TilesetView *TilesetDock::tilesetViewAt(int index) const
     return static_cast<TilesetView *>(mViewStack->widget(index));
 }
 
+/**
+ * Keeps the \a view of a tileset that is no longer shown in the dock, so that
+ * it doesn't need to be set up again when the tileset is shown again. Only
+ * the most recently used views are kept.
+ */
+void TilesetDock::keepTilesetView(TilesetDocument *tilesetDocument, TilesetView *view)
+{
+    view->hide();
+
+    KeptView kept { tilesetDocument, view, {}, {} };
+
+    kept.tilesetChanged = connect(tilesetDocument, &TilesetDocument::tilesetChanged,
+                                  view, [view] {
+        view->updateBackgroundColor();
+        view->tilesetModel()->tilesetChanged();
+    });
+
+    kept.destroyed = connect(tilesetDocument, &QObject::destroyed,
+                             view, [this, tilesetDocument] {
+        if (TilesetView *view = takeKeptTilesetView(tilesetDocument))
+            view->deleteLater();
+    });
+
+    mKeptViews.append(kept);
+
+    if (mKeptViews.size() > maxKeptTilesetViews) {
+        const KeptView oldest = mKeptViews.takeFirst();
+        disconnect(oldest.tilesetChanged);
+        disconnect(oldest.destroyed);
+        delete oldest.view;
+    }
+}
+
+/**
+ * Returns the view kept for the given \a tilesetDocument, if any, removing it
+ * from the kept views.
+ */
+TilesetView *TilesetDock::takeKeptTilesetView(TilesetDocument *tilesetDocument)
+{
+    for (int i = mKeptViews.size() - 1; i >= 0; --i) {
+        const KeptView &kept = mKeptViews.at(i);
+        if (kept.tilesetDocument != tilesetDocument)
+            continue;
+
+        disconnect(kept.tilesetChanged);
+        disconnect(kept.destroyed);
+
+        TilesetView *view = kept.view;
+        mKeptViews.remove(i);
+
+        // The selection was made for the previous map
+        if (QItemSelectionModel *selectionModel = view->selectionModel()) {
+            const QSignalBlocker blocker(selectionModel);
+            selectionModel->clear();
+        }
+
+        return view;
+    }
+
+    return nullptr;
+}
+
 void TilesetDock::setupTilesetModel(TilesetView *view, TilesetDocument *tilesetDocument)
 {
     view->setModel(new TilesetModel(tilesetDocument, view));
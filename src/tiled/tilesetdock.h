@@ -29,6 +29,7 @@
 #include <QDockWidget>
 #include <QList>
 #include <QMap>
+#include <QVector>
 
 #include <memory>
 
@@ -176,10 +177,25 @@ private:
     void deleteTilesetView(int index);
     void moveTilesetView(int from, int to);
     void setupTilesetModel(TilesetView *view, TilesetDocument *tilesetDocument);
+    void keepTilesetView(TilesetDocument *tilesetDocument, TilesetView *view);
+    TilesetView *takeKeptTilesetView(TilesetDocument *tilesetDocument);
+
+    /**
+     * A view that was set up for a tileset no longer shown in the dock, kept
+     * for when the tileset is shown again (usually after switching maps).
+     */
+    struct KeptView
+    {
+        TilesetDocument *tilesetDocument;
+        TilesetView *view;
+        QMetaObject::Connection tilesetChanged;
+        QMetaObject::Connection destroyed;
+    };
 
     MapDocument *mMapDocument = nullptr;
 
     QList<TilesetDocument *> mTilesetDocuments;
+    QVector<KeptView> mKeptViews;   // Least recently used first
     TilesetDocumentsFilterModel *mTilesetDocumentsFilterModel;
     FilterEdit *mTilesetFilterEdit;
 
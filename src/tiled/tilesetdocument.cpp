@@ -36,6 +36,8 @@
 #include <QQmlEngine>
 #include <QUndoStack>
 
+#include <utility>
+
 namespace Tiled {
 
 class ReloadTileset : public QUndoCommand
@@ -87,6 +89,12 @@ TilesetDocument::TilesetDocument(const SharedTileset &tileset)
 
     connect(mWangSetModel, &TilesetWangSetModel::wangSetRemoved,
             this, &TilesetDocument::onWangSetRemoved);
+
+    // Changes to many tiles are forwarded to the map documents at once
+    mMapDocumentsUpdateTimer.setSingleShot(true);
+    mMapDocumentsUpdateTimer.setInterval(0);
+    connect(&mMapDocumentsUpdateTimer, &QTimer::timeout,
+            this, &TilesetDocument::updateMapDocuments);
 }
 
 TilesetDocument::~TilesetDocument()
@@ -167,6 +175,11 @@ bool TilesetDocument::reload(QString *error)
     return true;
 }
 
+MemoryUsage TilesetDocument::memoryUsage() const
+{
+    return Tiled::memoryUsage(*mTileset);
+}
+
 TilesetDocumentPtr TilesetDocument::load(const QString &fileName,
                                          TilesetFormat *format,
                                          QString *error)
@@ -259,6 +272,7 @@ void TilesetDocument::swapTileset(SharedTileset &tileset)
     setSelectedTiles(QList<Tile*>());
     setCurrentObject(mTileset.data());
     mWangColorModels.clear();
+    updateMapDocuments();
 
     emit changed(AboutToReloadEvent());
 
@@ -343,6 +357,9 @@ void TilesetDocument::addTiles(const QList<Tile *> &tiles)
 
 void TilesetDocument::removeTiles(const QList<Tile *> &tiles)
 {
+    // Pending notifications may refer to the removed tiles
+    updateMapDocuments();
+
     // Switch current object to the tileset when it is one of the removed tiles
     for (Tile *tile : tiles) {
         if (tile == currentObject()) {
@@ -410,10 +427,7 @@ void TilesetDocument::setTileImage(Tile *tile,
     Q_ASSERT(tile->tileset() == mTileset.data());
 
     mTileset->setTileImage(tile, image, source);
-    emit tileImageSourceChanged(tile);
-
-    for (MapDocument *mapDocument : mapDocuments())
-        emit mapDocument->tileImageSourceChanged(tile);
+    emitTileImageSourceChanged(tile);
 }
 
 void TilesetDocument::setTileProbability(Tile *tile, qreal probability)
@@ -423,8 +437,8 @@ void TilesetDocument::setTileProbability(Tile *tile, qreal probability)
     tile->setProbability(probability);
     emit tileProbabilityChanged(tile);
 
-    for (MapDocument *mapDocument : mapDocuments())
-        emit mapDocument->tileProbabilityChanged(tile);
+    mPendingProbabilityChanges.insert(tile);
+    scheduleMapDocumentsUpdate();
 }
 
 void TilesetDocument::swapTileObjectGroup(Tile *tile, std::unique_ptr<ObjectGroup> &objectGroup)
@@ -432,8 +446,21 @@ void TilesetDocument::swapTileObjectGroup(Tile *tile, std::unique_ptr<ObjectGrou
     tile->swapObjectGroup(objectGroup);
     emit tileObjectGroupChanged(tile);
 
-    for (MapDocument *mapDocument : mapDocuments())
-        emit mapDocument->tileObjectGroupChanged(tile);
+    mPendingObjectGroupChanges.insert(tile);
+    scheduleMapDocumentsUpdate();
+}
+
+/**
+ * Emits tileImageSourceChanged for the given \a tile. The map documents using
+ * this tileset are notified once the current event has been processed, so
+ * that changing many tiles repaints the maps only once.
+ */
+void TilesetDocument::emitTileImageSourceChanged(Tile *tile)
+{
+    emit tileImageSourceChanged(tile);
+
+    mPendingImageSourceChanges.insert(tile);
+    scheduleMapDocumentsUpdate();
 }
 
 void TilesetDocument::checkIssues()
@@ -447,10 +474,11 @@ void TilesetDocument::checkIssues()
               std::function<void()>(), this);       // todo: hook to file dialog
     }
 
-    checkFilePathProperties(tileset().data());
+    QVector<FilePathReference> references;
+    checkFilePathProperties(tileset().data(), references);
 
     for (Tile *tile : tileset()->tiles()) {
-        checkFilePathProperties(tile);
+        checkFilePathProperties(tile, references);
         // todo: check properties on collision objects
 
         if (!tile->imageSource().isEmpty() && tile->imageStatus() == LoadingError) {
@@ -460,9 +488,11 @@ void TilesetDocument::checkIssues()
         }
     }
     for (WangSet *wangSet : tileset()->wangSets()) {
-        checkFilePathProperties(wangSet);
+        checkFilePathProperties(wangSet, references);
         // todo: check properties on wang colors
     }
+
+    checkFilePathReferences(std::move(references));
 }
 
 TilesetDocument *TilesetDocument::findDocumentForTileset(const SharedTileset &tileset)
@@ -494,6 +524,33 @@ void TilesetDocument::onPropertiesChanged(Object *object)
         emit mapDocument->propertiesChanged(object);
 }
 
+void TilesetDocument::scheduleMapDocumentsUpdate()
+{
+    if (!mMapDocumentsUpdateTimer.isActive())
+        mMapDocumentsUpdateTimer.start();
+}
+
+/**
+ * Forwards the pending tile changes to the map documents using this tileset.
+ */
+void TilesetDocument::updateMapDocuments()
+{
+    mMapDocumentsUpdateTimer.stop();
+
+    const QList<Tile*> imageSourceChanges = std::exchange(mPendingImageSourceChanges, {}).values();
+    const QList<Tile*> probabilityChanges = std::exchange(mPendingProbabilityChanges, {}).values();
+    const QList<Tile*> objectGroupChanges = std::exchange(mPendingObjectGroupChanges, {}).values();
+
+    for (MapDocument *mapDocument : mapDocuments()) {
+        if (!imageSourceChanges.isEmpty())
+            emit mapDocument->tileImageSourceChanged(imageSourceChanges);
+        if (!probabilityChanges.isEmpty())
+            emit mapDocument->tileProbabilityChanged(probabilityChanges);
+        if (!objectGroupChanges.isEmpty())
+            emit mapDocument->tileObjectGroupChanged(objectGroupChanges);
+    }
+}
+
 void TilesetDocument::onWangSetRemoved(WangSet *wangSet)
 {
     mWangColorModels.erase(wangSet);
@@ -27,6 +27,8 @@
 
 #include <QList>
 #include <QMap>
+#include <QSet>
+#include <QTimer>
 
 #include <memory>
 #include <unordered_map>
@@ -61,6 +63,8 @@ public:
     bool canReload() const override;
     bool reload(QString *error);
 
+    MemoryUsage memoryUsage() const override;
+
     /**
      * Loads a tileset and returns a TilesetDocument instance on success.
      * Returns null on error and sets the \a error message.
@@ -115,6 +119,8 @@ public:
     void setTileProbability(Tile *tile, qreal probability);
     void swapTileObjectGroup(Tile *tile, std::unique_ptr<ObjectGroup> &objectGroup);
 
+    void emitTileImageSourceChanged(Tile *tile);
+
     void checkIssues() override;
 
     static TilesetDocument* findDocumentForTileset(const SharedTileset &tileset);
@@ -175,9 +181,18 @@ private:
 
     void onWangSetRemoved(WangSet *wangSet);
 
+    void scheduleMapDocumentsUpdate();
+    void updateMapDocuments();
+
     SharedTileset mTileset;
     QList<MapDocument*> mMapDocuments;
 
+    // Tile changes not yet forwarded to the map documents
+    QSet<Tile*> mPendingImageSourceChanges;
+    QSet<Tile*> mPendingProbabilityChanges;
+    QSet<Tile*> mPendingObjectGroupChanges;
+    QTimer mMapDocumentsUpdateTimer;
+
     TilesetWangSetModel *mWangSetModel;
     std::unordered_map<WangSet*, std::unique_ptr<WangColorModel>> mWangColorModels;
 
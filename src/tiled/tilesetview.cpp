@@ -37,6 +37,7 @@
 #include <QAbstractItemDelegate>
 #include <QApplication>
 #include <QCoreApplication>
+#include <QFutureWatcher>
 #include <QGesture>
 #include <QGestureEvent>
 #include <QHeaderView>
@@ -44,13 +45,17 @@
 #include <QPainter>
 #include <QPainterPath>
 #include <QPinchGesture>
+#include <QPixmapCache>
 #include <QScrollBar>
 #include <QUndoCommand>
 #include <QWheelEvent>
+#include <QtConcurrent>
 #include <QtCore/qmath.h>
 
 #include <QDebug>
 
+#include <cmath>
+
 using namespace Tiled;
 
 namespace {
@@ -153,9 +158,13 @@ void TileDelegate::paint(QPainter *painter,
         if (zoomable->smoothTransform())
             painter->setRenderHint(QPainter::SmoothPixmapTransform);
 
-    if (!tileImage.isNull())
-        painter->drawPixmap(targetRect, tileImage, tile->imageRect());
-    else
+    if (!tileImage.isNull()) {
+        const QPixmap thumbnail = mTilesetView->thumbnail(tile, targetRect.size());
+        if (!thumbnail.isNull())
+            painter->drawPixmap(targetRect, thumbnail);
+        else
+            painter->drawPixmap(targetRect, tileImage, tile->imageRect());
+    } else
         mTilesetView->imageMissingIcon().paint(painter, targetRect, Qt::AlignBottom | Qt::AlignLeft);
 
 
@@ -571,6 +580,66 @@ QIcon TilesetView::imageMissingIcon() const
     return QIcon::fromTheme(QLatin1String("image-missing"), mImageMissingIcon);
 }
 
+/**
+ * Returns a downscaled image of the given collection \a tile, for drawing it
+ * at the given \a size. Thumbnails are created in the background at halving
+ * steps of the original size and kept in the pixmap cache.
+ *
+ * Returns a null pixmap when the tile image can be drawn directly or while
+ * its thumbnail is being created.
+ */
+QPixmap TilesetView::thumbnail(const Tile *tile, QSize size)
+{
+    if (!tile->tileset()->isCollection())
+        return QPixmap();
+
+    const QRect imageRect = tile->imageRect();
+    const QSize pixelSize = (QSizeF(size) * devicePixelRatioF()).toSize();
+    if (pixelSize.isEmpty() || imageRect.isEmpty())
+        return QPixmap();
+
+    const qreal factor = std::min(qreal(imageRect.width()) / pixelSize.width(),
+                                  qreal(imageRect.height()) / pixelSize.height());
+    const int level = std::min(qFloor(std::log2(factor)), 16);
+    if (level < 1)
+        return QPixmap();
+
+    const QString key = QStringLiteral("tiled-tile-thumbnail:%1:%2,%3,%4,%5:%6")
+            .arg(tile->image().cacheKey())
+            .arg(imageRect.x()).arg(imageRect.y())
+            .arg(imageRect.width()).arg(imageRect.height())
+            .arg(level);
+
+    QPixmap pixmap;
+    if (QPixmapCache::find(key, &pixmap))
+        return pixmap;
+
+    if (mPendingThumbnails.contains(key))
+        return QPixmap();
+
+    mPendingThumbnails.insert(key);
+
+    const QImage image = tile->image().toImage();
+    const QSize thumbnailSize(std::max(1, imageRect.width() >> level),
+                              std::max(1, imageRect.height() >> level));
+
+    auto watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, key] {
+        watcher->deleteLater();
+        mPendingThumbnails.remove(key);
+        QPixmapCache::insert(key, QPixmap::fromImage(watcher->result()));
+        viewport()->update();
+    });
+
+    watcher->setFuture(QtConcurrent::run([image, imageRect, thumbnailSize] {
+        return image.copy(imageRect).scaled(thumbnailSize,
+                                            Qt::IgnoreAspectRatio,
+                                            Qt::SmoothTransformation);
+    }));
+
+    return QPixmap();
+}
+
 void TilesetView::mousePressEvent(QMouseEvent *event)
 {
     if (mEditWangSet) {
@@ -23,6 +23,7 @@
 #include "tilesetmodel.h"
 #include "wangset.h"
 
+#include <QSet>
 #include <QTableView>
 
 namespace Tiled {
@@ -98,6 +99,8 @@ public:
 
     QIcon imageMissingIcon() const;
 
+    QPixmap thumbnail(const Tile *tile, QSize size);
+
     void updateBackgroundColor();
 
 signals:
@@ -160,6 +163,7 @@ private:
     bool mWangIdChanged = false;
 
     const QIcon mImageMissingIcon;
+    QSet<QString> mPendingThumbnails;
 };
 
 inline TilesetDocument *TilesetView::tilesetDocument() const
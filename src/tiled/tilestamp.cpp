@@ -179,11 +179,11 @@ void TileStamp::setQuickStampIndex(int quickStampIndex)
     d->quickStampIndex = quickStampIndex;
 }
 
-RandomPicker<Map *> TileStamp::randomVariations() const
+AliasRandomPicker<Map *> TileStamp::randomVariations() const
 {
     Q_ASSERT(!d->variations.isEmpty());
 
-    RandomPicker<Map *> randomPicker;
+    AliasRandomPicker<Map *> randomPicker;
     for (const TileStampVariation &variation : std::as_const(d->variations))
         randomPicker.add(variation.map, variation.probability);
 
@@ -35,13 +35,23 @@
 
 #include <QDebug>
 #include <QDirIterator>
+#include <QFutureWatcher>
 #include <QJsonDocument>
 #include <QRegularExpression>
+#include <QTimer>
+#include <QtConcurrent>
 
+#include <algorithm>
 #include <memory>
 
 using namespace Tiled;
 
+/**
+ * The number of loaded stamps added to the model at once, before giving the
+ * event loop a chance to run.
+ */
+static const int stampsPerBatch = 50;
+
 TileStampManager *TileStampManager::ourInstance;
 
 TileStampManager::TileStampManager(const ToolManager &toolManager,
@@ -101,6 +111,7 @@ static TileStamp stampFromContext(AbstractTool *selectedTool)
         mapParameters.infinite = false;
         auto copyMap = std::make_unique<Map>(mapParameters);
 
+        mapDocument->map()->pageInChunks(selectedArea);
         map->copyLayers(mapDocument->selectedLayers(), selectedArea, *copyMap);
 
         if (map->layerCount() > 0) {
@@ -168,6 +179,8 @@ void TileStampManager::stampsDirectoryChanged()
     mQuickStamps.fill(TileStamp());
     mStampsByName.clear();
     mTileStampModel->clear();
+    mLoadedStampFiles.clear();
+    mLoadedStampIndex = 0;
 
     loadStamps();
 }
@@ -195,9 +208,44 @@ void TileStampManager::setQuickStamp(int index, TileStamp stamp)
     mQuickStamps[index] = stamp;
 }
 
+/**
+ * Loads the stamps from the stamps directory. The stamp files are read and
+ * parsed in the background, after which the stamps are added in batches.
+ */
 void TileStampManager::loadStamps()
 {
-    const QDir stampsDir(stampsDirectory,
+    const QString directory = stampsDirectory;
+
+    auto watcher = new QFutureWatcher<QVector<StampFile>>(this);
+    mLoadWatcher = watcher;
+
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, directory] {
+        watcher->deleteLater();
+
+        // Ignore the result when the stamps directory changed meanwhile
+        if (mLoadWatcher != watcher)
+            return;
+
+        mLoadWatcher = nullptr;
+        mLoadedStampFiles = watcher->result();
+        mLoadedStampIndex = 0;
+        mLoadedStampsDir = QDir(directory);
+
+        addLoadedStamps();
+    });
+
+    watcher->setFuture(QtConcurrent::run(&TileStampManager::readStampFiles, directory));
+}
+
+/**
+ * Reads and parses the stamp files in the given \a directory. Called from a
+ * worker thread, since creating the stamps needs to happen on the main thread.
+ */
+QVector<TileStampManager::StampFile> TileStampManager::readStampFiles(const QString &directory)
+{
+    QVector<StampFile> stampFiles;
+
+    const QDir stampsDir(directory,
                          QLatin1String("*.stamp"),
                          QDir::Name | QDir::IgnoreCase,
                          QDir::Files | QDir::Readable);
@@ -218,11 +266,25 @@ void TileStampManager::loadStamps()
             continue;
         }
 
-        TileStamp stamp = TileStamp::fromJson(document.object(), stampsDir);
+        stampFiles.append({ iterator.fileName(), document.object() });
+    }
+
+    return stampFiles;
+}
+
+void TileStampManager::addLoadedStamps()
+{
+    const int end = std::min<int>(mLoadedStampIndex + stampsPerBatch,
+                                  mLoadedStampFiles.size());
+
+    for (; mLoadedStampIndex < end; ++mLoadedStampIndex) {
+        const StampFile &stampFile = mLoadedStampFiles.at(mLoadedStampIndex);
+
+        TileStamp stamp = TileStamp::fromJson(stampFile.json, mLoadedStampsDir);
         if (stamp.isEmpty())
             continue;
 
-        stamp.setFileName(iterator.fileName());
+        stamp.setFileName(stampFile.fileName);
 
         mTileStampModel->addStamp(stamp);
 
@@ -230,6 +292,13 @@ void TileStampManager::loadStamps()
         if (index >= 0 && index < mQuickStamps.size())
             mQuickStamps[index] = stamp;
     }
+
+    if (mLoadedStampIndex < mLoadedStampFiles.size()) {
+        QTimer::singleShot(0, this, &TileStampManager::addLoadedStamps);
+    } else {
+        mLoadedStampFiles.clear();
+        mLoadedStampIndex = 0;
+    }
 }
 
 void TileStampManager::stampAdded(TileStamp stamp)
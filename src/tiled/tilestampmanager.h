@@ -24,10 +24,14 @@
 #include "session.h"
 #include "tilestamp.h"
 
+#include <QDir>
+#include <QJsonObject>
 #include <QMap>
 #include <QObject>
 #include <QVector>
 
+template<typename T> class QFutureWatcher;
+
 namespace Tiled {
 
 class Map;
@@ -81,6 +85,15 @@ private:
     void setQuickStamp(int index, TileStamp stamp);
 
 private:
+    struct StampFile
+    {
+        QString fileName;
+        QJsonObject json;
+    };
+
+    static QVector<StampFile> readStampFiles(const QString &directory);
+    void addLoadedStamps();
+
     void stampAdded(TileStamp stamp);
     void stampRenamed(TileStamp stamp);
     void saveStamp(const TileStamp &stamp);
@@ -94,6 +107,11 @@ private:
     TileStampModel *mTileStampModel;
     Session::CallbackIterator mRegisteredCb;
 
+    QFutureWatcher<QVector<StampFile>> *mLoadWatcher = nullptr;
+    QVector<StampFile> mLoadedStampFiles;
+    int mLoadedStampIndex = 0;
+    QDir mLoadedStampsDir;
+
     const ToolManager &mToolManager;
 
     static TileStampManager *ourInstance;
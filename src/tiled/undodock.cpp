@@ -21,7 +21,12 @@
 
 #include "undodock.h"
 
+#include "painttilelayer.h"
+
 #include <QEvent>
+#include <QLabel>
+#include <QLocale>
+#include <QUndoStack>
 #include <QUndoView>
 #include <QVBoxLayout>
 
@@ -37,10 +42,15 @@ UndoDock::UndoDock(QWidget *parent)
     mUndoView->setCleanIcon(cleanIcon);
     mUndoView->setUniformItemSizes(true);
 
+    mMemoryUsageLabel = new QLabel(this);
+    mMemoryUsageLabel->setContentsMargins(4, 2, 4, 2);
+
     QWidget *widget = new QWidget(this);
     QVBoxLayout *layout = new QVBoxLayout(widget);
     layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
     layout->addWidget(mUndoView);
+    layout->addWidget(mMemoryUsageLabel);
 
     setWidget(widget);
     retranslateUi();
@@ -48,7 +58,16 @@ UndoDock::UndoDock(QWidget *parent)
 
 void UndoDock::setStack(QUndoStack *stack)
 {
+    if (mStack)
+        mStack->disconnect(this);
+
+    mStack = stack;
     mUndoView->setStack(stack);
+
+    if (stack)
+        connect(stack, &QUndoStack::indexChanged, this, &UndoDock::updateMemoryUsage);
+
+    updateMemoryUsage();
 }
 
 void UndoDock::changeEvent(QEvent *e)
@@ -67,6 +86,17 @@ void UndoDock::retranslateUi()
 {
     setWindowTitle(tr("History"));
     mUndoView->setEmptyLabel(tr("<empty>"));
+    updateMemoryUsage();
+}
+
+/**
+ * Shows the memory used by the tile changes on all undo stacks, since they
+ * are usually the largest.
+ */
+void UndoDock::updateMemoryUsage()
+{
+    const qint64 bytes = PaintTileLayer::totalMemoryUsage();
+    mMemoryUsageLabel->setText(tr("Tile changes: %1").arg(QLocale().formattedDataSize(bytes)));
 }
 
 #include "moc_undodock.cpp"
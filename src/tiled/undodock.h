@@ -22,7 +22,9 @@
 #pragma once
 
 #include <QDockWidget>
+#include <QPointer>
 
+class QLabel;
 class QUndoStack;
 class QUndoView;
 
@@ -46,7 +48,11 @@ protected:
 
 private:
     void retranslateUi();
+    void updateMemoryUsage();
+
     QUndoView *mUndoView;
+    QLabel *mMemoryUsageLabel;
+    QPointer<QUndoStack> mStack;
 };
 
 } // namespace Tiled
@@ -70,6 +70,29 @@ void WangBrushItem::paint(QPainter *painter,
     }
 }
 
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+static uint qHash(const WangBrushPreviewKey &key, uint seed = 0) Q_DECL_NOTHROW
+{
+    auto h = ::qHash(key.wangSet, seed);
+    h = ::qHash(key.wangSetRevision, h);
+    h = ::qHash(key.paintPoint.x(), h);
+    h = ::qHash(key.paintPoint.y(), h);
+    h = ::qHash(key.wangIndex, h);
+    h = ::qHash(key.color, h);
+    h = ::qHash(key.brushMode, h);
+    h = ::qHash(key.tileMode, h);
+    h = ::qHash(key.rotationalSymmetry, h);
+    return h;
+}
+#else
+static size_t qHash(const WangBrushPreviewKey &key, size_t seed = 0) Q_DECL_NOTHROW
+{
+    return qHashMulti(seed, key.wangSet, key.wangSetRevision, key.paintPoint,
+                      key.wangIndex, key.color, key.brushMode, key.tileMode,
+                      key.rotationalSymmetry);
+}
+#endif
+
 void WangBrushItem::setInvalidTiles(const QRegion &region)
 {
     if (mInvalidTiles == region)
@@ -361,6 +384,24 @@ void WangBrush::mapDocumentChanged(MapDocument *oldDocument, MapDocument *newDoc
     brushItem()->clear();
 
     AbstractTileTool::mapDocumentChanged(oldDocument, newDocument);
+
+    if (oldDocument) {
+        disconnect(oldDocument, &Document::changed, this, &WangBrush::invalidatePreviewCache);
+        disconnect(oldDocument, &MapDocument::regionChanged, this, &WangBrush::invalidatePreviewCache);
+        disconnect(oldDocument, &MapDocument::currentLayerChanged, this, &WangBrush::invalidatePreviewCache);
+        disconnect(oldDocument, &MapDocument::tileLayerChanged, this, &WangBrush::invalidatePreviewCache);
+        disconnect(oldDocument, &MapDocument::mapResized, this, &WangBrush::invalidatePreviewCache);
+    }
+
+    invalidatePreviewCache();
+
+    if (newDocument) {
+        connect(newDocument, &Document::changed, this, &WangBrush::invalidatePreviewCache);
+        connect(newDocument, &MapDocument::regionChanged, this, &WangBrush::invalidatePreviewCache);
+        connect(newDocument, &MapDocument::currentLayerChanged, this, &WangBrush::invalidatePreviewCache);
+        connect(newDocument, &MapDocument::tileLayerChanged, this, &WangBrush::invalidatePreviewCache);
+        connect(newDocument, &MapDocument::mapResized, this, &WangBrush::invalidatePreviewCache);
+    }
 }
 
 void WangBrush::updateStatusInfo()
@@ -523,14 +564,38 @@ static constexpr QPoint aroundTilePoints[WangId::NumIndexes] = {
 
 void WangBrush::updateBrush()
 {
-    brushItem()->clear();
-
-    if (!mWangSet)
+    if (!mWangSet) {
+        brushItem()->clear();
         return;
+    }
 
     const TileLayer *currentLayer = currentTileLayer();
     Q_ASSERT(currentLayer);
 
+    // While hovering, the constraints only depend on the position under the
+    // cursor, so previews solved before can be shown again as long as the
+    // map didn't change. This also keeps the rendered brush cached.
+    const bool cacheable = mBrushBehavior == Free;
+    const WangBrushPreviewKey key {
+        mWangSet,
+        mWangSet->revision(),
+        mPaintPoint,
+        mWangIndex,
+        mCurrentColor,
+        mBrushMode,
+        mIsTileMode,
+        mRotationalSymmetry
+    };
+
+    if (cacheable) {
+        if (const Preview *preview = mPreviewCache.object(key)) {
+            showPreview(*preview);
+            return;
+        }
+    }
+
+    brushItem()->clear();
+
     WangFiller wangFiller { *mWangSet, *currentLayer, mapDocument()->renderer() };
 
     QVector<QPoint> points;
@@ -605,8 +670,6 @@ void WangBrush::updateBrush()
     wangFiller.setCorrectionsEnabled(true);
     wangFiller.apply(*stamp);
 
-    static_cast<WangBrushItem*>(brushItem())->setInvalidTiles(wangFiller.invalidRegion());
-
     // Translate to map coordinate space and normalize stamp
     QRegion brushRegion = stamp->region([] (const Cell &cell) { return cell.checked(); });
     brushRegion.translate(currentLayer->position());
@@ -614,11 +677,27 @@ void WangBrush::updateBrush()
     stamp->setPosition(brushRect.topLeft());
     stamp->resize(brushRect.size(), -brushRect.topLeft());
 
+    const Preview preview { stamp, brushRegion, wangFiller.invalidRegion() };
+    showPreview(preview);
+
+    if (cacheable)
+        mPreviewCache.insert(key, new Preview(preview));
+}
+
+void WangBrush::showPreview(const Preview &preview)
+{
+    static_cast<WangBrushItem*>(brushItem())->setInvalidTiles(preview.invalidTiles);
+
     // set the new tile layer as the brush
-    brushItem()->setTileLayer(stamp, brushRegion);
+    brushItem()->setTileLayer(preview.stamp, preview.region);
     updateStatusInfo();
 }
 
+void WangBrush::invalidatePreviewCache()
+{
+    mPreviewCache.clear();
+}
+
 void WangBrush::updateBrushAt(WangFiller &filler, QPoint pos)
 {
     auto hexagonalRenderer = dynamic_cast<HexagonalRenderer*>(mapDocument()->renderer());
@@ -26,6 +26,7 @@
 #include "wangfiller.h"
 #include "wangset.h"
 
+#include <QCache>
 #include <QToolBar>
 
 namespace Tiled {
@@ -49,6 +50,34 @@ private:
     QRegion mInvalidTiles;
 };
 
+/**
+ * Identifies a hover preview of the WangBrush by everything that affects the
+ * constraints it was solved for.
+ */
+struct WangBrushPreviewKey
+{
+    const WangSet *wangSet;
+    quint64 wangSetRevision;
+    QPoint paintPoint;
+    int wangIndex;
+    int color;
+    int brushMode;
+    bool tileMode;
+    bool rotationalSymmetry;
+
+    bool operator==(const WangBrushPreviewKey &other) const
+    {
+        return wangSet == other.wangSet &&
+                wangSetRevision == other.wangSetRevision &&
+                paintPoint == other.paintPoint &&
+                wangIndex == other.wangIndex &&
+                color == other.color &&
+                brushMode == other.brushMode &&
+                tileMode == other.tileMode &&
+                rotationalSymmetry == other.rotationalSymmetry;
+    }
+};
+
 class WangBrush final : public AbstractTileTool
 {
     Q_OBJECT
@@ -106,6 +135,15 @@ private:
     void doPaint(bool mergeable);
     void updateBrush();
     void updateBrushAt(WangFiller &filler, QPoint pos);
+    void invalidatePreviewCache();
+
+    struct Preview {
+        SharedTileLayer stamp;
+        QRegion region;
+        QRegion invalidTiles;
+    };
+
+    void showPreview(const Preview &preview);
 
     // The point painting happens around
     // In tile mode, this is that tile
@@ -126,6 +164,9 @@ private:
     bool mLineStartSet = false;
     BrushBehavior mBrushBehavior = Free;
     QAction *mToggleFillFullTiles;
+
+    // Previously solved hover previews, cleared when the map changes
+    QCache<WangBrushPreviewKey, Preview> mPreviewCache { 64 };
 };
 
 } // namespace Tiled
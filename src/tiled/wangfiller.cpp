@@ -27,10 +27,18 @@
 #include "map.h"
 #include "randompicker.h"
 #include "tilelayer.h"
+#include "tracing.h"
 #include "wangset.h"
 
+#include <QRandomGenerator>
+#include <QThreadPool>
+#include <QtConcurrent>
+
 using namespace Tiled;
 
+// Rects of at least this many cells are resolved on multiple threads
+static constexpr int MinParallelArea = 128 * 128;
+
 static constexpr QPoint aroundTilePoints[WangId::NumIndexes] = {
     QPoint( 0, -1),
     QPoint( 1, -1),
@@ -187,6 +195,8 @@ static void updateAdjacent(WangFiller::CellInfo &adjacentInfo, WangId wangId, in
  */
 void WangFiller::apply(TileLayer &target)
 {
+    TILED_TRACE_SCOPE("WangFiller::apply");
+
     mInvalidRegion = QRegion();
 
     auto &grid = mFillRegion.grid;
@@ -242,34 +252,30 @@ void WangFiller::apply(TileLayer &target)
     if (!mMapRenderer->map()->infinite())
         bounds &= mBack.rect();
 
-    // Keep a list of points that need correction
-    QVector<QPoint> corrections;
-
-    auto resolve = [&] (int x, int y) {
-        const QPoint targetPos(x - target.x(),
-                               y - target.y());
+    // Make sure the Wang set is up to date, since it can't be updated while
+    // resolving cells in parallel
+    mWangSet.isComplete();
 
-        if (target.cellAt(targetPos).checked())
-            return;
+    const quint32 randomSeed = mRandomSeed ? *mRandomSeed
+                                           : QRandomGenerator::global()->generate();
 
-        Cell cell;
-        if (!findBestMatch(target, grid, QPoint(x, y), cell)) {
-            mInvalidRegion += QRect(x, y, 1, 1);
-            return;
-        }
+    // Chooses a cell for the given position and adjusts the desired WangIds
+    // for the surrounding tiles based on the placed one. Returns false when
+    // no matching cell could be found.
+    auto place = [&] (QPoint pos, const IsChecked &isChecked, Cell &cell, QVector<QPoint> &corrections) {
+        if (!findBestMatch(isChecked, grid, pos, randomSeed, cell))
+            return false;
 
         cell.setChecked(true);
-        target.setCell(targetPos.x(), targetPos.y(), cell);
 
         const WangId cellWangId = mWangSet.wangIdOfCell(cell);
 
-        // Adjust the desired WangIds for the surrounding tiles based on the placed one
         QPoint adjacentPoints[WangId::NumIndexes];
-        getSurroundingPoints(QPoint(x, y), mHexagonalRenderer, adjacentPoints);
+        getSurroundingPoints(pos, mHexagonalRenderer, adjacentPoints);
 
         for (int i = 0; i < WangId::NumIndexes; ++i) {
             const QPoint p = adjacentPoints[i];
-            if (target.cellAt(p - target.position()).checked())
+            if (isChecked(p))
                 continue;
 
             CellInfo &adjacentInfo = grid.add(p);
@@ -289,10 +295,116 @@ void WangFiller::apply(TileLayer &target)
                 }
             }
         }
+
+        return true;
     };
 
+    const IsChecked isCheckedInTarget = [&] (QPoint pos) {
+        return target.cellAt(pos - target.position()).checked();
+    };
+
+    // Keep a list of points that need correction
+    QVector<QPoint> corrections;
+
+    auto resolve = [&] (int x, int y) {
+        const QPoint targetPos(x - target.x(),
+                               y - target.y());
+
+        if (target.cellAt(targetPos).checked())
+            return;
+
+        Cell cell;
+        if (!place(QPoint(x, y), isCheckedInTarget, cell, corrections)) {
+            mInvalidRegion += QRect(x, y, 1, 1);
+            return;
+        }
+
+        target.setCell(targetPos.x(), targetPos.y(), cell);
+    };
+
+    // Resolves the cells of a large rect on multiple threads. The cells are
+    // resolved in waves along lines where x + 3y is constant. A cell only
+    // depends on the cells within a distance of 2, and all those that come
+    // before it in scanline order are part of earlier waves. The cells within
+    // the same wave are at least 3 apart, so they don't affect each other.
+    // This gives the same result as resolving the cells row by row.
+    auto resolveInParallel = [&] (const QRect &rect) {
+        const QRect area = rect.adjusted(-1, -1, 1, 1);
+        const int width = rect.width();
+        const int height = rect.height();
+
+        // Track the checked cells separately, since the target layer can't
+        // be changed from multiple threads. This also allocates the grid
+        // around the rect upfront.
+        std::vector<char> checked(static_cast<size_t>(area.width()) * area.height());
+        auto checkedIndex = [&] (QPoint pos) {
+            return static_cast<size_t>(pos.y() - area.top()) * area.width() + (pos.x() - area.left());
+        };
+
+        for (int y = area.top(); y <= area.bottom(); ++y) {
+            for (int x = area.left(); x <= area.right(); ++x) {
+                grid.add(x, y);
+                checked[checkedIndex(QPoint(x, y))] = isCheckedInTarget(QPoint(x, y));
+            }
+        }
+
+        const IsChecked isChecked = [&] (QPoint pos) {
+            return checked[checkedIndex(pos)] != 0;
+        };
+
+        std::vector<Cell> cells(static_cast<size_t>(width) * height);
+        std::vector<char> invalid(cells.size());
+        QVector<QVector<QPoint>> rowCorrections(height);   // cells in the same row are never resolved concurrently
+
+        QVector<int> rows;
+        const int waveCount = width + 3 * (height - 1);
+
+        for (int wave = 0; wave < waveCount; ++wave) {
+            rows.clear();
+            for (int dy = qMax(0, (wave - width + 3) / 3); dy < height && 3 * dy <= wave; ++dy)
+                rows.append(dy);
+
+            QtConcurrent::blockingMap(rows, [&] (int dy) {
+                const int dx = wave - 3 * dy;
+                const QPoint pos(rect.left() + dx, rect.top() + dy);
+                const size_t index = static_cast<size_t>(dy) * width + dx;
+
+                if (isChecked(pos))
+                    return;
+
+                if (place(pos, isChecked, cells[index], rowCorrections[dy]))
+                    checked[checkedIndex(pos)] = true;
+                else
+                    invalid[index] = true;
+            });
+        }
+
+        for (int dy = 0; dy < height; ++dy) {
+            for (int dx = 0; dx < width; ++dx) {
+                const size_t index = static_cast<size_t>(dy) * width + dx;
+                const QPoint pos(rect.left() + dx, rect.top() + dy);
+
+                if (invalid[index])
+                    mInvalidRegion += QRect(pos, QSize(1, 1));
+                else if (cells[index].checked())
+                    target.setCell(pos.x() - target.x(), pos.y() - target.y(), cells[index]);
+            }
+
+            corrections.append(rowCorrections.at(dy));
+        }
+    };
+
+    // Hexagonal maps have different neighborhoods depending on the row, and
+    // the waves are not worth it for small rects
+    const bool parallel = !mHexagonalRenderer && QThreadPool::globalInstance()->maxThreadCount() > 1;
+
     // First process the initial region
     for (const QRect &rect : region) {
+        if (parallel && rect.width() * rect.height() >= MinParallelArea) {
+            resolveInParallel(rect);
+            continue;
+        }
+
         for (int y = rect.top(); y <= rect.bottom(); ++y)
             for (int x = rect.left(); x <= rect.right(); ++x)
                 resolve(x, y);
@@ -372,9 +484,24 @@ WangId WangFiller::wangIdFromSurroundings(QPoint point) const
     return wangIdFromSurrounding(wangIds);
 }
 
-bool WangFiller::findBestMatch(const TileLayer &target,
+/**
+ * Returns a random number in the range [0, 1) for the given \a state,
+ * advancing it. Used to make the random choices depend only on the position
+ * and the seed, regardless of the order in which the cells are resolved.
+ */
+static qreal nextRandom(quint64 &state)
+{
+    quint64 z = (state += Q_UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * Q_UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * Q_UINT64_C(0x94D049BB133111EB);
+    z ^= z >> 31;
+    return (z >> 11) * (1.0 / (Q_UINT64_C(1) << 53));
+}
+
+bool WangFiller::findBestMatch(const IsChecked &isChecked,
                                const Grid<CellInfo> &grid,
                                QPoint position,
+                               quint32 randomSeed,
                                Cell &result) const
 {
     const CellInfo info = grid.get(position);
@@ -430,16 +557,20 @@ bool WangFiller::findBestMatch(const TileLayer &target,
         }
     };
 
-    const auto &wangIdsAndCells = mWangSet.wangIdsAndCells();
-    for (const auto &wangIdAndCell : wangIdsAndCells)
+    mWangSet.forEachMatchingWangIdAndCell(maskedWangId, info.mask, [&] (const WangSet::WangIdAndCell &wangIdAndCell) {
         processCandidate(wangIdAndCell.wangId, wangIdAndCell.cell);
+    });
 
     if (mErasingEnabled)
         processCandidate(WangId(), Cell());
 
+    quint64 randomState = (quint64(randomSeed) << 32) ^
+            (quint64(quint32(position.x())) * 73856093u) ^
+            (quint64(quint32(position.y())) * 19349663u);
+
     // Choose a candidate at random, with consideration for probability
     while (!matches.isEmpty()) {
-        result = matches.take();
+        result = matches.take(nextRandom(randomState));
 
         // Check if we will be able to place any Wang tile next to this
         // candidate. This can be a relatively expensive check, that we'll only
@@ -456,7 +587,7 @@ bool WangFiller::findBestMatch(const TileLayer &target,
 
             for (int i = 0; i < WangId::NumIndexes; ++i) {
                 const QPoint p = adjacentPoints[i];
-                if (target.cellAt(p - target.position()).checked())
+                if (isChecked(p))
                     continue;
 
                 CellInfo adjacentInfo = grid.get(p);
@@ -29,7 +29,9 @@
 #include <QMap>
 #include <QPoint>
 
+#include <functional>
 #include <memory>
+#include <optional>
 
 namespace Tiled {
 
@@ -78,6 +80,13 @@ public:
 
     void setDebugPainter(QPainter *painter) { mDebugPainter = painter; }
 
+    /**
+     * Sets the seed used for random choices. When set, applying the same
+     * changes gives the same result. Otherwise a new seed is chosen each time.
+     */
+    void setRandomSeed(std::optional<quint32> seed) { mRandomSeed = seed; }
+    std::optional<quint32> randomSeed() const { return mRandomSeed; }
+
     void setRegion(const QRegion &region);
     CellInfo &changePosition(QPoint pos);
     void setWangIndex(QPoint pos, WangId::Index index, int color);
@@ -100,9 +109,12 @@ private:
     WangId wangIdFromSurroundings(QPoint point) const;
     WangId wangIdFromSurroundingCells(const Cell surroundingCells[]) const;
 
-    bool findBestMatch(const TileLayer &target,
+    using IsChecked = std::function<bool (QPoint)>;
+
+    bool findBestMatch(const IsChecked &isChecked,
                        const Grid<CellInfo> &grid,
                        QPoint position,
+                       quint32 randomSeed,
                        Cell &result) const;
 
     const WangSet &mWangSet;
@@ -113,6 +125,7 @@ private:
     bool mErasingEnabled = true;
     FillRegion mFillRegion;
     QRegion mInvalidRegion;
+    std::optional<quint32> mRandomSeed;
 
     QPainter *mDebugPainter = nullptr;
 };
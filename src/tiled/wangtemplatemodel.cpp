@@ -28,6 +28,7 @@ WangTemplateModel::WangTemplateModel(WangSet *wangSet, QObject *parent)
     : QAbstractListModel(parent)
     , mWangSet(wangSet)
 {
+    rememberWangSetState();
 }
 
 int WangTemplateModel::rowCount(const QModelIndex &parent) const
@@ -116,13 +117,41 @@ void WangTemplateModel::setWangSet(WangSet *wangSet)
 {
     beginResetModel();
     mWangSet = wangSet;
+    rememberWangSetState();
     endResetModel();
 }
 
 void WangTemplateModel::wangSetChanged()
 {
+    if (!mWangSet)
+        return;
+
+    if (mWangSet->revision() == mRevision)
+        return;
+
+    // The templates only depend on the type and the number of colors. When
+    // those didn't change, only the shading of the used WangIds needs to be
+    // updated.
+    if (mWangSet->type() == mType && mWangSet->colorCount() == mColorCount) {
+        mRevision = mWangSet->revision();
+        if (const int rows = rowCount())
+            emit dataChanged(index(0), index(rows - 1));
+        return;
+    }
+
     beginResetModel();
+    rememberWangSetState();
     endResetModel();
 }
 
+void WangTemplateModel::rememberWangSetState()
+{
+    if (!mWangSet)
+        return;
+
+    mRevision = mWangSet->revision();
+    mType = mWangSet->type();
+    mColorCount = mWangSet->colorCount();
+}
+
 #include "moc_wangtemplatemodel.cpp"
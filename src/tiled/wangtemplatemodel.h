@@ -53,7 +53,15 @@ public slots:
     void wangSetChanged();
 
 private:
+    void rememberWangSetState();
+
     WangSet *mWangSet;
+
+    // State of the Wang set at the last reset, to avoid resetting the model
+    // when only the tiles changed
+    quint64 mRevision = 0;
+    WangSet::Type mType = WangSet::Corner;
+    int mColorCount = 0;
 };
 
 } // namespace Tiled
@@ -28,6 +28,7 @@
 #include "maprenderer.h"
 #include "mapscene.h"
 #include "mapview.h"
+#include "minimaprenderer.h"
 #include "preferences.h"
 #include "toolmanager.h"
 #include "utils.h"
@@ -36,6 +37,7 @@
 #include "zoomable.h"
 
 #include <QApplication>
+#include <QGraphicsPixmapItem>
 #include <QKeyEvent>
 #include <QMenu>
 #include <QToolBar>
@@ -61,6 +63,12 @@ WorldMoveMapTool::~WorldMoveMapTool()
 {
 }
 
+void WorldMoveMapTool::deactivate(MapScene *scene)
+{
+    abortMoving();
+    AbstractWorldTool::deactivate(scene);
+}
+
 void WorldMoveMapTool::keyPressed(QKeyEvent *event)
 {
     QPointF moveBy;
@@ -167,8 +175,13 @@ void WorldMoveMapTool::mouseMoved(const QPointF &pos,
 
     mDragOffset = newPos - currentMapRect.topLeft();
 
+    if (!mDragProxy && !mDragOffset.isNull())
+        createDragProxy();
+
     // update preview
     mDraggingMapItem->setPos(mDraggedMapStartPos + mDragOffset);
+    if (mDragProxy)
+        mDragProxy->setPos(mDraggingMapItem->pos());
     updateSelectionRectangle();
 
     setStatusInfo(tr("Move map to %1, %2 (offset: %3, %4)")
@@ -189,6 +202,8 @@ void WorldMoveMapTool::mouseReleased(QGraphicsSceneMouseEvent *event)
         const QRectF viewRect { view->viewport()->rect() };
         const QRectF sceneViewRect = view->viewportTransform().inverted().mapRect(viewRect);
 
+        removeDragProxy();
+
         auto draggedMap = std::exchange(mDraggingMap, nullptr);
         mDraggingMapItem = nullptr;
 
@@ -247,6 +262,8 @@ void WorldMoveMapTool::abortMoving()
     if (!mDraggingMap)
         return;
 
+    removeDragProxy();
+
     mDraggingMapItem->setPos(mDraggedMapStartPos);
     mDraggingMapItem = nullptr;
     mDraggingMap = nullptr;
@@ -256,6 +273,66 @@ void WorldMoveMapTool::abortMoving()
     setStatusInfo(QString());
 }
 
+/**
+ * Renders the dragged map into a pixmap at the current zoom level, which is
+ * shown in place of its MapItem while dragging. This way moving the map only
+ * requires drawing a pixmap, rather than re-rendering all its layers.
+ */
+void WorldMoveMapTool::createDragProxy()
+{
+    // Limits the memory used by the proxy for large maps
+    constexpr int MaxProxySize = 4096;
+
+    qreal scale = 1.0;
+    if (MapView *view = DocumentManager::instance()->viewForDocument(mapDocument()))
+        scale = view->zoomable()->scale() * view->devicePixelRatioF();
+
+    const MiniMapRenderer::RenderFlags renderFlags(MiniMapRenderer::DrawTileLayers |
+                                                   MiniMapRenderer::DrawMapObjects |
+                                                   MiniMapRenderer::DrawImageLayers |
+                                                   MiniMapRenderer::IgnoreInvisibleLayer |
+                                                   MiniMapRenderer::IncludeOverhangingTiles |
+                                                   MiniMapRenderer::SmoothPixmapTransform);
+
+    const MiniMapRenderer miniMapRenderer(mDraggingMap->map());
+    const QRect bounds = miniMapRenderer.mapBoundingRect(renderFlags);
+
+    QSize size = (QSizeF(bounds.size()) * scale).toSize();
+    if (size.width() > MaxProxySize || size.height() > MaxProxySize)
+        size.scale(MaxProxySize, MaxProxySize, Qt::KeepAspectRatio);
+    if (size.isEmpty())
+        return;
+
+    QImage image = miniMapRenderer.render(size, renderFlags);
+
+    mDragProxy = std::make_unique<QGraphicsPixmapItem>(QPixmap::fromImage(std::move(image)));
+    mDragProxy->setTransformationMode(Qt::SmoothTransformation);
+
+    QTransform transform;
+    transform.translate(bounds.x(), bounds.y());
+    transform.scale(qreal(bounds.width()) / size.width(),
+                    qreal(bounds.height()) / size.height());
+    mDragProxy->setTransform(transform);
+    mDragProxy->setOpacity(mDraggingMapItem->effectiveOpacity());
+    mDragProxy->setZValue(mDraggingMapItem->zValue());
+    mDragProxy->setPos(mDraggingMapItem->pos());
+
+    mapScene()->addItem(mDragProxy.get());
+    mDraggingMapItem->setVisible(false);
+}
+
+void WorldMoveMapTool::removeDragProxy()
+{
+    if (!mDragProxy)
+        return;
+
+    if (auto scene = mDragProxy->scene())
+        scene->removeItem(mDragProxy.get());
+    mDragProxy.reset();
+
+    mDraggingMapItem->setVisible(true);
+}
+
 } // namespace Tiled
 
 #include "moc_worldmovemaptool.cpp"
@@ -22,6 +22,10 @@
 
 #include "abstractworldtool.h"
 
+#include <memory>
+
+class QGraphicsPixmapItem;
+
 namespace Tiled {
 
 class MapItem;
@@ -34,6 +38,8 @@ public:
     explicit WorldMoveMapTool(QObject *parent = nullptr);
     ~WorldMoveMapTool() override;
 
+    void deactivate(MapScene *scene) override;
+
     void keyPressed(QKeyEvent *event) override;
     void mouseEntered() override;
     void mouseMoved(const QPointF &pos,
@@ -49,12 +55,18 @@ protected:
 
     void moveMap(MapDocument *document, QPoint moveBy);
 
+    void createDragProxy();
+    void removeDragProxy();
+
     // drag state
     MapDocument *mDraggingMap = nullptr;
     MapItem *mDraggingMapItem = nullptr;
     QPointF mDragStartScenePos;
     QPointF mDraggedMapStartPos;
     QPoint mDragOffset;
+
+    // Pre-rendered image of the dragged map, shown instead of its MapItem
+    std::unique_ptr<QGraphicsPixmapItem> mDragProxy;
 };
 
 } // namespace Tiled
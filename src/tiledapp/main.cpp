@@ -20,11 +20,17 @@
  * this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "automappingmanager.h"
 #include "commandlineparser.h"
+#include "diskimagecache.h"
 #include "exporthelper.h"
+#include "exportmanifest.h"
 #include "logginginterface.h"
 #include "mainwindow.h"
+#include "mapcache.h"
+#include "mapdocument.h"
 #include "mapformat.h"
+#include "mapthumbnailcache.h"
 #include "pluginmanager.h"
 #include "preferences.h"
 #include "scriptmanager.h"
@@ -32,15 +38,26 @@
 #include "stylehelper.h"
 #include "tiledapplication.h"
 #include "tileset.h"
+#include "tilesetexportcache.h"
 #include "tmxmapformat.h"
+#include "tracing.h"
 
 #include <QDebug>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileInfo>
 #include <QImageReader>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QProcess>
+#include <QScopeGuard>
+#include <QSet>
+#include <QTemporaryFile>
+#include <QUndoStack>
 #include <QtPlugin>
 
+#include <algorithm>
 #include <memory>
 
 #ifdef Q_OS_WIN
@@ -84,7 +101,14 @@ public:
     bool exportMap = false;
     bool exportTileset = false;
     bool newInstance = false;
+    bool autoMap = false;
+    QString autoMapRulesFile;
+    int jobs = 1;
     Preferences::ExportOptions exportOptions;
+    QString exportVersion;
+    QString exportManifest;
+    QString traceFile;
+    QStringList listedFiles;
 
 private:
     void showVersion();
@@ -97,10 +121,15 @@ private:
     void setExportDetachTemplateInstances();
     void setExportResolveObjectTypesAndProperties();
     void setExportMinimized();
+    void setExportManifest();
     void showExportFormats();
     void setCompatibilityVersion();
     void evaluateScript();
     void startNewInstance();
+    void setAutoMap();
+    void setJobs();
+    void setFileList();
+    void setTraceFile();
 
     // Convenience wrapper around registerOption
     template <void (CommandLineHandler::*memberFunction)()>
@@ -181,6 +210,420 @@ inline T *findExportFormat(const QString *filter,
     return outputFormat;
 }
 
+static QString formatElapsed(qint64 nanoseconds)
+{
+    return QStringLiteral("%1 ms").arg(nanoseconds / 1000000.0, 0, 'f', 1);
+}
+
+/**
+ * Applies the AutoMapping rules to the given map and saves it. Prints how
+ * long each of the rule maps took.
+ */
+static bool autoMapFile(const QString &rulesFile, const QString &fileName)
+{
+    QString errorMsg;
+
+    MapFormat *format = findSupportingMapFormat(fileName);
+    MapDocumentPtr mapDocument = format ? MapDocument::load(fileName, format, &errorMsg)
+                                        : MapDocumentPtr();
+    if (!mapDocument) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to load map '%1'.").arg(fileName);
+        if (!errorMsg.isEmpty())
+            qWarning().noquote() << errorMsg;
+        return false;
+    }
+
+    AutomappingManager manager;
+    manager.setMapDocument(mapDocument.data(), rulesFile);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    manager.autoMap();
+
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    if (!manager.warningString().isEmpty())
+        qWarning().noquote() << manager.warningString();
+
+    if (!manager.errorString().isEmpty()) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to AutoMap '%1'.").arg(fileName);
+        qWarning().noquote() << manager.errorString();
+        return false;
+    }
+
+    if (!mapDocument->undoStack()->isClean() && !mapDocument->save(fileName, &errorMsg)) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to save map '%1'.").arg(fileName);
+        if (!errorMsg.isEmpty())
+            qWarning().noquote() << errorMsg;
+        return false;
+    }
+
+    stdOut() << fileName << ": " << formatElapsed(elapsed) << Qt::endl;
+    for (const auto &timing : manager.lastTimings())
+        stdOut() << "  " << timing.rulesMapFileName << ": " << formatElapsed(timing.elapsed) << Qt::endl;
+
+    return true;
+}
+
+struct Job
+{
+    QStringList arguments;
+    QStringList files;
+};
+
+/**
+ * Runs this executable once for each of the given jobs, all in parallel.
+ * The files of each job are passed through a temporary file list, since the
+ * length of the command line is limited.
+ *
+ * Returns whether each of the processes started and exited successfully.
+ */
+static bool runJobs(const std::vector<Job> &jobs)
+{
+    std::vector<std::unique_ptr<QTemporaryFile>> fileLists;
+    std::vector<std::unique_ptr<QProcess>> processes;
+    bool success = true;
+
+    for (const Job &job : jobs) {
+        auto fileList = std::make_unique<QTemporaryFile>();
+        if (!fileList->open()) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to write file list: %1").arg(fileList->errorString());
+            success = false;
+            continue;
+        }
+
+        for (const QString &file : job.files)
+            fileList->write(file.toUtf8() + '\n');
+        fileList->close();
+
+        const QStringList arguments = QStringList { QStringLiteral("--file-list"), fileList->fileName() }
+                + job.arguments;
+
+        auto process = std::make_unique<QProcess>();
+        process->setProcessChannelMode(QProcess::ForwardedChannels);
+        process->start(QCoreApplication::applicationFilePath(), arguments);
+
+        if (!process->waitForStarted(-1)) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to start job: %1").arg(process->errorString());
+            success = false;
+            continue;
+        }
+
+        fileLists.push_back(std::move(fileList));
+        processes.push_back(std::move(process));
+    }
+
+    for (const auto &process : processes) {
+        const bool finished = process->waitForFinished(-1) ||
+                process->state() == QProcess::NotRunning;
+
+        if (!finished || process->error() != QProcess::UnknownError) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "Job failed: %1").arg(process->errorString());
+            success = false;
+            continue;
+        }
+
+        success &= process->exitStatus() == QProcess::NormalExit && process->exitCode() == 0;
+    }
+
+    return success;
+}
+
+/**
+ * Applies the AutoMapping rules to each of the given maps. When multiple
+ * \a jobs are requested, the maps are divided over that many processes.
+ */
+static int autoMapFiles(const QString &rulesFile, const QStringList &fileNames, int jobs)
+{
+    jobs = qBound(1, jobs, int(fileNames.size()));
+
+    if (jobs == 1) {
+        bool success = true;
+        for (const QString &fileName : fileNames)
+            success &= autoMapFile(rulesFile, fileName);
+        return success ? 0 : 1;
+    }
+
+    QStringList baseArguments;
+    if (!Preferences::startupProject().isEmpty())
+        baseArguments << QStringLiteral("--project") << Preferences::startupProject();
+    baseArguments << QStringLiteral("--automap") << rulesFile;
+
+    std::vector<Job> jobList(jobs, Job { baseArguments, {} });
+
+    for (int i = 0; i < fileNames.size(); ++i)
+        jobList[i % jobs].files.append(fileNames.at(i));
+
+    return runJobs(jobList) ? 0 : 1;
+}
+
+static bool isWildcardPattern(const QString &fileName)
+{
+    return fileName.contains(QLatin1Char('*')) ||
+            fileName.contains(QLatin1Char('?')) ||
+            fileName.contains(QLatin1Char('['));
+}
+
+/**
+ * Expands the given inputs to a list of map files. Each input can be a map
+ * file, a directory, which is searched recursively for files supported by
+ * any map format, or a wildcard pattern for the file name like "*.tmx".
+ */
+static QStringList expandMapInputs(const QStringList &inputs)
+{
+    QStringList fileNames;
+
+    for (const QString &input : inputs) {
+        const QFileInfo fileInfo(input);
+
+        if (fileInfo.isDir()) {
+            QStringList found;
+            QDirIterator it(input, QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                const QString fileName = it.next();
+                if (findSupportingMapFormat(fileName))
+                    found.append(fileName);
+            }
+            found.sort();
+            fileNames.append(found);
+        } else if (isWildcardPattern(fileInfo.fileName())) {
+            const QDir dir = fileInfo.dir();
+            const auto entries = dir.entryList({ fileInfo.fileName() }, QDir::Files, QDir::Name);
+            for (const QString &entry : entries)
+                fileNames.append(dir.filePath(entry));
+        } else {
+            fileNames.append(input);
+        }
+    }
+
+    return fileNames;
+}
+
+/**
+ * Returns the target file for the given source file. In the \a pattern,
+ * "{name}" is replaced by the name of the source file without its suffix,
+ * and "{dir}" by its directory relative to the current directory.
+ */
+static QString exportTargetFile(const QString &pattern, const QString &sourceFile)
+{
+    const QFileInfo fileInfo(sourceFile);
+
+    QString targetFile = pattern;
+    targetFile.replace(QLatin1String("{name}"), fileInfo.completeBaseName());
+    targetFile.replace(QLatin1String("{dir}"), QDir::current().relativeFilePath(fileInfo.absolutePath()));
+    return QDir::cleanPath(targetFile);
+}
+
+/**
+ * Exports a single map. The tilesets used by the map are added to
+ * \a tilesets, which keeps them loaded so that any following maps using
+ * the same tilesets can share them.
+ *
+ * When a \a manifest is given, the export is skipped if the manifest says
+ * the target is up to date, and the manifest is updated otherwise.
+ */
+static bool exportMapFile(const QString *filter,
+                          const QString &sourceFile,
+                          const QString &targetFile,
+                          Preferences::ExportOptions exportOptions,
+                          QSet<SharedTileset> &tilesets,
+                          ExportManifest *manifest)
+{
+    QString errorMsg;
+    MapFormat *outputFormat = findExportFormat<MapFormat>(filter, targetFile, errorMsg);
+    if (!outputFormat) {
+        Q_ASSERT(!errorMsg.isEmpty());
+        qWarning().noquote() << errorMsg;
+        return false;
+    }
+
+    const QString settings = ExportManifest::settings(outputFormat, exportOptions);
+    if (manifest && manifest->isUpToDate(targetFile, sourceFile, settings))
+        return true;
+
+    // Load the source file
+    const std::unique_ptr<Map> sourceMap(readMap(sourceFile, &errorMsg));
+    if (!sourceMap) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to load source map '%1'.").arg(sourceFile);
+        if (!errorMsg.isEmpty())
+            qWarning().noquote() << errorMsg;
+        return false;
+    }
+
+    for (const SharedTileset &tileset : sourceMap->tilesets())
+        if (!tileset->fileName().isEmpty())
+            tilesets.insert(tileset);
+
+    // Apply export options
+    std::unique_ptr<Map> exportMap;
+    ExportHelper exportHelper(exportOptions);
+    const Map *map = exportHelper.prepareExportMap(sourceMap.get(), exportMap);
+
+    // Write out the file
+    QDir().mkpath(QFileInfo(targetFile).absolutePath());
+    bool success = outputFormat->write(map, targetFile, exportHelper.formatOptions());
+
+    if (!success) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to export map to target file '%1'.").arg(targetFile);
+        errorMsg = outputFormat->errorString();
+        if (!errorMsg.isEmpty())
+            qWarning().noquote() << errorMsg;
+        if (manifest)
+            manifest->remove(targetFile);
+        return false;
+    }
+
+    if (manifest)
+        manifest->update(targetFile, sourceFile, settings, ExportManifest::dependencies(sourceMap.get()));
+
+    return true;
+}
+
+/**
+ * Saves the given \a manifest, reporting when that fails.
+ */
+static bool saveExportManifest(const ExportManifest &manifest)
+{
+    if (manifest.save())
+        return true;
+
+    qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to write export manifest '%1'.").arg(manifest.fileName());
+    return false;
+}
+
+/**
+ * Exports the maps found in the given \a inputs. When the \a target contains
+ * "{name}", it is used as a pattern for the target file of each map.
+ * Otherwise, only a single map can be exported.
+ *
+ * When multiple \a jobs are requested, the maps are divided over that many
+ * processes. Within each process, tilesets and templates are loaded only
+ * once.
+ *
+ * When an export manifest is used, maps whose inputs did not change since
+ * their last export are skipped. Each process records its exports in its own
+ * manifest, which are merged afterwards.
+ */
+static int exportMaps(const CommandLineHandler &commandLine,
+                      const QString *filter,
+                      const QStringList &inputs,
+                      const QString &target)
+{
+    const QStringList sourceFiles = expandMapInputs(inputs);
+    if (sourceFiles.isEmpty()) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "No maps found to export.");
+        return 1;
+    }
+
+    QSet<SharedTileset> tilesets;
+
+    // Embedded tilesets are prepared and serialized once for all maps
+    TilesetExportCache tilesetExportCache;
+
+    std::unique_ptr<ExportManifest> manifest;
+    if (!commandLine.exportManifest.isEmpty()) {
+        manifest = std::make_unique<ExportManifest>(commandLine.exportManifest);
+        manifest->load();
+    }
+
+    if (!target.contains(QLatin1String("{name}"))) {
+        if (sourceFiles.size() > 1) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "Exporting multiple maps requires a target pattern containing {name}, like out/{dir}/{name}.json");
+            return 1;
+        }
+        bool success = exportMapFile(filter, sourceFiles.first(), target, commandLine.exportOptions, tilesets, manifest.get());
+        if (manifest)
+            success &= saveExportManifest(*manifest);
+        return success ? 0 : 1;
+    }
+
+    // Leave out the maps that are up to date, before dividing them over jobs
+    QStringList outdatedFiles = sourceFiles;
+    if (manifest) {
+        outdatedFiles.erase(std::remove_if(outdatedFiles.begin(), outdatedFiles.end(),
+                                           [&] (const QString &sourceFile) {
+            const QString targetFile = exportTargetFile(target, sourceFile);
+            QString errorMsg;
+            const MapFormat *format = findExportFormat<MapFormat>(filter, targetFile, errorMsg);
+            return format && manifest->isUpToDate(targetFile, sourceFile,
+                                                  ExportManifest::settings(format, commandLine.exportOptions));
+        }), outdatedFiles.end());
+
+        stdOut() << QCoreApplication::translate("Command line", "%1 of %2 maps are up to date.")
+                    .arg(sourceFiles.size() - outdatedFiles.size())
+                    .arg(sourceFiles.size()) << Qt::endl;
+    }
+
+    if (outdatedFiles.isEmpty())
+        return saveExportManifest(*manifest) ? 0 : 1;
+
+    const int jobs = qBound(1, commandLine.jobs, int(outdatedFiles.size()));
+
+    if (jobs == 1) {
+        bool success = true;
+        for (const QString &sourceFile : std::as_const(outdatedFiles)) {
+            success &= exportMapFile(filter, sourceFile,
+                                     exportTargetFile(target, sourceFile),
+                                     commandLine.exportOptions, tilesets, manifest.get());
+        }
+        if (manifest)
+            success &= saveExportManifest(*manifest);
+        return success ? 0 : 1;
+    }
+
+    QStringList baseArguments;
+    if (!Preferences::startupProject().isEmpty())
+        baseArguments << QStringLiteral("--project") << Preferences::startupProject();
+    if (!commandLine.exportVersion.isEmpty())
+        baseArguments << QStringLiteral("--export-version") << commandLine.exportVersion;
+    if (commandLine.exportOptions.testFlag(Preferences::EmbedTilesets))
+        baseArguments << QStringLiteral("--embed-tilesets");
+    if (commandLine.exportOptions.testFlag(Preferences::DetachTemplateInstances))
+        baseArguments << QStringLiteral("--detach-templates");
+    if (commandLine.exportOptions.testFlag(Preferences::ResolveObjectTypesAndProperties))
+        baseArguments << QStringLiteral("--resolve-types-and-properties");
+    if (commandLine.exportOptions.testFlag(Preferences::ExportMinimized))
+        baseArguments << QStringLiteral("--minimize");
+    baseArguments << QStringLiteral("--export-map");
+    if (filter)
+        baseArguments << *filter;
+
+    baseArguments << target;
+
+    const auto jobManifestFileName = [&] (int job) {
+        return commandLine.exportManifest + QStringLiteral(".job%1").arg(job);
+    };
+
+    std::vector<Job> jobList;
+
+    for (int job = 0; job < jobs; ++job) {
+        QStringList arguments = baseArguments;
+        if (manifest) {
+            QFile::remove(jobManifestFileName(job));
+            arguments.insert(0, QStringLiteral("--manifest"));
+            arguments.insert(1, jobManifestFileName(job));
+        }
+        jobList.push_back(Job { arguments, {} });
+    }
+
+    for (int i = 0; i < outdatedFiles.size(); ++i)
+        jobList[i % jobs].files.append(outdatedFiles.at(i));
+
+    bool success = runJobs(jobList);
+
+    if (manifest) {
+        for (int job = 0; job < jobs; ++job) {
+            ExportManifest jobManifest(jobManifestFileName(job));
+            if (jobManifest.load())
+                manifest->merge(jobManifest);
+            QFile::remove(jobManifest.fileName());
+        }
+        success &= saveExportManifest(*manifest);
+    }
+
+    return success ? 0 : 1;
+}
 
 } // anonymous namespace
 
@@ -247,6 +690,11 @@ CommandLineHandler::CommandLineHandler()
                 QLatin1String("--minimize"),
                 tr("Minimize the exported file by omitting unnecessary whitespace"));
 
+    option<&CommandLineHandler::setExportManifest>(
+                QChar(),
+                QLatin1String("--manifest"),
+                tr("Skip exporting maps that did not change since the exports recorded in the given manifest file"));
+
     option<&CommandLineHandler::startNewInstance>(
                 QChar(),
                 QLatin1String("--new-instance"),
@@ -256,6 +704,26 @@ CommandLineHandler::CommandLineHandler()
                 QLatin1Char('e'),
                 QLatin1String("--evaluate"),
                 tr("Evaluate a script file and quit"));
+
+    option<&CommandLineHandler::setAutoMap>(
+                QChar(),
+                QLatin1String("--automap"),
+                tr("Apply the given AutoMapping rules file to the specified maps and save them"));
+
+    option<&CommandLineHandler::setJobs>(
+                QChar(),
+                QLatin1String("--jobs"),
+                tr("Number of processes to use with --automap and --export-map"));
+
+    option<&CommandLineHandler::setFileList>(
+                QChar(),
+                QLatin1String("--file-list"),
+                tr("Read the maps to use with --automap or --export-map from the given file, one per line"));
+
+    option<&CommandLineHandler::setTraceFile>(
+                QChar(),
+                QLatin1String("--trace"),
+                tr("Record a performance trace and write it to the given file on exit"));
 }
 
 void CommandLineHandler::showVersion()
@@ -324,6 +792,15 @@ void CommandLineHandler::setExportMinimized()
     exportOptions |= Preferences::ExportMinimized;
 }
 
+void CommandLineHandler::setExportManifest()
+{
+    exportManifest = nextArgument();
+    if (exportManifest.isNull()) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Missing argument, set the export manifest using: --manifest <file>");
+        justQuit();
+    }
+}
+
 void CommandLineHandler::showExportFormats()
 {
     initializePluginsAndExtensions();
@@ -371,6 +848,7 @@ void CommandLineHandler::setCompatibilityVersion()
     }
 
     FileFormat::setCompatibilityVersion(version);
+    exportVersion = versionString;
 }
 
 void CommandLineHandler::evaluateScript()
@@ -410,6 +888,85 @@ void CommandLineHandler::startNewInstance()
     newInstance = true;
 }
 
+void CommandLineHandler::setAutoMap()
+{
+    autoMapRulesFile = nextArgument();
+    if (autoMapRulesFile.isNull()) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Missing argument, AutoMap syntax is --automap <rules-file> <map>...");
+        justQuit();
+        return;
+    }
+
+    autoMap = true;
+}
+
+void CommandLineHandler::setJobs()
+{
+    bool ok;
+    jobs = nextArgument().toInt(&ok);
+    if (!ok || jobs < 1) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Invalid number of jobs, set it using: --jobs <count>");
+        justQuit();
+    }
+}
+
+void CommandLineHandler::setFileList()
+{
+    const QString fileName = nextArgument();
+    if (fileName.isNull()) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Missing argument, set the file list using: --file-list <file>");
+        justQuit();
+        return;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to read file list '%1'.").arg(fileName);
+        justQuit();
+        return;
+    }
+
+    while (!file.atEnd()) {
+        QString line = QString::fromUtf8(file.readLine());
+        if (line.endsWith(QLatin1Char('\n')))
+            line.chop(1);
+        if (!line.isEmpty())
+            listedFiles.append(line);
+    }
+}
+
+void CommandLineHandler::setTraceFile()
+{
+    traceFile = nextArgument();
+    if (traceFile.isNull()) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Missing argument, record a trace using: --trace <file>");
+        justQuit();
+        return;
+    }
+
+    Tracing::setEnabled(true);
+}
+
+/**
+ * Returns whether the command line requests an operation that runs without
+ * showing any windows, like exporting a map or evaluating a script.
+ */
+static bool isHeadlessCommand(int argc, char *argv[])
+{
+    static const char * const headlessOptions[] = {
+        "-h", "--help", "-v", "--version", "--quit",
+        "--export-map", "--export-tileset", "--export-formats",
+        "-e", "--evaluate", "--automap",
+    };
+
+    for (int i = 1; i < argc; ++i)
+        for (const char *option : headlessOptions)
+            if (qstrcmp(argv[i], option) == 0)
+                return true;
+
+    return false;
+}
+
 
 int main(int argc, char *argv[])
 {
@@ -453,6 +1010,14 @@ int main(int argc, char *argv[])
 
     Tiled::increaseImageAllocationLimit();
 
+    // Command-line operations don't need a display server. Using the
+    // offscreen platform also avoids the cost of connecting to one. The
+    // macOS app bundle only contains the Cocoa platform plugin.
+#if !defined(Q_OS_MAC)
+    if (isHeadlessCommand(argc, argv) && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+#endif
+
     TiledApplication a(argc, argv);
 
 #ifdef TILED_SENTRY
@@ -480,53 +1045,40 @@ int main(int argc, char *argv[])
     if (commandLine.disableOpenGL)
         Preferences::instance()->setUseOpenGL(false);
 
-    if (commandLine.exportMap) {
-        // Get the path to the source file and target file
-        if (commandLine.exportTileset || commandLine.filesToOpen().length() < 2) {
-            qWarning().noquote() << QCoreApplication::translate("Command line", "Export syntax is --export-map [format] <source> <target>");
-            return 1;
-        }
-
-        initializePluginsAndExtensions();
-
-        int index = 0;
-        const QString *filter = commandLine.filesToOpen().length() > 2 ? &commandLine.filesToOpen().at(index++) : nullptr;
-        const QString &sourceFile = commandLine.filesToOpen().at(index++);
-        const QString &targetFile = commandLine.filesToOpen().at(index++);
+    const auto writeTrace = qScopeGuard([&] {
+        if (commandLine.traceFile.isEmpty())
+            return;
 
-        QString errorMsg;
-        MapFormat *outputFormat = findExportFormat<MapFormat>(filter, targetFile, errorMsg);
-        if (!outputFormat) {
-            Q_ASSERT(!errorMsg.isEmpty());
-            qWarning().noquote() << errorMsg;
-            return 1;
+        QString error;
+        if (!Tracing::writeChromeTrace(commandLine.traceFile, &error)) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to write trace '%1'.").arg(commandLine.traceFile);
+            qWarning().noquote() << error;
         }
+    });
 
-        // Load the source file
-        const std::unique_ptr<Map> sourceMap(readMap(sourceFile, &errorMsg));
-        if (!sourceMap) {
-            qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to load source map.");
-            if (!errorMsg.isEmpty())
-                qWarning().noquote() << errorMsg;
+    if (commandLine.exportMap) {
+        // Get the paths to the source files and the target file or pattern.
+        // Sources may also come from a file list.
+        const QStringList &arguments = commandLine.filesToOpen();
+        const QStringList &listedFiles = commandLine.listedFiles;
+        if (commandLine.exportTileset || arguments.isEmpty() ||
+                arguments.length() + listedFiles.length() < 2) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "Export syntax is --export-map [format] <source>... <target>");
             return 1;
         }
 
-        // Apply export options
-        std::unique_ptr<Map> exportMap;
-        ExportHelper exportHelper(commandLine.exportOptions);
-        const Map *map = exportHelper.prepareExportMap(sourceMap.get(), exportMap);
+        initializePluginsAndExtensions();
 
-        // Write out the file
-        bool success = outputFormat->write(map, targetFile, exportHelper.formatOptions());
+        // The first argument is the format, unless it refers to a file
+        const QString &first = arguments.first();
+        const int minimumArguments = listedFiles.isEmpty() ? 2 : 1;
+        const bool hasFilter = arguments.length() > minimumArguments && !QFileInfo::exists(first) &&
+                !isWildcardPattern(QFileInfo(first).fileName());
 
-        if (!success) {
-            qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to export map to target file.");
-            errorMsg = outputFormat->errorString();
-            if (!errorMsg.isEmpty())
-                qWarning().noquote() << errorMsg;
-            return 1;
-        }
-        return 0;
+        const QString *filter = hasFilter ? &first : nullptr;
+        const QStringList inputs = listedFiles + arguments.mid(hasFilter ? 1 : 0, arguments.length() - (hasFilter ? 2 : 1));
+
+        return exportMaps(commandLine, filter, inputs, arguments.last());
     }
 
     if (commandLine.exportTileset) {
@@ -577,6 +1129,18 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    if (commandLine.autoMap) {
+        const QStringList fileNames = commandLine.listedFiles + commandLine.filesToOpen();
+        if (fileNames.isEmpty()) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "AutoMap syntax is --automap <rules-file> <map>...");
+            return 1;
+        }
+
+        initializePluginsAndExtensions();
+
+        return autoMapFiles(commandLine.autoMapRulesFile, fileNames, commandLine.jobs);
+    }
+
     QStringList filesToOpen;
 
     for (const QString &fileName : commandLine.filesToOpen()) {
@@ -611,6 +1175,15 @@ int main(int argc, char *argv[])
     Session::initialize();
     StyleHelper::initialize();
 
+    // Speeds up loading large tileset images during future sessions
+    DiskImageCache::setEnabled(true);
+
+    // Allows showing maps of large worlds without loading them
+    MapThumbnailCache::setEnabled(true);
+
+    // Speeds up opening large maps during future sessions
+    MapCache::setStoreSnapshots(true);
+
     MainWindow w;
     w.show();
 
@@ -211,6 +211,8 @@ ApplicationWindow {
                 text: {
                     if (mapLoader.status === Tiled.MapLoader.Null) {
                         qsTr("No map file loaded")
+                    } else if (mapLoader.status === Tiled.MapLoader.Loading) {
+                        qsTr("Loading...")
                     } else if (mapLoader.status === Tiled.MapLoader.Error) {
                         mapLoader.error
                     } else {
@@ -26,6 +26,7 @@
  * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "mapthumbnailcache.h"
 #include "pluginmanager.h"
 #include "tmxrasterizer.h"
 #include "tmxmapformat.h"
@@ -34,6 +35,7 @@
 #include <QDebug>
 #include <QGuiApplication>
 #include <QStringList>
+#include <QThread>
 #include <QUrl>
 
 static QString localFile(const QString &fileNameOrUrl)
@@ -100,25 +102,80 @@ int main(int argc, char *argv[])
                             QCoreApplication::translate("main", "If used, tile animations are advanced by the specified duration in milliseconds."),
                             QCoreApplication::translate("main", "duration") },
                           { QStringLiteral("frames"),
-                            QCoreApplication::translate("main", "Number of frames to export. This will add a frame number suffix to the image names. Animations are advanced by <frame-duration> for each frame."),
+                            QCoreApplication::translate("main", "Number of frames to export. This will add a frame number suffix to the image names, unless the image name ends with .apng, in which case an animated PNG is written. Animations are advanced by <frame-duration> for each frame."),
                             QCoreApplication::translate("main", "number") },
                           { QStringLiteral("frame-duration"),
                             QCoreApplication::translate("main", "Duration of each frame in milliseconds, defaults to 100."),
                             QCoreApplication::translate("main", "number") },
+                          { QStringLiteral("pyramid"),
+                            QCoreApplication::translate("main", "Writes a zoom pyramid of SIZE x SIZE tiles instead of a single image, as <image>/<z>/<x>/<y>.<suffix> based on the output file name. Tiles are rendered at the given --scale at the highest zoom level."),
+                            QCoreApplication::translate("main", "size") },
+                          { QStringLiteral("previous-map"),
+                            QCoreApplication::translate("main", "Updates the existing output image, which was rendered from the given previous version of the map, by repainting only the changed areas."),
+                            QCoreApplication::translate("main", "map") },
+                          { QStringLiteral("threads"),
+                            QCoreApplication::translate("main", "Number of threads used to render the map, defaults to 1. In batch mode, this is the number of maps rendered at the same time, which defaults to one for each processor core."),
+                            QCoreApplication::translate("main", "number") },
+                          { QStringLiteral("batch"),
+                            QCoreApplication::translate("main", "Renders all maps listed in the given manifest file within a single process, sharing loaded tilesets, images and templates. Each line holds a map or world and an image file name, separated by a tab. No positional arguments are used."),
+                            QCoreApplication::translate("main", "manifest") },
+                          { QStringLiteral("batch-glob"),
+                            QCoreApplication::translate("main", "Renders all maps matching the given wildcard pattern like --batch, to PNG images named after the maps. The only positional argument is the output directory."),
+                            QCoreApplication::translate("main", "pattern") },
+                          { QStringLiteral("report"),
+                            QCoreApplication::translate("main", "In batch mode, writes the time spent on each map to the given JSON file."),
+                            QCoreApplication::translate("main", "file") },
+                          { QStringLiteral("use-thumbnails"),
+                            QCoreApplication::translate("main", "When rendering a world at a small scale, draws maps from the thumbnails stored by Tiled when possible, instead of reading them. Layer and object filters do not apply to those maps.") },
                       });
     parser.addPositionalArgument(QStringLiteral("map|world"), QCoreApplication::translate("main", "Map or world file to render."));
     parser.addPositionalArgument(QStringLiteral("image"), QCoreApplication::translate("main", "Image file to output."));
     parser.process(app);
 
+    const bool batch = parser.isSet(QLatin1String("batch")) || parser.isSet(QLatin1String("batch-glob"));
     const QStringList args = parser.positionalArguments();
-    if (args.size() != 2)
-        parser.showHelp(1);
 
-    const QString &fileToOpen = localFile(args.at(0));
-    const QString &fileToSave = args.at(1);
+    QVector<TmxRasterizer::BatchEntry> batchEntries;
+    QString fileToOpen;
+    QString fileToSave;
+
+    if (parser.isSet(QLatin1String("batch"))) {
+        if (!args.isEmpty() || parser.isSet(QLatin1String("batch-glob")))
+            parser.showHelp(1);
+
+        const QString manifest = localFile(parser.value(QLatin1String("batch")));
+        QString error;
+        if (!TmxRasterizer::readBatchManifest(manifest, batchEntries, &error)) {
+            qWarning().noquote() << QCoreApplication::translate("main", "Error while reading \"%1\": %2").arg(manifest, error);
+            exit(1);
+        }
+    } else if (parser.isSet(QLatin1String("batch-glob"))) {
+        if (args.size() != 1)
+            parser.showHelp(1);
+
+        batchEntries = TmxRasterizer::batchEntriesMatching(localFile(parser.value(QLatin1String("batch-glob"))),
+                                                           localFile(args.at(0)));
+    } else {
+        if (args.size() != 2)
+            parser.showHelp(1);
 
-    if (fileToOpen.isEmpty() || fileToSave.isEmpty())
-        parser.showHelp(1);
+        fileToOpen = localFile(args.at(0));
+        fileToSave = args.at(1);
+
+        if (fileToOpen.isEmpty() || fileToSave.isEmpty())
+            parser.showHelp(1);
+    }
+
+    if (batch) {
+        // Options that advance the shared tile animations or render more
+        // than one image per map are not supported
+        for (const char *option : { "advance-animations", "frames", "pyramid", "previous-map" }) {
+            if (parser.isSet(QLatin1String(option))) {
+                qWarning().noquote() << QCoreApplication::translate("main", "The --%1 option is not supported in batch mode").arg(QLatin1String(option));
+                exit(1);
+            }
+        }
+    }
 
     TmxRasterizer w;
     w.setAntiAliasing(parser.isSet(QLatin1String("anti-aliasing")));
@@ -186,5 +243,40 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (parser.isSet(QLatin1String("pyramid"))) {
+        bool ok;
+        w.setPyramidTileSize(parser.value(QLatin1String("pyramid")).toInt(&ok));
+        if (!ok || w.pyramidTileSize() <= 0) {
+            qWarning().noquote() << QCoreApplication::translate("main", "Invalid pyramid tile size specified: \"%1\"").arg(parser.value(QLatin1String("pyramid")));
+            exit(1);
+        }
+    }
+
+    if (batch)
+        w.setThreadCount(QThread::idealThreadCount());
+
+    if (parser.isSet(QLatin1String("threads"))) {
+        bool ok;
+        w.setThreadCount(parser.value(QLatin1String("threads")).toInt(&ok));
+        if (!ok || w.threadCount() < 1) {
+            qWarning().noquote() << QCoreApplication::translate("main", "Invalid number of threads specified: \"%1\"").arg(parser.value(QLatin1String("threads")));
+            exit(1);
+        }
+    }
+
+    if (parser.isSet(QLatin1String("use-thumbnails"))) {
+        // Use the thumbnails in Tiled's cache location
+        app.setApplicationName(QLatin1String("Tiled"));
+        MapThumbnailCache::setDirectory(MapThumbnailCache::directory());
+        MapThumbnailCache::setEnabled(true);
+        app.setApplicationName(QLatin1String("TmxRasterizer"));
+    }
+
+    if (parser.isSet(QLatin1String("previous-map")))
+        w.setPreviousMapFileName(localFile(parser.value(QLatin1String("previous-map"))));
+
+    if (batch)
+        return w.renderBatch(batchEntries, localFile(parser.value(QLatin1String("report"))));
+
     return w.render(fileToOpen, fileToSave);
 }
@@ -29,19 +29,42 @@
 #include "tmxrasterizer.h"
 
 #include "grouplayer.h"
+#include "imagecache.h"
 #include "imagelayer.h"
 #include "map.h"
 #include "mapformat.h"
+#include "mapthumbnailcache.h"
 #include "objectgroup.h"
+#include "pngwriter.h"
+#include "taskscheduler.h"
 #include "tilelayer.h"
+#include "tileset.h"
 #include "tilesetmanager.h"
 #include "world.h"
 
+#include <QBuffer>
 #include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileInfo>
+#include <QHash>
 #include <QImageWriter>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QSet>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtMath>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <memory>
+#include <vector>
 
 using namespace Tiled;
 
@@ -49,7 +72,8 @@ TmxRasterizer::TmxRasterizer() = default;
 
 void TmxRasterizer::drawMapLayers(const MapRenderer &renderer,
                                   QPainter &painter,
-                                  QPoint mapOffset) const
+                                  QPoint mapOffset,
+                                  const QRectF &exposed) const
 {
     // Perform a similar rendering than found in minimaprenderer.cpp
     LayerIterator iterator(renderer.map());
@@ -63,19 +87,17 @@ void TmxRasterizer::drawMapLayers(const MapRenderer &renderer,
         painter.setOpacity(layer->effectiveOpacity());
         painter.translate(offset);
 
+        const QRectF layerExposed = exposed.isNull() ? exposed
+                                                     : exposed.translated(-offset);
+
         switch (layer->layerType()) {
         case Layer::TileLayerType:
             painter.setCompositionMode(compositionMode);
-            renderer.drawTileLayer(&painter, static_cast<const TileLayer*>(layer));
+            renderer.drawTileLayer(&painter, static_cast<const TileLayer*>(layer), layerExposed);
             break;
         case Layer::ObjectGroupType: {
             const auto objectGroup = static_cast<const ObjectGroup*>(layer);
-            QList<MapObject*> objects = objectGroup->objects();
-
-            if (objectGroup->drawOrder() == ObjectGroup::TopDownOrder)
-                std::stable_sort(objects.begin(), objects.end(), [](MapObject *a, MapObject *b){return a->y() < b->y();});
-
-            for (const MapObject *object : std::as_const(objects)) {
+            for (const MapObject *object : objectGroup->objectsInDrawOrder()) {
                 if (shouldDrawObject(object)) {
                     if (object->isTileObject())
                         painter.setCompositionMode(compositionMode);
@@ -100,7 +122,7 @@ void TmxRasterizer::drawMapLayers(const MapRenderer &renderer,
         }
         case Layer::ImageLayerType:
             painter.setCompositionMode(compositionMode);
-            renderer.drawImageLayer(&painter, static_cast<const ImageLayer*>(layer));
+            renderer.drawImageLayer(&painter, static_cast<const ImageLayer*>(layer), layerExposed);
             break;
         case Layer::GroupLayerType:
             // Recursion handled by LayerIterator
@@ -157,6 +179,9 @@ bool TmxRasterizer::shouldDrawObject(const MapObject *object) const
 int TmxRasterizer::render(const QString &fileName,
                           QString imageFileName)
 {
+    if (mPyramidTileSize > 0)
+        return renderPyramid(fileName, imageFileName);
+
     const QFileInfo imageFileInfo(imageFileName);
 
     const QString imagePath = imageFileInfo.path();
@@ -180,6 +205,9 @@ int TmxRasterizer::render(const QString &fileName,
         }
 
         renderer = MapRenderer::create(map.get());
+
+        if (mFrameCount > 0 && mPreviousMapFileName.isEmpty())
+            return renderFrames(*renderer, imageFileName);
     }
 
     for (int frame = 0; frame < frameCount; ++frame) {
@@ -190,7 +218,10 @@ int TmxRasterizer::render(const QString &fileName,
 
         int ret;
 
-        if (map) {
+        if (map && !mPreviousMapFileName.isEmpty()) {
+            ret = updateMap(*renderer, imageFileName);
+            mAdvanceAnimations = mFrameDuration;
+        } else if (map) {
             ret = renderMap(*renderer, imageFileName);
             mAdvanceAnimations = mFrameDuration;
         } else {
@@ -207,6 +238,65 @@ int TmxRasterizer::render(const QString &fileName,
 
 int TmxRasterizer::renderMap(const MapRenderer &renderer,
                              const QString &imageFileName)
+{
+    if (mAdvanceAnimations > 0)
+        TilesetManager::instance()->advanceTileAnimations(mAdvanceAnimations);
+
+    return saveImage(imageFileName, drawMap(renderer));
+}
+
+/**
+ * Draws the map into a new image. When more than one thread is used, the
+ * image is split into horizontal bands which are drawn in parallel.
+ */
+QImage TmxRasterizer::drawMap(const MapRenderer &renderer) const
+{
+    QSize imageSize;
+    const QTransform transform = mapTransform(renderer, imageSize);
+
+    QImage image(imageSize, QImage::Format_ARGB32);
+    image.fill(Qt::transparent);
+
+    const int bandCount = qBound(1, mThreadCount, image.height());
+    if (bandCount == 1) {
+        drawMapBand(renderer, image, transform);
+        return image;
+    }
+
+    // Each band paints directly into its part of the image
+    uchar *bits = image.bits();
+    const qsizetype bytesPerLine = image.bytesPerLine();
+    const int width = image.width();
+    const QImage::Format format = image.format();
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(bandCount);
+
+    for (int band = 0; band < bandCount; ++band) {
+        const int top = image.height() * band / bandCount;
+        const int bottom = image.height() * (band + 1) / bandCount;
+
+        threadPool.start([=, &renderer] {
+            QImage bandImage(bits + top * bytesPerLine,
+                             width, bottom - top,
+                             bytesPerLine, format);
+
+            drawMapBand(renderer, bandImage,
+                        transform * QTransform::fromTranslate(0, -top));
+        });
+    }
+
+    threadPool.waitForDone();
+
+    return image;
+}
+
+/**
+ * Returns the transform from map to image coordinates, and sets
+ * \a imageSize to the size of the image the map is drawn into.
+ */
+QTransform TmxRasterizer::mapTransform(const MapRenderer &renderer,
+                                       QSize &imageSize) const
 {
     const auto map = renderer.map();
     QRect mapBoundingRect = renderer.mapBoundingRect();
@@ -225,30 +315,504 @@ int TmxRasterizer::renderMap(const MapRenderer &renderer,
         xScale = yScale = mScale;
     }
 
+    mapSize.rwidth() *= xScale;
+    mapSize.rheight() *= yScale;
+    imageSize = mapSize;
+
+    QTransform transform = QTransform::fromScale(xScale, yScale);
+    transform.translate(-mapBoundingRect.left(), -mapBoundingRect.top());
+    return transform;
+}
+
+/**
+ * Updates an image previously rendered from the map set as previous map, by
+ * repainting only the areas that changed compared to the given map. Falls
+ * back to rendering the whole map when the changes can't be limited to
+ * certain areas, or when the image doesn't match the map size.
+ *
+ * Changes to external tilesets can't be detected, since the previous map
+ * loads the same tilesets.
+ */
+int TmxRasterizer::updateMap(const MapRenderer &renderer,
+                             const QString &imageFileName)
+{
+    QString errorString;
+    std::unique_ptr<Map> previousMap { readMap(mPreviousMapFileName, &errorString) };
+    if (!previousMap) {
+        qWarning("Error while reading \"%s\":\n%s",
+                 qUtf8Printable(mPreviousMapFileName),
+                 qUtf8Printable(errorString));
+        return 1;
+    }
+
     if (mAdvanceAnimations > 0)
         TilesetManager::instance()->advanceTileAnimations(mAdvanceAnimations);
 
-    mapSize.rwidth() *= xScale;
-    mapSize.rheight() *= yScale;
+    QSize imageSize;
+    const QTransform transform = mapTransform(renderer, imageSize);
 
-    QImage image(mapSize, QImage::Format_ARGB32);
-    image.fill(Qt::transparent);
+    QImage image(imageFileName);
+    QRegion region;
+
+    if (image.size() != imageSize || !changedRegion(renderer, *previousMap, region))
+        return saveImage(imageFileName, drawMap(renderer));
+
+    if (region.isEmpty())
+        return 0;
+
+    QRegion imageRegion;
+    for (const QRect &rect : region)
+        imageRegion += transform.mapRect(QRectF(rect)).toAlignedRect().adjusted(-1, -1, 1, 1);
+    imageRegion &= image.rect();
+
+    // Avoid drawing the map many times for scattered changes
+    if (imageRegion.rectCount() > 256)
+        imageRegion = imageRegion.boundingRect();
+
+    image = image.convertToFormat(QImage::Format_ARGB32);
+    repaintRegion(renderer, image, transform, imageRegion);
+
+    return saveImage(imageFileName, image);
+}
+
+/**
+ * Clears and redraws the parts of \a image covered by \a region, which is
+ * in image coordinates.
+ */
+void TmxRasterizer::repaintRegion(const MapRenderer &renderer,
+                                  QImage &image,
+                                  const QTransform &transform,
+                                  const QRegion &region) const
+{
     QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing, mUseAntiAliasing);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, mSmoothImages);
+
+    const QTransform inverted = transform.inverted();
+
+    for (const QRect &rect : region) {
+        painter.setTransform(QTransform());
+        painter.setClipRect(rect);
+        painter.setOpacity(1.0);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(rect, Qt::transparent);
+
+        painter.setTransform(transform);
+        drawMapLayers(renderer, painter, QPoint(0, 0),
+                      inverted.mapRect(QRectF(rect)));
+    }
+}
+
+static QRectF objectBounds(const MapRenderer &renderer,
+                           const MapObject *object,
+                           QPointF offset)
+{
+    QRectF bounds = renderer.boundingRect(object);
+
+    if (object->rotation() != qreal(0)) {
+        const QPointF origin = renderer.pixelToScreenCoords(object->position());
+        QTransform transform;
+        transform.translate(origin.x(), origin.y());
+        transform.rotate(object->rotation());
+        transform.translate(-origin.x(), -origin.y());
+        bounds = transform.mapRect(bounds);
+    }
+
+    return bounds.translated(offset);
+}
+
+static bool objectsDiffer(const MapObject *a, const MapObject *b)
+{
+    const TextData &textA = a->textData();
+    const TextData &textB = b->textData();
+
+    return a->position() != b->position() ||
+            a->size() != b->size() ||
+            a->rotation() != b->rotation() ||
+            a->cell() != b->cell() ||
+            a->shape() != b->shape() ||
+            a->polygon() != b->polygon() ||
+            a->isVisible() != b->isVisible() ||
+            a->name() != b->name() ||
+            a->effectiveColors() != b->effectiveColors() ||
+            textA.text != textB.text ||
+            textA.font != textB.font ||
+            textA.color != textB.color ||
+            textA.alignment != textB.alignment ||
+            textA.wordWrap != textB.wordWrap;
+}
+
+static bool sameTilesets(const Map &a, const Map &b)
+{
+    if (a.tilesetCount() != b.tilesetCount())
+        return false;
+
+    for (int i = 0; i < a.tilesetCount(); ++i) {
+        const Tileset &tilesetA = *a.tilesets().at(i);
+        const Tileset &tilesetB = *b.tilesets().at(i);
+
+        if (tilesetA.fileName() != tilesetB.fileName() ||
+                tilesetA.imageSource() != tilesetB.imageSource() ||
+                tilesetA.tileSize() != tilesetB.tileSize() ||
+                tilesetA.tileOffset() != tilesetB.tileOffset() ||
+                tilesetA.tileCount() != tilesetB.tileCount()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static QMargins maxMargins(const QMargins &a, const QMargins &b)
+{
+    return QMargins(qMax(a.left(), b.left()),
+                    qMax(a.top(), b.top()),
+                    qMax(a.right(), b.right()),
+                    qMax(a.bottom(), b.bottom()));
+}
+
+/**
+ * Computes the \a region in map pixel coordinates that needs to be repainted
+ * to turn an image of \a previousMap into an image of the renderer's map.
+ *
+ * Returns false when the maps differ in ways that affect the whole image.
+ */
+bool TmxRasterizer::changedRegion(const MapRenderer &renderer,
+                                  const Map &previousMap,
+                                  QRegion &region) const
+{
+    const Map *map = renderer.map();
+
+    if (map->orientation() != previousMap.orientation() ||
+            map->tileSize() != previousMap.tileSize() ||
+            map->renderOrder() != previousMap.renderOrder() ||
+            map->staggerAxis() != previousMap.staggerAxis() ||
+            map->staggerIndex() != previousMap.staggerIndex() ||
+            map->hexSideLength() != previousMap.hexSideLength() ||
+            !sameTilesets(*map, previousMap)) {
+        return false;
+    }
+
+    const auto previousRenderer = MapRenderer::create(&previousMap);
+    const QMargins margins = maxMargins(map->drawMargins(),
+                                        previousMap.drawMargins());
+
+    auto addRect = [&region] (const QRectF &rect) {
+        region += rect.toAlignedRect().adjusted(-1, -1, 1, 1);
+    };
+
+    LayerIterator iterator(map);
+    LayerIterator previousIterator(&previousMap);
+
+    while (true) {
+        const Layer *layer = iterator.next();
+        const Layer *previousLayer = previousIterator.next();
+
+        if (!layer || !previousLayer)
+            return layer == previousLayer;
+
+        if (layer->layerType() != previousLayer->layerType() ||
+                layer->name() != previousLayer->name()) {
+            return false;
+        }
+
+        const bool draw = shouldDrawLayer(layer);
+        if (draw != shouldDrawLayer(previousLayer))
+            return false;
+        if (!draw)
+            continue;
+
+        const QPointF offset = layer->totalOffset();
+
+        if (offset != previousLayer->totalOffset() ||
+                layer->effectiveOpacity() != previousLayer->effectiveOpacity() ||
+                layer->effectiveTintColor() != previousLayer->effectiveTintColor() ||
+                layer->compositionMode() != previousLayer->compositionMode()) {
+            return false;
+        }
+
+        switch (layer->layerType()) {
+        case Layer::TileLayerType: {
+            const auto tileLayer = static_cast<const TileLayer*>(layer);
+            const auto previousTileLayer = static_cast<const TileLayer*>(previousLayer);
+
+            const QRegion diff = tileLayer->computeDiffRegion(*previousTileLayer);
+            for (const QRect &rect : diff) {
+                const QRect tileRect = rect.translated(tileLayer->position());
+                addRect(QRectF(renderer.boundingRect(tileRect).marginsAdded(margins)).translated(offset));
+            }
+            break;
+        }
+        case Layer::ObjectGroupType: {
+            const auto objectGroup = static_cast<const ObjectGroup*>(layer);
+            const auto previousObjectGroup = static_cast<const ObjectGroup*>(previousLayer);
+
+            if (objectGroup->drawOrder() != previousObjectGroup->drawOrder())
+                return false;
+
+            QHash<int, const MapObject*> previousObjects;
+            for (const MapObject *object : previousObjectGroup->objects())
+                previousObjects.insert(object->id(), object);
+
+            for (const MapObject *object : objectGroup->objects()) {
+                const MapObject *previousObject = previousObjects.take(object->id());
+
+                if (previousObject && !objectsDiffer(object, previousObject))
+                    continue;
+
+                if (shouldDrawObject(object))
+                    addRect(objectBounds(renderer, object, offset));
+                if (previousObject && shouldDrawObject(previousObject))
+                    addRect(objectBounds(*previousRenderer, previousObject, offset));
+            }
+
+            // Objects that were removed
+            for (const MapObject *previousObject : std::as_const(previousObjects))
+                if (shouldDrawObject(previousObject))
+                    addRect(objectBounds(*previousRenderer, previousObject, offset));
+            break;
+        }
+        case Layer::ImageLayerType: {
+            const auto imageLayer = static_cast<const ImageLayer*>(layer);
+            const auto previousImageLayer = static_cast<const ImageLayer*>(previousLayer);
+
+            if (imageLayer->imageSource() != previousImageLayer->imageSource() ||
+                    imageLayer->repeatX() != previousImageLayer->repeatX() ||
+                    imageLayer->repeatY() != previousImageLayer->repeatY()) {
+                return false;
+            }
+            break;
+        }
+        case Layer::GroupLayerType:
+            // Changes to group layers affect the effective values compared
+            // for their child layers
+            break;
+        }
+    }
+}
+
+void TmxRasterizer::drawMapBand(const MapRenderer &renderer,
+                                QImage &band,
+                                const QTransform &transform) const
+{
+    QPainter painter(&band);
 
     painter.setRenderHint(QPainter::Antialiasing, mUseAntiAliasing);
     painter.setRenderHint(QPainter::SmoothPixmapTransform, mSmoothImages);
-    painter.setTransform(QTransform::fromScale(xScale, yScale));
+    painter.setTransform(transform);
+
+    const QRectF exposed = transform.inverted().mapRect(QRectF(band.rect()));
+    drawMapLayers(renderer, painter, QPoint(0, 0), exposed);
+}
 
-    painter.translate(-mapBoundingRect.left(), -mapBoundingRect.top());
+/**
+ * The places in the image covered by each animated tile, along with the
+ * frame it showed when the image was last drawn.
+ */
+struct TmxRasterizer::AnimatedTiles
+{
+    struct Placements
+    {
+        QVector<QRect> rects;
+        int frameIndex = 0;
+    };
 
-    drawMapLayers(renderer, painter);
+    QHash<const Tile*, Placements> placements;
 
-    return saveImage(imageFileName, image);
+    QRegion advance(int duration);
+};
+
+/**
+ * Advances the tile animations by \a duration milliseconds and returns the
+ * region of the image that needs to be repainted.
+ */
+QRegion TmxRasterizer::AnimatedTiles::advance(int duration)
+{
+    TilesetManager::instance()->advanceTileAnimations(duration);
+
+    QVector<QRect> rects;
+
+    for (auto it = placements.begin(), end = placements.end(); it != end; ++it) {
+        const int frameIndex = it.key()->currentFrameIndex();
+        if (frameIndex == it->frameIndex)
+            continue;
+
+        it->frameIndex = frameIndex;
+        rects.append(it->rects);
+    }
+
+    // Avoid drawing the map many times for scattered changes
+    if (rects.size() > 256) {
+        QRect bounds;
+        for (const QRect &rect : std::as_const(rects))
+            bounds |= rect;
+        return bounds;
+    }
+
+    QRegion region;
+    for (const QRect &rect : std::as_const(rects))
+        region += rect;
+    return region;
+}
+
+TmxRasterizer::AnimatedTiles TmxRasterizer::findAnimatedTiles(const MapRenderer &renderer,
+                                                              const QTransform &transform,
+                                                              const QRect &imageRect) const
+{
+    AnimatedTiles animatedTiles;
+    const QMargins margins = renderer.map()->drawMargins();
+
+    auto addPlacement = [&] (const Tile *tile, const QRectF &bounds) {
+        const QRect rect = transform.mapRect(bounds).toAlignedRect().adjusted(-1, -1, 1, 1) & imageRect;
+        if (rect.isEmpty())
+            return;
+
+        auto &placements = animatedTiles.placements[tile];
+        placements.frameIndex = tile->currentFrameIndex();
+        placements.rects.append(rect);
+    };
+
+    LayerIterator iterator(renderer.map());
+    while (const Layer *layer = iterator.next()) {
+        if (!shouldDrawLayer(layer))
+            continue;
+
+        const QPointF offset = layer->totalOffset();
+
+        switch (layer->layerType()) {
+        case Layer::TileLayerType: {
+            const auto tileLayer = static_cast<const TileLayer*>(layer);
+            for (auto it = tileLayer->begin(), end = tileLayer->end(); it != end; ++it) {
+                const Tile *tile = it.value().tile();
+                if (!tile || !tile->isAnimated())
+                    continue;
+
+                const QRect tileRect(it.key() + tileLayer->position(), QSize(1, 1));
+                addPlacement(tile, QRectF(renderer.boundingRect(tileRect).marginsAdded(margins)).translated(offset));
+            }
+            break;
+        }
+        case Layer::ObjectGroupType:
+            for (const MapObject *object : static_cast<const ObjectGroup*>(layer)->objects()) {
+                const Tile *tile = object->cell().tile();
+                if (tile && tile->isAnimated() && shouldDrawObject(object))
+                    addPlacement(tile, objectBounds(renderer, object, offset));
+            }
+            break;
+        case Layer::ImageLayerType:
+        case Layer::GroupLayerType:
+            break;
+        }
+    }
+
+    return animatedTiles;
+}
+
+/**
+ * Renders \c mFrameCount frames of the map's tile animations.
+ *
+ * Only the first frame is drawn completely. For each following frame, only
+ * the places of the animated tiles that changed their frame are repainted.
+ * Frames that don't change are not drawn again.
+ *
+ * When the image file name ends with ".apng", the frames are written to a
+ * single animated PNG, in which unchanged frames extend the duration of the
+ * previous frame. Otherwise each frame is saved to a numbered image file,
+ * while the next frames are being drawn.
+ */
+int TmxRasterizer::renderFrames(const MapRenderer &renderer,
+                                const QString &imageFileName)
+{
+    const QFileInfo imageFileInfo(imageFileName);
+    const bool animatedPng = imageFileInfo.suffix().compare(QLatin1String("apng"),
+                                                            Qt::CaseInsensitive) == 0;
+
+    auto frameFileName = [&] (int frame) {
+        return QString(QLatin1String("%1/%2%3.%4"))
+                .arg(imageFileInfo.path(), imageFileInfo.completeBaseName(),
+                     QString::number(frame), imageFileInfo.suffix());
+    };
+
+    TaskScheduler::setThreadCount(mThreadCount);
+
+    if (mAdvanceAnimations > 0)
+        TilesetManager::instance()->advanceTileAnimations(mAdvanceAnimations);
+
+    QSize imageSize;
+    const QTransform transform = mapTransform(renderer, imageSize);
+    AnimatedTiles animatedTiles = findAnimatedTiles(renderer, transform,
+                                                    QRect(QPoint(), imageSize));
+
+    QImage image = drawMap(renderer);
+
+    QVector<AnimatedPngWriter::Frame> pngFrames;
+    if (animatedPng)
+        pngFrames.append({ image, QPoint(), mFrameDuration });
+
+    // Identical frames are encoded once and written to each of their files
+    QSemaphore available(qMax(1, mThreadCount) * 2);
+    std::atomic<int> failures { 0 };
+    QStringList pendingFileNames { frameFileName(0) };
+
+    auto savePendingFrames = [&] {
+        available.acquire();
+        TaskScheduler::start([this, image, fileNames = pendingFileNames, &available, &failures] {
+            if (saveImageFiles(fileNames, image))
+                ++failures;
+            available.release();
+        }, TaskScheduler::Interactive);
+        pendingFileNames.clear();
+    };
+
+    for (int frame = 1; frame < mFrameCount; ++frame) {
+        const QRegion region = animatedTiles.advance(mFrameDuration);
+
+        if (!region.isEmpty()) {
+            if (!animatedPng)
+                savePendingFrames();
+
+            repaintRegion(renderer, image, transform, region);
+
+            if (animatedPng) {
+                const QRect bounds = region.boundingRect();
+                pngFrames.append({ image.copy(bounds), bounds.topLeft(), mFrameDuration });
+                continue;
+            }
+        } else if (animatedPng) {
+            pngFrames.last().duration += mFrameDuration;
+            continue;
+        }
+
+        pendingFileNames.append(frameFileName(frame));
+    }
+
+    if (!animatedPng) {
+        savePendingFrames();
+        TaskScheduler::waitForDone();
+        return failures > 0 ? 1 : 0;
+    }
+
+    QSaveFile file(imageFileName);
+    QString error;
+
+    if (!file.open(QIODevice::WriteOnly)) {
+        error = file.errorString();
+    } else if (AnimatedPngWriter::write(&file, imageSize, pngFrames, &error)) {
+        if (file.commit())
+            return 0;
+        error = file.errorString();
+    }
+
+    qWarning("Error while writing \"%s\": %s",
+             qUtf8Printable(imageFileName),
+             qUtf8Printable(error));
+    return 1;
 }
 
 
 int TmxRasterizer::saveImage(const QString &imageFileName,
-                             const QImage &image) const
+                             const QImage &image,
+                             QString *error) const
 {
     QImageWriter imageWriter(imageFileName);
 
@@ -259,12 +823,52 @@ int TmxRasterizer::saveImage(const QString &imageFileName,
         qWarning("Error while writing \"%s\": %s",
                  qUtf8Printable(imageFileName),
                  qUtf8Printable(imageWriter.errorString()));
+        if (error)
+            *error = imageWriter.errorString();
         return 1;
     }
 
     return 0;
 }
 
+/**
+ * Saves the \a image to each of the given files, encoding it only once. The
+ * format is chosen based on the suffix of the first file name.
+ */
+int TmxRasterizer::saveImageFiles(const QStringList &imageFileNames,
+                                  const QImage &image) const
+{
+    QByteArray format = QFileInfo(imageFileNames.first()).suffix().toLower().toLatin1();
+    if (!QImageWriter::supportedImageFormats().contains(format))
+        format = "png";
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+
+    QImageWriter imageWriter(&buffer, format);
+    if (!imageWriter.write(image)) {
+        qWarning("Error while writing \"%s\": %s",
+                 qUtf8Printable(imageFileNames.first()),
+                 qUtf8Printable(imageWriter.errorString()));
+        return 1;
+    }
+
+    for (const QString &imageFileName : imageFileNames) {
+        QSaveFile file(imageFileName);
+        if (!file.open(QIODevice::WriteOnly) ||
+                file.write(data) != data.size() ||
+                !file.commit()) {
+            qWarning("Error while writing \"%s\": %s",
+                     qUtf8Printable(imageFileName),
+                     qUtf8Printable(file.errorString()));
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
 int TmxRasterizer::renderWorld(const QString &worldFileName,
                                const QString &imageFileName)
 {
@@ -283,17 +887,29 @@ int TmxRasterizer::renderWorld(const QString &worldFileName,
                  qUtf8Printable(worldFileName));
         return 1;
     }
+    // Maps with a stored thumbnail don't need to be read to determine the
+    // size of the world
+    QVector<QRect> thumbnailBounds(maps.size());
+
     QRect worldBoundingRect;
-    for (const WorldMapEntry &mapEntry : maps) {
-        std::unique_ptr<Map> map { readMap(mapEntry.fileName, &errorString) };
-        if (!map) {
-            qWarning("Error while reading \"%s\":\n%s",
-                     qUtf8Printable(mapEntry.fileName),
-                     qUtf8Printable(errorString));
-            continue;
+    for (int i = 0; i < maps.size(); ++i) {
+        const WorldMapEntry &mapEntry = maps.at(i);
+        QRect mapBoundingRect = MapThumbnailCache::bounds(mapEntry.fileName);
+
+        if (!mapBoundingRect.isNull()) {
+            thumbnailBounds[i] = mapBoundingRect;
+        } else {
+            std::unique_ptr<Map> map { readMap(mapEntry.fileName, &errorString) };
+            if (!map) {
+                qWarning("Error while reading \"%s\":\n%s",
+                         qUtf8Printable(mapEntry.fileName),
+                         qUtf8Printable(errorString));
+                continue;
+            }
+            const auto renderer = MapRenderer::create(map.get());
+            mapBoundingRect = renderer->mapBoundingRect();
         }
-        const auto renderer = MapRenderer::create(map.get());
-        QRect mapBoundingRect = renderer->mapBoundingRect();
+
         mapBoundingRect.translate(mapEntry.rect.topLeft());
 
         worldBoundingRect = worldBoundingRect.united(mapBoundingRect);
@@ -321,7 +937,24 @@ int TmxRasterizer::renderWorld(const QString &worldFileName,
 
     painter.translate(-worldBoundingRect.topLeft());
 
-    for (const WorldMapEntry &mapEntry : maps) {
+    for (int i = 0; i < maps.size(); ++i) {
+        const WorldMapEntry &mapEntry = maps.at(i);
+
+        // Draw the thumbnail instead of the map when it is detailed enough
+        const QRect &bounds = thumbnailBounds.at(i);
+        if (!bounds.isNull()) {
+            const int drawnSize = qCeil(qMax(bounds.width(), bounds.height()) * xScale);
+            if (drawnSize <= MapThumbnailCache::largestSize) {
+                const auto thumbnail = MapThumbnailCache::load(mapEntry.fileName,
+                                                               MapThumbnailCache::sizeFor(drawnSize));
+                if (!thumbnail.isNull()) {
+                    painter.drawImage(QRectF(thumbnail.bounds.translated(mapEntry.rect.topLeft())),
+                                      thumbnail.image);
+                    continue;
+                }
+            }
+        }
+
         std::unique_ptr<Map> map { readMap(mapEntry.fileName, &errorString) };
         if (!map) {
             qWarning("Error while reading \"%s\":\n%s",
@@ -339,3 +972,433 @@ int TmxRasterizer::renderWorld(const QString &worldFileName,
 
     return saveImage(imageFileName, image);
 }
+
+/**
+ * Reads the maps and images listed in the given manifest. Each line holds
+ * the file name of a map or world and the file name of its image, separated
+ * by a tab. Empty lines and lines starting with '#' are skipped, and
+ * relative file names are relative to the manifest.
+ */
+bool TmxRasterizer::readBatchManifest(const QString &manifestFileName,
+                                      QVector<BatchEntry> &entries,
+                                      QString *error)
+{
+    QFile file(manifestFileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = file.errorString();
+        return false;
+    }
+
+    const QDir dir = QFileInfo(manifestFileName).dir();
+
+    QTextStream stream(&file);
+    int lineNumber = 0;
+
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine();
+        ++lineNumber;
+
+        if (line.trimmed().isEmpty() || line.startsWith(QLatin1Char('#')))
+            continue;
+
+        const QStringList fields = line.split(QLatin1Char('\t'));
+        if (fields.size() != 2 || fields.at(0).isEmpty() || fields.at(1).isEmpty()) {
+            *error = QStringLiteral("Line %1: expected a map and an image file name separated by a tab").arg(lineNumber);
+            return false;
+        }
+
+        entries.append({ dir.filePath(fields.at(0)), dir.filePath(fields.at(1)) });
+    }
+
+    return true;
+}
+
+/**
+ * Returns an entry for each file matching the given wildcard \a pattern,
+ * which may only contain wildcards in its file name. The images are PNG
+ * files named after the maps, in \a imageDirectory.
+ */
+QVector<TmxRasterizer::BatchEntry> TmxRasterizer::batchEntriesMatching(const QString &pattern,
+                                                                       const QString &imageDirectory)
+{
+    const QFileInfo patternInfo(pattern);
+    const QDir dir = patternInfo.dir();
+    const QDir imageDir(imageDirectory);
+
+    QVector<BatchEntry> entries;
+
+    const auto files = dir.entryInfoList({ patternInfo.fileName() }, QDir::Files, QDir::Name);
+    for (const QFileInfo &file : files) {
+        entries.append({ file.filePath(),
+                         imageDir.filePath(file.completeBaseName() + QLatin1String(".png")) });
+    }
+
+    return entries;
+}
+
+/**
+ * Renders each map to its image within this process.
+ *
+ * The maps are read one after the other on the calling thread, which shares
+ * the loaded tilesets, images and templates between them. Rendering and
+ * saving the images happens in parallel, using the thread count as the
+ * number of maps rendered at the same time. Worlds are rendered on the
+ * calling thread.
+ *
+ * When \a reportFileName is given, the time spent on each map is written to
+ * it in JSON format.
+ */
+int TmxRasterizer::renderBatch(const QVector<BatchEntry> &entries,
+                               const QString &reportFileName)
+{
+    struct Job
+    {
+        std::unique_ptr<Map> map;
+        QString error;
+        qint64 readTime = 0;
+        qint64 renderTime = 0;
+        qint64 saveTime = 0;
+        bool success = false;
+        std::atomic<bool> done { false };
+    };
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    ImageCache::resetStatistics();
+
+    // Each map is drawn by a single thread, since the maps are rendered in
+    // parallel instead
+    const int threadCount = mThreadCount;
+    TaskScheduler::setThreadCount(threadCount);
+    mThreadCount = 1;
+
+    const auto jobs = std::make_unique<Job[]>(entries.size());
+
+    // Tilesets are kept alive for the whole batch, so that they are loaded
+    // only once even when no map using them is currently loaded
+    QSet<SharedTileset> tilesets;
+
+    // Limits the number of maps kept in memory
+    const int maxPendingJobs = threadCount * 2;
+    QSemaphore available(maxPendingJobs);
+    QVector<int> pendingJobs;
+
+    // Maps are destroyed on this thread, since they may release tilesets
+    // and templates
+    auto releaseFinishedMaps = [&] {
+        pendingJobs.erase(std::remove_if(pendingJobs.begin(), pendingJobs.end(), [&] (int index) {
+            if (!jobs[index].done)
+                return false;
+            jobs[index].map.reset();
+            return true;
+        }), pendingJobs.end());
+    };
+
+    for (int i = 0; i < entries.size(); ++i) {
+        const BatchEntry &entry = entries.at(i);
+        Job &job = jobs[i];
+
+        QElapsedTimer timer;
+        timer.start();
+
+        if (entry.fileName.endsWith(QLatin1String(".world"), Qt::CaseInsensitive)) {
+            job.success = renderWorld(entry.fileName, entry.imageFileName) == 0;
+            job.renderTime = timer.elapsed();
+            job.done = true;
+            continue;
+        }
+
+        available.acquire();
+        releaseFinishedMaps();
+
+        timer.restart();
+        job.map = readMap(entry.fileName, &job.error);
+        job.readTime = timer.elapsed();
+
+        if (!job.map) {
+            qWarning("Error while reading \"%s\":\n%s",
+                     qUtf8Printable(entry.fileName),
+                     qUtf8Printable(job.error));
+            job.done = true;
+            available.release();
+            continue;
+        }
+
+        const auto mapTilesets = job.map->tilesets();
+        for (const SharedTileset &tileset : mapTilesets)
+            tilesets.insert(tileset);
+
+        pendingJobs.append(i);
+
+        const Map *map = job.map.get();
+        TaskScheduler::start([this, map, &entry, &job, &available] {
+            QElapsedTimer timer;
+            timer.start();
+
+            const auto renderer = MapRenderer::create(map);
+            const QImage image = drawMap(*renderer);
+            job.renderTime = timer.restart();
+
+            job.success = saveImage(entry.imageFileName, image, &job.error) == 0;
+            job.saveTime = timer.elapsed();
+
+            job.done = true;
+            available.release();
+        }, TaskScheduler::Interactive);
+    }
+
+    // Wait for all maps to be rendered
+    available.acquire(maxPendingJobs);
+    available.release(maxPendingJobs);
+    releaseFinishedMaps();
+
+    mThreadCount = threadCount;
+
+    int failures = 0;
+    QJsonArray maps;
+
+    for (int i = 0; i < entries.size(); ++i) {
+        const Job &job = jobs[i];
+        if (!job.success)
+            ++failures;
+
+        QJsonObject map {
+            { QStringLiteral("map"), entries.at(i).fileName },
+            { QStringLiteral("image"), entries.at(i).imageFileName },
+            { QStringLiteral("success"), job.success },
+            { QStringLiteral("readMs"), job.readTime },
+            { QStringLiteral("renderMs"), job.renderTime },
+            { QStringLiteral("saveMs"), job.saveTime },
+        };
+        if (!job.error.isEmpty())
+            map.insert(QStringLiteral("error"), job.error);
+
+        maps.append(map);
+    }
+
+    if (!reportFileName.isEmpty()) {
+        const ImageCache::Statistics imageCache = ImageCache::statistics();
+
+        const QJsonObject report {
+            { QStringLiteral("maps"), maps },
+            { QStringLiteral("failures"), failures },
+            { QStringLiteral("threads"), threadCount },
+            { QStringLiteral("tilesets"), tilesets.size() },
+            { QStringLiteral("imageCacheHits"), imageCache.hits },
+            { QStringLiteral("imageCacheMisses"), imageCache.misses },
+            { QStringLiteral("totalMs"), totalTimer.elapsed() },
+        };
+
+        QFile file(reportFileName);
+        if (!file.open(QIODevice::WriteOnly) ||
+                file.write(QJsonDocument(report).toJson()) == -1) {
+            qWarning("Error while writing \"%s\": %s",
+                     qUtf8Printable(reportFileName),
+                     qUtf8Printable(file.errorString()));
+            return 1;
+        }
+    }
+
+    return failures > 0 ? 1 : 0;
+}
+
+struct TmxRasterizer::Pyramid
+{
+    struct Source
+    {
+        std::unique_ptr<Map> map;
+        std::unique_ptr<MapRenderer> renderer;
+        QRect bounds;
+        QPoint offset;
+    };
+
+    std::vector<Source> sources;
+    QRect bounds;
+    qreal scale = 1.0;
+    int maxZoom = 0;
+    QString path;
+    QString suffix;
+};
+
+/**
+ * Writes a zoom pyramid of tiles to the directory named after the image file,
+ * as <name>/<z>/<x>/<y>.<suffix>. At the highest zoom level the tiles are
+ * drawn at the requested scale, and at each level below the resolution is
+ * halved, until the whole map or world fits in a single tile at zoom level 0.
+ *
+ * The tiles are rendered depth-first, so that memory usage is bounded by the
+ * tile size and the number of zoom levels. Tiles that would be empty are not
+ * written.
+ */
+int TmxRasterizer::renderPyramid(const QString &fileName,
+                                 const QString &imageFileName)
+{
+    Pyramid pyramid;
+    QString errorString;
+
+    auto addSource = [&] (std::unique_ptr<Map> map, QPoint offset) {
+        Pyramid::Source source;
+        source.renderer = MapRenderer::create(map.get());
+        source.bounds = source.renderer->mapBoundingRect();
+        map->adjustBoundingRectForOffsetsAndImageLayers(source.bounds);
+        source.bounds.translate(offset);
+        source.offset = offset;
+        source.map = std::move(map);
+
+        pyramid.bounds = pyramid.bounds.united(source.bounds);
+        pyramid.sources.push_back(std::move(source));
+    };
+
+    if (fileName.endsWith(QLatin1String(".world"), Qt::CaseInsensitive)) {
+        const auto world = World::load(fileName, &errorString);
+        if (!world) {
+            qWarning("Error loading the world file \"%s\":\n%s",
+                     qUtf8Printable(fileName),
+                     qUtf8Printable(errorString));
+            return 1;
+        }
+
+        for (const WorldMapEntry &mapEntry : world->allMaps()) {
+            std::unique_ptr<Map> map { readMap(mapEntry.fileName, &errorString) };
+            if (!map) {
+                qWarning("Error while reading \"%s\":\n%s",
+                         qUtf8Printable(mapEntry.fileName),
+                         qUtf8Printable(errorString));
+                continue;
+            }
+            addSource(std::move(map), mapEntry.rect.topLeft());
+        }
+    } else {
+        std::unique_ptr<Map> map { readMap(fileName, &errorString) };
+        if (!map) {
+            qWarning("Error while reading \"%s\":\n%s",
+                     qUtf8Printable(fileName),
+                     qUtf8Printable(errorString));
+            return 1;
+        }
+        addSource(std::move(map), QPoint());
+    }
+
+    if (pyramid.bounds.isEmpty()) {
+        qWarning("Error: Nothing to render in \"%s\"", qUtf8Printable(fileName));
+        return 1;
+    }
+
+    if (mAdvanceAnimations > 0)
+        TilesetManager::instance()->advanceTileAnimations(mAdvanceAnimations);
+
+    const QFileInfo imageFileInfo(imageFileName);
+    pyramid.path = imageFileInfo.dir().filePath(imageFileInfo.completeBaseName());
+    pyramid.suffix = imageFileInfo.suffix();
+    if (pyramid.suffix.isEmpty())
+        pyramid.suffix = QStringLiteral("png");
+
+    pyramid.scale = mScale;
+
+    const qreal size = qMax(pyramid.bounds.width(), pyramid.bounds.height()) * pyramid.scale;
+    pyramid.maxZoom = qMax(0, static_cast<int>(std::ceil(std::log2(size / mPyramidTileSize))));
+
+    QImage image;
+    return renderPyramidTile(pyramid, 0, 0, 0, image) ? 0 : 1;
+}
+
+/**
+ * Renders the pyramid tile at zoom level \a z and saves it to disk when it is
+ * not empty. Tiles below the highest zoom level are composed from their four
+ * child tiles.
+ *
+ * Returns false when a tile could not be written.
+ */
+bool TmxRasterizer::renderPyramidTile(const Pyramid &pyramid, int z, int x, int y,
+                                      QImage &image) const
+{
+    const int tileSize = mPyramidTileSize;
+    const qreal levelScale = std::ldexp(pyramid.scale, z - pyramid.maxZoom);
+    const qreal sourceSize = tileSize / levelScale;
+    const QRectF sourceRect(pyramid.bounds.left() + x * sourceSize,
+                            pyramid.bounds.top() + y * sourceSize,
+                            sourceSize, sourceSize);
+
+    image = QImage();
+
+    auto intersects = [&] (const Pyramid::Source &source) {
+        return sourceRect.intersects(source.bounds);
+    };
+    if (std::none_of(pyramid.sources.begin(), pyramid.sources.end(), intersects))
+        return true;
+
+    if (z == pyramid.maxZoom) {
+        image = QImage(tileSize, tileSize, QImage::Format_ARGB32);
+        image.fill(Qt::transparent);
+
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing, mUseAntiAliasing);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, mSmoothImages);
+
+        QTransform transform = QTransform::fromScale(levelScale, levelScale);
+        transform.translate(-sourceRect.left(), -sourceRect.top());
+
+        for (const Pyramid::Source &source : pyramid.sources) {
+            if (!intersects(source))
+                continue;
+
+            painter.setTransform(transform);
+            drawMapLayers(*source.renderer, painter, source.offset, sourceRect);
+        }
+
+        painter.end();
+
+        // Skip tiles where nothing ended up being drawn
+        bool empty = true;
+        for (int row = 0; row < tileSize && empty; ++row) {
+            auto line = reinterpret_cast<const QRgb*>(image.constScanLine(row));
+            empty = std::all_of(line, line + tileSize,
+                                [] (QRgb pixel) { return qAlpha(pixel) == 0; });
+        }
+        if (empty) {
+            image = QImage();
+            return true;
+        }
+    } else {
+        const qreal half = tileSize / 2.0;
+        QPainter painter;
+
+        for (int dy = 0; dy < 2; ++dy) {
+            for (int dx = 0; dx < 2; ++dx) {
+                QImage child;
+                if (!renderPyramidTile(pyramid, z + 1, x * 2 + dx, y * 2 + dy, child))
+                    return false;
+                if (child.isNull())
+                    continue;
+
+                if (image.isNull()) {
+                    image = QImage(tileSize, tileSize, QImage::Format_ARGB32);
+                    image.fill(Qt::transparent);
+                    painter.begin(&image);
+                    painter.setRenderHint(QPainter::SmoothPixmapTransform, mSmoothImages);
+                }
+
+                painter.drawImage(QRectF(dx * half, dy * half, half, half), child);
+            }
+        }
+
+        if (image.isNull())
+            return true;
+
+        painter.end();
+    }
+
+    const QString tilePath = QStringLiteral("%1/%2/%3").arg(pyramid.path,
+                                                          QString::number(z),
+                                                          QString::number(x));
+    if (!QDir().mkpath(tilePath)) {
+        qWarning("Error while creating directory \"%s\"", qUtf8Printable(tilePath));
+        return false;
+    }
+
+    const QString tileFileName = QStringLiteral("%1/%2.%3").arg(tilePath,
+                                                              QString::number(y),
+                                                              pyramid.suffix);
+    return saveImage(tileFileName, image) == 0;
+}
@@ -34,6 +34,7 @@
 
 #include <QString>
 #include <QStringList>
+#include <QVector>
 
 using namespace Tiled;
 
@@ -43,6 +44,12 @@ class QPainter;
 class TmxRasterizer
 {
 public:
+    struct BatchEntry
+    {
+        QString fileName;
+        QString imageFileName;
+    };
+
     TmxRasterizer();
 
     qreal scale() const { return mScale; }
@@ -54,6 +61,9 @@ public:
     bool useAntiAliasing() const { return mUseAntiAliasing; }
     bool smoothImages() const { return mSmoothImages; }
     bool ignoreVisibility() const { return mIgnoreVisibility; }
+    int threadCount() const { return mThreadCount; }
+    int pyramidTileSize() const { return mPyramidTileSize; }
+    const QString &previousMapFileName() const { return mPreviousMapFileName; }
 
     void setScale(qreal scale) { mScale = scale; }
     void setTileSize(int tileSize) { mTileSize = tileSize; }
@@ -64,6 +74,9 @@ public:
     void setAntiAliasing(bool useAntiAliasing) { mUseAntiAliasing = useAntiAliasing; }
     void setSmoothImages(bool smoothImages) { mSmoothImages = smoothImages; }
     void setIgnoreVisibility(bool IgnoreVisibility) { mIgnoreVisibility = IgnoreVisibility; }
+    void setThreadCount(int threadCount) { mThreadCount = threadCount; }
+    void setPyramidTileSize(int tileSize) { mPyramidTileSize = tileSize; }
+    void setPreviousMapFileName(const QString &fileName) { mPreviousMapFileName = fileName; }
 
     void setLayersToHide(QStringList layersToHide) { mLayersToHide = layersToHide; }
     void setLayersToShow(QStringList layersToShow) { mLayersToShow = layersToShow; }
@@ -74,6 +87,15 @@ public:
     void setLayerTypeVisible(Layer::TypeFlag layerType, bool visible);
 
     int render(const QString &fileName, QString imageFileName);
+    int renderBatch(const QVector<BatchEntry> &entries,
+                    const QString &reportFileName = QString());
+    QImage drawMap(const MapRenderer &renderer) const;
+
+    static bool readBatchManifest(const QString &manifestFileName,
+                                  QVector<BatchEntry> &entries,
+                                  QString *error);
+    static QVector<BatchEntry> batchEntriesMatching(const QString &pattern,
+                                                    const QString &imageDirectory);
 
 private:
     qreal mScale = 1.0;
@@ -85,16 +107,41 @@ private:
     bool mUseAntiAliasing = false;
     bool mSmoothImages = true;
     bool mIgnoreVisibility = false;
+    int mThreadCount = 1;
+    int mPyramidTileSize = 0;
+    QString mPreviousMapFileName;
     QStringList mLayersToHide;
     QStringList mLayersToShow;
     QStringList mObjectsToHide;
     QStringList mObjectsToShow;
     int mLayerTypesToShow = Layer::AnyLayerType & ~Layer::GroupLayerType;
 
-    void drawMapLayers(const MapRenderer &renderer, QPainter &painter, QPoint mapOffset = QPoint(0, 0)) const;
+    void drawMapLayers(const MapRenderer &renderer, QPainter &painter, QPoint mapOffset = QPoint(0, 0),
+                       const QRectF &exposed = QRectF()) const;
+    void drawMapBand(const MapRenderer &renderer, QImage &band,
+                     const QTransform &transform) const;
     int renderMap(const MapRenderer &renderer, const QString &imageFileName);
+    int updateMap(const MapRenderer &renderer, const QString &imageFileName);
+    void repaintRegion(const MapRenderer &renderer, QImage &image,
+                       const QTransform &transform, const QRegion &region) const;
+
+    struct AnimatedTiles;
+    int renderFrames(const MapRenderer &renderer, const QString &imageFileName);
+    AnimatedTiles findAnimatedTiles(const MapRenderer &renderer,
+                                    const QTransform &transform,
+                                    const QRect &imageRect) const;
+    QTransform mapTransform(const MapRenderer &renderer, QSize &imageSize) const;
+    bool changedRegion(const MapRenderer &renderer, const Map &previousMap,
+                       QRegion &region) const;
     int renderWorld(const QString &worldFileName, const QString &imageFileName);
-    int saveImage(const QString &imageFileName, const QImage &image) const;
+    int saveImage(const QString &imageFileName, const QImage &image,
+                  QString *error = nullptr) const;
+    int saveImageFiles(const QStringList &imageFileNames, const QImage &image) const;
+
+    struct Pyramid;
+    int renderPyramid(const QString &fileName, const QString &imageFileName);
+    bool renderPyramidTile(const Pyramid &pyramid, int z, int x, int y,
+                           QImage &image) const;
     bool shouldDrawLayer(const Layer *layer) const;
     bool shouldDrawObject(const MapObject *object) const;
 };
@@ -0,0 +1,99 @@
+/*
+ * benchmark.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of the TMX Viewer example.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "benchmark.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Benchmark {
+
+static const int framesPerPhase = 100;
+
+/**
+ * Returns the view positions of the benchmark: zooming out from the center
+ * until the whole map is visible, panning diagonally across the map at
+ * 100%, and zooming in on the center up to 400%.
+ */
+QVector<Step> steps(const QRectF &mapRect, QSize viewSize)
+{
+    QVector<Step> steps;
+    steps.reserve(framesPerPhase * 3);
+
+    const QPointF center = mapRect.center();
+    const qreal fitScale = std::min({ 1.0,
+                                      viewSize.width() / mapRect.width(),
+                                      viewSize.height() / mapRect.height() });
+
+    for (int i = 0; i < framesPerPhase; ++i) {
+        const qreal t = qreal(i) / (framesPerPhase - 1);
+        steps.append(Step { center, std::pow(fitScale, t) });
+    }
+
+    for (int i = 0; i < framesPerPhase; ++i) {
+        const qreal t = qreal(i) / (framesPerPhase - 1);
+        steps.append(Step { mapRect.topLeft() + t * (mapRect.bottomRight() - mapRect.topLeft()), 1.0 });
+    }
+
+    for (int i = 0; i < framesPerPhase; ++i) {
+        const qreal t = qreal(i) / (framesPerPhase - 1);
+        steps.append(Step { center, std::pow(4.0, t) });
+    }
+
+    return steps;
+}
+
+/**
+ * Prints the average, median, 95th percentile and worst of the given frame
+ * times, which are in nanoseconds.
+ */
+void printStatistics(const QVector<qint64> &frameTimes)
+{
+    if (frameTimes.isEmpty())
+        return;
+
+    QVector<qint64> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+
+    qint64 total = 0;
+    for (qint64 frameTime : sorted)
+        total += frameTime;
+
+    const auto ms = [] (qint64 ns) { return ns / 1000000.0; };
+    const qint64 percentile95 = sorted.at(std::min<int>(sorted.size() - 1, sorted.size() * 95 / 100));
+
+    qInfo("Frames: %d", int(sorted.size()));
+    qInfo("Average: %.2f ms (%.1f fps)", ms(total) / sorted.size(), sorted.size() * 1000.0 / ms(total));
+    qInfo("Median: %.2f ms", ms(sorted.at(sorted.size() / 2)));
+    qInfo("95th percentile: %.2f ms", ms(percentile95));
+    qInfo("Worst: %.2f ms", ms(sorted.last()));
+}
+
+} // namespace Benchmark
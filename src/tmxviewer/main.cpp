@@ -35,6 +35,12 @@
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QDebug>
+#include <QSurfaceFormat>
+#include <QTimer>
+
+#ifdef TMXVIEWER_QUICK
+#include "quickmapviewer.h"
+#endif
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -70,16 +76,55 @@ int main(int argc, char *argv[])
     parser.addHelpOption();
     parser.addVersionOption();
     parser.addPositionalArgument(QStringLiteral("file"), QCoreApplication::translate("main", "Map file to display."));
+#ifdef TMXVIEWER_QUICK
+    const QCommandLineOption quickOption(QStringLiteral("quick"),
+                                         QCoreApplication::translate("main", "Display the tile layers using the Qt Quick scene graph, which is faster for large maps."));
+    parser.addOption(quickOption);
+#endif
+    const QCommandLineOption benchmarkOption(QStringLiteral("benchmark"),
+                                             QCoreApplication::translate("main", "Run a scripted pan and zoom sequence, print frame statistics and quit."));
+    parser.addOption(benchmarkOption);
     parser.process(a);
 
     const QStringList args = parser.positionalArguments();
     if (args.size() != 1)
         parser.showHelp(1);
 
+    const bool benchmark = parser.isSet(benchmarkOption);
+
+#ifdef TMXVIEWER_QUICK
+    if (parser.isSet(quickOption)) {
+        // Don't let the frame rate be limited by the display when measuring
+        if (benchmark) {
+            QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+            format.setSwapInterval(0);
+            QSurfaceFormat::setDefaultFormat(format);
+        }
+
+        QuickMapViewer w;
+        w.resize(1024, 768);
+        if (!w.viewMap(args.first()))
+            return 1;
+
+        w.show();
+        if (benchmark)
+            w.runBenchmark();
+        return a.exec();
+    }
+#endif
+
     TmxViewer w;
     if (!w.viewMap(args.first()))
         return 1;
 
     w.show();
+
+    if (benchmark) {
+        QTimer::singleShot(0, &w, [&w] {
+            w.runBenchmark();
+            QCoreApplication::quit();
+        });
+    }
+
     return a.exec();
 }
@@ -0,0 +1,167 @@
+/*
+ * quickmapviewer.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of the TMX Viewer example.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "quickmapviewer.h"
+
+#include "map.h"
+#include "mapformat.h"
+#include "mapitem.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMouseEvent>
+#include <QWheelEvent>
+
+#include <cmath>
+
+QuickMapViewer::QuickMapViewer(QWindow *parent)
+    : QQuickView(parent)
+    , mContainer(new QQuickItem(contentItem()))
+    , mMapItem(new TiledQuick::MapItem(mContainer))
+{
+    setTitle(tr("TMX Viewer"));
+    setColor(Qt::black);
+
+    mContainer->setTransformOrigin(QQuickItem::TopLeft);
+}
+
+QuickMapViewer::~QuickMapViewer()
+{
+    // The item refers to the map, so it needs to be deleted first
+    delete mContainer;
+}
+
+bool QuickMapViewer::viewMap(const QString &fileName)
+{
+    mMapItem->unsetMap();
+
+    QString errorString;
+    mMap = Tiled::readMap(fileName, &errorString);
+    if (!mMap) {
+        qWarning().noquote() << "Error:" << errorString;
+        return false;
+    }
+
+    mMapItem->setMap(mMap.get());
+    centerOn(mMapItem->boundingRect().center(), 1.0);
+
+    return true;
+}
+
+/**
+ * Runs the scripted pan and zoom sequence, moving to the next step each time
+ * a frame has been presented, and prints the time between frames. Quits the
+ * application when done.
+ */
+void QuickMapViewer::runBenchmark()
+{
+    mBenchmarkSteps = Benchmark::steps(mMapItem->boundingRect(), size());
+    mFrameTimes.clear();
+    mFrameTimes.reserve(mBenchmarkSteps.size());
+
+    connect(this, &QQuickWindow::frameSwapped,
+            this, &QuickMapViewer::benchmarkFrameSwapped);
+
+    mFrameTimer.invalidate();
+    update();
+}
+
+void QuickMapViewer::benchmarkFrameSwapped()
+{
+    // The first frame only starts the timer
+    if (mFrameTimer.isValid())
+        mFrameTimes.append(mFrameTimer.nsecsElapsed());
+    mFrameTimer.start();
+
+    if (mFrameTimes.size() == mBenchmarkSteps.size()) {
+        disconnect(this, &QQuickWindow::frameSwapped,
+                   this, &QuickMapViewer::benchmarkFrameSwapped);
+
+        Benchmark::printStatistics(mFrameTimes);
+        QCoreApplication::quit();
+        return;
+    }
+
+    const Benchmark::Step &step = mBenchmarkSteps.at(mFrameTimes.size());
+    centerOn(step.center, step.scale);
+    update();
+}
+
+void QuickMapViewer::mousePressEvent(QMouseEvent *event)
+{
+    mLastMousePos = event->position();
+}
+
+void QuickMapViewer::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!(event->buttons() & Qt::LeftButton))
+        return;
+
+    const QPointF delta = event->position() - mLastMousePos;
+    mLastMousePos = event->position();
+
+    setView(mContainer->position() + delta, mContainer->scale());
+}
+
+void QuickMapViewer::wheelEvent(QWheelEvent *event)
+{
+    // Zoom around the mouse position
+    const qreal oldScale = mContainer->scale();
+    const qreal scale = qBound(0.01, oldScale * std::pow(1.2, event->angleDelta().y() / 120.0), 64.0);
+    const QPointF mousePos = event->position();
+    const QPointF mapPos = (mousePos - mContainer->position()) / oldScale;
+
+    setView(mousePos - mapPos * scale, scale);
+}
+
+void QuickMapViewer::resizeEvent(QResizeEvent *event)
+{
+    QQuickView::resizeEvent(event);
+    setView(mContainer->position(), mContainer->scale());
+}
+
+/**
+ * Moves and scales the map, and updates the area for which the map item
+ * creates nodes.
+ */
+void QuickMapViewer::setView(QPointF position, qreal scale)
+{
+    mContainer->setPosition(position);
+    mContainer->setScale(scale);
+
+    mMapItem->setVisibleArea(QRectF(-position.x() / scale,
+                                    -position.y() / scale,
+                                    width() / scale,
+                                    height() / scale));
+}
+
+void QuickMapViewer::centerOn(QPointF center, qreal scale)
+{
+    const QPointF viewCenter(width() / 2.0, height() / 2.0);
+    setView(viewCenter - center * scale, scale);
+}
@@ -0,0 +1,82 @@
+/*
+ * quickmapviewer.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of the TMX Viewer example.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "benchmark.h"
+
+#include <QElapsedTimer>
+#include <QQuickView>
+
+#include <memory>
+
+namespace Tiled {
+class Map;
+}
+
+namespace TiledQuick {
+class MapItem;
+}
+
+/**
+ * Displays the tile layers of a map using the scene graph based MapItem from
+ * libtiledquick, which only creates nodes for the visible chunks.
+ */
+class QuickMapViewer : public QQuickView
+{
+    Q_OBJECT
+
+public:
+    explicit QuickMapViewer(QWindow *parent = nullptr);
+    ~QuickMapViewer() override;
+
+    bool viewMap(const QString &fileName);
+
+    void runBenchmark();
+
+protected:
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    void setView(QPointF position, qreal scale);
+    void centerOn(QPointF center, qreal scale);
+    void benchmarkFrameSwapped();
+
+    std::unique_ptr<Tiled::Map> mMap;
+    QQuickItem *mContainer;
+    TiledQuick::MapItem *mMapItem;
+
+    QPointF mLastMousePos;
+
+    QVector<Benchmark::Step> mBenchmarkSteps;
+    QVector<qint64> mFrameTimes;
+    QElapsedTimer mFrameTimer;
+};
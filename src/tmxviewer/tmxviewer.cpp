@@ -28,6 +28,7 @@
 
 #include "tmxviewer.h"
 
+#include "benchmark.h"
 #include "map.h"
 #include "mapformat.h"
 #include "mapobject.h"
@@ -38,6 +39,7 @@
 
 #include <QCoreApplication>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QGraphicsItem>
 #include <QGraphicsScene>
 #include <QStyleOptionGraphicsItem>
@@ -207,3 +209,31 @@ bool TmxViewer::viewMap(const QString &fileName)
 
     return true;
 }
+
+/**
+ * Runs the scripted pan and zoom sequence, repainting the view for each
+ * step, and prints the time taken by the repaints.
+ */
+void TmxViewer::runBenchmark()
+{
+    if (!mRenderer)
+        return;
+
+    const auto steps = Benchmark::steps(mRenderer->mapBoundingRect(), viewport()->size());
+
+    QVector<qint64> frameTimes;
+    frameTimes.reserve(steps.size());
+
+    QElapsedTimer timer;
+
+    for (const Benchmark::Step &step : steps) {
+        setTransform(QTransform::fromScale(step.scale, step.scale));
+        centerOn(step.center);
+
+        timer.start();
+        viewport()->repaint();
+        frameTimes.append(timer.nsecsElapsed());
+    }
+
+    Benchmark::printStatistics(frameTimes);
+}
@@ -47,6 +47,8 @@ public:
 
     bool viewMap(const QString &fileName);
 
+    void runBenchmark();
+
 private:
     QGraphicsScene *mScene;
     std::unique_ptr<Tiled::Map> mMap;
@@ -0,0 +1,202 @@
+#include "map.h"
+#include "mapreader.h"
+#include "mapwriter.h"
+#include "pluginmanager.h"
+#include "tilelayer.h"
+#include "tileset.h"
+#include "tmxmapformat.h"
+
+#include "batchoperation.h"
+
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_BatchOperation : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void findTileUses();
+    void replaceTileset();
+    void skipNonMaps();
+    void cancel();
+
+private:
+    QStringList writeMaps(int count);
+    QVector<BatchOperationResult> run(std::shared_ptr<const BatchOperation> operation,
+                                      const QStringList &fileNames);
+
+    TmxMapFormat mFormat;
+    QTemporaryDir mDir;
+    QString mTilesetFileName;
+    QString mOtherTilesetFileName;
+};
+
+void test_BatchOperation::initTestCase()
+{
+    QVERIFY(mDir.isValid());
+
+    PluginManager::addObject(&mFormat);
+
+    MapWriter writer;
+
+    mTilesetFileName = mDir.filePath(QStringLiteral("tileset.tsx"));
+    QVERIFY(writer.writeTileset(*Tileset::create(QStringLiteral("tileset"), 16, 16),
+                                mTilesetFileName));
+
+    mOtherTilesetFileName = mDir.filePath(QStringLiteral("other.tsx"));
+    QVERIFY(writer.writeTileset(*Tileset::create(QStringLiteral("other"), 16, 16),
+                                mOtherTilesetFileName));
+}
+
+void test_BatchOperation::cleanupTestCase()
+{
+    PluginManager::removeObject(&mFormat);
+}
+
+/**
+ * Writes \a count maps, each using tile 0 of the tileset on a number of
+ * cells equal to its index + 1.
+ */
+QStringList test_BatchOperation::writeMaps(int count)
+{
+    MapReader reader;
+    const SharedTileset tileset = reader.readTileset(mTilesetFileName);
+    if (!tileset)
+        return {};
+
+    Map::Parameters parameters;
+    parameters.width = 10;
+    parameters.height = 10;
+    parameters.tileWidth = 16;
+    parameters.tileHeight = 16;
+
+    QStringList fileNames;
+    MapWriter writer;
+
+    for (int i = 0; i < count; ++i) {
+        Map map(parameters);
+        map.addTileset(tileset);
+
+        auto tileLayer = new TileLayer(QStringLiteral("Tiles"), 0, 0, 10, 10);
+        for (int x = 0; x <= i; ++x)
+            tileLayer->setCell(x % 10, x / 10, Cell(tileset.data(), 0));
+        map.addLayer(tileLayer);
+
+        const QString fileName = mDir.filePath(QStringLiteral("map%1.tmx").arg(i));
+        if (!writer.writeMap(&map, fileName))
+            return {};
+
+        fileNames.append(fileName);
+    }
+
+    return fileNames;
+}
+
+QVector<BatchOperationResult> test_BatchOperation::run(std::shared_ptr<const BatchOperation> operation,
+                                                       const QStringList &fileNames)
+{
+    BatchOperationRunner runner(std::move(operation));
+    QSignalSpy finishedSpy(&runner, &BatchOperationRunner::finished);
+
+    runner.start(fileNames);
+    if (runner.isRunning())
+        finishedSpy.wait(10000);
+
+    return runner.results();
+}
+
+void test_BatchOperation::findTileUses()
+{
+    const QStringList fileNames = writeMaps(5);
+    QCOMPARE(fileNames.size(), 5);
+
+    const auto results = run(std::make_shared<FindTileUsesOperation>(mTilesetFileName),
+                             fileNames);
+    QCOMPARE(results.size(), fileNames.size());
+
+    for (const BatchOperationResult &result : results) {
+        QCOMPARE(result.status, BatchOperationResult::Done);
+        QVERIFY(!result.saved);
+
+        const int index = fileNames.indexOf(result.fileName);
+        QVERIFY(index != -1);
+        QCOMPARE(result.changes, index + 1);
+    }
+}
+
+/**
+ * Replaces the tileset in more maps than are processed at once, which makes
+ * sure the writes don't interfere with each other.
+ */
+void test_BatchOperation::replaceTileset()
+{
+    const QStringList fileNames = writeMaps(QThread::idealThreadCount() * 4);
+    QVERIFY(!fileNames.isEmpty());
+
+    MapReader reader;
+    const SharedTileset otherTileset = reader.readTileset(mOtherTilesetFileName);
+    QVERIFY(otherTileset);
+
+    const auto results = run(std::make_shared<ReplaceTilesetOperation>(mTilesetFileName,
+                                                                       otherTileset),
+                             fileNames);
+    QCOMPARE(results.size(), fileNames.size());
+
+    for (const BatchOperationResult &result : results) {
+        QCOMPARE(result.status, BatchOperationResult::Done);
+        QCOMPARE(result.changes, 1);
+        QVERIFY2(result.saved, qPrintable(result.message));
+
+        const auto map = reader.readMap(result.fileName);
+        QVERIFY(map);
+        QCOMPARE(map->tilesetCount(), 1);
+        QCOMPARE(QFileInfo(map->tilesetAt(0)->fileName()),
+                 QFileInfo(mOtherTilesetFileName));
+    }
+
+    // Nothing left to replace
+    for (const BatchOperationResult &result : run(std::make_shared<ReplaceTilesetOperation>(mTilesetFileName,
+                                                                                            otherTileset),
+                                                  fileNames)) {
+        QCOMPARE(result.status, BatchOperationResult::Done);
+        QCOMPARE(result.changes, 0);
+        QVERIFY(!result.saved);
+    }
+}
+
+void test_BatchOperation::skipNonMaps()
+{
+    const QStringList fileNames { mTilesetFileName, mDir.filePath(QStringLiteral("missing.txt")) };
+
+    const auto results = run(std::make_shared<FindTileUsesOperation>(mTilesetFileName),
+                             fileNames);
+    QVERIFY(results.isEmpty());
+}
+
+void test_BatchOperation::cancel()
+{
+    const QStringList fileNames = writeMaps(QThread::idealThreadCount() * 4);
+    QVERIFY(!fileNames.isEmpty());
+
+    BatchOperationRunner runner(std::make_shared<FindTileUsesOperation>(mTilesetFileName));
+    QSignalSpy finishedSpy(&runner, &BatchOperationRunner::finished);
+
+    runner.start(fileNames);
+    runner.cancel();
+
+    if (runner.isRunning())
+        QVERIFY(finishedSpy.wait(10000));
+
+    QCOMPARE(finishedSpy.count(), 1);
+    QVERIFY(runner.results().size() < fileNames.size());
+}
+
+QTEST_MAIN(test_BatchOperation)
+#include "test_batchoperation.moc"
@@ -0,0 +1,563 @@
+#include "compression.h"
+#include "gidmapper.h"
+#include "map.h"
+#include "mapreader.h"
+#include "maprenderer.h"
+#include "maptovariantconverter.h"
+#include "mapwriter.h"
+#include "tilelayer.h"
+#include "tileset.h"
+#include "varianttomapconverter.h"
+#include "wangset.h"
+
+#include "automapper.h"
+#include "mapdocument.h"
+#include "wangfiller.h"
+
+#include <QBuffer>
+#include <QImage>
+#include <QJsonDocument>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+/**
+ * Benchmarks for the operations that tend to dominate the time spent on
+ * loading, saving, rendering and editing large maps.
+ *
+ * The large maps are generated on the fly with a fixed seed, based on the
+ * fixtures of the other tests, so that the results are comparable between
+ * runs. Use "-iterations" or "-minimumvalue" to get more stable numbers.
+ */
+class test_Benchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void writeMap_data();
+    void writeMap();
+
+    void readMap_data();
+    void readMap();
+
+    void gidMapperEncode_data();
+    void gidMapperEncode();
+
+    void gidMapperDecode_data();
+    void gidMapperDecode();
+
+    void tileLayerRegion();
+    void tileLayerComputeDiffRegion();
+    void tileLayerMerge();
+
+    void drawTileLayer_data();
+    void drawTileLayer();
+
+    void cellTile_data();
+    void cellTile();
+
+    void autoMap_data();
+    void autoMap();
+
+    void wangFill();
+    void wangPaint();
+
+private:
+    std::unique_ptr<Map> createMap(Map::Orientation orientation,
+                                   int size,
+                                   bool infinite = false) const;
+    void fillTileLayer(TileLayer &tileLayer, quint32 seed, int density) const;
+
+    static void addBase64FormatRows();
+    static std::unique_ptr<Map> scaledMap(const Map &map, int factor);
+
+    SharedTileset mTileset;
+};
+
+static const int largeMapSize = 512;
+
+void test_Benchmarks::initTestCase()
+{
+    mTileset = MapReader().readTileset(QStringLiteral("../automapping/spr_test_tileset.tsx"));
+    QVERIFY(mTileset);
+    QVERIFY(mTileset->tileCount() > 0);
+}
+
+/**
+ * Fills the \a tileLayer with random tiles, leaving about (100 - \a density)
+ * percent of the cells empty.
+ */
+void test_Benchmarks::fillTileLayer(TileLayer &tileLayer, quint32 seed, int density) const
+{
+    QRandomGenerator random(seed);
+    const int tileCount = mTileset->tileCount();
+
+    for (int y = 0; y < tileLayer.height(); ++y) {
+        for (int x = 0; x < tileLayer.width(); ++x) {
+            if (static_cast<int>(random.bounded(100)) >= density)
+                continue;
+
+            Cell cell(mTileset.data(), static_cast<int>(random.bounded(tileCount)));
+            cell.setFlippedHorizontally(random.bounded(8) == 0);
+            tileLayer.setCell(x, y, cell);
+        }
+    }
+}
+
+std::unique_ptr<Map> test_Benchmarks::createMap(Map::Orientation orientation,
+                                                int size,
+                                                bool infinite) const
+{
+    Map::Parameters parameters;
+    parameters.orientation = orientation;
+    parameters.width = size;
+    parameters.height = size;
+    parameters.tileWidth = 16;
+    parameters.tileHeight = orientation == Map::Orthogonal ? 16 : 8;
+    parameters.infinite = infinite;
+
+    if (orientation == Map::Hexagonal) {
+        parameters.tileHeight = 14;
+        parameters.hexSideLength = 6;
+    }
+
+    auto map = std::make_unique<Map>(parameters);
+    map->addTileset(mTileset);
+
+    // A full ground layer and a sparse decoration layer
+    auto ground = std::make_unique<TileLayer>(QStringLiteral("Ground"), 0, 0, size, size);
+    auto decoration = std::make_unique<TileLayer>(QStringLiteral("Decoration"), 0, 0, size, size);
+    fillTileLayer(*ground, 1, 100);
+    fillTileLayer(*decoration, 2, 10);
+
+    map->addLayer(std::move(ground));
+    map->addLayer(std::move(decoration));
+
+    return map;
+}
+
+void test_Benchmarks::addBase64FormatRows()
+{
+    QTest::addColumn<Map::LayerDataFormat>("layerDataFormat");
+
+    QTest::newRow("base64") << Map::Base64;
+    QTest::newRow("base64-gzip") << Map::Base64Gzip;
+    QTest::newRow("base64-zlib") << Map::Base64Zlib;
+    if (compressionSupported(Zstandard))
+        QTest::newRow("base64-zstd") << Map::Base64Zstandard;
+}
+
+static QByteArray writeMap(const Map &map, bool json)
+{
+    if (json) {
+        MapToVariantConverter converter;
+        const QVariant variant = converter.toVariant(map, QDir::current());
+        return QJsonDocument::fromVariant(variant).toJson(QJsonDocument::Compact);
+    }
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    MapWriter().writeMap(&map, &buffer, QDir::currentPath());
+    return buffer.data();
+}
+
+static std::unique_ptr<Map> readMap(const QByteArray &data, bool json)
+{
+    if (json) {
+        VariantToMapConverter converter;
+        return converter.toMap(QJsonDocument::fromJson(data).toVariant(), QDir::current());
+    }
+
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    return MapReader().readMap(&buffer, QDir::currentPath());
+}
+
+void test_Benchmarks::writeMap_data()
+{
+    QTest::addColumn<bool>("json");
+    QTest::addColumn<bool>("infinite");
+    QTest::addColumn<Map::LayerDataFormat>("layerDataFormat");
+
+    const struct {
+        const char *name;
+        Map::LayerDataFormat format;
+        bool tmxOnly;
+    } formats[] = {
+        { "xml", Map::XML, true },
+        { "csv", Map::CSV, false },
+        { "base64", Map::Base64, false },
+        { "base64-gzip", Map::Base64Gzip, false },
+        { "base64-zlib", Map::Base64Zlib, false },
+        { "base64-zstd", Map::Base64Zstandard, false },
+        { "base64-zstd-dict", Map::Base64ZstandardDictionary, false },
+    };
+
+    for (const bool json : { false, true }) {
+        for (const bool infinite : { false, true }) {
+            for (const auto &format : formats) {
+                if (json && format.tmxOnly)
+                    continue;
+                if ((format.format == Map::Base64Zstandard ||
+                     format.format == Map::Base64ZstandardDictionary) &&
+                        !compressionSupported(Zstandard))
+                    continue;
+
+                QTest::addRow("%s-%s-%s",
+                              json ? "json" : "tmx",
+                              infinite ? "infinite" : "fixed",
+                              format.name) << json << infinite << format.format;
+            }
+        }
+    }
+}
+
+void test_Benchmarks::writeMap()
+{
+    QFETCH(bool, json);
+    QFETCH(bool, infinite);
+    QFETCH(Map::LayerDataFormat, layerDataFormat);
+
+    auto map = createMap(Map::Orthogonal, largeMapSize, infinite);
+    map->setLayerDataFormat(layerDataFormat);
+
+    QByteArray data;
+    QBENCHMARK {
+        data = ::writeMap(*map, json);
+    }
+    QVERIFY(!data.isEmpty());
+}
+
+void test_Benchmarks::readMap_data()
+{
+    writeMap_data();
+}
+
+void test_Benchmarks::readMap()
+{
+    QFETCH(bool, json);
+    QFETCH(bool, infinite);
+    QFETCH(Map::LayerDataFormat, layerDataFormat);
+
+    auto map = createMap(Map::Orthogonal, largeMapSize, infinite);
+    map->setLayerDataFormat(layerDataFormat);
+
+    const QByteArray data = ::writeMap(*map, json);
+
+    std::unique_ptr<Map> result;
+    QBENCHMARK {
+        result = ::readMap(data, json);
+    }
+
+    QVERIFY(result);
+    QCOMPARE(result->layerCount(), map->layerCount());
+
+    const auto expectedLayer = map->layerAt(0)->asTileLayer();
+    const auto resultLayer = result->layerAt(0)->asTileLayer();
+    QVERIFY(resultLayer);
+    QCOMPARE(resultLayer->region(), expectedLayer->region());
+}
+
+void test_Benchmarks::gidMapperEncode_data()
+{
+    addBase64FormatRows();
+}
+
+void test_Benchmarks::gidMapperEncode()
+{
+    QFETCH(Map::LayerDataFormat, layerDataFormat);
+
+    const auto map = createMap(Map::Orthogonal, largeMapSize);
+    const auto tileLayer = map->layerAt(0)->asTileLayer();
+    const GidMapper gidMapper(map->tilesets());
+
+    QByteArray data;
+    QBENCHMARK {
+        data = gidMapper.encodeLayerData(*tileLayer, layerDataFormat);
+    }
+    QVERIFY(!data.isEmpty());
+}
+
+void test_Benchmarks::gidMapperDecode_data()
+{
+    addBase64FormatRows();
+}
+
+void test_Benchmarks::gidMapperDecode()
+{
+    QFETCH(Map::LayerDataFormat, layerDataFormat);
+
+    const auto map = createMap(Map::Orthogonal, largeMapSize);
+    const auto tileLayer = map->layerAt(0)->asTileLayer();
+    const GidMapper gidMapper(map->tilesets());
+    const QByteArray data = gidMapper.encodeLayerData(*tileLayer, layerDataFormat);
+    const QRect bounds = tileLayer->rect();
+
+    QBENCHMARK {
+        TileLayer result(QString(), 0, 0, largeMapSize, largeMapSize);
+        const auto error = gidMapper.decodeLayerData(result, data, layerDataFormat, bounds);
+        QCOMPARE(error, GidMapper::NoError);
+    }
+}
+
+void test_Benchmarks::tileLayerRegion()
+{
+    const auto map = createMap(Map::Orthogonal, largeMapSize);
+    const auto decoration = map->layerAt(1)->asTileLayer();
+
+    QRegion region;
+    QBENCHMARK {
+        region = decoration->region();
+    }
+    QVERIFY(!region.isEmpty());
+}
+
+void test_Benchmarks::tileLayerComputeDiffRegion()
+{
+    const auto map = createMap(Map::Orthogonal, largeMapSize);
+    const auto ground = map->layerAt(0)->asTileLayer();
+
+    // Change a few scattered cells, like a paint operation would
+    std::unique_ptr<TileLayer> changed { ground->clone() };
+    QRandomGenerator random(3);
+    for (int i = 0; i < 1000; ++i) {
+        const int x = static_cast<int>(random.bounded(largeMapSize));
+        const int y = static_cast<int>(random.bounded(largeMapSize));
+        changed->setCell(x, y, Cell());
+    }
+
+    QRegion diff;
+    QBENCHMARK {
+        diff = ground->computeDiffRegion(*changed);
+    }
+    QVERIFY(!diff.isEmpty());
+}
+
+void test_Benchmarks::tileLayerMerge()
+{
+    const auto map = createMap(Map::Orthogonal, largeMapSize);
+    const auto ground = map->layerAt(0)->asTileLayer();
+    const auto decoration = map->layerAt(1)->asTileLayer();
+
+    QBENCHMARK {
+        std::unique_ptr<TileLayer> target { ground->clone() };
+        target->merge(QPoint(), decoration);
+    }
+}
+
+void test_Benchmarks::drawTileLayer_data()
+{
+    QTest::addColumn<Map::Orientation>("orientation");
+    QTest::addColumn<bool>("infinite");
+
+    QTest::newRow("orthogonal") << Map::Orthogonal << false;
+    QTest::newRow("isometric") << Map::Isometric << false;
+    QTest::newRow("isometric-infinite") << Map::Isometric << true;
+    QTest::newRow("staggered") << Map::Staggered << false;
+    QTest::newRow("hexagonal") << Map::Hexagonal << false;
+}
+
+void test_Benchmarks::drawTileLayer()
+{
+    QFETCH(Map::Orientation, orientation);
+    QFETCH(bool, infinite);
+
+    const auto map = createMap(orientation, 256, infinite);
+    const auto renderer = MapRenderer::create(map.get());
+
+    const QRect exposed(0, 0, 1920, 1080);
+    QImage image(exposed.size(), QImage::Format_ARGB32_Premultiplied);
+
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        for (const Layer *layer : map->tileLayers())
+            renderer->drawTileLayer(&painter, static_cast<const TileLayer*>(layer), exposed);
+    }
+}
+
+void test_Benchmarks::cellTile_data()
+{
+    QTest::addColumn<bool>("sparse");
+
+    QTest::newRow("dense") << false;
+    QTest::newRow("sparse") << true;
+}
+
+/**
+ * Looks up the tile of each cell, like the render loop does. The sparse
+ * tileset spreads the tile IDs apart, like an image collection from which
+ * many tiles were removed, so it falls back to looking up the tiles by ID.
+ */
+void test_Benchmarks::cellTile()
+{
+    QFETCH(bool, sparse);
+
+    const int spread = sparse ? 16 : 1;
+    const SharedTileset tileset = Tileset::create(QStringLiteral("tiles"), 16, 16);
+    for (int i = 0; i < 1000; ++i)
+        tileset->findOrCreateTile(i * spread);
+
+    TileLayer tileLayer(QString(), 0, 0, largeMapSize, largeMapSize);
+    QRandomGenerator random(1);
+    for (int y = 0; y < tileLayer.height(); ++y)
+        for (int x = 0; x < tileLayer.width(); ++x)
+            tileLayer.setCell(x, y, Cell(tileset.data(), static_cast<int>(random.bounded(1000)) * spread));
+
+    int found = 0;
+
+    QBENCHMARK {
+        for (const Cell &cell : tileLayer)
+            found += cell.tile() != nullptr;
+    }
+
+    QVERIFY(found > 0);
+}
+
+/**
+ * Returns a copy of the given \a map with its tile layers repeated
+ * \a factor times in both directions.
+ */
+std::unique_ptr<Map> test_Benchmarks::scaledMap(const Map &map, int factor)
+{
+    auto scaled = map.clone();
+    scaled->setWidth(map.width() * factor);
+    scaled->setHeight(map.height() * factor);
+
+    for (Layer *layer : scaled->tileLayers()) {
+        auto tileLayer = static_cast<TileLayer*>(layer);
+        const std::unique_ptr<TileLayer> original { tileLayer->clone() };
+        const QSize size = original->size();
+
+        tileLayer->resize(size * factor, QPoint());
+
+        for (int y = 0; y < factor; ++y)
+            for (int x = 0; x < factor; ++x)
+                tileLayer->merge(QPoint(x * size.width(), y * size.height()), original.get());
+    }
+
+    return scaled;
+}
+
+void test_Benchmarks::autoMap_data()
+{
+    QTest::addColumn<QString>("directory");
+
+    QTest::newRow("simple-replace") << QStringLiteral("simple-replace");
+    QTest::newRow("simple-2x2-rule") << QStringLiteral("simple-2x2-rule");
+    QTest::newRow("mod-and-offset") << QStringLiteral("mod-and-offset");
+    QTest::newRow("terrain-corner") << QStringLiteral("terrain-corner");
+}
+
+void test_Benchmarks::autoMap()
+{
+    QFETCH(QString, directory);
+
+    const QString path = QStringLiteral("../automapping/") + directory;
+
+    MapReader reader;
+    auto inputMap = reader.readMap(path + QStringLiteral("/map.tmx"));
+    auto rulesMap = reader.readMap(path + QStringLiteral("/rules.tmx"));
+
+    QVERIFY(inputMap.get());
+    QVERIFY(rulesMap.get());
+
+    // Scale up the small fixture so that it resembles a real map
+    const int factor = qMax(1, 256 / qMax(inputMap->width(), inputMap->height()));
+
+    MapDocument mapDocument(scaledMap(*inputMap, factor));
+    AutoMapper autoMapper(std::move(rulesMap));
+
+    const QRegion region(QRect(QPoint(), mapDocument.map()->size()));
+
+    QBENCHMARK {
+        AutoMappingContext context(&mapDocument);
+        autoMapper.prepareAutoMap(context);
+        autoMapper.autoMap(region, nullptr, context);
+    }
+}
+
+void test_Benchmarks::wangFill()
+{
+    const SharedTileset tileset = MapReader().readTileset(QStringLiteral("../wangtiles/grassAndWater.tsx"));
+    QVERIFY(tileset);
+    QVERIFY(tileset->wangSetCount() > 0);
+
+    const WangSet &wangSet = *tileset->wangSet(0);
+
+    Map::Parameters parameters;
+    parameters.width = 128;
+    parameters.height = 128;
+    parameters.tileWidth = tileset->tileWidth();
+    parameters.tileHeight = tileset->tileHeight();
+    Map map(parameters);
+    map.addTileset(tileset);
+
+    const auto renderer = MapRenderer::create(&map);
+    const TileLayer back(QString(), 0, 0, map.width(), map.height());
+    const QRegion region(QRect(QPoint(), map.size()));
+
+    QBENCHMARK {
+        TileLayer target(QString(), 0, 0, map.width(), map.height());
+        WangFiller filler(wangSet, back, renderer.get());
+        filler.setRandomSeed(1);
+        filler.setRegion(region);
+        filler.apply(target);
+    }
+}
+
+void test_Benchmarks::wangPaint()
+{
+    const SharedTileset tileset = MapReader().readTileset(QStringLiteral("../wangtiles/grassAndWater.tsx"));
+    QVERIFY(tileset);
+    QVERIFY(tileset->wangSetCount() > 0);
+
+    const WangSet &wangSet = *tileset->wangSet(0);
+    QVERIFY(wangSet.colorCount() >= 2);
+
+    Map::Parameters parameters;
+    parameters.width = 128;
+    parameters.height = 128;
+    parameters.tileWidth = tileset->tileWidth();
+    parameters.tileHeight = tileset->tileHeight();
+    Map map(parameters);
+    map.addTileset(tileset);
+
+    const auto renderer = MapRenderer::create(&map);
+    const QRect rect(QPoint(), map.size());
+
+    // Start from a map filled with the first color
+    TileLayer back(QString(), 0, 0, map.width(), map.height());
+    {
+        WangFiller filler(wangSet, back, renderer.get());
+        filler.setRandomSeed(1);
+        filler.setRegion(rect);
+        filler.apply(back);
+    }
+
+    // Paint blobs of the second color, like dragging the Terrain Brush would
+    QRandomGenerator random(4);
+    QVector<QPoint> vertices;
+    for (int i = 0; i < 2000; ++i) {
+        vertices.append(QPoint(1 + static_cast<int>(random.bounded(map.width() - 1)),
+                               1 + static_cast<int>(random.bounded(map.height() - 1))));
+    }
+
+    QBENCHMARK {
+        TileLayer target(QString(), 0, 0, map.width(), map.height());
+        WangFiller filler(wangSet, back, renderer.get());
+        filler.setRandomSeed(1);
+        filler.setCorrectionsEnabled(true);
+        for (const QPoint &vertex : std::as_const(vertices))
+            filler.setCorner(vertex, 2);
+        filler.apply(target);
+    }
+}
+
+QTEST_MAIN(test_Benchmarks)
+#include "test_benchmarks.moc"
@@ -1,9 +1,16 @@
+#include "base64.h"
+#include "compression.h"
+#include "jsonmapreader.h"
 #include "map.h"
 #include "mapobject.h"
+#include "maptovariantconverter.h"
 #include "objectgroup.h"
 #include "tilelayer.h"
 #include "mapreader.h"
+#include "mapwriter.h"
+#include "varianttomapconverter.h"
 
+#include <QJsonDocument>
 #include <QtTest/QtTest>
 
 using namespace Tiled;
@@ -14,6 +21,13 @@ class test_MapReader : public QObject
 
 private slots:
     void loadMap();
+    void roundTrip_data();
+    void roundTrip();
+    void jsonMapReader_data();
+    void jsonMapReader();
+    void layerDictionary_data();
+    void layerDictionary();
+    void base64();
 };
 
 void test_MapReader::loadMap()
@@ -53,5 +67,204 @@ void test_MapReader::loadMap()
     QCOMPARE(mapObject->height(), qreal(64));
 }
 
+void test_MapReader::roundTrip_data()
+{
+    QTest::addColumn<QString>("fileName");
+
+    QDirIterator it(QStringLiteral("../../examples"), { QStringLiteral("*.tmx") },
+                    QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString fileName = it.next();
+        QTest::newRow(qUtf8Printable(fileName)) << fileName;
+    }
+}
+
+/*
+ * Checks that the reader reads back everything the writer writes, by
+ * comparing the output of writing a map before and after reading it back.
+ */
+void test_MapReader::roundTrip()
+{
+    QFETCH(QString, fileName);
+
+    const QString path = QFileInfo(fileName).absolutePath();
+
+    MapReader reader;
+    const auto map = reader.readMap(fileName);
+    QVERIFY2(map, qUtf8Printable(reader.errorString()));
+
+    MapWriter writer;
+    QBuffer written;
+    written.open(QIODevice::WriteOnly);
+    writer.writeMap(map.get(), &written, path);
+
+    QBuffer readBack(&written.buffer());
+    readBack.open(QIODevice::ReadOnly);
+    const auto mapReadBack = reader.readMap(&readBack, path);
+    QVERIFY2(mapReadBack, qUtf8Printable(reader.errorString()));
+
+    QBuffer writtenAgain;
+    writtenAgain.open(QIODevice::WriteOnly);
+    writer.writeMap(mapReadBack.get(), &writtenAgain, path);
+
+    QCOMPARE(writtenAgain.data(), written.data());
+}
+
+void test_MapReader::jsonMapReader_data()
+{
+    roundTrip_data();
+}
+
+static QByteArray writeTmx(const Map &map, const QString &path)
+{
+    MapWriter writer;
+    QBuffer written;
+    written.open(QIODevice::WriteOnly);
+    writer.writeMap(&map, &written, path);
+    return written.data();
+}
+
+/*
+ * Checks that the streaming JSON map reader reads the same map as the
+ * VariantToMapConverter does from a QJsonDocument.
+ */
+void test_MapReader::jsonMapReader()
+{
+    QFETCH(QString, fileName);
+
+    const QString path = QFileInfo(fileName).absolutePath();
+    const QDir dir(path);
+
+    MapReader reader;
+    const auto map = reader.readMap(fileName);
+    QVERIFY2(map, qUtf8Printable(reader.errorString()));
+
+    MapToVariantConverter toVariantConverter;
+    const QByteArray json = QJsonDocument::fromVariant(toVariantConverter.toVariant(*map, dir)).toJson();
+
+    VariantToMapConverter converter;
+    const auto expected = converter.toMap(QJsonDocument::fromJson(json).toVariant(), dir);
+    QVERIFY2(expected, qUtf8Printable(converter.errorString()));
+
+    JsonMapReader jsonReader;
+    const auto actual = jsonReader.readMap(json, dir);
+    QVERIFY2(actual, qUtf8Printable(jsonReader.errorString()));
+
+    QCOMPARE(writeTmx(*actual, path), writeTmx(*expected, path));
+
+    // A leading UTF-8 byte order mark is skipped
+    const auto withBom = jsonReader.readMap("\xef\xbb\xbf" + json, dir);
+    QVERIFY2(withBom, qUtf8Printable(jsonReader.errorString()));
+    QCOMPARE(writeTmx(*withBom, path), writeTmx(*expected, path));
+
+    QVERIFY(!jsonReader.readMap(json.left(json.size() / 2), dir));
+    QVERIFY(jsonReader.errorString().contains(QLatin1String("offset")));
+}
+
+void test_MapReader::layerDictionary_data()
+{
+    QTest::addColumn<bool>("infinite");
+
+    QTest::newRow("fixed") << false;
+    QTest::newRow("infinite") << true;
+}
+
+/*
+ * Checks that delta filtered layer data compressed with a shared dictionary
+ * is read back correctly. Only the infinite map has enough chunks for the
+ * dictionary to be written.
+ */
+void test_MapReader::layerDictionary()
+{
+    if (!compressionSupported(Zstandard))
+        QSKIP("Zstandard compression not supported");
+
+    QFETCH(bool, infinite);
+
+    Map::Parameters parameters;
+    parameters.width = 256;
+    parameters.height = 256;
+    parameters.tileWidth = 16;
+    parameters.tileHeight = 16;
+    parameters.infinite = infinite;
+
+    Map map(parameters);
+    map.setLayerDataFormat(Map::Base64ZstandardDictionary);
+
+    const SharedTileset tileset = Tileset::create(QStringLiteral("Tiles"), 16, 16);
+    map.addTileset(tileset);
+
+    auto tileLayer = std::make_unique<TileLayer>(QStringLiteral("Ground"), 0, 0, 256, 256);
+    for (int y = 0; y < 256; ++y) {
+        for (int x = 0; x < 256; ++x) {
+            Cell cell(tileset.data(), (x / 4 + y / 4) % 40);
+            cell.setFlippedHorizontally((x * y) % 7 == 0);
+            tileLayer->setCell(x, y, cell);
+        }
+    }
+    map.addLayer(std::move(tileLayer));
+
+    MapWriter writer;
+    QBuffer written;
+    written.open(QIODevice::WriteOnly);
+    writer.writeMap(&map, &written, QString());
+
+    QCOMPARE(written.data().contains("<layerdictionary"), infinite);
+
+    QBuffer readBack(&written.buffer());
+    readBack.open(QIODevice::ReadOnly);
+
+    MapReader reader;
+    const auto mapReadBack = reader.readMap(&readBack, QString());
+    QVERIFY2(mapReadBack, qUtf8Printable(reader.errorString()));
+    QCOMPARE(mapReadBack->layerDataFormat(), Map::Base64ZstandardDictionary);
+
+    const TileLayer *original = map.layerAt(0)->asTileLayer();
+    const TileLayer *tileLayerReadBack = mapReadBack->layerAt(0)->asTileLayer();
+    QVERIFY(tileLayerReadBack);
+
+    for (int y = 0; y < 256; ++y) {
+        for (int x = 0; x < 256; ++x) {
+            const Cell expected = original->cellAt(x, y);
+            const Cell cell = tileLayerReadBack->cellAt(x, y);
+            QCOMPARE(cell.tileId(), expected.tileId());
+            QCOMPARE(cell.flippedHorizontally(), expected.flippedHorizontally());
+        }
+    }
+}
+
+void test_MapReader::base64()
+{
+    for (int size = 0; size < 64; ++size) {
+        QByteArray data(size, Qt::Uninitialized);
+        for (int i = 0; i < size; ++i)
+            data[i] = static_cast<char>(i * 37 + size);
+
+        const QByteArray encoded = Base64::encode(data);
+        QCOMPARE(encoded, data.toBase64());
+
+        // Decode with whitespace inserted and in parts of different sizes
+        QString text;
+        for (int i = 0; i < encoded.size(); ++i) {
+            text.append(QLatin1Char(encoded.at(i)));
+            if (i % 5 == 4)
+                text.append(QLatin1String("\n  "));
+        }
+
+        Base64::Decoder decoder;
+        QByteArray decoded;
+        QByteArray part;
+        for (int i = 0; i < text.size(); i += 3) {
+            const QStringView slice = QStringView(text).mid(i, 3);
+            decoder.decode(reinterpret_cast<const char16_t*>(slice.utf16()), slice.size(), part);
+            decoded.append(part);
+        }
+        decoder.finish(part);
+        decoded.append(part);
+
+        QCOMPARE(decoded, data);
+    }
+}
+
 QTEST_MAIN(test_MapReader)
 #include "test_mapreader.moc"
@@ -0,0 +1,504 @@
+#include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "maprenderer.h"
+#include "minimaprenderer.h"
+#include "mipmapcache.h"
+#include "objectgroup.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <limits>
+
+using namespace Tiled;
+
+class test_MapRenderer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void drawTileLayerKeepsOrder_data();
+    void drawTileLayerKeepsOrder();
+
+    void drawTileLayerSkipsEmptyChunks();
+
+    void renderToImageParallel_data();
+    void renderToImageParallel();
+
+    void renderToPng();
+
+    void mipmapKeepsTilesApart();
+    void drawImageLayerZoomedOut();
+
+    void drawTileLayerColors();
+
+    void tileSelectionOutline();
+
+    void objectsInDrawOrder_data();
+    void objectsInDrawOrder();
+
+    void simplifiedPolygon();
+
+private:
+    std::unique_ptr<Map> createMap(Map::Orientation orientation,
+                                   Map::StaggerAxis staggerAxis,
+                                   int size) const;
+
+    SharedTileset mTileset;
+};
+
+void test_MapRenderer::initTestCase()
+{
+    // Translucent tiles of different colors that are taller than the grid,
+    // so that the result depends on the order in which they are drawn
+    QImage tilesetImage(256, 128, QImage::Format_ARGB32);
+    tilesetImage.fill(Qt::transparent);
+    {
+        QPainter painter(&tilesetImage);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        for (int y = 0; y < 4; ++y)
+            for (int x = 0; x < 8; ++x)
+                painter.fillRect(x * 32, y * 32, 32, 32,
+                                 QColor(x * 32, y * 64, 128, 160));
+    }
+
+    mTileset = Tileset::create(QStringLiteral("tileset"), 32, 32);
+    QVERIFY(mTileset->loadFromImage(tilesetImage, QStringLiteral("tileset.png")));
+}
+
+std::unique_ptr<Map> test_MapRenderer::createMap(Map::Orientation orientation,
+                                                 Map::StaggerAxis staggerAxis,
+                                                 int size) const
+{
+    Map::Parameters parameters;
+    parameters.orientation = orientation;
+    parameters.width = size;
+    parameters.height = size;
+    parameters.tileWidth = 32;
+    parameters.tileHeight = orientation == Map::Hexagonal ? 28 : 16;
+    parameters.hexSideLength = orientation == Map::Hexagonal ? 12 : 0;
+    parameters.staggerAxis = staggerAxis;
+
+    auto map = std::make_unique<Map>(parameters);
+    map->addTileset(mTileset);
+
+    auto tileLayer = new TileLayer(QString(), 0, 0, size, size);
+    for (int y = 0; y < size; ++y)
+        for (int x = 0; x < size; ++x)
+            tileLayer->setCell(x, y, Cell(mTileset->findTile((x * 7 + y * 3) % 32)));
+    map->addLayer(tileLayer);
+
+    return map;
+}
+
+void test_MapRenderer::drawTileLayerKeepsOrder_data()
+{
+    QTest::addColumn<Map::Orientation>("orientation");
+    QTest::addColumn<Map::StaggerAxis>("staggerAxis");
+
+    QTest::newRow("orthogonal") << Map::Orthogonal << Map::StaggerY;
+    QTest::newRow("isometric") << Map::Isometric << Map::StaggerY;
+    QTest::newRow("staggered") << Map::Staggered << Map::StaggerY;
+    QTest::newRow("hexagonal-x") << Map::Hexagonal << Map::StaggerX;
+    QTest::newRow("hexagonal-y") << Map::Hexagonal << Map::StaggerY;
+}
+
+/**
+ * Verifies that grouping the tiles by image doesn't change the result,
+ * compared to drawing each tile in order.
+ */
+void test_MapRenderer::drawTileLayerKeepsOrder()
+{
+    QFETCH(Map::Orientation, orientation);
+    QFETCH(Map::StaggerAxis, staggerAxis);
+
+    const auto map = createMap(orientation, staggerAxis, 16);
+    const auto renderer = MapRenderer::create(map.get());
+    const auto tileLayer = static_cast<TileLayer*>(map->layerAt(0));
+
+    const QRect bounds = renderer->mapBoundingRect().adjusted(0, -32, 0, 0);
+
+    QImage image(bounds.size(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    {
+        QPainter painter(&image);
+        painter.translate(-bounds.topLeft());
+        renderer->drawTileLayer(&painter, tileLayer);
+    }
+
+    QImage expected(bounds.size(), QImage::Format_ARGB32_Premultiplied);
+    expected.fill(Qt::transparent);
+    {
+        QPainter painter(&expected);
+        painter.translate(-bounds.topLeft());
+
+        CellRenderer cellRenderer(&painter, renderer.get(), QColor(), CellRenderer::KeepOrder);
+        renderer->drawTileLayer([&] (QPoint tilePos, const QPointF &screenPos) {
+            const Cell &cell = tileLayer->cellAt(tilePos);
+            if (!cell.isEmpty())
+                cellRenderer.render(cell, screenPos, cell.tile()->size(), CellRenderer::BottomLeft);
+        }, bounds);
+    }
+
+    QCOMPARE(image, expected);
+}
+
+/**
+ * Verifies that the isometric renderer skips the chunks that don't exist,
+ * without affecting the order in which the remaining tiles are visited.
+ */
+void test_MapRenderer::drawTileLayerSkipsEmptyChunks()
+{
+    Map::Parameters parameters;
+    parameters.orientation = Map::Isometric;
+    parameters.tileWidth = 32;
+    parameters.tileHeight = 16;
+    parameters.infinite = true;
+
+    Map map(parameters);
+    map.addTileset(mTileset);
+
+    TileLayer tileLayer;
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            const Cell cell(mTileset->findTile((x + y) % 32));
+            tileLayer.setCell(x - 40, y + 3, cell);
+            tileLayer.setCell(x + 50, y - 20, cell);
+        }
+    }
+
+    const auto renderer = MapRenderer::create(&map);
+    const QRect exposed = renderer->boundingRect(tileLayer.bounds());
+
+    QVector<QPoint> expected;
+    int visitedCount = 0;
+    renderer->drawTileLayer([&] (QPoint tilePos, const QPointF &) {
+        ++visitedCount;
+        if (!tileLayer.cellAt(tilePos).isEmpty())
+            expected.append(tilePos);
+    }, exposed);
+
+    QVector<QPoint> visited;
+    renderer->drawTileLayer([&] (QPoint tilePos, const QPointF &) {
+        visited.append(tilePos);
+    }, exposed, &tileLayer);
+
+    QVERIFY(visited.size() * 4 < visitedCount);
+
+    visited.erase(std::remove_if(visited.begin(), visited.end(), [&] (QPoint tilePos) {
+        return tileLayer.cellAt(tilePos).isEmpty();
+    }), visited.end());
+
+    QCOMPARE(visited, expected);
+    QCOMPARE(expected.size(), 2 * 8 * 8);
+}
+
+void test_MapRenderer::renderToImageParallel_data()
+{
+    drawTileLayerKeepsOrder_data();
+}
+
+/**
+ * Verifies that rendering the image in bands gives the same result as
+ * rendering it at once, and that the rendering can be canceled.
+ */
+void test_MapRenderer::renderToImageParallel()
+{
+    QFETCH(Map::Orientation, orientation);
+    QFETCH(Map::StaggerAxis, staggerAxis);
+
+    const auto map = createMap(orientation, staggerAxis, 16);
+    const MiniMapRenderer renderer(map.get());
+    const MiniMapRenderer::RenderFlags renderFlags(MiniMapRenderer::DrawTileLayers |
+                                                   MiniMapRenderer::DrawGrid);
+    const QSize size = renderer.mapSize() / 2;
+
+    const QImage expected = renderer.render(size, renderFlags);
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    int lastFinished = 0;
+    QVERIFY(renderer.renderToImageParallel(image, renderFlags, [&] (int finished, int total) {
+        lastFinished = finished;
+        return finished <= total;
+    }));
+    QVERIFY(lastFinished > 0);
+    QCOMPARE(image, expected);
+
+    int progressCalls = 0;
+    QVERIFY(!renderer.renderToImageParallel(image, renderFlags, [&] (int, int) {
+        ++progressCalls;
+        return false;
+    }));
+    QCOMPARE(progressCalls, 1);
+}
+
+/**
+ * Verifies that streaming the image to a PNG file gives the same result as
+ * rendering it at once.
+ */
+void test_MapRenderer::renderToPng()
+{
+    const auto map = createMap(Map::Isometric, Map::StaggerY, 16);
+    const MiniMapRenderer renderer(map.get());
+    const MiniMapRenderer::RenderFlags renderFlags(MiniMapRenderer::DrawTileLayers |
+                                                   MiniMapRenderer::DrawGrid);
+    const QSize size = renderer.mapSize();
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("map.png"));
+
+    QString error;
+    QVERIFY2(renderer.renderToPng(fileName, size, renderFlags, {}, &error), qUtf8Printable(error));
+
+    const QImage expected = renderer.render(size, renderFlags);
+    const QImage image(fileName);
+    QCOMPARE(image.convertToFormat(QImage::Format_ARGB32),
+             expected.convertToFormat(QImage::Format_ARGB32));
+}
+
+/**
+ * Verifies that the tiles are scaled down separately when creating mipmaps,
+ * so that neither neighboring tiles nor the spacing between them bleed in.
+ */
+void test_MapRenderer::mipmapKeepsTilesApart()
+{
+    QImage tilesetImage(68, 34, QImage::Format_ARGB32);
+    tilesetImage.fill(Qt::green);
+    {
+        QPainter painter(&tilesetImage);
+        painter.fillRect(1, 1, 32, 32, Qt::red);
+        painter.fillRect(35, 1, 32, 32, Qt::blue);
+    }
+
+    const SharedTileset tileset = Tileset::create(QStringLiteral("spaced"), 32, 32, 2, 1);
+    QVERIFY(tileset->loadFromImage(tilesetImage, QStringLiteral("spaced.png")));
+    QCOMPARE(tileset->tileCount(), 2);
+
+    QCOMPARE(MipmapCache::levelFor(tileset.data(), 1.0), 0);
+    QCOMPARE(MipmapCache::levelFor(tileset.data(), 0.5), 1);
+    QCOMPARE(MipmapCache::levelFor(tileset.data(), 0.2), 2);
+    QCOMPARE(MipmapCache::levelFor(tileset.data(), 0.01), int(MipmapCache::MaxLevel));
+
+    const QImage mipmap = MipmapCache::mipmap(tileset.data(), 2).toImage();
+    QCOMPARE(mipmap.size(), QSize(16, 8));
+    QCOMPARE(MipmapCache::sourceRect(tileset.data(), tileset->findTile(1)->imageRect(), 2),
+             QRect(8, 0, 8, 8));
+
+    for (int y = 0; y < mipmap.height(); ++y) {
+        for (int x = 0; x < mipmap.width(); ++x) {
+            const QRgb expected = x < 8 ? qRgb(255, 0, 0) : qRgb(0, 0, 255);
+            QCOMPARE(mipmap.pixel(x, y), expected);
+        }
+    }
+}
+
+/**
+ * Verifies that a large repeated image layer is drawn from a downscaled copy
+ * when zoomed out, while still lining up with its repetitions.
+ */
+void test_MapRenderer::drawImageLayerZoomedOut()
+{
+    QImage image(1024, 256, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    {
+        QPainter painter(&image);
+        painter.fillRect(512, 0, 512, 256, Qt::blue);
+    }
+
+    ImageLayer imageLayer(QStringLiteral("background"), 0, 0);
+    QVERIFY(imageLayer.loadFromImage(image, QStringLiteral("background.png")));
+    imageLayer.setRepeatX(true);
+
+    QCOMPARE(MipmapCache::levelFor(imageLayer.image(), 1.0), 0);
+    QCOMPARE(MipmapCache::levelFor(imageLayer.image(), 0.25), 2);
+    QCOMPARE(MipmapCache::levelFor(QPixmap(64, 64), 0.25), 0);
+    QCOMPARE(MipmapCache::mipmap(imageLayer.image(), 2).size(), QSize(256, 64));
+
+    const auto map = createMap(Map::Orthogonal, Map::StaggerY, 16);
+    const auto renderer = MapRenderer::create(map.get());
+
+    QImage result(512, 64, QImage::Format_ARGB32_Premultiplied);
+    result.fill(Qt::transparent);
+    {
+        QPainter painter(&result);
+        painter.scale(0.25, 0.25);
+        renderer->drawImageLayer(&painter, &imageLayer, QRectF(0, 0, 2048, 256));
+    }
+
+    // Sample away from the edges between the colors
+    QCOMPARE(result.pixel(64, 32), qRgb(255, 0, 0));
+    QCOMPARE(result.pixel(192, 32), qRgb(0, 0, 255));
+    QCOMPARE(result.pixel(320, 32), qRgb(255, 0, 0));
+    QCOMPARE(result.pixel(448, 32), qRgb(0, 0, 255));
+}
+
+/**
+ * Verifies that when zoomed out far enough, each tile is drawn as a single
+ * pixel of its average color.
+ */
+void test_MapRenderer::drawTileLayerColors()
+{
+    const auto map = createMap(Map::Orthogonal, Map::StaggerY, 16);
+    const auto renderer = MapRenderer::create(map.get());
+    const auto tileLayer = static_cast<TileLayer*>(map->layerAt(0));
+
+    QImage image(16, 16, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    {
+        QPainter painter(&image);
+        painter.scale(1.0 / 32, 1.0 / 16);
+        renderer->drawTileLayer(&painter, tileLayer);
+    }
+
+    for (int y = 0; y < 16; ++y) {
+        for (int x = 0; x < 16; ++x) {
+            const Tile *tile = tileLayer->cellAt(x, y).tile();
+            const QColor expected(tile->id() % 8 * 32, tile->id() / 8 * 64, 128, 160);
+            const QColor average = QColor::fromRgba(tile->averageColor());
+
+            QVERIFY(qAbs(average.red() - expected.red()) <= 1);
+            QVERIFY(qAbs(average.green() - expected.green()) <= 1);
+            QVERIFY(qAbs(average.blue() - expected.blue()) <= 1);
+            QCOMPARE(average.alpha(), expected.alpha());
+
+            QCOMPARE(image.pixel(x, y), qUnpremultiply(qPremultiply(average.rgba())));
+        }
+    }
+}
+
+/**
+ * Verifies that the outline of a selection merges adjacent rectangles and
+ * that the exposed rectangle is only applied when it isn't null.
+ */
+void test_MapRenderer::tileSelectionOutline()
+{
+    const auto map = createMap(Map::Orthogonal, Map::StaggerY, 16);
+    const auto renderer = MapRenderer::create(map.get());
+
+    QRegion region;
+    region += QRect(0, 0, 4, 2);
+    region += QRect(2, 2, 4, 2);
+    region += QRect(10, 10, 1, 1);
+
+    const QPainterPath outline = renderer->tileSelectionOutline(region);
+    QCOMPARE(outline.toFillPolygons().size(), 2);
+    QCOMPARE(outline.boundingRect(), QRectF(0, 0, 11 * 32, 11 * 16));
+
+    const QPainterPath exposedOutline = renderer->tileSelectionOutline(region, QRectF(0, 0, 64, 64));
+    QCOMPARE(exposedOutline.toFillPolygons().size(), 1);
+    QCOMPARE(exposedOutline.boundingRect(), QRectF(0, 0, 6 * 32, 4 * 16));
+}
+
+void test_MapRenderer::objectsInDrawOrder_data()
+{
+    QTest::addColumn<Map::Orientation>("orientation");
+
+    QTest::newRow("orthogonal") << Map::Orthogonal;
+    QTest::newRow("isometric") << Map::Isometric;
+}
+
+/**
+ * Verifies that the draw order of a top-down object group matches sorting the
+ * objects by their screen y-coordinate, also after objects have moved.
+ */
+void test_MapRenderer::objectsInDrawOrder()
+{
+    QFETCH(Map::Orientation, orientation);
+
+    const auto map = createMap(orientation, Map::StaggerY, 16);
+    const auto renderer = MapRenderer::create(map.get());
+
+    auto objectGroup = std::make_unique<ObjectGroup>();
+    QRandomGenerator random(7);
+
+    // Few distinct positions, to have many objects at the same height
+    for (int i = 0; i < 1000; ++i)
+        objectGroup->addObject(std::make_unique<MapObject>(QString(), QString(),
+                                                           QPointF(random.bounded(20) * 8,
+                                                                   random.bounded(20) * 8)));
+    map->addLayer(std::move(objectGroup));
+    const ObjectGroup *group = map->layerAt(map->layerCount() - 1)->asObjectGroup();
+
+    auto expectedOrder = [&] (QList<MapObject*> objects) {
+        std::stable_sort(objects.begin(), objects.end(), [&] (MapObject *a, MapObject *b) {
+            return renderer->pixelToScreenCoords(a->position()).y() <
+                    renderer->pixelToScreenCoords(b->position()).y();
+        });
+        return objects;
+    };
+
+    QCOMPARE(group->objectsInDrawOrder(), expectedOrder(group->objects()));
+
+    for (int i = 0; i < 200; ++i) {
+        MapObject *object = group->objectAt(random.bounded(group->objectCount()));
+        object->setPosition(QPointF(random.bounded(20) * 8, random.bounded(20) * 8));
+    }
+
+    QCOMPARE(group->objectsInDrawOrder(), expectedOrder(group->objects()));
+
+    const QList<MapObject*> subset = group->objects().mid(100, 50);
+    QList<MapObject*> sortedSubset = subset;
+    group->sortByDrawOrder(sortedSubset);
+    QCOMPARE(sortedSubset, expectedOrder(subset));
+}
+
+/**
+ * Verifies that polygons are only simplified when zoomed out, that the
+ * simplified polygon stays within the tolerance and that it is updated
+ * when the polygon changes.
+ */
+void test_MapRenderer::simplifiedPolygon()
+{
+    const auto map = createMap(Map::Orthogonal, Map::StaggerY, 16);
+    const auto renderer = MapRenderer::create(map.get());
+
+    // A wavy line with small bumps that disappear when zoomed out
+    QPolygonF polygon;
+    for (int i = 0; i < 1000; ++i)
+        polygon.append(QPointF(i, (i % 2) * 0.5 + (i / 100) * 10));
+
+    MapObject object;
+    object.setShape(MapObject::Polyline);
+    object.setPolygon(polygon);
+
+    renderer->setPainterScale(1);
+    QCOMPARE(renderer->simplifiedPolygon(&object), polygon);
+
+    renderer->setPainterScale(0.25);
+    const QPolygonF simplified = renderer->simplifiedPolygon(&object);
+    QVERIFY(simplified.size() < polygon.size() / 10);
+    QCOMPARE(simplified.first(), polygon.first());
+    QCOMPARE(simplified.last(), polygon.last());
+
+    // Each original point is within tolerance (2 pixels) of the simplified line
+    for (const QPointF &point : std::as_const(polygon)) {
+        qreal distance = std::numeric_limits<qreal>::max();
+        for (int i = 1; i < simplified.size(); ++i) {
+            const QLineF line(simplified.at(i - 1), simplified.at(i));
+            const QPointF delta = line.p2() - line.p1();
+            const qreal t = qBound(qreal(0),
+                                   QPointF::dotProduct(point - line.p1(), delta) / QPointF::dotProduct(delta, delta),
+                                   qreal(1));
+            distance = std::min(distance, QLineF(point, line.p1() + delta * t).length());
+        }
+        QVERIFY(distance <= 2);
+    }
+
+    // Changing the polygon invalidates the cached simplification
+    polygon.translate(0, 100);
+    object.setPolygon(polygon);
+    QCOMPARE(renderer->simplifiedPolygon(&object).first(), polygon.first());
+}
+
+QTEST_MAIN(test_MapRenderer)
+#include "test_maprenderer.moc"
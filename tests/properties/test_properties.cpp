@@ -253,6 +253,7 @@ private slots:
     void loadProperties();
     void saveProperties();
     void mergeProperties();
+    void deduplicateProperties();
 
     void cleanupTestCase();
 
@@ -570,6 +571,29 @@ void test_Properties::mergeProperties()
     QCOMPARE(classMember.typeId, newEnumStringType->id);
 }
 
+void test_Properties::deduplicateProperties()
+{
+    PropertiesDeduplicator deduplicator;
+
+    const Properties first = deduplicator.deduplicate({
+        { QStringLiteral("name"), QStringLiteral("value") },
+        { QStringLiteral("number"), 1 },
+    });
+    const Properties equal = deduplicator.deduplicate({
+        { QStringLiteral("name"), QStringLiteral("value") },
+        { QStringLiteral("number"), 1 },
+    });
+    QVERIFY(equal.isSharedWith(first));
+
+    // Values of a different type should not be considered equal
+    const Properties differentType = deduplicator.deduplicate({
+        { QStringLiteral("name"), QStringLiteral("value") },
+        { QStringLiteral("number"), QStringLiteral("1") },
+    });
+    QVERIFY(!differentType.isSharedWith(first));
+    QCOMPARE(differentType.value(QStringLiteral("number")).userType(), int(QMetaType::QString));
+}
+
 void test_Properties::cleanupTestCase()
 {
     mTypes.clear();
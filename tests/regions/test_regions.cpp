@@ -0,0 +1,254 @@
+#include "map.h"
+#include "mapdocument.h"
+#include "mapwriter.h"
+#include "pluginmanager.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include "regionfile.h"
+#include "regionsplugin.h"
+
+#include <QScopeGuard>
+#include <QtTest/QtTest>
+
+#include <memory>
+
+using namespace Tiled;
+using namespace Regions;
+
+class test_Regions : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip();
+    void incrementalSave();
+    void failedChunkLoad();
+    void reloadWithPagedInChunks();
+
+private:
+    std::unique_ptr<Map> createMap() const;
+    QString layerDirectory(const QString &mapFileName, const Layer *layer) const;
+};
+
+/**
+ * Creates an infinite map with a tile layer that has chunks in several
+ * regions, including ones at negative positions.
+ */
+std::unique_ptr<Map> test_Regions::createMap() const
+{
+    Map::Parameters parameters;
+    parameters.width = 10;
+    parameters.height = 10;
+    parameters.tileWidth = 16;
+    parameters.tileHeight = 16;
+    parameters.infinite = true;
+
+    auto map = std::make_unique<Map>(parameters);
+    const SharedTileset tileset = Tileset::create(QStringLiteral("tileset"), 16, 16);
+    map->addTileset(tileset);
+
+    auto tileLayer = new TileLayer(QStringLiteral("Tiles"), 0, 0, 10, 10);
+    const int regionTiles = REGION_SIZE * CHUNK_SIZE;
+
+    for (int y = -CHUNK_SIZE; y < CHUNK_SIZE * 2; ++y) {
+        for (int x = -CHUNK_SIZE; x < regionTiles + CHUNK_SIZE; x += 3) {
+            Cell cell(tileset.data(), (x + y) & 0xff);
+            cell.setFlippedHorizontally(x & 1);
+            cell.setFlippedAntiDiagonally(y & 1);
+            tileLayer->setCell(x, y, cell);
+        }
+    }
+
+    map->addLayer(tileLayer);
+    return map;
+}
+
+QString test_Regions::layerDirectory(const QString &mapFileName, const Layer *layer) const
+{
+    const QFileInfo info(mapFileName);
+    return info.dir().filePath(info.completeBaseName() + QLatin1String(".regions/")
+                               + QString::number(layer->id()));
+}
+
+/**
+ * Compares the cells of \a layer with those of \a expected, which refer to
+ * another instance of the same tileset.
+ */
+static void compareCells(const TileLayer &layer, const TileLayer &expected, Tileset *tileset)
+{
+    QCOMPARE(layer.region(), expected.region());
+
+    for (const QRect &rect : expected.region()) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                Cell cell = expected.cellAt(x, y);
+                cell.setTile(tileset, cell.tileId());
+                QCOMPARE(layer.cellAt(x, y), cell);
+            }
+        }
+    }
+}
+
+/**
+ * Verifies that the cells are stored in region files and only read when
+ * their chunks are paged in.
+ */
+void test_Regions::roundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("map.tmr"));
+
+    const auto map = createMap();
+    const auto tileLayer = static_cast<TileLayer*>(map->layerAt(0));
+
+    RegionsPlugin plugin;
+    QVERIFY2(plugin.write(map.get(), fileName, {}), qPrintable(plugin.errorString()));
+
+    const QString directory = layerDirectory(fileName, tileLayer);
+    QVERIFY(QFile::exists(regionFileName(directory, QPoint(-1, -1))));
+    QVERIFY(QFile::exists(regionFileName(directory, QPoint(0, 0))));
+    QVERIFY(QFile::exists(regionFileName(directory, QPoint(1, 0))));
+
+    const auto readMap = plugin.read(fileName);
+    QVERIFY2(readMap, qPrintable(plugin.errorString()));
+    QVERIFY(readMap->infinite());
+    QCOMPARE(readMap->tileLayerCount(), 1);
+
+    const auto readLayer = static_cast<TileLayer*>(readMap->layerAt(0));
+    QVERIFY(readLayer->chunkStore());
+    QCOMPARE(readLayer->pagedOutChunks().size(), tileLayer->sortedChunksToWrite(QSize(CHUNK_SIZE, CHUNK_SIZE)).size());
+    QCOMPARE(readLayer->tilesetUseCount(readMap->tilesetAt(0).data()),
+             tileLayer->tilesetUseCount(map->tilesetAt(0).data()));
+
+    QVERIFY(readLayer->pageInAll());
+    compareCells(*readLayer, *tileLayer, readMap->tilesetAt(0).data());
+}
+
+/**
+ * Verifies that saving only rewrites the regions with changed chunks.
+ */
+void test_Regions::incrementalSave()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("map.tmr"));
+
+    const auto map = createMap();
+    RegionsPlugin plugin;
+    QVERIFY2(plugin.write(map.get(), fileName, {}), qPrintable(plugin.errorString()));
+
+    const auto readMap = plugin.read(fileName);
+    QVERIFY2(readMap, qPrintable(plugin.errorString()));
+    const auto readLayer = static_cast<TileLayer*>(readMap->layerAt(0));
+    Tileset *tileset = readMap->tilesetAt(0).data();
+
+    const QString directory = layerDirectory(fileName, readLayer);
+    QFile unchangedRegion(regionFileName(directory, QPoint(1, 0)));
+    QVERIFY(unchangedRegion.open(QIODevice::ReadOnly));
+    const QByteArray unchangedData = unchangedRegion.readAll();
+    unchangedRegion.close();
+
+    readLayer->setCell(1, 1, Cell(tileset, 300));
+    QVERIFY(!readLayer->pagedOutChunks().contains(QPoint(0, 0)));
+    QVERIFY2(plugin.write(readMap.get(), fileName, {}), qPrintable(plugin.errorString()));
+
+    QVERIFY(unchangedRegion.open(QIODevice::ReadOnly));
+    QCOMPARE(unchangedRegion.readAll(), unchangedData);
+    unchangedRegion.close();
+
+    // The saved map has the change and still has the unchanged chunks
+    const auto savedMap = plugin.read(fileName);
+    QVERIFY2(savedMap, qPrintable(plugin.errorString()));
+    const auto savedLayer = static_cast<TileLayer*>(savedMap->layerAt(0));
+    QVERIFY(savedLayer->pageInAll());
+
+    map->layerAt(0)->asTileLayer()->setCell(1, 1, Cell(map->tilesetAt(0).data(), 300));
+    compareCells(*savedLayer, *map->layerAt(0)->asTileLayer(), savedMap->tilesetAt(0).data());
+}
+
+/**
+ * Verifies that a region with a chunk that could not be loaded is not
+ * overwritten.
+ */
+void test_Regions::failedChunkLoad()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("map.tmr"));
+
+    const auto map = createMap();
+    RegionsPlugin plugin;
+    QVERIFY2(plugin.write(map.get(), fileName, {}), qPrintable(plugin.errorString()));
+
+    // Truncate a region file after its first chunk, so that the chunk after
+    // it can't be read
+    const QString regionFile = regionFileName(layerDirectory(fileName, map->layerAt(0)), QPoint(0, 0));
+    QVector<StoredChunk> chunks;
+    QString error;
+    QVERIFY2(readRegionIndex(regionFile, chunks, error), qPrintable(error));
+    QVERIFY(chunks.size() > 1);
+    QCOMPARE(chunks.at(0).position, QPoint(0, 0));
+    QCOMPARE(chunks.at(1).position, QPoint(1, 0));
+    const qint64 truncatedSize = static_cast<qint64>(chunks.at(1).offset);
+    QVERIFY(QFile::resize(regionFile, truncatedSize));
+
+    const auto readMap = plugin.read(fileName);
+    QVERIFY2(readMap, qPrintable(plugin.errorString()));
+    const auto readLayer = static_cast<TileLayer*>(readMap->layerAt(0));
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("^Failed to load chunk")));
+    QVERIFY(!readLayer->pageIn(QRect(0, 0, CHUNK_SIZE * 2, CHUNK_SIZE)));
+    QCOMPARE(readLayer->failedChunks(), QSet<QPoint> { QPoint(1, 0) });
+
+    // Changing the region of the failed chunk makes saving fail, without
+    // touching the region file
+    readLayer->setCell(0, 0, Cell(readMap->tilesetAt(0).data(), 300));
+    QVERIFY(!plugin.write(readMap.get(), fileName, {}));
+    QVERIFY(!plugin.errorString().isEmpty());
+    QCOMPARE(QFileInfo(regionFile).size(), truncatedSize);
+}
+
+/**
+ * Verifies that reloading a map that has some of its chunks paged in neither
+ * erases tiles nor misses changes to the chunks that are paged out.
+ */
+void test_Regions::reloadWithPagedInChunks()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("map.tmr"));
+    const QString tilesetFileName = dir.filePath(QStringLiteral("tileset.tsx"));
+
+    // An external tileset is shared between the document and the reloaded
+    // map, which allows reloading to apply only the differences
+    const auto map = createMap();
+    const SharedTileset tileset = map->tilesetAt(0);
+    QVERIFY(MapWriter().writeTileset(*tileset, tilesetFileName));
+    tileset->setFileName(tilesetFileName);
+
+    RegionsPlugin plugin;
+    PluginManager::addObject(&plugin);
+    const auto removePlugin = qScopeGuard([&] { PluginManager::removeObject(&plugin); });
+    QVERIFY2(plugin.write(map.get(), fileName, {}), qPrintable(plugin.errorString()));
+
+    QString error;
+    const auto document = MapDocument::load(fileName, &plugin, &error);
+    QVERIFY2(document, qPrintable(error));
+    QVERIFY(document->map()->layerAt(0)->asTileLayer()->pageIn(QRect(0, 0, CHUNK_SIZE, CHUNK_SIZE)));
+
+    // Change a cell in a chunk that is paged out in the document
+    const auto tileLayer = map->layerAt(0)->asTileLayer();
+    tileLayer->setCell(REGION_SIZE * CHUNK_SIZE, 1, Cell(tileset.data(), 300));
+    QVERIFY2(plugin.write(map.get(), fileName, {}), qPrintable(plugin.errorString()));
+
+    QVERIFY2(document->reload(&error), qPrintable(error));
+
+    const auto reloadedLayer = document->map()->layerAt(0)->asTileLayer();
+    QVERIFY(reloadedLayer->pageInAll());
+    compareCells(*reloadedLayer, *tileLayer, document->map()->tilesetAt(0).data());
+}
+
+QTEST_MAIN(test_Regions)
+#include "test_regions.moc"
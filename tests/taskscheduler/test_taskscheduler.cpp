@@ -0,0 +1,138 @@
+#include "taskscheduler.h"
+
+#include <QtTest/QtTest>
+
+#include <atomic>
+
+using namespace Tiled;
+
+class test_TaskScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanup();
+
+    void parallelForVisitsEachIndex_data();
+    void parallelForVisitsEachIndex();
+
+    void parallelForNested();
+    void parallelForCanceled();
+
+    void backgroundTasksLeaveThreads();
+    void canceledTaskIsSkipped();
+};
+
+void test_TaskScheduler::cleanup()
+{
+    TaskScheduler::waitForDone();
+    TaskScheduler::setThreadCount(0);
+}
+
+void test_TaskScheduler::parallelForVisitsEachIndex_data()
+{
+    QTest::addColumn<int>("threadCount");
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("serial") << 1 << 1000;
+    QTest::newRow("empty") << 4 << 0;
+    QTest::newRow("single") << 4 << 1;
+    QTest::newRow("fewer than threads") << 8 << 3;
+    QTest::newRow("many") << 4 << 100000;
+}
+
+void test_TaskScheduler::parallelForVisitsEachIndex()
+{
+    QFETCH(int, threadCount);
+    QFETCH(int, count);
+
+    TaskScheduler::setThreadCount(threadCount);
+    QCOMPARE(TaskScheduler::threadCount(), threadCount);
+
+    QVector<int> visits(count, 0);
+    TaskScheduler::parallelFor(count, [&] (int index) {
+        ++visits[index];
+    });
+
+    QCOMPARE(visits, QVector<int>(count, 1));
+}
+
+/**
+ * Verifies that parallelFor can be used from within its own function, even
+ * when all threads are busy.
+ */
+void test_TaskScheduler::parallelForNested()
+{
+    TaskScheduler::setThreadCount(2);
+
+    std::atomic<int> total { 0 };
+    TaskScheduler::parallelFor(8, [&] (int) {
+        TaskScheduler::parallelFor(100, [&] (int) { ++total; });
+    });
+
+    QCOMPARE(total.load(), 800);
+}
+
+void test_TaskScheduler::parallelForCanceled()
+{
+    TaskScheduler::setThreadCount(4);
+
+    CancellationToken token;
+    std::atomic<int> calls { 0 };
+
+    TaskScheduler::parallelFor(100000, [&] (int) {
+        if (++calls == 10)
+            token.cancel();
+    }, token);
+
+    QVERIFY(calls < 100000);
+}
+
+/**
+ * Verifies that background tasks don't use more than half of the threads.
+ */
+void test_TaskScheduler::backgroundTasksLeaveThreads()
+{
+    TaskScheduler::setThreadCount(4);
+
+    std::atomic<int> running { 0 };
+    std::atomic<int> maxRunning { 0 };
+    std::atomic<int> finished { 0 };
+
+    for (int i = 0; i < 16; ++i) {
+        TaskScheduler::start([&] {
+            const int nowRunning = ++running;
+            int previousMax = maxRunning;
+            while (nowRunning > previousMax && !maxRunning.compare_exchange_weak(previousMax, nowRunning))
+                ;
+            QThread::msleep(5);
+            --running;
+            ++finished;
+        }, TaskScheduler::Background);
+    }
+
+    // Interactive work still gets threads while the background tasks run
+    std::atomic<int> interactive { 0 };
+    TaskScheduler::start([&] { ++interactive; }, TaskScheduler::Interactive);
+
+    TaskScheduler::waitForDone();
+
+    QCOMPARE(finished.load(), 16);
+    QCOMPARE(interactive.load(), 1);
+    QVERIFY(maxRunning <= 2);
+}
+
+void test_TaskScheduler::canceledTaskIsSkipped()
+{
+    CancellationToken token;
+    token.cancel();
+
+    std::atomic<bool> ran { false };
+    TaskScheduler::start([&] { ran = true; }, TaskScheduler::Foreground, token);
+    TaskScheduler::waitForDone();
+
+    QVERIFY(!ran);
+}
+
+QTEST_MAIN(test_TaskScheduler)
+#include "test_taskscheduler.moc"
@@ -0,0 +1,85 @@
+#include "mapobject.h"
+#include "textlayoutcache.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_TextLayoutCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void reusesLayout();
+    void layoutDependsOnWidth();
+    void clearInvalidates();
+
+private:
+    void draw(const TextData &textData, qreal width = 100);
+};
+
+void test_TextLayoutCache::init()
+{
+    TextLayoutCache::clear();
+    TextLayoutCache::resetStatistics();
+}
+
+void test_TextLayoutCache::draw(const TextData &textData, qreal width)
+{
+    QImage image(128, 64, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    TextLayoutCache::drawText(&painter, QRectF(0, 0, width, 64), textData);
+}
+
+void test_TextLayoutCache::reusesLayout()
+{
+    TextData textData;
+    textData.text = QStringLiteral("Hello World");
+
+    draw(textData);
+    draw(textData);
+
+    QCOMPARE(TextLayoutCache::statistics().misses, qint64(1));
+    QCOMPARE(TextLayoutCache::statistics().hits, qint64(1));
+
+    textData.text = QStringLiteral("Goodbye");
+    draw(textData);
+
+    QCOMPARE(TextLayoutCache::statistics().misses, qint64(2));
+    QCOMPARE(TextLayoutCache::statistics().hits, qint64(1));
+}
+
+void test_TextLayoutCache::layoutDependsOnWidth()
+{
+    TextData textData;
+    textData.text = QStringLiteral("Hello World");
+
+    draw(textData, 100);
+    draw(textData, 50);
+    draw(textData, 100);
+
+    QCOMPARE(TextLayoutCache::statistics().misses, qint64(2));
+    QCOMPARE(TextLayoutCache::statistics().hits, qint64(1));
+}
+
+void test_TextLayoutCache::clearInvalidates()
+{
+    TextData textData;
+    textData.text = QStringLiteral("Hello World");
+
+    draw(textData);
+    TextLayoutCache::clear();
+    draw(textData);
+
+    QCOMPARE(TextLayoutCache::statistics().misses, qint64(2));
+    QCOMPARE(TextLayoutCache::statistics().hits, qint64(0));
+}
+
+QTEST_MAIN(test_TextLayoutCache)
+#include "test_textlayoutcache.moc"
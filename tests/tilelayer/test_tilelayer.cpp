@@ -0,0 +1,824 @@
+#include "chunkstore.h"
+#include "map.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QRandomGenerator>
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <memory>
+
+using namespace Tiled;
+
+class test_TileLayer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void cellRoundTrip();
+    void iterationOrder();
+    void sparseChunks();
+    void copyOnWrite();
+    void mapSnapshot();
+    void nonEmptyRegion();
+    void chunkOccupancy();
+    void contentHash();
+    void tilesetUseCount();
+    void similarTileset();
+    void resizeAndOffset_data();
+    void resizeAndOffset();
+    void flipAndRotate();
+    void diffRegion();
+    void mergeLayer_data();
+    void mergeLayer();
+    void sortedChunksToWrite_data();
+    void sortedChunksToWrite();
+    void pageInAndOut();
+    void failedChunkLoad();
+
+    void benchmarkLinearAccess();
+    void benchmarkRandomAccess();
+    void benchmarkRegion();
+    void benchmarkRegionWithCondition();
+    void benchmarkHasCell();
+    void benchmarkSortedChunksToWrite();
+
+private:
+    SharedTileset mTileset;
+};
+
+void test_TileLayer::initTestCase()
+{
+    mTileset = Tileset::create(QStringLiteral("tileset"), 16, 16);
+}
+
+void test_TileLayer::cellRoundTrip()
+{
+    TileLayer layer(QString(), 0, 0, 64, 64);
+
+    Cell small(mTileset.data(), 3);
+    small.setFlippedHorizontally(true);
+
+    Cell large(mTileset.data(), 1000000);
+    large.setFlippedAntiDiagonally(true);
+
+    layer.setCell(1, 2, small);
+    layer.setCell(40, 40, large);
+
+    QCOMPARE(layer.cellAt(1, 2), small);
+    QCOMPARE(layer.cellAt(40, 40), large);
+    QVERIFY(layer.cellAt(0, 0).isEmpty());
+
+    // Widening a chunk keeps the cells that were already set
+    layer.setCell(2, 2, large);
+    QCOMPARE(layer.cellAt(1, 2), small);
+    QCOMPARE(layer.cellAt(2, 2), large);
+}
+
+void test_TileLayer::iterationOrder()
+{
+    TileLayer layer(QString(), 0, 0, 0, 0);
+
+    const Cell cell(mTileset.data(), 0);
+    layer.setCell(100, 100, cell);
+    layer.setCell(-20, 5, cell);
+    layer.setCell(0, -40, cell);
+    layer.setCell(50, 5, cell);
+
+    QVector<QPoint> positions;
+    for (auto it = layer.begin(); it != layer.end(); ++it)
+        if (!it.value().isEmpty())
+            positions.append(it.key());
+
+    QCOMPARE(positions, (QVector<QPoint> { QPoint(0, -40),
+                                           QPoint(-20, 5),
+                                           QPoint(50, 5),
+                                           QPoint(100, 100) }));
+}
+
+void test_TileLayer::sparseChunks()
+{
+    TileLayer layer(QString(), 0, 0, 0, 0);
+
+    const Cell cell(mTileset.data(), 1);
+    const QVector<QPoint> positions { QPoint(0, 0),
+                                      QPoint(100000, 0),
+                                      QPoint(-100000, 100000),
+                                      QPoint(5, 100000) };
+
+    QRegion expectedRegion;
+    for (const QPoint &pos : positions) {
+        layer.setCell(pos.x(), pos.y(), cell);
+        expectedRegion += QRect(pos, QSize(1, 1));
+    }
+
+    for (const QPoint &pos : positions)
+        QCOMPARE(layer.cellAt(pos), cell);
+
+    QVERIFY(layer.cellAt(50000, 50000).isEmpty());
+    QCOMPARE(layer.region(), expectedRegion);
+}
+
+void test_TileLayer::copyOnWrite()
+{
+    TileLayer layer(QString(), 0, 0, 64, 64);
+    for (int y = 0; y < layer.height(); ++y)
+        for (int x = 0; x < layer.width(); ++x)
+            layer.setCell(x, y, Cell(mTileset.data(), x));
+
+    const auto copy = layer.copy(QRegion(0, 0, 40, 40));
+    QCOMPARE(copy->size(), QSize(40, 40));
+    QCOMPARE(copy->cellAt(20, 35), layer.cellAt(20, 35));
+    QCOMPARE(copy->cellAt(39, 39), layer.cellAt(39, 39));
+    QVERIFY(copy->cellAt(40, 0).isEmpty());
+    QVERIFY(copy->findChunk(0, 0)->isSharedWith(*layer.findChunk(0, 0)));
+
+    // Changing the copy detaches the chunk, leaving the original unchanged
+    copy->setCell(1, 1, Cell::empty);
+    QVERIFY(copy->cellAt(1, 1).isEmpty());
+    QCOMPARE(layer.cellAt(1, 1), Cell(mTileset.data(), 1));
+    QVERIFY(!copy->findChunk(0, 0)->isSharedWith(*layer.findChunk(0, 0)));
+}
+
+/**
+ * Verifies that a snapshot shares the tile data of the map, and that it can
+ * be read from another thread while the map is changed.
+ */
+void test_TileLayer::mapSnapshot()
+{
+    Map::Parameters parameters;
+    parameters.width = 64;
+    parameters.height = 64;
+    parameters.tileWidth = 16;
+    parameters.tileHeight = 16;
+
+    Map map(parameters);
+    mTileset->setFileName(QStringLiteral("tileset.tsx"));
+    map.addTileset(mTileset);
+
+    auto tileLayer = new TileLayer(QString(), 0, 0, 64, 64);
+    for (int y = 0; y < 64; ++y)
+        for (int x = 0; x < 64; ++x)
+            tileLayer->setCell(x, y, Cell(mTileset.data(), x + y));
+    map.addLayer(tileLayer);
+
+    auto objectGroup = new ObjectGroup;
+    for (int i = 0; i < 300; ++i)
+        objectGroup->addObject(std::make_unique<MapObject>(QString(), QString(), QPointF(i, 300 - i)));
+    map.addLayer(objectGroup);
+
+    const std::shared_ptr<const Map> snapshot = map.snapshot();
+    const auto snapshotLayer = snapshot->layerAt(0)->asTileLayer();
+    QVERIFY(snapshotLayer->findChunk(0, 0)->isSharedWith(*tileLayer->findChunk(0, 0)));
+
+    int sum = 0;
+    qreal firstObjectY = 0;
+    QThread *reader = QThread::create([&] {
+        for (int y = 0; y < 64; ++y)
+            for (int x = 0; x < 64; ++x)
+                sum += snapshotLayer->cellAt(x, y).tileId();
+
+        const auto snapshotGroup = snapshot->layerAt(1)->asObjectGroup();
+        firstObjectY = snapshotGroup->objectsInDrawOrder().first()->y();
+    });
+    reader->start();
+
+    for (int y = 0; y < 64; ++y)
+        for (int x = 0; x < 64; ++x)
+            tileLayer->setCell(x, y, Cell::empty);
+    objectGroup->objectAt(0)->setY(1000);
+
+    QVERIFY(reader->wait());
+    delete reader;
+
+    QCOMPARE(sum, 64 * 63 * 64);
+    QCOMPARE(firstObjectY, qreal(1));
+    QVERIFY(tileLayer->isEmpty());
+    QCOMPARE(snapshotLayer->cellAt(5, 5).tileId(), 10);
+
+    mTileset->setFileName(QString());
+}
+
+void test_TileLayer::nonEmptyRegion()
+{
+    TileLayer layer(QString(), 0, 0, 64, 64);
+    layer.setCell(1, 1, Cell(mTileset.data(), 0));
+    layer.setCell(2, 1, Cell(mTileset.data(), 1));
+    layer.setCell(40, 30, Cell(mTileset.data(), 1000000));   // needs a wider format
+
+    const QRegion expected = layer.region([] (const Cell &cell) { return !cell.isEmpty(); });
+    QCOMPARE(layer.region(), expected);
+    QCOMPARE(layer.tileRegion().tileCount(), qint64(3));
+
+    QVERIFY(layer.hasCell([] (const Cell &cell) { return cell.tileId() == 1000000; }));
+    QVERIFY(!layer.hasCell([] (const Cell &cell) { return cell.tileId() == 5; }));
+}
+
+void test_TileLayer::chunkOccupancy()
+{
+    Chunk chunk;
+    QVERIFY(chunk.isEmpty());
+    QCOMPARE(chunk.bounds(), QRect());
+
+    chunk.setCell(2, 3, Cell(mTileset.data(), 0));
+    chunk.setCell(10, 5, Cell(mTileset.data(), 1));
+    chunk.setCell(4, 12, Cell(mTileset.data(), 1000000));  // needs a wider format
+    QCOMPARE(chunk.cellCount(), 3);
+    QCOMPARE(chunk.bounds(), QRect(QPoint(2, 3), QPoint(10, 12)));
+
+    // Overwriting a cell doesn't change the count
+    chunk.setCell(2, 3, Cell(mTileset.data(), 2));
+    QCOMPARE(chunk.cellCount(), 3);
+
+    // Removing cells at the edges shrinks the bounds
+    chunk.setCell(10, 5, Cell());
+    QCOMPARE(chunk.cellCount(), 2);
+    QCOMPARE(chunk.bounds(), QRect(QPoint(2, 3), QPoint(4, 12)));
+
+    chunk.setCell(2, 3, Cell());
+    chunk.setCell(4, 12, Cell());
+    QVERIFY(chunk.isEmpty());
+    QCOMPARE(chunk.bounds(), QRect());
+
+    // The layer combines the bounds of its chunks
+    TileLayer layer(QString(), 0, 0, 64, 64);
+    layer.setCell(3, 4, Cell(mTileset.data(), 0));
+    layer.setCell(40, 50, Cell(mTileset.data(), 0));
+    QCOMPARE(layer.usedBounds(), layer.region().boundingRect());
+
+    layer.removeReferencesToTileset(mTileset.data());
+    QCOMPARE(layer.usedBounds(), QRect());
+    QVERIFY(layer.isEmpty());
+}
+
+void test_TileLayer::tilesetUseCount()
+{
+    const SharedTileset other = Tileset::create(QStringLiteral("other"), 16, 16);
+
+    TileLayer layer(QString(), 0, 0, 64, 64);
+    layer.setCell(0, 0, Cell(mTileset.data(), 0));
+    layer.setCell(1, 0, Cell(mTileset.data(), 1));
+    layer.setCell(40, 40, Cell(other.data(), 0));
+
+    QCOMPARE(layer.tilesetUseCount(mTileset.data()), 2);
+    QCOMPARE(layer.tilesetUseCount(other.data()), 1);
+    QCOMPARE(layer.usedTilesets(), (QSet<SharedTileset> { mTileset, other }));
+
+    // Overwriting and erasing cells releases the tileset
+    layer.setCell(40, 40, Cell(mTileset.data(), 2));
+    QCOMPARE(layer.tilesetUseCount(mTileset.data()), 3);
+    QVERIFY(!layer.referencesTileset(other.data()));
+
+    layer.erase(QRegion(0, 0, 2, 1));
+    QCOMPARE(layer.tilesetUseCount(mTileset.data()), 1);
+
+    // Sharing whole chunks from another layer updates the counts as well
+    TileLayer source(QString(), 0, 0, CHUNK_SIZE, CHUNK_SIZE);
+    for (int y = 0; y < CHUNK_SIZE; ++y)
+        for (int x = 0; x < CHUNK_SIZE; ++x)
+            source.setCell(x, y, Cell(other.data(), 0));
+
+    layer.setCells(32, 32, &source);
+    QCOMPARE(layer.tilesetUseCount(mTileset.data()), 0);
+    QCOMPARE(layer.tilesetUseCount(other.data()), CHUNK_SIZE * CHUNK_SIZE);
+
+    layer.replaceReferencesToTileset(other.data(), mTileset.data());
+    QCOMPARE(layer.tilesetUseCount(mTileset.data()), CHUNK_SIZE * CHUNK_SIZE);
+    QVERIFY(!layer.referencesTileset(other.data()));
+
+    layer.removeReferencesToTileset(mTileset.data());
+    QVERIFY(layer.usedTilesets().isEmpty());
+}
+
+static void fillLayer(TileLayer &layer, Tileset *tileset)
+{
+    for (int y = 0; y < layer.height(); ++y)
+        for (int x = 0; x < layer.width(); ++x)
+            if ((x * 7 + y * 3) % 5)
+                layer.setCell(x, y, Cell(tileset, (x + y * layer.width()) % 300));
+}
+
+static int cellCount(const TileLayer &layer)
+{
+    return static_cast<int>(std::count_if(layer.begin(), layer.end(),
+                                          [] (const Cell &cell) { return !cell.isEmpty(); }));
+}
+
+void test_TileLayer::contentHash()
+{
+    // Chunks with the same cells have the same hash, regardless of encoding
+    Chunk packed;
+    packed.setCell(1, 1, Cell(mTileset.data(), 5));
+
+    Chunk widened;
+    widened.setCell(2, 2, Cell(mTileset.data(), 1000000));
+    widened.setCell(2, 2, Cell());
+    widened.setCell(1, 1, Cell(mTileset.data(), 5));
+    QVERIFY(widened.format() != packed.format());
+    QCOMPARE(widened.contentHash(), packed.contentHash());
+
+    widened.setCell(1, 1, Cell(mTileset.data(), 6));
+    QVERIFY(widened.contentHash() != packed.contentHash());
+
+    TileLayer layer(QString(), 0, 0, 64, 64);
+    fillLayer(layer, mTileset.data());
+
+    std::unique_ptr<TileLayer> clone(layer.clone());
+    QCOMPARE(clone->contentHash(), layer.contentHash());
+
+    // Changing a cell changes the hash, restoring it restores the hash
+    const quint64 hash = layer.contentHash();
+    const Cell cell = layer.cellAt(21, 30);
+    layer.setCell(21, 30, Cell());
+    QVERIFY(layer.contentHash() != hash);
+    QCOMPARE(layer.computeDiffRegion(*clone), QRegion(21, 30, 1, 1));
+
+    layer.setCell(21, 30, cell);
+    QCOMPARE(layer.contentHash(), hash);
+    QVERIFY(layer.computeDiffRegion(*clone).isEmpty());
+
+    layer.flip(FlipHorizontally);
+    QVERIFY(layer.contentHash() != hash);
+}
+
+void test_TileLayer::similarTileset()
+{
+    auto createCollection = [] (const QString &name, int tileCount) {
+        SharedTileset tileset = Tileset::create(name, 16, 16);
+        for (int id = tileCount - 1; id >= 0; --id) {
+            Tile *tile = tileset->findOrCreateTile(id);
+            tile->setImageSource(QUrl::fromLocalFile(QStringLiteral("/tiles/%1.png").arg(id)));
+        }
+        return tileset;
+    };
+
+    const SharedTileset subject = createCollection(QStringLiteral("subject"), 50);
+
+    QVector<SharedTileset> candidates;
+    for (int i = 0; i < 20; ++i)
+        candidates.append(createCollection(QStringLiteral("other"), 49));
+    const SharedTileset similar = createCollection(QStringLiteral("similar"), 50);
+    candidates.append(similar);
+
+    QCOMPARE(subject->similarityHash(), similar->similarityHash());
+    QCOMPARE(subject->findSimilarTileset(candidates), similar);
+
+    // Changing the image of a tile updates the cached hash
+    similar->findTile(10)->setImageSource(QUrl::fromLocalFile(QStringLiteral("/tiles/other.png")));
+    QVERIFY(subject->similarityHash() != similar->similarityHash());
+    QVERIFY(!subject->findSimilarTileset(candidates));
+
+    similar->findTile(10)->setImageSource(QUrl::fromLocalFile(QStringLiteral("/tiles/10.png")));
+    QCOMPARE(subject->findSimilarTileset(candidates), similar);
+
+    // So does adding a tile
+    similar->findOrCreateTile(50);
+    QVERIFY(!subject->findSimilarTileset(candidates));
+}
+
+void test_TileLayer::resizeAndOffset_data()
+{
+    QTest::addColumn<QPoint>("offset");
+
+    QTest::newRow("chunk-aligned") << QPoint(CHUNK_SIZE, -2 * CHUNK_SIZE);
+    QTest::newRow("unaligned") << QPoint(5, -19);
+}
+
+/**
+ * Verifies that moving the cells around, both by whole chunks and one by
+ * one, gives the same result as looking up each cell.
+ */
+void test_TileLayer::resizeAndOffset()
+{
+    QFETCH(QPoint, offset);
+
+    TileLayer layer(QString(), 0, 0, 100, 70);
+    fillLayer(layer, mTileset.data());
+
+    const QSize newSize(90, 80);
+    std::unique_ptr<TileLayer> resized(layer.clone());
+    resized->resize(newSize, offset);
+
+    QCOMPARE(resized->size(), newSize);
+    for (int y = 0; y < newSize.height(); ++y)
+        for (int x = 0; x < newSize.width(); ++x)
+            QCOMPARE(resized->cellAt(x, y), layer.cellAt(x - offset.x(), y - offset.y()));
+
+    QCOMPARE(resized->tilesetUseCount(mTileset.data()), cellCount(*resized));
+
+    std::unique_ptr<TileLayer> offsetLayer(layer.clone());
+    offsetLayer->offsetTiles(offset);
+    for (int y = -50; y < 120; ++y)
+        for (int x = -50; x < 120; ++x)
+            QCOMPARE(offsetLayer->cellAt(x, y), layer.cellAt(x - offset.x(), y - offset.y()));
+
+    // Offsetting within bounds only affects the cells inside the bounds
+    const QRect bounds(10, 10, 60, 40);
+    std::unique_ptr<TileLayer> wrapped(layer.clone());
+    wrapped->offsetTiles(offset, bounds, true, false);
+    for (int y = 0; y < layer.height(); ++y) {
+        for (int x = 0; x < layer.width(); ++x) {
+            QPoint source(x, y);
+            if (bounds.contains(source)) {
+                source -= offset;
+                source.setX((source.x() - bounds.left() + bounds.width() * 2) % bounds.width() + bounds.left());
+            }
+
+            const Cell expected = bounds.contains(source) ? layer.cellAt(source) : Cell();
+            QCOMPARE(wrapped->cellAt(x, y), expected);
+        }
+    }
+
+    QCOMPARE(wrapped->tilesetUseCount(mTileset.data()), cellCount(*wrapped));
+}
+
+/**
+ * Verifies that flipping or rotating a layer four times restores it.
+ */
+void test_TileLayer::flipAndRotate()
+{
+    TileLayer layer(QString(), 0, 0, 100, 70);
+    fillLayer(layer, mTileset.data());
+
+    std::unique_ptr<TileLayer> flipped(layer.clone());
+    flipped->flip(FlipHorizontally);
+
+    Cell expected = layer.cellAt(1, 2);
+    expected.setFlippedHorizontally(true);
+    QCOMPARE(flipped->cellAt(98, 2), expected);
+
+    flipped->flip(FlipVertically);
+    flipped->flip(FlipHorizontally);
+    flipped->flip(FlipVertically);
+    QVERIFY(flipped->computeDiffRegion(layer).isEmpty());
+
+    std::unique_ptr<TileLayer> rotated(layer.clone());
+    rotated->rotate(RotateRight);
+    QCOMPARE(rotated->size(), QSize(70, 100));
+    QCOMPARE(rotated->cellAt(67, 1).tileId(), layer.cellAt(1, 2).tileId());
+
+    for (int i = 0; i < 3; ++i)
+        rotated->rotate(RotateRight);
+
+    QCOMPARE(rotated->size(), layer.size());
+    QVERIFY(rotated->computeDiffRegion(layer).isEmpty());
+    QCOMPARE(rotated->tilesetUseCount(mTileset.data()), cellCount(layer));
+}
+
+/**
+ * Verifies that the chunks skipped when computing the difference between two
+ * layers don't affect the result.
+ */
+void test_TileLayer::diffRegion()
+{
+    TileLayer layer(QString(), 0, 0, 100, 70);
+    fillLayer(layer, mTileset.data());
+
+    std::unique_ptr<TileLayer> changed(layer.clone());
+    QVERIFY(changed->computeDiffRegion(layer).isEmpty());
+
+    changed->setCell(3, 4, Cell(mTileset.data(), 500));
+    changed->setCell(61, 60, Cell());
+    changed->setCell(200, 3, Cell(mTileset.data(), 1));
+
+    QRegion expected;
+    expected += QRect(3, 4, 1, 1);
+    expected += QRect(61, 60, 1, 1);
+    expected += QRect(200, 3, 1, 1);
+    QCOMPARE(changed->computeDiffRegion(layer), expected);
+    QCOMPARE(layer.computeDiffRegion(*changed), expected);
+
+    // Unaligned layers are compared cell by cell
+    std::unique_ptr<TileLayer> moved(layer.clone());
+    moved->setPosition(3, 0);
+    QCOMPARE(moved->computeDiffRegion(layer), layer.computeDiffRegion(*moved).translated(-3, 0));
+    QVERIFY(!moved->computeDiffRegion(layer).isEmpty());
+}
+
+void test_TileLayer::mergeLayer_data()
+{
+    QTest::addColumn<QPoint>("pos");
+
+    QTest::newRow("chunk-aligned") << QPoint(CHUNK_SIZE, 2 * CHUNK_SIZE);
+    QTest::newRow("unaligned") << QPoint(5, -19);
+}
+
+/**
+ * Verifies that merging keeps the existing cells where the merged layer is
+ * empty, whether or not its chunks can be shared.
+ */
+void test_TileLayer::mergeLayer()
+{
+    QFETCH(QPoint, pos);
+
+    TileLayer source(QString(), 0, 0, 100, 70);
+    fillLayer(source, mTileset.data());
+
+    TileLayer layer(QString(), 0, 0, 120, 120);
+    for (int i = 0; i < 120; ++i)
+        layer.setCell(i, i, Cell(mTileset.data(), 1000));
+
+    std::unique_ptr<TileLayer> merged(layer.clone());
+    merged->merge(pos, &source);
+
+    for (int y = 0; y < layer.height(); ++y) {
+        for (int x = 0; x < layer.width(); ++x) {
+            const Cell sourceCell = source.contains(x - pos.x(), y - pos.y())
+                    ? source.cellAt(x - pos.x(), y - pos.y()) : Cell();
+            const Cell expected = sourceCell.isEmpty() ? layer.cellAt(x, y) : sourceCell;
+            QCOMPARE(merged->cellAt(x, y), expected);
+        }
+    }
+
+    QCOMPARE(merged->tilesetUseCount(mTileset.data()), cellCount(*merged));
+}
+
+void test_TileLayer::sortedChunksToWrite_data()
+{
+    QTest::addColumn<QSize>("chunkSize");
+
+    QTest::newRow("native") << QSize(CHUNK_SIZE, CHUNK_SIZE);
+    QTest::newRow("10x7") << QSize(10, 7);
+    QTest::newRow("40x40") << QSize(40, 40);
+    QTest::newRow("5x33") << QSize(5, 33);
+}
+
+/**
+ * Verifies that exactly the chunks containing non-empty cells are returned,
+ * in order of their position.
+ */
+void test_TileLayer::sortedChunksToWrite()
+{
+    QFETCH(QSize, chunkSize);
+
+    TileLayer layer(QString(), 0, 0, 0, 0);
+
+    QRandomGenerator random(7);
+    for (int i = 0; i < 200; ++i) {
+        const QPoint pos(random.bounded(-150, 150), random.bounded(-150, 150));
+        layer.setCell(pos.x(), pos.y(), Cell(mTileset.data(), i));
+    }
+
+    // Chunks that only contain empty cells are skipped
+    layer.setCell(500, 500, Cell(mTileset.data(), 1));
+    layer.setCell(500, 500, Cell::empty);
+
+    QVector<QRect> expected;
+    const QRect bounds = layer.bounds();
+    auto floorDiv = [] (int a, int b) { return a >= 0 ? a / b : (a + 1) / b - 1; };
+
+    for (int y = floorDiv(bounds.top(), chunkSize.height()); y <= floorDiv(bounds.bottom(), chunkSize.height()); ++y) {
+        for (int x = floorDiv(bounds.left(), chunkSize.width()); x <= floorDiv(bounds.right(), chunkSize.width()); ++x) {
+            const QRect rect(QPoint(x * chunkSize.width(), y * chunkSize.height()), chunkSize);
+            if (!layer.region().intersected(rect).isEmpty())
+                expected.append(rect);
+        }
+    }
+
+    QCOMPARE(layer.sortedChunksToWrite(chunkSize), expected);
+}
+
+namespace {
+
+/**
+ * Provides stored chunks from memory, counting the reads.
+ */
+class MemoryChunkStore : public ChunkStore
+{
+public:
+    bool readChunk(QPoint chunkPos, Chunk &chunk) override
+    {
+        ++reads;
+        if (failing.contains(chunkPos) || !chunks.contains(chunkPos))
+            return false;
+        chunk = chunks.value(chunkPos);
+        return true;
+    }
+
+    QHash<QPoint, Chunk> chunks;
+    QSet<QPoint> failing;
+    int reads = 0;
+};
+
+} // anonymous namespace
+
+/**
+ * Makes the chunks at \a positions of \a layer stored chunks, filled with
+ * tile ID \a tileId.
+ */
+static std::shared_ptr<MemoryChunkStore> storeChunks(TileLayer &layer,
+                                                     Tileset *tileset, int tileId,
+                                                     const QVector<QPoint> &positions)
+{
+    auto store = std::make_shared<MemoryChunkStore>();
+    QHash<Tileset*, int> tilesetUseCounts;
+
+    for (const QPoint chunkPos : positions) {
+        Chunk chunk;
+        for (int y = 0; y < CHUNK_SIZE; ++y)
+            for (int x = 0; x < CHUNK_SIZE; ++x)
+                chunk.setCell(x, y, Cell(tileset, tileId));
+
+        store->chunks.insert(chunkPos, chunk);
+        tilesetUseCounts[tileset] += CHUNK_SIZE * CHUNK_SIZE;
+    }
+
+    layer.setChunkStore(store, positions, tilesetUseCounts);
+    return store;
+}
+
+/**
+ * Verifies that stored chunks are only read when paged in, and that the
+ * least recently used unchanged chunks are paged out beyond the budget.
+ */
+void test_TileLayer::pageInAndOut()
+{
+    TileLayer layer(QString(), 0, 0, CHUNK_SIZE * 4, CHUNK_SIZE);
+    auto store = storeChunks(layer, mTileset.data(), 1,
+                             { QPoint(0, 0), QPoint(1, 0), QPoint(2, 0), QPoint(3, 0) });
+
+    QCOMPARE(store->reads, 0);
+    QVERIFY(!layer.isEmpty());
+    QCOMPARE(layer.usedBounds(), layer.rect());
+    QCOMPARE(layer.tilesetUseCount(mTileset.data()), 4 * CHUNK_SIZE * CHUNK_SIZE);
+
+    // Paged out chunks read as empty and are not included in copies
+    QVERIFY(layer.cellAt(0, 0).isEmpty());
+    QVERIFY(layer.copy(QRegion(0, 0, 2, 2))->cellAt(1, 1).isEmpty());
+    QCOMPARE(layer.pagedOutChunks().size(), 4);
+
+    QVERIFY(layer.pageIn(QRect(0, 0, CHUNK_SIZE + 1, 1)));
+    QCOMPARE(store->reads, 2);
+    QCOMPARE(layer.pagedOutChunks(), (QSet<QPoint> { QPoint(2, 0), QPoint(3, 0) }));
+    QCOMPARE(layer.cellAt(CHUNK_SIZE, 0), Cell(mTileset.data(), 1));
+    QCOMPARE(layer.copy(QRegion(0, 0, 2, 2))->cellAt(1, 1), Cell(mTileset.data(), 1));
+
+    // With a budget of two chunks, paging in another chunk pages out the
+    // least recently used one
+    store->setMemoryBudget(layer.memoryUsage());
+    QVERIFY(layer.pageIn(QRect(0, 0, 1, 1)));
+    QVERIFY(layer.pageIn(QRect(CHUNK_SIZE * 2, 0, 1, 1)));
+    QCOMPARE(layer.pagedOutChunks(), (QSet<QPoint> { QPoint(1, 0), QPoint(3, 0) }));
+
+    // Changed chunks are not paged out
+    layer.setCell(0, 0, Cell(mTileset.data(), 2));
+    QVERIFY(layer.pageIn(QRect(CHUNK_SIZE * 3, 0, 1, 1)));
+    QCOMPARE(layer.pagedOutChunks(), (QSet<QPoint> { QPoint(1, 0), QPoint(2, 0) }));
+    QCOMPARE(layer.cellAt(0, 0), Cell(mTileset.data(), 2));
+
+    // Paging in all chunks keeps track of their use, so they can be paged
+    // out again afterwards
+    QVERIFY(layer.pageInAll());
+    QVERIFY(!layer.hasPagedOutChunks());
+    QVERIFY(layer.pageIn(QRect(CHUNK_SIZE * 3, 0, 1, 1)));
+    layer.pageOut(store->memoryBudget());
+    QCOMPARE(layer.pagedOutChunks(), (QSet<QPoint> { QPoint(1, 0), QPoint(2, 0) }));
+
+    // The chunks paged in again are the same as those stored
+    QVERIFY(layer.pageInAll());
+    QCOMPARE(layer.cellAt(CHUNK_SIZE * 2 + 5, 7), Cell(mTileset.data(), 1));
+    QCOMPARE(layer.tilesetUseCount(mTileset.data()), 4 * CHUNK_SIZE * CHUNK_SIZE);
+    QCOMPARE(layer.region(), QRegion(layer.rect()));
+}
+
+/**
+ * Verifies that a chunk that can't be loaded stays paged out, and that
+ * changes to it are ignored rather than replacing its stored cells.
+ */
+void test_TileLayer::failedChunkLoad()
+{
+    TileLayer layer(QString(), 0, 0, CHUNK_SIZE * 2, CHUNK_SIZE);
+    auto store = storeChunks(layer, mTileset.data(), 1, { QPoint(0, 0), QPoint(1, 0) });
+    store->failing.insert(QPoint(1, 0));
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("^Failed to load chunk")));
+    QVERIFY(!layer.pageInAll());
+    QCOMPARE(layer.failedChunks(), QSet<QPoint> { QPoint(1, 0) });
+    QCOMPARE(layer.pagedOutChunks(), QSet<QPoint> { QPoint(1, 0) });
+    QCOMPARE(layer.cellAt(0, 0), Cell(mTileset.data(), 1));
+
+    // Loading the failed chunk is not attempted again
+    const int reads = store->reads;
+    QVERIFY(!layer.pageIn(layer.rect()));
+    QCOMPARE(store->reads, reads);
+
+    layer.setCell(CHUNK_SIZE, 0, Cell(mTileset.data(), 2));
+    QVERIFY(layer.cellAt(CHUNK_SIZE, 0).isEmpty());
+    QCOMPARE(layer.pagedOutChunks(), QSet<QPoint> { QPoint(1, 0) });
+    QCOMPARE(layer.tilesetUseCount(mTileset.data()), 2 * CHUNK_SIZE * CHUNK_SIZE);
+
+    // Also sharing a whole chunk leaves the failed chunk alone
+    TileLayer source(QString(), 0, 0, CHUNK_SIZE, CHUNK_SIZE);
+    source.setCell(0, 0, Cell(mTileset.data(), 2));
+    layer.setCells(CHUNK_SIZE, 0, &source);
+    QVERIFY(layer.cellAt(CHUNK_SIZE, 0).isEmpty());
+    QCOMPARE(layer.failedChunks(), QSet<QPoint> { QPoint(1, 0) });
+
+    // A clone keeps the chunk as failed
+    std::unique_ptr<TileLayer> clone(layer.clone());
+    QCOMPARE(clone->failedChunks(), QSet<QPoint> { QPoint(1, 0) });
+    QVERIFY(!clone->isEmpty());
+}
+
+void test_TileLayer::benchmarkLinearAccess()
+{
+    TileLayer layer(QString(), 0, 0, 1024, 1024);
+    for (int y = 0; y < layer.height(); ++y)
+        for (int x = 0; x < layer.width(); ++x)
+            layer.setCell(x, y, Cell(mTileset.data(), (x + y) & 0xff));
+
+    int count = 0;
+    QBENCHMARK {
+        for (int y = 0; y < layer.height(); ++y)
+            for (int x = 0; x < layer.width(); ++x)
+                count += layer.cellAt(x, y).tileId();
+    }
+    QVERIFY(count > 0);
+}
+
+void test_TileLayer::benchmarkRandomAccess()
+{
+    TileLayer layer(QString(), 0, 0, 1024, 1024);
+    for (int y = 0; y < layer.height(); ++y)
+        for (int x = 0; x < layer.width(); ++x)
+            layer.setCell(x, y, Cell(mTileset.data(), (x + y) & 0xff));
+
+    QRandomGenerator random(42);
+    QVector<QPoint> points(layer.width() * layer.height());
+    for (QPoint &point : points)
+        point = QPoint(random.bounded(layer.width()), random.bounded(layer.height()));
+
+    int count = 0;
+    QBENCHMARK {
+        for (const QPoint &point : std::as_const(points))
+            count += layer.cellAt(point).tileId();
+    }
+    QVERIFY(count > 0);
+}
+
+void test_TileLayer::benchmarkRegion()
+{
+    TileLayer layer(QString(), 0, 0, 1024, 1024);
+    for (int y = 0; y < layer.height(); ++y)
+        for (int x = 0; x < layer.width(); ++x)
+            if ((x ^ y) & 4)
+                layer.setCell(x, y, Cell(mTileset.data(), (x + y) & 0xff));
+
+    qint64 count = 0;
+    QBENCHMARK {
+        count += layer.tileRegion().tileCount();
+    }
+    QVERIFY(count > 0);
+}
+
+void test_TileLayer::benchmarkRegionWithCondition()
+{
+    TileLayer layer(QString(), 0, 0, 1024, 1024);
+    for (int y = 0; y < layer.height(); ++y)
+        for (int x = 0; x < layer.width(); ++x)
+            layer.setCell(x, y, Cell(mTileset.data(), (x + y) & 0xff));
+
+    const Cell match(mTileset.data(), 7);
+
+    qint64 count = 0;
+    QBENCHMARK {
+        count += layer.tileRegion([&] (const Cell &cell) { return cell == match; }).tileCount();
+    }
+    QVERIFY(count > 0);
+}
+
+void test_TileLayer::benchmarkHasCell()
+{
+    TileLayer layer(QString(), 0, 0, 1024, 1024);
+    for (int y = 0; y < layer.height(); ++y)
+        for (int x = 0; x < layer.width(); ++x)
+            layer.setCell(x, y, Cell(mTileset.data(), (x + y) & 0xff));
+
+    bool found = false;
+    QBENCHMARK {
+        // Searches the whole layer, since no cell has this tile ID
+        found |= layer.hasCell([] (const Cell &cell) { return cell.tileId() == 1000; });
+    }
+    QVERIFY(!found);
+}
+
+void test_TileLayer::benchmarkSortedChunksToWrite()
+{
+    TileLayer layer(QString(), 0, 0, 512, 512);
+    for (int y = 0; y < layer.height(); ++y)
+        for (int x = 0; x < layer.width(); ++x)
+            layer.setCell(x, y, Cell(mTileset.data(), x % 8));
+
+    QBENCHMARK {
+        layer.sortedChunksToWrite(QSize(24, 24));
+    }
+}
+
+QTEST_MAIN(test_TileLayer)
+#include "test_tilelayer.moc"
@@ -0,0 +1,85 @@
+#include "chunkstore.h"
+#include "map.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include "mapdocument.h"
+#include "tilepainter.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_TilePainter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fillNextToPagedOutChunk();
+};
+
+namespace {
+
+/**
+ * Provides a single stored chunk filled with one tile.
+ */
+class FilledChunkStore : public ChunkStore
+{
+public:
+    explicit FilledChunkStore(Tileset *tileset)
+    {
+        for (int y = 0; y < CHUNK_SIZE; ++y)
+            for (int x = 0; x < CHUNK_SIZE; ++x)
+                mChunk.setCell(x, y, Cell(tileset, 0));
+    }
+
+    bool readChunk(QPoint, Chunk &chunk) override
+    {
+        chunk = mChunk;
+        return true;
+    }
+
+private:
+    Chunk mChunk;
+};
+
+} // anonymous namespace
+
+/**
+ * Verifies that a fill stops at the tiles of a stored chunk, rather than
+ * flooding through it while it is paged out.
+ */
+void test_TilePainter::fillNextToPagedOutChunk()
+{
+    const SharedTileset tileset = Tileset::create(QStringLiteral("tileset"), 16, 16);
+
+    Map::Parameters parameters;
+    parameters.width = CHUNK_SIZE * 2;
+    parameters.height = CHUNK_SIZE;
+    parameters.tileWidth = 16;
+    parameters.tileHeight = 16;
+
+    auto map = std::make_unique<Map>(parameters);
+    map->addTileset(tileset);
+
+    auto tileLayer = new TileLayer(QStringLiteral("Tiles"), 0, 0, CHUNK_SIZE * 2, CHUNK_SIZE);
+    tileLayer->setChunkStore(std::make_shared<FilledChunkStore>(tileset.data()),
+                             { QPoint(1, 0) },
+                             { { tileset.data(), CHUNK_SIZE * CHUNK_SIZE } });
+    map->addLayer(tileLayer);
+
+    MapDocument mapDocument(std::move(map));
+    TilePainter painter(&mapDocument, tileLayer);
+
+    const auto isEmpty = [] (const Cell &cell) { return cell.isEmpty(); };
+    const QRegion leftChunk(0, 0, CHUNK_SIZE, CHUNK_SIZE);
+
+    QCOMPARE(painter.computeFillRegion(QPoint(0, 0), isEmpty), leftChunk);
+    QVERIFY(!tileLayer->hasPagedOutChunks());
+
+    QCOMPARE(painter.computePaintableFillRegion(QPoint(0, 0), isEmpty), leftChunk);
+    QCOMPARE(painter.cellAt(CHUNK_SIZE, 0), Cell(tileset.data(), 0));
+}
+
+QTEST_MAIN(test_TilePainter)
+#include "test_tilepainter.moc"
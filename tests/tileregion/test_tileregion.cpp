@@ -0,0 +1,120 @@
+#include "tileregion.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_TileRegion : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void addMergesSpans();
+    void subtract();
+    void intersect();
+    void translate();
+    void matchesQRegion_data();
+    void matchesQRegion();
+};
+
+void test_TileRegion::addMergesSpans()
+{
+    TileRegion region;
+    region.add(QRect(0, 0, 2, 1));
+    region.add(QRect(4, 0, 2, 1));
+    region.add(QRect(2, 0, 2, 1));
+
+    QCOMPARE(region.rows().value(0).size(), 1);
+    QCOMPARE(region.boundingRect(), QRect(0, 0, 6, 1));
+    QCOMPARE(region.tileCount(), qint64(6));
+
+    region.add(QRect(0, 1, 6, 1));
+    QCOMPARE(region.rects(), QVector<QRect>() << QRect(0, 0, 6, 2));
+}
+
+void test_TileRegion::subtract()
+{
+    TileRegion region(QRect(0, 0, 10, 10));
+    region.subtract(QRect(2, 2, 6, 6));
+
+    QCOMPARE(region.tileCount(), qint64(100 - 36));
+    QVERIFY(region.contains(1, 1));
+    QVERIFY(!region.contains(2, 2));
+    QVERIFY(!region.contains(7, 7));
+    QVERIFY(region.contains(8, 7));
+
+    region.subtract(TileRegion(QRect(0, 0, 10, 10)));
+    QVERIFY(region.isEmpty());
+    QVERIFY(region.rows().isEmpty());
+}
+
+void test_TileRegion::intersect()
+{
+    TileRegion region(QRect(0, 0, 10, 10));
+    region.intersect(QRect(5, 5, 10, 10));
+    QCOMPARE(region.rects(), QVector<QRect>() << QRect(5, 5, 5, 5));
+
+    TileRegion other;
+    other.add(QRect(0, 6, 6, 1));
+    other.add(QRect(8, 6, 1, 1));
+    region.intersect(other);
+    QCOMPARE(region.rects(), QVector<QRect>() << QRect(5, 6, 1, 1) << QRect(8, 6, 1, 1));
+
+    region.intersect(QRect());
+    QVERIFY(region.isEmpty());
+}
+
+void test_TileRegion::translate()
+{
+    TileRegion region(QRect(0, 0, 2, 2));
+    QCOMPARE(region.translated(QPoint(-3, 5)).boundingRect(), QRect(-3, 5, 2, 2));
+}
+
+void test_TileRegion::matchesQRegion_data()
+{
+    QTest::addColumn<int>("seed");
+
+    for (int seed = 1; seed <= 5; ++seed)
+        QTest::newRow(qPrintable(QString::number(seed))) << seed;
+}
+
+void test_TileRegion::matchesQRegion()
+{
+    QFETCH(int, seed);
+
+    QRandomGenerator random(seed);
+    auto randomRect = [&] {
+        return QRect(random.bounded(-20, 20), random.bounded(-20, 20),
+                     random.bounded(1, 10), random.bounded(1, 10));
+    };
+
+    TileRegion tileRegion;
+    QRegion region;
+
+    for (int i = 0; i < 200; ++i) {
+        const QRect rect = randomRect();
+
+        switch (random.bounded(3)) {
+        case 0:
+            tileRegion.add(rect);
+            region += rect;
+            break;
+        case 1:
+            tileRegion.subtract(rect);
+            region -= rect;
+            break;
+        case 2:
+            if (random.bounded(4) == 0) {
+                tileRegion.intersect(rect);
+                region &= rect;
+            }
+            break;
+        }
+
+        QVERIFY((tileRegion.toQRegion() ^ region).isEmpty());
+        QCOMPARE(TileRegion(region), tileRegion);
+    }
+}
+
+QTEST_MAIN(test_TileRegion)
+#include "test_tileregion.moc"
@@ -0,0 +1,275 @@
+#include "tmxrasterizer.h"
+
+#include "map.h"
+#include "tile.h"
+#include "maprenderer.h"
+#include "mapwriter.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_TmxRasterizer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void threadsMatchSingleThread();
+    void updateFromPreviousMap();
+    void renderBatch();
+    void renderFrames();
+
+    void benchmarkThreads_data();
+    void benchmarkThreads();
+
+private:
+    QTemporaryDir mDir;
+    std::unique_ptr<Map> mMap;
+};
+
+void test_TmxRasterizer::initTestCase()
+{
+    // A tileset image of 16x16 tiles, each with a different color
+    QImage tilesetImage(256, 256, QImage::Format_ARGB32);
+    tilesetImage.fill(Qt::transparent);
+    {
+        QPainter painter(&tilesetImage);
+        for (int y = 0; y < 16; ++y)
+            for (int x = 0; x < 16; ++x)
+                painter.fillRect(x * 16 + 1, y * 16 + 1, 14, 14,
+                                 QColor(x * 16, y * 16, 128));
+    }
+
+    QVERIFY(mDir.isValid());
+    const QString tilesetImageFileName = mDir.filePath(QStringLiteral("tileset.png"));
+    QVERIFY(tilesetImage.save(tilesetImageFileName));
+
+    auto tileset = Tileset::create(QStringLiteral("tileset"), 16, 16);
+    QVERIFY(tileset->loadFromImage(tilesetImage, tilesetImageFileName));
+
+    Map::Parameters parameters;
+    parameters.width = 256;
+    parameters.height = 256;
+    parameters.tileWidth = 16;
+    parameters.tileHeight = 16;
+
+    mMap = std::make_unique<Map>(parameters);
+    mMap->addTileset(tileset);
+
+    auto layer = std::make_unique<TileLayer>(QStringLiteral("layer"), 0, 0, 256, 256);
+    for (int y = 0; y < layer->height(); ++y)
+        for (int x = 0; x < layer->width(); ++x)
+            layer->setCell(x, y, Cell(tileset.data(), (x * 7 + y * 3) & 0xff));
+
+    mMap->addLayer(std::move(layer));
+}
+
+void test_TmxRasterizer::threadsMatchSingleThread()
+{
+    const auto renderer = MapRenderer::create(mMap.get());
+
+    TmxRasterizer rasterizer;
+    const QImage expected = rasterizer.drawMap(*renderer);
+
+    rasterizer.setThreadCount(7);
+    QCOMPARE(rasterizer.drawMap(*renderer), expected);
+}
+
+void test_TmxRasterizer::updateFromPreviousMap()
+{
+    const QString previousMapFileName = mDir.filePath(QStringLiteral("previous.tmx"));
+    const QString mapFileName = mDir.filePath(QStringLiteral("map.tmx"));
+    const QString imageFileName = mDir.filePath(QStringLiteral("map.png"));
+    const QString expectedFileName = mDir.filePath(QStringLiteral("expected.png"));
+
+    MapWriter writer;
+    QVERIFY(writer.writeMap(mMap.get(), previousMapFileName));
+
+    auto map = mMap->clone();
+    TileLayer *layer = map->layerAt(0)->asTileLayer();
+    const Cell cell(map->tilesetAt(0).data(), 5);
+    layer->setCell(3, 4, cell);
+    layer->setCell(200, 100, cell);
+    layer->setCell(201, 100, cell);
+    QVERIFY(writer.writeMap(map.get(), mapFileName));
+
+    TmxRasterizer rasterizer;
+    QCOMPARE(rasterizer.render(previousMapFileName, imageFileName), 0);
+    const QImage previousImage(imageFileName);
+
+    rasterizer.setPreviousMapFileName(previousMapFileName);
+    QCOMPARE(rasterizer.render(mapFileName, imageFileName), 0);
+
+    TmxRasterizer fullRasterizer;
+    QCOMPARE(fullRasterizer.render(mapFileName, expectedFileName), 0);
+
+    const QImage image(imageFileName);
+    QVERIFY(image != previousImage);
+    QCOMPARE(image, QImage(expectedFileName));
+}
+
+void test_TmxRasterizer::renderBatch()
+{
+    const QString batchPath = mDir.filePath(QStringLiteral("batch"));
+    QVERIFY(QDir().mkpath(batchPath));
+
+    MapWriter writer;
+    QVERIFY(writer.writeMap(mMap.get(), batchPath + QStringLiteral("/a.tmx")));
+
+    auto map = mMap->clone();
+    map->layerAt(0)->asTileLayer()->setCell(0, 0, Cell(map->tilesetAt(0).data(), 5));
+    QVERIFY(writer.writeMap(map.get(), batchPath + QStringLiteral("/b.tmx")));
+
+    const QString manifestFileName = mDir.filePath(QStringLiteral("manifest.txt"));
+    {
+        QFile manifest(manifestFileName);
+        QVERIFY(manifest.open(QIODevice::WriteOnly | QIODevice::Text));
+        manifest.write("# map\timage\n"
+                       "batch/a.tmx\tbatch/a.png\n"
+                       "\n"
+                       "batch/b.tmx\tbatch/b.png\n"
+                       "batch/missing.tmx\tbatch/missing.png\n");
+    }
+
+    QVector<TmxRasterizer::BatchEntry> entries;
+    QString error;
+    QVERIFY(TmxRasterizer::readBatchManifest(manifestFileName, entries, &error));
+    QCOMPARE(entries.size(), 3);
+    QCOMPARE(entries.at(1).imageFileName, batchPath + QStringLiteral("/b.png"));
+
+    const QString reportFileName = mDir.filePath(QStringLiteral("report.json"));
+
+    TmxRasterizer rasterizer;
+    rasterizer.setThreadCount(2);
+    QCOMPARE(rasterizer.renderBatch(entries, reportFileName), 1);   // one map is missing
+
+    TmxRasterizer singleRasterizer;
+    for (const QString &name : { QStringLiteral("a"), QStringLiteral("b") }) {
+        const QString expectedFileName = mDir.filePath(name + QStringLiteral("-expected.png"));
+        QCOMPARE(singleRasterizer.render(batchPath + QLatin1Char('/') + name + QStringLiteral(".tmx"),
+                                         expectedFileName), 0);
+        QCOMPARE(QImage(batchPath + QLatin1Char('/') + name + QStringLiteral(".png")),
+                 QImage(expectedFileName));
+    }
+
+    QFile reportFile(reportFileName);
+    QVERIFY(reportFile.open(QIODevice::ReadOnly));
+    const QJsonObject report = QJsonDocument::fromJson(reportFile.readAll()).object();
+    const QJsonArray maps = report.value(QStringLiteral("maps")).toArray();
+    QCOMPARE(maps.size(), 3);
+    QVERIFY(maps.at(0).toObject().value(QStringLiteral("success")).toBool());
+    QVERIFY(!maps.at(2).toObject().value(QStringLiteral("success")).toBool());
+    QCOMPARE(report.value(QStringLiteral("failures")).toInt(), 1);
+    QCOMPARE(report.value(QStringLiteral("tilesets")).toInt(), 2);      // embedded in each map
+
+    const auto matching = TmxRasterizer::batchEntriesMatching(batchPath + QStringLiteral("/*.tmx"),
+                                                              mDir.path());
+    QCOMPARE(matching.size(), 2);
+    QCOMPARE(matching.at(1).imageFileName, mDir.filePath(QStringLiteral("b.png")));
+}
+
+void test_TmxRasterizer::renderFrames()
+{
+    auto tileset = mMap->tilesetAt(0)->clone();
+    Frame first;
+    first.tileId = 1;
+    first.duration = 200;
+    Frame second = first;
+    second.tileId = 2;
+    tileset->findOrCreateTile(1)->setFrames({ first, second });
+
+    Map::Parameters parameters;
+    parameters.width = 8;
+    parameters.height = 8;
+    parameters.tileWidth = 16;
+    parameters.tileHeight = 16;
+
+    Map map(parameters);
+    map.addTileset(tileset);
+
+    auto layer = std::make_unique<TileLayer>(QStringLiteral("layer"), 0, 0, 8, 8);
+    for (int y = 0; y < layer->height(); ++y)
+        for (int x = 0; x < layer->width(); ++x)
+            layer->setCell(x, y, Cell(tileset.data(), (x + y) % 3 == 0 ? 1 : 20 + x));
+    map.addLayer(std::move(layer));
+
+    const QString mapFileName = mDir.filePath(QStringLiteral("animated.tmx"));
+    MapWriter writer;
+    QVERIFY(writer.writeMap(&map, mapFileName));
+
+    TmxRasterizer rasterizer;
+    rasterizer.setFrameCount(4);
+    rasterizer.setFrameDuration(100);
+    QCOMPARE(rasterizer.render(mapFileName, mDir.filePath(QStringLiteral("frames.png"))), 0);
+
+    // Each frame matches a full render of the map at that time
+    for (int frame = 0; frame < 4; ++frame) {
+        const QString expectedFileName = mDir.filePath(QStringLiteral("frame-expected.png"));
+
+        TmxRasterizer fullRasterizer;
+        fullRasterizer.setAdvanceAnimations(frame * 100);
+        QCOMPARE(fullRasterizer.render(mapFileName, expectedFileName), 0);
+
+        const QImage image(mDir.filePath(QStringLiteral("frames%1.png").arg(frame)));
+        QCOMPARE(image, QImage(expectedFileName));
+    }
+
+    QVERIFY(QImage(mDir.filePath(QStringLiteral("frames0.png"))) !=
+            QImage(mDir.filePath(QStringLiteral("frames2.png"))));
+
+    // Unchanged frames are merged in an animated PNG
+    const QString animatedFileName = mDir.filePath(QStringLiteral("frames.apng"));
+    QCOMPARE(rasterizer.render(mapFileName, animatedFileName), 0);
+
+    QFile file(animatedFileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray data = file.readAll();
+
+    const int animationControl = data.indexOf("acTL");
+    QVERIFY(animationControl > 0);
+    QCOMPARE(qFromBigEndian<quint32>(data.constData() + animationControl + 4), 2u);
+    QCOMPARE(data.count("fcTL"), 2);
+    QCOMPARE(data.count("fdAT"), 1);
+
+    // The first frame is readable by any PNG decoder
+    QCOMPARE(QImage::fromData(data, "png"),
+             QImage(mDir.filePath(QStringLiteral("frames0.png"))));
+}
+
+void test_TmxRasterizer::benchmarkThreads_data()
+{
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("4") << 4;
+    QTest::newRow("16") << 16;
+}
+
+void test_TmxRasterizer::benchmarkThreads()
+{
+    QFETCH(int, threads);
+
+    const auto renderer = MapRenderer::create(mMap.get());
+
+    TmxRasterizer rasterizer;
+    rasterizer.setThreadCount(threads);
+
+    QBENCHMARK {
+        const QImage image = rasterizer.drawMap(*renderer);
+        QCOMPARE(image.size(), QSize(4096, 4096));
+    }
+}
+
+QTEST_MAIN(test_TmxRasterizer)
+#include "test_tmxrasterizer.moc"
@@ -0,0 +1,280 @@
+#include "xmlwriter.h"
+
+#include <QBuffer>
+#include <QXmlStreamWriter>
+#include <QtTest/QtTest>
+
+#include <cmath>
+
+using namespace Tiled;
+
+/**
+ * Adapts QXmlStreamWriter to the interface of XmlWriter, formatting numbers
+ * the way MapWriter used to.
+ */
+class QtWriter
+{
+public:
+    explicit QtWriter(QIODevice *device) : w(device) {}
+
+    void setAutoFormatting(bool autoFormatting) { w.setAutoFormatting(autoFormatting); }
+    void setAutoFormattingIndent(int spaces) { w.setAutoFormattingIndent(spaces); }
+
+    void writeStartDocument() { w.writeStartDocument(); }
+    void writeDTD(QLatin1String dtd) { w.writeDTD(dtd); }
+    void writeEndDocument() { w.writeEndDocument(); }
+
+    void writeStartElement(QLatin1String name) { w.writeStartElement(name); }
+    void writeEmptyElement(QLatin1String name) { w.writeEmptyElement(name); }
+    void writeEndElement() { w.writeEndElement(); }
+
+    void writeAttribute(QLatin1String name, const QString &value) { w.writeAttribute(name, value); }
+    void writeAttribute(QLatin1String name, QLatin1String value) { w.writeAttribute(name, value); }
+    void writeAttribute(QLatin1String name, int value) { w.writeAttribute(name, QString::number(value)); }
+    void writeAttribute(QLatin1String name, unsigned value) { w.writeAttribute(name, QString::number(value)); }
+    void writeAttribute(QLatin1String name, double value) { w.writeAttribute(name, QString::number(value)); }
+    void writeAttribute(const QString &name, const QString &value) { w.writeAttribute(name, value); }
+
+    void writeCharacters(const QString &text) { w.writeCharacters(text); }
+    void writeCharacters(QLatin1String text) { w.writeCharacters(text); }
+
+private:
+    QXmlStreamWriter w;
+};
+
+template<typename Writer>
+static QByteArray writeSample(bool autoFormatting, bool dtd)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    {
+        Writer w(&buffer);
+        w.setAutoFormatting(autoFormatting);
+        w.setAutoFormattingIndent(1);
+
+        w.writeStartDocument();
+        if (dtd)
+            w.writeDTD(QLatin1String("<!DOCTYPE map SYSTEM \"http://mapeditor.org/dtd/1.0/map.dtd\">"));
+
+        w.writeStartElement(QLatin1String("map"));
+        w.writeAttribute(QLatin1String("version"), QStringLiteral("1.10"));
+        w.writeAttribute(QLatin1String("width"), 100);
+        w.writeAttribute(QLatin1String("nextobjectid"), -42);
+        w.writeAttribute(QLatin1String("gid"), 0x80000001u);
+        w.writeAttribute(QLatin1String("infinite"), true);
+
+        // Nested elements with and without contents
+        w.writeStartElement(QLatin1String("properties"));
+        w.writeStartElement(QLatin1String("property"));
+        w.writeAttribute(QLatin1String("name"), QStringLiteral("quotes \"<&>\" and\ttab\r\nnewline"));
+        w.writeAttribute(QLatin1String("value"), QString::fromUtf8("caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80"));
+        w.writeEndElement();
+        w.writeStartElement(QLatin1String("property"));
+        w.writeAttribute(QStringLiteral("type"), QStringLiteral("string"));
+        w.writeCharacters(QStringLiteral("multi\nline <text> & \"quotes\"\t\r"));
+        w.writeEndElement();
+        w.writeStartElement(QLatin1String("property"));
+        w.writeCharacters(QString());
+        w.writeEndElement();
+        w.writeEndElement();
+
+        // Floating point values
+        const double values[] = {
+            0.0, -0.0, 1.0, -1.0, 0.5, 0.1, 1.0 / 3.0, 16.25, -123.456,
+            999999.0, 1000000.0, -1000000.0, 123456.5, 1234567.0, 1e-7,
+            1e21, 3.4e38, std::nan(""), HUGE_VAL, -HUGE_VAL
+        };
+        for (const double value : values) {
+            w.writeEmptyElement(QLatin1String("value"));
+            w.writeAttribute(QLatin1String("v"), value);
+            w.writeAttribute(QLatin1String("f"), static_cast<double>(static_cast<float>(value)));
+        }
+
+        // Layer data
+        w.writeStartElement(QLatin1String("layer"));
+        w.writeStartElement(QLatin1String("data"));
+        w.writeAttribute(QLatin1String("encoding"), QLatin1String("base64"));
+        w.writeCharacters(QLatin1String("\n   "));
+        w.writeCharacters(QLatin1String("eJztwTEBAAAAwqD1T20JT6AAAHgaAAAB"));
+        w.writeCharacters(QLatin1String("\n  "));
+        w.writeEndElement();
+        w.writeEmptyElement(QLatin1String("point"));
+        w.writeEndElement();
+
+        w.writeStartElement(QLatin1String("text"));
+        w.writeCharacters(QLatin1String("latin1 \xe9"));
+        w.writeEndElement();
+
+        w.writeEndDocument();
+    }
+
+    return buffer.data();
+}
+
+class test_XmlWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matchesQXmlStreamWriter_data();
+    void matchesQXmlStreamWriter();
+    void appendNumber();
+    void replayRecording_data();
+    void replayRecording();
+    void invalidCharacters();
+};
+
+void test_XmlWriter::matchesQXmlStreamWriter_data()
+{
+    QTest::addColumn<bool>("autoFormatting");
+    QTest::addColumn<bool>("dtd");
+
+    QTest::newRow("formatted") << true << false;
+    QTest::newRow("formatted-dtd") << true << true;
+    QTest::newRow("minimized") << false << false;
+    QTest::newRow("minimized-dtd") << false << true;
+}
+
+void test_XmlWriter::matchesQXmlStreamWriter()
+{
+    QFETCH(bool, autoFormatting);
+    QFETCH(bool, dtd);
+
+    const QByteArray expected = writeSample<QtWriter>(autoFormatting, dtd);
+    const QByteArray actual = writeSample<XmlWriter>(autoFormatting, dtd);
+
+    QCOMPARE(actual, expected);
+}
+
+void test_XmlWriter::appendNumber()
+{
+    for (int i = -2000; i <= 2000; ++i) {
+        const double value = i * 0.37;
+
+        QByteArray out;
+        XmlWriter::appendNumber(out, value);
+        QCOMPARE(out, QString::number(value).toLatin1());
+    }
+
+    QByteArray out;
+    XmlWriter::appendNumber(out, qint64(-9223372036854775807LL - 1));
+    QCOMPARE(out, QByteArray("-9223372036854775808"));
+}
+
+
+void test_XmlWriter::replayRecording_data()
+{
+    QTest::addColumn<bool>("autoFormatting");
+
+    QTest::newRow("formatted") << true;
+    QTest::newRow("minimized") << false;
+}
+
+/**
+ * Writes pairs of tilesets, where the second of each pair is either written
+ * normally or replayed from a recording of the first.
+ */
+static QByteArray writeTilesets(bool autoFormatting, bool replay)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    {
+        XmlWriter w(&buffer);
+        w.setAutoFormatting(autoFormatting);
+        w.setAutoFormattingIndent(1);
+
+        w.writeStartDocument();
+        w.writeStartElement(QLatin1String("map"));
+
+        auto writeTileset = [&] (int firstGid, bool empty) {
+            w.writeStartElement(QLatin1String("tileset"));
+            w.writeAttribute(QLatin1String("firstgid"), firstGid);
+            w.writeAttribute(QLatin1String("name"), QStringLiteral("tiles"));
+            if (!empty) {
+                w.writeStartElement(QLatin1String("image"));
+                w.writeAttribute(QLatin1String("source"), QStringLiteral("tiles.png"));
+                w.writeEndElement();
+            }
+            w.writeEndElement();
+        };
+
+        for (const bool empty : { false, true }) {
+            w.writeStartElement(QLatin1String("tileset"));
+            w.writeAttribute(QLatin1String("firstgid"), 1);
+            w.startRecording();
+            w.writeAttribute(QLatin1String("name"), QStringLiteral("tiles"));
+            if (!empty) {
+                w.writeStartElement(QLatin1String("image"));
+                w.writeAttribute(QLatin1String("source"), QStringLiteral("tiles.png"));
+                w.writeEndElement();
+            }
+            w.writeEndElement();
+            const QByteArray recorded = w.finishRecording();
+
+            if (replay) {
+                w.writeStartElement(QLatin1String("tileset"));
+                w.writeAttribute(QLatin1String("firstgid"), 10);
+                w.writeRecordedElementEnd(recorded);
+            } else {
+                writeTileset(10, empty);
+            }
+        }
+
+        w.writeEmptyElement(QLatin1String("layer"));
+        w.writeEndDocument();
+    }
+
+    return buffer.data();
+}
+
+void test_XmlWriter::replayRecording()
+{
+    QFETCH(bool, autoFormatting);
+
+    const QByteArray expected = writeTilesets(autoFormatting, false);
+    QVERIFY(expected.count("firstgid=\"10\"") == 2);
+    QCOMPARE(writeTilesets(autoFormatting, true), expected);
+}
+
+void test_XmlWriter::invalidCharacters()
+{
+    auto write = [] (const QString &text, bool *hasError) {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+
+        XmlWriter w(&buffer);
+        w.writeStartElement(QLatin1String("property"));
+        w.writeAttribute(QLatin1String("value"), text);
+        w.writeCharacters(text);
+        w.writeEndDocument();
+
+        *hasError = w.hasError();
+        return buffer.data();
+    };
+
+    bool hasError;
+
+    const QString invalid = QStringLiteral("a\vb\fc\x01" "d") + QChar(0xffff) + QStringLiteral("e");
+    QCOMPARE(write(invalid, &hasError), QByteArray("<property value=\"abcde\">abcde</property>\n"));
+    QVERIFY(hasError);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    {
+        XmlWriter w(&buffer);
+        w.writeStartElement(QLatin1String("data"));
+        w.writeCharacters(QLatin1String("x\x02y"));
+        w.writeEndDocument();
+        QVERIFY(w.hasError());
+    }
+    QCOMPARE(buffer.data(), QByteArray("<data>xy</data>\n"));
+
+    QCOMPARE(write(QStringLiteral("a\tb\nc\rd"), &hasError),
+             QByteArray("<property value=\"a&#9;b&#10;c&#13;d\">a\tb\nc\rd</property>\n"));
+    QVERIFY(!hasError);
+}
+
+QTEST_MAIN(test_XmlWriter)
+#include "test_xmlwriter.moc"